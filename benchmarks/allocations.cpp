@@ -0,0 +1,186 @@
+#include "allocations.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string_view>
+#include <vector>
+
+#if __has_include(<malloc.h>)
+#    include <malloc.h>
+#endif
+
+// The global operator new and delete, with the allocations counted (relaxed increments), and the main
+// of the benchmarks, which reports them for every benchmark.
+
+namespace {
+    std::atomic<std::size_t>    allocation_count{0};
+    std::atomic<std::size_t>    allocated_bytes{0};
+    std::atomic<std::ptrdiff_t> live_bytes{0}; // only where the size of a block can be asked
+
+    [[nodiscard]] std::size_t block_size([[maybe_unused]] void* ptr) noexcept {
+#ifdef __GLIBC__
+        return malloc_usable_size(ptr);
+#else
+        return 0;
+#endif
+    }
+
+    void* counted_alloc(std::size_t size, std::size_t alignment = 0) noexcept {
+        size = size == 0 ? 1 : size;
+        void* ptr =
+          alignment <= alignof(std::max_align_t)
+            ? std::malloc(size)
+            : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+        if (ptr) {
+            allocation_count.fetch_add(1, std::memory_order_relaxed);
+            allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+            live_bytes.fetch_add(static_cast<std::ptrdiff_t>(block_size(ptr)), std::memory_order_relaxed);
+        }
+        return ptr;
+    }
+
+    void counted_free(void* ptr) noexcept {
+        if (!ptr)
+            return;
+        live_bytes.fetch_sub(static_cast<std::ptrdiff_t>(block_size(ptr)), std::memory_order_relaxed);
+        std::free(ptr);
+    }
+
+    void* counted_alloc_or_throw(std::size_t size, std::size_t alignment = 0) {
+        if (void* ptr = counted_alloc(size, alignment))
+            return ptr;
+        throw std::bad_alloc{};
+    }
+
+    /**
+     * Google Benchmark runs every benchmark once more with this, and reports the allocations per
+     * iteration of that run
+     */
+    class heap_memory_manager : public benchmark::MemoryManager {
+        heap_usage     start;
+        std::ptrdiff_t start_live = 0;
+
+      public:
+        void Start() override {
+            start      = current_heap_usage();
+            start_live = live_bytes.load(std::memory_order_relaxed);
+        }
+
+        void Stop(Result& result) override {
+            auto const end               = current_heap_usage();
+            result.num_allocs            = static_cast<std::int64_t>(end.allocations - start.allocations);
+            result.total_allocated_bytes = static_cast<std::int64_t>(end.bytes - start.bytes);
+            result.net_heap_growth = static_cast<std::int64_t>(live_bytes.load(std::memory_order_relaxed) -
+                                                               start_live);
+        }
+
+        void Stop(Result* result) override {
+            Stop(*result);
+        }
+    };
+
+    /**
+     * The console reporter, with the allocations per iteration of the memory manager in the counters of
+     * the benchmarks that don't count their own (see counted_allocations)
+     */
+    class allocations_reporter : public benchmark::ConsoleReporter {
+      public:
+        void ReportRuns(std::vector<Run> const& reports) override {
+            auto runs = reports;
+            for (auto& run : runs) {
+                if (!run.memory_result || run.counters.contains("allocs/iter"))
+                    continue;
+                run.counters["allocs/iter"] = benchmark::Counter(run.allocs_per_iter);
+            }
+            ConsoleReporter::ReportRuns(runs);
+        }
+    };
+} // namespace
+
+heap_usage current_heap_usage() noexcept {
+    return {allocation_count.load(std::memory_order_relaxed),
+            allocated_bytes.load(std::memory_order_relaxed)};
+}
+
+void* operator new(std::size_t size) {
+    return counted_alloc_or_throw(size);
+}
+
+void* operator new[](std::size_t size) {
+    return counted_alloc_or_throw(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return counted_alloc_or_throw(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return counted_alloc_or_throw(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept {
+    return counted_alloc(size);
+}
+
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept {
+    return counted_alloc(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    counted_free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    counted_free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    counted_free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    counted_free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    counted_free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    counted_free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    counted_free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    counted_free(ptr);
+}
+
+int main(int argc, char** argv) {
+    // the other formats (json, csv) have the allocations of the memory manager already
+    bool console = true;
+    for (int index = 1; index < argc; index++) {
+        std::string_view const arg = argv[index];
+        if (arg.starts_with("--benchmark_format=") && arg != "--benchmark_format=console")
+            console = false;
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    heap_memory_manager memory_manager;
+    benchmark::RegisterMemoryManager(&memory_manager);
+    if (console) {
+        allocations_reporter reporter;
+        benchmark::RunSpecifiedBenchmarks(&reporter);
+    } else {
+        benchmark::RunSpecifiedBenchmarks();
+    }
+    benchmark::RegisterMemoryManager(nullptr);
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,49 @@
+#ifndef WEBPP_BENCHMARKS_ALLOCATIONS_H
+#define WEBPP_BENCHMARKS_ALLOCATIONS_H
+
+#include "benchmark_pch.h"
+
+#include <cstddef>
+
+// The global operator new of the benchmarks counts the heap allocations (see allocations.cpp); every
+// benchmark gets an "allocs/iter" counter from them. That one counts the whole benchmark function, set
+// up included, over a few iterations; use counted_allocations for the exact count of the loop.
+
+struct heap_usage {
+    std::size_t allocations = 0;
+    std::size_t bytes       = 0;
+};
+
+/**
+ * The allocations of the global operator new so far, on all the threads
+ */
+[[nodiscard]] heap_usage current_heap_usage() noexcept;
+
+/**
+ * Count the allocations from here to the end of the scope into the "allocs/iter" and "bytes/iter"
+ * counters of the benchmark; put it right before the loop:
+ *   counted_allocations const _allocations{state};
+ *   for (auto _ : state) ...
+ */
+class counted_allocations {
+    benchmark::State& state;
+    heap_usage        start;
+
+  public:
+    explicit counted_allocations(benchmark::State& _state) noexcept
+      : state{_state},
+        start{current_heap_usage()} {}
+
+    counted_allocations(counted_allocations const&)            = delete;
+    counted_allocations& operator=(counted_allocations const&) = delete;
+
+    ~counted_allocations() {
+        auto const end                = current_heap_usage();
+        state.counters["allocs/iter"] = benchmark::Counter(
+          static_cast<double>(end.allocations - start.allocations), benchmark::Counter::kAvgIterations);
+        state.counters["bytes/iter"]  = benchmark::Counter(static_cast<double>(end.bytes - start.bytes),
+                                                          benchmark::Counter::kAvgIterations);
+    }
+};
+
+#endif // WEBPP_BENCHMARKS_ALLOCATIONS_H
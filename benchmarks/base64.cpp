@@ -0,0 +1,65 @@
+#include "benchmark_pch.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <webpp/utils/base64.hpp>
+
+using namespace webpp;
+
+namespace {
+    // the sizes of the session ids, the sealed cookies, and the bigger bodies
+    std::string random_bytes(std::size_t size) {
+        std::mt19937_64 gen{42}; // NOLINT(cert-msc51-cpp)
+        std::string     res(size, '\0');
+        for (auto& c : res)
+            c = static_cast<char>(gen());
+        return res;
+    }
+} // namespace
+
+static void base64_encode_scalar(benchmark::State& state) {
+    auto const  data = random_bytes(static_cast<std::size_t>(state.range(0)));
+    std::string out(base64::encoded_size(data.size()), '\0');
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(base64::encode_scalar(data, out.data(), out.size()));
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * data.size()));
+}
+BENCHMARK(base64_encode_scalar)->Arg(32)->Arg(256)->Arg(4096);
+
+static void base64_encode(benchmark::State& state) {
+    auto const  data = random_bytes(static_cast<std::size_t>(state.range(0)));
+    std::string out(base64::encoded_size(data.size()), '\0');
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(base64::encode(data, out.data(), out.size()));
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * data.size()));
+}
+BENCHMARK(base64_encode)->Arg(32)->Arg(256)->Arg(4096);
+
+static void base64_decode_scalar(benchmark::State& state) {
+    std::string encoded;
+    base64::encode(random_bytes(static_cast<std::size_t>(state.range(0))), encoded);
+    std::string out(base64::max_decoded_size(encoded.size()), '\0');
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(base64::decode_scalar(encoded, out.data(), out.size()));
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * encoded.size()));
+}
+BENCHMARK(base64_decode_scalar)->Arg(32)->Arg(256)->Arg(4096);
+
+static void base64_decode(benchmark::State& state) {
+    std::string encoded;
+    base64::encode(random_bytes(static_cast<std::size_t>(state.range(0))), encoded);
+    std::string out(base64::max_decoded_size(encoded.size()), '\0');
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(base64::decode(encoded, out.data(), out.size()));
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * encoded.size()));
+}
+BENCHMARK(base64_decode)->Arg(32)->Arg(256)->Arg(4096);
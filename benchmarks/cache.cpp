@@ -0,0 +1,150 @@
+#include "benchmark_pch.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+#include <webpp/cache/cache.hpp>
+#include <webpp/cache/lru_cache.hpp>
+#include <webpp/cache/mmap_cache.hpp>
+#include <webpp/cache/sharded_cache.hpp>
+#include <webpp/cache/tinylfu_cache.hpp>
+
+using namespace webpp;
+
+namespace {
+    constexpr int key_count  = 100'000;
+    constexpr int cache_size = 1'000;
+
+    // the keys of the requests: a few are popular, most of them are not (Zipf, s = 1)
+    std::vector<std::string> const& zipf_keys() {
+        static std::vector<std::string> const keys = [] {
+            std::vector<double> weights;
+            for (int i = 1; i <= key_count; i++)
+                weights.push_back(1.0 / i);
+            std::mt19937                    gen{42};
+            std::discrete_distribution<int> dist{weights.begin(), weights.end()};
+            std::vector<std::string>        res;
+            for (int i = 0; i < 200'000; i++)
+                res.push_back("/page/" + std::to_string(dist(gen)));
+            return res;
+        }();
+        return keys;
+    }
+
+    template <typename Cache>
+    void cache_zipf(benchmark::State& state) {
+        auto const& keys = zipf_keys();
+        Cache       cache{cache_size};
+        std::size_t i    = 0;
+        std::size_t hits = 0;
+        for (auto _ : state) {
+            auto const& key = keys[i++ % keys.size()];
+            if (auto* value = cache.find(key)) {
+                benchmark::DoNotOptimize(value);
+                hits++;
+            } else {
+                cache.set(key, "response");
+            }
+        }
+        state.counters["hit_ratio"] = static_cast<double>(hits) / static_cast<double>(i);
+    }
+
+    // one cache with one lock, for comparison
+    struct single_lock_cache {
+        std::mutex  lock;
+        lru_cache<> cache{64 * cache_size};
+
+        bool get(std::string const& key, std::string& out) {
+            std::scoped_lock const guard{lock};
+            if (auto const* value = cache.find(key)) {
+                out = *value;
+                return true;
+            }
+            return false;
+        }
+    };
+
+    std::vector<std::string> const& hot_keys() {
+        static std::vector<std::string> const keys = [] {
+            std::vector<std::string> res;
+            for (int i = 0; i < cache_size; i++)
+                res.push_back("/page/" + std::to_string(i));
+            return res;
+        }();
+        return keys;
+    }
+} // namespace
+
+static void cache_lru_zipf(benchmark::State& state) {
+    cache_zipf<lru_cache<>>(state);
+}
+BENCHMARK(cache_lru_zipf);
+
+static void cache_tinylfu_zipf(benchmark::State& state) {
+    cache_zipf<tinylfu_cache<>>(state);
+}
+BENCHMARK(cache_tinylfu_zipf);
+
+static void cache_single_lock_get(benchmark::State& state) {
+    static single_lock_cache cache;
+    auto const&              keys = hot_keys();
+    if (state.thread_index() == 0)
+        for (auto const& key : keys)
+            cache.cache.set(key, "response");
+    std::string out;
+    std::size_t i = static_cast<std::size_t>(state.thread_index()) * 101;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(cache.get(keys[i++ % keys.size()], out));
+}
+BENCHMARK(cache_single_lock_get)->Threads(1)->Threads(4);
+
+static void cache_sharded_get(benchmark::State& state) {
+    static sharded_cache<> cache{64 * cache_size};
+    auto const&            keys = hot_keys();
+    if (state.thread_index() == 0)
+        for (auto const& key : keys)
+            cache.set(key, "response");
+    std::size_t i = static_cast<std::size_t>(state.thread_index()) * 101;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(cache.get(keys[i++ % keys.size()]));
+}
+BENCHMARK(cache_sharded_get)->Threads(1)->Threads(4);
+
+static void cache_direct_get(benchmark::State& state) {
+    lru_cache<int, int> cache{cache_size};
+    for (int i = 0; i < cache_size; i++)
+        cache.set(i, i);
+    int i = 0;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(cache.get(i++ % cache_size, -1));
+}
+BENCHMARK(cache_direct_get);
+
+static void cache_unified_get(benchmark::State& state) {
+    unified_caches<lru_cache<std::string, std::string>, lru_cache<long, long>, lru_cache<int, int>> caches{
+      lru_cache<std::string, std::string>{cache_size},
+      lru_cache<long, long>{cache_size},
+      lru_cache<int, int>{cache_size}};
+    for (int i = 0; i < cache_size; i++)
+        caches.set(i, i);
+    int i = 0;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(caches.get(i++ % cache_size, -1));
+}
+BENCHMARK(cache_unified_get);
+
+static void cache_mmap_get(benchmark::State& state) {
+    auto const path = std::filesystem::temp_directory_path() / "webpp-cache-benchmark";
+    mmap_cache  cache{path};
+    auto const& keys = hot_keys();
+    for (auto const& key : keys)
+        cache.set(key, "response");
+    std::size_t i = 0;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(cache.get(keys[i++ % keys.size()]));
+    std::filesystem::remove(path);
+}
+BENCHMARK(cache_mmap_get);
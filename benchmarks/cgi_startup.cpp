@@ -0,0 +1,88 @@
+#include "benchmark_pch.h"
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <spawn.h>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// The exec-to-first-byte time of a CGI program: from posix_spawn until the first byte of the response is
+// on its stdout. It's mostly the startup of the process (the dynamic loader, the static initializers, and
+// the setup of the interface), which is what a CGI deployment pays on every request. The program is
+// examples/001-hello-world; build it and point WEBPP_CGI_BINARY at it (the default is where it's
+// installed). The "until_exit" counter is the time until the process has exited, in microseconds.
+
+namespace {
+    std::string cgi_binary() {
+        if (auto const* path = std::getenv("WEBPP_CGI_BINARY"))
+            return path;
+        return "/srv/http/cgi-bin/webpp_helloworld";
+    }
+
+    void cgi_startup(benchmark::State& state) {
+        auto const binary = cgi_binary();
+        if (::access(binary.c_str(), X_OK) != 0) {
+            state.SkipWithError(("Can't execute " + binary + "; set WEBPP_CGI_BINARY").c_str());
+            return;
+        }
+        char* const argv[] = {const_cast<char*>(binary.c_str()), nullptr};
+        char* const envp[] = {const_cast<char*>("GATEWAY_INTERFACE=CGI/1.1"),
+                              const_cast<char*>("SERVER_PROTOCOL=HTTP/1.1"),
+                              const_cast<char*>("REQUEST_METHOD=GET"),
+                              const_cast<char*>("SCRIPT_NAME=/cgi-bin/webpp_helloworld"),
+                              const_cast<char*>("REQUEST_URI=/cgi-bin/webpp_helloworld"),
+                              const_cast<char*>("QUERY_STRING="),
+                              const_cast<char*>("HTTP_HOST=localhost"),
+                              nullptr};
+
+        double until_exit = 0;
+        for (auto _ : state) {
+            int fds[2];
+            if (::pipe(fds) != 0) {
+                state.SkipWithError("Can't make the pipe of the stdout");
+                break;
+            }
+            posix_spawn_file_actions_t actions;
+            posix_spawn_file_actions_init(&actions);
+            posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+            posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+            posix_spawn_file_actions_addclose(&actions, fds[0]);
+            posix_spawn_file_actions_addclose(&actions, fds[1]);
+
+            auto const start = std::chrono::steady_clock::now();
+            pid_t      pid   = 0;
+            auto const error = ::posix_spawn(&pid, binary.c_str(), &actions, nullptr, argv, envp);
+            posix_spawn_file_actions_destroy(&actions);
+            ::close(fds[1]);
+            if (error != 0) {
+                ::close(fds[0]);
+                state.SkipWithError("Can't start the CGI program");
+                break;
+            }
+
+            std::array<char, 4096> buf;
+            auto                   n          = ::read(fds[0], buf.data(), buf.size());
+            auto const             first_byte = std::chrono::steady_clock::now();
+            bool const             responded  = n > 0;
+            while (n > 0)
+                n = ::read(fds[0], buf.data(), buf.size());
+            int status = 0;
+            ::waitpid(pid, &status, 0);
+            auto const exited = std::chrono::steady_clock::now();
+            ::close(fds[0]);
+
+            if (!responded || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                state.SkipWithError("The CGI program didn't respond");
+                break;
+            }
+            state.SetIterationTime(std::chrono::duration<double>(first_byte - start).count());
+            until_exit += std::chrono::duration<double, std::micro>(exited - start).count();
+        }
+        state.counters["until_exit"] = benchmark::Counter(until_exit, benchmark::Counter::kAvgIterations);
+    }
+} // namespace
+
+BENCHMARK(cgi_startup)->UseManualTime()->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,85 @@
+// A synthetic translation unit for measuring how the compile time of the
+// extension packs and of the const lists grows with their sizes; see
+// measure.cmake. It's only compiled, never run.
+
+#include "../../core/include/webpp/extensions/extension.hpp"
+#include "../../core/include/webpp/traits/std_traits.hpp"
+#include "../../core/include/webpp/utils/const_list.hpp"
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#ifndef WEBPP_BENCH_EXTENSIONS
+#    define WEBPP_BENCH_EXTENSIONS 32
+#endif
+
+#ifndef WEBPP_BENCH_ROUTES
+#    define WEBPP_BENCH_ROUTES 32
+#endif
+
+using namespace webpp;
+
+template <std::size_t I>
+struct bench_mother {
+    template <typename TraitsType>
+    struct type {
+        std::size_t value = I;
+    };
+};
+
+template <std::size_t I>
+struct bench_child {
+    template <typename TraitsType, typename Parent>
+    struct type : public Parent {};
+};
+
+// each one brings two mothers, and one of them is the next one's too, so
+// they have to be made unique
+template <std::size_t I>
+struct bench_holder {
+    using bench_extensions = extension_pack<bench_mother<I>, bench_mother<I + 1>>;
+};
+
+struct bench_descriptor {
+    template <typename ExtensionType>
+    struct has_related_extension_pack {
+        static constexpr bool value = requires {
+            typename ExtensionType::bench_extensions;
+        };
+    };
+
+    template <typename ExtensionType>
+    using related_extension_pack_type = typename ExtensionType::bench_extensions;
+
+    template <typename ExtensionListType, typename TraitsType, typename EList>
+    struct mid_level_extensie_type : public EList {};
+
+    template <typename ExtensionListType, typename TraitsType, typename EList>
+    struct final_extensie_type : public EList {};
+};
+
+template <std::size_t... I>
+auto make_bench_pack(std::index_sequence<I...>) -> extension_pack<bench_holder<I>..., bench_child<I>...>;
+
+using bench_pack = decltype(make_bench_pack(std::make_index_sequence<WEBPP_BENCH_EXTENSIONS>{}));
+using bench_extensie = typename bench_pack::template extensie_type<std_traits, bench_descriptor>;
+
+static_assert(sizeof(bench_extensie) != 0);
+
+template <typename... E>
+constexpr std::size_t pack_size(extension_pack<E...> const*) noexcept {
+    return sizeof...(E);
+}
+
+using bench_mothers = typename bench_pack::template merge_extensions<bench_descriptor,
+                                                                    bench_pack::template mother_type>;
+static_assert(pack_size(static_cast<bench_mothers const*>(nullptr)) == WEBPP_BENCH_EXTENSIONS + 1);
+
+template <std::size_t... I>
+constexpr auto make_bench_routes(std::index_sequence<I...>) noexcept {
+    return make_const_list(std::integral_constant<std::size_t, I>{}...);
+}
+
+constexpr auto bench_routes = make_bench_routes(std::make_index_sequence<WEBPP_BENCH_ROUTES>{});
+static_assert(bench_routes.template at<WEBPP_BENCH_ROUTES - 1>() == WEBPP_BENCH_ROUTES - 1);
@@ -0,0 +1,80 @@
+# Compiles extension_pack.cpp once for each size and prints how long it
+# took, so it's easy to see if the compile time of the extension packs and
+# of the const lists is growing linearly or not.
+#
+#   cmake -DCXX=g++ -P measure.cmake
+#   cmake -DCXX=clang++ -DSIZES="8;16;32;64;128" -DOUTPUT_DIR=/tmp/ct -P measure.cmake
+#
+# With clang, the -ftime-trace files are left in OUTPUT_DIR (open them in
+# chrome://tracing or speedscope); with gcc the -ftime-report of each size
+# is written there instead. TEMPLIGHT can be set to a templight++ binary to
+# get the template instantiation profiles as well.
+
+cmake_minimum_required(VERSION 3.23) # for the microseconds in the timestamps
+
+if (NOT CXX)
+    set(CXX c++)
+endif ()
+if (NOT SIZES)
+    set(SIZES 8 16 32 64 128)
+endif ()
+if (NOT SOURCE)
+    set(SOURCE "${CMAKE_CURRENT_LIST_DIR}/extension_pack.cpp")
+endif ()
+if (NOT OUTPUT_DIR)
+    set(OUTPUT_DIR "${CMAKE_CURRENT_BINARY_DIR}/compile_time")
+endif ()
+file(MAKE_DIRECTORY "${OUTPUT_DIR}")
+
+execute_process(COMMAND ${CXX} --version OUTPUT_VARIABLE compiler_version)
+if (compiler_version MATCHES "clang")
+    set(profile_flag -ftime-trace)
+else ()
+    set(profile_flag -ftime-report)
+endif ()
+
+message(STATUS "size    extensions        routes          both")
+foreach (size IN LISTS SIZES)
+    set(line "")
+    foreach (kind extensions routes both)
+        if (kind STREQUAL "extensions")
+            set(defines -DWEBPP_BENCH_EXTENSIONS=${size} -DWEBPP_BENCH_ROUTES=1)
+        elseif (kind STREQUAL "routes")
+            set(defines -DWEBPP_BENCH_EXTENSIONS=1 -DWEBPP_BENCH_ROUTES=${size})
+        else ()
+            set(defines -DWEBPP_BENCH_EXTENSIONS=${size} -DWEBPP_BENCH_ROUTES=${size})
+        endif ()
+        set(output "${OUTPUT_DIR}/${kind}_${size}")
+
+        string(TIMESTAMP start "%s%f")
+        execute_process(
+                COMMAND ${CXX} -std=c++2a -c ${defines} ${profile_flag} "${SOURCE}" -o "${output}.o"
+                RESULT_VARIABLE result
+                ERROR_VARIABLE report)
+        string(TIMESTAMP end "%s%f")
+        if (NOT result EQUAL 0)
+            message(FATAL_ERROR "Compiling ${kind} ${size} failed:\n${report}")
+        endif ()
+        if (NOT compiler_version MATCHES "clang")
+            file(WRITE "${output}.txt" "${report}")
+        endif ()
+
+        if (TEMPLIGHT)
+            execute_process(
+                    COMMAND ${TEMPLIGHT} -Xtemplight -profiler -Xtemplight -ignore-system -Xtemplight
+                    -output=${output}.trace.pbf -std=c++2a -fsyntax-only ${defines} "${SOURCE}"
+                    RESULT_VARIABLE result)
+        endif ()
+
+        # milliseconds
+        math(EXPR elapsed "(${end} - ${start}) / 1000")
+        string(LENGTH "${elapsed}" width)
+        math(EXPR width "12 - ${width}")
+        string(REPEAT " " ${width} pad)
+        string(APPEND line "${pad}${elapsed}ms")
+    endforeach ()
+    string(LENGTH "${size}" width)
+    math(EXPR width "4 - ${width}")
+    string(REPEAT " " ${width} pad)
+    message(STATUS "${pad}${size}${line}")
+endforeach ()
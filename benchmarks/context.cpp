@@ -0,0 +1,119 @@
+#include "benchmark_pch.h"
+
+#include <string_view>
+#include <webpp/http/interfaces/fcgi.hpp>
+#include <webpp/http/routes/context.hpp>
+#include <webpp/http/routes/path.hpp>
+#include <webpp/utils/uri.hpp>
+
+using namespace webpp;
+
+namespace {
+    struct bench_app {};
+
+    using bench_request   = basic_request<std_traits, fcgi<std_traits, bench_app>>;
+    using bench_context   = simple_context<bench_request>;
+    using path_extension  = routes::path_context_extension<routes::path<>, routes::path_segments>;
+    constexpr auto bench_uri = std::string_view{"/blog/2020/06/some-post-title/comments?page=2"};
+
+    struct bench_fixture {
+        fastcgi::request source;
+        bench_request    req{source};
+
+        bench_fixture() {
+            source.params += char(11);
+            source.params += char(bench_uri.size());
+            source.params += "REQUEST_URI";
+            source.params += bench_uri;
+        }
+    };
+} // namespace
+
+////////////////////////////// Init //////////////////////////////
+
+static void context_init(benchmark::State& state) {
+    bench_fixture fixture;
+    for (auto _ : state) {
+        bench_context ctx{fixture.req};
+        benchmark::DoNotOptimize(ctx);
+    }
+}
+BENCHMARK(context_init);
+
+////////////////////////////// Segments //////////////////////////////
+
+// what each path route used to do
+static void context_segments_uri_parse(benchmark::State& state) {
+    for (auto _ : state) {
+        auto segs = basic_uri<std_traits, false>{std::string_view{bench_uri}}.path_structured();
+        benchmark::DoNotOptimize(segs);
+    }
+}
+BENCHMARK(context_segments_uri_parse);
+
+static void context_segments_parse(benchmark::State& state) {
+    for (auto _ : state) {
+        auto segs = routes::path_segments::parse(bench_uri);
+        benchmark::DoNotOptimize(segs);
+    }
+}
+BENCHMARK(context_segments_parse);
+
+////////////////////////////// Clone //////////////////////////////
+
+// the cost for each path route to add its extension to the context
+static void context_clone_path_extension(benchmark::State& state) {
+    bench_fixture fixture;
+    bench_context ctx{fixture.req};
+    benchmark::DoNotOptimize(ctx.segments());
+    for (auto _ : state) {
+        auto nctx = ctx.template clone<path_extension>();
+        benchmark::DoNotOptimize(nctx);
+    }
+}
+BENCHMARK(context_clone_path_extension);
+
+static void context_clone_nested_path_extension(benchmark::State& state) {
+    bench_fixture fixture;
+    bench_context ctx{fixture.req};
+    benchmark::DoNotOptimize(ctx.segments());
+    for (auto _ : state) {
+        auto nctx  = ctx.template clone<path_extension>();
+        auto nnctx = nctx.template clone<path_extension>();
+        benchmark::DoNotOptimize(nnctx);
+    }
+}
+BENCHMARK(context_clone_nested_path_extension);
+
+////////////////////////////// Layout //////////////////////////////
+
+namespace {
+    template <int N>
+    struct bench_child {
+        struct extension {
+            template <Traits TraitsType, typename ContextType>
+            struct type : public ContextType {
+                template <typename... Args>
+                constexpr type(Args&&... args) noexcept : ContextType{std::forward<Args>(args)...} {}
+
+                int value = N;
+            };
+        };
+    };
+} // namespace
+
+// the fields of the basic context, read through a context with two child extensions (they used to
+// make it a virtual base)
+static void context_fields_two_children(benchmark::State& state) {
+    bench_fixture fixture;
+    bench_context ctx{fixture.req};
+    auto nctx = ctx.template clone<bench_child<1>::extension, bench_child<2>::extension>();
+    for (auto _ : state) {
+        auto* ptr = &nctx;
+        benchmark::DoNotOptimize(ptr);
+        benchmark::DoNotOptimize(ptr->request);
+        benchmark::DoNotOptimize(ptr->router_features.profiler);
+        benchmark::DoNotOptimize(ptr->segments().size());
+    }
+}
+BENCHMARK(context_fields_two_children);
@@ -0,0 +1,235 @@
+#include "benchmark_pch.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <webpp/http/bodies/string.hpp>
+#include <webpp/http/cookies/cookie_cipher.hpp>
+#include <webpp/http/cookies/cookie_header.hpp>
+#include <webpp/http/cookies/cookie_jar.hpp>
+#include <webpp/http/response.hpp>
+#include <webpp/utils/strings.hpp>
+
+using namespace webpp;
+
+namespace {
+    using hashed_response = typename extension_pack<string_response>::template extensie_type<
+      std_traits, basic_response_descriptor>;
+    using flat_response = typename extension_pack<flat_headers, string_response>::template extensie_type<
+      std_traits, basic_response_descriptor>;
+
+    // the headers of a usual response
+    template <typename ResponseType>
+    void fill_headers(ResponseType& res) {
+        res.header.emplace("Cache-Control", "no-cache");
+        res.header.emplace("Date", "Wed, 21 Oct 2015 07:28:00 GMT");
+        res.header.emplace("Server", "webpp");
+        res.header.emplace("X-Content-Type-Options", "nosniff");
+        res.header.emplace("Vary", "Accept-Encoding");
+        res.header.emplace("ETag", "\"33a64df551425fcc55e4d42a148795d9f25f89d4\"");
+        res.calculate_default_headers();
+    }
+
+    template <typename ResponseType>
+    void build_headers(benchmark::State& state) {
+        for (auto _ : state) {
+            ResponseType res{200u, "hello"};
+            fill_headers(res);
+            benchmark::DoNotOptimize(res.header.contains("ETag"));
+            benchmark::DoNotOptimize(res.header.str());
+        }
+    }
+
+    template <typename ResponseType>
+    void lookup_headers(benchmark::State& state) {
+        ResponseType res{200u, "hello"};
+        fill_headers(res);
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(res.header.contains("content-length"));
+            benchmark::DoNotOptimize(res.header.contains("Location"));
+        }
+    }
+} // namespace
+
+static void headers_hashed_build(benchmark::State& state) {
+    build_headers<hashed_response>(state);
+}
+BENCHMARK(headers_hashed_build);
+
+static void headers_flat_build(benchmark::State& state) {
+    build_headers<flat_response>(state);
+}
+BENCHMARK(headers_flat_build);
+
+static void headers_hashed_lookup(benchmark::State& state) {
+    lookup_headers<hashed_response>(state);
+}
+BENCHMARK(headers_hashed_lookup);
+
+static void headers_flat_lookup(benchmark::State& state) {
+    lookup_headers<flat_response>(state);
+}
+BENCHMARK(headers_flat_lookup);
+
+// the six-way compare of the trims before they were vectorized
+static void headers_trim_find_if(benchmark::State& state) {
+    std::string const value = "    " + std::string(40, 'v') + "        ";
+    for (auto _ : state) {
+        std::string_view str = value;
+        auto const       is_space = [](char c) {
+            return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v';
+        };
+        auto const start = std::find_if_not(str.begin(), str.end(), is_space);
+        str.remove_prefix(static_cast<std::size_t>(start - str.begin()));
+        auto const end = std::find_if_not(str.rbegin(), str.rend(), is_space);
+        str.remove_suffix(static_cast<std::size_t>(end - str.rbegin()));
+        benchmark::DoNotOptimize(str);
+    }
+}
+BENCHMARK(headers_trim_find_if);
+
+static void headers_trim(benchmark::State& state) {
+    std::string const value = "    " + std::string(40, 'v') + "        ";
+    for (auto _ : state) {
+        std::string_view str = value;
+        trim<std_traits>(str);
+        benchmark::DoNotOptimize(str);
+    }
+}
+BENCHMARK(headers_trim);
+
+static void headers_lower_per_char(benchmark::State& state) {
+    std::string name = "Access-Control-Allow-Credentials";
+    for (auto _ : state) {
+        for (auto& c : name)
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        benchmark::DoNotOptimize(name.data());
+        name[0] = 'A';
+    }
+}
+BENCHMARK(headers_lower_per_char);
+
+static void headers_lower(benchmark::State& state) {
+    std::string name = "Access-Control-Allow-Credentials";
+    for (auto _ : state) {
+        ascii_to_lower(name.data(), name.size());
+        benchmark::DoNotOptimize(name.data());
+        name[0] = 'A';
+    }
+}
+BENCHMARK(headers_lower);
+
+namespace {
+    // a Cookie header of a site with a lot of analytics
+    std::string const cookie_header = [] {
+        std::string res = "session=2b7e151628aed2a6abf7158809cf4f3c";
+        for (int i = 0; i < 35; i++)
+            res += "; _tracker" + std::to_string(i) + "=GA1.2." + std::to_string(1'000'000 + i * 7919);
+        return res;
+    }();
+} // namespace
+
+// a copy of each pair, the way a jar of cookies that own their strings has them
+static void headers_cookies_copied(benchmark::State& state) {
+    for (auto _ : state) {
+        std::vector<std::pair<std::string, std::string>> jar;
+        std::string_view                                 header = cookie_header;
+        for (cookie_pair pair; details::next_cookie(header, pair);)
+            jar.emplace_back(pair.name, pair.value);
+        benchmark::DoNotOptimize(jar.data());
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * cookie_header.size()));
+}
+BENCHMARK(headers_cookies_copied);
+
+static void headers_cookies_view(benchmark::State& state) {
+    for (auto _ : state) {
+        cookie_header_view<> const cookies{cookie_header};
+        benchmark::DoNotOptimize(cookies.value("session").data());
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * cookie_header.size()));
+}
+BENCHMARK(headers_cookies_view);
+
+// the cookies of a response that sets some of them more than once (the login, then the session refresh)
+static void headers_cookie_jar(benchmark::State& state) {
+    std::vector<std::string> names;
+    for (int i = 0; i < 30; i++)
+        names.push_back("cookie" + std::to_string(i));
+    for (auto _ : state) {
+        response_cookie_jar<std_traits> jar;
+        for (int round = 0; round < 2; round++)
+            for (auto const& name : names)
+                jar.emplace_back(name, "value");
+        jar.remove_duplicates();
+        for (auto const& name : names)
+            benchmark::DoNotOptimize(jar.find(name));
+    }
+}
+BENCHMARK(headers_cookie_jar);
+
+namespace {
+    response_cookie<std_traits> session_cookie() {
+        response_cookie<std_traits> cookie{"session", "0123456789abcdef0123456789abcdef"};
+        cookie.path("/").domain("example.com").secure(true).host_only(true).max_age(3600);
+        cookie.expires_in(std::chrono::hours(24));
+        return cookie;
+    }
+} // namespace
+
+// the Set-Cookie header of a session cookie that's set on every response
+static void headers_set_cookie_render(benchmark::State& state) {
+    auto const cookie = session_cookie();
+    for (auto _ : state) {
+        std::string header = "Set-Cookie: ";
+        cookie.append_to(header);
+        benchmark::DoNotOptimize(header);
+    }
+}
+BENCHMARK(headers_set_cookie_render);
+
+static void headers_set_cookie_serialized(benchmark::State& state) {
+    auto cookie = session_cookie();
+    cookie.serialize();
+    for (auto _ : state) {
+        std::string header = "Set-Cookie: ";
+        cookie.append_to(header);
+        benchmark::DoNotOptimize(header);
+    }
+}
+BENCHMARK(headers_set_cookie_serialized);
+
+// the session state that's kept in an encrypted cookie instead of a session store
+static void headers_cookie_seal(benchmark::State& state) {
+    cookie_cipher cipher;
+    if (!cipher.rotate()) {
+        state.SkipWithError("the encryption is not compiled in");
+        return;
+    }
+    std::string const value(256, 's');
+    for (auto _ : state) {
+        std::string sealed;
+        benchmark::DoNotOptimize(cipher.seal("session", value, sealed));
+        benchmark::DoNotOptimize(sealed);
+    }
+}
+BENCHMARK(headers_cookie_seal);
+
+static void headers_cookie_open(benchmark::State& state) {
+    cookie_cipher cipher;
+    std::string   sealed;
+    if (!cipher.rotate() || !cipher.seal("session", std::string(256, 's'), sealed)) {
+        state.SkipWithError("the encryption is not compiled in");
+        return;
+    }
+    for (auto _ : state) {
+        std::string value;
+        benchmark::DoNotOptimize(cipher.open("session", sealed, value));
+        benchmark::DoNotOptimize(value);
+    }
+}
+BENCHMARK(headers_cookie_open);
@@ -0,0 +1,54 @@
+#include "benchmark_pch.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <webpp/encoding/html.hpp>
+
+using namespace webpp;
+
+namespace {
+    // a user's comment: mostly text, a few quotes and an ampersand here and there
+    std::string const comment = [] {
+        std::string res;
+        for (int i = 0; i < 64; i++)
+            res += i % 8 == 0 ? "I'd say \"Tom & Jerry\" is the best one. " : "Some plain text of a comment here. ";
+        return res;
+    }();
+
+    // the char at a time loop, to compare with
+    void escape_bytewise(std::string_view str, std::string& out) {
+        for (auto const c : str) {
+            switch (c) {
+                case '<': out += "&lt;"; break;
+                case '>': out += "&gt;"; break;
+                case '&': out += "&amp;"; break;
+                case '"': out += "&quot;"; break;
+                case '\'': out += "&#39;"; break;
+                default: out += c;
+            }
+        }
+    }
+} // namespace
+
+static void html_escape_bytewise(benchmark::State& state) {
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        escape_bytewise(comment, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * comment.size()));
+}
+BENCHMARK(html_escape_bytewise);
+
+static void html_escape_runs(benchmark::State& state) {
+    std::string out;
+    for (auto _ : state) {
+        out.clear();
+        encoding::escape_html(comment, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * comment.size()));
+}
+BENCHMARK(html_escape_runs);
@@ -0,0 +1,54 @@
+#include "benchmark_pch.h"
+
+#include <string>
+#include <string_view>
+#include <webpp/http/interfaces/http1/request_parser.hpp>
+#include <webpp/http/interfaces/http1/scanner.hpp>
+
+using namespace webpp;
+
+// a request that looks like what a browser sends
+static constexpr std::string_view browser_request =
+  "GET /wp-content/uploads/2010/03/hello-kitty-darth-vader-pink.jpg HTTP/1.1\r\n"
+  "Host: www.kittyhell.com\r\n"
+  "User-Agent: Mozilla/5.0 (Macintosh; U; Intel Mac OS X 10.6; ja-JP-mac; rv:1.9.2.3) Gecko/20100401 "
+  "Firefox/3.6.3 Pathtraq/0.9\r\n"
+  "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+  "Accept-Language: ja,en-us;q=0.7,en;q=0.3\r\n"
+  "Accept-Encoding: gzip,deflate\r\n"
+  "Accept-Charset: Shift_JIS,utf-8;q=0.7,*;q=0.7\r\n"
+  "Keep-Alive: 115\r\n"
+  "Connection: keep-alive\r\n"
+  "Cookie: wp_ozh_wsa_visits=2; wp_ozh_wsa_visit_lasttime=xxxxxxxxxx; "
+  "__utma=xxxxxxxxx.xxxxxxxxxx.xxxxxxxxxx.xxxxxxxxxx.xxxxxxxxxx.x; "
+  "__utmz=xxxxxxxxx.xxxxxxxxxx.x.x.utmccn=(referral)|utmcsr=reader.livedoor.com|utmcct=/reader/|utmcmd=referral\r\n"
+  "\r\n";
+
+template <typename Scanner>
+static void http1_parse_request(benchmark::State& state) {
+    http1::request_view req;
+    std::size_t         consumed = 0;
+    for (auto _ : state) {
+        auto status = http1::parse_request<Scanner>(browser_request, req, consumed);
+        benchmark::DoNotOptimize(status);
+        benchmark::DoNotOptimize(req);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * browser_request.size()));
+}
+BENCHMARK_TEMPLATE(http1_parse_request, http1::scalar_scanner);
+BENCHMARK_TEMPLATE(http1_parse_request, http1::simd_scanner);
+
+
+template <typename Scanner>
+static void http1_scan_lines(benchmark::State& state) {
+    for (auto _ : state) {
+        std::size_t pos = 0;
+        while ((pos = Scanner::find(browser_request, pos, '\r', '\r')) != std::string_view::npos) {
+            benchmark::DoNotOptimize(pos);
+            pos++;
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * browser_request.size()));
+}
+BENCHMARK_TEMPLATE(http1_scan_lines, http1::scalar_scanner);
+BENCHMARK_TEMPLATE(http1_scan_lines, http1::simd_scanner);
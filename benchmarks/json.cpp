@@ -0,0 +1,130 @@
+#include "benchmark_pch.h"
+
+#include <string>
+#include <vector>
+#include <webpp/utils/json.hpp>
+
+using namespace webpp;
+
+namespace {
+    struct item {
+        int         id;
+        std::string name;
+        double      price;
+        bool        available;
+
+        template <typename WriterType>
+        void to_json(WriterType& out) const {
+            out.begin_object()
+              .member("id", id)
+              .member("name", name)
+              .member("price", price)
+              .member("available", available)
+              .end_object();
+        }
+    };
+
+    std::vector<item> make_items() {
+        std::vector<item> items;
+        for (int i = 0; i < 100; i++)
+            items.push_back({i, "the product number " + std::to_string(i), i * 1.25, i % 3 != 0});
+        return items;
+    }
+} // namespace
+
+static void json_write_items(benchmark::State& state) {
+    auto const  items = make_items();
+    std::string out;
+    for (auto _ : state) {
+        out.clear(); // the capacity is reused, like a recycled response
+        json::serialize(out, items);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * out.size()));
+}
+BENCHMARK(json_write_items);
+
+static void json_escape_long_string(benchmark::State& state) {
+    std::string const text(4096, 'a');
+    std::string       out;
+    for (auto _ : state) {
+        out.clear();
+        json::write_string(out, text);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+}
+BENCHMARK(json_escape_long_string);
+
+static void json_read_items(benchmark::State& state) {
+    std::string text;
+    json::serialize(text, make_items());
+    for (auto _ : state) {
+        json::reader in{text};
+        std::size_t  count = 0;
+        while (in.next() != json::token::end)
+            count++;
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+}
+BENCHMARK(json_read_items);
+
+namespace {
+    // about 50KB, with the two fields that are wanted at the end of it
+    std::string make_payload() {
+        std::string text = R"({"items": )";
+        json::serialize(text, std::vector(6, make_items()));
+        json::serialize(text.append(R"(, "notes": )"), std::vector<std::string>(50, "a note \"quoted\" in it"));
+        text += R"(, "user": {"name": "someone", "id": 42}})";
+        return text;
+    }
+} // namespace
+
+static void json_two_fields_reader(benchmark::State& state) {
+    auto const text = make_payload();
+    for (auto _ : state) {
+        json::reader     in{text};
+        std::string_view name;
+        int              id = 0;
+        in.next();
+        while (in.next() == json::token::key) {
+            if (in.raw() != "user") {
+                in.next();
+                in.skip();
+                continue;
+            }
+            in.next();
+            while (in.next() == json::token::key) {
+                auto const key = in.raw();
+                in.next();
+                if (key == "name")
+                    name = in.raw();
+                else if (key == "id")
+                    in.number_value(id);
+                else
+                    in.skip();
+            }
+        }
+        benchmark::DoNotOptimize(name);
+        benchmark::DoNotOptimize(id);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+}
+BENCHMARK(json_two_fields_reader);
+
+static void json_two_fields_document(benchmark::State& state) {
+    auto const     text = make_payload();
+    json::document doc;
+    for (auto _ : state) {
+        doc.parse(text);
+        auto const user = doc["user"];
+        auto const name = user["name"].raw();
+        int        id   = 0;
+        user["id"].number_value(id);
+        benchmark::DoNotOptimize(name);
+        benchmark::DoNotOptimize(id);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+}
+BENCHMARK(json_two_fields_document);
@@ -0,0 +1,52 @@
+#include "benchmark_pch.h"
+
+#include <atomic>
+#include <webpp/utils/metrics.hpp>
+
+using namespace webpp;
+
+namespace {
+    metrics_registry registry;
+
+    // the usual counter: one atomic that all the threads add to
+    std::atomic<std::uint64_t> shared_counter{0};
+} // namespace
+
+static void Metrics_SharedAtomic(benchmark::State& state) {
+    for (auto _ : state)
+        shared_counter.fetch_add(1, std::memory_order_relaxed);
+}
+BENCHMARK(Metrics_SharedAtomic)->ThreadRange(1, 8);
+
+static void Metrics_Counter(benchmark::State& state) {
+    static auto const counter = registry.counter("bench_total", "");
+    for (auto _ : state)
+        counter.inc();
+}
+BENCHMARK(Metrics_Counter)->ThreadRange(1, 8);
+
+static void Metrics_Histogram(benchmark::State& state) {
+    static auto const histogram = registry.histogram("bench_seconds", "");
+    double            value     = 0;
+    for (auto _ : state) {
+        histogram.observe(value);
+        value = value > 1 ? 0 : value + 0.001;
+    }
+}
+BENCHMARK(Metrics_Histogram)->ThreadRange(1, 8);
+
+static void Metrics_Text(benchmark::State& state) {
+    metrics_registry many;
+    for (int i = 0; i < 100; i++) {
+        auto const name = std::to_string(i);
+        many.counter("requests_total", "", {{"route", name}}).inc();
+        many.histogram("latency_seconds", "", {{"route", name}}).observe(0.01);
+    }
+    std::string text;
+    for (auto _ : state) {
+        text.clear();
+        many.write_text(text);
+        benchmark::DoNotOptimize(text.data());
+    }
+}
+BENCHMARK(Metrics_Text);
@@ -0,0 +1,108 @@
+#include "benchmark_pch.h"
+
+#include <array>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+#include <webpp/http/bodies/string.hpp>
+#include <webpp/http/cookies/cookie_jar.hpp>
+#include <webpp/http/interfaces/fcgi.hpp>
+#include <webpp/http/response.hpp>
+#include <webpp/http/routes/router.hpp>
+#include <webpp/traits/std_pmr_traits.hpp>
+
+using namespace webpp;
+
+namespace {
+    struct bench_app {};
+
+    template <typename TraitsType>
+    struct bench_fixture {
+        using request_type = basic_request<TraitsType, fcgi<TraitsType, bench_app>>;
+
+        fastcgi::request source;
+        request_type     req{source};
+
+        bench_fixture(std::string_view uri) {
+            source.params += char(11);
+            source.params += char(uri.size());
+            source.params += "REQUEST_URI";
+            source.params += uri;
+        }
+    };
+
+    template <typename TraitsType>
+    using bench_response = basic_response<TraitsType, empty_extension_pack, response_headers<TraitsType>,
+                                          string_body::type<TraitsType>>;
+
+    // the arena that the pmr benchmarks get their memory from; it's released
+    // after each iteration, like the arena of a request
+    struct bench_arena {
+        alignas(std::max_align_t) std::array<std::byte, 16 * 1024> buffer;
+        std::pmr::monotonic_buffer_resource resource{buffer.data(), buffer.size()};
+        std::pmr::memory_resource*          previous = std::pmr::set_default_resource(&resource);
+
+        ~bench_arena() {
+            std::pmr::set_default_resource(previous);
+        }
+    };
+
+    template <typename TraitsType>
+    void build_response() {
+        bench_response<TraitsType> res{200u, "a body that is too long for the small string optimization"};
+        res.calculate_default_headers();
+
+        response_cookie_jar<TraitsType> jar;
+        jar.emplace_back("session", "a session id that doesn't fit in the string either");
+        jar.emplace_back("theme", "dark");
+        jar.remove_duplicates();
+
+        benchmark::DoNotOptimize(res.header.str());
+        benchmark::DoNotOptimize(jar);
+    }
+
+    constexpr auto route = [](Context auto& ctx) noexcept -> std::optional<std::string_view> {
+        if (ctx.request->request_uri().starts_with("/about"))
+            return "about";
+        return std::nullopt;
+    };
+} // namespace
+
+static void pmr_traits_response_std(benchmark::State& state) {
+    for (auto _ : state)
+        build_response<std_traits>();
+}
+BENCHMARK(pmr_traits_response_std);
+
+static void pmr_traits_response_arena(benchmark::State& state) {
+    bench_arena arena;
+    for (auto _ : state) {
+        build_response<std_pmr_traits>();
+        arena.resource.release();
+    }
+}
+BENCHMARK(pmr_traits_response_arena);
+
+static void pmr_traits_router_std(benchmark::State& state) {
+    bench_fixture<std_traits> fixture{"/about/team"};
+    router                    _router{route};
+    for (auto _ : state) {
+        auto res = _router(fixture.req);
+        benchmark::DoNotOptimize(res);
+    }
+}
+BENCHMARK(pmr_traits_router_std);
+
+static void pmr_traits_router_arena(benchmark::State& state) {
+    bench_fixture<std_pmr_traits> fixture{"/about/team"};
+    router                        _router{route};
+    bench_arena                   arena;
+    for (auto _ : state) {
+        {
+            auto res = _router(fixture.req);
+            benchmark::DoNotOptimize(res);
+        }
+        arena.resource.release();
+    }
+}
+BENCHMARK(pmr_traits_router_arena);
@@ -0,0 +1,147 @@
+#include "allocations.hpp"
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <webpp/http/interfaces/fcgi.hpp>
+#include <webpp/http/routes/dynamic_router.hpp>
+#include <webpp/http/routes/router.hpp>
+
+// The whole path of a request through the router: the request and its context are made from the FastCGI
+// params, routed through tables of 10, 100 and 1000 routes (a mix of the methods, the path captures, and
+// the requests that nothing matches), and the response is made. The time is per request, and the
+// "allocs/iter" counter is the number of the heap allocations per request; watch both of them for the
+// regressions of the hot path.
+
+using namespace webpp;
+using namespace webpp::routes;
+
+namespace {
+    struct throughput_app {};
+    using throughput_request = basic_request<std_traits, fcgi<std_traits, throughput_app>>;
+    using throughput_context = simple_context<throughput_request>;
+
+    // "/api-NNN/"
+    template <std::size_t I>
+    constexpr std::array<char, 9> api_name{
+      '/', 'a', 'p', 'i', '-', char('0' + I / 100 % 10), char('0' + I / 10 % 10), char('0' + I % 10), '/'};
+
+    // "/api-NNN/items/{id}", for one method
+    template <std::size_t I, http_method Method>
+    struct api_route {
+        [[nodiscard]] static constexpr http_method static_method() noexcept {
+            return Method;
+        }
+
+        [[nodiscard]] static constexpr std::string_view static_path_prefix() noexcept {
+            return {api_name<I>.data(), api_name<I>.size()};
+        }
+
+        std::optional<std::string_view> operator()(throughput_context& ctx) const noexcept {
+            std::string_view path = ctx.request->request_uri();
+            if (!path.starts_with(static_path_prefix()))
+                return std::nullopt;
+            path.remove_prefix(static_path_prefix().size());
+            if (!path.starts_with("items/"))
+                return std::nullopt;
+            return path.substr(6); // the id
+        }
+    };
+
+    template <std::size_t... I>
+    auto make_static_router(std::index_sequence<I...>) {
+        return router{api_route<I, http_method::get>{}..., api_route<I, http_method::post>{}...};
+    }
+
+    auto make_dynamic_router(std::size_t count) {
+        dynamic_router<throughput_context> res;
+        for (std::size_t i = 0; i < count; i++) {
+            auto const base = "/api-" + std::to_string(i);
+            res.on(base + "/items/{id}", [](throughput_context& ctx, path_captures const& captures) noexcept {
+                return ctx.request->request_method() == std::string_view{"GET"} ? captures["id"] : "created";
+            });
+            res.on(base + "/items/{id}/comments/{comment}",
+                   [](throughput_context&, path_captures const& captures) noexcept {
+                       return captures["comment"];
+                   });
+        }
+        return res;
+    }
+
+    // the FastCGI params of a request
+    struct fake_request {
+        fastcgi::request source;
+
+        fake_request(std::string_view uri, std::string_view method) {
+            auto const add = [this](std::string_view name, std::string_view value) {
+                source.params += char(name.size());
+                source.params += char(value.size());
+                source.params += name;
+                source.params += value;
+            };
+            add("REQUEST_URI", uri);
+            add("REQUEST_METHOD", method);
+            add("HTTP_HOST", "example.com");
+            add("HTTP_ACCEPT", "text/html,application/json;q=0.9");
+        }
+    };
+
+    /**
+     * A mix of the requests to the routes: mostly GETs, some POSTs, and one in sixteen that nothing
+     * matches; the names of the static routes are padded, and the dynamic ones have deeper paths too
+     */
+    std::vector<fake_request> make_requests(std::size_t route_count, bool dynamic) {
+        std::vector<fake_request> res;
+        res.reserve(256);
+        for (std::size_t i = 0; i < 256; i++) {
+            auto const number = std::to_string(i * 7919 % route_count);
+            auto const base   = "/api-" + (dynamic ? number : std::string(3 - number.size(), '0') + number);
+            auto const id     = std::to_string(i);
+            if (i % 16 == 15) {
+                res.emplace_back("/missing/" + id, "GET");
+            } else if (i % 4 == 3) {
+                res.emplace_back(base + "/items/" + id, "POST");
+            } else if (dynamic && i % 4 == 2) {
+                res.emplace_back(base + "/items/" + id + "/comments/7", "GET");
+            } else {
+                res.emplace_back(base + "/items/" + id, "GET");
+            }
+        }
+        return res;
+    }
+
+    template <typename Router>
+    void route_requests(benchmark::State& state, Router& _router, std::vector<fake_request>& requests) {
+        std::size_t               index = 0;
+        counted_allocations const _allocations{state};
+        for (auto _ : state) {
+            throughput_request req{requests[index++ % requests.size()].source};
+            throughput_context ctx{req};
+            auto               res = _router(ctx);
+            benchmark::DoNotOptimize(res);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    template <std::size_t Count>
+    void throughput_static_router(benchmark::State& state) {
+        static auto const _router  = make_static_router(std::make_index_sequence<Count>{});
+        auto              requests = make_requests(Count, false);
+        route_requests(state, _router, requests);
+    }
+
+    void throughput_dynamic_router(benchmark::State& state) {
+        auto const count    = static_cast<std::size_t>(state.range(0));
+        auto       _router  = make_dynamic_router(count);
+        auto       requests = make_requests(count, true);
+        route_requests(state, _router, requests);
+    }
+} // namespace
+
+BENCHMARK(throughput_static_router<10>);
+BENCHMARK(throughput_static_router<100>);
+BENCHMARK(throughput_dynamic_router)->Arg(10)->Arg(100)->Arg(1000);
@@ -0,0 +1,56 @@
+#include "benchmark_pch.h"
+
+#include <string>
+#include <webpp/http/bodies/stream.hpp>
+#include <webpp/http/bodies/string.hpp>
+#include <webpp/http/response.hpp>
+
+using namespace webpp;
+
+namespace {
+    // one body extension; the body is the string body itself
+    using extension_response = typename extension_pack<string_response>::template extensie_type<
+      std_traits, basic_response_descriptor>;
+    using single_response = basic_response<std_traits, empty_extension_pack, response_headers<std_traits>,
+                                           select_response_body<std_traits, string_body>>;
+    using variant_response = basic_response<std_traits, empty_extension_pack, response_headers<std_traits>,
+                                            select_response_body<std_traits, string_body, stream_body>>;
+
+    std::string const payload(512, 'x');
+
+    // only the bodies; the headers of the responses are not what we measure
+    template <typename ResponseType>
+    void body_round_trip(benchmark::State& state) {
+        using body_type = typename ResponseType::body_type;
+        for (auto _ : state) {
+            body_type body{payload};
+            benchmark::DoNotOptimize(body.str().size());
+            benchmark::DoNotOptimize(body.str().data());
+        }
+    }
+} // namespace
+
+// the baseline: what a body costs if it's just a string
+static void body_raw_string(benchmark::State& state) {
+    for (auto _ : state) {
+        std::string body{payload};
+        benchmark::DoNotOptimize(body.size());
+        benchmark::DoNotOptimize(body.data());
+    }
+}
+BENCHMARK(body_raw_string);
+
+static void body_extension(benchmark::State& state) {
+    body_round_trip<extension_response>(state);
+}
+BENCHMARK(body_extension);
+
+static void body_single(benchmark::State& state) {
+    body_round_trip<single_response>(state);
+}
+BENCHMARK(body_single);
+
+static void body_variant(benchmark::State& state) {
+    body_round_trip<variant_response>(state);
+}
+BENCHMARK(body_variant);
@@ -0,0 +1,131 @@
+#include "benchmark_pch.h"
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <webpp/http/interfaces/fcgi.hpp>
+#include <webpp/http/routes/dynamic_router.hpp>
+#include <webpp/http/routes/router.hpp>
+
+using namespace webpp;
+
+struct bench_app {};
+using bench_request = basic_request<std_traits, fcgi<std_traits, bench_app>>;
+using bench_context = simple_context<bench_request>;
+
+// "/route-NN/" for each of the routes
+template <std::size_t I>
+static constexpr std::array<char, 10> route_name{
+  '/', 'r', 'o', 'u', 't', 'e', '-', char('0' + I / 10), char('0' + I % 10), '/'};
+
+// the route checks the path itself too, so the linear walk gives the same
+// responses as the prefix tree
+template <std::size_t I>
+struct numbered_route {
+    [[nodiscard]] static constexpr std::string_view static_path_prefix() noexcept {
+        return {route_name<I>.data(), route_name<I>.size()};
+    }
+
+    std::optional<std::string_view> operator()(bench_context& ctx) const noexcept {
+        if (ctx.request->request_uri().starts_with(static_path_prefix()))
+            return "found";
+        return std::nullopt;
+    }
+};
+
+template <std::size_t... I>
+static auto make_router(std::index_sequence<I...>) {
+    return router{numbered_route<I>{}...};
+}
+
+static auto const bench_router = make_router(std::make_index_sequence<32>{});
+
+struct bench_fixture {
+    fastcgi::request source;
+    bench_request    req{source};
+
+    bench_fixture(std::string_view uri) {
+        source.params += char(11);
+        source.params += char(uri.size());
+        source.params += "REQUEST_URI";
+        source.params += uri;
+    }
+};
+
+static void router_prefix_dispatch(benchmark::State& state) {
+    bench_fixture fixture{"/route-31/page"};
+    for (auto _ : state) {
+        bench_context ctx{fixture.req};
+        auto          res = bench_router(ctx);
+        benchmark::DoNotOptimize(res);
+    }
+}
+BENCHMARK(router_prefix_dispatch);
+
+static void router_linear_walk(benchmark::State& state) {
+    bench_fixture fixture{"/route-31/page"};
+    for (auto _ : state) {
+        bench_context ctx{fixture.req};
+        auto          res = bench_router.walk(ctx);
+        benchmark::DoNotOptimize(res);
+    }
+}
+BENCHMARK(router_linear_walk);
+
+static void router_prefix_not_found(benchmark::State& state) {
+    bench_fixture fixture{"/nowhere"};
+    for (auto _ : state) {
+        bench_context ctx{fixture.req};
+        auto          res = bench_router(ctx);
+        benchmark::DoNotOptimize(res);
+    }
+}
+BENCHMARK(router_prefix_not_found);
+
+static void router_linear_not_found(benchmark::State& state) {
+    bench_fixture fixture{"/nowhere"};
+    for (auto _ : state) {
+        bench_context ctx{fixture.req};
+        auto          res = bench_router.walk(ctx);
+        benchmark::DoNotOptimize(res);
+    }
+}
+BENCHMARK(router_linear_not_found);
+
+// a few thousand routes, like the ones that the plugins add at runtime
+static auto& plugin_router() {
+    static auto _router = [] {
+        dynamic_router<bench_context> res;
+        for (int i = 0; i < 4000; i++) {
+            res.on("/plugin-" + std::to_string(i) + "/items/{id}",
+                   [](bench_context&, path_captures const& captures) noexcept {
+                       return captures["id"];
+                   });
+        }
+        return res;
+    }();
+    return _router;
+}
+
+static void router_dynamic_lookup(benchmark::State& state) {
+    auto&         _router = plugin_router();
+    bench_fixture fixture{"/plugin-3999/items/12"};
+    for (auto _ : state) {
+        bench_context ctx{fixture.req};
+        auto          res = _router(ctx);
+        benchmark::DoNotOptimize(res);
+    }
+}
+BENCHMARK(router_dynamic_lookup);
+
+static void router_dynamic_not_found(benchmark::State& state) {
+    auto&         _router = plugin_router();
+    bench_fixture fixture{"/plugin-4000/items/12"};
+    for (auto _ : state) {
+        bench_context ctx{fixture.req};
+        auto          res = _router(ctx);
+        benchmark::DoNotOptimize(res);
+    }
+}
+BENCHMARK(router_dynamic_not_found);
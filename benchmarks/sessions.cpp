@@ -0,0 +1,117 @@
+#include "benchmark_pch.h"
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <webpp/http/modules/session/server-adapter/memory_adapter.hpp>
+#include <webpp/http/modules/session/session_writer.hpp>
+
+using namespace webpp;
+
+namespace {
+    constexpr int session_count = 100'000;
+
+    std::vector<std::string> const& session_ids() {
+        static std::vector<std::string> const ids = [] {
+            std::vector<std::string> res;
+            for (int i = 0; i < session_count; i++)
+                res.push_back("session-" + std::to_string(i * 2'654'435'761u));
+            return res;
+        }();
+        return ids;
+    }
+
+    // one map with one lock, for comparison
+    struct single_lock_store {
+        std::mutex                                   lock;
+        std::unordered_map<std::string, std::string> map;
+
+        void set(std::string const& id, std::string value) {
+            std::scoped_lock const guard{lock};
+            map[id] = std::move(value);
+        }
+
+        bool get(std::string const& id, std::string& out) {
+            std::scoped_lock const guard{lock};
+            auto const             it = map.find(id);
+            if (it == map.end())
+                return false;
+            out = it->second;
+            return true;
+        }
+    };
+
+    template <typename Store>
+    Store& filled() {
+        static Store store;
+        static bool const ready = [] {
+            for (auto const& id : session_ids())
+                store.set(id, "user=42; role=admin");
+            return true;
+        }();
+        benchmark::DoNotOptimize(ready);
+        return store;
+    }
+} // namespace
+
+// the requests of 100k live sessions, from the worker threads; 1 in 10 of them changes its session
+static void sessions_single_lock(benchmark::State& state) {
+    auto&       store = filled<single_lock_store>();
+    auto const& ids   = session_ids();
+    std::size_t i     = static_cast<std::size_t>(state.thread_index()) * 7'919;
+    std::string value;
+    for (auto _ : state) {
+        auto const& id = ids[i++ % ids.size()];
+        if (i % 10 == 0)
+            store.set(id, "user=42; role=admin");
+        else
+            benchmark::DoNotOptimize(store.get(id, value));
+    }
+}
+BENCHMARK(sessions_single_lock)->ThreadRange(1, 8)->UseRealTime();
+
+static void sessions_sharded(benchmark::State& state) {
+    auto&       store = filled<memory_adapter>();
+    auto const& ids   = session_ids();
+    std::size_t i     = static_cast<std::size_t>(state.thread_index()) * 7'919;
+    std::string value;
+    for (auto _ : state) {
+        auto const& id = ids[i++ % ids.size()];
+        if (i % 10 == 0)
+            store.set(id, "user=42; role=admin");
+        else
+            benchmark::DoNotOptimize(store.visit(id, [&value](std::string const& session) {
+                value = session;
+            }));
+    }
+}
+BENCHMARK(sessions_sharded)->ThreadRange(1, 8)->UseRealTime();
+
+// the write-back of a session at the end of a request: a thread per session (the way the sessions
+// used to do it), and the shared writer
+static void sessions_write_thread(benchmark::State& state) {
+    auto&       store = filled<memory_adapter>();
+    auto const& ids   = session_ids();
+    std::size_t i     = 0;
+    for (auto _ : state) {
+        std::thread writer{[&] {
+            store.set(ids[i % ids.size()], "user=42; role=admin");
+        }};
+        writer.join();
+        i++;
+    }
+}
+BENCHMARK(sessions_write_thread);
+
+static void sessions_write_queued(benchmark::State& state) {
+    auto&                          store = filled<memory_adapter>();
+    auto const&                    ids   = session_ids();
+    session_writer<memory_adapter> writer{store};
+    std::size_t                    i = 0;
+    for (auto _ : state)
+        writer.write(ids[i++ % ids.size()], "user=42; role=admin");
+    writer.flush();
+}
+BENCHMARK(sessions_write_queued);
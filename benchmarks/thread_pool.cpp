@@ -0,0 +1,127 @@
+#include "benchmark_pch.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <latch>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <webpp/utils/thread_pool.hpp>
+
+using namespace webpp;
+
+namespace {
+    constexpr int task_count = 10'000;
+
+    // the usual pool: one queue with a lock and a condition variable
+    class locked_pool {
+        std::mutex                        lock;
+        std::condition_variable           ready;
+        std::deque<std::function<void()>> tasks;
+        std::vector<std::thread>          threads;
+        bool                              stopping = false;
+
+      public:
+        explicit locked_pool(std::size_t count) {
+            for (std::size_t i = 0; i < count; i++) {
+                threads.emplace_back([this] {
+                    for (;;) {
+                        std::function<void()> task;
+                        {
+                            std::unique_lock guard{lock};
+                            ready.wait(guard, [this] {
+                                return stopping || !tasks.empty();
+                            });
+                            if (tasks.empty())
+                                return;
+                            task = std::move(tasks.front());
+                            tasks.pop_front();
+                        }
+                        task();
+                    }
+                });
+            }
+        }
+
+        ~locked_pool() {
+            {
+                std::scoped_lock guard{lock};
+                stopping = true;
+            }
+            ready.notify_all();
+            for (auto& thread : threads)
+                thread.join();
+        }
+
+        void post(std::function<void()> task) {
+            {
+                std::scoped_lock guard{lock};
+                tasks.push_back(std::move(task));
+            }
+            ready.notify_one();
+        }
+    };
+
+    template <typename Pool>
+    void pool_post(benchmark::State& state) {
+        Pool pool{static_cast<std::size_t>(state.range(0))};
+        for (auto _ : state) {
+            std::latch done{task_count};
+            for (int i = 0; i < task_count; i++) {
+                pool.post([&done] {
+                    done.count_down();
+                });
+            }
+            done.wait();
+        }
+        state.SetItemsProcessed(state.iterations() * task_count);
+    }
+
+    // a registered function, posted by its handle with its argument; nothing is allocated
+    void pool_post_registered(benchmark::State& state) {
+        thread_pool pool{static_cast<std::size_t>(state.range(0))};
+        auto        count_down = pool.register_task<std::latch*>(
+          [](std::latch* done) {
+              done->count_down();
+          },
+          task_count);
+        for (auto _ : state) {
+            std::latch done{task_count};
+            for (int i = 0; i < task_count; i++)
+                pool.post(count_down, &done);
+            done.wait();
+        }
+        state.SetItemsProcessed(state.iterations() * task_count);
+    }
+
+    // the tasks post the next ones themselves, like a divide-and-conquer job
+    template <typename Pool>
+    void pool_fan_out(benchmark::State& state) {
+        Pool pool{static_cast<std::size_t>(state.range(0))};
+        for (auto _ : state) {
+            std::latch                     done{1 << 13};
+            std::function<void(int)> const spawn = [&](int depth) {
+                if (depth == 0) {
+                    done.count_down();
+                    return;
+                }
+                for (int i = 0; i < 2; i++) {
+                    pool.post([&spawn, depth] {
+                        spawn(depth - 1);
+                    });
+                }
+            };
+            spawn(13);
+            done.wait();
+        }
+        state.SetItemsProcessed(state.iterations() * (1 << 14));
+    }
+} // namespace
+
+BENCHMARK(pool_post<thread_pool>)->Arg(1)->Arg(4)->UseRealTime();
+BENCHMARK(pool_post<locked_pool>)->Arg(1)->Arg(4)->UseRealTime();
+BENCHMARK(pool_post_registered)->Arg(1)->Arg(4)->UseRealTime();
+BENCHMARK(pool_fan_out<thread_pool>)->Arg(1)->Arg(4)->UseRealTime();
+BENCHMARK(pool_fan_out<locked_pool>)->Arg(1)->Arg(4)->UseRealTime();
@@ -2,6 +2,9 @@
 using namespace std;
 using namespace boost::asio;
 
+using ipv4_t = webpp::ipv4<webpp::std_traits>;
+using ipv6_t = webpp::ipv6<webpp::std_traits>;
+
 static void ip_asio_v4(benchmark::State& state) {
     for (auto _ : state) {
         auto addr = ip::make_address_v4("192.168.1.8");
@@ -12,7 +15,7 @@ BENCHMARK(ip_asio_v4);
 
 static void ip_webpp_v4(benchmark::State& state) {
     for (auto _ : state) {
-        auto addr = webpp::ipv4("192.168.1.8");
+        auto addr = ipv4_t("192.168.1.8");
         benchmark::DoNotOptimize(addr);
     }
 }
@@ -50,12 +53,83 @@ BENCHMARK(ip_asio_v4_random);
 static void ip_webpp_v4_random(benchmark::State& state) {
     ipv4_data();
     for (auto _ : state) {
-        auto addr = webpp::ipv4(ipv4_data());
+        auto addr = ipv4_t(ipv4_data());
         benchmark::DoNotOptimize(addr);
     }
 }
 BENCHMARK(ip_webpp_v4_random);
 
+/////////////////// Random valid and invalid ///////////////////////////
+
+// the X-Forwarded-For chains have all sorts of lengths
+auto ipv4_valid_set() {
+    std::mt19937   random{4};
+    vector<string> ips;
+    for (int i = 0; i < 1024; i++) {
+        ips.push_back(to_string(random() % 256) + "." + to_string(random() % 256) + "." +
+                      to_string(random() % 256) + "." + to_string(random() % 256));
+        if (i % 8 == 0)
+            ips.back() += "/" + to_string(random() % 33);
+    }
+    return ips;
+}
+
+// a char of a valid one changed, or a number too big
+auto ipv4_invalid_set() {
+    std::mt19937   random{44};
+    vector<string> ips = ipv4_valid_set();
+    for (auto& ip : ips) {
+        if (random() % 2 == 0) {
+            ip[random() % ip.size()] = "x.0/ "[random() % 5];
+        } else {
+            ip = to_string(256 + random() % 700) + ip.substr(ip.find('.'));
+        }
+    }
+    return ips;
+}
+
+static void ip_asio_v4_valid_set(benchmark::State& state) {
+    auto const ips = ipv4_valid_set();
+    std::size_t i = 0;
+    for (auto _ : state) {
+        boost::system::error_code ec;
+        auto addr = ip::make_address_v4(ips[i++ % ips.size()], ec);
+        benchmark::DoNotOptimize(addr);
+    }
+}
+BENCHMARK(ip_asio_v4_valid_set);
+
+static void ip_webpp_v4_valid_set(benchmark::State& state) {
+    auto const ips = ipv4_valid_set();
+    std::size_t i = 0;
+    for (auto _ : state) {
+        ipv4_t addr{ips[i++ % ips.size()]};
+        benchmark::DoNotOptimize(addr);
+    }
+}
+BENCHMARK(ip_webpp_v4_valid_set);
+
+static void ip_asio_v4_invalid_set(benchmark::State& state) {
+    auto const ips = ipv4_invalid_set();
+    std::size_t i = 0;
+    for (auto _ : state) {
+        boost::system::error_code ec;
+        auto addr = ip::make_address_v4(ips[i++ % ips.size()], ec);
+        benchmark::DoNotOptimize(addr);
+    }
+}
+BENCHMARK(ip_asio_v4_invalid_set);
+
+static void ip_webpp_v4_invalid_set(benchmark::State& state) {
+    auto const ips = ipv4_invalid_set();
+    std::size_t i = 0;
+    for (auto _ : state) {
+        ipv4_t addr{ips[i++ % ips.size()]};
+        benchmark::DoNotOptimize(addr);
+    }
+}
+BENCHMARK(ip_webpp_v4_invalid_set);
+
 ///////////////////// IPv6 ///////////////////////////
 
 static void ip_asio_v6(benchmark::State& state) {
@@ -68,7 +142,7 @@ BENCHMARK(ip_asio_v6);
 
 static void ip_webpp_v6(benchmark::State& state) {
     for (auto _ : state) {
-        auto addr = webpp::ipv6("::1");
+        auto addr = ipv6_t("::1");
         benchmark::DoNotOptimize(addr);
     }
 }
@@ -106,10 +180,208 @@ BENCHMARK(ip_asio_v6_random);
 static void ip_webpp_v6_random(benchmark::State& state) {
     ipv6_data();
     for (auto _ : state) {
-        auto addr = webpp::ipv6(ipv6_data());
+        auto addr = ipv6_t(ipv6_data());
         benchmark::DoNotOptimize(addr);
     }
 }
 BENCHMARK(ip_webpp_v6_random);
 
+/////////////////// IPv6 sets and formatting ///////////////////////
+
+// written the way the clients and the proxies write them: compressed, mostly
+auto ipv6_set() {
+    std::mt19937   random{6};
+    vector<string> ips;
+    for (int i = 0; i < 1024; i++) {
+        std::array<unsigned char, 16> bytes{};
+        for (auto& byte : bytes)
+            byte = random() % 3 == 0 ? static_cast<unsigned char>(random()) : 0;
+        ips.push_back(ip::make_address_v6(bytes).to_string());
+    }
+    return ips;
+}
+
+static void ip_asio_v6_set(benchmark::State& state) {
+    auto const ips = ipv6_set();
+    std::size_t i = 0;
+    for (auto _ : state) {
+        boost::system::error_code ec;
+        auto addr = ip::make_address_v6(ips[i++ % ips.size()], ec);
+        benchmark::DoNotOptimize(addr);
+    }
+}
+BENCHMARK(ip_asio_v6_set);
+
+static void ip_webpp_v6_set(benchmark::State& state) {
+    auto const ips = ipv6_set();
+    std::size_t i = 0;
+    for (auto _ : state) {
+        ipv6_t addr{ips[i++ % ips.size()]};
+        benchmark::DoNotOptimize(addr);
+    }
+}
+BENCHMARK(ip_webpp_v6_set);
+
+static void ip_asio_v6_to_string(benchmark::State& state) {
+    vector<ip::address_v6> addrs;
+    for (auto const& str : ipv6_set())
+        addrs.push_back(ip::make_address_v6(str));
+    std::size_t i = 0;
+    for (auto _ : state) {
+        auto str = addrs[i++ % addrs.size()].to_string();
+        benchmark::DoNotOptimize(str);
+    }
+}
+BENCHMARK(ip_asio_v6_to_string);
+
+static void ip_webpp_v6_short_str(benchmark::State& state) {
+    vector<ipv6_t> addrs;
+    for (auto const& str : ipv6_set())
+        addrs.emplace_back(str);
+    std::size_t i = 0;
+    for (auto _ : state) {
+        auto str = addrs[i++ % addrs.size()].short_str();
+        benchmark::DoNotOptimize(str);
+    }
+}
+BENCHMARK(ip_webpp_v6_short_str);
+
+static void ip_webpp_v6_to_chars(benchmark::State& state) {
+    vector<ipv6_t> addrs;
+    for (auto const& str : ipv6_set())
+        addrs.emplace_back(str);
+    std::size_t                          i = 0;
+    std::array<char, ipv6_t::max_str_size> buffer;
+    for (auto _ : state) {
+        auto end = addrs[i++ % addrs.size()].to_chars(buffer.data());
+        benchmark::DoNotOptimize(end);
+        benchmark::DoNotOptimize(buffer);
+    }
+}
+BENCHMARK(ip_webpp_v6_to_chars);
+
+/////////////////// Prefix lookups ///////////////////////////
+
+auto ipv4_rules() {
+    std::mt19937        gen{7}; // NOLINT(cert-msc51-cpp)
+    vector<ipv4_t>      rules;
+    for (int i = 0; i < 5000; i++)
+        rules.emplace_back(static_cast<uint32_t>(gen()), static_cast<uint8_t>(8 + gen() % 25));
+    return rules;
+}
+
+auto ipv4_lookups() {
+    std::mt19937   gen{8}; // NOLINT(cert-msc51-cpp)
+    vector<ipv4_t> ips;
+    for (int i = 0; i < 1024; i++)
+        ips.emplace_back(static_cast<uint32_t>(gen()));
+    return ips;
+}
+
+static void ip_webpp_v4_subnets_linear(benchmark::State& state) {
+    auto const  rules = ipv4_rules();
+    auto const  ips   = ipv4_lookups();
+    std::size_t i     = 0;
+    for (auto _ : state) {
+        auto const& ip    = ips[i++ % ips.size()];
+        bool        found = false;
+        for (auto const& rule : rules)
+            found |= ip.is_in_subnet(rule);
+        benchmark::DoNotOptimize(found);
+    }
+}
+BENCHMARK(ip_webpp_v4_subnets_linear);
+
+static void ip_webpp_v4_subnets_prefix_map(benchmark::State& state) {
+    webpp::ip_prefix_map<bool> map;
+    for (auto const& rule : ipv4_rules())
+        map.insert(rule, true);
+    auto const  ips = ipv4_lookups();
+    std::size_t i   = 0;
+    for (auto _ : state) {
+        auto found = map.find(ips[i++ % ips.size()]);
+        benchmark::DoNotOptimize(found);
+    }
+}
+BENCHMARK(ip_webpp_v4_subnets_prefix_map);
+
+static void ip_webpp_v6_subnets_prefix_map(benchmark::State& state) {
+    std::mt19937               gen{9}; // NOLINT(cert-msc51-cpp)
+    webpp::ip_prefix_map<bool> map;
+    vector<ipv6_t>             ips;
+    for (int i = 0; i < 5000; i++) {
+        ipv6_t::octets8_t octets{0x20, 0x01, 0x0d, 0xb8};
+        for (std::size_t j = 4; j < octets.size(); j++)
+            octets[j] = static_cast<uint8_t>(gen());
+        map.insert(ipv6_t{octets, static_cast<uint8_t>(32 + gen() % 33)}, true);
+        octets[7] ^= static_cast<uint8_t>(gen() % 2);
+        ips.emplace_back(octets);
+    }
+    std::size_t i = 0;
+    for (auto _ : state) {
+        auto found = map.find(ips[i++ % ips.size()]);
+        benchmark::DoNotOptimize(found);
+    }
+}
+BENCHMARK(ip_webpp_v6_subnets_prefix_map);
+
+/////////////////// Batches ///////////////////////////
+
+// the lines of an access log: mostly valid, some not
+auto log_ips(vector<string> const& valid, vector<string> const& invalid) {
+    vector<string> ips;
+    for (std::size_t i = 0; i < valid.size(); i++)
+        ips.push_back(i % 16 == 0 && !invalid.empty() ? invalid[i] : valid[i]);
+    return ips;
+}
+
+template <typename IP>
+static void ip_webpp_one_by_one(benchmark::State& state, vector<string> const& strs) {
+    vector<std::string_view> const views(strs.begin(), strs.end());
+    vector<IP>                     ips(views.size());
+    for (auto _ : state) {
+        std::size_t invalid = 0;
+        for (std::size_t i = 0; i < views.size(); i++) {
+            ips[i] = IP{views[i]};
+            invalid += !ips[i].is_valid();
+        }
+        benchmark::DoNotOptimize(invalid);
+        benchmark::DoNotOptimize(ips.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * views.size()));
+}
+
+template <typename IP>
+static void ip_webpp_parse_all(benchmark::State& state, vector<string> const& strs) {
+    vector<std::string_view> const views(strs.begin(), strs.end());
+    vector<IP>                     ips(views.size());
+    vector<uint64_t>               invalid_bits((views.size() + 63) / 64);
+    for (auto _ : state) {
+        auto invalid = IP::parse_all(views, ips, invalid_bits);
+        benchmark::DoNotOptimize(invalid);
+        benchmark::DoNotOptimize(ips.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * views.size()));
+}
+
+static void ip_webpp_v4_one_by_one(benchmark::State& state) {
+    ip_webpp_one_by_one<ipv4_t>(state, log_ips(ipv4_valid_set(), ipv4_invalid_set()));
+}
+BENCHMARK(ip_webpp_v4_one_by_one);
+
+static void ip_webpp_v4_parse_all(benchmark::State& state) {
+    ip_webpp_parse_all<ipv4_t>(state, log_ips(ipv4_valid_set(), ipv4_invalid_set()));
+}
+BENCHMARK(ip_webpp_v4_parse_all);
+
+static void ip_webpp_v6_one_by_one(benchmark::State& state) {
+    ip_webpp_one_by_one<ipv6_t>(state, log_ips(ipv6_set(), {}));
+}
+BENCHMARK(ip_webpp_v6_one_by_one);
+
+static void ip_webpp_v6_parse_all(benchmark::State& state) {
+    ip_webpp_parse_all<ipv6_t>(state, log_ips(ipv6_set(), {}));
+}
+BENCHMARK(ip_webpp_v6_parse_all);
+
 // BENCHMARK_MAIN();
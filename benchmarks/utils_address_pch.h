@@ -2,14 +2,18 @@
 
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
+#include <array>
 #include <cstdlib>
 #include <deque>
 #include <iostream>
 #include <list>
 #include <memory>
+#include <random>
 #include <set>
 #include <string>
 #include <utility>
 #include <vector>
-#include <webpp/utils/ipv4.h>
-#include <webpp/utils/ipv6.h>
+#include <webpp/traits/std_traits.hpp>
+#include <webpp/utils/ip_prefix_map.hpp>
+#include <webpp/utils/ipv4.hpp>
+#include <webpp/utils/ipv6.hpp>
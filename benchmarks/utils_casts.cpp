@@ -0,0 +1,173 @@
+#include "benchmark_pch.h"
+
+#include <array>
+#include <charconv>
+#include <cstdlib>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <webpp/traits/std_traits.hpp>
+#include <webpp/utils/casts.hpp>
+
+using namespace webpp;
+
+namespace {
+    // the Content-Length and the port sized numbers, and a few big ones
+    std::vector<std::string> const numbers = [] {
+        std::mt19937_64          gen{42}; // NOLINT(cert-msc51-cpp)
+        std::vector<std::string> res;
+        for (int i = 0; i < 1024; i++) {
+            auto const value = gen() >> (gen() % 4 == 0 ? gen() % 64 : 40 + gen() % 24);
+            res.push_back(std::to_string(value));
+        }
+        return res;
+    }();
+
+    // the kind of the floating points that are in the paths
+    std::vector<std::string> const decimals = [] {
+        std::mt19937_64          gen{42}; // NOLINT(cert-msc51-cpp)
+        std::vector<std::string> res;
+        for (int i = 0; i < 1024; i++)
+            res.push_back(std::to_string(gen() % 100'000) + "." + std::to_string(gen() % 1'000'000));
+        return res;
+    }();
+
+    std::vector<std::uint64_t> const values = [] {
+        std::vector<std::uint64_t> res;
+        for (auto const& str : numbers)
+            res.push_back(std::stoull(str));
+        return res;
+    }();
+
+    // the digit at a time parser that was there before, to compare with
+    std::uint64_t parse_bytewise(std::string_view str) {
+        std::uint64_t res = 0;
+        for (auto const c : str) {
+            if (c < '0' || c > '9')
+                return 0;
+            res = res * 10 + static_cast<std::uint64_t>(c - '0');
+        }
+        return res;
+    }
+} // namespace
+
+static void casts_parse_bytewise(benchmark::State& state) {
+    for (auto _ : state) {
+        for (auto const& str : numbers)
+            benchmark::DoNotOptimize(parse_bytewise(str));
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * numbers.size()));
+}
+BENCHMARK(casts_parse_bytewise);
+
+static void casts_parse_from_chars(benchmark::State& state) {
+    for (auto _ : state) {
+        for (auto const& str : numbers) {
+            std::uint64_t res = 0;
+            std::from_chars(str.data(), str.data() + str.size(), res);
+            benchmark::DoNotOptimize(res);
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * numbers.size()));
+}
+BENCHMARK(casts_parse_from_chars);
+
+static void casts_parse_integer(benchmark::State& state) {
+    for (auto _ : state) {
+        for (auto const& str : numbers) {
+            std::uint64_t res = 0;
+            benchmark::DoNotOptimize(parse_integer(std::string_view{str}, res));
+            benchmark::DoNotOptimize(res);
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * numbers.size()));
+}
+BENCHMARK(casts_parse_integer);
+
+static void casts_parse_port(benchmark::State& state) {
+    std::array<std::string_view, 4> const ports{"80", "443", "8080", "65535"};
+    for (auto _ : state) {
+        for (auto const port : ports) {
+            std::uint16_t res = 0;
+            benchmark::DoNotOptimize(parse_integer(port, res));
+            benchmark::DoNotOptimize(res);
+        }
+    }
+}
+BENCHMARK(casts_parse_port);
+
+static void casts_to_uint(benchmark::State& state) {
+    for (auto _ : state) {
+        for (auto const& str : numbers)
+            benchmark::DoNotOptimize(to_uint64<std_traits>(str));
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * numbers.size()));
+}
+BENCHMARK(casts_to_uint);
+
+static void casts_parse_strtod(benchmark::State& state) {
+    for (auto _ : state) {
+        for (auto const& str : decimals)
+            benchmark::DoNotOptimize(std::strtod(str.c_str(), nullptr));
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * decimals.size()));
+}
+BENCHMARK(casts_parse_strtod);
+
+// what routes::number did for the doubles, through a long double
+static void casts_parse_long_double(benchmark::State& state) {
+    for (auto _ : state) {
+        for (auto const& str : decimals) {
+            long double res = 0;
+            benchmark::DoNotOptimize(parse_floating(str, res));
+            benchmark::DoNotOptimize(static_cast<double>(res));
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * decimals.size()));
+}
+BENCHMARK(casts_parse_long_double);
+
+static void casts_parse_double(benchmark::State& state) {
+    for (auto _ : state) {
+        for (auto const& str : decimals) {
+            double res = 0;
+            benchmark::DoNotOptimize(parse_floating(str, res));
+            benchmark::DoNotOptimize(res);
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * decimals.size()));
+}
+BENCHMARK(casts_parse_double);
+
+static void casts_format_to_chars(benchmark::State& state) {
+    std::array<char, 24> buf{};
+    for (auto _ : state) {
+        for (auto const value : values) {
+            auto const res = std::to_chars(buf.data(), buf.data() + buf.size(), value);
+            benchmark::DoNotOptimize(res.ptr);
+            benchmark::DoNotOptimize(buf);
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * values.size()));
+}
+BENCHMARK(casts_format_to_chars);
+
+static void casts_format_to_str_buffer(benchmark::State& state) {
+    for (auto _ : state) {
+        for (auto const value : values)
+            benchmark::DoNotOptimize(to_str_buffer(value));
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * values.size()));
+}
+BENCHMARK(casts_format_to_str_buffer);
+
+static void casts_format_to_str(benchmark::State& state) {
+    for (auto _ : state) {
+        for (auto const value : values)
+            benchmark::DoNotOptimize(to_str<std_traits>(value));
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * values.size()));
+}
+BENCHMARK(casts_format_to_str);
@@ -0,0 +1,165 @@
+#include "benchmark_pch.h"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <webpp/traits/std_traits.hpp>
+#include <webpp/utils/uri.hpp>
+
+using namespace webpp;
+
+namespace {
+    constexpr auto allowed_chars = charset(ALPHA<char>, DIGIT<char>, charset_t<char, 4>{'-', '.', '_', '~'});
+
+    // the byte at a time decoder that was there before, to compare with
+    std::optional<std::string> decode_bytewise(std::string_view encoded_str) {
+        int         digits_left  = 2;
+        char        decoded_char = 0;
+        bool        decoding     = false;
+        std::string res;
+        for (const auto c : encoded_str) {
+            if (decoding && digits_left) {
+                decoded_char <<= 4;
+                if (c >= '0' && c <= '9') {
+                    decoded_char += c - '0';
+                } else if (c >= 'A' && c <= 'F') {
+                    decoded_char += c - 'A' + 10;
+                } else if (c >= 'a' && c <= 'f') {
+                    decoded_char += c - 'a' + 10;
+                } else {
+                    return std::nullopt;
+                }
+                if (--digits_left == 0) {
+                    decoding = false;
+                    res.push_back(decoded_char);
+                }
+            } else if (c == '%') {
+                decoding     = true;
+                digits_left  = 2;
+                decoded_char = 0;
+            } else {
+                if (!allowed_chars.contains(c))
+                    return std::nullopt;
+                res.push_back(c);
+            }
+        }
+        return res;
+    }
+
+    // a long path with an escaped space here and there
+    std::string make_encoded() {
+        std::string str;
+        for (int i = 0; i < 64; i++)
+            str += "some-long_segment.name%20" + std::to_string(i);
+        return str;
+    }
+} // namespace
+
+static void uri_decode_bytewise(benchmark::State& state) {
+    auto const encoded = make_encoded();
+    for (auto _ : state) {
+        auto res = decode_bytewise(encoded);
+        benchmark::DoNotOptimize(res);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * encoded.size()));
+}
+BENCHMARK(uri_decode_bytewise);
+
+static void uri_decode_component(benchmark::State& state) {
+    auto const encoded = make_encoded();
+    for (auto _ : state) {
+        auto res = decode_uri_component<std_traits>(encoded, allowed_chars);
+        benchmark::DoNotOptimize(res);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * encoded.size()));
+}
+BENCHMARK(uri_decode_component);
+
+static void uri_decode_component_inplace(benchmark::State& state) {
+    auto const  encoded = make_encoded();
+    std::string buffer;
+    for (auto _ : state) {
+        buffer = encoded; // the capacity is reused
+        auto valid = decode_uri_component_inplace<std_traits>(buffer, allowed_chars);
+        benchmark::DoNotOptimize(valid);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * encoded.size()));
+}
+BENCHMARK(uri_decode_component_inplace);
+
+static void uri_host_domains_getters(benchmark::State& state) {
+    const_uri const u{"https://api.eu.example.co.uk/v1/users"};
+    for (auto _ : state) {
+        auto tld = u.top_level_domain();
+        auto sld = u.second_level_domain();
+        auto sub = u.subdomains();
+        benchmark::DoNotOptimize(tld);
+        benchmark::DoNotOptimize(sld);
+        benchmark::DoNotOptimize(sub);
+    }
+}
+BENCHMARK(uri_host_domains_getters);
+
+static void uri_host_domains_info(benchmark::State& state) {
+    const_uri const u{"https://api.eu.example.co.uk/v1/users"};
+    for (auto _ : state) {
+        auto const info = u.host_info();
+        auto       tld  = info.top_level_domain();
+        auto       sld  = info.second_level_domain();
+        auto       sub  = info.subdomains();
+        benchmark::DoNotOptimize(tld);
+        benchmark::DoNotOptimize(sld);
+        benchmark::DoNotOptimize(sub);
+    }
+}
+BENCHMARK(uri_host_domains_info);
+
+// the search in the chars of the set, as charset_t::contains was before the bitmap
+static void charset_contains_linear(benchmark::State& state) {
+    auto allowed = make_encoded();
+    std::erase(allowed, '%');
+    std::string_view const chars{allowed_chars.data(), allowed_chars.size()};
+    for (auto _ : state) {
+        bool res = true;
+        for (auto const c : allowed)
+            res = res && chars.find(c) != std::string_view::npos;
+        benchmark::DoNotOptimize(res);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * allowed.size()));
+}
+BENCHMARK(charset_contains_linear);
+
+static void charset_contains(benchmark::State& state) {
+    auto allowed = make_encoded();
+    std::erase(allowed, '%');
+    for (auto _ : state) {
+        auto res = allowed_chars.contains(allowed);
+        benchmark::DoNotOptimize(res);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * allowed.size()));
+}
+BENCHMARK(charset_contains);
+
+static void charset_string_view_find_first_not_of(benchmark::State& state) {
+    auto allowed = make_encoded();
+    std::erase(allowed, '%');
+    std::string_view const chars{allowed_chars.data(), allowed_chars.size()};
+    for (auto _ : state) {
+        auto res = std::string_view{allowed}.find_first_not_of(chars);
+        benchmark::DoNotOptimize(res);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * allowed.size()));
+}
+BENCHMARK(charset_string_view_find_first_not_of);
+
+static void charset_find_first_not_in(benchmark::State& state) {
+    auto allowed = make_encoded();
+    std::erase(allowed, '%');
+    for (auto _ : state) {
+        auto res = allowed_chars.find_first_not_in(allowed);
+        benchmark::DoNotOptimize(res);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * allowed.size()));
+}
+BENCHMARK(charset_find_first_not_in);
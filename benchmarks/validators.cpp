@@ -0,0 +1,186 @@
+#include "benchmark_pch.h"
+
+#include <cstdint>
+#include <random>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include <webpp/traits/std_traits.hpp>
+#include <webpp/validators/email_providers.hpp>
+#include <webpp/validators/validators.hpp>
+
+using namespace webpp;
+
+namespace {
+    // the numeric path segments and the form fields
+    std::vector<std::string> const short_numbers{"80",    "443",    "8080",     "1024",
+                                                 "65535", "123456", "20231231", "7"};
+
+    // the long hex ids, like the hashes and the tokens
+    std::vector<std::string> const hex_tokens{
+      "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+      "2cf24dba5fb0a30e26e83b2ac5b9e29e1b161e5c1fa7425e73043362938b9824",
+      "D7A8FBB307D7809469CA9ABCB0082E4F8D5651E46D3CDB762D02D0BF37C9E592",
+      "9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08"};
+
+    // the char at a time checks that were there before, to compare with
+    bool digit_bytewise(std::string_view str) {
+        for (auto c : str)
+            if (c < '0' || c > '9')
+                return false;
+        return !str.empty();
+    }
+
+    bool hex_bytewise(std::string_view str) {
+        for (auto c : str)
+            if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F')))
+                return false;
+        return !str.empty();
+    }
+
+    // a signup import: mostly valid, some of them not
+    std::vector<std::string> const signups = [] {
+        std::mt19937                  gen{42}; // NOLINT(cert-msc51-cpp)
+        std::vector<std::string_view> names{"john", "jane.doe", "a.b.c", "first.last+news", "x_y", "bob"};
+        std::vector<std::string_view> domains{"gmail.com", "example.co.uk", "mail-server.example.org",
+                                              "t.io"};
+        std::vector<std::string>      res;
+        for (int i = 0; i < 4096; i++) {
+            auto mail = std::string{names[gen() % names.size()]} + std::to_string(gen() % 10'000) + "@" +
+                        std::string{domains[gen() % domains.size()]};
+            if (gen() % 10 == 0)
+                mail[gen() % mail.size()] = ' ';
+            res.push_back(std::move(mail));
+        }
+        return res;
+    }();
+
+    std::int64_t const signups_size = [] {
+        std::int64_t size = 0;
+        for (auto const& mail : signups)
+            size += static_cast<std::int64_t>(mail.size());
+        return size;
+    }();
+} // namespace
+
+static void validators_digit_bytewise(benchmark::State& state) {
+    for (auto _ : state) {
+        for (auto const& str : short_numbers)
+            benchmark::DoNotOptimize(digit_bytewise(str));
+    }
+}
+BENCHMARK(validators_digit_bytewise);
+
+static void validators_digit(benchmark::State& state) {
+    for (auto _ : state) {
+        for (auto const& str : short_numbers)
+            benchmark::DoNotOptimize(is::digit(std::string_view{str}));
+    }
+}
+BENCHMARK(validators_digit);
+
+static void validators_number(benchmark::State& state) {
+    std::vector<std::string> const numbers{"1.5",      "3.14159", "100",
+                                           "0.000123", "65535.5", "2.718281828459045"};
+    for (auto _ : state) {
+        for (auto const& str : numbers)
+            benchmark::DoNotOptimize(is::number(std::string_view{str}));
+    }
+}
+BENCHMARK(validators_number);
+
+static void validators_hex_bytewise(benchmark::State& state) {
+    for (auto _ : state) {
+        for (auto const& str : hex_tokens)
+            benchmark::DoNotOptimize(hex_bytewise(str));
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * hex_tokens.size() * 64));
+}
+BENCHMARK(validators_hex_bytewise);
+
+static void validators_hex(benchmark::State& state) {
+    for (auto _ : state) {
+        for (auto const& str : hex_tokens)
+            benchmark::DoNotOptimize(is::hex(std::string_view{str}));
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * hex_tokens.size() * 64));
+}
+BENCHMARK(validators_hex);
+
+// the regex that is::email was before
+static void validators_email_regex(benchmark::State& state) {
+    std::regex const pattern{"^[_A-Za-z0-9-\\+]+(\\.[_A-Za-z0-9-]+)*@[A-Za-z0-9-]+(\\.[A-Za-"
+                             "z0-9]+)*(\\.[A-Za-z]{2,})$"};
+    for (auto _ : state) {
+        for (auto const& mail : signups)
+            benchmark::DoNotOptimize(std::regex_match(mail, pattern));
+    }
+    state.SetBytesProcessed(state.iterations() * signups_size);
+}
+BENCHMARK(validators_email_regex);
+
+static void validators_email(benchmark::State& state) {
+    for (auto _ : state) {
+        for (auto const& mail : signups)
+            benchmark::DoNotOptimize(is::email<std_traits>(mail));
+    }
+    state.SetBytesProcessed(state.iterations() * signups_size);
+}
+BENCHMARK(validators_email);
+
+static void validators_emails(benchmark::State& state) {
+    std::vector<std::string_view> const views(signups.begin(), signups.end());
+    std::vector<std::uint64_t>          invalid((views.size() + 63) / 64);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(is::emails(views, invalid));
+        benchmark::DoNotOptimize(invalid.data());
+    }
+    state.SetBytesProcessed(state.iterations() * signups_size);
+}
+BENCHMARK(validators_emails);
+
+namespace {
+    // a block list of the size of the public disposable email lists
+    std::vector<std::string> const blocked_domains = [] {
+        std::vector<std::string> res;
+        for (int i = 0; i < 50'000; i++)
+            res.push_back("throwaway" + std::to_string(i) + (i % 2 ? ".com" : ".net"));
+        return res;
+    }();
+
+    std::vector<std::string> const checked_domains = [] {
+        std::mt19937             gen{7}; // NOLINT(cert-msc51-cpp)
+        std::vector<std::string> res;
+        for (int i = 0; i < 1000; i++)
+            res.push_back(gen() % 2 ? blocked_domains[gen() % blocked_domains.size()] : "gmail.com");
+        return res;
+    }();
+} // namespace
+
+static void validators_email_blocked_set(benchmark::State& state) {
+    std::unordered_set<std::string> const blocked(blocked_domains.begin(), blocked_domains.end());
+    for (auto _ : state) {
+        for (auto const& domain : checked_domains)
+            benchmark::DoNotOptimize(blocked.contains(domain));
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * checked_domains.size()));
+}
+BENCHMARK(validators_email_blocked_set);
+
+static void validators_email_blocked_database(benchmark::State& state) {
+    email_database_builder builder;
+    for (auto const& domain : blocked_domains) {
+        std::string_view const name = domain;
+        builder.add(email_provider_kind::blocked, {&name, 1});
+    }
+    auto const           bytes = builder.build();
+    email_database const blocked{bytes};
+    for (auto _ : state) {
+        for (auto const& domain : checked_domains)
+            benchmark::DoNotOptimize(blocked.is_blocked(domain));
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * checked_domains.size()));
+}
+BENCHMARK(validators_email_blocked_database);
@@ -1,6 +0,0 @@
-#include "benchmark_pch.h"
-
-#include <webpp/interfaces/basic_interface.h>
-#include <webpp/valves/methods.h>
-#include <webpp/valves/uri.h>
-#include <webpp/valves/valve.h>
@@ -0,0 +1,112 @@
+# Compile a directory of assets into the binary:
+#
+#   include(cmake/embedded_assets.cmake)
+#   webpp_embed_assets(site_assets DIRECTORY assets PREFIX /static)
+#   target_link_libraries(my_app PRIVATE site_assets)
+#
+# "site_assets" is a static library that defines webpp::find_embedded_asset
+# (a perfect hash index of the files, see webpp/utils/embedded_assets.hpp)
+# and the get_static_file hook of the file bodies, so a file body of
+# "/static/index.html" is served from the binary without touching the file
+# system. Every file is gzipped as well, and the compressed variant is kept
+# if it's smaller.
+#
+# The assets are embedded again when they change (or when files are added to
+# the directory, on the next configure).
+
+if (NOT CMAKE_SCRIPT_MODE_FILE)
+  set(WEBPP_EMBEDDED_ASSETS_SCRIPT "${CMAKE_CURRENT_LIST_FILE}" CACHE INTERNAL "")
+endif ()
+
+function(webpp_embed_assets target)
+  cmake_parse_arguments(ARG "" "DIRECTORY;PREFIX" "" ${ARGN})
+  get_filename_component(assets_dir "${ARG_DIRECTORY}" ABSOLUTE)
+  file(GLOB_RECURSE assets CONFIGURE_DEPENDS "${assets_dir}/*")
+
+  set(output "${CMAKE_CURRENT_BINARY_DIR}/${target}.cpp")
+  add_custom_command(
+    OUTPUT "${output}"
+    COMMAND "${CMAKE_COMMAND}"
+            "-DASSETS_DIR=${assets_dir}"
+            "-DASSETS_PREFIX=${ARG_PREFIX}"
+            "-DASSETS_OUTPUT=${output}"
+            -P "${WEBPP_EMBEDDED_ASSETS_SCRIPT}"
+    DEPENDS ${assets} "${WEBPP_EMBEDDED_ASSETS_SCRIPT}"
+    COMMENT "Embedding the assets of ${assets_dir}"
+    VERBATIM)
+
+  add_library(${target} STATIC "${output}")
+  target_link_libraries(${target} PUBLIC webpp::webpp)
+  target_compile_definitions(${target} PUBLIC WEBPP_EMBEDDED_FILES)
+endfunction()
+
+
+# turn the bytes of a file into the lines of a string literal
+function(_webpp_string_literal file out_var)
+  file(READ "${file}" hex HEX)
+  string(LENGTH "${hex}" hex_length)
+  math(EXPR length "${hex_length} / 2")
+
+  # 32 bytes in each line
+  string(REPEAT "[0-9a-f]" 64 line_pattern)
+  string(REGEX REPLACE "(${line_pattern})" "\\1\"\n    \"" lines "${hex}")
+  string(REGEX REPLACE "([0-9a-f][0-9a-f])" "\\\\x\\1" escaped "${lines}")
+  set(${out_var} "std::string_view{\"${escaped}\", ${length}}" PARENT_SCOPE)
+endfunction()
+
+
+# the script mode: generate the source file
+if (CMAKE_SCRIPT_MODE_FILE AND DEFINED ASSETS_OUTPUT)
+  file(GLOB_RECURSE assets RELATIVE "${ASSETS_DIR}" "${ASSETS_DIR}/*")
+  list(SORT assets)
+  list(LENGTH assets assets_count)
+
+  set(work_dir "${ASSETS_OUTPUT}.gz")
+  file(REMOVE_RECURSE "${work_dir}")
+  file(MAKE_DIRECTORY "${work_dir}")
+
+  set(entries "")
+  set(index 0)
+  foreach (asset IN LISTS assets)
+    set(asset_file "${ASSETS_DIR}/${asset}")
+    _webpp_string_literal("${asset_file}" content)
+
+    # the compressed variant, if it's worth it
+    set(gzip "std::string_view{}")
+    set(gzip_file "${work_dir}/${index}.gz")
+    file(ARCHIVE_CREATE OUTPUT "${gzip_file}" PATHS "${asset_file}" FORMAT raw COMPRESSION GZip)
+    file(SIZE "${asset_file}" asset_size)
+    file(SIZE "${gzip_file}" gzip_size)
+    math(EXPR gzip_limit "${asset_size} * 9 / 10")
+    if (gzip_size LESS gzip_limit)
+      _webpp_string_literal("${gzip_file}" gzip)
+    endif ()
+
+    string(APPEND entries "  webpp::embedded_asset{\n    \"${ASSETS_PREFIX}/${asset}\",\n    ${content},\n    ${gzip}},\n")
+    math(EXPR index "${index} + 1")
+  endforeach ()
+  file(REMOVE_RECURSE "${work_dir}")
+
+  file(WRITE "${ASSETS_OUTPUT}"
+"// Generated by cmake/embedded_assets.cmake from ${ASSETS_DIR}; don't edit it.
+
+#include <webpp/utils/embedded_assets.hpp>
+
+#include <array>
+#include <string_view>
+
+namespace {
+  constexpr webpp::embedded_asset_index<${assets_count}> assets{std::array<webpp::embedded_asset, ${assets_count}>{
+${entries}}};
+} // namespace
+
+webpp::embedded_asset const* webpp::find_embedded_asset(std::string_view path) noexcept {
+  return assets.find(path);
+}
+
+std::string_view get_static_file(std::string_view const& path) noexcept {
+  auto const asset = assets.find(path);
+  return asset != nullptr ? asset->content : std::string_view{};
+}
+")
+endif ()
@@ -1,6 +1,7 @@
 #ifndef WEBPP_CACHE_CACHE_H
 #define WEBPP_CACHE_CACHE_H
 
+#include <functional>
 #include <type_traits>
 #include <utility>
 
@@ -20,32 +21,133 @@ namespace webpp {
     template <typename... CacheSystem>
     class unified_caches : public CacheSystem... {
       private:
+        // the first system that the condition holds for, or void
+        template <template <typename> typename Condition, typename... Systems>
+        struct first_system {
+            using type = void;
+        };
+
+        template <template <typename> typename Condition, typename First,
+                  typename... Rest>
+        struct first_system<Condition, First, Rest...> {
+            using type = std::conditional_t<
+              Condition<First>::value, First,
+              typename first_system<Condition, Rest...>::type>;
+        };
+
+        template <typename KeyType, typename ValueType>
+        struct holds_exactly {
+            template <typename System>
+            using condition = std::bool_constant<
+              std::is_same_v<KeyType, typename System::key_type> &&
+              std::is_same_v<ValueType, typename System::value_type>>;
+        };
+
+        template <typename KeyType, typename ValueType>
+        struct holds {
+            template <typename System>
+            using condition = std::bool_constant<
+              std::is_convertible_v<KeyType, typename System::key_type> &&
+              std::is_convertible_v<ValueType, typename System::value_type>>;
+        };
+
+        template <typename KeyType, typename ValueType>
+        struct cache_for {
+            using exact = typename first_system<
+              holds_exactly<KeyType, ValueType>::template condition,
+              CacheSystem...>::type;
+
+            using convertible = typename first_system<
+              holds<KeyType, ValueType>::template condition,
+              CacheSystem...>::type;
+
+            using type =
+              std::conditional_t<std::is_void_v<exact>, convertible, exact>;
+        };
+
       public:
-        unified_caches() noexcept = default;
-        //
-        // template <typename KeyType, typename ValueType>
-        // auto set(KeyType&& key, ValueType&& value) noexcept {
-        // static_assert(
-        // can_use_as_key<KeyType>(),
-        // "You cannot use this key type in this caching system. You can "
-        // "add a new template parameter to the caching system store in "
-        // "order to be able to use this key type here.");
-        // static_assert(
-        // can_use_as_value<ValueType>(),
-        // "You can't use this value type in this caching system. Add a "
-        // "new template parameter to the caching system store in order "
-        // "to be able to store this value here.");
-        // }
-        //
-        // template <typename KeyType, typename ValueType>
-        // auto get(KeyType&& key, ValueType default_value) noexcept {
-        // static_assert(
-        // can_use_as_key<KeyType>(),
-        // "You cannot use this key type in this caching system. You can "
-        // "add a new template parameter to the caching system store in "
-        // "order to be able to use this key type here.");
-        // }
-        //
+        /**
+         * The caching system that the key and the value go to; it's picked at
+         * compile time: the one that holds exactly these types, or else the
+         * first one that they're convertible to (void if there's none). The
+         * calls go straight to it, so there's no overhead compared to calling
+         * it directly.
+         */
+        template <typename KeyType, typename ValueType>
+        using cache_for_t =
+          typename cache_for<std::remove_cvref_t<KeyType>,
+                             std::remove_cvref_t<ValueType>>::type;
+
+        unified_caches() = default;
+
+        /**
+         * Use the caching systems that are already configured (their budgets
+         * for example)
+         */
+        explicit unified_caches(CacheSystem... systems)
+          : CacheSystem{std::move(systems)}... {}
+
+        /**
+         * Store the value in the caching system of the key and the value (see
+         * cache_for_t)
+         */
+        template <typename KeyType, typename ValueType>
+        auto& set(KeyType&& key, ValueType&& value) {
+            using system = cache_for_t<KeyType, ValueType>;
+            static_assert(
+              !std::is_void_v<system>,
+              "You cannot use this key and value types in this caching "
+              "system. You can add a new template parameter to the caching "
+              "system store in order to be able to use them here.");
+            static_cast<system&>(*this).set(std::forward<KeyType>(key),
+                                            std::forward<ValueType>(value));
+            return *this;
+        }
+
+        /**
+         * Get the value from the caching system that it'd be stored in (see
+         * cache_for_t), or the default value if it's not there
+         */
+        template <typename KeyType, typename ValueType>
+        auto get(KeyType&& key, ValueType&& default_value) {
+            using system = cache_for_t<KeyType, ValueType>;
+            static_assert(
+              !std::is_void_v<system>,
+              "You cannot use this key and value types in this caching "
+              "system. You can add a new template parameter to the caching "
+              "system store in order to be able to use them here.");
+            return static_cast<system&>(*this).get(
+              std::forward<KeyType>(key),
+              std::forward<ValueType>(default_value));
+        }
+
+        /**
+         * Get the value, or compute it with the callback and store it; the
+         * caching system is picked by the type that the callback returns.
+         */
+        template <typename KeyType, typename Callable>
+        auto get_or_set(KeyType&& key, Callable&& callback) {
+            using result_type = std::conditional_t<
+              std::is_invocable_v<Callable, KeyType const&>,
+              std::invoke_result<Callable, KeyType const&>,
+              std::invoke_result<Callable>>;
+            using system = cache_for_t<KeyType, typename result_type::type>;
+            static_assert(
+              !std::is_void_v<system>,
+              "You cannot use this key and value types in this caching "
+              "system. You can add a new template parameter to the caching "
+              "system store in order to be able to use them here.");
+            return static_cast<system&>(*this).get_or_set(
+              std::forward<KeyType>(key), std::forward<Callable>(callback));
+        }
+
+        /**
+         * The caching system of that type, to use its own methods
+         */
+        template <typename System>
+        System& cache() noexcept {
+            return static_cast<System&>(*this);
+        }
 
 
         // ------------------------- static methods -------------------------
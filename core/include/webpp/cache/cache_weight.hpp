@@ -0,0 +1,48 @@
+#ifndef WEBPP_CACHE_CACHE_WEIGHT_H
+#define WEBPP_CACHE_CACHE_WEIGHT_H
+
+#include "../std/std.hpp"
+
+#include <cstddef>
+
+namespace webpp {
+
+    /**
+     * Every entry weighs one; the budget of the cache is the number of its entries.
+     */
+    struct unit_weight {
+        template <typename Key, typename Value>
+        constexpr stl::size_t operator()(Key const&, Value const&) const noexcept {
+            return 1;
+        }
+    };
+
+    /**
+     * An entry weighs about as much memory as it takes: the key and the value, what their strings and
+     * vectors hold, and the nodes of the cache; the budget of the cache is in bytes then. The values
+     * that own their data in other ways (a shared_ptr to a file) need a weigher of their own.
+     */
+    struct byte_weight {
+        static constexpr stl::size_t entry_overhead = 64;
+
+        template <typename T>
+        static constexpr stl::size_t bytes_of(T const& obj) noexcept {
+            if constexpr (requires {
+                              obj.size();
+                              obj.data();
+                          }) {
+                return sizeof(T) + obj.size() * sizeof(*obj.data());
+            } else {
+                return sizeof(T);
+            }
+        }
+
+        template <typename Key, typename Value>
+        constexpr stl::size_t operator()(Key const& key, Value const& value) const noexcept {
+            return bytes_of(key) + bytes_of(value) + entry_overhead;
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_CACHE_CACHE_WEIGHT_H
@@ -0,0 +1,191 @@
+#ifndef WEBPP_CACHE_LRU_CACHE_H
+#define WEBPP_CACHE_LRU_CACHE_H
+
+#include "../std/std.hpp"
+#include "./cache_weight.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+namespace webpp {
+
+    /**
+     * A cache with a budget; when it's over the budget, the entries that are not used for the longest
+     * time are evicted. All of the operations are O(1): the entries are in a list, the most recently
+     * used first, and a hash map points into it.
+     *
+     * The budget is in the weights of the entries (see unit_weight and byte_weight). It's not
+     * thread-safe; the caches that are shared between the threads need a lock around them.
+     */
+    template <typename KeyT     = stl::string,
+              typename ValT     = stl::string,
+              typename Weigher  = unit_weight,
+              typename Hash     = stl::hash<KeyT>,
+              typename KeyEqual = stl::equal_to<KeyT>>
+    class lru_cache {
+      public:
+        using key_type     = KeyT;
+        using value_type   = ValT;
+        using weigher_type = Weigher;
+
+      private:
+        struct entry {
+            key_type    key;
+            value_type  value;
+            stl::size_t weight;
+        };
+
+        using list_type = stl::list<entry>;
+
+        list_type                                                                  entries{};
+        stl::unordered_map<key_type, typename list_type::iterator, Hash, KeyEqual> index{};
+        stl::size_t                                                                budget;
+        stl::size_t                                                                total_weight = 0;
+        [[no_unique_address]] weigher_type                                         weigher;
+
+        void evict() {
+            while (total_weight > budget) {
+                auto& last = entries.back();
+                total_weight -= last.weight;
+                index.erase(last.key);
+                entries.pop_back();
+            }
+        }
+
+      public:
+        explicit lru_cache(stl::size_t max_weight = 1024, weigher_type weigh = {})
+          : budget{max_weight},
+            weigher{stl::move(weigh)} {}
+
+        /**
+         * The value of the key, or null; it's the most recently used one after this.
+         */
+        [[nodiscard]] value_type* find(key_type const& key) {
+            auto const it = index.find(key);
+            if (it == index.end())
+                return nullptr;
+            entries.splice(entries.begin(), entries, it->second);
+            return &it->second->value;
+        }
+
+        /**
+         * The value of the key, or null, without counting it as a use; the concurrent caches look the
+         * keys up with it under a shared lock, and "touch" them later.
+         */
+        [[nodiscard]] value_type const* peek(key_type const& key) const {
+            auto const it = index.find(key);
+            return it == index.end() ? nullptr : &it->second->value;
+        }
+
+        /**
+         * Count it as a use of the key
+         */
+        void touch(key_type const& key) {
+            static_cast<void>(find(key));
+        }
+
+        template <typename DataType>
+        [[nodiscard]] value_type get(key_type const& key, DataType&& default_value) {
+            if (auto const* value = find(key))
+                return *value;
+            return value_type(stl::forward<DataType>(default_value));
+        }
+
+        /**
+         * The value of the key; if it's not there, the callback computes it (it's called with the key,
+         * or with nothing) and it's set. See sharded_cache for the one that's shared between threads.
+         */
+        template <typename Callable>
+        value_type get_or_set(key_type const& key, Callable&& callback) {
+            if (auto const* value = find(key))
+                return *value;
+            value_type value = [&] {
+                if constexpr (stl::is_invocable_v<Callable, key_type const&>) {
+                    return value_type(stl::invoke(stl::forward<Callable>(callback), key));
+                } else {
+                    return value_type(stl::invoke(stl::forward<Callable>(callback)));
+                }
+            }();
+            set(key, value);
+            return value;
+        }
+
+        /**
+         * Set the value of the key; the ones that weigh more than the whole budget are not kept.
+         */
+        template <typename KeyType, typename ValueType>
+        lru_cache& set(KeyType&& key, ValueType&& value) {
+            key_type   cache_key(stl::forward<KeyType>(key));
+            value_type cache_value(stl::forward<ValueType>(value));
+            auto const weight = weigher(cache_key, cache_value);
+            if (weight > budget) {
+                erase(cache_key);
+                return *this;
+            }
+            if (auto const it = index.find(cache_key); it != index.end()) {
+                auto& item = *it->second;
+                total_weight -= item.weight;
+                item.value  = stl::move(cache_value);
+                item.weight = weight;
+                entries.splice(entries.begin(), entries, it->second);
+            } else {
+                entries.push_front(entry{stl::move(cache_key), stl::move(cache_value), weight});
+                index.emplace(entries.front().key, entries.begin());
+            }
+            total_weight += weight;
+            evict();
+            return *this;
+        }
+
+        bool erase(key_type const& key) {
+            auto const it = index.find(key);
+            if (it == index.end())
+                return false;
+            total_weight -= it->second->weight;
+            entries.erase(it->second);
+            index.erase(it);
+            return true;
+        }
+
+        /**
+         * Whether the key is in the cache; it's not counted as a use.
+         */
+        [[nodiscard]] bool contains(key_type const& key) const {
+            return index.contains(key);
+        }
+
+        void clear() noexcept {
+            index.clear();
+            entries.clear();
+            total_weight = 0;
+        }
+
+        /**
+         * Change the budget; the entries that don't fit anymore are evicted.
+         */
+        void max_weight(stl::size_t new_budget) {
+            budget = new_budget;
+            evict();
+        }
+
+        [[nodiscard]] stl::size_t max_weight() const noexcept {
+            return budget;
+        }
+
+        [[nodiscard]] stl::size_t weight() const noexcept {
+            return total_weight;
+        }
+
+        [[nodiscard]] stl::size_t size() const noexcept {
+            return index.size();
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_CACHE_LRU_CACHE_H
@@ -0,0 +1,428 @@
+#ifndef WEBPP_CACHE_MMAP_CACHE_H
+#define WEBPP_CACHE_MMAP_CACHE_H
+
+#include "../std/std.hpp"
+#include "../utils/embedded_assets.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+
+namespace webpp {
+
+    struct mmap_cache_options {
+        stl::size_t slot_count = 64 * 1024; // rounded up to a power of 2
+        stl::size_t key_size   = 128;       // the longest key that's stored
+        stl::size_t value_size = 1024;      // the biggest value that's stored
+
+        // the TTL of the entries that are set without one; zero means they don't expire
+        stl::chrono::seconds default_ttl{0};
+    };
+
+    /**
+     * A cache in a memory-mapped file: it's still there after a restart, and the worker processes of
+     * one host that open the same file share it. It's the tier under the in-memory caches that makes
+     * the warm restarts warm.
+     *
+     * The file is a table of fixed-size slots, with open addressing: a key can be in any of the
+     * "probe_count" slots after the one that its hash points to. When they're all taken, the one that
+     * expires first is replaced. The keys and the values that don't fit in a slot are not stored.
+     *
+     * Each slot is a seqlock, so the readers (in all of the processes) don't write to the shared
+     * memory: they copy the slot and check that it didn't change while they did. The writers take the
+     * slot by making its sequence odd; a writer that loses the race for a slot drops its write, it's a
+     * cache. A slot that is left odd by a writer that died is taken over by the next writer. The hash is
+     * stable across the builds, since the file outlives them.
+     *
+     * If the file can't be opened or mapped, every lookup is a miss (see is_open). If its layout doesn't
+     * match the options, it's replaced by a new file; the processes that have the old one mapped keep
+     * using it until they open it again.
+     */
+    class mmap_cache {
+      public:
+        using key_type   = stl::string;
+        using value_type = stl::string;
+        using clock_type = stl::chrono::system_clock; // the expiry times outlive the process
+
+        static constexpr stl::size_t probe_count = 8;
+
+      private:
+        static constexpr stl::uint64_t magic          = 0x3230'4843'4143'5050ULL; // "PPCACH02"
+        static constexpr stl::uint64_t hash_seed      = 0x6d6d'6170;
+        static constexpr stl::size_t   header_size    = 64;
+        static constexpr stl::size_t   slot_alignment = 64;
+        static constexpr stl::int64_t  empty_rank     = stl::numeric_limits<stl::int64_t>::min();
+        static constexpr stl::int64_t  never_rank     = stl::numeric_limits<stl::int64_t>::max();
+
+        struct file_header {
+            stl::uint64_t magic;
+            stl::uint64_t slot_count;
+            stl::uint64_t key_size;
+            stl::uint64_t value_size;
+        };
+
+        struct slot_header {
+            stl::atomic<stl::uint64_t> seq; // odd while it's being written
+            stl::uint64_t              hash;
+            stl::int64_t               expires; // in seconds since the epoch; 0 means it doesn't expire
+            stl::uint32_t              key_length;
+            stl::uint32_t              value_length; // the key, then the value, are after the header
+            stl::atomic<::pid_t>       owner;        // the process that took it last
+        };
+
+        static_assert(stl::atomic<stl::uint64_t>::is_always_lock_free,
+                      "The processes share the slots through lock-free atomics.");
+
+        mmap_cache_options opts;
+        stl::size_t        slot_size = 0;
+        stl::size_t        mask      = 0;
+        stl::size_t        map_size  = 0;
+        char*              map       = nullptr;
+
+        [[nodiscard]] static stl::uint64_t hash_of(stl::string_view key) noexcept {
+            return details::asset_hash(key, hash_seed) | 1U; // zero is an empty slot
+        }
+
+        [[nodiscard]] slot_header& slot_at(stl::size_t index) const noexcept {
+            return *reinterpret_cast<slot_header*>(map + header_size + (index & mask) * slot_size);
+        }
+
+        [[nodiscard]] static char* data_of(slot_header& slot) noexcept {
+            return reinterpret_cast<char*>(&slot) + sizeof(slot_header);
+        }
+
+        [[nodiscard]] static stl::int64_t now_seconds() noexcept {
+            return stl::chrono::duration_cast<stl::chrono::seconds>(clock_type::now().time_since_epoch())
+              .count();
+        }
+
+        [[nodiscard]] static bool is_live(stl::int64_t expires, stl::int64_t now) noexcept {
+            return expires == 0 || expires > now;
+        }
+
+        bool format(int fd) const noexcept {
+            if (::ftruncate(fd, static_cast<::off_t>(map_size)) != 0)
+                return false;
+            file_header const header{magic, mask + 1, opts.key_size, opts.value_size};
+            return ::pwrite(fd, &header, sizeof(header), 0) == static_cast<::ssize_t>(sizeof(header));
+        }
+
+        /**
+         * The file that should be mapped: this one if it's in the layout of the options (or if it's
+         * new), or else a new one that replaces it. The old one is not touched, since the other
+         * processes could have it mapped. The callers hold the file lock.
+         * @returns -1 if it fails, or the file descriptor of the file that was put in its place
+         */
+        int prepare(stl::filesystem::path const& path, int fd) const noexcept {
+            struct stat info {};
+            if (::fstat(fd, &info) != 0)
+                return -1;
+            if (info.st_size == 0)
+                return format(fd) ? fd : -1;
+            bool const matches = static_cast<stl::size_t>(info.st_size) == map_size && [&] {
+                file_header header{};
+                return ::pread(fd, &header, sizeof(header), 0) == static_cast<::ssize_t>(sizeof(header)) &&
+                       header.magic == magic && header.slot_count == mask + 1 &&
+                       header.key_size == opts.key_size && header.value_size == opts.value_size;
+            }();
+            if (matches)
+                return fd;
+
+            auto replacement = path;
+            replacement += ".new-" + stl::to_string(::getpid());
+            int const new_fd = ::open(replacement.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+            if (new_fd == -1)
+                return -1;
+            if (!format(new_fd) || ::rename(replacement.c_str(), path.c_str()) != 0) {
+                ::unlink(replacement.c_str());
+                ::close(new_fd);
+                return -1;
+            }
+            return new_fd;
+        }
+
+        // the file is still the one at the path; it's not if it was replaced while we waited for its lock
+        [[nodiscard]] static bool is_current(stl::filesystem::path const& path, int fd) noexcept {
+            struct stat opened {};
+            struct stat named {};
+            return ::fstat(fd, &opened) == 0 && ::stat(path.c_str(), &named) == 0 &&
+                   opened.st_dev == named.st_dev && opened.st_ino == named.st_ino;
+        }
+
+        void open_map(stl::filesystem::path const& path) noexcept {
+            // one process formats the file, the others wait for it
+            for (int attempt = 0; attempt < 4; attempt++) {
+                int const fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+                if (fd == -1)
+                    return;
+                bool replaced = false;
+                if (::flock(fd, LOCK_EX) == 0) {
+                    replaced = !is_current(path, fd);
+                    if (int const map_fd = replaced ? -1 : prepare(path, fd); map_fd != -1) {
+                        void* const res = ::mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, map_fd, 0);
+                        if (res != MAP_FAILED)
+                            map = static_cast<char*>(res);
+                        if (map_fd != fd)
+                            ::close(map_fd);
+                    }
+                    ::flock(fd, LOCK_UN);
+                }
+                ::close(fd);
+                if (!replaced)
+                    return;
+            }
+        }
+
+        // call the function with a copy of the value of the key
+        template <typename Func>
+        bool read_slot(stl::string_view key, Func&& func) const {
+            if (map == nullptr || key.size() > opts.key_size)
+                return false;
+            auto const hash = hash_of(key);
+            auto const now  = now_seconds();
+            for (stl::size_t probe = 0; probe < probe_count; probe++) {
+                auto&      slot = slot_at(hash + probe);
+                auto const seq  = slot.seq.load(stl::memory_order_acquire);
+                if ((seq & 1U) != 0 || slot.hash != hash)
+                    continue;
+                auto const key_length   = slot.key_length;
+                auto const value_length = slot.value_length;
+                auto const expires      = slot.expires;
+                if (key_length != key.size() || value_length > opts.value_size ||
+                    stl::memcmp(data_of(slot), key.data(), key.size()) != 0)
+                    continue;
+                value_type value(data_of(slot) + key_length, value_length);
+                stl::atomic_thread_fence(stl::memory_order_acquire);
+                if (slot.seq.load(stl::memory_order_relaxed) != seq)
+                    continue; // it changed while it was copied
+                if (!is_live(expires, now))
+                    return false;
+                stl::invoke(stl::forward<Func>(func), stl::move(value));
+                return true;
+            }
+            return false;
+        }
+
+        // the writer that has the slot is gone, so it's never going to give it back
+        [[nodiscard]] static bool is_abandoned(slot_header const& slot) noexcept {
+            auto const owner = slot.owner.load(stl::memory_order_relaxed);
+            return owner > 0 && owner != ::getpid() && ::kill(owner, 0) == -1 && errno == ESRCH;
+        }
+
+        // take the slot for writing; false if another writer has it
+        [[nodiscard]] static bool lock_slot(slot_header& slot, stl::uint64_t& seq) noexcept {
+            seq = slot.seq.load(stl::memory_order_relaxed);
+            if ((seq & 1U) != 0) {
+                // it stays odd while it's taken over, and it's unlocked as if it was even
+                if (!is_abandoned(slot) ||
+                    !slot.seq.compare_exchange_strong(seq, seq + 2, stl::memory_order_acquire))
+                    return false;
+                seq++;
+            } else if (!slot.seq.compare_exchange_strong(seq, seq + 1, stl::memory_order_acquire)) {
+                return false;
+            }
+            slot.owner.store(::getpid(), stl::memory_order_relaxed);
+            stl::atomic_thread_fence(stl::memory_order_release);
+            return true;
+        }
+
+        static void unlock_slot(slot_header& slot, stl::uint64_t seq) noexcept {
+            slot.seq.store(seq + 2, stl::memory_order_release);
+        }
+
+        [[nodiscard]] bool holds(slot_header& slot, stl::uint64_t hash, stl::string_view key) const noexcept {
+            return slot.hash == hash && slot.key_length == key.size() &&
+                   stl::memcmp(data_of(slot), key.data(), key.size()) == 0;
+        }
+
+      public:
+        explicit mmap_cache(stl::filesystem::path const& path, mmap_cache_options options = {}) noexcept
+          : opts{options} {
+            auto const slot_count = stl::bit_ceil(stl::max<stl::size_t>(opts.slot_count, probe_count));
+            slot_size = (sizeof(slot_header) + opts.key_size + opts.value_size + slot_alignment - 1) /
+                        slot_alignment * slot_alignment;
+            mask      = slot_count - 1;
+            map_size  = header_size + slot_count * slot_size;
+            open_map(path);
+        }
+
+        mmap_cache(mmap_cache&& other) noexcept
+          : opts{other.opts},
+            slot_size{other.slot_size},
+            mask{other.mask},
+            map_size{other.map_size},
+            map{stl::exchange(other.map, nullptr)} {}
+
+        mmap_cache(mmap_cache const&)            = delete;
+        mmap_cache& operator=(mmap_cache const&) = delete;
+        mmap_cache& operator=(mmap_cache&&)      = delete;
+
+        ~mmap_cache() {
+            if (map != nullptr)
+                ::munmap(map, map_size);
+        }
+
+        [[nodiscard]] bool is_open() const noexcept {
+            return map != nullptr;
+        }
+
+        [[nodiscard]] stl::optional<value_type> get(stl::string_view key) const {
+            stl::optional<value_type> res;
+            read_slot(key, [&res](value_type&& value) {
+                res.emplace(stl::move(value));
+            });
+            return res;
+        }
+
+        template <typename DataType>
+        [[nodiscard]] value_type get(stl::string_view key, DataType&& default_value) const {
+            if (auto value = get(key))
+                return stl::move(*value);
+            return value_type(stl::forward<DataType>(default_value));
+        }
+
+        /**
+         * Set the value of the key; it's dropped if it doesn't fit in a slot, or if another writer
+         * has the slot.
+         */
+        mmap_cache& set(stl::string_view key, stl::string_view value, stl::chrono::seconds ttl) {
+            if (map == nullptr || key.size() > opts.key_size || value.size() > opts.value_size)
+                return *this;
+            auto const   hash    = hash_of(key);
+            auto const   now     = now_seconds();
+            stl::int64_t expires = ttl.count() > 0 ? now + ttl.count() : 0;
+
+            // the slot of the key if it's there, or else an empty or expired one, or else the one that
+            // expires first
+            slot_header* target = nullptr;
+            stl::int64_t rank   = 0;
+            for (stl::size_t probe = 0; probe < probe_count; probe++) {
+                auto& slot = slot_at(hash + probe);
+                if (holds(slot, hash, key)) {
+                    target = &slot;
+                    break;
+                }
+                auto const slot_rank = slot.hash == 0 || !is_live(slot.expires, now) ? empty_rank
+                                       : slot.expires == 0                         ? never_rank
+                                                                                   : slot.expires;
+                if (target == nullptr || slot_rank < rank) {
+                    target = &slot;
+                    rank   = slot_rank;
+                }
+            }
+
+            stl::uint64_t seq = 0;
+            if (!lock_slot(*target, seq))
+                return *this;
+            target->hash         = hash;
+            target->expires      = expires;
+            target->key_length   = static_cast<stl::uint32_t>(key.size());
+            target->value_length = static_cast<stl::uint32_t>(value.size());
+            stl::memcpy(data_of(*target), key.data(), key.size());
+            stl::memcpy(data_of(*target) + key.size(), value.data(), value.size());
+            unlock_slot(*target, seq);
+            return *this;
+        }
+
+        template <typename KeyType, typename ValueType>
+        mmap_cache& set(KeyType&& key, ValueType&& value) {
+            return set(stl::string_view{key}, stl::string_view{value}, opts.default_ttl);
+        }
+
+        bool erase(stl::string_view key) {
+            if (map == nullptr || key.size() > opts.key_size)
+                return false;
+            auto const hash = hash_of(key);
+            for (stl::size_t probe = 0; probe < probe_count; probe++) {
+                auto&         slot = slot_at(hash + probe);
+                stl::uint64_t seq  = 0;
+                if (!holds(slot, hash, key) || !lock_slot(slot, seq))
+                    continue;
+                bool const found = holds(slot, hash, key); // it could've changed before it was taken
+                if (found)
+                    slot.hash = 0;
+                unlock_slot(slot, seq);
+                if (found)
+                    return true;
+            }
+            return false;
+        }
+
+        [[nodiscard]] bool contains(stl::string_view key) const {
+            return read_slot(key, [](value_type&&) {});
+        }
+
+        /**
+         * The value of the key; if it's not there, the callback computes it (it's called with the key,
+         * or with nothing) and it's set.
+         */
+        template <typename Callable>
+        value_type get_or_set(stl::string_view key, Callable&& callback) {
+            if (auto value = get(key))
+                return stl::move(*value);
+            value_type value = [&] {
+                if constexpr (stl::is_invocable_v<Callable, key_type const&>) {
+                    return value_type(stl::invoke(stl::forward<Callable>(callback), key_type{key}));
+                } else {
+                    return value_type(stl::invoke(stl::forward<Callable>(callback)));
+                }
+            }();
+            set(key, value);
+            return value;
+        }
+
+        /**
+         * Empty all of the slots; the slots that are being written are skipped.
+         */
+        void clear() noexcept {
+            for (stl::size_t index = 0; map != nullptr && index <= mask; index++) {
+                auto&         slot = slot_at(index);
+                stl::uint64_t seq  = 0;
+                if (slot.hash != 0 && lock_slot(slot, seq)) {
+                    slot.hash = 0;
+                    unlock_slot(slot, seq);
+                }
+            }
+        }
+
+        /**
+         * The number of the live entries; it reads all of the slots.
+         */
+        [[nodiscard]] stl::size_t size() const noexcept {
+            stl::size_t res = 0;
+            auto const  now = now_seconds();
+            for (stl::size_t index = 0; map != nullptr && index <= mask; index++) {
+                auto const& slot = slot_at(index);
+                if (slot.hash != 0 && is_live(slot.expires, now))
+                    res++;
+            }
+            return res;
+        }
+
+        [[nodiscard]] stl::size_t capacity() const noexcept {
+            return map == nullptr ? 0 : mask + 1;
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_CACHE_MMAP_CACHE_H
@@ -1,6 +1,7 @@
 #ifndef WEBPP_CACHE_PASSIVE_CACHE
 #define WEBPP_CACHE_PASSIVE_CACHE
 
+#include <string>
 #include <string_view>
 #include <type_traits>
 
@@ -21,7 +22,7 @@ namespace webpp {
 
       private:
       public:
-        passive_cache() noexcept;
+        passive_cache() noexcept = default;
 
         template <typename KeyValue, typename DataType>
         auto get(KeyValue&& /* key */,
@@ -0,0 +1,200 @@
+#ifndef WEBPP_CACHE_REFRESHING_CACHE_H
+#define WEBPP_CACHE_REFRESHING_CACHE_H
+
+#include "../std/std.hpp"
+#include "../utils/thread_pool.hpp"
+#include "./lru_cache.hpp"
+#include "./sharded_cache.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <unordered_set>
+#include <utility>
+
+namespace webpp {
+
+    namespace details {
+        /**
+         * The pool that refreshes the caches that aren't given an executor; they all share it, and
+         * it's started by the first refresh
+         */
+        inline thread_pool& refresh_pool() {
+            static thread_pool pool{};
+            return pool;
+        }
+    } // namespace details
+
+    struct refresh_options {
+        // the entries are served as they are until the soft TTL, then they're served stale while they're
+        // refreshed in the background, until the hard TTL
+        stl::chrono::nanoseconds soft_ttl = stl::chrono::minutes{1};
+        stl::chrono::nanoseconds hard_ttl = stl::chrono::minutes{5};
+
+        // the TTLs of each entry are moved by up to this fraction of them, randomly, so the entries that
+        // are set together don't expire together
+        double jitter = 0.1;
+    };
+
+    /**
+     * A value, and the times that it's fresh and stale until
+     */
+    template <typename ValueType, typename TimePoint>
+    struct timed_value {
+        ValueType value;
+        TimePoint fresh_until;
+        TimePoint stale_until;
+    };
+
+    /**
+     * A concurrent cache (see sharded_cache) whose entries are refreshed before they expire
+     * (stale-while-revalidate): after the soft TTL of an entry, it's still served, and the loader is
+     * called in the background to refresh it; only the requests that come after its hard TTL wait for
+     * the loader (one of them calls it, the others wait for it). The TTLs have a random jitter, so the
+     * entries that are set together are refreshed at different times.
+     *
+     * The refreshes run on the executor, a function that runs a task somewhere else, like:
+     *   [&pool](auto task) { pool.post(task_priority::background, std::move(task)); } // a thread_pool
+     * By default they're posted in the background lane of a pool that all of the caches share, so a lot
+     * of keys that go stale together don't start a thread each. A key has one refresh at a time, and the
+     * failed ones (the loader throws) are tried again by the next request.
+     *
+     *   refreshing_cache<std::string, std::string> pages{10'000, {.soft_ttl = 30s, .hard_ttl = 5min}};
+     *   auto page = pages.get_or_set(path, [](std::string const& path) { return render(path); });
+     */
+    template <typename KeyT,
+              typename ValT,
+              template <typename...> typename Cache = lru_cache,
+              stl::size_t ShardCount                = 64,
+              typename Clock                        = stl::chrono::steady_clock>
+    class refreshing_cache {
+      public:
+        using key_type      = KeyT;
+        using value_type    = ValT;
+        using clock_type    = Clock;
+        using time_point    = typename Clock::time_point;
+        using entry_type    = timed_value<value_type, time_point>;
+        using loader_type   = stl::function<value_type(key_type const&)>;
+        using executor_type = stl::function<void(stl::function<void()>)>;
+
+      private:
+        // the tasks of the refreshes hold it, so it outlives the cache until they're done
+        struct state_type {
+            sharded_cache<Cache<key_type, entry_type>, ShardCount> entries;
+            refresh_options                                        options;
+            stl::mutex                                             lock{};
+            stl::unordered_set<key_type>                           refreshing{};
+
+            state_type(stl::size_t max_weight, refresh_options const& opts)
+              : entries{max_weight},
+                options{opts} {}
+
+            [[nodiscard]] entry_type make_entry(value_type value) const {
+                auto const now = clock_type::now();
+                // the same factor for both of the TTLs of an entry
+                thread_local stl::minstd_rand    random{stl::random_device{}()};
+                stl::uniform_real_distribution<> dist{-options.jitter, options.jitter};
+                auto const                       factor = 1.0 + (options.jitter > 0 ? dist(random) : 0.0);
+                auto const scale = [factor](stl::chrono::nanoseconds ttl) {
+                    return stl::chrono::duration_cast<typename clock_type::duration>(
+                      stl::chrono::duration<double, stl::nano>{static_cast<double>(ttl.count()) * factor});
+                };
+                return {stl::move(value), now + scale(options.soft_ttl), now + scale(options.hard_ttl)};
+            }
+        };
+
+        stl::shared_ptr<state_type> state;
+        executor_type               executor;
+
+        void refresh(key_type const& key, loader_type const& loader) {
+            {
+                stl::scoped_lock const guard{state->lock};
+                if (!state->refreshing.insert(key).second)
+                    return; // it's being refreshed already
+            }
+            executor([shared = state, key, loader] {
+                try {
+                    shared->entries.set(key, shared->make_entry(loader(key)));
+                } catch (...) {
+                    // the stale value is served until the next request tries again
+                }
+                stl::scoped_lock const guard{shared->lock};
+                shared->refreshing.erase(key);
+            });
+        }
+
+      public:
+        explicit refreshing_cache(stl::size_t     max_weight = 1024 * ShardCount,
+                                  refresh_options options    = {},
+                                  executor_type   exec       = {})
+          : state{stl::make_shared<state_type>(max_weight, options)},
+            executor{stl::move(exec)} {
+            if (!executor) {
+                executor = [](stl::function<void()> task) {
+                    details::refresh_pool().post(task_priority::background, stl::move(task));
+                };
+            }
+        }
+
+        /**
+         * The value of the key, if it's not past its hard TTL; it's not refreshed.
+         */
+        [[nodiscard]] stl::optional<value_type> get(key_type const& key) {
+            auto entry = state->entries.get(key);
+            if (!entry || entry->stale_until <= clock_type::now())
+                return stl::nullopt;
+            return stl::move(entry->value);
+        }
+
+        /**
+         * The value of the key: the fresh one right away; the stale one right away too, while it's
+         * refreshed in the background; or the one that the loader returns when there's none.
+         */
+        template <typename Loader>
+        value_type get_or_set(key_type const& key, Loader&& load) {
+            auto const now = clock_type::now();
+            if (auto entry = state->entries.get(key)) {
+                if (now < entry->fresh_until)
+                    return stl::move(entry->value);
+                if (now < entry->stale_until) {
+                    refresh(key, loader_type{load});
+                    return stl::move(entry->value);
+                }
+                state->entries.erase(key); // it's too old to be served
+            }
+            return state->entries
+              .get_or_set(key,
+                          [&] {
+                              return state->make_entry(stl::invoke(stl::forward<Loader>(load), key));
+                          })
+              .value;
+        }
+
+        template <typename KeyType, typename ValueType>
+        refreshing_cache& set(KeyType&& key, ValueType&& value) {
+            state->entries.set(stl::forward<KeyType>(key),
+                               state->make_entry(value_type(stl::forward<ValueType>(value))));
+            return *this;
+        }
+
+        bool erase(key_type const& key) {
+            return state->entries.erase(key);
+        }
+
+        /**
+         * The number of the refreshes that are not done yet
+         */
+        [[nodiscard]] stl::size_t refreshing() const {
+            stl::scoped_lock const guard{state->lock};
+            return state->refreshing.size();
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_CACHE_REFRESHING_CACHE_H
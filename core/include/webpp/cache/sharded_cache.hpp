@@ -0,0 +1,239 @@
+#ifndef WEBPP_CACHE_SHARDED_CACHE_H
+#define WEBPP_CACHE_SHARDED_CACHE_H
+
+#include "../std/std.hpp"
+#include "./lru_cache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+namespace webpp {
+
+    /**
+     * A cache that's shared between the threads: the keys are spread over the shards, and each shard is
+     * a cache of its own (lru_cache, tinylfu_cache, ...) with its own lock, on its own cache line, so
+     * the threads that look up different keys don't wait for each other.
+     *
+     * The lookups only take the shard's lock for reading; the use of the key is recorded afterwards if
+     * the lock is free, and it's dropped if it's not: under heavy load the order of the entries is a
+     * bit off, but the readers never wait for it. The writes lock the shard.
+     *
+     * The budget is split evenly between the shards.
+     *
+     *   sharded_cache<tinylfu_cache<std::string, std::string>> cache{10'000};
+     *   cache.set(path, body);
+     *   if (auto body = cache.get(path)) ...
+     */
+    template <typename Cache = lru_cache<>, stl::size_t ShardCount = 64>
+    class sharded_cache {
+        static_assert(stl::has_single_bit(ShardCount), "The number of the shards should be a power of 2.");
+
+      public:
+        using cache_type = Cache;
+        using key_type   = typename Cache::key_type;
+        using value_type = typename Cache::value_type;
+
+        static constexpr stl::size_t shard_count = ShardCount;
+
+      private:
+        struct alignas(64) shard {
+            mutable stl::shared_mutex                                     lock;
+            cache_type                                                    cache;
+            stl::unordered_map<key_type, stl::shared_future<value_type>> flights{}; // being computed
+
+            template <typename... Args>
+            explicit shard(Args&&... args) : cache(stl::forward<Args>(args)...) {}
+        };
+
+        using shards_type = stl::array<shard, shard_count>;
+
+        stl::unique_ptr<shards_type> shards;
+
+        template <stl::size_t... Index, typename... Args>
+        static stl::unique_ptr<shards_type>
+        make_shards(stl::index_sequence<Index...>, stl::size_t budget, Args const&... args) {
+            return stl::unique_ptr<shards_type>{
+              new shards_type{shard{(static_cast<void>(Index), budget), args...}...}};
+        }
+
+        [[nodiscard]] shard& shard_of(key_type const& key) const noexcept {
+            // the high bits pick the shard; the maps of the shards use the low ones for their buckets
+            auto const hash  = static_cast<stl::uint64_t>(stl::hash<key_type>{}(key));
+            auto const mixed = hash * 0x9E37'79B9'7F4A'7C15ULL;
+            return (*shards)[mixed >> (64 - stl::countr_zero(shard_count))];
+        }
+
+      public:
+        /**
+         * @param max_weight the budget of the whole cache
+         * @param args the rest of the arguments of the caches of the shards (the weigher, ...)
+         */
+        template <typename... Args>
+        explicit sharded_cache(stl::size_t max_weight = 1024 * shard_count, Args const&... args)
+          : shards{make_shards(stl::make_index_sequence<shard_count>{},
+                               stl::max<stl::size_t>(max_weight / shard_count, 1),
+                               args...)} {}
+
+        sharded_cache(sharded_cache const&)            = delete;
+        sharded_cache& operator=(sharded_cache const&) = delete;
+
+        /**
+         * Call the function with the value of the key (without copying it); the shard is locked for
+         * reading while it's called, so don't call the cache from it.
+         * @returns false if the key is not there
+         */
+        template <typename Func>
+        bool visit(key_type const& key, Func&& func) {
+            auto& s = shard_of(key);
+            {
+                stl::shared_lock const guard{s.lock};
+                auto const*            value = s.cache.peek(key);
+                if (value == nullptr)
+                    return false;
+                stl::invoke(stl::forward<Func>(func), *value);
+            }
+            if (stl::unique_lock guard{s.lock, stl::try_to_lock}; guard.owns_lock())
+                s.cache.touch(key);
+            return true;
+        }
+
+        /**
+         * A copy of the value of the key, if it's there
+         */
+        [[nodiscard]] stl::optional<value_type> get(key_type const& key) {
+            stl::optional<value_type> res;
+            visit(key, [&res](value_type const& value) {
+                res.emplace(value);
+            });
+            return res;
+        }
+
+        template <typename DataType>
+        [[nodiscard]] value_type get(key_type const& key, DataType&& default_value) {
+            if (auto value = get(key))
+                return stl::move(*value);
+            return value_type(stl::forward<DataType>(default_value));
+        }
+
+        /**
+         * The value of the key; if it's not there, the callback computes it (it's called with the key,
+         * or with nothing) and it's set. When the threads miss the same key at the same time, only one
+         * of them calls the callback, and the others wait for its result (single-flight), so the
+         * backends don't get a stampede of the same request when a popular entry is evicted.
+         *
+         * The exception of the callback is thrown in all of the threads that wait for it, and nothing
+         * is set.
+         */
+        template <typename Callable>
+        value_type get_or_set(key_type const& key, Callable&& callback) {
+            if (auto value = get(key))
+                return stl::move(*value);
+
+            auto&                          s = shard_of(key);
+            stl::promise<value_type>       promise;
+            stl::shared_future<value_type> flight;
+            {
+                stl::scoped_lock const guard{s.lock};
+                if (auto const* value = s.cache.peek(key))
+                    return *value; // it was set after the lookup above
+                if (auto const it = s.flights.find(key); it != s.flights.end()) {
+                    flight = it->second;
+                } else {
+                    s.flights.emplace(key, promise.get_future().share());
+                }
+            }
+            if (flight.valid())
+                return flight.get(); // another thread is computing it
+
+            try {
+                value_type value = [&] {
+                    if constexpr (stl::is_invocable_v<Callable, key_type const&>) {
+                        return value_type(stl::invoke(stl::forward<Callable>(callback), key));
+                    } else {
+                        return value_type(stl::invoke(stl::forward<Callable>(callback)));
+                    }
+                }();
+                {
+                    stl::scoped_lock const guard{s.lock};
+                    s.cache.set(key, value);
+                    s.flights.erase(key);
+                }
+                promise.set_value(value);
+                return value;
+            } catch (...) {
+                {
+                    stl::scoped_lock const guard{s.lock};
+                    s.flights.erase(key);
+                }
+                promise.set_exception(stl::current_exception());
+                throw;
+            }
+        }
+
+        template <typename KeyType, typename ValueType>
+        sharded_cache& set(KeyType&& key, ValueType&& value) {
+            key_type               cache_key(stl::forward<KeyType>(key));
+            auto&                  s = shard_of(cache_key);
+            stl::scoped_lock const guard{s.lock};
+            s.cache.set(stl::move(cache_key), stl::forward<ValueType>(value));
+            return *this;
+        }
+
+        bool erase(key_type const& key) {
+            auto&                  s = shard_of(key);
+            stl::scoped_lock const guard{s.lock};
+            return s.cache.erase(key);
+        }
+
+        [[nodiscard]] bool contains(key_type const& key) const {
+            auto&                  s = shard_of(key);
+            stl::shared_lock const guard{s.lock};
+            return s.cache.contains(key);
+        }
+
+        void clear() {
+            for (auto& s : *shards) {
+                stl::scoped_lock const guard{s.lock};
+                s.cache.clear();
+            }
+        }
+
+        /**
+         * The number of the entries; the shards are counted one at a time, so it's not exact while the
+         * other threads change the cache.
+         */
+        [[nodiscard]] stl::size_t size() const {
+            stl::size_t res = 0;
+            for (auto& s : *shards) {
+                stl::shared_lock const guard{s.lock};
+                res += s.cache.size();
+            }
+            return res;
+        }
+
+        [[nodiscard]] stl::size_t weight() const {
+            stl::size_t res = 0;
+            for (auto& s : *shards) {
+                stl::shared_lock const guard{s.lock};
+                res += s.cache.weight();
+            }
+            return res;
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_CACHE_SHARDED_CACHE_H
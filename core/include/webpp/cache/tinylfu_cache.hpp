@@ -0,0 +1,341 @@
+#ifndef WEBPP_CACHE_TINYLFU_CACHE_H
+#define WEBPP_CACHE_TINYLFU_CACHE_H
+
+#include "../std/std.hpp"
+#include "./cache_weight.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace webpp {
+
+    namespace details {
+
+        /**
+         * How often the keys are used, roughly: a count-min sketch of 4-bit counters, 4 rows of them
+         * in each word. The counters are halved every so often, so the keys that were popular a while
+         * ago fade away.
+         */
+        class frequency_sketch {
+            static constexpr stl::array<stl::uint64_t, 4> seeds{0xC3A5'C85C'97CB'3127ULL,
+                                                                0xB492'B66F'BE98'F273ULL,
+                                                                0x9AE1'6A3B'2F90'404FULL,
+                                                                0xCBF2'9CE4'8422'2325ULL};
+
+            stl::vector<stl::uint64_t> table;
+            stl::size_t                sample_size;
+            stl::size_t                additions = 0;
+
+            // the word, and the shift of the counter in it, of the row
+            [[nodiscard]] stl::pair<stl::size_t, unsigned> counter_of(stl::uint64_t hash,
+                                                                     stl::size_t   row) const noexcept {
+                auto mixed = (hash + seeds[row]) * seeds[row];
+                mixed ^= mixed >> 32U;
+                auto const word  = static_cast<stl::size_t>(mixed) & (table.size() - 1);
+                auto const shift = static_cast<unsigned>(((mixed >> 61U) & 3U) + row * 4) * 4U;
+                return {word, shift};
+            }
+
+            void reset() noexcept {
+                for (auto& word : table)
+                    word = (word >> 1U) & 0x7777'7777'7777'7777ULL;
+                additions /= 2;
+            }
+
+          public:
+            explicit frequency_sketch(stl::size_t expected_entries)
+              : table(stl::bit_ceil(stl::max<stl::size_t>(expected_entries, 16))),
+                sample_size{table.size() * 10} {}
+
+            void increment(stl::uint64_t hash) noexcept {
+                bool added = false;
+                for (stl::size_t row = 0; row < seeds.size(); row++) {
+                    auto const [word, shift] = counter_of(hash, row);
+                    if (((table[word] >> shift) & 0xFU) != 0xFU) {
+                        table[word] += 1ULL << shift;
+                        added = true;
+                    }
+                }
+                if (added && ++additions >= sample_size)
+                    reset();
+            }
+
+            [[nodiscard]] unsigned frequency(stl::uint64_t hash) const noexcept {
+                unsigned res = 0xFU;
+                for (stl::size_t row = 0; row < seeds.size(); row++) {
+                    auto const [word, shift] = counter_of(hash, row);
+                    res = stl::min(res, static_cast<unsigned>((table[word] >> shift) & 0xFU));
+                }
+                return res;
+            }
+        };
+
+    } // namespace details
+
+    /**
+     * A cache that keeps the entries that are used often, even through the scans of the keys that are
+     * used once (W-TinyLFU). The new entries go into a small LRU window (1% of the budget); the ones
+     * that fall out of it are admitted to the main part only if they're used more often than the
+     * entry that'd be evicted for them. The main part is a segmented LRU: the entries that are used
+     * again move from its probation segment to its protected one (80% of it).
+     *
+     * All of the operations are O(1). The budget is in the weights of the entries (see unit_weight and
+     * byte_weight); the "expected_entries" sizes the frequency sketch, and it's the budget by default.
+     * It's not thread-safe; the caches that are shared between the threads need a lock around them.
+     */
+    template <typename KeyT     = stl::string,
+              typename ValT     = stl::string,
+              typename Weigher  = unit_weight,
+              typename Hash     = stl::hash<KeyT>,
+              typename KeyEqual = stl::equal_to<KeyT>>
+    class tinylfu_cache {
+      public:
+        using key_type     = KeyT;
+        using value_type   = ValT;
+        using weigher_type = Weigher;
+
+      private:
+        enum struct segment : stl::uint8_t { window, probation, protect };
+
+        struct entry {
+            key_type      key;
+            value_type    value;
+            stl::size_t   weight;
+            stl::uint64_t hash;
+            segment       place;
+        };
+
+        using list_type = stl::list<entry>;
+        using iterator  = typename list_type::iterator;
+
+        // the most recently used first in each of them
+        stl::array<list_type, 3>   lists{};
+        stl::array<stl::size_t, 3> weights{};
+
+        stl::unordered_map<key_type, iterator, Hash, KeyEqual> index{};
+        details::frequency_sketch                              sketch;
+        stl::size_t                                            budget;
+        [[no_unique_address]] Hash                             hasher{};
+        [[no_unique_address]] weigher_type                     weigher;
+
+        [[nodiscard]] list_type& list_of(segment place) noexcept {
+            return lists[static_cast<stl::size_t>(place)];
+        }
+
+        [[nodiscard]] stl::size_t& weight_of(segment place) noexcept {
+            return weights[static_cast<stl::size_t>(place)];
+        }
+
+        [[nodiscard]] stl::size_t window_budget() const noexcept {
+            return stl::max<stl::size_t>(budget / 100, 1);
+        }
+
+        [[nodiscard]] stl::size_t protected_budget() const noexcept {
+            return (budget - stl::min(budget, window_budget())) / 5 * 4;
+        }
+
+        [[nodiscard]] stl::size_t total_weight() const noexcept {
+            return weights[0] + weights[1] + weights[2];
+        }
+
+        // move the entry to the front of the segment
+        void move_to(iterator it, segment place) {
+            weight_of(it->place) -= it->weight;
+            weight_of(place) += it->weight;
+            list_of(place).splice(list_of(place).begin(), list_of(it->place), it);
+            it->place = place;
+        }
+
+        void remove(iterator it) {
+            weight_of(it->place) -= it->weight;
+            index.erase(it->key);
+            list_of(it->place).erase(it);
+        }
+
+        void on_hit(iterator it) {
+            switch (it->place) {
+                case segment::window: move_to(it, segment::window); break;
+                case segment::probation:
+                    move_to(it, segment::protect);
+                    while (weight_of(segment::protect) > protected_budget())
+                        move_to(stl::prev(list_of(segment::protect).end()), segment::probation);
+                    break;
+                case segment::protect: move_to(it, segment::protect); break;
+            }
+        }
+
+        // the least recently used one of the main part
+        [[nodiscard]] iterator victim_of(iterator candidate) {
+            auto& probation = list_of(segment::probation);
+            auto  victim    = stl::prev(probation.end());
+            if (victim == candidate && !list_of(segment::protect).empty())
+                victim = stl::prev(list_of(segment::protect).end());
+            return victim;
+        }
+
+        void evict() {
+            // the ones that fall out of the window try to get into the main part
+            while (weight_of(segment::window) > window_budget()) {
+                auto const candidate = stl::prev(list_of(segment::window).end());
+                move_to(candidate, segment::probation);
+                while (total_weight() > budget) {
+                    auto const victim = victim_of(candidate);
+                    if (victim == candidate ||
+                        sketch.frequency(candidate->hash) <= sketch.frequency(victim->hash)) {
+                        remove(candidate);
+                        break;
+                    }
+                    remove(victim);
+                }
+            }
+            // the window is within its budget, but a bigger value could've been set in the main part
+            for (auto place : {segment::probation, segment::protect, segment::window})
+                while (total_weight() > budget && !list_of(place).empty())
+                    remove(stl::prev(list_of(place).end()));
+        }
+
+      public:
+        explicit tinylfu_cache(stl::size_t  max_weight       = 1024,
+                               stl::size_t  expected_entries = 0,
+                               weigher_type weigh            = {})
+          : sketch{expected_entries != 0 ? expected_entries : max_weight},
+            budget{max_weight},
+            weigher{stl::move(weigh)} {}
+
+        /**
+         * The value of the key, or null; it's counted as a use of the key, even if it's not there.
+         */
+        [[nodiscard]] value_type* find(key_type const& key) {
+            auto const hash = static_cast<stl::uint64_t>(hasher(key));
+            sketch.increment(hash);
+            auto const it = index.find(key);
+            if (it == index.end())
+                return nullptr;
+            auto const item = it->second;
+            on_hit(item);
+            return &item->value;
+        }
+
+        /**
+         * The value of the key, or null, without counting it as a use; the concurrent caches look the
+         * keys up with it under a shared lock, and "touch" them later.
+         */
+        [[nodiscard]] value_type const* peek(key_type const& key) const {
+            auto const it = index.find(key);
+            return it == index.end() ? nullptr : &it->second->value;
+        }
+
+        /**
+         * Count it as a use of the key, even if it's not there
+         */
+        void touch(key_type const& key) {
+            static_cast<void>(find(key));
+        }
+
+        template <typename DataType>
+        [[nodiscard]] value_type get(key_type const& key, DataType&& default_value) {
+            if (auto const* value = find(key))
+                return *value;
+            return value_type(stl::forward<DataType>(default_value));
+        }
+
+        /**
+         * The value of the key; if it's not there, the callback computes it (it's called with the key,
+         * or with nothing) and it's set. See sharded_cache for the one that's shared between threads.
+         */
+        template <typename Callable>
+        value_type get_or_set(key_type const& key, Callable&& callback) {
+            if (auto const* value = find(key))
+                return *value;
+            value_type value = [&] {
+                if constexpr (stl::is_invocable_v<Callable, key_type const&>) {
+                    return value_type(stl::invoke(stl::forward<Callable>(callback), key));
+                } else {
+                    return value_type(stl::invoke(stl::forward<Callable>(callback)));
+                }
+            }();
+            set(key, value);
+            return value;
+        }
+
+        /**
+         * Set the value of the key; a new key may not be kept if it's used less often than the ones that
+         * are in the cache, and the ones that weigh more than the whole budget are not kept at all.
+         */
+        template <typename KeyType, typename ValueType>
+        tinylfu_cache& set(KeyType&& key, ValueType&& value) {
+            key_type   cache_key(stl::forward<KeyType>(key));
+            value_type cache_value(stl::forward<ValueType>(value));
+            auto const weight = weigher(cache_key, cache_value);
+            if (weight > budget) {
+                erase(cache_key);
+                return *this;
+            }
+            auto const hash = static_cast<stl::uint64_t>(hasher(cache_key));
+            sketch.increment(hash);
+            if (auto const it = index.find(cache_key); it != index.end()) {
+                auto const item = it->second;
+                weight_of(item->place) -= item->weight;
+                weight_of(item->place) += weight;
+                item->value  = stl::move(cache_value);
+                item->weight = weight;
+                on_hit(item);
+            } else {
+                auto& window = list_of(segment::window);
+                window.push_front(
+                  entry{stl::move(cache_key), stl::move(cache_value), weight, hash, segment::window});
+                weight_of(segment::window) += weight;
+                index.emplace(window.front().key, window.begin());
+            }
+            evict();
+            return *this;
+        }
+
+        bool erase(key_type const& key) {
+            auto const it = index.find(key);
+            if (it == index.end())
+                return false;
+            remove(it->second);
+            return true;
+        }
+
+        /**
+         * Whether the key is in the cache; it's not counted as a use.
+         */
+        [[nodiscard]] bool contains(key_type const& key) const {
+            return index.contains(key);
+        }
+
+        void clear() noexcept {
+            index.clear();
+            for (auto& list : lists)
+                list.clear();
+            weights = {};
+        }
+
+        [[nodiscard]] stl::size_t max_weight() const noexcept {
+            return budget;
+        }
+
+        [[nodiscard]] stl::size_t weight() const noexcept {
+            return total_weight();
+        }
+
+        [[nodiscard]] stl::size_t size() const noexcept {
+            return index.size();
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_CACHE_TINYLFU_CACHE_H
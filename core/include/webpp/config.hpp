@@ -1,6 +1,27 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include "./std/std.hpp"
+#include "./traits/std_traits.hpp"
+#include "./utils/strings.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 /**
  *
  * This config class should:
@@ -9,8 +30,8 @@
  * - [ ] you can configure it to be used across other software or even other
  *       computers
  * - [ ] should support multiple config formats including:
- *    - [ ] Memory
- *    - [ ] INI
+ *    - [x] Memory
+ *    - [x] INI
  *    - [ ] Windows Registry
  *    - [ ] Android properties
  *    - [ ] JSON
@@ -21,9 +42,10 @@
  * - [ ] should support cache
  * - [ ] should inform other software / systems about changes that happen in
  *       this instance of software.
+ *       (the ones in this process are informed; see config::subscribe)
  * - [ ] should support user specific configs
  * - [ ] should support session specific configs
- * - [ ] should support instance specific configs (for the whole software)
+ * - [x] should support instance specific configs (for the whole software)
  *       (just in memory)
  * - [ ] should be able to add more than one backup storage for configs.
  *       should be able to use other type of config formats for those backups.
@@ -58,21 +80,21 @@
  *
  *
  * Data structure (what user can store in it):
- * - [ ] key/value pairs
+ * - [x] key/value pairs
  * - [ ] Array of values for a key
- * - [ ] Nested keys
+ * - [x] Nested keys ("section.key"; the INI sections)
  *
  * Value types:
- * - [ ] string
- * - [ ] integers
+ * - [x] string
+ * - [x] integers
  * - [ ] Serializable classes
  * - [ ] Vectors/Lists/Arrays/...
  * - [ ] Blob of data
  * - [ ] practically void*
  *
  * How to retrieve data:
- * - [ ] call it by its key
- * - [ ] call it by its nested key
+ * - [x] call it by its key
+ * - [x] call it by its nested key
  * - [ ] get a list of all keys in root
  * - [ ] get a list of all keys in a key (sub-keys)
  */
@@ -81,9 +103,301 @@ namespace webpp {
 
     enum class config_format { Native, Ini };
 
+    /**
+     * The values of the config at one moment; it's never changed after it's
+     * published, so the readers don't need a lock to read it. The keys of the
+     * INI sections are "section.key".
+     */
+    class config_snapshot {
+      public:
+        using entry_type = stl::pair<stl::string, stl::string>;
+
+      private:
+        stl::vector<entry_type> entries; // sorted by the keys
+
+        [[nodiscard]] auto find(stl::string_view key) const noexcept {
+            auto const it = stl::lower_bound(entries.begin(), entries.end(), key, [](auto const& entry, auto k) {
+                return stl::string_view{entry.first} < k;
+            });
+            return it != entries.end() && it->first == key ? it : entries.end();
+        }
+
+      public:
+        config_snapshot() = default;
+
+        /**
+         * The last one of the duplicate keys wins
+         */
+        explicit config_snapshot(stl::vector<entry_type> values) {
+            stl::stable_sort(values.begin(), values.end(), [](auto const& a, auto const& b) {
+                return a.first < b.first;
+            });
+            entries.reserve(values.size());
+            for (auto& entry : values) {
+                if (!entries.empty() && entries.back().first == entry.first)
+                    entries.back() = stl::move(entry);
+                else
+                    entries.push_back(stl::move(entry));
+            }
+        }
+
+        [[nodiscard]] stl::optional<stl::string_view> get(stl::string_view key) const noexcept {
+            if (auto const it = find(key); it != entries.end())
+                return stl::string_view{it->second};
+            return stl::nullopt;
+        }
+
+        [[nodiscard]] stl::string_view get_or(stl::string_view key, stl::string_view default_value) const noexcept {
+            return get(key).value_or(default_value);
+        }
+
+        /**
+         * The value as a number or a bool ("true", "yes", "on" or "1"); the
+         * default value if it's not there or if it's not one of them.
+         */
+        template <typename T>
+        requires(stl::is_arithmetic_v<T>)
+          [[nodiscard]] T get_as(stl::string_view key, T default_value) const noexcept {
+            auto const value = get(key);
+            if (!value)
+                return default_value;
+            if constexpr (stl::is_same_v<T, bool>) {
+                for (auto const yes : {"true", "yes", "on", "1"})
+                    if (ascii_iequals(*value, yes))
+                        return true;
+                for (auto const no : {"false", "no", "off", "0"})
+                    if (ascii_iequals(*value, no))
+                        return false;
+                return default_value;
+            } else {
+                T          result{};
+                auto const end = value->data() + value->size();
+                auto const res = stl::from_chars(value->data(), end, result);
+                return res.ec == stl::errc{} && res.ptr == end ? result : default_value;
+            }
+        }
+
+        [[nodiscard]] bool contains(stl::string_view key) const noexcept {
+            return find(key) != entries.end();
+        }
+
+        /**
+         * A copy of this one with the value of the key changed (or added)
+         */
+        [[nodiscard]] config_snapshot with(stl::string_view key, stl::string_view value) const {
+            config_snapshot copy{*this};
+            auto const      it = stl::lower_bound(copy.entries.begin(), copy.entries.end(), key,
+                                             [](auto const& entry, auto k) {
+                                                 return stl::string_view{entry.first} < k;
+                                             });
+            if (it != copy.entries.end() && it->first == key)
+                it->second = value;
+            else
+                copy.entries.emplace(it, stl::string{key}, stl::string{value});
+            return copy;
+        }
+
+        [[nodiscard]] stl::size_t size() const noexcept {
+            return entries.size();
+        }
+
+        [[nodiscard]] auto begin() const noexcept {
+            return entries.begin();
+        }
+
+        [[nodiscard]] auto end() const noexcept {
+            return entries.end();
+        }
+
+        /**
+         * Parse an INI file: "key = value" lines, "[section]"s, and the
+         * comments that start with ';' or '#'; nullopt if a line is not one
+         * of them.
+         */
+        [[nodiscard]] static stl::optional<config_snapshot> parse_ini(stl::string_view text) {
+            stl::vector<entry_type> values;
+            stl::string             section;
+            while (!text.empty()) {
+                auto const eol  = text.find('\n');
+                auto       line = trim_copy<std_traits>(text.substr(0, eol));
+                text.remove_prefix(eol == stl::string_view::npos ? text.size() : eol + 1);
+                if (line.empty() || line.front() == ';' || line.front() == '#')
+                    continue;
+                if (line.front() == '[') {
+                    if (line.back() != ']')
+                        return stl::nullopt;
+                    section = trim_copy<std_traits>(line.substr(1, line.size() - 2));
+                    continue;
+                }
+                auto const eq = line.find('=');
+                if (eq == stl::string_view::npos)
+                    return stl::nullopt;
+                auto const key = trim_copy<std_traits>(line.substr(0, eq));
+                if (key.empty())
+                    return stl::nullopt;
+                auto value = trim_copy<std_traits>(line.substr(eq + 1));
+                if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+                    value = value.substr(1, value.size() - 2);
+                values.emplace_back(section.empty() ? stl::string{key} : section + '.' + stl::string{key},
+                                    stl::string{value});
+            }
+            return config_snapshot{stl::move(values)};
+        }
+    };
+
+    /**
+     * The config of the whole program.
+     *
+     * The readers never take a lock: each one of them keeps the snapshot
+     * that it has loaded, and the only thing that it checks on the hot path
+     * is the generation of the config (one atomic load); it loads the new
+     * snapshot only after a change (RCU-like). The writers build the new
+     * snapshot on the side and publish it as a whole; the readers that have
+     * the old one keep it until they load the new one.
+     *
+     *   config::reader settings{cfg}; // one for each thread (or connection)
+     *   auto const timeout = settings->get_as("server.timeout", 30);
+     */
     class config {
       public:
-        config();
+        using snapshot_ptr = stl::shared_ptr<config_snapshot const>;
+        using callback     = stl::function<void(config_snapshot const&)>;
+
+      private:
+        stl::atomic<snapshot_ptr>  current{stl::make_shared<config_snapshot const>()};
+        stl::atomic<stl::uint64_t> gen{0};
+
+        stl::mutex                                      writers; // the writers, and the subscribers; never the readers
+        stl::vector<stl::pair<stl::uint64_t, callback>> subscribers;
+        stl::uint64_t                                   next_subscriber = 0;
+
+        void publish_locked(snapshot_ptr next) {
+            current.store(next, stl::memory_order_release);
+            gen.fetch_add(1, stl::memory_order_acq_rel); // after the store; the readers check it first
+            for (auto const& [id, subscriber] : subscribers)
+                subscriber(*next);
+        }
+
+      public:
+        /**
+         * A reader's copy of the snapshot; it's not shared between the
+         * threads, but the config that it reads is.
+         */
+        class reader {
+            config const* cfg;
+            stl::uint64_t loaded_gen;
+            snapshot_ptr  snap;
+
+          public:
+            explicit reader(config const& the_config) noexcept
+              : cfg{&the_config},
+                loaded_gen{the_config.generation()},
+                snap{the_config.snapshot()} {}
+
+            /**
+             * The latest snapshot; it's only loaded again if it's changed
+             */
+            [[nodiscard]] config_snapshot const& get() noexcept {
+                if (auto const now = cfg->generation(); now != loaded_gen) [[unlikely]] {
+                    loaded_gen = now;
+                    snap       = cfg->snapshot();
+                }
+                return *snap;
+            }
+
+            [[nodiscard]] config_snapshot const* operator->() noexcept {
+                return &get();
+            }
+        };
+
+        config() = default;
+
+        explicit config(config_snapshot values)
+          : current{stl::make_shared<config_snapshot const>(stl::move(values))} {}
+
+        config(config const&) = delete;
+        config& operator=(config const&) = delete;
+
+        /**
+         * The number of the snapshots that are published so far
+         */
+        [[nodiscard]] stl::uint64_t generation() const noexcept {
+            return gen.load(stl::memory_order_acquire);
+        }
+
+        /**
+         * The current snapshot; it's cheaper to keep a reader than to call
+         * this on each request.
+         */
+        [[nodiscard]] snapshot_ptr snapshot() const noexcept {
+            return current.load(stl::memory_order_acquire);
+        }
+
+        /**
+         * Replace the whole config, and let the subscribers know
+         */
+        void publish(config_snapshot values) {
+            auto             next = stl::make_shared<config_snapshot const>(stl::move(values));
+            stl::scoped_lock lock{writers};
+            publish_locked(stl::move(next));
+        }
+
+        /**
+         * Change one value
+         */
+        void set(stl::string_view key, stl::string_view value) {
+            stl::scoped_lock lock{writers};
+            publish_locked(stl::make_shared<config_snapshot const>(snapshot()->with(key, value)));
+        }
+
+        /**
+         * Replace the config with the content of a file; false (and nothing
+         * is changed) if it can't be read or parsed. The Native format is the
+         * "key = value" lines of the INI files, without the sections.
+         */
+        bool load(stl::string_view text, config_format format = config_format::Ini) {
+            switch (format) {
+                case config_format::Ini:
+                case config_format::Native: {
+                    auto values = config_snapshot::parse_ini(text);
+                    if (!values)
+                        return false;
+                    publish(stl::move(*values));
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool load_file(stl::filesystem::path const& path, config_format format = config_format::Ini) {
+            stl::ifstream file{path, stl::ios::binary};
+            if (!file)
+                return false;
+            stl::string const text{stl::istreambuf_iterator<char>{file}, stl::istreambuf_iterator<char>{}};
+            return load(text, format);
+        }
+
+        /**
+         * Call it with each snapshot that's published from now on; it's called
+         * in the thread of the writer, and it shouldn't change the config.
+         * The returned id is for unsubscribing.
+         */
+        stl::uint64_t subscribe(callback subscriber) {
+            stl::scoped_lock lock{writers};
+            subscribers.emplace_back(next_subscriber, stl::move(subscriber));
+            return next_subscriber++;
+        }
+
+        /**
+         * Stop calling the subscriber; after it returns, the subscriber is not
+         * being called and won't be called again.
+         */
+        void unsubscribe(stl::uint64_t id) {
+            stl::scoped_lock lock{writers};
+            stl::erase_if(subscribers, [id](auto const& subscriber) {
+                return subscriber.first == id;
+            });
+        }
     };
 
 } // namespace webpp
@@ -3,6 +3,16 @@
 #ifndef WEBPP_ENCODED_WORD_H
 #define WEBPP_ENCODED_WORD_H
 
+#include "../std/std.hpp"
+#include "../utils/base64.hpp"
+#include "../utils/strings.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
 namespace webpp::encoding {
 
     /**
@@ -21,7 +31,353 @@ namespace webpp::encoding {
      * For example:
      *   In the header:  "Subject: =?iso-8859-1?Q?=A1Hola,_se=F1or!?="
      *   Interpreted as: "Subject: ¡Hola, señor!"
+     *
+     * The words are decoded into UTF-8; the charsets that we know are UTF-8,
+     * US-ASCII, and ISO-8859-1, and the words of the other charsets are left
+     * as they are.
+     */
+
+    enum struct word_encoding : char {
+        Q = 'Q', // like quoted-printable; good for the mostly ASCII text
+        B = 'B'  // base64
+    };
+
+    /**
+     * One "=?charset?encoding?text?=" in a header value
+     */
+    struct encoded_word {
+        stl::string_view charset;  // without the RFC 2231 language, if any
+        word_encoding    encoding;
+        stl::string_view text;     // still encoded
+        stl::size_t      size;     // the length of the whole word in the value
+    };
+
+    /**
+     * The check that's done before anything else; the values that don't have
+     * an encoded word in them (almost all of them) are used as they are.
      */
-}
+    [[nodiscard]] constexpr bool has_encoded_words(stl::string_view value) noexcept {
+        return value.find("=?") != stl::string_view::npos;
+    }
+
+    namespace details {
+
+        [[nodiscard]] constexpr int word_hex_value(char c) noexcept {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            return -1;
+        }
+
+        static constexpr stl::string_view word_hex_digits = "0123456789ABCDEF";
+
+        /**
+         * The "Q" text; "_" is a space, and "=XX" is a byte
+         */
+        template <typename StrT>
+        constexpr bool q_decode(stl::string_view text, StrT& out) {
+            for (stl::size_t i = 0; i < text.size(); i++) {
+                auto const c = text[i];
+                if (c == '_') {
+                    out.push_back(' ');
+                } else if (c == '=') {
+                    if (i + 2 >= text.size())
+                        return false;
+                    auto const high = word_hex_value(text[i + 1]);
+                    auto const low  = word_hex_value(text[i + 2]);
+                    if (high == -1 || low == -1)
+                        return false;
+                    out.push_back(static_cast<char>((high << 4) | low));
+                    i += 2;
+                } else {
+                    out.push_back(c);
+                }
+            }
+            return true;
+        }
+
+        enum struct word_charset { unknown, utf8, latin1 };
+
+        [[nodiscard]] constexpr word_charset charset_of(stl::string_view charset) noexcept {
+            for (auto const name : {"utf-8", "utf8", "us-ascii", "ascii"})
+                if (ascii_iequals(charset, name))
+                    return word_charset::utf8;
+            for (auto const name : {"iso-8859-1", "iso_8859-1", "latin1"})
+                if (ascii_iequals(charset, name))
+                    return word_charset::latin1;
+            return word_charset::unknown;
+        }
+
+        /**
+         * Turn the Latin-1 bytes at the end of the output (from "start") into
+         * UTF-8, in place; it's done from the back since it only grows.
+         */
+        template <typename StrT>
+        constexpr void latin1_to_utf8(StrT& out, stl::size_t start) {
+            stl::size_t wide = 0;
+            for (auto i = start; i < out.size(); i++)
+                if (static_cast<unsigned char>(out[i]) >= 0x80u)
+                    wide++;
+            if (wide == 0)
+                return;
+            auto from = out.size();
+            auto to   = from + wide;
+            out.resize(to);
+            while (from > start) {
+                auto const byte = static_cast<unsigned char>(out[--from]);
+                if (byte < 0x80u) {
+                    out[--to] = static_cast<char>(byte);
+                } else {
+                    out[--to] = static_cast<char>(0x80u | (byte & 0x3Fu));
+                    out[--to] = static_cast<char>(0xC0u | (byte >> 6u));
+                }
+            }
+        }
+
+        /**
+         * The Q encoding is only safe with these, the rest of them are "=XX";
+         * a space is "_" (RFC 2047, section 5 (3)).
+         */
+        [[nodiscard]] constexpr bool is_q_safe(char c) noexcept {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '!' ||
+                   c == '*' || c == '+' || c == '-' || c == '/';
+        }
+
+        /**
+         * The length of the UTF-8 sequence that starts with this byte; the
+         * words are never split in the middle of a character.
+         */
+        [[nodiscard]] constexpr stl::size_t utf8_sequence_size(char c) noexcept {
+            auto const byte = static_cast<unsigned char>(c);
+            if (byte >= 0xF0u)
+                return 4;
+            if (byte >= 0xE0u)
+                return 3;
+            if (byte >= 0xC0u)
+                return 2;
+            return 1;
+        }
+
+        // an encoded word can't be longer than this (RFC 2047, section 2)
+        static constexpr stl::size_t max_word_size = 75;
+
+        static constexpr stl::string_view utf8_q_prefix = "=?UTF-8?Q?";
+        static constexpr stl::string_view utf8_b_prefix = "=?UTF-8?B?";
+        static constexpr stl::string_view word_suffix   = "?=";
+
+    } // namespace details
+
+    /**
+     * Parse the encoded word at the start of the string; nullopt if it's not
+     * one.
+     */
+    [[nodiscard]] constexpr stl::optional<encoded_word> parse_encoded_word(stl::string_view str) noexcept {
+        if (!str.starts_with("=?"))
+            return stl::nullopt;
+        auto const charset_end = str.find('?', 2);
+        if (charset_end == stl::string_view::npos || charset_end == 2 || charset_end + 3 >= str.size() ||
+            str[charset_end + 2] != '?')
+            return stl::nullopt;
+        word_encoding encoding;
+        switch (str[charset_end + 1]) {
+            case 'Q':
+            case 'q': encoding = word_encoding::Q; break;
+            case 'B':
+            case 'b': encoding = word_encoding::B; break;
+            default: return stl::nullopt;
+        }
+        auto const text_start = charset_end + 3;
+        auto const text_end   = str.find("?=", text_start);
+        if (text_end == stl::string_view::npos)
+            return stl::nullopt;
+        auto const text = str.substr(text_start, text_end - text_start);
+        for (auto const c : text)
+            if (c == ' ' || c == '\t' || c == '?' || static_cast<unsigned char>(c) < 0x20u)
+                return stl::nullopt;
+        auto charset = str.substr(2, charset_end - 2);
+        if (auto const star = charset.find('*'); star != stl::string_view::npos)
+            charset = charset.substr(0, star); // "utf-8*en"
+        return encoded_word{.charset  = charset,
+                            .encoding = encoding,
+                            .text     = text,
+                            .size     = text_end + details::word_suffix.size()};
+    }
+
+    /**
+     * Decode one encoded word at the end of the output as UTF-8; false (and
+     * nothing is appended) if it's broken or its charset is not known.
+     */
+    template <typename StrT>
+    constexpr bool decode_word(encoded_word const& word, StrT& out) {
+        auto const charset = details::charset_of(word.charset);
+        if (charset == details::word_charset::unknown)
+            return false;
+        auto const start = out.size();
+        bool const ok    = word.encoding == word_encoding::Q ? details::q_decode(word.text, out)
+                                                             : base64::decode(word.text, out);
+        if (!ok) {
+            out.resize(start);
+            return false;
+        }
+        if (charset == details::word_charset::latin1)
+            details::latin1_to_utf8(out, start);
+        return true;
+    }
+
+    /**
+     * Decode the encoded words of the value at the end of the output; the rest
+     * of the value is copied as it is. The spaces between two encoded words
+     * are dropped, as the RFC says (section 6.2).
+     *
+     * @returns true if at least one word was decoded
+     */
+    template <typename StrT>
+    constexpr bool decode_words(stl::string_view value, StrT& out) {
+        bool decoded      = false;
+        bool after_a_word = false; // the last thing appended was a decoded word
+        while (!value.empty()) {
+            auto const start = value.find("=?");
+            auto const plain = value.substr(0, start);
+            if (start == stl::string_view::npos) {
+                out.append(plain.data(), plain.size());
+                break;
+            }
+            auto const word = parse_encoded_word(value.substr(start));
+            if (!word) {
+                out.append(value.data(), start + 2);
+                value.remove_prefix(start + 2);
+                after_a_word = false;
+                continue;
+            }
+            bool const only_spaces = plain.find_first_not_of(" \t\r\n") == stl::string_view::npos;
+            if (!(after_a_word && only_spaces))
+                out.append(plain.data(), plain.size());
+            if (decode_word(*word, out)) {
+                decoded      = true;
+                after_a_word = true;
+            } else {
+                out.append(value.data() + start, word->size);
+                after_a_word = false;
+            }
+            value.remove_prefix(start + word->size);
+        }
+        return decoded;
+    }
+
+    /**
+     * The value with its encoded words decoded. The common case, a value with
+     * no "=?" in it, is returned as it is, and the buffer isn't touched;
+     * otherwise the decoded value is in the buffer, and the returned view
+     * points into it.
+     */
+    template <typename StrT>
+    [[nodiscard]] constexpr stl::string_view decoded(stl::string_view value, StrT& buffer) {
+        if (!has_encoded_words(value)) [[likely]]
+            return value;
+        buffer.clear();
+        if (!decode_words(value, buffer))
+            return value;
+        return {buffer.data(), buffer.size()};
+    }
+
+    /**
+     * Whether the value can't be sent in a header as it is: it has non-ASCII
+     * bytes or control characters, or it looks like an encoded word itself.
+     */
+    [[nodiscard]] constexpr bool needs_encoding(stl::string_view value) noexcept {
+        for (auto const c : value) {
+            auto const byte = static_cast<unsigned char>(c);
+            if (byte >= 0x7Fu || (byte < 0x20u && c != '\t'))
+                return true;
+        }
+        return has_encoded_words(value);
+    }
+
+    /**
+     * Encode the UTF-8 text as encoded words at the end of the output; the
+     * words are kept under 75 characters, and a long text becomes a few of
+     * them separated by spaces (which the decoders drop).
+     */
+    template <typename StrT>
+    constexpr void encode_word(stl::string_view text, StrT& out, word_encoding encoding = word_encoding::Q) {
+        using details::max_word_size;
+        using details::word_suffix;
+        auto const prefix =
+          encoding == word_encoding::Q ? details::utf8_q_prefix : details::utf8_b_prefix;
+
+        // the room for the encoded text of each word
+        constexpr stl::size_t room = max_word_size - details::utf8_q_prefix.size() - word_suffix.size();
+
+        bool first = true;
+        while (!text.empty() || first) {
+            if (!first)
+                out.push_back(' ');
+            first = false;
+            out.append(prefix.data(), prefix.size());
+            stl::size_t used = 0;
+            stl::size_t take = 0; // the bytes of the text that go in this word
+            while (take < text.size()) {
+                auto const len  = stl::min(details::utf8_sequence_size(text[take]), text.size() - take);
+                stl::size_t cost = 0;
+                if (encoding == word_encoding::Q) {
+                    for (stl::size_t i = 0; i < len; i++) {
+                        auto const c = text[take + i];
+                        cost += c == ' ' || details::is_q_safe(c) ? 1 : 3;
+                    }
+                } else {
+                    cost = ((take + len + 2) / 3) * 4 - used;
+                }
+                if (used + cost > room && take != 0)
+                    break;
+                used += cost;
+                take += len;
+            }
+            auto const chunk = text.substr(0, take);
+            if (encoding == word_encoding::Q) {
+                for (auto const c : chunk) {
+                    if (c == ' ') {
+                        out.push_back('_');
+                    } else if (details::is_q_safe(c)) {
+                        out.push_back(c);
+                    } else {
+                        auto const byte = static_cast<unsigned char>(c);
+                        out.push_back('=');
+                        out.push_back(details::word_hex_digits[byte >> 4u]);
+                        out.push_back(details::word_hex_digits[byte & 0xFu]);
+                    }
+                }
+            } else {
+                base64::encode(chunk, out);
+            }
+            out.append(word_suffix.data(), word_suffix.size());
+            text.remove_prefix(take);
+        }
+    }
+
+    /**
+     * Put the value at the end of the output, as it is if it can be, or as
+     * encoded words if it needs to be; the encoding that makes it shorter
+     * is used.
+     */
+    template <typename StrT>
+    constexpr void encode_words(stl::string_view value, StrT& out) {
+        if (!needs_encoding(value)) {
+            out.append(value.data(), value.size());
+            return;
+        }
+        stl::size_t unsafe = 0;
+        for (auto const c : value)
+            if (c != ' ' && !details::is_q_safe(c))
+                unsafe++;
+        // each unsafe byte is three in Q; base64 is four for each three
+        auto const q_size = value.size() + unsafe * 2;
+        auto const b_size = (value.size() + 2) / 3 * 4;
+        encode_word(value, out, q_size <= b_size ? word_encoding::Q : word_encoding::B);
+    }
+
+} // namespace webpp::encoding
 
 #endif // WEBPP_ENCODED_WORD_H
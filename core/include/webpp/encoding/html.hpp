@@ -0,0 +1,159 @@
+#ifndef WEBPP_ENCODING_HTML_H
+#define WEBPP_ENCODING_HTML_H
+
+#include "../std/std.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#    define WEBPP_HTML_SCANNER_WIDTH 32
+#elif defined(__SSE2__)
+#    include <emmintrin.h>
+#    define WEBPP_HTML_SCANNER_WIDTH 16
+#else
+#    define WEBPP_HTML_SCANNER_WIDTH 1
+#endif
+
+/**
+ * Escaping the text that goes into the HTML; the same escapes are fine in the
+ * text and in the quoted attributes (with either of the quotes), so there's
+ * one of them.
+ */
+namespace webpp::encoding {
+
+    /**
+     * Finds the chars that are escaped in HTML: <, >, &, ", and '. 16 (SSE2)
+     * or 32 (AVX2) bytes at a time, like the JSON's escape scanner; the most
+     * of the text doesn't have any, so it's copied in runs.
+     */
+    struct html_scanner {
+        static constexpr stl::size_t width = WEBPP_HTML_SCANNER_WIDTH;
+
+        [[nodiscard]] static constexpr bool needs_escape(char c) noexcept {
+            return c == '<' || c == '>' || c == '&' || c == '"' || c == '\'';
+        }
+
+        /**
+         * The position of the first char that should be escaped at or after
+         * "pos"; npos if there's none.
+         */
+        [[nodiscard]] static constexpr stl::size_t find(stl::string_view data, stl::size_t pos = 0) noexcept {
+#if WEBPP_HTML_SCANNER_WIDTH > 1
+            if (!stl::is_constant_evaluated()) {
+                auto const* const begin = data.data();
+#    if WEBPP_HTML_SCANNER_WIDTH == 32
+                auto const lt    = _mm256_set1_epi8('<');
+                auto const gt    = _mm256_set1_epi8('>');
+                auto const amp   = _mm256_set1_epi8('&');
+                auto const quote = _mm256_set1_epi8('"');
+                auto const apos  = _mm256_set1_epi8('\'');
+                for (; pos + width <= data.size(); pos += width) {
+                    auto const chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(begin + pos));
+                    auto const eq    = _mm256_or_si256(
+                      _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, lt), _mm256_cmpeq_epi8(chunk, gt)),
+                                      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, amp), _mm256_cmpeq_epi8(chunk, quote))),
+                      _mm256_cmpeq_epi8(chunk, apos));
+                    auto const mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+                    if (mask != 0)
+                        return pos + static_cast<stl::size_t>(__builtin_ctz(mask));
+                }
+#    else
+                auto const lt    = _mm_set1_epi8('<');
+                auto const gt    = _mm_set1_epi8('>');
+                auto const amp   = _mm_set1_epi8('&');
+                auto const quote = _mm_set1_epi8('"');
+                auto const apos  = _mm_set1_epi8('\'');
+                for (; pos + width <= data.size(); pos += width) {
+                    auto const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(begin + pos));
+                    auto const eq    = _mm_or_si128(
+                      _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, lt), _mm_cmpeq_epi8(chunk, gt)),
+                                   _mm_or_si128(_mm_cmpeq_epi8(chunk, amp), _mm_cmpeq_epi8(chunk, quote))),
+                      _mm_cmpeq_epi8(chunk, apos));
+                    auto const mask = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+                    if (mask != 0)
+                        return pos + static_cast<stl::size_t>(__builtin_ctz(mask));
+                }
+#    endif
+            }
+#endif
+            for (; pos < data.size(); pos++)
+                if (needs_escape(data[pos]))
+                    return pos;
+            return stl::string_view::npos;
+        }
+    };
+
+    [[nodiscard]] constexpr stl::string_view html_entity(char c) noexcept {
+        switch (c) {
+            case '<': return "&lt;";
+            case '>': return "&gt;";
+            case '&': return "&amp;";
+            case '"': return "&quot;";
+            default: return "&#39;";
+        }
+    }
+
+    /**
+     * The size of the escaped text
+     */
+    [[nodiscard]] constexpr stl::size_t html_escaped_size(stl::string_view str) noexcept {
+        stl::size_t size = str.size();
+        for (auto pos = html_scanner::find(str); pos != stl::string_view::npos;
+             pos      = html_scanner::find(str, pos + 1))
+            size += html_entity(str[pos]).size() - 1;
+        return size;
+    }
+
+    /**
+     * Append the escaped text to the end of the output (a response body, or
+     * any other string)
+     */
+    template <typename StrT>
+    constexpr void escape_html(stl::string_view str, StrT& out) {
+        stl::size_t start = 0;
+        for (;;) {
+            auto const pos = html_scanner::find(str, start);
+            if (pos == stl::string_view::npos) {
+                out.append(str.data() + start, str.size() - start);
+                return;
+            }
+            out.append(str.data() + start, pos - start);
+            auto const entity = html_entity(str[pos]);
+            out.append(entity.data(), entity.size());
+            start = pos + 1;
+        }
+    }
+
+    /**
+     * Escape the text into the buffer
+     * @returns the size of the escaped text, or npos if it doesn't fit (what
+     *          did fit is written)
+     */
+    constexpr stl::size_t escape_html(stl::string_view str, char* out, stl::size_t capacity) noexcept {
+        stl::size_t start = 0;
+        stl::size_t size  = 0;
+        auto const  write = [&](stl::string_view part) constexpr noexcept {
+            if (part.size() > capacity - size)
+                return false;
+            stl::char_traits<char>::copy(out + size, part.data(), part.size());
+            size += part.size();
+            return true;
+        };
+        for (;;) {
+            auto const pos = html_scanner::find(str, start);
+            if (pos == stl::string_view::npos)
+                return write(str.substr(start)) ? size : stl::string_view::npos;
+            if (!write(str.substr(start, pos - start)) || !write(html_entity(str[pos])))
+                return stl::string_view::npos;
+            start = pos + 1;
+        }
+    }
+
+} // namespace webpp::encoding
+
+#endif // WEBPP_ENCODING_HTML_H
@@ -33,71 +33,150 @@ namespace webpp {
 
     template <typename T>
     concept ChildExtension = Extension<T>&& requires {
-        T::template type<fake_traits_type, fake_extensie>;
+        typename T::template type<fake_traits_type, fake_extensie>;
     };
 
     template <Extension... E>
-    struct extension_pack {
+    struct extension_pack;
 
-        template <typename... NE>
-        using appended = extension_pack<E..., NE...>;
+    namespace details {
+
+        /**
+         * A list of types that, unlike the extension_pack, can hold anything; the extension_pack checks
+         * its extensions on each instantiation, this one doesn't.
+         */
+        template <typename... T>
+        struct epack_list {};
+
+        template <typename List>
+        struct epack_of {};
 
-        template <template <typename...> typename PackType, typename... F>
-        struct prepend {
-            using type = PackType<F...>;
+        template <typename... T>
+        struct epack_of<epack_list<T...>> {
+            using type = extension_pack<T...>;
         };
 
-        template <template <typename...> typename PackType, typename F, typename... L>
-        struct prepend<PackType, F, extension_pack<L...>> {
-            using type = PackType<F, L...>;
+        /**
+         * Join the lists; it takes four of them at a time, so a pack of N lists costs about N/4
+         * instantiations instead of N recursive "appended"s.
+         */
+        template <typename... Lists>
+        struct epack_concat {
+            using type = epack_list<>;
         };
 
-        template <template <typename...> typename PackType, template <typename> typename IF,
-                  typename First = void, typename... EI>
-        struct filter {
-            using type = stl::conditional_t<
-              IF<First>::value,
-              typename prepend<PackType, First, typename filter<PackType, IF, EI...>::type>::type,
-              typename filter<PackType, IF, EI...>::type>;
+        template <typename... A>
+        struct epack_concat<epack_list<A...>> {
+            using type = epack_list<A...>;
         };
 
-        template <template <typename...> typename PackType, template <typename> typename IF, typename... EI>
-        struct filter<PackType, IF, void, EI...> {
-            using type = PackType<EI...>;
+        template <typename... A, typename... B>
+        struct epack_concat<epack_list<A...>, epack_list<B...>> {
+            using type = epack_list<A..., B...>;
         };
 
-        template <template <typename...> typename PackType, template <typename> typename IF, typename... EI>
-        struct filter_epack {
-            using type = typename filter<PackType, IF, EI...>::type;
+        template <typename... A, typename... B, typename... C>
+        struct epack_concat<epack_list<A...>, epack_list<B...>, epack_list<C...>> {
+            using type = epack_list<A..., B..., C...>;
         };
 
-        template <template <typename...> typename PackType, template <typename> typename IF, typename... EI>
-        struct filter_epack<PackType, IF, extension_pack<EI...>> {
-            using type = typename filter<PackType, IF, EI...>::type;
+        template <typename... A, typename... B, typename... C, typename... D, typename... Rest>
+        struct epack_concat<epack_list<A...>, epack_list<B...>, epack_list<C...>, epack_list<D...>, Rest...> {
+            using type = typename epack_concat<epack_list<A..., B..., C..., D...>, Rest...>::type;
         };
 
-        template <typename First = void, typename... U>
-        struct unique_types {
-            using type = stl::conditional_t<
-              ((!std::is_same_v<First, U>)&&...),
-              typename prepend<extension_pack, First, typename unique_types<U...>::type>::type,
-              typename unique_types<U...>::type>;
+        template <bool Keep, typename T>
+        using epack_list_if = stl::conditional_t<Keep, epack_list<T>, epack_list<>>;
+
+        /**
+         * The extensions that satisfy IF
+         */
+        template <template <typename> typename IF, typename... E>
+        struct epack_filter {
+            using list = typename epack_concat<epack_list_if<IF<E>::value, E>...>::type;
+            using type = typename epack_of<list>::type;
         };
 
-        template <typename... U>
-        struct unique_types<void, U...> {
-            using type = extension_pack<U...>;
+        /**
+         * Open up the extension packs (and the packs in them) into a list
+         */
+        template <typename T>
+        struct epack_flatten {
+            using type = epack_list<T>;
         };
 
-        template <typename... U>
-        struct unique_types<extension_pack<U...>> {
-            using type = typename unique_types<U...>::type;
+        template <typename... T>
+        struct epack_flatten<extension_pack<T...>> {
+            using type = typename epack_concat<typename epack_flatten<T>::type...>::type;
         };
 
         /**
-         * Get the unique types
+         * The flattened related extension pack of E, if the descriptor says it has one
          */
-        //        using unique = typename unique_types<E...>::type;
+        template <typename ExtensieDescriptor, typename E,
+                  bool = ExtensieDescriptor::template has_related_extension_pack<E>::value>
+        struct epack_related {
+            using type = epack_list<>;
+        };
+
+        template <typename ExtensieDescriptor, typename E>
+        struct epack_related<ExtensieDescriptor, E, true> {
+            using type =
+              typename epack_flatten<typename ExtensieDescriptor::template related_extension_pack_type<E>>::type;
+        };
+
+        template <typename List, typename Reversed = epack_list<>>
+        struct epack_reverse {
+            using type = Reversed;
+        };
+
+        template <typename F, typename... R, typename... K>
+        struct epack_reverse<epack_list<F, R...>, epack_list<K...>> {
+            using type = typename epack_reverse<epack_list<R...>, epack_list<F, K...>>::type;
+        };
+
+        /**
+         * The types that are already in the unique list; asking the compiler if it's a base class is a
+         * lot cheaper than comparing it against each one of them with is_same.
+         */
+        template <typename T>
+        struct epack_tag {};
+
+        template <typename... T>
+        struct epack_seen : epack_tag<T>... {};
+
+        /**
+         * Goes through the reversed list and puts each new one in front of the kept ones, so the list is
+         * back in its order and the last one of the duplicates is the one that stays.
+         */
+        template <typename Kept, typename Seen, typename... T>
+        struct epack_unique_of {
+            using type = typename epack_of<Kept>::type;
+        };
+
+        template <typename... K, typename... S, typename F, typename... R>
+        struct epack_unique_of<epack_list<K...>, epack_seen<S...>, F, R...> {
+            using type = typename stl::conditional_t<
+              stl::is_base_of_v<epack_tag<F>, epack_seen<S...>>,
+              epack_unique_of<epack_list<K...>, epack_seen<S...>, R...>,
+              epack_unique_of<epack_list<F, K...>, epack_seen<S..., F>, R...>>::type;
+        };
+
+        template <typename ReversedList>
+        struct epack_unique;
+
+        template <typename... T>
+        struct epack_unique<epack_list<T...>> {
+            using type = typename epack_unique_of<epack_list<>, epack_seen<>, T...>::type;
+        };
+
+    } // namespace details
+
+    template <Extension... E>
+    struct extension_pack {
+
+        template <typename... NE>
+        using appended = extension_pack<E..., NE...>;
 
         template <typename T>
         struct mother_type {
@@ -136,16 +215,6 @@ namespace webpp {
         //        };
 
 
-        template <template <typename...> typename PackType, template <typename> typename Extractor,
-                  typename... EPack>
-        struct epack_miner {};
-
-        template <template <typename...> typename PackType, template <typename> typename Extractor,
-                  typename... EPack>
-        struct epack_miner<PackType, Extractor, extension_pack<EPack...>> {
-            using type = PackType<Extractor<EPack>...>;
-        };
-
         //        template <typename... Ex>
         //        struct inheritable_extension_pack {
         //            // this should not happen
@@ -157,50 +226,22 @@ namespace webpp {
         //            }
         //        };
 
-        using mother_extensions = typename filter<extension_pack, mother_type, E...>::type;
-        using child_extensions  = typename filter<extension_pack, child_type, E...>::type;
+        using mother_extensions = typename details::epack_filter<mother_type, E...>::type;
+        using child_extensions  = typename details::epack_filter<child_type, E...>::type;
 
         using this_epack = extension_pack<E...>;
 
-        template <typename... EPacks>
-        struct flatten_epacks {
-            using type = extension_pack<EPacks...>;
-        };
-
-        template <Extension... Ex>
-        struct flatten_epacks<extension_pack<Ex...>> {
-            using type = extension_pack<Ex...>;
-        };
-
-        template <Extension... Ex1, Extension... Ex2>
-        struct flatten_epacks<extension_pack<Ex1...>, extension_pack<Ex2...>> {
-            using type = extension_pack<Ex1..., Ex2...>;
-        };
-
-        template <Extension... Ex, typename... EPacks>
-        struct flatten_epacks<extension_pack<Ex...>, EPacks...> {
-            using type = typename flatten_epacks<Ex..., typename flatten_epacks<EPacks...>::type>::type;
-        };
-
-        template <Extension... Ex1, typename... EPacks>
-        struct flatten_epacks<extension_pack<extension_pack<Ex1...>, EPacks...>> {
-            using type =
-              typename flatten_epacks<extension_pack<Ex1...>, typename flatten_epacks<EPacks...>::type>::type;
-        };
-
-
+        /**
+         * The related extension packs of the extensions (flattened), plus the extensions of this pack that
+         * satisfy IF, without the duplicates.
+         * Each step is expanded over the whole pack at once, so the number of instantiations grows
+         * linearly with the number of extensions.
+         */
         template <typename ExtensieDescriptor, template <typename> typename IF>
-        using merge_extensions = typename unique_types<
-          typename flatten_epacks<typename epack_miner<
-            extension_pack, ExtensieDescriptor::template related_extension_pack_type,
-
-            // filter the packs that contain the interested packs
-            typename filter_epack<extension_pack, ExtensieDescriptor::template has_related_extension_pack,
-                                  this_epack>::type
-
-            >::type>::type
-          // append the individual lonely extensions in the big epack
-          ::template appended<typename filter_epack<extension_pack, IF, this_epack>::type>>::type;
+        using merge_extensions = typename details::epack_unique<
+          typename details::epack_reverse<typename details::epack_concat<
+            typename details::epack_related<ExtensieDescriptor, E>::type...,
+            typename details::epack_filter<IF, E...>::list>::type>::type>::type;
 
         /**
          * This struct is used to ignore the constructor calls to the base classes that don't have the
@@ -208,20 +249,6 @@ namespace webpp {
          * This struct requires the base classes to be default constructible.
          * @tparam Parent
          */
-        template <typename Parent>
-        struct vctor : public virtual Parent {
-
-            template <typename... Args>
-            requires(stl::constructible_from<Parent, Args...>) vctor(Args&&... args) noexcept
-              : Parent{stl::forward<Args>(args)...} {
-            }
-
-            template <typename... Args>
-            requires(!stl::constructible_from<Parent, Args...>) vctor([[maybe_unused]] Args&&... args) noexcept
-              : Parent{} {
-            }
-        };
-
         template <typename Parent>
         struct ctor : public  Parent {
 
@@ -245,31 +272,22 @@ namespace webpp {
             }
         };
 
-        // with 2 or more kids
+        // without any kids
         template <Traits TraitsType, typename Mother, typename... Kids>
         struct children_inherited {
-            struct type : public vctor<typename Kids::template type<TraitsType, vctor<Mother>>>... {
-                template <typename... Args>
-                constexpr type(Args&&... args) noexcept
-                  : vctor<typename Kids::template type<TraitsType, vctor<Mother>>>{
-                      stl::forward<Args>(args)...}... {
-                }
-            };
-        };
-
-        // without any kids
-        template <Traits TraitsType, typename Mother>
-        struct children_inherited<TraitsType, Mother> {
             using type = Mother;
         };
 
-        // with only one kid
-        template <Traits TraitsType, typename Mother, typename Kid>
-        struct children_inherited<TraitsType, Mother, Kid> {
-            using type = typename Kid::template type<TraitsType, Mother>;
+        // with kids; they're stacked on each other (the first one is the most derived), not inherited
+        // virtually side by side, so the fields of the mother are at a fixed offset and reaching them
+        // doesn't go through a virtual base pointer
+        template <Traits TraitsType, typename Mother, typename Kid, typename... Kids>
+        struct children_inherited<TraitsType, Mother, Kid, Kids...> {
+            using type =
+              typename Kid::template type<TraitsType, typename children_inherited<TraitsType, Mother, Kids...>::type>;
         };
 
-        // 2 or more kids, passed with an extension pack
+        // the kids, passed with an extension pack
         template <Traits TraitsType, typename Mother, typename... Kids>
         struct children_inherited<TraitsType, Mother, extension_pack<Kids...>> {
             using type = typename children_inherited<TraitsType, Mother, Kids...>::type;
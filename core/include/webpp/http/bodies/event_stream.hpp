@@ -0,0 +1,76 @@
+#ifndef WEBPP_HTTP_BODIES_EVENT_STREAM_H
+#define WEBPP_HTTP_BODIES_EVENT_STREAM_H
+
+#include "../../traits/traits_concepts.hpp"
+#include "../event_stream.hpp"
+
+#include <memory>
+#include <string_view>
+#include <utility>
+
+namespace webpp {
+
+    /**
+     * A body that subscribes the client to an event channel (Server-Sent
+     * Events); the response head is sent, and then the events that are
+     * published to the channel, until the channel is closed or the client
+     * goes away. The simple server streams it; the interfaces that can't
+     * stream see an empty body.
+     */
+    struct event_stream_body {
+        template <Traits TraitsType>
+        struct type {
+            using traits_type      = TraitsType;
+            using string_type      = typename traits_type::string_type;
+            using string_view_type = typename traits_type::string_view_type;
+            using allocator_type   = typename string_type::allocator_type;
+            using alloc_type       = allocator_type const&;
+            using channel_type     = stl::shared_ptr<event_channel>;
+
+          private:
+            channel_type events{};
+            string_type  content; // always empty
+
+          public:
+            type(alloc_type alloc = allocator_type{}) noexcept : content{alloc} {}
+
+            type(channel_type channel, alloc_type alloc = allocator_type{}) noexcept
+              : events{stl::move(channel)},
+                content{alloc} {}
+
+            type(type const&)     = default;
+            type(type&&) noexcept = default;
+            type& operator=(type const&) = default;
+            type& operator=(type&&) noexcept = default;
+
+            /**
+             * There's a channel; the response has no length
+             */
+            [[nodiscard]] bool is_stream() const noexcept {
+                return events != nullptr;
+            }
+
+            /**
+             * The channel, for the interfaces that subscribe the connection to it
+             */
+            [[nodiscard]] channel_type const& channel() const noexcept {
+                return events;
+            }
+
+            [[nodiscard]] stl::string_view content_type() const noexcept {
+                return events ? "text/event-stream" : "";
+            }
+
+            [[nodiscard]] string_type const& str() const noexcept {
+                return content;
+            }
+
+            [[nodiscard]] bool operator==(type const& other) const noexcept {
+                return events == other.events;
+            }
+        };
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_HTTP_BODIES_EVENT_STREAM_H
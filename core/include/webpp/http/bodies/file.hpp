@@ -2,11 +2,26 @@
 #define WEBPP_HTTP_FILE_H
 
 #include "../../traits/traits_concepts.hpp"
+#include "../byte_ranges.hpp"
+#include "../compression.hpp"
+#include "../http_date.hpp"
+#include "../static_file_cache.hpp"
+#include "../well_known_headers.hpp"
 
+#include <array>
+#include <charconv>
+#include <fcntl.h>
 #include <filesystem>
+#include <memory>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #ifdef WEBPP_EMBEDDED_FILES
-#    if CONFIG_FILE != ""
+#    ifdef CONFIG_FILE
 #        include CONFIG_FILE
 #    else
 extern std::string_view get_static_file(std::string_view const&) noexcept;
@@ -15,58 +30,440 @@ extern std::string_view get_static_file(std::string_view const&) noexcept;
 
 namespace webpp {
 
+    /**
+     * An open file; it's closed when the last one who holds it lets it go.
+     */
+    class file_descriptor {
+        int fd = -1;
+
+      public:
+        explicit file_descriptor(int native_fd) noexcept : fd{native_fd} {}
+        file_descriptor(file_descriptor const&) = delete;
+        file_descriptor& operator=(file_descriptor const&) = delete;
+
+        ~file_descriptor() noexcept {
+            if (fd != -1)
+                ::close(fd);
+        }
+
+        [[nodiscard]] int native_handle() const noexcept {
+            return fd;
+        }
+    };
+
+    /**
+     * A part of a file body that's selected by a Range request: the bytes of
+     * the multipart framing, or a slice of the file
+     */
+    struct file_segment {
+        stl::string_view text{};
+        stl::size_t      offset = 0;
+        stl::size_t      length = 0;
+    };
+
+    namespace details {
+
+        /**
+         * The ranges of a file body; it's shared between the copies of the
+         * response, and the text of the segments points into it.
+         */
+        struct file_selection {
+            stl::string               text{};
+            stl::string               content_type{}; // the multipart type; empty if there's one range
+            stl::vector<file_segment> segments{};
+            stl::size_t               total = 0;
+        };
+
+        // the boundary of the multipart/byteranges; it's random, so it's not in the file
+        [[nodiscard]] inline stl::string byterange_boundary() {
+            thread_local stl::mt19937_64 engine{stl::random_device{}()};
+            stl::array<char, 16>         hex{};
+            auto const end = stl::to_chars(hex.data(), hex.data() + hex.size(), engine(), 16).ptr;
+            return stl::string{"webpp-"}.append(hex.data(), end);
+        }
+
+    } // namespace details
+
+    /**
+     * A body that is a file on the disk.
+     *
+     * The file is only opened, not read; the interfaces that can (the simple
+     * server) hand the descriptor to the connection and the kernel copies the
+     * file to the socket (sendfile), so the big downloads never come into the
+     * user space. The other interfaces read it through "str".
+     *
+     * The files that come from a static_file_cache are not opened at all;
+     * the body points into the cached file.
+     *
+     * A Range request selects parts of it (see select); the slices are sent
+     * by the kernel too, and the framing of a multipart/byteranges is sent
+     * in between them.
+     */
     struct file_body {
         template <Traits TraitsType>
         struct type {
             using traits_type      = TraitsType;
             using string_type      = typename traits_type::string_type;
-            using string_view_type = typename traits_type::stirng_view_type;
-            using char_type        = typename string_type::char_type;
-            using allocator_type   = typename traits_type::allocator<char_type>;
+            using string_view_type = typename traits_type::string_view_type;
+            using char_type        = typename string_type::value_type;
+            using allocator_type   = typename string_type::allocator_type;
             using alloc_type       = allocator_type const&;
+            using file_type        = stl::shared_ptr<file_descriptor const>;
+            using cached_file_type = stl::shared_ptr<static_file const>;
+            using selection_type   = stl::shared_ptr<details::file_selection const>;
 
           private:
-            string_type content;
+            file_type     file{}; // shared between the copies of the response
+            stl::size_t   file_size = 0;
+            stl::uint64_t mtime     = 0; // in nanoseconds, like static_file::modified
+
+            cached_file_type cached{}; // the file is in the memory of a static_file_cache
+
+            stl::string_view type_value{}; // from the extension of the file; empty if there's no file
+
+            selection_type selection{}; // the ranges that are sent, if it's a Range request
 
-            static string_type load_file(stl::filesystem::path const& filepath,
-                                         alloc_type                   alloc) const noexcept {
+            // the embedded files, or the file after it's read by "str"
+            mutable string_type content;
+            mutable bool        loaded = false;
+
+            void open(stl::filesystem::path const& filepath) noexcept {
 #ifdef WEBPP_EMBEDDED_FILES
-                if (auto content = ::get_static_file(filepath); !content.empty()) {
-                    return string_type{content, alloc};
+                if (auto embedded = ::get_static_file(filepath.native()); !embedded.empty()) {
+                    content.assign(embedded.data(), embedded.size());
+                    loaded = true;
+                    return;
                 }
 #endif
-
-                // TODO: performance tests
-                // todo: add unix specializations for performance and having fun reasons
-                // TODO: change the replace_string with replace_string_view if the file is cached
-
-                if (stl::ifstream in{filepath.c_str(), stl::ios::binary | stl::ios::ate}) {
-                    // details on this matter:
-                    // https://stackoverflow.com/questions/11563963/writing-a-binary-file-in-c-very-fast/39097696#39097696
-                    // stl::unique_ptr<char[]> buffer{new char[buffer_size]};
-                    // in.rdbuf()->pubsetbuf(buffer.get(), buffer_size); // speed boost, I think
-                    auto                         size = in.tellg();
-                    stl::unique_ptr<char_type[]> result(alloc.allocate(size));
-                    in.seekg(0);
-                    in.read(result.get(), size);
-                    return string_type{result.get(), static_cast<stl::string_view::size_type>(size), alloc};
+                int const fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd == -1)
+                    return;
+                struct stat info {};
+                if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+                    ::close(fd);
+                    return;
                 }
+                file      = stl::make_shared<file_descriptor const>(fd);
+                file_size = static_cast<stl::size_t>(info.st_size);
+                mtime     = static_file::modification_time(info);
+            }
 
-                return res;
+            /**
+             * Read a part of the file into "out"
+             * @returns the size that's read; less if the file got shorter
+             */
+            stl::size_t read_at(char* out, stl::size_t offset, stl::size_t length) const noexcept {
+                stl::size_t done = 0;
+                while (done < length) {
+                    auto const res =
+                      ::pread(file->native_handle(), out + done, length - done, static_cast<off_t>(offset + done));
+                    if (res <= 0)
+                        break; // the file got shorter, or we couldn't read it
+                    done += static_cast<stl::size_t>(res);
+                }
+                return done;
             }
 
           public:
-            type(stl::filesystem::path filename, alloc_type alloc = alloc_type()) noexcept
-              : content{load_file(filename, alloc)} {
+            type(alloc_type alloc = allocator_type{}) noexcept : content{alloc}, loaded{true} {}
+
+            type(stl::filesystem::path const& filepath, alloc_type alloc = allocator_type{}) noexcept
+              : type_value{mime_type_of(filepath.native())},
+                content{alloc} {
+                open(filepath);
+            }
+
+            type(cached_file_type cached_file, alloc_type alloc = allocator_type{}) noexcept
+              : cached{stl::move(cached_file)},
+                type_value{cached ? cached->content_type() : stl::string_view{}},
+                content{alloc},
+                loaded{cached == nullptr} {}
+
+            type(type const&)     = default;
+            type(type&&) noexcept = default;
+            type& operator=(type const&) = default;
+            type& operator=(type&&) noexcept = default;
+
+            /**
+             * The file couldn't be opened (or it's not a regular file)
+             */
+            [[nodiscard]] bool is_open() const noexcept {
+                return file != nullptr || cached != nullptr || loaded;
+            }
+
+            /**
+             * The descriptor of the file; -1 if the body is in the memory
+             */
+            [[nodiscard]] int native_handle() const noexcept {
+                return file ? file->native_handle() : -1;
+            }
+
+            /**
+             * The owner of the descriptor; keep it while the descriptor is used
+             */
+            [[nodiscard]] file_type const& file_handle() const noexcept {
+                return file;
+            }
+
+            /**
+             * The file in the cache that the body points into; nullptr if it's
+             * not from a cache
+             */
+            [[nodiscard]] cached_file_type const& cached_file() const noexcept {
+                return cached;
+            }
+
+            /**
+             * The Content-Type of the file; the response uses it if it doesn't
+             * have one. Empty if the body is not a file.
+             */
+            [[nodiscard]] stl::string_view content_type() const noexcept {
+                if (selection && !selection->content_type.empty())
+                    return selection->content_type;
+                return type_value;
             }
 
+            /**
+             * The size of the whole file, even if some ranges are selected
+             */
+            [[nodiscard]] stl::size_t file_length() const noexcept {
+                return file ? file_size : cached ? cached->size() : content.size();
+            }
+
+            /**
+             * The modification time of the file, in nanoseconds; zero if it's
+             * not a file
+             */
+            [[nodiscard]] stl::uint64_t modified() const noexcept {
+                return file ? mtime : cached ? cached->modified() : 0;
+            }
+
+            /**
+             * The size of what's sent: the selected ranges, or the whole file
+             */
+            [[nodiscard]] stl::size_t size() const noexcept {
+                return selection ? selection->total : file_length();
+            }
+
+            /**
+             * Only send these ranges of the file (of a Range request, see
+             * parse_byte_ranges); more than one of them are sent as a
+             * multipart/byteranges whose parts have the content type.
+             * @returns false if it's not a file (the ranges are not selected)
+             */
+            bool select(stl::span<byte_range const> ranges, stl::string_view part_type) {
+                if (ranges.empty() || (!file && !cached))
+                    return false;
+                auto sel = stl::make_shared<details::file_selection>();
+                content.clear(); // "str" reads the selection
+                loaded = false;
+                if (ranges.size() == 1) {
+                    sel->segments.push_back({.offset = ranges.front().offset, .length = ranges.front().length});
+                    sel->total = ranges.front().length;
+                    selection  = stl::move(sel);
+                    return true;
+                }
+
+                auto const boundary = details::byterange_boundary();
+                auto const whole    = file_length();
+                auto const number   = [&](stl::size_t value) {
+                    stl::array<char, 24> str{};
+                    sel->text.append(str.data(), stl::to_chars(str.data(), str.data() + str.size(), value).ptr);
+                };
+                // the text is written first, and the segments point into it after that
+                stl::vector<stl::size_t> heads;
+                for (auto const& range : ranges) {
+                    heads.push_back(sel->text.size());
+                    sel->text.append("\r\n--").append(boundary).append("\r\nContent-Type: ").append(part_type);
+                    sel->text.append("\r\nContent-Range: bytes ");
+                    number(range.offset);
+                    sel->text.push_back('-');
+                    number(range.last());
+                    sel->text.push_back('/');
+                    number(whole);
+                    sel->text.append("\r\n\r\n");
+                }
+                heads.push_back(sel->text.size());
+                sel->text.append("\r\n--").append(boundary).append("--\r\n");
+                heads.push_back(sel->text.size());
+
+                stl::string_view const text = sel->text;
+                for (stl::size_t i = 0; i < ranges.size(); i++) {
+                    sel->segments.push_back({.text = text.substr(heads[i], heads[i + 1] - heads[i])});
+                    sel->segments.push_back({.offset = ranges[i].offset, .length = ranges[i].length});
+                    sel->total += heads[i + 1] - heads[i] + ranges[i].length;
+                }
+                sel->segments.push_back({.text = text.substr(heads[ranges.size()])});
+                sel->total += text.size() - heads[ranges.size()];
+                sel->content_type = "multipart/byteranges; boundary=" + boundary;
+                selection         = stl::move(sel);
+                return true;
+            }
+
+            /**
+             * The selected parts, for the interfaces that send them one by
+             * one; empty if there's no selection. Their text is kept by the
+             * segments_owner.
+             */
+            [[nodiscard]] stl::span<file_segment const> segments() const noexcept {
+                if (!selection)
+                    return {};
+                return selection->segments;
+            }
+
+            [[nodiscard]] stl::shared_ptr<void const> segments_owner() const noexcept {
+                return selection;
+            }
+
+            /**
+             * The content without copying the cached files
+             */
+            [[nodiscard]] string_view_type view() const noexcept {
+                if (cached && !selection)
+                    return string_view_type{cached->content().data(), cached->size()};
+                auto const& str_content = str();
+                return string_view_type{str_content.data(), str_content.size()};
+            }
 
+            /**
+             * The content of the file; it's read the first time it's asked for.
+             */
             [[nodiscard]] string_type const& str() const noexcept {
+                if (loaded)
+                    return content;
+                loaded = true;
+                if (selection) {
+                    content.reserve(selection->total);
+                    for (auto const& segment : selection->segments) {
+                        if (!segment.text.empty()) {
+                            content.append(segment.text.data(), segment.text.size());
+                        } else if (cached) {
+                            auto const part = cached->content().substr(segment.offset, segment.length);
+                            content.append(part.data(), part.size());
+                        } else {
+                            auto const at = content.size();
+                            content.resize(at + segment.length);
+                            content.resize(at + read_at(content.data() + at, segment.offset, segment.length));
+                        }
+                    }
+                    return content;
+                }
+                if (cached) {
+                    content.assign(cached->content().data(), cached->size());
+                    return content;
+                }
+                content.resize(file_size);
+                content.resize(read_at(content.data(), 0, file_size));
                 return content;
             }
-        }
+
+            [[nodiscard]] bool operator==(type const& other) const noexcept {
+                if (file || other.file)
+                    return file == other.file && selection == other.selection;
+                if (cached || other.cached)
+                    return cached == other.cached && selection == other.selection;
+                return content == other.content;
+            }
+        };
     };
 
+    /**
+     * The response of a static file: from the cache if it's small enough to be
+     * kept there, otherwise the file is opened and it's sent by the kernel.
+     * 404 if the file is not there.
+     *
+     * If the client accepts them (the Accept-Encoding of the request), the
+     * pre-compressed sidecars of the file ("style.css.br", "style.css.gz")
+     * are served instead.
+     *
+     * The files have an ETag and a Last-Modified, and if the request has a
+     * Range (and its If-Range matches them), only those ranges are sent with
+     * a 206, or a 416 if none of them is in the file.
+     */
+    template <typename ResponseType>
+    [[nodiscard]] ResponseType file_response(static_file_cache&           cache,
+                                             stl::filesystem::path const& path,
+                                             stl::string_view             accept_encoding = {},
+                                             stl::string_view             range           = {},
+                                             stl::string_view             if_range        = {}) noexcept {
+        using body_type = typename ResponseType::body_type;
+
+        auto const   content_type = mime_type_of(path.native());
+        ResponseType res{200u};
+        auto const   respond = [&](body_type body, stl::string_view etag) noexcept {
+            auto const seconds = static_cast<stl::int64_t>(body.modified() / 1'000'000'000u);
+            stl::array<char, http_date_size> date{};
+            format_http_date(seconds, date.data());
+            res.header.emplace(well_known_header_name(well_known_header::etag), etag);
+            res.header.emplace(well_known_header_name(well_known_header::last_modified),
+                               stl::string_view{date.data(), date.size()});
+            res.header.emplace(well_known_header_name(well_known_header::accept_ranges), "bytes");
+
+            stl::vector<byte_range> ranges;
+            auto const              whole  = body.file_length();
+            auto const              status = range.empty() || !if_range_matches(if_range, etag, seconds)
+                                               ? range_status::ignored
+                                               : parse_byte_ranges(range, whole, ranges);
+            if (status == range_status::unsatisfiable) {
+                res.header.status_code = 416u;
+                res.header.emplace(well_known_header_name(well_known_header::content_range),
+                                   "bytes */" + stl::to_string(whole));
+                return;
+            }
+            if (status == range_status::satisfiable && body.select(ranges, content_type)) {
+                res.header.status_code = 206u;
+                if (ranges.size() == 1) {
+                    res.header.emplace(well_known_header_name(well_known_header::content_range),
+                                       "bytes " + stl::to_string(ranges.front().offset) + "-" +
+                                         stl::to_string(ranges.front().last()) + "/" + stl::to_string(whole));
+                }
+            }
+            res.header.emplace(well_known_header_name(well_known_header::content_type),
+                               ranges.size() > 1 ? body.content_type() : content_type);
+            res.header.emplace(well_known_header_name(well_known_header::content_length),
+                               to_str_buffer(body.size()).view());
+            res.body = stl::move(body);
+        };
+        auto const serve = [&](stl::filesystem::path const& file_path) noexcept {
+            if (auto file = cache.get(file_path)) {
+                auto const etag = file->etag();
+                respond(body_type{stl::move(file)}, etag); // the cache keeps the file too
+                return true;
+            }
+            body_type body{file_path};
+            if (!body.is_open())
+                return false;
+            stl::array<char, 40> etag{};
+            auto const           tag = static_file::make_etag(body.modified(), body.file_length(), etag);
+            respond(stl::move(body), tag);
+            return true;
+        };
+
+        if (!accept_encoding.empty() && is_compressible(content_type)) {
+            // the one that the client likes more first; brotli wins the ties
+            auto const br   = encoding_quality(accept_encoding, content_encoding::br);
+            auto const gzip = encoding_quality(accept_encoding, content_encoding::gzip);
+            stl::array<content_encoding, 2> const order =
+              gzip > br ? stl::array{content_encoding::gzip, content_encoding::br}
+                        : stl::array{content_encoding::br, content_encoding::gzip};
+            for (auto const encoding : order) {
+                if (encoding_quality(accept_encoding, encoding) == 0)
+                    continue;
+                auto sidecar = path;
+                sidecar += encoding_extension(encoding);
+                if (serve(sidecar)) {
+                    res.header.emplace(well_known_header_name(well_known_header::content_encoding),
+                                       encoding_name(encoding));
+                    res.header.emplace(well_known_header_name(well_known_header::vary), "Accept-Encoding");
+                    return res;
+                }
+            }
+        }
+        if (!serve(path))
+            return ResponseType{404u};
+        return res;
+    }
+
 } // namespace webpp
 
-#endif // FILE_H
+#endif // WEBPP_HTTP_FILE_H
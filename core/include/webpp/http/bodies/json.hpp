@@ -0,0 +1,107 @@
+#ifndef WEBPP_HTTP_BODIES_JSON_H
+#define WEBPP_HTTP_BODIES_JSON_H
+
+#include "../../extensions/extension.hpp"
+#include "../../traits/traits_concepts.hpp"
+#include "../../utils/json.hpp"
+#include "../header.hpp"
+
+#include <utility>
+
+namespace webpp {
+
+    /**
+     * A body that the values are serialized into as JSON; the writer writes
+     * right into the string of the body, so there's no DOM and no copy in
+     * between. The string keeps its capacity when the body is reused.
+     *
+     *   res.body.json(user);
+     *   res.body.writer().begin_object().member("id", id).end_object();
+     */
+    struct json_body {
+        template <Traits TraitsType>
+        struct type {
+            using traits_type      = TraitsType;
+            using string_type      = typename traits_type::string_type;
+            using string_view_type = typename traits_type::string_view_type;
+            using allocator_type   = typename string_type::allocator_type;
+            using alloc_type       = allocator_type const&;
+            using writer_type      = ::webpp::json::writer<string_type>;
+
+          private:
+            string_type content;
+
+          public:
+            type(alloc_type alloc = allocator_type{}) noexcept : content{alloc} {}
+
+            type(type const&)     = default;
+            type(type&&) noexcept = default;
+            type& operator=(type const&) = default;
+            type& operator=(type&&) noexcept = default;
+
+            /**
+             * Replace the body with the value
+             */
+            template <typename T>
+            void json(T const& value) noexcept {
+                content.clear();
+                ::webpp::json::serialize(content, value);
+            }
+
+            /**
+             * A writer that appends to the body
+             */
+            [[nodiscard]] writer_type writer() noexcept {
+                return writer_type{content};
+            }
+
+            [[nodiscard]] string_type const& str() const noexcept {
+                return content;
+            }
+
+            [[nodiscard]] string_view_type view() const noexcept {
+                return string_view_type{content.data(), content.size()};
+            }
+
+            [[nodiscard]] stl::size_t size() const noexcept {
+                return content.size();
+            }
+
+            /**
+             * Replace the body with JSON that's already serialized
+             */
+            template <typename... Args>
+            requires(requires(string_type str, Args&&... args) { str.assign(stl::forward<Args>(args)...); })
+            void assign(Args&&... args) noexcept {
+                content.assign(stl::forward<Args>(args)...);
+            }
+
+            void clear() noexcept {
+                content.clear();
+            }
+
+            [[nodiscard]] bool operator==(type const& other) const noexcept {
+                return content == other.content;
+            }
+        };
+    };
+
+    struct json_response {
+        using response_body_extensions = extension_pack<json_body>;
+    };
+
+    /**
+     * A response with the value serialized as its body, and the JSON
+     * Content-Type
+     */
+    template <typename ResponseType, typename T>
+    [[nodiscard]] ResponseType make_json_response(T const& value, status_code_type status = 200u) noexcept {
+        ResponseType res{status};
+        res.body.json(value);
+        res.header.emplace(well_known_header_name(well_known_header::content_type), "application/json");
+        return res;
+    }
+
+} // namespace webpp
+
+#endif // WEBPP_HTTP_BODIES_JSON_H
@@ -0,0 +1,202 @@
+#ifndef WEBPP_HTTP_BODIES_STREAM_H
+#define WEBPP_HTTP_BODIES_STREAM_H
+
+#include "../../std/coroutine.hpp"
+#include "../../traits/traits_concepts.hpp"
+
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace webpp {
+
+    /**
+     * A coroutine that yields the chunks of a stream body:
+     *
+     *   chunk_generator report(rows_type rows) {
+     *       for (auto const& row : rows)
+     *           co_yield format_row(row);
+     *   }
+     *
+     * It's resumed each time the interface wants the next chunk, which is
+     * after the previous one is written.
+     */
+    class chunk_generator {
+      public:
+        struct promise_type {
+            stl::string chunk;
+
+            chunk_generator get_return_object() noexcept {
+                return chunk_generator{stl::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            stl::suspend_always initial_suspend() noexcept {
+                return {};
+            }
+
+            stl::suspend_always final_suspend() noexcept {
+                return {};
+            }
+
+            stl::suspend_always yield_value(stl::string&& value) noexcept {
+                chunk = stl::move(value);
+                return {};
+            }
+
+            template <typename T>
+            requires(stl::is_convertible_v<T const&, stl::string_view>)
+            stl::suspend_always yield_value(T const& value) noexcept {
+                chunk.assign(stl::string_view{value});
+                return {};
+            }
+
+            void return_void() noexcept {}
+
+            void unhandled_exception() noexcept {
+                stl::terminate();
+            }
+        };
+
+        using handle_type = stl::coroutine_handle<promise_type>;
+
+      private:
+        handle_type handle;
+
+      public:
+        explicit chunk_generator(handle_type _handle) noexcept : handle{_handle} {}
+        chunk_generator(chunk_generator const&) = delete;
+        chunk_generator(chunk_generator&& other) noexcept : handle{stl::exchange(other.handle, nullptr)} {}
+        chunk_generator& operator=(chunk_generator const&) = delete;
+        chunk_generator& operator=(chunk_generator&& other) noexcept {
+            if (this != &other) {
+                if (handle)
+                    handle.destroy();
+                handle = stl::exchange(other.handle, nullptr);
+            }
+            return *this;
+        }
+
+        ~chunk_generator() noexcept {
+            if (handle)
+                handle.destroy();
+        }
+
+        /**
+         * Run the coroutine up to its next chunk
+         * @returns false if it's finished
+         */
+        bool next(stl::string& chunk) noexcept {
+            if (!handle || handle.done())
+                return false;
+            handle.resume();
+            if (handle.done())
+                return false;
+            chunk.swap(handle.promise().chunk); // the capacities go back and forth
+            return true;
+        }
+    };
+
+    /**
+     * A body that is produced a chunk at a time while it's being sent; the
+     * response doesn't have a Content-Length, the simple server sends it with
+     * the chunked transfer encoding (and FastCGI as STDOUT records).
+     *
+     * The producer writes the next chunk into the string that it's given,
+     * and returns false when there's nothing more (what it has written in
+     * that last call is still sent). It's called after the request is done,
+     * so it should not hold anything from the request (the request's arena
+     * is gone by then); it's shared between the copies of the response, so
+     * the body can be read only once.
+     */
+    struct stream_body {
+        template <Traits TraitsType>
+        struct type {
+            using traits_type      = TraitsType;
+            using string_type      = typename traits_type::string_type;
+            using string_view_type = typename traits_type::string_view_type;
+            using allocator_type   = typename string_type::allocator_type;
+            using alloc_type       = allocator_type const&;
+            using chunk_type       = stl::string; // it outlives the request
+            using producer_type    = stl::function<bool(chunk_type&)>;
+
+          private:
+            stl::shared_ptr<producer_type> producer{};
+
+            // the whole of it, after it's read by "str"
+            mutable string_type content;
+
+          public:
+            type(alloc_type alloc = allocator_type{}) noexcept : content{alloc} {}
+
+            template <typename Producer>
+            requires(!stl::same_as<stl::remove_cvref_t<Producer>, type> &&
+                     !stl::same_as<stl::remove_cvref_t<Producer>, chunk_generator> &&
+                     stl::is_invocable_r_v<bool, Producer&, chunk_type&>)
+            type(Producer&& _producer, alloc_type alloc = allocator_type{}) noexcept
+              : producer{stl::make_shared<producer_type>(stl::forward<Producer>(_producer))},
+                content{alloc} {}
+
+            type(chunk_generator generator, alloc_type alloc = allocator_type{}) noexcept
+              : type{[gen = stl::make_shared<chunk_generator>(stl::move(generator))](chunk_type& chunk) noexcept {
+                         return gen->next(chunk);
+                     },
+                     alloc} {}
+
+            type(type const&)     = default;
+            type(type&&) noexcept = default;
+            type& operator=(type const&) = default;
+            type& operator=(type&&) noexcept = default;
+
+            /**
+             * There's a producer; the response has no length
+             */
+            [[nodiscard]] bool is_stream() const noexcept {
+                return producer && *producer;
+            }
+
+            /**
+             * The producer, for the interfaces that send the chunks as they're
+             * produced; keep it until the stream is over.
+             */
+            [[nodiscard]] stl::shared_ptr<producer_type> const& producer_handle() const noexcept {
+                return producer;
+            }
+
+            /**
+             * Produce the next chunk
+             * @returns false if the stream is over
+             */
+            bool next(chunk_type& chunk) const noexcept {
+                return is_stream() && (*producer)(chunk);
+            }
+
+            /**
+             * All of the chunks together; for the interfaces that can't stream.
+             * The producer is used up.
+             */
+            [[nodiscard]] string_type const& str() const noexcept {
+                if (!is_stream())
+                    return content;
+                chunk_type chunk;
+                for (bool more = true; more;) {
+                    chunk.clear();
+                    more = (*producer)(chunk);
+                    content.append(chunk.data(), chunk.size());
+                }
+                *producer = nullptr; // the other copies see that it's over too
+                return content;
+            }
+
+            [[nodiscard]] bool operator==(type const& other) const noexcept {
+                return producer == other.producer && content == other.content;
+            }
+        };
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_HTTP_BODIES_STREAM_H
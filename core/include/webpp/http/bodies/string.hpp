@@ -6,6 +6,7 @@
 #include "../../extensions/extension.hpp"
 #include "../../traits/traits_concepts.hpp"
 
+#include <memory>
 #include <type_traits>
 #include <utility>
 
@@ -24,27 +25,110 @@ namespace webpp {
             using allocator_type   = typename string_type::allocator_type;
             using alloc_type       = allocator_type const&;
 
+            using shared_string_type = stl::shared_ptr<string_type const>;
+            using owner_type         = stl::shared_ptr<void const>;
+
           private:
-            string_type content = "";
+            mutable string_type content = ""; // a copy of the borrowed bytes, if "str" is asked for
+            shared_string_type  shared{}; // an immutable content that's shared between the responses
+
+            // or the bytes that someone else owns (a cached blob, a mapped file, ...)
+            string_view_type borrowed{};
+            owner_type       owner{};
 
           public:
             template <typename... Args>
+            requires(!(sizeof...(Args) == 1 && (stl::same_as<stl::remove_cvref_t<Args>, shared_string_type> && ...)) &&
+                     stl::constructible_from<string_type, Args...>)
             type(Args&&... args) noexcept : content{stl::forward<Args>(args)...} {
             }
 
+            /**
+             * Share the content with the other responses instead of copying it;
+             * copying this body is a pointer copy then.
+             */
+            type(shared_string_type str) noexcept : shared{stl::move(str)} {}
+
+            /**
+             * Point to the bytes that the owner keeps alive; they're not copied
+             * (not even to the socket, by the interfaces that can).
+             */
+            type(string_view_type bytes, owner_type bytes_owner) noexcept
+              : borrowed{bytes},
+                owner{stl::move(bytes_owner)} {}
+
             /**
              * @brief Get a reference to the body's string
              * @return string
              */
             [[nodiscard]] string_type const& str() const noexcept {
+                if (shared)
+                    return *shared;
+                if (owner && content.size() != borrowed.size())
+                    content.assign(borrowed.data(), borrowed.size());
                 return content;
             }
+
+            /**
+             * The content without copying it
+             */
+            [[nodiscard]] string_view_type view() const noexcept {
+                if (shared)
+                    return string_view_type{shared->data(), shared->size()};
+                if (owner)
+                    return borrowed;
+                return string_view_type{content.data(), content.size()};
+            }
+
+            [[nodiscard]] stl::size_t size() const noexcept {
+                return view().size();
+            }
+
+            /**
+             * Whoever keeps the content alive if it's shared (the shared string,
+             * or the owner of the borrowed bytes); nullptr if the body owns it.
+             */
+            [[nodiscard]] owner_type shared_owner() const noexcept {
+                if (shared)
+                    return shared;
+                return owner;
+            }
+
+            /**
+             * Replace the content as if the body was constructed with the args;
+             * the capacity of the string is reused if it's enough.
+             */
+            template <typename... Args>
+            requires(sizeof...(Args) == 0 ||
+                     (sizeof...(Args) == 1 && (stl::same_as<stl::remove_cvref_t<Args>, shared_string_type> && ...)) ||
+                     requires(string_type str, Args&&... args) { str.assign(stl::forward<Args>(args)...); })
+            void assign(Args&&... args) noexcept {
+                if constexpr (sizeof...(Args) == 0) {
+                    clear();
+                } else if constexpr (sizeof...(Args) == 1 &&
+                                     (stl::same_as<stl::remove_cvref_t<Args>, shared_string_type> && ...)) {
+                    clear();
+                    shared = shared_string_type{stl::forward<Args>(args)...};
+                } else {
+                    clear();
+                    content.assign(stl::forward<Args>(args)...);
+                }
+            }
+
+            /**
+             * Empty the body, but keep the capacity of the string
+             */
+            void clear() noexcept {
+                content.clear();
+                shared.reset();
+                borrowed = {};
+                owner.reset();
+            }
         };
     };
 
 
     struct string_response {
-        template <Traits TraitsType>
         using response_body_extensions = extension_pack<string_body>;
     };
 
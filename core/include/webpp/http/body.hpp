@@ -2,10 +2,15 @@
 #define WEBPP_BODY_H
 
 #include "../extensions/extension.hpp"
+#include "../traits/traits_concepts.hpp"
 
+#include <concepts>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <variant>
 
 /**
@@ -20,17 +25,17 @@
  *   This means that we need access to the Interface so we can use it to read
  *   the data of the body, then we parse it to the thing that the user needs.
  *
- *   - Parsing formats:
- *     - [ ] JSON that returns:
- *       - [ ] JSONObject or some sort of custom class
+ *   - Parsing formats (see request_body_parsers in request_body.hpp):
+ *     - [X] JSON that returns:
+ *       - [X] json::document, read lazily
  *       - [ ] Array
  *       - [ ] std::vector
  *       - [ ] std::multimap
- *     - [ ] blob
+ *     - [X] blob (the "body()" of the request)
  *     - [ ] GraphQL Object
- *     - [ ] Form inputs
- *       - [ ] format 1 (I don't remember the type now)
- *       - [ ] format 2 TODO
+ *     - [X] Form inputs
+ *       - [X] application/x-www-form-urlencoded
+ *       - [X] multipart/form-data
  *
  * Response Body:
  *   - Features of the response body:
@@ -90,6 +95,11 @@
  */
 namespace webpp {
 
+    /**
+     * The body extensions are inherited, so a response with one body
+     * extension calls that body directly, there's nothing to dispatch; see
+     * select_response_body to choose between a few body types.
+     */
     template <Traits TraitsType, typename EList = empty_extension_pack>
     class response_body : public EList {
       public:
@@ -97,25 +107,7 @@ namespace webpp {
         using string_type      = typename traits_type::string_type;
         using string_view_type = typename traits_type::string_view_type;
         using elist_type       = EList;
-        /*
-              private:
-                template <typename ExtensionType>
-                using variant_extractor = typename ExtensionType::response_body_extensions;
-
-                template <typename ExtensionType>
-                struct has_variant {
-                    static constexpr bool value = requires {
-                        typename ExtensionType::response_body_extensions;
-                    };
-                };
-
-                using extensions_that_has_variants =
-                  typename EList::template filter<stl::variant, has_variant, EList>;
-
-              public:
-                using variant_type   = typename EList::template epack_miner<stl::variant, variant_extractor,
-                                                                          extensions_that_has_variants>::type;
-        */
+
         template <typename... Args>
         response_body(Args&&... args) noexcept : elist_type{stl::forward<Args>(args)...} {
         }
@@ -123,6 +115,126 @@ namespace webpp {
     };
 
 
+    /**
+     * A body that is one of a few body types, chosen at runtime; every call
+     * is a visitation. Use select_response_body to get it, so the responses
+     * with one body type don't pay for it.
+     */
+    template <typename... BodyTypes>
+    class variant_body {
+        static_assert(sizeof...(BodyTypes) > 1, "Use the body type itself.");
+
+        using first_type = stl::tuple_element_t<0, stl::tuple<BodyTypes...>>;
+
+        template <typename T>
+        static constexpr bool is_alternative = (stl::same_as<stl::remove_cvref_t<T>, BodyTypes> || ...);
+
+        stl::variant<BodyTypes...> value;
+
+      public:
+        using string_type = typename first_type::string_type;
+
+        /**
+         * The args are for the first body type
+         */
+        template <typename... Args>
+        requires(!(sizeof...(Args) == 1 && (is_alternative<Args> && ...)) &&
+                 stl::constructible_from<first_type, Args...>)
+        variant_body(Args&&... args) noexcept : value{stl::in_place_index<0>, stl::forward<Args>(args)...} {}
+
+        template <typename BodyType>
+        requires(is_alternative<BodyType>)
+        variant_body(BodyType&& body) noexcept : value{stl::forward<BodyType>(body)} {}
+
+        template <typename BodyType>
+        [[nodiscard]] bool holds() const noexcept {
+            return stl::holds_alternative<BodyType>(value);
+        }
+
+        template <typename BodyType>
+        [[nodiscard]] BodyType& get() noexcept {
+            return *stl::get_if<BodyType>(&value);
+        }
+
+        template <typename BodyType>
+        [[nodiscard]] BodyType const& get() const noexcept {
+            return *stl::get_if<BodyType>(&value);
+        }
+
+        template <typename BodyType, typename... Args>
+        BodyType& emplace(Args&&... args) noexcept {
+            return value.template emplace<BodyType>(stl::forward<Args>(args)...);
+        }
+
+        /**
+         * Call the visitor with the body that it holds
+         */
+        template <typename Visitor>
+        decltype(auto) visit(Visitor&& visitor) const noexcept {
+            return stl::visit(stl::forward<Visitor>(visitor), value);
+        }
+
+        [[nodiscard]] string_type const& str() const noexcept {
+            return stl::visit(
+              [](auto const& body) noexcept -> string_type const& {
+                  return body.str();
+              },
+              value);
+        }
+
+        [[nodiscard]] stl::size_t size() const noexcept {
+            return stl::visit(
+              [](auto const& body) noexcept -> stl::size_t {
+                  if constexpr (requires { body.size(); }) {
+                      return body.size();
+                  } else {
+                      return body.str().size();
+                  }
+              },
+              value);
+        }
+
+        /**
+         * Replace it with the first body type that can be assigned the args
+         */
+        template <typename... Args>
+        requires(requires(first_type & body, Args&&... args) { body.assign(stl::forward<Args>(args)...); })
+        void assign(Args&&... args) noexcept {
+            if (auto* body = stl::get_if<0>(&value)) {
+                body->assign(stl::forward<Args>(args)...);
+            } else {
+                value.template emplace<0>().assign(stl::forward<Args>(args)...);
+            }
+        }
+
+        [[nodiscard]] bool operator==(variant_body const& other) const noexcept
+          requires(stl::equality_comparable<BodyTypes> && ...) {
+            return value == other.value;
+        }
+    };
+
+    namespace details {
+        template <typename... BodyTypes>
+        struct select_response_body {
+            using type = variant_body<BodyTypes...>;
+        };
+
+        template <typename BodyType>
+        struct select_response_body<BodyType> {
+            using type = BodyType;
+        };
+    } // namespace details
+
+    /**
+     * The body of a response that can be any of these; one body type is the
+     * body type itself (collapsed at compile time, no variant), and more than
+     * one of them is a variant_body.
+     */
+    template <Traits TraitsType, typename... BodyDescriptors>
+    using select_response_body =
+      typename details::select_response_body<typename BodyDescriptors::template type<TraitsType>...>::type;
+
+
     struct response_body_descriptor {
         template <typename ExtensionType>
         struct has_related_extension_pack {
@@ -0,0 +1,144 @@
+#ifndef WEBPP_HTTP_BYTE_RANGES_H
+#define WEBPP_HTTP_BYTE_RANGES_H
+
+#include "../std/std.hpp"
+#include "../utils/strings.hpp"
+#include "./http_date.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace webpp {
+
+    /**
+     * A part of a representation, for the Range requests (RFC 9110, 14)
+     */
+    struct byte_range {
+        stl::size_t offset = 0;
+        stl::size_t length = 0;
+
+        [[nodiscard]] constexpr stl::size_t last() const noexcept {
+            return offset + length - 1;
+        }
+
+        [[nodiscard]] constexpr bool operator==(byte_range const&) const noexcept = default;
+    };
+
+    enum struct range_status {
+        ignored,      // there's no Range, or it's not valid; the whole of it is sent (200)
+        satisfiable,  // the ranges are sent (206)
+        unsatisfiable // none of the ranges are in it (416)
+    };
+
+    // more ranges than this are ignored; nobody needs them, and they make for cheap amplification
+    static constexpr stl::size_t max_byte_ranges = 16;
+
+    /**
+     * Parse the ranges of a Range header ("bytes=0-99, 200-, -50") for a
+     * representation of the size; the ranges are cut to the size, the ones
+     * that start after the end are dropped, and the ones that overlap are
+     * merged (so "bytes=0-,0-,0-" can't send the file three times).
+     */
+    [[nodiscard]] constexpr range_status parse_byte_ranges(stl::string_view           header,
+                                                           stl::size_t                size,
+                                                           stl::vector<byte_range>&   ranges) noexcept {
+        ranges.clear();
+        auto const eq = header.find('=');
+        if (eq == stl::string_view::npos || !ascii_iequals(header.substr(0, eq), "bytes"))
+            return range_status::ignored;
+        header.remove_prefix(eq + 1);
+
+        auto const number = [](stl::string_view str, stl::size_t& value) constexpr noexcept {
+            if (str.empty() || str.find_first_not_of("0123456789") != stl::string_view::npos)
+                return false;
+            auto const [ptr, ec] = stl::from_chars(str.data(), str.data() + str.size(), value);
+            return ec == stl::errc{} && ptr == str.data() + str.size();
+        };
+
+        bool found = false; // a valid range, even if it's not in the representation
+        while (!header.empty()) {
+            auto const comma = header.find(',');
+            auto       item  = header.substr(0, comma);
+            header.remove_prefix(comma == stl::string_view::npos ? header.size() : comma + 1);
+            auto const start = item.find_first_not_of(" \t");
+            if (start == stl::string_view::npos)
+                continue; // the empty elements of a list are allowed
+            item = item.substr(start, item.find_last_not_of(" \t") + 1 - start);
+
+            auto const dash = item.find('-');
+            if (dash == stl::string_view::npos)
+                return range_status::ignored;
+            auto const  first_str = item.substr(0, dash);
+            auto const  last_str  = item.substr(dash + 1);
+            stl::size_t first = 0, last = 0;
+            if (first_str.empty()) {
+                // the suffix: the last "n" bytes
+                if (!number(last_str, last))
+                    return range_status::ignored;
+                found = true;
+                if (last == 0 || size == 0)
+                    continue;
+                last = stl::min(last, size);
+                ranges.push_back({size - last, last});
+            } else {
+                if (!number(first_str, first) || (!last_str.empty() && (!number(last_str, last) || last < first)))
+                    return range_status::ignored;
+                found = true;
+                if (first >= size)
+                    continue;
+                last = last_str.empty() ? size - 1 : stl::min(last, size - 1);
+                ranges.push_back({first, last - first + 1});
+            }
+            if (ranges.size() > max_byte_ranges) {
+                ranges.clear();
+                return range_status::ignored;
+            }
+        }
+        if (!found)
+            return range_status::ignored;
+        if (ranges.empty())
+            return range_status::unsatisfiable;
+
+        if (ranges.size() > 1) {
+            stl::sort(ranges.begin(), ranges.end(), [](auto const& a, auto const& b) constexpr noexcept {
+                return a.offset < b.offset;
+            });
+            stl::size_t merged = 0;
+            for (stl::size_t i = 1; i < ranges.size(); i++) {
+                auto& prev = ranges[merged];
+                if (ranges[i].offset <= prev.offset + prev.length) {
+                    prev.length = stl::max(prev.offset + prev.length, ranges[i].offset + ranges[i].length) - prev.offset;
+                } else {
+                    ranges[++merged] = ranges[i];
+                }
+            }
+            ranges.resize(merged + 1);
+        }
+        return range_status::satisfiable;
+    }
+
+    /**
+     * Whether the Range should be used, by the If-Range of the request: if
+     * it's an ETag, it should be the same strong ETag, and if it's a date, it
+     * should be the Last-Modified (in seconds since the epoch). It's true if
+     * there's no If-Range.
+     */
+    [[nodiscard]] constexpr bool if_range_matches(stl::string_view if_range,
+                                                  stl::string_view etag,
+                                                  stl::int64_t     last_modified) noexcept {
+        if (if_range.empty())
+            return true;
+        if (if_range.starts_with('"'))
+            return !etag.empty() && if_range == etag;
+        if (if_range.starts_with("W/"))
+            return false; // the weak ones are never good enough for this
+        auto const date = parse_http_date(if_range);
+        return date && *date == last_modified;
+    }
+
+} // namespace webpp
+
+#endif // WEBPP_HTTP_BYTE_RANGES_H
@@ -0,0 +1,526 @@
+#ifndef WEBPP_HTTP_COMPRESSION_H
+#define WEBPP_HTTP_COMPRESSION_H
+
+#include "../std/std.hpp"
+#include "./well_known_headers.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+#include <utility>
+
+// the encoders are only used if they're asked for at build time (the
+// WEBPP_COMPRESSION option of cmake finds them)
+#if defined(WEBPP_ZLIB) && __has_include(<zlib.h>)
+#    define WEBPP_USE_ZLIB
+#    include <zlib.h>
+#endif
+#if defined(WEBPP_BROTLI) && __has_include(<brotli/encode.h>)
+#    define WEBPP_USE_BROTLI
+#    include <brotli/encode.h>
+#endif
+
+namespace webpp {
+
+    enum struct content_encoding : stl::uint8_t { identity, gzip, br };
+
+    /**
+     * The value of the Content-Encoding header, and the extension of the
+     * pre-compressed files (the sidecars)
+     */
+    [[nodiscard]] constexpr stl::string_view encoding_name(content_encoding encoding) noexcept {
+        switch (encoding) {
+            case content_encoding::gzip: return "gzip";
+            case content_encoding::br: return "br";
+            default: return "identity";
+        }
+    }
+
+    [[nodiscard]] constexpr stl::string_view encoding_extension(content_encoding encoding) noexcept {
+        switch (encoding) {
+            case content_encoding::gzip: return ".gz";
+            case content_encoding::br: return ".br";
+            default: return "";
+        }
+    }
+
+    /**
+     * Is the encoder of this encoding compiled in
+     */
+    [[nodiscard]] constexpr bool can_encode(content_encoding encoding) noexcept {
+        switch (encoding) {
+#ifdef WEBPP_USE_ZLIB
+            case content_encoding::gzip: return true;
+#endif
+#ifdef WEBPP_USE_BROTLI
+            case content_encoding::br: return true;
+#endif
+            case content_encoding::identity: return true;
+            default: return false;
+        }
+    }
+
+    /**
+     * The q-value of the encoding in an Accept-Encoding header, in
+     * thousandths; the ones that are not mentioned get the q-value of "*",
+     * or 0 (identity gets 1 then).
+     */
+    [[nodiscard]] constexpr int encoding_quality(stl::string_view accept_encoding,
+                                                 content_encoding encoding) noexcept {
+        constexpr auto lower = [](char c) constexpr noexcept {
+            return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+        };
+        constexpr auto trim = [](stl::string_view str) constexpr noexcept {
+            while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+                str.remove_prefix(1);
+            while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+                str.remove_suffix(1);
+            return str;
+        };
+        constexpr auto same = [=](stl::string_view a, stl::string_view b) constexpr noexcept {
+            if (a.size() != b.size())
+                return false;
+            for (stl::size_t i = 0; i < a.size(); i++)
+                if (lower(a[i]) != b[i])
+                    return false;
+            return true;
+        };
+        // "0.5" -> 500
+        constexpr auto parse_q = [](stl::string_view str) constexpr noexcept {
+            int         q     = str.starts_with('1') ? 1000 : 0;
+            int         scale = 100;
+            stl::size_t dot   = str.find('.');
+            if (dot != stl::string_view::npos && q == 0) {
+                for (auto c : str.substr(dot + 1)) {
+                    if (c < '0' || c > '9' || scale == 0)
+                        break;
+                    q += (c - '0') * scale;
+                    scale /= 10;
+                }
+            }
+            return q;
+        };
+
+        auto const name     = encoding_name(encoding);
+        int        quality  = -1;
+        int        wildcard = -1;
+        while (!accept_encoding.empty()) {
+            auto const comma = accept_encoding.find(',');
+            auto       item  = accept_encoding.substr(0, comma);
+            accept_encoding.remove_prefix(comma == stl::string_view::npos ? accept_encoding.size() : comma + 1);
+
+            int        q    = 1000;
+            auto const semi = item.find(';');
+            if (semi != stl::string_view::npos) {
+                auto params = trim(item.substr(semi + 1));
+                if (params.size() > 2 && lower(params[0]) == 'q' && params[1] == '=')
+                    q = parse_q(trim(params.substr(2)));
+                item = item.substr(0, semi);
+            }
+            item = trim(item);
+            if (same(item, name) || (encoding == content_encoding::gzip && same(item, "x-gzip"))) {
+                quality = q;
+            } else if (item == "*") {
+                wildcard = q;
+            }
+        }
+        if (quality != -1)
+            return quality;
+        if (wildcard != -1)
+            return wildcard;
+        return encoding == content_encoding::identity ? 1000 : 0;
+    }
+
+    /**
+     * The encoding that the client likes the most, out of the ones that we
+     * have; brotli wins the ties, it's smaller.
+     * @param available is the encoding available (the sidecar exists, ...)
+     */
+    template <typename Available>
+    [[nodiscard]] constexpr content_encoding negotiate_encoding(stl::string_view accept_encoding,
+                                                                Available&&      available) noexcept {
+        if (accept_encoding.empty())
+            return content_encoding::identity;
+        auto best         = content_encoding::identity;
+        int  best_quality = 0;
+        for (auto const encoding : {content_encoding::br, content_encoding::gzip}) {
+            auto const quality = encoding_quality(accept_encoding, encoding);
+            if (quality > best_quality && available(encoding)) {
+                best         = encoding;
+                best_quality = quality;
+            }
+        }
+        return best;
+    }
+
+    [[nodiscard]] constexpr content_encoding negotiate_encoding(stl::string_view accept_encoding) noexcept {
+        return negotiate_encoding(accept_encoding, [](content_encoding encoding) constexpr noexcept {
+            return can_encode(encoding);
+        });
+    }
+
+    /**
+     * The content types that are worth compressing; the images, the videos,
+     * and the archives are already compressed.
+     */
+    [[nodiscard]] constexpr bool is_compressible(stl::string_view content_type) noexcept {
+        if (content_type.empty() || content_type.starts_with("text/"))
+            return true;
+        constexpr stl::array<stl::string_view, 7> types{"application/json",
+                                                        "application/javascript",
+                                                        "application/xml",
+                                                        "application/wasm",
+                                                        "image/svg+xml",
+                                                        "application/manifest+json",
+                                                        "font/ttf"};
+        for (auto const type : types)
+            if (content_type.starts_with(type))
+                return true;
+        return content_type.find("+json") != stl::string_view::npos ||
+               content_type.find("+xml") != stl::string_view::npos;
+    }
+
+    namespace details {
+
+        /**
+         * The blocks that the encoders free, kept for the next responses of
+         * this thread; an encoder asks for the same sizes every time, so after
+         * the first response they don't go to malloc.
+         */
+        class compressor_memory {
+            struct block {
+                void*       ptr  = nullptr;
+                stl::size_t size = 0;
+            };
+
+            static constexpr stl::size_t max_blocks = 32;
+            static constexpr stl::size_t header     = alignof(stl::max_align_t);
+
+            stl::array<block, max_blocks> blocks{};
+            stl::size_t                   count = 0;
+
+          public:
+            compressor_memory() noexcept = default;
+            compressor_memory(compressor_memory const&) = delete;
+            compressor_memory& operator=(compressor_memory const&) = delete;
+
+            ~compressor_memory() noexcept {
+                for (stl::size_t i = 0; i != count; i++)
+                    stl::free(blocks[i].ptr);
+            }
+
+            [[nodiscard]] void* allocate(stl::size_t size) noexcept {
+                for (stl::size_t i = 0; i != count; i++) {
+                    if (blocks[i].size == size) {
+                        auto* const ptr = blocks[i].ptr;
+                        blocks[i]       = blocks[--count];
+                        return static_cast<char*>(ptr) + header;
+                    }
+                }
+                auto* const ptr = static_cast<char*>(stl::malloc(size + header));
+                if (ptr == nullptr)
+                    return nullptr;
+                *reinterpret_cast<stl::size_t*>(ptr) = size; // remember it for deallocate
+                return ptr + header;
+            }
+
+            void deallocate(void* address) noexcept {
+                if (address == nullptr)
+                    return;
+                auto* const ptr  = static_cast<char*>(address) - header;
+                auto const  size = *reinterpret_cast<stl::size_t*>(ptr);
+                if (count == max_blocks) {
+                    stl::free(ptr);
+                    return;
+                }
+                blocks[count++] = {ptr, size};
+            }
+
+            [[nodiscard]] static compressor_memory& local() noexcept {
+                thread_local compressor_memory memory;
+                return memory;
+            }
+        };
+
+        /**
+         * Make sure there's some room at the end of the output for the encoder
+         * to write to
+         */
+        template <typename StringType>
+        [[nodiscard]] inline stl::pair<char*, stl::size_t> grow_output(StringType& out, stl::size_t& used,
+                                                                       stl::size_t min_room) noexcept {
+            if (out.size() - used < min_room)
+                out.resize(used + (min_room > used ? min_room : used));
+            return {out.data() + used, out.size() - used};
+        }
+
+    } // namespace details
+
+#ifdef WEBPP_USE_ZLIB
+    /**
+     * A gzip encoder; the state is reset and used again for the next response
+     * (see local), so it doesn't allocate once it's warm.
+     *
+     * It's a streaming encoder: begin, write the chunks, and finish; the
+     * compressed bytes are appended to the output.
+     */
+    class gzip_compressor {
+        z_stream    stream{};
+        bool        ready = false;
+        stl::size_t used  = 0;
+
+        template <typename StringType>
+        bool run(StringType& out, stl::string_view input, int flush) noexcept {
+            stream.next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+            stream.avail_in = static_cast<uInt>(input.size());
+            for (;;) {
+                auto [ptr, room] = details::grow_output(out, used, 16 * 1024);
+                stream.next_out  = reinterpret_cast<Bytef*>(ptr);
+                stream.avail_out = static_cast<uInt>(room);
+                auto const res   = ::deflate(&stream, flush);
+                used += room - stream.avail_out;
+                if (res == Z_STREAM_END)
+                    return true;
+                if (res != Z_OK && res != Z_BUF_ERROR)
+                    return false;
+                if (stream.avail_in == 0 && stream.avail_out != 0 && flush == Z_NO_FLUSH)
+                    return true;
+            }
+        }
+
+      public:
+        explicit gzip_compressor(int level = 6) noexcept {
+            stream.zalloc = [](voidpf, uInt items, uInt size) -> voidpf {
+                return details::compressor_memory::local().allocate(static_cast<stl::size_t>(items) * size);
+            };
+            stream.zfree = [](voidpf, voidpf address) {
+                details::compressor_memory::local().deallocate(address);
+            };
+            // 15 + 16: the biggest window, with the gzip wrapper
+            ready = ::deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+        }
+
+        gzip_compressor(gzip_compressor const&) = delete;
+        gzip_compressor& operator=(gzip_compressor const&) = delete;
+
+        ~gzip_compressor() noexcept {
+            if (ready)
+                ::deflateEnd(&stream);
+        }
+
+        /**
+         * Start a new stream; the compressed bytes go at the end of "out"
+         */
+        template <typename StringType>
+        bool begin(StringType& out) noexcept {
+            used = out.size();
+            return ready && ::deflateReset(&stream) == Z_OK;
+        }
+
+        template <typename StringType>
+        bool write(StringType& out, stl::string_view chunk) noexcept {
+            return run(out, chunk, Z_NO_FLUSH);
+        }
+
+        template <typename StringType>
+        bool finish(StringType& out) noexcept {
+            auto const done = run(out, {}, Z_FINISH);
+            out.resize(used);
+            return done;
+        }
+
+        /**
+         * The encoder of this thread
+         */
+        [[nodiscard]] static gzip_compressor& local() noexcept {
+            // the memory should outlive the encoder; they're destroyed in reverse
+            static_cast<void>(details::compressor_memory::local());
+            thread_local gzip_compressor compressor;
+            return compressor;
+        }
+    };
+#endif
+
+#ifdef WEBPP_USE_BROTLI
+    /**
+     * A brotli encoder; brotli can't reset its state, so a new one is made
+     * for each stream, but its memory comes from the blocks of the previous
+     * ones (see compressor_memory).
+     *
+     * The quality is lower than the default (11) which is meant for the files
+     * that are compressed once, not for each response.
+     */
+    class brotli_compressor {
+        BrotliEncoderState* state   = nullptr;
+        int                 quality = 5;
+        stl::size_t         used    = 0;
+
+        void reset() noexcept {
+            if (state != nullptr)
+                ::BrotliEncoderDestroyInstance(state);
+            state = nullptr;
+        }
+
+        template <typename StringType>
+        bool run(StringType& out, stl::string_view input, BrotliEncoderOperation op) noexcept {
+            auto        available_in = input.size();
+            auto const* next_in      = reinterpret_cast<uint8_t const*>(input.data());
+            for (;;) {
+                auto [ptr, room] = details::grow_output(out, used, 16 * 1024);
+                auto  available  = room;
+                auto* next_out   = reinterpret_cast<uint8_t*>(ptr);
+                if (!::BrotliEncoderCompressStream(state, op, &available_in, &next_in, &available, &next_out,
+                                                   nullptr))
+                    return false;
+                used += room - available;
+                if (op == BROTLI_OPERATION_FINISH ? ::BrotliEncoderIsFinished(state)
+                                                  : available_in == 0 && !::BrotliEncoderHasMoreOutput(state))
+                    return true;
+            }
+        }
+
+      public:
+        explicit brotli_compressor(int _quality = 5) noexcept : quality{_quality} {}
+
+        brotli_compressor(brotli_compressor const&) = delete;
+        brotli_compressor& operator=(brotli_compressor const&) = delete;
+
+        ~brotli_compressor() noexcept {
+            reset();
+        }
+
+        template <typename StringType>
+        bool begin(StringType& out) noexcept {
+            reset();
+            used  = out.size();
+            state = ::BrotliEncoderCreateInstance(
+              [](void*, size_t size) -> void* {
+                  return details::compressor_memory::local().allocate(size);
+              },
+              [](void*, void* address) {
+                  details::compressor_memory::local().deallocate(address);
+              },
+              nullptr);
+            if (state == nullptr)
+                return false;
+            ::BrotliEncoderSetParameter(state, BROTLI_PARAM_QUALITY, static_cast<uint32_t>(quality));
+            ::BrotliEncoderSetParameter(state, BROTLI_PARAM_LGWIN, 20);
+            return true;
+        }
+
+        template <typename StringType>
+        bool write(StringType& out, stl::string_view chunk) noexcept {
+            return state != nullptr && run(out, chunk, BROTLI_OPERATION_PROCESS);
+        }
+
+        template <typename StringType>
+        bool finish(StringType& out) noexcept {
+            auto const done = state != nullptr && run(out, {}, BROTLI_OPERATION_FINISH);
+            out.resize(used);
+            reset(); // give its memory back to the blocks
+            return done;
+        }
+
+        [[nodiscard]] static brotli_compressor& local() noexcept {
+            static_cast<void>(details::compressor_memory::local()); // see gzip_compressor::local
+            thread_local brotli_compressor compressor;
+            return compressor;
+        }
+    };
+#endif
+
+    /**
+     * Compress the data with the encoder of this thread, a chunk at a time;
+     * the result is appended to "out".
+     * @returns false if it's not compressed (the encoding is not compiled in)
+     */
+    template <typename StringType>
+    bool compress(content_encoding encoding, stl::string_view data, StringType& out) noexcept {
+        constexpr stl::size_t chunk_size = 64 * 1024;
+        auto                  stream     = [&](auto& compressor) noexcept {
+            auto const start = out.size();
+            if (!compressor.begin(out))
+                return false;
+            for (stl::size_t pos = 0; pos < data.size(); pos += chunk_size) {
+                if (!compressor.write(out, data.substr(pos, chunk_size))) {
+                    compressor.finish(out);
+                    out.resize(start);
+                    return false;
+                }
+            }
+            if (!compressor.finish(out)) {
+                out.resize(start);
+                return false;
+            }
+            return true;
+        };
+        switch (encoding) {
+#ifdef WEBPP_USE_ZLIB
+            case content_encoding::gzip: return stream(gzip_compressor::local());
+#endif
+#ifdef WEBPP_USE_BROTLI
+            case content_encoding::br: return stream(brotli_compressor::local());
+#endif
+            default: return false;
+        }
+    }
+
+    struct compression_options {
+        stl::size_t min_size = 256; // the smaller ones may get bigger
+    };
+
+    /**
+     * The content type of the response; empty if it's not set
+     */
+    template <typename ResponseType>
+    [[nodiscard]] stl::string_view response_content_type(ResponseType const& res) noexcept {
+        for (auto const& field : res.header)
+            if (field.known == well_known_header::content_type)
+                return {field.value.data(), field.value.size()};
+        return {};
+    }
+
+    /**
+     * Compress the body of the response with the encoding that the client
+     * accepts (the Accept-Encoding header of the request); call it before
+     * the default headers are calculated.
+     *
+     * The responses that are already encoded, the ones that know their own
+     * length, the small ones, and the ones that are already compressed (the
+     * images, ...) are left alone; so are the bodies that can't be assigned
+     * a string (the files; see file_response for their sidecars).
+     */
+    template <typename ResponseType>
+    void compress_response(ResponseType&              res,
+                           stl::string_view           accept_encoding,
+                           compression_options const& options = {}) noexcept {
+        if constexpr (requires(typename ResponseType::str_t str) {
+                          res.body.str();
+                          res.body.assign(stl::move(str));
+                      }) {
+            if (res.header.contains(well_known_header::content_encoding) ||
+                res.header.contains(well_known_header::content_length))
+                return;
+            auto const& body = res.body.str();
+            if (body.size() < options.min_size || !is_compressible(response_content_type(res)))
+                return;
+            auto const encoding = negotiate_encoding(accept_encoding);
+            if (encoding == content_encoding::identity)
+                return;
+
+            typename ResponseType::str_t compressed{body.get_allocator()};
+            compressed.reserve(body.size() / 2);
+            if (!compress(encoding, {body.data(), body.size()}, compressed) || compressed.size() >= body.size())
+                return;
+            res.body.assign(stl::move(compressed));
+            res.header.emplace(well_known_header_name(well_known_header::content_encoding),
+                               encoding_name(encoding));
+            res.header.emplace(well_known_header_name(well_known_header::vary), "Accept-Encoding");
+        }
+    }
+
+} // namespace webpp
+
+#endif // WEBPP_HTTP_COMPRESSION_H
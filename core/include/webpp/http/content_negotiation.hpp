@@ -0,0 +1,240 @@
+#ifndef WEBPP_HTTP_CONTENT_NEGOTIATION_H
+#define WEBPP_HTTP_CONTENT_NEGOTIATION_H
+
+#include "../cache/lru_cache.hpp"
+#include "../cache/sharded_cache.hpp"
+#include "../std/optional.hpp"
+#include "../std/std.hpp"
+#include "../std/string.hpp"
+#include "../std/string_view.hpp"
+#include "../std/vector.hpp"
+#include "../utils/strings.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+
+namespace webpp {
+
+    /**
+     * The headers that are negotiated, and how their ranges match:
+     *   media_type: Accept           (star/star, text/star, "text/html")
+     *   language:   Accept-Language  ("*", "en" matches "en-US" too)
+     *   encoding:   Accept-Encoding  ("*", "gzip")
+     *   charset:    Accept-Charset   ("*", "utf-8")
+     */
+    enum struct accept_kind : stl::uint8_t { media_type, language, encoding, charset };
+
+    /**
+     * One of the ranges of an Accept header, lowercased, without its parameters
+     */
+    struct accept_range {
+        stl::string  value;
+        stl::int16_t quality = 1000; // the q-value, in thousandths
+    };
+
+    /**
+     * The ranges of an Accept header, the ones that the client likes more
+     * first (the ties keep the order of the header).
+     */
+    using accept_list = stl::vector<accept_range>;
+
+    namespace details {
+
+        /**
+         * "0.5" -> 500; the ones that are not valid q-values are 0
+         */
+        [[nodiscard]] constexpr stl::int16_t parse_qvalue(stl::string_view str) noexcept {
+            if (str.empty() || (str[0] != '0' && str[0] != '1'))
+                return 0;
+            int value = str[0] == '1' ? 1000 : 0;
+            if (str.size() > 1) {
+                if (str[1] != '.' || str.size() > 5)
+                    return 0;
+                int scale = 100;
+                for (auto const c : str.substr(2)) {
+                    if (c < '0' || c > '9')
+                        return 0;
+                    value += (c - '0') * scale;
+                    scale /= 10;
+                }
+            }
+            return static_cast<stl::int16_t>(stl::min(value, 1000));
+        }
+
+        [[nodiscard]] constexpr stl::string_view trim_ows(stl::string_view str) noexcept {
+            while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+                str.remove_prefix(1);
+            while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+                str.remove_suffix(1);
+            return str;
+        }
+
+        /**
+         * How specific the range is for the offer, or -1 if it doesn't match
+         * it; the most specific range that matches gives the offer its q-value.
+         */
+        [[nodiscard]] constexpr int
+        range_specificity(accept_kind kind, stl::string_view range, stl::string_view offer) noexcept {
+            if (kind == accept_kind::media_type) {
+                if (range == "*/*")
+                    return 0;
+                if (range.ends_with("/*")) {
+                    auto const type = range.substr(0, range.size() - 1); // with the slash
+                    return offer.size() > type.size() && ascii_iequals(offer.substr(0, type.size()), type)
+                             ? 1
+                             : -1;
+                }
+                return ascii_iequals(range, offer) ? 2 : -1;
+            }
+            if (range == "*")
+                return 0;
+            if (ascii_iequals(range, offer))
+                return static_cast<int>(range.size()) + 1;
+            // the basic filtering of the language tags: "en" is "en-US" too
+            if (kind == accept_kind::language && offer.size() > range.size() && offer[range.size()] == '-' &&
+                ascii_iequals(offer.substr(0, range.size()), range))
+                return static_cast<int>(range.size());
+            return -1;
+        }
+
+    } // namespace details
+
+    /**
+     * Parse and sort the ranges of an Accept, Accept-Language, Accept-Encoding,
+     * or Accept-Charset header. The parameters of the media types (other
+     * than q) are dropped.
+     */
+    [[nodiscard]] inline accept_list parse_accept(stl::string_view header) {
+        accept_list list;
+        while (!header.empty()) {
+            auto const comma = header.find(',');
+            auto       item  = header.substr(0, comma);
+            header.remove_prefix(comma == stl::string_view::npos ? header.size() : comma + 1);
+
+            stl::int16_t quality = 1000;
+            auto         semi    = item.find(';');
+            auto const   value   = details::trim_ows(item.substr(0, semi));
+            while (semi != stl::string_view::npos) {
+                item.remove_prefix(semi + 1);
+                semi             = item.find(';');
+                auto const param = details::trim_ows(item.substr(0, semi));
+                if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+                    quality = details::parse_qvalue(details::trim_ows(param.substr(2)));
+                    break; // the ones after q are the extensions of the range
+                }
+            }
+            if (value.empty())
+                continue;
+            auto& range = list.emplace_back(accept_range{stl::string{value}, quality});
+            ascii_to_lower(range.value.data(), range.value.size());
+        }
+        stl::stable_sort(list.begin(), list.end(), [](accept_range const& a, accept_range const& b) {
+            return a.quality > b.quality;
+        });
+        return list;
+    }
+
+    /**
+     * The q-value of the offer in the parsed header (in thousandths); the
+     * offers that no range matches are not acceptable (0).
+     */
+    [[nodiscard]] inline int
+    accept_quality(accept_list const& list, accept_kind kind, stl::string_view offer) noexcept {
+        int quality     = 0;
+        int specificity = -1;
+        for (auto const& range : list) {
+            auto const spec = details::range_specificity(kind, range.value, offer);
+            if (spec > specificity) {
+                specificity = spec;
+                quality     = range.quality;
+            }
+        }
+        return quality;
+    }
+
+    /**
+     * The index of the offer that the client likes the most, if it accepts any
+     * of them; the ties go to the one that comes first in the offers (the
+     * server's preference). An empty header accepts everything.
+     */
+    template <typename OffersType>
+    [[nodiscard]] stl::optional<stl::size_t>
+    negotiate(accept_list const& list, accept_kind kind, OffersType const& offers) noexcept {
+        stl::optional<stl::size_t> best;
+        int                        best_quality = 0;
+        stl::size_t                index        = 0;
+        for (auto const& offer : offers) {
+            auto const quality = list.empty() ? 1000 : accept_quality(list, kind, offer);
+            if (quality > best_quality) {
+                best         = index;
+                best_quality = quality;
+            }
+            index++;
+        }
+        return best;
+    }
+
+    /**
+     * The negotiation of one header against a fixed set of offers, with its
+     * results remembered by the raw value of the header. The clients send the
+     * same few values over and over (each build of each browser has its own),
+     * so most of the requests are a hash lookup instead of a parse and a sort.
+     * It's safe to share between the threads.
+     *
+     *   accept_negotiator types{accept_kind::media_type, {"application/json", "text/html"}};
+     *   if (auto type = types.choose(req.header("Accept"))) ...
+     *   else 406
+     *
+     * The headers that are longer than "max_memoized_size" are negotiated
+     * every time; they're not worth the memory.
+     */
+    class accept_negotiator {
+        // the index of the offer + 1, or 0 if none of them is acceptable
+        using memo_type = sharded_cache<lru_cache<stl::string, stl::uint16_t>, 16>;
+
+        accept_kind              kind;
+        stl::vector<stl::string> offers;
+        memo_type                memo;
+
+      public:
+        static constexpr stl::size_t max_memoized_size = 512;
+
+        accept_negotiator(accept_kind kind, stl::initializer_list<stl::string_view> offers,
+                          stl::size_t max_entries = 1024)
+          : kind{kind},
+            offers(offers.begin(), offers.end()),
+            memo{max_entries} {}
+
+        /**
+         * The index of the chosen offer, if any of them is acceptable
+         */
+        [[nodiscard]] stl::optional<stl::size_t> choose_index(stl::string_view header) {
+            if (header.size() > max_memoized_size)
+                return negotiate(parse_accept(header), kind, offers);
+            auto const chosen = memo.get_or_set(stl::string{header}, [this, header] {
+                auto const index = negotiate(parse_accept(header), kind, offers);
+                return static_cast<stl::uint16_t>(index ? *index + 1 : 0);
+            });
+            if (chosen == 0)
+                return stl::nullopt;
+            return chosen - 1u;
+        }
+
+        /**
+         * The chosen offer, if any of them is acceptable
+         */
+        [[nodiscard]] stl::optional<stl::string_view> choose(stl::string_view header) {
+            if (auto const index = choose_index(header))
+                return stl::string_view{offers[*index]};
+            return stl::nullopt;
+        }
+
+        [[nodiscard]] stl::size_t memoized() const {
+            return memo.size();
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_HTTP_CONTENT_NEGOTIATION_H
@@ -88,8 +88,10 @@
 #include "../../utils/charset.hpp"
 #include "../../utils/strings.hpp"
 #include "../common.hpp"
+#include "../http_date.hpp"
 #include "./cookies_concepts.hpp"
 
+#include <charconv>
 #include <chrono>
 #include <string_view>
 #include <type_traits>
@@ -115,7 +117,7 @@ namespace webpp {
 
         using name_t         = storing_string_type;
         using value_t        = storing_string_type;
-        using allocator_type = typename storing_string_type::allocator_type;
+        using allocator_type = typename string_type::allocator_type; // the views don't use it
 
       protected:
         name_t  _name;
@@ -133,7 +135,7 @@ namespace webpp {
 
         void parse_SE_name(string_view_type& str, allocator_type const& alloc) noexcept {
             ltrim<traits_type>(str);
-            if (auto equal_pos = str.find_first_not_of(VALID_COOKIE_NAME.data());
+            if (auto equal_pos = VALID_COOKIE_NAME.find_first_not_in(str);
                 equal_pos != string_view_type::npos) {
                 // setting the name we found it
                 _name = name_t{str.substr(0, equal_pos), alloc};
@@ -156,7 +158,7 @@ namespace webpp {
                 str.remove_prefix(1);
             ltrim<traits_type>(str);
             if (starts_with<traits_type>(str, '"')) {
-                if (auto d_quote_end = str.find_first_not_of(VALID_COOKIE_VALUE.data(), 1);
+                if (auto d_quote_end = VALID_COOKIE_VALUE.find_first_not_in(str, 1);
                     d_quote_end != string_view_type::npos) {
                     if (str[d_quote_end] == '"') {
                         _value = value_t{str.substr(1, d_quote_end - 1), alloc};
@@ -176,7 +178,7 @@ namespace webpp {
                 }
             } else {
                 // there's no double quote in the value
-                if (auto semicolon_pos = str.find_first_not_of(VALID_COOKIE_VALUE.data());
+                if (auto semicolon_pos = VALID_COOKIE_VALUE.find_first_not_in(str);
                     semicolon_pos != string_view_type::npos) {
                     _value = value_t{str.substr(0, semicolon_pos), alloc};
                     str.remove_prefix(semicolon_pos);
@@ -200,6 +202,16 @@ namespace webpp {
         basic_cookie_common(const basic_cookie_common& c)     = default;
         basic_cookie_common(basic_cookie_common&& c) noexcept = default;
 
+        // the allocator-extended ones, for the containers with polymorphic allocators
+        basic_cookie_common(basic_cookie_common const& c, allocator_type const& alloc)
+          : _name{c._name, alloc},
+            _value{c._value, alloc},
+            _valid{c._valid} {}
+        basic_cookie_common(basic_cookie_common&& c, allocator_type const& alloc)
+          : _name{stl::move(c._name), alloc},
+            _value{stl::move(c._value), alloc},
+            _valid{c._valid} {}
+
         basic_cookie_common(name_t __name, value_t __value,
                             allocator_type const& alloc = allocator_type{}) noexcept
           : _name(trim_copy<traits_type>(__name), alloc),
@@ -291,8 +303,8 @@ namespace webpp {
         using encrypted_t        = bool;
         using comment_t          = typename super::storing_string_type;
 
-        using attrs_t = stl::unordered_map<TraitsType, typename super::storing_string_type,
-                                           typename super::storing_string_type>;
+        using attrs_t = istl::unordered_map<TraitsType, typename super::storing_string_type,
+                                            typename super::storing_string_type>;
 
 
       private:
@@ -310,11 +322,110 @@ namespace webpp {
         // todo: encapsulate this
         attrs_t attrs;
 
+        // the Set-Cookie value that "serialize" keeps; the setters drop it
+        typename super::string_type serialized{};
+        bool                        is_serialized_valid = false;
+
+        self_t& changed() noexcept {
+            is_serialized_valid = false;
+            return *this;
+        }
+
+        void render_into(typename super::string_type& out) const {
+            auto const put = [&out](stl::string_view str) {
+                out.append(str.begin(), str.end());
+            };
+            if (_prefix) {
+                if (_secure)
+                    put("__Secure-");
+                else if (_host_only)
+                    put("__Host-");
+            }
+            if (super::_name.empty())
+                return;
+            // FIXME: encode/... name and value here. Programmers are dumb!
+            out.append(super::_name);
+            put("=");
+            out.append(super::_value);
+
+            if (!_comment.empty()) {
+                put("; Comment=");
+                out.append(_comment);
+            }
+            if (!_domain.empty()) {
+                put("; Domain=");
+                out.append(_domain);
+            }
+            if (!_path.empty()) {
+                put("; Path=");
+                out.append(_path);
+            }
+            if (_expires) {
+                char date[http_date_size];
+                format_http_date(*_expires, date);
+                put("; Expires=");
+                put({date, http_date_size});
+            }
+            if (_secure)
+                put("; Secure");
+            if (_host_only)
+                put("; HttpOnly");
+            if (_max_age) {
+                char       digits[24];
+                auto const res = stl::to_chars(digits, digits + sizeof(digits), _max_age);
+                put("; Max-Age=");
+                put({digits, static_cast<stl::size_t>(res.ptr - digits)});
+            }
+            if (_same_site != super::same_site_value::NONE)
+                put(_same_site == super::same_site_value::STRICT ? "; SameSite=Strict" : "; SameSite=Lax");
+
+            // TODO: encode value and check the key here:
+            for (auto const& attr : attrs) {
+                put("; ");
+                out.append(attr.first);
+                put("=");
+                out.append(attr.second);
+            }
+        }
+
       public:
         static constexpr auto header_direction = header_type::response;
         static constexpr bool is_mutable       = true;
 
         constexpr response_cookie(alloc_type const& alloc = {}) noexcept : super{alloc} {};
+        response_cookie(response_cookie const&)     = default;
+        response_cookie(response_cookie&&) noexcept = default;
+
+        response_cookie(response_cookie const& c, alloc_type const& alloc)
+          : super{c, alloc},
+            _domain{c._domain, alloc},
+            _path{c._path, alloc},
+            _expires{c._expires},
+            _comment{c._comment, alloc},
+            _max_age{c._max_age},
+            _same_site{c._same_site},
+            _secure{c._secure},
+            _host_only{c._host_only},
+            _encrypted{c._encrypted},
+            _prefix{c._prefix},
+            attrs{c.attrs} {}
+
+        response_cookie(response_cookie&& c, alloc_type const& alloc)
+          : super{stl::move(c), alloc},
+            _domain{stl::move(c._domain), alloc},
+            _path{stl::move(c._path), alloc},
+            _expires{c._expires},
+            _comment{stl::move(c._comment), alloc},
+            _max_age{c._max_age},
+            _same_site{c._same_site},
+            _secure{c._secure},
+            _host_only{c._host_only},
+            _encrypted{c._encrypted},
+            _prefix{c._prefix},
+            attrs{stl::move(c.attrs)} {}
+
+        response_cookie& operator=(response_cookie const&) = default;
+        response_cookie& operator=(response_cookie&&) noexcept = default;
 
 
         explicit response_cookie(typename super::name_t name, typename super::value_t value,
@@ -369,48 +480,50 @@ namespace webpp {
             return super::value();
         }
         self_t& name(typename super::name_t __name) noexcept {
-            return static_cast<self_t&>(super::name(__name));
+            super::name(__name);
+            return changed();
         }
         self_t& value(typename super::value_t __value) noexcept {
-            return static_cast<self_t&>(super::value(__value));
+            super::value(__value);
+            return changed();
         }
 
         auto& comment(comment_t __comment) noexcept {
             _comment = stl::move(__comment);
-            return *this;
+            return changed();
         }
 
         auto& domain(domain_t __domain) noexcept {
             _domain = stl::move(__domain);
-            return *this;
+            return changed();
         }
         auto& path(path_t __path) noexcept {
             _path = stl::move(__path);
-            return *this;
+            return changed();
         }
         auto& max_age(max_age_t __max_age) noexcept {
             _max_age = __max_age;
-            return *this;
+            return changed();
         }
         auto& prefix(prefix_t __prefix) noexcept {
             _prefix = __prefix;
-            return *this;
+            return changed();
         }
         auto& same_site(same_site_t __same_site) noexcept {
             _same_site = __same_site;
-            return *this;
+            return changed();
         }
         auto& secure(secure_t __secure) noexcept {
             _secure = __secure;
-            return *this;
+            return changed();
         }
         auto& host_only(host_only_t __host_only) noexcept {
             _host_only = __host_only;
-            return *this;
+            return changed();
         }
         auto& expires(date_t __expires) noexcept {
             _expires = __expires;
-            return *this;
+            return changed();
         }
 
         auto& remove(bool __remove = true) noexcept {
@@ -438,7 +551,7 @@ namespace webpp {
         template <typename D, typename T>
         inline auto& expires_in(stl::chrono::duration<D, T> const& __dur) noexcept {
             _expires = stl::chrono::system_clock::now() + __dur;
-            return *this;
+            return changed();
         }
 
         /**
@@ -448,70 +561,24 @@ namespace webpp {
          */
         auto& encrypted(encrypted_t __encrypted) noexcept {
             _encrypted = __encrypted;
-            return *this;
+            return changed();
         }
 
         /**
          * @brief decrypt-able encryption
          */
         typename super::value_t encrypted_value() const noexcept {
-            // todo implement this
+            // todo implement this; it's empty until then, and not the value in plain text
+            return {};
         }
 
         stl::basic_ostream<typename super::char_type>&
-        operator<<(stl::basic_ostream<typename super::char_type>& out) const noexcept {
-            using namespace stl::chrono;
-            if (_prefix) {
-                if (_secure)
-                    out << "__Secure-";
-                else if (_host_only)
-                    out << "__Host-";
-            }
-            if (!super::_name.empty()) {
-                // FIXME: encode/... name and value here. Programmers are dumb!
-                out << super::_name << "=" << super::_value;
-
-                if (!_comment.empty())
-                    out << "; Comment=" << _comment;
-
-                if (!_domain.empty())
-                    out << "; Domain=" << _domain;
-
-                if (!_path.empty())
-                    out << "; Path=" << _path;
-
-                if (_expires) {
-                    stl::time_t expires_c  = system_clock::to_time_t(*_expires);
-                    stl::tm     expires_tm = *stl::localtime(&expires_c);
-                    char        buff[30];
-                    // FIXME: check time zone and see if it's ok
-                    //            setlocale(LC_ALL, "en_US.UTF-8");
-                    if (strftime(buff, sizeof buff, "%a, %d %b %Y %H:%M:%S GMT", &expires_tm))
-                        out << "; Expires=" << buff;
-                }
-
-                if (_secure)
-                    out << "; Secure";
-
-                if (_host_only)
-                    out << "; HttpOnly";
-
-                if (_max_age)
-                    out << "; Max-Age=" << _max_age;
-
-                if (_same_site != super::same_site_value::NONE)
-                    out << "; SameSite=" << (_same_site == super::same_site_value::STRICT ? "Strict" : "Lax");
-
-                // TODO: encode value and check the key here:
-                if (!attrs.empty())
-                    for (auto const& attr : attrs)
-                        out << "; " << attr.first << "=" << attr.second;
-            }
-            return out;
+        operator<<(stl::basic_ostream<typename super::char_type>& out) const {
+            return out << render();
         }
 
         bool operator==(request_cookie<TraitsType> const& c) const noexcept {
-            return super::_name == c._name && super::_value == c._value;
+            return super::_name == c.name() && super::_value == c.value();
         }
 
         bool operator==(response_cookie<TraitsType> const& c) const noexcept {
@@ -537,11 +604,41 @@ namespace webpp {
             return _expires >= c._expires;
         }
 
-        [[nodiscard]] typename super::string_type render() const noexcept {
-            // todo: don't use streams here
-            stl::basic_ostringstream<typename super::char_type> os;
-                                                                operator<<(os);
-            return os.str();
+        [[nodiscard]] typename super::string_type render() const {
+            typename super::string_type out;
+            append_to(out);
+            return out;
+        }
+
+        /**
+         * Append the value of the Set-Cookie header of the cookie to "out"; it's a copy of the one that
+         * "serialize" has kept, if there's one.
+         */
+        void append_to(typename super::string_type& out) const {
+            if (is_serialized_valid)
+                out.append(serialized);
+            else
+                render_into(out);
+        }
+
+        /**
+         * Render the Set-Cookie value once and keep it, so the cookies that are set on every response
+         * (like the session refreshes) are copied instead of rendered; the setters drop it. It's not
+         * thread-safe to call it while the other threads are reading the cookie.
+         */
+        self_t& serialize() {
+            serialized.clear();
+            render_into(serialized);
+            is_serialized_valid = true;
+            return *this;
+        }
+
+        [[nodiscard]] bool is_serialized() const noexcept {
+            return is_serialized_valid;
+        }
+
+        [[nodiscard]] typename super::string_type response_str() const {
+            return render();
         }
 
         /**
@@ -572,6 +669,9 @@ namespace webpp {
             swap(first._encrypted, second._encrypted);
             swap(first._prefix, second._prefix);
             swap(first._same_site, second._same_site);
+            swap(first.attrs, second.attrs);
+            swap(first.serialized, second.serialized);
+            swap(first.is_serialized_valid, second.is_serialized_valid);
         }
     };
 
@@ -645,4 +745,12 @@ namespace webpp {
 
 } // namespace webpp
 
+#ifdef WEBPP_EXTERN_TEMPLATES
+namespace webpp {
+    // compiled once, in the library (see src/instances.cpp)
+    extern template struct basic_cookie_common<std_traits, true>;
+    extern template struct response_cookie<std_traits>;
+} // namespace webpp
+#endif
+
 #endif // WEBPP_HTTP_COOKIES_H
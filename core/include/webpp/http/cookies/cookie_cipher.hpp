@@ -0,0 +1,408 @@
+#ifndef WEBPP_HTTP_COOKIE_CIPHER_H
+#define WEBPP_HTTP_COOKIE_CIPHER_H
+
+#include "../../std/std.hpp"
+#include "../../utils/base64.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+
+// the cookies are only encrypted if it's asked for at build time (the
+// WEBPP_COOKIE_ENCRYPTION option of cmake finds OpenSSL's libcrypto)
+#if defined(WEBPP_OPENSSL) && __has_include(<openssl/evp.h>)
+#    define WEBPP_USE_OPENSSL
+#    include <openssl/crypto.h>
+#    include <openssl/evp.h>
+#    include <openssl/rand.h>
+#endif
+
+namespace webpp {
+
+    enum struct cookie_cipher_algorithm : stl::uint8_t {
+        aes_256_gcm,      // the fastest one on the CPUs with AES-NI (OpenSSL picks it at runtime)
+        chacha20_poly1305 // the fastest one on the CPUs without it
+    };
+
+    namespace details {
+
+        [[nodiscard]] constexpr stl::size_t base64url_size(stl::size_t size) noexcept {
+            return base64url::encoded_size(size);
+        }
+
+        inline void base64url_encode(unsigned char const* data, stl::size_t size, char* out) noexcept {
+            auto const bytes = stl::string_view{reinterpret_cast<char const*>(data), size};
+            static_cast<void>(base64url::encode(bytes, out, base64url::encoded_size(size)));
+        }
+
+        /**
+         * Decode the unpadded base64url into "out" (it should have room for str.size() * 3 / 4 bytes)
+         * @returns the number of the bytes, or npos if it's not base64url
+         */
+        inline stl::size_t base64url_decode(stl::string_view str, unsigned char* out) noexcept {
+            return base64url::decode(str, reinterpret_cast<char*>(out), base64url::max_decoded_size(str.size()));
+        }
+
+        /**
+         * The serials of the keys and the ciphers; the per-thread contexts remember the key that they're
+         * set up with by its serial, since the addresses are reused.
+         */
+        inline stl::uint64_t next_cipher_serial() noexcept {
+            static stl::atomic<stl::uint64_t> serial{0};
+            return serial.fetch_add(1, stl::memory_order_relaxed) + 1;
+        }
+
+    } // namespace details
+
+    /**
+     * Authenticated encryption of the cookie values, so the session state can be kept in the cookies
+     * instead of a server-side store; the values can't be read or changed by the clients, and they
+     * can't be moved to another cookie (the name is authenticated with them).
+     *
+     * A sealed value is the base64url of: the key id (1 byte), the nonce (12 bytes), the encrypted
+     * value, and the tag (16 bytes).
+     *
+     * The keys are rotated with "rotate": the new key seals the values from then on, and the last
+     * max_keys keys open them, so the cookies that were sealed before a rotation still work for a while.
+     * Each thread has its own cipher contexts (the key schedule is set up once per key per thread), so
+     * nothing is shared between the threads but the keys, which are copied when they're rotated.
+     *
+     *   cookie_cipher cipher;
+     *   cipher.rotate(key); // 32 bytes
+     *   cipher.seal("session", state, res_value);
+     *   cipher.open("session", req.cookies().value("session"), state);
+     */
+    class cookie_cipher {
+      public:
+        static constexpr stl::size_t key_size       = 32;
+        static constexpr stl::size_t nonce_size     = 12;
+        static constexpr stl::size_t tag_size       = 16;
+        static constexpr stl::size_t overhead       = 1 + nonce_size + tag_size;
+        static constexpr stl::size_t max_keys       = 4;
+        static constexpr stl::size_t max_value_size = 4096; // the browsers don't keep bigger cookies
+
+      private:
+        struct key {
+            stl::uint64_t                       serial = 0;
+            stl::uint8_t                        id     = 0;
+            stl::array<unsigned char, key_size> bytes{};
+        };
+
+        struct keyring {
+            stl::array<key, max_keys> keys{}; // the first one is the one that seals
+            stl::size_t               count = 0;
+
+            keyring() noexcept               = default;
+            keyring(keyring const&) noexcept = default;
+
+            ~keyring() noexcept {
+#ifdef WEBPP_USE_OPENSSL
+                OPENSSL_cleanse(keys.data(), sizeof(keys));
+#endif
+            }
+
+            [[nodiscard]] key const* find(stl::uint8_t id) const noexcept {
+                for (stl::size_t i = 0; i < count; i++)
+                    if (keys[i].id == id)
+                        return &keys[i];
+                return nullptr;
+            }
+        };
+
+#ifdef WEBPP_USE_OPENSSL
+        // an EVP context of a thread, and the key that it's set up with
+        struct thread_context {
+            EVP_CIPHER_CTX* ctx    = EVP_CIPHER_CTX_new();
+            stl::uint64_t   serial = 0;
+
+            thread_context() noexcept                        = default;
+            thread_context(thread_context const&)            = delete;
+            thread_context& operator=(thread_context const&) = delete;
+
+            ~thread_context() noexcept {
+                EVP_CIPHER_CTX_free(ctx);
+            }
+        };
+
+        // the nonces of a thread: 12 random bytes, then the last 8 of them are counted up, so the
+        // threads don't share the nonces without any coordination
+        struct thread_nonces {
+            stl::array<unsigned char, nonce_size> nonce{};
+            stl::uint64_t                         counter = 0;
+            bool                                  seeded  = false;
+
+            bool next(unsigned char* out) noexcept {
+                if (!seeded) {
+                    if (RAND_bytes(nonce.data(), static_cast<int>(nonce.size())) != 1)
+                        return false;
+                    stl::memcpy(&counter, nonce.data() + 4, sizeof(counter));
+                    seeded = true;
+                }
+                counter++;
+                stl::memcpy(nonce.data() + 4, &counter, sizeof(counter));
+                stl::memcpy(out, nonce.data(), nonce_size);
+                return true;
+            }
+        };
+#endif
+
+        // the keys that a thread has last seen
+        struct thread_keys {
+            stl::uint64_t                  instance = 0;
+            stl::uint64_t                  version  = 0;
+            stl::shared_ptr<keyring const> ring{};
+        };
+
+        cookie_cipher_algorithm        algorithm;
+        stl::uint64_t                  instance = details::next_cipher_serial();
+        stl::atomic<stl::uint64_t>     version{0};
+        mutable stl::mutex             lock{};
+        stl::shared_ptr<keyring const> ring = stl::make_shared<keyring const>();
+
+        [[nodiscard]] keyring const& current_keys() const {
+            thread_local thread_keys cache;
+            if (cache.instance != instance || cache.version != version.load(stl::memory_order_acquire)) {
+                stl::scoped_lock const guard{lock};
+                cache.ring     = ring;
+                cache.version  = version.load(stl::memory_order_relaxed);
+                cache.instance = instance;
+            }
+            return *cache.ring;
+        }
+
+#ifdef WEBPP_USE_OPENSSL
+        // the contexts are not shared between the sealing and the opening, so a thread that does both
+        // doesn't set the key schedule up for each of them
+        static thread_context& sealing_context() noexcept {
+            thread_local thread_context context;
+            return context;
+        }
+
+        static thread_context& opening_context() noexcept {
+            thread_local thread_context context;
+            return context;
+        }
+
+        static thread_nonces& nonces() noexcept {
+            thread_local thread_nonces thread_nonce;
+            return thread_nonce;
+        }
+
+        [[nodiscard]] EVP_CIPHER const* evp_cipher() const noexcept {
+            return algorithm == cookie_cipher_algorithm::aes_256_gcm ? EVP_aes_256_gcm()
+                                                                     : EVP_chacha20_poly1305();
+        }
+#endif
+
+      public:
+        explicit cookie_cipher(cookie_cipher_algorithm algo = cookie_cipher_algorithm::aes_256_gcm) noexcept
+          : algorithm{algo} {}
+
+        cookie_cipher(cookie_cipher const&)            = delete;
+        cookie_cipher& operator=(cookie_cipher const&) = delete;
+
+        /**
+         * Is the encryption compiled in
+         */
+        [[nodiscard]] static constexpr bool is_available() noexcept {
+#ifdef WEBPP_USE_OPENSSL
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        /**
+         * Seal the values with this key from now on; the oldest key is dropped if there are max_keys
+         * of them already. It's safe to rotate the keys while the other threads use the cipher.
+         * @returns false if the encryption is not compiled in
+         */
+        bool rotate(stl::span<unsigned char const, key_size> new_key) {
+            if constexpr (!is_available())
+                return false;
+            stl::scoped_lock const guard{lock};
+            auto                   next = stl::make_shared<keyring>();
+            next->keys[0].serial        = details::next_cipher_serial();
+            next->keys[0].id = ring->count == 0 ? 0 : static_cast<stl::uint8_t>(ring->keys[0].id + 1);
+            stl::memcpy(next->keys[0].bytes.data(), new_key.data(), key_size);
+            next->count = stl::min(ring->count + 1, max_keys);
+            for (stl::size_t i = 1; i < next->count; i++)
+                next->keys[i] = ring->keys[i - 1];
+            ring = stl::move(next);
+            version.fetch_add(1, stl::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Rotate to a random key; for the servers that don't share the cookies with the other servers
+         * and don't need them to survive a restart.
+         */
+        bool rotate() {
+#ifdef WEBPP_USE_OPENSSL
+            stl::array<unsigned char, key_size> new_key;
+            if (RAND_bytes(new_key.data(), static_cast<int>(new_key.size())) != 1)
+                return false;
+            auto const res = rotate(new_key);
+            OPENSSL_cleanse(new_key.data(), new_key.size());
+            return res;
+#else
+            return false;
+#endif
+        }
+
+        /**
+         * Encrypt the value of the cookie with the name, and append the sealed value to "out"
+         * @returns false if there's no key, the value is too big, or the encryption is not compiled in
+         */
+        template <typename StringType>
+        bool seal(stl::string_view name, stl::string_view value, StringType& out) const {
+#ifdef WEBPP_USE_OPENSSL
+            if (value.size() > max_value_size)
+                return false;
+            auto const& keys = current_keys();
+            if (keys.count == 0)
+                return false;
+            auto const& sealing = keys.keys[0];
+
+            auto&       context = sealing_context();
+            auto* const ctx     = context.ctx;
+            if (context.serial != sealing.serial) {
+                if (EVP_EncryptInit_ex(ctx, evp_cipher(), nullptr, sealing.bytes.data(), nullptr) != 1)
+                    return false;
+                context.serial = sealing.serial;
+            }
+
+            stl::array<unsigned char, overhead + max_value_size> raw;
+            raw[0]                 = sealing.id;
+            auto* const ciphertext = raw.data() + 1 + nonce_size;
+            int         len        = 0;
+            int         final_len  = 0;
+            if (!nonces().next(raw.data() + 1) ||
+                EVP_EncryptInit_ex(ctx, nullptr, nullptr, nullptr, raw.data() + 1) != 1 ||
+                EVP_EncryptUpdate(ctx,
+                                  nullptr,
+                                  &len,
+                                  reinterpret_cast<unsigned char const*>(name.data()),
+                                  static_cast<int>(name.size())) != 1 ||
+                EVP_EncryptUpdate(ctx,
+                                  ciphertext,
+                                  &len,
+                                  reinterpret_cast<unsigned char const*>(value.data()),
+                                  static_cast<int>(value.size())) != 1 ||
+                EVP_EncryptFinal_ex(ctx, ciphertext + len, &final_len) != 1 ||
+                EVP_CIPHER_CTX_ctrl(ctx,
+                                    EVP_CTRL_AEAD_GET_TAG,
+                                    static_cast<int>(tag_size),
+                                    ciphertext + value.size()) != 1) {
+                context.serial = 0;
+                return false;
+            }
+
+            auto const raw_size = overhead + value.size();
+            auto const old_size = out.size();
+            out.resize(old_size + details::base64url_size(raw_size));
+            details::base64url_encode(raw.data(), raw_size, out.data() + old_size);
+            return true;
+#else
+            (void) name;
+            (void) value;
+            (void) out;
+            return false;
+#endif
+        }
+
+        /**
+         * Decrypt the sealed value of the cookie with the name, and append the value to "out"
+         * @returns false if it's not sealed by one of the keys for this name, or it's been changed
+         */
+        template <typename StringType>
+        bool open(stl::string_view name, stl::string_view sealed, StringType& out) const {
+#ifdef WEBPP_USE_OPENSSL
+            if (sealed.size() < details::base64url_size(overhead) ||
+                sealed.size() > details::base64url_size(overhead + max_value_size))
+                return false;
+            stl::array<unsigned char, overhead + max_value_size> raw;
+            auto const raw_size = details::base64url_decode(sealed, raw.data());
+            if (raw_size == stl::string_view::npos || raw_size < overhead)
+                return false;
+            auto const* const opening = current_keys().find(raw[0]);
+            if (opening == nullptr)
+                return false;
+
+            auto&       context = opening_context();
+            auto* const ctx     = context.ctx;
+            if (context.serial != opening->serial) {
+                if (EVP_DecryptInit_ex(ctx, evp_cipher(), nullptr, opening->bytes.data(), nullptr) != 1)
+                    return false;
+                context.serial = opening->serial;
+            }
+
+            auto const  value_size = raw_size - overhead;
+            auto* const ciphertext = raw.data() + 1 + nonce_size;
+            auto const  old_size   = out.size();
+            out.resize(old_size + value_size);
+            int        len       = 0;
+            int        final_len = 0;
+            bool const ok        =
+              EVP_DecryptInit_ex(ctx, nullptr, nullptr, nullptr, raw.data() + 1) == 1 &&
+              EVP_CIPHER_CTX_ctrl(ctx,
+                                  EVP_CTRL_AEAD_SET_TAG,
+                                  static_cast<int>(tag_size),
+                                  ciphertext + value_size) == 1 &&
+              EVP_DecryptUpdate(ctx,
+                                nullptr,
+                                &len,
+                                reinterpret_cast<unsigned char const*>(name.data()),
+                                static_cast<int>(name.size())) == 1 &&
+              EVP_DecryptUpdate(ctx,
+                                reinterpret_cast<unsigned char*>(out.data() + old_size),
+                                &len,
+                                ciphertext,
+                                static_cast<int>(value_size)) == 1 &&
+              EVP_DecryptFinal_ex(ctx, reinterpret_cast<unsigned char*>(out.data() + old_size) + len,
+                                  &final_len) == 1;
+            if (!ok) {
+                // the forged values are not handed out, not even a part of them
+                OPENSSL_cleanse(out.data() + old_size, value_size);
+                out.resize(old_size);
+            }
+            return ok;
+#else
+            (void) name;
+            (void) sealed;
+            (void) out;
+            return false;
+#endif
+        }
+
+        /**
+         * Seal the values of the cookies of the jar that are marked as encrypted; they're marked as not
+         * encrypted after that, so they're not sealed twice.
+         * @returns false if one of them can't be sealed
+         */
+        template <typename CookieJarType>
+        bool seal_cookies(CookieJarType& jar) const {
+            bool ok = true;
+            for (auto& cookie : jar) {
+                if (!cookie.encrypted())
+                    continue;
+                typename stl::remove_cvref_t<decltype(cookie.value())> sealed;
+                if (seal(cookie.name(), cookie.value(), sealed))
+                    cookie.value(stl::move(sealed)).encrypted(false);
+                else
+                    ok = false;
+            }
+            return ok;
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_HTTP_COOKIE_CIPHER_H
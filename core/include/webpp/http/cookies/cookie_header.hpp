@@ -0,0 +1,206 @@
+#ifndef WEBPP_HTTP_COOKIE_HEADER_H
+#define WEBPP_HTTP_COOKIE_HEADER_H
+
+#include "../../std/std.hpp"
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+namespace webpp {
+
+    /**
+     * Decode the %XX escapes of a cookie value (the "+" stays a "+"), and append it to "out"; most of the
+     * values need none of it, so it's only done when it's asked for.
+     * @returns false if it has a broken escape
+     */
+    template <typename StringType>
+    constexpr bool decode_cookie_value(stl::string_view encoded, StringType& out) noexcept {
+        constexpr auto hex_value = [](char c) constexpr noexcept -> int {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            return -1;
+        };
+        for (stl::size_t i = 0; i < encoded.size(); i++) {
+            if (encoded[i] != '%') {
+                out.push_back(encoded[i]);
+                continue;
+            }
+            if (i + 2 >= encoded.size())
+                return false;
+            auto const high = hex_value(encoded[i + 1]);
+            auto const low  = hex_value(encoded[i + 2]);
+            if (high < 0 || low < 0)
+                return false;
+            out.push_back(static_cast<char>((high << 4) | low));
+            i += 2;
+        }
+        return true;
+    }
+
+    /**
+     * A name=value pair of a Cookie header; they're views into the header, and the value is without its
+     * double quotes, still encoded.
+     */
+    struct cookie_pair {
+        stl::string_view name;
+        stl::string_view value;
+
+        template <typename StringType>
+        constexpr bool decoded_value(StringType& out) const noexcept {
+            return decode_cookie_value(value, out);
+        }
+    };
+
+    namespace details {
+
+        [[nodiscard]] constexpr stl::string_view trim_cookie_spaces(stl::string_view str) noexcept {
+            while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+                str.remove_prefix(1);
+            while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+                str.remove_suffix(1);
+            return str;
+        }
+
+        /**
+         * Cut the next pair off of the Cookie header; the empty ones are skipped, and the ones without a
+         * "=" are values with an empty name, the way the browsers take them.
+         * @returns false if there's none left
+         */
+        constexpr bool next_cookie(stl::string_view& header, cookie_pair& pair) noexcept {
+            while (!header.empty()) {
+                auto const semicolon = header.find(';');
+                auto const segment   = trim_cookie_spaces(header.substr(0, semicolon));
+                header.remove_prefix(semicolon == stl::string_view::npos ? header.size() : semicolon + 1);
+                if (segment.empty())
+                    continue;
+
+                auto const equal = segment.find('=');
+                if (equal == stl::string_view::npos) {
+                    pair.name  = {};
+                    pair.value = segment;
+                } else {
+                    pair.name  = trim_cookie_spaces(segment.substr(0, equal));
+                    pair.value = trim_cookie_spaces(segment.substr(equal + 1));
+                }
+                if (pair.value.size() >= 2 && pair.value.front() == '"' && pair.value.back() == '"')
+                    pair.value = pair.value.substr(1, pair.value.size() - 2);
+                return true;
+            }
+            return false;
+        }
+
+    } // namespace details
+
+    /**
+     * The pairs of a Cookie header, tokenized once into views; nothing is allocated and nothing is
+     * copied. The first "Capacity" pairs are kept in the view, and the ones after them (the requests
+     * with a lot of tracking cookies) are tokenized when they're looked up.
+     *
+     *   cookie_header_view const cookies{req.header("Cookie")};
+     *   auto const session = cookies.value("session");
+     *   for (auto const& [name, value] : cookies) ...
+     */
+    template <stl::size_t Capacity = 32>
+    struct cookie_header_view {
+        static constexpr stl::size_t capacity = Capacity;
+
+      private:
+        stl::array<cookie_pair, Capacity> pairs{};
+        stl::size_t                       count = 0;
+        stl::string_view                  rest{}; // the part that's not tokenized
+
+      public:
+        constexpr cookie_header_view() noexcept = default;
+
+        constexpr explicit cookie_header_view(stl::string_view header) noexcept : rest{header} {
+            for (cookie_pair pair; count < Capacity && details::next_cookie(rest, pair);)
+                pairs[count++] = pair;
+        }
+
+        [[nodiscard]] constexpr auto begin() const noexcept {
+            return pairs.begin();
+        }
+
+        [[nodiscard]] constexpr auto end() const noexcept {
+            return pairs.begin() + static_cast<stl::ptrdiff_t>(count);
+        }
+
+        /**
+         * The number of the pairs that are kept in the view
+         */
+        [[nodiscard]] constexpr stl::size_t size() const noexcept {
+            return count;
+        }
+
+        [[nodiscard]] constexpr bool empty() const noexcept {
+            return count == 0;
+        }
+
+        [[nodiscard]] constexpr cookie_pair const& operator[](stl::size_t index) const noexcept {
+            return pairs[index];
+        }
+
+        /**
+         * Are there more pairs than the ones that are kept in the view
+         */
+        [[nodiscard]] constexpr bool overflowed() const noexcept {
+            auto        header = rest;
+            cookie_pair pair;
+            return details::next_cookie(header, pair);
+        }
+
+        /**
+         * Call the function with all of the pairs, the ones that are not kept in the view too
+         */
+        template <typename Func>
+        constexpr void for_each(Func&& func) const {
+            for (auto const& pair : *this)
+                func(pair);
+            auto header = rest;
+            for (cookie_pair pair; details::next_cookie(header, pair);)
+                func(pair);
+        }
+
+        /**
+         * The first pair with the name (the names are case-sensitive); its views are null if there's none.
+         */
+        [[nodiscard]] constexpr cookie_pair find(stl::string_view name) const noexcept {
+            for (auto const& pair : *this)
+                if (pair.name == name)
+                    return pair;
+            auto header = rest;
+            for (cookie_pair pair; details::next_cookie(header, pair);)
+                if (pair.name == name)
+                    return pair;
+            return {};
+        }
+
+        [[nodiscard]] constexpr bool contains(stl::string_view name) const noexcept {
+            return find(name).value.data() != nullptr;
+        }
+
+        /**
+         * The value of the first pair with the name, still encoded; empty if there's none
+         */
+        [[nodiscard]] constexpr stl::string_view value(stl::string_view name) const noexcept {
+            return find(name).value;
+        }
+    };
+
+    /**
+     * The value of the first pair of the Cookie header with the name, without keeping the others; for
+     * when only one of them is needed.
+     */
+    [[nodiscard]] constexpr stl::string_view find_cookie_value(stl::string_view header,
+                                                               stl::string_view name) noexcept {
+        return cookie_header_view<0>{header}.value(name);
+    }
+
+} // namespace webpp
+
+#endif // WEBPP_HTTP_COOKIE_HEADER_H
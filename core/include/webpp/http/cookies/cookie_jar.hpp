@@ -7,9 +7,12 @@
 #include "./cookie.hpp"
 
 #include <algorithm>
+#include <bit>
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <memory>
+#include <vector>
 
 namespace webpp {
 
@@ -35,14 +38,14 @@ namespace webpp {
      * class has to put new cookies into the header classes before the
      * string_views's in basic_cookie class go out of scope.
      *
-     *
-     * istl::unordered_set<typename CookieType::traits_type, CookieType,
-     *                              cookie_hash<CookieType>,
-     *                              cookie_equals<CookieType>>
-     *
+     * The cookies are unique: a cookie that's the "same_as" one that's in the jar (the same name, and the
+     * same domain and path for the response cookies) replaces it in its place. The lookups go through an
+     * open-addressing table of the positions of the cookies by the hashes of their names, so they're O(1);
+     * it's built on the first lookup, and it's dropped (and built again on the next lookup) when the
+     * cookies are changed through the non-const iterators, or they're erased.
      */
     template <Cookie CookieType>
-    struct basic_cookie_jar : public istl::vector<typename CookieType::traits_type, CookieType> {
+    struct basic_cookie_jar : private istl::vector<typename CookieType::traits_type, CookieType> {
 
       public:
         using traits_type      = typename CookieType::traits_type;
@@ -53,36 +56,225 @@ namespace webpp {
       private:
         using super = istl::vector<traits_type, cookie_type>;
 
+        static constexpr stl::uint32_t empty_slot = 0;
+
+        // the positions + 1 of the cookies; a name can be in more than one slot (different domains)
+        mutable stl::vector<stl::uint32_t> slots{};
+        mutable bool                       indexed = false;
+
+        [[nodiscard]] static stl::size_t name_hash(string_view_type name) noexcept {
+            return stl::hash<string_view_type>{}(name);
+        }
+
+        [[nodiscard]] static bool is_same(cookie_type const& a, cookie_type const& b) noexcept {
+            if constexpr (requires { a.same_as(b); }) {
+                return a.same_as(b);
+            } else {
+                return a.name() == b.name();
+            }
+        }
+
+        void add_slot(stl::size_t pos) const noexcept {
+            auto const mask = slots.size() - 1;
+            auto       slot = name_hash(super::operator[](pos).name()) & mask;
+            while (slots[slot] != empty_slot)
+                slot = (slot + 1) & mask;
+            slots[slot] = static_cast<stl::uint32_t>(pos + 1);
+        }
+
+        // at most half full, so the runs of the probes stay short
+        void reindex() const {
+            slots.assign(stl::bit_ceil(stl::max<stl::size_t>(16, super::size() * 2)), empty_slot);
+            for (stl::size_t pos = 0; pos < super::size(); pos++)
+                add_slot(pos);
+            indexed = true;
+        }
+
+        void ensure_index() const {
+            if (!indexed)
+                reindex();
+        }
+
+        /**
+         * Call the function with the positions of the cookies that their name has the same hash, until it
+         * returns true
+         */
+        template <typename Func>
+        void for_each_candidate(string_view_type name, Func&& func) const {
+            ensure_index();
+            auto const mask = slots.size() - 1;
+            for (auto slot = name_hash(name) & mask; slots[slot] != empty_slot; slot = (slot + 1) & mask)
+                if (func(static_cast<stl::size_t>(slots[slot] - 1)))
+                    return;
+        }
+
+        cookie_type& put(cookie_type&& cookie) {
+            cookie_type* same = nullptr;
+            for_each_candidate(cookie.name(), [&](stl::size_t pos) {
+                auto& other = super::operator[](pos);
+                if (is_same(other, cookie))
+                    same = &other;
+                return same != nullptr;
+            });
+            if (same != nullptr) {
+                *same = stl::move(cookie);
+                return *same;
+            }
+            super::push_back(stl::move(cookie));
+            if (super::size() * 2 > slots.size())
+                reindex();
+            else
+                add_slot(super::size() - 1);
+            return super::back();
+        }
+
       public:
+        using typename super::allocator_type;
+        using typename super::const_iterator;
+        using typename super::const_reference;
+        using typename super::const_reverse_iterator;
+        using typename super::difference_type;
+        using typename super::iterator;
+        using typename super::reference;
+        using typename super::reverse_iterator;
+        using typename super::size_type;
+        using typename super::value_type;
+
+        using super::capacity;
+        using super::cbegin;
+        using super::cend;
+        using super::crbegin;
+        using super::crend;
+        using super::empty;
+        using super::get_allocator;
+        using super::max_size;
+        using super::reserve;
+        using super::size;
+
         template <typename... Args>
-        basic_cookie_jar(Args&&... args) : super{std::forward<Args>(args)...} {
+        basic_cookie_jar(Args&&... args) : super{stl::forward<Args>(args)...} {
         }
 
-        typename super::const_iterator find(typename cookie_type::name_t const& name) const noexcept {
-            return stl::find_if(super::cbegin(), super::cend(), [&](auto const& a) {
-                return a.name() == name;
+        // the non-const access can change the cookies, so the index is built again after it
+        [[nodiscard]] iterator begin() noexcept {
+            indexed = false;
+            return super::begin();
+        }
+        [[nodiscard]] iterator end() noexcept {
+            indexed = false;
+            return super::end();
+        }
+        [[nodiscard]] reverse_iterator rbegin() noexcept {
+            indexed = false;
+            return super::rbegin();
+        }
+        [[nodiscard]] reverse_iterator rend() noexcept {
+            indexed = false;
+            return super::rend();
+        }
+        [[nodiscard]] reference operator[](size_type pos) noexcept {
+            indexed = false;
+            return super::operator[](pos);
+        }
+        [[nodiscard]] const_iterator begin() const noexcept {
+            return super::begin();
+        }
+        [[nodiscard]] const_iterator end() const noexcept {
+            return super::end();
+        }
+        [[nodiscard]] const_reverse_iterator rbegin() const noexcept {
+            return super::rbegin();
+        }
+        [[nodiscard]] const_reverse_iterator rend() const noexcept {
+            return super::rend();
+        }
+        [[nodiscard]] const_reference operator[](size_type pos) const noexcept {
+            return super::operator[](pos);
+        }
+
+        /**
+         * Add the cookie, or replace the one that's the same as it
+         * @returns the cookie in the jar
+         */
+        cookie_type& push_back(cookie_type const& cookie) {
+            return put(cookie_type{cookie});
+        }
+
+        cookie_type& push_back(cookie_type&& cookie) {
+            return put(stl::move(cookie));
+        }
+
+        template <typename... Args>
+        cookie_type& emplace_back(Args&&... args) {
+            return put(cookie_type{stl::forward<Args>(args)...});
+        }
+
+        iterator erase(const_iterator pos) {
+            indexed = false;
+            return super::erase(pos);
+        }
+
+        iterator erase(const_iterator first, const_iterator last) {
+            indexed = false;
+            return super::erase(first, last);
+        }
+
+        void clear() noexcept {
+            indexed = false;
+            super::clear();
+        }
+
+        /**
+         * The last cookie with the name (the newest one, if there are more than one of them with different
+         * domains or paths); end() if there's none
+         */
+        [[nodiscard]] const_iterator find(string_view_type name) const {
+            stl::size_t found = super::size();
+            for_each_candidate(name, [&](stl::size_t pos) {
+                if (super::operator[](pos).name() == name && (found == super::size() || pos > found))
+                    found = pos;
+                return false;
             });
+            return cbegin() + static_cast<difference_type>(found);
         }
 
-        typename super::const_iterator find(cookie_type const& c) const noexcept {
-            return stl::find_if(super::cbegin(), super::cend(), [&](auto const& a) {
-                return a.same_as(c);
+        [[nodiscard]] const_iterator find(cookie_type const& c) const {
+            stl::size_t found = super::size();
+            for_each_candidate(c.name(), [&](stl::size_t pos) {
+                if (is_same(super::operator[](pos), c))
+                    found = pos;
+                return found != super::size();
             });
+            return cbegin() + static_cast<difference_type>(found);
         }
 
-        void remove_duplicates() noexcept {
-            constexpr auto predicate = [](auto const& a, auto const& b) {
-                return trim_copy<traits_type>(a.name()) < trim_copy<traits_type>(b.name()) ||
-                       a.domain() < b.domain();
-            };
-            stl::sort(super::begin(), super::end(), predicate);
-            super::erase(
-              super::begin(),
-              super::begin() +
-                stl::distance(super::begin(),
-                              stl::unique(super::rbegin(), super::rend(), [](auto const& a, auto const& b) {
-                                  return a.same_as(b);
-                              }).base()));
+        /**
+         * Remove the cookies that were made the same as a newer one (by changing their names, domains or
+         * paths); the newer ones are kept, and the order of the rest doesn't change.
+         */
+        void remove_duplicates() {
+            ensure_index();
+            stl::vector<bool> removed(super::size(), false);
+            for (stl::size_t pos = super::size(); pos-- > 0;) {
+                if (removed[pos])
+                    continue;
+                auto const& cookie = super::operator[](pos);
+                for_each_candidate(cookie.name(), [&](stl::size_t other) {
+                    if (other < pos && is_same(super::operator[](other), cookie))
+                        removed[other] = true;
+                    return false;
+                });
+            }
+            stl::size_t kept = 0;
+            for (stl::size_t pos = 0; pos < super::size(); pos++) {
+                if (removed[pos])
+                    continue;
+                if (kept != pos)
+                    super::operator[](kept) = stl::move(super::operator[](pos));
+                kept++;
+            }
+            super::erase(super::begin() + static_cast<difference_type>(kept), super::end());
+            indexed = false;
         }
     };
 
@@ -132,19 +324,14 @@ namespace webpp {
 
 
         typename super::iterator remove_const(typename super::const_iterator const& citer) noexcept {
-            if (citer == super::cend())
-                return super::end();
-            auto it = super::begin();
-            stl::advance(it, stl::distance(it, citer.base()));
-            return it;
+            return super::begin() + (citer - super::cbegin());
         }
 
+        // the reverse iterators point to the one before their base
         typename super::iterator remove_const(typename super::const_reverse_iterator const& citer) noexcept {
-            if (citer == super::rcend())
+            if (citer == super::crend())
                 return super::end();
-            auto it = super::begin();
-            stl::advance(it, stl::distance(it, citer.base()));
-            return it;
+            return super::begin() + (stl::prev(citer.base()) - super::cbegin());
         }
 
         typename super::iterator remove_const(typename super::iterator& iter) noexcept {
@@ -154,9 +341,7 @@ namespace webpp {
         typename super::iterator remove_const(typename super::reverse_iterator& iter) noexcept {
             if (iter == super::rend())
                 return super::end();
-            auto it = super::begin();
-            stl::advance(it, stl::distance(it, iter.base()));
-            return it;
+            return stl::prev(iter.base());
         }
 
       public:
@@ -0,0 +1,300 @@
+#ifndef WEBPP_HTTP_EVENT_STREAM_H
+#define WEBPP_HTTP_EVENT_STREAM_H
+
+#include "../std/std.hpp"
+#include "./interfaces/common/connection.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Server-Sent Events (the text/event-stream of the HTML spec). The clients
+ * subscribe to a channel by asking for a response whose body is the channel
+ * (see event_stream_body), and each event that's published to the channel is
+ * serialized once, and the same bytes are queued to all the subscribers:
+ *
+ *   auto news = stl::make_shared<event_channel>();
+ *   ...
+ *   res.body = event_stream_body::type<traits_type>{news}; // in the route
+ *   ...
+ *   news->publish({.data = "hello", .event = "greeting"}); // from any thread
+ *
+ * The events are delivered on the threads of the connections; a subscriber
+ * that doesn't read them fast enough is dropped (the browsers reconnect).
+ * The idle timeout of the connections still applies, so publish a heartbeat
+ * more often than that if the events are rare.
+ */
+namespace webpp {
+
+    struct sse_event {
+        stl::string_view          data{};
+        stl::string_view          event{}; // the type; the clients see "message" if it's empty
+        stl::string_view          id{};    // the client sends it back in Last-Event-ID when it reconnects
+        stl::chrono::milliseconds retry{0}; // the reconnection time; not sent if it's zero
+    };
+
+    namespace details {
+        // the fields can't have line breaks; what's after the first one is dropped
+        [[nodiscard]] constexpr stl::string_view first_line(stl::string_view value) noexcept {
+            return value.substr(0, value.find_first_of("\r\n"));
+        }
+    } // namespace details
+
+    /**
+     * Append the event; each line of the data is a "data:" field, which the
+     * clients put back together with "\n".
+     */
+    template <typename StrT>
+    constexpr void write_event(StrT& out, sse_event const& event) {
+        if (!event.event.empty())
+            out.append("event: ").append(details::first_line(event.event)).append("\n");
+        if (!event.id.empty())
+            out.append("id: ").append(details::first_line(event.id)).append("\n");
+        if (event.retry.count() > 0) {
+            stl::array<char, 24> retry{};
+            auto const end = stl::to_chars(retry.data(), retry.data() + retry.size(), event.retry.count()).ptr;
+            out.append("retry: ").append(retry.data(), static_cast<stl::size_t>(end - retry.data())).append("\n");
+        }
+        auto data = event.data;
+        for (;;) {
+            auto const end = data.find_first_of("\r\n");
+            out.append("data: ").append(data.substr(0, end)).append("\n");
+            if (end == stl::string_view::npos)
+                break;
+            data.remove_prefix(end + (data.substr(end, 2) == "\r\n" ? 2 : 1));
+        }
+        out.append("\n");
+    }
+
+    /**
+     * Append a comment; the clients ignore them, they keep the connections
+     * (and the proxies in between) from timing out.
+     */
+    template <typename StrT>
+    constexpr void write_event_comment(StrT& out, stl::string_view text = {}) {
+        out.append(":").append(details::first_line(text)).append("\n\n");
+    }
+
+    struct event_channel_options {
+        // the subscribers that have this many writes waiting are too slow; they're dropped
+        stl::size_t max_backlog = 1024;
+    };
+
+    namespace details {
+
+        /**
+         * An event that's serialized once for all the subscribers; it's framed
+         * as a chunk, and the HTTP/1.0 subscribers are sent what's inside the
+         * framing.
+         */
+        struct event_buffer {
+            stl::string bytes;
+            stl::size_t head_size = 0; // "size in hex\r\n"
+
+            explicit event_buffer(stl::string_view event) {
+                stl::array<char, 16> size{};
+                auto const end = stl::to_chars(size.data(), size.data() + size.size(), event.size(), 16).ptr;
+                head_size      = static_cast<stl::size_t>(end - size.data()) + 2;
+                bytes.reserve(head_size + event.size() + 2);
+                bytes.append(size.data(), end).append("\r\n").append(event).append("\r\n");
+            }
+
+            [[nodiscard]] stl::string_view view(bool chunked) const noexcept {
+                if (chunked)
+                    return bytes;
+                return stl::string_view{bytes}.substr(head_size, bytes.size() - head_size - 2);
+            }
+        };
+
+        struct event_subscriber {
+            common::connection* conn;
+            bool                chunked;
+        };
+
+        /**
+         * The subscribers that live on one worker thread; the list is only
+         * touched on that thread, so an event is one post per thread and not
+         * one per subscriber.
+         */
+        struct event_group {
+            using executor_type = common::connection::executor_type;
+
+            executor_type                 executor;
+            stl::size_t                   max_backlog;
+            stl::vector<event_subscriber> subscribers{};
+            stl::atomic<stl::size_t>      count{0};
+
+            event_group(executor_type _executor, stl::size_t _max_backlog) noexcept
+              : executor{stl::move(_executor)},
+                max_backlog{_max_backlog} {}
+
+            void add(common::connection& conn, bool chunked) {
+                subscribers.push_back({&conn, chunked});
+                count.store(subscribers.size(), stl::memory_order_relaxed);
+            }
+
+            void remove(common::connection* conn) noexcept {
+                auto const it = stl::find_if(subscribers.begin(), subscribers.end(), [=](auto const& sub) noexcept {
+                    return sub.conn == conn;
+                });
+                if (it == subscribers.end())
+                    return;
+                *it = subscribers.back();
+                subscribers.pop_back();
+                count.store(subscribers.size(), stl::memory_order_relaxed);
+            }
+
+            void deliver(stl::shared_ptr<event_buffer const> const& event) {
+                stl::vector<common::connection*> slow;
+                for (auto const& sub : subscribers) {
+                    if (sub.conn->queued_count() >= max_backlog) {
+                        slow.push_back(sub.conn);
+                        continue;
+                    }
+                    sub.conn->send(event->view(sub.chunked), event);
+                }
+                // they're removed by their close handlers
+                for (auto* conn : slow)
+                    conn->stop();
+            }
+
+            // the channel is closed; end the streams
+            void end() {
+                auto const ended = stl::move(subscribers);
+                subscribers.clear();
+                count.store(0, stl::memory_order_relaxed);
+                for (auto const& sub : ended) {
+                    if (sub.chunked)
+                        sub.conn->send(stl::string{"0\r\n\r\n"});
+                    sub.conn->close_after_write();
+                }
+            }
+        };
+
+    } // namespace details
+
+    /**
+     * The subscribers of a stream of events; it's thread-safe, and it's
+     * shared (by the bodies of the responses that subscribe to it).
+     */
+    class event_channel {
+        using group_ptr = stl::shared_ptr<details::event_group>;
+
+        mutable stl::mutex     lock;
+        stl::vector<group_ptr> groups;
+        event_channel_options  options;
+        bool                   closed = false;
+
+        void broadcast(stl::shared_ptr<details::event_buffer const> event) {
+            stl::lock_guard const guard{lock};
+            if (closed)
+                return;
+            for (auto const& group : groups) {
+                if (group->count.load(stl::memory_order_relaxed) == 0)
+                    continue;
+                stl::net::post(group->executor, [group, event] {
+                    group->deliver(event);
+                });
+            }
+        }
+
+      public:
+        explicit event_channel(event_channel_options const& _options = {}) noexcept : options{_options} {}
+        event_channel(event_channel const&) = delete;
+        event_channel& operator=(event_channel const&) = delete;
+
+        ~event_channel() noexcept {
+            close();
+        }
+
+        /**
+         * Send the event to all the subscribers; it's serialized here, once.
+         */
+        void publish(sse_event const& event) {
+            stl::string bytes;
+            write_event(bytes, event);
+            broadcast(stl::make_shared<details::event_buffer const>(bytes));
+        }
+
+        /**
+         * Send a comment to all the subscribers, to keep the idle connections
+         * open
+         */
+        void heartbeat(stl::string_view text = {}) {
+            stl::string bytes;
+            write_event_comment(bytes, text);
+            broadcast(stl::make_shared<details::event_buffer const>(bytes));
+        }
+
+        /**
+         * Add the connection whose response head is sent; it's called on the
+         * connection's thread (by the interface), and the connection leaves
+         * the channel when it's closed. The chunked ones have each event
+         * framed as a chunk.
+         */
+        void subscribe(common::connection& conn, bool chunked) {
+            group_ptr group;
+            {
+                stl::lock_guard const guard{lock};
+                if (!closed) {
+                    auto const executor = conn.get_executor();
+                    auto const it = stl::find_if(groups.begin(), groups.end(), [&](auto const& g) noexcept {
+                        return g->executor == executor;
+                    });
+                    group = it != groups.end()
+                              ? *it
+                              : groups.emplace_back(stl::make_shared<details::event_group>(executor,
+                                                                                           options.max_backlog));
+                }
+            }
+            if (!group) {
+                if (chunked)
+                    conn.send(stl::string{"0\r\n\r\n"});
+                conn.close_after_write();
+                return;
+            }
+            group->add(conn, chunked);
+            conn.on_closed([group, ptr = &conn] {
+                group->remove(ptr);
+            });
+        }
+
+        /**
+         * End the streams of all the subscribers; nothing is published after this.
+         */
+        void close() noexcept {
+            stl::lock_guard const guard{lock};
+            if (closed)
+                return;
+            closed = true;
+            for (auto const& group : groups) {
+                stl::net::post(group->executor, [group] {
+                    group->end();
+                });
+            }
+            groups.clear();
+        }
+
+        /**
+         * The number of the subscribers
+         */
+        [[nodiscard]] stl::size_t size() const noexcept {
+            stl::lock_guard const guard{lock};
+            stl::size_t           res = 0;
+            for (auto const& group : groups)
+                res += group->count.load(stl::memory_order_relaxed);
+            return res;
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_HTTP_EVENT_STREAM_H
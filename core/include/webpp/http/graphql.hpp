@@ -0,0 +1,2174 @@
+#ifndef WEBPP_HTTP_GRAPHQL_H
+#define WEBPP_HTTP_GRAPHQL_H
+
+#include "../cache/lru_cache.hpp"
+#include "../cache/sharded_cache.hpp"
+#include "../std/std.hpp"
+#include "../utils/json.hpp"
+#include "../utils/sha256.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+/**
+ * GraphQL (the October 2021 spec): the queries are parsed into a flat AST
+ * (the nodes are in arrays and point at each other by their indexes, and the
+ * names are offsets into one copy of the query), checked against a schema,
+ * and kept as plans; the next requests with the same query, or with the same
+ * persisted hash, go straight to the execution.
+ *
+ * The execution goes one level of the response at a time: all the fields of
+ * the level are resolved before the next level, so a field with a batch
+ * resolver is called once for all its occurrences in the level (the authors
+ * of all the posts, the users of all the "user(id: ...)" fields), instead of
+ * once for each of them (the N+1 calls).
+ *
+ * The schema has the object types, the scalars, and the enums; the
+ * interfaces, the unions, the input objects, the subscriptions, and the
+ * introspection (other than __typename) are not there yet.
+ *
+ *   graphql::schema schema;
+ *   schema.query().field("post", "Post", [](graphql::resolve_info const& info) {...}).argument("id", "ID!");
+ *   schema.object("Post").field("title", "String!");
+ *   schema.object("Post").batch_field("author", "User", [](graphql::batch_info const& info) {...});
+ *   graphql::service service{std::move(schema)};
+ *   auto const res = service.execute({.query = "{ post(id: 1) { title author { name } } }"});
+ */
+namespace webpp::graphql {
+
+    class value;
+
+    using list   = stl::vector<value>;
+    using object = stl::vector<stl::pair<stl::string, value>>; // the members, in their order
+
+    enum struct value_kind : stl::uint8_t { null, boolean, integer, floating, string, list, object };
+
+    /**
+     * The values of the arguments and of the variables, what the resolvers
+     * return, and the response.
+     */
+    class value {
+        stl::variant<stl::nullptr_t, bool, stl::int64_t, double, stl::string, list, object> data{};
+
+      public:
+        value() noexcept = default;
+        value(stl::nullptr_t) noexcept {}
+        value(bool val) noexcept : data{val} {}
+
+        template <typename T>
+        requires(stl::is_integral_v<T> && !stl::same_as<T, bool> && !stl::same_as<T, char>)
+        value(T val) noexcept : data{static_cast<stl::int64_t>(val)} {}
+
+        value(double val) noexcept : data{val} {}
+        value(char const* str) : data{stl::string{str}} {}
+        value(stl::string_view str) : data{stl::string{str}} {}
+        value(stl::string str) noexcept : data{stl::move(str)} {}
+        value(list items) noexcept : data{stl::move(items)} {}
+        value(object members) noexcept : data{stl::move(members)} {}
+
+        [[nodiscard]] value_kind kind() const noexcept {
+            return static_cast<value_kind>(data.index());
+        }
+
+        [[nodiscard]] bool is_null() const noexcept {
+            return kind() == value_kind::null;
+        }
+
+        [[nodiscard]] bool as_bool() const noexcept {
+            auto const* val = stl::get_if<bool>(&data);
+            return val != nullptr && *val;
+        }
+
+        [[nodiscard]] stl::int64_t as_int() const noexcept {
+            auto const* val = stl::get_if<stl::int64_t>(&data);
+            return val != nullptr ? *val : 0;
+        }
+
+        [[nodiscard]] double as_float() const noexcept {
+            if (auto const* val = stl::get_if<double>(&data))
+                return *val;
+            return static_cast<double>(as_int());
+        }
+
+        [[nodiscard]] stl::string_view as_string() const noexcept {
+            auto const* val = stl::get_if<stl::string>(&data);
+            return val != nullptr ? stl::string_view{*val} : stl::string_view{};
+        }
+
+        [[nodiscard]] list const* as_list() const noexcept {
+            return stl::get_if<list>(&data);
+        }
+
+        [[nodiscard]] list* as_list() noexcept {
+            return stl::get_if<list>(&data);
+        }
+
+        [[nodiscard]] object const* as_object() const noexcept {
+            return stl::get_if<object>(&data);
+        }
+
+        [[nodiscard]] object* as_object() noexcept {
+            return stl::get_if<object>(&data);
+        }
+
+        /**
+         * The member of the object; null if it's not an object, or it's not there
+         */
+        [[nodiscard]] value const* find(stl::string_view name) const noexcept {
+            if (auto const* members = as_object())
+                for (auto const& [key, member] : *members)
+                    if (key == name)
+                        return &member;
+            return nullptr;
+        }
+
+        [[nodiscard]] bool operator==(value const&) const = default;
+
+        template <typename StringType>
+        void to_json(json::writer<StringType>& out) const {
+            switch (kind()) {
+                case value_kind::null: out.value(nullptr); break;
+                case value_kind::boolean: out.value(stl::get<bool>(data)); break;
+                case value_kind::integer: out.value(stl::get<stl::int64_t>(data)); break;
+                case value_kind::floating: out.value(stl::get<double>(data)); break;
+                case value_kind::string: out.value(stl::get<stl::string>(data)); break;
+                case value_kind::list:
+                    out.begin_array();
+                    for (auto const& item : stl::get<list>(data))
+                        item.to_json(out);
+                    out.end_array();
+                    break;
+                case value_kind::object:
+                    out.begin_object();
+                    for (auto const& [key, member] : stl::get<object>(data)) {
+                        out.key(key);
+                        member.to_json(out);
+                    }
+                    out.end_object();
+                    break;
+            }
+        }
+    };
+
+    /**
+     * The value of a JSON element (the variables of a request)
+     */
+    [[nodiscard]] inline value from_json(json::element elem) {
+        switch (elem.kind()) {
+            case json::kind::object: {
+                object members;
+                elem.for_each_member([&members](stl::string_view name, json::element member) {
+                    members.emplace_back(stl::string{name}, from_json(member));
+                    return true;
+                });
+                return members;
+            }
+            case json::kind::array: {
+                list items;
+                elem.for_each([&items](json::element item) {
+                    items.push_back(from_json(item));
+                    return true;
+                });
+                return items;
+            }
+            case json::kind::string: {
+                stl::string str;
+                static_cast<void>(elem.string_value(str));
+                return str;
+            }
+            case json::kind::number: {
+                stl::int64_t integer = 0;
+                if (elem.number_value(integer))
+                    return integer;
+                double floating = 0;
+                static_cast<void>(elem.number_value(floating));
+                return floating;
+            }
+            case json::kind::boolean: {
+                bool boolean = false;
+                static_cast<void>(elem.bool_value(boolean));
+                return boolean;
+            }
+            default: return {};
+        }
+    }
+
+    struct error {
+        stl::string   message;
+        stl::uint32_t line   = 0; // in the query, from 1; 0 if it's not about a place in the query
+        stl::uint32_t column = 0;
+        list          path{};     // the response keys and the list indexes down to the field
+        stl::string   code{};     // the "code" of the "extensions", if it has one
+
+        template <typename StringType>
+        void to_json(json::writer<StringType>& out) const {
+            out.begin_object().member("message", message);
+            if (line != 0) {
+                out.key("locations").begin_array().begin_object();
+                out.member("line", line).member("column", column);
+                out.end_object().end_array();
+            }
+            if (!path.empty()) {
+                out.key("path");
+                value{path}.to_json(out);
+            }
+            if (!code.empty())
+                out.key("extensions").begin_object().member("code", code).end_object();
+            out.end_object();
+        }
+    };
+
+    /**
+     * The response of a request: the data (if the execution has started),
+     * and the errors.
+     */
+    struct response {
+        value              data{};
+        bool               has_data = false;
+        stl::vector<error> errors{};
+
+        template <typename StringType>
+        void to_json(json::writer<StringType>& out) const {
+            out.begin_object();
+            if (!errors.empty())
+                out.member("errors", errors);
+            if (has_data) {
+                out.key("data");
+                data.to_json(out);
+            }
+            out.end_object();
+        }
+    };
+
+    /**
+     * The types are written as they're in the schema language: "[Post!]!"
+     */
+    namespace types {
+        [[nodiscard]] constexpr bool is_non_null(stl::string_view type) noexcept {
+            return type.ends_with('!');
+        }
+
+        [[nodiscard]] constexpr stl::string_view nullable(stl::string_view type) noexcept {
+            return is_non_null(type) ? type.substr(0, type.size() - 1) : type;
+        }
+
+        [[nodiscard]] constexpr bool is_list(stl::string_view type) noexcept {
+            return nullable(type).starts_with('[');
+        }
+
+        // the type of the items of a list type
+        [[nodiscard]] constexpr stl::string_view item(stl::string_view type) noexcept {
+            auto const list_type = nullable(type);
+            return list_type.substr(1, list_type.size() - 2);
+        }
+
+        // the name in it, without the lists and the "!"s
+        [[nodiscard]] constexpr stl::string_view named(stl::string_view type) noexcept {
+            auto const start = type.find_first_not_of('[');
+            if (start == stl::string_view::npos)
+                return {};
+            auto const end = type.find_first_of("]!", start);
+            return type.substr(start, end == stl::string_view::npos ? stl::string_view::npos : end - start);
+        }
+    } // namespace types
+
+    /**
+     * What a resolver gets: the value of the parent object (what the resolver
+     * of the parent field returned), the arguments, and the context that's
+     * given to the execution (the route gives its context).
+     */
+    struct resolve_info {
+        value const&  parent;
+        object const& args;
+        void*         context;
+        stl::string*  failure;
+
+        [[nodiscard]] value const* arg(stl::string_view name) const noexcept {
+            for (auto const& [key, val] : args)
+                if (key == name)
+                    return &val;
+            return nullptr;
+        }
+
+        template <typename T>
+        [[nodiscard]] T& context_as() const noexcept {
+            return *static_cast<T*>(context);
+        }
+
+        /**
+         * The field is null, and the error is in the response
+         */
+        void fail(stl::string message) const {
+            *failure = stl::move(message);
+        }
+    };
+
+    struct batch_item {
+        value const*  parent;
+        object const* args;
+
+        [[nodiscard]] value const* arg(stl::string_view name) const noexcept {
+            for (auto const& [key, val] : *args)
+                if (key == name)
+                    return &val;
+            return nullptr;
+        }
+    };
+
+    /**
+     * What a batch resolver gets: all the occurrences of its field in one
+     * level of the response; it returns one value for each item, in their
+     * order.
+     */
+    struct batch_info {
+        stl::span<batch_item const>                          items;
+        void*                                                context;
+        stl::vector<stl::pair<stl::size_t, stl::string>>*   failures;
+
+        template <typename T>
+        [[nodiscard]] T& context_as() const noexcept {
+            return *static_cast<T*>(context);
+        }
+
+        /**
+         * The field of the item is null, and the error is in the response
+         */
+        void fail(stl::size_t item, stl::string message) const {
+            failures->emplace_back(item, stl::move(message));
+        }
+    };
+
+    using resolver       = stl::function<value(resolve_info const&)>;
+    using batch_resolver = stl::function<list(batch_info const&)>;
+
+    struct argument_definition {
+        stl::string          name;
+        stl::string          type;
+        stl::optional<value> default_value{};
+    };
+
+    /**
+     * A field of an object type; if it has no resolver, it's the member of
+     * the parent object with its name.
+     */
+    struct field_definition {
+        stl::string                      name;
+        stl::string                      type;
+        stl::vector<argument_definition> arguments{};
+        resolver                         resolve{};
+        batch_resolver                   resolve_batch{};
+
+        field_definition& argument(stl::string arg_name, stl::string arg_type,
+                                   stl::optional<value> default_value = stl::nullopt) {
+            arguments.push_back({stl::move(arg_name), stl::move(arg_type), stl::move(default_value)});
+            return *this;
+        }
+
+        [[nodiscard]] argument_definition const* find_argument(stl::string_view arg_name) const noexcept {
+            for (auto const& arg : arguments)
+                if (arg.name == arg_name)
+                    return &arg;
+            return nullptr;
+        }
+    };
+
+    class object_type {
+        stl::string                  type_name;
+        stl::deque<field_definition> fields{}; // the plans point to them
+
+      public:
+        explicit object_type(stl::string name) noexcept : type_name{stl::move(name)} {}
+
+        [[nodiscard]] stl::string_view name() const noexcept {
+            return type_name;
+        }
+
+        field_definition& field(stl::string field_name, stl::string type, resolver resolve = {}) {
+            return fields.emplace_back(
+              field_definition{.name = stl::move(field_name), .type = stl::move(type), .resolve = stl::move(resolve)});
+        }
+
+        /**
+         * A field that's resolved for all its occurrences in a level at once
+         */
+        field_definition& batch_field(stl::string field_name, stl::string type, batch_resolver resolve) {
+            return fields.emplace_back(field_definition{.name          = stl::move(field_name),
+                                                        .type          = stl::move(type),
+                                                        .resolve_batch = stl::move(resolve)});
+        }
+
+        [[nodiscard]] field_definition const* find(stl::string_view field_name) const noexcept {
+            for (auto const& def : fields)
+                if (def.name == field_name)
+                    return &def;
+            return nullptr;
+        }
+    };
+
+    /**
+     * The types; "Query" is the root of the queries, and "Mutation" of the
+     * mutations. Int, Float, String, Boolean, and ID are there already.
+     */
+    class schema {
+        stl::deque<object_type>                                      objects{};
+        stl::vector<stl::string>                                     scalars{"Int", "Float", "String", "Boolean", "ID"};
+        stl::vector<stl::pair<stl::string, stl::vector<stl::string>>> enums{};
+
+      public:
+        object_type& object(stl::string_view name) {
+            for (auto& type : objects)
+                if (type.name() == name)
+                    return type;
+            return objects.emplace_back(stl::string{name});
+        }
+
+        object_type& query() {
+            return object("Query");
+        }
+
+        object_type& mutation() {
+            return object("Mutation");
+        }
+
+        /**
+         * A custom scalar; its values are given to the resolvers, and taken
+         * from them, as they are
+         */
+        schema& scalar(stl::string name) {
+            scalars.push_back(stl::move(name));
+            return *this;
+        }
+
+        schema& enumeration(stl::string name, stl::vector<stl::string> values) {
+            enums.emplace_back(stl::move(name), stl::move(values));
+            return *this;
+        }
+
+        [[nodiscard]] object_type const* find_object(stl::string_view name) const noexcept {
+            for (auto const& type : objects)
+                if (type.name() == name)
+                    return &type;
+            return nullptr;
+        }
+
+        [[nodiscard]] bool is_scalar(stl::string_view name) const noexcept {
+            return stl::find(scalars.begin(), scalars.end(), name) != scalars.end();
+        }
+
+        [[nodiscard]] stl::vector<stl::string> const* find_enum(stl::string_view name) const noexcept {
+            for (auto const& [enum_name, values] : enums)
+                if (enum_name == name)
+                    return &values;
+            return nullptr;
+        }
+    };
+
+    enum struct operation_type : stl::uint8_t { query, mutation, subscription };
+
+    struct plan_limits {
+        stl::size_t max_depth      = 24;     // of the selection sets
+        stl::size_t max_selections = 10'000; // in the query, with its fragments spread
+    };
+
+    namespace details {
+
+        static constexpr stl::uint32_t no_index = 0xFFFF'FFFFu;
+
+        // a part of the source of the document
+        struct text {
+            stl::uint32_t offset = 0;
+            stl::uint32_t size   = 0;
+        };
+
+        struct range {
+            stl::uint32_t first = 0;
+            stl::uint32_t count = 0;
+        };
+
+        enum struct literal_kind : stl::uint8_t {
+            variable,
+            integer,
+            floating,
+            string,
+            boolean,
+            null,
+            enumeration,
+            list,  // the items are in the literals
+            object // the fields are in the arguments
+        };
+
+        struct literal {
+            literal_kind kind = literal_kind::null;
+            text         str{};
+            range        items{};
+        };
+
+        struct argument {
+            text          name{};
+            stl::uint32_t value = no_index; // the literal
+            stl::uint32_t at    = 0;
+        };
+
+        struct directive {
+            text          name{};
+            range         arguments{};
+            stl::uint32_t at = 0;
+        };
+
+        enum struct selection_kind : stl::uint8_t { field, fragment_spread, inline_fragment };
+
+        struct selection {
+            selection_kind kind = selection_kind::field;
+            text           name{};  // of the field, of the fragment, or the type condition
+            text           alias{};
+            range          arguments{};
+            range          directives{};
+            range          children{}; // the selections of the fragment, for the spreads (after the validation)
+            stl::uint32_t  at = 0;
+        };
+
+        struct variable_definition {
+            text          name{};
+            text          type{}; // without the spaces
+            stl::uint32_t default_value = no_index;
+            stl::uint32_t at            = 0;
+        };
+
+        struct operation_definition {
+            operation_type type = operation_type::query;
+            text           name{};
+            range          variables{};
+            range          selections{};
+            stl::uint32_t  at = 0;
+        };
+
+        struct fragment_definition {
+            text          name{};
+            text          type_condition{};
+            range         selections{};
+            stl::uint32_t at = 0;
+        };
+
+        /**
+         * The AST of a query; the nodes point at each other by their indexes,
+         * and the items of a list are next to each other.
+         */
+        struct document {
+            stl::string                       source{}; // the query, and the unescaped strings after it
+            stl::size_t                       query_size = 0;
+            stl::vector<operation_definition> operations{};
+            stl::vector<fragment_definition>  fragments{};
+            stl::vector<variable_definition>  variables{};
+            stl::vector<selection>            selections{};
+            stl::vector<argument>             arguments{};
+            stl::vector<directive>            directives{};
+            stl::vector<literal>              literals{};
+
+            [[nodiscard]] stl::string_view str(text part) const noexcept {
+                return stl::string_view{source}.substr(part.offset, part.size);
+            }
+
+            [[nodiscard]] stl::string_view response_key(selection const& sel) const noexcept {
+                return str(sel.alias.size != 0 ? sel.alias : sel.name);
+            }
+
+            [[nodiscard]] error error_at(stl::uint32_t at, stl::string message) const {
+                error err{.message = stl::move(message), .line = 1, .column = 1};
+                for (stl::size_t i = 0; i < at && i < query_size; i++) {
+                    if (source[i] == '\n' || (source[i] == '\r' && (i + 1 == query_size || source[i + 1] != '\n'))) {
+                        err.line++;
+                        err.column = 1;
+                    } else {
+                        err.column++;
+                    }
+                }
+                return err;
+            }
+        };
+
+        [[nodiscard]] constexpr bool is_name_start(char c) noexcept {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+        }
+
+        [[nodiscard]] constexpr bool is_name_char(char c) noexcept {
+            return is_name_start(c) || (c >= '0' && c <= '9');
+        }
+
+        [[nodiscard]] constexpr bool is_digit(char c) noexcept {
+            return c >= '0' && c <= '9';
+        }
+
+        template <typename StringType>
+        constexpr void append_utf8(StringType& out, stl::uint32_t code) {
+            if (code < 0x80u) {
+                out.push_back(static_cast<char>(code));
+            } else if (code < 0x800u) {
+                out.push_back(static_cast<char>(0xC0u | (code >> 6u)));
+                out.push_back(static_cast<char>(0x80u | (code & 0x3Fu)));
+            } else if (code < 0x10000u) {
+                out.push_back(static_cast<char>(0xE0u | (code >> 12u)));
+                out.push_back(static_cast<char>(0x80u | ((code >> 6u) & 0x3Fu)));
+                out.push_back(static_cast<char>(0x80u | (code & 0x3Fu)));
+            } else {
+                out.push_back(static_cast<char>(0xF0u | (code >> 18u)));
+                out.push_back(static_cast<char>(0x80u | ((code >> 12u) & 0x3Fu)));
+                out.push_back(static_cast<char>(0x80u | ((code >> 6u) & 0x3Fu)));
+                out.push_back(static_cast<char>(0x80u | (code & 0x3Fu)));
+            }
+        }
+
+        /**
+         * A recursive descent parser of the executable documents; it stops at
+         * the first error. The strings without escapes are not copied.
+         */
+        class parser {
+            document&   doc;
+            stl::size_t end;
+            stl::size_t max_depth;
+            stl::size_t pos   = 0;
+            stl::size_t depth = 0;
+
+          public:
+            stl::string   message{}; // the error
+            stl::uint32_t failed_at = 0;
+
+          private:
+            [[nodiscard]] char peek(stl::size_t ahead = 0) const noexcept {
+                return pos + ahead < end ? doc.source[pos + ahead] : '\0';
+            }
+
+            void skip_ignored() noexcept {
+                while (pos < end) {
+                    auto const c = doc.source[pos];
+                    if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',') {
+                        pos++;
+                    } else if (c == '#') {
+                        while (pos < end && doc.source[pos] != '\n' && doc.source[pos] != '\r')
+                            pos++;
+                    } else if (doc.source.compare(pos, 3, "\xEF\xBB\xBF") == 0) {
+                        pos += 3;
+                    } else {
+                        break;
+                    }
+                }
+            }
+
+            bool fail(stl::string_view what) {
+                if (message.empty()) {
+                    message.assign(what);
+                    failed_at = static_cast<stl::uint32_t>(pos);
+                }
+                return false;
+            }
+
+            bool take(char c) noexcept {
+                skip_ignored();
+                if (peek() != c)
+                    return false;
+                pos++;
+                return true;
+            }
+
+            bool expect(char c) {
+                if (take(c))
+                    return true;
+                stl::string what{"expected \""};
+                what += c;
+                what += '"';
+                return fail(what);
+            }
+
+            [[nodiscard]] bool at_keyword(stl::string_view word) noexcept {
+                skip_ignored();
+                return doc.source.compare(pos, word.size(), word) == 0 && pos + word.size() <= end &&
+                       !is_name_char(peek(word.size()));
+            }
+
+            bool name(text& out) {
+                skip_ignored();
+                if (!is_name_start(peek()))
+                    return fail("expected a name");
+                auto const start = pos;
+                while (pos < end && is_name_char(doc.source[pos]))
+                    pos++;
+                out = {static_cast<stl::uint32_t>(start), static_cast<stl::uint32_t>(pos - start)};
+                return true;
+            }
+
+            text append(stl::string_view str) {
+                text const res{static_cast<stl::uint32_t>(doc.source.size()), static_cast<stl::uint32_t>(str.size())};
+                doc.source.append(str);
+                return res;
+            }
+
+            template <typename T>
+            range append_all(stl::vector<T>& to, stl::vector<T> const& items) {
+                range const res{static_cast<stl::uint32_t>(to.size()), static_cast<stl::uint32_t>(items.size())};
+                to.insert(to.end(), items.begin(), items.end());
+                return res;
+            }
+
+            bool deeper() {
+                if (++depth > max_depth)
+                    return fail("the query is nested too deep");
+                return true;
+            }
+
+            bool type_into(stl::string& out) {
+                if (!deeper())
+                    return false;
+                if (take('[')) {
+                    out += '[';
+                    if (!type_into(out) || !expect(']'))
+                        return false;
+                    out += ']';
+                } else {
+                    text type_name;
+                    if (!name(type_name))
+                        return false;
+                    out += doc.str(type_name);
+                }
+                if (take('!'))
+                    out += '!';
+                depth--;
+                return true;
+            }
+
+            bool type(text& out) {
+                skip_ignored();
+                auto const  start = pos;
+                stl::string normalized;
+                if (!type_into(normalized))
+                    return false;
+                if (doc.str({static_cast<stl::uint32_t>(start), static_cast<stl::uint32_t>(pos - start)}) ==
+                    normalized) {
+                    out = {static_cast<stl::uint32_t>(start), static_cast<stl::uint32_t>(pos - start)};
+                } else {
+                    out = append(normalized);
+                }
+                return true;
+            }
+
+            bool unescape(stl::string_view raw, stl::string& out) {
+                for (stl::size_t i = 0; i < raw.size(); i++) {
+                    if (raw[i] != '\\') {
+                        out.push_back(raw[i]);
+                        continue;
+                    }
+                    switch (raw[++i]) {
+                        case '"': out.push_back('"'); break;
+                        case '\\': out.push_back('\\'); break;
+                        case '/': out.push_back('/'); break;
+                        case 'b': out.push_back('\b'); break;
+                        case 'f': out.push_back('\f'); break;
+                        case 'n': out.push_back('\n'); break;
+                        case 'r': out.push_back('\r'); break;
+                        case 't': out.push_back('\t'); break;
+                        case 'u': {
+                            auto const hex = [&](stl::size_t at, stl::uint32_t& code) {
+                                if (at + 4 > raw.size())
+                                    return false;
+                                auto const [ptr, ec] = stl::from_chars(raw.data() + at, raw.data() + at + 4, code, 16);
+                                return ec == stl::errc{} && ptr == raw.data() + at + 4;
+                            };
+                            stl::uint32_t code = 0;
+                            if (!hex(i + 1, code))
+                                return fail("the \\u escape of the string is not valid");
+                            i += 4;
+                            if (code >= 0xD800u && code <= 0xDBFFu) {
+                                stl::uint32_t low = 0;
+                                if (raw.substr(i + 1, 2) != "\\u" || !hex(i + 3, low) || low < 0xDC00u ||
+                                    low > 0xDFFFu)
+                                    return fail("the surrogate pair of the string is not complete");
+                                i += 6;
+                                code = 0x10000u + ((code - 0xD800u) << 10u) + (low - 0xDC00u);
+                            } else if (code >= 0xDC00u && code <= 0xDFFFu) {
+                                return fail("the surrogate pair of the string is not complete");
+                            }
+                            append_utf8(out, code);
+                            break;
+                        }
+                        default: return fail("the escape of the string is not valid");
+                    }
+                }
+                return true;
+            }
+
+            // the value of a block string: the common indentation and the blank lines around it are removed
+            static stl::string block_string(stl::string_view raw) {
+                stl::vector<stl::string_view> lines;
+                for (stl::size_t start = 0;;) {
+                    auto const brk = raw.find_first_of("\r\n", start);
+                    lines.push_back(raw.substr(start, brk == stl::string_view::npos ? brk : brk - start));
+                    if (brk == stl::string_view::npos)
+                        break;
+                    start = brk + (raw.substr(brk, 2) == "\r\n" ? 2 : 1);
+                }
+                auto indent = stl::string_view::npos;
+                for (stl::size_t i = 1; i < lines.size(); i++) {
+                    auto const first = lines[i].find_first_not_of(" \t");
+                    if (first != stl::string_view::npos)
+                        indent = stl::min(indent, first);
+                }
+                if (indent != stl::string_view::npos)
+                    for (stl::size_t i = 1; i < lines.size(); i++)
+                        lines[i].remove_prefix(stl::min(indent, lines[i].size()));
+                auto const blank = [](stl::string_view line) {
+                    return line.find_first_not_of(" \t") == stl::string_view::npos;
+                };
+                stl::size_t first = 0;
+                auto        last  = lines.size();
+                while (first < last && blank(lines[first]))
+                    first++;
+                while (last > first && blank(lines[last - 1]))
+                    last--;
+                stl::string res;
+                for (auto i = first; i < last; i++) {
+                    if (i != first)
+                        res.push_back('\n');
+                    res.append(lines[i]);
+                }
+                return res;
+            }
+
+            bool string_literal(literal& lit) {
+                lit.kind = literal_kind::string;
+                if (doc.source.compare(pos, 3, R"(""")") == 0 && pos + 3 <= end) {
+                    pos += 3;
+                    stl::string raw;
+                    for (;;) {
+                        if (pos >= end)
+                            return fail("the block string is not closed");
+                        if (doc.source.compare(pos, 3, R"(""")") == 0 && pos + 3 <= end) {
+                            pos += 3;
+                            break;
+                        }
+                        if (doc.source.compare(pos, 4, R"(\""")") == 0 && pos + 4 <= end) {
+                            raw.append(R"(""")");
+                            pos += 4;
+                            continue;
+                        }
+                        raw.push_back(doc.source[pos++]);
+                    }
+                    lit.str = append(block_string(raw));
+                    return true;
+                }
+                auto const start   = ++pos;
+                bool       escaped = false;
+                for (;; pos++) {
+                    if (pos >= end)
+                        return fail("the string is not closed");
+                    auto const c = doc.source[pos];
+                    if (c == '"')
+                        break;
+                    if (c == '\n' || c == '\r')
+                        return fail("the string is not closed before the end of the line");
+                    if (c == '\\') {
+                        escaped = true;
+                        pos++;
+                    }
+                }
+                text const raw{static_cast<stl::uint32_t>(start), static_cast<stl::uint32_t>(pos - start)};
+                pos++;
+                if (!escaped) {
+                    lit.str = raw;
+                    return true;
+                }
+                stl::string unescaped;
+                if (!unescape(stl::string{doc.str(raw)}, unescaped))
+                    return false;
+                lit.str = append(unescaped);
+                return true;
+            }
+
+            bool number_literal(literal& lit) {
+                auto const start = pos;
+                if (peek() == '-')
+                    pos++;
+                if (!is_digit(peek()))
+                    return fail("expected a number");
+                if (peek() == '0' && is_digit(peek(1)))
+                    return fail("a number can't start with a zero");
+                while (is_digit(peek()))
+                    pos++;
+                lit.kind = literal_kind::integer;
+                if (peek() == '.') {
+                    pos++;
+                    if (!is_digit(peek()))
+                        return fail("expected the fraction of the number");
+                    while (is_digit(peek()))
+                        pos++;
+                    lit.kind = literal_kind::floating;
+                }
+                if (peek() == 'e' || peek() == 'E') {
+                    pos++;
+                    if (peek() == '+' || peek() == '-')
+                        pos++;
+                    if (!is_digit(peek()))
+                        return fail("expected the exponent of the number");
+                    while (is_digit(peek()))
+                        pos++;
+                    lit.kind = literal_kind::floating;
+                }
+                if (is_name_start(peek()) || peek() == '.')
+                    return fail("a number can't be followed by a name or a dot");
+                lit.str = {static_cast<stl::uint32_t>(start), static_cast<stl::uint32_t>(pos - start)};
+                return true;
+            }
+
+            bool value_literal(literal& lit, bool constant) {
+                if (!deeper())
+                    return false;
+                skip_ignored();
+                auto const c = peek();
+                if (c == '$') {
+                    if (constant)
+                        return fail("a variable can't be used here");
+                    pos++;
+                    lit.kind = literal_kind::variable;
+                    if (!name(lit.str))
+                        return false;
+                } else if (c == '-' || is_digit(c)) {
+                    if (!number_literal(lit))
+                        return false;
+                } else if (c == '"') {
+                    if (!string_literal(lit))
+                        return false;
+                } else if (c == '[') {
+                    pos++;
+                    stl::vector<literal> items;
+                    while (!take(']')) {
+                        if (pos >= end)
+                            return fail("the list is not closed");
+                        literal item;
+                        if (!value_literal(item, constant))
+                            return false;
+                        items.push_back(item);
+                    }
+                    lit.kind  = literal_kind::list;
+                    lit.items = append_all(doc.literals, items);
+                } else if (c == '{') {
+                    pos++;
+                    stl::vector<argument> fields;
+                    while (!take('}')) {
+                        if (pos >= end)
+                            return fail("the object is not closed");
+                        argument field;
+                        field.at = static_cast<stl::uint32_t>(pos);
+                        literal field_value;
+                        if (!name(field.name) || !expect(':') || !value_literal(field_value, constant))
+                            return false;
+                        field.value = static_cast<stl::uint32_t>(doc.literals.size());
+                        doc.literals.push_back(field_value);
+                        fields.push_back(field);
+                    }
+                    lit.kind  = literal_kind::object;
+                    lit.items = append_all(doc.arguments, fields);
+                } else if (is_name_start(c)) {
+                    if (!name(lit.str))
+                        return false;
+                    auto const word = doc.str(lit.str);
+                    lit.kind        = word == "true" || word == "false" ? literal_kind::boolean
+                                      : word == "null"                  ? literal_kind::null
+                                                                        : literal_kind::enumeration;
+                } else {
+                    return fail("expected a value");
+                }
+                depth--;
+                return true;
+            }
+
+            bool arguments(range& out, bool constant) {
+                if (!expect('('))
+                    return false;
+                stl::vector<argument> items;
+                while (!take(')')) {
+                    if (pos >= end)
+                        return fail("expected \")\"");
+                    argument arg;
+                    skip_ignored();
+                    arg.at = static_cast<stl::uint32_t>(pos);
+                    literal arg_value;
+                    if (!name(arg.name) || !expect(':') || !value_literal(arg_value, constant))
+                        return false;
+                    arg.value = static_cast<stl::uint32_t>(doc.literals.size());
+                    doc.literals.push_back(arg_value);
+                    items.push_back(arg);
+                }
+                if (items.empty())
+                    return fail("the arguments can't be empty");
+                out = append_all(doc.arguments, items);
+                return true;
+            }
+
+            bool directives(range& out, bool constant) {
+                stl::vector<directive> items;
+                for (;;) {
+                    skip_ignored();
+                    auto const at = pos;
+                    if (!take('@'))
+                        break;
+                    directive item;
+                    item.at = static_cast<stl::uint32_t>(at);
+                    if (!name(item.name))
+                        return false;
+                    if (skip_ignored(), peek() == '(' && !arguments(item.arguments, constant))
+                        return false;
+                    items.push_back(item);
+                }
+                out = append_all(doc.directives, items);
+                return true;
+            }
+
+            bool selection_item(selection& item) {
+                skip_ignored();
+                item.at = static_cast<stl::uint32_t>(pos);
+                if (doc.source.compare(pos, 3, "...") == 0 && pos + 3 <= end) {
+                    pos += 3;
+                    if (at_keyword("on")) {
+                        pos += 2;
+                        item.kind = selection_kind::inline_fragment;
+                        return name(item.name) && directives(item.directives, false) &&
+                               selection_set(item.children);
+                    }
+                    if (skip_ignored(), is_name_start(peek())) {
+                        item.kind = selection_kind::fragment_spread;
+                        return name(item.name) && directives(item.directives, false);
+                    }
+                    item.kind = selection_kind::inline_fragment;
+                    return directives(item.directives, false) && selection_set(item.children);
+                }
+                item.kind = selection_kind::field;
+                if (!name(item.name))
+                    return false;
+                if (take(':')) {
+                    item.alias = item.name;
+                    if (!name(item.name))
+                        return false;
+                }
+                if (skip_ignored(), peek() == '(' && !arguments(item.arguments, false))
+                    return false;
+                if (!directives(item.directives, false))
+                    return false;
+                if (skip_ignored(), peek() == '{')
+                    return selection_set(item.children);
+                return true;
+            }
+
+            bool selection_set(range& out) {
+                if (!expect('{') || !deeper())
+                    return false;
+                stl::vector<selection> items;
+                while (!take('}')) {
+                    if (pos >= end)
+                        return fail("expected \"}\"");
+                    selection item;
+                    if (!selection_item(item))
+                        return false;
+                    items.push_back(item);
+                }
+                if (items.empty())
+                    return fail("the selection set can't be empty");
+                depth--;
+                out = append_all(doc.selections, items);
+                return true;
+            }
+
+            bool variable_definitions(range& out) {
+                stl::vector<variable_definition> items;
+                if (!take('('))
+                    return true;
+                while (!take(')')) {
+                    if (pos >= end)
+                        return fail("expected \")\"");
+                    variable_definition var;
+                    skip_ignored();
+                    var.at = static_cast<stl::uint32_t>(pos);
+                    range ignored_directives;
+                    if (!expect('$') || !name(var.name) || !expect(':') || !type(var.type))
+                        return false;
+                    if (take('=')) {
+                        literal default_value;
+                        if (!value_literal(default_value, true))
+                            return false;
+                        var.default_value = static_cast<stl::uint32_t>(doc.literals.size());
+                        doc.literals.push_back(default_value);
+                    }
+                    if (!directives(ignored_directives, true))
+                        return false;
+                    items.push_back(var);
+                }
+                if (items.empty())
+                    return fail("the variable definitions can't be empty");
+                out = append_all(doc.variables, items);
+                return true;
+            }
+
+            bool operation() {
+                operation_definition op;
+                skip_ignored();
+                op.at = static_cast<stl::uint32_t>(pos);
+                range ignored_directives;
+                if (peek() != '{') {
+                    if (at_keyword("query")) {
+                        pos += 5;
+                    } else if (at_keyword("mutation")) {
+                        op.type = operation_type::mutation;
+                        pos += 8;
+                    } else {
+                        op.type = operation_type::subscription;
+                        pos += 12;
+                    }
+                    if (skip_ignored(), is_name_start(peek()) && !name(op.name))
+                        return false;
+                    if (!variable_definitions(op.variables) || !directives(ignored_directives, false))
+                        return false;
+                }
+                if (!selection_set(op.selections))
+                    return false;
+                doc.operations.push_back(op);
+                return true;
+            }
+
+            bool fragment() {
+                fragment_definition frag;
+                skip_ignored();
+                frag.at = static_cast<stl::uint32_t>(pos);
+                pos += 8;
+                range ignored_directives;
+                if (!name(frag.name))
+                    return false;
+                if (doc.str(frag.name) == "on")
+                    return fail("a fragment can't be named \"on\"");
+                if (!at_keyword("on"))
+                    return fail("expected the type condition of the fragment");
+                pos += 2;
+                if (!name(frag.type_condition) || !directives(ignored_directives, false) ||
+                    !selection_set(frag.selections))
+                    return false;
+                doc.fragments.push_back(frag);
+                return true;
+            }
+
+          public:
+            parser(document& the_doc, stl::size_t the_max_depth) noexcept
+              : doc{the_doc},
+                end{the_doc.query_size},
+                max_depth{the_max_depth} {}
+
+            bool parse() {
+                skip_ignored();
+                if (pos >= end)
+                    return fail("the document is empty");
+                while (skip_ignored(), pos < end) {
+                    bool const parsed = peek() == '{' || at_keyword("query") || at_keyword("mutation") ||
+                                            at_keyword("subscription")
+                                          ? operation()
+                                        : at_keyword("fragment") ? fragment()
+                                                                 : fail("expected an operation or a fragment");
+                    if (!parsed)
+                        return false;
+                }
+                return true;
+            }
+        };
+
+        class validator;
+        class executor;
+
+    } // namespace details
+
+    /**
+     * A query that's parsed, and checked against the schema; it can be run as
+     * many times as needed, with other variables, from any thread. The
+     * fields point at their definitions in the schema, so the schema should
+     * outlive it.
+     */
+    class plan {
+        friend class details::validator;
+        friend class details::executor;
+
+        details::document                    doc{};
+        stl::vector<field_definition const*> definitions{}; // of the field selections; null for __typename
+        schema const*                        model = nullptr;
+
+      public:
+        /**
+         * Parse and check the query
+         * @returns null if it's not valid; the errors say why
+         */
+        [[nodiscard]] static inline stl::shared_ptr<plan const>
+        make(schema const& model, stl::string_view query, stl::vector<error>& errors, plan_limits limits = {});
+
+        [[nodiscard]] stl::string_view query() const noexcept {
+            return stl::string_view{doc.source}.substr(0, doc.query_size);
+        }
+
+        /**
+         * The type of the operation with the name (or the only operation);
+         * nullopt if there's no such operation
+         */
+        [[nodiscard]] stl::optional<operation_type> find_operation(stl::string_view name) const noexcept {
+            auto const* op = operation(name);
+            return op ? stl::optional<operation_type>{op->type} : stl::nullopt;
+        }
+
+        /**
+         * Run the operation with the name (it can be empty if there's only
+         * one operation); the context is given to the resolvers as it is.
+         */
+        [[nodiscard]] inline response
+        execute(stl::string_view operation_name, object const& variables, void* context = nullptr) const;
+
+      private:
+        [[nodiscard]] details::operation_definition const* operation(stl::string_view name) const noexcept {
+            if (name.empty())
+                return doc.operations.size() == 1 ? &doc.operations.front() : nullptr;
+            for (auto const& op : doc.operations)
+                if (doc.str(op.name) == name)
+                    return &op;
+            return nullptr;
+        }
+    };
+
+    namespace details {
+
+        /**
+         * Checks a document against the schema (a part of the validation rules
+         * of the spec), and points its fields at their definitions.
+         */
+        class validator {
+            plan&                              prepared;
+            document&                          doc;
+            schema const&                      model;
+            stl::vector<error>&                errors;
+            plan_limits                        limits;
+            stl::size_t                        visited = 0;
+            stl::vector<stl::uint32_t>         spreading{}; // the fragments that are being checked
+            stl::vector<bool>                  used_fragments{};
+            stl::vector<stl::string_view>      used_variables{};
+            operation_definition const*        op = nullptr;
+
+            void fail(stl::uint32_t at, stl::string message) {
+                errors.push_back(doc.error_at(at, stl::move(message)));
+            }
+
+            [[nodiscard]] variable_definition const* find_variable(stl::string_view name) const noexcept {
+                for (auto i = op->variables.first; i != op->variables.first + op->variables.count; i++)
+                    if (doc.str(doc.variables[i].name) == name)
+                        return &doc.variables[i];
+                return nullptr;
+            }
+
+            [[nodiscard]] bool is_input_type(stl::string_view name) const noexcept {
+                return model.is_scalar(name) || model.find_enum(name) != nullptr;
+            }
+
+            void check_literal(stl::uint32_t index, stl::string_view type, stl::uint32_t at) {
+                auto const& lit = doc.literals[index];
+                if (lit.kind == literal_kind::variable) {
+                    auto const name = doc.str(lit.str);
+                    used_variables.push_back(name);
+                    if (auto const* var = find_variable(name)) {
+                        auto const var_type = doc.str(var->type);
+                        if (types::named(var_type) != types::named(type) ||
+                            (types::is_non_null(type) && !types::is_non_null(var_type) &&
+                             var->default_value == no_index))
+                            fail(at, "the variable $" + stl::string{name} + " of type " + stl::string{var_type} +
+                                       " can't be used as " + stl::string{type});
+                    } else {
+                        fail(at, "the variable $" + stl::string{name} + " is not defined");
+                    }
+                    return;
+                }
+                if (lit.kind == literal_kind::null) {
+                    if (types::is_non_null(type))
+                        fail(at, "null is not a " + stl::string{type});
+                    return;
+                }
+                if (types::is_list(type)) {
+                    if (lit.kind != literal_kind::list) {
+                        check_literal(index, types::item(type), at); // one item is a list of one
+                        return;
+                    }
+                    for (auto i = lit.items.first; i != lit.items.first + lit.items.count; i++)
+                        check_literal(i, types::item(type), at);
+                    return;
+                }
+                auto const name = types::named(type);
+                bool       ok   = false;
+                if (name == "Int") {
+                    stl::int64_t val = 0;
+                    auto const   str = doc.str(lit.str);
+                    ok               = lit.kind == literal_kind::integer &&
+                         stl::from_chars(str.data(), str.data() + str.size(), val).ec == stl::errc{} &&
+                         val >= INT32_MIN && val <= INT32_MAX;
+                } else if (name == "Float") {
+                    ok = lit.kind == literal_kind::integer || lit.kind == literal_kind::floating;
+                } else if (name == "String") {
+                    ok = lit.kind == literal_kind::string;
+                } else if (name == "Boolean") {
+                    ok = lit.kind == literal_kind::boolean;
+                } else if (name == "ID") {
+                    ok = lit.kind == literal_kind::string || lit.kind == literal_kind::integer;
+                } else if (auto const* values = model.find_enum(name)) {
+                    ok = lit.kind == literal_kind::enumeration &&
+                         stl::find(values->begin(), values->end(), doc.str(lit.str)) != values->end();
+                } else if (model.is_scalar(name)) {
+                    ok = lit.kind != literal_kind::object;
+                }
+                if (!ok)
+                    fail(at, "the value is not a " + stl::string{type});
+            }
+
+            void check_directives(range dirs) {
+                for (auto i = dirs.first; i != dirs.first + dirs.count; i++) {
+                    auto const& dir  = doc.directives[i];
+                    auto const  name = doc.str(dir.name);
+                    if (name != "skip" && name != "include") {
+                        fail(dir.at, "the directive @" + stl::string{name} + " is not known");
+                        continue;
+                    }
+                    if (dir.arguments.count != 1 || doc.str(doc.arguments[dir.arguments.first].name) != "if") {
+                        fail(dir.at, "the directive @" + stl::string{name} + " takes one argument, \"if\"");
+                        continue;
+                    }
+                    auto const& arg = doc.arguments[dir.arguments.first];
+                    check_literal(arg.value, "Boolean!", arg.at);
+                }
+            }
+
+            void check_arguments(selection const& sel, field_definition const& def) {
+                for (auto i = sel.arguments.first; i != sel.arguments.first + sel.arguments.count; i++) {
+                    auto const& arg  = doc.arguments[i];
+                    auto const  name = doc.str(arg.name);
+                    for (auto j = sel.arguments.first; j != i; j++)
+                        if (doc.str(doc.arguments[j].name) == name)
+                            fail(arg.at, "the argument \"" + stl::string{name} + "\" is given more than once");
+                    if (auto const* arg_def = def.find_argument(name)) {
+                        check_literal(arg.value, arg_def->type, arg.at);
+                    } else {
+                        fail(arg.at, "the field \"" + def.name + "\" has no argument \"" + stl::string{name} + '"');
+                    }
+                }
+                for (auto const& arg_def : def.arguments) {
+                    if (!types::is_non_null(arg_def.type) || arg_def.default_value)
+                        continue;
+                    bool given = false;
+                    for (auto i = sel.arguments.first; i != sel.arguments.first + sel.arguments.count; i++)
+                        given = given || doc.str(doc.arguments[i].name) == arg_def.name;
+                    if (!given)
+                        fail(sel.at, "the argument \"" + arg_def.name + "\" of the field \"" + def.name +
+                                       "\" is required");
+                }
+            }
+
+            void check_selections(range set, object_type const& type, stl::size_t level) {
+                if (level > limits.max_depth) {
+                    fail(doc.selections[set.first].at, "the query is nested too deep");
+                    return;
+                }
+                for (auto index = set.first; index != set.first + set.count; index++) {
+                    if (++visited > limits.max_selections) {
+                        if (visited == limits.max_selections + 1)
+                            fail(0, "the query has too many fields");
+                        return;
+                    }
+                    auto& sel = doc.selections[index];
+                    check_directives(sel.directives);
+                    auto const name = doc.str(sel.name);
+                    switch (sel.kind) {
+                        case selection_kind::field: {
+                            if (name == "__typename") {
+                                if (sel.arguments.count != 0 || sel.children.count != 0)
+                                    fail(sel.at, "__typename has no arguments and no fields");
+                                continue;
+                            }
+                            auto const* def = type.find(name);
+                            if (def == nullptr) {
+                                fail(sel.at, "the type " + stl::string{type.name()} + " has no field \"" +
+                                               stl::string{name} + '"');
+                                continue;
+                            }
+                            prepared.definitions[index] = def;
+                            check_arguments(sel, *def);
+                            if (auto const* child = model.find_object(types::named(def->type))) {
+                                if (sel.children.count == 0) {
+                                    fail(sel.at, "the field \"" + def->name + "\" of type " + def->type +
+                                                   " needs a selection of its fields");
+                                } else {
+                                    check_selections(sel.children, *child, level + 1);
+                                }
+                            } else if (sel.children.count != 0) {
+                                fail(sel.at, "the field \"" + def->name + "\" of type " + def->type +
+                                               " has no fields to select");
+                            }
+                            break;
+                        }
+                        case selection_kind::inline_fragment:
+                            if (!name.empty() && name != type.name()) {
+                                fail(sel.at, "the fragment on " + stl::string{name} + " can't be spread on " +
+                                               stl::string{type.name()});
+                                continue;
+                            }
+                            check_selections(sel.children, type, level);
+                            break;
+                        case selection_kind::fragment_spread: {
+                            auto frag = no_index;
+                            for (stl::uint32_t i = 0; i != doc.fragments.size(); i++)
+                                if (doc.str(doc.fragments[i].name) == name)
+                                    frag = i;
+                            if (frag == no_index) {
+                                fail(sel.at, "the fragment " + stl::string{name} + " is not defined");
+                                continue;
+                            }
+                            if (stl::find(spreading.begin(), spreading.end(), frag) != spreading.end()) {
+                                fail(sel.at, "the fragment " + stl::string{name} + " spreads itself");
+                                continue;
+                            }
+                            auto const& def  = doc.fragments[frag];
+                            used_fragments[frag] = true;
+                            if (doc.str(def.type_condition) != type.name()) {
+                                fail(sel.at, "the fragment " + stl::string{name} + " can't be spread on " +
+                                               stl::string{type.name()});
+                                continue;
+                            }
+                            sel.children = def.selections;
+                            spreading.push_back(frag);
+                            check_selections(def.selections, type, level);
+                            spreading.pop_back();
+                            break;
+                        }
+                    }
+                }
+            }
+
+            void check_operation(operation_definition const& operation) {
+                op = &operation;
+                used_variables.clear();
+                object_type const* root = nullptr;
+                switch (operation.type) {
+                    case operation_type::query: root = model.find_object("Query"); break;
+                    case operation_type::mutation: root = model.find_object("Mutation"); break;
+                    case operation_type::subscription:
+                        fail(operation.at, "the subscriptions are not supported");
+                        return;
+                }
+                if (root == nullptr) {
+                    fail(operation.at, operation.type == operation_type::query ? "the schema has no queries"
+                                                                               : "the schema has no mutations");
+                    return;
+                }
+                for (auto i = operation.variables.first; i != operation.variables.first + operation.variables.count;
+                     i++) {
+                    auto const& var  = doc.variables[i];
+                    auto const  name = doc.str(var.name);
+                    auto const  type = doc.str(var.type);
+                    if (find_variable(name) != &var)
+                        fail(var.at, "the variable $" + stl::string{name} + " is defined more than once");
+                    if (!is_input_type(types::named(type))) {
+                        fail(var.at, "the type of the variable $" + stl::string{name} + " is not an input type");
+                        continue;
+                    }
+                    if (var.default_value != no_index)
+                        check_literal(var.default_value, type, var.at);
+                }
+                check_selections(operation.selections, *root, 1);
+                for (auto i = operation.variables.first; i != operation.variables.first + operation.variables.count;
+                     i++) {
+                    auto const name = doc.str(doc.variables[i].name);
+                    if (stl::find(used_variables.begin(), used_variables.end(), name) == used_variables.end())
+                        fail(doc.variables[i].at, "the variable $" + stl::string{name} + " is not used");
+                }
+            }
+
+          public:
+            validator(plan& the_plan, schema const& the_model, stl::vector<error>& the_errors, plan_limits the_limits)
+              : prepared{the_plan},
+                doc{the_plan.doc},
+                model{the_model},
+                errors{the_errors},
+                limits{the_limits} {}
+
+            bool validate() {
+                auto const errors_before = errors.size();
+                prepared.definitions.assign(doc.selections.size(), nullptr);
+                used_fragments.assign(doc.fragments.size(), false);
+
+                for (auto const& operation : doc.operations) {
+                    if (operation.name.size == 0 && doc.operations.size() > 1)
+                        fail(operation.at, "an operation without a name should be the only one");
+                    for (auto const& other : doc.operations)
+                        if (&other != &operation && operation.name.size != 0 &&
+                            doc.str(other.name) == doc.str(operation.name) && &other < &operation)
+                            fail(operation.at, "there's more than one operation named " +
+                                                 stl::string{doc.str(operation.name)});
+                }
+                for (auto const& frag : doc.fragments) {
+                    for (auto const& other : doc.fragments)
+                        if (&other < &frag && doc.str(other.name) == doc.str(frag.name))
+                            fail(frag.at, "there's more than one fragment named " + stl::string{doc.str(frag.name)});
+                    if (model.find_object(doc.str(frag.type_condition)) == nullptr)
+                        fail(frag.at, "the type " + stl::string{doc.str(frag.type_condition)} + " is not an object type");
+                }
+                if (errors.size() != errors_before)
+                    return false;
+
+                for (auto const& operation : doc.operations)
+                    check_operation(operation);
+                for (stl::size_t i = 0; i != doc.fragments.size(); i++)
+                    if (!used_fragments[i] && errors.size() == errors_before)
+                        fail(doc.fragments[i].at, "the fragment " + stl::string{doc.str(doc.fragments[i].name)} +
+                                                    " is not used");
+                return errors.size() == errors_before;
+            }
+        };
+
+        /**
+         * Runs an operation of a plan, one level of the response at a time
+         */
+        class executor {
+            struct path_segment {
+                path_segment const* parent;
+                stl::string_view    key{};
+                stl::int64_t        index = -1;
+            };
+
+            // the selections of an object that have the same response key
+            struct collected_field {
+                stl::string_view           key;
+                field_definition const*    def;
+                stl::vector<stl::uint32_t> nodes;
+            };
+
+            using collection = stl::vector<collected_field>;
+
+            struct object_task {
+                object_type const*  type;
+                value const*        source;
+                value*              out;
+                stl::vector<range>  sets;
+                path_segment const* path;
+            };
+
+            struct field_task {
+                object_type const*     type; // of the parent
+                value const*           source;
+                value*                 slot;
+                collected_field const* field;
+                path_segment const*    path;
+                object const*          args = nullptr;
+                value                  result{};
+            };
+
+            plan const&                                               prepared;
+            document const&                                           doc;
+            object const&                                             variables;
+            void*                                                     context;
+            response&                                                 res;
+            stl::deque<value>                                         sources{};
+            stl::deque<path_segment>                                  paths{};
+            stl::deque<object>                                        argument_values{};
+            stl::unordered_map<stl::uint32_t, object const*>          arguments_of{};
+            stl::deque<collection>                                    collections{};
+            stl::unordered_map<stl::uint64_t, collection const*>      collection_of{};
+
+            void fail(path_segment const* path, stl::uint32_t node, stl::string message) {
+                auto err = doc.error_at(doc.selections[node].at, stl::move(message));
+                for (auto const* segment = path; segment != nullptr; segment = segment->parent)
+                    err.path.emplace_back(segment->index >= 0 ? value{segment->index} : value{segment->key});
+                stl::reverse(err.path.begin(), err.path.end());
+                res.errors.push_back(stl::move(err));
+            }
+
+            [[nodiscard]] value literal_value(stl::uint32_t index) const {
+                auto const& lit = doc.literals[index];
+                auto const  str = doc.str(lit.str);
+                switch (lit.kind) {
+                    case literal_kind::variable: {
+                        for (auto const& [name, val] : variables)
+                            if (name == str)
+                                return val;
+                        return {};
+                    }
+                    case literal_kind::integer: {
+                        stl::int64_t val = 0;
+                        if (stl::from_chars(str.data(), str.data() + str.size(), val).ec == stl::errc{})
+                            return val;
+                        [[fallthrough]]; // too big for an integer
+                    }
+                    case literal_kind::floating: {
+                        double val = 0;
+                        stl::from_chars(str.data(), str.data() + str.size(), val);
+                        return val;
+                    }
+                    case literal_kind::string:
+                    case literal_kind::enumeration: return str;
+                    case literal_kind::boolean: return str == "true";
+                    case literal_kind::null: return {};
+                    case literal_kind::list: {
+                        list items;
+                        for (auto i = lit.items.first; i != lit.items.first + lit.items.count; i++)
+                            items.push_back(literal_value(i));
+                        return items;
+                    }
+                    case literal_kind::object: {
+                        object fields;
+                        for (auto i = lit.items.first; i != lit.items.first + lit.items.count; i++)
+                            fields.emplace_back(doc.str(doc.arguments[i].name), literal_value(doc.arguments[i].value));
+                        return fields;
+                    }
+                }
+                return {};
+            }
+
+            [[nodiscard]] bool has_variable(stl::string_view name) const noexcept {
+                for (auto const& [key, val] : variables)
+                    if (key == name)
+                        return true;
+                return false;
+            }
+
+            [[nodiscard]] bool included(range dirs) const {
+                for (auto i = dirs.first; i != dirs.first + dirs.count; i++) {
+                    auto const& dir  = doc.directives[i];
+                    auto const  cond = literal_value(doc.arguments[dir.arguments.first].value).as_bool();
+                    if (doc.str(dir.name) == "skip" ? cond : !cond)
+                        return false;
+                }
+                return true;
+            }
+
+            // the arguments of a field selection, with the defaults; they're the same in all of its occurrences
+            object const* arguments_for(stl::uint32_t node, field_definition const& def) {
+                if (auto const it = arguments_of.find(node); it != arguments_of.end())
+                    return it->second;
+                auto const& sel  = doc.selections[node];
+                auto&       args = argument_values.emplace_back();
+                for (auto const& arg_def : def.arguments) {
+                    auto given = no_index;
+                    for (auto i = sel.arguments.first; i != sel.arguments.first + sel.arguments.count; i++)
+                        if (doc.str(doc.arguments[i].name) == arg_def.name)
+                            given = doc.arguments[i].value;
+                    // a variable that's not given is like an argument that's not given
+                    if (given != no_index && (doc.literals[given].kind != literal_kind::variable ||
+                                              has_variable(doc.str(doc.literals[given].str)))) {
+                        auto val = literal_value(given);
+                        coerce(val, arg_def.type);
+                        args.emplace_back(arg_def.name, stl::move(val));
+                    } else if (arg_def.default_value) {
+                        args.emplace_back(arg_def.name, *arg_def.default_value);
+                    }
+                }
+                arguments_of.emplace(node, &args);
+                return &args;
+            }
+
+            void collect(collection& fields, range set) const {
+                for (auto index = set.first; index != set.first + set.count; index++) {
+                    auto const& sel = doc.selections[index];
+                    if (!included(sel.directives))
+                        continue;
+                    if (sel.kind != selection_kind::field) {
+                        collect(fields, sel.children); // the type conditions are checked already
+                        continue;
+                    }
+                    auto const key = doc.response_key(sel);
+                    auto const it  = stl::find_if(fields.begin(), fields.end(), [key](auto const& field) {
+                        return field.key == key;
+                    });
+                    if (it != fields.end()) {
+                        it->nodes.push_back(index);
+                    } else {
+                        fields.push_back({key, prepared.definitions[index], {index}});
+                    }
+                }
+            }
+
+            // the fields of the selection sets; the objects of a list have the same ones
+            collection const& collect(stl::vector<range> const& sets) {
+                stl::uint64_t key = 0;
+                if (sets.size() == 1) {
+                    key = (stl::uint64_t{sets.front().first} << 32u) | sets.front().count;
+                    if (auto const it = collection_of.find(key); it != collection_of.end())
+                        return *it->second;
+                }
+                auto& fields = collections.emplace_back();
+                for (auto const set : sets)
+                    collect(fields, set);
+                if (sets.size() == 1)
+                    collection_of.emplace(key, &fields);
+                return fields;
+            }
+
+            void expand(object_task const& task, stl::vector<field_task>& tasks) {
+                auto const& fields  = collect(task.sets);
+                auto&       members = *task.out->as_object();
+                members.reserve(fields.size());
+                for (auto const& field : fields)
+                    members.emplace_back(field.key, value{});
+                for (stl::size_t i = 0; i != fields.size(); i++)
+                    tasks.push_back(field_task_of(task, fields[i], &members[i].second));
+            }
+
+            field_task field_task_of(object_task const& task, collected_field const& field, value* slot) {
+                auto const* path = &paths.emplace_back(path_segment{task.path, field.key});
+                field_task  res{task.type, task.source, slot, &field, path};
+                if (field.def != nullptr)
+                    res.args = arguments_for(field.nodes.front(), *field.def);
+                return res;
+            }
+
+            void resolve(field_task& task) {
+                auto const* def = task.field->def;
+                if (def == nullptr) {
+                    task.result = stl::string{task.type->name()}; // __typename
+                } else if (def->resolve) {
+                    stl::string failure;
+                    task.result = def->resolve(resolve_info{*task.source, *task.args, context, &failure});
+                    if (!failure.empty()) {
+                        task.result = {};
+                        fail(task.path, task.field->nodes.front(), stl::move(failure));
+                    }
+                } else if (auto const* member = task.source->find(def->name)) {
+                    task.result = *member;
+                }
+            }
+
+            void resolve_batch(field_definition const& def, stl::span<field_task*> tasks) {
+                stl::vector<batch_item> items;
+                items.reserve(tasks.size());
+                for (auto const* task : tasks)
+                    items.push_back({task->source, task->args});
+                stl::vector<stl::pair<stl::size_t, stl::string>> failures;
+                auto results = def.resolve_batch(batch_info{items, context, &failures});
+                if (results.size() != tasks.size()) {
+                    for (auto const* task : tasks)
+                        fail(task->path, task->field->nodes.front(),
+                             "the resolver of \"" + def.name + "\" didn't return a value for each item");
+                    return;
+                }
+                for (stl::size_t i = 0; i != tasks.size(); i++)
+                    tasks[i]->result = stl::move(results[i]);
+                for (auto& [item, message] : failures) {
+                    if (item >= tasks.size())
+                        continue;
+                    tasks[item]->result = {};
+                    fail(tasks[item]->path, tasks[item]->field->nodes.front(), stl::move(message));
+                }
+            }
+
+            void complete(stl::string_view type,
+                          value&&          result,
+                          value*           slot,
+                          field_task const& task,
+                          path_segment const* path,
+                          stl::vector<object_task>& next) {
+                if (result.is_null()) {
+                    if (types::is_non_null(type))
+                        fail(path, task.field->nodes.front(), "the field \"" + stl::string{task.field->key} +
+                                                                 "\" can't be null");
+                    *slot = nullptr;
+                    return;
+                }
+                if (types::is_list(type)) {
+                    auto* items = result.as_list();
+                    if (items == nullptr) {
+                        fail(path, task.field->nodes.front(), "the field \"" + stl::string{task.field->key} +
+                                                                 "\" should be a list");
+                        *slot = nullptr;
+                        return;
+                    }
+                    *slot          = list(items->size());
+                    auto& out_list = *slot->as_list();
+                    for (stl::size_t i = 0; i != items->size(); i++) {
+                        auto const* item_path =
+                          &paths.emplace_back(path_segment{path, {}, static_cast<stl::int64_t>(i)});
+                        complete(types::item(type), stl::move((*items)[i]), &out_list[i], task, item_path, next);
+                    }
+                    return;
+                }
+                if (auto const* child = prepared.model->find_object(types::named(type))) {
+                    // the object is the parent of the next level; it can be anything its resolvers understand
+                    auto const& source = sources.emplace_back(stl::move(result));
+                    *slot              = object{};
+                    stl::vector<range> sets;
+                    for (auto const node : task.field->nodes)
+                        if (doc.selections[node].children.count != 0)
+                            sets.push_back(doc.selections[node].children);
+                    next.push_back({child, &source, slot, stl::move(sets), path});
+                    return;
+                }
+                coerce(result, types::named(type)); // the IDs are strings, the Floats are not integers
+                *slot = stl::move(result);
+            }
+
+            void run_level(stl::vector<field_task>& tasks, stl::vector<object_task>& next) {
+                stl::vector<stl::pair<field_definition const*, stl::vector<field_task*>>> batches;
+                for (auto& task : tasks) {
+                    auto const* def = task.field->def;
+                    if (def == nullptr || !def->resolve_batch) {
+                        resolve(task);
+                        continue;
+                    }
+                    auto const it = stl::find_if(batches.begin(), batches.end(), [def](auto const& batch) {
+                        return batch.first == def;
+                    });
+                    if (it != batches.end()) {
+                        it->second.push_back(&task);
+                    } else {
+                        batches.emplace_back(def, stl::vector<field_task*>{&task});
+                    }
+                }
+                for (auto& [def, batch] : batches)
+                    resolve_batch(*def, batch);
+                for (auto& task : tasks) {
+                    auto const type = task.field->def != nullptr ? stl::string_view{task.field->def->type}
+                                                                 : stl::string_view{"String!"};
+                    complete(type, stl::move(task.result), task.slot, task, task.path, next);
+                }
+            }
+
+            void run(stl::vector<object_task> frontier) {
+                stl::vector<field_task>  tasks;
+                stl::vector<object_task> next;
+                while (!frontier.empty()) {
+                    tasks.clear();
+                    next.clear();
+                    for (auto const& task : frontier)
+                        expand(task, tasks);
+                    run_level(tasks, next);
+                    stl::swap(frontier, next);
+                }
+            }
+
+            bool check_variable(value& val, stl::string_view type) const {
+                if (val.is_null())
+                    return !types::is_non_null(type);
+                if (types::is_list(type)) {
+                    if (auto* items = val.as_list()) {
+                        for (auto& item : *items)
+                            if (!check_variable(item, types::item(type)))
+                                return false;
+                        return true;
+                    }
+                    if (!check_variable(val, types::item(type)))
+                        return false;
+                    val = list{stl::move(val)};
+                    return true;
+                }
+                auto const name = types::named(type);
+                auto const kind = val.kind();
+                if (name == "Int")
+                    return kind == value_kind::integer && val.as_int() >= INT32_MIN && val.as_int() <= INT32_MAX;
+                if (name == "Float") {
+                    if (kind == value_kind::integer)
+                        val = val.as_float();
+                    return val.kind() == value_kind::floating;
+                }
+                if (name == "String")
+                    return kind == value_kind::string;
+                if (name == "Boolean")
+                    return kind == value_kind::boolean;
+                if (name == "ID") {
+                    if (kind == value_kind::integer)
+                        val = stl::to_string(val.as_int());
+                    return val.kind() == value_kind::string;
+                }
+                if (auto const* values = prepared.model->find_enum(name))
+                    return kind == value_kind::string &&
+                           stl::find(values->begin(), values->end(), val.as_string()) != values->end();
+                return true; // the custom scalars
+            }
+
+          public:
+            // the literals and the defaults are checked already; they're only converted
+            static void coerce(value& val, stl::string_view type) {
+                if (val.is_null())
+                    return;
+                if (types::is_list(type)) {
+                    if (auto* items = val.as_list()) {
+                        for (auto& item : *items)
+                            coerce(item, types::item(type));
+                    } else {
+                        coerce(val, types::item(type));
+                        val = list{stl::move(val)};
+                    }
+                    return;
+                }
+                auto const name = types::named(type);
+                if (name == "Float" && val.kind() == value_kind::integer) {
+                    val = val.as_float();
+                } else if (name == "ID" && val.kind() == value_kind::integer) {
+                    val = stl::to_string(val.as_int());
+                }
+            }
+
+            executor(plan const& the_plan, object const& the_variables, void* the_context, response& the_res)
+              : prepared{the_plan},
+                doc{the_plan.doc},
+                variables{the_variables},
+                context{the_context},
+                res{the_res} {}
+
+            /**
+             * The variables of the operation, from the ones that are given
+             * @returns false if they don't match their definitions
+             */
+            bool coerce_variables(operation_definition const& op, object const& given, object& out) {
+                for (auto i = op.variables.first; i != op.variables.first + op.variables.count; i++) {
+                    auto const& var  = doc.variables[i];
+                    auto const  name = doc.str(var.name);
+                    auto const  type = doc.str(var.type);
+                    auto const  it   = stl::find_if(given.begin(), given.end(), [name](auto const& item) {
+                        return item.first == name;
+                    });
+                    if (it != given.end()) {
+                        value val = it->second;
+                        if (!check_variable(val, type)) {
+                            res.errors.push_back(doc.error_at(var.at, "the variable $" + stl::string{name} +
+                                                                        " is not a " + stl::string{type}));
+                            continue;
+                        }
+                        out.emplace_back(name, stl::move(val));
+                    } else if (var.default_value != no_index) {
+                        auto val = literal_value(var.default_value);
+                        coerce(val, type);
+                        out.emplace_back(name, stl::move(val));
+                    } else if (types::is_non_null(type)) {
+                        res.errors.push_back(
+                          doc.error_at(var.at, "the variable $" + stl::string{name} + " is required"));
+                    }
+                }
+                return res.errors.empty();
+            }
+
+            void execute(operation_definition const& op) {
+                auto const* root = prepared.model->find_object(op.type == operation_type::query ? "Query" : "Mutation");
+                static value const root_value{};
+                res.data     = object{};
+                res.has_data = true;
+                object_task const root_task{root, &root_value, &res.data, {op.selections}, nullptr};
+                if (op.type == operation_type::query) {
+                    run({root_task});
+                    return;
+                }
+                // the fields of a mutation are run one after another, with everything under them
+                auto const& fields  = collect(root_task.sets);
+                auto&       members = *res.data.as_object();
+                members.reserve(fields.size());
+                for (auto const& field : fields)
+                    members.emplace_back(field.key, value{});
+                for (stl::size_t i = 0; i != fields.size(); i++) {
+                    stl::vector<field_task>  tasks{field_task_of(root_task, fields[i], &members[i].second)};
+                    stl::vector<object_task> next;
+                    run_level(tasks, next);
+                    run(stl::move(next));
+                }
+            }
+        };
+
+    } // namespace details
+
+    inline stl::shared_ptr<plan const>
+    plan::make(schema const& model, stl::string_view query, stl::vector<error>& errors, plan_limits limits) {
+        auto res            = stl::make_shared<plan>();
+        res->model          = &model;
+        res->doc.source     = query;
+        res->doc.query_size = query.size();
+        if (query.size() >= details::no_index) {
+            errors.push_back({.message = "the query is too big"});
+            return nullptr;
+        }
+        details::parser parse{res->doc, limits.max_depth * 2 + 8}; // the values nest too
+        if (!parse.parse()) {
+            errors.push_back(res->doc.error_at(parse.failed_at, stl::move(parse.message)));
+            return nullptr;
+        }
+        if (!details::validator{*res, model, errors, limits}.validate())
+            return nullptr;
+        return res;
+    }
+
+    inline response plan::execute(stl::string_view operation_name, object const& variables, void* context) const {
+        response    res;
+        auto const* op = operation(operation_name);
+        if (op == nullptr) {
+            res.errors.push_back({.message = operation_name.empty()
+                                               ? "the name of the operation is needed"
+                                               : "there's no operation named " + stl::string{operation_name}});
+            return res;
+        }
+        object                     coerced;
+        details::executor          exec{*this, coerced, context, res};
+        if (!exec.coerce_variables(*op, variables, coerced))
+            return res;
+        exec.execute(*op);
+        return res;
+    }
+
+    struct service_options {
+        stl::size_t max_plans      = 1024;      // the parsed and checked queries that are kept
+        stl::size_t max_persisted  = 4096;      // the persisted queries that are kept
+        stl::size_t max_query_size = 64 * 1024; // in bytes
+        plan_limits limits{};
+    };
+
+    struct request {
+        stl::string_view query{};
+        stl::string_view operation_name{};
+        object           variables{};
+        stl::string_view persisted_hash{};         // the sha256Hash of the persistedQuery extension, in hex
+        bool             allow_mutations = true;   // they're not allowed over GET
+    };
+
+    /**
+     * A schema, and the plans of the queries that it has run; it can be used
+     * from all the threads.
+     *
+     * The plans are kept by the hash of their query (and the query is
+     * compared, so a collision is only a miss), the most recently used ones;
+     * a request with a query that's seen before is not parsed or checked.
+     *
+     * The persisted queries are the automatic ones of Apollo: the client
+     * sends the SHA-256 of the query, and the query only if the server
+     * doesn't have it yet (a "PERSISTED_QUERY_NOT_FOUND" error); the hash of
+     * the query is checked before it's kept.
+     */
+    class service {
+        struct persisted_query {
+            sha256::digest_type         digest;
+            stl::shared_ptr<plan const> prepared;
+        };
+
+        using plan_cache      = sharded_cache<lru_cache<stl::uint64_t, stl::shared_ptr<plan const>>, 16>;
+        using persisted_cache = sharded_cache<lru_cache<stl::uint64_t, persisted_query>, 16>;
+
+        graphql::schema model;
+        service_options options;
+        plan_cache      plans;
+        persisted_cache persisted;
+
+        [[nodiscard]] static bool parse_digest(stl::string_view hex, sha256::digest_type& out) noexcept {
+            if (hex.size() != out.size() * 2)
+                return false;
+            for (stl::size_t i = 0; i != out.size(); i++) {
+                auto const [ptr, ec] = stl::from_chars(hex.data() + i * 2, hex.data() + i * 2 + 2, out[i], 16);
+                if (ec != stl::errc{} || ptr != hex.data() + i * 2 + 2)
+                    return false;
+            }
+            return true;
+        }
+
+        [[nodiscard]] static stl::uint64_t key_of(sha256::digest_type const& digest) noexcept {
+            stl::uint64_t key = 0;
+            for (stl::size_t i = 0; i != 8; i++)
+                key = (key << 8u) | digest[i];
+            return key;
+        }
+
+      public:
+        explicit service(graphql::schema schema, service_options opts = {})
+          : model{stl::move(schema)},
+            options{opts},
+            plans{opts.max_plans},
+            persisted{opts.max_persisted} {}
+
+        service(service const&)            = delete;
+        service& operator=(service const&) = delete;
+
+        [[nodiscard]] graphql::schema const& schema() const noexcept {
+            return model;
+        }
+
+        /**
+         * The plan of the query; it's parsed and checked if it's not in the cache
+         * @returns null if it's not valid; the errors say why
+         */
+        [[nodiscard]] stl::shared_ptr<plan const> prepare(stl::string_view query, stl::vector<error>& errors) {
+            if (query.size() > options.max_query_size) {
+                errors.push_back({.message = "the query is too big"});
+                return nullptr;
+            }
+            auto const hash = static_cast<stl::uint64_t>(stl::hash<stl::string_view>{}(query));
+            if (auto cached = plans.get(hash); cached && (*cached)->query() == query)
+                return stl::move(*cached);
+            auto prepared = plan::make(model, query, errors, options.limits);
+            if (prepared)
+                plans.set(hash, prepared);
+            return prepared;
+        }
+
+        /**
+         * Run the request; the context is given to the resolvers
+         */
+        [[nodiscard]] response execute(request const& req, void* context = nullptr) {
+            response                    res;
+            stl::shared_ptr<plan const> prepared;
+            if (!req.persisted_hash.empty()) {
+                sha256::digest_type digest{};
+                if (!parse_digest(req.persisted_hash, digest)) {
+                    res.errors.push_back({.message = "the hash of the persisted query is not valid"});
+                    return res;
+                }
+                auto const key = key_of(digest);
+                if (req.query.empty()) {
+                    if (auto entry = persisted.get(key); entry && entry->digest == digest) {
+                        prepared = stl::move(entry->prepared);
+                    } else {
+                        res.errors.push_back(
+                          {.message = "PersistedQueryNotFound", .code = "PERSISTED_QUERY_NOT_FOUND"});
+                        return res;
+                    }
+                } else {
+                    if (sha256::hash(req.query) != digest) {
+                        res.errors.push_back({.message = "the hash of the persisted query doesn't match the query"});
+                        return res;
+                    }
+                    prepared = prepare(req.query, res.errors);
+                    if (prepared)
+                        persisted.set(key, persisted_query{digest, prepared});
+                }
+            } else if (req.query.empty()) {
+                res.errors.push_back({.message = "there's no query"});
+                return res;
+            } else {
+                prepared = prepare(req.query, res.errors);
+            }
+            if (!prepared)
+                return res;
+            if (!req.allow_mutations && prepared->find_operation(req.operation_name) == operation_type::mutation) {
+                res.errors.push_back({.message = "the mutations are only allowed over POST"});
+                return res;
+            }
+            return prepared->execute(req.operation_name, req.variables, context);
+        }
+
+        /**
+         * The number of the plans in the cache
+         */
+        [[nodiscard]] stl::size_t cached_plans() const {
+            return plans.size();
+        }
+
+        [[nodiscard]] stl::size_t persisted_queries() const {
+            return persisted.size();
+        }
+    };
+
+} // namespace webpp::graphql
+
+#endif // WEBPP_HTTP_GRAPHQL_H
@@ -1,16 +1,26 @@
 #ifndef WEBPP_HTTP_HEADERS_H
 #define WEBPP_HTTP_HEADERS_H
 
+#include "../extensions/extension.hpp"
 #include "../std/format.hpp"
 #include "../std/string.hpp"
 #include "../std/string_view.hpp"
 #include "../std/unordered_set.hpp"
+#include "../std/vector.hpp"
 #include "../traits/traits_concepts.hpp"
 #include "./common.hpp"
+#include "./header_sanitizer.hpp"
+#include "../utils/strings.hpp"
+#include "./well_known_headers.hpp"
 #include "./cookies/cookie.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <iterator>
+#include <memory>
+#include <new>
 #include <sstream>
 #include <type_traits>
 
@@ -138,6 +148,93 @@ namespace webpp {
         }
     }
 
+    namespace details {
+        struct cgi_status_prefix {
+            static constexpr stl::string_view value = "Status: ";
+        };
+
+        struct http11_status_prefix {
+            static constexpr stl::string_view value = "HTTP/1.1 ";
+        };
+
+        /**
+         * The status lines ("<prefix><code> <reason phrase>\r\n") of all the
+         * codes from 100 to 599, formatted at compile time and packed one
+         * after another.
+         */
+        template <typename Prefix>
+        struct status_line_table {
+            static constexpr status_code_type first = 100;
+            static constexpr status_code_type last  = 599;
+            static constexpr stl::size_t      count = last - first + 1;
+
+            static constexpr stl::size_t line_size(status_code_type code) noexcept {
+                return Prefix::value.size() + 3 + 1 + stl::string_view{status_reason_phrase(code)}.size() + 2;
+            }
+
+            static constexpr stl::size_t total_size() noexcept {
+                stl::size_t size = 0;
+                for (auto code = first; code <= last; code++)
+                    size += line_size(code);
+                return size;
+            }
+
+            stl::array<char, total_size()> chars{};
+            stl::array<uint16_t, count + 1> offsets{};
+
+            constexpr status_line_table() noexcept {
+                stl::size_t pos = 0;
+                auto        put = [&](stl::string_view str) constexpr {
+                    for (auto c : str)
+                        chars[pos++] = c;
+                };
+                for (auto code = first; code <= last; code++) {
+                    offsets[code - first] = static_cast<uint16_t>(pos);
+                    put(Prefix::value);
+                    chars[pos++] = static_cast<char>('0' + code / 100);
+                    chars[pos++] = static_cast<char>('0' + code / 10 % 10);
+                    chars[pos++] = static_cast<char>('0' + code % 10);
+                    chars[pos++] = ' ';
+                    put(status_reason_phrase(code));
+                    put("\r\n");
+                }
+                offsets[count] = static_cast<uint16_t>(pos);
+            }
+
+            /**
+             * The status line of the code; empty if it's not in the table
+             */
+            [[nodiscard]] constexpr stl::string_view operator[](status_code_type code) const noexcept {
+                if (code < first || code > last)
+                    return {};
+                auto const index = code - first;
+                return {chars.data() + offsets[index], static_cast<stl::size_t>(offsets[index + 1] - offsets[index])};
+            }
+        };
+
+        static_assert(status_line_table<http11_status_prefix>::total_size() <= 0xFFFFu, "the offsets are 16 bits");
+
+        inline constexpr status_line_table<cgi_status_prefix>    cgi_status_lines{};
+        inline constexpr status_line_table<http11_status_prefix> http11_status_lines{};
+    } // namespace details
+
+    /**
+     * The CGI status line of the status code ("Status: 200 OK\r\n"), so
+     * sending one is a copy; empty if the status code is not between 100
+     * and 599.
+     */
+    [[nodiscard]] constexpr stl::string_view cgi_status_line(status_code_type status_code) noexcept {
+        return details::cgi_status_lines[status_code];
+    }
+
+    /**
+     * The HTTP/1.1 status line of the status code ("HTTP/1.1 200 OK\r\n");
+     * empty if the status code is not between 100 and 599.
+     */
+    [[nodiscard]] constexpr stl::string_view http11_status_line(status_code_type status_code) noexcept {
+        return details::http11_status_lines[status_code];
+    }
+
     /**
      * This is the header class witch will contain the name, and the value of
      * one single field of a header.
@@ -155,29 +252,59 @@ namespace webpp {
         string_type name;
         string_type value;
 
-        constexpr response_header_field(string_type&& _name, string_type&& _value)
-          : name{stl::move(_name)},
-            value{stl::move(_value)} {
-        }
+        // which one of the well-known headers this is; set when it's added to the headers
+        well_known_header known = well_known_header::unknown;
 
-        constexpr response_header_field(string_view_type _name, string_view_type _value,
-                                        alloc_type alloc = allocator_type{})
-          : name{_name, alloc},
-            value{_value, alloc} {
+        /**
+         * The name and the value can be strings, string views, or anything
+         * that a string can be constructed from.
+         */
+        template <typename NameT, typename ValueT>
+        requires(stl::constructible_from<string_type, NameT, alloc_type>&&
+                   stl::constructible_from<string_type, ValueT, alloc_type>)
+        constexpr response_header_field(NameT&& _name, ValueT&& _value, alloc_type alloc = allocator_type{})
+          : name{stl::forward<NameT>(_name), alloc},
+            value{stl::forward<ValueT>(_value), alloc} {
         }
 
-        constexpr response_header_field(string_view_type _name, string_type&& _value,
-                                        alloc_type alloc = allocator_type{})
-          : name{_name, alloc},
-            value{stl::move(_value)} {
-        }
+        constexpr response_header_field(response_header_field const&) = default;
+        constexpr response_header_field(response_header_field&&) noexcept = default;
+
+        // the allocator-extended ones, for the containers with polymorphic allocators
+        constexpr response_header_field(response_header_field const& other, alloc_type alloc)
+          : EList{other},
+            name{other.name, alloc},
+            value{other.value, alloc},
+            known{other.known} {}
+        constexpr response_header_field(response_header_field&& other, alloc_type alloc)
+          : EList{stl::move(other)},
+            name{stl::move(other.name), alloc},
+            value{stl::move(other.value), alloc},
+            known{other.known} {}
 
-        constexpr response_header_field(string_type&& _name, string_view_type _value,
-                                        alloc_type alloc = allocator_type{})
-          : name{stl::move(_name)},
-            value{_value, alloc} {
+        constexpr response_header_field& operator=(response_header_field const&) = default;
+        constexpr response_header_field& operator=(response_header_field&&) noexcept = default;
+
+
+        /**
+         * Replace the CR, LF, and NUL bytes of the name and the value with
+         * spaces, so the field can't end early or inject another field.
+         * @returns true if they were already safe
+         */
+        constexpr bool sanitize() noexcept {
+            auto const safe_name = header_sanitizer::sanitize(name);
+            return header_sanitizer::sanitize(value) && safe_name;
         }
 
+        /**
+         * Sanitize the field and find out if it's a well-known header; the
+         * headers call it when the field is added.
+         */
+        constexpr well_known_header prepare() noexcept {
+            sanitize();
+            known = to_well_known_header(name);
+            return known;
+        }
 
         /**
          * Check if the specified name is the same as the header name
@@ -185,14 +312,98 @@ namespace webpp {
          * case-insensitive.
          */
         constexpr bool is_name(string_view_type const& str) const noexcept {
-            return to_lower_copy<string_type::value_type, string_type::traits_type,
-                                 string_type::allocator_type>(name) ==
-                   to_lower_copy<string_view_type::value_type, string_view_type::traits_type,
-                                 traits_type::allocator>(str);
+            return str.size() == name.size() && ascii_iequals(name, str);
+        }
+
+        [[nodiscard]] constexpr bool operator==(response_header_field const& other) const noexcept {
+            return is_name(other.name) && value == other.value;
         }
+
+        /**
+         * The hash of the header fields is the hash of their (case-insensitive)
+         * names so the fields with the same name end up in the same bucket; the
+         * names can be looked up without a field too.
+         */
+        struct hash {
+            using is_transparent = void;
+
+            [[nodiscard]] stl::size_t operator()(response_header_field const& field) const noexcept {
+                return ascii_ihash(field.name);
+            }
+
+            [[nodiscard]] stl::size_t operator()(string_view_type name) const noexcept {
+                return ascii_ihash(name);
+            }
+        };
+
+        /**
+         * The fields are the same key if their names are (case-insensitively)
+         */
+        struct name_equal {
+            using is_transparent = void;
+
+            [[nodiscard]] bool operator()(response_header_field const& a,
+                                          response_header_field const& b) const noexcept {
+                return a.is_name(b.name);
+            }
+
+            [[nodiscard]] bool operator()(string_view_type name,
+                                          response_header_field const& field) const noexcept {
+                return field.is_name(name);
+            }
+
+            [[nodiscard]] bool operator()(response_header_field const& field,
+                                          string_view_type             name) const noexcept {
+                return field.is_name(name);
+            }
+        };
     };
 
 
+    namespace details {
+        /**
+         * Write the fields at the end of the string as "name: value\r\n" lines;
+         * the string grows once, and the names and the values are copied into
+         * it as they are.
+         */
+        template <typename StringType, typename FieldsType>
+        void append_header_fields(StringType& out, FieldsType const& fields) noexcept {
+            using char_traits = typename StringType::traits_type;
+
+            stl::size_t size = 0;
+            for (auto const& field : fields)
+                size += field.name.size() + field.value.size() + 4;
+            auto const old_size = out.size();
+            out.resize(old_size + size);
+
+            auto* it = out.data() + old_size;
+            for (auto const& field : fields) {
+                // the fields are sanitized when they're added (see header_sanitizer)
+                if constexpr (requires { field.known; }) {
+                    // the interned name and the ": " in one copy
+                    if (auto const prefix = well_known_header_prefix(field.known); !prefix.empty()) {
+                        char_traits::copy(it, prefix.data(), prefix.size());
+                        it += prefix.size();
+                    } else {
+                        char_traits::copy(it, field.name.data(), field.name.size());
+                        it += field.name.size();
+                        *it++ = ':';
+                        *it++ = ' ';
+                    }
+                } else {
+                    char_traits::copy(it, field.name.data(), field.name.size());
+                    it += field.name.size();
+                    *it++ = ':';
+                    *it++ = ' ';
+                }
+                char_traits::copy(it, field.value.data(), field.value.size());
+                it += field.value.size();
+                *it++ = '\r';
+                *it++ = '\n';
+            }
+        }
+    } // namespace details
+
     /**
      * Setting non-ascii characters in the value section of the headers should
      * result in transforming the value to the "Encoded-Word" syntax (RFC 2047).
@@ -200,42 +411,404 @@ namespace webpp {
      *   In the header:  "Subject: =?iso-8859-1?Q?=A1Hola,_se=F1or!?="
      *   Interpreted as: "Subject: ¡Hola, señor!"
      *
+     * The values are not encoded by themselves; use encoding::encode_words
+     * for the ones that need it (see encoding::needs_encoding).
      */
     template <Traits TraitsType, typename HeaderEList = empty_extension_pack,
               typename HeaderFieldType = response_header_field<TraitsType>>
-    class response_headers : public stl::unordered_multiset<TraitsType, HeaderFieldType>, public HeaderEList {
+    class response_headers
+      : public istl::unordered_multiset<TraitsType,
+                                        HeaderFieldType,
+                                        typename HeaderFieldType::hash,
+                                        typename HeaderFieldType::name_equal>,
+        public HeaderEList {
+
+        using super = istl::unordered_multiset<TraitsType,
+                                               HeaderFieldType,
+                                               typename HeaderFieldType::hash,
+                                               typename HeaderFieldType::name_equal>;
+        using node_type = typename super::node_type;
+
+        static constexpr stl::size_t max_spare_fields = 16;
+
+        /**
+         * The nodes of the fields that are cleared, to be used by the next
+         * fields so their strings don't allocate again; they're not copied
+         * with the headers.
+         */
+        struct spare_fields_type : public istl::vector<TraitsType, node_type> {
+            spare_fields_type() noexcept = default;
+            spare_fields_type(spare_fields_type const&) noexcept : spare_fields_type{} {}
+            spare_fields_type(spare_fields_type&&) noexcept = default;
+            spare_fields_type& operator=(spare_fields_type const&) noexcept {
+                return *this;
+            }
+            spare_fields_type& operator=(spare_fields_type&&) noexcept = default;
+        };
 
-        using super = stl::unordered_multiset<TraitsType, HeaderFieldType>;
+        spare_fields_type    spare_fields{};
+        well_known_header_set known_fields{}; // the well-known fields that are added
 
       public:
         using traits_type       = TraitsType;
         using string_type       = typename traits_type::string_type;
+        using string_view_type  = typename traits_type::string_view_type;
         using header_field_type = HeaderFieldType;
 
         using HeaderEList::HeaderEList;
 
         status_code_type status_code = 200u;
 
+        response_headers() noexcept = default;
+        response_headers(status_code_type _status_code) noexcept : status_code{_status_code} {
+        }
+
+        /**
+         * Add a field; the node (and the strings) of a cleared field is reused
+         * if there's one. The field is sanitized before it's hashed.
+         */
+        template <typename... Args>
+        auto emplace(Args&&... args) {
+            if constexpr (sizeof...(Args) == 2 && requires(string_type str, Args&&... parts) {
+                              (str.assign(stl::forward<Args>(parts)), ...);
+                          }) {
+                if (!spare_fields.empty()) {
+                    auto node = stl::move(spare_fields.back());
+                    spare_fields.pop_back();
+                    [&](auto&& name, auto&& value) {
+                        node.value().name.assign(stl::forward<decltype(name)>(name));
+                        node.value().value.assign(stl::forward<decltype(value)>(value));
+                    }(stl::forward<Args>(args)...);
+                    known_fields.insert(node.value().prepare());
+                    return super::insert(stl::move(node));
+                }
+            }
+            header_field_type field(stl::forward<Args>(args)...);
+            known_fields.insert(field.prepare());
+            return super::insert(stl::move(field));
+        }
+
+        /**
+         * Remove the fields and reset the status code; the buckets and the
+         * nodes of the fields are kept to be used again (see recycle_pool).
+         */
+        void clear() noexcept {
+            if (spare_fields.capacity() == 0)
+                spare_fields.reserve(max_spare_fields);
+            while (!this->empty() && spare_fields.size() < max_spare_fields)
+                spare_fields.push_back(super::extract(this->begin()));
+            super::clear();
+            known_fields.clear();
+            status_code = 200u;
+        }
+
+        /**
+         * A field with the specified name; it's looked up in its bucket.
+         */
+        [[nodiscard]] auto find(string_view_type name) const noexcept {
+            return super::find(name);
+        }
+
+        /**
+         * Check if there's a header field with the specified name
+         */
+        [[nodiscard]] bool contains(string_view_type name) const noexcept {
+            return super::find(name) != this->end();
+        }
+
+        /**
+         * Check if a well-known field is added; it's a bit test.
+         */
+        [[nodiscard]] bool contains(well_known_header name) const noexcept {
+            return known_fields.contains(name);
+        }
+
+
+        /**
+         * Write the fields at the end of the string (the outgoing buffer of
+         * the interface, for example)
+         */
+        template <typename StringType>
+        void append_to(StringType& out) const noexcept {
+            details::append_header_fields(out, *this);
+        }
 
         auto str() const noexcept {
-            // todo check performance
             // TODO: add support for other HTTP versions
-            // res << "HTTP/1.1" << " " << status_code() << " " <<
-            // status_reason_phrase(status_code()) << "\r\n";
-            stl::size_t size = 1;
-            for (auto const& [attr, val] : *this) {
-                size += attr.size() + val.size() + 4;
-            }
             string_type res{super::get_allocator()};
-            res.reserve(size);
-            for (auto const& [attr, val] : *this) {
-                // todo: make sure value is secure and doesn't have any newlines
-                stl::format_to(stl::back_insert_iterator<string_type>(res), "{}: {}\r\n", attr, val);
+            append_to(res);
+            return res;
+        }
+    };
+
+
+    /**
+     * The response headers in a flat array, in the order that they're added.
+     *
+     * The first few fields are stored inside of the object, so a response
+     * with a usual number of headers doesn't hash or allocate a node for each
+     * of them; the lookups are linear (and case-insensitive) which is faster
+     * than hashing for this many fields. If there are more fields, all of
+     * them are moved to a vector.
+     *
+     * The cleared fields are kept alive, so the next fields reuse their
+     * strings (see recycle_pool).
+     *
+     * Select it with the flat_headers extension.
+     */
+    template <Traits TraitsType, typename HeaderEList = empty_extension_pack,
+              typename HeaderFieldType = response_header_field<TraitsType>, stl::size_t InlineCapacity = 16>
+    class flat_response_headers : public HeaderEList {
+        static_assert(InlineCapacity > 0, "Use response_headers if you don't want the inline fields.");
+
+      public:
+        using traits_type       = TraitsType;
+        using string_type       = typename traits_type::string_type;
+        using string_view_type  = typename traits_type::string_view_type;
+        using header_field_type = HeaderFieldType;
+        using value_type        = header_field_type;
+        using iterator          = header_field_type*;
+        using const_iterator    = header_field_type const*;
+        using size_type         = stl::size_t;
+
+        static constexpr stl::size_t inline_capacity = InlineCapacity;
+
+      private:
+        alignas(header_field_type) stl::byte storage[inline_capacity * sizeof(header_field_type)];
+        stl::size_t                                 count       = 0; // the fields in use
+        stl::size_t                                 constructed = 0; // the inline fields that are alive
+        istl::vector<traits_type, header_field_type> spilled{};      // all the fields, if they didn't fit
+        well_known_header_set                        known_fields{}; // the well-known fields that are added
+
+        [[nodiscard]] header_field_type* inline_fields() noexcept {
+            return stl::launder(reinterpret_cast<header_field_type*>(storage));
+        }
+
+        [[nodiscard]] header_field_type const* inline_fields() const noexcept {
+            return stl::launder(reinterpret_cast<header_field_type const*>(storage));
+        }
+
+        /**
+         * Move the inline fields to the vector
+         */
+        void spill() {
+            spilled.reserve(inline_capacity * 2);
+            auto* const fields = inline_fields();
+            for (stl::size_t i = 0; i < count; i++)
+                spilled.push_back(stl::move(fields[i]));
+            stl::destroy_n(fields, constructed);
+            constructed = 0;
+        }
+
+        template <typename... Args>
+        header_field_type& append(Args&&... args) {
+            auto& field = construct_field(stl::forward<Args>(args)...);
+            known_fields.insert(field.prepare());
+            return field;
+        }
+
+        template <typename... Args>
+        header_field_type& construct_field(Args&&... args) {
+            if (!spilled.empty()) {
+                auto& field = spilled.emplace_back(stl::forward<Args>(args)...);
+                ++count;
+                return field;
+            }
+            auto* const fields = inline_fields();
+            if (count < constructed) {
+                // reuse the strings of a cleared field
+                auto& field = fields[count];
+                if constexpr (sizeof...(Args) == 2 && requires(string_type str, Args&&... parts) {
+                                  (str.assign(stl::forward<Args>(parts)), ...);
+                              }) {
+                    [&](auto&& name, auto&& value) {
+                        field.name.assign(stl::forward<decltype(name)>(name));
+                        field.value.assign(stl::forward<decltype(value)>(value));
+                    }(stl::forward<Args>(args)...);
+                } else {
+                    field = header_field_type(stl::forward<Args>(args)...);
+                }
+                ++count;
+                return field;
+            }
+            if (count < inline_capacity) {
+                auto* const field = stl::construct_at(fields + count, stl::forward<Args>(args)...);
+                ++count;
+                ++constructed;
+                return *field;
+            }
+            spill();
+            auto& field = spilled.emplace_back(stl::forward<Args>(args)...);
+            ++count;
+            return field;
+        }
+
+      public:
+        using HeaderEList::HeaderEList;
+
+        status_code_type status_code = 200u;
+
+        flat_response_headers() noexcept = default;
+        flat_response_headers(status_code_type _status_code) noexcept : status_code{_status_code} {}
+
+        flat_response_headers(flat_response_headers const& other)
+          : HeaderEList{other},
+            known_fields{other.known_fields},
+            status_code{other.status_code} {
+            for (auto const& field : other)
+                construct_field(field);
+        }
+
+        flat_response_headers(flat_response_headers&& other) noexcept
+          : HeaderEList{stl::move(other)},
+            known_fields{other.known_fields},
+            status_code{other.status_code} {
+            if (!other.spilled.empty()) {
+                spilled = stl::move(other.spilled);
+                count   = spilled.size();
+            } else {
+                for (auto& field : other)
+                    construct_field(stl::move(field));
+            }
+            other.clear();
+        }
+
+        flat_response_headers& operator=(flat_response_headers const& other) {
+            if (this != &other) {
+                HeaderEList::operator=(other);
+                clear();
+                known_fields = other.known_fields;
+                status_code  = other.status_code;
+                for (auto const& field : other)
+                    construct_field(field);
+            }
+            return *this;
+        }
+
+        flat_response_headers& operator=(flat_response_headers&& other) noexcept {
+            if (this != &other) {
+                HeaderEList::operator=(stl::move(other));
+                clear();
+                known_fields = other.known_fields;
+                status_code  = other.status_code;
+                if (!other.spilled.empty()) {
+                    spilled = stl::move(other.spilled);
+                    count   = spilled.size();
+                } else {
+                    for (auto& field : other)
+                        construct_field(stl::move(field));
+                }
+                other.clear();
             }
+            return *this;
+        }
+
+        ~flat_response_headers() noexcept {
+            stl::destroy_n(inline_fields(), constructed);
+        }
+
+        [[nodiscard]] iterator begin() noexcept {
+            return spilled.empty() ? inline_fields() : spilled.data();
+        }
+        [[nodiscard]] iterator end() noexcept {
+            return begin() + count;
+        }
+        [[nodiscard]] const_iterator begin() const noexcept {
+            return spilled.empty() ? inline_fields() : spilled.data();
+        }
+        [[nodiscard]] const_iterator end() const noexcept {
+            return begin() + count;
+        }
+
+        [[nodiscard]] stl::size_t size() const noexcept {
+            return count;
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return count == 0;
+        }
+
+        /**
+         * Add a field at the end; the fields are serialized in this order.
+         */
+        template <typename... Args>
+        iterator emplace(Args&&... args) {
+            auto& field = append(stl::forward<Args>(args)...);
+            return &field;
+        }
+
+        /**
+         * Remove the fields and reset the status code; the inline fields are
+         * kept to be used again.
+         */
+        void clear() noexcept {
+            spilled.clear();
+            known_fields.clear();
+            count       = 0;
+            status_code = 200u;
+        }
+
+        /**
+         * The first field with the specified name
+         */
+        [[nodiscard]] const_iterator find(string_view_type name) const noexcept {
+            return stl::find_if(begin(), end(), [=](auto const& field) noexcept {
+                return field.is_name(name);
+            });
+        }
+
+        /**
+         * Check if there's a header field with the specified name
+         */
+        [[nodiscard]] bool contains(string_view_type name) const noexcept {
+            return find(name) != end();
+        }
+
+        /**
+         * Check if a well-known field is added; it's a bit test.
+         */
+        [[nodiscard]] bool contains(well_known_header name) const noexcept {
+            return known_fields.contains(name);
+        }
+
+        [[nodiscard]] bool operator==(flat_response_headers const& other) const noexcept {
+            return status_code == other.status_code && stl::is_permutation(begin(), end(), other.begin(), other.end());
+        }
+
+        /**
+         * Write the fields at the end of the string, in their order
+         */
+        template <typename StringType>
+        void append_to(StringType& out) const noexcept {
+            details::append_header_fields(out, *this);
+        }
+
+        auto str() const noexcept {
+            string_type res;
+            append_to(res);
             return res;
         }
     };
 
+    /**
+     * An extension that makes the responses store their headers in a
+     * flat_response_headers instead of a hash table.
+     */
+    struct flat_headers {
+        static constexpr bool flat_response_headers = true;
+    };
+
+    template <typename ExtensionType>
+    concept FlatHeadersExtension = requires {
+        requires ExtensionType::flat_response_headers;
+    };
+
+    template <typename ExtensionListType>
+    struct uses_flat_headers : stl::false_type {};
+
+    template <typename... E>
+    struct uses_flat_headers<extension_pack<E...>> : stl::bool_constant<(FlatHeadersExtension<E> || ...)> {};
+
 
     struct response_header_field_descriptor {
         template <typename ExtensionType>
@@ -270,9 +843,14 @@ namespace webpp {
         using related_extension_pack_type = typename ExtensionType::response_headers_extensions;
 
         template <typename ExtensionListType, typename TraitsType, typename EList>
-        using mid_level_extensie_type = response_headers<
-          TraitsType, EList,
-          typename ExtensionListType::template extensie_type<TraitsType, response_header_field_descriptor>>;
+        using mid_level_extensie_type = stl::conditional_t<
+          uses_flat_headers<ExtensionListType>::value,
+          flat_response_headers<
+            TraitsType, EList,
+            typename ExtensionListType::template extensie_type<TraitsType, response_header_field_descriptor>>,
+          response_headers<
+            TraitsType, EList,
+            typename ExtensionListType::template extensie_type<TraitsType, response_header_field_descriptor>>>;
 
         // empty final extensie
         template <typename ExtensionListType, typename TraitsType, typename EList>
@@ -0,0 +1,140 @@
+#ifndef WEBPP_HTTP_HEADER_INDEX_H
+#define WEBPP_HTTP_HEADER_INDEX_H
+
+#include "../std/optional.hpp"
+#include "../std/std.hpp"
+#include "../std/string_view.hpp"
+#include "../utils/strings.hpp"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <span>
+
+namespace webpp {
+
+    /**
+     * The header fields of a request, as views into where they're read from
+     * (the params of FastCGI, the buffer of the connection), with a
+     * case-insensitive hash index on them. Nothing is done until the first
+     * lookup: the requests whose handlers read no headers don't pay for it.
+     *
+     *   lazy_header_index<> index;
+     *   auto const value = index.find("Accept", [&](auto& add) {
+     *       for (auto const& field : fields)
+     *           add(field.name, field.value);
+     *   });
+     *
+     * The first "MaxFields" fields are kept; see overflowed.
+     */
+    template <stl::size_t MaxFields = 64>
+    class lazy_header_index {
+        static_assert(MaxFields > 0 && MaxFields < 255, "the slots hold the index of the field in a byte");
+
+      public:
+        struct field {
+            stl::string_view name;
+            stl::string_view value;
+        };
+
+        static constexpr stl::size_t max_fields = MaxFields;
+
+      private:
+        static constexpr stl::size_t slot_count = stl::bit_ceil(MaxFields * 2); // half full at most
+        static constexpr stl::size_t slot_mask  = slot_count - 1;
+
+        struct table_type {
+            stl::array<field, MaxFields>           fields{};
+            stl::array<stl::uint32_t, MaxFields>   hashes{};
+            stl::array<stl::uint8_t, slot_count>   slots{}; // the index of the field + 1, or 0 if it's empty
+            stl::size_t                            count      = 0;
+            bool                                   overflowed = false;
+
+            void add(stl::string_view name, stl::string_view value) noexcept {
+                if (count == MaxFields) {
+                    overflowed = true;
+                    return;
+                }
+                auto const hash = static_cast<stl::uint32_t>(ascii_ihash(name));
+                auto       slot = hash & slot_mask;
+                while (slots[slot] != 0) // the duplicates go after the first one, so it's found first
+                    slot = (slot + 1) & slot_mask;
+                fields[count] = {name, value};
+                hashes[count] = hash;
+                slots[slot]   = static_cast<stl::uint8_t>(++count);
+            }
+        };
+
+        stl::optional<table_type> table{};
+
+      public:
+        /**
+         * Index the fields, if they're not indexed yet; "fill" is called with
+         * an "add(name, value)" function, and adds all of the fields.
+         */
+        template <typename Fill>
+        void build(Fill&& fill) {
+            if (table)
+                return;
+            auto& tbl = table.emplace();
+            auto  add = [&tbl](stl::string_view name, stl::string_view value) noexcept {
+                tbl.add(name, value);
+            };
+            fill(add);
+        }
+
+        [[nodiscard]] bool is_built() const noexcept {
+            return table.has_value();
+        }
+
+        /**
+         * The value of the first field with the name (case-insensitively);
+         * empty if there's none, or the index is not built.
+         */
+        [[nodiscard]] stl::string_view find(stl::string_view name) const noexcept {
+            if (!table)
+                return {};
+            auto const hash = static_cast<stl::uint32_t>(ascii_ihash(name));
+            for (auto slot = hash & slot_mask; table->slots[slot] != 0; slot = (slot + 1) & slot_mask) {
+                auto const index = table->slots[slot] - 1u;
+                if (table->hashes[index] == hash && ascii_iequals(table->fields[index].name, name))
+                    return table->fields[index].value;
+            }
+            return {};
+        }
+
+        /**
+         * Build the index if needed, and find the field
+         */
+        template <typename Fill>
+        [[nodiscard]] stl::string_view find(stl::string_view name, Fill&& fill) {
+            build(stl::forward<Fill>(fill));
+            return find(name);
+        }
+
+        /**
+         * The fields, in their order
+         */
+        [[nodiscard]] stl::span<field const> fields() const noexcept {
+            return table ? stl::span<field const>{table->fields.data(), table->count} : stl::span<field const>{};
+        }
+
+        /**
+         * There were more fields than what's kept; a name that's not found
+         * may be in the ones after them.
+         */
+        [[nodiscard]] bool overflowed() const noexcept {
+            return table && table->overflowed;
+        }
+
+        /**
+         * Forget the fields; the next lookup indexes them again
+         */
+        void clear() noexcept {
+            table.reset();
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_HTTP_HEADER_INDEX_H
@@ -0,0 +1,103 @@
+#ifndef WEBPP_HTTP_HEADER_SANITIZER_H
+#define WEBPP_HTTP_HEADER_SANITIZER_H
+
+#include "../std/std.hpp"
+
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#    define WEBPP_HEADER_SANITIZER_WIDTH 32
+#elif defined(__SSE2__)
+#    include <emmintrin.h>
+#    define WEBPP_HEADER_SANITIZER_WIDTH 16
+#else
+#    define WEBPP_HEADER_SANITIZER_WIDTH 1
+#endif
+
+namespace webpp {
+
+    /**
+     * Finds the bytes that should never be in the name or the value of a
+     * response header field: CR and LF (they'd end the field early and start
+     * a new one, which is a header injection) and NUL.
+     *
+     * Looks at 16 (SSE2) or 32 (AVX2) bytes at a time like the HTTP/1.1
+     * scanner; the tail and the constant evaluation are done one byte at a
+     * time.
+     */
+    struct header_sanitizer {
+        static constexpr stl::size_t width = WEBPP_HEADER_SANITIZER_WIDTH;
+
+        [[nodiscard]] static constexpr bool is_unsafe(char c) noexcept {
+            return c == '\r' || c == '\n' || c == '\0';
+        }
+
+        /**
+         * The position of the first unsafe byte at or after "pos"; npos if
+         * there's none.
+         */
+        [[nodiscard]] static constexpr stl::size_t find(stl::string_view data, stl::size_t pos = 0) noexcept {
+#if WEBPP_HEADER_SANITIZER_WIDTH > 1
+            if (!stl::is_constant_evaluated()) {
+                auto const* const begin = data.data();
+#    if WEBPP_HEADER_SANITIZER_WIDTH == 32
+                auto const cr  = _mm256_set1_epi8('\r');
+                auto const lf  = _mm256_set1_epi8('\n');
+                auto const nul = _mm256_setzero_si256();
+                for (; pos + width <= data.size(); pos += width) {
+                    auto const chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(begin + pos));
+                    auto const eq    = _mm256_or_si256(
+                      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, cr), _mm256_cmpeq_epi8(chunk, lf)),
+                      _mm256_cmpeq_epi8(chunk, nul));
+                    auto const mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+                    if (mask != 0)
+                        return pos + static_cast<stl::size_t>(__builtin_ctz(mask));
+                }
+#    else
+                auto const cr  = _mm_set1_epi8('\r');
+                auto const lf  = _mm_set1_epi8('\n');
+                auto const nul = _mm_setzero_si128();
+                for (; pos + width <= data.size(); pos += width) {
+                    auto const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(begin + pos));
+                    auto const eq =
+                      _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, cr), _mm_cmpeq_epi8(chunk, lf)),
+                                   _mm_cmpeq_epi8(chunk, nul));
+                    auto const mask = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+                    if (mask != 0)
+                        return pos + static_cast<stl::size_t>(__builtin_ctz(mask));
+                }
+#    endif
+            }
+#endif
+            for (; pos < data.size(); pos++)
+                if (is_unsafe(data[pos]))
+                    return pos;
+            return stl::string_view::npos;
+        }
+
+        /**
+         * Replace the unsafe bytes of the string with spaces; the strings that
+         * don't have any (almost all of them) are only read once.
+         * @returns true if the string was safe
+         */
+        template <typename StringType>
+        static constexpr bool sanitize(StringType& str) noexcept {
+            stl::string_view const data{str.data(), str.size()};
+            auto                   pos = find(data);
+            if (pos == stl::string_view::npos)
+                return true;
+            for (; pos < str.size(); pos++)
+                if (is_unsafe(str[pos]))
+                    str[pos] = ' ';
+            return false;
+        }
+    };
+
+} // namespace webpp
+
+#undef WEBPP_HEADER_SANITIZER_WIDTH
+
+#endif // WEBPP_HTTP_HEADER_SANITIZER_H
@@ -4,6 +4,7 @@
 #include "../traits/traits_concepts.hpp"
 #include "./application_concepts.hpp"
 #include "./interfaces/basic_interface_concepts.hpp"
+#include "./interfaces/common/prefork.hpp"
 #include "./routes/router.hpp"
 
 namespace webpp {
@@ -23,6 +24,34 @@ namespace webpp {
             InterfaceType::operator()();
             return 0; // success
         }
+
+        /**
+         * Run the interface in the prefork mode: this process opens the
+         * listening sockets, and the workers (the forked copies of it) serve
+         * them; see common::prefork. The worker threads of each process
+         * come from the options (one by default); the processes are the
+         * concurrency here. Only the interfaces that can adopt the sockets
+         * (simple_server and fcgi) support it.
+         * @returns zero if the workers exited on their own, or the signal
+         *          that stopped them
+         */
+        int run(common::prefork_options const& options) noexcept
+          requires requires(InterfaceType& iface, stl::span<int const> handles) {
+              iface.adopt_listeners(handles);
+              iface.listen_endpoints();
+          }
+        {
+            if constexpr (requires { this->concurrency(options.worker_threads); })
+                this->concurrency(options.worker_threads);
+            common::prefork supervisor{options};
+            if (!supervisor.listen(this->listen_endpoints()))
+                return 1;
+            return supervisor.run([this](common::prefork_worker const& worker) {
+                this->adopt_listeners(worker.listeners);
+                InterfaceType::operator()();
+                return 0;
+            });
+        }
     };
 
     // todo: we can provide more tools for traits here so the user can get the allocators from the interface (for app)
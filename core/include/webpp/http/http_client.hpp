@@ -0,0 +1,667 @@
+#ifndef WEBPP_HTTP_HTTP_CLIENT_H
+#define WEBPP_HTTP_HTTP_CLIENT_H
+
+#include "../std/buffer.hpp"
+#include "../std/coroutine.hpp"
+#include "../std/internet.hpp"
+#include "../std/io_context.hpp"
+#include "../std/socket.hpp"
+#include "../std/timer.hpp"
+#include "../utils/deadline.hpp"
+#include "../utils/task.hpp"
+#include "./interfaces/http1/response_parser.hpp"
+
+#include <array>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/write.hpp>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * An HTTP/1.1 client for calling the upstream services from the routes; it
+ * runs on the io_context of the worker that the route runs on, so a route
+ * that returns a task can wait for it without blocking the thread:
+ *
+ *   http_client upstream{srv.io};
+ *   ...
+ *   auto res = co_await upstream.get("users.internal", 8080, "/users/42", ctx.cancellation);
+ *   if (!res)
+ *       co_return stl::nullopt;
+ *
+ * The connections are kept alive in a pool for each host, and they're
+ * reused for the next requests; the idempotent requests can be pipelined on
+ * them too (see client_options::max_pipeline).
+ */
+namespace webpp {
+
+    struct client_options {
+        // the open connections to each host (the idle ones, and the busy ones)
+        stl::size_t max_connections_per_host = 8;
+
+        // the requests in flight on one connection; 1 means no pipelining. Only
+        // the idempotent requests are pipelined, and only when all the
+        // connections to the host are open and busy.
+        stl::size_t max_pipeline = 1;
+
+        // an idle connection is not reused after this long
+        stl::chrono::steady_clock::duration idle_timeout = stl::chrono::seconds{30};
+
+        // the timeout of a request, if its cancellation token has no earlier deadline; zero means none
+        stl::chrono::steady_clock::duration timeout = stl::chrono::seconds{30};
+
+        stl::size_t max_response_size = 16 * 1024 * 1024;
+    };
+
+    struct client_request {
+        stl::string                                         method = "GET";
+        stl::string                                         target = "/";
+        stl::vector<stl::pair<stl::string, stl::string>>    headers{};
+        stl::string                                         body{};
+    };
+
+    enum struct client_error {
+        none,
+        connect_failed,    // resolving or connecting failed
+        connection_closed, // the connection is closed before the response is complete
+        bad_response,      // the response is not valid HTTP/1.1
+        too_large,         // the response is bigger than the max_response_size
+        timed_out,         // the deadline has passed
+        cancelled          // the token is cancelled, or the client is destroyed
+    };
+
+    struct client_response {
+        client_error                                     error  = client_error::none;
+        unsigned                                         status = 0;
+        stl::string                                      reason{};
+        stl::vector<stl::pair<stl::string, stl::string>> headers{};
+        stl::string                                      body{};
+
+        [[nodiscard]] stl::string_view header(stl::string_view name) const noexcept {
+            for (auto const& [key, value] : headers)
+                if (http1::iequals(key, name))
+                    return value;
+            return {};
+        }
+
+        // there's a response (of any status)
+        [[nodiscard]] explicit operator bool() const noexcept {
+            return error == client_error::none;
+        }
+    };
+
+    class http_client;
+
+    namespace details {
+
+        class client_connection;
+
+        /**
+         * A request and its response; it's shared between the awaiting
+         * coroutine, the connection that it's sent on, and its timer.
+         */
+        struct client_exchange {
+            stl::string                                 wire; // the serialized request
+            client_response                             response{};
+            bool                                        head       = false;
+            bool                                        idempotent = false;
+            bool                                        done       = false;
+            unsigned                                    attempts   = 0;
+            stl::coroutine_handle<>                     waiter{};
+            stl::optional<stl::net::steady_timer>       timer{};
+            stl::weak_ptr<client_connection>            conn{};
+            stl::net::io_context*                       io = nullptr;
+
+            /**
+             * Finish it, and resume the awaiting coroutine; it's resumed later
+             * (not in the middle of the connection's handlers).
+             */
+            void complete(client_error err = client_error::none) {
+                if (done)
+                    return;
+                done           = true;
+                response.error = err;
+                if (timer)
+                    timer->cancel();
+                if (waiter)
+                    stl::net::post(*io, [handle = stl::exchange(waiter, {})] {
+                        handle.resume();
+                    });
+            }
+        };
+
+        using exchange_ptr = stl::shared_ptr<client_exchange>;
+
+        struct host_pool {
+            stl::string                                   host;
+            stl::uint16_t                                 port = 0;
+            stl::vector<stl::shared_ptr<client_connection>> connections{};
+            stl::deque<exchange_ptr>                      queue{}; // the ones waiting for a connection
+            bool                                          dispatching = false;
+        };
+
+        [[nodiscard]] inline bool is_idempotent(stl::string_view method) noexcept {
+            return method == "GET" || method == "HEAD" || method == "PUT" || method == "DELETE" ||
+                   method == "OPTIONS" || method == "TRACE";
+        }
+
+        inline void serialize_request(stl::string&          out,
+                                      client_request const& req,
+                                      stl::string_view      host,
+                                      stl::uint16_t         port) {
+            out.reserve(req.method.size() + req.target.size() + host.size() + req.body.size() + 64 +
+                        req.headers.size() * 32);
+            out.append(req.method).append(" ").append(req.target).append(" HTTP/1.1\r\n");
+            bool has_host = false;
+            for (auto const& [name, value] : req.headers) {
+                has_host |= http1::iequals(name, "Host");
+                out.append(name).append(": ").append(value).append("\r\n");
+            }
+            if (!has_host) {
+                out.append("Host: ").append(host);
+                if (port != 80)
+                    out.append(":").append(stl::to_string(port));
+                out.append("\r\n");
+            }
+            if (!req.body.empty() || req.method == "POST" || req.method == "PUT")
+                out.append("Content-Length: ").append(stl::to_string(req.body.size())).append("\r\n");
+            out.append("\r\n").append(req.body);
+        }
+
+        /**
+         * A keep-alive connection to a host; the requests are written in order,
+         * and the responses are matched to them in the same order.
+         */
+        class client_connection : public stl::enable_shared_from_this<client_connection> {
+          public:
+            using socket_t   = stl::net::ip::tcp::socket;
+            using resolver_t = stl::net::ip::tcp::resolver;
+
+            // the pool and the client are nulled when the client is destroyed
+            host_pool*   pool   = nullptr;
+            http_client* client = nullptr;
+
+            stl::deque<exchange_ptr>              in_flight{};
+            stl::chrono::steady_clock::time_point idle_since = stl::chrono::steady_clock::now();
+            bool                                  connected  = false;
+            bool                                  closed     = false;
+
+          private:
+            socket_t                             socket;
+            resolver_t                           resolver;
+            stl::array<char, 16 * 1024>          buffer{};
+            stl::string                          in;
+            stl::string                          out;
+            stl::string                          writing_out;
+            bool                                 writing = false;
+
+          public:
+            client_connection(stl::net::io_context& io, host_pool& _pool, http_client& _client)
+              : pool{&_pool},
+                client{&_client},
+                socket{io},
+                resolver{io} {}
+
+            void connect();
+            void send(exchange_ptr const& ex);
+            void close();
+
+            [[nodiscard]] bool is_idle() const noexcept {
+                return connected && !closed && in_flight.empty();
+            }
+
+            [[nodiscard]] bool can_pipeline(stl::size_t max_pipeline) const noexcept {
+                if (closed || in_flight.size() >= max_pipeline)
+                    return false;
+                for (auto const& ex : in_flight)
+                    if (!ex->idempotent)
+                        return false;
+                return true;
+            }
+
+          private:
+            void write();
+            void read();
+            void on_read(istl::net_error_code const& err, stl::size_t bytes);
+
+            /**
+             * Match the responses that are complete in the input to the requests
+             * @returns false if the connection is closed
+             */
+            bool parse(bool eof);
+
+            // the connection is lost, or the response said so
+            void lost(client_error err);
+        };
+
+    } // namespace details
+
+    /**
+     * The client; one of them belongs to each io thread (it's not
+     * thread-safe), and it should outlive the io_context's run, or be
+     * destroyed on its thread. The pending requests are cancelled when it's
+     * destroyed.
+     */
+    class http_client {
+        friend class details::client_connection;
+
+        using exchange_ptr = details::exchange_ptr;
+
+        stl::net::io_context*                                                io;
+        client_options                                                       options;
+        stl::unordered_map<stl::string, stl::unique_ptr<details::host_pool>> pools;
+
+        details::host_pool& pool_of(stl::string_view host, stl::uint16_t port) {
+            auto key = stl::string{host};
+            key.append(":").append(stl::to_string(port));
+            auto& pool = pools[key];
+            if (!pool) {
+                pool       = stl::make_unique<details::host_pool>();
+                pool->host = host;
+                pool->port = port;
+            }
+            return *pool;
+        }
+
+        void submit(details::host_pool& pool, exchange_ptr const& ex) {
+            pool.queue.push_back(ex);
+            dispatch(pool);
+        }
+
+        /**
+         * Give the queued requests to the connections: an idle one, a new one,
+         * or a busy one that they can be pipelined on.
+         */
+        void dispatch(details::host_pool& pool) {
+            if (pool.dispatching)
+                return; // the closed connections call us again
+            pool.dispatching = true;
+
+            // the idle connections that the server may have forgotten about
+            auto const now = stl::chrono::steady_clock::now();
+            for (stl::size_t i = pool.connections.size(); i-- > 0;) {
+                auto& conn = *pool.connections[i];
+                if (conn.is_idle() && now - conn.idle_since >= options.idle_timeout)
+                    conn.close(); // it removes itself from the pool
+            }
+
+            while (!pool.queue.empty()) {
+                auto ex = pool.queue.front();
+                if (ex->done) { // it's timed out while waiting
+                    pool.queue.pop_front();
+                    continue;
+                }
+
+                details::client_connection* chosen = nullptr;
+                for (auto const& conn : pool.connections) {
+                    if (conn->is_idle()) {
+                        chosen = conn.get();
+                        break;
+                    }
+                }
+                if (!chosen && pool.connections.size() < options.max_connections_per_host) {
+                    auto conn = stl::make_shared<details::client_connection>(*io, pool, *this);
+                    pool.connections.push_back(conn);
+                    conn->connect();
+                    chosen = conn.get();
+                }
+                if (!chosen && options.max_pipeline > 1 && ex->idempotent) {
+                    for (auto const& conn : pool.connections) {
+                        if (conn->can_pipeline(options.max_pipeline) &&
+                            (!chosen || conn->in_flight.size() < chosen->in_flight.size()))
+                            chosen = conn.get();
+                    }
+                }
+                if (!chosen)
+                    break; // wait for a connection to be free
+                pool.queue.pop_front();
+                chosen->send(ex);
+            }
+            pool.dispatching = false;
+        }
+
+        /**
+         * Wait for the exchange; it's submitted when the coroutine is suspended
+         */
+        struct exchange_awaiter {
+            http_client&        client;
+            details::host_pool& pool;
+            exchange_ptr const& ex; // it's trivially destructible, like a temporary should be in a co_await
+
+            bool await_ready() const noexcept {
+                return ex->done;
+            }
+
+            void await_suspend(stl::coroutine_handle<> handle) {
+                ex->waiter = handle;
+                client.submit(pool, ex);
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        task<client_response> perform(details::host_pool& pool, exchange_ptr ex) {
+            co_await exchange_awaiter{*this, pool, ex};
+            co_return stl::move(ex->response);
+        }
+
+        void start_timer(exchange_ptr const& ex, cancellation_token const& token) {
+            auto deadline = token.deadline();
+            if (options.timeout != stl::chrono::steady_clock::duration::zero())
+                deadline = stl::min(deadline, stl::chrono::steady_clock::now() + options.timeout);
+            if (deadline == deadline_clock::time_point::max())
+                return;
+            ex->timer.emplace(*io);
+            ex->timer->expires_at(deadline);
+            ex->timer->async_wait([weak = stl::weak_ptr<details::client_exchange>{ex}](istl::net_error_code const&) {
+                auto ex = weak.lock();
+                if (!ex || ex->done)
+                    return; // it's done, or the client is destroyed
+                auto conn = ex->conn.lock();
+                ex->complete(client_error::timed_out);
+                // the responses after it can't be matched to their requests
+                // if we skip this one, so the connection is closed
+                if (conn && !conn->closed)
+                    conn->close();
+            });
+        }
+
+      public:
+        explicit http_client(stl::net::io_context& _io, client_options const& _options = {})
+          : io{&_io},
+            options{_options} {}
+
+        http_client(http_client const&)            = delete;
+        http_client& operator=(http_client const&) = delete;
+
+        ~http_client() {
+            for (auto& [key, pool] : pools) {
+                for (auto& ex : pool->queue)
+                    ex->complete(client_error::cancelled);
+                for (auto& conn : pool->connections) {
+                    conn->pool   = nullptr;
+                    conn->client = nullptr;
+                    for (auto& ex : conn->in_flight)
+                        ex->complete(client_error::cancelled);
+                    conn->in_flight.clear();
+                    conn->close();
+                }
+            }
+        }
+
+        [[nodiscard]] client_options const& get_options() const noexcept {
+            return options;
+        }
+
+        /**
+         * Send the request to the host, on a pooled connection; the token's
+         * deadline (or options.timeout, whichever is earlier) is the deadline of
+         * the whole exchange, and a cancelled token cancels it before it's sent.
+         */
+        task<client_response> request(stl::string_view          host,
+                                      stl::uint16_t             port,
+                                      client_request const&     req,
+                                      cancellation_token const& token = {}) {
+            if (token.is_cancelled())
+                return task<client_response>::ready(client_response{.error = client_error::cancelled});
+            // the request is serialized right away, so the coroutine only keeps the exchange
+            auto ex        = stl::make_shared<details::client_exchange>();
+            ex->io         = io;
+            ex->head       = req.method == "HEAD";
+            ex->idempotent = details::is_idempotent(req.method);
+            details::serialize_request(ex->wire, req, host, port);
+            start_timer(ex, token);
+            return perform(pool_of(host, port), stl::move(ex));
+        }
+
+        task<client_response> get(stl::string_view          host,
+                                  stl::uint16_t             port,
+                                  stl::string_view          target,
+                                  cancellation_token const& token = {}) {
+            return request(host, port, client_request{.target = stl::string{target}}, token);
+        }
+
+        /**
+         * The open connections to the host, the idle ones and the busy ones
+         */
+        [[nodiscard]] stl::size_t connection_count(stl::string_view host, stl::uint16_t port) const {
+            auto key = stl::string{host};
+            key.append(":").append(stl::to_string(port));
+            auto const it = pools.find(key);
+            return it == pools.end() ? 0 : it->second->connections.size();
+        }
+    };
+
+    namespace details {
+
+        inline void client_connection::connect() {
+            resolver.async_resolve(
+              pool->host,
+              stl::to_string(pool->port),
+              [self = shared_from_this()](istl::net_error_code const& err, resolver_t::results_type const& results) {
+                  if (self->closed)
+                      return;
+                  if (err) {
+                      self->lost(client_error::connect_failed);
+                      return;
+                  }
+                  stl::net::async_connect(self->socket,
+                                          results,
+                                          [self](istl::net_error_code const& err, auto const&) {
+                                              if (self->closed)
+                                                  return;
+                                              if (err) {
+                                                  self->lost(client_error::connect_failed);
+                                                  return;
+                                              }
+                                              self->connected = true;
+                                              istl::net_error_code ignored;
+                                              self->socket.set_option(stl::net::ip::tcp::no_delay{true}, ignored);
+                                              self->read();
+                                              self->write();
+                                          });
+              });
+        }
+
+        inline void client_connection::send(exchange_ptr const& ex) {
+            ex->attempts++;
+            ex->conn = weak_from_this();
+            in_flight.push_back(ex);
+            out.append(ex->wire);
+            write();
+        }
+
+        inline void client_connection::write() {
+            if (!connected || closed || writing || out.empty())
+                return;
+            writing = true;
+            writing_out.clear();
+            stl::swap(writing_out, out);
+            stl::net::async_write(socket,
+                                  stl::net::buffer(writing_out),
+                                  [self = shared_from_this()](istl::net_error_code const& err, stl::size_t) {
+                                      self->writing = false;
+                                      if (self->closed)
+                                          return;
+                                      if (err) {
+                                          self->lost(client_error::connection_closed);
+                                          return;
+                                      }
+                                      self->write();
+                                  });
+        }
+
+        inline void client_connection::read() {
+            socket.async_read_some(stl::net::buffer(buffer),
+                                   [self = shared_from_this()](istl::net_error_code const& err, stl::size_t bytes) {
+                                       self->on_read(err, bytes);
+                                   });
+        }
+
+        inline void client_connection::on_read(istl::net_error_code const& err, stl::size_t bytes) {
+            if (closed)
+                return;
+            if (err) {
+                // the server has closed it; it may be the end of a response too
+                if (parse(true))
+                    lost(client_error::connection_closed);
+                return;
+            }
+            in.append(buffer.data(), bytes);
+            if (parse(false))
+                read();
+        }
+
+        inline bool client_connection::parse(bool eof) {
+            while (!in_flight.empty()) {
+                auto& ex = in_flight.front();
+
+                http1::response_view head{};
+                stl::size_t          head_size = 0;
+                auto const           status    = http1::parse_response_head(in, head, head_size);
+                if (status == http1::parse_status::incomplete)
+                    return true;
+                if (status == http1::parse_status::error) {
+                    ex->complete(client_error::bad_response);
+                    in_flight.pop_front();
+                    lost(client_error::connection_closed);
+                    return false;
+                }
+                if (head.status < 200 && head.status != 101) {
+                    in.erase(0, head_size); // 100 Continue, 103 Early Hints
+                    continue;
+                }
+
+                auto const  max_size = client ? client->options.max_response_size : in.size();
+                stl::size_t length   = 0;
+                stl::size_t consumed = 0;
+                auto&       res      = ex->response;
+                switch (http1::response_framing(head, ex->head, length)) {
+                    case http1::body_framing::none: consumed = head_size; break;
+                    case http1::body_framing::content_length:
+                        if (length > max_size) {
+                            ex->complete(client_error::too_large);
+                            in_flight.pop_front();
+                            lost(client_error::connection_closed);
+                            return false;
+                        }
+                        if (in.size() - head_size < length)
+                            return true;
+                        res.body.assign(in, head_size, length);
+                        consumed = head_size + length;
+                        break;
+                    case http1::body_framing::chunked: {
+                        stl::size_t body_size = 0;
+                        auto const  chunks = http1::parse_chunked_body(stl::string_view{in}.substr(head_size),
+                                                                      res.body,
+                                                                      body_size);
+                        if (chunks == http1::parse_status::incomplete && in.size() <= max_size + head_size)
+                            return true;
+                        if (chunks != http1::parse_status::complete) {
+                            ex->complete(chunks == http1::parse_status::error ? client_error::bad_response
+                                                                              : client_error::too_large);
+                            in_flight.pop_front();
+                            lost(client_error::connection_closed);
+                            return false;
+                        }
+                        consumed = head_size + body_size;
+                        break;
+                    }
+                    case http1::body_framing::until_close:
+                        if (!eof && in.size() <= max_size + head_size)
+                            return true;
+                        if (!eof) {
+                            ex->complete(client_error::too_large);
+                            in_flight.pop_front();
+                            lost(client_error::connection_closed);
+                            return false;
+                        }
+                        res.body.assign(in, head_size);
+                        consumed = in.size();
+                        break;
+                }
+
+                res.status = head.status;
+                res.reason = head.reason;
+                res.headers.reserve(head.header_count);
+                for (stl::size_t i = 0; i < head.header_count; i++)
+                    res.headers.emplace_back(head.headers[i].name, head.headers[i].value);
+                auto const keep_alive = head.keep_alive() && !eof;
+                in.erase(0, consumed);
+                ex->complete();
+                in_flight.pop_front();
+
+                if (!keep_alive) {
+                    lost(client_error::connection_closed);
+                    return false;
+                }
+            }
+            if (eof)
+                return true;
+            if (!in.empty()) {
+                // the server is sending what nobody has asked for
+                lost(client_error::connection_closed);
+                return false;
+            }
+            idle_since = stl::chrono::steady_clock::now();
+            if (pool && client)
+                client->dispatch(*pool);
+            return !closed;
+        }
+
+        inline void client_connection::lost(client_error err) {
+            if (!connected) {
+                // there's no other connection that would do better
+                for (auto& ex : in_flight)
+                    ex->complete(err);
+                in_flight.clear();
+            }
+            close();
+        }
+
+        inline void client_connection::close() {
+            if (closed)
+                return;
+            closed = true;
+            istl::net_error_code ignored;
+            resolver.cancel();
+            socket.shutdown(socket_t::shutdown_both, ignored);
+            socket.close(ignored);
+
+            // the idempotent requests are sent once more on another connection
+            // (it's usually a keep-alive connection that the server has closed
+            // just before our requests, or the ones behind a timed out one);
+            // the others may have been done already
+            auto pending = stl::move(in_flight);
+            in_flight.clear();
+            for (auto it = pending.rbegin(); it != pending.rend(); ++it) {
+                auto& ex = *it;
+                if (ex->done)
+                    continue;
+                if (pool && ex->idempotent && ex->attempts < 2) {
+                    pool->queue.push_front(ex);
+                } else {
+                    ex->complete(client_error::connection_closed);
+                }
+            }
+            if (!pool)
+                return;
+            auto self = shared_from_this(); // it's the pool that owns us
+            stl::erase(pool->connections, self);
+            if (client)
+                client->dispatch(*pool);
+        }
+
+    } // namespace details
+
+} // namespace webpp
+
+#endif // WEBPP_HTTP_HTTP_CLIENT_H
@@ -0,0 +1,264 @@
+#ifndef WEBPP_HTTP_HTTP_DATE_H
+#define WEBPP_HTTP_HTTP_DATE_H
+
+#include "../std/std.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string_view>
+
+namespace webpp {
+
+    /**
+     * The size of an HTTP-date (IMF-fixdate), like "Sun, 06 Nov 1994 08:49:37 GMT"
+     */
+    static constexpr stl::size_t http_date_size = 29;
+
+    /**
+     * Write the HTTP-date of the seconds since the epoch into "out" (http_date_size chars); it's always in
+     * GMT, and it doesn't touch the locale or the time zone, so it's safe in every thread (unlike
+     * strftime with gmtime/localtime). The years after 9999 are written as 9999.
+     */
+    constexpr void format_http_date(stl::int64_t seconds, char* out) noexcept {
+        constexpr stl::string_view week_days = "ThuFriSatSunMonTueWed"; // 1970-01-01 was a Thursday
+        constexpr stl::string_view months    = "JanFebMarAprMayJunJulAugSepOctNovDec";
+        constexpr stl::int64_t     day       = 86'400;
+
+        auto       days = seconds / day;
+        auto       secs = seconds % day;
+        if (secs < 0) {
+            secs += day;
+            days--;
+        }
+        auto const week_day = ((days % 7) + 7) % 7;
+
+        // the civil date of the days since the epoch (Howard Hinnant's days_from_civil, backwards)
+        auto const shifted = days + 719'468;
+        auto const era     = (shifted >= 0 ? shifted : shifted - 146'096) / 146'097;
+        auto const doe     = shifted - era * 146'097;
+        auto const yoe     = (doe - doe / 1460 + doe / 36'524 - doe / 146'096) / 365;
+        auto const doy     = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        auto const mp      = (5 * doy + 2) / 153;
+        auto const month   = mp < 10 ? mp + 3 : mp - 9;
+        auto       year    = yoe + era * 400 + (month <= 2 ? 1 : 0);
+        auto const mday    = doy - (153 * mp + 2) / 5 + 1;
+        year               = year < 0 ? 0 : year > 9999 ? 9999 : year;
+
+        auto const two = [](char* ptr, stl::int64_t value) constexpr noexcept {
+            ptr[0] = static_cast<char>('0' + value / 10);
+            ptr[1] = static_cast<char>('0' + value % 10);
+        };
+        for (stl::size_t i = 0; i < 3; i++) {
+            out[i]     = week_days[static_cast<stl::size_t>(week_day) * 3 + i];
+            out[8 + i] = months[static_cast<stl::size_t>(month - 1) * 3 + i];
+        }
+        out[3] = ',';
+        out[4] = ' ';
+        two(out + 5, mday);
+        out[7]  = ' ';
+        out[11] = ' ';
+        two(out + 12, year / 100);
+        two(out + 14, year % 100);
+        out[16] = ' ';
+        two(out + 17, secs / 3600);
+        out[19] = ':';
+        two(out + 20, secs / 60 % 60);
+        out[22] = ':';
+        two(out + 23, secs % 60);
+        out[25] = ' ';
+        out[26] = 'G';
+        out[27] = 'M';
+        out[28] = 'T';
+    }
+
+    /**
+     * The seconds since the epoch of an HTTP-date (IMF-fixdate, like "Sun, 06 Nov 1994 08:49:37 GMT"); the
+     * obsolete formats (RFC 850, asctime) and the invalid dates are nullopt. The week day is not checked.
+     */
+    [[nodiscard]] constexpr stl::optional<stl::int64_t> parse_http_date(stl::string_view str) noexcept {
+        constexpr stl::string_view months = "JanFebMarAprMayJunJulAugSepOctNovDec";
+        if (str.size() != http_date_size || str[3] != ',' || str[4] != ' ' || str[7] != ' ' ||
+            str[11] != ' ' || str[16] != ' ' || str[19] != ':' || str[22] != ':' || str.substr(25) != " GMT")
+            return stl::nullopt;
+
+        bool       valid  = true;
+        auto const digits = [&](stl::size_t pos, stl::size_t count) constexpr noexcept {
+            stl::int64_t value = 0;
+            for (stl::size_t i = pos; i < pos + count; i++) {
+                valid = valid && str[i] >= '0' && str[i] <= '9';
+                value = value * 10 + (str[i] - '0');
+            }
+            return value;
+        };
+        auto const mday  = digits(5, 2);
+        auto const year  = digits(12, 4);
+        auto const hour  = digits(17, 2);
+        auto const min   = digits(20, 2);
+        auto const sec   = digits(23, 2);
+        auto       month = stl::int64_t{1};
+        while (month <= 12 && months.substr(static_cast<stl::size_t>(month - 1) * 3, 3) != str.substr(8, 3))
+            month++;
+        if (!valid || month > 12 || mday < 1 || mday > 31 || hour > 23 || min > 59 || sec > 60)
+            return stl::nullopt;
+
+        // Howard Hinnant's days_from_civil
+        auto const y   = year - (month <= 2 ? 1 : 0);
+        auto const era = y / 400;
+        auto const yoe = y - era * 400;
+        auto const doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + mday - 1;
+        auto const doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        auto const day = era * 146'097 + doe - 719'468;
+        return day * 86'400 + hour * 3600 + min * 60 + sec;
+    }
+
+    /**
+     * The HTTP-dates of the last few seconds, shared between the threads; the Date headers and the
+     * cookies that expire in a fixed time from now are formatted once per second, and the rest of them
+     * are copies.
+     *
+     * Each slot is a seqlock: the readers copy the words of the date and check that the second of the
+     * slot didn't change while they did; one writer at a time fills a slot, and the others (and the
+     * readers of a slot that's being written) format the date themselves.
+     */
+    class http_date_cache {
+        static constexpr stl::size_t  slot_count = 16;
+        static constexpr stl::size_t  word_count = (http_date_size + 7) / 8;
+        static constexpr stl::int64_t none       = stl::numeric_limits<stl::int64_t>::min();
+
+        struct slot {
+            stl::atomic<stl::int64_t>                          second{none};
+            stl::array<stl::atomic<stl::uint64_t>, word_count> words{};
+        };
+
+        stl::array<slot, slot_count> slots{};
+        stl::atomic_flag             writing{};
+
+      public:
+        /**
+         * Write the HTTP-date of the seconds since the epoch into "out" (http_date_size chars)
+         */
+        void format(stl::int64_t seconds, char* out) noexcept {
+            auto& entry = slots[static_cast<stl::uint64_t>(seconds) % slot_count];
+            stl::array<stl::uint64_t, word_count> words;
+            if (entry.second.load(stl::memory_order_acquire) == seconds) {
+                for (stl::size_t i = 0; i < word_count; i++)
+                    words[i] = entry.words[i].load(stl::memory_order_relaxed);
+                stl::atomic_thread_fence(stl::memory_order_acquire);
+                if (entry.second.load(stl::memory_order_relaxed) == seconds) {
+                    stl::memcpy(out, words.data(), http_date_size);
+                    return;
+                }
+            }
+
+            format_http_date(seconds, out);
+            if (writing.test_and_set(stl::memory_order_acquire))
+                return; // another thread is filling a slot
+            words.back() = 0;
+            stl::memcpy(words.data(), out, http_date_size);
+            entry.second.store(none, stl::memory_order_relaxed);
+            stl::atomic_thread_fence(stl::memory_order_release);
+            for (stl::size_t i = 0; i < word_count; i++)
+                entry.words[i].store(words[i], stl::memory_order_relaxed);
+            entry.second.store(seconds, stl::memory_order_release);
+            writing.clear(stl::memory_order_release);
+        }
+    };
+
+    /**
+     * The HTTP-date of the current second, for the Date headers of the responses; it's formatted once
+     * per second, and all of the io threads copy it.
+     *
+     * It's double buffered: the readers copy the date of the current buffer, while the first thread that
+     * sees a new second fills the other one and then makes it the current one, so the writer is never in
+     * the way of the readers of the date that's being replaced. The readers still check the second of the
+     * buffer after copying it, in case it was filled again (two seconds later) while they were reading.
+     */
+    class http_date_clock {
+        static constexpr stl::size_t  word_count = (http_date_size + 7) / 8;
+        static constexpr stl::int64_t none       = stl::numeric_limits<stl::int64_t>::min();
+
+        struct buffer {
+            stl::atomic<stl::int64_t>                          second{none};
+            stl::array<stl::atomic<stl::uint64_t>, word_count> words{};
+        };
+
+        stl::array<buffer, 2>     buffers{};
+        stl::atomic<stl::uint8_t> current{0};
+        stl::atomic_flag          writing{};
+
+      public:
+        /**
+         * Write the HTTP-date of the seconds since the epoch into "out" (http_date_size chars); the
+         * seconds are expected to be now, the other ones are formatted each time.
+         */
+        void format(stl::int64_t seconds, char* out) noexcept {
+            auto const index = current.load(stl::memory_order_acquire);
+            auto&      front = buffers[index];
+            auto const front_second = front.second.load(stl::memory_order_acquire);
+            stl::array<stl::uint64_t, word_count> words;
+            if (front_second == seconds) {
+                for (stl::size_t i = 0; i < word_count; i++)
+                    words[i] = front.words[i].load(stl::memory_order_relaxed);
+                stl::atomic_thread_fence(stl::memory_order_acquire);
+                if (front.second.load(stl::memory_order_relaxed) == seconds) {
+                    stl::memcpy(out, words.data(), http_date_size);
+                    return;
+                }
+            }
+
+            format_http_date(seconds, out);
+            if (seconds < front_second || writing.test_and_set(stl::memory_order_acquire))
+                return; // an old second, or another thread is flipping the buffers
+            if (current.load(stl::memory_order_relaxed) == index) {
+                auto& back   = buffers[index ^ 1u];
+                words.back() = 0;
+                stl::memcpy(words.data(), out, http_date_size);
+                back.second.store(none, stl::memory_order_relaxed);
+                stl::atomic_thread_fence(stl::memory_order_release);
+                for (stl::size_t i = 0; i < word_count; i++)
+                    back.words[i].store(words[i], stl::memory_order_relaxed);
+                back.second.store(seconds, stl::memory_order_release);
+                current.store(static_cast<stl::uint8_t>(index ^ 1u), stl::memory_order_release);
+            }
+            writing.clear(stl::memory_order_release);
+        }
+
+        /**
+         * Write the HTTP-date of now into "out" (http_date_size chars)
+         */
+        void now(char* out) noexcept {
+            auto const seconds =
+              stl::chrono::floor<stl::chrono::seconds>(stl::chrono::system_clock::now()).time_since_epoch();
+            format(static_cast<stl::int64_t>(seconds.count()), out);
+        }
+    };
+
+    namespace details {
+        inline http_date_cache shared_http_dates{};
+        inline http_date_clock shared_http_date_clock{};
+    } // namespace details
+
+    /**
+     * Write the HTTP-date of now into "out" (http_date_size chars), for the Date headers
+     */
+    inline void format_current_http_date(char* out) noexcept {
+        details::shared_http_date_clock.now(out);
+    }
+
+    /**
+     * Write the HTTP-date of the time into "out" (http_date_size chars), through the shared cache
+     */
+    inline void format_http_date(stl::chrono::system_clock::time_point time, char* out) noexcept {
+        auto const seconds = stl::chrono::floor<stl::chrono::seconds>(time).time_since_epoch().count();
+        details::shared_http_dates.format(static_cast<stl::int64_t>(seconds), out);
+    }
+
+} // namespace webpp
+
+#endif // WEBPP_HTTP_HTTP_DATE_H
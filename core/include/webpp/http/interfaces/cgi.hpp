@@ -2,6 +2,7 @@
 #define WEBPP_CGI_H
 
 #include "../../std/string_view.hpp"
+#include "../../traits/std_arena_traits.hpp"
 #include "../../traits/std_traits.hpp"
 #include "../../utils/casts.hpp"
 #include "../../utils/strings.hpp"
@@ -9,33 +10,99 @@
 #include "../request.hpp"
 #include "../response.hpp"
 #include "../routes/router.hpp"
+#include "./common/cgi_variables.hpp"
+#include "./common/constants.hpp"
+#include "./fcgi.hpp"
 
-#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
 #include <cstdlib>
 #include <functional>
-#include <iostream>
-#include <sstream>
+#include <limits>
+#include <optional>
+#ifndef WEBPP_CGI_RAW_IO
+#    include <iostream>
+#endif
 
 // TODO: use GetEnvironmentVariableA for Windows operating system
 #include <unistd.h> // for environ
+#ifdef __unix__
+#    include <sys/socket.h>
+#    include <sys/uio.h> // for writev
+#endif
 
 namespace webpp {
 
 
+    /**
+     * The CGI interface; each request is a new process and the request is
+     * in the environment variables and the stdin.
+     *
+     * If the web server starts us as a FastCGI application instead (it gives
+     * us a listening socket as the stdin), the same application is served in
+     * a FastCGI loop for as long as the web server wants; so you don't have
+     * to change anything to get rid of the process-per-request cost.
+     *
+     * With WEBPP_CGI_RAW_IO, the stdin and the stdout are read and written
+     * with read(2) and write(2) directly; cin and cout are never touched, so
+     * the process doesn't pay for setting up the iostreams and their locale
+     * before the first byte of the response. What's written with printf or
+     * cout (synced with stdio) is flushed before our own writes.
+     */
     template <Traits TraitsType, Application App>
     struct cgi {
       public:
         using traits_type      = TraitsType;
         using application_type = App;
         using interface_type   = cgi<traits_type, application_type>;
-        // todo: think about the extensions
-        using request_type     = basic_request<traits_type, interface_type>;
         using str_view_type    = typename TraitsType::string_view_type;
         using str_type         = typename TraitsType::string_type;
         using ostream_t        = typename TraitsType::ostream_type;
 
         application_type app;
 
+      private:
+        stl::optional<common::server> _server;
+
+      public:
+#ifdef WEBPP_CGI_RAW_IO
+        cgi() noexcept = default;
+
+        /**
+         * Read up to "length" bytes of the stdin; it's less than that only at
+         * the end of the stdin.
+         */
+        static stl::streamsize read(char* data, stl::streamsize length) noexcept {
+            stl::streamsize total = 0;
+            while (total < length) {
+                auto const res = ::read(STDIN_FILENO, data + total, static_cast<stl::size_t>(length - total));
+                if (res < 0 && errno == EINTR)
+                    continue;
+                if (res <= 0)
+                    break;
+                total += res;
+            }
+            return total;
+        }
+
+        /**
+         * Send data to the user
+         */
+        static void write(char const* data, stl::streamsize length) noexcept {
+            stl::fflush(stdout); // what has been written with printf goes first
+            while (length > 0) {
+                auto const res = ::write(STDOUT_FILENO, data, static_cast<stl::size_t>(length));
+                if (res < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    return;
+                }
+                data += res;
+                length -= res;
+            }
+        }
+#else
         cgi() noexcept {
             // I'm not using C here; so why should I pay for it!
             // And also the user should not use cin and cout. so ...
@@ -73,16 +140,63 @@ namespace webpp {
         static void write(char const* data, stl::streamsize length) noexcept {
             stl::cout.write(data, length);
         }
+#endif
+
+        /**
+         * Send the head and the body of the response; it's one writev on the
+         * stdout in the usual case, instead of copying them into the buffer
+         * of cout first.
+         */
+        static void write(str_view_type head, str_view_type body) noexcept {
+#ifdef __unix__
+#    ifdef WEBPP_CGI_RAW_IO
+            stl::fflush(stdout); // what has been written with printf goes first
+#    else
+            stl::cout.flush(); // what has been written with cout goes first
+#    endif
+            iovec  iovs[2] = {{const_cast<char*>(head.data()), head.size()},
+                              {const_cast<char*>(body.data()), body.size()}};
+            iovec* it      = iovs;
+            int    count   = 2;
+            while (count != 0) {
+                auto const res = ::writev(STDOUT_FILENO, it, count);
+                if (res < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    return;
+                }
+                // skip what has been written; it's usually everything
+                auto written = static_cast<stl::size_t>(res);
+                for (; count != 0 && written >= it->iov_len; ++it, --count)
+                    written -= it->iov_len;
+                if (count != 0) {
+                    it->iov_base = static_cast<char*>(it->iov_base) + written;
+                    it->iov_len -= written;
+                }
+            }
+#else
+            write(head.data(), static_cast<stl::streamsize>(head.size()));
+            write(body.data(), static_cast<stl::streamsize>(body.size()));
+#endif
+        }
+
+        /**
+         * The environment variables, indexed the first time they're needed;
+         * there's only one request in a CGI process, so this is once per
+         * request.
+         */
+        [[nodiscard]] static common::environ_index const& environment() noexcept {
+            static common::environ_index const index{::environ};
+            return index;
+        }
 
         /**
          * Get the environment value safely
          * @param key
          * @return
          */
-        [[nodiscard]] static stl::string_view env(char const* key) noexcept {
-            if (auto value = getenv(key))
-                return value;
-            return {};
+        [[nodiscard]] static stl::string_view env(stl::string_view key) noexcept {
+            return environment().get(key);
         }
 
         /**
@@ -90,16 +204,10 @@ namespace webpp {
          * @param name
          * @return
          */
-        [[nodiscard]] static str_view_type header(stl::string name) noexcept {
-            // fixme: check if this is all we have to do or we have to do more too:
-            stl::transform(name.begin(), name.end(), name.begin(), [](auto const& c) {
-                if (c == '-')
-                    return '_';
-                return static_cast<char>(stl::toupper(c));
-            });
-
-            name.insert(0, "HTTP_");
-            return env(name.c_str());
+        [[nodiscard]] static str_view_type header(str_view_type name) noexcept {
+            stl::array<char, 128> buffer;
+            auto const            variable = common::cgi_header_name(name, buffer);
+            return variable.empty() ? str_view_type{} : env(variable);
         }
 
         /**
@@ -108,73 +216,149 @@ namespace webpp {
         [[nodiscard]] static str_view_type headers() noexcept {
             // we can do this only in CGI, we have to come up with new ways for
             // long-running protocols:
-            static str_type headers_cache;
-            if (headers_cache.empty()) {
-                // TODO: this code won't work on windows. Change when you are worried
-                // about windows
-                for (auto it = ::environ; *it; it++) {
-                    str_view_type h{*it};
-                    if (starts_with<traits_type>(h, "HTTP_")) {
-                        headers_cache.append(h.substr(5));
-                        // FIXME: decide if you need to convert _ to - or not.
-                    }
-                }
-            }
+            static str_type const headers_cache = [] {
+                str_type res;
+                environment().for_each_prefixed("HTTP_", [&](stl::string_view name, stl::string_view value) {
+                    common::append_cgi_header(res, name, value);
+                });
+                return res;
+            }();
             return headers_cache;
         }
 
         /**
-         * Get the full body as a string_view
+         * Read the next chunk of the body into the buffer; it never reads past
+         * the CONTENT_LENGTH (the web server doesn't have to close the stdin
+         * after the body), and if there's no CONTENT_LENGTH, it reads until
+         * the end of the stdin. Only the chunk is in the memory, so this is
+         * how you should read the big uploads.
+         * @returns the number of bytes read; zero means the end of the body
          */
-        [[nodiscard]] static str_view_type body() noexcept {
+        static stl::size_t read_body(char* data, stl::size_t size) noexcept {
+            // there's only one request in a CGI process
+            static stl::size_t left = [] {
+                auto const str = env("CONTENT_LENGTH");
+                if (str.empty())
+                    return stl::numeric_limits<stl::size_t>::max();
+                stl::size_t len = 0;
+                if (!parse_integer(str, len))
+                    return stl::size_t{0};
+                return len;
+            }();
+            auto const n = static_cast<stl::size_t>(read(data, static_cast<stl::streamsize>(stl::min(size, left))));
+            left         = n == 0 ? 0 : left - n;
+            return n;
+        }
+
+        /**
+         * Get the full body as a string_view; it's read in chunks and it stops
+         * at the limit (the limit of the first call), and the rest of the body
+         * is left for read_body.
+         */
+        [[nodiscard]] static str_view_type body(stl::size_t limit = default_max_body_size) noexcept {
             // again, we can do this only in cgi protocol not in other
             // interfaces:
-            static str_type body_cache;
-            if (body_cache.empty()) {
-                if (auto content_length_str = env("CONTENT_LENGTH"); !content_length_str.empty()) {
-                    // now we know how much content the user is going to send
-                    // so we just create a buffer with that size
-                    auto content_length = to_uint<traits_type>(content_length_str);
-
-                    char* buffer = new char[content_length];
-                    stl::cin.rdbuf()->pubsetbuf(buffer, sizeof(buffer));
-                } else {
-                    // we don't know how much the user is going to send. so we
-                    // use a small size buffer:
-
-                    // TODO: add something here
+            static str_type const body_cache = [limit] {
+                str_type res;
+                for (;;) {
+                    auto const old   = res.size();
+                    auto const chunk = stl::min(default_body_chunk_size, limit - old);
+                    if (chunk == 0)
+                        break;
+                    res.resize(old + chunk);
+                    auto const n = read_body(res.data() + old, chunk);
+                    res.resize(old + n);
+                    if (n == 0)
+                        break;
                 }
-            }
+                return res;
+            }();
             return body_cache;
         }
 
 
+        /**
+         * The FastCGI spec says the web server gives the application its
+         * listening socket as the stdin (FCGI_LISTENSOCK_FILENO); a socket
+         * that is not connected is how we know that.
+         */
+        [[nodiscard]] static bool is_fastcgi() noexcept {
+#ifdef __unix__
+            sockaddr_storage addr{};
+            socklen_t        len = sizeof(addr);
+            return ::getpeername(0, reinterpret_cast<sockaddr*>(&addr), &len) == -1 && errno == ENOTCONN;
+#else
+            return false;
+#endif
+        }
+
+        /**
+         * Call the application for a complete FastCGI request, and send the
+         * response; the request is only valid in here.
+         */
+        void serve(fastcgi::session& session, fastcgi::request& freq) noexcept {
+            serve_in_request_arena<traits_type>([&]() noexcept {
+                using request_type = basic_request<traits_type, interface_type>;
+                request_type req{freq};
+                auto         res = app(req);
+                res.calculate_default_headers();
+                session.write_stdout(freq.id, common::cgi_response_head(res));
+                fcgi<traits_type, application_type>::send_body(session, freq.id, res.body);
+                recycle_response(stl::move(res));
+            });
+        }
+
         void operator()() noexcept {
+            // the request type is named here and not as a member alias because
+            // checking the Interface concept needs this class to be complete
+            using request_type = basic_request<traits_type, interface_type>;
+
+#ifdef __unix__
+            if (is_fastcgi()) {
+                // one thread, like a CGI process; the application doesn't
+                // have to be thread-safe
+                _server.emplace(stl::vector<common::server::endpoint_t>{});
+                if (_server->adopt(0)) {
+                    _server->on_connection([this] {
+                        fastcgi::session session{[this](fastcgi::session& s, fastcgi::request& freq) {
+                            serve(s, freq);
+                        }};
+                        return [session = stl::move(session)](common::connection& conn,
+                                                              stl::string_view data) mutable noexcept {
+                            fcgi<traits_type, application_type>::handle(conn, session, data);
+                        };
+                    });
+                    _server->run();
+                    return;
+                }
+            }
+#endif
+
             request_type req;
             auto         res = app(req);
             res.calculate_default_headers();
-            auto header_str = res.header.str();
-            auto str        = res.body.str();
-
-            // From RFC: https://tools.ietf.org/html/rfc3875
-            // Send status code:
-            // Status         = "Status:" status-code SP reason-phrase NL
-            // status-code    = "200" | "302" | "400" | "501" | extension-code
-            // extension-code = 3digit
-            // reason-phrase  = *TEXT
-
-            // todo: use <format> or {fmt}
-            // todo: give the user the ability to change the status phrase
-            stl::stringstream status_line;
-            status_line << "Status: " << res.header.status_code() << " "
-                        << status_reason_phrase(res.header.status_code()) << "\r\n";
-
-            auto _status_line_str = status_line.str();
-            write(_status_line_str.data(), _status_line_str.size());
-
-            write(header_str.data(), header_str.size());
-            write("\r\n", 2);
-            write(str.data(), str.size());
+            auto const head = common::cgi_response_head(res);
+            if constexpr (requires { res.body.producer_handle(); }) {
+                if (res.body.is_stream()) {
+                    // each chunk is written as soon as it's produced
+                    write(head, {});
+                    for (bool more = true; more;) {
+                        stl::string chunk;
+                        more = res.body.next(chunk);
+                        write(chunk, {});
+                    }
+                    return;
+                }
+            }
+            write(head, res.body.str());
+        }
+
+        /**
+         * Stop the FastCGI loop if we're running one
+         */
+        void stop() noexcept {
+            if (_server)
+                _server->stop();
         }
     };
 
@@ -242,254 +426,32 @@ namespace webpp {
      * the user is able to use this class properly and easily.
      */
     template <Traits TraitsType, Application App>
-    struct basic_request<TraitsType, cgi<TraitsType, App>> {
-        using traits_type  = TraitsType;
+    struct basic_request<TraitsType, cgi<TraitsType, App>>
+      : public common::cgi_variables<basic_request<TraitsType, cgi<TraitsType, App>>>,
+        public request_body_parsers<basic_request<TraitsType, cgi<TraitsType, App>>> {
+        using traits_type    = TraitsType;
         using interface_type = cgi<TraitsType, App>;
+        using str_type       = typename traits_type::string_type;
 
-        /**
-         * @brief get the server's software
-         * @details Name and version of the information server software
-         * answering the request (and running the gateway). Format:
-         * name/version.
-         * @example SERVER_SOFTWARE=Apache/2.4.41 (Unix) OpenSSL/1.1.1d
-         */
-        [[nodiscard]] stl::string_view server_software() const noexcept {
-            return interface_type::env("SERVER_SOFTWARE");
-        }
-
-        /**
-         * @brief get the server name
-         * @details Server's hostname, DNS alias, or IP address as it appears in
-         * self-referencing URLs.
-         * @example SERVER_NAME=localhost
-         */
-        [[nodiscard]] stl::string_view server_name() const noexcept {
-            return interface_type::env("SERVER_NAME");
-        }
-
-        /**
-         * @brief get the gateway interface environment variable
-         * @details CGI specification revision with which this server complies.
-         * Format: CGI/revision.
-         * @example GATEWAY_INTERFACE=CGI/1.1
-         */
-        [[nodiscard]] stl::string_view gateway_interface() const noexcept {
-            return interface_type::env("GATEWAY_INTERFACE");
-        }
-
-        /**
-         * @brief get the server protocol
-         * @details Name and revision of the information protocol this request
-         * came in with. Format: protocol/revision.
-         * @example SERVER_PROTOCOL=HTTP/1.1
-         */
-        [[nodiscard]] stl::string_view server_protocol() const noexcept {
-            return interface_type::env("SERVER_PROTOCOL");
-        }
-
-        /**
-         * @brief get the port that the server is listening on
-         * @details Port number to which the request was sent.
-         */
-        [[nodiscard]] stl::string_view server_port() const noexcept {
-            return interface_type::env("SERVER_PORT");
-        }
-
-        /**
-         * @brief Get the method
-         * @details Method with which the request was made. For HTTP, this is
-         * Get, Head, Post, and so on.
-         */
-        [[nodiscard]] stl::string_view request_method() const noexcept {
-            return interface_type::env("REQUEST_METHOD");
-        }
-
-        /**
-         * @brief get the path info
-         * @details Extra path information, as given by the client. Scripts can
-         * be accessed by their virtual pathname, followed by extra information
-         * at the end of this path. The extra information is sent as PATH_INFO.
-         * @example PATH_INFO=/hello/world
-         */
-        [[nodiscard]] stl::string_view path_info() const noexcept {
-            return interface_type::env("PATH_INFO");
-        }
+      private:
+        // the FastCGI request, if we're in the persistent mode
+        fastcgi::request const* source = nullptr;
+        mutable str_type        headers_cache;
+        mutable stl::size_t     body_offset = 0; // what read_body has given out of the source
 
-        /**
-         * @brief get the path translated
-         * @details Translated version of PATH_INFO after any
-         * virtual-to-physical mapping.
-         * @example PATH_TRANSLATED=/srv/http/hello/world
-         */
-        [[nodiscard]] stl::string_view path_translated() const noexcept {
-            return interface_type::env("PATH_TRANSLATED");
-        }
-
-        /**
-         * @brief get the script name
-         * @details Virtual path to the script that is executing; used for
-         * self-referencing URLs.
-         * @example SCRIPT_NAME=/cgi-bin/one.cgi
-         */
-        [[nodiscard]] stl::string_view script_name() const noexcept {
-            return interface_type::env("SCRIPT_NAME");
-        }
-
-        /**
-         * @brief get the query string
-         * @details Query information that follows the ? in the URL that
-         * referenced this script.
-         */
-        [[nodiscard]] stl::string_view query_string() const noexcept {
-            return interface_type::env("QUERY_STRING");
-        }
-
-        /**
-         * @brief get the remote host
-         * @details Hostname making the request. If the server does not have
-         * this information, it sets REMOTE_ADDR and does not set REMOTE_HOST.
-         */
-        [[nodiscard]] stl::string_view remote_host() const noexcept {
-            return interface_type::env("REMOTE_HOST");
-        }
-
-        /**
-         * @brief get the ip address of the user
-         * @details IP address of the remote host making the request.
-         */
-        [[nodiscard]] stl::string_view remote_addr() const noexcept {
-            return interface_type::env("REMOTE_ADDR");
-        }
-
-        /**
-         * @brief get the auth type
-         * @details If the server supports user authentication, and the script
-         * is protected, the protocol-specific authentication method used to
-         * validate the user.
-         */
-        [[nodiscard]] stl::string_view auth_type() const noexcept {
-            return interface_type::env("AUTH_TYPE");
-        }
-
-        /**
-         * @brief get the remote user or auth user value (both should be the
-         * same)
-         * @details If the server supports user authentication, and the script
-         * is protected, the username the user has authenticated as. (Also
-         * available as AUTH_USER.)
-         */
-        [[nodiscard]] stl::string_view remote_user() const noexcept {
-            if (auto a = interface_type::env("REMOTE_USER"); !a.empty())
-                return a;
-            return interface_type::env("AUTH_USER");
-        }
-
-        /**
-         * @brief get the remote user or auth user value (both should be the
-         * same)
-         * @details If the server supports user authentication, and the script
-         * is protected, the username the user has authenticated as. (Also
-         * available as AUTH_USER.)
-         */
-        [[nodiscard]] stl::string_view auth_user() const noexcept {
-            if (auto a = interface_type::env("AUTH_USER"); !a.empty())
-                return a;
-            return interface_type::env("REMOTE_USER");
-        }
-
-        /**
-         * @brief get the remote ident
-         * @details If the HTTP server supports RFC 931 identification, this
-         * variable is set to the remote username retrieved from the server. Use
-         * this variable for logging only.
-         */
-        [[nodiscard]] stl::string_view remote_ident() const noexcept {
-            return interface_type::env("REMOTE_IDENT");
-        }
-
-        /**
-         * @brief returns the request scheme (http/https/...)
-         */
-        [[nodiscard]] stl::string_view request_scheme() const noexcept {
-            return interface_type::env("REQUEST_SCHEME");
-        }
-
-        /**
-         * @brief get the user's port number
-         */
-        [[nodiscard]] stl::string_view remote_port() const noexcept {
-            return interface_type::env("REMOTE_PORT");
-        }
-
-        /**
-         * @brief get the ip address that the server is listening on
-         */
-        [[nodiscard]] stl::string_view server_addr() const noexcept {
-            return interface_type::env("SERVER_ADDR");
-        }
-
-        /**
-         * @brief get the request uri
-         */
-        [[nodiscard]] stl::string_view request_uri() const noexcept {
-            return interface_type::env("REQUEST_URI");
-        }
-
-        /**
-         * @brief get the content_type
-         * @details For queries that have attached information, such as HTTP
-         * POST and PUT, this is the content type of the data.
-         */
-        [[nodiscard]] stl::string_view content_type() const noexcept {
-            return interface_type::env("CONTENT_LENGTH");
-        }
-
-        /**
-         * @brief get the content length
-         * @details Length of the content as given by the client.
-         */
-        [[nodiscard]] stl::string_view content_length() const noexcept {
-            return interface_type::env("CONTENT_LENGTH");
-        }
-
-        /**
-         * @brief get the document root environment value
-         * @details The root directory of your server
-         */
-        [[nodiscard]] stl::string_view document_root() const noexcept {
-            return interface_type::env("DOCUMENT_ROOT");
-        }
-
-        /**
-         * @brief get the https environment value
-         * @return "on" if the user used HTTPS protocol
-         */
-        [[nodiscard]] stl::string_view https() const noexcept {
-            return interface_type::env("HTTPS");
-        }
-
-        /**
-         * @brief get the server admin environment value
-         * @return probabely the administrator's email address
-         */
-        [[nodiscard]] stl::string_view server_admin() const noexcept {
-            return interface_type::env("SERVER_ADMIN");
-        }
-
-        /**
-         * @brief get the path environment variable
-         * @details The system path your server is running under
-         */
-        [[nodiscard]] stl::string_view path() const noexcept {
-            return interface_type::env("PATH");
+      public:
+        basic_request() noexcept = default;
+        basic_request(fastcgi::request const& _source) noexcept : source{&_source} {
         }
 
         /**
-         * @brief get the script_filename of the environment variables
-         * @details The full pathname of the current CGI
+         * Get a meta-variable; it's an environment variable, or a param of
+         * the request in the persistent mode.
          */
-        [[nodiscard]] stl::string_view script_filename() const noexcept {
-            return interface_type::env("SCRIPT_FILENAME");
+        [[nodiscard]] stl::string_view env(stl::string_view name) const noexcept {
+            if (source)
+                return source->param(name);
+            return interface_type::env(name);
         }
 
         /**
@@ -497,7 +459,9 @@ namespace webpp {
          * @param name
          */
         [[nodiscard]] stl::string_view header(stl::string_view const& name) const noexcept {
-            return interface_type::header(stl::string(name));
+            stl::array<char, 128> buffer;
+            auto const            variable = common::cgi_header_name(name, buffer);
+            return variable.empty() ? stl::string_view{} : env(variable);
         }
 
         /**
@@ -508,7 +472,14 @@ namespace webpp {
          * variables.
          */
         [[nodiscard]] stl::string_view headers() const noexcept {
-            return interface_type::headers();
+            if (!source)
+                return interface_type::headers();
+            if (headers_cache.empty()) {
+                source->for_each_param([this](stl::string_view name, stl::string_view value) noexcept {
+                    common::append_cgi_header(headers_cache, name, value);
+                });
+            }
+            return headers_cache;
         }
 
         /**
@@ -517,8 +488,24 @@ namespace webpp {
          * the request and will not parse it. Parsing it is another methods'
          * problem that might even use this function as the source.
          */
-        [[nodiscard]] stl::string_view body() const noexcept {
-            return interface_type::body();
+        [[nodiscard]] stl::string_view body(stl::size_t limit = default_max_body_size) const noexcept {
+            if (source)
+                return stl::string_view{source->std_in}.substr(0, limit);
+            return interface_type::body(limit);
+        }
+
+        /**
+         * @brief read the next chunk of the body
+         * @details the body is streamed in chunks of the buffer's size; so the
+         * uploads of any size can be handled with constant memory.
+         * @returns the number of bytes read; zero means the end of the body
+         */
+        stl::size_t read_body(char* data, stl::size_t size) const noexcept {
+            if (!source)
+                return interface_type::read_body(data, size);
+            auto const n = source->std_in.copy(data, size, stl::min(body_offset, source->std_in.size()));
+            body_offset += n;
+            return n;
         }
     };
 
@@ -0,0 +1,192 @@
+#ifndef WEBPP_INTERFACES_COMMON_BUFFER_POOL_H
+#define WEBPP_INTERFACES_COMMON_BUFFER_POOL_H
+
+#include "../../../std/std.hpp"
+#include "constants.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#ifdef __linux__
+#    include <sys/mman.h>
+#endif
+
+namespace webpp::common {
+
+    /**
+     * The read buffers of the connections of a worker. A connection only
+     * holds one while it's reading (the data is there, and it's being given
+     * to the data handler); the idle keep-alive connections hold nothing, so
+     * 100k connections need as many buffers as the ones that are busy at
+     * once, not 100k of them.
+     *
+     * The buffers are cut out of 2 MiB chunks that are backed by huge pages
+     * if the kernel has them reserved (MAP_HUGETLB), or asked to be (the
+     * transparent huge pages), so the buffers that are in use take a few TLB
+     * entries instead of one per 4 KiB page. The chunks are kept until the
+     * pool is destroyed; the free buffers are reused (the most recent one
+     * first, it's probably still in the cache).
+     *
+     * It's not thread-safe; each worker has its own, so it's a free list per
+     * thread.
+     */
+    class buffer_pool {
+      public:
+        static constexpr stl::size_t huge_page_size = 2 * 1024 * 1024;
+
+      private:
+        struct chunk {
+            char*       data;
+            stl::size_t size;
+            bool        mapped; // by mmap; by new otherwise
+            bool        huge;   // MAP_HUGETLB
+        };
+
+        stl::size_t        bytes_per_buffer;
+        stl::vector<chunk> chunks{};
+        stl::vector<char*> free_buffers{};
+        stl::size_t        used = 0;
+
+        [[nodiscard]] stl::size_t chunk_bytes() const noexcept {
+            // a whole number of huge pages, that has room for at least one buffer
+            return (bytes_per_buffer + huge_page_size - 1) / huge_page_size * huge_page_size;
+        }
+
+        bool grow() noexcept {
+            auto const size = chunk_bytes();
+            chunk      ch{nullptr, size, false, false};
+#ifdef __linux__
+#    ifdef MAP_HUGETLB
+            if (void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                data != MAP_FAILED) {
+                ch = {static_cast<char*>(data), size, true, true};
+            }
+#    endif
+            if (ch.data == nullptr) {
+                // no reserved huge pages; the transparent ones need the chunk to be aligned to them
+                auto const padded = size + huge_page_size;
+                if (void* data =
+                      ::mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                    data != MAP_FAILED) {
+                    auto* const begin   = static_cast<char*>(data);
+                    auto const  address = reinterpret_cast<stl::uintptr_t>(begin);
+                    auto* const aligned =
+                      begin + ((huge_page_size - address % huge_page_size) % huge_page_size);
+                    if (aligned != begin)
+                        ::munmap(begin, static_cast<stl::size_t>(aligned - begin));
+                    ::munmap(aligned + size, static_cast<stl::size_t>(begin + padded - (aligned + size)));
+#    ifdef MADV_HUGEPAGE
+                    ::madvise(aligned, size, MADV_HUGEPAGE);
+#    endif
+                    ch = {aligned, size, true, false};
+                }
+            }
+#endif
+            if (ch.data == nullptr) {
+                ch.data = static_cast<char*>(
+                  ::operator new(size, stl::align_val_t{huge_page_size}, stl::nothrow));
+                if (ch.data == nullptr)
+                    return false;
+            }
+            auto const count = size / bytes_per_buffer;
+            try {
+                // the room is made first, so the pushes below don't throw
+                chunks.reserve(chunks.size() + 1);
+                free_buffers.reserve(free_buffers.size() + count);
+            } catch (...) {
+                free_chunk(ch);
+                return false;
+            }
+            chunks.push_back(ch);
+            for (auto index = count; index != 0; index--)
+                free_buffers.push_back(ch.data + (index - 1) * bytes_per_buffer); // the first one is on the top
+            return true;
+        }
+
+        static void free_chunk(chunk const& ch) noexcept {
+#ifdef __linux__
+            if (ch.mapped) {
+                ::munmap(ch.data, ch.size);
+                return;
+            }
+#endif
+            ::operator delete(ch.data, stl::align_val_t{huge_page_size});
+        }
+
+      public:
+        explicit buffer_pool(stl::size_t _buffer_bytes = buffer_size) noexcept
+          : bytes_per_buffer{stl::max<stl::size_t>(_buffer_bytes, 1)} {}
+
+        buffer_pool(buffer_pool const&)            = delete;
+        buffer_pool& operator=(buffer_pool const&) = delete;
+
+        /**
+         * The buffers should all be released by now
+         */
+        ~buffer_pool() noexcept {
+            for (auto const& ch : chunks)
+                free_chunk(ch);
+        }
+
+        /**
+         * A buffer of buffer_bytes(); nullptr if we're out of memory
+         */
+        [[nodiscard]] char* acquire() noexcept {
+            if (free_buffers.empty() && !grow())
+                return nullptr;
+            auto* const buf = free_buffers.back();
+            free_buffers.pop_back();
+            used++;
+            return buf;
+        }
+
+        void release(char* buf) noexcept {
+            if (buf == nullptr)
+                return;
+            used--;
+            free_buffers.push_back(buf); // it doesn't allocate, there was room for it when its chunk came
+        }
+
+        [[nodiscard]] stl::size_t buffer_bytes() const noexcept {
+            return bytes_per_buffer;
+        }
+
+        /**
+         * The buffers that the connections hold now
+         */
+        [[nodiscard]] stl::size_t in_use() const noexcept {
+            return used;
+        }
+
+        /**
+         * The buffers that are there for the next reads
+         */
+        [[nodiscard]] stl::size_t available() const noexcept {
+            return free_buffers.size();
+        }
+
+        /**
+         * The memory that the pool has taken, in bytes
+         */
+        [[nodiscard]] stl::size_t reserved() const noexcept {
+            return chunks.size() * chunk_bytes();
+        }
+
+        /**
+         * How many of the chunks are on the huge pages that are reserved for
+         * them (the transparent ones are not counted, the kernel decides)
+         */
+        [[nodiscard]] stl::size_t huge_chunks() const noexcept {
+            return static_cast<stl::size_t>(stl::count_if(chunks.begin(), chunks.end(), [](chunk const& ch) {
+                return ch.huge;
+            }));
+        }
+    };
+
+} // namespace webpp::common
+
+#endif // WEBPP_INTERFACES_COMMON_BUFFER_POOL_H
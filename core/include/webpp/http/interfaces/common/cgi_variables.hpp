@@ -0,0 +1,407 @@
+#ifndef WEBPP_INTERFACES_COMMON_CGI_VARIABLES_H
+#define WEBPP_INTERFACES_COMMON_CGI_VARIABLES_H
+
+#include "../../../std/std.hpp"
+#include "../../../std/string_view.hpp"
+#include "../../header.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace webpp::common {
+
+    /**
+     * Convert a header name to its CGI meta-variable name (RFC 3875 4.1.18):
+     * "Accept-Encoding" is "HTTP_ACCEPT_ENCODING". The result is written in
+     * the buffer and is null terminated; it's empty if it doesn't fit.
+     */
+    template <stl::size_t N>
+    [[nodiscard]] stl::string_view cgi_header_name(stl::string_view name, stl::array<char, N>& buffer) noexcept {
+        constexpr stl::string_view prefix = "HTTP_";
+        if (prefix.size() + name.size() + 1 > N)
+            return {};
+        auto out = stl::copy(prefix.begin(), prefix.end(), buffer.begin());
+        for (auto c : name)
+            *out++ = c == '-' ? '_' : static_cast<char>(stl::toupper(static_cast<unsigned char>(c)));
+        *out = '\0';
+        return {buffer.data(), static_cast<stl::size_t>(out - buffer.begin())};
+    }
+
+    /**
+     * The reverse of the above: append "ACCEPT-ENCODING: value\r\n" for the
+     * "HTTP_ACCEPT_ENCODING" meta-variable; the case of the name is lost in
+     * CGI. The other meta-variables are not headers and are ignored.
+     */
+    template <typename StrT>
+    void append_cgi_header(StrT& out, stl::string_view variable, stl::string_view value) noexcept {
+        constexpr stl::string_view prefix = "HTTP_";
+        if (!variable.starts_with(prefix))
+            return;
+        for (auto c : variable.substr(prefix.size()))
+            out.push_back(c == '_' ? '-' : c);
+        out.append(": ");
+        out.append(value);
+        out.append("\r\n");
+    }
+
+    /**
+     * A sorted view of the environment variables; it's built once, and then
+     * a lookup is a binary search that doesn't allocate, instead of getenv's
+     * linear scan (with string comparisons) of the whole environment. The
+     * HTTP_* variables end up next to each other too, so all the headers
+     * are one range.
+     *
+     * The environment should not change while it's being used.
+     */
+    class environ_index {
+        using entry_type = stl::pair<stl::string_view, stl::string_view>;
+
+        stl::vector<entry_type> entries;
+
+        [[nodiscard]] auto lower_bound(stl::string_view name) const noexcept {
+            return stl::lower_bound(entries.begin(), entries.end(), name, [](entry_type const& e, auto n) {
+                return e.first < n;
+            });
+        }
+
+      public:
+        environ_index() noexcept = default;
+        explicit environ_index(char const* const* env) noexcept {
+            for (; env && *env; ++env) {
+                stl::string_view const var{*env};
+                if (auto const eq = var.find('='); eq != stl::string_view::npos)
+                    entries.emplace_back(var.substr(0, eq), var.substr(eq + 1));
+            }
+            // stable, so the first one wins when there are duplicates; like getenv
+            stl::stable_sort(entries.begin(), entries.end(), [](entry_type const& a, entry_type const& b) {
+                return a.first < b.first;
+            });
+        }
+
+        /**
+         * Get the value of a variable; empty if there's no such variable
+         */
+        [[nodiscard]] stl::string_view get(stl::string_view name) const noexcept {
+            if (auto it = lower_bound(name); it != entries.end() && it->first == name)
+                return it->second;
+            return {};
+        }
+
+        /**
+         * Call the callback with the name and the value of the variables
+         * that start with the prefix
+         */
+        template <typename Callback>
+        void for_each_prefixed(stl::string_view prefix, Callback&& callback) const noexcept {
+            for (auto it = lower_bound(prefix); it != entries.end() && it->first.starts_with(prefix); ++it)
+                callback(it->first, it->second);
+        }
+
+        [[nodiscard]] stl::size_t size() const noexcept {
+            return entries.size();
+        }
+    };
+
+    /**
+     * The head of a CGI response (RFC 3875 6.3.3); the web server turns the
+     * "Status" header into the status line of its own response:
+     *   Status         = "Status:" status-code SP reason-phrase NL
+     *   status-code    = "200" | "302" | "400" | "501" | extension-code
+     *   extension-code = 3digit
+     *   reason-phrase  = *TEXT
+     */
+    template <typename ResponseType>
+    [[nodiscard]] stl::string cgi_response_head(ResponseType const& res) noexcept {
+        // todo: give the user the ability to change the status phrase
+        auto const status      = res.header.status_code;
+        auto const status_line = cgi_status_line(status); // formatted at compile time
+
+        // one allocation for the whole thing
+        stl::size_t size = (status_line.empty() ? 32 : status_line.size()) + 2;
+        for (auto const& field : res.header)
+            size += field.name.size() + field.value.size() + 4;
+
+        stl::string head;
+        head.reserve(size);
+        if (!status_line.empty()) {
+            head.append(status_line);
+        } else {
+            // not a standard status code, so there's no reason phrase either
+            stl::array<char, 24> code;
+            head.append("Status: ");
+            head.append(code.data(), stl::to_chars(code.data(), code.data() + code.size(), status).ptr);
+            head.append(" \r\n");
+        }
+        res.header.append_to(head);
+        head.append("\r\n");
+        return head;
+    }
+
+    /**
+     * The CGI meta-variables (RFC 3875) of a request; the requests of the
+     * interfaces that get their requests as CGI variables (the cgi and the
+     * fcgi interfaces) inherit these, and only have to implement "env".
+     */
+    template <typename Derived>
+    struct cgi_variables {
+      private:
+        [[nodiscard]] constexpr Derived const& self() const noexcept {
+            return *static_cast<Derived const*>(this);
+        }
+
+      public:
+        /**
+         * @brief get the server's software
+         * @details Name and version of the information server software
+         * answering the request (and running the gateway). Format:
+         * name/version.
+         * @example SERVER_SOFTWARE=Apache/2.4.41 (Unix) OpenSSL/1.1.1d
+         */
+        [[nodiscard]] stl::string_view server_software() const noexcept {
+            return self().env("SERVER_SOFTWARE");
+        }
+
+        /**
+         * @brief get the server name
+         * @details Server's hostname, DNS alias, or IP address as it appears in
+         * self-referencing URLs.
+         * @example SERVER_NAME=localhost
+         */
+        [[nodiscard]] stl::string_view server_name() const noexcept {
+            return self().env("SERVER_NAME");
+        }
+
+        /**
+         * @brief get the gateway interface environment variable
+         * @details CGI specification revision with which this server complies.
+         * Format: CGI/revision.
+         * @example GATEWAY_INTERFACE=CGI/1.1
+         */
+        [[nodiscard]] stl::string_view gateway_interface() const noexcept {
+            return self().env("GATEWAY_INTERFACE");
+        }
+
+        /**
+         * @brief get the server protocol
+         * @details Name and revision of the information protocol this request
+         * came in with. Format: protocol/revision.
+         * @example SERVER_PROTOCOL=HTTP/1.1
+         */
+        [[nodiscard]] stl::string_view server_protocol() const noexcept {
+            return self().env("SERVER_PROTOCOL");
+        }
+
+        /**
+         * @brief get the port that the server is listening on
+         * @details Port number to which the request was sent.
+         */
+        [[nodiscard]] stl::string_view server_port() const noexcept {
+            return self().env("SERVER_PORT");
+        }
+
+        /**
+         * @brief Get the method
+         * @details Method with which the request was made. For HTTP, this is
+         * Get, Head, Post, and so on.
+         */
+        [[nodiscard]] stl::string_view request_method() const noexcept {
+            return self().env("REQUEST_METHOD");
+        }
+
+        /**
+         * @brief get the path info
+         * @details Extra path information, as given by the client. Scripts can
+         * be accessed by their virtual pathname, followed by extra information
+         * at the end of this path. The extra information is sent as PATH_INFO.
+         * @example PATH_INFO=/hello/world
+         */
+        [[nodiscard]] stl::string_view path_info() const noexcept {
+            return self().env("PATH_INFO");
+        }
+
+        /**
+         * @brief get the path translated
+         * @details Translated version of PATH_INFO after any
+         * virtual-to-physical mapping.
+         * @example PATH_TRANSLATED=/srv/http/hello/world
+         */
+        [[nodiscard]] stl::string_view path_translated() const noexcept {
+            return self().env("PATH_TRANSLATED");
+        }
+
+        /**
+         * @brief get the script name
+         * @details Virtual path to the script that is executing; used for
+         * self-referencing URLs.
+         * @example SCRIPT_NAME=/cgi-bin/one.cgi
+         */
+        [[nodiscard]] stl::string_view script_name() const noexcept {
+            return self().env("SCRIPT_NAME");
+        }
+
+        /**
+         * @brief get the query string
+         * @details Query information that follows the ? in the URL that
+         * referenced this script.
+         */
+        [[nodiscard]] stl::string_view query_string() const noexcept {
+            return self().env("QUERY_STRING");
+        }
+
+        /**
+         * @brief get the remote host
+         * @details Hostname making the request. If the server does not have
+         * this information, it sets REMOTE_ADDR and does not set REMOTE_HOST.
+         */
+        [[nodiscard]] stl::string_view remote_host() const noexcept {
+            return self().env("REMOTE_HOST");
+        }
+
+        /**
+         * @brief get the ip address of the user
+         * @details IP address of the remote host making the request.
+         */
+        [[nodiscard]] stl::string_view remote_addr() const noexcept {
+            return self().env("REMOTE_ADDR");
+        }
+
+        /**
+         * @brief get the auth type
+         * @details If the server supports user authentication, and the script
+         * is protected, the protocol-specific authentication method used to
+         * validate the user.
+         */
+        [[nodiscard]] stl::string_view auth_type() const noexcept {
+            return self().env("AUTH_TYPE");
+        }
+
+        /**
+         * @brief get the remote user or auth user value (both should be the
+         * same)
+         * @details If the server supports user authentication, and the script
+         * is protected, the username the user has authenticated as. (Also
+         * available as AUTH_USER.)
+         */
+        [[nodiscard]] stl::string_view remote_user() const noexcept {
+            if (auto a = self().env("REMOTE_USER"); !a.empty())
+                return a;
+            return self().env("AUTH_USER");
+        }
+
+        /**
+         * @brief get the remote user or auth user value (both should be the
+         * same)
+         * @details If the server supports user authentication, and the script
+         * is protected, the username the user has authenticated as. (Also
+         * available as AUTH_USER.)
+         */
+        [[nodiscard]] stl::string_view auth_user() const noexcept {
+            if (auto a = self().env("AUTH_USER"); !a.empty())
+                return a;
+            return self().env("REMOTE_USER");
+        }
+
+        /**
+         * @brief get the remote ident
+         * @details If the HTTP server supports RFC 931 identification, this
+         * variable is set to the remote username retrieved from the server. Use
+         * this variable for logging only.
+         */
+        [[nodiscard]] stl::string_view remote_ident() const noexcept {
+            return self().env("REMOTE_IDENT");
+        }
+
+        /**
+         * @brief returns the request scheme (http/https/...)
+         */
+        [[nodiscard]] stl::string_view request_scheme() const noexcept {
+            return self().env("REQUEST_SCHEME");
+        }
+
+        /**
+         * @brief get the user's port number
+         */
+        [[nodiscard]] stl::string_view remote_port() const noexcept {
+            return self().env("REMOTE_PORT");
+        }
+
+        /**
+         * @brief get the ip address that the server is listening on
+         */
+        [[nodiscard]] stl::string_view server_addr() const noexcept {
+            return self().env("SERVER_ADDR");
+        }
+
+        /**
+         * @brief get the request uri
+         */
+        [[nodiscard]] stl::string_view request_uri() const noexcept {
+            return self().env("REQUEST_URI");
+        }
+
+        /**
+         * @brief get the content_type
+         * @details For queries that have attached information, such as HTTP
+         * POST and PUT, this is the content type of the data.
+         */
+        [[nodiscard]] stl::string_view content_type() const noexcept {
+            return self().env("CONTENT_TYPE");
+        }
+
+        /**
+         * @brief get the content length
+         * @details Length of the content as given by the client.
+         */
+        [[nodiscard]] stl::string_view content_length() const noexcept {
+            return self().env("CONTENT_LENGTH");
+        }
+
+        /**
+         * @brief get the document root environment value
+         * @details The root directory of your server
+         */
+        [[nodiscard]] stl::string_view document_root() const noexcept {
+            return self().env("DOCUMENT_ROOT");
+        }
+
+        /**
+         * @brief get the https environment value
+         * @return "on" if the user used HTTPS protocol
+         */
+        [[nodiscard]] stl::string_view https() const noexcept {
+            return self().env("HTTPS");
+        }
+
+        /**
+         * @brief get the server admin environment value
+         * @return probabely the administrator's email address
+         */
+        [[nodiscard]] stl::string_view server_admin() const noexcept {
+            return self().env("SERVER_ADMIN");
+        }
+
+        /**
+         * @brief get the path environment variable
+         * @details The system path your server is running under
+         */
+        [[nodiscard]] stl::string_view path() const noexcept {
+            return self().env("PATH");
+        }
+
+        /**
+         * @brief get the script_filename of the environment variables
+         * @details The full pathname of the current CGI
+         */
+        [[nodiscard]] stl::string_view script_filename() const noexcept {
+            return self().env("SCRIPT_FILENAME");
+        }
+    };
+
+} // namespace webpp::common
+
+#endif // WEBPP_INTERFACES_COMMON_CGI_VARIABLES_H
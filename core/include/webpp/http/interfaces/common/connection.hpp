@@ -1,13 +1,41 @@
 #ifndef WEBPP_INTERFACE_COMMON_CONNECTION_H
 #define WEBPP_INTERFACE_COMMON_CONNECTION_H
 
-#include "../../std/buffer.hpp"
-#include "../../std/internet.hpp"
-#include "../../std/socket.hpp"
+#include "../../../std/buffer.hpp"
+#include "../../../std/internet.hpp"
+#include "../../../std/socket.hpp"
+#include "../../../utils/load_shedder.hpp"
+#include "../../../utils/metrics.hpp"
+#include "../../../utils/tracing.hpp"
+#include "buffer_pool.hpp"
 #include "constants.hpp"
+#include "timing_wheel.hpp"
+#include "tls.hpp"
+#include "uring.hpp"
 
+#include <algorithm>
+#include <array>
+#include <boost/asio/post.hpp>
+#include <boost/asio/write.hpp>
+#include <cerrno>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <new>
+#include <span>
+#include <string>
+#include <string_view>
 #include <system_error>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#    include <sys/sendfile.h>
+#endif
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 /**
  * The reason that this file is here and not in the include directory is because
@@ -17,32 +45,716 @@
 
 namespace webpp::common {
 
+    /**
+     * How long a connection is allowed to stay quiet; see constants.hpp
+     */
+    struct connection_timeouts {
+        stl::chrono::steady_clock::duration idle  = default_idle_timeout;
+        stl::chrono::steady_clock::duration read  = default_read_timeout;
+        stl::chrono::steady_clock::duration write = default_write_timeout;
+    };
+
+    /**
+     * The counters of the bytes of the connections (see server::metrics); the default ones count
+     * nothing
+     */
+    struct connection_metrics {
+        metric_counter received{};
+        metric_counter sent{};
+        metric_counter writes{}; // the gather writes, and the files
+    };
+
+    /**
+     * A connection reads the data and hands it to its data handler, and writes
+     * whatever the handler sends back.
+     *
+     * The output is queued; when a slow client lets the queue grow past the
+     * high-water mark, we stop reading from it (so no new requests are
+     * produced) until the queue drains below the low-water mark.
+     *
+     * If it's given a timer service, the connection is closed when it stays
+     * quiet for longer than its timeouts; there's only one timer per
+     * connection and it's re-armed on every read and write.
+     *
+     * With the io_uring backend (WEBPP_IO_URING), the reads and the writes
+     * go through the worker's ring instead of asio's reactor; the read buffer
+     * is registered in the ring if there's room for it.
+     *
+     * With a buffer pool (see read_buffers), the connection waits for the
+     * socket to be readable without a buffer, and borrows one from the pool
+     * only to read what's there and to hand it to the data handler; the idle
+     * connections hold no buffer at all.
+     *
+     * The files are queued as descriptors; they're copied to the socket by
+     * the kernel (sendfile) in their turn, so they never come into the user
+     * space.
+     *
+     * With TLS (WEBPP_TLS, see tls.hpp), the handshake is done before the
+     * first read; after it, the kernel encrypts and decrypts the records if
+     * it can (kTLS) and nothing else changes, otherwise OpenSSL does it and
+     * the gather writes are copied into one buffer to be encrypted.
+     *
+     * The output is corked while the data handler runs: the responses to the
+     * pipelined requests of one read are queued, and they go out together
+     * with one gather write when the handler returns, instead of one write
+     * (and one packet) each.
+     */
     class connection {
       public:
-        using socket_t = std::net::ip::tcp::socket;
+        using socket_t        = stl::net::ip::tcp::socket;
+        using executor_type   = socket_t::executor_type;
+        using close_handler_t = stl::function<void()>;
+        using data_handler_t  = stl::function<void(connection&, stl::string_view)>;
+        using producer_t      = stl::function<bool(stl::string&)>;
 
       private:
-        socket_t                      socket;
-        std::array<char, buffer_size> buffer;
+        socket_t        socket;
+        close_handler_t on_close;
+        data_handler_t  on_data;
+        close_handler_t on_protocol_close; // see on_closed
+
+        // the read buffer: it's borrowed from the pool while we're reading, or
+        // it's our own (allocated on the first read) if there's no pool
+        char*                   buffer          = nullptr;
+        stl::size_t             buffer_capacity = buffer_size;
+        buffer_pool*            buffers         = nullptr;
+        stl::unique_ptr<char[]> own_buffer{};
+
+        /**
+         * A string, the bytes that someone else owns, a part of a file that
+         * the kernel copies to the socket, or a stream whose chunks are
+         * produced one at a time (each one into "data")
+         */
+        struct output {
+            stl::string                 data{};
+            stl::string_view            borrowed{};
+            stl::shared_ptr<void const> owner{}; // keeps the borrowed bytes, or the descriptor
+            int                         fd     = -1;
+            off_t                       offset = 0;
+            stl::size_t                 length = 0;
+            producer_t                  producer{}; // it's dropped after the last chunk
+            bool                        stream  = false;
+            bool                        counted = false; // the borrowed bytes are ours, see write
+
+            /**
+             * What it adds to the queued size
+             */
+            [[nodiscard]] stl::size_t queued() const noexcept {
+                return counted ? borrowed.size() : data.size();
+            }
+
+            [[nodiscard]] bool is_file() const noexcept {
+                return fd != -1;
+            }
+
+            [[nodiscard]] stl::string_view bytes() const noexcept {
+                return owner ? borrowed : stl::string_view{data};
+            }
+        };
+
+        // the output queue; the first "writing_count" of them are being written
+        stl::deque<output>                  out_queue;
+        stl::vector<stl::net::const_buffer> write_buffers;
+        stl::size_t                         writing_count = 0;
+        stl::size_t                         queued_bytes  = 0;
+        stl::size_t                         high_water    = default_high_water_mark;
+        stl::size_t                         low_water     = default_low_water_mark;
+
+        timer_service*      timers = nullptr;
+        timer_node          timeout_timer;
+        connection_timeouts limits{};
+        connection_metrics  counters{};
+
+        load_shedder*                         shedder = nullptr;
+        stl::chrono::steady_clock::time_point read_at{}; // when the last read was done, if there's a shedder
+
+        // the address of the client, formatted on the first ask
+        stl::array<char, INET6_ADDRSTRLEN> peer_address{};
+        stl::size_t                        peer_address_size = 0;
+
+#ifdef WEBPP_USE_IO_URING
+        uring_service*     ring = nullptr;
+        uring_operation    read_op;
+        uring_operation    poll_op; // waits for the socket to be readable, if the buffers are borrowed
+        uring_operation    write_op;
+        msghdr             write_msg{};
+        stl::vector<iovec> write_iovs;
+        stl::size_t        write_first  = 0;  // the first iovec that is not fully written
+        int                buffer_index = -1; // the registered buffer, it's kept while we're reused
+#endif
+
+#ifdef WEBPP_USE_TLS
+        tls_context const* tls_ctx = nullptr; // see use_tls
+        tls_session        tls{};
+        stl::string        tls_plain;       // what OpenSSL is encrypting, if the kernel doesn't
+        stl::size_t        tls_written = 0; // of the tls_plain
+        bool               tls_ready   = false; // the handshake is done
+        bool               tls_send_offloaded    = false; // the kernel encrypts what we write (kTLS)
+        bool               tls_receive_offloaded = false; // the kernel decrypts what we read
+#    ifdef WEBPP_USE_IO_URING
+        uring_service* parked_ring = nullptr; // the ring is not used until we know the kernel does the TLS
+#    endif
+#endif
+
+        bool closed      = false;
+        bool finished    = false; // the close handler is called
+        bool reading     = false; // there's a read in progress
+        bool writing     = false; // there's a write in progress
+        bool read_paused = false; // we're waiting for the output to drain
+        bool closing     = false; // close as soon as the output is written
+        bool draining    = false; // the server is shutting down; close when we're not busy
+        bool is_busy     = false; // the protocol is in the middle of a request
+
+        stl::uint32_t corks = 0; // the output is held while it's not zero (see cork)
+
+#ifdef WEBPP_TRACING
+        stl::uint64_t write_began = 0; // in trace_ticks
+#endif
+
+        /**
+         * Restart the timeout for what we're waiting for now
+         */
+        void rearm() noexcept {
+            if (timers == nullptr || closed)
+                return;
+            auto const timeout = writing ? limits.write : is_busy ? limits.read : limits.idle;
+            if (timeout == stl::chrono::steady_clock::duration::zero()) {
+                timers->cancel(timeout_timer);
+            } else {
+                timers->schedule(timeout_timer, timeout);
+            }
+        }
 
         void read() noexcept {
-            // we share ourselves, so the connection keeps itself alive.
-            socket.async_read_some(
-              std::net::buffer(buffer),
-              [this](std::error_code const& err,
-                     std::size_t            bytes_transferred) noexcept {
-                  if (!err) {
-                      // we need to parse, store, read more, or
-                      // write something
-                  }
-              });
+            if (closed || reading)
+                return;
+            reading = true;
+#ifdef WEBPP_USE_TLS
+            if (tls && !tls_receive_offloaded) {
+                tls_read();
+                return;
+            }
+#endif
+            if (buffers != nullptr) {
+                wait_readable();
+                return;
+            }
+            if (!attach_buffer()) {
+                stl::net::post(socket.get_executor(), [this] {
+                    on_read(stl::net::error::no_buffer_space, 0);
+                });
+                return;
+            }
+#ifdef WEBPP_USE_IO_URING
+            if (ring != nullptr) {
+                ring->recv(read_op, socket.native_handle(), buffer, buffer_capacity, buffer_index);
+                return;
+            }
+#endif
+            // the server owns us and it will not release us until we call the
+            // close handler, and we don't call it while an operation is
+            // pending, so capturing "this" is safe here
+            socket.async_read_some(stl::net::buffer(buffer, buffer_capacity),
+                                   [this](istl::net_error_code const& err, stl::size_t bytes_transferred) noexcept {
+                                       on_read(err, bytes_transferred);
+                                   });
+        }
+
+        /**
+         * Get a read buffer, from the pool if there's one; false if we're out
+         * of memory
+         */
+        bool attach_buffer() noexcept {
+            if (buffer != nullptr)
+                return true;
+            if (buffers != nullptr) {
+                buffer          = buffers->acquire();
+                buffer_capacity = buffers->buffer_bytes();
+                return buffer != nullptr;
+            }
+            if (!own_buffer) {
+                own_buffer.reset(new (stl::nothrow) char[buffer_size]);
+                buffer_capacity = buffer_size;
+            }
+            buffer = own_buffer.get();
+            return buffer != nullptr;
+        }
+
+        /**
+         * Give the borrowed buffer back to the pool; our own one is kept
+         */
+        void detach_buffer() noexcept {
+            if (buffers != nullptr && buffer != nullptr)
+                buffers->release(stl::exchange(buffer, nullptr));
+        }
+
+        /**
+         * Wait for the socket to be readable, without a buffer
+         */
+        void wait_readable() noexcept {
+#ifdef WEBPP_USE_IO_URING
+            if (ring != nullptr) {
+                ring->poll_readable(poll_op, socket.native_handle());
+                return;
+            }
+#endif
+            socket.async_wait(socket_t::wait_read, [this](istl::net_error_code const& err) noexcept {
+                if (err) {
+                    on_read(err, 0);
+                } else {
+                    read_ready();
+                }
+            });
+        }
+
+        /**
+         * The socket is readable; borrow a buffer and read what's there
+         */
+        void read_ready() noexcept {
+            if (closed) {
+                on_read(stl::net::error::operation_aborted, 0);
+                return;
+            }
+            if (!attach_buffer()) {
+                on_read(stl::net::error::no_buffer_space, 0);
+                return;
+            }
+            for (;;) {
+                auto const res = ::recv(socket.native_handle(), buffer, buffer_capacity, MSG_DONTWAIT);
+                if (res > 0) {
+                    on_read({}, static_cast<stl::size_t>(res));
+                } else if (res == 0) {
+                    on_read(stl::net::error::eof, 0);
+                } else if (errno == EINTR) {
+                    continue;
+                } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    // it was a false alarm; the buffer goes back while we wait again
+                    detach_buffer();
+                    wait_readable();
+                } else {
+                    on_read({errno, boost::system::system_category()}, 0);
+                }
+                return;
+            }
         }
 
-        void write() noexcept {
+        void on_read(istl::net_error_code const& err, stl::size_t bytes_transferred) noexcept {
+            reading = false;
+            if (err || closed) {
+                // eof, reset by peer, or we've been closed by the server
+                detach_buffer();
+                stop();
+                return;
+            }
+            counters.received.inc(bytes_transferred);
+            if (shedder != nullptr)
+                read_at = stl::chrono::steady_clock::now();
+            if (on_data) {
+                // the responses of this read are written together
+                corks++;
+                on_data(*this, stl::string_view{buffer, bytes_transferred});
+                corks--;
+            }
+            // the protocols keep what they still need of it in their own buffers
+            detach_buffer();
+            flush();
+            rearm();
+            if (closing)
+                return; // we're not interested in the rest of it
+            if (queued_bytes > high_water) {
+                read_paused = true;
+                return;
+            }
+            read();
+        }
+
+        void flush() noexcept {
+            if (closed || writing || corks != 0 || out_queue.empty())
+                return;
+            if (out_queue.front().stream && !produce()) {
+                if (closing)
+                    stop(); // the stream was the last of it
+                return;
+            }
+            writing = true;
+            counters.writes.inc();
+#ifdef WEBPP_TRACING
+            write_began = trace_ticks();
+#endif
+            rearm();
+            if (out_queue.front().is_file()) {
+                writing_count = 1;
+#ifdef WEBPP_USE_TLS
+                if (tls && !tls_send_offloaded) {
+                    tls_plain.clear();
+                    tls_written = 0;
+                    tls_write_rest();
+                    return;
+                }
+#endif
+                send_file_rest();
+                return;
+            }
+
+            if (out_queue.front().stream) {
+                writing_count = 1; // what comes after it waits for the stream to end
+            } else {
+                // the strings up to the next file (or stream) are written together
+                writing_count = 0;
+                while (writing_count != out_queue.size() && !out_queue[writing_count].is_file() &&
+                       !out_queue[writing_count].stream)
+                    writing_count++;
+            }
+#ifdef WEBPP_USE_TLS
+            if (tls && !tls_send_offloaded) {
+                // the records are as big as they can be, and there's one write for all of them
+                tls_plain.clear();
+                tls_written = 0;
+                for (stl::size_t i = 0; i != writing_count; i++)
+                    tls_plain.append(out_queue[i].bytes());
+                tls_write_rest();
+                return;
+            }
+#endif
+#ifdef WEBPP_USE_IO_URING
+            if (ring != nullptr) {
+                write_iovs.clear();
+                for (stl::size_t i = 0; i != writing_count; i++) {
+                    auto const bytes = out_queue[i].bytes();
+                    write_iovs.push_back(iovec{const_cast<char*>(bytes.data()), bytes.size()});
+                }
+                write_first = 0;
+                send_rest();
+                return;
+            }
+#endif
+            write_buffers.clear();
+            for (stl::size_t i = 0; i != writing_count; i++)
+                write_buffers.push_back(stl::net::buffer(out_queue[i].bytes()));
+
+            // one gather write for everything that is queued
+            stl::net::async_write(socket, write_buffers,
+                                  [this](istl::net_error_code const& err, stl::size_t) noexcept {
+                                      on_written(err);
+                                  });
+        }
+
+        /**
+         * Ask the stream at the front of the queue for its next chunk; the
+         * stream is dropped when it's over.
+         * @returns false if the queue is empty after it
+         */
+        bool produce() noexcept {
+            while (!out_queue.empty() && out_queue.front().stream) {
+                auto& out = out_queue.front();
+                out.data.clear();
+                while (out.data.empty() && out.producer) {
+                    if (!out.producer(out.data))
+                        out.producer = nullptr; // this one is the last chunk
+                }
+                if (!out.data.empty()) {
+                    queued_bytes += out.data.size();
+                    return true;
+                }
+                out_queue.pop_front();
+            }
+            return !out_queue.empty();
+        }
+
+        void on_written(istl::net_error_code const& err) noexcept {
+#ifdef WEBPP_TRACING
+            trace_since(trace_point::write, trace_id(), write_began);
+#endif
+            writing = false;
+            for (; writing_count != 0; writing_count--) {
+                auto& out = out_queue.front();
+                queued_bytes -= out.queued();
+                if (!err && !out.is_file())
+                    counters.sent.inc(out.bytes().size()); // the files are counted while they're sent
+                if (out.producer) {
+                    out.data.clear(); // the stream stays until it's over
+                    continue;
+                }
+                out_queue.pop_front();
+            }
+            if (err || closed || (closing && out_queue.empty())) {
+                stop();
+                return;
+            }
+            flush();
+            rearm();
+            if (read_paused && queued_bytes <= low_water) {
+                read_paused = false;
+                read();
+            }
+        }
+
+        /**
+         * Let the kernel copy the file at the front of the queue to the
+         * socket; when the socket is full, we wait for it to be writable and
+         * continue from where we were.
+         */
+        void send_file_rest() noexcept {
+            auto& out = out_queue.front();
+#ifdef __linux__
+            istl::net_error_code ec;
+            socket.native_non_blocking(true, ec);
+            while (!ec && !closed && out.length != 0) {
+                auto const sent = ::sendfile(socket.native_handle(), out.fd, &out.offset, out.length);
+                if (sent > 0) {
+                    out.length -= static_cast<stl::size_t>(sent);
+                    counters.sent.inc(static_cast<stl::size_t>(sent));
+                } else if (sent == 0) {
+                    ec = stl::net::error::eof; // the file got shorter than what we promised
+                } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    // both of the backends wait for the socket here, the ring
+                    // would need a pipe to splice the file
+                    socket.async_wait(socket_t::wait_write, [this](istl::net_error_code const& err) noexcept {
+                        if (err) {
+                            on_written(err);
+                        } else {
+                            send_file_rest();
+                        }
+                    });
+                    return;
+                } else if (errno != EINTR) {
+                    ec.assign(errno, boost::system::system_category());
+                }
+            }
+#    ifdef WEBPP_USE_IO_URING
+            // the ring expects a blocking socket
+            if (ring != nullptr) {
+                istl::net_error_code ignored;
+                socket.native_non_blocking(false, ignored);
+            }
+#    endif
+            on_written(ec);
+#else
+            on_written(stl::net::error::operation_not_supported);
+#endif
+        }
+
+#ifdef WEBPP_USE_IO_URING
+        static istl::net_error_code ring_error(int res) noexcept {
+            return {-res, boost::system::system_category()};
+        }
+
+        /**
+         * Send what is left of the gather write; the kernel may take only a
+         * part of it
+         */
+        void send_rest() noexcept {
+            write_msg.msg_iov    = write_iovs.data() + write_first;
+            write_msg.msg_iovlen = write_iovs.size() - write_first;
+            ring->sendmsg(write_op, socket.native_handle(), write_msg);
+        }
+
+        void on_ring_write(int res) noexcept {
+            if (res < 0) {
+                on_written(ring_error(res));
+                return;
+            }
+            // skip the part that is written
+            auto written = static_cast<stl::size_t>(res);
+            while (write_first < write_iovs.size() && written >= write_iovs[write_first].iov_len)
+                written -= write_iovs[write_first++].iov_len;
+            if (write_first == write_iovs.size() || closed) {
+                on_written({});
+                return;
+            }
+            auto& iov = write_iovs[write_first];
+            iov.iov_base = static_cast<char*>(iov.iov_base) + written;
+            iov.iov_len -= written;
+            send_rest();
+        }
+#endif
+
+#ifdef WEBPP_USE_TLS
+        static constexpr stl::size_t tls_file_chunk = 64 * 1024;
+
+        // the error of the last OpenSSL call of this thread, as an asio error
+        [[nodiscard]] istl::net_error_code tls_error(int res) noexcept {
+            auto const code = SSL_get_error(tls.get(), res);
+            ERR_clear_error();
+            if (code == SSL_ERROR_ZERO_RETURN)
+                return stl::net::error::eof; // the client has sent its close_notify
+            return stl::net::error::connection_reset;
+        }
+
+        /**
+         * Wait until the socket is ready for what OpenSSL wants, and call the
+         * next step; the error goes to the failed one.
+         * @returns false if OpenSSL doesn't want to wait (it's an error)
+         */
+        template <typename Next, typename Failed>
+        bool tls_wait(int res, Next&& next, Failed&& failed) noexcept {
+            auto const code = SSL_get_error(tls.get(), res);
+            if (code != SSL_ERROR_WANT_READ && code != SSL_ERROR_WANT_WRITE)
+                return false;
+            socket.async_wait(code == SSL_ERROR_WANT_READ ? socket_t::wait_read : socket_t::wait_write,
+                              [this, next = stl::forward<Next>(next), failed = stl::forward<Failed>(failed)](
+                                istl::net_error_code const& err) mutable noexcept {
+                                  if (err || closed) {
+                                      failed(err ? err : stl::net::error::operation_aborted);
+                                  } else {
+                                      next();
+                                  }
+                              });
+            return true;
+        }
+
+        /**
+         * Begin the TLS of the connection; the first read is done after the
+         * handshake.
+         */
+        void start_tls() noexcept {
+            tls = tls_ctx->new_session(socket.native_handle());
+            if (!tls) {
+                stop();
+                return;
+            }
+#    ifdef WEBPP_USE_IO_URING
+            parked_ring = stl::exchange(ring, nullptr);
+#    endif
+            istl::net_error_code ec;
+            socket.native_non_blocking(true, ec);
+            reading = true; // the handshake is the first read
+            tls_handshake();
+        }
+
+        void tls_handshake() noexcept {
+            ERR_clear_error();
+            auto const res = SSL_do_handshake(tls.get());
+            if (res == 1) {
+                tls_ready             = true;
+                tls_send_offloaded    = tls_kernel_send(tls.get());
+                tls_receive_offloaded = tls_kernel_receive(tls.get());
+#    ifdef WEBPP_USE_IO_URING
+                // the ring reads and writes the plain socket, so it can only do it if the kernel does the TLS
+                if (parked_ring != nullptr && tls_send_offloaded && tls_receive_offloaded) {
+                    ring = stl::exchange(parked_ring, nullptr);
+                    istl::net_error_code ignored;
+                    socket.native_non_blocking(false, ignored);
+                }
+#    endif
+                reading = false;
+                read();
+                rearm();
+                return;
+            }
+            auto const failed = [this](istl::net_error_code const&) noexcept {
+                reading = false;
+                stop();
+            };
+            if (!tls_wait(
+                  res,
+                  [this] {
+                      tls_handshake();
+                  },
+                  failed)) {
+                ERR_clear_error();
+                failed({});
+            }
+        }
+
+        /**
+         * Read and decrypt what's there; the data handler is called later (it
+         * may be called from inside of the handler that's reading).
+         */
+        void tls_read() noexcept {
+            if (!attach_buffer()) {
+                stl::net::post(socket.get_executor(), [this] {
+                    on_read(stl::net::error::no_buffer_space, 0);
+                });
+                return;
+            }
+            ERR_clear_error();
+            stl::size_t read_size = 0;
+            auto const  res       = SSL_read_ex(tls.get(), buffer, buffer_capacity, &read_size);
+            if (res == 1) {
+                stl::net::post(socket.get_executor(), [this, read_size] {
+                    on_read({}, read_size);
+                });
+                return;
+            }
+            auto const failed = [this](istl::net_error_code const& err) noexcept {
+                on_read(err, 0);
+            };
+            detach_buffer(); // there's nothing in it yet
+            if (!tls_wait(
+                  res,
+                  [this] {
+                      tls_read();
+                  },
+                  failed)) {
+                stl::net::post(socket.get_executor(), [this, err = tls_error(res)] {
+                    on_read(err, 0);
+                });
+            }
+        }
+
+        /**
+         * Encrypt and write the rest of the tls_plain; the files at the front
+         * of the queue are read into it a part at a time.
+         */
+        void tls_write_rest() noexcept {
+            for (;;) {
+                while (tls_written < tls_plain.size()) {
+                    ERR_clear_error();
+                    stl::size_t written = 0;
+                    auto const  res     = SSL_write_ex(tls.get(), tls_plain.data() + tls_written,
+                                                  tls_plain.size() - tls_written, &written);
+                    if (res == 1) {
+                        tls_written += written;
+                        continue;
+                    }
+                    auto const failed = [this](istl::net_error_code const& err) noexcept {
+                        on_written(err);
+                    };
+                    if (!tls_wait(
+                          res,
+                          [this] {
+                              tls_write_rest();
+                          },
+                          failed))
+                        failed(tls_error(res));
+                    return;
+                }
+
+                auto& out = out_queue.front();
+                if (!out.is_file() || out.length == 0)
+                    break;
+                tls_plain.resize(stl::min(out.length, tls_file_chunk));
+                auto const res = ::pread(out.fd, tls_plain.data(), tls_plain.size(), out.offset);
+                if (res <= 0) {
+                    on_written(stl::net::error::eof); // the file got shorter than what we promised
+                    return;
+                }
+                tls_plain.resize(static_cast<stl::size_t>(res));
+                tls_written = 0;
+                out.offset += static_cast<off_t>(res);
+                out.length -= static_cast<stl::size_t>(res);
+                counters.sent.inc(static_cast<stl::size_t>(res));
+            }
+            // like the writes of asio, it's never finished from inside of flush
+            stl::net::post(socket.get_executor(), [this] {
+                on_written({});
+            });
+        }
+#endif
+
+        void finish() noexcept {
+            if (finished || reading || writing)
+                return;
+            finished = true;
+            if (on_protocol_close)
+                stl::exchange(on_protocol_close, nullptr)();
+            if (on_close)
+                on_close();
         }
 
       public:
-        connection(socket_t socket) noexcept : socket(std::move(socket)) {
+        connection(socket_t socket) noexcept : socket(stl::move(socket)) {
         }
         connection(connection const&) = delete;
         connection(connection&&)      = default;
@@ -51,13 +763,446 @@ namespace webpp::common {
 
         /**
          * Start async operations
+         * The close handler is called exactly once, after the pending
+         * operations are done; after that the server is free to destroy this
+         * connection.
          */
-        void start() noexcept;
+        void start(close_handler_t handler, data_handler_t data_handler = {}) noexcept {
+            on_close = stl::move(handler);
+            on_data  = stl::move(data_handler);
+#ifdef WEBPP_USE_TLS
+            if (tls_ctx != nullptr) {
+                start_tls();
+                rearm();
+                return;
+            }
+#endif
+            read();
+            rearm();
+        }
+
+#ifdef WEBPP_USE_TLS
+        /**
+         * Talk TLS with the client, with the certificate of the context; call
+         * it before start. The context should outlive the connection.
+         */
+        void use_tls(tls_context const& context) noexcept {
+            tls_ctx = &context;
+        }
+
+        /**
+         * The kernel encrypts what's written (kTLS); false if it's not TLS
+         */
+        [[nodiscard]] bool is_tls_offloaded() const noexcept {
+            return tls_send_offloaded;
+        }
+
+        [[nodiscard]] bool is_tls() const noexcept {
+            return tls_ctx != nullptr;
+        }
+#endif
+
+#ifdef WEBPP_USE_IO_URING
+        /**
+         * Do the reads and the writes on the ring (of the thread that runs this
+         * connection); call it before start.
+         */
+        void use_ring(uring_service& service) noexcept {
+            if (ring != &service) {
+                // we're always reused by the same worker, so the buffer stays
+                // registered in its ring; the borrowed buffers are not registered
+                ring = &service;
+                if (buffers == nullptr && attach_buffer())
+                    buffer_index = service.register_buffer(buffer, buffer_capacity);
+            }
+            read_op.on_complete = [this](int res, unsigned) {
+                if (res == 0) {
+                    on_read(stl::net::error::eof, 0);
+                } else if (res < 0) {
+                    on_read(ring_error(res), 0);
+                } else {
+                    on_read({}, static_cast<stl::size_t>(res));
+                }
+            };
+            write_op.on_complete = [this](int res, unsigned) {
+                on_ring_write(res);
+            };
+            poll_op.on_complete = [this](int res, unsigned) {
+                if (res < 0) {
+                    on_read(ring_error(res), 0);
+                } else {
+                    read_ready();
+                }
+            };
+        }
+#endif
+
+        /**
+         * Borrow the read buffers from the pool (of the thread that runs this
+         * connection) while reading, instead of keeping one; call it before
+         * start. The pool should outlive the connection.
+         */
+        void read_buffers(buffer_pool& pool) noexcept {
+            if (buffer == own_buffer.get())
+                buffer = nullptr; // ours is not the pool's to take
+            buffers = &pool;
+        }
+
+        /**
+         * Call the handler when the connection is closed, before the server's
+         * close handler; for the protocols whose sessions outlive the requests
+         * (WebSocket). It's called once, and it can be set at any time.
+         */
+        void on_closed(close_handler_t handler) noexcept {
+            on_protocol_close = stl::move(handler);
+        }
+
+        /**
+         * The data that the data handler is given is in our receive buffer, and
+         * it's the handler's to change in place until it returns (to unmask
+         * the WebSocket frames, for example); this is that data, writable.
+         * Empty if it's not in our buffer.
+         */
+        [[nodiscard]] stl::span<char> writable(stl::string_view data) noexcept {
+            auto const* const begin = buffer;
+            if (begin == nullptr || data.data() < begin || data.data() + data.size() > begin + buffer_capacity)
+                return {};
+            return {buffer + (data.data() - begin), data.size()};
+        }
+
+        /**
+         * Count the bytes that are read and written into these counters
+         */
+        void metrics(connection_metrics const& _counters) noexcept {
+            counters = _counters;
+        }
+
+        /**
+         * Use the timer service (of the thread that runs this connection) for
+         * the timeouts; call it before start.
+         */
+        void timeouts(timer_service& service, connection_timeouts const& _limits) noexcept {
+            timers                  = &service;
+            limits                  = _limits;
+            timeout_timer.on_expire = [this] {
+                stop();
+            };
+        }
+
+        /**
+         * Decide whether the requests are served with the load shedder (of the
+         * thread that runs this connection); call it before start.
+         */
+        void shedding(load_shedder& service) noexcept {
+            shedder = &service;
+        }
+
+        /**
+         * Whether the request that the protocol has just read should be
+         * served; if not, the protocol answers it with a 503. The time that it
+         * has waited is the loop's lag (see timer_service::lag) and the time
+         * since it was read (the pipelined requests wait for the ones before
+         * them). It's always admitted if there's no shedder.
+         */
+        [[nodiscard]] bool admit() noexcept {
+            if (shedder == nullptr)
+                return true;
+            auto const now = stl::chrono::steady_clock::now();
+            auto const lag = timers != nullptr ? timers->lag() : stl::chrono::steady_clock::duration::zero();
+            return shedder->admit(lag + (now - read_at), now);
+        }
+
+        /**
+         * Make a finished connection ready to be used again with a new socket;
+         * the buffers keep their memory.
+         */
+        void reset(socket_t new_socket) noexcept {
+            socket   = stl::move(new_socket);
+            on_close = nullptr;
+            on_data  = nullptr;
+            on_protocol_close = nullptr;
+            out_queue.clear();
+            write_buffers.clear();
+            writing_count = 0;
+            queued_bytes  = 0;
+            closed        = false;
+            finished      = false;
+            reading       = false;
+            writing       = false;
+            read_paused   = false;
+            closing       = false;
+            draining      = false;
+            is_busy       = false;
+            corks         = 0;
+            timers        = nullptr;
+            shedder       = nullptr;
+            detach_buffer();
+            buffers           = nullptr;
+            peer_address_size = 0;
+#ifdef WEBPP_USE_TLS
+            tls_ctx = nullptr;
+            tls.reset();
+            tls_plain.clear();
+            tls_written           = 0;
+            tls_ready             = false;
+            tls_send_offloaded    = false;
+            tls_receive_offloaded = false;
+#    ifdef WEBPP_USE_IO_URING
+            if (parked_ring != nullptr)
+                ring = stl::exchange(parked_ring, nullptr); // use_ring sees that it's the same ring
+#    endif
+#endif
+        }
+
+        /**
+         * The executor of the thread that runs this connection; post to it to
+         * send from the other threads.
+         */
+        [[nodiscard]] executor_type get_executor() noexcept {
+            return socket.get_executor();
+        }
+
+        /**
+         * The address of the client (what REMOTE_ADDR is in CGI), without the
+         * port; empty if the socket is not connected anymore. It's valid as
+         * long as the connection is open.
+         */
+        [[nodiscard]] stl::string_view remote_address() noexcept {
+            if (peer_address_size == 0) {
+                sockaddr_storage addr{};
+                socklen_t        len = sizeof(addr);
+                if (::getpeername(socket.native_handle(), reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+                    return {};
+                void const* src = nullptr;
+                if (addr.ss_family == AF_INET) {
+                    src = &reinterpret_cast<sockaddr_in const&>(addr).sin_addr;
+                } else if (addr.ss_family == AF_INET6) {
+                    src = &reinterpret_cast<sockaddr_in6 const&>(addr).sin6_addr;
+                } else {
+                    return {};
+                }
+                if (::inet_ntop(addr.ss_family, src, peer_address.data(), peer_address.size()) == nullptr)
+                    return {};
+                peer_address_size = stl::string_view{peer_address.data()}.size();
+            }
+            return {peer_address.data(), peer_address_size};
+        }
+
+        /**
+         * The id of the connection in the traces (see tracing.hpp); its descriptor
+         */
+        [[nodiscard]] stl::uint64_t trace_id() noexcept {
+            return static_cast<stl::uint64_t>(socket.native_handle());
+        }
+
+        /**
+         * Queue the data to be written to the client
+         */
+        void send(stl::string data) noexcept {
+            if (closed || data.empty())
+                return;
+            queued_bytes += data.size();
+            out_queue.push_back(output{.data = stl::move(data)});
+            flush();
+        }
+
+        /**
+         * Queue the bytes without copying them; the owner is kept until
+         * they're written. They're not counted in the queued size, they're
+         * not ours.
+         */
+        void send(stl::string_view data, stl::shared_ptr<void const> owner) noexcept {
+            if (closed || data.empty() || !owner)
+                return;
+            out_queue.push_back(output{.borrowed = data, .owner = stl::move(owner)});
+            flush();
+        }
+
+        /**
+         * Queue a stream to be written after what's queued before it; the
+         * producer writes its next chunk into the string it's given, and it
+         * returns false when it's over. It's only asked for a chunk when the
+         * previous one is written, so a slow client slows the producer down.
+         */
+        void send_stream(producer_t producer) noexcept {
+            if (closed || !producer)
+                return;
+            out_queue.push_back(output{.producer = stl::move(producer), .stream = true});
+            flush();
+        }
+
+        /**
+         * Queue a part of a file to be written to the client after what's
+         * queued before it; the owner is kept until it's written, so the
+         * descriptor stays open. The file is not counted in the queued size,
+         * it's not in the memory.
+         */
+        void send_file(int fd, stl::size_t offset, stl::size_t length,
+                       stl::shared_ptr<void const> owner = {}) noexcept {
+            if (closed || fd == -1 || length == 0)
+                return;
+#ifdef __linux__
+            out_queue.push_back(output{.owner      = stl::move(owner),
+                                       .fd         = fd,
+                                       .offset     = static_cast<off_t>(offset),
+                                       .length     = length});
+            flush();
+#else
+            // no sendfile here; read it into the queue
+            stl::string data(length, '\0');
+            stl::size_t done = 0;
+            while (done < length) {
+                auto const res = ::pread(fd, data.data() + done, length - done, static_cast<off_t>(offset + done));
+                if (res <= 0)
+                    break;
+                done += static_cast<stl::size_t>(res);
+            }
+            data.resize(done);
+            send(stl::move(data));
+#endif
+        }
+
+        /**
+         * Queue the buffers to go out with the rest of the output, in the
+         * same gather write; they're not copied, and the owner (of all of
+         * them) is dropped when they're written. Unlike the borrowed bytes of
+         * send, they're counted in the queued size; they're the output of a
+         * protocol of ours, which a slow peer lets grow.
+         */
+        template <typename ConstBufferSequence>
+        void write(ConstBufferSequence const& buffers, stl::shared_ptr<void const> const& owner) noexcept {
+            if (closed || !owner)
+                return;
+            for (auto const& buf : buffers) {
+                if (buf.size() == 0)
+                    continue;
+                out_queue.push_back(
+                  output{.borrowed = stl::string_view{static_cast<char const*>(buf.data()), buf.size()},
+                         .owner    = owner,
+                         .counted  = true});
+                queued_bytes += buf.size();
+            }
+            flush();
+        }
+
+        /**
+         * Hold the output until uncork, so what's sent in between goes out
+         * with one gather write; it's done for the data handler already, so
+         * it's only needed for the responses that are finished somewhere
+         * else (a thread pool, or a timer). They nest.
+         */
+        void cork() noexcept {
+            corks++;
+        }
+
+        void uncork() noexcept {
+            if (corks != 0 && --corks == 0)
+                flush();
+        }
+
+        /**
+         * Close the connection after everything that is queued is written;
+         * nothing is read from the client anymore.
+         */
+        void close_after_write() noexcept {
+            closing = true;
+            if (!writing && out_queue.empty())
+                stop();
+        }
+
+        /**
+         * The server is shutting down gracefully; the connection is closed as
+         * soon as it's not busy and its output is written. The protocols
+         * should check is_draining and stop accepting new requests.
+         */
+        void drain() noexcept {
+            if (closed)
+                return;
+            draining = true;
+            if (!is_busy)
+                close_after_write();
+        }
+
+        /**
+         * The protocol tells us that it has a half-read request (or a
+         * response that is not finished yet), so a drain should wait for it.
+         */
+        void busy(bool value) noexcept {
+            if (is_busy == value)
+                return;
+            is_busy = value;
+            if (draining && !is_busy)
+                close_after_write();
+            rearm();
+        }
+
+        [[nodiscard]] bool is_draining() const noexcept {
+            return draining;
+        }
 
         /**
          * We're shutting down everything, keep up!
          */
-        void stop() noexcept;
+        void stop() noexcept {
+            if (!closed) {
+                closed = true;
+#ifdef WEBPP_USE_TLS
+                // the close_notify, if it fits; it's not waited for
+                if (tls && tls_ready && !writing) {
+                    SSL_shutdown(tls.get());
+                    ERR_clear_error();
+                }
+#endif
+                istl::net_error_code ec;
+                socket.shutdown(socket_t::shutdown_both, ec);
+#ifdef WEBPP_USE_IO_URING
+                // the ring holds its own reference to the socket, so closing
+                // it doesn't end the pending operations
+                if (ring != nullptr && reading)
+                    ring->cancel(buffers != nullptr ? poll_op : read_op);
+                if (ring != nullptr && writing)
+                    ring->cancel(write_op);
+#endif
+                socket.close(ec);
+                if (timers != nullptr)
+                    timers->cancel(timeout_timer);
+            }
+            finish();
+        }
+
+        /**
+         * Set the limits of the output queue
+         */
+        void water_marks(stl::size_t high, stl::size_t low) noexcept {
+            high_water = high;
+            low_water  = low < high ? low : high;
+        }
+
+        [[nodiscard]] bool is_open() const noexcept {
+            return !closed && socket.is_open();
+        }
+
+        /**
+         * We've stopped reading because the client is not reading its responses
+         */
+        [[nodiscard]] bool is_read_paused() const noexcept {
+            return read_paused;
+        }
+
+        /**
+         * The number of bytes that are waiting to be written
+         */
+        [[nodiscard]] stl::size_t queued_size() const noexcept {
+            return queued_bytes;
+        }
+
+        /**
+         * The number of outputs that are waiting to be written; the borrowed
+         * bytes are counted here, not in queued_size.
+         */
+        [[nodiscard]] stl::size_t queued_count() const noexcept {
+            return out_queue.size();
+        }
     };
 
 } // namespace webpp::common
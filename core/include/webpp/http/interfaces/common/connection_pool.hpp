@@ -0,0 +1,102 @@
+#ifndef WEBPP_INTERFACE_COMMON_CONNECTION_POOL_H
+#define WEBPP_INTERFACE_COMMON_CONNECTION_POOL_H
+
+#include "../../../std/std.hpp"
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace webpp::common {
+
+    /**
+     * A pool of objects that never move.
+     *
+     * The objects are allocated in slabs, and the released ones are kept in a
+     * free-list to be reused; so once the pool has grown to the number of
+     * objects that are needed at the same time, getting an object doesn't
+     * allocate, and a pointer to an object is valid as long as the pool lives.
+     *
+     * The released objects are not destroyed, it's up to the user to reset
+     * them before using them again.
+     */
+    template <typename T, stl::size_t SlabSize = 32>
+    class object_pool {
+        static_assert(SlabSize > 0, "The slabs should have room for at least one object.");
+
+        using slab_type = stl::array<stl::optional<T>, SlabSize>;
+
+        stl::vector<stl::unique_ptr<slab_type>> slabs;
+        stl::vector<T*>                         free_list;
+        stl::size_t                             last_slab_size = SlabSize; // constructed objects in the last slab
+
+      public:
+        object_pool() noexcept = default;
+        object_pool(object_pool const&) = delete;
+        object_pool& operator=(object_pool const&) = delete;
+
+        /**
+         * Get a released object; nullptr if there's none
+         */
+        [[nodiscard]] T* reuse() noexcept {
+            if (free_list.empty())
+                return nullptr;
+            auto obj = free_list.back();
+            free_list.pop_back();
+            return obj;
+        }
+
+        /**
+         * Construct a new object in the pool
+         */
+        template <typename... Args>
+        [[nodiscard]] T* emplace(Args&&... args) noexcept {
+            if (last_slab_size == SlabSize) {
+                slabs.push_back(stl::make_unique<slab_type>());
+                last_slab_size = 0;
+                // the free list should never need to grow while we're releasing
+                free_list.reserve(slabs.size() * SlabSize);
+            }
+            return &(*slabs.back())[last_slab_size++].emplace(stl::forward<Args>(args)...);
+        }
+
+        /**
+         * Give the object back to the pool; the object should have been taken
+         * from this pool.
+         */
+        void release(T* obj) noexcept {
+            free_list.push_back(obj);
+        }
+
+        /**
+         * Call the callback with every constructed object, released or not
+         */
+        template <typename Callback>
+        void for_each(Callback&& callback) noexcept {
+            for (stl::size_t i = 0; i < slabs.size(); i++) {
+                auto const count = i + 1 == slabs.size() ? last_slab_size : SlabSize;
+                for (stl::size_t j = 0; j < count; j++)
+                    callback(*(*slabs[i])[j]);
+            }
+        }
+
+        /**
+         * The number of objects that are in use
+         */
+        [[nodiscard]] stl::size_t size() const noexcept {
+            return capacity() - free_list.size();
+        }
+
+        /**
+         * The number of constructed objects
+         */
+        [[nodiscard]] stl::size_t capacity() const noexcept {
+            return slabs.empty() ? 0 : (slabs.size() - 1) * SlabSize + last_slab_size;
+        }
+    };
+
+} // namespace webpp::common
+
+#endif // WEBPP_INTERFACE_COMMON_CONNECTION_POOL_H
@@ -1,6 +1,9 @@
 #ifndef WEBPP_INTERFACE_COMMON_CONSTANTS_H
 #define WEBPP_INTERFACE_COMMON_CONSTANTS_H
 
+#include <chrono>
+#include <cstddef>
+
 constexpr std::size_t buffer_size = 1024 * 1024;
 
 /**
@@ -23,4 +26,58 @@ constexpr auto default_fcgi_listen_addr = "localhost";
  */
 constexpr auto default_fcgi_listen_port = 8181;
 
+/**
+ * This is the default number of connections that the server keeps open at the
+ * same time. The server stops accepting new connections when it reaches this
+ * limit and starts again as soon as one of them gets closed.
+ */
+constexpr std::size_t default_max_connections = 10000;
+
+/**
+ * When the output of a connection that is waiting to be written goes over this
+ * limit, we stop reading from that connection; and we start reading again when
+ * it goes under the low-water mark.
+ */
+constexpr std::size_t default_high_water_mark = 1024 * 1024;
+constexpr std::size_t default_low_water_mark  = 256 * 1024;
+
+/**
+ * How long a graceful shutdown waits for the open connections to finish
+ * their requests before closing them anyway
+ */
+constexpr std::chrono::steady_clock::duration default_drain_timeout = std::chrono::seconds(30);
+
+/**
+ * The connections are closed when they stay quiet for too long:
+ *   idle:  waiting for a new request (a keep-alive connection)
+ *   read:  in the middle of reading a request
+ *   write: a response is being written but the client doesn't read it
+ * Zero means no timeout.
+ */
+constexpr std::chrono::steady_clock::duration default_idle_timeout  = std::chrono::seconds(60);
+constexpr std::chrono::steady_clock::duration default_read_timeout  = std::chrono::seconds(30);
+constexpr std::chrono::steady_clock::duration default_write_timeout = std::chrono::seconds(60);
+
+/**
+ * The timeouts are checked this often (one tick of the timing wheels)
+ */
+constexpr std::chrono::steady_clock::duration default_timer_resolution = std::chrono::milliseconds(100);
+
+/**
+ * The size of each worker's io_uring (when it's enabled), and the number of
+ * the connections' read buffers that are registered in it; the registered
+ * buffers are pinned in memory, so it's not a good idea to register all of
+ * them.
+ */
+constexpr unsigned default_uring_entries      = 256;
+constexpr unsigned default_uring_buffer_slots = 64;
+
+/**
+ * The request bodies are read in chunks of this size, and the convenience
+ * functions that give you the whole body at once stop at the max size (use
+ * the streaming functions for the bigger uploads).
+ */
+constexpr std::size_t default_body_chunk_size = 64 * 1024;
+constexpr std::size_t default_max_body_size   = 16 * 1024 * 1024;
+
 #endif // WEBPP_INTERFACE_COMMON_CONSTANTS_H
\ No newline at end of file
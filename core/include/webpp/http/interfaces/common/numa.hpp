@@ -0,0 +1,168 @@
+#ifndef WEBPP_INTERFACES_COMMON_NUMA_H
+#define WEBPP_INTERFACES_COMMON_NUMA_H
+
+#include "../../../std/std.hpp"
+#include "../../../std/string.hpp"
+#include "../../../std/string_view.hpp"
+#include "../../../std/vector.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <thread>
+
+#ifdef __linux__
+#    include <pthread.h>
+#    include <sched.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+namespace webpp::common {
+
+    /**
+     * A NUMA node: the cores that are close to its memory
+     */
+    struct numa_node {
+        unsigned              id;
+        stl::vector<unsigned> cpus;
+    };
+
+    /**
+     * Parse a list of the CPUs the way the kernel writes them ("0-3,8-11")
+     */
+    [[nodiscard]] inline stl::vector<unsigned> parse_cpu_list(stl::string_view list) {
+        stl::vector<unsigned> cpus;
+        while (!list.empty()) {
+            auto const comma = list.find(',');
+            auto       item  = list.substr(0, comma);
+            list.remove_prefix(comma == stl::string_view::npos ? list.size() : comma + 1);
+            while (!item.empty() && (item.back() == '\n' || item.back() == ' '))
+                item.remove_suffix(1);
+
+            unsigned   first = 0, last = 0;
+            auto const dash  = item.find('-');
+            auto const head  = item.substr(0, dash);
+            if (stl::from_chars(head.data(), head.data() + head.size(), first).ec != stl::errc{})
+                continue;
+            last = first;
+            if (dash != stl::string_view::npos) {
+                auto const tail = item.substr(dash + 1);
+                if (stl::from_chars(tail.data(), tail.data() + tail.size(), last).ec != stl::errc{} ||
+                    last < first)
+                    continue;
+            }
+            for (auto cpu = first; cpu <= last; cpu++)
+                cpus.push_back(cpu);
+        }
+        return cpus;
+    }
+
+    /**
+     * The NUMA nodes of the machine, and the CPUs of each one that this
+     * process is allowed to run on. A machine without NUMA (or without sysfs)
+     * is one node with all of the CPUs.
+     */
+    class numa_topology {
+        stl::vector<numa_node> node_list{};
+        stl::vector<int>       cpu_nodes{}; // the index of the node of each CPU, -1 if it's not ours
+
+        void index_cpus() {
+            cpu_nodes.clear();
+            for (stl::size_t index = 0; index < node_list.size(); index++) {
+                for (auto const cpu : node_list[index].cpus) {
+                    if (cpu >= cpu_nodes.size())
+                        cpu_nodes.resize(cpu + 1, -1);
+                    cpu_nodes[cpu] = static_cast<int>(index);
+                }
+            }
+        }
+
+      public:
+        numa_topology() = default;
+
+        explicit numa_topology(stl::vector<numa_node> nodes) : node_list{stl::move(nodes)} {
+            stl::erase_if(node_list, [](numa_node const& node) {
+                return node.cpus.empty();
+            });
+            index_cpus();
+        }
+
+        /**
+         * Read it from /sys/devices/system/node
+         */
+        [[nodiscard]] static numa_topology detect() {
+            stl::vector<numa_node> nodes;
+#ifdef __linux__
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            bool const has_allowed = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+            auto const read_file = [](stl::string const& path) {
+                stl::ifstream file{path};
+                return stl::string{stl::istreambuf_iterator<char>{file}, stl::istreambuf_iterator<char>{}};
+            };
+            for (auto const id : parse_cpu_list(read_file("/sys/devices/system/node/online"))) {
+                auto cpus =
+                  parse_cpu_list(read_file("/sys/devices/system/node/node" + stl::to_string(id) + "/cpulist"));
+                if (has_allowed) {
+                    stl::erase_if(cpus, [&](unsigned cpu) {
+                        return cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed);
+                    });
+                }
+                nodes.push_back({id, stl::move(cpus)});
+            }
+#endif
+            numa_topology topology{stl::move(nodes)};
+            if (topology.node_list.empty()) {
+                numa_node all{0, {}};
+                for (unsigned cpu = 0; cpu < stl::max(1u, stl::thread::hardware_concurrency()); cpu++)
+                    all.cpus.push_back(cpu);
+                topology = numa_topology{{stl::move(all)}};
+            }
+            return topology;
+        }
+
+        [[nodiscard]] stl::vector<numa_node> const& nodes() const noexcept {
+            return node_list;
+        }
+
+        [[nodiscard]] stl::size_t node_count() const noexcept {
+            return node_list.size();
+        }
+
+        /**
+         * The index (in nodes()) of the node of the CPU
+         */
+        [[nodiscard]] stl::optional<stl::size_t> node_of_cpu(unsigned cpu) const noexcept {
+            if (cpu >= cpu_nodes.size() || cpu_nodes[cpu] < 0)
+                return stl::nullopt;
+            return static_cast<stl::size_t>(cpu_nodes[cpu]);
+        }
+    };
+
+    /**
+     * Make the kernel prefer the node's memory for the pages that this thread
+     * touches first (set_mempolicy with MPOL_PREFERRED); the memory of the
+     * other nodes is still used when the node is full. False if it's not
+     * supported.
+     */
+    inline bool prefer_numa_node([[maybe_unused]] unsigned node) noexcept {
+#if defined(__linux__) && defined(SYS_set_mempolicy)
+        constexpr int      mpol_preferred = 1;
+        constexpr unsigned word_bits      = sizeof(unsigned long) * 8;
+        unsigned long      mask[4]{};
+        if (node >= word_bits * stl::size(mask))
+            return false;
+        mask[node / word_bits] = 1ul << (node % word_bits);
+        return ::syscall(SYS_set_mempolicy, mpol_preferred, mask, word_bits * stl::size(mask) + 1) == 0;
+#else
+        return false;
+#endif
+    }
+
+} // namespace webpp::common
+
+#endif // WEBPP_INTERFACES_COMMON_NUMA_H
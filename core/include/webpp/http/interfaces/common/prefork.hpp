@@ -0,0 +1,385 @@
+#ifndef WEBPP_INTERFACES_COMMON_PREFORK_H
+#define WEBPP_INTERFACES_COMMON_PREFORK_H
+
+#include "../../../std/internet.hpp"
+#include "../../../std/io_context.hpp"
+#include "../../../std/socket.hpp"
+#include "../../../std/std.hpp"
+#include "../../../utils/logger.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+#ifdef __unix__
+#    include <cerrno>
+#    include <csignal>
+#    include <ctime>
+#    include <pthread.h>
+#    include <sys/socket.h>
+#    include <sys/wait.h>
+#    include <unistd.h>
+#endif
+#ifdef __linux__
+#    include <sched.h>
+#endif
+#ifdef SO_REUSEPORT
+#    include <boost/asio/detail/socket_option.hpp>
+#endif
+
+/**
+ * The prefork mode: a master process opens the listening sockets and forks
+ * the workers, which inherit them and accept on them; each worker is a whole
+ * server of its own (its own allocator, its own application), so the
+ * applications that are not thread-safe scale over the cores too, and a
+ * crash only takes one worker down. The master restarts the workers that
+ * crash, passes SIGHUP on to them, and stops them on SIGTERM or SIGINT.
+ */
+namespace webpp::common {
+
+    struct prefork_options {
+        // the number of the worker processes; zero means one per core
+        stl::size_t workers = 0;
+
+        // the threads in each worker process (for the interfaces that have them)
+        stl::size_t worker_threads = 1;
+
+        // pin the worker processes to the cores, one each
+        bool pin = true;
+
+        // the time to wait before starting a worker again after it crashes
+        stl::chrono::milliseconds restart_delay{500};
+
+        // the time that the workers have to exit after SIGTERM, before they get a SIGKILL
+        stl::chrono::milliseconds stop_timeout{10'000};
+    };
+
+    /**
+     * What a worker process knows about itself
+     */
+    struct prefork_worker {
+        stl::size_t          index    = 0; // the slot, and the core that it's pinned to
+        stl::size_t          restarts = 0; // the times that this slot has crashed before
+        stl::span<int const> listeners{};  // the listening sockets; the worker owns its copies
+    };
+
+    class prefork {
+      public:
+        using endpoint_t = stl::net::ip::tcp::endpoint;
+        using worker_t   = stl::function<int(prefork_worker const&)>;
+
+      private:
+        struct slot {
+            pid_t       pid      = 0; // zero if it's not running
+            stl::size_t restarts = 0;
+
+            stl::chrono::steady_clock::time_point start_at{}; // when it should be started again
+        };
+
+        prefork_options   options;
+        stl::vector<int>  handles;
+        stl::vector<slot> slots;
+#ifdef __unix__
+        pthread_t         master{};
+        stl::atomic<bool> master_running = false;
+#endif
+
+      public:
+        explicit prefork(prefork_options const& opts = {}) noexcept : options{opts} {
+            if (options.workers == 0)
+                options.workers = stl::max(1u, stl::thread::hardware_concurrency());
+        }
+
+        prefork(prefork const&)            = delete;
+        prefork& operator=(prefork const&) = delete;
+
+        ~prefork() noexcept {
+#ifdef __unix__
+            for (auto const handle : handles)
+                ::close(handle);
+#endif
+        }
+
+        /**
+         * Open the listening sockets in the master, before the workers are
+         * forked; returns false if none of them could be opened.
+         */
+        bool listen(stl::span<endpoint_t const> endpoints) noexcept {
+            stl::net::io_context io;
+            for (auto const& endpoint : endpoints) {
+                istl::net_error_code            ec;
+                stl::net::ip::tcp::acceptor acceptor{io};
+                acceptor.open(endpoint.protocol(), ec);
+                if (!ec)
+                    acceptor.set_option(stl::net::ip::tcp::acceptor::reuse_address(true), ec);
+#ifdef SO_REUSEPORT
+                // so the workers can open their own siblings on it too (see server::adopt)
+                if (!ec)
+                    acceptor.set_option(
+                      boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true), ec);
+#endif
+                if (!ec)
+                    acceptor.bind(endpoint, ec);
+                if (!ec)
+                    acceptor.listen(stl::net::ip::tcp::acceptor::max_listen_connections, ec);
+                if (ec) {
+                    log_error("can't listen on {}:{}: {}",
+                              endpoint.address().to_string(),
+                              endpoint.port(),
+                              ec.message());
+                    continue;
+                }
+                handles.push_back(acceptor.release(ec));
+            }
+            return !handles.empty();
+        }
+
+        /**
+         * The endpoints that the master listens on; the ports are the real
+         * ones even if port 0 was asked for.
+         */
+        [[nodiscard]] stl::vector<endpoint_t> local_endpoints() const noexcept {
+            stl::vector<endpoint_t> res;
+#ifdef __unix__
+            for (auto const handle : handles) {
+                sockaddr_storage addr{};
+                socklen_t        len = sizeof(addr);
+                if (::getsockname(handle, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+                    continue;
+                if (addr.ss_family == AF_INET) {
+                    auto const& in = reinterpret_cast<sockaddr_in const&>(addr);
+                    res.emplace_back(stl::net::ip::address_v4{ntohl(in.sin_addr.s_addr)}, ntohs(in.sin_port));
+                } else if (addr.ss_family == AF_INET6) {
+                    auto const&                         in6 = reinterpret_cast<sockaddr_in6 const&>(addr);
+                    stl::net::ip::address_v6::bytes_type bytes;
+                    stl::memcpy(bytes.data(), in6.sin6_addr.s6_addr, bytes.size());
+                    res.emplace_back(stl::net::ip::address_v6{bytes}, ntohs(in6.sin6_port));
+                }
+            }
+#endif
+            return res;
+        }
+
+        [[nodiscard]] stl::span<int const> listeners() const noexcept {
+            return handles;
+        }
+
+        [[nodiscard]] stl::size_t worker_count() const noexcept {
+            return options.workers;
+        }
+
+        /**
+         * Fork the workers and look after them until they're all done; the
+         * worker function runs in each of them, and its result is the exit
+         * code of that process. A worker that exits with zero is done; one
+         * that crashes, or exits with anything else, is started again. Where
+         * there's no fork, the worker runs once, in this process.
+         * @returns zero if the workers exited on their own, or the signal
+         *          that stopped them
+         */
+        int run(worker_t const& worker) noexcept {
+#ifdef __unix__
+            sigset_t signals;
+            sigset_t old_mask;
+            sigemptyset(&signals);
+            sigaddset(&signals, SIGCHLD);
+            sigaddset(&signals, SIGTERM);
+            sigaddset(&signals, SIGINT);
+            sigaddset(&signals, SIGHUP);
+            // they're waited for here, not handled
+            pthread_sigmask(SIG_BLOCK, &signals, &old_mask);
+            master = pthread_self();
+            master_running.store(true);
+
+            slots.assign(options.workers, slot{});
+            for (stl::size_t i = 0; i < slots.size(); i++)
+                spawn(i, worker, old_mask);
+
+            int result = 0;
+            while (running_count() != 0 || has_pending_restarts()) {
+                // the other threads may take the SIGCHLD if they don't block
+                // it, so the children are looked for once a second anyway
+                auto const wait =
+                  stl::min(next_restart_wait().value_or(stl::chrono::milliseconds{1000}), stl::chrono::milliseconds{1000});
+                timespec const timeout{.tv_sec  = static_cast<time_t>(wait.count() / 1000),
+                                       .tv_nsec = static_cast<long>(wait.count() % 1000) * 1'000'000};
+                siginfo_t      info{};
+                int const      sig = ::sigtimedwait(&signals, &info, &timeout);
+
+                if (sig == SIGCHLD || sig < 0) {
+                    reap();
+                } else if (sig == SIGHUP) {
+                    signal_workers(SIGHUP); // they reload their config
+                } else if (sig == SIGTERM || sig == SIGINT) {
+                    result = sig;
+                    stop_workers();
+                    break;
+                }
+                restart_due(worker, old_mask);
+            }
+
+            master_running.store(false);
+            pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+            return result;
+#else
+            return worker(prefork_worker{.index = 0, .restarts = 0, .listeners = handles});
+#endif
+        }
+
+        /**
+         * Stop the workers, and make "run" return; it can be called from any
+         * thread of the master.
+         */
+        void stop() noexcept {
+#ifdef __unix__
+            if (master_running.load())
+                pthread_kill(master, SIGTERM);
+#endif
+        }
+
+      private:
+#ifdef __unix__
+        static void pin_to_core([[maybe_unused]] stl::size_t core) noexcept {
+#    ifdef __linux__
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(core % CPU_SETSIZE, &cpus);
+            sched_setaffinity(0, sizeof(cpus), &cpus);
+#    endif
+        }
+
+        void spawn(stl::size_t index, worker_t const& worker, sigset_t const& old_mask) noexcept {
+            auto&       s   = slots[index];
+            pid_t const pid = ::fork();
+            if (pid < 0) {
+                log_error("can't fork the worker {}: {}", index, stl::strerror(errno));
+                s.restarts++;
+                s.start_at = stl::chrono::steady_clock::now() + options.restart_delay;
+                return;
+            }
+            if (pid == 0) {
+                // the worker gets the signals again, SIGTERM is what stops it
+                pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+                if (options.pin)
+                    pin_to_core(index);
+                int const code = worker(prefork_worker{.index = index, .restarts = s.restarts, .listeners = handles});
+                // the master's objects are the master's to destroy
+                ::_exit(code);
+            }
+            s.pid = pid;
+        }
+
+        [[nodiscard]] stl::size_t running_count() const noexcept {
+            stl::size_t count = 0;
+            for (auto const& s : slots)
+                count += s.pid != 0 ? 1 : 0;
+            return count;
+        }
+
+        [[nodiscard]] bool has_pending_restarts() const noexcept {
+            for (auto const& s : slots)
+                if (s.pid == 0 && s.start_at != stl::chrono::steady_clock::time_point{})
+                    return true;
+            return false;
+        }
+
+        [[nodiscard]] stl::optional<stl::chrono::milliseconds> next_restart_wait() const noexcept {
+            stl::optional<stl::chrono::milliseconds> res;
+            auto const                                now = stl::chrono::steady_clock::now();
+            for (auto const& s : slots) {
+                if (s.pid != 0 || s.start_at == stl::chrono::steady_clock::time_point{})
+                    continue;
+                auto const wait = stl::max(stl::chrono::milliseconds{0},
+                                           stl::chrono::ceil<stl::chrono::milliseconds>(s.start_at - now));
+                if (!res || wait < *res)
+                    res = wait;
+            }
+            return res;
+        }
+
+        void reap() noexcept {
+            int   status = 0;
+            pid_t pid    = 0;
+            while ((pid = ::waitpid(-1, &status, WNOHANG)) > 0) {
+                for (stl::size_t i = 0; i < slots.size(); i++) {
+                    auto& s = slots[i];
+                    if (s.pid != pid)
+                        continue;
+                    s.pid = 0;
+                    if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+                        s.start_at = {}; // it's done
+                        break;
+                    }
+                    if (WIFSIGNALED(status)) {
+                        log_warning("the worker {} was killed by the signal {}; it's started again",
+                                    i,
+                                    WTERMSIG(status));
+                    } else {
+                        log_warning("the worker {} exited with {}; it's started again", i, WEXITSTATUS(status));
+                    }
+                    s.restarts++;
+                    s.start_at = stl::chrono::steady_clock::now() + options.restart_delay;
+                    break;
+                }
+            }
+        }
+
+        void restart_due(worker_t const& worker, sigset_t const& old_mask) noexcept {
+            auto const now = stl::chrono::steady_clock::now();
+            for (stl::size_t i = 0; i < slots.size(); i++) {
+                auto& s = slots[i];
+                if (s.pid == 0 && s.start_at != stl::chrono::steady_clock::time_point{} && s.start_at <= now) {
+                    s.start_at = {};
+                    spawn(i, worker, old_mask);
+                }
+            }
+        }
+
+        void signal_workers(int sig) const noexcept {
+            for (auto const& s : slots)
+                if (s.pid != 0)
+                    ::kill(s.pid, sig);
+        }
+
+        /**
+         * Ask the workers to stop, and kill the ones that don't in time
+         */
+        void stop_workers() noexcept {
+            signal_workers(SIGTERM);
+            auto const deadline = stl::chrono::steady_clock::now() + options.stop_timeout;
+            while (running_count() != 0) {
+                int   status = 0;
+                pid_t pid    = ::waitpid(-1, &status, WNOHANG);
+                if (pid > 0) {
+                    for (auto& s : slots)
+                        if (s.pid == pid)
+                            s.pid = 0;
+                    continue;
+                }
+                if (pid < 0 && errno == ECHILD)
+                    break;
+                if (stl::chrono::steady_clock::now() >= deadline) {
+                    signal_workers(SIGKILL);
+                    for (auto& s : slots) {
+                        if (s.pid != 0)
+                            ::waitpid(s.pid, &status, 0);
+                        s.pid = 0;
+                    }
+                    break;
+                }
+                stl::this_thread::sleep_for(stl::chrono::milliseconds{10});
+            }
+            for (auto& s : slots)
+                s.start_at = {};
+        }
+#endif
+    };
+
+} // namespace webpp::common
+
+#endif // WEBPP_INTERFACES_COMMON_PREFORK_H
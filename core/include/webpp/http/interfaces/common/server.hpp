@@ -1,70 +1,582 @@
 #ifndef WEBPP_INTERFACES_COMMON_SERVER_H
 #define WEBPP_INTERFACES_COMMON_SERVER_H
 
-#include "../../std/buffer.hpp"
-#include "../../std/internet.hpp"
-#include "../../std/io_context.hpp"
+#include "../../../config.hpp"
+#include "../../../std/buffer.hpp"
+#include "../../../std/internet.hpp"
+#include "../../../std/io_context.hpp"
+#include "../../../std/socket.hpp"
+#include "../../../std/timer.hpp"
+#include "../../../utils/logger.hpp"
+#include "../../../utils/metrics.hpp"
+#include "../../../utils/tracing.hpp"
+#include "buffer_pool.hpp"
 #include "connection.hpp"
+#include "connection_pool.hpp"
 #include "constants.hpp"
+#include "numa.hpp"
+#include "socket_handoff.hpp"
+#include "timing_wheel.hpp"
+#include "uring.hpp"
 
-#include <boost/asio/thread_pool.hpp>
+#include <atomic>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/signal_set.hpp>
+#include <chrono>
+#include <csignal>
+#include <functional>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <thread>
 #include <vector>
 
+#ifdef __linux__
+#    include <pthread.h>
+#    include <sched.h>
+#endif
+#ifdef __unix__
+#    include <boost/asio/local/stream_protocol.hpp>
+#    include <sys/socket.h>
+#    include <unistd.h>
+#endif
+#ifdef SO_REUSEPORT
+#    include <boost/asio/detail/socket_option.hpp>
+#endif
+
 namespace webpp::common {
 
+    /**
+     * How the server chooses the worker that gets the next connection
+     */
+    enum struct balance_policy {
+        round_robin, // one after another
+        least_load   // the one with the least number of open connections
+    };
+
     /**
      * This class is the server and the connection manager.
+     *
+     * The server can run more than one io_context (one per core); the
+     * acceptors run on the first one, and each accepted socket is handed to a
+     * single worker which runs every handler of that connection afterwards,
+     * so the connections never jump between threads.
+     *
+     * With "reuse_port", every worker opens its own acceptor on each endpoint
+     * (SO_REUSEPORT) and the kernel load-balances the new connections between
+     * them; then no connection is ever handed over to another thread and
+     * there's no single acceptor to be the bottleneck.
+     *
+     * Shutting down can be graceful (drain): the acceptors are closed, the
+     * idle connections are closed, and the busy ones get some time to finish
+     * their requests. The listening sockets can also be handed to a new
+     * process before draining (hot restart), so the port is never closed.
+     *
+     * Each worker has one timing wheel for the timeouts of all of its
+     * connections, instead of one timer for each of them.
+     *
+     * With the io_uring backend (WEBPP_IO_URING), each worker also has its
+     * own ring; the listeners use a multishot accept on it, and the
+     * connections read and write through it. If the ring can't be set up,
+     * the worker falls back on asio.
+     *
+     * On the NUMA machines, the workers can be placed on the nodes (see
+     * numa): each one runs on a core of its node, its memory comes from its
+     * node, and the new connections go to the workers of the node whose core
+     * got their packets.
      */
     class server {
       public:
-        using socket_t     = std::net::ip::tcp::socket;
-        using endpoint_t   = std::net::ip::tcp::endpoint;
-        using io_context_t = std::net::io_context;
+        using socket_t     = stl::net::ip::tcp::socket;
+        using endpoint_t   = stl::net::ip::tcp::endpoint;
+        using acceptor_t   = stl::net::ip::tcp::acceptor;
+        using io_context_t = stl::net::io_context;
+        using duration_t   = stl::chrono::steady_clock::duration;
+        using handle_t     = acceptor_t::native_handle_type;
+
+        // creates the data handler (the protocol) of each new connection;
+        // it's called from the workers' threads
+        using handler_factory_t = stl::function<connection::data_handler_t()>;
 
         // I share this publicly because I know this file will not be used in a
         // header file so the final user doesn't have access to this class.
+        // This is the first worker's io_context; the acceptors live here too.
         io_context_t io;
 
       private:
-        std::vector<connection>                  connections;
-        std::vector<std::net::ip::tcp::acceptor> acceptors;
-        boost::asio::thread_pool                 pool;
-
-        void accept() noexcept {
-            //            for (auto& acceptor : acceptors)
-            //                acceptor.async_accept(
-            //                    [this](std::error_code const& ec, socket_t
-            //                    socket) {
-            //                        // Check whether the server was stopped by a signal
-            //
-            //                        // before this completion handler had a chance to run
-            //                        if (!acceptor.is_open()) {
-            //                            return;
-            //                        }
-            //
-            //                        if (!ec) {
-            //                            connections.emplace_back(std::move(socket));
-            //                        } else {
-            //                            // TODO: log
-            //                        }
-            //
-            //                        if (!io.stopped())
-            //                            accept();
-            //                    });
+        // the connections capture their own address in their handlers, so
+        // they should never move; the pool also reuses them so accepting a
+        // connection doesn't allocate (the read buffers are in the worker's
+        // buffer pool).
+        using connection_pool = object_pool<connection>;
+        using work_guard_t    = boost::asio::executor_work_guard<io_context_t::executor_type>;
+
+        /**
+         * A worker owns an io_context and the connections that live on it;
+         * the connection list is only touched from the worker's own thread.
+         */
+        struct listener;
+
+        struct worker {
+            io_context_t*            ctx;
+            timer_service            timers;
+            load_shedder             shedder{};
+            buffer_pool              buffers{}; // the read buffers of the connections, while they're reading
+            connection_pool          connections{};
+            stl::atomic<stl::size_t> load{0};
+
+            // this worker's copy of the timeouts, and the generation of them
+            // that it was copied from; only touched from the worker's thread
+            connection_timeouts timeouts{};
+            stl::uint64_t       timeouts_gen = 0;
+
+            // the acceptors of this worker that are waiting for the connection
+            // count to go down before they accept another connection
+            std::vector<listener*> paused_listeners{};
+
+            // we're waiting for the connections to finish, until the timer expires
+            bool                                    draining = false;
+            stl::unique_ptr<stl::net::steady_timer> drain_timer{};
+
+#ifdef WEBPP_USE_IO_URING
+            stl::unique_ptr<uring_service> ring;
+#endif
+
+            // where it runs, if it's placed on a NUMA node (see numa)
+            stl::optional<stl::size_t> node{}; // the index of the node in the topology
+            stl::optional<unsigned>    cpu{};
+
+            worker(io_context_t* _ctx) noexcept : ctx{_ctx}, timers{*_ctx, default_timer_resolution} {
+#ifdef WEBPP_USE_IO_URING
+                ring = stl::make_unique<uring_service>(*_ctx);
+                if (!ring->is_open())
+                    ring.reset();
+#endif
+            }
+        };
+
+        /**
+         * An acceptor and the worker that it runs on
+         */
+        struct listener {
+            acceptor_t acceptor;
+            worker*    home;
+
+#ifdef WEBPP_USE_IO_URING
+            stl::net::ip::tcp protocol = stl::net::ip::tcp::v4();
+            uring_operation   accept_op{};
+            bool              ring_armed = false; // the accept operation is pending
+            bool              paused     = false; // it's in its home's paused list
+#endif
+        };
+
+        std::vector<std::unique_ptr<io_context_t>> worker_contexts; // the extra ones
+        stl::list<worker>                          workers;
+        stl::list<listener>                        listeners;
+        stl::atomic<stl::size_t>                   max_connections{default_max_connections};
+        balance_policy                             policy = balance_policy::least_load;
+        bool                                       sharded         = false;
+        bool                                       shed            = false; // see shedding
+        stl::size_t                                next_worker     = 0;
+        stl::atomic<stl::size_t>                   total_connections{0};
+        handler_factory_t                          handler_factory;
+        connection_timeouts                        conn_timeouts{}; // guarded by the limits_lock
+        stl::atomic<stl::uint64_t>                 timeouts_gen{0};
+        mutable stl::mutex                         limits_lock;
+        stl::optional<boost::asio::signal_set>     hangup;
+        stl::function<void()>                      hangup_handler;
+        metric_counter                             accepted_counter{};
+        metric_gauge                               open_gauge{};
+        connection_metrics                         conn_metrics{};
+        numa_topology                              topology{}; // empty if the workers are not placed
+
+#ifdef WEBPP_USE_TLS
+        tls_context const* tls_ctx = nullptr; // see tls
+#endif
+
+#ifdef __unix__
+        using local_acceptor_t = boost::asio::local::stream_protocol::acceptor;
+
+        stl::optional<local_acceptor_t> handoff_acceptor;
+        stl::string                     handoff_path;
+#endif
+
+        /**
+         * @param node only the workers of this NUMA node, if there's one of them
+         */
+        worker& choose_worker(stl::optional<stl::size_t> node = stl::nullopt) noexcept {
+            auto const on_node = [node](worker const& w) noexcept {
+                return !node || w.node == node;
+            };
+            if (policy == balance_policy::round_robin) {
+                for (stl::size_t tries = 0; tries < workers.size(); tries++) {
+                    auto it     = stl::next(workers.begin(), static_cast<long>(next_worker));
+                    next_worker = (next_worker + 1) % workers.size();
+                    if (on_node(*it))
+                        return *it;
+                }
+                return workers.front();
+            }
+            auto chosen = workers.end();
+            for (auto it = workers.begin(); it != workers.end(); ++it) {
+                if (on_node(*it) && (chosen == workers.end() || it->load.load(stl::memory_order_relaxed) <
+                                                                  chosen->load.load(stl::memory_order_relaxed)))
+                    chosen = it;
+            }
+            return chosen == workers.end() ? choose_worker() : *chosen;
         }
 
-      public:
-        // TODO: optimize this
-        server(std::vector<endpoint_t> endpoints) noexcept {};
+        /**
+         * Choose a worker on the NUMA node of the core that got the packets of
+         * the accepted socket (SO_INCOMING_CPU), so its data doesn't cross the
+         * nodes; any worker if the workers are not placed.
+         */
+        worker& choose_worker_near([[maybe_unused]] socket_t::native_handle_type fd) noexcept {
+#ifdef SO_INCOMING_CPU
+            if (topology.node_count() > 1) {
+                int       cpu = -1;
+                socklen_t len = sizeof(cpu);
+                if (::getsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) == 0 && cpu >= 0)
+                    return choose_worker(topology.node_of_cpu(static_cast<unsigned>(cpu)));
+            }
+#endif
+            return choose_worker();
+        }
 
-        void run() noexcept {
+        /**
+         * The connections are steered to the nodes after they're accepted
+         */
+        [[nodiscard]] bool steering() const noexcept {
+            return !sharded && topology.node_count() > 1;
+        }
+
+        /**
+         * Move the socket that's accepted on one worker's context to another's
+         */
+        static socket_t rehome(socket_t socket, worker& w) noexcept {
+            istl::net_error_code ec;
+            auto const           protocol = socket.local_endpoint(ec).protocol();
+            socket_t             moved{*w.ctx};
+            if (ec)
+                return moved;
+            auto const fd = socket.release(ec);
+            if (ec)
+                return moved;
+            moved.assign(protocol, fd, ec);
+            if (ec)
+                ::close(fd);
+            return moved;
+        }
+
+        /**
+         * Check if the listeners of the specified worker are allowed to accept
+         * more connections. The limit is shared between the workers when they
+         * have their own acceptors.
+         */
+        [[nodiscard]] bool has_room(worker const& home) const noexcept {
+            if (sharded)
+                return home.load.load(stl::memory_order_relaxed) * workers.size() <
+                       max_connections.load(stl::memory_order_relaxed);
+            return total_connections.load(stl::memory_order_relaxed) < max_connections.load(stl::memory_order_relaxed);
+        }
+
+        /**
+         * Give the new socket to its worker
+         */
+        void accepted(listener& l, worker& w, socket_t socket) noexcept {
+            WEBPP_TRACE_SPAN(accept, socket.native_handle());
+            w.load.fetch_add(1, stl::memory_order_relaxed);
+            total_connections.fetch_add(1, stl::memory_order_relaxed);
+            accepted_counter.inc();
+            open_gauge.inc();
+            if (&w == l.home) {
+                start_connection(w, *l.home, stl::move(socket));
+            } else {
+                boost::asio::post(*w.ctx, [this, &w, &l, socket = stl::move(socket)]() mutable {
+                    start_connection(w, *l.home, stl::move(socket));
+                });
+            }
+        }
+
+#ifdef WEBPP_USE_IO_URING
+        /**
+         * Accept on the home's ring; one multishot operation keeps accepting
+         * until we cancel it because we're full.
+         */
+        void ring_accept(listener& l) noexcept {
+            if (l.ring_armed)
+                return; // still waiting for the cancelled one to finish
+            l.ring_armed            = true;
+            l.accept_op.on_complete = [this, &l](int res, unsigned flags) {
+                auto& ring = *l.home->ring;
+                if ((flags & IORING_CQE_F_MORE) == 0)
+                    l.ring_armed = false;
+                if (!l.acceptor.is_open()) {
+                    if (res >= 0)
+                        ::close(res);
+                    return;
+                }
+                if (res >= 0) {
+                    // the sharded acceptors keep their connections for themselves
+                    auto&                w = sharded ? *l.home : choose_worker_near(res);
+                    istl::net_error_code ec;
+                    socket_t             socket{*w.ctx};
+                    socket.assign(l.protocol, res, ec);
+                    if (ec) {
+                        ::close(res);
+                    } else {
+                        // a multishot accept may give us a few more after we've
+                        // asked it to stop; they're served anyway
+                        accepted(l, w, stl::move(socket));
+                    }
+                } else if (res == -EINVAL && ring.is_multishot()) {
+                    ring.disable_multishot(); // an old kernel
+                } else if (res != -ECANCELED) {
+                    log_error("accept failed: {}", stl::system_category().message(-res));
+                }
+
+                if (l.home->ctx->stopped())
+                    return;
+                if (has_room(*l.home)) {
+                    if (!l.paused)
+                        ring_accept(l);
+                } else if (!l.paused) {
+                    l.paused = true;
+                    l.home->paused_listeners.push_back(&l);
+                    if (l.ring_armed)
+                        ring.cancel(l.accept_op);
+                }
+            };
+            l.home->ring->accept(l.accept_op, l.acceptor.native_handle());
+        }
+#endif
+
+        void accept(listener& l) noexcept {
+#ifdef WEBPP_USE_IO_URING
+            if (l.home->ring) {
+                l.paused = false;
+                ring_accept(l);
+                return;
+            }
+#endif
+            // the sharded acceptors keep their connections for themselves, and
+            // the ones that are steered to the NUMA nodes choose after accepting
+            auto& w = sharded || steering() ? *l.home : choose_worker();
+
+            // the socket is created on the worker's io_context so all of its
+            // handlers run on the worker's thread
+            l.acceptor.async_accept(*w.ctx, [this, &l, &w](istl::net_error_code const& ec, socket_t socket) {
+                // Check whether the server was stopped by a signal
+                // before this completion handler had a chance to run
+                if (!l.acceptor.is_open()) {
+                    return;
+                }
+
+                if (!ec && steering()) {
+                    auto& near = choose_worker_near(socket.native_handle());
+                    accepted(l, near, &near == &w ? stl::move(socket) : rehome(stl::move(socket), near));
+                } else if (!ec) {
+                    accepted(l, w, stl::move(socket));
+                } else {
+                    log_error("accept failed: {}", ec.message());
+                }
+
+                if (l.home->ctx->stopped())
+                    return;
+
+                if (has_room(*l.home)) {
+                    accept(l);
+                } else {
+                    // let the kernel's backlog hold the new connections until
+                    // we have room for them
+                    l.home->paused_listeners.push_back(&l);
+                }
+            });
+        }
+
+        void start_connection(worker& w, worker& home, socket_t socket) noexcept {
+            auto conn = w.connections.reuse();
+            if (conn) {
+                conn->reset(stl::move(socket));
+            } else {
+                conn = w.connections.emplace(stl::move(socket));
+            }
+            // the timeouts are only copied again after they've changed
+            if (auto const gen = timeouts_gen.load(stl::memory_order_acquire); gen != w.timeouts_gen) [[unlikely]] {
+                stl::scoped_lock lock{limits_lock};
+                w.timeouts     = conn_timeouts;
+                w.timeouts_gen = timeouts_gen.load(stl::memory_order_relaxed);
+            }
+            conn->timeouts(w.timers, w.timeouts);
+            conn->read_buffers(w.buffers);
+            conn->metrics(conn_metrics);
+            if (shed)
+                conn->shedding(w.shedder);
+#ifdef WEBPP_USE_TLS
+            if (tls_ctx != nullptr)
+                conn->use_tls(*tls_ctx);
+#endif
+#ifdef WEBPP_USE_IO_URING
+            if (w.ring)
+                conn->use_ring(*w.ring);
+#endif
+            conn->start(
+              [this, &w, &home, conn] {
+                  // the connection calls this from inside its own
+                  // handler, so we postpone releasing it
+                  boost::asio::post(*w.ctx, [this, &w, &home, conn] {
+                      release(w, home, conn);
+                  });
+              },
+              handler_factory ? handler_factory() : connection::data_handler_t{});
+        }
+
+        void release(worker& w, worker& home, connection* conn) noexcept {
+            w.connections.release(conn);
+            w.load.fetch_sub(1, stl::memory_order_relaxed);
+            total_connections.fetch_sub(1, stl::memory_order_relaxed);
+            open_gauge.dec();
+
+            // the last one is done, no need to wait for the deadline
+            if (w.draining && w.connections.size() == 0 && w.drain_timer)
+                w.drain_timer->cancel();
+
+            // the listener that accepted this connection lives on its home
+            if (&w == &home) {
+                resume_accepting(home);
+            } else {
+                boost::asio::post(*home.ctx, [this, &home] {
+                    resume_accepting(home);
+                });
+            }
+        }
+
+        void resume_accepting(worker& home) noexcept {
+            if (!home.paused_listeners.empty() && has_room(home)) {
+                auto l = home.paused_listeners.back();
+                home.paused_listeners.pop_back();
+                if (l->acceptor.is_open())
+                    accept(*l);
+            }
+        }
+
+        void wait_for_hangup() noexcept {
+            hangup->async_wait([this](istl::net_error_code const& ec, int) {
+                if (ec)
+                    return; // cancelled
+                hangup_handler();
+                wait_for_hangup();
+            });
+        }
+
+        void stop_waiting_for_hangup() noexcept {
+            if (hangup) {
+                istl::net_error_code ec;
+                hangup->cancel(ec);
+            }
+        }
+
+        /**
+         * Open, bind, and listen on the endpoint; returns false if we can't.
+         */
+        bool listen(worker& home, endpoint_t const& endpoint) noexcept {
+            istl::net_error_code ec;
+            acceptor_t           acceptor{*home.ctx};
+            acceptor.open(endpoint.protocol(), ec);
+            if (!ec)
+                acceptor.set_option(acceptor_t::reuse_address(true), ec);
+#ifdef SO_REUSEPORT
+            if (!ec && sharded)
+                acceptor.set_option(
+                  boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true), ec);
+#endif
+            if (!ec)
+                acceptor.bind(endpoint, ec);
+            if (!ec)
+                acceptor.listen(acceptor_t::max_listen_connections, ec);
+            if (ec) {
+                // we just don't listen on this endpoint
+                log_error("can't listen on {}:{}: {}",
+                          endpoint.address().to_string(),
+                          endpoint.port(),
+                          ec.message());
+                return false;
+            }
+            [[maybe_unused]] auto& l = listeners.emplace_back(listener{stl::move(acceptor), &home});
+#ifdef WEBPP_USE_IO_URING
+            l.protocol = endpoint.protocol();
+#endif
+            return true;
+        }
+
+        /**
+         * Close the acceptors of a worker; it's called from its own thread
+         */
+        void close_listeners(worker& w) noexcept {
+            istl::net_error_code ec;
+            for (auto& l : listeners) {
+                if (l.home != &w)
+                    continue;
+#ifdef WEBPP_USE_IO_URING
+                // the ring holds its own reference to the listening socket
+                if (l.ring_armed)
+                    w.ring->cancel(l.accept_op);
+#endif
+                l.acceptor.close(ec);
+            }
+            w.paused_listeners.clear();
+        }
+
+        void drain_worker(worker& w, duration_t timeout) noexcept {
+            close_listeners(w);
+            w.draining = true;
+            w.connections.for_each([](connection& conn) noexcept {
+                if (conn.is_open())
+                    conn.drain();
+            });
+            if (w.connections.size() == 0)
+                return;
+            w.drain_timer = stl::make_unique<stl::net::steady_timer>(*w.ctx, timeout);
+            w.drain_timer->async_wait([&w](istl::net_error_code const& ec) {
+                if (ec)
+                    return; // they've finished in time
+                w.connections.for_each([](connection& conn) noexcept {
+                    conn.stop();
+                });
+            });
+        }
+
+        static void pin_to_core([[maybe_unused]] stl::size_t core) noexcept {
+#ifdef __linux__
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(core % CPU_SETSIZE, &cpus);
+            pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#endif
+        }
+
+        /**
+         * Pin the thread of the worker to its core, and make its memory come
+         * from its NUMA node if it's placed on one
+         */
+        void place(worker const& w, stl::size_t core) noexcept {
+            if (!w.cpu || !w.node) {
+                pin_to_core(core);
+                return;
+            }
+            pin_to_core(*w.cpu);
+            prefer_numa_node(topology.nodes()[*w.node].id);
+        }
+
+        static void run_context(io_context_t& ctx) noexcept {
             // Run until the tasks finishes normally.
-            // Don't worry, we'll accept another connection when we finish one
-            // of them
             for (;;) {
                 try {
-                    io.run();
+                    ctx.run();
                     break;
                 } catch (std::exception const& err) {
                     // todo: what should I do here?
@@ -72,11 +584,430 @@ namespace webpp::common {
             }
         }
 
+      public:
+        /**
+         * @param concurrency the number of io_contexts (and threads) to run;
+         *        zero means one per core. With a concurrency of one everything
+         *        runs on "io" and nothing gets pinned.
+         * @param reuse_port give each worker its own acceptor on every endpoint
+         *        and let the kernel balance the connections; the policy is not
+         *        used then. Only works where SO_REUSEPORT is supported; the
+         *        other platforms will only listen on the first worker.
+         */
+        server(std::vector<endpoint_t> const& endpoints,
+               stl::size_t                    _max_connections = default_max_connections,
+               stl::size_t                    concurrency      = 1,
+               balance_policy                 _policy          = balance_policy::least_load,
+               bool                           reuse_port       = false) noexcept
+          : max_connections{_max_connections},
+            policy{_policy},
+            sharded{reuse_port} {
+            if (concurrency == 0)
+                concurrency = stl::max(1u, stl::thread::hardware_concurrency());
+
+            workers.emplace_back(&io);
+            worker_contexts.reserve(concurrency - 1);
+            for (stl::size_t i = 1; i < concurrency; i++) {
+                // each context is only run by one thread
+                auto& ctx = worker_contexts.emplace_back(stl::make_unique<io_context_t>(1));
+                workers.emplace_back(ctx.get());
+            }
+
+            for (auto const& endpoint : endpoints) {
+                if (!listen(workers.front(), endpoint))
+                    continue;
+#ifdef SO_REUSEPORT
+                if (sharded) {
+                    // the rest of them should use the same port that the first
+                    // one got, even if the user asked for port zero
+                    istl::net_error_code ec;
+                    auto const           bound = listeners.back().acceptor.local_endpoint(ec);
+                    if (ec)
+                        continue;
+                    for (auto it = stl::next(workers.begin()); it != workers.end(); ++it)
+                        listen(*it, bound);
+                }
+#endif
+            }
+            for (auto& l : listeners)
+                accept(l);
+        }
+
+        /**
+         * Set the protocol of the connections; this should be done before
+         * running the server.
+         */
+        void on_connection(handler_factory_t factory) noexcept {
+            handler_factory = stl::move(factory);
+        }
+
+        /**
+         * Set the timeouts of the new connections; it can be done while the
+         * server is running (the open connections keep their own timeouts),
+         * each worker picks them up with its next connection.
+         */
+        void timeouts(connection_timeouts const& limits) noexcept {
+            stl::scoped_lock lock{limits_lock};
+            conn_timeouts = limits;
+            timeouts_gen.fetch_add(1, stl::memory_order_release);
+        }
+
+        [[nodiscard]] connection_timeouts timeouts() const noexcept {
+            stl::scoped_lock lock{limits_lock};
+            return conn_timeouts;
+        }
+
+        /**
+         * Change the maximum number of the connections while the server is
+         * running; the open connections are not closed if it's lowered, but
+         * no new one is accepted until there's room. If it's raised, the
+         * paused acceptors start accepting again (in their own threads).
+         */
+        void max_connection_count(stl::size_t count) noexcept {
+            max_connections.store(count, stl::memory_order_relaxed);
+            for (auto& w : workers) {
+                boost::asio::post(*w.ctx, [this, &w] {
+                    // each call resumes one of them
+                    while (!w.paused_listeners.empty() && has_room(w))
+                        resume_accepting(w);
+                });
+            }
+        }
+
+        /**
+         * Apply the limits of the config: "server.max_connections" and the
+         * "server.idle_timeout_ms", "server.read_timeout_ms", and
+         * "server.write_timeout_ms" of the new connections. The missing ones
+         * are left as they are.
+         */
+        void reload(config_snapshot const& cfg) noexcept {
+            using stl::chrono::milliseconds;
+            auto limits = timeouts();
+            auto const as_ms = [&](stl::string_view key, duration_t current) noexcept {
+                auto const ms = cfg.get_as<long long>(key, -1);
+                return ms < 0 ? current : stl::chrono::duration_cast<duration_t>(milliseconds{ms});
+            };
+            limits.idle  = as_ms("server.idle_timeout_ms", limits.idle);
+            limits.read  = as_ms("server.read_timeout_ms", limits.read);
+            limits.write = as_ms("server.write_timeout_ms", limits.write);
+            timeouts(limits);
+            if (auto const count = cfg.get_as<stl::size_t>("server.max_connections", 0); count != 0)
+                max_connection_count(count);
+        }
+
+        /**
+         * Call the handler (on the first io_context) each time the process
+         * gets a SIGHUP, which is how the daemons are usually asked to reload
+         * their config; it stops when the server is stopped or drained. This
+         * should be done before running the server.
+         */
+        void on_hangup(stl::function<void()> handler) noexcept {
+#ifdef SIGHUP
+            hangup_handler = stl::move(handler);
+            istl::net_error_code ec;
+            hangup.emplace(io);
+            hangup->add(SIGHUP, ec);
+            if (ec) {
+                hangup.reset();
+                return;
+            }
+            wait_for_hangup();
+#endif
+        }
+
+        /**
+         * Reject the requests that have waited too long when a worker falls
+         * behind (see load_shedder); each worker decides for its own
+         * connections, and the protocols answer the rejected requests with a
+         * 503. This should be done before running the server.
+         */
+        void shedding(shedding_options const& options) noexcept {
+            for (auto& w : workers)
+                w.shedder = load_shedder{options};
+            shed = true;
+        }
+
+        /**
+         * Place the workers on the NUMA nodes, in blocks of the same size; each
+         * worker's thread is pinned to one of the cores of its node, and the
+         * pages that it touches first (its connections, its read buffers, its
+         * timers, ...) come from the memory of its node. The new connections
+         * go to the least loaded worker of the node whose core got their
+         * packets (SO_INCOMING_CPU; the kernel steers the flows of a NIC
+         * queue to its cores), unless each worker has its own acceptors
+         * (reuse_port), then they already are on the node that accepts them.
+         *
+         * On a machine with one node this is the same as the pinning to the
+         * cores, only in the order of the allowed cores. This should be done
+         * before running the server.
+         */
+        void numa(numa_topology const& _topology = numa_topology::detect()) {
+            topology = _topology;
+            if (topology.node_count() == 0)
+                return;
+            auto const            node_count = topology.node_count();
+            stl::vector<unsigned> placed(node_count, 0); // on each node
+            stl::size_t           index = 0;
+            for (auto& w : workers) {
+                auto const  node = index++ * node_count / workers.size();
+                auto const& cpus = topology.nodes()[node].cpus;
+                w.node           = node;
+                w.cpu            = cpus[placed[node]++ % cpus.size()];
+            }
+        }
+
+        /**
+         * The NUMA node (its id) and the core of the worker, if it's placed
+         */
+        [[nodiscard]] stl::optional<unsigned> worker_node(stl::size_t index) const noexcept {
+            auto const& w = *stl::next(workers.begin(), static_cast<long>(index));
+            if (!w.node)
+                return stl::nullopt;
+            return topology.nodes()[*w.node].id;
+        }
+
+        [[nodiscard]] stl::optional<unsigned> worker_cpu(stl::size_t index) const noexcept {
+            return stl::next(workers.begin(), static_cast<long>(index))->cpu;
+        }
+
+#ifdef WEBPP_USE_TLS
+        /**
+         * Talk TLS with all the clients (see connection::use_tls); the context
+         * should outlive the server. This should be done before running the
+         * server.
+         */
+        void tls(tls_context const& context) noexcept {
+            tls_ctx = &context;
+        }
+#endif
+
+        /**
+         * Count the connections and their bytes into the registry; this
+         * should be done before running the server.
+         */
+        void metrics(metrics_registry& registry) {
+            accepted_counter = registry.counter("webpp_connections_accepted_total",
+                                                "The connections that are accepted");
+            open_gauge       = registry.gauge("webpp_connections_open", "The connections that are open");
+            conn_metrics.received =
+              registry.counter("webpp_received_bytes_total", "The bytes that are read from the connections");
+            conn_metrics.sent =
+              registry.counter("webpp_sent_bytes_total", "The bytes that are written to the connections");
+            conn_metrics.writes =
+              registry.counter("webpp_writes_total", "The writes to the connections; the coalesced ones are one");
+        }
+
+        /**
+         * Run the server; this blocks the calling thread which will run the
+         * first io_context, and one thread is spawned for each of the others.
+         */
+        void run() noexcept {
+            std::vector<work_guard_t> guards;
+            std::vector<std::thread>  threads;
+            guards.reserve(worker_contexts.size());
+            threads.reserve(worker_contexts.size());
+            auto w = stl::next(workers.begin());
+            for (stl::size_t i = 0; i < worker_contexts.size(); i++, ++w) {
+                auto& ctx = *worker_contexts[i];
+                ctx.restart();
+                // the workers should wait for connections even if they have none
+                guards.push_back(boost::asio::make_work_guard(ctx));
+                threads.emplace_back([this, &ctx, &home = *w, core = i + 1] {
+                    place(home, core);
+                    run_context(ctx);
+                });
+            }
+            if (!threads.empty() || workers.front().cpu)
+                place(workers.front(), 0);
+
+            // Don't worry, we'll accept another connection when we finish one
+            // of them
+            run_context(io);
+
+            // the other workers return when they're stopped, or when they're
+            // done with draining their connections
+            for (auto& guard : guards)
+                guard.reset();
+            for (auto& thread : threads)
+                thread.join();
+        }
+
         void stop() noexcept {
+            stop_waiting_for_hangup();
+            for (auto& w : workers) {
+                auto shutdown = [this, &w] {
+                    close_listeners(w);
+                    // the released ones are already stopped
+                    w.connections.for_each([](connection& conn) noexcept {
+                        conn.stop();
+                    });
+                };
+                if (w.ctx == &io) {
+                    shutdown();
+                } else {
+                    // the other workers' acceptors and connections are only
+                    // touched by their own threads
+                    boost::asio::post(*w.ctx, [&w, shutdown] {
+                        shutdown();
+                        w.ctx->stop();
+                    });
+                }
+            }
             io.stop();
         }
+
+        /**
+         * Stop accepting, and close the connections as soon as they're done
+         * with their requests; the ones that are still busy when the timeout
+         * expires are closed anyway. The "run" returns when all of them are
+         * closed. Call it from the thread that runs "io" (post it there).
+         */
+        void drain(duration_t timeout = default_drain_timeout) noexcept {
+#ifdef __unix__
+            close_handoff();
+#endif
+            stop_waiting_for_hangup();
+            for (auto& w : workers) {
+                if (w.ctx == &io) {
+                    drain_worker(w, timeout);
+                } else {
+                    boost::asio::post(*w.ctx, [this, &w, timeout] {
+                        drain_worker(w, timeout);
+                    });
+                }
+            }
+        }
+
+#ifdef __unix__
+        /**
+         * Listen on a socket that we've got from another process (see
+         * serve_handoff); with reuse_port, the other workers open their own
+         * acceptors on the same address. Call it before running the server.
+         */
+        bool adopt(handle_t handle) noexcept {
+            istl::net_error_code ec;
+            sockaddr_storage     addr{};
+            socklen_t            len = sizeof(addr);
+            if (::getsockname(handle, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+                return false;
+            auto const protocol =
+              addr.ss_family == AF_INET6 ? stl::net::ip::tcp::v6() : stl::net::ip::tcp::v4();
+            acceptor_t acceptor{io};
+            acceptor.assign(protocol, handle, ec);
+            if (ec)
+                return false;
+            auto& l = listeners.emplace_back(listener{stl::move(acceptor), &workers.front()});
+#ifdef WEBPP_USE_IO_URING
+            l.protocol = protocol;
+#endif
+            accept(l);
+#ifdef SO_REUSEPORT
+            if (sharded) {
+                auto const bound = l.acceptor.local_endpoint(ec);
+                for (auto it = stl::next(workers.begin()); !ec && it != workers.end(); ++it) {
+                    if (listen(*it, bound))
+                        accept(listeners.back());
+                }
+            }
+#endif
+            return true;
+        }
+
+        /**
+         * Wait for a new process to connect to the Unix domain socket at
+         * "path", give it our listening sockets, and drain. The new process
+         * calls "receive_listeners(path)" and adopts them.
+         *
+         * Only the first worker's sockets are passed; with reuse_port the new
+         * process should open its own siblings (adopt does that), and the
+         * connections waiting on our other siblings' backlog are lost.
+         */
+        bool serve_handoff(stl::string_view path, duration_t drain_timeout = default_drain_timeout) noexcept {
+            using local = boost::asio::local::stream_protocol;
+
+            istl::net_error_code ec;
+            handoff_path.assign(path);
+            ::unlink(handoff_path.c_str());
+            handoff_acceptor.emplace(io);
+            handoff_acceptor->open(local{}, ec);
+            if (!ec)
+                handoff_acceptor->bind(local::endpoint{handoff_path}, ec);
+            if (!ec)
+                handoff_acceptor->listen(1, ec);
+            if (ec) {
+                handoff_acceptor.reset();
+                return false;
+            }
+            handoff_acceptor->async_accept([this, drain_timeout](istl::net_error_code const& err,
+                                                                 local::socket           channel) {
+                if (err)
+                    return; // closed
+                stl::vector<int> handles;
+                for (auto& l : listeners)
+                    if (l.home == &workers.front() && l.acceptor.is_open())
+                        handles.push_back(l.acceptor.native_handle());
+                if (!send_handles(channel.native_handle(), handles)) {
+                    log_warning("the listening sockets couldn't be handed off; we keep serving");
+                    close_handoff();
+                    return;
+                }
+                drain(drain_timeout);
+            });
+            return true;
+        }
+
+        void close_handoff() noexcept {
+            if (!handoff_acceptor)
+                return;
+            istl::net_error_code ec;
+            handoff_acceptor->close(ec);
+            handoff_acceptor.reset();
+            ::unlink(handoff_path.c_str());
+        }
+#endif
+
+        /**
+         * The endpoints that we're actually listening on. The ports are the
+         * real ones even if the user asked for port 0. The sharded acceptors of
+         * the other workers listen on the same endpoints, so they're not
+         * repeated here.
+         */
+        [[nodiscard]] std::vector<endpoint_t> local_endpoints() const noexcept {
+            std::vector<endpoint_t> res;
+            for (auto const& l : listeners) {
+                if (l.home != &workers.front())
+                    continue;
+                istl::net_error_code ec;
+                if (auto ep = l.acceptor.local_endpoint(ec); !ec)
+                    res.push_back(ep);
+            }
+            return res;
+        }
+
+        /**
+         * The number of acceptors; with reuse_port this is the number of
+         * endpoints times the concurrency.
+         */
+        [[nodiscard]] stl::size_t acceptor_count() const noexcept {
+            return listeners.size();
+        }
+
+        [[nodiscard]] stl::size_t connection_count() const noexcept {
+            return total_connections.load(stl::memory_order_relaxed);
+        }
+
+        [[nodiscard]] stl::size_t max_connection_count() const noexcept {
+            return max_connections.load(stl::memory_order_relaxed);
+        }
+
+        /**
+         * The number of io_contexts (threads) that serve the connections
+         */
+        [[nodiscard]] stl::size_t concurrency() const noexcept {
+            return workers.size();
+        }
     };
 
 } // namespace webpp::common
 
-#endif // WEBPP_INTERFACES_COMMON_SERVER_H
\ No newline at end of file
+#endif // WEBPP_INTERFACES_COMMON_SERVER_H
@@ -0,0 +1,111 @@
+#ifndef WEBPP_INTERFACES_COMMON_SOCKET_HANDOFF_H
+#define WEBPP_INTERFACES_COMMON_SOCKET_HANDOFF_H
+
+#include "../../../std/std.hpp"
+#include "../../../std/string_view.hpp"
+
+#include <vector>
+
+#ifdef __unix__
+#    include <cstring>
+#    include <sys/socket.h>
+#    include <sys/un.h>
+#    include <unistd.h>
+#endif
+
+/**
+ * Passing the listening sockets to another process (hot restart).
+ *
+ * The old process listens on a Unix domain socket; the new one connects to
+ * it and receives duplicates of the listening sockets (SCM_RIGHTS), so the
+ * port is never closed and the connections that are waiting in the kernel's
+ * backlog are accepted by the new process. The old one then drains its own
+ * connections and exits.
+ */
+namespace webpp::common {
+
+    // more than enough for the number of endpoints that anybody listens on
+    constexpr stl::size_t max_handoff_sockets = 64;
+
+#ifdef __unix__
+
+    /**
+     * Send the file descriptors through a connected Unix domain socket
+     */
+    inline bool send_handles(int channel, stl::vector<int> const& handles) noexcept {
+        if (handles.empty() || handles.size() > max_handoff_sockets)
+            return false;
+
+        // at least one byte of real data should go with the ancillary data
+        char  byte = 'L';
+        iovec iov{&byte, 1};
+
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * max_handoff_sockets)]{};
+        msghdr                msg{};
+        msg.msg_iov        = &iov;
+        msg.msg_iovlen     = 1;
+        msg.msg_control    = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * handles.size());
+
+        auto cmsg        = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type  = SCM_RIGHTS;
+        cmsg->cmsg_len   = CMSG_LEN(sizeof(int) * handles.size());
+        stl::memcpy(CMSG_DATA(cmsg), handles.data(), sizeof(int) * handles.size());
+        return ::sendmsg(channel, &msg, MSG_NOSIGNAL) == 1;
+    }
+
+    /**
+     * Receive the file descriptors that the other side sends with send_handles
+     */
+    inline stl::vector<int> receive_handles(int channel) noexcept {
+        stl::vector<int> handles;
+        char             byte;
+        iovec            iov{&byte, 1};
+
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * max_handoff_sockets)]{};
+        msghdr                msg{};
+        msg.msg_iov        = &iov;
+        msg.msg_iovlen     = 1;
+        msg.msg_control    = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (::recvmsg(channel, &msg, MSG_CMSG_CLOEXEC) != 1)
+            return handles;
+        for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+                continue;
+            auto const count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            auto const first = handles.size();
+            handles.resize(first + count);
+            stl::memcpy(handles.data() + first, CMSG_DATA(cmsg), count * sizeof(int));
+        }
+        return handles;
+    }
+
+    /**
+     * Connect to the old process' handoff socket and take its listening
+     * sockets; pass them to server::adopt.
+     */
+    inline stl::vector<int> receive_listeners(stl::string_view path) noexcept {
+        sockaddr_un addr{};
+        if (path.size() >= sizeof(addr.sun_path))
+            return {};
+        addr.sun_family = AF_UNIX;
+        stl::memcpy(addr.sun_path, path.data(), path.size());
+
+        auto const channel = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (channel < 0)
+            return {};
+        stl::vector<int> handles;
+        if (::connect(channel, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) == 0)
+            handles = receive_handles(channel);
+        ::close(channel);
+        return handles;
+    }
+
+#endif
+
+} // namespace webpp::common
+
+#endif // WEBPP_INTERFACES_COMMON_SOCKET_HANDOFF_H
@@ -0,0 +1,83 @@
+#ifndef WEBPP_INTERFACES_COMMON_TASK_LINK_H
+#define WEBPP_INTERFACES_COMMON_TASK_LINK_H
+
+#include "../../../std/std.hpp"
+#include "../../../utils/deadline.hpp"
+#include "connection.hpp"
+
+#include <boost/asio/post.hpp>
+#include <memory>
+#include <utility>
+
+namespace webpp::common {
+
+    /**
+     * What the tasks of a connection's requests (the coroutine applications,
+     * see task) hold on to: they finish on the connection's thread, and only
+     * if it's still open by then, since the connection may be closed (and
+     * reused) while they're waiting. The token is cancelled when the
+     * connection is closed, so the tasks can give up on the clients that
+     * have gone away.
+     *
+     * It's shared between the copies; the first one that is attached to a
+     * connection attaches all of them.
+     */
+    class task_link {
+        struct state_type {
+            connection*               conn = nullptr; // nullptr once it's closed; only touched on its thread
+            connection::executor_type executor{};
+            cancellation_source       cancellation{};
+            bool                      attached = false;
+        };
+
+        stl::shared_ptr<state_type> state = stl::make_shared<state_type>();
+
+      public:
+        /**
+         * Watch the connection; the handler is called too when it's closed.
+         * It takes the connection's close hook (see connection::on_closed), so
+         * the protocols that set their own don't start any tasks after it.
+         */
+        void attach(connection& conn, connection::close_handler_t on_close = {}) noexcept {
+            if (state->attached)
+                return;
+            state->attached = true;
+            state->conn     = &conn;
+            state->executor = conn.get_executor();
+            conn.on_closed([st = state, handler = stl::move(on_close)] {
+                st->conn = nullptr;
+                st->cancellation.cancel();
+                if (handler)
+                    handler();
+            });
+        }
+
+        [[nodiscard]] bool is_attached() const noexcept {
+            return state->attached;
+        }
+
+        /**
+         * The token of the requests of this connection; it's cancelled when
+         * the client goes away.
+         */
+        [[nodiscard]] cancellation_token token() const {
+            return state->cancellation.token();
+        }
+
+        /**
+         * Call the callback with the connection on its thread; it can be
+         * called from any thread, and the callback is dropped if the
+         * connection is closed by the time it gets there.
+         */
+        template <typename Callback>
+        void post(Callback&& callback) const noexcept {
+            stl::net::post(state->executor, [st = state, cb = stl::forward<Callback>(callback)]() mutable noexcept {
+                if (st->conn != nullptr)
+                    cb(*st->conn);
+            });
+        }
+    };
+
+} // namespace webpp::common
+
+#endif // WEBPP_INTERFACES_COMMON_TASK_LINK_H
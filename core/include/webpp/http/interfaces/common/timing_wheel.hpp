@@ -0,0 +1,110 @@
+#ifndef WEBPP_INTERFACES_COMMON_TIMING_WHEEL_H
+#define WEBPP_INTERFACES_COMMON_TIMING_WHEEL_H
+
+#include "../../../std/io_context.hpp"
+#include "../../../std/socket.hpp"
+#include "../../../std/std.hpp"
+#include "../../../std/timer.hpp"
+#include "../../../utils/timing_wheel.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace webpp::common {
+
+    // the wheel itself doesn't need asio, so it's in the utils
+    using webpp::timer_node;
+    using webpp::timing_wheel;
+
+    /**
+     * A timing wheel that is driven by one asio timer on an io_context; the
+     * asio timer only runs while there's something in the wheel, so an idle
+     * io_context is still allowed to run out of work.
+     */
+    class timer_service {
+      public:
+        using clock_t    = stl::chrono::steady_clock;
+        using duration_t = clock_t::duration;
+
+      private:
+        stl::net::steady_timer timer;
+        timing_wheel           wheel;
+        duration_t             resolution;
+        clock_t::time_point    epoch;           // the time of the tick zero
+        duration_t             last_lag{};      // how late the last tick was
+        bool                   running = false; // the asio timer is waiting
+
+        [[nodiscard]] uint64_t ticks_since_epoch() const noexcept {
+            return static_cast<uint64_t>((clock_t::now() - epoch) / resolution);
+        }
+
+        void arm() noexcept {
+            running = true;
+            timer.expires_at(epoch + resolution * static_cast<long>(wheel.now() + 1));
+            timer.async_wait([this](istl::net_error_code const& ec) {
+                running = false;
+                if (ec) {
+                    // cancelled; but something may have been scheduled since
+                    last_lag = {};
+                    if (!wheel.empty())
+                        arm();
+                    return;
+                }
+                last_lag = clock_t::now() - timer.expiry();
+                // catch up if we've been late
+                for (auto const target = ticks_since_epoch(); wheel.now() < target && !wheel.empty();)
+                    wheel.tick();
+                if (!wheel.empty())
+                    arm();
+            });
+        }
+
+      public:
+        timer_service(stl::net::io_context& ctx, duration_t _resolution) noexcept
+          : timer{ctx},
+            resolution{_resolution},
+            epoch{clock_t::now()} {
+        }
+
+        /**
+         * Call the timer's callback after the timeout passes; it's rounded up
+         * to the resolution of the wheel.
+         */
+        void schedule(timer_node& node, duration_t timeout) noexcept {
+            if (wheel.empty()) {
+                // nothing has been ticking; bring the wheel up to date
+                auto const target = ticks_since_epoch();
+                if (target > wheel.now())
+                    wheel.skip(target - wheel.now());
+            }
+            auto const ticks = static_cast<uint64_t>((timeout + resolution - duration_t{1}) / resolution);
+            wheel.schedule(node, ticks);
+            if (!running)
+                arm();
+        }
+
+        void cancel(timer_node& node) noexcept {
+            wheel.cancel(node);
+            if (wheel.empty() && running)
+                timer.cancel();
+        }
+
+        [[nodiscard]] stl::size_t size() const noexcept {
+            return wheel.size();
+        }
+
+        /**
+         * How late the last tick was; it's the time that the handlers wait in
+         * the io_context's queue behind the others (the loop's lag), sampled
+         * once per tick while there are timers.
+         */
+        [[nodiscard]] duration_t lag() const noexcept {
+            return last_lag;
+        }
+    };
+
+} // namespace webpp::common
+
+#endif // WEBPP_INTERFACES_COMMON_TIMING_WHEEL_H
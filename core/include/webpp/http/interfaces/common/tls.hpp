@@ -0,0 +1,162 @@
+#ifndef WEBPP_INTERFACES_COMMON_TLS_H
+#define WEBPP_INTERFACES_COMMON_TLS_H
+
+#include "../../../std/std.hpp"
+
+#include <array>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// the connections only do TLS if it's asked for at build time (the WEBPP_TLS
+// option of cmake finds OpenSSL's libssl)
+#if defined(WEBPP_TLS) && __has_include(<openssl/ssl.h>)
+#    define WEBPP_USE_TLS
+#    include <openssl/bio.h>
+#    include <openssl/err.h>
+#    include <openssl/ssl.h>
+#endif
+
+/**
+ * TLS for the self-hosted servers. OpenSSL does the handshake, and then, if
+ * the kernel can (the "tls" module of Linux, and an OpenSSL that's built
+ * with kTLS), the records are encrypted and decrypted by the kernel: the
+ * connection reads and writes the socket as if it was plain, so the gather
+ * writes and the sendfile of the files keep working, with no copies in the
+ * user space.
+ *
+ * If the kernel can't (or kernel_offload is off), OpenSSL encrypts what's
+ * written and decrypts what's read; the files are read a part at a time to be
+ * encrypted then.
+ */
+namespace webpp::common {
+
+    struct tls_options {
+        stl::string certificate_chain_file{}; // PEM, the certificate first
+        stl::string private_key_file{};       // PEM
+        bool        kernel_offload = true;    // use kTLS when it's available
+    };
+
+#ifdef WEBPP_USE_TLS
+
+    namespace details {
+        struct ssl_ctx_free {
+            void operator()(SSL_CTX* ctx) const noexcept {
+                SSL_CTX_free(ctx);
+            }
+        };
+
+        struct ssl_free {
+            void operator()(SSL* ssl) const noexcept {
+                SSL_free(ssl);
+            }
+        };
+    } // namespace details
+
+    // the TLS of one connection
+    using tls_session = stl::unique_ptr<SSL, details::ssl_free>;
+
+    /**
+     * Whether the kernel encrypts what's written to the connection (kTLS)
+     */
+    [[nodiscard]] inline bool tls_kernel_send(SSL* ssl) noexcept {
+#    if !defined(OPENSSL_NO_KTLS) && defined(BIO_get_ktls_send)
+        return BIO_get_ktls_send(SSL_get_wbio(ssl)) != 0;
+#    else
+        static_cast<void>(ssl);
+        return false;
+#    endif
+    }
+
+    /**
+     * Whether the kernel decrypts what's read from the connection (kTLS)
+     */
+    [[nodiscard]] inline bool tls_kernel_receive(SSL* ssl) noexcept {
+#    if !defined(OPENSSL_NO_KTLS) && defined(BIO_get_ktls_recv)
+        return BIO_get_ktls_recv(SSL_get_rbio(ssl)) != 0;
+#    else
+        static_cast<void>(ssl);
+        return false;
+#    endif
+    }
+
+    /**
+     * The certificate and the settings of the TLS connections of a server;
+     * it's shared by all the connections (of all the threads).
+     */
+    class tls_context {
+        stl::unique_ptr<SSL_CTX, details::ssl_ctx_free> ctx;
+        stl::string                                     last_error{};
+
+        void fail(stl::string_view what) {
+            last_error.assign(what);
+            stl::array<char, 256> reason{};
+            if (auto const code = ERR_get_error(); code != 0) {
+                ERR_error_string_n(code, reason.data(), reason.size());
+                last_error.append(": ").append(reason.data());
+            }
+            ERR_clear_error();
+            ctx.reset();
+        }
+
+      public:
+        explicit tls_context(tls_options const& options) noexcept : ctx{SSL_CTX_new(TLS_server_method())} {
+            if (!ctx) {
+                fail("can't create the TLS context");
+                return;
+            }
+            SSL_CTX_set_min_proto_version(ctx.get(), TLS1_2_VERSION);
+            auto flags = SSL_OP_NO_RENEGOTIATION | SSL_OP_CIPHER_SERVER_PREFERENCE;
+#    ifdef SSL_OP_ENABLE_KTLS
+            if (options.kernel_offload)
+                flags |= SSL_OP_ENABLE_KTLS;
+#    endif
+            SSL_CTX_set_options(ctx.get(), flags);
+            // the writes are retried from where they were left, and the buffers are given back when idle
+            SSL_CTX_set_mode(ctx.get(),
+                             SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER |
+                               SSL_MODE_RELEASE_BUFFERS);
+            if (SSL_CTX_use_certificate_chain_file(ctx.get(), options.certificate_chain_file.c_str()) != 1) {
+                fail("can't load the certificate " + options.certificate_chain_file);
+                return;
+            }
+            if (SSL_CTX_use_PrivateKey_file(ctx.get(), options.private_key_file.c_str(), SSL_FILETYPE_PEM) != 1 ||
+                SSL_CTX_check_private_key(ctx.get()) != 1) {
+                fail("can't load the private key " + options.private_key_file);
+                return;
+            }
+        }
+
+        [[nodiscard]] bool is_valid() const noexcept {
+            return ctx != nullptr;
+        }
+
+        /**
+         * Why it's not valid
+         */
+        [[nodiscard]] stl::string_view error() const noexcept {
+            return last_error;
+        }
+
+        /**
+         * The TLS of a connection whose socket is the descriptor; the server's
+         * side of the handshake. Null if it can't be made.
+         */
+        [[nodiscard]] tls_session new_session(int fd) const noexcept {
+            if (!ctx)
+                return nullptr;
+            tls_session session{SSL_new(ctx.get())};
+            if (!session || SSL_set_fd(session.get(), fd) != 1) {
+                ERR_clear_error();
+                return nullptr;
+            }
+            SSL_set_accept_state(session.get());
+            return session;
+        }
+    };
+
+#endif
+
+} // namespace webpp::common
+
+#endif // WEBPP_INTERFACES_COMMON_TLS_H
@@ -0,0 +1,437 @@
+#ifndef WEBPP_INTERFACES_COMMON_URING_H
+#define WEBPP_INTERFACES_COMMON_URING_H
+
+#include "../../../std/io_context.hpp"
+#include "../../../std/socket.hpp"
+#include "../../../std/std.hpp"
+#include "constants.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#    define WEBPP_HAS_IO_URING
+#    include <boost/asio/post.hpp>
+#    include <boost/asio/posix/stream_descriptor.hpp>
+#    include <cerrno>
+#    include <cstring>
+#    include <linux/io_uring.h>
+#    include <poll.h>
+#    include <sys/eventfd.h>
+#    include <sys/mman.h>
+#    include <sys/socket.h>
+#    include <sys/syscall.h>
+#    include <sys/uio.h>
+#    include <unistd.h>
+#endif
+
+// the connections and the server only use it if it's asked for at build time
+// (the WEBPP_IO_URING option of cmake)
+#if defined(WEBPP_IO_URING) && defined(WEBPP_HAS_IO_URING)
+#    define WEBPP_USE_IO_URING
+#endif
+
+/**
+ * A minimal io_uring backend for the connections (Linux 5.x+).
+ *
+ * We talk to the kernel directly (no liburing). The ring's completions are
+ * signalled through an eventfd that asio watches, so the ring lives inside
+ * the worker's io_context next to everything else (timers, posts, ...), and
+ * the submissions are batched: everything that is queued while handling one
+ * batch of completions goes to the kernel with one syscall.
+ */
+namespace webpp::common {
+
+#ifdef WEBPP_HAS_IO_URING
+
+    /**
+     * One pending operation; it should not move while it's pending. The
+     * callback gets the result of the operation (a negative errno on error)
+     * and the flags of the completion.
+     */
+    struct uring_operation {
+        stl::function<void(int, unsigned)> on_complete;
+    };
+
+    class uring_service {
+        using descriptor_t = boost::asio::posix::stream_descriptor;
+
+        int ring_fd = -1;
+
+        // the rings that are shared with the kernel
+        void*         sq_ptr   = nullptr;
+        void*         cq_ptr   = nullptr;
+        io_uring_sqe* sqes     = nullptr;
+        stl::size_t   sq_size  = 0;
+        stl::size_t   cq_size  = 0;
+        stl::size_t   sqe_size = 0;
+
+        unsigned*     sq_head    = nullptr;
+        unsigned*     sq_tail    = nullptr;
+        unsigned*     sq_array   = nullptr;
+        unsigned      sq_mask    = 0;
+        unsigned      sq_count   = 0;
+        unsigned*     cq_head    = nullptr;
+        unsigned*     cq_tail    = nullptr;
+        unsigned      cq_mask    = 0;
+        io_uring_cqe* cqes       = nullptr;
+        unsigned      local_tail = 0; // the entries up to here are prepared
+        unsigned      submitted  = 0; // the entries up to here are given to the kernel
+
+        stl::net::io_context& ctx;
+        descriptor_t          event;
+        uint64_t              event_count      = 0;
+        stl::size_t           inflight         = 0; // the operations that are not done yet
+        bool                  waiting          = false;
+        bool                  submit_scheduled = false;
+        bool                  reaping          = false;
+        bool                  multishot        = true; // until the kernel says no
+
+        // the registered (fixed) buffers; the table is sparse and the slots
+        // are given to the connections as they come
+        stl::vector<unsigned> free_buffer_slots;
+
+        static int enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) noexcept {
+            return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+        }
+
+        static int register_ring(int fd, unsigned opcode, void const* arg, unsigned nr) noexcept {
+            return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr));
+        }
+
+        template <typename T>
+        static T* at(void* base, unsigned offset) noexcept {
+            return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+        }
+
+        bool setup(unsigned entries, unsigned buffer_slots) noexcept {
+            io_uring_params params{};
+            params.flags = IORING_SETUP_CLAMP;
+            ring_fd      = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+            if (ring_fd < 0)
+                return false;
+
+            sq_size  = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cq_size  = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            sqe_size = params.sq_entries * sizeof(io_uring_sqe);
+            auto const single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (single)
+                sq_size = cq_size = stl::max(sq_size, cq_size);
+
+            auto const map = [this](stl::size_t size, auto offset) noexcept -> void* {
+                auto const ptr =
+                  ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+                return ptr == MAP_FAILED ? nullptr : ptr;
+            };
+            sq_ptr = map(sq_size, IORING_OFF_SQ_RING);
+            cq_ptr = single ? sq_ptr : map(cq_size, IORING_OFF_CQ_RING);
+            sqes   = static_cast<io_uring_sqe*>(map(sqe_size, IORING_OFF_SQES));
+            if (sq_ptr == nullptr || cq_ptr == nullptr || sqes == nullptr)
+                return false;
+
+            sq_head  = at<unsigned>(sq_ptr, params.sq_off.head);
+            sq_tail  = at<unsigned>(sq_ptr, params.sq_off.tail);
+            sq_array = at<unsigned>(sq_ptr, params.sq_off.array);
+            sq_mask  = *at<unsigned>(sq_ptr, params.sq_off.ring_mask);
+            sq_count = params.sq_entries;
+            cq_head  = at<unsigned>(cq_ptr, params.cq_off.head);
+            cq_tail  = at<unsigned>(cq_ptr, params.cq_off.tail);
+            cq_mask  = *at<unsigned>(cq_ptr, params.cq_off.ring_mask);
+            cqes     = at<io_uring_cqe>(cq_ptr, params.cq_off.cqes);
+
+            local_tail = submitted = *sq_tail;
+
+            // the completions wake asio up through this eventfd
+            auto const efd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            if (efd < 0)
+                return false;
+            if (register_ring(ring_fd, IORING_REGISTER_EVENTFD, &efd, 1) < 0) {
+                ::close(efd);
+                return false;
+            }
+            istl::net_error_code ec;
+            event.assign(efd, ec);
+            if (ec) {
+                ::close(efd);
+                return false;
+            }
+
+            // the fixed buffers are optional (they need 5.13+ and enough
+            // locked memory); we just use the plain recv without them
+            if (buffer_slots != 0) {
+                io_uring_rsrc_register reg{};
+                reg.nr    = buffer_slots;
+                reg.flags = IORING_RSRC_REGISTER_SPARSE;
+                if (register_ring(ring_fd, IORING_REGISTER_BUFFERS2, &reg, sizeof(reg)) == 0) {
+                    free_buffer_slots.reserve(buffer_slots);
+                    for (unsigned i = buffer_slots; i != 0; i--)
+                        free_buffer_slots.push_back(i - 1);
+                }
+            }
+            return true;
+        }
+
+        void close() noexcept {
+            if (event.is_open()) {
+                istl::net_error_code ec;
+                event.close(ec);
+            }
+            if (sqes != nullptr)
+                ::munmap(sqes, sqe_size);
+            if (cq_ptr != nullptr && cq_ptr != sq_ptr)
+                ::munmap(cq_ptr, cq_size);
+            if (sq_ptr != nullptr)
+                ::munmap(sq_ptr, sq_size);
+            if (ring_fd >= 0)
+                ::close(ring_fd); // the kernel cancels whatever is pending
+            ring_fd = -1;
+            sqes    = nullptr;
+            sq_ptr = cq_ptr = nullptr;
+        }
+
+        /**
+         * Get an entry to fill; it's given to the kernel on the next submit
+         */
+        io_uring_sqe* next_sqe() noexcept {
+            auto const head = stl::atomic_ref<unsigned>{*sq_head}.load(stl::memory_order_acquire);
+            if (local_tail - head >= sq_count) {
+                submit(); // it's full, make room
+                if (local_tail - stl::atomic_ref<unsigned>{*sq_head}.load(stl::memory_order_acquire) >=
+                    sq_count)
+                    return nullptr;
+            }
+            auto const index = local_tail & sq_mask;
+            auto       sqe   = &sqes[index];
+            stl::memset(sqe, 0, sizeof(io_uring_sqe));
+            sq_array[index] = index;
+            local_tail++;
+            schedule_submit();
+            return sqe;
+        }
+
+        void schedule_submit() noexcept {
+            if (submit_scheduled || reaping)
+                return; // the reaper submits when it's done
+            submit_scheduled = true;
+            boost::asio::post(ctx, [this] {
+                submit_scheduled = false;
+                submit();
+            });
+        }
+
+        /**
+         * We only wait on the eventfd while there's something pending, so the
+         * ring doesn't keep the io_context running when there's nothing to do
+         */
+        void wait_for_completions() noexcept {
+            waiting = true;
+            event.async_read_some(boost::asio::buffer(&event_count, sizeof(event_count)),
+                                  [this](istl::net_error_code const& ec, stl::size_t) noexcept {
+                                      waiting = false;
+                                      if (ec)
+                                          return; // closed
+                                      reap();
+                                      if (inflight != 0 && !waiting)
+                                          wait_for_completions();
+                                  });
+        }
+
+        void reap() noexcept {
+            reaping = true;
+            auto head = *cq_head;
+            for (;;) {
+                auto const tail = stl::atomic_ref<unsigned>{*cq_tail}.load(stl::memory_order_acquire);
+                if (head == tail)
+                    break;
+                auto const& cqe       = cqes[head & cq_mask];
+                auto const  user_data = cqe.user_data;
+                auto const  res       = cqe.res;
+                auto const  flags     = cqe.flags;
+                head++;
+                stl::atomic_ref<unsigned>{*cq_head}.store(head, stl::memory_order_release);
+                if (user_data == 0)
+                    continue; // a cancellation request
+                if ((flags & IORING_CQE_F_MORE) == 0)
+                    inflight--;
+                auto& op = *reinterpret_cast<uring_operation*>(user_data);
+                if (op.on_complete)
+                    op.on_complete(res, flags);
+            }
+            reaping = false;
+            submit();
+        }
+
+        void prepare(io_uring_sqe* sqe, uint8_t opcode, int fd, void const* addr, unsigned len,
+                     uring_operation& op) noexcept {
+            if (inflight++ == 0 && !waiting)
+                wait_for_completions();
+            sqe->opcode    = opcode;
+            sqe->fd        = fd;
+            sqe->addr      = reinterpret_cast<uint64_t>(addr);
+            sqe->len       = len;
+            sqe->user_data = reinterpret_cast<uint64_t>(&op);
+        }
+
+        /**
+         * Tell the operation that it failed because we couldn't get an entry;
+         * it's posted so the callback doesn't run inside the call.
+         */
+        void fail(uring_operation& op, int error) noexcept {
+            boost::asio::post(ctx, [&op, error] {
+                if (op.on_complete)
+                    op.on_complete(-error, 0);
+            });
+        }
+
+      public:
+        explicit uring_service(stl::net::io_context& _ctx,
+                               unsigned              entries      = default_uring_entries,
+                               unsigned              buffer_slots = default_uring_buffer_slots) noexcept
+          : ctx{_ctx},
+            event{_ctx} {
+            if (!setup(entries, buffer_slots))
+                close();
+        }
+
+        uring_service(uring_service const&) = delete;
+        uring_service& operator=(uring_service const&) = delete;
+
+        ~uring_service() noexcept {
+            close();
+        }
+
+        /**
+         * The ring could be set up; the kernel may be too old, or io_uring
+         * may be disabled (containers usually block it), then we fall back
+         * on asio.
+         */
+        [[nodiscard]] bool is_open() const noexcept {
+            return ring_fd >= 0;
+        }
+
+        /**
+         * Give the prepared entries to the kernel
+         */
+        void submit() noexcept {
+            auto const count = local_tail - submitted;
+            if (count == 0)
+                return;
+            stl::atomic_ref<unsigned>{*sq_tail}.store(local_tail, stl::memory_order_release);
+            auto const res = enter(ring_fd, count, 0, 0);
+            if (res > 0)
+                submitted += static_cast<unsigned>(res);
+        }
+
+        /**
+         * Register a buffer that doesn't move for as long as the ring lives;
+         * returns its index, or -1 if there's no room (or no support) for it.
+         */
+        [[nodiscard]] int register_buffer(void* data, stl::size_t size) noexcept {
+            if (free_buffer_slots.empty())
+                return -1;
+            auto const            slot = free_buffer_slots.back();
+            iovec                 iov{data, size};
+            io_uring_rsrc_update2 update{};
+            update.offset = slot;
+            update.data   = reinterpret_cast<uint64_t>(&iov);
+            update.nr     = 1;
+            if (register_ring(ring_fd, IORING_REGISTER_BUFFERS_UPDATE, &update, sizeof(update)) != 1) {
+                free_buffer_slots.clear(); // probably out of locked memory; don't try again
+                return -1;
+            }
+            free_buffer_slots.pop_back();
+            return static_cast<int>(slot);
+        }
+
+        /**
+         * Read from a socket, into a registered buffer if there's an index
+         */
+        void recv(uring_operation& op, int fd, void* data, stl::size_t size, int buffer_index = -1) noexcept {
+            auto sqe = next_sqe();
+            if (sqe == nullptr)
+                return fail(op, EBUSY);
+            auto const len = static_cast<unsigned>(size);
+            if (buffer_index >= 0) {
+                prepare(sqe, IORING_OP_READ_FIXED, fd, data, len, op);
+                sqe->off       = static_cast<uint64_t>(-1); // no offset for the sockets
+                sqe->buf_index = static_cast<uint16_t>(buffer_index);
+            } else {
+                prepare(sqe, IORING_OP_RECV, fd, data, len, op);
+            }
+        }
+
+        /**
+         * Wait for the socket to be readable; the result is its events (POLLIN,
+         * POLLHUP, ...). The connections that borrow their read buffers wait
+         * with it, and take a buffer only when there's something to read.
+         */
+        void poll_readable(uring_operation& op, int fd) noexcept {
+            auto sqe = next_sqe();
+            if (sqe == nullptr)
+                return fail(op, EBUSY);
+            prepare(sqe, IORING_OP_POLL_ADD, fd, nullptr, 0, op);
+            sqe->poll32_events = POLLIN | POLLRDHUP;
+        }
+
+        /**
+         * A gather write; the message and its buffers should be kept alive
+         * until the operation completes. It may write only part of them.
+         */
+        void sendmsg(uring_operation& op, int fd, msghdr const& msg) noexcept {
+            auto sqe = next_sqe();
+            if (sqe == nullptr)
+                return fail(op, EBUSY);
+            prepare(sqe, IORING_OP_SENDMSG, fd, &msg, 1, op);
+            sqe->msg_flags = MSG_NOSIGNAL;
+        }
+
+        /**
+         * Accept on a listening socket; the result is the new socket. With a
+         * multishot accept (5.19+), one operation keeps accepting and its
+         * completions have IORING_CQE_F_MORE; when that flag is missing, the
+         * operation is done and should be started again.
+         */
+        void accept(uring_operation& op, int fd) noexcept {
+            auto sqe = next_sqe();
+            if (sqe == nullptr)
+                return fail(op, EBUSY);
+            prepare(sqe, IORING_OP_ACCEPT, fd, nullptr, 0, op);
+            sqe->accept_flags = SOCK_CLOEXEC;
+            if (multishot)
+                sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        }
+
+        /**
+         * The kernel doesn't know about IORING_ACCEPT_MULTISHOT (EINVAL); the
+         * next accepts are one shot.
+         */
+        void disable_multishot() noexcept {
+            multishot = false;
+        }
+
+        [[nodiscard]] bool is_multishot() const noexcept {
+            return multishot;
+        }
+
+        /**
+         * Ask the kernel to cancel a pending operation; it completes with
+         * -ECANCELED (or with its own result if it finishes first).
+         */
+        void cancel(uring_operation& op) noexcept {
+            auto sqe = next_sqe();
+            if (sqe == nullptr)
+                return;
+            sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+            sqe->fd        = -1;
+            sqe->addr      = reinterpret_cast<uint64_t>(&op);
+            sqe->user_data = 0;
+        }
+    };
+
+#endif
+
+} // namespace webpp::common
+
+#endif // WEBPP_INTERFACES_COMMON_URING_H
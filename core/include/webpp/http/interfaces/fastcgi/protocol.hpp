@@ -1,6 +1,10 @@
 #ifndef WEBPP_INTERFACE_FCGI_PROTOCOL
 #define WEBPP_INTERFACE_FCGI_PROTOCOL
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
 #include <string_view>
 
 namespace webpp::protocol {
@@ -86,6 +90,26 @@ namespace webpp::protocol {
         }
     };
 
+    /**
+     * The role that the web server expects the application to play
+     */
+    enum class role_type : uint16_t { responder = 1, authorizer = 2, filter = 3 };
+
+    /**
+     * The protocol level status of an end request record
+     */
+    enum class protocol_status_type : uint8_t {
+        request_complete = 0, // normal end of the request
+        cant_mpx_conn    = 1, // we don't do multiplexing
+        overloaded       = 2, // we've run out of some resources
+        unknown_role     = 3  // we don't know how to play the role
+    };
+
+    /**
+     * The web server asks us to keep the connection open after the request
+     */
+    constexpr uint8_t keep_conn_flag = 1;
+
     class begin_request {
       private:
         uint8_t role_b1;
@@ -94,6 +118,13 @@ namespace webpp::protocol {
         uint8_t reserved[5] = {};
 
       public:
+        inline role_type role() const noexcept {
+            return static_cast<role_type>((static_cast<uint16_t>(role_b1) << 8u) | role_b0);
+        }
+
+        inline bool keep_connection() const noexcept {
+            return flags & keep_conn_flag;
+        }
     };
 
     class end_request {
@@ -102,10 +133,20 @@ namespace webpp::protocol {
         uint8_t app_status_b2;
         uint8_t app_status_b1;
         uint8_t app_status_b0;
-        uint8_t protocol_status;
+        uint8_t _protocol_status;
         uint8_t reserved[3] = {};
 
       public:
+        end_request(uint32_t status_code = 0,
+                    protocol_status_type status = protocol_status_type::request_complete) noexcept
+          : _protocol_status{static_cast<uint8_t>(status)} {
+            app_status(status_code);
+        }
+
+        inline void protocol_status(protocol_status_type status) noexcept {
+            _protocol_status = static_cast<uint8_t>(status);
+        }
+
         inline void app_status(uint32_t status_code) noexcept {
             app_status_b3 = static_cast<uint8_t>(status_code >> 24u);
             app_status_b2 = static_cast<uint8_t>(status_code >> 16u & 0xFFu);
@@ -119,47 +160,72 @@ namespace webpp::protocol {
         uint8_t     reserved[7];
     };
 
-    template <std::size_t NAMELENGTH, std::size_t VALUELENGTH,
-              std::size_t PADDINGLENGTH>
-    struct management_reply {
-      private:
-        header  _header;
-        uint8_t name_length  = NAMELENGTH;
-        uint8_t value_length = VALUELENGTH;
-        uint8_t name[NAMELENGTH];
-        uint8_t value[VALUELENGTH];
-        uint8_t padding[PADDINGLENGTH] = {};
+    /**
+     * A name-value pair of a GET_VALUES_RESULT record, serialized at
+     * compile time (or once, when the server is configured) so answering a
+     * GET_VALUES record is only a matter of pointing to these bytes.
+     * The names and the values are short, so the lengths are one byte each.
+     */
+    struct management_value {
+        static constexpr std::size_t max_size = 2 + 15 + 20; // lengths + the longest name + the biggest number
+
+        std::array<char, max_size> bytes{};
+        std::size_t                size = 0;
+
+        constexpr management_value() noexcept = default;
+
+        constexpr management_value(std::string_view name, std::size_t value) noexcept {
+            char        digits[20]{};
+            std::size_t digit_count = 0;
+            do {
+                digits[digit_count++] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            } while (value != 0);
+
+            bytes[size++] = static_cast<char>(name.size());
+            bytes[size++] = static_cast<char>(digit_count);
+            for (auto c : name)
+                bytes[size++] = c;
+            while (digit_count != 0)
+                bytes[size++] = digits[--digit_count];
+        }
 
-      public:
-        constexpr management_reply(char const* _name,
-                                   char const* _value) noexcept
-          : _header{record_type::get_values_result, 0u,
-                    NAMELENGTH + VALUELENGTH, PADDINGLENGTH} {
-            auto _name_end  = _name + NAMELENGTH;
-            auto _value_end = _value + VALUELENGTH;
-            auto name_ptr   = name;
-            auto value_ptr  = value;
-            while (_name != _name_end)
-                *name_ptr = *_name++;
-            while (_value != _value_end)
-                *value_ptr = *_value++;
+        [[nodiscard]] constexpr std::string_view name() const noexcept {
+            return {bytes.data() + 2, static_cast<std::size_t>(bytes[0])};
+        }
+
+        [[nodiscard]] constexpr std::string_view serialized() const noexcept {
+            return {bytes.data(), size};
         }
     };
 
     /**
-     * Automatically calculate the managemenr reply required tempate lengths
+     * The variables that the web server can ask about with a GET_VALUES
+     * record.
      */
-    template <typename NameT, typename ValueT>
-    management_reply(NameT name, ValueT value) -> management_reply<
-      (sizeof(NameT) / sizeof(char)), (sizeof(ValueT) / sizeof(char)),
-      ((sizeof(int_fast8_t) * 8u) -
-       ((sizeof(management_reply<1, 1, 1>) - 3 +
-         (sizeof(NameT) / sizeof(char)) + (sizeof(ValueT) / sizeof(char))) %
-        (sizeof(int_fast8_t) * 8u)))>;
-
-    management_reply default_max_conns_reply{"FCGI_MAX_CONNS", "10"};
-    management_reply default_max_reqs_reply{"FCGI_MAX_REQS", "50"};
-    management_reply default_mpxs_conns_reply{"FCGI_MPXS_CONNS", "1"};
+    struct management_values {
+        management_value max_conns;
+        management_value max_reqs;
+        management_value mpxs_conns;
+
+        constexpr management_values(std::size_t max_connections,
+                                    std::size_t max_requests,
+                                    bool        multiplexing = true) noexcept
+          : max_conns{"FCGI_MAX_CONNS", max_connections},
+            max_reqs{"FCGI_MAX_REQS", max_requests},
+            mpxs_conns{"FCGI_MPXS_CONNS", multiplexing ? 1u : 0u} {
+        }
+
+        /**
+         * The pre-serialized pair of the variable; empty if we don't know it
+         */
+        [[nodiscard]] constexpr std::string_view find(std::string_view name) const noexcept {
+            for (auto const* value : {&max_conns, &max_reqs, &mpxs_conns})
+                if (value->name() == name)
+                    return value->serialized();
+            return {};
+        }
+    };
 
 } // namespace webpp::protocol
 
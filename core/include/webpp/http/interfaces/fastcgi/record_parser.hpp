@@ -0,0 +1,200 @@
+#ifndef WEBPP_INTERFACE_FCGI_RECORD_PARSER
+#define WEBPP_INTERFACE_FCGI_RECORD_PARSER
+
+#include "../../../std/std.hpp"
+#include "./protocol.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace webpp::protocol {
+
+    /**
+     * The size of the header of each record; it's the same in all the
+     * versions of the protocol we know of.
+     */
+    constexpr stl::size_t header_length = 8;
+
+    /**
+     * A piece of a record's content.
+     *
+     * The content is a view into the buffer that was passed to the parser so
+     * it's only valid until the next read into that buffer. If a record is
+     * split across reads, you get more than one fragment for it and only the
+     * last one is marked as "complete".
+     */
+    struct record_fragment {
+        record_type      type;
+        uint16_t         request_id;
+        stl::string_view content;
+        bool             complete; // this is the last piece of this record
+    };
+
+    /**
+     * Incremental FastCGI record decoder.
+     *
+     * It never allocates and never copies the content; the only thing that
+     * gets copied is the 8 bytes of a header that is split between two reads.
+     * So you can feed it with the connection's buffer directly after each read:
+     *
+     *   parser.parse(stl::string_view{buffer.data(), bytes_transferred},
+     *                [](record_fragment const& fragment) { ... });
+     */
+    class record_parser {
+      public:
+        enum struct state_type : uint8_t {
+            header,  // we're reading the header
+            content, // we're reading the content
+            padding, // we're skipping the padding
+            error    // we've seen something that is not FastCGI; the connection should be closed
+        };
+
+      private:
+        stl::array<uint8_t, header_length> header_bytes{};
+
+        stl::size_t header_size       = 0; // the number of available bytes in the header_bytes
+        uint16_t    content_remaining = 0;
+        uint16_t    content_length    = 0;
+        uint8_t     padding_remaining = 0;
+        state_type  state             = state_type::header;
+
+        [[nodiscard]] record_type type() const noexcept {
+            return static_cast<record_type>(header_bytes[1]);
+        }
+
+        [[nodiscard]] uint16_t request_id() const noexcept {
+            return static_cast<uint16_t>((static_cast<uint16_t>(header_bytes[2]) << 8u) | header_bytes[3]);
+        }
+
+      public:
+        /**
+         * Parse as much as possible from the data and call the callback for
+         * each fragment of each record in the order that they appear.
+         * Empty records (like the end of the params stream) will produce one
+         * fragment with an empty content.
+         *
+         * @returns false if the data is not valid; parsing is stopped then.
+         */
+        template <typename Callback>
+        bool parse(stl::string_view data, Callback&& callback) noexcept {
+            auto it        = data.data();
+            auto const end = it + data.size();
+            while (it != end) {
+                switch (state) {
+                    case state_type::header: {
+                        while (header_size != header_length && it != end)
+                            header_bytes[header_size++] = static_cast<uint8_t>(*it++);
+                        if (header_size != header_length)
+                            return true; // wait for the rest of the header
+                        if (header_bytes[0] != 1) {
+                            state = state_type::error;
+                            return false;
+                        }
+                        header_size = 0;
+                        content_length =
+                          static_cast<uint16_t>((static_cast<uint16_t>(header_bytes[4]) << 8u) | header_bytes[5]);
+                        content_remaining = content_length;
+                        padding_remaining = header_bytes[6];
+                        if (content_length == 0) {
+                            callback(record_fragment{type(), request_id(), {}, true});
+                            state = padding_remaining ? state_type::padding : state_type::header;
+                        } else {
+                            state = state_type::content;
+                        }
+                        break;
+                    }
+                    case state_type::content: {
+                        auto const available = static_cast<stl::size_t>(end - it);
+                        auto const len =
+                          available < content_remaining ? available : static_cast<stl::size_t>(content_remaining);
+                        content_remaining -= static_cast<uint16_t>(len);
+                        auto const complete = content_remaining == 0;
+                        callback(record_fragment{type(), request_id(), stl::string_view{it, len}, complete});
+                        it += len;
+                        if (complete)
+                            state = padding_remaining ? state_type::padding : state_type::header;
+                        break;
+                    }
+                    case state_type::padding: {
+                        auto const available = static_cast<stl::size_t>(end - it);
+                        auto const len =
+                          available < padding_remaining ? available : static_cast<stl::size_t>(padding_remaining);
+                        padding_remaining -= static_cast<uint8_t>(len);
+                        it += len;
+                        if (padding_remaining == 0)
+                            state = state_type::header;
+                        break;
+                    }
+                    case state_type::error: return false;
+                }
+            }
+            return state != state_type::error;
+        }
+
+        /**
+         * Start from scratch; the bytes of the half-parsed record are forgotten
+         */
+        void reset() noexcept {
+            header_size       = 0;
+            content_remaining = 0;
+            content_length    = 0;
+            padding_remaining = 0;
+            state             = state_type::header;
+        }
+
+        [[nodiscard]] state_type current_state() const noexcept {
+            return state;
+        }
+
+        /**
+         * Check if we're between two records
+         */
+        [[nodiscard]] bool at_record_boundary() const noexcept {
+            return state == state_type::header && header_size == 0;
+        }
+    };
+
+    /**
+     * Decode the name-value pairs of a PARAMS (or GET_VALUES) content.
+     * The names and values are views into the content.
+     *
+     * @returns false if the content is truncated.
+     */
+    template <typename Callback>
+    bool parse_name_values(stl::string_view content, Callback&& callback) noexcept {
+        auto it        = reinterpret_cast<uint8_t const*>(content.data());
+        auto const end = it + content.size();
+
+        // the lengths are either one byte, or 4 bytes with the high bit set
+        auto read_length = [&](stl::size_t& len) noexcept -> bool {
+            if (it == end)
+                return false;
+            if ((*it & 0x80u) == 0) {
+                len = *it++;
+                return true;
+            }
+            if (end - it < 4)
+                return false;
+            len = (static_cast<stl::size_t>(it[0] & 0x7Fu) << 24u) | (static_cast<stl::size_t>(it[1]) << 16u) |
+                  (static_cast<stl::size_t>(it[2]) << 8u) | static_cast<stl::size_t>(it[3]);
+            it += 4;
+            return true;
+        };
+
+        while (it != end) {
+            stl::size_t name_len, value_len;
+            if (!read_length(name_len) || !read_length(value_len))
+                return false;
+            if (static_cast<stl::size_t>(end - it) < name_len + value_len)
+                return false;
+            auto const name = reinterpret_cast<char const*>(it);
+            callback(stl::string_view{name, name_len}, stl::string_view{name + name_len, value_len});
+            it += name_len + value_len;
+        }
+        return true;
+    }
+
+} // namespace webpp::protocol
+
+#endif // WEBPP_INTERFACE_FCGI_RECORD_PARSER
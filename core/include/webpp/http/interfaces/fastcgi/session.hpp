@@ -1,33 +1,707 @@
-#include "../../std/internet.hpp"
-#include "../../std/socket.hpp"
+#ifndef WEBPP_INTERFACE_FCGI_SESSION
+#define WEBPP_INTERFACE_FCGI_SESSION
 
-#include <system_error>
+#include "../../../std/buffer.hpp"
+#include "../../../std/std.hpp"
+#include "../../../utils/deadline.hpp"
+#include "../../../utils/uri.hpp"
+#include "../common/constants.hpp"
+#include "./protocol.hpp"
+#include "./record_parser.hpp"
+
+#include <array>
+#include <concepts>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
+
+namespace webpp::fastcgi {
+
+    /**
+     * The number of requests that can be in-flight at the same time over one
+     * connection; this is what we advertise as FCGI_MAX_REQS.
+     */
+    constexpr stl::size_t default_max_requests = 50;
+
+    /**
+     * The maximum size of the params of one request (the headers, in the
+     * HTTP terms); the bigger ones are rejected so the web server can't make
+     * us buffer forever.
+     */
+    constexpr stl::size_t max_params_size = 64 * 1024;
+
+    /**
+     * A fixed size table of the requests of a connection indexed by their
+     * request id. The slots are reused (and so are their buffers), so a
+     * long-living connection doesn't allocate for each request.
+     */
+    template <typename T, stl::size_t Capacity = default_max_requests>
+    class request_table {
+        static_assert(Capacity > 0, "The table should have at least one slot.");
+
+        struct slot {
+            uint16_t id = 0; // zero is the management id, so we use it for the free slots
+            T        value{};
+        };
+
+        stl::array<slot, Capacity> slots{};
+        stl::size_t                count = 0;
+
+        [[nodiscard]] slot* lookup(uint16_t id) noexcept {
+            // the web servers usually use small ids one after another so the
+            // first probe is almost always the right one
+            for (stl::size_t i = 0, index = id % Capacity; i < Capacity; i++, index = (index + 1) % Capacity) {
+                if (slots[index].id == id)
+                    return &slots[index];
+            }
+            return nullptr;
+        }
+
+        // the first free slot in the probe sequence of the id, so the lookups
+        // of the id find it with the fewest probes
+        [[nodiscard]] slot* find_free(uint16_t id) noexcept {
+            for (stl::size_t i = 0, index = id % Capacity; i < Capacity; i++, index = (index + 1) % Capacity) {
+                if (slots[index].id == 0)
+                    return &slots[index];
+            }
+            return nullptr;
+        }
+
+      public:
+        /**
+         * Get the request with the specified id; nullptr if there's none
+         */
+        [[nodiscard]] T* find(uint16_t id) noexcept {
+            if (id == 0)
+                return nullptr;
+            auto s = lookup(id);
+            return s ? &s->value : nullptr;
+        }
+
+        /**
+         * Reserve a slot for the specified id; nullptr if the table is full
+         * or if the id is already in use.
+         */
+        [[nodiscard]] T* emplace(uint16_t id) noexcept {
+            if (id == 0 || count == Capacity || lookup(id))
+                return nullptr;
+            auto s = find_free(id);
+            s->id  = id;
+            count++;
+            return &s->value;
+        }
+
+        bool erase(uint16_t id) noexcept {
+            if (id == 0)
+                return false;
+            if (auto s = lookup(id)) {
+                s->id = 0;
+                count--;
+                return true;
+            }
+            return false;
+        }
 
-class session {
-  public:
-    using socket_t = std::net::ip::tcp::socket;
+        template <typename Callback>
+        void for_each(Callback&& callback) noexcept {
+            for (auto& s : slots)
+                if (s.id != 0)
+                    callback(s.id, s.value);
+        }
 
-  private:
-    socket_t _socket;
+        [[nodiscard]] stl::size_t size() const noexcept {
+            return count;
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return count == 0;
+        }
+
+        [[nodiscard]] static constexpr stl::size_t capacity() noexcept {
+            return Capacity;
+        }
+    };
 
     /**
-     * This function will read the data and pass it to read_callback to handle
-     * those data
+     * One FastCGI request that is being received or served
      */
-    void read() {
-    }
+    struct request {
+        uint16_t            id         = 0;
+        protocol::role_type role       = protocol::role_type::responder;
+        bool                keep_conn  = false;
+        bool                params_end = false; // we've got the whole params stream
+        bool                stdin_end  = false; // we've got the whole stdin stream
+        bool                dispatched = false; // the handler has been called
+
+        // these have to be copied because the data in the record parser is
+        // only valid until the next read
+        stl::string params; // the raw name-value pairs
+        stl::string std_in;
+        stl::string target; // the REQUEST_URI, if it had to be normalized
+
+        // the cancellation of the task that serves it, if it's served by one (see fcgi);
+        // it's cancelled if the web server aborts the request, or the connection is closed
+        stl::optional<cancellation_source> cancellation{};
+
+        void reset(uint16_t _id, protocol::role_type _role, bool _keep_conn) noexcept {
+            id         = _id;
+            role       = _role;
+            keep_conn  = _keep_conn;
+            params_end = false;
+            stdin_end  = false;
+            dispatched = false;
+            params.clear(); // keeps the capacity
+            std_in.clear();
+            target.clear();
+            cancellation.reset();
+        }
 
-    void read_callback(std::error_code const&, std::size_t length) noexcept;
+        /**
+         * Call the callback with each of the name and values in the params
+         */
+        template <typename Callback>
+        bool for_each_param(Callback&& callback) const noexcept {
+            return protocol::parse_name_values(params, stl::forward<Callback>(callback));
+        }
+
+        /**
+         * Get the value of a param; empty if there's no such param
+         */
+        [[nodiscard]] stl::string_view param(stl::string_view name) const noexcept {
+            stl::string_view res;
+            for_each_param([&](stl::string_view n, stl::string_view v) noexcept {
+                if (n == name)
+                    res = v;
+            });
+            return res;
+        }
+
+        /**
+         * Normalize the path of the REQUEST_URI before the application routes
+         * it, the way the HTTP/1.1 server does; the ones that are normalized
+         * already are not copied.
+         */
+        void normalize_target() noexcept {
+            auto const uri = param("REQUEST_URI");
+            if (!uri.starts_with('/') || is_normalized_path(uri))
+                return;
+            target.assign(uri);
+            target.resize(normalize_path_inplace(target.data(), target.size()));
+        }
+
+        /**
+         * The REQUEST_URI, normalized
+         */
+        [[nodiscard]] stl::string_view request_target() const noexcept {
+            return target.empty() ? param("REQUEST_URI") : stl::string_view{target};
+        }
+    };
 
     /**
-     * This method will write the data and calls the write_callback to handle
-     * the next steps
+     * The FastCGI protocol state of one connection.
+     *
+     * It's not tied to a socket: you feed it with whatever has been read and
+     * it gives you the buffers that should be written. Many requests can be
+     * in-flight at the same time (multiplexing) and their STDOUT records can
+     * be interleaved in any order.
+     *
+     * The output is a list of const buffers (record headers, the response
+     * slices, paddings, and the end request records) so the whole thing can
+     * be flushed with one gather write and the response bodies never get
+     * concatenated into a temporary string. The streamed responses are
+     * producers in between the buffers; each chunk is made into a STDOUT
+     * record when the writer asks for it.
      */
-    void write();
-    void write_callback(std::error_code const&, std::size_t length) noexcept;
+    template <stl::size_t MaxRequests = default_max_requests>
+    class basic_session {
+      public:
+        using request_type    = request;
+        using request_handler = stl::function<void(basic_session&, request_type&)>;
+        using producer_type   = stl::function<bool(stl::string&)>;
+
+        /**
+         * A stream that goes after the first "position" buffers of the output
+         */
+        struct stream_part {
+            stl::size_t   position;
+            producer_type producer;
+        };
+
+      private:
+        protocol::record_parser                  parser;
+        request_table<request_type, MaxRequests> requests;
+        request_handler                          handler;
+        bool                                     close_requested = false;
+        bool                                     shedding        = false; // see overloaded
+        stl::size_t                              max_body_size   = default_max_body_size;
+
+        // the answers to the requests that are bigger than the limits
+        static constexpr stl::string_view params_too_large_response =
+          "Status: 431 Request Header Fields Too Large\r\nContent-Length: 0\r\n\r\n";
+        static constexpr stl::string_view body_too_large_response =
+          "Status: 413 Content Too Large\r\nContent-Length: 0\r\n\r\n";
+
+        /**
+         * The records that we make ourselves; the content of these records are
+         * small enough to be stored right after their header.
+         */
+        struct control_record {
+            protocol::header    header;
+            stl::array<char, 8> content{};
+        };
+
+        // a deque, because the buffers point into them so they should not move
+        stl::deque<control_record>               controls;
+        stl::deque<stl::string>                  held;   // the strings that the user gave us
+        stl::vector<stl::shared_ptr<void const>> owners; // the owners of the bytes that they lent us
+        stl::vector<stl::net::const_buffer>      output;
+        stl::vector<stream_part>                 streams;
+        stl::size_t                              output_bytes = 0;
+
+        static constexpr stl::array<char, 8> zero_padding{};
+
+      public:
+        /**
+         * What we tell the web server if it asks about our limits; the number
+         * of connections should be set to the server's limit.
+         */
+        static constexpr protocol::management_values default_values{default_max_connections, MaxRequests};
+
+      private:
+        protocol::management_values const* values = &default_values;
+
+        // keeps the values alive if they're shared (they're reloaded, for example)
+        stl::shared_ptr<protocol::management_values const> values_owner{};
+
+        // the body of the begin request record that is being read
+        stl::array<char, sizeof(protocol::begin_request)> begin_body{};
+        stl::size_t                                        begin_size = 0;
+
+        // the names of a GET_VALUES record that is being read; the web server
+        // only asks about a few variables, so the rest of it is ignored
+        stl::array<char, 256> management_body{};
+        stl::size_t           management_size = 0;
+
+        void push_buffer(void const* data, stl::size_t size) noexcept {
+            if (size == 0)
+                return;
+            output.emplace_back(data, size);
+            output_bytes += size;
+        }
+
+        /**
+         * Add a record whose content is owned by somebody else
+         */
+        void append_record(protocol::record_type type, uint16_t id, stl::string_view content) noexcept {
+            auto const padding = static_cast<uint8_t>((8u - (content.size() % 8u)) % 8u);
+            auto&      rec =
+              controls.emplace_back(protocol::header{type, id, static_cast<uint16_t>(content.size()), padding});
+            static_assert(sizeof(rec.header) == protocol::header_length);
+            push_buffer(&rec.header, sizeof(rec.header));
+            push_buffer(content.data(), content.size());
+            push_buffer(zero_padding.data(), padding);
+        }
+
+        /**
+         * Add a record with a small content that we copy
+         */
+        void append_control_record(protocol::record_type type, uint16_t id, stl::string_view content) noexcept {
+            auto const padding = static_cast<uint8_t>((8u - (content.size() % 8u)) % 8u);
+            auto&      rec =
+              controls.emplace_back(protocol::header{type, id, static_cast<uint16_t>(content.size()), padding});
+            stl::memcpy(rec.content.data(), content.data(), content.size());
+            // the content and the padding are right after the header
+            push_buffer(&rec.header, sizeof(rec.header) + content.size() + padding);
+        }
+
+        /**
+         * Add a record to a string, for the streams; the content is split
+         * into as many records as it needs.
+         */
+        static void append_record_to(stl::string&          out,
+                                     protocol::record_type type,
+                                     uint16_t              id,
+                                     stl::string_view      content) noexcept {
+            do {
+                auto const len     = stl::min<stl::size_t>(content.size(), 0xFFFFu & ~7u);
+                auto const padding = static_cast<uint8_t>((8u - (len % 8u)) % 8u);
+                protocol::header const header{type, id, static_cast<uint16_t>(len), padding};
+                out.append(reinterpret_cast<char const*>(&header), sizeof(header));
+                out.append(content.data(), len);
+                out.append(zero_padding.data(), padding);
+                content.remove_prefix(len);
+            } while (!content.empty());
+        }
+
+        void append_end_request(uint16_t id, uint32_t app_status, protocol::protocol_status_type status) noexcept {
+            protocol::end_request body{app_status, status};
+            static_assert(sizeof(body) == sizeof(control_record::content));
+            append_control_record(protocol::record_type::end_request, id,
+                                  stl::string_view{reinterpret_cast<char const*>(&body), sizeof(body)});
+        }
+
+        void on_begin_request(protocol::record_fragment const& f) noexcept {
+            // the body is tiny, but it still can be split between two reads
+            auto const len = stl::min(f.content.size(), begin_body.size() - begin_size);
+            stl::memcpy(begin_body.data() + begin_size, f.content.data(), len);
+            begin_size += len;
+            if (!f.complete)
+                return;
+            auto const size = stl::exchange(begin_size, stl::size_t{0});
+            if (size < sizeof(protocol::begin_request))
+                return; // that's not a valid begin request
+            protocol::begin_request body;
+            stl::memcpy(&body, begin_body.data(), sizeof(body));
+            if (body.role() != protocol::role_type::responder) {
+                append_end_request(f.request_id, 0, protocol::protocol_status_type::unknown_role);
+                return;
+            }
+            auto req = requests.emplace(f.request_id);
+            if (!req) {
+                append_end_request(f.request_id, 0, protocol::protocol_status_type::overloaded);
+                return;
+            }
+            req->reset(f.request_id, body.role(), body.keep_connection());
+        }
+
+        /**
+         * Answer a GET_VALUES record; the pairs are pointed to and not copied,
+         * so there's no allocation or formatting here.
+         */
+        void on_get_values(protocol::record_fragment const& f) noexcept {
+            // the names may come in more than one fragment
+            auto const len = stl::min(f.content.size(), management_body.size() - management_size);
+            stl::memcpy(management_body.data() + management_size, f.content.data(), len);
+            management_size += len;
+            if (!f.complete)
+                return;
+            stl::string_view const names{management_body.data(), stl::exchange(management_size, stl::size_t{0})};
+
+            // the lengths in the header are set after we know them; the buffer
+            // only points to it
+            auto& rec = controls.emplace_back(protocol::header{protocol::record_type::get_values_result, 0, 0, 0});
+            push_buffer(&rec.header, sizeof(rec.header));
+            stl::size_t content_length = 0;
+            protocol::parse_name_values(names, [&](stl::string_view name, stl::string_view) noexcept {
+                if (auto const pair = values->find(name); !pair.empty()) {
+                    push_buffer(pair.data(), pair.size());
+                    content_length += pair.size();
+                }
+            });
+            auto const padding = static_cast<uint8_t>((8u - (content_length % 8u)) % 8u);
+            rec.header.content_length(static_cast<uint16_t>(content_length));
+            rec.header.padding_length = padding;
+            push_buffer(zero_padding.data(), padding);
+        }
+
+        void on_management(protocol::record_fragment const& f) noexcept {
+            if (f.type == protocol::record_type::get_values) {
+                on_get_values(f);
+                return;
+            }
+            if (!f.complete)
+                return;
+            protocol::unknown_type body{f.type, {}};
+            append_control_record(protocol::record_type::unknown_type, 0,
+                                  stl::string_view{reinterpret_cast<char const*>(&body), sizeof(body)});
+        }
+
+        /**
+         * Answer a request that is bigger than the limits without calling the
+         * handler; its slot is freed, so the rest of its records are ignored.
+         */
+        void reject(uint16_t id, stl::string_view response) noexcept {
+            write_stdout(id, response);
+            end_request(id);
+        }
+
+        void on_fragment(protocol::record_fragment const& f) noexcept {
+            if (f.request_id == 0) {
+                on_management(f);
+                return;
+            }
+            switch (f.type) {
+                case protocol::record_type::begin_request: on_begin_request(f); return;
+                case protocol::record_type::abort_request:
+                    if (auto req = requests.find(f.request_id); f.complete && req && req->cancellation)
+                        req->cancellation->cancel();
+                    if (f.complete && requests.erase(f.request_id))
+                        append_end_request(f.request_id, 0, protocol::protocol_status_type::request_complete);
+                    return;
+                case protocol::record_type::params:
+                    if (auto req = requests.find(f.request_id); req && !req->params_end) {
+                        if (req->params.size() + f.content.size() > max_params_size) {
+                            reject(f.request_id, params_too_large_response);
+                            return;
+                        }
+                        req->params.append(f.content);
+                        // an empty record is the end of the stream
+                        req->params_end = f.complete && f.content.empty();
+                    }
+                    return;
+                case protocol::record_type::std_in:
+                    if (auto req = requests.find(f.request_id); req && !req->stdin_end) {
+                        if (req->std_in.size() + f.content.size() > max_body_size) {
+                            reject(f.request_id, body_too_large_response);
+                            return;
+                        }
+                        req->std_in.append(f.content);
+                        req->stdin_end = f.complete && f.content.empty();
+                        if (req->stdin_end && req->params_end && !req->dispatched) {
+                            req->dispatched = true;
+                            req->normalize_target();
+                            if (handler)
+                                handler(*this, *req);
+                        }
+                    }
+                    return;
+                default: return; // we don't know about these
+            }
+        }
+
+      public:
+        /**
+         * The requests whose body is bigger than the max body size are
+         * answered with a 413, and the ones whose params are bigger than
+         * max_params_size with a 431.
+         */
+        basic_session(request_handler _handler       = {},
+                      stl::size_t     _max_body_size = default_max_body_size) noexcept
+          : handler{stl::move(_handler)},
+            max_body_size{_max_body_size} {
+        }
+
+        /**
+         * Set the values that we answer GET_VALUES with; they should live
+         * longer than this session.
+         */
+        void management_values(protocol::management_values const& _values) noexcept {
+            values = &_values;
+            values_owner.reset();
+        }
+
+        /**
+         * Share the values with the other sessions; they're kept alive for as
+         * long as this session uses them.
+         */
+        void management_values(stl::shared_ptr<protocol::management_values const> _values) noexcept {
+            if (!_values)
+                return;
+            values       = _values.get();
+            values_owner = stl::move(_values);
+        }
+
+        /**
+         * Feed the session with the data that has been read from the socket
+         * @returns false if the peer is not speaking FastCGI
+         */
+        bool feed(stl::string_view data) noexcept {
+            return parser.parse(data, [this](protocol::record_fragment const& f) noexcept {
+                on_fragment(f);
+            });
+        }
+
+        /**
+         * Send a part of the response of the specified request; it can be
+         * called as many times as needed, and between the calls for other
+         * requests.
+         *
+         * The data is not copied, so it should be kept alive until the output
+         * is released.
+         */
+        void write_stdout(uint16_t id, stl::string_view data) noexcept {
+            if (!requests.find(id))
+                return;
+            // the content length of a record is 16 bits
+            while (!data.empty()) {
+                auto const len = stl::min<stl::size_t>(data.size(), 0xFFFFu & ~7u);
+                append_record(protocol::record_type::std_out, id, data.substr(0, len));
+                data.remove_prefix(len);
+            }
+        }
+
+        /**
+         * Same as above, but the session holds the string until the output
+         * is released.
+         */
+        template <typename StrT>
+        requires(stl::same_as<StrT, stl::string>) // only the rvalues
+        void write_stdout(uint16_t id, StrT&& data) noexcept {
+            if (!requests.find(id) || data.empty())
+                return;
+            write_stdout(id, stl::string_view{held.emplace_back(stl::move(data))});
+        }
+
+        /**
+         * Same as above, but the owner is kept until the output is released;
+         * the bytes are not copied.
+         */
+        void write_stdout(uint16_t id, stl::string_view data, stl::shared_ptr<void const> owner) noexcept {
+            if (!requests.find(id) || data.empty())
+                return;
+            owners.push_back(stl::move(owner));
+            write_stdout(id, data);
+        }
+
+        /**
+         * Finish the response of the specified request and free its slot
+         */
+        void end_request(uint16_t id, uint32_t app_status = 0) noexcept {
+            auto req = requests.find(id);
+            if (!req)
+                return;
+            append_record(protocol::record_type::std_out, id, {}); // the end of the stdout stream
+            append_end_request(id, app_status, protocol::protocol_status_type::request_complete);
+            if (!req->keep_conn)
+                close_requested = true;
+            requests.erase(id);
+        }
+
+        /**
+         * Finish the response of the specified request with a stream; the
+         * producer is asked for its chunks when the writer gets to it, and
+         * each one goes out as a STDOUT record, with the end of the request
+         * after the last one. The slot is freed now; the web server doesn't
+         * reuse the id before it has the end of the request.
+         */
+        void end_request(uint16_t id, producer_type producer, uint32_t app_status = 0) noexcept {
+            auto req = requests.find(id);
+            if (!req)
+                return;
+            streams.push_back(stream_part{
+              output.size(),
+              [id, app_status, producer = stl::move(producer), chunk = stl::string{}](
+                stl::string& out) mutable noexcept {
+                  chunk.clear();
+                  auto const more = producer && producer(chunk);
+                  if (!chunk.empty())
+                      append_record_to(out, protocol::record_type::std_out, id, chunk);
+                  if (!more) {
+                      append_record_to(out, protocol::record_type::std_out, id, {}); // the end of the stdout
+                      protocol::end_request const body{app_status,
+                                                       protocol::protocol_status_type::request_complete};
+                      append_record_to(out, protocol::record_type::end_request, id,
+                                       stl::string_view{reinterpret_cast<char const*>(&body), sizeof(body)});
+                  }
+                  return more;
+              }});
+            if (!req->keep_conn)
+                close_requested = true;
+            requests.erase(id);
+        }
+
+        /**
+         * What has been written so far, taken out of the session: the buffers,
+         * the streams that go in between them, and everything that the
+         * buffers point to. It's kept alive for as long as the batch is.
+         */
+        struct output_batch {
+            stl::deque<control_record>                         controls;
+            stl::deque<stl::string>                            held;
+            stl::vector<stl::shared_ptr<void const>>           owners;
+            stl::shared_ptr<protocol::management_values const> values; // the GET_VALUES pairs point into them
+            stl::vector<stl::net::const_buffer>                buffers;
+            stl::vector<stream_part>                           streams;
+        };
+
+        /**
+         * Hand the output to a writer that writes it later; the session
+         * starts over with an empty output, and the buffers of the batch stay
+         * valid until it's dropped (moving the deques doesn't move their
+         * elements).
+         */
+        [[nodiscard]] stl::shared_ptr<output_batch> detach_output() noexcept {
+            auto batch = stl::make_shared<output_batch>(output_batch{.controls = stl::move(controls),
+                                                                     .held     = stl::move(held),
+                                                                     .owners   = stl::move(owners),
+                                                                     .values   = values_owner,
+                                                                     .buffers  = stl::move(output),
+                                                                     .streams  = stl::move(streams)});
+            release_output();
+            return batch;
+        }
+
+        /**
+         * The buffers that should be written to the socket, in order; they
+         * are valid until release_output is called. The streams are not in
+         * them, see detach_output.
+         */
+        [[nodiscard]] stl::vector<stl::net::const_buffer> const& output_buffers() const noexcept {
+            return output;
+        }
+
+        /**
+         * The sum of the sizes of the output buffers
+         */
+        [[nodiscard]] stl::size_t output_size() const noexcept {
+            return output_bytes;
+        }
+
+        [[nodiscard]] bool has_output() const noexcept {
+            return !output.empty() || !streams.empty();
+        }
+
+        /**
+         * Call this when the output buffers have been written
+         */
+        void release_output() noexcept {
+            output.clear();
+            controls.clear();
+            held.clear();
+            owners.clear();
+            streams.clear();
+            output_bytes = 0;
+        }
+
+        /**
+         * The worker is overloaded (see load_shedder); the requests that are
+         * completed now should be rejected instead of being served. The
+         * interface decides it for each read, and the handler looks at it.
+         */
+        void overloaded(bool value) noexcept {
+            shedding = value;
+        }
+
+        [[nodiscard]] bool is_overloaded() const noexcept {
+            return shedding;
+        }
+
+        /**
+         * The web server didn't ask us to keep the connection and we've
+         * finished its request; close it after writing the output.
+         */
+        [[nodiscard]] bool should_close() const noexcept {
+            return close_requested && requests.empty();
+        }
+
+        /**
+         * Cancel the tasks that are serving the requests; the connection is
+         * closed, and nobody is waiting for them anymore.
+         */
+        void cancel_tasks() noexcept {
+            requests.for_each([](uint16_t, request_type& req) noexcept {
+                if (req.cancellation)
+                    req.cancellation->cancel();
+            });
+        }
+
+        [[nodiscard]] stl::size_t in_flight() const noexcept {
+            return requests.size();
+        }
+
+        [[nodiscard]] static constexpr stl::size_t max_requests() noexcept {
+            return MaxRequests;
+        }
+    };
+
+    using session = basic_session<>;
+
+} // namespace webpp::fastcgi
 
-  public:
-    session(socket_t&& _socket) noexcept : _socket(std::move(_socket)) {
-    }
-};
+#endif // WEBPP_INTERFACE_FCGI_SESSION
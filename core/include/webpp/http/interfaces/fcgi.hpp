@@ -1,50 +1,373 @@
 #ifndef WEBPP_INTERFACE_FCGI
 #define WEBPP_INTERFACE_FCGI
 
+#include "../../config.hpp"
 #include "../../std/internet.hpp"
 #include "../../std/set.hpp"
 #include "../../std/vector.hpp"
+#include "../../traits/std_arena_traits.hpp"
+#include "../../traits/std_traits.hpp"
+#include "../../utils/logger.hpp"
+#include "../../utils/task.hpp"
+#include "../../utils/tracing.hpp"
+#include "../application_concepts.hpp"
+#include "../header_index.hpp"
 #include "../request.hpp"
+#include "./common/cgi_variables.hpp"
 #include "./common/server.hpp"
-#include "basic_interface.hpp"
+#include "./common/task_link.hpp"
+#include "./fastcgi/session.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
 
 namespace webpp {
 
-    template <typename Traits>
-    class fcgi : public basic_interface<Traits, fcgi<Traits>> {
+    /**
+     * A FastCGI application server (the responder role); the web server
+     * connects to us and multiplexes its requests onto the connections.
+     *
+     * The application is called from the worker threads, so if you set the
+     * concurrency to more than one, the application should be thread-safe.
+     */
+    template <Traits TraitsType, Application App>
+    struct fcgi {
       public:
-        static_assert(
-          is_traits_v<Traits>,
-          "The specified template parameter is not a valid traits type.");
-        using traits_type = Traits;
-        using endpoint_t  = stl::net::ip::tcp::endpoint;
+        using traits_type      = TraitsType;
+        using application_type = App;
+        using interface_type   = fcgi<traits_type, application_type>;
+        using endpoint_t       = stl::net::ip::tcp::endpoint;
+
+        application_type app;
 
       private:
-        stl::set<traits_type, endpoint_t> _endpoints;
-        common::server               _server;
+        istl::set<traits_type, endpoint_t> _endpoints;
+        stl::optional<common::server>      _server;
+        stl::size_t                        _concurrency   = 0; // one per core
+        stl::size_t                        _max_body_size = default_max_body_size;
+        metrics_registry*                  _metrics       = nullptr;
+        bool                               _access_log    = false;
+        stl::optional<shedding_options>    _shedding{};
 
-        auto get_endpoints() noexcept {
-            stl::net::ip::tcp::resolver resolver(_server.io);
-            stl::error_code             ec;
-            //        std::net::ip::tcp::resolver::results_type _endpoints;
-            //        if (_fcgi->endpoints().empty()) {
-            //            _endpoints = resolver.resolve(
-            //                default_fcgi_listen_addr,
-            //                std::to_string(default_fcgi_listen_port));
-            //        } else {
-            //            _endpoints = std::net::ip::tcp::v4();
-            //        }
-            return stl::vector<traits_type, stl::net::ip::tcp::endpoint>{};
-        }
+        // the answer to the requests that the load shedder rejects
+        static constexpr stl::string_view overloaded_response =
+          "Status: 503 Service Unavailable\r\nContent-Length: 0\r\nRetry-After: 1\r\n\r\n";
+        stl::vector<int>                   _adopted{};
 
+        // the limits can be reloaded while we're running (see "configure")
+        using management_ptr = stl::shared_ptr<protocol::management_values const>;
+        config*                     _config = nullptr;
+        stl::filesystem::path       _config_path{};
+        stl::atomic<management_ptr> _management{};
+
+        /**
+         * The endpoints that we're going to listen on; the default fcgi
+         * address and port are used if the user hasn't specified any.
+         */
+        auto get_endpoints() const noexcept {
+            istl::vector<traits_type, endpoint_t> res;
+            if (!_endpoints.empty()) {
+                res.assign(_endpoints.begin(), _endpoints.end());
+                return res;
+            }
+            stl::net::io_context        io;
+            stl::net::ip::tcp::resolver resolver(io);
+            istl::net_error_code        ec;
+            auto const                  results =
+              resolver.resolve(default_fcgi_listen_addr, stl::to_string(default_fcgi_listen_port), ec);
+            if (!ec) {
+                for (auto const& result : results)
+                    res.push_back(result.endpoint());
+            }
+            return res;
+        }
 
       public:
-        webpp::router_t<traits_type, fcgi> router;
+        /**
+         * Call the application for a complete request, and send the response
+         */
+        void serve(fastcgi::session& session, fastcgi::request& freq) noexcept {
+            if (session.is_overloaded()) [[unlikely]] {
+                session.write_stdout(freq.id, stl::string{overloaded_response});
+                session.end_request(freq.id);
+                return;
+            }
+            serve_in_request_arena<traits_type>([&]() noexcept {
+                // the request type is named here and not as a member alias because
+                // checking the Interface concept needs this class to be complete
+                using request_type = basic_request<traits_type, interface_type>;
+                request_type req{freq};
+                auto const   start = _access_log ? stl::chrono::steady_clock::now()
+                                                 : stl::chrono::steady_clock::time_point{};
+                auto         res   = [&] {
+                    WEBPP_TRACE_SPAN(handler, freq.id);
+                    return app(req);
+                }();
+                respond(session, freq, res, start);
+            });
+        }
+
+        /**
+         * Start the task of a complete request (the application is a
+         * coroutine); the request is copied, since the task outlives its slot
+         * if the web server aborts it. The session is where the connection's
+         * data handler keeps it. The response is written on the
+         * connection's thread when it's done, unless the request is aborted
+         * or the connection is closed by then; its slot is kept until then,
+         * so the connection is busy. The tasks are not served in the request
+         * arena, since the arena is reset before they're done.
+         */
+        void serve_task(common::task_link const& tasks, fastcgi::session& session, fastcgi::request& freq) noexcept {
+            if (session.is_overloaded()) [[unlikely]] {
+                session.write_stdout(freq.id, stl::string{overloaded_response});
+                session.end_request(freq.id);
+                return;
+            }
+            using request_type = basic_request<traits_type, interface_type>;
+            struct in_flight {
+                fastcgi::request            source;
+                stl::optional<request_type> req{};
+            };
+            freq.cancellation.emplace();
+            auto flight    = stl::make_shared<in_flight>();
+            flight->source = freq;
+            flight->req.emplace(flight->source, freq.cancellation->token());
+            auto const start  = _access_log ? stl::chrono::steady_clock::now()
+                                            : stl::chrono::steady_clock::time_point{};
+            auto       result = [&] {
+                WEBPP_TRACE_SPAN(handler, freq.id);
+                return app(*flight->req);
+            }();
+            stl::move(result).start([this, &session, flight, start, link = tasks](auto res) mutable noexcept {
+                link.post([this, &session, flight = stl::move(flight), start, res = stl::move(res)](
+                            common::connection& conn) mutable noexcept {
+                    // the session lives as long as the connection is open
+                    if (flight->source.cancellation->is_cancelled())
+                        return; // the web server has aborted it, and its id may be someone else's now
+                    respond(session, flight->source, res, start);
+                    queue_output(conn, session);
+                });
+            });
+        }
+
+        /**
+         * Write the response, and finish the request
+         */
+        template <typename ResponseType>
+        void respond(fastcgi::session&                     session,
+                     fastcgi::request const&               freq,
+                     ResponseType&                         res,
+                     stl::chrono::steady_clock::time_point start) noexcept {
+            WEBPP_TRACE_SPAN(serialize, freq.id);
+            res.calculate_default_headers();
+            if (_access_log)
+                log_access(freq.param("REQUEST_METHOD"),
+                           freq.request_target(),
+                           static_cast<unsigned>(res.header.status_code),
+                           start);
+            session.write_stdout(freq.id, common::cgi_response_head(res));
+            send_body(session, freq.id, res.body);
+            recycle_response(stl::move(res));
+        }
 
-        fcgi() noexcept;
+        /**
+         * Send the body and finish the request. The streams are produced while
+         * they're written, one STDOUT record per chunk, so a slow web server
+         * slows the producer down; the shared bodies are not copied, they're
+         * written from where they are.
+         */
+        template <typename BodyType>
+        static void send_body(fastcgi::session& session, uint16_t id, BodyType const& body) noexcept {
+            if constexpr (requires { body.producer_handle(); }) {
+                if (body.is_stream()) {
+                    session.end_request(id, [producer = body.producer_handle()](stl::string& chunk) noexcept {
+                        return (*producer)(chunk);
+                    });
+                    return;
+                }
+            }
+            if constexpr (requires { body.shared_owner(); }) {
+                if (auto owner = body.shared_owner(); owner != nullptr) {
+                    auto const bytes = body.view();
+                    session.write_stdout(id, stl::string_view{bytes.data(), bytes.size()}, stl::move(owner));
+                    session.end_request(id);
+                    return;
+                }
+            }
+            session.write_stdout(id, stl::string{body.str()});
+            session.end_request(id);
+        }
 
-        void operator()() noexcept;
+        /**
+         * Queue the session's output on the connection: the buffers go out
+         * from where they are (the batch is kept until they're written), and
+         * the streams take their turn in between them.
+         */
+        static void send_output(common::connection& conn, fastcgi::session& session) noexcept {
+            auto const                              batch = session.detach_output();
+            stl::span<stl::net::const_buffer const> buffers{batch->buffers};
+            stl::size_t                             first = 0;
+            for (auto& part : batch->streams) {
+                conn.write(buffers.subspan(first, part.position - first), batch);
+                conn.send_stream(stl::move(part.producer));
+                first = part.position;
+            }
+            conn.write(buffers.subspan(first), batch);
+        }
+
+        /**
+         * Feed the session with the data that is read from the connection,
+         * and queue what it has to say.
+         */
+        static void handle(common::connection& conn, fastcgi::session& session, stl::string_view data) noexcept {
+            // the records are parsed, and the complete requests are served, in the feed
+            session.overloaded(!conn.admit());
+            auto const ok = [&] {
+                WEBPP_TRACE_SPAN(parse, conn.trace_id());
+                return session.feed(data);
+            }();
+            queue_output(conn, session, ok);
+        }
+
+        /**
+         * Same as above, for the coroutine applications; the tasks of the
+         * requests are cancelled when the connection is closed.
+         */
+        static void handle(common::connection& conn,
+                           fastcgi::session&   session,
+                           common::task_link&  tasks,
+                           stl::string_view    data) noexcept {
+            if (!tasks.is_attached()) {
+                tasks.attach(conn, [&session] {
+                    session.cancel_tasks();
+                });
+            }
+            handle(conn, session, data);
+        }
+
+        /**
+         * Queue what the session has to say, and close the connection if it's
+         * done (or if the peer is not speaking FastCGI)
+         */
+        static void queue_output(common::connection& conn, fastcgi::session& session, bool ok = true) noexcept {
+            if (session.has_output())
+                send_output(conn, session);
+            if (!ok || session.should_close()) {
+                conn.close_after_write();
+            } else {
+                conn.busy(session.in_flight() != 0);
+            }
+        }
+
+        /**
+         * Every worker thread gets its own acceptor on each endpoint
+         * (SO_REUSEPORT), so the kernel balances the connections between
+         * them instead of all the threads fighting over one acceptor.
+         */
+        void operator()() noexcept {
+            _server.emplace(_adopted.empty() ? listen_endpoints() : stl::vector<endpoint_t>{},
+                            default_max_connections,
+                            _concurrency,
+                            common::balance_policy::least_load,
+                            true);
+#ifdef __unix__
+            for (auto const handle : _adopted)
+                _server->adopt(handle);
+#endif
+            stl::uint64_t subscription = 0;
+            if (_config != nullptr) {
+                reload(*_config->snapshot());
+                subscription = _config->subscribe([this](config_snapshot const& cfg) {
+                    reload(cfg);
+                });
+                if (!_config_path.empty()) {
+                    _server->on_hangup([this] {
+                        if (!_config->load_file(_config_path))
+                            log_warning("the config file {} couldn't be reloaded", _config_path.string());
+                    });
+                }
+            }
+            _server->on_connection([this] {
+                using request_type = basic_request<traits_type, interface_type>;
+                if constexpr (Task<decltype(app(stl::declval<request_type&>()))>) {
+                    common::task_link tasks;
+                    fastcgi::session  session{[this, tasks](fastcgi::session& s, fastcgi::request& freq) {
+                                                  serve_task(tasks, s, freq);
+                                              },
+                                              _max_body_size};
+                    session.management_values(_management.load(stl::memory_order_acquire));
+                    return [session = stl::move(session), tasks](common::connection& conn,
+                                                                 stl::string_view    data) mutable noexcept {
+                        handle(conn, session, tasks, data);
+                    };
+                } else {
+                    fastcgi::session session{[this](fastcgi::session& s, fastcgi::request& freq) {
+                                                 serve(s, freq);
+                                             },
+                                             _max_body_size};
+                    // each connection keeps the limits that were current when it was accepted
+                    session.management_values(_management.load(stl::memory_order_acquire));
+                    return [session = stl::move(session)](common::connection& conn,
+                                                          stl::string_view    data) mutable noexcept {
+                        handle(conn, session, data);
+                    };
+                }
+            });
+            if (_metrics != nullptr)
+                _server->metrics(*_metrics);
+            if (_shedding)
+                _server->shedding(*_shedding);
+            _server->run();
+            if (_config != nullptr)
+                _config->unsubscribe(subscription);
+        }
+
+        /**
+         * Take the limits from the config, and apply them again each time it
+         * changes: the server's (see common::server::reload) and the
+         * "fastcgi.max_requests" that we tell the web server about, which
+         * can't be more than what a session can hold. With a path, the file
+         * is loaded into the config each time we get a SIGHUP. The config
+         * should outlive the server. This will only work before you run the
+         * operator()
+         */
+        void configure(config& cfg, stl::filesystem::path path = {}) noexcept {
+            _config      = &cfg;
+            _config_path = stl::move(path);
+        }
+
+        /**
+         * Apply the limits of the config now; it's called from the thread
+         * that publishes the config, and the io threads pick the new limits
+         * up without stopping.
+         */
+        void reload(config_snapshot const& cfg) noexcept {
+            auto max_connections = default_max_connections;
+            if (_server) {
+                _server->reload(cfg);
+                max_connections = _server->max_connection_count();
+            }
+            auto const max_requests = stl::min(
+              cfg.get_as<stl::size_t>("fastcgi.max_requests", fastcgi::session::max_requests()),
+              fastcgi::session::max_requests());
+            _management.store(
+              stl::make_shared<protocol::management_values const>(max_connections, max_requests),
+              stl::memory_order_release);
+        }
+
+        /**
+         * What the new connections answer the GET_VALUES with; nullptr if
+         * nothing is reloaded yet (the defaults of the session are used then)
+         */
+        [[nodiscard]] management_ptr management_values() const noexcept {
+            return _management.load(stl::memory_order_acquire);
+        }
 
         /**
          * This will only work before you run the operator()
@@ -56,9 +379,11 @@ namespace webpp {
         /**
          * This will only work before you run the operator()
          */
-        void add_endpoint(stl::string_view const& addr,
-                          uint_fast8_t            port) noexcept {
-            _endpoints.emplace(stl::net::ip::make_address(addr), port);
+        void add_endpoint(stl::string_view const& addr, uint_fast16_t port) noexcept {
+            istl::net_error_code ec;
+            auto const           address = stl::net::ip::make_address(addr, ec);
+            if (!ec)
+                _endpoints.emplace(address, port);
         }
 
         /**
@@ -74,12 +399,182 @@ namespace webpp {
         auto const& endpoints() const noexcept {
             return _endpoints;
         }
+
+        /**
+         * The number of worker threads; zero means one per core.
+         * This will only work before you run the operator()
+         */
+        void concurrency(stl::size_t count) noexcept {
+            _concurrency = count;
+        }
+
+        /**
+         * The biggest request body; the bigger ones are answered with a 413.
+         * This will only work before you run the operator()
+         */
+        void max_body_size(stl::size_t size) noexcept {
+            _max_body_size = size;
+        }
+
+        /**
+         * Accept on the listening sockets that are already open (the ones
+         * that a prefork master opened, see http::run) instead of the
+         * endpoints; the server owns them, and each worker thread opens its
+         * own sibling on them. This will only work before you run the
+         * operator()
+         */
+        void adopt_listeners(stl::span<int const> handles) noexcept {
+            _adopted.assign(handles.begin(), handles.end());
+        }
+
+        [[nodiscard]] stl::vector<endpoint_t> listen_endpoints() const noexcept {
+            auto const endpoints = get_endpoints();
+            return {endpoints.begin(), endpoints.end()};
+        }
+
+        /**
+         * Answer the requests with a 503 when the server falls behind, instead
+         * of letting the latency grow (see load_shedder); it's off by default.
+         * This will only work before you run the operator()
+         */
+        void shedding(shedding_options const& options = {}) noexcept {
+            _shedding = options;
+        }
+
+        /**
+         * Count the connections, and the bytes that they read and write, into
+         * the registry (see common::server::metrics); the registry should
+         * outlive the server. This will only work before you run the
+         * operator()
+         */
+        void metrics(metrics_registry& registry) noexcept {
+            _metrics = &registry;
+        }
+
+        /**
+         * Log the requests (their method, URI, status, and the time that the
+         * application took) at the info level; see logger. It's off by
+         * default.
+         */
+        void access_log(bool enabled = true) noexcept {
+            _access_log = enabled;
+        }
+
+        /**
+         * Stop the server that is running in operator()
+         */
+        void stop() noexcept {
+            if (_server)
+                _server->stop();
+        }
     };
 
-    template <typename Traits>
-    class basic_request<Traits, fcgi<Traits>> {
+    /**
+     * The request of the FastCGI interface; the meta-variables come from the
+     * params of the request instead of the environment. It holds a reference
+     * to the FastCGI request, so it's only valid while the application is
+     * handling it; the requests of the tasks refer to their own copy.
+     */
+    template <Traits TraitsType, Application App>
+    struct basic_request<TraitsType, fcgi<TraitsType, App>>
+      : public common::cgi_variables<basic_request<TraitsType, fcgi<TraitsType, App>>>,
+        public request_body_parsers<basic_request<TraitsType, fcgi<TraitsType, App>>> {
+        using traits_type    = TraitsType;
+        using interface_type = fcgi<TraitsType, App>;
+        using str_type       = typename traits_type::string_type;
+
       private:
+        fastcgi::request const&     source;
+        mutable str_type            headers_cache;
+        mutable lazy_header_index<> header_index; // of the HTTP_* params, without the prefix
+        mutable stl::size_t         body_offset = 0; // what read_body has given
+        cancellation_token          token{};
+
       public:
+        basic_request(fastcgi::request const& _source) noexcept : source{_source} {
+        }
+
+        basic_request(fastcgi::request const& _source, cancellation_token _token) noexcept
+          : source{_source},
+            token{stl::move(_token)} {
+        }
+
+        /**
+         * It's cancelled when the web server aborts the request, or the
+         * connection is closed (see basic_context::cancellation)
+         */
+        [[nodiscard]] cancellation_token const& cancellation() const noexcept {
+            return token;
+        }
+
+        /**
+         * Get a param of the request; they're what the environment variables
+         * are in CGI.
+         */
+        [[nodiscard]] stl::string_view env(stl::string_view name) const noexcept {
+            return source.param(name);
+        }
+
+        /**
+         * The REQUEST_URI, with its path normalized (see fastcgi::request::normalize_target)
+         */
+        [[nodiscard]] stl::string_view request_uri() const noexcept {
+            return source.request_target();
+        }
+
+        /**
+         * @brief get a single header
+         * @param name
+         */
+        [[nodiscard]] stl::string_view header(stl::string_view name) const noexcept {
+            stl::array<char, 128> buffer;
+            auto const            variable = common::cgi_header_name(name, buffer);
+            if (variable.empty())
+                return {};
+            // the params are indexed the first time a header is asked for, instead of going over
+            // all of them for each header
+            auto const value = header_index.find(variable.substr(5), [this](auto& add) {
+                source.for_each_param([&add](stl::string_view param, stl::string_view param_value) noexcept {
+                    if (param.starts_with("HTTP_")) {
+                        add(param.substr(5), param_value);
+                    } else if (param == "CONTENT_TYPE" || param == "CONTENT_LENGTH") {
+                        add(param, param_value); // these two don't have the prefix in CGI
+                    }
+                });
+            });
+            return value.empty() && header_index.overflowed() ? env(variable) : value;
+        }
+
+        /**
+         * @brief get all of the headers as a string_view
+         * @details they're recreated from the HTTP_* params the first time
+         * they're asked for.
+         */
+        [[nodiscard]] stl::string_view headers() const noexcept {
+            if (headers_cache.empty()) {
+                source.for_each_param([this](stl::string_view name, stl::string_view value) noexcept {
+                    common::append_cgi_header(headers_cache, name, value);
+                });
+            }
+            return headers_cache;
+        }
+
+        /**
+         * @brief get the whole body as a string_view
+         */
+        [[nodiscard]] stl::string_view body() const noexcept {
+            return source.std_in;
+        }
+
+        /**
+         * @brief read the next chunk of the body
+         * @returns the number of bytes read; zero means the end of the body
+         */
+        stl::size_t read_body(char* data, stl::size_t size) const noexcept {
+            auto const n = source.std_in.copy(data, size, stl::min(body_offset, source.std_in.size()));
+            body_offset += n;
+            return n;
+        }
     };
 
 } // namespace webpp
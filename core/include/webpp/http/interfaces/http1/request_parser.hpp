@@ -0,0 +1,285 @@
+#ifndef WEBPP_INTERFACE_HTTP1_REQUEST_PARSER_H
+#define WEBPP_INTERFACE_HTTP1_REQUEST_PARSER_H
+
+#include "../../../std/std.hpp"
+#include "../../../utils/casts.hpp"
+#include "../../../utils/strings.hpp"
+#include "../common/constants.hpp"
+#include "./scanner.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace webpp::http1 {
+
+    /**
+     * The maximum size of the request line and the headers; anything bigger
+     * than this is rejected so a client can't make us buffer forever.
+     */
+    constexpr stl::size_t max_header_block_size = 64 * 1024;
+
+    /**
+     * The maximum number of header fields of one request
+     */
+    constexpr stl::size_t default_max_headers = 64;
+
+    struct header_field_view {
+        stl::string_view name;
+        stl::string_view value;
+    };
+
+    /**
+     * Compare two header names; header names are case-insensitive
+     */
+    [[nodiscard]] constexpr bool iequals(stl::string_view a, stl::string_view b) noexcept {
+        return ascii_iequals(a, b);
+    }
+
+    /**
+     * A parsed request; all the views point into the buffer that was parsed,
+     * nothing is copied.
+     */
+    template <stl::size_t MaxHeaders = default_max_headers>
+    struct basic_request_view {
+        stl::string_view                          method;
+        stl::string_view                          target;
+        uint8_t                                   version_major = 1;
+        uint8_t                                   version_minor = 1;
+        stl::array<header_field_view, MaxHeaders> headers{};
+        stl::size_t                               header_count = 0;
+        stl::string_view                          body;
+
+        /**
+         * The value of the first header with the specified name; empty if
+         * there's no such header.
+         */
+        [[nodiscard]] constexpr stl::string_view header(stl::string_view name) const noexcept {
+            for (stl::size_t i = 0; i < header_count; i++)
+                if (iequals(headers[i].name, name))
+                    return headers[i].value;
+            return {};
+        }
+
+        /**
+         * Check if the client wants us to keep the connection open after this
+         * request; HTTP/1.1 connections are persistent by default.
+         */
+        [[nodiscard]] constexpr bool keep_alive() const noexcept {
+            auto const conn = header("Connection");
+            if (version_major == 1 && version_minor >= 1)
+                return !iequals(conn, "close");
+            return iequals(conn, "keep-alive");
+        }
+    };
+
+    using request_view = basic_request_view<>;
+
+    enum struct parse_status {
+        complete,       // a whole request is parsed
+        incomplete,     // we need more data
+        error,          // it's not a valid (or supported) request
+        too_large,      // its body is bigger than the limit (413)
+        not_implemented // it has a transfer coding (501)
+    };
+
+    namespace details {
+
+        [[nodiscard]] constexpr bool is_token_char(char c) noexcept {
+            // RFC 7230: tchar
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '!' ||
+                   c == '#' || c == '$' || c == '%' || c == '&' || c == '\'' || c == '*' || c == '+' || c == '-' ||
+                   c == '.' || c == '^' || c == '_' || c == '`' || c == '|' || c == '~';
+        }
+
+        [[nodiscard]] constexpr stl::string_view trim_ows(stl::string_view str) noexcept {
+            while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+                str.remove_prefix(1);
+            while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+                str.remove_suffix(1);
+            return str;
+        }
+
+        /**
+         * Find the end of the line that starts at "pos"; only CRLF is accepted
+         * as the line terminator.
+         *
+         * @returns the position of the CR, or npos if we need more data; the
+         *          status is set to error if there's a bare LF or CR.
+         */
+        template <typename Scanner>
+        [[nodiscard]] constexpr stl::size_t find_eol(stl::string_view data, stl::size_t pos,
+                                                     parse_status& status) noexcept {
+            auto const cr = Scanner::find(data, pos, '\r', '\n');
+            if (cr == stl::string_view::npos || cr + 1 == data.size())
+                return stl::string_view::npos;
+            if (data[cr] != '\r' || data[cr + 1] != '\n') {
+                status = parse_status::error;
+                return stl::string_view::npos;
+            }
+            return cr;
+        }
+
+        /**
+         * Tokenize the header fields in one pass; "pos" is the start of the
+         * first field and is set to the end of the empty line if the block is
+         * complete.
+         */
+        template <typename Scanner, typename View>
+        [[nodiscard]] constexpr parse_status parse_headers(stl::string_view data, stl::size_t& pos, View& req) noexcept {
+            auto status = parse_status::incomplete;
+            while (pos < data.size()) {
+                if (data[pos] == '\r') {
+                    if (pos + 1 == data.size())
+                        return parse_status::incomplete;
+                    if (data[pos + 1] != '\n')
+                        return parse_status::error;
+                    pos += 2; // the empty line
+                    return parse_status::complete;
+                }
+                auto const colon = Scanner::find(data, pos, ':', '\r');
+                if (colon == stl::string_view::npos)
+                    return parse_status::incomplete;
+                if (data[colon] != ':' || colon == pos || req.header_count == req.headers.size())
+                    return parse_status::error;
+                auto const name = data.substr(pos, colon - pos);
+                for (auto c : name)
+                    if (!is_token_char(c))
+                        return parse_status::error;
+                auto const cr = find_eol<Scanner>(data, colon + 1, status);
+                if (cr == stl::string_view::npos)
+                    return status;
+                req.headers[req.header_count++] = {name, trim_ows(data.substr(colon + 1, cr - colon - 1))};
+                pos                             = cr + 2;
+            }
+            return parse_status::incomplete;
+        }
+
+        [[nodiscard]] constexpr bool parse_request_line(stl::string_view line, auto& req) noexcept {
+            auto const sp1 = line.find(' ');
+            if (sp1 == 0 || sp1 == stl::string_view::npos)
+                return false;
+            auto const sp2 = line.find(' ', sp1 + 1);
+            if (sp2 == stl::string_view::npos || sp2 == sp1 + 1)
+                return false;
+            req.method = line.substr(0, sp1);
+            for (auto c : req.method)
+                if (!is_token_char(c))
+                    return false;
+            req.target         = line.substr(sp1 + 1, sp2 - sp1 - 1);
+            auto const version = line.substr(sp2 + 1);
+            if (version.size() != 8 || version.substr(0, 5) != "HTTP/" || version[6] != '.' || version[5] < '0' ||
+                version[5] > '9' || version[7] < '0' || version[7] > '9')
+                return false;
+            req.version_major = static_cast<uint8_t>(version[5] - '0');
+            req.version_minor = static_cast<uint8_t>(version[7] - '0');
+            return req.version_major == 1;
+        }
+
+        [[nodiscard]] constexpr bool parse_content_length(stl::string_view str, stl::size_t& len) noexcept {
+            return str.size() <= 15 && parse_integer(str, len);
+        }
+
+        /**
+         * The length of the body; if there's more than one Content-Length,
+         * they should all be the same, or it's a request that the proxies in
+         * front of us might have framed differently (RFC 9112, section 6.3)
+         */
+        template <typename View>
+        [[nodiscard]] constexpr bool content_length_of(View const& req, stl::size_t& len) noexcept {
+            bool found = false;
+            for (stl::size_t i = 0; i < req.header_count; i++) {
+                if (!iequals(req.headers[i].name, "Content-Length"))
+                    continue;
+                stl::size_t value = 0;
+                if (!parse_content_length(req.headers[i].value, value) || (found && value != len))
+                    return false;
+                len   = value;
+                found = true;
+            }
+            return true;
+        }
+
+        /**
+         * An HTTP/1.1 request should have exactly one Host (RFC 9112, section 3.2)
+         */
+        template <typename View>
+        [[nodiscard]] constexpr bool has_one_host(View const& req) noexcept {
+            if (req.version_minor == 0)
+                return true;
+            stl::size_t count = 0;
+            for (stl::size_t i = 0; i < req.header_count; i++)
+                if (iequals(req.headers[i].name, "Host"))
+                    count++;
+            return count == 1;
+        }
+
+    } // namespace details
+
+    /**
+     * Parse one request from the beginning of the data.
+     *
+     * This doesn't keep any state, so if the request is not complete, call it
+     * again with the same data plus the rest of it. If a request is complete,
+     * "consumed" is set to the number of bytes of this request, the next one
+     * (when the client is pipelining) starts right after it.
+     *
+     * The requests with a body that is bigger than the limit are rejected
+     * as soon as their headers are here, so the body is never buffered. The
+     * transfer codings (chunked, too) are not supported yet. The HTTP/1.1
+     * requests without a Host, and the ones with different Content-Lengths,
+     * are errors.
+     */
+    template <typename Scanner = default_scanner, stl::size_t MaxHeaders>
+    [[nodiscard]] constexpr parse_status parse_request(stl::string_view                data,
+                                                       basic_request_view<MaxHeaders>& req,
+                                                       stl::size_t&                    consumed,
+                                                       stl::size_t max_body_size = default_max_body_size) noexcept {
+        // RFC 7230: we should ignore at least one empty line before the request-line
+        stl::size_t skipped = 0;
+        while (data.starts_with("\r\n")) {
+            data.remove_prefix(2);
+            skipped += 2;
+        }
+
+        // a partial request that is this big is not going to end well; the
+        // empty lines count too, or a client could send them forever
+        auto const incomplete = [&]() noexcept {
+            return skipped + data.size() > max_header_block_size ? parse_status::error
+                                                                 : parse_status::incomplete;
+        };
+
+        auto       status   = parse_status::incomplete;
+        auto const line_end = details::find_eol<Scanner>(data, 0, status);
+        if (line_end == stl::string_view::npos)
+            return status == parse_status::error ? status : incomplete();
+        req.header_count = 0;
+        if (!details::parse_request_line(data.substr(0, line_end), req))
+            return parse_status::error;
+
+        stl::size_t header_end = line_end + 2;
+        status                 = details::parse_headers<Scanner>(data, header_end, req);
+        if (status == parse_status::incomplete)
+            return incomplete();
+        if (status == parse_status::error || skipped + header_end > max_header_block_size ||
+            !details::has_one_host(req))
+            return parse_status::error;
+
+        if (!req.header("Transfer-Encoding").empty())
+            return parse_status::not_implemented;
+
+        stl::size_t content_length = 0;
+        if (!details::content_length_of(req, content_length))
+            return parse_status::error;
+        if (content_length > max_body_size)
+            return parse_status::too_large;
+        if (data.size() - header_end < content_length)
+            return parse_status::incomplete;
+        req.body = data.substr(header_end, content_length);
+        consumed = skipped + header_end + content_length;
+        return parse_status::complete;
+    }
+
+} // namespace webpp::http1
+
+#endif // WEBPP_INTERFACE_HTTP1_REQUEST_PARSER_H
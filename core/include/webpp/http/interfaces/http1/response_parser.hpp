@@ -0,0 +1,194 @@
+#ifndef WEBPP_INTERFACE_HTTP1_RESPONSE_PARSER_H
+#define WEBPP_INTERFACE_HTTP1_RESPONSE_PARSER_H
+
+#include "./request_parser.hpp"
+
+#include <string>
+
+namespace webpp::http1 {
+
+    /**
+     * The status line and the headers of a parsed response; the views point
+     * into the buffer that was parsed. The body is framed by the caller (see
+     * body_framing), because it may come in any number of reads.
+     */
+    template <stl::size_t MaxHeaders = default_max_headers>
+    struct basic_response_view {
+        uint8_t                                   version_major = 1;
+        uint8_t                                   version_minor = 1;
+        unsigned                                  status        = 0;
+        stl::string_view                          reason;
+        stl::array<header_field_view, MaxHeaders> headers{};
+        stl::size_t                               header_count = 0;
+
+        [[nodiscard]] constexpr stl::string_view header(stl::string_view name) const noexcept {
+            for (stl::size_t i = 0; i < header_count; i++)
+                if (iequals(headers[i].name, name))
+                    return headers[i].value;
+            return {};
+        }
+
+        /**
+         * Whether the server keeps the connection open after this response
+         */
+        [[nodiscard]] constexpr bool keep_alive() const noexcept {
+            auto const conn = header("Connection");
+            if (version_major == 1 && version_minor >= 1)
+                return !iequals(conn, "close");
+            return iequals(conn, "keep-alive");
+        }
+    };
+
+    using response_view = basic_response_view<>;
+
+    /**
+     * How the body of a response ends
+     */
+    enum struct body_framing {
+        none,           // there's no body (HEAD, 1xx, 204, 304)
+        content_length, // it's "Content-Length" bytes
+        chunked,        // it's in chunks
+        until_close     // it's what comes until the server closes the connection
+    };
+
+    namespace details {
+
+        [[nodiscard]] constexpr bool parse_status_line(stl::string_view line, auto& res) noexcept {
+            // HTTP/1.1 200 OK
+            if (line.size() < 12 || line.substr(0, 5) != "HTTP/" || line[6] != '.' || line[8] != ' ' ||
+                line[5] < '0' || line[5] > '9' || line[7] < '0' || line[7] > '9')
+                return false;
+            res.version_major = static_cast<uint8_t>(line[5] - '0');
+            res.version_minor = static_cast<uint8_t>(line[7] - '0');
+            res.status        = 0;
+            for (stl::size_t i = 9; i < 12; i++) {
+                if (line[i] < '0' || line[i] > '9')
+                    return false;
+                res.status = res.status * 10 + static_cast<unsigned>(line[i] - '0');
+            }
+            if (line.size() > 12 && line[12] != ' ')
+                return false;
+            res.reason = line.size() > 13 ? line.substr(13) : stl::string_view{};
+            return res.version_major == 1 && res.status >= 100;
+        }
+
+        [[nodiscard]] constexpr int hex_digit(char c) noexcept {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            return -1;
+        }
+
+    } // namespace details
+
+    /**
+     * Parse the status line and the headers of a response from the beginning
+     * of the data; "head_size" is set to where the body starts.
+     */
+    template <typename Scanner = default_scanner, stl::size_t MaxHeaders>
+    [[nodiscard]] constexpr parse_status parse_response_head(stl::string_view                 data,
+                                                             basic_response_view<MaxHeaders>& res,
+                                                             stl::size_t&                     head_size) noexcept {
+        auto const incomplete = [&]() noexcept {
+            return data.size() > max_header_block_size ? parse_status::error : parse_status::incomplete;
+        };
+
+        auto       status   = parse_status::incomplete;
+        auto const line_end = details::find_eol<Scanner>(data, 0, status);
+        if (line_end == stl::string_view::npos)
+            return status == parse_status::error ? status : incomplete();
+        res.header_count = 0;
+        if (!details::parse_status_line(data.substr(0, line_end), res))
+            return parse_status::error;
+
+        head_size = line_end + 2;
+        status    = details::parse_headers<Scanner>(data, head_size, res);
+        if (status == parse_status::incomplete)
+            return incomplete();
+        if (status == parse_status::error || head_size > max_header_block_size)
+            return parse_status::error;
+        return parse_status::complete;
+    }
+
+    /**
+     * How the body of the response is framed (RFC 7230, 3.3.3); the length
+     * is set if it has a Content-Length.
+     */
+    template <stl::size_t MaxHeaders>
+    [[nodiscard]] constexpr body_framing response_framing(basic_response_view<MaxHeaders> const& res,
+                                                          bool                                   head_request,
+                                                          stl::size_t& content_length) noexcept {
+        if (head_request || res.status < 200 || res.status == 204 || res.status == 304)
+            return body_framing::none;
+        if (auto const te = res.header("Transfer-Encoding"); !te.empty()) {
+            // chunked is always the last one of the codings
+            constexpr stl::string_view chunked = "chunked";
+            return te.size() >= chunked.size() && iequals(te.substr(te.size() - chunked.size()), chunked)
+                     ? body_framing::chunked
+                     : body_framing::until_close;
+        }
+        if (auto const cl = res.header("Content-Length"); !cl.empty()) {
+            if (details::parse_content_length(cl, content_length))
+                return body_framing::content_length;
+        }
+        return body_framing::until_close;
+    }
+
+    /**
+     * Decode a chunked body from the beginning of the data into "body"; like
+     * the other parsers it keeps no state, so if it's incomplete, call it
+     * again with the same data plus the rest of it ("body" is cleared). The
+     * chunk extensions and the trailers are skipped.
+     */
+    template <typename StrT>
+    [[nodiscard]] constexpr parse_status parse_chunked_body(stl::string_view data,
+                                                            StrT&            body,
+                                                            stl::size_t&     consumed) noexcept {
+        body.clear();
+        stl::size_t pos = 0;
+        for (;;) {
+            auto const line_end = data.find("\r\n", pos);
+            if (line_end == stl::string_view::npos)
+                return parse_status::incomplete;
+            stl::size_t size   = 0;
+            stl::size_t digits = 0;
+            for (; pos + digits < line_end; digits++) {
+                auto const digit = details::hex_digit(data[pos + digits]);
+                if (digit < 0)
+                    break;
+                if (digits == 15)
+                    return parse_status::error; // too big
+                size = size * 16 + static_cast<stl::size_t>(digit);
+            }
+            if (digits == 0)
+                return parse_status::error;
+            pos = line_end + 2;
+            if (size == 0)
+                break;
+            if (data.size() - pos < size + 2)
+                return parse_status::incomplete;
+            if (data.substr(pos + size, 2) != "\r\n")
+                return parse_status::error;
+            body.append(data.data() + pos, size);
+            pos += size + 2;
+        }
+        // the trailers, up to the empty line
+        for (;;) {
+            auto const line_end = data.find("\r\n", pos);
+            if (line_end == stl::string_view::npos)
+                return parse_status::incomplete;
+            auto const empty = line_end == pos;
+            pos              = line_end + 2;
+            if (empty)
+                break;
+        }
+        consumed = pos;
+        return parse_status::complete;
+    }
+
+} // namespace webpp::http1
+
+#endif // WEBPP_INTERFACE_HTTP1_RESPONSE_PARSER_H
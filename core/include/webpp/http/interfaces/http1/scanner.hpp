@@ -0,0 +1,92 @@
+#ifndef WEBPP_INTERFACE_HTTP1_SCANNER_H
+#define WEBPP_INTERFACE_HTTP1_SCANNER_H
+
+#include "../../../std/std.hpp"
+
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#    define WEBPP_HTTP1_SCANNER_WIDTH 32
+#elif defined(__SSE2__)
+#    include <emmintrin.h>
+#    define WEBPP_HTTP1_SCANNER_WIDTH 16
+#else
+#    define WEBPP_HTTP1_SCANNER_WIDTH 1
+#endif
+
+namespace webpp::http1 {
+
+    /**
+     * The scanners find the delimiters of the request (CR, colon, space) in
+     * the receive buffer. They all have the same interface:
+     *
+     *   find(data, pos, a, b): the position of the first byte at or after
+     *                          "pos" that is either "a" or "b"; npos if
+     *                          there's none.
+     *
+     * The parser is templated on the scanner so the benchmarks can run the
+     * same parser with the scalar one.
+     */
+    struct scalar_scanner {
+        static constexpr stl::size_t width = 1;
+
+        [[nodiscard]] static constexpr stl::size_t find(stl::string_view data, stl::size_t pos, char a,
+                                                        char b) noexcept {
+            for (; pos < data.size(); pos++)
+                if (data[pos] == a || data[pos] == b)
+                    return pos;
+            return stl::string_view::npos;
+        }
+    };
+
+    /**
+     * Looks at 16 (SSE2) or 32 (AVX2) bytes at a time; which one is used is
+     * decided by the compiler flags (-mavx2 or -march=...). The tail that
+     * doesn't fill a whole register, and constant evaluation, go through the
+     * scalar scanner.
+     */
+    struct simd_scanner {
+        static constexpr stl::size_t width = WEBPP_HTTP1_SCANNER_WIDTH;
+
+        [[nodiscard]] static constexpr stl::size_t find(stl::string_view data, stl::size_t pos, char a,
+                                                        char b) noexcept {
+#if WEBPP_HTTP1_SCANNER_WIDTH > 1
+            if (!stl::is_constant_evaluated()) {
+                auto const* const begin = data.data();
+#    if WEBPP_HTTP1_SCANNER_WIDTH == 32
+                auto const va = _mm256_set1_epi8(a);
+                auto const vb = _mm256_set1_epi8(b);
+                for (; pos + width <= data.size(); pos += width) {
+                    auto const chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(begin + pos));
+                    auto const eq = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, va), _mm256_cmpeq_epi8(chunk, vb));
+                    auto const mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+                    if (mask != 0)
+                        return pos + static_cast<stl::size_t>(__builtin_ctz(mask));
+                }
+#    else
+                auto const va = _mm_set1_epi8(a);
+                auto const vb = _mm_set1_epi8(b);
+                for (; pos + width <= data.size(); pos += width) {
+                    auto const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(begin + pos));
+                    auto const eq    = _mm_or_si128(_mm_cmpeq_epi8(chunk, va), _mm_cmpeq_epi8(chunk, vb));
+                    auto const mask  = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+                    if (mask != 0)
+                        return pos + static_cast<stl::size_t>(__builtin_ctz(mask));
+                }
+#    endif
+            }
+#endif
+            return scalar_scanner::find(data, pos, a, b);
+        }
+    };
+
+    using default_scanner = simd_scanner;
+
+} // namespace webpp::http1
+
+#undef WEBPP_HTTP1_SCANNER_WIDTH
+
+#endif // WEBPP_INTERFACE_HTTP1_SCANNER_H
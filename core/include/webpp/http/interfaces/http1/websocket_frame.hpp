@@ -0,0 +1,249 @@
+#ifndef WEBPP_INTERFACE_HTTP1_WEBSOCKET_FRAME_H
+#define WEBPP_INTERFACE_HTTP1_WEBSOCKET_FRAME_H
+
+#include "../../../std/std.hpp"
+#include "../../../utils/base64.hpp"
+#include "../../../utils/sha1.hpp"
+#include "../../websocket.hpp"
+#include "./request_parser.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#    define WEBPP_WEBSOCKET_UNMASK_WIDTH 32
+#elif defined(__SSE2__)
+#    include <emmintrin.h>
+#    define WEBPP_WEBSOCKET_UNMASK_WIDTH 16
+#else
+#    define WEBPP_WEBSOCKET_UNMASK_WIDTH 1
+#endif
+
+namespace webpp::websocket {
+
+    using http1::parse_status;
+
+    struct frame_header {
+        bool                          fin    = false;
+        opcode                        op     = opcode::continuation;
+        bool                          masked = false;
+        stl::array<stl::uint8_t, 4>   mask{};
+        stl::uint64_t                 payload_size = 0;
+        stl::size_t                   header_size  = 0; // where the payload starts
+    };
+
+    [[nodiscard]] constexpr bool is_control(opcode op) noexcept {
+        return (static_cast<stl::uint8_t>(op) & 0x8u) != 0;
+    }
+
+    /**
+     * Parse the header of the frame at the beginning of the data; the
+     * extensions are not supported, so the frames with the RSV bits, or with
+     * an unknown opcode, or the control frames that are fragmented or too
+     * big, are errors.
+     */
+    [[nodiscard]] constexpr parse_status parse_frame_header(stl::string_view data, frame_header& frame) noexcept {
+        if (data.size() < 2)
+            return parse_status::incomplete;
+        auto const byte = [&](stl::size_t index) constexpr noexcept -> stl::uint8_t {
+            return static_cast<stl::uint8_t>(data[index]);
+        };
+        if ((byte(0) & 0x70u) != 0)
+            return parse_status::error;
+        frame.fin    = (byte(0) & 0x80u) != 0;
+        frame.op     = static_cast<opcode>(byte(0) & 0x0Fu);
+        frame.masked = (byte(1) & 0x80u) != 0;
+        switch (frame.op) {
+            case opcode::continuation:
+            case opcode::text:
+            case opcode::binary:
+            case opcode::close:
+            case opcode::ping:
+            case opcode::pong: break;
+            default: return parse_status::error;
+        }
+
+        stl::size_t pos  = 2;
+        auto const  size = byte(1) & 0x7Fu;
+        if (size == 126) {
+            if (data.size() < 4)
+                return parse_status::incomplete;
+            frame.payload_size = (stl::uint64_t{byte(2)} << 8u) | byte(3);
+            pos                = 4;
+        } else if (size == 127) {
+            if (data.size() < 10)
+                return parse_status::incomplete;
+            frame.payload_size = 0;
+            for (stl::size_t i = 2; i < 10; i++)
+                frame.payload_size = (frame.payload_size << 8u) | byte(i);
+            if ((frame.payload_size >> 63u) != 0)
+                return parse_status::error;
+            pos = 10;
+        } else {
+            frame.payload_size = size;
+        }
+        if (is_control(frame.op) && (!frame.fin || frame.payload_size > 125))
+            return parse_status::error;
+
+        if (frame.masked) {
+            if (data.size() < pos + 4)
+                return parse_status::incomplete;
+            for (stl::size_t i = 0; i < 4; i++)
+                frame.mask[i] = byte(pos + i);
+            pos += 4;
+        }
+        frame.header_size = pos;
+        return parse_status::complete;
+    }
+
+    /**
+     * Unmask the payload in place, one byte at a time; "offset" is the
+     * position of the data in the payload (for the payloads that are
+     * unmasked in parts).
+     */
+    constexpr void unmask_scalar(char*                              data,
+                                 stl::size_t                        size,
+                                 stl::array<stl::uint8_t, 4> const& mask,
+                                 stl::size_t                        offset = 0) noexcept {
+        for (stl::size_t i = 0; i < size; i++)
+            data[i] = static_cast<char>(static_cast<stl::uint8_t>(data[i]) ^ mask[(offset + i) % 4]);
+    }
+
+    /**
+     * Unmask the payload in place; 16 (SSE2) or 32 (AVX2) bytes at a time,
+     * and 8 bytes at a time without them. It's done right in the receive
+     * buffer, so the messages are handed to the handler without a copy.
+     */
+    inline void unmask(char* data, stl::size_t size, stl::array<stl::uint8_t, 4> const& mask, stl::size_t offset = 0) noexcept {
+        // the key, rotated to start at the offset, and repeated
+        stl::array<stl::uint8_t, 32> key{};
+        for (stl::size_t i = 0; i < key.size(); i++)
+            key[i] = mask[(offset + i) % 4];
+
+        stl::size_t pos = 0;
+#if WEBPP_WEBSOCKET_UNMASK_WIDTH == 32
+        auto const vkey = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(key.data()));
+        for (; pos + 32 <= size; pos += 32) {
+            auto* const ptr = reinterpret_cast<__m256i*>(data + pos);
+            _mm256_storeu_si256(ptr, _mm256_xor_si256(_mm256_loadu_si256(ptr), vkey));
+        }
+#elif WEBPP_WEBSOCKET_UNMASK_WIDTH == 16
+        auto const vkey = _mm_loadu_si128(reinterpret_cast<__m128i const*>(key.data()));
+        for (; pos + 16 <= size; pos += 16) {
+            auto* const ptr = reinterpret_cast<__m128i*>(data + pos);
+            _mm_storeu_si128(ptr, _mm_xor_si128(_mm_loadu_si128(ptr), vkey));
+        }
+#endif
+        stl::uint64_t key64 = 0;
+        stl::memcpy(&key64, key.data(), sizeof(key64));
+        for (; pos + 8 <= size; pos += 8) {
+            stl::uint64_t word = 0;
+            stl::memcpy(&word, data + pos, sizeof(word));
+            word ^= key64;
+            stl::memcpy(data + pos, &word, sizeof(word));
+        }
+        // the key repeats every 4 bytes, so it's at the same phase here
+        unmask_scalar(data + pos, size - pos, mask, offset + pos);
+    }
+
+    /**
+     * Append a frame that the server sends (they're not masked)
+     */
+    template <typename StrT>
+    constexpr void write_frame(StrT& out, opcode op, stl::string_view payload, bool fin = true) {
+        out.reserve(out.size() + payload.size() + 10);
+        out.push_back(static_cast<char>((fin ? 0x80u : 0u) | static_cast<stl::uint8_t>(op)));
+        if (payload.size() < 126) {
+            out.push_back(static_cast<char>(payload.size()));
+        } else if (payload.size() <= 0xFFFF) {
+            out.push_back(static_cast<char>(126));
+            out.push_back(static_cast<char>(payload.size() >> 8u));
+            out.push_back(static_cast<char>(payload.size() & 0xFFu));
+        } else {
+            out.push_back(static_cast<char>(127));
+            auto const size = static_cast<stl::uint64_t>(payload.size());
+            for (stl::size_t i = 0; i < 8; i++)
+                out.push_back(static_cast<char>((size >> (56u - i * 8u)) & 0xFFu));
+        }
+        out.append(payload.data(), payload.size());
+    }
+
+    /**
+     * Append a close frame; the reason is cut to fit into a control frame
+     */
+    template <typename StrT>
+    constexpr void write_close_frame(StrT& out, close_code code, stl::string_view reason = {}) {
+        stl::array<char, 125> payload{};
+        auto const            value = static_cast<stl::uint16_t>(code);
+        payload[0]                  = static_cast<char>(value >> 8u);
+        payload[1]                  = static_cast<char>(value & 0xFFu);
+        reason                      = reason.substr(0, payload.size() - 2);
+        for (stl::size_t i = 0; i < reason.size(); i++)
+            payload[2 + i] = reason[i];
+        write_frame(out, opcode::close, {payload.data(), reason.size() + 2});
+    }
+
+    /**
+     * The value of the Sec-WebSocket-Accept of the handshake's response
+     */
+    [[nodiscard]] constexpr stl::array<char, 28> accept_key(stl::string_view client_key) noexcept {
+        sha1 hash;
+        hash.update(client_key);
+        hash.update("258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+        auto const           digest = hash.digest();
+        stl::array<char, 20> bytes{};
+        for (stl::size_t i = 0; i < bytes.size(); i++)
+            bytes[i] = static_cast<char>(digest[i]);
+        stl::array<char, 28> res{};
+        static_cast<void>(base64::encode_scalar({bytes.data(), bytes.size()}, res.data(), res.size()));
+        return res;
+    }
+
+    /**
+     * Whether the request asks for a WebSocket (the version is checked by the
+     * one that answers it, see handshake_status).
+     */
+    template <typename RequestView>
+    [[nodiscard]] constexpr bool is_upgrade(RequestView const& req) noexcept {
+        if (req.method != "GET" || !http1::iequals(req.header("Upgrade"), "websocket"))
+            return false;
+        // "Connection: keep-alive, Upgrade"
+        auto conn = req.header("Connection");
+        while (!conn.empty()) {
+            auto const comma = conn.find(',');
+            auto       token = conn.substr(0, comma);
+            while (!token.empty() && token.front() == ' ')
+                token.remove_prefix(1);
+            while (!token.empty() && token.back() == ' ')
+                token.remove_suffix(1);
+            if (http1::iequals(token, "upgrade"))
+                return true;
+            conn = comma == stl::string_view::npos ? stl::string_view{} : conn.substr(comma + 1);
+        }
+        return false;
+    }
+
+    /**
+     * The status of the answer to an upgrade request: 101 if it can be
+     * upgraded, 426 if it's not the version 13, and 400 if the key is not valid.
+     */
+    template <typename RequestView>
+    [[nodiscard]] constexpr unsigned handshake_status(RequestView const& req) noexcept {
+        if (req.header("Sec-WebSocket-Version") != "13")
+            return 426;
+        // it's 16 random bytes in base64
+        auto const key = req.header("Sec-WebSocket-Key");
+        if (key.size() != 24 || key.substr(22) != "==")
+            return 400;
+        return 101;
+    }
+
+} // namespace webpp::websocket
+
+#undef WEBPP_WEBSOCKET_UNMASK_WIDTH
+
+#endif // WEBPP_INTERFACE_HTTP1_WEBSOCKET_FRAME_H
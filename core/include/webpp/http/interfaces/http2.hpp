@@ -0,0 +1,309 @@
+#ifndef WEBPP_INTERFACE_HTTP2_H
+#define WEBPP_INTERFACE_HTTP2_H
+
+#include "../../std/internet.hpp"
+#include "../../std/set.hpp"
+#include "../../std/vector.hpp"
+#include "../../traits/std_arena_traits.hpp"
+#include "../../traits/std_traits.hpp"
+#include "../../utils/task.hpp"
+#include "../application_concepts.hpp"
+#include "../request.hpp"
+#include "./common/server.hpp"
+#include "./common/task_link.hpp"
+#include "./http2/session.hpp"
+
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace webpp {
+
+    /**
+     * A standalone HTTP/2 server (h2c with prior knowledge).
+     *
+     * The streams of a connection are multiplexed onto the application; each
+     * complete request is passed to the application and its response is sent
+     * on its own stream, so a slow download doesn't block the other requests
+     * of that connection.
+     *
+     * The application is called from the worker threads, so if you set the
+     * concurrency to more than one, the application should be thread-safe.
+     */
+    template <Traits TraitsType, Application App>
+    struct http2_server {
+      public:
+        using traits_type      = TraitsType;
+        using application_type = App;
+        using interface_type   = http2_server<traits_type, application_type>;
+        using endpoint_t       = stl::net::ip::tcp::endpoint;
+
+        application_type app;
+
+      private:
+        istl::set<traits_type, endpoint_t> _endpoints;
+        stl::optional<common::server>      _server;
+        stl::size_t                        _concurrency = 1;
+        stl::size_t                        _max_body_size = default_max_body_size;
+
+      public:
+        /**
+         * Call the application for a complete request, and send the response
+         */
+        void serve(http2::session& session, http2::stream& stream) noexcept {
+            serve_in_request_arena<traits_type>([&]() noexcept {
+                // the request type is named here and not as a member alias because
+                // checking the Interface concept needs this class to be complete
+                using request_type = basic_request<traits_type, interface_type>;
+                request_type req{stream, session.remote_address()};
+                auto         res = app(req);
+                respond(session, stream, res);
+            });
+        }
+
+        /**
+         * Start the task of a complete request (the application is a
+         * coroutine); the stream is copied, since the client can reset it
+         * while the task is waiting. The response is sent on the connection's
+         * thread when it's done, unless the connection is closed by then; the
+         * session drops it if the stream is reset. The session is where the
+         * connection's data handler keeps it. The tasks are not served in the
+         * request arena, since the arena is reset before they're done.
+         */
+        void serve_task(common::task_link const& tasks, http2::session& session, http2::stream& stream) noexcept {
+            using request_type = basic_request<traits_type, interface_type>;
+            struct in_flight {
+                http2::stream               source;
+                stl::string                 remote_address;
+                stl::optional<request_type> req{};
+            };
+            auto flight            = stl::make_shared<in_flight>();
+            flight->source         = stream;
+            flight->remote_address = session.remote_address();
+            flight->req.emplace(flight->source, tasks.token(), flight->remote_address);
+            auto result = app(*flight->req);
+            stl::move(result).start([this, &session, flight, link = tasks](auto res) mutable noexcept {
+                link.post([this, &session, flight = stl::move(flight), res = stl::move(res)](
+                            common::connection& conn) mutable noexcept {
+                    // the session lives as long as the connection is open
+                    respond(session, flight->source, res);
+                    queue_output(conn, session);
+                });
+            });
+        }
+
+        /**
+         * Send the response on the stream
+         */
+        template <typename ResponseType>
+        static void respond(http2::session& session, http2::stream const& stream, ResponseType& res) noexcept {
+            res.calculate_default_headers();
+            res.calculate_date_header();
+
+            // the body of the responses to the HEAD requests are not sent
+            auto const status = res.header.status_code;
+            if (stream.method() == "HEAD") {
+                session.respond(stream.id, status, res.header);
+            } else {
+                session.respond(stream.id, status, res.header, stl::string{res.body.str()});
+            }
+            recycle_response(stl::move(res));
+        }
+
+        /**
+         * Feed the session with the data that is read from the connection,
+         * and queue what it has to say.
+         */
+        static void handle(common::connection& conn, http2::session& session, stl::string_view data) noexcept {
+            if (session.remote_address().empty())
+                session.remote_address(conn.remote_address());
+            auto const ok = session.feed(data);
+            if (ok && conn.is_draining())
+                session.shutdown(); // the open streams are finished, no new ones
+            queue_output(conn, session, ok);
+        }
+
+        /**
+         * Same as above, for the coroutine applications; the tasks of the
+         * streams are cancelled when the connection is closed.
+         */
+        static void handle(common::connection& conn,
+                           http2::session&     session,
+                           common::task_link&  tasks,
+                           stl::string_view    data) noexcept {
+            tasks.attach(conn);
+            handle(conn, session, data);
+        }
+
+        /**
+         * Queue what the session has to say, and close the connection if it's
+         * done (or if the client has broken the protocol)
+         */
+        static void queue_output(common::connection& conn, http2::session& session, bool ok = true) noexcept {
+            if (session.has_output())
+                conn.send(session.take_output());
+            if (!ok || session.should_close()) {
+                conn.close_after_write();
+            } else {
+                conn.busy(session.stream_count() != 0);
+            }
+        }
+
+        void operator()() noexcept {
+            stl::vector<endpoint_t> endpoints{_endpoints.begin(), _endpoints.end()};
+            if (endpoints.empty()) {
+                istl::net_error_code ec;
+                auto const           address = stl::net::ip::make_address(default_self_hosted_listen_addr, ec);
+                endpoints.emplace_back(ec ? stl::net::ip::address_v4::loopback() : address,
+                                       static_cast<unsigned short>(default_self_hosted_listen_port));
+            }
+            _server.emplace(endpoints, default_max_connections, _concurrency);
+            _server->on_connection([this] {
+                using request_type = basic_request<traits_type, interface_type>;
+                if constexpr (Task<decltype(app(stl::declval<request_type&>()))>) {
+                    common::task_link tasks;
+                    http2::session    session{[this, tasks](http2::session& s, http2::stream& stream) {
+                                               serve_task(tasks, s, stream);
+                                           },
+                                           _max_body_size};
+                    return [session = stl::move(session), tasks](common::connection& conn,
+                                                                 stl::string_view    data) mutable noexcept {
+                        handle(conn, session, tasks, data);
+                    };
+                } else {
+                    http2::session session{[this](http2::session& s, http2::stream& stream) {
+                                               serve(s, stream);
+                                           },
+                                           _max_body_size};
+                    return [session = stl::move(session)](common::connection& conn,
+                                                          stl::string_view    data) mutable noexcept {
+                        handle(conn, session, data);
+                    };
+                }
+            });
+            _server->run();
+        }
+
+        /**
+         * This will only work before you run the operator()
+         */
+        void add_endpoint(endpoint_t _endpoint) noexcept {
+            _endpoints.insert(stl::move(_endpoint));
+        }
+
+        /**
+         * This will only work before you run the operator()
+         */
+        void add_endpoint(stl::string_view const& addr, uint_fast16_t port) noexcept {
+            istl::net_error_code ec;
+            auto const           address = stl::net::ip::make_address(addr, ec);
+            if (!ec)
+                _endpoints.emplace(address, port);
+        }
+
+        /**
+         * The number of worker threads; zero means one per core.
+         * This will only work before you run the operator()
+         */
+        void concurrency(stl::size_t count) noexcept {
+            _concurrency = count;
+        }
+
+        /**
+         * The biggest request body; the bigger ones are answered with a 413.
+         * This will only work before you run the operator()
+         */
+        void max_body_size(stl::size_t size) noexcept {
+            _max_body_size = size;
+        }
+
+        /**
+         * Stop the server that is running in operator()
+         */
+        void stop() noexcept {
+            if (_server)
+                _server->stop();
+        }
+    };
+
+    /**
+     * The request of the HTTP/2 server; it holds a reference to the stream
+     * (and a view of the session's address of the client), so it's only
+     * valid while the application is handling it. The requests of the tasks
+     * refer to their own copy, and hold the token of their connection.
+     */
+    template <Traits TraitsType, Application App>
+    struct basic_request<TraitsType, http2_server<TraitsType, App>>
+      : public request_body_parsers<basic_request<TraitsType, http2_server<TraitsType, App>>> {
+        using traits_type      = TraitsType;
+        using interface_type   = http2_server<TraitsType, App>;
+        using string_view_type = typename traits_type::string_view_type;
+
+      private:
+        http2::stream const& stream;
+        cancellation_token   token{};
+        string_view_type     remote{};
+
+      public:
+        basic_request(http2::stream const& _stream, string_view_type _remote = {}) noexcept
+          : stream{_stream},
+            remote{_remote} {
+        }
+
+        basic_request(http2::stream const& _stream,
+                      cancellation_token   _token,
+                      string_view_type     _remote = {}) noexcept
+          : stream{_stream},
+            token{stl::move(_token)},
+            remote{_remote} {
+        }
+
+        /**
+         * It's cancelled when the client goes away (see basic_context::cancellation)
+         */
+        [[nodiscard]] cancellation_token const& cancellation() const noexcept {
+            return token;
+        }
+
+        [[nodiscard]] string_view_type request_method() const noexcept {
+            return stream.method();
+        }
+
+        [[nodiscard]] string_view_type request_uri() const noexcept {
+            return stream.path();
+        }
+
+        [[nodiscard]] string_view_type server_protocol() const noexcept {
+            return "HTTP/2.0";
+        }
+
+        /**
+         * The address of the client, without the port (REMOTE_ADDR in CGI)
+         */
+        [[nodiscard]] string_view_type remote_address() const noexcept {
+            return remote;
+        }
+
+        [[nodiscard]] string_view_type request_scheme() const noexcept {
+            return stream.scheme();
+        }
+
+        /**
+         * Get a specific header by it's name; ":authority" is what "Host" is
+         * in HTTP/1.1, so that's given if you ask for the host.
+         */
+        [[nodiscard]] string_view_type header(string_view_type name) const noexcept {
+            auto const value = stream.header(name);
+            if (value.empty() && http2::hpack::details::equals_lower(name, "host"))
+                return stream.authority();
+            return value;
+        }
+
+        [[nodiscard]] string_view_type body() const noexcept {
+            return stream.body;
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_INTERFACE_HTTP2_H
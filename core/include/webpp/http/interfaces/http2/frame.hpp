@@ -0,0 +1,169 @@
+#ifndef WEBPP_INTERFACE_HTTP2_FRAME_H
+#define WEBPP_INTERFACE_HTTP2_FRAME_H
+
+#include "../../../std/std.hpp"
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/**
+ * The framing layer of HTTP/2 (RFC 7540 Section 4 and 6)
+ */
+namespace webpp::http2 {
+
+    /**
+     * The client sends this before anything else
+     */
+    constexpr stl::string_view connection_preface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+    constexpr stl::size_t frame_header_length = 9;
+
+    // we never receive nor send frames that are bigger than this; it's the
+    // initial value of SETTINGS_MAX_FRAME_SIZE and we don't raise it
+    constexpr stl::size_t default_max_frame_size = 16384;
+
+    constexpr uint32_t default_initial_window_size = 65535;
+    constexpr uint32_t max_window_size             = 0x7FFFFFFF;
+
+    enum struct frame_type : uint8_t {
+        data          = 0x0,
+        headers       = 0x1,
+        priority      = 0x2,
+        rst_stream    = 0x3,
+        settings      = 0x4,
+        push_promise  = 0x5,
+        ping          = 0x6,
+        goaway        = 0x7,
+        window_update = 0x8,
+        continuation  = 0x9
+    };
+
+    namespace flags {
+        constexpr uint8_t end_stream  = 0x1;
+        constexpr uint8_t ack         = 0x1; // SETTINGS and PING
+        constexpr uint8_t end_headers = 0x4;
+        constexpr uint8_t padded      = 0x8;
+        constexpr uint8_t priority    = 0x20;
+    } // namespace flags
+
+    enum struct error_code : uint32_t {
+        no_error            = 0x0,
+        protocol_error      = 0x1,
+        internal_error      = 0x2,
+        flow_control_error  = 0x3,
+        settings_timeout    = 0x4,
+        stream_closed       = 0x5,
+        frame_size_error    = 0x6,
+        refused_stream      = 0x7,
+        cancel              = 0x8,
+        compression_error   = 0x9,
+        connect_error       = 0xa,
+        enhance_your_calm   = 0xb,
+        inadequate_security = 0xc,
+        http_1_1_required   = 0xd
+    };
+
+    enum struct settings_id : uint16_t {
+        header_table_size      = 0x1,
+        enable_push            = 0x2,
+        max_concurrent_streams = 0x3,
+        initial_window_size    = 0x4,
+        max_frame_size         = 0x5,
+        max_header_list_size   = 0x6
+    };
+
+    struct frame_header {
+        uint32_t   length    = 0; // 24 bits
+        frame_type type      = frame_type::data;
+        uint8_t    flags     = 0;
+        uint32_t   stream_id = 0; // 31 bits
+
+        [[nodiscard]] constexpr bool has(uint8_t flag) const noexcept {
+            return (flags & flag) != 0;
+        }
+
+        /**
+         * Read the header from the first 9 bytes of the data
+         */
+        [[nodiscard]] static constexpr frame_header parse(stl::string_view data) noexcept {
+            auto const byte = [&](stl::size_t i) constexpr noexcept {
+                return static_cast<uint32_t>(static_cast<uint8_t>(data[i]));
+            };
+            frame_header header;
+            header.length    = (byte(0) << 16u) | (byte(1) << 8u) | byte(2);
+            header.type      = static_cast<frame_type>(byte(3));
+            header.flags     = static_cast<uint8_t>(byte(4));
+            header.stream_id = ((byte(5) & 0x7Fu) << 24u) | (byte(6) << 16u) | (byte(7) << 8u) | byte(8);
+            return header;
+        }
+
+        void serialize(stl::string& out) const noexcept {
+            char const bytes[frame_header_length] = {static_cast<char>(length >> 16u),
+                                                     static_cast<char>(length >> 8u),
+                                                     static_cast<char>(length),
+                                                     static_cast<char>(type),
+                                                     static_cast<char>(flags),
+                                                     static_cast<char>((stream_id >> 24u) & 0x7Fu),
+                                                     static_cast<char>(stream_id >> 16u),
+                                                     static_cast<char>(stream_id >> 8u),
+                                                     static_cast<char>(stream_id)};
+            out.append(bytes, frame_header_length);
+        }
+    };
+
+    /**
+     * Read a big-endian 32bit number
+     */
+    [[nodiscard]] constexpr uint32_t read_uint32(stl::string_view data) noexcept {
+        return (static_cast<uint32_t>(static_cast<uint8_t>(data[0])) << 24u) |
+               (static_cast<uint32_t>(static_cast<uint8_t>(data[1])) << 16u) |
+               (static_cast<uint32_t>(static_cast<uint8_t>(data[2])) << 8u) |
+               static_cast<uint32_t>(static_cast<uint8_t>(data[3]));
+    }
+
+    inline void append_uint32(stl::string& out, uint32_t value) noexcept {
+        char const bytes[4] = {static_cast<char>(value >> 24u),
+                               static_cast<char>(value >> 16u),
+                               static_cast<char>(value >> 8u),
+                               static_cast<char>(value)};
+        out.append(bytes, 4);
+    }
+
+    inline void append_frame(stl::string& out, frame_type type, uint8_t frame_flags, uint32_t stream_id,
+                             stl::string_view payload) noexcept {
+        frame_header{static_cast<uint32_t>(payload.size()), type, frame_flags, stream_id}.serialize(out);
+        out.append(payload);
+    }
+
+    inline void append_settings(stl::string&                                           out,
+                                stl::initializer_list<stl::pair<settings_id, uint32_t>> settings) noexcept {
+        frame_header{static_cast<uint32_t>(settings.size() * 6), frame_type::settings, 0, 0}.serialize(out);
+        for (auto const& [id, value] : settings) {
+            out.push_back(static_cast<char>(static_cast<uint16_t>(id) >> 8u));
+            out.push_back(static_cast<char>(id));
+            append_uint32(out, value);
+        }
+    }
+
+    inline void append_window_update(stl::string& out, uint32_t stream_id, uint32_t increment) noexcept {
+        frame_header{4, frame_type::window_update, 0, stream_id}.serialize(out);
+        append_uint32(out, increment);
+    }
+
+    inline void append_rst_stream(stl::string& out, uint32_t stream_id, error_code code) noexcept {
+        frame_header{4, frame_type::rst_stream, 0, stream_id}.serialize(out);
+        append_uint32(out, static_cast<uint32_t>(code));
+    }
+
+    inline void append_goaway(stl::string& out, uint32_t last_stream_id, error_code code) noexcept {
+        frame_header{8, frame_type::goaway, 0, 0}.serialize(out);
+        append_uint32(out, last_stream_id & 0x7FFFFFFFu);
+        append_uint32(out, static_cast<uint32_t>(code));
+    }
+
+} // namespace webpp::http2
+
+#endif // WEBPP_INTERFACE_HTTP2_FRAME_H
@@ -0,0 +1,569 @@
+#ifndef WEBPP_INTERFACE_HTTP2_HPACK_H
+#define WEBPP_INTERFACE_HTTP2_HPACK_H
+
+#include "../../../std/std.hpp"
+#include "../../../utils/strings.hpp"
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+
+/**
+ * HPACK: Header Compression for HTTP/2 (RFC 7541)
+ *
+ * The decoder keeps the dynamic table that the client builds. The encoder
+ * never adds anything to the client's table, so it has no state: the header
+ * fields that are in the static table are sent as an index (":status: 200")
+ * or as a literal with an indexed name ("content-type: ..."), and the rest
+ * as literals. The encoded block is appended to a string that the caller
+ * owns and reuses, so encoding a response doesn't allocate after the first
+ * few responses.
+ */
+namespace webpp::http2::hpack {
+
+    constexpr stl::size_t default_header_table_size = 4096;
+
+    // the size of an entry is the length of its name and value plus 32
+    constexpr stl::size_t entry_overhead = 32;
+
+    struct header_view {
+        stl::string_view name;
+        stl::string_view value;
+    };
+
+    /**
+     * The static table (RFC 7541 Appendix A); the indices start at 1 so the
+     * entry at index i is static_table[i - 1].
+     */
+    constexpr stl::array<header_view, 61> static_table{{
+        {":authority", ""},                   // 1
+        {":method", "GET"},                   // 2
+        {":method", "POST"},                  // 3
+        {":path", "/"},                       // 4
+        {":path", "/index.html"},             // 5
+        {":scheme", "http"},                  // 6
+        {":scheme", "https"},                 // 7
+        {":status", "200"},                   // 8
+        {":status", "204"},                   // 9
+        {":status", "206"},                   // 10
+        {":status", "304"},                   // 11
+        {":status", "400"},                   // 12
+        {":status", "404"},                   // 13
+        {":status", "500"},                   // 14
+        {"accept-charset", ""},               // 15
+        {"accept-encoding", "gzip, deflate"}, // 16
+        {"accept-language", ""},              // 17
+        {"accept-ranges", ""},                // 18
+        {"accept", ""},                       // 19
+        {"access-control-allow-origin", ""},  // 20
+        {"age", ""},                          // 21
+        {"allow", ""},                        // 22
+        {"authorization", ""},                // 23
+        {"cache-control", ""},                // 24
+        {"content-disposition", ""},          // 25
+        {"content-encoding", ""},             // 26
+        {"content-language", ""},             // 27
+        {"content-length", ""},               // 28
+        {"content-location", ""},             // 29
+        {"content-range", ""},                // 30
+        {"content-type", ""},                 // 31
+        {"cookie", ""},                       // 32
+        {"date", ""},                         // 33
+        {"etag", ""},                         // 34
+        {"expect", ""},                       // 35
+        {"expires", ""},                      // 36
+        {"from", ""},                         // 37
+        {"host", ""},                         // 38
+        {"if-match", ""},                     // 39
+        {"if-modified-since", ""},            // 40
+        {"if-none-match", ""},                // 41
+        {"if-range", ""},                     // 42
+        {"if-unmodified-since", ""},          // 43
+        {"last-modified", ""},                // 44
+        {"link", ""},                         // 45
+        {"location", ""},                     // 46
+        {"max-forwards", ""},                 // 47
+        {"proxy-authenticate", ""},           // 48
+        {"proxy-authorization", ""},          // 49
+        {"range", ""},                        // 50
+        {"referer", ""},                      // 51
+        {"refresh", ""},                      // 52
+        {"retry-after", ""},                  // 53
+        {"server", ""},                       // 54
+        {"set-cookie", ""},                   // 55
+        {"strict-transport-security", ""},    // 56
+        {"transfer-encoding", ""},            // 57
+        {"user-agent", ""},                   // 58
+        {"vary", ""},                         // 59
+        {"via", ""},                          // 60
+        {"www-authenticate", ""},             // 61
+    }};
+
+    struct huffman_code {
+        uint32_t code;
+        uint8_t  bits;
+    };
+
+    /**
+     * The Huffman code (RFC 7541 Appendix B); the last one is EOS.
+     * It's a canonical Huffman code, so the decoding table is built from the
+     * lengths alone.
+     */
+    constexpr stl::array<huffman_code, 257> huffman_codes{{
+        {0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28},
+        {0xfffffe4, 28}, {0xfffffe5, 28}, {0xfffffe6, 28}, {0xfffffe7, 28},
+        {0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28},
+        {0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28},
+        {0xfffffed, 28}, {0xfffffee, 28}, {0xfffffef, 28}, {0xffffff0, 28},
+        {0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},
+        {0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28},
+        {0xffffff8, 28}, {0xffffff9, 28}, {0xffffffa, 28}, {0xffffffb, 28},
+        {0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12},
+        {0x1ff9, 13}, {0x15, 6}, {0xf8, 8}, {0x7fa, 11},
+        {0x3fa, 10}, {0x3fb, 10}, {0xf9, 8}, {0x7fb, 11},
+        {0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6},
+        {0x0, 5}, {0x1, 5}, {0x2, 5}, {0x19, 6},
+        {0x1a, 6}, {0x1b, 6}, {0x1c, 6}, {0x1d, 6},
+        {0x1e, 6}, {0x1f, 6}, {0x5c, 7}, {0xfb, 8},
+        {0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10},
+        {0x1ffa, 13}, {0x21, 6}, {0x5d, 7}, {0x5e, 7},
+        {0x5f, 7}, {0x60, 7}, {0x61, 7}, {0x62, 7},
+        {0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7},
+        {0x67, 7}, {0x68, 7}, {0x69, 7}, {0x6a, 7},
+        {0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7},
+        {0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7},
+        {0xfc, 8}, {0x73, 7}, {0xfd, 8}, {0x1ffb, 13},
+        {0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},
+        {0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5},
+        {0x24, 6}, {0x5, 5}, {0x25, 6}, {0x26, 6},
+        {0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7},
+        {0x28, 6}, {0x29, 6}, {0x2a, 6}, {0x7, 5},
+        {0x2b, 6}, {0x76, 7}, {0x2c, 6}, {0x8, 5},
+        {0x9, 5}, {0x2d, 6}, {0x77, 7}, {0x78, 7},
+        {0x79, 7}, {0x7a, 7}, {0x7b, 7}, {0x7ffe, 15},
+        {0x7fc, 11}, {0x3ffd, 14}, {0x1ffd, 13}, {0xffffffc, 28},
+        {0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20},
+        {0x3fffd3, 22}, {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23},
+        {0x3fffd6, 22}, {0x7fffda, 23}, {0x7fffdb, 23}, {0x7fffdc, 23},
+        {0x7fffdd, 23}, {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23},
+        {0xffffec, 24}, {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23},
+        {0xffffee, 24}, {0x7fffe1, 23}, {0x7fffe2, 23}, {0x7fffe3, 23},
+        {0x7fffe4, 23}, {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23},
+        {0x3fffd9, 22}, {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24},
+        {0x3fffda, 22}, {0x1fffdd, 21}, {0xfffe9, 20}, {0x3fffdb, 22},
+        {0x3fffdc, 22}, {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21},
+        {0x7fffea, 23}, {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24},
+        {0x1fffdf, 21}, {0x3fffdf, 22}, {0x7fffeb, 23}, {0x7fffec, 23},
+        {0x1fffe0, 21}, {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21},
+        {0x7fffed, 23}, {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23},
+        {0xfffea, 20}, {0x3fffe2, 22}, {0x3fffe3, 22}, {0x3fffe4, 22},
+        {0x7ffff0, 23}, {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23},
+        {0x3ffffe0, 26}, {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19},
+        {0x3fffe7, 22}, {0x7ffff2, 23}, {0x3fffe8, 22}, {0x1ffffec, 25},
+        {0x3ffffe2, 26}, {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27},
+        {0x7ffffdf, 27}, {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25},
+        {0x7fff2, 19}, {0x1fffe3, 21}, {0x3ffffe6, 26}, {0x7ffffe0, 27},
+        {0x7ffffe1, 27}, {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24},
+        {0x1fffe4, 21}, {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26},
+        {0xffffffd, 28}, {0x7ffffe3, 27}, {0x7ffffe4, 27}, {0x7ffffe5, 27},
+        {0xfffec, 20}, {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21},
+        {0x3fffe9, 22}, {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23},
+        {0x3fffea, 22}, {0x3fffeb, 22}, {0x1ffffee, 25}, {0x1ffffef, 25},
+        {0xfffff4, 24}, {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23},
+        {0x3ffffeb, 26}, {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26},
+        {0x7ffffe7, 27}, {0x7ffffe8, 27}, {0x7ffffe9, 27}, {0x7ffffea, 27},
+        {0x7ffffeb, 27}, {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27},
+        {0x7ffffee, 27}, {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26},
+        {0x3fffffff, 30},
+    }};
+
+    namespace details {
+
+        constexpr stl::size_t huffman_eos         = 256;
+        constexpr uint8_t     huffman_min_bits    = 5;
+        constexpr uint8_t     huffman_max_bits    = 30;
+        constexpr uint8_t     huffman_lengths_end = huffman_max_bits + 1;
+
+        struct huffman_decode_table {
+            // the codes of length "l" are in [first[l], first[l] + count) and
+            // in left-justified form (in a 32bit window) all of them are
+            // less than limit[l]
+            stl::array<uint64_t, huffman_lengths_end> limit{};
+            stl::array<uint32_t, huffman_lengths_end> first{};
+            stl::array<uint16_t, huffman_lengths_end> offset{};  // the first symbol of length "l" in symbols
+            stl::array<uint16_t, 257>                 symbols{}; // sorted by (length, symbol)
+        };
+
+        [[nodiscard]] constexpr huffman_decode_table make_huffman_decode_table() noexcept {
+            huffman_decode_table table;
+            uint16_t             index = 0;
+            uint32_t             code  = 0;
+            for (uint8_t len = huffman_min_bits; len <= huffman_max_bits; len++) {
+                table.first[len]  = code;
+                table.offset[len] = index;
+                for (stl::size_t sym = 0; sym < huffman_codes.size(); sym++) {
+                    if (huffman_codes[sym].bits == len) {
+                        table.symbols[index++] = static_cast<uint16_t>(sym);
+                        code++;
+                    }
+                }
+                table.limit[len] = static_cast<uint64_t>(code) << (32u - len);
+                code <<= 1u;
+            }
+            return table;
+        }
+
+        constexpr huffman_decode_table huffman_table = make_huffman_decode_table();
+
+        [[nodiscard]] constexpr char to_lower(char c) noexcept {
+            return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+        }
+
+        /**
+         * Compare a header name with a lowercase name from the static table
+         */
+        [[nodiscard]] constexpr bool equals_lower(stl::string_view name, stl::string_view lower) noexcept {
+            if (name.size() != lower.size())
+                return false;
+            for (stl::size_t i = 0; i < name.size(); i++)
+                if (to_lower(name[i]) != lower[i])
+                    return false;
+            return true;
+        }
+
+    } // namespace details
+
+    /**
+     * Decode a Huffman encoded string and append it to "out".
+     * @returns false if it's not a valid encoding (EOS, or bad padding)
+     */
+    inline bool huffman_decode(stl::string_view in, stl::string& out) noexcept {
+        auto const& table = details::huffman_table;
+
+        uint64_t acc  = 0; // left-justified
+        unsigned bits = 0;
+        auto     it   = in.begin();
+        while (true) {
+            for (; bits <= 56 && it != in.end(); bits += 8)
+                acc |= static_cast<uint64_t>(static_cast<uint8_t>(*it++)) << (56u - bits);
+            if (bits == 0)
+                return true;
+            auto const window = acc >> 32u;
+            auto       len    = details::huffman_min_bits;
+            while (len <= details::huffman_max_bits && window >= table.limit[len])
+                len++;
+            if (len > bits) {
+                // the padding: less than 8 bits, all ones (the prefix of EOS)
+                return bits < 8 && (acc >> (64u - bits)) == (1u << bits) - 1u;
+            }
+            auto const index =
+              table.offset[len] + ((static_cast<uint32_t>(window) >> (32u - len)) - table.first[len]);
+            auto const symbol = table.symbols[index];
+            if (symbol == details::huffman_eos)
+                return false;
+            out.push_back(static_cast<char>(symbol));
+            acc <<= len;
+            bits -= len;
+        }
+    }
+
+    /**
+     * The size of the Huffman encoding of the string in bytes
+     */
+    [[nodiscard]] constexpr stl::size_t huffman_encoded_size(stl::string_view str, bool lower = false) noexcept {
+        stl::size_t bits = 0;
+        for (auto c : str)
+            bits += huffman_codes[static_cast<uint8_t>(lower ? details::to_lower(c) : c)].bits;
+        return (bits + 7) / 8;
+    }
+
+    inline void huffman_encode(stl::string_view str, stl::string& out, bool lower = false) noexcept {
+        uint64_t acc  = 0;
+        unsigned bits = 0;
+        for (auto c : str) {
+            auto const& code = huffman_codes[static_cast<uint8_t>(lower ? details::to_lower(c) : c)];
+            acc              = (acc << code.bits) | code.code;
+            bits += code.bits;
+            for (; bits >= 8; bits -= 8)
+                out.push_back(static_cast<char>(acc >> (bits - 8)));
+        }
+        if (bits != 0) // pad with the most significant bits of EOS
+            out.push_back(static_cast<char>((acc << (8 - bits)) | (0xFFu >> bits)));
+    }
+
+    /**
+     * Append an integer with an N-bit prefix; the rest of the first byte is
+     * taken from "flags".
+     */
+    inline void encode_integer(stl::string& out, uint8_t flags, uint8_t prefix_bits, stl::size_t value) noexcept {
+        auto const max_prefix = static_cast<stl::size_t>((1u << prefix_bits) - 1u);
+        if (value < max_prefix) {
+            out.push_back(static_cast<char>(flags | value));
+            return;
+        }
+        out.push_back(static_cast<char>(flags | max_prefix));
+        value -= max_prefix;
+        for (; value >= 128; value >>= 7u)
+            out.push_back(static_cast<char>((value & 0x7Fu) | 0x80u));
+        out.push_back(static_cast<char>(value));
+    }
+
+    /**
+     * Read an integer with an N-bit prefix
+     * @returns false if the data is truncated or the number is too big
+     */
+    inline bool decode_integer(uint8_t const*& it, uint8_t const* end, uint8_t prefix_bits,
+                               stl::size_t& value) noexcept {
+        if (it == end)
+            return false;
+        auto const max_prefix = static_cast<stl::size_t>((1u << prefix_bits) - 1u);
+        value                 = *it++ & max_prefix;
+        if (value < max_prefix)
+            return true;
+        for (unsigned shift = 0; shift <= 28; shift += 7) {
+            if (it == end)
+                return false;
+            auto const byte = *it++;
+            value += static_cast<stl::size_t>(byte & 0x7Fu) << shift;
+            if ((byte & 0x80u) == 0)
+                return true;
+        }
+        return false; // we don't need anything bigger than 2^32 anyway
+    }
+
+    /**
+     * Append a string literal; it's Huffman encoded if that's shorter.
+     * The names are lowercased because HTTP/2 requires lowercase names.
+     */
+    inline void encode_string(stl::string& out, stl::string_view str, bool lower = false) noexcept {
+        auto const huffman_size = huffman_encoded_size(str, lower);
+        if (huffman_size < str.size()) {
+            encode_integer(out, 0x80, 7, huffman_size);
+            huffman_encode(str, out, lower);
+            return;
+        }
+        encode_integer(out, 0, 7, str.size());
+        out.append(str);
+        if (lower)
+            ascii_to_lower(out.data() + out.size() - str.size(), str.size());
+    }
+
+    /**
+     * Find the header in the static table.
+     * @returns the index of the entry (zero if there's none), and sets
+     *          "exact" if the value matches too.
+     */
+    [[nodiscard]] constexpr stl::size_t find_static(stl::string_view name, stl::string_view value,
+                                                    bool& exact) noexcept {
+        stl::size_t found = 0;
+        exact             = false;
+        for (stl::size_t i = 0; i < static_table.size(); i++) {
+            if (!details::equals_lower(name, static_table[i].name))
+                continue;
+            if (static_table[i].value == value) {
+                exact = true;
+                return i + 1;
+            }
+            if (found == 0)
+                found = i + 1;
+        }
+        return found;
+    }
+
+    /**
+     * Append the encoding of a header field to the header block.
+     * The dynamic table is never used, so this doesn't need any state.
+     */
+    inline void encode_header(stl::string& out, stl::string_view name, stl::string_view value) noexcept {
+        bool       exact = false;
+        auto const index = find_static(name, value, exact);
+        if (exact) {
+            encode_integer(out, 0x80, 7, index); // indexed header field
+            return;
+        }
+        // literal header field without indexing
+        encode_integer(out, 0, 4, index);
+        if (index == 0)
+            encode_string(out, name, true);
+        encode_string(out, value);
+    }
+
+    /**
+     * Append the ":status" pseudo-header; the common ones are in the static
+     * table and take one byte.
+     */
+    inline void encode_status(stl::string& out, unsigned status) noexcept {
+        switch (status) {
+            case 200: out.push_back(static_cast<char>(0x80 | 8)); return;
+            case 204: out.push_back(static_cast<char>(0x80 | 9)); return;
+            case 206: out.push_back(static_cast<char>(0x80 | 10)); return;
+            case 304: out.push_back(static_cast<char>(0x80 | 11)); return;
+            case 400: out.push_back(static_cast<char>(0x80 | 12)); return;
+            case 404: out.push_back(static_cast<char>(0x80 | 13)); return;
+            case 500: out.push_back(static_cast<char>(0x80 | 14)); return;
+            default: break;
+        }
+        char digits[3] = {static_cast<char>('0' + status / 100 % 10),
+                          static_cast<char>('0' + status / 10 % 10),
+                          static_cast<char>('0' + status % 10)};
+        encode_integer(out, 0, 4, 8); // the name of ":status"
+        encode_integer(out, 0, 7, 3);
+        out.append(digits, 3);
+    }
+
+    /**
+     * Decodes the header blocks of one connection; the dynamic table lives
+     * as long as the connection.
+     */
+    class decoder {
+        struct entry {
+            stl::string name;
+            stl::string value;
+        };
+
+        stl::deque<entry> table; // the newest entry is at the front
+        stl::size_t       table_size     = 0;
+        stl::size_t       max_table_size = default_header_table_size;
+        stl::size_t       settings_limit = default_header_table_size; // what we've told the client
+
+        // the Huffman decoded strings; reused for each field
+        stl::string name_buffer;
+        stl::string value_buffer;
+
+        void evict(stl::size_t limit) noexcept {
+            while (table_size > limit) {
+                auto const& last = table.back();
+                table_size -= last.name.size() + last.value.size() + entry_overhead;
+                table.pop_back();
+            }
+        }
+
+        void insert(stl::string_view name, stl::string_view value) noexcept {
+            auto const size = name.size() + value.size() + entry_overhead;
+            if (size > max_table_size) {
+                // an entry that is bigger than the whole table empties it
+                evict(0);
+                return;
+            }
+            // the name may point into an entry that is going to be evicted
+            entry new_entry{stl::string{name}, stl::string{value}};
+            evict(max_table_size - size);
+            table.push_front(stl::move(new_entry));
+            table_size += size;
+        }
+
+        [[nodiscard]] bool lookup(stl::size_t index, header_view& header) const noexcept {
+            if (index == 0)
+                return false;
+            if (index <= static_table.size()) {
+                header = static_table[index - 1];
+                return true;
+            }
+            index -= static_table.size() + 1;
+            if (index >= table.size())
+                return false;
+            header = {table[index].name, table[index].value};
+            return true;
+        }
+
+        [[nodiscard]] static bool read_string(uint8_t const*& it, uint8_t const* end, stl::string& buffer,
+                                              stl::string_view& str) noexcept {
+            if (it == end)
+                return false;
+            bool const  huffman = (*it & 0x80u) != 0;
+            stl::size_t len;
+            if (!decode_integer(it, end, 7, len) || static_cast<stl::size_t>(end - it) < len)
+                return false;
+            auto const raw = stl::string_view{reinterpret_cast<char const*>(it), len};
+            it += len;
+            if (!huffman) {
+                str = raw;
+                return true;
+            }
+            buffer.clear();
+            if (!huffman_decode(raw, buffer))
+                return false;
+            str = buffer;
+            return true;
+        }
+
+      public:
+        /**
+         * Decode a complete header block and call the callback with the name
+         * and the value of each field; they're only valid during the call.
+         *
+         * @returns false on a decoding error; that's a COMPRESSION_ERROR and
+         *          the connection can't be used anymore.
+         */
+        template <typename Callback>
+        bool decode(stl::string_view block, Callback&& callback) noexcept {
+            auto       it           = reinterpret_cast<uint8_t const*>(block.data());
+            auto const end          = it + block.size();
+            bool       seen_a_field = false;
+            while (it != end) {
+                auto const  first = *it;
+                stl::size_t index;
+                header_view header;
+                if (first & 0x80u) { // indexed header field
+                    if (!decode_integer(it, end, 7, index) || !lookup(index, header))
+                        return false;
+                    callback(header.name, header.value);
+                    seen_a_field = true;
+                    continue;
+                }
+                if ((first & 0xE0u) == 0x20u) { // dynamic table size update
+                    if (seen_a_field || !decode_integer(it, end, 5, index) || index > settings_limit)
+                        return false;
+                    max_table_size = index;
+                    evict(max_table_size);
+                    continue;
+                }
+                // literals; with incremental indexing (6bit prefix), without
+                // indexing or never indexed (4bit prefix)
+                bool const indexing = (first & 0xC0u) == 0x40u;
+                if (!decode_integer(it, end, indexing ? 6 : 4, index))
+                    return false;
+                if (index == 0) {
+                    if (!read_string(it, end, name_buffer, header.name))
+                        return false;
+                } else {
+                    header_view indexed;
+                    if (!lookup(index, indexed))
+                        return false;
+                    header.name = indexed.name;
+                }
+                if (!read_string(it, end, value_buffer, header.value))
+                    return false;
+                callback(header.name, header.value);
+                if (indexing)
+                    insert(header.name, header.value);
+                seen_a_field = true;
+            }
+            return true;
+        }
+
+        /**
+         * Call this when our SETTINGS_HEADER_TABLE_SIZE is acknowledged
+         */
+        void header_table_size(stl::size_t limit) noexcept {
+            settings_limit = limit;
+            if (max_table_size > limit) {
+                max_table_size = limit;
+                evict(limit);
+            }
+        }
+
+        [[nodiscard]] stl::size_t dynamic_table_size() const noexcept {
+            return table_size;
+        }
+
+        [[nodiscard]] stl::size_t dynamic_table_count() const noexcept {
+            return table.size();
+        }
+    };
+
+} // namespace webpp::http2::hpack
+
+#endif // WEBPP_INTERFACE_HTTP2_HPACK_H
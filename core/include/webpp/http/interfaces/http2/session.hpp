@@ -0,0 +1,699 @@
+#ifndef WEBPP_INTERFACE_HTTP2_SESSION_H
+#define WEBPP_INTERFACE_HTTP2_SESSION_H
+
+#include "../../../std/std.hpp"
+#include "../../../utils/uri.hpp"
+#include "../common/constants.hpp"
+#include "./frame.hpp"
+#include "./hpack.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace webpp::http2 {
+
+    constexpr uint32_t default_max_concurrent_streams = 100;
+
+    // the size of the decoded header fields of one request
+    constexpr stl::size_t default_max_header_list_size = 64 * 1024;
+
+    // how much the client can send us before we've read it, at least; the
+    // streams' windows are as big as the biggest body, so one upload can
+    // finish, and the connection's window is opened again as the data
+    // arrives, so the uploads don't wait for each other to finish.
+    constexpr uint32_t receive_window_size = 1024 * 1024;
+
+    // the bodies that a connection can make us hold before they're complete;
+    // the streams that go over it are refused
+    constexpr stl::size_t default_max_buffered_size = 32 * 1024 * 1024;
+
+    /**
+     * One request/response exchange. The decoded header fields are kept back
+     * to back in one string so a request doesn't need an allocation per field.
+     */
+    struct stream {
+        struct field {
+            uint32_t name_offset;
+            uint32_t name_length;
+            uint32_t value_offset;
+            uint32_t value_length;
+        };
+
+        uint32_t           id = 0;
+        stl::string        fields_data;
+        stl::vector<field> fields;
+        stl::string        header_block; // the HEADERS and CONTINUATION fragments until END_HEADERS
+        stl::string        body;
+        stl::size_t        buffered = 0; // the part of the body that's counted in the connection's buffered size
+
+        bool headers_done = false; // we've got the request's header block
+        bool end_stream   = false; // the client won't send anything else
+        bool responded    = false; // the response's header block has been sent
+
+        // the part of the response's body that is waiting for the flow control window
+        stl::string response_body;
+        stl::size_t response_sent = 0;
+        int64_t     send_window   = default_initial_window_size;
+
+        void add_field(stl::string_view name, stl::string_view value) noexcept {
+            auto const offset = static_cast<uint32_t>(fields_data.size());
+            fields_data.append(name);
+            fields_data.append(value);
+            fields.push_back({offset, static_cast<uint32_t>(name.size()),
+                              offset + static_cast<uint32_t>(name.size()), static_cast<uint32_t>(value.size())});
+        }
+
+        [[nodiscard]] stl::string_view name_of(field const& f) const noexcept {
+            return stl::string_view{fields_data}.substr(f.name_offset, f.name_length);
+        }
+
+        [[nodiscard]] stl::string_view value_of(field const& f) const noexcept {
+            return stl::string_view{fields_data}.substr(f.value_offset, f.value_length);
+        }
+
+        /**
+         * Normalize the ":path" where it is, before the application routes it
+         * (see normalize_path_inplace); it never gets longer.
+         */
+        void normalize_path() noexcept {
+            for (auto& f : fields) {
+                if (name_of(f) != ":path")
+                    continue;
+                auto const path = value_of(f);
+                if (path.starts_with('/') && !is_normalized_path(path))
+                    f.value_length = static_cast<uint32_t>(
+                      normalize_path_inplace(fields_data.data() + f.value_offset, f.value_length));
+                return;
+            }
+        }
+
+        /**
+         * The value of the first header field with this name; the names are
+         * lowercase in HTTP/2, but we're forgiving about the name you ask for.
+         */
+        [[nodiscard]] stl::string_view header(stl::string_view name) const noexcept {
+            for (auto const& f : fields)
+                if (hpack::details::equals_lower(name, name_of(f)))
+                    return value_of(f);
+            return {};
+        }
+
+        template <typename Callback>
+        void for_each_header(Callback&& callback) const noexcept {
+            for (auto const& f : fields)
+                callback(name_of(f), value_of(f));
+        }
+
+        [[nodiscard]] stl::string_view method() const noexcept {
+            return header(":method");
+        }
+
+        [[nodiscard]] stl::string_view path() const noexcept {
+            return header(":path");
+        }
+
+        [[nodiscard]] stl::string_view scheme() const noexcept {
+            return header(":scheme");
+        }
+
+        [[nodiscard]] stl::string_view authority() const noexcept {
+            return header(":authority");
+        }
+    };
+
+    /**
+     * One HTTP/2 connection (RFC 7540), without the socket.
+     *
+     * Feed it with what is read from the socket and write what's in the
+     * output; the handler is called when a request (headers and body) is
+     * complete, and it should call "respond" then or later.
+     *
+     * Only the "prior knowledge" start of a connection is supported; that's
+     * what the clients do behind a TLS terminating proxy, and what they do
+     * after ALPN negotiates "h2".
+     */
+    class session {
+      public:
+        using request_handler = stl::function<void(session&, stream&)>;
+
+      private:
+        using stream_map = stl::unordered_map<uint32_t, stream>;
+
+        request_handler handler;
+        hpack::decoder  decoder;
+        stream_map      streams;
+        stl::string     input;        // the part of a frame that didn't fit in one read
+        stl::string     output;       // the frames that should be written to the socket
+        stl::string     header_block; // reused to encode the responses' headers
+        stl::string     peer_address; // the address of the client, if the transport has told us
+
+        bool     preface_received    = false;
+        bool     close_requested     = false; // we've sent or received a GOAWAY
+        uint32_t last_stream_id      = 0;     // the biggest stream id that the client has used
+        uint32_t continuation_stream = 0;     // we're waiting for the CONTINUATION frames of this stream
+        uint32_t peer_initial_window = default_initial_window_size;
+        int64_t  connection_window   = default_initial_window_size;
+        stl::size_t max_body_size;
+        stl::size_t max_buffered_size;
+        stl::size_t buffered_size     = 0; // the bodies of the requests that haven't been dispatched yet
+        uint32_t    receive_window;        // our initial window of the streams, and of the connection
+        uint32_t    connection_credit = 0; // the DATA of this read, to be given back to the connection's window
+
+        /**
+         * A connection error; we tell the client why with a GOAWAY and the
+         * connection should be closed after that.
+         */
+        bool connection_error(error_code code) noexcept {
+            if (!close_requested)
+                append_goaway(output, last_stream_id, code);
+            close_requested = true;
+            return false;
+        }
+
+        void stream_error(uint32_t id, error_code code) noexcept {
+            append_rst_stream(output, id, code);
+            close_stream(id);
+        }
+
+        /**
+         * Forget a stream, and what it held
+         */
+        void close_stream(uint32_t id) noexcept {
+            if (auto it = streams.find(id); it != streams.end()) {
+                release(it->second);
+                streams.erase(it);
+            }
+        }
+
+        /**
+         * The stream's body has been passed to the application (or thrown
+         * away), so it's not counted in the connection's buffered size
+         */
+        void release(stream& s) noexcept {
+            buffered_size -= stl::exchange(s.buffered, 0u);
+        }
+
+        /**
+         * The body is too big; we say so with a 413 and stop the client from
+         * sending the rest of it (RFC 9113, section 8.1)
+         */
+        void reject_body(stream& s) noexcept {
+            auto const id = s.id;
+            header_block.clear();
+            hpack::encode_status(header_block, 413);
+            send_header_block(id, true);
+            stream_error(id, error_code::no_error);
+        }
+
+        /**
+         * Remove the padding (and the priority fields) of DATA and HEADERS
+         */
+        [[nodiscard]] static bool strip_payload(frame_header const& header, stl::string_view& payload) noexcept {
+            stl::size_t padding = 0;
+            if (header.has(flags::padded)) {
+                if (payload.empty())
+                    return false;
+                padding = static_cast<uint8_t>(payload.front());
+                payload.remove_prefix(1);
+            }
+            if (header.type == frame_type::headers && header.has(flags::priority)) {
+                if (payload.size() < 5)
+                    return false;
+                payload.remove_prefix(5);
+            }
+            if (padding > payload.size())
+                return false;
+            payload.remove_suffix(padding);
+            return true;
+        }
+
+        bool on_settings(frame_header const& header, stl::string_view payload) noexcept {
+            if (header.stream_id != 0)
+                return connection_error(error_code::protocol_error);
+            if (header.has(flags::ack))
+                return payload.empty() || connection_error(error_code::frame_size_error);
+            if (payload.size() % 6 != 0)
+                return connection_error(error_code::frame_size_error);
+            for (; !payload.empty(); payload.remove_prefix(6)) {
+                auto const id = static_cast<settings_id>((static_cast<uint8_t>(payload[0]) << 8u) |
+                                                         static_cast<uint8_t>(payload[1]));
+                auto const value = read_uint32(payload.substr(2));
+                switch (id) {
+                    case settings_id::initial_window_size: {
+                        if (value > max_window_size)
+                            return connection_error(error_code::flow_control_error);
+                        // the change applies to the streams that are already open
+                        auto const delta = static_cast<int64_t>(value) - peer_initial_window;
+                        for (auto& [_, s] : streams)
+                            s.send_window += delta;
+                        peer_initial_window = value;
+                        break;
+                    }
+                    case settings_id::max_frame_size:
+                        // we keep sending the default size, which is always allowed
+                        if (value < default_max_frame_size || value > 0xFFFFFF)
+                            return connection_error(error_code::protocol_error);
+                        break;
+                    case settings_id::enable_push:
+                        if (value > 1)
+                            return connection_error(error_code::protocol_error);
+                        break;
+                    default:
+                        // the header table size is the size of the client's
+                        // decoder table which we never use
+                        break;
+                }
+            }
+            append_frame(output, frame_type::settings, flags::ack, 0, {});
+            send_pending_data();
+            return true;
+        }
+
+        bool on_window_update(frame_header const& header, stl::string_view payload) noexcept {
+            if (payload.size() != 4)
+                return connection_error(error_code::frame_size_error);
+            auto const increment = read_uint32(payload) & 0x7FFFFFFFu;
+            if (header.stream_id == 0) {
+                if (increment == 0)
+                    return connection_error(error_code::protocol_error);
+                connection_window += increment;
+                if (connection_window > max_window_size)
+                    return connection_error(error_code::flow_control_error);
+                send_pending_data();
+                return true;
+            }
+            auto it = streams.find(header.stream_id);
+            if (it == streams.end())
+                return true; // it's closed already
+            if (increment == 0) {
+                stream_error(header.stream_id, error_code::protocol_error);
+                return true;
+            }
+            it->second.send_window += increment;
+            if (it->second.send_window > max_window_size) {
+                stream_error(header.stream_id, error_code::flow_control_error);
+                return true;
+            }
+            if (send_data(it->second))
+                streams.erase(it);
+            return true;
+        }
+
+        bool on_headers(frame_header const& header, stl::string_view payload) noexcept {
+            auto const id = header.stream_id;
+            if (id == 0 || (id & 1u) == 0 || !strip_payload(header, payload))
+                return connection_error(error_code::protocol_error);
+
+            stream* s  = nullptr;
+            auto    it = streams.find(id);
+            if (it != streams.end()) {
+                // trailers; they should end the stream
+                s = &it->second;
+                if (s->end_stream || !header.has(flags::end_stream))
+                    return connection_error(error_code::protocol_error);
+            } else {
+                if (id <= last_stream_id)
+                    return connection_error(error_code::stream_closed);
+                last_stream_id = id;
+                s              = &streams[id];
+                s->id          = id;
+                s->send_window = peer_initial_window;
+            }
+            s->end_stream = header.has(flags::end_stream);
+            s->header_block.append(payload);
+            if (!header.has(flags::end_headers)) {
+                continuation_stream = id;
+                return true;
+            }
+            return end_headers(*s);
+        }
+
+        bool on_continuation(frame_header const& header, stl::string_view payload) noexcept {
+            if (header.stream_id != continuation_stream)
+                return connection_error(error_code::protocol_error);
+            auto& s = streams[header.stream_id];
+            s.header_block.append(payload);
+            if (s.header_block.size() > default_max_header_list_size)
+                return connection_error(error_code::enhance_your_calm);
+            if (!header.has(flags::end_headers))
+                return true;
+            continuation_stream = 0;
+            return end_headers(s);
+        }
+
+        /**
+         * The whole header block of a stream has arrived
+         */
+        bool end_headers(stream& s) noexcept {
+            // the block should be decoded even if we're going to refuse the
+            // stream, the decoder's table depends on it
+            bool       too_large = false;
+            auto const decoded   = decoder.decode(s.header_block, [&](stl::string_view name, stl::string_view value) {
+                if (s.fields_data.size() + name.size() + value.size() > default_max_header_list_size) {
+                    too_large = true;
+                    return;
+                }
+                s.add_field(name, value);
+            });
+            s.header_block.clear();
+            if (!decoded)
+                return connection_error(error_code::compression_error);
+
+            auto const id = s.id;
+            if (too_large || (!s.headers_done && s.method().empty()) || s.path().empty()) {
+                stream_error(id, error_code::protocol_error);
+                return true;
+            }
+            if (!s.headers_done && streams.size() > default_max_concurrent_streams) {
+                stream_error(id, error_code::refused_stream);
+                return true;
+            }
+            if (!s.headers_done)
+                s.normalize_path();
+            s.headers_done = true;
+            if (s.end_stream)
+                dispatch(s);
+            return true;
+        }
+
+        bool on_data(frame_header const& header, stl::string_view payload) noexcept {
+            auto const id = header.stream_id;
+            if (id == 0)
+                return connection_error(error_code::protocol_error);
+
+            if (!strip_payload(header, payload))
+                return connection_error(error_code::protocol_error);
+
+            // the whole frame counts for the flow control, even the padding;
+            // the connection's window is opened again right away, what we
+            // hold is limited by the buffered size instead
+            connection_credit += header.length;
+            auto it = streams.find(id);
+            if (it == streams.end()) {
+                if (id > last_stream_id)
+                    return connection_error(error_code::protocol_error);
+                append_rst_stream(output, id, error_code::stream_closed);
+                return true;
+            }
+            auto& s = it->second;
+            if (s.end_stream || !s.headers_done) {
+                stream_error(id, error_code::stream_closed);
+                return true;
+            }
+            if (s.body.size() + payload.size() > max_body_size) {
+                reject_body(s);
+                return true;
+            }
+            if (buffered_size + payload.size() > max_buffered_size) {
+                stream_error(id, error_code::refused_stream);
+                return true;
+            }
+            // the stream's window is as big as the biggest body, so it's
+            // never opened again; the body ends before it's used up
+            s.body.append(payload);
+            s.buffered += payload.size();
+            buffered_size += payload.size();
+            s.end_stream = header.has(flags::end_stream);
+            if (s.end_stream) {
+                release(s);
+                dispatch(s);
+            }
+            return true;
+        }
+
+        bool on_frame(frame_header const& header, stl::string_view payload) noexcept {
+            if (continuation_stream != 0 && header.type != frame_type::continuation)
+                return connection_error(error_code::protocol_error);
+            switch (header.type) {
+                case frame_type::data: return on_data(header, payload);
+                case frame_type::headers: return on_headers(header, payload);
+                case frame_type::continuation: return on_continuation(header, payload);
+                case frame_type::settings: return on_settings(header, payload);
+                case frame_type::window_update: return on_window_update(header, payload);
+                case frame_type::ping:
+                    if (header.stream_id != 0)
+                        return connection_error(error_code::protocol_error);
+                    if (payload.size() != 8)
+                        return connection_error(error_code::frame_size_error);
+                    if (!header.has(flags::ack))
+                        append_frame(output, frame_type::ping, flags::ack, 0, payload);
+                    return true;
+                case frame_type::rst_stream:
+                    if (header.stream_id == 0)
+                        return connection_error(error_code::protocol_error);
+                    if (payload.size() != 4)
+                        return connection_error(error_code::frame_size_error);
+                    close_stream(header.stream_id);
+                    return true;
+                case frame_type::priority:
+                    if (header.stream_id == 0)
+                        return connection_error(error_code::protocol_error);
+                    return payload.size() == 5 || connection_error(error_code::frame_size_error);
+                case frame_type::goaway:
+                    // the client is leaving; we finish what we have
+                    close_requested = true;
+                    return true;
+                case frame_type::push_promise:
+                    // clients can't push
+                    return connection_error(error_code::protocol_error);
+                default:
+                    // unknown frame types should be ignored
+                    return true;
+            }
+        }
+
+        void dispatch(stream& s) noexcept {
+            if (handler)
+                handler(*this, s);
+        }
+
+        /**
+         * Send as much of the response's body as the flow control allows
+         * @returns true if the whole response has been sent
+         */
+        bool send_data(stream& s) noexcept {
+            if (!s.responded)
+                return false;
+            while (s.response_sent < s.response_body.size()) {
+                auto const window = stl::min(connection_window, s.send_window);
+                if (window <= 0)
+                    return false;
+                auto const len = stl::min({s.response_body.size() - s.response_sent,
+                                           default_max_frame_size,
+                                           static_cast<stl::size_t>(window)});
+                auto const last = s.response_sent + len == s.response_body.size();
+                append_frame(output,
+                             frame_type::data,
+                             last ? flags::end_stream : 0,
+                             s.id,
+                             stl::string_view{s.response_body}.substr(s.response_sent, len));
+                s.response_sent += len;
+                s.send_window -= static_cast<int64_t>(len);
+                connection_window -= static_cast<int64_t>(len);
+            }
+            return true;
+        }
+
+        void send_pending_data() noexcept {
+            for (auto it = streams.begin(); it != streams.end();) {
+                if (it->second.responded && send_data(it->second)) {
+                    it = streams.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        void send_header_block(uint32_t id, bool end_stream) noexcept {
+            stl::string_view block = header_block;
+            auto             type  = frame_type::headers;
+            do {
+                auto const len       = stl::min(block.size(), default_max_frame_size);
+                auto const last      = len == block.size();
+                uint8_t    frame_flg = last ? flags::end_headers : 0;
+                if (type == frame_type::headers && end_stream)
+                    frame_flg |= flags::end_stream;
+                append_frame(output, type, frame_flg, id, block.substr(0, len));
+                block.remove_prefix(len);
+                type = frame_type::continuation;
+            } while (!block.empty());
+        }
+
+        /**
+         * The connection-specific header fields are not allowed in HTTP/2
+         */
+        [[nodiscard]] static bool is_connection_specific(stl::string_view name) noexcept {
+            using hpack::details::equals_lower;
+            return equals_lower(name, "connection") || equals_lower(name, "keep-alive") ||
+                   equals_lower(name, "proxy-connection") || equals_lower(name, "transfer-encoding") ||
+                   equals_lower(name, "upgrade");
+        }
+
+      public:
+        /**
+         * The bodies that are bigger than max_body_size are answered with a
+         * 413, and the streams whose bodies would make the connection hold
+         * more than max_buffered_size (at least one body) are refused.
+         */
+        session(request_handler _handler           = {},
+                stl::size_t     _max_body_size     = default_max_body_size,
+                stl::size_t     _max_buffered_size = default_max_buffered_size) noexcept
+          : handler{stl::move(_handler)},
+            max_body_size{_max_body_size},
+            max_buffered_size{stl::max(_max_buffered_size, _max_body_size)},
+            receive_window{static_cast<uint32_t>(
+              stl::clamp<stl::size_t>(_max_body_size, receive_window_size, max_window_size))} {
+            // our SETTINGS should be the first thing that we send
+            append_settings(output,
+                            {{settings_id::max_concurrent_streams, default_max_concurrent_streams},
+                             {settings_id::initial_window_size, receive_window},
+                             {settings_id::enable_push, 0}});
+            append_window_update(output, 0, receive_window - default_initial_window_size);
+        }
+
+        /**
+         * Parse the data that is read from the socket
+         * @returns false if it's a connection error; send the output (it has
+         *          a GOAWAY in it) and close the connection.
+         */
+        bool feed(stl::string_view data) noexcept {
+            if (close_requested && streams.empty())
+                return false;
+            stl::string_view in = data;
+            if (!input.empty()) {
+                input.append(data);
+                in = input;
+            }
+
+            stl::size_t consumed = 0;
+            auto        result   = true;
+            if (!preface_received) {
+                auto const len = stl::min(in.size(), connection_preface.size());
+                if (in.substr(0, len) != connection_preface.substr(0, len)) {
+                    close_requested = true;
+                    return false;
+                }
+                if (len == connection_preface.size()) {
+                    preface_received = true;
+                    consumed         = len;
+                } else {
+                    consumed = in.size(); // wait for the rest of it
+                    input.assign(in);
+                    return true;
+                }
+            }
+            while (in.size() - consumed >= frame_header_length) {
+                auto const header = frame_header::parse(in.substr(consumed));
+                if (header.length > default_max_frame_size) {
+                    result = connection_error(error_code::frame_size_error);
+                    break;
+                }
+                if (in.size() - consumed - frame_header_length < header.length)
+                    break;
+                auto const payload = in.substr(consumed + frame_header_length, header.length);
+                consumed += frame_header_length + header.length;
+                if (!on_frame(header, payload)) {
+                    result = false;
+                    break;
+                }
+            }
+
+            if (!result) {
+                input.clear();
+                return false;
+            }
+            if (connection_credit != 0)
+                append_window_update(output, 0, stl::exchange(connection_credit, 0u));
+            // keep the incomplete frame for the next read
+            if (input.empty()) {
+                input.assign(in.substr(consumed));
+            } else {
+                input.erase(0, consumed);
+            }
+            return true;
+        }
+
+        /**
+         * Send a response; the headers should be a range of objects with
+         * "name" and "value" members (like response_headers). The body is
+         * sent as fast as the client's flow control windows allow.
+         */
+        template <typename HeadersType>
+        void respond(uint32_t id, unsigned status, HeadersType const& headers, stl::string body = {}) noexcept {
+            auto it = streams.find(id);
+            if (it == streams.end() || it->second.responded)
+                return; // the client has reset the stream
+            auto& s = it->second;
+
+            header_block.clear();
+            hpack::encode_status(header_block, status);
+            for (auto const& field : headers)
+                if (!is_connection_specific(field.name))
+                    hpack::encode_header(header_block, field.name, field.value);
+            send_header_block(id, body.empty());
+
+            s.responded     = true;
+            s.response_body = stl::move(body);
+            if (send_data(s))
+                streams.erase(it);
+        }
+
+        /**
+         * Tell the client that we're not going to accept new streams (GOAWAY);
+         * the ones that are open are finished.
+         */
+        void shutdown() noexcept {
+            if (close_requested)
+                return;
+            append_goaway(output, last_stream_id, error_code::no_error);
+            close_requested = true;
+        }
+
+        [[nodiscard]] bool has_output() const noexcept {
+            return !output.empty();
+        }
+
+        [[nodiscard]] stl::string_view output_data() const noexcept {
+            return output;
+        }
+
+        /**
+         * Get the frames that should be written to the socket
+         */
+        [[nodiscard]] stl::string take_output() noexcept {
+            return stl::exchange(output, stl::string{});
+        }
+
+        /**
+         * The connection should be closed after writing the output
+         */
+        [[nodiscard]] bool should_close() const noexcept {
+            return close_requested && streams.empty();
+        }
+
+        [[nodiscard]] stl::size_t stream_count() const noexcept {
+            return streams.size();
+        }
+
+        /**
+         * The address of the client, to be given to the requests; the session
+         * doesn't know it unless it's told
+         */
+        void remote_address(stl::string_view address) {
+            peer_address.assign(address);
+        }
+
+        [[nodiscard]] stl::string_view remote_address() const noexcept {
+            return peer_address;
+        }
+    };
+
+} // namespace webpp::http2
+
+#endif // WEBPP_INTERFACE_HTTP2_SESSION_H
@@ -1,13 +1,902 @@
 #ifndef WEBPP_INTERFACE_SSERVER_H
 #define WEBPP_INTERFACE_SSERVER_H
 
-#include "basic_interface.hpp"
+#include "../../std/internet.hpp"
+#include "../../std/set.hpp"
+#include "../../std/vector.hpp"
+#include "../../traits/std_arena_traits.hpp"
+#include "../../traits/std_traits.hpp"
+#include "../../utils/logger.hpp"
+#include "../../utils/task.hpp"
+#include "../../utils/tracing.hpp"
+#include "../../utils/uri.hpp"
+#include "../../utils/utf8.hpp"
+#include "../application_concepts.hpp"
+#include "../compression.hpp"
+#include "../event_stream.hpp"
+#include "../header.hpp"
+#include "../header_index.hpp"
+#include "../request.hpp"
+#include "../websocket.hpp"
+#include "./common/server.hpp"
+#include "./common/task_link.hpp"
+#include "./http1/request_parser.hpp"
+#include "./http1/websocket_frame.hpp"
+
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <type_traits>
 
 namespace webpp {
 
-    class simple_server : public basic_interface<simple_server> {
+    namespace details {
+
+        /**
+         * A connection of the simple server after it's upgraded to WebSocket
+         */
+        struct websocket_session final : websocket::sender {
+            using opcode     = websocket::opcode;
+            using close_code = websocket::close_code;
+
+            common::connection*                       conn;
+            stl::shared_ptr<websocket::handler const> handler;
+            stl::string                               message{}; // the fragments, if they're put together
+            opcode message_op = opcode::continuation;           // the type of the message that's in progress
+            bool   closing    = false;                          // the close frame is sent
+            bool   closed     = false;                          // on_close is called
+
+            websocket_session(common::connection& _conn, stl::shared_ptr<websocket::handler const> _handler) noexcept
+              : conn{&_conn},
+                handler{stl::move(_handler)} {}
+
+            void send(opcode op, stl::string_view payload) noexcept override {
+                if (closing)
+                    return;
+                stl::string frame;
+                websocket::write_frame(frame, op, payload);
+                conn->send(stl::move(frame));
+            }
+
+            void close(close_code code = close_code::normal, stl::string_view reason = {}) noexcept override {
+                if (closing)
+                    return;
+                closing = true;
+                stl::string frame;
+                websocket::write_close_frame(frame, code, reason);
+                conn->send(stl::move(frame));
+                conn->close_after_write();
+            }
+
+            // the client, or the connection, is gone
+            void finish(close_code code) noexcept {
+                if (closed)
+                    return;
+                closed = true;
+                if (handler->on_close)
+                    handler->on_close(*this, code);
+            }
+
+            void fail(close_code code) noexcept {
+                close(code);
+                finish(code);
+            }
+
+            /**
+             * Handle a frame whose payload is unmasked
+             */
+            void on_frame(websocket::frame_header const& frame, stl::string_view payload) noexcept {
+                if (closing && frame.op != opcode::close)
+                    return; // we're waiting for the client's close frame
+                switch (frame.op) {
+                    case opcode::ping: send(opcode::pong, payload); return;
+                    case opcode::pong: return;
+                    case opcode::close: {
+                        if (payload.size() == 1) {
+                            fail(close_code::protocol_error);
+                            return;
+                        }
+                        auto const code =
+                          payload.empty()
+                            ? close_code::no_status
+                            : static_cast<close_code>((static_cast<stl::uint8_t>(payload[0]) << 8u) |
+                                                      static_cast<stl::uint8_t>(payload[1]));
+                        close(code == close_code::no_status ? close_code::normal : code); // the echo
+                        finish(code);
+                        return;
+                    }
+                    case opcode::text:
+                    case opcode::binary:
+                        if (message_op != opcode::continuation) {
+                            fail(close_code::protocol_error); // the last one is not finished
+                            return;
+                        }
+                        message_op = frame.op;
+                        break;
+                    case opcode::continuation:
+                        if (message_op == opcode::continuation) {
+                            fail(close_code::protocol_error); // there's nothing to continue
+                            return;
+                        }
+                        break;
+                }
+
+                auto const binary = message_op == opcode::binary;
+                auto const first  = frame.op != opcode::continuation;
+                if (frame.fin)
+                    message_op = opcode::continuation;
+                if (handler->on_fragment) {
+                    handler->on_fragment(*this, payload, binary, frame.fin);
+                    return;
+                }
+                if (first && frame.fin) {
+                    deliver(payload, binary); // right from the receive buffer
+                    return;
+                }
+                if (message.size() + payload.size() > handler->max_message_size) {
+                    fail(close_code::too_big);
+                    return;
+                }
+                message.append(payload);
+                if (frame.fin) {
+                    deliver(message, binary);
+                    message.clear();
+                }
+            }
+
+            void deliver(stl::string_view msg, bool binary) noexcept {
+                if (!binary && !utf8_validator::validate(msg)) {
+                    fail(close_code::invalid_payload);
+                    return;
+                }
+                if (handler->on_message)
+                    handler->on_message(*this, msg, binary);
+            }
+        };
+
+    } // namespace details
+
+    /**
+     * A standalone HTTP/1.1 server; no web server or FastCGI in between.
+     *
+     * The connections are persistent (keep-alive) unless the client asks
+     * otherwise, and pipelined requests are answered in order. The requests
+     * are parsed in place, so the request object only holds views into the
+     * connection's buffer.
+     *
+     * The application is called from the worker threads, so if you set the
+     * concurrency to more than one, the application should be thread-safe.
+     *
+     * If the application has WebSocket endpoints (see router::websocket),
+     * their connections are upgraded, and the frames are parsed and unmasked
+     * right in the receive buffer; only the frames that don't fit in one read
+     * and the fragmented messages (unless they're streamed) are copied.
+     */
+    template <Traits TraitsType, Application App>
+    struct simple_server {
+      public:
+        using traits_type      = TraitsType;
+        using application_type = App;
+        using interface_type   = simple_server<traits_type, application_type>;
+        using endpoint_t       = stl::net::ip::tcp::endpoint;
+
+        application_type app;
+
+      private:
+        istl::set<traits_type, endpoint_t> _endpoints;
+        stl::optional<common::server>      _server;
+        stl::size_t                        _concurrency = 1;
+        stl::optional<compression_options> _compression{};
+        stl::optional<shedding_options>    _shedding{};
+        stl::optional<common::tls_options> _tls{};
+        metrics_registry*                  _metrics     = nullptr;
+        bool                               _access_log  = false;
+        stl::vector<int>                   _adopted{};
+        stl::size_t                        _max_body_size = default_max_body_size;
+
+      public:
+        /**
+         * The state of one connection; only the part of a request that didn't
+         * fit into one read, and the targets that had to be normalized, are
+         * copied here.
+         */
+        struct connection_state {
+            stl::string pending;
+            stl::string target;
+
+            // it's been upgraded
+            stl::shared_ptr<details::websocket_session> websocket{};
+
+            // it's subscribed to an event channel; what the client sends after that is ignored
+            bool event_stream = false;
+
+            // a task is serving a request (see serve_task); the requests after it wait in the pending
+            bool                              serving = false;
+            stl::optional<common::task_link> tasks{};
+        };
+
+      private:
+        static constexpr stl::string_view bad_request_response =
+          "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+        static constexpr stl::string_view too_large_response =
+          "HTTP/1.1 413 Content Too Large\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+        static constexpr stl::string_view not_implemented_response =
+          "HTTP/1.1 501 Not Implemented\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+        // the answer to the requests that the load shedder rejects
+        static constexpr stl::string_view overloaded_response =
+          "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nRetry-After: 1\r\n\r\n";
+
+        static constexpr stl::string_view websocket_version_response =
+          "HTTP/1.1 426 Upgrade Required\r\nSec-WebSocket-Version: 13\r\nContent-Length: 0\r\nConnection: "
+          "close\r\n\r\n";
+
+        /**
+         * Call the application and queue the response; the coroutine
+         * applications are given a task (see serve_task), and the requests
+         * after it wait for it.
+         * @returns true if the connection should be kept open
+         */
+        bool serve(common::connection&        conn,
+                   connection_state&          state,
+                   http1::request_view const& view,
+                   stl::string_view           raw = {}) noexcept {
+            if (!conn.admit()) [[unlikely]] {
+                conn.send(stl::string{overloaded_response});
+                return view.keep_alive() && !conn.is_draining();
+            }
+            // the request type is named here and not as a member alias because
+            // checking the Interface concept needs this class to be complete
+            using request_type = basic_request<traits_type, interface_type>;
+            if constexpr (Task<decltype(app(stl::declval<request_type&>()))>) {
+                serve_task(conn, state, view, raw);
+                return true;
+            } else {
+                return serve_in_request_arena<traits_type>([&]() noexcept {
+                    request_type req{view, conn.remote_address()};
+                    auto const   start = _access_log ? stl::chrono::steady_clock::now()
+                                                     : stl::chrono::steady_clock::time_point{};
+                    auto         res   = [&] {
+                        WEBPP_TRACE_SPAN(handler, conn.trace_id());
+                        return app(req);
+                    }();
+                    return respond(conn, state, view, res, start);
+                });
+            }
+        }
+
+        /**
+         * Start the task of a request; it's copied out of the connection's
+         * buffer (the raw bytes of it) because the task outlives the read.
+         * Its response is queued on the connection's thread when it's done,
+         * and then the pipelined requests that have waited are served. The
+         * tasks are not served in the request arena, since the arena is reset
+         * before they're done.
+         */
+        void serve_task(common::connection&        conn,
+                        connection_state&          state,
+                        http1::request_view const& view,
+                        stl::string_view           raw) noexcept {
+            using request_type = basic_request<traits_type, interface_type>;
+            struct in_flight {
+                stl::string                 raw;
+                stl::string                 target;
+                stl::string                 remote_address;
+                http1::request_view         view{};
+                stl::optional<request_type> req{};
+            };
+            if (!state.tasks) {
+                state.tasks.emplace();
+                state.tasks->attach(conn);
+            }
+            auto flight = stl::make_shared<in_flight>();
+            flight->raw.assign(raw);
+            stl::size_t consumed = 0;
+            static_cast<void>(http1::parse_request(flight->raw, flight->view, consumed, _max_body_size)); // it's whole
+            if (view.target.data() == state.target.data()) {
+                flight->target.assign(view.target); // it was normalized
+                flight->view.target = flight->target;
+            }
+            flight->remote_address.assign(conn.remote_address());
+            flight->req.emplace(flight->view, state.tasks->token(), flight->remote_address);
+            state.serving = true;
+
+            auto const start  = _access_log ? stl::chrono::steady_clock::now()
+                                            : stl::chrono::steady_clock::time_point{};
+            auto       result = [&] {
+                WEBPP_TRACE_SPAN(handler, conn.trace_id());
+                return app(*flight->req);
+            }();
+            stl::move(result).start([this, &state, flight, start, link = *state.tasks](auto res) mutable noexcept {
+                link.post([this, &state, flight = stl::move(flight), start, res = stl::move(res)](
+                            common::connection& c) mutable noexcept {
+                    // the data handler (and the state in it) lives as long as the connection is open
+                    c.cork();
+                    state.serving         = false;
+                    auto const keep_alive = respond(c, state, flight->view, res, start);
+                    if (!keep_alive) {
+                        c.close_after_write();
+                        state.pending.clear();
+                    } else if (state.event_stream) {
+                        state.pending.clear();
+                        c.busy(false);
+                    } else {
+                        handle(c, state, {}); // the ones that have waited in the pending
+                    }
+                    c.uncork();
+                });
+            });
+        }
+
+        /**
+         * Serialize the response, and queue it
+         * @returns true if the connection should be kept open
+         */
+        template <typename ResponseType>
+        bool respond(common::connection&                   conn,
+                     connection_state&                     state,
+                     http1::request_view const&            view,
+                     ResponseType&                         res,
+                     stl::chrono::steady_clock::time_point start) noexcept {
+            WEBPP_TRACE_SPAN(serialize, conn.trace_id());
+            if (_compression)
+                compress_response(res, view.header("Accept-Encoding"), *_compression);
+            res.calculate_default_headers();
+            res.calculate_date_header();
+
+            // the streams are chunked; the HTTP/1.0 clients read them until we close
+            auto const is_head = view.method == "HEAD";
+            auto const chunked = res.is_stream() && view.version_minor >= 1 && !is_head;
+            if (chunked)
+                res.header.emplace(well_known_header_name(well_known_header::transfer_encoding), "chunked");
+
+            // the server is shutting down; this is the last one
+            auto const keep_alive =
+              view.keep_alive() && !conn.is_draining() && (chunked || is_head || !res.is_stream());
+            auto const status = res.header.status_code;
+            if (_access_log)
+                log_access(view.method, view.target, static_cast<unsigned>(status), start);
+
+            stl::string head;
+            head.reserve(256);
+            if (auto const status_line = http11_status_line(status); !status_line.empty()) {
+                head.append(status_line); // formatted at compile time
+            } else {
+                stl::format_to(stl::back_inserter(head), "HTTP/1.1 {} \r\n", status);
+            }
+            res.header.append_to(head);
+            if (!keep_alive)
+                head.append("Connection: close\r\n");
+            head.append("\r\n");
+            conn.send(stl::move(head));
+
+            // the body of the responses to the HEAD requests are not sent
+            if (!is_head)
+                state.event_stream = send_body(conn, res.body, chunked);
+            recycle_response(stl::move(res));
+            return keep_alive;
+        }
+
+        /**
+         * The files are copied to the socket by the kernel, the cached files
+         * and the shared bodies are written from where they are, and the
+         * streams are produced while they're written; the rest is copied to
+         * the queue. The event streams subscribe the connection to their
+         * channel, and the events are queued as they're published.
+         * @returns true if it's subscribed
+         */
+        template <typename BodyType>
+        static bool send_body(common::connection& conn, BodyType const& body, bool chunked) noexcept {
+            if constexpr (requires { body.channel(); }) {
+                if (auto const& channel = body.channel(); channel) {
+                    channel->subscribe(conn, chunked);
+                    return true;
+                }
+            }
+            if constexpr (requires { body.producer_handle(); }) {
+                if (body.is_stream()) {
+                    send_stream(conn, body.producer_handle(), chunked);
+                    return false;
+                }
+            }
+            if constexpr (requires { body.segments(); }) {
+                if (auto const segments = body.segments(); !segments.empty()) {
+                    send_segments(conn, body, segments);
+                    return false;
+                }
+            }
+            if constexpr (requires { body.file_handle(); }) {
+                if (auto const fd = body.native_handle(); fd != -1) {
+                    conn.send_file(fd, 0, body.size(), body.file_handle());
+                    return false;
+                }
+            }
+            if constexpr (requires { body.shared_owner(); }) {
+                if (auto owner = body.shared_owner(); owner != nullptr) {
+                    auto const bytes = body.view();
+                    conn.send(stl::string_view{bytes.data(), bytes.size()}, stl::move(owner));
+                    return false;
+                }
+            }
+            if constexpr (requires { body.cached_file(); }) {
+                if (auto const& file = body.cached_file(); file != nullptr) {
+                    conn.send(file->content(), file);
+                    return false;
+                }
+            }
+            conn.send(stl::string{body.str()});
+            return false;
+        }
+
+        /**
+         * The ranges of a file (of a Range request); the slices are copied by
+         * the kernel, or written from the cache, and the multipart framing in
+         * between them is written from where it is.
+         */
+        template <typename BodyType, typename SegmentsType>
+        static void send_segments(common::connection& conn, BodyType const& body, SegmentsType segments) noexcept {
+            for (auto const& segment : segments) {
+                if (!segment.text.empty()) {
+                    conn.send(segment.text, body.segments_owner());
+                } else if (auto const fd = body.native_handle(); fd != -1) {
+                    conn.send_file(fd, segment.offset, segment.length, body.file_handle());
+                } else if (auto const& file = body.cached_file(); file != nullptr) {
+                    conn.send(file->content().substr(segment.offset, segment.length), file);
+                }
+            }
+        }
+
+        /**
+         * Each chunk is framed as "size in hex\r\n chunk \r\n", and the last
+         * one is followed by the zero sized chunk
+         */
+        template <typename ProducerPtr>
+        static void send_stream(common::connection& conn, ProducerPtr producer, bool chunked) noexcept {
+            if (!chunked) {
+                conn.send_stream([producer = stl::move(producer)](stl::string& out) noexcept {
+                    return (*producer)(out);
+                });
+                return;
+            }
+            conn.send_stream([producer = stl::move(producer),
+                              chunk    = stl::string{}](stl::string& out) mutable noexcept {
+                chunk.clear();
+                auto const more = (*producer)(chunk);
+                if (!chunk.empty()) {
+                    stl::array<char, 16> size{};
+                    auto const end = stl::to_chars(size.data(), size.data() + size.size(), chunk.size(), 16).ptr;
+                    out.reserve(chunk.size() + 24);
+                    out.append(size.data(), end);
+                    out.append("\r\n");
+                    out.append(chunk);
+                    out.append("\r\n");
+                }
+                if (!more)
+                    out.append("0\r\n\r\n");
+                return more;
+            });
+        }
+
+        /**
+         * Answer the handshake, and hand the connection to the WebSocket
+         * handler; the frames that have come right after the request are
+         * handled too.
+         */
+        void upgrade(common::connection&                       conn,
+                     connection_state&                         state,
+                     http1::request_view const&                view,
+                     stl::shared_ptr<websocket::handler const> handler,
+                     stl::string_view                          rest) noexcept {
+            auto const status = websocket::handshake_status(view);
+            if (status != 101) {
+                conn.send(stl::string{status == 426 ? websocket_version_response : bad_request_response});
+                conn.close_after_write();
+                state.pending.clear();
+                return;
+            }
+            auto const  key = websocket::accept_key(view.header("Sec-WebSocket-Key"));
+            stl::string head;
+            head.append("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                        "Sec-WebSocket-Accept: ")
+              .append(key.data(), key.size())
+              .append("\r\n\r\n");
+            conn.send(stl::move(head));
+
+            auto session    = stl::make_shared<details::websocket_session>(conn, stl::move(handler));
+            state.websocket = session;
+            conn.on_closed([session] {
+                session->finish(websocket::close_code::abnormal);
+            });
+            conn.busy(false);
+            stl::string const leftover{rest}; // it may be in the pending
+            state.pending.clear();
+            if (session->handler->on_open)
+                session->handler->on_open(*session);
+            if (!leftover.empty())
+                on_frames(conn, state, leftover);
+        }
+
+        /**
+         * Handle the frames of an upgraded connection; they're unmasked in
+         * place, in the connection's buffer if they're whole in it, and in the
+         * pending frame otherwise.
+         */
+        static void on_frames(common::connection& conn, connection_state& state, stl::string_view data) noexcept {
+            auto& session = *state.websocket;
+            if (data.empty() || session.closing)
+                return;
+            auto       input    = state.pending.empty() ? conn.writable(data) : stl::span<char>{};
+            bool const buffered = input.empty();
+            if (buffered) {
+                state.pending.append(data);
+                input = {state.pending.data(), state.pending.size()};
+            }
+
+            stl::size_t total_consumed = 0;
+            while (!input.empty() && !session.closing) {
+                websocket::frame_header frame;
+                auto const status = websocket::parse_frame_header({input.data(), input.size()}, frame);
+                if (status == http1::parse_status::incomplete)
+                    break;
+                if (status == http1::parse_status::error || !frame.masked) { // the clients always mask
+                    session.fail(websocket::close_code::protocol_error);
+                    break;
+                }
+                if (frame.payload_size > session.handler->max_message_size) {
+                    session.fail(websocket::close_code::too_big);
+                    break;
+                }
+                auto const frame_size = frame.header_size + static_cast<stl::size_t>(frame.payload_size);
+                if (input.size() < frame_size)
+                    break;
+                auto* const payload = input.data() + frame.header_size;
+                websocket::unmask(payload, frame_size - frame.header_size, frame.mask);
+                session.on_frame(frame, {payload, frame_size - frame.header_size});
+                input = input.subspan(frame_size);
+                total_consumed += frame_size;
+            }
+
+            // keep the incomplete frame for the next read
+            if (session.closing) {
+                state.pending.clear();
+            } else if (buffered) {
+                state.pending.erase(0, total_consumed);
+            } else {
+                state.pending.assign(input.data(), input.size());
+            }
+        }
+
+      public:
+        /**
+         * Normalize the path of the request target before the application
+         * routes it (see normalize_path_inplace), so "/a/./b" and "/a/%62"
+         * don't get past the routes of "/a/b" as other paths. Most of the
+         * targets are normalized already, and those are not copied.
+         */
+        static void normalize_target(connection_state& state, http1::request_view& view) noexcept {
+            if (!view.target.starts_with('/') || is_normalized_path(view.target))
+                return;
+            state.target.assign(view.target);
+            state.target.resize(normalize_path_inplace(state.target.data(), state.target.size()));
+            view.target = state.target;
+        }
+
+        /**
+         * Handle the data that is read from a connection.
+         * All the complete requests in the data are served (pipelining), and
+         * the rest of it is kept for the next read.
+         */
+        void handle(common::connection& conn, connection_state& state, stl::string_view data) noexcept {
+            if (state.websocket) {
+                on_frames(conn, state, data);
+                return;
+            }
+            if (state.event_stream)
+                return;
+            if (state.serving) {
+                // they're read (so we know if the client goes away), but they wait for the task;
+                // more than a whole request is not waited for
+                state.pending.append(data);
+                if (state.pending.size() > http1::max_header_block_size + _max_body_size) {
+                    state.pending.clear();
+                    conn.close_after_write();
+                }
+                return;
+            }
+            stl::string_view input = data;
+            if (!state.pending.empty()) {
+                state.pending.append(data);
+                input = state.pending;
+            }
+
+            stl::size_t total_consumed = 0;
+            while (!input.empty()) {
+                http1::request_view view;
+                stl::size_t         consumed = 0;
+                auto const          status   = [&] {
+                    WEBPP_TRACE_SPAN(parse, conn.trace_id());
+                    return http1::parse_request(input, view, consumed, _max_body_size);
+                }();
+                if (status == http1::parse_status::incomplete)
+                    break;
+                if (status != http1::parse_status::complete) {
+                    // we don't know where its body ends, so there's nothing to keep reading for
+                    conn.send(stl::string{status == http1::parse_status::too_large ? too_large_response
+                                          : status == http1::parse_status::not_implemented
+                                            ? not_implemented_response
+                                            : bad_request_response});
+                    conn.close_after_write();
+                    state.pending.clear();
+                    return;
+                }
+                normalize_target(state, view);
+                if constexpr (requires { app.websocket_handler(view.target); }) {
+                    if (websocket::is_upgrade(view)) {
+                        if (auto handler = app.websocket_handler(view.target); handler) {
+                            upgrade(conn, state, view, stl::move(handler), input.substr(consumed));
+                            return;
+                        }
+                    }
+                }
+                auto const keep_alive = serve(conn, state, view, input.substr(0, consumed));
+                input.remove_prefix(consumed);
+                total_consumed += consumed;
+                if (state.serving)
+                    break; // the rest waits for the task
+                if (state.event_stream) {
+                    // the stream is the rest of this connection
+                    state.pending.clear();
+                    conn.busy(false);
+                    return;
+                }
+                if (!keep_alive) {
+                    conn.close_after_write();
+                    state.pending.clear();
+                    return;
+                }
+            }
+
+            // keep the incomplete request for the next read
+            if (state.pending.empty()) {
+                state.pending.assign(input);
+            } else {
+                state.pending.erase(0, total_consumed);
+            }
+            conn.busy(state.serving || !state.pending.empty());
+        }
+
+        /**
+         * The endpoints that we're going to listen on; the default address and
+         * port are used if the user hasn't specified any.
+         */
+        [[nodiscard]] stl::vector<endpoint_t> listen_endpoints() const noexcept {
+            stl::vector<endpoint_t> endpoints{_endpoints.begin(), _endpoints.end()};
+            if (endpoints.empty()) {
+                istl::net_error_code ec;
+                auto const           address = stl::net::ip::make_address(default_self_hosted_listen_addr, ec);
+                endpoints.emplace_back(ec ? stl::net::ip::address_v4::loopback() : address,
+                                       static_cast<unsigned short>(default_self_hosted_listen_port));
+            }
+            return endpoints;
+        }
+
+        void operator()() noexcept {
+            if (_adopted.empty()) {
+                _server.emplace(listen_endpoints(), default_max_connections, _concurrency);
+            } else {
+                _server.emplace(stl::vector<endpoint_t>{}, default_max_connections, _concurrency);
+#ifdef __unix__
+                for (auto const handle : _adopted)
+                    _server->adopt(handle);
+#endif
+            }
+            _server->on_connection([this] {
+                return [this, state = connection_state{}](common::connection& conn,
+                                                          stl::string_view    data) mutable noexcept {
+                    handle(conn, state, data);
+                };
+            });
+            if (_metrics != nullptr)
+                _server->metrics(*_metrics);
+            if (_shedding)
+                _server->shedding(*_shedding);
+#ifdef WEBPP_USE_TLS
+            stl::optional<common::tls_context> tls_ctx;
+            if (_tls) {
+                tls_ctx.emplace(*_tls);
+                if (!tls_ctx->is_valid()) {
+                    // it's never served in plain text instead
+                    log_error("can't serve TLS: {}", tls_ctx->error());
+                    return;
+                }
+                _server->tls(*tls_ctx);
+            }
+#else
+            if (_tls) {
+                log_error("can't serve TLS: webpp is built without it (see the WEBPP_TLS option)");
+                return;
+            }
+#endif
+            _server->run();
+        }
+
+        /**
+         * This will only work before you run the operator()
+         */
+        void add_endpoint(endpoint_t _endpoint) noexcept {
+            _endpoints.insert(stl::move(_endpoint));
+        }
+
+        /**
+         * This will only work before you run the operator()
+         */
+        void add_endpoint(stl::string_view const& addr, uint_fast16_t port) noexcept {
+            istl::net_error_code ec;
+            auto const           address = stl::net::ip::make_address(addr, ec);
+            if (!ec)
+                _endpoints.emplace(address, port);
+        }
+
+        /**
+         * The number of worker threads; zero means one per core.
+         * This will only work before you run the operator()
+         */
+        void concurrency(stl::size_t count) noexcept {
+            _concurrency = count;
+        }
+
+        /**
+         * The biggest request body that is accepted; the bigger ones are
+         * answered with a 413 before their body is read, and the connection
+         * is closed. It's default_max_body_size by default.
+         */
+        void max_body_size(stl::size_t size) noexcept {
+            _max_body_size = size;
+        }
+
+        /**
+         * Accept on the listening sockets that are already open (the ones
+         * that a prefork master opened, see http::run) instead of the
+         * endpoints; the server owns them. This will only work before you
+         * run the operator()
+         */
+        void adopt_listeners(stl::span<int const> handles) noexcept {
+            _adopted.assign(handles.begin(), handles.end());
+        }
+
+        /**
+         * Compress the responses for the clients that accept it (gzip or
+         * brotli, see compress_response); it's off by default.
+         */
+        void compression(compression_options const& options = {}) noexcept {
+            _compression = options;
+        }
+
+        /**
+         * Answer the requests with a 503 when the server falls behind, instead
+         * of letting the latency grow (see load_shedder); it's off by default.
+         * This will only work before you run the operator()
+         */
+        void shedding(shedding_options const& options = {}) noexcept {
+            _shedding = options;
+        }
+
+        /**
+         * Serve HTTPS with the certificate and the key of the options; the
+         * kernel encrypts the records if it can (see common::tls_options).
+         * This will only work before you run the operator()
+         */
+        void tls(common::tls_options const& options) noexcept {
+            _tls = options;
+        }
+
+        /**
+         * Count the connections, and the bytes that they read and write, into
+         * the registry (see common::server::metrics); the registry should
+         * outlive the server. This will only work before you run the
+         * operator()
+         */
+        void metrics(metrics_registry& registry) noexcept {
+            _metrics = &registry;
+        }
+
+        /**
+         * Log the requests (their method, target, status, and the time that
+         * the application took) at the info level; see logger. It's off by
+         * default.
+         */
+        void access_log(bool enabled = true) noexcept {
+            _access_log = enabled;
+        }
+
+        /**
+         * Stop the server that is running in operator()
+         */
+        void stop() noexcept {
+            if (_server)
+                _server->stop();
+        }
+    };
+
+    /**
+     * The request of the simple server; it only holds views into the
+     * connection's buffer (and the connection's address of the client), so
+     * it's only valid while the application is handling it. The requests of
+     * the tasks hold views into their own copy, and the token of their
+     * connection.
+     */
+    template <Traits TraitsType, Application App>
+    struct basic_request<TraitsType, simple_server<TraitsType, App>>
+      : public request_body_parsers<basic_request<TraitsType, simple_server<TraitsType, App>>> {
+        using traits_type      = TraitsType;
+        using interface_type   = simple_server<TraitsType, App>;
+        using string_view_type = typename traits_type::string_view_type;
+
       private:
+        http1::request_view const&                            view;
+        mutable lazy_header_index<http1::default_max_headers> header_index;
+        cancellation_token                                    token{};
+        string_view_type                                      remote{};
+
       public:
+        basic_request(http1::request_view const& _view, string_view_type _remote = {}) noexcept
+          : view{_view},
+            remote{_remote} {
+        }
+
+        basic_request(http1::request_view const& _view,
+                      cancellation_token         _token,
+                      string_view_type           _remote = {}) noexcept
+          : view{_view},
+            token{stl::move(_token)},
+            remote{_remote} {
+        }
+
+        /**
+         * It's cancelled when the client goes away (see basic_context::cancellation)
+         */
+        [[nodiscard]] cancellation_token const& cancellation() const noexcept {
+            return token;
+        }
+
+        [[nodiscard]] string_view_type request_method() const noexcept {
+            return view.method;
+        }
+
+        [[nodiscard]] string_view_type request_uri() const noexcept {
+            return view.target;
+        }
+
+        [[nodiscard]] string_view_type server_protocol() const noexcept {
+            return view.version_minor == 0 ? "HTTP/1.0" : "HTTP/1.1";
+        }
+
+        /**
+         * The address of the client, without the port (REMOTE_ADDR in CGI)
+         */
+        [[nodiscard]] string_view_type remote_address() const noexcept {
+            return remote;
+        }
+
+        /**
+         * Get a specific header by it's name
+         */
+        [[nodiscard]] string_view_type header(string_view_type name) const noexcept {
+            return header_index.find(name, [this](auto& add) {
+                for (stl::size_t i = 0; i < view.header_count; i++)
+                    add(view.headers[i].name, view.headers[i].value);
+            });
+        }
+
+        [[nodiscard]] string_view_type body() const noexcept {
+            return view.body;
+        }
     };
 
 } // namespace webpp
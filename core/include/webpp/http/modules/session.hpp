@@ -22,55 +22,53 @@
  *    - [ ] In a folder
  *    - [ ] In predefined file (your own thing)
  *    - [ ] In cutsom file (json, xml, Excel, ...)
- *    - [ ] In memory (for long lived versions of builds like FastCGI)
+ *    - [X] In memory (for long lived versions of builds like FastCGI)
  *    - [ ] In cookies (encrypted or plain text)
  *    - [ ] In predefined database (sqlite)
  *    - [ ] In custom database (User configured database)
+ *    - [X] In a Redis server (server-adapter/redis_adapter.hpp, for more than one node)
  */
 
 #include "session/client-adapter/cookie_adapter.hpp"
 #include "session/server-adapter/memory_adapter.hpp"
+#include "session/session_writer.hpp"
 
 #include <memory>
+#include <optional>
 #include <string>
-#include <thread>
-#include <type_traits>
+#include <string_view>
+#include <utility>
 
 namespace webpp {
 
+    template <typename Session>
+    class lazy_session;
+
+    /**
+     * The sessions share their server adapter (the store of all of the sessions), so it's created once
+     * and handed to them; and a session_writer too, if the adapter is slow to write to. The sessions
+     * that are set through a writer are not seen by "get" until they're written.
+     */
     template <class ServerAdapter = webpp::memory_adapter,
               class ClientAdapter = webpp::cookie_adapter>
     class session {
       public:
-        using key_t = std::string;
+        using key_t      = std::string;
+        using value_type = typename ServerAdapter::value_type;
+        using writer_t   = session_writer<ServerAdapter>;
 
       protected:
-        /**
-         * @brief The cache for the ServerAdapter in sessions.
-         */
-        class cache_proxy_t {
-          private:
-            std::thread tr;
-            bool        _cache_enabled =
-              !std::is_same<ServerAdapter, memory_adapter>::value;
-
-          public:
-            cache_proxy_t(
-              std::unique_ptr<ServerAdapter>&& server_adapter) noexcept
-              : tr(server_adapter) {
-            }
-
-            ~cache_proxy_t() noexcept {
-                if (tr.joinable())
-                    tr.join();
-            }
-        } proxy;
+        std::shared_ptr<ServerAdapter> _server_adapter;
+        std::shared_ptr<ClientAdapter> _client_adapter;
+        std::shared_ptr<writer_t>      _writer;
 
       public:
-        session(decltype(_server_adapter)&& server_adapter = nullptr,
-                decltype(_client_adapter)&& client_adapter = nullptr) noexcept
+        session(std::shared_ptr<ServerAdapter> server_adapter = nullptr,
+                std::shared_ptr<ClientAdapter> client_adapter = nullptr,
+                std::shared_ptr<writer_t>      writer         = nullptr)
           : _server_adapter{std::move(server_adapter)},
-            _client_adapter{std::move(client_adapter)} {
+            _client_adapter{std::move(client_adapter)},
+            _writer{std::move(writer)} {
             if (!_server_adapter)
                 _server_adapter = std::make_shared<ServerAdapter>();
 
@@ -78,9 +76,148 @@ namespace webpp {
                 _client_adapter = std::make_shared<ClientAdapter>();
         }
 
-        template <typename T>
-        T& get(session::key_t key) noexcept {
-            return proxy.get(key);
+        auto get(key_t const& key) const {
+            return _server_adapter->get(key);
+        }
+
+        void set(key_t const& key, value_type value) {
+            if (_writer)
+                _writer->write(key, std::move(value));
+            else
+                _server_adapter->set(key, std::move(value));
+        }
+
+        void erase(key_t const& key) {
+            if (_writer)
+                _writer->flush(); // so a queued write doesn't bring it back
+            _server_adapter->erase(key);
+        }
+
+        /**
+         * The session of a request; nothing is read until it's used, and nothing is written unless
+         * it's changed.
+         */
+        lazy_session<session> open(std::string_view id) {
+            return {*this, id};
+        }
+
+        ServerAdapter& server_adapter() noexcept {
+            return *_server_adapter;
+        }
+    };
+
+    /**
+     * The session of one request. Most of the requests don't touch their session, so it's read from
+     * the server adapter on the first access, and written back when it's destroyed (or saved) only if
+     * it's changed; the ones that are never used cost no session I/O at all.
+     *
+     * The sessions store must outlive it.
+     *
+     *   auto data = sessions.open(id);
+     *   if (some_condition)
+     *       data.mutate() += "more";
+     */
+    template <typename Session>
+    class lazy_session {
+      public:
+        using value_type = typename Session::value_type;
+
+      private:
+        Session*                  store;
+        std::string               _id;
+        std::optional<value_type> data{};
+        bool                      loaded = false;
+        bool                      dirty  = false;
+
+        void load() {
+            if (!loaded) {
+                data   = store->get(_id);
+                loaded = true;
+            }
+        }
+
+      public:
+        lazy_session(Session& sessions, std::string_view id) : store{&sessions}, _id{id} {}
+
+        lazy_session(lazy_session&& other) noexcept
+          : store{other.store},
+            _id{std::move(other._id)},
+            data{std::move(other.data)},
+            loaded{other.loaded},
+            dirty{std::exchange(other.dirty, false)} {}
+
+        lazy_session(lazy_session const&)            = delete;
+        lazy_session& operator=(lazy_session const&) = delete;
+        lazy_session& operator=(lazy_session&&)      = delete;
+
+        ~lazy_session() {
+            save();
+        }
+
+        [[nodiscard]] std::string_view id() const noexcept {
+            return _id;
+        }
+
+        /**
+         * The data of the session; it's read the first time
+         */
+        [[nodiscard]] std::optional<value_type> const& value() {
+            load();
+            return data;
+        }
+
+        [[nodiscard]] bool has_value() {
+            return value().has_value();
+        }
+
+        /**
+         * The data of the session to be changed in place; it's created if there's none
+         */
+        [[nodiscard]] value_type& mutate() {
+            load();
+            if (!data)
+                data.emplace();
+            dirty = true;
+            return *data;
+        }
+
+        /**
+         * Replace the data of the session; the old one is not read
+         */
+        void set(value_type value) {
+            data.emplace(std::move(value));
+            loaded = true;
+            dirty  = true;
+        }
+
+        /**
+         * Remove the session from the store when it's saved
+         */
+        void erase() {
+            data.reset();
+            loaded = true;
+            dirty  = true;
+        }
+
+        /**
+         * Write the session back if it's changed; it's called when it's destroyed too.
+         */
+        void save() {
+            if (!dirty)
+                return;
+            dirty = false;
+            if (data)
+                store->set(_id, *data);
+            else
+                store->erase(_id);
+        }
+
+        [[nodiscard]] bool is_loaded() const noexcept {
+            return loaded;
+        }
+
+        [[nodiscard]] bool is_dirty() const noexcept {
+            return dirty;
         }
     };
 
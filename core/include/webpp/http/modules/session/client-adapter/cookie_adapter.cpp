@@ -1,4 +0,0 @@
-#include "cookie_adapter.hpp"
-
-webpp::cookie_adapter::cookie_adapter() {
-}
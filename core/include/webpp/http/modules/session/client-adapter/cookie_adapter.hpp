@@ -5,7 +5,7 @@ namespace webpp {
 
     class cookie_adapter {
       public:
-        cookie_adapter();
+        cookie_adapter() = default;
     };
 } // namespace webpp
 
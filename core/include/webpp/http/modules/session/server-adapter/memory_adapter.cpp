@@ -1,4 +0,0 @@
-#include "memory_adapter.hpp"
-
-webpp::memory_adapter::memory_adapter() {
-}
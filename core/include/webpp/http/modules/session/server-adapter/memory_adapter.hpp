@@ -1,13 +1,271 @@
 #ifndef MEMORY_ADAPTER_H
 #define MEMORY_ADAPTER_H
 
+#include "../../../../std/std.hpp"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
 namespace webpp {
 
-    class memory_adapter {
+    /**
+     * A steady clock with a resolution of a few milliseconds (CLOCK_MONOTONIC_COARSE of Linux); it
+     * doesn't read the TSC, which waits for the loads before it to finish, so it doesn't stall the
+     * lookups that it's used in. The TTLs of the sessions don't need a better one.
+     */
+    struct coarse_steady_clock {
+        using duration   = stl::chrono::nanoseconds;
+        using rep        = duration::rep;
+        using period     = duration::period;
+        using time_point = stl::chrono::time_point<coarse_steady_clock>;
+
+        static constexpr bool is_steady = true;
+
+        static time_point now() noexcept {
+#ifdef CLOCK_MONOTONIC_COARSE
+            timespec ts{};
+            ::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+            return time_point{stl::chrono::seconds{ts.tv_sec} + stl::chrono::nanoseconds{ts.tv_nsec}};
+#else
+            return time_point{stl::chrono::duration_cast<duration>(
+              stl::chrono::steady_clock::now().time_since_epoch())};
+#endif
+        }
+    };
+
+    /**
+     * The sessions of a long-running server (FastCGI, or the self-hosted ones), in memory; the session
+     * ids are spread over the shards, and each shard has its own lock, so the workers that handle the
+     * requests of different sessions don't wait for each other.
+     *
+     * The sessions expire after their TTL; the expired ones are not found anymore, and a sweeper thread
+     * removes them from the shards every "sweep_interval", one shard at a time.
+     *
+     *   memory_adapter sessions{std::chrono::minutes{30}};
+     *   sessions.set(id, data);
+     *   if (auto data = sessions.get(id)) ...
+     */
+    template <typename ValueType = stl::string, typename Clock = coarse_steady_clock>
+    class basic_memory_adapter {
+      public:
+        using value_type = ValueType;
+        using clock_type = Clock;
+        using duration   = typename Clock::duration;
+        using time_point = typename Clock::time_point;
+
+        static constexpr stl::size_t shard_count = 64;
+
+      private:
+        struct entry {
+            value_type value;
+            time_point expires;
+        };
+
+        struct key_hash {
+            using is_transparent = void;
+
+            stl::size_t operator()(stl::string_view key) const noexcept {
+                return stl::hash<stl::string_view>{}(key);
+            }
+        };
+
+        using map_type = stl::unordered_map<stl::string, entry, key_hash, stl::equal_to<>>;
+
+        struct alignas(64) shard {
+            mutable stl::shared_mutex lock;
+            map_type                  map;
+        };
+
+        stl::unique_ptr<stl::array<shard, shard_count>> shards =
+          stl::make_unique<stl::array<shard, shard_count>>();
+        duration                 ttl;
+        duration                 sweep_interval;
+        stl::atomic<stl::size_t> count{0};
+
+        stl::mutex              sweeper_lock;
+        stl::condition_variable sweeper_wake;
+        bool                    stopping = false;
+        stl::thread             sweeper;
+
+        [[nodiscard]] shard& shard_of(stl::string_view key) const noexcept {
+            // the high bits pick the shard; the map of the shard uses the low ones for its buckets
+            auto const hash = static_cast<stl::uint64_t>(key_hash{}(key)) * 0x9E37'79B9'7F4A'7C15ULL;
+            return (*shards)[hash >> (64 - stl::countr_zero(shard_count))];
+        }
+
+        void sweep_loop() {
+            stl::unique_lock guard{sweeper_lock};
+            while (!sweeper_wake.wait_for(guard, sweep_interval, [this] {
+                return stopping;
+            })) {
+                guard.unlock();
+                sweep();
+                guard.lock();
+            }
+        }
+
       public:
-        memory_adapter();
+        /**
+         * @param default_ttl the TTL of the sessions that are set without one
+         * @param sweep_every how often the expired sessions are removed; zero means there's no sweeper
+         *        thread, and "sweep" is called by the user
+         */
+        explicit basic_memory_adapter(duration default_ttl = stl::chrono::minutes{30},
+                                      duration sweep_every = stl::chrono::seconds{10})
+          : ttl{default_ttl},
+            sweep_interval{sweep_every} {
+            if (sweep_interval > duration::zero())
+                sweeper = stl::thread{[this] {
+                    sweep_loop();
+                }};
+        }
+
+        basic_memory_adapter(basic_memory_adapter const&)            = delete;
+        basic_memory_adapter& operator=(basic_memory_adapter const&) = delete;
+
+        ~basic_memory_adapter() {
+            if (!sweeper.joinable())
+                return;
+            {
+                stl::scoped_lock const guard{sweeper_lock};
+                stopping = true;
+            }
+            sweeper_wake.notify_one();
+            sweeper.join();
+        }
+
+        /**
+         * Set the value of the session; it expires after the TTL.
+         */
+        void set(stl::string_view id, value_type value, duration session_ttl) {
+            auto&                  s       = shard_of(id);
+            auto const             expires = clock_type::now() + session_ttl;
+            stl::scoped_lock const guard{s.lock};
+            if (auto it = s.map.find(id); it != s.map.end()) {
+                it->second = entry{stl::move(value), expires};
+            } else {
+                s.map.emplace(stl::string{id}, entry{stl::move(value), expires});
+                count.fetch_add(1, stl::memory_order_relaxed);
+            }
+        }
+
+        void set(stl::string_view id, value_type value) {
+            set(id, stl::move(value), ttl);
+        }
+
+        /**
+         * A copy of the value of the session, if it's there and it's not expired
+         */
+        [[nodiscard]] stl::optional<value_type> get(stl::string_view id) const {
+            stl::optional<value_type> res;
+            visit(id, [&res](value_type const& value) {
+                res.emplace(value);
+            });
+            return res;
+        }
+
+        /**
+         * Call the function with the value of the session (without copying it); the shard is locked for
+         * reading while it's called, so don't call the adapter from it.
+         * @returns false if there's no such session, or it's expired
+         */
+        template <typename Func>
+        bool visit(stl::string_view id, Func&& func) const {
+            auto const&            s   = shard_of(id);
+            auto const             now = clock_type::now();
+            stl::shared_lock const guard{s.lock};
+            auto const             it = s.map.find(id);
+            if (it == s.map.end() || it->second.expires <= now)
+                return false;
+            stl::invoke(stl::forward<Func>(func), it->second.value);
+            return true;
+        }
+
+        /**
+         * Extend the session by the TTL, from now (the sliding sessions)
+         * @returns false if there's no such session, or it's expired
+         */
+        bool touch(stl::string_view id, duration session_ttl) {
+            auto&                  s   = shard_of(id);
+            auto const             now = clock_type::now();
+            stl::scoped_lock const guard{s.lock};
+            auto const             it = s.map.find(id);
+            if (it == s.map.end() || it->second.expires <= now)
+                return false;
+            it->second.expires = now + session_ttl;
+            return true;
+        }
+
+        bool touch(stl::string_view id) {
+            return touch(id, ttl);
+        }
+
+        bool erase(stl::string_view id) {
+            auto&                  s = shard_of(id);
+            stl::scoped_lock const guard{s.lock};
+            auto const             it = s.map.find(id);
+            if (it == s.map.end())
+                return false;
+            s.map.erase(it);
+            count.fetch_sub(1, stl::memory_order_relaxed);
+            return true;
+        }
+
+        /**
+         * Remove the expired sessions; the sweeper calls it, one shard is locked at a time.
+         * @returns the number of the removed sessions
+         */
+        stl::size_t sweep() {
+            stl::size_t removed = 0;
+            for (auto& s : *shards) {
+                auto const             now = clock_type::now();
+                stl::scoped_lock const guard{s.lock};
+                removed += stl::erase_if(s.map, [now](auto const& item) {
+                    return item.second.expires <= now;
+                });
+            }
+            count.fetch_sub(removed, stl::memory_order_relaxed);
+            return removed;
+        }
+
+        void clear() {
+            for (auto& s : *shards) {
+                stl::scoped_lock const guard{s.lock};
+                count.fetch_sub(s.map.size(), stl::memory_order_relaxed);
+                s.map.clear();
+            }
+        }
+
+        /**
+         * The number of the sessions, the expired ones that are not swept yet too
+         */
+        [[nodiscard]] stl::size_t size() const noexcept {
+            return count.load(stl::memory_order_relaxed);
+        }
+
+        [[nodiscard]] duration default_ttl() const noexcept {
+            return ttl;
+        }
     };
 
+    using memory_adapter = basic_memory_adapter<>;
+
 } // namespace webpp
 
 #endif // MEMORY_ADAPTER_H
@@ -0,0 +1,458 @@
+#ifndef WEBPP_REDIS_ADAPTER_H
+#define WEBPP_REDIS_ADAPTER_H
+
+#include "../../../../std/internet.hpp"
+#include "../../../../std/socket.hpp"
+#include "../../../../std/std.hpp"
+#include "./memory_adapter.hpp"
+
+#include <array>
+#include <boost/asio/post.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/write.hpp>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace webpp {
+
+    namespace details {
+
+        /**
+         * Append a command in RESP (the protocol of Redis, and the servers that speak it) to "out"
+         */
+        inline void append_resp_command(stl::string& out, stl::initializer_list<stl::string_view> args) {
+            auto const append_number = [&out](stl::size_t number) {
+                char       digits[24];
+                auto const res = stl::to_chars(digits, digits + sizeof(digits), number);
+                out.append(digits, res.ptr);
+            };
+            out += '*';
+            append_number(args.size());
+            out += "\r\n";
+            for (auto const arg : args) {
+                out += '$';
+                append_number(arg.size());
+                out += "\r\n";
+                out += arg;
+                out += "\r\n";
+            }
+        }
+
+        /**
+         * A reply of the server; the value is a view into the buffer that it's parsed from
+         */
+        struct resp_reply {
+            enum struct type : stl::uint8_t { simple, bulk, nil, integer, error };
+
+            type             kind = type::nil;
+            stl::string_view value{};
+            stl::int64_t     integer = 0;
+        };
+
+        /**
+         * Parse the reply at the start of the buffer; the arrays are not used by the commands of the
+         * adapters, so they're not parsed.
+         * @returns the size of the reply, 0 if it's not all in the buffer yet, or npos if it's broken
+         */
+        inline stl::size_t parse_resp_reply(stl::string_view buf, resp_reply& reply) noexcept {
+            constexpr auto npos     = stl::string_view::npos;
+            auto const     line_end = buf.find("\r\n");
+            if (line_end == npos)
+                return 0;
+            if (line_end == 0)
+                return npos;
+            auto const line      = buf.substr(1, line_end - 1);
+            auto const parse_int = [](stl::string_view str, stl::int64_t& out) noexcept {
+                auto const [ptr, ec] = stl::from_chars(str.data(), str.data() + str.size(), out);
+                return ec == stl::errc{} && ptr == str.data() + str.size();
+            };
+            switch (buf.front()) {
+                case '+':
+                    reply.kind  = resp_reply::type::simple;
+                    reply.value = line;
+                    return line_end + 2;
+                case '-':
+                    reply.kind  = resp_reply::type::error;
+                    reply.value = line;
+                    return line_end + 2;
+                case ':':
+                    if (!parse_int(line, reply.integer))
+                        return npos;
+                    reply.kind = resp_reply::type::integer;
+                    return line_end + 2;
+                case '$': {
+                    stl::int64_t size = 0;
+                    if (!parse_int(line, size) || size < -1)
+                        return npos;
+                    if (size == -1) {
+                        reply.kind = resp_reply::type::nil;
+                        return line_end + 2;
+                    }
+                    auto const total = line_end + 2 + static_cast<stl::size_t>(size) + 2;
+                    if (buf.size() < total)
+                        return 0;
+                    if (buf.substr(total - 2, 2) != "\r\n")
+                        return npos;
+                    reply.kind  = resp_reply::type::bulk;
+                    reply.value = buf.substr(line_end + 2, static_cast<stl::size_t>(size));
+                    return total;
+                }
+                default: return npos;
+            }
+        }
+
+    } // namespace details
+
+    struct redis_adapter_options {
+        stl::string                   key_prefix     = "session:";
+        coarse_steady_clock::duration ttl            = stl::chrono::minutes{30};
+        coarse_steady_clock::duration near_cache_ttl = stl::chrono::seconds{1}; // zero means there's none
+    };
+
+    /**
+     * The sessions in a Redis server (or the ones that speak its protocol), for the servers that run
+     * on more than one node.
+     *
+     * All of the requests share one connection, and their commands are pipelined: they're written
+     * together while the replies of the previous ones are on their way, and the replies are matched to
+     * them in order. The handlers are called on the io_context (don't block in them).
+     *
+     * The sessions that are read or written are kept in a near-cache for a short TTL (a second by
+     * default), so the requests of a session that come back to back don't go to the server; the
+     * changes of the other nodes are seen after that TTL.
+     *
+     *   redis_adapter sessions{io, endpoint};
+     *   sessions.async_get(id, [](std::optional<std::string> data) { ... });
+     *   sessions.set(id, data); // pipelined, it doesn't wait for the reply
+     */
+    class redis_adapter {
+      public:
+        using value_type   = stl::string;
+        using duration     = coarse_steady_clock::duration;
+        using tcp          = stl::net::ip::tcp;
+        using get_handler  = stl::function<void(stl::optional<value_type>)>;
+        using done_handler = stl::function<void(bool)>;
+
+        using options      = redis_adapter_options;
+
+      private:
+        // the handler of a reply; it gets a null if the connection is lost before the reply comes
+        using reply_type    = details::resp_reply;
+        using reply_handler = stl::function<void(reply_type const*)>;
+
+        using strand_type = stl::net::strand<stl::net::io_context::executor_type>;
+
+        /**
+         * The connection and its pipeline; the callbacks hold it, so it outlives the adapter until
+         * they're done. The socket is only touched in the strand.
+         */
+        struct connection : stl::enable_shared_from_this<connection> {
+            enum struct state : stl::uint8_t { closed, connecting, open };
+
+            strand_type   strand;
+            tcp::socket   socket;
+            tcp::endpoint endpoint;
+
+            stl::mutex                lock;
+            stl::string               outbox{};       // the commands that are not written yet
+            stl::deque<reply_handler> waiting{};      // the handlers of the commands, in order
+            state                     status     = state::closed;
+            bool                      writing    = false;
+            stl::uint64_t             generation = 0; // of the socket; the callbacks of the old ones stop
+
+            // only touched in the strand
+            stl::string                 sending{};
+            stl::string                 inbox{};
+            stl::array<char, 16 * 1024> chunk{};
+
+            connection(stl::net::io_context& io, tcp::endpoint server)
+              : strand{stl::net::make_strand(io)},
+                socket{strand},
+                endpoint{server} {}
+
+            void submit(stl::string command, reply_handler handler) {
+                bool connect_now = false;
+                bool write_now   = false;
+                {
+                    stl::scoped_lock const guard{lock};
+                    outbox += command;
+                    waiting.push_back(stl::move(handler));
+                    if (status == state::closed) {
+                        status      = state::connecting;
+                        connect_now = true;
+                    } else if (status == state::open && !writing) {
+                        writing   = true;
+                        write_now = true;
+                    }
+                }
+                if (connect_now) {
+                    stl::net::post(strand, [self = this->shared_from_this()] {
+                        self->connect();
+                    });
+                } else if (write_now) {
+                    stl::net::post(strand, [self = this->shared_from_this()] {
+                        self->write();
+                    });
+                }
+            }
+
+            void connect() {
+                stl::uint64_t gen = 0;
+                {
+                    stl::scoped_lock const guard{lock};
+                    gen = ++generation;
+                }
+                socket.async_connect(endpoint,
+                                     [self = this->shared_from_this(), gen](istl::net_error_code const& ec) {
+                                         if (!self->is_current(gen))
+                                             return;
+                                         if (ec) {
+                                             self->fail();
+                                             return;
+                                         }
+                                         istl::net_error_code ignored;
+                                         self->socket.set_option(tcp::no_delay{true}, ignored);
+                                         bool write_now = false;
+                                         {
+                                             stl::scoped_lock const guard{self->lock};
+                                             self->status = state::open;
+                                             if (!self->outbox.empty() && !self->writing) {
+                                                 self->writing = true;
+                                                 write_now     = true;
+                                             }
+                                         }
+                                         if (write_now)
+                                             self->write();
+                                         self->read(gen);
+                                     });
+            }
+
+            [[nodiscard]] bool is_current(stl::uint64_t gen) {
+                stl::scoped_lock const guard{lock};
+                return gen == generation && status != state::closed;
+            }
+
+            // everything that's in the outbox goes in one write
+            void write() {
+                stl::uint64_t gen = 0;
+                {
+                    stl::scoped_lock const guard{lock};
+                    sending.clear();
+                    sending.swap(outbox);
+                    gen = generation;
+                }
+                stl::net::async_write(
+                  socket,
+                  stl::net::buffer(sending),
+                  [self = this->shared_from_this(), gen](istl::net_error_code const& ec, stl::size_t) {
+                      if (!self->is_current(gen))
+                          return;
+                      if (ec) {
+                          self->fail();
+                          return;
+                      }
+                      bool more = false;
+                      {
+                          stl::scoped_lock const guard{self->lock};
+                          more = !self->outbox.empty();
+                          if (!more)
+                              self->writing = false;
+                      }
+                      if (more)
+                          self->write();
+                  });
+            }
+
+            void read(stl::uint64_t gen) {
+                socket.async_read_some(
+                  stl::net::buffer(chunk),
+                  [self = this->shared_from_this(), gen](istl::net_error_code const& ec, stl::size_t size) {
+                      if (!self->is_current(gen))
+                          return;
+                      if (ec) {
+                          self->fail();
+                          return;
+                      }
+                      self->inbox.append(self->chunk.data(), size);
+                      if (self->deliver())
+                          self->read(gen);
+                  });
+            }
+
+            // call the handlers of the replies that are in the inbox
+            bool deliver() {
+                stl::size_t offset = 0;
+                for (;;) {
+                    details::resp_reply reply;
+                    auto const          rest = stl::string_view{inbox}.substr(offset);
+                    auto const          size = details::parse_resp_reply(rest, reply);
+                    if (size == 0)
+                        break;
+                    reply_handler handler;
+                    {
+                        stl::scoped_lock const guard{lock};
+                        if (size != stl::string_view::npos && !waiting.empty()) {
+                            handler = stl::move(waiting.front());
+                            waiting.pop_front();
+                        }
+                    }
+                    if (!handler) {
+                        fail(); // a broken reply, or one that nothing's waiting for
+                        return false;
+                    }
+                    handler(&reply);
+                    offset += size;
+                }
+                inbox.erase(0, offset);
+                return true;
+            }
+
+            void fail() {
+                stl::deque<reply_handler> lost;
+                {
+                    stl::scoped_lock const guard{lock};
+                    status  = state::closed;
+                    writing = false;
+                    outbox.clear();
+                    lost.swap(waiting);
+                }
+                istl::net_error_code ignored;
+                socket.close(ignored);
+                inbox.clear();
+                for (auto& handler : lost)
+                    if (handler)
+                        handler(nullptr);
+            }
+        };
+
+        options                                           opts;
+        stl::shared_ptr<connection>                       conn;
+        stl::shared_ptr<basic_memory_adapter<value_type>> near_cache{};
+
+        [[nodiscard]] stl::string key_of(stl::string_view id) const {
+            stl::string key;
+            key.reserve(opts.key_prefix.size() + id.size());
+            key += opts.key_prefix;
+            key += id;
+            return key;
+        }
+
+      public:
+        redis_adapter(stl::net::io_context& io, tcp::endpoint endpoint, options adapter_options = {})
+          : opts{stl::move(adapter_options)},
+            conn{stl::make_shared<connection>(io, endpoint)} {
+            using cache_type = basic_memory_adapter<value_type>;
+            if (opts.near_cache_ttl > duration::zero())
+                near_cache = stl::make_shared<cache_type>(opts.near_cache_ttl, opts.near_cache_ttl);
+        }
+
+        redis_adapter(redis_adapter const&)            = delete;
+        redis_adapter& operator=(redis_adapter const&) = delete;
+
+        /**
+         * The connection is closed; the handlers of the commands that are not replied get nothing.
+         */
+        ~redis_adapter() {
+            stl::net::post(conn->strand, [self = conn] {
+                self->fail();
+            });
+        }
+
+        /**
+         * Fetch the session; the handler gets nothing if there's no such session, or the server can't
+         * be reached. It's called right away if the session is in the near-cache.
+         */
+        void async_get(stl::string_view id, get_handler handler) {
+            if (near_cache) {
+                if (auto value = near_cache->get(id)) {
+                    handler(stl::move(value));
+                    return;
+                }
+            }
+            stl::string command;
+            details::append_resp_command(command, {"GET", key_of(id)});
+            conn->submit(stl::move(command),
+                         [cache = near_cache, id = stl::string{id}, handler = stl::move(handler)](
+                           details::resp_reply const* reply) {
+                             if (reply == nullptr || reply->kind != details::resp_reply::type::bulk) {
+                                 handler(stl::nullopt);
+                                 return;
+                             }
+                             value_type value{reply->value};
+                             if (cache)
+                                 cache->set(id, value);
+                             handler(stl::move(value));
+                         });
+        }
+
+        void async_set(stl::string_view id, value_type value, duration ttl, done_handler handler = {}) {
+            auto const millis = stl::chrono::duration_cast<stl::chrono::milliseconds>(ttl).count();
+            char       digits[24];
+            auto const res = stl::to_chars(digits, digits + sizeof(digits), millis);
+            stl::string_view const px{digits, static_cast<stl::size_t>(res.ptr - digits)};
+            stl::string            command;
+            details::append_resp_command(command, {"SET", key_of(id), value, "PX", px});
+            if (near_cache)
+                near_cache->set(id, stl::move(value));
+            conn->submit(stl::move(command), [handler = stl::move(handler)](reply_type const* reply) {
+                if (handler)
+                    handler(reply != nullptr && reply->kind == reply_type::type::simple);
+            });
+        }
+
+        void async_erase(stl::string_view id, done_handler handler = {}) {
+            if (near_cache)
+                near_cache->erase(id);
+            stl::string command;
+            details::append_resp_command(command, {"DEL", key_of(id)});
+            conn->submit(stl::move(command), [handler = stl::move(handler)](reply_type const* reply) {
+                if (handler)
+                    handler(reply != nullptr && reply->kind == reply_type::type::integer &&
+                            reply->integer > 0);
+            });
+        }
+
+        /**
+         * Wait for the session; don't call it from the thread that runs the io_context.
+         */
+        [[nodiscard]] stl::optional<value_type> get(stl::string_view id) {
+            auto promise = stl::make_shared<stl::promise<stl::optional<value_type>>>();
+            auto future  = promise->get_future();
+            async_get(id, [promise](stl::optional<value_type> value) {
+                promise->set_value(stl::move(value));
+            });
+            return future.get();
+        }
+
+        /**
+         * Set the session; it doesn't wait for the reply
+         */
+        void set(stl::string_view id, value_type value, duration ttl) {
+            async_set(id, stl::move(value), ttl);
+        }
+
+        void set(stl::string_view id, value_type value) {
+            async_set(id, stl::move(value), opts.ttl);
+        }
+
+        void erase(stl::string_view id) {
+            async_erase(id);
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_REDIS_ADAPTER_H
@@ -0,0 +1,155 @@
+#ifndef WEBPP_SESSION_WRITER_H
+#define WEBPP_SESSION_WRITER_H
+
+#include "../../../std/std.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace webpp {
+
+    /**
+     * Writes the changed sessions back to a server adapter that's slow to write to (a file, a database),
+     * so the requests don't wait for it. There's one writer for all of the sessions: the requests put
+     * the sessions in a bounded queue, and its thread writes them in batches. A session that's changed
+     * again before it's written is written once.
+     *
+     * The queue doesn't grow: when it's full, "push" returns false and the caller writes the session
+     * itself, so the writes slow the requests down instead of piling up.
+     */
+    template <typename ServerAdapter>
+    class session_writer {
+      public:
+        using value_type = typename ServerAdapter::value_type;
+
+        static constexpr stl::size_t default_capacity = 4096;
+
+      private:
+        struct pending {
+            stl::string id;
+            value_type  value;
+        };
+
+        ServerAdapter&       adapter;
+        stl::size_t          capacity;
+        stl::vector<pending> queue{};      // the sessions that are waiting for the writer
+        stl::size_t          writing  = 0; // the number of the sessions that the writer has taken
+        bool                 stopping = false;
+
+        stl::mutex              lock;
+        stl::condition_variable has_work;
+        stl::condition_variable is_idle;
+        stl::thread             writer;
+
+        // the value is only moved if it's queued
+        bool try_push(stl::string_view id, value_type& value) {
+            {
+                stl::scoped_lock const guard{lock};
+                // the writer writes the queue in order, so the last value of a session wins anyway; but
+                // the requests of a session usually come back to back, so it's replaced in place
+                if (!queue.empty() && queue.back().id == id) {
+                    queue.back().value = stl::move(value);
+                    return true;
+                }
+                if (queue.size() >= capacity)
+                    return false;
+                queue.push_back(pending{stl::string{id}, stl::move(value)});
+            }
+            has_work.notify_one();
+            return true;
+        }
+
+        void write_loop() {
+            stl::vector<pending> batch;
+            batch.reserve(capacity);
+            stl::unique_lock guard{lock};
+            for (;;) {
+                has_work.wait(guard, [this] {
+                    return stopping || !queue.empty();
+                });
+                if (queue.empty())
+                    return; // stopping, and everything is written
+                batch.swap(queue);
+                writing = batch.size();
+                guard.unlock();
+
+                for (auto& session : batch)
+                    adapter.set(session.id, stl::move(session.value));
+                batch.clear();
+
+                guard.lock();
+                writing = 0;
+                if (queue.empty())
+                    is_idle.notify_all();
+            }
+        }
+
+      public:
+        explicit session_writer(ServerAdapter& server_adapter, stl::size_t queue_capacity = default_capacity)
+          : adapter{server_adapter},
+            capacity{queue_capacity} {
+            queue.reserve(capacity);
+            writer = stl::thread{[this] {
+                write_loop();
+            }};
+        }
+
+        session_writer(session_writer const&)            = delete;
+        session_writer& operator=(session_writer const&) = delete;
+
+        /**
+         * The sessions in the queue are written before it returns
+         */
+        ~session_writer() {
+            {
+                stl::scoped_lock const guard{lock};
+                stopping = true;
+            }
+            has_work.notify_one();
+            writer.join();
+        }
+
+        /**
+         * Queue the session to be written
+         * @returns false if the queue is full; the session is not queued then
+         */
+        bool push(stl::string_view id, value_type value) {
+            return try_push(id, value);
+        }
+
+        /**
+         * Queue the session, or write it right here if the queue is full
+         */
+        void write(stl::string_view id, value_type value) {
+            if (!try_push(id, value))
+                adapter.set(id, stl::move(value));
+        }
+
+        /**
+         * Wait until the sessions that are queued are written
+         */
+        void flush() {
+            stl::unique_lock guard{lock};
+            is_idle.wait(guard, [this] {
+                return queue.empty() && writing == 0;
+            });
+        }
+
+        /**
+         * The number of the sessions that are not written yet
+         */
+        [[nodiscard]] stl::size_t size() {
+            stl::scoped_lock const guard{lock};
+            return queue.size() + writing;
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_SESSION_WRITER_H
@@ -14,7 +14,7 @@
  *       things that the user may not need in order to create and pass a
  *       response.
  * - [ ] The headers
- * - [ ] The body
+ * - [X] The body (see request_body_parsers)
  *
  *
  * Only the interface should be instantiating this class. There should be no
@@ -31,6 +31,7 @@
 #include "../traits/traits_concepts.hpp"
 #include "./body.hpp"
 #include "./header.hpp"
+#include "./request_body.hpp"
 #include "./request_concepts.hpp"
 
 namespace webpp {
@@ -0,0 +1,591 @@
+#ifndef WEBPP_HTTP_REQUEST_BODY_H
+#define WEBPP_HTTP_REQUEST_BODY_H
+
+#include "../encoding/encoded_word.hpp"
+#include "../std/std.hpp"
+#include "../utils/json.hpp"
+#include "./cookies/cookie_header.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace webpp {
+
+    namespace details {
+
+        [[nodiscard]] constexpr char ascii_lower(char c) noexcept {
+            return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+        }
+
+        // "lower" is in lower case
+        [[nodiscard]] constexpr bool iequals_lower(stl::string_view str, stl::string_view lower) noexcept {
+            if (str.size() != lower.size())
+                return false;
+            for (stl::size_t i = 0; i < str.size(); i++)
+                if (ascii_lower(str[i]) != lower[i])
+                    return false;
+            return true;
+        }
+
+        [[nodiscard]] constexpr stl::string_view trim_spaces(stl::string_view str) noexcept {
+            auto const start = str.find_first_not_of(" \t");
+            if (start == stl::string_view::npos)
+                return {};
+            return str.substr(start, str.find_last_not_of(" \t") + 1 - start);
+        }
+
+        /**
+         * The media type of a Content-Type, without its parameters
+         */
+        [[nodiscard]] constexpr stl::string_view media_type(stl::string_view content_type) noexcept {
+            return trim_spaces(content_type.substr(0, content_type.find(';')));
+        }
+
+        /**
+         * A parameter of a header value ("boundary" of a Content-Type, "name"
+         * of a Content-Disposition); the quotes are taken off, the escapes in
+         * them are left as they are. The name is in lower case.
+         */
+        [[nodiscard]] constexpr stl::string_view header_parameter(stl::string_view header,
+                                                                  stl::string_view name) noexcept {
+            for (auto pos = header.find(';'); pos != stl::string_view::npos;) {
+                auto const eq = header.find('=', pos + 1);
+                if (eq == stl::string_view::npos)
+                    break;
+                auto const key   = trim_spaces(header.substr(pos + 1, eq - pos - 1));
+                auto       start = header.find_first_not_of(" \t", eq + 1);
+                if (start == stl::string_view::npos)
+                    start = header.size();
+                stl::string_view value;
+                if (start < header.size() && header[start] == '"') {
+                    auto end = start + 1;
+                    for (; end < header.size() && header[end] != '"'; end++)
+                        if (header[end] == '\\')
+                            end++;
+                    value = header.substr(start + 1, stl::min(end, header.size()) - start - 1);
+                    pos   = header.find(';', end);
+                } else {
+                    pos   = header.find(';', start);
+                    value = trim_spaces(header.substr(start, pos - start));
+                }
+                if (iequals_lower(key, name))
+                    return value;
+            }
+            return {};
+        }
+
+    } // namespace details
+
+    /**
+     * Decode a name or a value of a urlencoded form ("+" is a space), and
+     * append it to "out"
+     * @returns false if it has a broken escape
+     */
+    template <typename StringType>
+    constexpr bool decode_form_component(stl::string_view encoded, StringType& out) noexcept {
+        constexpr auto hex_value = [](char c) constexpr noexcept -> int {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            return -1;
+        };
+        for (stl::size_t i = 0; i < encoded.size(); i++) {
+            switch (auto const c = encoded[i]) {
+                case '+': out.push_back(' '); break;
+                case '%': {
+                    if (i + 2 >= encoded.size())
+                        return false;
+                    auto const high = hex_value(encoded[i + 1]);
+                    auto const low  = hex_value(encoded[i + 2]);
+                    if (high < 0 || low < 0)
+                        return false;
+                    out.push_back(static_cast<char>((high << 4) | low));
+                    i += 2;
+                    break;
+                }
+                default: out.push_back(c);
+            }
+        }
+        return true;
+    }
+
+    /**
+     * A field of a urlencoded form; they're views into the body, still
+     * encoded.
+     */
+    struct form_field {
+        stl::string_view name;
+        stl::string_view value;
+
+        template <typename StringType>
+        constexpr bool decoded_name(StringType& out) const noexcept {
+            return decode_form_component(name, out);
+        }
+
+        template <typename StringType>
+        constexpr bool decoded_value(StringType& out) const noexcept {
+            return decode_form_component(value, out);
+        }
+    };
+
+    /**
+     * A part of a multipart/form-data body; they're views into the body.
+     */
+    struct multipart_part {
+        stl::string_view name;         // of the Content-Disposition
+        stl::string_view filename;     // of the Content-Disposition; empty if it's not a file
+        stl::string_view content_type; // empty means text/plain
+        stl::string_view headers;      // all of the headers of the part
+        stl::string_view data;
+    };
+
+    namespace details {
+        /**
+         * Fill the fields of the part that come from its headers
+         */
+        constexpr void parse_part_headers(multipart_part& part) noexcept {
+            for (auto headers = part.headers; !headers.empty();) {
+                auto const eol   = headers.find("\r\n");
+                auto const line  = headers.substr(0, eol);
+                auto const colon = line.find(':');
+                if (colon != stl::string_view::npos) {
+                    auto const name  = trim_spaces(line.substr(0, colon));
+                    auto const value = trim_spaces(line.substr(colon + 1));
+                    if (iequals_lower(name, "content-disposition")) {
+                        part.name     = header_parameter(value, "name");
+                        part.filename = header_parameter(value, "filename");
+                    } else if (iequals_lower(name, "content-type")) {
+                        part.content_type = value;
+                    }
+                }
+                if (eol == stl::string_view::npos)
+                    break;
+                headers.remove_prefix(eol + 2);
+            }
+        }
+    } // namespace details
+
+    /**
+     * Split a urlencoded form ("a=1&b=2") into its fields; the ones without
+     * a name are left out.
+     */
+    template <typename Container>
+    constexpr void parse_form(stl::string_view body, Container& fields) noexcept {
+        while (!body.empty()) {
+            auto const       amp   = body.find('&');
+            auto const       field = body.substr(0, amp);
+            auto const       eq    = field.find('=');
+            stl::string_view value = eq == stl::string_view::npos ? stl::string_view{} : field.substr(eq + 1);
+            if (auto const name = field.substr(0, eq); !name.empty())
+                fields.push_back(form_field{name, value});
+            if (amp == stl::string_view::npos)
+                break;
+            body.remove_prefix(amp + 1);
+        }
+    }
+
+    /**
+     * Split a multipart body into its parts (RFC 7578); what's before the
+     * first boundary and after the last one is ignored.
+     * @returns false if the body is not complete or it's broken
+     */
+    template <typename Container>
+    constexpr bool parse_multipart(stl::string_view body,
+                                   stl::string_view boundary,
+                                   Container&       parts) noexcept {
+        if (boundary.empty())
+            return false;
+
+        // "--boundary" at the start of the body or of a line
+        auto const find_delimiter = [&](stl::size_t from) constexpr noexcept {
+            for (;;) {
+                auto const pos = body.find(boundary, from);
+                if (pos == stl::string_view::npos)
+                    return pos;
+                auto const after = body.substr(pos + boundary.size(), 2);
+                if (pos >= 2 && body[pos - 2] == '-' && body[pos - 1] == '-' &&
+                    (pos == 2 || (pos >= 4 && body[pos - 4] == '\r' && body[pos - 3] == '\n')) &&
+                    (after == "--" || after == "\r\n" || after.starts_with(' ') || after.starts_with('\t')))
+                    return pos - 2;
+                from = pos + 1;
+            }
+        };
+
+        auto pos = find_delimiter(0);
+        while (pos != stl::string_view::npos) {
+            pos += 2 + boundary.size();
+            if (body.substr(pos, 2) == "--")
+                return true; // the last one
+            pos = body.find_first_not_of(" \t", pos); // the padding
+            if (pos == stl::string_view::npos || body.substr(pos, 2) != "\r\n")
+                return false;
+            pos += 2;
+
+            multipart_part part;
+            stl::size_t    data_start = pos + 2; // no headers
+            if (body.substr(pos, 2) != "\r\n") {
+                auto const headers_end = body.find("\r\n\r\n", pos);
+                if (headers_end == stl::string_view::npos)
+                    return false;
+                part.headers = body.substr(pos, headers_end - pos);
+                data_start   = headers_end + 4;
+            }
+            auto const next = find_delimiter(data_start);
+            if (next == stl::string_view::npos || next < data_start + 2)
+                return false;
+            part.data = body.substr(data_start, next - 2 - data_start);
+
+            details::parse_part_headers(part);
+            parts.push_back(part);
+            pos = next;
+        }
+        return false;
+    }
+
+    /**
+     * A multipart/form-data parser that's given the body a chunk at a time,
+     * for the uploads that shouldn't be in the memory all at once. The
+     * handler is called as the parts are found:
+     *
+     *   handler.on_part(part);   // its headers; the data is empty
+     *   handler.on_data(data);   // a piece of the data of the part, any number of times
+     *   handler.on_part_end();
+     *
+     * The views are only valid in the call. The data is given right out of
+     * the chunks; only the end of a chunk that may be the start of a
+     * boundary, and the headers of a part that are not complete, are kept
+     * for the next chunk, so the memory doesn't grow with the uploads. The
+     * boundaries are found with Boyer-Moore-Horspool.
+     */
+    class multipart_parser {
+      public:
+        static constexpr stl::size_t max_boundary_size = 70; // RFC 2046
+        static constexpr stl::size_t max_headers_size  = 16 * 1024;
+
+      private:
+        enum struct state : stl::uint8_t { preamble, after_delimiter, headers, data, done, error };
+
+        stl::array<char, max_boundary_size + 4> delimiter{}; // "\r\n--" and the boundary
+        stl::size_t                             delimiter_size = 0;
+        stl::array<stl::uint8_t, 256>           skips{};
+        stl::string                             buffer{"\r\n"}; // the first boundary has no CRLF before it
+        state                                   current = state::preamble;
+
+        [[nodiscard]] stl::string_view delimiter_view() const noexcept {
+            return {delimiter.data(), delimiter_size};
+        }
+
+        [[nodiscard]] stl::size_t find_delimiter(stl::string_view input, stl::size_t from) const noexcept {
+            auto const last      = delimiter_size - 1;
+            auto const last_char = delimiter[last];
+            for (auto i = from; i + delimiter_size <= input.size();) {
+                auto const c = input[i + last];
+                if (c == last_char && stl::memcmp(input.data() + i, delimiter.data(), last) == 0)
+                    return i;
+                i += skips[static_cast<unsigned char>(c)];
+            }
+            return stl::string_view::npos;
+        }
+
+        // where the end of the input may be the start of a delimiter
+        [[nodiscard]] stl::size_t partial_delimiter(stl::string_view input, stl::size_t from) const noexcept {
+            auto i = input.size() >= delimiter_size ? input.size() - delimiter_size + 1 : 0;
+            for (i = stl::max(i, from); i < input.size(); i++)
+                if (input[i] == '\r' && delimiter_view().starts_with(input.substr(i)))
+                    return i;
+            return input.size();
+        }
+
+        /**
+         * @returns how much of the input is used; the rest is for the next chunk
+         */
+        template <typename Handler>
+        stl::size_t process(stl::string_view input, Handler& handler) noexcept {
+            stl::size_t pos = 0;
+            auto const  emit = [&](stl::size_t end) {
+                if (current == state::data && end > pos)
+                    handler.on_data(input.substr(pos, end - pos));
+            };
+            for (;;) {
+                switch (current) {
+                    case state::preamble:
+                    case state::data:
+                        for (auto from = pos;;) {
+                            auto const found = find_delimiter(input, from);
+                            if (found == stl::string_view::npos) {
+                                auto const end = partial_delimiter(input, from);
+                                emit(end);
+                                return end;
+                            }
+                            auto const after = input.substr(found + delimiter_size, 2);
+                            if (after.size() < 2) {
+                                emit(found);
+                                return found;
+                            }
+                            if (after == "--" || after == "\r\n" || after[0] == ' ' || after[0] == '\t') {
+                                emit(found);
+                                if (current == state::data)
+                                    handler.on_part_end();
+                                pos     = found + delimiter_size;
+                                current = state::after_delimiter;
+                                break;
+                            }
+                            from = found + 1; // it's in the data
+                        }
+                        continue;
+                    case state::after_delimiter:
+                        if (input.size() - pos < 2)
+                            return pos;
+                        if (input.substr(pos, 2) == "--") {
+                            current = state::done;
+                            return input.size(); // the epilogue is ignored
+                        }
+                        while (pos < input.size() && (input[pos] == ' ' || input[pos] == '\t'))
+                            pos++;
+                        if (input.size() - pos < 2)
+                            return pos;
+                        if (input.substr(pos, 2) != "\r\n") {
+                            current = state::error;
+                            return input.size();
+                        }
+                        pos += 2;
+                        current = state::headers;
+                        continue;
+                    case state::headers: {
+                        if (input.size() - pos < 2)
+                            return pos;
+                        multipart_part part;
+                        if (input.substr(pos, 2) == "\r\n") {
+                            pos += 2; // no headers
+                        } else {
+                            auto const end = input.find("\r\n\r\n", pos);
+                            if (end == stl::string_view::npos) {
+                                if (input.size() - pos > max_headers_size)
+                                    current = state::error;
+                                return pos;
+                            }
+                            part.headers = input.substr(pos, end - pos);
+                            pos          = end + 4;
+                            details::parse_part_headers(part);
+                        }
+                        handler.on_part(part);
+                        current = state::data;
+                        continue;
+                    }
+                    default: return input.size();
+                }
+            }
+        }
+
+      public:
+        explicit multipart_parser(stl::string_view boundary) noexcept {
+            if (boundary.empty() || boundary.size() > max_boundary_size) {
+                current = state::error;
+                return;
+            }
+            stl::string_view const prefix = "\r\n--";
+            stl::copy(prefix.begin(), prefix.end(), delimiter.begin());
+            stl::copy(boundary.begin(), boundary.end(), delimiter.begin() + prefix.size());
+            delimiter_size = prefix.size() + boundary.size();
+            skips.fill(static_cast<stl::uint8_t>(delimiter_size));
+            for (stl::size_t i = 0; i + 1 < delimiter_size; i++) {
+                auto const skip                                 = delimiter_size - 1 - i;
+                skips[static_cast<unsigned char>(delimiter[i])] = static_cast<stl::uint8_t>(skip);
+            }
+        }
+
+        /**
+         * Parse the next chunk of the body
+         * @returns false if the body is broken
+         */
+        template <typename Handler>
+        bool feed(stl::string_view chunk, Handler& handler) noexcept {
+            if (current == state::done || current == state::error)
+                return current == state::done;
+            if (buffer.empty()) {
+                auto const used = process(chunk, handler);
+                buffer.assign(chunk.substr(stl::min(used, chunk.size())));
+            } else {
+                buffer.append(chunk);
+                buffer.erase(0, process(buffer, handler));
+            }
+            return current != state::error;
+        }
+
+        /**
+         * The last boundary is seen; false if the body was cut before it
+         */
+        [[nodiscard]] bool is_done() const noexcept {
+            return current == state::done;
+        }
+    };
+
+    /**
+     * The parsers of the request body; the requests of the interfaces
+     * inherit these, and they only have to have "body()" and "header(name)".
+     *
+     * Nothing is parsed until it's asked for, and then only once for each
+     * request; the fields, the parts, and the JSON values are views into the
+     * body, so the body should outlive what's taken out of them. The copies
+     * of a request parse again.
+     */
+    template <typename Derived>
+    struct request_body_parsers {
+      private:
+        enum parsed_bits : stl::uint8_t { form_bit = 1u, multipart_bit = 2u, json_bit = 4u };
+
+        mutable stl::vector<form_field>     form_fields{};
+        mutable stl::vector<multipart_part> parts{};
+        mutable ::webpp::json::document     document{};
+        mutable stl::uint8_t                parsed       = 0;
+        mutable bool                        multipart_ok = false;
+
+        [[nodiscard]] constexpr Derived const& self() const noexcept {
+            return *static_cast<Derived const*>(this);
+        }
+
+        [[nodiscard]] bool parse_once(parsed_bits bit) const noexcept {
+            if (parsed & bit)
+                return false;
+            parsed |= bit;
+            return true;
+        }
+
+      public:
+        request_body_parsers() noexcept = default;
+        request_body_parsers(request_body_parsers const&) noexcept {}
+        request_body_parsers& operator=(request_body_parsers const&) noexcept {
+            return *this;
+        }
+
+        /**
+         * The fields of an application/x-www-form-urlencoded body; empty if
+         * the body is something else.
+         */
+        [[nodiscard]] stl::vector<form_field> const& form() const noexcept {
+            if (parse_once(form_bit)) {
+                auto const type = details::media_type(self().header("Content-Type"));
+                if (details::iequals_lower(type, "application/x-www-form-urlencoded"))
+                    parse_form(self().body(), form_fields);
+            }
+            return form_fields;
+        }
+
+        /**
+         * The value of the first field of the form with the name; still
+         * encoded (see decode_form_component)
+         */
+        [[nodiscard]] stl::string_view form_value(stl::string_view name) const noexcept {
+            for (auto const& field : form())
+                if (field.name == name)
+                    return field.value;
+            return {};
+        }
+
+        /**
+         * The parts of a multipart/form-data body; empty if the body is
+         * something else, or it's broken (the parts before the break are
+         * there, see is_multipart_complete).
+         */
+        [[nodiscard]] stl::vector<multipart_part> const& multipart() const noexcept {
+            if (parse_once(multipart_bit)) {
+                auto const content_type = self().header("Content-Type");
+                if (details::iequals_lower(details::media_type(content_type), "multipart/form-data"))
+                    multipart_ok = parse_multipart(self().body(),
+                                                   details::header_parameter(content_type, "boundary"),
+                                                   parts);
+            }
+            return parts;
+        }
+
+        [[nodiscard]] bool is_multipart_complete() const noexcept {
+            static_cast<void>(multipart());
+            return multipart_ok;
+        }
+
+        /**
+         * The first part with the name; nullptr if there's none
+         */
+        [[nodiscard]] multipart_part const* part(stl::string_view name) const noexcept {
+            for (auto const& item : multipart())
+                if (item.name == name)
+                    return &item;
+            return nullptr;
+        }
+
+        /**
+         * Give the parts of a multipart/form-data body to the handler as
+         * they're read (see multipart_parser); the interfaces that can read
+         * the body in chunks (read_body) never have all of it in the memory,
+         * so it's for the uploads. Don't use it with "multipart()", the body
+         * is read only once.
+         * @returns false if it's not multipart, or it's broken or cut
+         */
+        template <typename Handler>
+        bool read_multipart(Handler& handler, stl::size_t chunk_size = 16 * 1024) const noexcept {
+            auto const content_type = self().header("Content-Type");
+            if (!details::iequals_lower(details::media_type(content_type), "multipart/form-data"))
+                return false;
+            multipart_parser parser{details::header_parameter(content_type, "boundary")};
+            if constexpr (requires(char* data) { self().read_body(data, chunk_size); }) {
+                stl::string chunk(chunk_size, '\0');
+                for (;;) {
+                    auto const size = self().read_body(chunk.data(), chunk.size());
+                    if (size == 0 || !parser.feed(stl::string_view{chunk.data(), size}, handler))
+                        break;
+                }
+            } else {
+                parser.feed(self().body(), handler);
+            }
+            return parser.is_done();
+        }
+
+        /**
+         * The body as a JSON document; it's indexed, and the values are read
+         * as they're asked for (see json::document). It's not valid if the
+         * body is not JSON, whatever the Content-Type says.
+         */
+        [[nodiscard]] ::webpp::json::document const& json() const noexcept {
+            if (parse_once(json_bit))
+                static_cast<void>(document.parse(self().body()));
+            return document;
+        }
+
+        /**
+         * The header with its RFC 2047 encoded words decoded into UTF-8; the
+         * value is only decoded (into the buffer) if it has "=?" in it,
+         * otherwise it's the same view that "header" gives.
+         */
+        template <typename StrT>
+        [[nodiscard]] stl::string_view decoded_header(stl::string_view name, StrT& buffer) const {
+            return encoding::decoded(self().header(name), buffer);
+        }
+
+        /**
+         * The pairs of the Cookie header, as views into it (see cookie_header_view); it's tokenized on
+         * each call, so keep the view if more than one cookie is needed.
+         */
+        [[nodiscard]] cookie_header_view<> cookies() const noexcept {
+            return cookie_header_view<>{self().header("Cookie")};
+        }
+
+        /**
+         * The value of the first cookie with the name, still encoded (see decode_cookie_value); empty if
+         * there's none.
+         */
+        [[nodiscard]] stl::string_view cookie(stl::string_view name) const noexcept {
+            return find_cookie_value(self().header("Cookie"), name);
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_HTTP_REQUEST_BODY_H
@@ -2,9 +2,12 @@
 #define WEBPP_HTTP_RESPONSE_H
 
 #include "../traits/traits_concepts.hpp"
+#include "../utils/casts.hpp"
+#include "../utils/recycle_pool.hpp"
 #include "./response_concepts.hpp"
 #include "body.hpp"
 #include "header.hpp"
+#include "http_date.hpp"
 
 #include <filesystem>
 #include <fstream>
@@ -40,6 +43,14 @@ namespace webpp {
         }
         basic_response(status_code_type err_code, str_t&& b) noexcept : header{err_code}, body{stl::move(b)} {
         }
+        /**
+         * The body is shared with the other responses (see string_body)
+         */
+        basic_response(status_code_type err_code, stl::shared_ptr<str_t const> b) noexcept
+          : body{stl::move(b)},
+            header{err_code} {
+        }
+
         basic_response(str_t const& b) noexcept : body(b) {
         }
         basic_response(str_t&& b) noexcept : body(stl::move(b)) {
@@ -48,12 +59,18 @@ namespace webpp {
 
         basic_response& operator=(basic_response const&) = default;
         basic_response& operator=(basic_response&& res) noexcept = default;
-        basic_response& operator                                 =(str_t const& str) noexcept {
-            body.replace_string(str);
-            return *this;
-        }
-        basic_response& operator=(str_t&& str) noexcept {
-            body.replace_string(stl::move(str));
+        /**
+         * Replace the body with the string; its memory is reused if the body
+         * can be assigned a string
+         */
+        template <typename StrT>
+        requires(stl::same_as<stl::remove_cvref_t<StrT>, str_t>)
+        basic_response& operator=(StrT&& str) noexcept {
+            if constexpr (requires { body.assign(stl::forward<StrT>(str)); }) {
+                body.assign(stl::forward<StrT>(str));
+            } else {
+                body = body_type{stl::forward<StrT>(str)};
+            }
             return *this;
         }
 
@@ -64,14 +81,102 @@ namespace webpp {
             return body != res.body || header != res.header;
         }
 
+        /**
+         * Make the response like the one that's constructed with the status
+         * code and the args of the body, but reuse the memory of this one.
+         */
+        template <typename... Args>
+        requires(requires(body_type & b, Args&&... args) {
+            b.assign(stl::forward<Args>(args)...);
+        }) void assign(status_code_type err_code, Args&&... args) noexcept {
+            header.status_code = err_code;
+            body.assign(stl::forward<Args>(args)...);
+        }
+
+        /**
+         * Empty the response, and keep its memory (see recycle_pool)
+         */
+        void clear() noexcept requires(requires(headers_type & h, body_type & b) {
+            h.clear();
+            b.clear();
+        }) {
+            header.clear();
+            body.clear();
+        }
+
         void calculate_default_headers() noexcept {
-            if (!header.contains("Content-Type"))
-                header.emplace("Content-Type", "text/html; charset=utf-8");
+            if (!has_header(well_known_header::content_type))
+                header.emplace(well_known_header_name(well_known_header::content_type), default_content_type());
+
+            if (!has_header(well_known_header::content_length) && !is_stream())
+                header.emplace(well_known_header_name(well_known_header::content_length),
+                               to_str_buffer(body_size() * sizeof(char)).view());
+        }
+
+        /**
+         * The Date header that the HTTP/1.1 and HTTP/2 servers send (the CGI
+         * gateways add their own); the date is formatted once per second.
+         */
+        void calculate_date_header() noexcept {
+            if (!has_header(well_known_header::date)) {
+                char date[http_date_size];
+                format_current_http_date(date);
+                header.emplace(well_known_header_name(well_known_header::date),
+                               stl::string_view{date, http_date_size});
+            }
+        }
+
+        /**
+         * The Content-Type of the body if it knows it (the file bodies know it
+         * by the extension of the file), otherwise html
+         */
+        [[nodiscard]] stl::string_view default_content_type() const noexcept {
+            if constexpr (requires {
+                              { body.content_type() } -> stl::convertible_to<stl::string_view>;
+                          }) {
+                if (stl::string_view const type = body.content_type(); !type.empty())
+                    return type;
+            }
+            return "text/html; charset=utf-8";
+        }
+
+        /**
+         * The body is produced while it's sent (a stream body); its length is
+         * not known
+         */
+        [[nodiscard]] bool is_stream() const noexcept {
+            if constexpr (requires { body.is_stream(); }) {
+                return body.is_stream();
+            } else {
+                return false;
+            }
+        }
 
-            if (!header.contains("Content-Length"))
-                header.emplace("Content-Length", stl::to_string(body.str().size() * sizeof(char)));
+      private:
+        /**
+         * The bodies that know their size without being read (a file body)
+         */
+        [[nodiscard]] stl::size_t body_size() const noexcept {
+            if constexpr (requires { body.size(); }) {
+                return body.size();
+            } else {
+                return body.str().size();
+            }
         }
 
+        /**
+         * A bit test if the headers keep track of the well-known fields
+         */
+        [[nodiscard]] bool has_header(well_known_header name) const noexcept {
+            if constexpr (requires { header.contains(name); }) {
+                return header.contains(name);
+            } else {
+                return header.contains(well_known_header_name(name));
+            }
+        }
+
+      public:
+
 
         // static methods:
         /*
@@ -84,6 +189,27 @@ namespace webpp {
 
 
 
+    /**
+     * The responses that are worth keeping in a recycle_pool after they're
+     * sent; the ones whose memory belongs to a memory resource (a request
+     * arena for example) should not outlive it, so they're not kept.
+     */
+    template <typename ResponseType>
+    concept RecyclableResponse = Recyclable<ResponseType> && stl::allocator_traits<
+      typename ResponseType::traits_type::template allocator<char>>::is_always_equal::value;
+
+    /**
+     * Give the response that's sent to the response pool of this thread; the
+     * contexts make the next responses from them.
+     */
+    template <typename ResponseType>
+    void recycle_response(ResponseType&& res) noexcept {
+        using response_type = stl::remove_cvref_t<ResponseType>;
+        if constexpr (RecyclableResponse<response_type> && !stl::is_const_v<stl::remove_reference_t<ResponseType>>) {
+            recycle_pool<response_type>::local().recycle(stl::move(res));
+        }
+    }
+
     template <Traits TraitsType, typename DescriptorType, typename OriginalExtensionList, typename EList>
     struct final_response final : public EList {
         using traits_type                  = TraitsType;
@@ -91,6 +217,8 @@ namespace webpp {
         using response_descriptor_type     = DescriptorType;
         using original_extension_pack_type = OriginalExtensionList;
 
+        using EList::EList;
+
         /**
          * Append some extensions to this context type and get the type back
          */
@@ -4,13 +4,17 @@
 #define WEBPP_ROUTES_CONTEXT_H
 
 #include "../../extensions/extension.hpp"
+#include "../../utils/deadline.hpp"
 #include "../request.hpp"
 #include "../response.hpp"
 #include "./context_concepts.hpp"
 #include "./extensions/map.hpp"
+#include "./path_segments.hpp"
 
 namespace webpp {
 
+    class route_profiler;
+
     struct router_stats {
         // todo: add termination of routing here, so the user can terminate it with the context
 
@@ -29,6 +33,9 @@ namespace webpp {
         bool          last_subroute : 1            = false;
         bool          last_internal_subroute : 1   = false;
         route_level   level : 2                    = route_level::none;
+
+        // the entry routes are counted and timed into it, if it's set (see route_profiler)
+        route_profiler* profiler = nullptr;
     };
 
     /**
@@ -133,42 +140,116 @@ namespace webpp {
      *
      *
      */
+    template <typename, Request, Response>
+    struct basic_context;
+
+    namespace details {
+
+        /**
+         * The fields of the context that the routes read on every request; it's the first base of the
+         * context, so they're at its start (in its first cache line, the first few segments too),
+         * before whatever the extensions add.
+         */
+        template <typename RequestType>
+        struct context_fields {
+            RequestType* request = nullptr;
+            router_stats router_features{};
+
+            // the deadline of the request, and whether the client is still waiting for it (see deadline.hpp)
+            cancellation_token cancellation{};
+
+          private:
+            // the segments of the request's path; parsed the first time a route
+            // asks for them, and copied to the cloned contexts
+            mutable bool                  segments_parsed = false;
+            mutable routes::path_segments segments_cache{};
+
+            template <typename, Request, Response>
+            friend struct ::webpp::basic_context;
+
+          public:
+            constexpr context_fields(RequestType* req = nullptr) noexcept : request{req} {
+                // the interfaces give a token to the requests that are served by tasks
+                if constexpr (requires { req->cancellation(); }) {
+                    if (req != nullptr)
+                        cancellation = req->cancellation();
+                }
+            }
+
+            constexpr context_fields(RequestType* req, cancellation_token const& token) noexcept
+              : request{req},
+                cancellation{token} {}
+        };
+
+    } // namespace details
+
     template <typename EList, Request RequestType, Response ResponseType>
-    struct basic_context : public EList {
+    struct basic_context : public details::context_fields<RequestType>, public EList {
         using elist_type         = EList;
+        using fields_type        = details::context_fields<RequestType>;
+        using traits_type        = typename RequestType::traits_type;
         using request_type       = RequestType;
         using response_type      = ResponseType;
         using basic_context_type = basic_context<EList, RequestType, ResponseType>;
 
-        router_stats  router_features{};
-        request_type* request = nullptr;
-
-        constexpr basic_context() noexcept : elist_type{} {
+        constexpr basic_context() noexcept : fields_type{}, elist_type{} {
         }
 
-        constexpr basic_context(request_type& req) noexcept : elist_type{}, request(&req) {
+        constexpr basic_context(request_type& req) noexcept : fields_type{&req}, elist_type{} {
         }
 
-        constexpr basic_context(request_type* req) noexcept : elist_type{}, request(req) {
+        constexpr basic_context(request_type* req) noexcept : fields_type{req}, elist_type{} {
         }
 
 
         template <typename... Args>
         constexpr basic_context(request_type& req, Args&&... args) noexcept
-          : elist_type{stl::forward<Args>(args)...},
-            request(&req) {
+          : fields_type{&req},
+            elist_type{stl::forward<Args>(args)...} {
         }
 
         template <typename... Args>
         constexpr basic_context(request_type* req, Args&&... args) noexcept
-          : elist_type{stl::forward<Args>(args)...},
-            request(req) {
+          : fields_type{req},
+            elist_type{stl::forward<Args>(args)...} {
         }
 
         template <Context ContextType>
         constexpr basic_context(ContextType&& ctx) noexcept
-          : request{ctx.request},
+          : fields_type{ctx.request, ctx.cancellation},
             elist_type{stl::forward<ContextType>(ctx)} {
+            copy_segments_from(ctx);
+        }
+
+        /**
+         * The work of this request should be dropped; its deadline has passed,
+         * or it's cancelled.
+         */
+        [[nodiscard]] bool is_cancelled() const noexcept {
+            return this->cancellation.is_cancelled();
+        }
+
+        /**
+         * The segments of the path of the request; all of the path routes
+         * share them, so the uri is split only once per request.
+         */
+        [[nodiscard]] constexpr routes::path_segments const& segments() const noexcept {
+            if (!this->segments_parsed) {
+                this->segments_cache  = routes::path_segments::parse(this->request->request_uri());
+                this->segments_parsed = true;
+            }
+            return this->segments_cache;
+        }
+
+        /**
+         * Take the already-parsed segments of another context of this request
+         */
+        template <typename ContextType>
+        constexpr void copy_segments_from(ContextType const& ctx) noexcept {
+            if (ctx.segments_parsed) {
+                this->segments_cache  = ctx.segments_cache;
+                this->segments_parsed = true;
+            }
         }
 
         /**
@@ -182,7 +263,15 @@ namespace webpp {
             using new_response_type =
               typename response_type::template apply_extensions_type<NewExtensions...>;
             // todo: write an auto extension finder based on the Args that get passed
-            return new_response_type{stl::forward<Args>(args)...};
+            if constexpr (RecyclableResponse<new_response_type> &&
+                          requires(new_response_type & res) { res.assign(stl::forward<Args>(args)...); }) {
+                // a cleared response from the pool of this thread keeps its buckets and strings
+                auto res = recycle_pool<new_response_type>::local().acquire();
+                res.assign(stl::forward<Args>(args)...);
+                return res;
+            } else {
+                return new_response_type{stl::forward<Args>(args)...};
+            }
         }
     };
 
@@ -225,17 +314,23 @@ namespace webpp {
         //        }
 
 
-        constexpr final_context(request_type* req) noexcept : basic_context_type{req} {
+        // The basic context is not a direct base when there are child extensions, so it's constructed
+        // through the EList; the request is set here again in case an extension doesn't pass it on.
+
+        constexpr final_context(request_type* req) noexcept : EList{req} {
+            this->request = req;
         }
 
-        constexpr final_context(request_type& req) noexcept : basic_context_type{req} {
+        constexpr final_context(request_type& req) noexcept : final_context{&req} {
         }
 
         template <Traits NTraitsType, typename NContextDescriptorType, typename NOriginalExtensionList,
                   typename NEList, typename NReqType>
         constexpr final_context(final_context<NTraitsType, NContextDescriptorType, NOriginalExtensionList,
                                               NEList, NReqType> const& ctx) noexcept
-          : basic_context_type{ctx.request} {
+          : final_context{ctx.request} {
+            this->copy_segments_from(ctx);
+            this->cancellation = ctx.cancellation;
         }
 
         /**
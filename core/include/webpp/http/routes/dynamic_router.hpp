@@ -0,0 +1,550 @@
+#ifndef WEBPP_DYNAMIC_ROUTER_H
+#define WEBPP_DYNAMIC_ROUTER_H
+
+#include "../../std/optional.hpp"
+#include "../../std/string.hpp"
+#include "../../std/string_view.hpp"
+#include "../../std/unordered_map.hpp"
+#include "../../std/vector.hpp"
+#include "./router.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace webpp {
+
+    /**
+     * The values of the "{name}" segments of a dynamic route's path
+     */
+    struct path_captures {
+        static constexpr stl::size_t max_captures = 8;
+
+        stl::array<stl::pair<stl::string_view, stl::string_view>, max_captures> items{};
+        stl::size_t                                                              count = 0;
+
+        [[nodiscard]] stl::string_view operator[](stl::string_view name) const noexcept {
+            for (stl::size_t i = 0; i < count; i++)
+                if (items[i].first == name)
+                    return items[i].second;
+            return {};
+        }
+
+        [[nodiscard]] stl::size_t size() const noexcept {
+            return count;
+        }
+    };
+
+    /**
+     * A type-erased route of a dynamic router. The callables that fit in a few
+     * pointers (the lambdas that capture a couple of references, the function
+     * pointers, ...) are stored inside of it, the bigger ones are put on the heap;
+     * calling it is one indirect call, and unlike std::function there's no
+     * copying and no RTTI.
+     *
+     * The callable is called like the routes of the router are (with the context,
+     * the request, or nothing), or with the context and the path_captures.
+     */
+    template <typename ContextType>
+    struct dynamic_route {
+        using context_type  = ContextType;
+        using response_type = decltype(details::error_response(stl::declval<context_type const&>(), 404u));
+
+        static constexpr stl::size_t buffer_size = 4 * sizeof(void*);
+
+      private:
+        struct vtable {
+            bool (*call)(void*, context_type&, path_captures const&, stl::optional<response_type>&) noexcept;
+            void (*move)(void* from, void* to) noexcept; // move-construct to an uninitialized buffer
+            void (*destroy)(void*) noexcept;
+        };
+
+        template <typename F>
+        static constexpr bool is_inline =
+          sizeof(F) <= buffer_size && alignof(F) <= alignof(stl::max_align_t) &&
+          stl::is_nothrow_move_constructible_v<F>;
+
+        template <typename F>
+        static F& get(void* buf) noexcept {
+            if constexpr (is_inline<F>) {
+                return *static_cast<F*>(buf);
+            } else {
+                return **static_cast<F**>(buf);
+            }
+        }
+
+        template <typename F>
+        static bool call_impl(void* buf, context_type& ctx, path_captures const& captures,
+                              stl::optional<response_type>& out) noexcept {
+            auto const& callable = get<F>(buf);
+            if constexpr (stl::is_invocable_v<F const&, context_type&, path_captures const&>) {
+                using result_type = stl::invoke_result_t<F const&, context_type&, path_captures const&>;
+                if constexpr (stl::is_void_v<result_type>) {
+                    callable(ctx, captures);
+                    return false;
+                } else {
+                    return details::take_route_result(callable(ctx, captures), ctx, out);
+                }
+            } else {
+                using result_type = decltype(details::call_route(callable, ctx));
+                if constexpr (stl::is_void_v<result_type>) {
+                    details::call_route(callable, ctx);
+                    return false;
+                } else {
+                    return details::take_route_result(details::call_route(callable, ctx), ctx, out);
+                }
+            }
+        }
+
+        template <typename F>
+        static constexpr vtable vtable_of{
+          .call = &call_impl<F>,
+          .move =
+            [](void* from, void* to) noexcept {
+                if constexpr (is_inline<F>) {
+                    new (to) F{stl::move(*static_cast<F*>(from))};
+                    static_cast<F*>(from)->~F();
+                } else {
+                    *static_cast<F**>(to) = *static_cast<F**>(from);
+                }
+            },
+          .destroy =
+            [](void* buf) noexcept {
+                if constexpr (is_inline<F>) {
+                    static_cast<F*>(buf)->~F();
+                } else {
+                    delete *static_cast<F**>(buf);
+                }
+            }};
+
+        alignas(stl::max_align_t) unsigned char buffer[buffer_size];
+        vtable const* vptr = nullptr;
+
+      public:
+        dynamic_route() noexcept = default;
+
+        template <typename F>
+        requires(!stl::same_as<stl::remove_cvref_t<F>, dynamic_route>) dynamic_route(F&& callable) noexcept {
+            using func_type = stl::remove_cvref_t<F>;
+            if constexpr (is_inline<func_type>) {
+                new (buffer) func_type{stl::forward<F>(callable)};
+            } else {
+                *reinterpret_cast<func_type**>(buffer) = new func_type{stl::forward<F>(callable)};
+            }
+            vptr = &vtable_of<func_type>;
+        }
+
+        dynamic_route(dynamic_route&& other) noexcept : vptr{other.vptr} {
+            if (vptr) {
+                vptr->move(other.buffer, buffer);
+                other.vptr = nullptr;
+            }
+        }
+
+        dynamic_route& operator=(dynamic_route&& other) noexcept {
+            if (this != &other) {
+                reset();
+                if (other.vptr) {
+                    other.vptr->move(other.buffer, buffer);
+                    vptr       = other.vptr;
+                    other.vptr = nullptr;
+                }
+            }
+            return *this;
+        }
+
+        dynamic_route(dynamic_route const&) = delete;
+        dynamic_route& operator=(dynamic_route const&) = delete;
+
+        ~dynamic_route() noexcept {
+            reset();
+        }
+
+        void reset() noexcept {
+            if (vptr) {
+                vptr->destroy(buffer);
+                vptr = nullptr;
+            }
+        }
+
+        explicit operator bool() const noexcept {
+            return vptr != nullptr;
+        }
+
+        /**
+         * Call the route
+         * @returns true if it has responded, and the response is in the "out"
+         */
+        bool operator()(context_type& ctx, path_captures const& captures,
+                        stl::optional<response_type>& out) noexcept {
+            return vptr && vptr->call(buffer, ctx, captures, out);
+        }
+    };
+
+    /**
+     * A router that its routes can be added at runtime (by the plugins, for
+     * example). The routes are attached to the paths in a trie of the path
+     * segments; each node has a hash map of its constant children and at most
+     * one "{name}" child that matches any one segment, so the cost of a lookup
+     * depends on the number of the segments of the path and not on the number
+     * of the routes.
+     *
+     * A constant segment is preferred over a variable one; if none of the
+     * routes of a path respond, the other matching paths are tried. A path
+     * ending in "*" matches the rest of the path too.
+     *
+     * It's not thread-safe to add routes while the requests are being routed.
+     *
+     * In the adaptive mode (see "adapt"), the router counts the responses of
+     * each route, and every few requests it reorders the routes of each path
+     * so the hottest ones are tried first; counting is a relaxed atomic
+     * increment, and the check for the reordering is a compare, so the cost
+     * per request stays constant. The reordering itself mutates the router,
+     * so the adaptive mode is for the routers that are used by one thread at
+     * a time; "freeze" keeps the learned order and stops the counting, after
+     * which the router can be shared again. Only use it when the routes of the
+     * same path don't overlap (by method, for example), because it changes
+     * which one of them gets the first chance to respond.
+     *
+     * @tparam ContextType the context that the routes are called with
+     */
+    template <Context ContextType>
+    struct dynamic_router {
+        using context_type  = ContextType;
+        using route_type    = dynamic_route<context_type>;
+        using response_type = typename route_type::response_type;
+
+      private:
+        using index_type                 = stl::uint32_t;
+        static constexpr index_type npos = static_cast<index_type>(-1);
+
+        struct segment_hash {
+            using is_transparent = void;
+
+            stl::size_t operator()(stl::string_view segment) const noexcept {
+                return stl::hash<stl::string_view>{}(segment);
+            }
+        };
+
+        /**
+         * A route and the number of the times it has responded
+         */
+        struct route_entry {
+            route_type                 route;
+            stl::atomic<stl::uint64_t> hits{0};
+
+            route_entry(route_type&& r) noexcept : route{stl::move(r)} {}
+
+            route_entry(route_entry&& other) noexcept
+              : route{stl::move(other.route)},
+                hits{other.hits.load(stl::memory_order_relaxed)} {}
+
+            route_entry& operator=(route_entry&& other) noexcept {
+                route = stl::move(other.route);
+                hits.store(other.hits.load(stl::memory_order_relaxed), stl::memory_order_relaxed);
+                return *this;
+            }
+        };
+
+        struct node {
+            stl::unordered_map<stl::string, index_type, segment_hash, stl::equal_to<>> children{};
+            index_type                                                               variable = npos;
+            index_type                                                               rest     = npos;
+            stl::string              variable_name{}; // the name of the "{name}" child
+            stl::vector<route_entry> routes{};
+        };
+
+        stl::vector<node> nodes{1}; // the root is the first one
+        stl::size_t       count = 0;
+
+        // the adaptive ordering; the interval is zero when it's off
+        stl::atomic<stl::uint64_t> requests{0};
+        stl::uint64_t              reorder_interval = 0;
+        stl::uint64_t              warm_up          = 0; // freeze after this many requests; zero is never
+
+        index_type child_of(index_type parent, stl::string_view segment) noexcept {
+            if (segment == "*") {
+                if (nodes[parent].rest == npos) {
+                    auto const index    = static_cast<index_type>(nodes.size());
+                    nodes[parent].rest = index;
+                    nodes.emplace_back();
+                }
+                return nodes[parent].rest;
+            }
+            if (segment.size() >= 2 && segment.front() == '{' && segment.back() == '}') {
+                // all the variables of a node share the child; the first name wins
+                if (nodes[parent].variable == npos) {
+                    auto const index             = static_cast<index_type>(nodes.size());
+                    nodes[parent].variable       = index;
+                    nodes[parent].variable_name  = segment.substr(1, segment.size() - 2);
+                    nodes.emplace_back();
+                }
+                return nodes[parent].variable;
+            }
+            if (auto it = nodes[parent].children.find(segment); it != nodes[parent].children.end())
+                return it->second;
+            auto const index = static_cast<index_type>(nodes.size());
+            nodes[parent].children.emplace(stl::string{segment}, index);
+            nodes.emplace_back(); // invalidates the references to the nodes
+            return index;
+        }
+
+        bool call_routes(index_type current, context_type& ctx, path_captures const& captures,
+                         stl::optional<response_type>& out) noexcept {
+            for (auto& entry : nodes[current].routes) {
+                if (entry.route(ctx, captures, out)) {
+                    if (reorder_interval != 0)
+                        entry.hits.fetch_add(1, stl::memory_order_relaxed);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool match(index_type current, stl::string_view path, context_type& ctx, path_captures& captures,
+                   stl::optional<response_type>& out) noexcept {
+            auto const& n = nodes[current];
+            if (path.empty())
+                return call_routes(current, ctx, captures, out) ||
+                       (n.rest != npos && call_routes(n.rest, ctx, captures, out));
+
+            auto const slash   = path.find('/');
+            auto const segment = path.substr(0, slash);
+            auto const rest    = slash == stl::string_view::npos ? stl::string_view{} : path.substr(slash + 1);
+
+            if (auto it = n.children.find(segment); it != n.children.end())
+                if (match(it->second, rest, ctx, captures, out))
+                    return true;
+            if (n.variable != npos && !segment.empty() && captures.count < path_captures::max_captures) {
+                captures.items[captures.count++] = {n.variable_name, segment};
+                if (match(n.variable, rest, ctx, captures, out))
+                    return true;
+                captures.count--;
+            }
+            return n.rest != npos && call_routes(n.rest, ctx, captures, out);
+        }
+
+        static stl::string_view trim_path(stl::string_view path) noexcept {
+            path = path.substr(0, path.find_first_of("?#"));
+            while (path.starts_with('/'))
+                path.remove_prefix(1);
+            return path;
+        }
+
+      public:
+        dynamic_router() noexcept = default;
+
+        dynamic_router(dynamic_router&& other) noexcept
+          : nodes{stl::move(other.nodes)},
+            count{other.count},
+            requests{other.requests.load(stl::memory_order_relaxed)},
+            reorder_interval{other.reorder_interval},
+            warm_up{other.warm_up} {}
+
+        dynamic_router& operator=(dynamic_router&& other) noexcept {
+            nodes            = stl::move(other.nodes);
+            count            = other.count;
+            reorder_interval = other.reorder_interval;
+            warm_up          = other.warm_up;
+            requests.store(other.requests.load(stl::memory_order_relaxed), stl::memory_order_relaxed);
+            return *this;
+        }
+
+        /**
+         * Add a route for a path, like "/users/{id}/posts"; the routes of the
+         * same path are tried in the order they're added.
+         */
+        template <typename F>
+        dynamic_router& on(stl::string_view path, F&& callable) noexcept {
+            index_type current = 0;
+            for (path = trim_path(path); !path.empty();) {
+                auto const slash = path.find('/');
+                current          = child_of(current, path.substr(0, slash));
+                path             = slash == stl::string_view::npos ? stl::string_view{} : path.substr(slash + 1);
+            }
+            nodes[current].routes.emplace_back(route_type{stl::forward<F>(callable)});
+            count++;
+            return *this;
+        }
+
+        /**
+         * Turn on the adaptive ordering of the routes: every "interval" requests
+         * the routes of each path are sorted by their hits. With a "warm_up_requests",
+         * the order is frozen after that many requests.
+         */
+        dynamic_router& adapt(stl::uint64_t interval = 1024, stl::uint64_t warm_up_requests = 0) noexcept {
+            reorder_interval = interval;
+            warm_up          = warm_up_requests;
+            return *this;
+        }
+
+        /**
+         * Keep the current order of the routes, and stop counting the hits
+         */
+        dynamic_router& freeze() noexcept {
+            reorder_interval = 0;
+            return *this;
+        }
+
+        [[nodiscard]] bool is_adaptive() const noexcept {
+            return reorder_interval != 0;
+        }
+
+        /**
+         * Sort the routes of each path by the number of their hits; the ties
+         * keep their current order. The hits are halved after each sort so the
+         * old traffic fades away and the order can follow the changes.
+         */
+        void reorder() noexcept {
+            for (auto& n : nodes) {
+                if (n.routes.size() > 1) {
+                    stl::stable_sort(n.routes.begin(), n.routes.end(), [](auto const& a, auto const& b) {
+                        return a.hits.load(stl::memory_order_relaxed) > b.hits.load(stl::memory_order_relaxed);
+                    });
+                }
+                for (auto& entry : n.routes)
+                    entry.hits.store(entry.hits.load(stl::memory_order_relaxed) / 2, stl::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * How many times the route has responded since the last reordering; the
+         * index is the position of the route in the current order of its path.
+         */
+        [[nodiscard]] stl::uint64_t hits(stl::string_view path, stl::size_t index) const noexcept {
+            index_type current = 0;
+            for (path = trim_path(path); !path.empty();) {
+                auto const slash   = path.find('/');
+                auto const segment = path.substr(0, slash);
+                index_type next    = npos;
+                if (segment == "*")
+                    next = nodes[current].rest;
+                else if (segment.size() >= 2 && segment.front() == '{' && segment.back() == '}')
+                    next = nodes[current].variable;
+                else if (auto it = nodes[current].children.find(segment); it != nodes[current].children.end())
+                    next = it->second;
+                if (next == npos)
+                    return 0;
+                current = next;
+                path    = slash == stl::string_view::npos ? stl::string_view{} : path.substr(slash + 1);
+            }
+            auto const& routes = nodes[current].routes;
+            return index < routes.size() ? routes[index].hits.load(stl::memory_order_relaxed) : 0;
+        }
+
+        /**
+         * @return how many routes are in this router
+         */
+        [[nodiscard]] stl::size_t route_count() const noexcept {
+            return count;
+        }
+
+        Response auto error(context_type const& ctx, status_code_type error_code,
+                            stl::string_view phrase = "") const noexcept {
+            return details::error_response(ctx, error_code, phrase);
+        }
+
+        /**
+         * Run the context through the routes of its path
+         */
+        response_type operator()(context_type& ctx) noexcept {
+            ctx.router_features.level = router_stats::route_level::entryroute;
+
+            if (reorder_interval != 0) {
+                auto const seen = requests.fetch_add(1, stl::memory_order_relaxed) + 1;
+                if (seen % reorder_interval == 0)
+                    reorder();
+                if (warm_up != 0 && seen >= warm_up) {
+                    reorder();
+                    freeze();
+                }
+            }
+
+            stl::optional<response_type> res;
+            path_captures                captures;
+            if (match(0, trim_path(ctx.request->request_uri()), ctx, captures, res))
+                return stl::move(*res);
+            return error(ctx, 404u);
+        }
+
+        template <typename RequestType>
+        requires(stl::same_as<stl::remove_cvref_t<RequestType>, typename context_type::request_type>)
+          response_type
+          operator()(RequestType& req) noexcept {
+            context_type ctx{req};
+            return this->operator()(ctx);
+        }
+    };
+
+    /**
+     * A dynamic_router that its whole route table can be replaced while the
+     * requests are being routed (the routes of a reloaded config, or of a
+     * plugin that's loaded again): the new router is built on the side and
+     * swapped in, and each request keeps the router that it started with
+     * until it's done, so the io threads never wait for the swap.
+     *
+     * The router is shared by all the threads, so its adaptive ordering is
+     * turned off when it's stored.
+     */
+    template <Context ContextType>
+    struct reloadable_router {
+        using context_type  = ContextType;
+        using router_type   = dynamic_router<context_type>;
+        using router_ptr    = stl::shared_ptr<router_type>;
+        using response_type = typename router_type::response_type;
+
+      private:
+        stl::atomic<router_ptr> current{stl::make_shared<router_type>()};
+
+      public:
+        reloadable_router() noexcept = default;
+
+        explicit reloadable_router(router_type router) noexcept {
+            store(stl::move(router));
+        }
+
+        /**
+         * The current router; it stays alive while it's held even if it's
+         * replaced in the meantime.
+         */
+        [[nodiscard]] router_ptr load() const noexcept {
+            return current.load(stl::memory_order_acquire);
+        }
+
+        /**
+         * Replace the routes; the requests that are being routed finish with
+         * the old ones.
+         */
+        void store(router_type router) noexcept {
+            router.freeze();
+            current.store(stl::make_shared<router_type>(stl::move(router)), stl::memory_order_release);
+        }
+
+        [[nodiscard]] stl::size_t route_count() const noexcept {
+            return load()->route_count();
+        }
+
+        response_type operator()(context_type& ctx) noexcept {
+            auto const router = load();
+            return (*router)(ctx);
+        }
+
+        template <typename RequestType>
+        requires(stl::same_as<stl::remove_cvref_t<RequestType>, typename context_type::request_type>)
+          response_type
+          operator()(RequestType& req) noexcept {
+            context_type ctx{req};
+            return this->operator()(ctx);
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_DYNAMIC_ROUTER_H
@@ -0,0 +1,158 @@
+#ifndef WEBPP_ROUTES_EXTENSIONS_GRAPHQL_H
+#define WEBPP_ROUTES_EXTENSIONS_GRAPHQL_H
+
+#include "../../../std/optional.hpp"
+#include "../../../std/string.hpp"
+#include "../../../std/string_view.hpp"
+#include "../../../utils/json.hpp"
+#include "../../graphql.hpp"
+#include "../../request_body.hpp"
+#include "../router.hpp"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace webpp::extensions {
+
+    /**
+     * A GraphQL endpoint (GraphQL over HTTP): the POSTs have a JSON body with the "query", the
+     * "operationName", the "variables", and the "extensions" (the persistedQuery of Apollo), or an
+     * application/graphql body that's only the query; the GETs have the same in their query string,
+     * and they can't run the mutations. The resolvers get the context of the request as their context
+     * (resolve_info::context_as<ContextType>()).
+     *
+     * The copies of the route share the service, and so its plans.
+     */
+    struct graphql_route {
+        stl::shared_ptr<::webpp::graphql::service> service;
+        stl::string_view                           path = "/graphql";
+
+        [[nodiscard]] constexpr stl::string_view static_path_prefix() const noexcept {
+            return path;
+        }
+
+        template <typename ContextType>
+        auto operator()(ContextType& ctx) const {
+            using response_type = decltype(webpp::details::error_response(ctx, 404u));
+            using str_t         = typename ContextType::traits_type::string_type;
+
+            stl::optional<response_type> res;
+            auto const&                  req    = *ctx.request;
+            stl::string_view const       uri    = req.request_uri();
+            stl::string_view const       method = req.request_method();
+            auto const                   query  = uri.find('?');
+            if (uri.substr(0, uri.find_first_of("?#")) != path)
+                return res;
+
+            ::webpp::graphql::request gql;
+            ::webpp::graphql::response result;
+            stl::string               decoded_query, decoded_name, decoded_hash; // the storage of the views
+            json::document            variables_doc, extensions_doc;
+            bool                      malformed = false;
+
+            auto const read_extensions = [&](json::element extensions) {
+                auto const hash = extensions["persistedQuery"]["sha256Hash"];
+                if (hash && !hash.string_value(decoded_hash))
+                    malformed = true;
+                gql.persisted_hash = decoded_hash;
+            };
+            auto const read_variables = [&](json::element variables) {
+                if (!variables || variables.is_null())
+                    return;
+                auto vars = ::webpp::graphql::from_json(variables);
+                if (auto* members = vars.as_object()) {
+                    gql.variables = stl::move(*members);
+                } else {
+                    malformed = true;
+                }
+            };
+
+            if (method == "POST") {
+                if (webpp::details::iequals_lower(webpp::details::media_type(req.header("Content-Type")),
+                                           "application/graphql")) {
+                    gql.query = req.body();
+                } else if (auto const& doc = req.json(); doc.is_valid() && doc.root().kind() == json::kind::object) {
+                    auto const root = doc.root();
+                    if (auto const q = root["query"]; q && !q.is_null() && !q.string_value(decoded_query))
+                        malformed = true;
+                    if (auto const name = root["operationName"];
+                        name && !name.is_null() && !name.string_value(decoded_name))
+                        malformed = true;
+                    gql.query          = decoded_query;
+                    gql.operation_name = decoded_name;
+                    read_variables(root["variables"]);
+                    read_extensions(root["extensions"]);
+                } else {
+                    malformed = true;
+                }
+            } else if (method == "GET" || method == "HEAD") {
+                gql.allow_mutations = false;
+                stl::vector<form_field> fields;
+                if (query != stl::string_view::npos) {
+                    auto const query_string = uri.substr(query + 1, uri.find('#', query) - query - 1);
+                    parse_form(query_string, fields);
+                }
+                stl::string decoded_variables, decoded_extensions;
+                for (auto const& field : fields) {
+                    bool decoded = true;
+                    if (field.name == "query") {
+                        decoded = field.decoded_value(decoded_query);
+                    } else if (field.name == "operationName") {
+                        decoded = field.decoded_value(decoded_name);
+                    } else if (field.name == "variables") {
+                        decoded = field.decoded_value(decoded_variables);
+                    } else if (field.name == "extensions") {
+                        decoded = field.decoded_value(decoded_extensions);
+                    }
+                    malformed = malformed || !decoded;
+                }
+                gql.query          = decoded_query;
+                gql.operation_name = decoded_name;
+                if (!decoded_variables.empty()) {
+                    if (variables_doc.parse(decoded_variables)) {
+                        read_variables(variables_doc.root());
+                    } else {
+                        malformed = true;
+                    }
+                }
+                if (!decoded_extensions.empty()) {
+                    if (extensions_doc.parse(decoded_extensions)) {
+                        read_extensions(extensions_doc.root());
+                    } else {
+                        malformed = true;
+                    }
+                }
+            } else {
+                res.emplace(webpp::details::error_response(ctx, 405u));
+                res->header.emplace(well_known_header_name(well_known_header::allow), "GET, HEAD, POST");
+                return res;
+            }
+
+            if (malformed) {
+                result.errors.push_back({.message = "the GraphQL request is not valid"});
+            } else {
+                result = service->execute(gql, &ctx);
+            }
+
+            str_t body;
+            json::serialize(body, result);
+            res.emplace(ctx.template response<string_response>(malformed ? 400u : 200u, stl::move(body)));
+            res->header.emplace(well_known_header_name(well_known_header::content_type),
+                                "application/json; charset=utf-8");
+            return res;
+        }
+    };
+
+    /**
+     * Serve the GraphQL service at the path (/graphql by default):
+     *   router{graphql(service), routes...}
+     */
+    [[nodiscard]] inline graphql_route graphql(stl::shared_ptr<::webpp::graphql::service> service,
+                                               stl::string_view                           path = "/graphql") {
+        return {stl::move(service), path};
+    }
+
+} // namespace webpp::extensions
+
+#endif // WEBPP_ROUTES_EXTENSIONS_GRAPHQL_H
@@ -0,0 +1,242 @@
+#ifndef WEBPP_ROUTES_EXTENSIONS_MEMOIZE_H
+#define WEBPP_ROUTES_EXTENSIONS_MEMOIZE_H
+
+#include "../../../std/optional.hpp"
+#include "../../../std/string.hpp"
+#include "../../../std/string_view.hpp"
+#include "../../../std/unordered_map.hpp"
+#include "../../../utils/request_arena.hpp"
+#include "../router.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace webpp::extensions {
+
+    /**
+     * The parts of the request that the memoized responses are keyed by; they
+     * can be combined: memo_key::path | memo_key::method
+     */
+    enum struct memo_key : stl::uint8_t {
+        path   = 1u << 0u,
+        query  = 1u << 1u,
+        method = 1u << 2u,
+
+        uri = path | query
+    };
+
+    [[nodiscard]] constexpr memo_key operator|(memo_key a, memo_key b) noexcept {
+        return static_cast<memo_key>(static_cast<stl::uint8_t>(a) | static_cast<stl::uint8_t>(b));
+    }
+
+    [[nodiscard]] constexpr bool has_key(memo_key keys, memo_key key) noexcept {
+        return (static_cast<stl::uint8_t>(keys) & static_cast<stl::uint8_t>(key)) != 0;
+    }
+
+    struct memoize_options {
+        stl::chrono::nanoseconds ttl         = stl::chrono::seconds{60};
+        stl::size_t              max_entries = 1024;
+        memo_key                 keys        = memo_key::uri;
+    };
+
+    namespace details {
+
+        /**
+         * The memoized responses of one route; it's shared between the copies
+         * of the route, and it's locked while it's being looked up or filled, not
+         * while the route is being called.
+         */
+        template <typename ResponseType, typename ClockType>
+        struct memo_cache {
+            using time_point = typename ClockType::time_point;
+
+            struct entry {
+                stl::string  key; // to tell the hash collisions apart
+                ResponseType response;
+                time_point   expires;
+            };
+
+            stl::mutex                                   lock{};
+            stl::unordered_map<stl::uint64_t, entry>     entries{};
+
+            stl::optional<ResponseType> find(stl::uint64_t hash, stl::string_view key, time_point now) {
+                stl::scoped_lock _lock{lock};
+                auto             it = entries.find(hash);
+                if (it == entries.end())
+                    return stl::nullopt;
+                if (it->second.expires <= now || it->second.key != key) {
+                    entries.erase(it);
+                    return stl::nullopt;
+                }
+                return it->second.response;
+            }
+
+            void put(stl::uint64_t hash, stl::string&& key, ResponseType const& response, time_point now,
+                     memoize_options const& options) {
+                if (options.max_entries == 0)
+                    return;
+                outside_request_arena const _outside; // the copy outlives the request
+                stl::scoped_lock            _lock{lock};
+                if (entries.size() >= options.max_entries && !entries.contains(hash)) {
+                    stl::erase_if(entries, [now](auto const& item) {
+                        return item.second.expires <= now;
+                    });
+                    if (entries.size() >= options.max_entries) {
+                        // still full, the one that expires first goes
+                        auto oldest = entries.begin();
+                        for (auto it = entries.begin(); it != entries.end(); ++it)
+                            if (it->second.expires < oldest->second.expires)
+                                oldest = it;
+                        entries.erase(oldest);
+                    }
+                }
+                entries.insert_or_assign(hash, entry{stl::move(key), response, now + options.ttl});
+            }
+
+            [[nodiscard]] stl::size_t size() noexcept {
+                stl::scoped_lock _lock{lock};
+                return entries.size();
+            }
+        };
+
+    } // namespace details
+
+    /**
+     * A route whose responses are remembered; the next requests with the same
+     * key (the path and the query by default) get a copy of the remembered
+     * response and the route is not called at all, until the response expires.
+     * So only memoize the routes that don't have side effects, and whose
+     * responses only depend on the key.
+     *
+     * When the route doesn't respond, nothing is remembered; the routes are
+     * used with one context type most of the time, so the cache is made for
+     * the first context type it's called with, and the other ones are passed
+     * through.
+     *
+     * @tparam Route the route to memoize
+     * @tparam ClockType a steady clock; the tests can use a fake one
+     */
+    template <typename Route, typename ClockType = stl::chrono::steady_clock>
+    struct memoized_route {
+        using route_type = Route;
+        using clock_type = ClockType;
+
+        route_type      route;
+        memoize_options options{};
+
+      private:
+        struct cache_holder {
+            stl::once_flag        once{};
+            stl::shared_ptr<void> cache{};
+            void const*           tag = nullptr; // the type of the cache
+        };
+
+        template <typename ResponseType>
+        static constexpr char tag_of = 0;
+
+        stl::shared_ptr<cache_holder> holder = stl::make_shared<cache_holder>();
+
+        template <typename ResponseType>
+        details::memo_cache<ResponseType, clock_type>* cache_of() const {
+            using cache_type = details::memo_cache<ResponseType, clock_type>;
+            stl::call_once(holder->once, [this] {
+                holder->cache = stl::make_shared<cache_type>();
+                holder->tag   = &tag_of<ResponseType>;
+            });
+            return holder->tag == &tag_of<ResponseType> ? static_cast<cache_type*>(holder->cache.get())
+                                                        : nullptr;
+        }
+
+        template <typename RequestType>
+        stl::string key_of(RequestType const& req) const {
+            stl::string      key;
+            stl::string_view uri = req.request_uri();
+            if (has_key(options.keys, memo_key::method)) {
+                key += req.request_method();
+                key += ' ';
+            }
+            auto const query_start = uri.find_first_of("?#");
+            if (has_key(options.keys, memo_key::path))
+                key += uri.substr(0, query_start);
+            if (has_key(options.keys, memo_key::query) && query_start != stl::string_view::npos &&
+                uri[query_start] == '?') {
+                auto query = uri.substr(query_start);
+                key += query.substr(0, query.find('#'));
+            }
+            return key;
+        }
+
+      public:
+        memoized_route(route_type _route, memoize_options _options = {}) noexcept
+          : route{stl::move(_route)},
+            options{_options} {}
+
+        [[nodiscard]] static constexpr routes::http_method static_method() noexcept
+          requires routes::MethodRoute<route_type> {
+            return route_type::static_method();
+        }
+
+        [[nodiscard]] constexpr stl::string_view static_path_prefix() const noexcept
+          requires PrefixedRoute<route_type> {
+            return route.static_path_prefix();
+        }
+
+        /**
+         * Get the remembered response, or call the route and remember what it returns
+         */
+        template <typename ContextType>
+        auto operator()(ContextType& ctx) const {
+            using response_type = decltype(webpp::details::error_response(ctx, 404u));
+
+            stl::optional<response_type> res;
+            auto* const                  cache = cache_of<response_type>();
+            if (!cache) {
+                webpp::details::take_route_result(webpp::details::call_route(route, ctx), ctx, res);
+                return res;
+            }
+
+            auto       key  = key_of(*ctx.request);
+            auto const hash = static_cast<stl::uint64_t>(stl::hash<stl::string_view>{}(key));
+            auto const now  = clock_type::now();
+            if (res = cache->find(hash, key, now); res)
+                return res;
+
+            using result_type = decltype(webpp::details::call_route(route, ctx));
+            if constexpr (!stl::is_void_v<result_type>) {
+                if (webpp::details::take_route_result(webpp::details::call_route(route, ctx), ctx, res))
+                    cache->put(hash, stl::move(key), *res, now, options);
+            } else {
+                webpp::details::call_route(route, ctx);
+            }
+            return res;
+        }
+
+        /**
+         * The number of the remembered responses; the expired ones are counted
+         * until they're looked up again or pushed out.
+         */
+        template <typename ContextType>
+        [[nodiscard]] stl::size_t cached_count() const {
+            using response_type = decltype(webpp::details::error_response(stl::declval<ContextType&>(), 404u));
+            auto* const cache   = cache_of<response_type>();
+            return cache ? cache->size() : 0;
+        }
+    };
+
+    /**
+     * Memoize the responses of a route:
+     *   router{memoize(tpath<"/page/{uint:num}">(render_page), {.ttl = 10s, .max_entries = 256})}
+     */
+    template <typename ClockType = stl::chrono::steady_clock, typename Route>
+    [[nodiscard]] auto memoize(Route&& route, memoize_options options = {}) {
+        return memoized_route<stl::remove_cvref_t<Route>, ClockType>{stl::forward<Route>(route), options};
+    }
+
+} // namespace webpp::extensions
+
+#endif // WEBPP_ROUTES_EXTENSIONS_MEMOIZE_H
@@ -0,0 +1,128 @@
+#ifndef WEBPP_ROUTES_EXTENSIONS_METRICS_H
+#define WEBPP_ROUTES_EXTENSIONS_METRICS_H
+
+#include "../../../std/optional.hpp"
+#include "../../../std/string.hpp"
+#include "../../../std/string_view.hpp"
+#include "../../../utils/metrics.hpp"
+#include "../router.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <type_traits>
+#include <utility>
+
+namespace webpp::extensions {
+
+    /**
+     * Count the responses of a route by their status class (webpp_requests_total{route, code}), and
+     * the time that it takes to respond (webpp_handler_duration_seconds{route}); the requests that the
+     * route doesn't respond to are not counted.
+     */
+    template <typename Route>
+    struct measured_route {
+        using route_type = Route;
+
+        route_type                    route;
+        stl::array<metric_counter, 5> responses{}; // 1xx to 5xx
+        metric_histogram              latency{};
+
+        measured_route(route_type _route, metrics_registry& registry, stl::string_view name)
+          : route{stl::move(_route)},
+            latency{registry.histogram("webpp_handler_duration_seconds",
+                                       "The time that the routes take to respond",
+                                       {{"route", name}})} {
+            static constexpr stl::array<stl::string_view, 5> codes{"1xx", "2xx", "3xx", "4xx", "5xx"};
+            for (stl::size_t i = 0; i < codes.size(); i++) {
+                responses[i] = registry.counter("webpp_requests_total",
+                                                "The requests that the routes have responded to",
+                                                {{"route", name}, {"code", codes[i]}});
+            }
+        }
+
+        [[nodiscard]] static constexpr routes::http_method static_method() noexcept
+          requires routes::MethodRoute<route_type> {
+            return route_type::static_method();
+        }
+
+        [[nodiscard]] constexpr stl::string_view static_path_prefix() const noexcept
+          requires PrefixedRoute<route_type> {
+            return route.static_path_prefix();
+        }
+
+        template <typename ContextType>
+        auto operator()(ContextType& ctx) const {
+            using response_type = decltype(webpp::details::error_response(ctx, 404u));
+            using result_type   = decltype(webpp::details::call_route(route, ctx));
+
+            stl::optional<response_type> res;
+            auto const                   start = stl::chrono::steady_clock::now();
+            if constexpr (stl::is_void_v<result_type>) {
+                webpp::details::call_route(route, ctx);
+                return res;
+            } else {
+                if (!webpp::details::take_route_result(webpp::details::call_route(route, ctx), ctx, res))
+                    return res;
+                latency.observe(stl::chrono::steady_clock::now() - start);
+                auto const status = static_cast<stl::size_t>(res->header.status_code) / 100;
+                responses[stl::clamp<stl::size_t>(status, 1, 5) - 1].inc();
+                return res;
+            }
+        }
+    };
+
+    /**
+     * Measure the responses of a route, under the name:
+     *   router{measure(registry, "posts", tpath<"/posts/{id}">(show_post))}
+     */
+    template <typename Route>
+    [[nodiscard]] auto measure(metrics_registry& registry, stl::string_view name, Route&& route) {
+        return measured_route<stl::remove_cvref_t<Route>>{stl::forward<Route>(route), registry, name};
+    }
+
+    /**
+     * Answer the GET requests of the path with the metrics of the registry, in the text format of
+     * Prometheus; the registry should outlive the router.
+     */
+    struct metrics_route {
+        metrics_registry* registry;
+        stl::string_view  path = "/metrics";
+
+        [[nodiscard]] constexpr stl::string_view static_path_prefix() const noexcept {
+            return path;
+        }
+
+        template <typename ContextType>
+        auto operator()(ContextType& ctx) const {
+            using response_type = decltype(webpp::details::error_response(ctx, 404u));
+            using str_t         = typename ContextType::traits_type::string_type;
+
+            stl::optional<response_type> res;
+            auto const&                  req    = *ctx.request;
+            stl::string_view const       uri    = req.request_uri();
+            stl::string_view const       method = req.request_method();
+            if (uri.substr(0, uri.find_first_of("?#")) != path || (method != "GET" && method != "HEAD"))
+                return res;
+
+            str_t text;
+            registry->write_text(text);
+            res.emplace(ctx.template response<string_response>(stl::move(text)));
+            res->header.emplace(well_known_header_name(well_known_header::content_type),
+                                "text/plain; version=0.0.4; charset=utf-8");
+            return res;
+        }
+    };
+
+    /**
+     * Serve the metrics at the path (/metrics by default):
+     *   router{expose_metrics(registry), routes...}
+     */
+    [[nodiscard]] inline metrics_route expose_metrics(metrics_registry& registry,
+                                                      stl::string_view  path = "/metrics") noexcept {
+        return {&registry, path};
+    }
+
+} // namespace webpp::extensions
+
+#endif // WEBPP_ROUTES_EXTENSIONS_METRICS_H
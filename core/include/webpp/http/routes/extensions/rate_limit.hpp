@@ -0,0 +1,112 @@
+#ifndef WEBPP_ROUTES_EXTENSIONS_RATE_LIMIT_H
+#define WEBPP_ROUTES_EXTENSIONS_RATE_LIMIT_H
+
+#include "../../../std/optional.hpp"
+#include "../../../std/string_view.hpp"
+#include "../../../utils/casts.hpp"
+#include "../../../utils/embedded_assets.hpp"
+#include "../../../utils/ipv4.hpp"
+#include "../../../utils/ipv6.hpp"
+#include "../../../utils/rate_limiter.hpp"
+#include "../router.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace webpp::extensions {
+
+    /**
+     * The key of the client of the request: its address, from REMOTE_ADDR on the interfaces that have
+     * it (CGI, FastCGI), or from the connection (remote_address) on the servers. The ipv6 clients are
+     * keyed by their /64, since that's what one of them usually gets; the v4-mapped ones by their ipv4.
+     * There's no key if the address is not known (the client is gone); the clients are never put in
+     * one shared bucket.
+     */
+    struct client_address {
+        template <typename ContextType>
+        [[nodiscard]] stl::optional<stl::uint64_t> operator()(ContextType const& ctx) const noexcept {
+            using traits_type = typename ContextType::traits_type;
+            auto const&      req = *ctx.request;
+            stl::string_view addr;
+            if constexpr (requires { req.env("REMOTE_ADDR"); }) {
+                addr = req.env("REMOTE_ADDR");
+            } else if constexpr (requires { req.remote_address(); }) {
+                addr = req.remote_address();
+            } else {
+                static_assert(!sizeof(ContextType),
+                              "The requests of this interface don't know the address of the client; give "
+                              "limit_rate a key function.");
+            }
+            if (addr.empty())
+                return stl::nullopt;
+            if (addr.find(':') != stl::string_view::npos) {
+                ipv6<traits_type> const ip{addr};
+                if (ip.is_valid())
+                    return ip.is_v4_mapped() ? ip.octets64()[1] & 0xFFFF'FFFFULL : ip.octets64()[0];
+            } else {
+                ipv4<traits_type> const ip{addr};
+                if (ip.is_valid())
+                    return ip.integer();
+            }
+            return webpp::details::asset_hash(addr, 0);
+        }
+    };
+
+    /**
+     * A route that rejects the clients that are over their rate limit with a 429 (and a Retry-After),
+     * and lets the rest of them through to the next routes; it's put before the routes that it guards,
+     * so the rejected requests don't cost any routing:
+     *   router{limit_rate({.rate = 20, .burst = 40}), routes...}
+     *
+     * The key function gets the context and returns the key of the client (see client_address), or an
+     * empty optional if it doesn't have one, which lets the request through; the copies of the route
+     * share the limiter.
+     */
+    template <typename KeyFunc = client_address, typename ClockType = stl::chrono::steady_clock>
+    struct rate_limited_route {
+        using limiter_type = rate_limiter<ClockType>;
+
+        stl::shared_ptr<limiter_type> limiter;
+        KeyFunc                       key_of{};
+
+        template <typename ContextType>
+        auto operator()(ContextType& ctx) const {
+            using response_type = decltype(webpp::details::error_response(ctx, 429u));
+
+            stl::optional<response_type> res;
+            auto const    key = stl::invoke(key_of, stl::as_const(ctx));
+            rate_decision decision{};
+            if constexpr (requires { key.has_value(); }) {
+                if (!key)
+                    return res; // there's no one to count it for
+                decision = limiter->acquire(*key);
+            } else {
+                decision = limiter->acquire(key);
+            }
+            if (!decision) {
+                auto const seconds = stl::chrono::ceil<stl::chrono::seconds>(decision.retry_after).count();
+                res.emplace(webpp::details::error_response(ctx, 429u));
+                res->header.emplace(well_known_header_name(well_known_header::retry_after),
+                                    to_str_buffer(seconds).view());
+            }
+            return res;
+        }
+    };
+
+    /**
+     * Limit the rate of the requests of each client; the clients are keyed by the key function, and
+     * "max_keys" of them are kept track of at a time (see rate_limiter).
+     */
+    template <typename ClockType = stl::chrono::steady_clock, typename KeyFunc = client_address>
+    [[nodiscard]] auto limit_rate(rate_limit limit, KeyFunc&& key_of = {}, stl::size_t max_keys = 65'536) {
+        using route_type = rate_limited_route<stl::remove_cvref_t<KeyFunc>, ClockType>;
+        return route_type{stl::make_shared<typename route_type::limiter_type>(limit, max_keys),
+                          stl::forward<KeyFunc>(key_of)};
+    }
+
+} // namespace webpp::extensions
+
+#endif // WEBPP_ROUTES_EXTENSIONS_RATE_LIMIT_H
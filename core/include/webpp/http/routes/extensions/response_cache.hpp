@@ -0,0 +1,414 @@
+#ifndef WEBPP_ROUTES_EXTENSIONS_RESPONSE_CACHE_H
+#define WEBPP_ROUTES_EXTENSIONS_RESPONSE_CACHE_H
+
+#include "../../../cache/lru_cache.hpp"
+#include "../../../cache/sharded_cache.hpp"
+#include "../../../std/optional.hpp"
+#include "../../../std/string.hpp"
+#include "../../../std/string_view.hpp"
+#include "../../../utils/casts.hpp"
+#include "../../../utils/embedded_assets.hpp"
+#include "../../../utils/request_arena.hpp"
+#include "../../../utils/strings.hpp"
+#include "../../http_date.hpp"
+#include "../router.hpp"
+
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace webpp::extensions {
+
+    struct response_cache_options {
+        // how long the responses are kept when they don't have a max-age of their own
+        stl::chrono::nanoseconds ttl         = stl::chrono::seconds{60};
+        stl::size_t              max_entries = 1024;
+    };
+
+    namespace details {
+
+        /**
+         * The value of the header of the response, or empty
+         */
+        template <typename ResponseType>
+        [[nodiscard]] stl::string_view header_of(ResponseType const& res, well_known_header name) noexcept {
+            for (auto const& field : res.header)
+                if (field.known == name)
+                    return {field.value.data(), field.value.size()};
+            return {};
+        }
+
+        /**
+         * Call the function with each one of the items of a comma-separated header, without the spaces
+         * around them; it stops when the function returns true.
+         */
+        template <typename Func>
+        constexpr bool any_of_list(stl::string_view list, Func&& func) noexcept {
+            while (!list.empty()) {
+                auto const comma = list.find(',');
+                auto       item  = list.substr(0, comma);
+                list.remove_prefix(comma == stl::string_view::npos ? list.size() : comma + 1);
+                auto const start = item.find_first_not_of(" \t");
+                if (start == stl::string_view::npos)
+                    continue;
+                if (func(item.substr(start, item.find_last_not_of(" \t") + 1 - start)))
+                    return true;
+            }
+            return false;
+        }
+
+        /**
+         * The value of a directive of a Cache-Control header: nullopt if it's not there, and empty if it
+         * doesn't have a value ("no-store")
+         */
+        [[nodiscard]] constexpr stl::optional<stl::string_view>
+        cache_directive(stl::string_view header, stl::string_view name) noexcept {
+            stl::optional<stl::string_view> res;
+            any_of_list(header, [&](stl::string_view item) constexpr noexcept {
+                auto const eq = item.find('=');
+                if (!ascii_iequals(item.substr(0, eq), name))
+                    return false;
+                auto value = eq == stl::string_view::npos ? stl::string_view{} : item.substr(eq + 1);
+                if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+                    value = value.substr(1, value.size() - 2);
+                res = value;
+                return true;
+            });
+            return res;
+        }
+
+        /**
+         * Whether one of the entity tags of an If-None-Match header matches the ETag; they're compared
+         * weakly (the "W/" is ignored), as they should be for a GET.
+         */
+        [[nodiscard]] constexpr bool etag_matches(stl::string_view if_none_match,
+                                                  stl::string_view etag) noexcept {
+            auto const opaque = [](stl::string_view tag) constexpr noexcept {
+                return tag.starts_with("W/") ? tag.substr(2) : tag;
+            };
+            return any_of_list(if_none_match, [&](stl::string_view item) constexpr noexcept {
+                return item == "*" || (!etag.empty() && opaque(item) == opaque(etag));
+            });
+        }
+
+        /**
+         * A strong ETag of the body: its 64-bit hash, in hex
+         */
+        [[nodiscard]] inline stl::string body_etag(stl::string_view body) {
+            auto const           hash = webpp::details::asset_hash(body, 0);
+            stl::array<char, 18> etag{};
+            etag.front() = '"';
+            auto* end    = stl::to_chars(etag.data() + 1, etag.data() + etag.size(), hash, 16).ptr;
+            *end++       = '"';
+            return {etag.data(), end};
+        }
+
+        /**
+         * The cached responses of one route, with what the conditional requests are answered by; the
+         * entries are kept in a sharded LRU cache, and the route is not called while one is fresh.
+         */
+        template <typename ResponseType, typename ClockType>
+        struct response_cache_store {
+            using time_point = typename ClockType::time_point;
+
+            struct entry {
+                ResponseType response;
+                stl::string  etag{};
+                stl::int64_t last_modified = 0;  // the seconds since the epoch
+                stl::string  varied{};           // the values of the request headers that the Vary names
+                time_point   stored{};
+                time_point   expires{};
+            };
+
+            sharded_cache<lru_cache<stl::string, entry>, 16> entries;
+
+            explicit response_cache_store(stl::size_t max_entries)
+              : entries{stl::max<stl::size_t>(max_entries, 16)} {}
+        };
+
+    } // namespace details
+
+    /**
+     * A route whose responses are cached like a shared HTTP cache (a CDN) would cache them: the fresh
+     * responses of the GET and HEAD requests are served from the cache without calling the route, and
+     * the conditional requests (If-None-Match, If-Modified-Since) whose copies are up-to-date get a 304
+     * without a body.
+     *
+     * The responses get a strong ETag (the hash of the body) and a Last-Modified (the time they were
+     * cached) if they don't have them already. They're kept for their "s-maxage" or "max-age" of their
+     * Cache-Control, or the TTL of the options; the ones that are "no-store", "private", "no-cache", that
+     * set cookies, that are not 200, or that "Vary: *" are not kept at all. They're keyed by the method,
+     * the Host and the URI (without the fragment), and they vary by the request headers that their Vary
+     * header names. The requests with "Cache-Control: no-cache" skip the cached copy (the new response
+     * replaces it), the ones with "no-store" aren't kept, and the ones with an Authorization are passed
+     * through.
+     *
+     * Like memoized_route, the route shouldn't have side effects, and the cache is made for the first
+     * context type that it's called with.
+     */
+    template <typename Route, typename ClockType = stl::chrono::steady_clock>
+    struct cached_route {
+        using route_type = Route;
+        using clock_type = ClockType;
+
+        route_type             route;
+        response_cache_options options{};
+
+      private:
+        struct cache_holder {
+            stl::once_flag        once{};
+            stl::shared_ptr<void> cache{};
+            void const*           tag = nullptr; // the type of the cache
+        };
+
+        template <typename ResponseType>
+        static constexpr char tag_of = 0;
+
+        stl::shared_ptr<cache_holder> holder = stl::make_shared<cache_holder>();
+
+        template <typename ResponseType>
+        details::response_cache_store<ResponseType, clock_type>* cache_of() const {
+            using cache_type = details::response_cache_store<ResponseType, clock_type>;
+            stl::call_once(holder->once, [this] {
+                outside_request_arena const _outside;
+                holder->cache = stl::make_shared<cache_type>(options.max_entries);
+                holder->tag   = &tag_of<ResponseType>;
+            });
+            return holder->tag == &tag_of<ResponseType> ? static_cast<cache_type*>(holder->cache.get())
+                                                        : nullptr;
+        }
+
+        template <typename RequestType>
+        [[nodiscard]] static stl::string_view request_header(RequestType const& req, stl::string_view name) {
+            if constexpr (requires { req.header(name); }) {
+                return req.header(name);
+            } else {
+                return {};
+            }
+        }
+
+        // the method, the host (the ":authority" of HTTP/2), the path and the query; a HEAD response is
+        // not a GET's, and the virtual hosts don't share their pages
+        template <typename RequestType>
+        [[nodiscard]] static stl::string key_of(RequestType const& req) {
+            stl::string_view const method = req.request_method();
+            stl::string_view const host   = request_header(req, "Host");
+            stl::string_view       uri    = req.request_uri();
+            uri                           = uri.substr(0, uri.find('#'));
+            stl::string key;
+            key.reserve(method.size() + host.size() + uri.size() + 1);
+            key += method;
+            key += ' ';
+            key += host;
+            key += uri;
+            return key;
+        }
+
+        // the values of the request headers that the response varies by
+        template <typename RequestType>
+        [[nodiscard]] static stl::string varied_by(RequestType const& req, stl::string_view vary) {
+            stl::string res;
+            details::any_of_list(vary, [&](stl::string_view name) {
+                res += request_header(req, name);
+                res += '\n';
+                return false;
+            });
+            return res;
+        }
+
+        /**
+         * Whether the client's copy is up-to-date; the If-None-Match wins if it's there
+         */
+        template <typename RequestType, typename Entry>
+        [[nodiscard]] static bool not_modified(RequestType const& req, Entry const& item) {
+            if (auto const if_none_match = request_header(req, "If-None-Match"); !if_none_match.empty())
+                return details::etag_matches(if_none_match, item.etag);
+            auto const since = parse_http_date(request_header(req, "If-Modified-Since"));
+            return since && item.last_modified <= *since;
+        }
+
+        // the 304 has the validators and the caching headers of the response, but not its body
+        template <typename ContextType, typename ResponseType>
+        [[nodiscard]] static auto not_modified_response(ContextType& ctx, ResponseType const& source) {
+            auto res = ctx.template response<string_response>(304u);
+            for (auto const& field : source.header) {
+                switch (field.known) {
+                    case well_known_header::cache_control:
+                    case well_known_header::content_location:
+                    case well_known_header::content_length:
+                    case well_known_header::etag:
+                    case well_known_header::expires:
+                    case well_known_header::last_modified:
+                    case well_known_header::vary: res.header.emplace(field.name, field.value); break;
+                    default: break;
+                }
+            }
+            return res;
+        }
+
+        /**
+         * Add an ETag and a Last-Modified to the response if it doesn't have them
+         */
+        template <typename Entry, typename ResponseType>
+        static void add_validators(Entry& item, ResponseType& res) {
+            if (auto const etag = details::header_of(res, well_known_header::etag); !etag.empty()) {
+                item.etag = etag;
+            } else if constexpr (requires { res.body.str(); }) {
+                if (!res.header.contains(well_known_header::content_encoding)) {
+                    auto const& body = res.body.str();
+                    item.etag        = details::body_etag({body.data(), body.size()});
+                    res.header.emplace(well_known_header_name(well_known_header::etag), item.etag);
+                }
+            }
+            auto const modified = parse_http_date(details::header_of(res, well_known_header::last_modified));
+            if (modified) {
+                item.last_modified = *modified;
+                return;
+            }
+            auto const now     = stl::chrono::system_clock::now();
+            item.last_modified = stl::chrono::floor<stl::chrono::seconds>(now).time_since_epoch().count();
+            stl::array<char, http_date_size> date;
+            format_http_date(now, date.data());
+            res.header.emplace(well_known_header_name(well_known_header::last_modified),
+                               stl::string_view{date.data(), date.size()});
+        }
+
+        /**
+         * How long the response can be kept; nullopt if it can't be
+         */
+        template <typename ResponseType>
+        [[nodiscard]] stl::optional<typename clock_type::duration> ttl_of(ResponseType const& res) const {
+            auto const cache_control = details::header_of(res, well_known_header::cache_control);
+            if (res.header.contains(well_known_header::set_cookie) ||
+                details::cache_directive(cache_control, "no-store") ||
+                details::cache_directive(cache_control, "private") ||
+                details::cache_directive(cache_control, "no-cache") ||
+                details::header_of(res, well_known_header::vary).find('*') != stl::string_view::npos) {
+                return stl::nullopt;
+            }
+            auto max_age = details::cache_directive(cache_control, "s-maxage");
+            if (!max_age)
+                max_age = details::cache_directive(cache_control, "max-age");
+            if (!max_age)
+                return stl::chrono::duration_cast<typename clock_type::duration>(options.ttl);
+            stl::int64_t seconds = 0;
+            auto const   end     = max_age->data() + max_age->size();
+            auto const [ptr, ec] = stl::from_chars(max_age->data(), end, seconds);
+            if (ec != stl::errc{} || seconds <= 0)
+                return stl::nullopt;
+            return stl::chrono::duration_cast<typename clock_type::duration>(stl::chrono::seconds{seconds});
+        }
+
+      public:
+        cached_route(route_type _route, response_cache_options _options = {}) noexcept
+          : route{stl::move(_route)},
+            options{_options} {}
+
+        [[nodiscard]] static constexpr routes::http_method static_method() noexcept
+          requires routes::MethodRoute<route_type> {
+            return route_type::static_method();
+        }
+
+        [[nodiscard]] constexpr stl::string_view static_path_prefix() const noexcept
+          requires PrefixedRoute<route_type> {
+            return route.static_path_prefix();
+        }
+
+        /**
+         * The cached response (or a 304), or call the route and cache what it returns
+         */
+        template <typename ContextType>
+        auto operator()(ContextType& ctx) const {
+            using response_type = decltype(webpp::details::error_response(ctx, 404u));
+            using result_type   = decltype(webpp::details::call_route(route, ctx));
+            using entry_type    = typename details::response_cache_store<response_type, clock_type>::entry;
+
+            stl::optional<response_type> res;
+            if constexpr (stl::is_void_v<result_type>) {
+                webpp::details::call_route(route, ctx);
+                return res;
+            } else {
+                auto const& req    = *ctx.request;
+                auto const  method = stl::string_view{req.request_method()};
+                auto* const cache  = cache_of<response_type>();
+                if (!cache || (method != "GET" && method != "HEAD") ||
+                    !request_header(req, "Authorization").empty()) {
+                    webpp::details::take_route_result(webpp::details::call_route(route, ctx), ctx, res);
+                    return res;
+                }
+
+                auto const request_control = request_header(req, "Cache-Control");
+                auto       key             = key_of(req);
+                auto const now             = clock_type::now();
+                if (!details::cache_directive(request_control, "no-cache")) {
+                    auto item = cache->entries.get(key);
+                    if (item && item->expires <= now) {
+                        cache->entries.erase(key);
+                        item.reset();
+                    }
+                    auto const vary = item ? details::header_of(item->response, well_known_header::vary) : "";
+                    if (item && item->varied == varied_by(req, vary)) {
+                        if (not_modified(req, *item)) {
+                            res.emplace(not_modified_response(ctx, item->response));
+                            return res;
+                        }
+                        auto const age = stl::chrono::floor<stl::chrono::seconds>(now - item->stored).count();
+                        res.emplace(stl::move(item->response));
+                        res->header.emplace(well_known_header_name(well_known_header::age),
+                                            to_str_buffer(age).view());
+                        return res;
+                    }
+                }
+
+                if (!webpp::details::take_route_result(webpp::details::call_route(route, ctx), ctx, res) ||
+                    res->header.status_code != 200u)
+                    return res;
+
+                entry_type item{.response = {}};
+                add_validators(item, *res);
+                auto const up_to_date = not_modified(req, item);
+                auto const ttl        = ttl_of(*res);
+                if (ttl && !details::cache_directive(request_control, "no-store")) {
+                    outside_request_arena const _outside; // the copy outlives the request
+                    item.response = *res;
+                    item.varied   = varied_by(req, details::header_of(*res, well_known_header::vary));
+                    item.stored   = now;
+                    item.expires  = now + *ttl;
+                    cache->entries.set(stl::move(key), stl::move(item));
+                }
+                if (up_to_date)
+                    res.emplace(not_modified_response(ctx, *res));
+                return res;
+            }
+        }
+
+        /**
+         * The number of the cached responses; the expired ones are counted until they're looked up
+         * again or pushed out.
+         */
+        template <typename ContextType>
+        [[nodiscard]] stl::size_t cached_count() const {
+            using response_type =
+              decltype(webpp::details::error_response(stl::declval<ContextType&>(), 404u));
+            auto* const cache = cache_of<response_type>();
+            return cache ? cache->entries.size() : 0;
+        }
+    };
+
+    /**
+     * Cache the responses of a route, and answer the conditional requests:
+     *   router{cache_responses(tpath<"/blog/{slug}">(render_post), {.ttl = 5min})}
+     */
+    template <typename ClockType = stl::chrono::steady_clock, typename Route>
+    [[nodiscard]] auto cache_responses(Route&& route, response_cache_options options = {}) {
+        return cached_route<stl::remove_cvref_t<Route>, ClockType>{stl::forward<Route>(route), options};
+    }
+
+} // namespace webpp::extensions
+
+#endif // WEBPP_ROUTES_EXTENSIONS_RESPONSE_CACHE_H
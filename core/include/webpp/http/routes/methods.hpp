@@ -1,10 +1,102 @@
 #ifndef WEBPP_VALVES_METHODS_H
 #define WEBPP_VALVES_METHODS_H
 
+#include "../../std/optional.hpp"
+#include "../../std/string_view.hpp"
 #include "route.hpp"
 
+#include <bit>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
 namespace webpp::routes {
 
+    /**
+     * The methods that the router has a bucket for; the rest of them are "other"
+     */
+    enum struct http_method : stl::uint8_t { get, head, post, put, delete_, connect, options, trace, patch, other };
+
+    static constexpr stl::size_t http_method_count = static_cast<stl::size_t>(http_method::other) + 1;
+
+    [[nodiscard]] constexpr http_method parse_http_method(stl::string_view method) noexcept {
+        switch (method.size()) {
+            case 3:
+                return method == "GET" ? http_method::get
+                                       : method == "PUT" ? http_method::put : http_method::other;
+            case 4:
+                return method == "POST" ? http_method::post
+                                        : method == "HEAD" ? http_method::head : http_method::other;
+            case 5:
+                return method == "PATCH" ? http_method::patch
+                                         : method == "TRACE" ? http_method::trace : http_method::other;
+            case 6: return method == "DELETE" ? http_method::delete_ : http_method::other;
+            case 7:
+                return method == "OPTIONS" ? http_method::options
+                                           : method == "CONNECT" ? http_method::connect : http_method::other;
+            default: return http_method::other;
+        }
+    }
+
+    /**
+     * The routes that only respond to one method can say so at compile time;
+     * the router puts them in the bucket of that method and doesn't even call
+     * them for the requests of the other methods.
+     */
+    template <typename T>
+    concept MethodRoute = requires {
+        { T::static_method() } -> stl::same_as<http_method>;
+        requires stl::bool_constant<(T::static_method(), true)>::value; // it's a constant expression
+    };
+
+    /**
+     * A condition on the method of the request, as a set of methods; the
+     * method sets are merged when they're combined (method<get> || method<head>
+     * is one bit test), and a set of one method is a MethodRoute.
+     */
+    template <stl::uint16_t Mask>
+    struct method_set : combinable {
+        static constexpr bool          is_static_condition = true;
+        static constexpr stl::uint16_t mask                = Mask;
+
+        [[nodiscard]] static constexpr http_method static_method() noexcept
+          requires(stl::has_single_bit(Mask)) {
+            return static_cast<http_method>(stl::countr_zero(Mask));
+        }
+
+        template <typename ContextType>
+        constexpr bool operator()(ContextType const& ctx) const noexcept {
+            auto const bit = static_cast<stl::uint16_t>(parse_http_method(ctx.request->request_method()));
+            return ((Mask >> bit) & 1u) != 0;
+        }
+    };
+
+    template <http_method... Methods>
+    inline constexpr method_set<((stl::uint16_t{1} << static_cast<stl::uint16_t>(Methods)) | ...)> method{};
+
+    template <stl::uint16_t A, stl::uint16_t B>
+    constexpr auto fuse_and(method_set<A> const&, method_set<B> const&) noexcept {
+        if constexpr ((A & B) == 0) {
+            return never;
+        } else {
+            return method_set<(A & B)>{};
+        }
+    }
+
+    template <stl::uint16_t A, stl::uint16_t B>
+    constexpr auto fuse_or(method_set<A> const&, method_set<B> const&) noexcept {
+        return method_set<(A | B)>{};
+    }
+
+    template <stl::uint16_t A, stl::uint16_t B>
+    constexpr auto fuse_xor(method_set<A> const&, method_set<B> const&) noexcept {
+        if constexpr ((A ^ B) == 0) {
+            return never;
+        } else {
+            return method_set<(A ^ B)>{};
+        }
+    }
+
     struct method_condition {
       private:
         const stl::string_view method_string;
@@ -22,6 +114,51 @@ namespace webpp::routes {
         }
     };
 
+    /**
+     * A route that only calls its handler for the requests of one method; the
+     * handler is called with the context, the request, or nothing. If the
+     * method doesn't match, it returns an empty optional (or false, or nothing,
+     * depending on what the handler returns).
+     */
+    template <http_method Method, typename Handler>
+    struct method_route {
+        Handler handler;
+
+        [[nodiscard]] static constexpr http_method static_method() noexcept {
+            return Method;
+        }
+
+        [[nodiscard]] constexpr stl::string_view static_path_prefix() const noexcept
+          requires requires(Handler const h) { {h.static_path_prefix()}; } {
+            return handler.static_path_prefix();
+        }
+
+        template <typename ContextType>
+        constexpr auto operator()(ContextType& ctx) const noexcept {
+            auto const call = [&]() noexcept {
+                if constexpr (stl::is_invocable_v<Handler const&, ContextType&>) {
+                    return handler(ctx);
+                } else if constexpr (stl::is_invocable_v<Handler const&,
+                                                         typename ContextType::request_type const&>) {
+                    return handler(*ctx.request);
+                } else {
+                    return handler();
+                }
+            };
+            bool const matches = parse_http_method(ctx.request->request_method()) == Method;
+            return webpp::details::call_if(matches, call);
+        }
+    };
+
+    /**
+     * Make a route that only responds to the specified method:
+     *   router{on<http_method::post>([](auto& ctx) { ... })}
+     */
+    template <http_method Method, typename Handler>
+    [[nodiscard]] constexpr auto on(Handler&& handler) noexcept {
+        return method_route<Method, stl::remove_cvref_t<Handler>>{stl::forward<Handler>(handler)};
+    }
+
     //    struct method : public routes::route<method_condition> {
     //        using routes::route<method_condition>::valve;
     //    };
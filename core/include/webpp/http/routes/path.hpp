@@ -6,6 +6,7 @@
 #include "../../std/optional.hpp"
 #include "../../utils/fixed_string.hpp"
 #include "../../utils/uri.hpp"
+#include "./path_segments.hpp"
 #include "route.hpp"
 
 #include <type_traits>
@@ -34,7 +35,7 @@ namespace webpp::routes {
      * This class is used as a field type in the context type of the
      * internal sub routes of the "path" sub route.
      */
-    template <Context ContextType, typename PathType, typename UriSegmentsType>
+    template <typename ContextType, typename PathType, typename UriSegmentsType>
     struct path_field {
         using context_type           = ContextType;
         using traits_type            = typename context_type::traits_type;
@@ -45,14 +46,16 @@ namespace webpp::routes {
 
         // todo: also give access to the segments the user specified
 
-        segments_type          segments{};
+        // they point into the segments of the context, which are shared
+        // between all of the path routes (see basic_context::segments)
         segments_iterator_type current_segment{};
+        segments_iterator_type segments_end{};
 
         path_type* pth = nullptr;
 
         bool next_segment() noexcept {
             // todo: should this method be private?
-            return ++current_segment != segments.end();
+            return ++current_segment != segments_end;
         }
 
         //        template <fixed_string segment_variable_name>
@@ -75,19 +78,21 @@ namespace webpp::routes {
     template <typename PathType, typename UriSegmentsType>
     struct path_context_extension {
 
-        template <Traits TraitsType, typename ContextType>
-        struct path_extension : public virtual ContextType {
-
-            template <typename... Args>
-            constexpr path_extension(Args&&... args) noexcept : ContextType{stl::forward<Args>(args)...} {
-            }
+        // a child extension of the context; it's only a few pointers, so
+        // adding it to the context doesn't allocate and is cheap to copy
+        struct path_extension {
+            template <Traits TraitsType, typename ContextType>
+            struct type : public ContextType {
 
+                template <typename... Args>
+                constexpr type(Args&&... args) noexcept : ContextType{stl::forward<Args>(args)...} {
+                }
 
-            path_field<ContextType, PathType, UriSegmentsType> path{};
+                path_field<ContextType, PathType, UriSegmentsType> path{};
+            };
         };
 
-        template <Traits TraitsType, typename ContextType>
-        using context_extensions = extension_pack<path_extension<TraitsType, ContextType>>;
+        using context_extensions = extension_pack<path_extension>;
     };
 
     /**
@@ -271,25 +276,23 @@ namespace webpp::routes {
 
             if constexpr (!has_path_extension) {
 
-                // parse the uri
-                // todo: we can optimize this, right? it parses the whole uri, do we need the whole uri? I think yes
+                // the uri is parsed once per request, the first time a path
+                // route asks for it; the other path routes reuse it
                 // fixme: should we decode it? if we decode it we need to care about the UTF-8 stuff as well?
-                auto uri_segments =
-                  basic_uri<traits_type, false>{ctx.request.request_uri()}.path_structured();
-                using uri_segments_type = decltype(uri_segments);
+                auto const& uri_segments = ctx.segments();
 
                 // context switching
-                auto new_ctx = ctx.template clone<path_context_extension<path_type, uri_segments_type>>();
+                auto new_ctx = ctx.template clone<path_context_extension<path_type, routes::path_segments>>();
                 static_assert(
                   requires { {new_ctx.path}; },
                   "For some reason, we're not able to perform context switching.");
 
-                new_ctx.path.segments        = stl::move(uri_segments);
-                new_ctx.path.current_segment = new_ctx.path.segments.begin();
+                new_ctx.path.current_segment = uri_segments.begin();
+                new_ctx.path.segments_end    = uri_segments.end();
                 new_ctx.path.pth             = this;
 
                 // nothing to do if the segment counts don't match
-                if (new_ctx.path.current_segment == new_ctx.path.current_segment.end())
+                if (new_ctx.path.current_segment == new_ctx.path.segments_end)
                     return false;
 
                 return run(stl::move(new_ctx));
@@ -7,9 +7,11 @@
 
 #include "../../../std/optional.hpp"
 #include "../../../std/string_view.hpp"
+#include "../../../utils/casts.hpp"
 #include "../../../validators/validators.hpp"
 #include "../path.hpp"
 
+#include <cstdint>
 #include <type_traits>
 
 namespace webpp::routes {
@@ -21,27 +23,50 @@ namespace webpp::routes {
             return is::number(ctx.path.current_segment);
         }
 
+        /**
+         * The number of the segment; the integers and the floating points are
+         * parsed strictly (see parse_number), and the other types that can be
+         * made of a long double are made of one.
+         */
         template <typename T>
-        requires(stl::is_integral_v<T> || stl::is_constructible_v<T, long double>)
+        requires(stl::is_arithmetic_v<T> || stl::is_constructible_v<T, long double>)
           [[nodiscard]] stl::optional<T> parse(Context auto const& ctx) const noexcept {
-            using context_type     = decltype(ctx);
-            using traits_type      = typename context_type::traits_type;
-            using string_view_type = typename traits_type::string_view_type;
+            stl::string_view const str = *ctx.current_segment;
 
-            auto const str = *ctx.current_segment;
-
-            if constexpr (stl::is_integral_v<T>) {
-                return to<T>(str);
-            } else if constexpr (stl::is_constructible_v<T, long double>) {
-                return T(to<long double>(str));
+            if constexpr (stl::is_arithmetic_v<T>) {
+                if (T value; parse_number(str, value))
+                    return value;
+            } else {
+                if (long double value; parse_floating(str, value))
+                    return T(value);
             }
-
             return stl::nullopt;
         }
-    };
 
-    // todo: other types including:
-    // double, float, unsigned, short, ...
+        [[nodiscard]] auto parse_int(Context auto const& ctx) const noexcept {
+            return parse<int>(ctx);
+        }
+
+        [[nodiscard]] auto parse_uint(Context auto const& ctx) const noexcept {
+            return parse<unsigned int>(ctx);
+        }
+
+        [[nodiscard]] auto parse_int64(Context auto const& ctx) const noexcept {
+            return parse<stl::int64_t>(ctx);
+        }
+
+        [[nodiscard]] auto parse_uint64(Context auto const& ctx) const noexcept {
+            return parse<stl::uint64_t>(ctx);
+        }
+
+        [[nodiscard]] auto parse_float(Context auto const& ctx) const noexcept {
+            return parse<float>(ctx);
+        }
+
+        [[nodiscard]] auto parse_double(Context auto const& ctx) const noexcept {
+            return parse<double>(ctx);
+        }
+    };
 
 } // namespace webpp::routes
 
@@ -0,0 +1,95 @@
+#ifndef WEBPP_ROUTES_PATH_SEGMENTS_H
+#define WEBPP_ROUTES_PATH_SEGMENTS_H
+
+#include "../../std/std.hpp"
+#include "../../std/string_view.hpp"
+
+#include <array>
+#include <cstddef>
+
+namespace webpp::routes {
+
+    /**
+     * The segments of the path of a request, as views into the request's
+     * uri, in a fixed small vector; so it's parsed once per request and it's
+     * cheap to copy along with the context. It's split the same way that
+     * basic_uri::path_structured splits the path: "/a/b" is {"", "a", "b"}.
+     *
+     * The paths with more than "capacity" segments are truncated; the
+     * "overflowed" tells if that has happened.
+     */
+    struct path_segments {
+        static constexpr stl::size_t capacity = 16;
+
+        using value_type     = stl::string_view;
+        using iterator       = value_type const*;
+        using const_iterator = value_type const*;
+
+      private:
+        stl::array<value_type, capacity> items{};
+        stl::size_t                      count       = 0;
+        bool                             _overflowed = false;
+
+      public:
+        constexpr path_segments() noexcept = default;
+
+        /**
+         * Split the path of a request uri; the query and the fragment are not
+         * a part of the path
+         */
+        [[nodiscard]] static constexpr path_segments parse(stl::string_view uri) noexcept {
+            path_segments res;
+            if (uri.empty() || uri.front() == '?' || uri.front() == '#')
+                return res;
+            // one pass; the segments end at a slash, and the path ends at the query or the fragment
+            stl::size_t start = 0, i = 0;
+            for (; i < uri.size(); i++) {
+                auto const c = uri[i];
+                if (c == '/') {
+                    res.emplace_back(uri.data() + start, i - start);
+                    start = i + 1;
+                } else if (c == '?' || c == '#') {
+                    break;
+                }
+            }
+            res.emplace_back(uri.data() + start, i - start);
+            return res;
+        }
+
+        template <typename... Args>
+        constexpr void emplace_back(Args&&... args) noexcept {
+            if (count == capacity) {
+                _overflowed = true;
+                return;
+            }
+            items[count++] = value_type{stl::forward<Args>(args)...};
+        }
+
+        [[nodiscard]] constexpr iterator begin() const noexcept {
+            return items.data();
+        }
+
+        [[nodiscard]] constexpr iterator end() const noexcept {
+            return items.data() + count;
+        }
+
+        [[nodiscard]] constexpr value_type operator[](stl::size_t index) const noexcept {
+            return items[index];
+        }
+
+        [[nodiscard]] constexpr stl::size_t size() const noexcept {
+            return count;
+        }
+
+        [[nodiscard]] constexpr bool empty() const noexcept {
+            return count == 0;
+        }
+
+        [[nodiscard]] constexpr bool overflowed() const noexcept {
+            return _overflowed;
+        }
+    };
+
+} // namespace webpp::routes
+
+#endif // WEBPP_ROUTES_PATH_SEGMENTS_H
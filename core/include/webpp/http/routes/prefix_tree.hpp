@@ -0,0 +1,166 @@
+#ifndef WEBPP_ROUTES_PREFIX_TREE_H
+#define WEBPP_ROUTES_PREFIX_TREE_H
+
+#include "../../std/std.hpp"
+#include "../../std/string_view.hpp"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+namespace webpp::routes {
+
+    /**
+     * A fixed-size radix tree (a compressed trie) of the static path prefixes
+     * of the entry routes of a router. The router knows the number of its
+     * routes at compile time, so the nodes live in arrays and building it
+     * doesn't allocate; it can be built in a constant expression too.
+     *
+     * Every route is attached to the node of its prefix (the routes without
+     * a prefix are attached to the root), and a lookup walks the tree along
+     * a path and collects the routes of the nodes it goes through; those are
+     * the only routes that could possibly match the path. The prefixes are
+     * not copied, so they should outlive the tree (they're string literals
+     * most of the time).
+     */
+    template <stl::size_t RouteCount>
+    class prefix_tree {
+      public:
+        using index_type = stl::uint16_t;
+
+        static constexpr index_type  npos       = static_cast<index_type>(-1);
+        static constexpr stl::size_t word_bits  = 64;
+        static constexpr stl::size_t word_count = (RouteCount + word_bits - 1) / word_bits;
+
+        static_assert(RouteCount * 2 + 1 < npos, "Too many routes for a router.");
+
+        /**
+         * A set of the route indices; the bit N is the route N
+         */
+        using mask_type = stl::array<stl::uint64_t, word_count>;
+
+      private:
+        // each insertion adds one leaf and at most one split node
+        static constexpr stl::size_t max_nodes = RouteCount * 2 + 1;
+
+        struct node {
+            stl::string_view label{};
+            index_type       first_child  = npos;
+            index_type       next_sibling = npos;
+            mask_type        routes{};
+        };
+
+        stl::array<node, max_nodes> nodes{};
+        index_type                  node_count = 1; // the root
+
+        static constexpr stl::size_t common_length(stl::string_view a, stl::string_view b) noexcept {
+            stl::size_t i = 0;
+            while (i < a.size() && i < b.size() && a[i] == b[i])
+                i++;
+            return i;
+        }
+
+        constexpr index_type add_node(stl::string_view label) noexcept {
+            nodes[node_count].label = label;
+            return node_count++;
+        }
+
+      public:
+        constexpr prefix_tree() noexcept = default;
+
+        /**
+         * Attach the route to the node of the prefix; it creates the node if
+         * it's not there already, and splits the edge it falls in the middle of.
+         */
+        constexpr void insert(stl::string_view prefix, stl::size_t route) noexcept {
+            index_type current = 0;
+            while (!prefix.empty()) {
+                index_type* link  = &nodes[current].first_child;
+                index_type  child = *link;
+                while (child != npos && nodes[child].label.front() != prefix.front()) {
+                    link  = &nodes[child].next_sibling;
+                    child = *link;
+                }
+                if (child == npos) {
+                    // no edge starts with this character; the rest is a new leaf
+                    auto const leaf = add_node(prefix);
+                    *link           = leaf;
+                    current         = leaf;
+                    break;
+                }
+                auto const common = common_length(nodes[child].label, prefix);
+                if (common < nodes[child].label.size()) {
+                    // the prefix ends, or goes another way, in the middle of this
+                    // edge; put a node where they part and hang the old child under it
+                    auto const mid          = add_node(nodes[child].label.substr(0, common));
+                    nodes[mid].next_sibling = nodes[child].next_sibling;
+                    nodes[mid].first_child  = child;
+                    nodes[child].next_sibling = npos;
+                    nodes[child].label.remove_prefix(common);
+                    *link = mid;
+                    child = mid;
+                }
+                current = child;
+                prefix.remove_prefix(common);
+            }
+            nodes[current].routes[route / word_bits] |= stl::uint64_t{1} << (route % word_bits);
+        }
+
+        /**
+         * The routes whose prefixes are a prefix of the specified path
+         */
+        [[nodiscard]] constexpr mask_type candidates(stl::string_view path) const noexcept {
+            mask_type  res     = nodes[0].routes;
+            index_type current = nodes[0].first_child;
+            while (current != npos && !path.empty()) {
+                auto const& n = nodes[current];
+                if (n.label.front() != path.front()) {
+                    current = n.next_sibling;
+                    continue;
+                }
+                // the siblings start with different characters, so this is
+                // the only edge that can go on
+                if (!path.starts_with(n.label))
+                    break;
+                for (stl::size_t i = 0; i < word_count; i++)
+                    res[i] |= n.routes[i];
+                path.remove_prefix(n.label.size());
+                current = n.first_child;
+            }
+            return res;
+        }
+
+        /**
+         * The mask of all of the routes
+         */
+        [[nodiscard]] static constexpr mask_type all() noexcept {
+            mask_type res{};
+            for (stl::size_t i = 0; i < RouteCount; i++)
+                res[i / word_bits] |= stl::uint64_t{1} << (i % word_bits);
+            return res;
+        }
+
+        /**
+         * Call the callback with the index of each route in the mask, in order,
+         * until the callback returns true.
+         * @returns true if the callback has returned true
+         */
+        template <typename Callback>
+        static constexpr bool for_each(mask_type mask, Callback&& callback) noexcept {
+            for (stl::size_t i = 0; i < word_count; i++) {
+                for (auto word = mask[i]; word != 0; word &= word - 1) {
+                    if (callback(i * word_bits + static_cast<stl::size_t>(stl::countr_zero(word))))
+                        return true;
+                }
+            }
+            return false;
+        }
+
+        [[nodiscard]] constexpr stl::size_t size() const noexcept {
+            return node_count;
+        }
+    };
+
+} // namespace webpp::routes
+
+#endif // WEBPP_ROUTES_PREFIX_TREE_H
@@ -3,17 +3,78 @@
 #ifndef WEBPP_ROUTES_ROUTE_H
 #define WEBPP_ROUTES_ROUTE_H
 
+#include "../../std/optional.hpp"
+#include "../../std/string_view.hpp"
 #include "../../utils/functional.hpp"
+#include "../../utils/task.hpp"
+#include "../../utils/utf8.hpp"
 #include "./route_concepts.hpp"
 
+#include <cstddef>
 #include <type_traits>
 #include <utility>
 
-namespace webpp::routes {
+namespace webpp {
 
+    namespace details {
 
+        /**
+         * Call a route with what it wants; the context, the request, or nothing
+         */
+        template <typename R, typename ContextType>
+        constexpr auto call_route(R const& _route, ContextType& ctx) noexcept {
+            if constexpr (stl::is_invocable_v<R const&, ContextType&>) {
+                return _route(ctx);
+            } else if constexpr (stl::is_invocable_v<R const&, typename ContextType::request_type const&>) {
+                return _route(*ctx.request);
+            } else {
+                static_assert(stl::is_invocable_v<R const&>,
+                              "The route should be callable with a context, a request, or nothing.");
+                return _route();
+            }
+        }
 
+        /**
+         * Call the route only if it matches; what it returns says if it has
+         * matched: an empty optional (or false, or nothing) means it didn't.
+         * A coroutine route gives a task of that, so it's not awaited here.
+         */
+        template <typename Call>
+        constexpr auto call_if(bool matches, Call const& call) noexcept {
+            using result_type = decltype(call());
+            if constexpr (stl::is_void_v<result_type>) {
+                if (matches)
+                    call();
+            } else if constexpr (stl::same_as<result_type, bool>) {
+                return matches && call();
+            } else if constexpr (is_specialization_of<result_type, stl::optional>::value) {
+                return matches ? call() : result_type{};
+            } else if constexpr (Task<result_type>) {
+                using value_type = typename result_type::value_type;
+                using out_type   = stl::conditional_t<
+                  stl::is_void_v<value_type> || stl::same_as<value_type, bool> ||
+                    is_specialization_of<value_type, stl::optional>::value,
+                  value_type, stl::optional<value_type>>;
+                if (!matches) {
+                    if constexpr (stl::same_as<out_type, bool>) {
+                        return task<out_type>::ready(false);
+                    } else {
+                        return task<out_type>::ready();
+                    }
+                }
+                return [](result_type t) -> task<out_type> {
+                    co_return co_await stl::move(t);
+                }(call());
+            } else {
+                return matches ? stl::optional<result_type>{call()} : stl::nullopt;
+            }
+        }
+
+    } // namespace details
+
+} // namespace webpp
 
+namespace webpp::routes {
 
     /**
      * Check if we can convert T to U
@@ -31,299 +92,573 @@ namespace webpp::routes {
     template <typename T, typename U>
     constexpr bool can_convert_v = can_convert<T, U>::value;
 
+    enum class logical_operators { none, AND, OR, XOR };
+
     /**
-     * Check if we can convert T to a string
-     * @tparam Traits
-     * @tparam U
+     * The routes that can be combined with the logical operators derive from
+     * this; the other side of the operator can be any callable.
      */
-    template <typename Traits, typename U>
-    struct can_convert_to_string
-      : stl::integral_constant<
-          bool, (can_convert_v<Traits, U, typename Traits::string_type> ||
-                 can_convert_v<Traits, U, typename Traits::string_view_type>)> {
+    struct combinable {};
+
+    template <typename T>
+    concept Combinable = stl::derived_from<stl::remove_cvref_t<T>, combinable>;
+
+    /**
+     * The conditions that their result is known without looking at the
+     * request; they're folded away when they're combined with other routes.
+     */
+    template <bool Value>
+    struct constant_condition : combinable {
+        static constexpr bool constant_value = Value;
+
+        template <typename... Args>
+        constexpr bool operator()(Args&&...) const noexcept {
+            return Value;
+        }
     };
 
-    template <typename Traits, typename U>
-    constexpr bool can_convert_to_string_v =
-      can_convert_to_string<Traits, U>::value;
+    inline constexpr constant_condition<true>  always{};
+    inline constexpr constant_condition<false> never{};
 
+    template <typename T>
+    concept ConstantCondition = requires {
+        { stl::remove_cvref_t<T>::constant_value } -> stl::convertible_to<bool>;
+    };
 
+    /**
+     * The conditions that only look at the request, don't have side effects,
+     * and their type says everything about them (the method and the path
+     * literal conditions); so they can be merged together at compile time.
+     */
+    template <typename T>
+    concept StaticCondition = ConstantCondition<T> || requires {
+        requires stl::remove_cvref_t<T>::is_static_condition;
+    };
 
+    /**
+     * What the fuse_and/fuse_or/fuse_xor hooks return when the two conditions
+     * can't be merged into one. The conditions add their own overloads of the
+     * hooks (they're found by ADL), like method_set and path_prefix do.
+     */
+    struct no_fusion {};
 
+    template <typename L, typename R>
+    constexpr no_fusion fuse_and(L const&, R const&) noexcept {
+        return {};
+    }
 
-    template <typename HandleExceptionCallable, typename Callable,
-              typename... Args>
-    constexpr auto
-    run_and_catch(HandleExceptionCallable const& handle_exception,
-                  Callable const&                c, Args... args) noexcept {
-        using RetType = stl::invoke_result_t<Callable, Args...>;
-        if constexpr (stl::is_nothrow_invocable_r_v<RetType, Callable,
-                                                    Args...>) {
-            // It's noexcept, we call it knowing that.
-            return callable(stl::forward<Args>(args)...);
-        } else if constexpr (stl::is_invocable_r_v<RetType, Callable,
-                                                   Args...>) {
-            try {
-                return callable(stl::forward<Args>(args)...);
-            } catch (...) {
-                handle_exception(stl::current_exception());
-                return false; // todo: check this
-            }
-        } else {
-            throw stl::invalid_argument(
-              "The specified route is not valid. We're not able to call it.");
-        }
+    template <typename L, typename R>
+    constexpr no_fusion fuse_or(L const&, R const&) noexcept {
+        return {};
+    }
+
+    template <typename L, typename R>
+    constexpr no_fusion fuse_xor(L const&, R const&) noexcept {
+        return {};
     }
 
     /**
-     * Handle the return type of a route::operator()
-     * @tparam RetType
-     * @param ret
-     * @return
+     * The path literal of the path conditions, as a template parameter
      */
-    template <typename RetType>
-    constexpr auto handle_callable_return_type(RetType&& ret) noexcept {
-        if constexpr (stl::is_void_v<RetType>) {
-            // it's an "Unknown route"
-            return;
-        } else if constexpr (Response<RetType>) {
-            // It was a "Response route"
-        } else if constexpr (Context<RetType>) {
-            // It's a "Context Switching route"
-
-        } else if constexpr (stl::is_same_v<RetType, bool>) {
-            // It's a "Conditional route"
-            return ret;
+    template <stl::size_t N>
+    struct path_literal {
+        char chars[N]{};
+
+        constexpr path_literal(char const (&str)[N]) noexcept {
+            for (stl::size_t i = 0; i < N; i++)
+                chars[i] = str[i];
         }
-    }
 
-    template <typename C, Context ContextType>
-    bool call_route(C& c, ContextType& context) noexcept {
-        using req_t     = typename ContextType::request_type const&;
-        using res_t     = typename ContextType::response_type&;
-        using callable  = stl::decay_t<C>;
-        using context_t = ContextType&;
-        auto callback   = stl::forward<C>(c);
-
-        constexpr auto handle_exception = [](auto err) {
-
-        };
-
-
-        // TODO: add more overrides. You can simulate "dependency injection" here
-
-        if constexpr (stl::is_invocable_v<callable, req_t>) {
-            return handle_callback_return_type(
-              run_and_catch(handle_exception, callback, context.request));
-        } else if constexpr (stl::is_invocable_v<callable, res_t>) {
-            return handle_callback_return_type(
-              run_and_catch(handle_exception, callback, context.response));
-        } else if constexpr (stl::is_invocable_v<callable, req_t, res_t>) {
-            return handle_callback_return_type(run_and_catch(
-              handle_exception, callback, context.request, context.response));
-        } else if constexpr (stl::is_invocable_v<callable, res_t, req_t>) {
-            return handle_callback_return_type(run_and_catch(
-              handle_exception, callback, context.response, context.request));
-        } else if constexpr (stl::is_invocable_v<callable, context_t>) {
-            return handle_callback_return_type(
-              run_and_catch(handle_exception, callback, context));
-        } else if constexpr (stl::is_invocable_v<callable>) {
-            return handle_callback_return_type(
-              run_and_catch(handle_exception, callback));
-        } else {
-            throw stl::invalid_argument(
-              "The specified route cannot be called.");
+        [[nodiscard]] constexpr stl::string_view view() const noexcept {
+            return {chars, N - 1};
         }
-    }
+    };
 
+    namespace details {
 
-    enum class logical_operators { none, AND, OR, XOR };
+        template <typename ContextType>
+        constexpr stl::string_view request_path_of(ContextType const& ctx) noexcept {
+            stl::string_view const uri = ctx.request->request_uri();
+            return uri.substr(0, uri.find_first_of("?#"));
+        }
 
-    template <typename RouteType, logical_operators Op, typename NextRoute>
-    struct basic_route : public make_inheritable<RouteType> {
-        using next_valve_type =
-          stl::remove_reference_t<stl::remove_cv_t<NextRoute>>;
+    } // namespace details
 
-        constexpr static logical_operators op = Op;
-        next_valve_type                    next;
+    /**
+     * The path starts with the prefix; the router puts these in its prefix tree
+     */
+    template <path_literal Prefix>
+    struct path_prefix : combinable {
+        static constexpr bool is_static_condition = true;
 
-        constexpr basic_route(RouteType&&       super,
-                              next_valve_type&& _next) noexcept
-          : RouteType(stl::move(super)),
-            next(stl::move(_next)) {
+        static_assert(Prefix.view().find_first_of("?#") == stl::string_view::npos,
+                      "A path prefix can't have a query or a fragment.");
+
+        [[nodiscard]] static constexpr stl::string_view static_path_prefix() noexcept {
+            return Prefix.view();
         }
 
-        constexpr basic_route(RouteType const&       super,
-                              const next_valve_type& _next) noexcept
-          : RouteType(super),
-            next(_next) {
+        template <typename ContextType>
+        constexpr bool operator()(ContextType const& ctx) const noexcept {
+            return details::request_path_of(ctx).starts_with(Prefix.view());
         }
+    };
+
+    /**
+     * The path is exactly the specified path
+     */
+    template <path_literal Path>
+    struct path_is : combinable {
+        static constexpr bool is_static_condition = true;
+
+        static_assert(Path.view().find_first_of("?#") == stl::string_view::npos,
+                      "A path can't have a query or a fragment.");
 
-        constexpr basic_route(RouteType const&  super,
-                              next_valve_type&& _next) noexcept
-          : RouteType(super),
-            next(stl::move(_next)) {
+        [[nodiscard]] static constexpr stl::string_view static_path_prefix() noexcept {
+            return Path.view();
         }
 
-        constexpr basic_route(RouteType&&            super,
-                              next_valve_type const& _next) noexcept
-          : RouteType(stl::move(super)),
-            next(_next) {
+        template <typename ContextType>
+        constexpr bool operator()(ContextType const& ctx) const noexcept {
+            return details::request_path_of(ctx) == Path.view();
         }
+    };
 
-        constexpr basic_route(basic_route const& v) noexcept = default;
-        constexpr basic_route(basic_route&& v) noexcept      = default;
+    namespace details {
 
-        constexpr basic_route&
-                               operator=(basic_route const& v) noexcept = default;
-        constexpr basic_route& operator=(basic_route&&) noexcept = default;
-    };
+        /**
+         * The URI is UTF-8 after its percent escapes are decoded; it's decoded
+         * in pieces, so nothing is allocated.
+         */
+        [[nodiscard]] constexpr bool is_utf8_uri(stl::string_view uri) noexcept {
+            if (uri.find('%') == stl::string_view::npos)
+                return utf8_validator::validate(uri);
+
+            auto const hex_value = [](char c) constexpr noexcept -> int {
+                return c >= '0' && c <= '9'   ? c - '0'
+                       : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                       : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                              : -1;
+            };
+            char        buf[256]{};
+            stl::size_t size = 0;
+            for (stl::size_t pos = 0; pos < uri.size(); pos++) {
+                char c = uri[pos];
+                if (c == '%' && pos + 2 < uri.size()) {
+                    // the broken escapes are left as they are
+                    if (auto const high = hex_value(uri[pos + 1]), low = hex_value(uri[pos + 2]);
+                        high >= 0 && low >= 0) {
+                        c = static_cast<char>((high << 4) | low);
+                        pos += 2;
+                    }
+                }
+                buf[size++] = c;
+                if (size == sizeof(buf)) {
+                    // the char that's cut goes to the next piece
+                    auto const complete = utf8_validator::complete_size({buf, size});
+                    if (!utf8_validator::validate({buf, complete}))
+                        return false;
+                    for (stl::size_t i = complete; i < size; i++)
+                        buf[i - complete] = buf[i];
+                    size -= complete;
+                }
+            }
+            return utf8_validator::validate({buf, size});
+        }
+
+    } // namespace details
 
-    template <Route RouteType>
-    struct basic_route<RouteType, logical_operators::none, void>
-      : public make_inheritable<RouteType> {
-        using RouteType::RouteType;
+    /**
+     * The path and the query of the request are UTF-8, after their percent
+     * escapes are decoded; for the routes that give them to the JSON or to
+     * the templates:
+     *   valid_utf8 && prefix<"/search"> && search_page
+     */
+    struct valid_utf8_condition : combinable {
+        template <typename ContextType>
+        constexpr bool operator()(ContextType const& ctx) const noexcept {
+            stl::string_view const uri = ctx.request->request_uri();
+            return details::is_utf8_uri(uri.substr(0, uri.find('#')));
+        }
     };
 
+    inline constexpr valid_utf8_condition valid_utf8{};
 
+    template <path_literal Prefix>
+    inline constexpr path_prefix<Prefix> prefix{};
 
-    template <Route RouteType, logical_operators Op = logical_operators::none,
-              NextRoute NextRouteType = void>
-    struct route : public basic_route<RouteType, Op, NextRouteType> {
+    template <path_literal Path>
+    inline constexpr path_is<Path> exact{};
 
-        using route_type                      = RouteType;
-        using next_route_type                 = NextRouteType;
-        static constexpr logical_operators op = Op;
+    // both have to match, so the longer one is enough, or they can't both match
+    template <path_literal A, path_literal B>
+    constexpr auto fuse_and(path_prefix<A> const&, path_prefix<B> const&) noexcept {
+        if constexpr (A.view().starts_with(B.view())) {
+            return path_prefix<A>{};
+        } else if constexpr (B.view().starts_with(A.view())) {
+            return path_prefix<B>{};
+        } else {
+            return never;
+        }
+    }
 
-      private:
-        using super_t = basic_route<RouteType, Op, NextRouteType>;
+    template <path_literal A, path_literal B>
+    constexpr auto fuse_and(path_is<A> const&, path_prefix<B> const&) noexcept {
+        if constexpr (A.view().starts_with(B.view())) {
+            return path_is<A>{};
+        } else {
+            return never;
+        }
+    }
 
-      public:
-        using super_t::operator();
+    template <path_literal A, path_literal B>
+    constexpr auto fuse_and(path_prefix<A> const& a, path_is<B> const& b) noexcept {
+        return fuse_and(b, a);
+    }
 
-        constexpr route() noexcept : super_t{} {
+    template <path_literal A, path_literal B>
+    constexpr auto fuse_and(path_is<A> const&, path_is<B> const&) noexcept {
+        if constexpr (A.view() == B.view()) {
+            return path_is<A>{};
+        } else {
+            return never;
         }
+    }
 
-        template <typename... Args>
-        requires(stl::is_constructible_v<super_t, Args...>) constexpr route(
-          Args&&... args) noexcept
-          : super_t{stl::forward<Args>(args)...} {
+    template <path_literal A, path_literal B>
+    constexpr auto fuse_or(path_prefix<A> const&, path_prefix<B> const&) noexcept {
+        if constexpr (A.view().starts_with(B.view())) {
+            return path_prefix<B>{};
+        } else if constexpr (B.view().starts_with(A.view())) {
+            return path_prefix<A>{};
+        } else {
+            return no_fusion{};
         }
+    }
 
-        constexpr route(route const&) noexcept = default;
+    template <path_literal A, path_literal B>
+    constexpr auto fuse_or(path_is<A> const&, path_prefix<B> const&) noexcept {
+        if constexpr (A.view().starts_with(B.view())) {
+            return path_prefix<B>{};
+        } else {
+            return no_fusion{};
+        }
+    }
 
-        constexpr route(route&&) noexcept = default;
+    template <path_literal A, path_literal B>
+    constexpr auto fuse_or(path_prefix<A> const& a, path_is<B> const& b) noexcept {
+        return fuse_or(b, a);
+    }
 
-        using super_t::operator=;
+    /**
+     * Any callable, as a route that can be combined with the others
+     */
+    template <typename Callable>
+    struct route : combinable {
+        using callable_type = Callable;
 
-        /**
-         * Run the migration
-         * @return the response or the context or ...
-         */
-        template <typename... Args>
-        auto operator()(Args&&... args) noexcept {
-            return super_t::operator()(stl::forward<Args>(args)...);
+        callable_type callable;
+
+        constexpr route(callable_type _callable) noexcept : callable{stl::move(_callable)} {}
+
+        [[nodiscard]] static constexpr auto static_method() noexcept
+          requires requires { callable_type::static_method(); } {
+            return callable_type::static_method();
         }
 
+        [[nodiscard]] constexpr stl::string_view static_path_prefix() const noexcept
+          requires PrefixedRoute<callable_type> {
+            return callable.static_path_prefix();
+        }
+
+        template <typename ContextType>
+        constexpr auto operator()(ContextType& ctx) const noexcept {
+            return webpp::details::call_route(callable, ctx);
+        }
+    };
+
+    template <typename Callable>
+    route(Callable) -> route<Callable>;
+
+    /**
+     * Two routes combined with a logical operator; the left one is a condition
+     * (it returns a bool). The conditions are evaluated with short-circuits,
+     * so the right side isn't called if the left side has decided already:
+     *   - AND: the right side is called only if the left side is true; if the
+     *          right side responds, the response is the result
+     *   - OR:  the right side is called only if the left side is false
+     *   - XOR: both sides are called
+     *   - none (>>): both sides are called, and the result is of the right side
+     *
+     * They're built by the operators of the routes, which fold and fuse the
+     * static conditions at compile time, so "method<get> && prefix<"/a"> &&
+     * prefix<"/a/b">" is one bit test and one compare.
+     */
+    template <logical_operators Op, typename Left, typename Right>
+    struct logical_route : combinable {
+        static constexpr logical_operators op = Op;
+
+        using left_type  = Left;
+        using right_type = Right;
+
+        left_type  left;
+        right_type right;
+
+        constexpr logical_route(left_type _left, right_type _right) noexcept
+          : left{stl::move(_left)},
+            right{stl::move(_right)} {}
 
         /**
-         * @tparam NewValveType
-         * @param valve
+         * Both sides of an AND have to match, so the method of any of them is
+         * the method of the whole route
          */
-        template <logical_operators TheOp, typename NewRouteType>
-        [[nodiscard]] constexpr auto
-        set_next(NewRouteType&& new_route) const noexcept {
-            if constexpr (stl::is_void_v<next_route_type>) {
-                // this part will only execute when the "next_valve_type" is
-                // void
-
-                // the first way (A<X, void> and B<Y, void> === A<X, B<Y, void>>
-                return route<route_type, TheOp, NewRouteType>(
-                  *this, stl::forward<NewRouteType>(new_route));
+        [[nodiscard]] static constexpr auto static_method() noexcept
+          requires(Op == logical_operators::AND &&
+                   (requires { left_type::static_method(); } || requires { right_type::static_method(); })) {
+            if constexpr (requires { left_type::static_method(); }) {
+                return left_type::static_method();
             } else {
-                // this means this function has a "next" valve already,
-                // so it goes to the next's next valve
-                // this way we recursively create a valve type and return it.
-                auto n =
-                  basic_route<route_type, TheOp, NewRouteType>::next.set_next(
-                    stl::forward<NewRouteType>(new_route));
-                return route<route_type, op, decltype(n)>{*this, n};
+                return right_type::static_method();
             }
         }
 
-        [[nodiscard]] constexpr auto
-        operator&&(NextRoute auto&& new_route) const noexcept {
-            return set_next<logical_operators::AND>(
-              stl::forward<decltype(new_route)>(new_route));
+        /**
+         * For AND, the longer prefix of the two sides (both have to match); for
+         * OR, what their prefixes have in common.
+         */
+        [[nodiscard]] constexpr stl::string_view static_path_prefix() const noexcept
+          requires((Op == logical_operators::AND && (PrefixedRoute<left_type> || PrefixedRoute<right_type>)) ||
+                   (Op == logical_operators::OR && PrefixedRoute<left_type> && PrefixedRoute<right_type>)) {
+            if constexpr (Op == logical_operators::OR) {
+                stl::string_view const a = left.static_path_prefix(), b = right.static_path_prefix();
+                stl::size_t            i = 0;
+                while (i < a.size() && i < b.size() && a[i] == b[i])
+                    i++;
+                return a.substr(0, i);
+            } else if constexpr (PrefixedRoute<left_type> && PrefixedRoute<right_type>) {
+                stl::string_view const a = left.static_path_prefix(), b = right.static_path_prefix();
+                return a.size() >= b.size() ? a : b;
+            } else if constexpr (PrefixedRoute<left_type>) {
+                return left.static_path_prefix();
+            } else {
+                return right.static_path_prefix();
+            }
         }
 
-        [[nodiscard]] constexpr auto
-        operator&(NextRoute auto&& new_route) const noexcept {
-            return set_next<logical_operators::AND>(
-              stl::forward<decltype(new_route)>(new_route));
+        template <typename ContextType>
+        constexpr auto operator()(ContextType& ctx) const noexcept {
+            using left_result  = decltype(webpp::details::call_route(left, ctx));
+            using right_result = decltype(webpp::details::call_route(right, ctx));
+            auto const call_left = [&]() noexcept {
+                return webpp::details::call_route(left, ctx);
+            };
+            auto const call_right = [&]() noexcept {
+                return webpp::details::call_route(right, ctx);
+            };
+
+            if constexpr (Op == logical_operators::none) {
+                call_left();
+                return call_right();
+            } else {
+                static_assert(stl::same_as<left_result, bool>,
+                              "The left side of a logical operator of the routes should be a condition.");
+                if constexpr (Op == logical_operators::AND) {
+                    return webpp::details::call_if(call_left(), call_right);
+                } else {
+                    static_assert(stl::same_as<right_result, bool>,
+                                  "Only the conditions can be combined with OR and XOR.");
+                    if constexpr (Op == logical_operators::OR) {
+                        return call_left() || call_right();
+                    } else {
+                        return call_left() != call_right();
+                    }
+                }
+            }
         }
+    };
 
-        [[nodiscard]] constexpr auto
-        operator||(NextRoute auto&& new_route) const noexcept {
-            return set_next<logical_operators::OR>(
-              stl::forward<decltype(new_route)>(new_route));
-        }
+    namespace details {
 
-        [[nodiscard]] constexpr auto
-        operator|(NextRoute auto&& new_route) const noexcept {
-            return set_next<logical_operators::OR>(
-              stl::forward<decltype(new_route)>(new_route));
+        template <typename T>
+        constexpr auto as_route(T&& value) noexcept {
+            if constexpr (Combinable<T>) {
+                return stl::remove_cvref_t<T>{stl::forward<T>(value)};
+            } else {
+                return route<stl::remove_cvref_t<T>>{stl::forward<T>(value)};
+            }
         }
 
-        [[nodiscard]] constexpr auto
-        operator^(NextRoute auto&& new_route) const noexcept {
-            return set_next<logical_operators::XOR>(
-              stl::forward<decltype(new_route)>(new_route));
-        }
+        template <typename T>
+        struct is_and_route : stl::false_type {};
+
+        template <typename L, typename R>
+        struct is_and_route<logical_route<logical_operators::AND, L, R>> : stl::true_type {};
+
+        template <typename T>
+        struct is_or_route : stl::false_type {};
+
+        template <typename L, typename R>
+        struct is_or_route<logical_route<logical_operators::OR, L, R>> : stl::true_type {};
 
-        [[nodiscard]] constexpr auto
-        operator>>(NextRoute auto&& new_route) const noexcept {
-            return set_next<logical_operators::none>(
-              stl::forward<decltype(new_route)>(new_route));
+        /**
+         * Merge two routes that are next to each other in an AND chain, if they can be
+         */
+        template <typename L, typename R>
+        constexpr auto fuse_and_pair(L const& l, R const& r) noexcept {
+            if constexpr (ConstantCondition<L>) {
+                if constexpr (L::constant_value) {
+                    return r; // true && r is r
+                } else {
+                    return never; // r is not even called
+                }
+            } else if constexpr (StaticCondition<L> && ConstantCondition<R>) {
+                // the static conditions don't have side effects, so they're not needed
+                if constexpr (R::constant_value) {
+                    return l;
+                } else {
+                    return never;
+                }
+            } else if constexpr (StaticCondition<L> && StaticCondition<R>) {
+                return fuse_and(l, r);
+            } else {
+                return no_fusion{};
+            }
         }
 
-        [[nodiscard]] bool call_this_route(Context auto&& ctx) const noexcept {
-            // todo handle the return types
-            return super_t::operator()(stl::forward<decltype(ctx)>(ctx));
+        template <typename L, typename R>
+        constexpr auto fuse_or_pair(L const& l, R const& r) noexcept {
+            if constexpr (ConstantCondition<L>) {
+                if constexpr (L::constant_value) {
+                    return always; // r is not even called
+                } else {
+                    return r;
+                }
+            } else if constexpr (StaticCondition<L> && ConstantCondition<R>) {
+                if constexpr (R::constant_value) {
+                    return always;
+                } else {
+                    return l;
+                }
+            } else if constexpr (StaticCondition<L> && StaticCondition<R>) {
+                return fuse_or(l, r);
+            } else {
+                return no_fusion{};
+            }
         }
 
-        [[nodiscard]] bool call_next_route(Context auto&& ctx) const noexcept {
-            // todo handle the return types
-            if constexpr (stl::is_void_v<next_route_type>) {
-                return true; // it's the last route in this sub route, doesn't
-                             // matter what I return here; at least not yet
+        /**
+         * The chains are kept nested to the right, "a && (b && (c && d))", so
+         * the conditions that are written next to each other end up next to
+         * each other, and each one is merged with the next one if it can be.
+         */
+        template <logical_operators Op, typename L, typename R>
+        constexpr auto make_chain(L const& l, R const& r) noexcept {
+            constexpr bool is_and = Op == logical_operators::AND;
+            using chain_trait = stl::conditional_t<is_and, is_and_route<L>, is_or_route<L>>;
+            using next_trait  = stl::conditional_t<is_and, is_and_route<R>, is_or_route<R>>;
+
+            auto const fuse = [](auto const& a, auto const& b) constexpr noexcept {
+                if constexpr (is_and) {
+                    return fuse_and_pair(a, b);
+                } else {
+                    return fuse_or_pair(a, b);
+                }
+            };
+
+            if constexpr (chain_trait::value) {
+                // (a && b) && r becomes a && (b && r)
+                return make_chain<Op>(l.left, make_chain<Op>(l.right, r));
+            } else if constexpr (next_trait::value) {
+                using next_left = stl::remove_cvref_t<decltype(r.left)>;
+                using next_right = stl::remove_cvref_t<decltype(r.right)>;
+                if constexpr (!stl::same_as<decltype(fuse(l, r.left)), no_fusion>) {
+                    // l && (a && b) becomes (l + a) && b
+                    return make_chain<Op>(fuse(l, r.left), r.right);
+                } else if constexpr (StaticCondition<L> && StaticCondition<next_left>) {
+                    // the static conditions don't have side effects, so their order
+                    // doesn't matter; l can go past "a" and merge with one after it
+                    auto rest = make_chain<Op>(l, r.right);
+                    if constexpr (stl::same_as<decltype(rest), logical_route<Op, L, next_right>>) {
+                        return logical_route<Op, L, R>{l, r}; // nothing to merge with
+                    } else {
+                        return make_chain<Op>(r.left, rest);
+                    }
+                } else {
+                    return logical_route<Op, L, R>{l, r};
+                }
+            } else if constexpr (!stl::same_as<decltype(fuse(l, r)), no_fusion>) {
+                return fuse(l, r);
             } else {
-                return super_t::next::operator()(
-                  stl::forward<decltype(ctx)>(ctx));
+                return logical_route<Op, L, R>{l, r};
             }
         }
 
-        [[nodiscard]] bool operator()(Context auto&& ctx) const noexcept {
-            // handling sub-route calls:
-            using context_type = decltype(ctx);
-            if constexpr (logical_operators::none == op) {
-                call_this_route(stl::forward<context_type>(ctx));
-                return call_next_route(stl::forward<context_type>(ctx));
-            } else if constexpr (logical_operators::AND == op) {
-                return call_this_route(stl::forward<context_type>(ctx)) &&
-                       call_next_route(stl::forward<context_type>(ctx));
-            } else if constexpr (logical_operators::OR == op) {
-                return call_this_route(stl::forward<context_type>(ctx)) ||
-                       call_next_route(stl::forward<context_type>(ctx));
-            } else if constexpr (logical_operators::XOR == op) {
-                return call_this_route(stl::forward<context_type>(ctx)) ^
-                       call_next_route(stl::forward<context_type>(ctx));
+        template <typename L, typename R>
+        constexpr auto make_xor(L const& l, R const& r) noexcept {
+            if constexpr (ConstantCondition<L> && ConstantCondition<R>) {
+                return constant_condition<(L::constant_value != R::constant_value)>{};
+            } else if constexpr (StaticCondition<L> && StaticCondition<R> &&
+                                 !stl::same_as<decltype(fuse_xor(l, r)), no_fusion>) {
+                return fuse_xor(l, r);
+            } else if constexpr (StaticCondition<L> && ConstantCondition<R>) {
+                if constexpr (!R::constant_value) {
+                    return l; // l ^ false is l
+                } else {
+                    return logical_route<logical_operators::XOR, L, R>{l, r};
+                }
             } else {
-                // should not happen ever.
-                return true;
+                return logical_route<logical_operators::XOR, L, R>{l, r};
             }
         }
-    };
+
+        template <typename L, typename R>
+        concept route_operands =
+          (Combinable<L> || Combinable<R>) && stl::is_class_v<stl::remove_cvref_t<L>> &&
+          stl::is_class_v<stl::remove_cvref_t<R>>;
+
+    } // namespace details
+
+    template <typename L, typename R>
+    requires details::route_operands<L, R>
+    [[nodiscard]] constexpr auto operator&&(L&& l, R&& r) noexcept {
+        return details::make_chain<logical_operators::AND>(details::as_route(stl::forward<L>(l)),
+                                                           details::as_route(stl::forward<R>(r)));
+    }
+
+    template <typename L, typename R>
+    requires details::route_operands<L, R>
+    [[nodiscard]] constexpr auto operator&(L&& l, R&& r) noexcept {
+        return stl::forward<L>(l) && stl::forward<R>(r);
+    }
+
+    template <typename L, typename R>
+    requires details::route_operands<L, R>
+    [[nodiscard]] constexpr auto operator||(L&& l, R&& r) noexcept {
+        return details::make_chain<logical_operators::OR>(details::as_route(stl::forward<L>(l)),
+                                                          details::as_route(stl::forward<R>(r)));
+    }
+
+    template <typename L, typename R>
+    requires details::route_operands<L, R>
+    [[nodiscard]] constexpr auto operator|(L&& l, R&& r) noexcept {
+        return stl::forward<L>(l) || stl::forward<R>(r);
+    }
+
+    template <typename L, typename R>
+    requires details::route_operands<L, R>
+    [[nodiscard]] constexpr auto operator^(L&& l, R&& r) noexcept {
+        return details::make_xor(details::as_route(stl::forward<L>(l)), details::as_route(stl::forward<R>(r)));
+    }
+
+    template <typename L, typename R>
+    requires details::route_operands<L, R>
+    [[nodiscard]] constexpr auto operator>>(L&& l, R&& r) noexcept {
+        auto left  = details::as_route(stl::forward<L>(l));
+        auto right = details::as_route(stl::forward<R>(r));
+        return logical_route<logical_operators::none, decltype(left), decltype(right)>{stl::move(left),
+                                                                                      stl::move(right)};
+    }
+
 } // namespace webpp::routes
 
 #endif // WEBPP_ROUTES_ROUTE_H
@@ -3,6 +3,7 @@
 #ifndef WEBPP_ROUTE_CONCEPTS_H
 #define WEBPP_ROUTE_CONCEPTS_H
 
+#include "../../std/string_view.hpp"
 #include "../response_concepts.hpp"
 #include "./context_concepts.hpp"
 
@@ -25,6 +26,16 @@ namespace webpp {
     template <typename T>
     concept NextRoute = Route<T> || stl::same_as<T, void>;
 
+    /**
+     * The routes that can only match the paths that start with a constant
+     * string can say so; the router doesn't even call them for other paths.
+     * The returned string should outlive the route (a literal, most likely).
+     */
+    template <typename T>
+    concept PrefixedRoute = requires(T const r) {
+        { r.static_path_prefix() } -> stl::convertible_to<stl::string_view>;
+    };
+
 } // namespace webpp
 
 #endif // WEBPP_ROUTE_CONCEPTS_H
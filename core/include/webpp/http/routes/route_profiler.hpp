@@ -0,0 +1,137 @@
+#ifndef WEBPP_ROUTES_ROUTE_PROFILER_H
+#define WEBPP_ROUTES_ROUTE_PROFILER_H
+
+#include "../../std/format.hpp"
+#include "../../std/std.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace webpp {
+
+    /**
+     * The numbers of one entry route
+     */
+    struct route_profile {
+        stl::size_t   index       = 0;
+        stl::uint64_t evaluations = 0; // the times that it's called
+        stl::uint64_t matches     = 0; // the times that it has responded
+        stl::uint64_t missed_ns   = 0; // the time of the calls that didn't respond; the wasted cycles
+        stl::uint64_t matched_ns  = 0; // the time of the ones that did, their handlers included
+    };
+
+    /**
+     * Count how many times each entry route of a router is evaluated and how many times it matches,
+     * and the time that goes into them; a router that has a profiler (see router::profile, or
+     * router_stats::profiler) records every route that it calls. It's for finding the routes whose
+     * conditions waste the most time (reorder them, or give them a static prefix or a method so the
+     * router skips them); it costs two clock reads for each route, so it's off by default.
+     *
+     * The counters are shared by the threads (relaxed atomics); the coroutine routes are not profiled.
+     */
+    class route_profiler {
+        struct counters {
+            stl::atomic<stl::uint64_t> evaluations{0};
+            stl::atomic<stl::uint64_t> matches{0};
+            stl::atomic<stl::uint64_t> missed_ns{0};
+            stl::atomic<stl::uint64_t> matched_ns{0};
+        };
+
+        stl::size_t                 count;
+        stl::unique_ptr<counters[]> routes;
+
+      public:
+        explicit route_profiler(stl::size_t route_count)
+          : count{route_count},
+            routes{new counters[route_count]} {}
+
+        void record(stl::size_t index, bool matched, stl::chrono::steady_clock::duration took) noexcept {
+            if (index >= count)
+                return;
+            auto const ns = static_cast<stl::uint64_t>(
+              stl::max<stl::int64_t>(stl::chrono::duration_cast<stl::chrono::nanoseconds>(took).count(), 0));
+            auto& route = routes[index];
+            route.evaluations.fetch_add(1, stl::memory_order_relaxed);
+            if (matched) {
+                route.matches.fetch_add(1, stl::memory_order_relaxed);
+                route.matched_ns.fetch_add(ns, stl::memory_order_relaxed);
+            } else {
+                route.missed_ns.fetch_add(ns, stl::memory_order_relaxed);
+            }
+        }
+
+        [[nodiscard]] route_profile profile(stl::size_t index) const noexcept {
+            if (index >= count)
+                return {.index = index};
+            auto const& route = routes[index];
+            return {.index       = index,
+                    .evaluations = route.evaluations.load(stl::memory_order_relaxed),
+                    .matches     = route.matches.load(stl::memory_order_relaxed),
+                    .missed_ns   = route.missed_ns.load(stl::memory_order_relaxed),
+                    .matched_ns  = route.matched_ns.load(stl::memory_order_relaxed)};
+        }
+
+        /**
+         * The routes, the ones that waste the most time first
+         */
+        [[nodiscard]] stl::vector<route_profile> snapshot() const {
+            stl::vector<route_profile> res;
+            res.reserve(count);
+            for (stl::size_t i = 0; i < count; i++)
+                res.push_back(profile(i));
+            stl::stable_sort(res.begin(), res.end(), [](route_profile const& a, route_profile const& b) {
+                return a.missed_ns > b.missed_ns;
+            });
+            return res;
+        }
+
+        /**
+         * Write a table of the routes (see snapshot)
+         */
+        void write(stl::string& out) const {
+            auto it = stl::back_inserter(out);
+            stl::format_to(it,
+                           "{:>5} {:>12} {:>12} {:>14} {:>14} {:>10}\n",
+                           "route",
+                           "evaluations",
+                           "matches",
+                           "missed ns",
+                           "matched ns",
+                           "ns/miss");
+            for (auto const& route : snapshot()) {
+                auto const misses = route.evaluations - route.matches;
+                stl::format_to(it,
+                               "{:>5} {:>12} {:>12} {:>14} {:>14} {:>10}\n",
+                               route.index,
+                               route.evaluations,
+                               route.matches,
+                               route.missed_ns,
+                               route.matched_ns,
+                               misses == 0 ? 0 : route.missed_ns / misses);
+            }
+        }
+
+        void reset() noexcept {
+            for (stl::size_t i = 0; i < count; i++) {
+                auto& route = routes[i];
+                route.evaluations.store(0, stl::memory_order_relaxed);
+                route.matches.store(0, stl::memory_order_relaxed);
+                route.missed_ns.store(0, stl::memory_order_relaxed);
+                route.matched_ns.store(0, stl::memory_order_relaxed);
+            }
+        }
+
+        [[nodiscard]] stl::size_t route_count() const noexcept {
+            return count;
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_ROUTES_ROUTE_PROFILER_H
@@ -2,47 +2,360 @@
 #define WEBPP_ROUTER_H
 
 #include "../../extensions/extension.hpp"
+#include "../../std/optional.hpp"
 #include "../../std/vector.hpp"
+#include "../../utils/deadline.hpp"
+#include "../../utils/functional.hpp"
+#include "../../utils/request_arena.hpp"
+#include "../../utils/task.hpp"
+#include "../../utils/tracing.hpp"
+#include "../../views/html_template.hpp"
+#include "../bodies/string.hpp"
 #include "../request_concepts.hpp"
 #include "../response_concepts.hpp"
+#include "../websocket.hpp"
 #include "./context.hpp"
+#include "./methods.hpp"
+#include "./prefix_tree.hpp"
 #include "./route_concepts.hpp"
+#include "./route_profiler.hpp"
 #include "./router_concepts.hpp"
-#include "../bodies/string.hpp"
 
+#include <array>
+#include <bit>
+#include <charconv>
+#include <chrono>
 #include <functional>
 #include <map>
+#include <memory>
+#include <string>
 #include <tuple>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace webpp {
 
+    namespace details {
+
+        /**
+         * Put what the route has returned into the result
+         * @returns true if the route has responded
+         */
+        template <typename ResultType, typename ContextType, typename ResponseType>
+        constexpr bool take_route_result(ResultType&& res, ContextType& ctx,
+                                         stl::optional<ResponseType>& out) noexcept {
+            using result_type = stl::remove_cvref_t<ResultType>;
+            if constexpr (is_specialization_of<result_type, stl::optional>::value) {
+                return res && take_route_result(stl::move(*res), ctx, out);
+            } else if constexpr (stl::same_as<result_type, ResponseType>) {
+                out.emplace(stl::forward<ResultType>(res));
+                return true;
+            } else if constexpr (Response<result_type>) {
+                static_assert(stl::is_constructible_v<ResponseType, ResultType>,
+                              "The response of the route is not convertible to the router's response.");
+                out.emplace(stl::forward<ResultType>(res));
+                return true;
+            } else if constexpr (stl::is_convertible_v<result_type, stl::string_view> &&
+                                 !stl::same_as<result_type, bool>) {
+                using str_t = typename ContextType::traits_type::string_type;
+                out.emplace(ctx.template response<string_response>(
+                  str_t{stl::string_view{stl::forward<ResultType>(res)}}));
+                return true;
+            } else {
+                // bool, void, a context, or whatever else; the next route should be tried
+                return false;
+            }
+        }
+
+        /**
+         * The rendered bodies of the error responses; they're rendered once in
+         * each thread for each status code (and each custom phrase), and then the
+         * responses share them, so an error response doesn't format or allocate
+         * its body. The pages with the custom phrases are limited, so the phrases
+         * that are made for each request don't fill the memory; the rest of them
+         * are rendered every time.
+         */
+        template <typename StringType>
+        struct error_pages {
+            using page_type = stl::shared_ptr<StringType const>;
+
+            static constexpr stl::size_t     max_custom_pages = 64;
+            static constexpr status_code_type max_status_code  = 600;
+
+            // the phrases are escaped by the template, the custom ones can have anything in them
+            static constexpr views::static_html_template<
+              R"html(<!doctype html><html><head><meta charset="utf-8"><title>{{code}} {{phrase}}!</title></head><body><h1>{{code}} {{phrase}}</h1></body></html>)html">
+              page_template{};
+
+            static page_type render(status_code_type error_code, stl::string_view phrase) {
+                outside_request_arena const _outside; // they outlive the request
+                char                        code[8]{};
+                auto const                  code_end = stl::to_chars(code, code + sizeof(code), error_code).ptr;
+                stl::string                 page;
+                page_template.render(page, {stl::string_view{code, code_end}, phrase});
+                if constexpr (stl::same_as<StringType, decltype(page)>) {
+                    return stl::make_shared<StringType const>(stl::move(page));
+                } else {
+                    return stl::make_shared<StringType const>(stl::string_view{page});
+                }
+            }
+
+            page_type get(status_code_type error_code, stl::string_view phrase) {
+                if (error_code >= max_status_code)
+                    return render(error_code, phrase.empty() ? status_reason_phrase(error_code) : phrase);
+                if (phrase.empty() || phrase == status_reason_phrase(error_code)) {
+                    auto& page = default_pages[error_code];
+                    if (!page)
+                        page = render(error_code, status_reason_phrase(error_code));
+                    return page;
+                }
+                for (auto const& [code, custom_phrase, page] : custom_pages)
+                    if (code == error_code && custom_phrase == phrase)
+                        return page;
+                auto page = render(error_code, phrase);
+                if (custom_pages.size() < max_custom_pages) {
+                    outside_request_arena const _outside;
+                    custom_pages.emplace_back(error_code, StringType{phrase}, page);
+                }
+                return page;
+            }
+
+            static error_pages& local() noexcept {
+                thread_local error_pages pages;
+                return pages;
+            }
+
+          private:
+            stl::array<page_type, max_status_code>                              default_pages{};
+            stl::vector<stl::tuple<status_code_type, StringType, page_type>> custom_pages{};
+        };
+
+        /**
+         * The response of the routers when no route has responded
+         */
+        template <typename ContextType>
+        constexpr auto error_response(ContextType const& ctx, status_code_type error_code,
+                                      stl::string_view phrase = "") noexcept {
+            using str_t = typename ContextType::traits_type::string_type;
+            return ctx.template response<string_response>(error_code,
+                                                          error_pages<str_t>::local().get(error_code, phrase));
+        }
+
+    } // namespace details
 
     /**
      * Const router is a router that satisfies that "Router" concept.
      *
-     * @tparam InitialContextType
+     * The entry routes are tried in order, and the first one that responds
+     * wins. A route can respond by returning:
+     *   - a response (it's converted to the router's response type if needed)
+     *   - something string-like (it's put in a string_response)
+     *   - an optional of those; an empty optional means it doesn't match
+     * Anything else (void, bool, a context) means the route didn't respond and
+     * the next route should be tried; passing a modified context from one
+     * entry route to the next is not supported yet.
+     *
+     * The routes that have a static path prefix (see PrefixedRoute) are put in
+     * a radix tree when the router is constructed, and a request only goes
+     * through the routes whose prefixes match its path; the routes are still
+     * called in their original order. The routes that only respond to one
+     * method (see routes::MethodRoute) are put in the bucket of that method at
+     * compile time, so the requests of the other methods skip them too.
+     *
      * @tparam ExtensionListType
      * @tparam RouteType
      */
-    template <ExtensionList ExtensionListType = empty_extension_pack, Route... RouteType>
+    template <ExtensionList ExtensionListType = empty_extension_pack, typename... RouteType>
     struct router {
-
+        using extension_list_type = ExtensionListType;
+        using prefix_tree_type    = routes::prefix_tree<sizeof...(RouteType)>;
 
         // todo: Additional routes extracted from the extensions
         //        using additional_routes = ;
 
         const stl::tuple<RouteType...> routes;
 
-        constexpr router(RouteType&&... _route) noexcept : routes(stl::forward<RouteType>(_route)...) {
+      private:
+        prefix_tree_type tree{};
+        route_profiler*  profiler = nullptr;
+
+        // where the requests get their deadlines from, if they're given any
+        stl::optional<deadline_options> deadline_source{};
+
+        // the WebSocket endpoints, by their paths
+        stl::vector<stl::pair<stl::string, stl::shared_ptr<websocket::handler const>>> websocket_endpoints{};
+
+        template <typename R>
+        static constexpr stl::string_view static_prefix_of(R const& _route) noexcept {
+            if constexpr (PrefixedRoute<R>) {
+                return _route.static_path_prefix();
+            } else {
+                return {};
+            }
+        }
+
+        template <stl::size_t... I>
+        constexpr void build_tree(stl::index_sequence<I...>) noexcept {
+            (tree.insert(static_prefix_of(stl::get<I>(routes)), I), ...);
+        }
+
+        /**
+         * The routes of each method, from the types of the routes; the routes
+         * that don't specify a method are in all of the buckets.
+         */
+        template <stl::size_t... I>
+        static constexpr auto make_method_buckets(stl::index_sequence<I...>) noexcept {
+            using mask_type = typename prefix_tree_type::mask_type;
+            stl::array<mask_type, routes::http_method_count> buckets{};
+            auto const add = [&]<typename R>(stl::size_t index, R*) constexpr noexcept {
+                for (stl::size_t m = 0; m < routes::http_method_count; m++) {
+                    if constexpr (routes::MethodRoute<R>) {
+                        if (m != static_cast<stl::size_t>(R::static_method()))
+                            continue;
+                    }
+                    buckets[m][index / prefix_tree_type::word_bits] |= stl::uint64_t{1}
+                                                                       << (index % prefix_tree_type::word_bits);
+                }
+            };
+            if constexpr (sizeof...(I) != 0)
+                (add(I, static_cast<RouteType*>(nullptr)), ...);
+            return buckets;
+        }
+
+        static constexpr auto method_buckets = make_method_buckets(stl::index_sequence_for<RouteType...>{});
+
+        /**
+         * The path that the prefixes are matched against; without the query
+         * string. If the request doesn't have one, every route is a candidate.
+         */
+        template <typename ContextType>
+        static constexpr stl::optional<stl::string_view> request_path(ContextType const& ctx) noexcept {
+            if constexpr (requires { ctx.request->request_uri(); }) {
+                stl::string_view const uri = ctx.request->request_uri();
+                return uri.substr(0, uri.find_first_of("?#"));
+            } else {
+                return stl::nullopt;
+            }
+        }
+
+        /**
+         * Call the route at the index with the context
+         */
+        template <stl::size_t Index, typename ContextType, typename ResponseType>
+        static bool call_entryroute(router const& self, ContextType& ctx,
+                                    stl::optional<ResponseType>& out) noexcept {
+            // setting the context features
+            ctx.router_features.level            = router_stats::route_level::entryroute;
+            ctx.router_features.last_entryroute  = Index + 1 == sizeof...(RouteType);
+            ctx.router_features.entryroute_index = Index;
+
+            auto const call = [&]() noexcept {
+                using result_type = decltype(details::call_route(stl::get<Index>(self.routes), ctx));
+                if constexpr (stl::is_void_v<result_type>) {
+                    details::call_route(stl::get<Index>(self.routes), ctx);
+                    return false;
+                } else {
+                    return details::take_route_result(details::call_route(stl::get<Index>(self.routes), ctx),
+                                                      ctx,
+                                                      out);
+                }
+            };
+            if (auto* const prof = ctx.router_features.profiler; prof != nullptr) [[unlikely]] {
+                auto const start   = stl::chrono::steady_clock::now();
+                auto const matched = call();
+                prof->record(Index, matched, stl::chrono::steady_clock::now() - start);
+                return matched;
+            }
+            return call();
         }
 
+        template <typename ContextType, typename ResponseType>
+        using entryroute_caller = bool (*)(router const&, ContextType&, stl::optional<ResponseType>&) noexcept;
+
+        template <stl::size_t Index, typename ContextType>
+        using entryroute_result_type = decltype(details::call_route(stl::get<Index>(stl::declval<router const&>().routes),
+                                                                    stl::declval<ContextType&>()));
 
-        Response auto error(stl::uint_fast16_t error_code) {
-            // todo
-            return "Error";
+        /**
+         * The routes that return a task (the coroutines) make the router async
+         * for that context type
+         */
+        template <typename ContextType, stl::size_t... I>
+        static constexpr bool has_async_routes(stl::index_sequence<I...>) noexcept {
+            return (Task<entryroute_result_type<I, ContextType>> || ...);
         }
 
+        template <typename ContextType>
+        static constexpr bool is_async_for = has_async_routes<ContextType>(stl::index_sequence_for<RouteType...>{});
+
+        /**
+         * Call the route at the index, and await it if it's a coroutine; the
+         * synchronous routes are called right away and don't make a coroutine.
+         */
+        template <stl::size_t Index, typename ContextType, typename ResponseType>
+        static task<bool> call_async_entryroute(router const& self, ContextType& ctx,
+                                                stl::optional<ResponseType>& out) noexcept {
+            using result_type = entryroute_result_type<Index, ContextType>;
+            if constexpr (!Task<result_type>) {
+                return task<bool>::ready(call_entryroute<Index>(self, ctx, out));
+            } else {
+                return [](router const& self, ContextType& ctx, stl::optional<ResponseType>& out) -> task<bool> {
+                    ctx.router_features.level            = router_stats::route_level::entryroute;
+                    ctx.router_features.last_entryroute  = Index + 1 == sizeof...(RouteType);
+                    ctx.router_features.entryroute_index = Index;
+                    if constexpr (stl::is_void_v<typename result_type::value_type>) {
+                        co_await details::call_route(stl::get<Index>(self.routes), ctx);
+                        co_return false;
+                    } else {
+                        co_return details::take_route_result(
+                          co_await details::call_route(stl::get<Index>(self.routes), ctx), ctx, out);
+                    }
+                }(self, ctx, out);
+            }
+        }
+
+        template <typename ContextType, typename ResponseType>
+        using async_entryroute_caller = task<bool> (*)(router const&, ContextType&,
+                                                       stl::optional<ResponseType>&) noexcept;
+
+        template <typename ContextType, typename ResponseType, stl::size_t... I>
+        static constexpr auto make_async_entryroute_table(stl::index_sequence<I...>) noexcept {
+            return stl::array<async_entryroute_caller<ContextType, ResponseType>, sizeof...(I)>{
+              &call_async_entryroute<I, ContextType, ResponseType>...};
+        }
+
+        template <typename ContextType, typename ResponseType>
+        static constexpr auto async_entryroute_table =
+          make_async_entryroute_table<ContextType, ResponseType>(stl::index_sequence_for<RouteType...>{});
+
+        /**
+         * A jump table of the entry routes for a context type, so the routes
+         * in a candidate set can be called by their indices
+         */
+        template <typename ContextType, typename ResponseType, stl::size_t... I>
+        static constexpr auto make_entryroute_table(stl::index_sequence<I...>) noexcept {
+            return stl::array<entryroute_caller<ContextType, ResponseType>, sizeof...(I)>{
+              &call_entryroute<I, ContextType, ResponseType>...};
+        }
+
+        template <typename ContextType, typename ResponseType>
+        static constexpr auto entryroute_table =
+          make_entryroute_table<ContextType, ResponseType>(stl::index_sequence_for<RouteType...>{});
+
+      public:
+        constexpr router() noexcept requires(sizeof...(RouteType) == 0) = default;
+
+        template <typename... R>
+        requires(sizeof...(R) == sizeof...(RouteType) && sizeof...(R) != 0 &&
+                 (stl::is_constructible_v<RouteType, R&&> && ...)) constexpr router(R&&... _route) noexcept
+          : routes(stl::forward<R>(_route)...) {
+            build_tree(stl::index_sequence_for<RouteType...>{});
+        }
+
+        constexpr router(router const&) noexcept = default;
+        constexpr router(router&&) noexcept      = default;
+
         /**
          * @return how many routes are in this router
          */
@@ -51,102 +364,200 @@ namespace webpp {
         }
 
         /**
-         * Get the nth route
-         * @tparam N
-         * @param i
-         * @return
+         * Count and time the entry routes into the profiler (see route_profiler); null turns it off.
+         * The profiler should outlive the router, and have room for all of its routes.
          */
-        template <stl::size_t N = 0>
-        constexpr auto& operator[](stl::size_t i) const noexcept {
-            if (N == i) {
-                return stl::get<N>(routes);
-            }
-            if constexpr (N + 1 < route_count()) {
-                return operator[]<N + 1>(i);
-            }
-            throw stl::invalid_argument("The specified index is not valid");
+        constexpr void profile(route_profiler* _profiler) noexcept {
+            profiler = _profiler;
+        }
+
+        /**
+         * Give the requests their deadlines (see deadline_options); the
+         * requests whose deadlines have passed, or that are cancelled, are
+         * answered with a 503 and their routes are not called (the coroutine
+         * routes are checked after each of them too). The header's name
+         * should outlive the router.
+         */
+        constexpr void deadlines(deadline_options const& options) noexcept {
+            deadline_source = options;
+        }
+
+        /**
+         * Upgrade the requests to the path to WebSocket (see websocket.hpp); the
+         * interfaces that can't upgrade the connections pass them to the
+         * routes as usual.
+         */
+        void websocket(stl::string_view path, websocket::handler handler) {
+            websocket_endpoints.emplace_back(path, stl::make_shared<websocket::handler const>(stl::move(handler)));
+        }
+
+        /**
+         * The handler of the WebSocket endpoint of the path (without the query
+         * string); null if there's none. It's for the interfaces.
+         */
+        [[nodiscard]] stl::shared_ptr<websocket::handler const> websocket_handler(stl::string_view path) const noexcept {
+            path = path.substr(0, path.find_first_of("?#"));
+            for (auto const& [endpoint, handler] : websocket_endpoints)
+                if (endpoint == path)
+                    return handler;
+            return nullptr;
+        }
+
+        /**
+         * The radix tree of the static prefixes of the routes
+         */
+        constexpr prefix_tree_type const& prefixes() const noexcept {
+            return tree;
         }
 
         Response auto error(Context auto const& ctx, status_code_type error_code,
                             stl::string_view phrase = "") const noexcept {
-            stl::string_view _phrase = phrase.empty() ? status_reason_phrase(error_code) : phrase;
-            return ctx.template response<string_response>(
-              error_code,
-              stl::format(
-                R"html(<!doctype html><html><head><meta charset="utf-8"><title>{1} {2}!</title></head><body><h1>{1} {2}</h1></body></html>)html",
-                error_code, _phrase));
+            return details::error_response(ctx, error_code, phrase);
         }
 
         /**
-         * Run the request through the routes and then return the response
+         * Run the request through the routes and then return the response; if
+         * some of the routes are coroutines, it's a task of the response, and
+         * the request should live until the task is done.
          * @param req
          * @return final response
          */
         template <typename RequestType>
-        requires(Request<stl::remove_cvref_t<RequestType>>) Response auto
-        operator()(RequestType& req) noexcept {
+        requires(Request<stl::remove_cvref_t<RequestType>>) auto
+        operator()(RequestType& req) const noexcept {
             using req_type     = stl::remove_cvref_t<RequestType>;
             using context_type = simple_context<req_type, ExtensionListType>;
-            return this->operator()(context_type{req});
+            context_type ctx{req};
+            return this->operator()(ctx);
         }
 
-        template <typename ContextType, stl::size_t Index = 0>
-        requires(Context<stl::remove_cvref_t<ContextType>>) Response auto
-        operator()(ContextType&& ctx) noexcept {
-
+        /**
+         * Run the context through the routes whose prefixes match its path,
+         * and are in the bucket of its method. If some of the routes are
+         * coroutines, the result is a task of the response that has its own
+         * copy of the context.
+         */
+        template <typename ContextType>
+        requires(Context<stl::remove_cvref_t<ContextType>>) auto
+        operator()(ContextType&& ctx) const noexcept {
             if constexpr (sizeof...(RouteType) == 0) {
                 return error(ctx, 404u);
             } else {
-
-                // handling root-level route calls:
-                using context_type              = stl::remove_cvref_t<ContextType>;
-                constexpr auto next_route_index = Index + 1;
-                constexpr auto route            = stl::get<Index>(routes);
-                constexpr bool is_last_route    = Index == route_count() - 1;
-
-                // setting the context features
-                ctx.router_features.level            = router_stats::route_level::entryroute;
-                ctx.router_features.last_entryroute  = is_last_route;
-                ctx.router_features.entryroute_index = Index;
-
-                auto res          = route(ctx);
-                using result_type = decltype(res);
-
-                if constexpr (Response<result_type>) {
-
-                    // just call the context handlers
-                    ctx.call_post_entryroute_methods();
-
-                    // we're done; don't call the next route
-                    return res;
-                } else if constexpr (Context<result_type>) {
-                    // context switching is happening here
-                    // just call the next route or finish it with calling the
-                    // context handlers
-                    if constexpr (!is_last_route) {
-                        return operator()<next_route_index>(stl::move(res));
+                if (profiler != nullptr)
+                    ctx.router_features.profiler = profiler;
+                if (deadline_source)
+                    assign_deadline(ctx);
+                if (ctx.is_cancelled()) [[unlikely]] {
+                    if constexpr (is_async_for<stl::remove_cvref_t<ContextType>>) {
+                        return task<decltype(error(ctx, 404u))>::ready(error(ctx, 503u));
                     } else {
-                        // call the context handlers
-                        ctx.call_post_entryroute_methods();
-                        return error(ctx, 404u);
+                        return error(ctx, 503u);
                     }
+                }
+                auto const candidates = [&] {
+                    WEBPP_TRACE_SPAN(route, 0);
+                    auto const path = request_path(ctx);
+                    auto       res  = path ? tree.candidates(*path) : prefix_tree_type::all();
+                    if constexpr (requires { ctx.request->request_method(); }) {
+                        auto const  method = routes::parse_http_method(ctx.request->request_method());
+                        auto const& bucket = method_buckets[static_cast<stl::size_t>(method)];
+                        for (stl::size_t i = 0; i < prefix_tree_type::word_count; i++)
+                            res[i] &= bucket[i];
+                    }
+                    return res;
+                }();
+                if constexpr (is_async_for<stl::remove_cvref_t<ContextType>>) {
+                    return async_dispatch<stl::remove_cvref_t<ContextType>>(ctx, candidates);
                 } else {
-                    // we just ignore anything else the user returns;
-                    // todo: add a warning or log here so the user can find the issue
+                    return dispatch(ctx, candidates);
                 }
+            }
+        }
 
-                // call the next route:
-                if constexpr (!is_last_route) {
-                    return operator()<next_route_index>(stl::forward<context_type>(ctx));
-                } else {
-                    // call the context
-                    ctx.call_post_entryroute_methods();
-                    return error(ctx, 404u);
+        /**
+         * Run the context through all of the routes, one by one, without
+         * looking at their prefixes (it's what the router did before the
+         * prefix tree; it's here for the benchmarks and for the tests).
+         */
+        template <typename ContextType>
+        requires(Context<stl::remove_cvref_t<ContextType>>) Response auto
+        walk(ContextType&& ctx) const noexcept {
+            using context_type  = stl::remove_cvref_t<ContextType>;
+            using response_type = decltype(error(ctx, 404u));
+
+            stl::optional<response_type> res;
+            if constexpr (sizeof...(RouteType) != 0) {
+                if (profiler != nullptr)
+                    ctx.router_features.profiler = profiler;
+                for (auto const caller : entryroute_table<context_type, response_type>) {
+                    if (caller(*this, ctx, res))
+                        return stl::move(*res);
                 }
             }
+            return error(ctx, 404u);
+        }
+
+      private:
+        /**
+         * The deadline of the request, from the options and its header; the
+         * context keeps the one it has if it's earlier.
+         */
+        template <typename ContextType>
+        void assign_deadline(ContextType& ctx) const noexcept {
+            stl::string_view header_value;
+            if constexpr (requires { ctx.request->header(deadline_source->header); }) {
+                if (!deadline_source->header.empty())
+                    header_value = ctx.request->header(deadline_source->header);
+            }
+            auto const deadline = request_deadline(*deadline_source, header_value);
+            if (deadline < ctx.cancellation.deadline())
+                ctx.cancellation = ctx.cancellation.with_deadline(deadline);
+        }
+
+        template <typename ContextType>
+        Response auto dispatch(ContextType& ctx, typename prefix_tree_type::mask_type const& candidates) const
+          noexcept {
+            using context_type  = stl::remove_cvref_t<ContextType>;
+            using response_type = decltype(error(ctx, 404u));
+
+            auto const&                  table = entryroute_table<context_type, response_type>;
+            stl::optional<response_type> res;
+            if (prefix_tree_type::for_each(candidates, [&](stl::size_t index) noexcept {
+                    return table[index](*this, ctx, res);
+                }))
+                return stl::move(*res);
+            return error(ctx, 404u);
+        }
+
+        /**
+         * Like dispatch, but the routes can suspend; the context is copied in,
+         * because the coroutine outlives the caller's context.
+         */
+        template <typename ContextType>
+        auto async_dispatch(ContextType ctx, typename prefix_tree_type::mask_type candidates) const noexcept
+          -> task<decltype(error(ctx, 404u))> {
+            using response_type = decltype(error(ctx, 404u));
+
+            auto const&                  table = async_entryroute_table<ContextType, response_type>;
+            stl::optional<response_type> res;
+            for (stl::size_t i = 0; i < prefix_tree_type::word_count; i++) {
+                for (auto word = candidates[i]; word != 0; word &= word - 1) {
+                    auto const index = i * prefix_tree_type::word_bits +
+                                       static_cast<stl::size_t>(stl::countr_zero(word));
+                    if (co_await table[index](*this, ctx, res))
+                        co_return stl::move(*res);
+                    // the route may have waited long enough for the client to give up
+                    if (ctx.is_cancelled())
+                        co_return error(ctx, 503u);
+                }
+            }
+            co_return error(ctx, 404u);
         }
     };
 
+    template <typename... R>
+    router(R&&...) -> router<empty_extension_pack, stl::remove_cvref_t<R>...>;
+
     /**
      * This is the router; the developers need this class to inject their routes
      * and also add more migrations.
@@ -196,43 +607,6 @@ namespace webpp {
     };
      */
 
-
-
-
-    /*
-    struct dynamic_route {
-
-      protected:
-        // todo: maybe don't use std::function? it's slow a bit (but not that much)
-        using callback_t = std::function<void()>;
-
-        callback_t callback = nullptr;
-
-      public:
-        // fixme: it gives me error when I put "noexcept" here:
-        dynamic_route() = default;
-        dynamic_route(callback_t callback) noexcept : callback(callback) {
-        }
-
-        template <typename C>
-        dynamic_route& operator=(C&& callback) noexcept {
-            this->callback = [=](req_t req, res_t res) noexcept {
-                return call_route(callback, req, res);
-            };
-            return *this;
-        }
-
-        auto operator()(req_t req, res_t res) noexcept {
-            return callback(req, res);
-        }
-
-        inline bool is_match(req_t req) noexcept {
-            return condition(req);
-        }
-    };
-     */
-
-
 }; // namespace webpp
 
 #endif // WEBPP_ROUTER_H
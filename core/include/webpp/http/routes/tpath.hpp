@@ -3,216 +3,341 @@
 #ifndef WEBPP_TPATH_H
 #define WEBPP_TPATH_H
 
-#include "../../utils/uri.hpp"
-#include "route.hpp"
+#include "../../std/optional.hpp"
+#include "../../std/string_view.hpp"
+#include "../../std/tuple.hpp"
+#include "../../utils/casts.hpp"
+#include "../../utils/fixed_string.hpp"
+#include "./path_segments.hpp"
+#include "./router.hpp"
 
-#include <cassert>
+#include <array>
+#include <charconv>
 #include <cstddef> // for std::size_t
-#include <string_view>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
 
 
 namespace webpp {
 
     /**
-     * TODO: add types to the "{user_id}" to be able to use it as "{int:user_id}"
+     * The types that a segment of a tpath can be captured as:
+     *   {name} or {string:name} : stl::string_view (not decoded)
+     *   {uint:name}             : stl::uint64_t
+     *   {int:name}              : stl::int64_t
      */
-    stl::map<stl::string_view, stl::string_view>
-    parse_vars(stl::string_view const& _templ,
-               stl::string_view const& _path) noexcept {
-        using namespace webpp;
-
-        stl::map<stl::string_view, stl::string_view> res;
-
-        using ptr_t = decltype(_templ.data());
-
-        ptr_t templ_start = _templ.data();
-        ptr_t templ_end   = _templ.data() + _templ.size();
-        ptr_t curly_start = templ_end;
-        ptr_t colon       = templ_end;
-        ptr_t path_char   = _path.data();
-
-        for (ptr_t c = templ_start; *c; c++) {
-            // breaks out of the loop when the template and the paths don't
-            // match
-            if (curly_start == templ_end && *c != '{' && *c != *path_char++)
-                break;
-
-            switch (*c) {
-                case '{':
-                    if (curly_start == templ_end) {
-                        colon = curly_start = c;
-                    }
-                    break;
-                case ':':
-                    if (curly_start != templ_end) {
-                        colon = c;
+    enum struct tpath_capture_type : stl::uint8_t { string, uint, integer };
+
+    namespace details {
+
+        template <tpath_capture_type Type>
+        using tpath_capture_value_type = stl::conditional_t<
+          Type == tpath_capture_type::uint, stl::uint64_t,
+          stl::conditional_t<Type == tpath_capture_type::integer, stl::int64_t, stl::string_view>>;
+
+        /**
+         * One segment of a templated path; it's a literal, or a capture with
+         * an optional literal before and after it, like "{uint:page}.html"
+         */
+        struct tpath_segment {
+            stl::string_view   literal{}; // the whole segment, or the part before the capture
+            stl::string_view   suffix{};  // the part after the capture
+            stl::string_view   name{};
+            tpath_capture_type type    = tpath_capture_type::string;
+            bool               capture = false;
+        };
+
+        /**
+         * The templated path, compiled into a list of segments at compile time.
+         * The template is split the same way as the paths of the requests are
+         * (see routes::path_segments), so matching is a segment by segment
+         * comparison.
+         */
+        template <fixed_string Template>
+        struct tpath_program {
+            static constexpr stl::size_t template_size = Template.size();
+
+            // the template as chars; the segments are views into this
+            static constexpr auto chars = [] {
+                stl::array<char, template_size + 1> res{};
+                for (stl::size_t i = 0; i < template_size; i++)
+                    res[i] = static_cast<char>(Template[i]);
+                return res;
+            }();
+
+            static constexpr bool is_ascii = [] {
+                for (stl::size_t i = 0; i < template_size; i++)
+                    if (Template[i] >= 0x80)
+                        return false;
+                return true;
+            }();
+
+            static constexpr stl::string_view source{chars.data(), template_size};
+
+            static constexpr auto raw_segments = routes::path_segments::parse(source);
+
+            static constexpr stl::size_t segment_count = raw_segments.size();
+
+            static constexpr stl::optional<tpath_segment> compile_segment(stl::string_view seg) noexcept {
+                tpath_segment res;
+                auto const    open = seg.find('{');
+                if (open == stl::string_view::npos) {
+                    if (seg.find('}') != stl::string_view::npos)
+                        return stl::nullopt;
+                    res.literal = seg;
+                    return res;
+                }
+                auto const close = seg.find('}', open);
+                if (close == stl::string_view::npos || seg.find('{', open + 1) < close ||
+                    seg.find_first_of("{}", close + 1) != stl::string_view::npos ||
+                    seg.substr(0, open).find('}') != stl::string_view::npos)
+                    return stl::nullopt; // only one capture in each segment
+                res.capture      = true;
+                res.literal      = seg.substr(0, open);
+                res.suffix       = seg.substr(close + 1);
+                auto const inner = seg.substr(open + 1, close - open - 1);
+                auto const colon = inner.find(':');
+                res.name         = colon == stl::string_view::npos ? inner : inner.substr(colon + 1);
+                if (colon != stl::string_view::npos) {
+                    auto const type = inner.substr(0, colon);
+                    if (type == "uint")
+                        res.type = tpath_capture_type::uint;
+                    else if (type == "int")
+                        res.type = tpath_capture_type::integer;
+                    else if (type != "string")
+                        return stl::nullopt;
+                }
+                if (res.name.empty())
+                    return stl::nullopt;
+                return res;
+            }
+
+            struct compiled {
+                stl::array<tpath_segment, routes::path_segments::capacity> segments{};
+                stl::array<stl::size_t, routes::path_segments::capacity>   capture_positions{};
+                stl::size_t                                              capture_count = 0;
+                bool                                                     valid         = true;
+            };
+
+            static constexpr compiled program = [] {
+                compiled res;
+                if (!is_ascii || raw_segments.overflowed()) {
+                    res.valid = false;
+                    return res;
+                }
+                for (stl::size_t i = 0; i < segment_count; i++) {
+                    auto const seg = compile_segment(raw_segments[i]);
+                    if (!seg) {
+                        res.valid = false;
+                        return res;
                     }
-                    break;
-                case '}':
-                    // check if we are in a curly braces
-                    if (curly_start != templ_end) {
-                        stl::string_view key{
-                          colon + 1, static_cast<stl::string_view::size_type>(
-                                       c - colon - 1)};
-
-                        // find _ in "{var}_" inside path
-                        // this doesn't take the / in account
-                        auto next_char_path =
-                          stl::string_view{path_char}.find(*(c + 1));
-
-                        stl::string_view value{
-                          path_char,
-                          stl::min(next_char_path,
-                                   _path.size() - (path_char - _path.data()))};
-                        /*
-                        std::string_view type{curly_start + 1,
-                                              static_cast<std::string_view::size_type>(
-                                                  colon - curly_start)};
-                                                  */
-                        res[key] = value;
-
-                        // preparing for the next variable
-                        curly_start = colon = templ_end; // reset
-                        path_char += next_char_path;
+                    res.segments[i] = *seg;
+                    if (seg->capture) {
+                        for (stl::size_t j = 0; j < res.capture_count; j++)
+                            if (res.segments[res.capture_positions[j]].name == seg->name)
+                                res.valid = false; // the names should be unique
+                        res.capture_positions[res.capture_count++] = i;
                     }
-                    break;
+                }
+                return res;
+            }();
+
+            static constexpr bool        valid         = program.valid;
+            static constexpr stl::size_t capture_count = program.capture_count;
+
+            static constexpr tpath_segment const& capture(stl::size_t index) noexcept {
+                return program.segments[program.capture_positions[index]];
             }
-        }
 
-        return res;
-    }
+            template <stl::size_t... I>
+            static auto make_values_type(stl::index_sequence<I...>)
+              -> stl::tuple<tpath_capture_value_type<capture(I).type>...>;
+
+            using values_type = decltype(make_values_type(stl::make_index_sequence<capture_count>{}));
+
+            /**
+             * The literal part of the template before its first capture
+             */
+            static constexpr stl::string_view static_prefix = [] {
+                auto const open = source.find('{');
+                return source.substr(0, open);
+            }();
+
+            template <typename T>
+            static constexpr bool decode(stl::string_view str, T& out) noexcept {
+                if constexpr (stl::is_same_v<T, stl::string_view>) {
+                    out = str;
+                    return !str.empty();
+                } else if constexpr (stl::is_integral_v<T>) {
+                    return parse_integer(str, out);
+                } else {
+                    auto const [ptr, ec] = stl::from_chars(str.data(), str.data() + str.size(), out);
+                    return ec == stl::errc{} && ptr == str.data() + str.size() && !str.empty();
+                }
+            }
+
+            template <stl::size_t Index>
+            static constexpr bool match_capture(routes::path_segments const& segs, values_type& values) noexcept {
+                constexpr auto const& seg  = capture(Index);
+                auto                  part = segs[program.capture_positions[Index]];
+                if (part.size() < seg.literal.size() + seg.suffix.size() || !part.starts_with(seg.literal) ||
+                    !part.ends_with(seg.suffix))
+                    return false;
+                part.remove_prefix(seg.literal.size());
+                part.remove_suffix(seg.suffix.size());
+                return decode(part, stl::get<Index>(values));
+            }
 
+            template <stl::size_t... I>
+            static constexpr bool match_captures(routes::path_segments const& segs, values_type& values,
+                                                 stl::index_sequence<I...>) noexcept {
+                return (match_capture<I>(segs, values) && ...);
+            }
 
+            /**
+             * Match the segments of a path, and decode the captures into the values
+             */
+            static constexpr bool match(routes::path_segments const& segs, values_type& values) noexcept {
+                if (segs.size() != segment_count || segs.overflowed())
+                    return false;
+                for (stl::size_t i = 0; i < segment_count; i++) {
+                    auto const& seg = program.segments[i];
+                    if (!seg.capture && seg.literal != segs[i])
+                        return false;
+                }
+                return match_captures(segs, values, stl::make_index_sequence<capture_count>{});
+            }
+
+            template <fixed_string Name>
+            static constexpr stl::size_t index_of() noexcept {
+                for (stl::size_t i = 0; i < capture_count; i++) {
+                    auto const name = capture(i).name;
+                    if (name.size() != Name.size())
+                        continue;
+                    bool same = true;
+                    for (stl::size_t j = 0; j < name.size(); j++)
+                        same = same && static_cast<char32_t>(name[j]) == Name[j];
+                    if (same)
+                        return i;
+                }
+                return capture_count;
+            }
+        };
 
+    } // namespace details
 
     /**
-     * Check whether or not the specified URI path is a match for the specified
-     * template. This function will be used in "tpath_condition". I didn't
-     * implement it there because it's a template method and I'd like to
-     * abstract away the implementation details.
-     * @param templated_path
-     * @param _path
-     * @return
+     * The decoded captures of a tpath; they're decoded once when the path
+     * matches, and then they're in the context:
+     *   ctx.captures.get<"page">()
      */
-    template <typename CharT>
-    [[nodiscard]] bool
-    tpath_check(stl::basic_string_view<CharT> const& templated_path,
-                stl::basic_string_view<CharT> const& _path) noexcept {
-        //        auto          tit        = templated_path.data(); // templated
-        //        iterator auto          pit        = _path.data();          //
-        //        path iterator decltype(tit) seg_start  = nullptr; stl::size_t
-        //        seg_starts = 0; decltype(pit) pseg_start = nullptr; for (;;) {
-        //            switch (*tit) {
-        //                case '\0':
-        //
-        //                    // error: there's an open segment rule and we can't just
-        //                    // leave it unclosed. I should throw an error in the user's
-        //                    // face but I'm nice and I'm just gonna assert
-        //                    assert(("the specified templated path is not
-        //                    valid.",
-        //                            seg_start == nullptr));
-        //                    if (seg_start) {
-        //                        return false;
-        //                    }
-        //                    break;
-        //                case '{': // might be start of a segment
-        //
-        //                    if (seg_start) {
-        //                        // the { char is part of the segment rule here
-        //                        ++seg_starts;
-        //                        break;
-        //                    }
-        //
-        //                    // pinpoint the segment start for when we reach the end of
-        //                    // it
-        //                    seg_start  = tit + 1;
-        //                    pseg_start = pit;
-        //                    break;
-        //                case '}':
-        //                    { // might be the end of a segment
-        //
-        //                        // a new } char with no starting { char
-        //                        assert(("The specified templated path is not
-        //                        valid.",
-        //                                seg_starts != 0));
-        //                        if (seg_starts == 0)
-        //                            return false;
-        //
-        //                        --seg_starts;
-        //                        if (seg_starts != 0)
-        //                            break; // this } char is part of the
-        //                            segment rule
-        //                                   // itself
-        //
-        //#if CXX20
-        //                        stl::basic_string_view<CharT>
-        //                        seg_rule(seg_start, tit);
-        //#elif CXX17
-        //                        std::basic_string_view<CharT>
-        //                        seg_rule(seg_start,
-        //                                                               tit -
-        //                                                               seg_start);
-        //#endif
-        //
-        //                        // going to find the segment in the path string too
-        //                        for (auto it = pit;; ++it) {
-        //                            switch (*it) {
-        //                                case '\0':
-        //                                    goto after_loop;
-        //                                    //                                case '/':
-        //                                    // todo
-        //                            }
-        //                        }
-        //                        //                    after_loop:
-        //                        // todo
-        //                        //                        parse_seg(seg_rule, );
-        //                    }
-        //                    break;
-        //                case '\\': // escape character
-        //                    // we just don't care what the next char is. even if it's {
-        //                    // or } which they have meanings in this algorithm.
-        //                    ++tit;
-        //                    if (*tit != '}' && *tit != '{')
-        //                        --tit;
-        //                    break;
-        //                default:
-        //                    // it's not an error, it's normal to return false here.
-        //                    if (!seg_start && *tit != *pit)
-        //                        return false;
-        //            }
-        //
-        //            ++tit;
-        //            pit += seg_start != nullptr; // only add 1 if we're not in
-        //            a segment
-        //        }
-        return false;
-    }
+    template <fixed_string Template>
+    struct tpath_captures {
+        using program_type = details::tpath_program<Template>;
+        using values_type  = typename program_type::values_type;
+
+        values_type values{};
 
-    struct tpath_condition {
-      protected:
-        stl::string_view tpath_str;
+        template <fixed_string Name>
+        [[nodiscard]] constexpr auto const& get() const noexcept {
+            constexpr auto index = program_type::template index_of<Name>();
+            static_assert(index < program_type::capture_count, "There's no capture with this name in the tpath.");
+            return stl::get<index>(values);
+        }
 
-      public:
-        constexpr tpath_condition(stl::string_view str) noexcept
-          : tpath_str(str) {
+        [[nodiscard]] static constexpr stl::size_t size() noexcept {
+            return program_type::capture_count;
         }
+    };
+
+    /**
+     * The context extension that the tpath routes add to the context
+     */
+    template <fixed_string Template>
+    struct tpath_context_extension {
 
-        constexpr tpath_condition() noexcept = default;
+        struct captures_extension {
+            template <Traits TraitsType, typename ContextType>
+            struct type : public ContextType {
+
+                template <typename... Args>
+                constexpr type(Args&&... args) noexcept : ContextType{stl::forward<Args>(args)...} {
+                }
+
+                tpath_captures<Template> captures{};
+            };
+        };
+
+        using context_extensions = extension_pack<captures_extension>;
+    };
+
+    /**
+     * A route that calls its handler only when the path of the request matches
+     * the template; the template is parsed and validated at compile time, so
+     * matching is just comparing the segments and decoding the captures:
+     *
+     *   tpath<"/page/{uint:page_num}.html">([](auto& ctx) {
+     *       return fmt::format("page {}", ctx.captures.template get<"page_num">());
+     *   })
+     *
+     * The handler is called with a clone of the context that has the captures,
+     * or with the request, or with nothing. If the path doesn't match, it
+     * returns an empty optional (or false, or nothing, depending on what the
+     * handler returns).
+     */
+    template <fixed_string Template, typename Handler>
+    struct tpath_route {
+        using program_type  = details::tpath_program<Template>;
+        using captures_type = tpath_captures<Template>;
 
-        template <typename RequestType>
-        [[nodiscard]] inline bool
-        operator()(RequestType const& req) const noexcept {
-            return tpath_check(tpath_str, req.request_uri());
+        static_assert(program_type::valid,
+                      "The templated path is not valid; each segment can have one {type:name} capture, the "
+                      "names should be unique, and the types are string, uint, and int.");
+
+        Handler handler;
+
+        /**
+         * The part of the template before its first capture; the router uses
+         * it to skip this route for the paths that don't start with it.
+         */
+        [[nodiscard]] static constexpr stl::string_view static_path_prefix() noexcept {
+            return program_type::static_prefix;
+        }
+
+        template <typename ContextType>
+        constexpr auto operator()(ContextType& ctx) const noexcept {
+            captures_type captures;
+            bool const    matches = program_type::match(ctx.segments(), captures.values);
+            auto const    call    = [&]() noexcept {
+                auto nctx     = ctx.template clone<tpath_context_extension<Template>>();
+                nctx.captures = captures;
+                using result_type = decltype(details::call_route(handler, nctx));
+                if constexpr (Task<result_type>) {
+                    // the coroutine keeps its own context, it outlives this one
+                    return [](Handler const& h, decltype(nctx) c) -> result_type {
+                        co_return co_await details::call_route(h, c);
+                    }(handler, stl::move(nctx));
+                } else {
+                    return details::call_route(handler, nctx);
+                }
+            };
+            return details::call_if(matches, call);
         }
     };
 
+    template <fixed_string Template, typename Handler>
+    [[nodiscard]] constexpr auto tpath(Handler&& handler) noexcept {
+        return tpath_route<Template, stl::remove_cvref_t<Handler>>{stl::forward<Handler>(handler)};
+    }
+
     /**
      * Features:
-     *   - [ ] Type
-     *     - [ ] Default type
+     *   - [X] Type
+     *     - [X] Default type
      *   - [ ] Validating the segments with a custom method
-     *   - [ ] Partial segments: segments that are not between two slashes
-     *   - [ ] Naming the segments
+     *   - [X] Partial segments: segments that are not between two slashes
+     *   - [X] Naming the segments
      *   - [ ] Variadic segments: segments that contain multiple path segments
      *   - [ ] Default value for segments
      *     - [ ] string as default value
@@ -224,28 +349,17 @@ namespace webpp {
      *     - [ ]
      * Examples of tpath:
      *   - /{int:user_id}/profile
-     *   - /{username:username}/profile
-     *   - /{int:}
-     *   - /{email:}
      *   - /page/{uint:page_num}.html
-     *   - /product/{product_list:prod_name}/view
      *   - /view/{view_name}
      *   - /{string:one}/{two}
+     * Not yet:
+     *   - /{username:username}/profile
+     *   - /{email:}
+     *   - /product/{product_list:prod_name}/view
      *   - /{slugs...}/page/{uint:page_num}
      *   - /{string:controller=Home}/{action=Index}/{id?}
-     * Attention: getting those segments are the responsibility of the
-     * "route" class. We will define the implementation for it here, but the
-     * final user should get the data from there; they can use this feature
-     * directly here, but it looks nicer if they do it there.
      */
-    //    struct tpath : public valve<tpath_condition> {
-    //        using valve<tpath_condition>::valve;
-    //    };
-    //
-    //    constexpr tpath operator""_tpath(const char* str, std::size_t len) {
-    //        return tpath{std::string_view{str, len}};
-    //    }
-    //
+
 } // namespace webpp
 
 #endif // WEBPP_TPATH_H
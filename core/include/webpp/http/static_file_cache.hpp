@@ -0,0 +1,463 @@
+#ifndef WEBPP_HTTP_STATIC_FILE_CACHE_H
+#define WEBPP_HTTP_STATIC_FILE_CACHE_H
+
+#include "../config.hpp"
+#include "../std/std.hpp"
+#include "../utils/casts.hpp"
+#include "../utils/perfect_hash.hpp"
+#include "../utils/request_arena.hpp"
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <fcntl.h>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace webpp {
+
+    namespace details {
+        /**
+         * The Content-Type of the file extensions; it's a perfect hash, so
+         * finding one is a hash and a compare, not a compare with each one.
+         */
+        inline constexpr ifixed_string_map<stl::string_view,
+                                           "html",
+                                           "htm",
+                                           "css",
+                                           "js",
+                                           "mjs",
+                                           "json",
+                                           "map",
+                                           "txt",
+                                           "md",
+                                           "csv",
+                                           "xml",
+                                           "svg",
+                                           "png",
+                                           "apng",
+                                           "jpg",
+                                           "jpeg",
+                                           "gif",
+                                           "webp",
+                                           "avif",
+                                           "bmp",
+                                           "ico",
+                                           "woff",
+                                           "woff2",
+                                           "ttf",
+                                           "otf",
+                                           "wasm",
+                                           "pdf",
+                                           "zip",
+                                           "gz",
+                                           "tar",
+                                           "mp3",
+                                           "ogg",
+                                           "wav",
+                                           "mp4",
+                                           "webm",
+                                           "webmanifest">
+          mime_types{{
+            "text/html; charset=utf-8",
+            "text/html; charset=utf-8",
+            "text/css; charset=utf-8",
+            "text/javascript; charset=utf-8",
+            "text/javascript; charset=utf-8",
+            "application/json",
+            "application/json",
+            "text/plain; charset=utf-8",
+            "text/markdown; charset=utf-8",
+            "text/csv; charset=utf-8",
+            "application/xml",
+            "image/svg+xml",
+            "image/png",
+            "image/apng",
+            "image/jpeg",
+            "image/jpeg",
+            "image/gif",
+            "image/webp",
+            "image/avif",
+            "image/bmp",
+            "image/x-icon",
+            "font/woff",
+            "font/woff2",
+            "font/ttf",
+            "font/otf",
+            "application/wasm",
+            "application/pdf",
+            "application/zip",
+            "application/gzip",
+            "application/x-tar",
+            "audio/mpeg",
+            "audio/ogg",
+            "audio/wav",
+            "video/mp4",
+            "video/webm",
+            "application/manifest+json",
+          }};
+    } // namespace details
+
+    /**
+     * The Content-Type of a file by its extension; the unknown ones are
+     * "application/octet-stream".
+     */
+    [[nodiscard]] constexpr stl::string_view mime_type_of(stl::string_view path) noexcept {
+        auto const dot = path.find_last_of("./");
+        if (dot == stl::string_view::npos || path[dot] != '.')
+            return "application/octet-stream";
+        return details::mime_types.value_or(path.substr(dot + 1), "application/octet-stream");
+    }
+
+    /**
+     * A file that's loaded into the memory once, with the values of its
+     * headers; the responses point into it, they don't copy it.
+     */
+    class static_file {
+        stl::unique_ptr<char[]>     data;
+        stl::size_t                 length = 0;
+        stl::uint64_t               mtime  = 0;
+        stl::string                 etag_value;
+        int_str_buffer<stl::size_t> length_value;
+        stl::string_view            type_value;
+
+      public:
+        [[nodiscard]] static stl::uint64_t modification_time(struct stat const& info) noexcept {
+            return static_cast<stl::uint64_t>(info.st_mtim.tv_sec) * 1'000'000'000u +
+                   static_cast<stl::uint64_t>(info.st_mtim.tv_nsec);
+        }
+
+        /**
+         * Like the ETags of the other servers: the modification time and the
+         * size; it's written into "out".
+         */
+        [[nodiscard]] static stl::string_view make_etag(stl::uint64_t         mtime,
+                                                        stl::size_t           length,
+                                                        stl::array<char, 40>& out) noexcept {
+            auto* p = out.data();
+            *p++    = '"';
+            p       = stl::to_chars(p, out.data() + out.size(), mtime, 16).ptr;
+            *p++    = '-';
+            p       = stl::to_chars(p, out.data() + out.size(), length, 16).ptr;
+            *p++    = '"';
+            return {out.data(), static_cast<stl::size_t>(p - out.data())};
+        }
+
+        /**
+         * Load the file; nullptr if it's not a regular file, it's bigger than
+         * the max size, or it can't be read.
+         */
+        [[nodiscard]] static stl::shared_ptr<static_file const> load(stl::filesystem::path const& path,
+                                                                     stl::size_t max_size) noexcept {
+            int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd == -1)
+                return nullptr;
+            struct stat info {};
+            if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) ||
+                static_cast<stl::size_t>(info.st_size) > max_size) {
+                ::close(fd);
+                return nullptr;
+            }
+
+            outside_request_arena const _outside; // the files outlive the requests
+            auto                        file = stl::make_shared<static_file>();
+            file->length                     = static_cast<stl::size_t>(info.st_size);
+            file->data                       = stl::make_unique_for_overwrite<char[]>(file->length);
+            stl::size_t done                 = 0;
+            while (done < file->length) {
+                auto const res = ::read(fd, file->data.get() + done, file->length - done);
+                if (res < 0 && errno == EINTR)
+                    continue;
+                if (res <= 0)
+                    break;
+                done += static_cast<stl::size_t>(res);
+            }
+            ::close(fd);
+            if (done != file->length)
+                return nullptr; // it changed while we were reading it
+
+            file->mtime = modification_time(info);
+            stl::array<char, 40> etag{};
+            file->etag_value.assign(make_etag(file->mtime, file->length, etag));
+            file->length_value = to_str_buffer(file->length);
+            file->type_value   = mime_type_of(path.native());
+            return file;
+        }
+
+        [[nodiscard]] stl::string_view content() const noexcept {
+            return {data.get(), length};
+        }
+
+        [[nodiscard]] stl::size_t size() const noexcept {
+            return length;
+        }
+
+        /**
+         * The modification time of the file when it was loaded, in nanoseconds
+         */
+        [[nodiscard]] stl::uint64_t modified() const noexcept {
+            return mtime;
+        }
+
+        [[nodiscard]] stl::string_view etag() const noexcept {
+            return etag_value;
+        }
+
+        [[nodiscard]] stl::string_view content_length() const noexcept {
+            return length_value.view();
+        }
+
+        [[nodiscard]] stl::string_view content_type() const noexcept {
+            return type_value;
+        }
+    };
+
+    struct static_file_cache_options {
+        stl::size_t max_file_size = 1024 * 1024; // the bigger ones are sent with sendfile
+        stl::size_t max_entries   = 1024;
+
+        // how often the changes of the files are looked at
+        stl::chrono::steady_clock::duration refresh_interval = stl::chrono::seconds{1};
+    };
+
+    /**
+     * The small, hot files (the assets of a site) kept in the memory, keyed by
+     * their paths.
+     *
+     * A file is read the first time it's asked for; after that, the responses
+     * are made from the memory without touching the disk. The files are
+     * watched with inotify, and they're loaded again after they change; the
+     * changes are looked at once per refresh interval (or when "refresh" is
+     * called, the inotify descriptor can be waited on in an event loop).
+     *
+     * The cache can be shared between the threads; the files that are
+     * dropped stay alive until the last response that points into them is
+     * gone.
+     */
+    class static_file_cache {
+        using clock_type = stl::chrono::steady_clock;
+        using file_ptr   = stl::shared_ptr<static_file const>;
+
+        struct entry {
+            file_ptr file;
+            int      watch = -1;
+        };
+
+        static_file_cache_options                 options; // guarded by the lock
+        mutable stl::shared_mutex                 lock{};
+        stl::unordered_map<stl::string, entry>    files{};
+        stl::unordered_multimap<int, stl::string> watches{}; // the paths of each inotify watch
+        int                                       inotify = -1;
+        stl::atomic<clock_type::rep>              next_refresh{0};
+        stl::atomic<clock_type::rep>              refresh_every;
+
+        void unwatch(int watch, stl::string const& path) noexcept {
+            if (watch == -1)
+                return;
+            auto [first, last] = watches.equal_range(watch);
+            for (auto w = first; w != last; ++w) {
+                if (w->second == path) {
+                    watches.erase(w);
+                    break;
+                }
+            }
+            // the other paths of the same file keep the watch
+            if (!watches.contains(watch))
+                ::inotify_rm_watch(inotify, watch);
+        }
+
+        void drop(stl::unordered_map<stl::string, entry>::iterator it) noexcept {
+            unwatch(it->second.watch, it->first);
+            files.erase(it);
+        }
+
+        void maybe_refresh() noexcept {
+            if (inotify == -1)
+                return;
+            auto const now  = clock_type::now().time_since_epoch().count();
+            auto       next = next_refresh.load(stl::memory_order_relaxed);
+            if (now < next)
+                return;
+            // only one of the threads does it
+            if (next_refresh.compare_exchange_strong(
+                  next,
+                  now + refresh_every.load(stl::memory_order_relaxed),
+                  stl::memory_order_relaxed)) {
+                refresh();
+            }
+        }
+
+      public:
+        explicit static_file_cache(static_file_cache_options const& opts = {}) noexcept
+          : options{opts},
+            inotify{::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)},
+            refresh_every{stl::chrono::duration_cast<clock_type::duration>(opts.refresh_interval).count()} {}
+
+        static_file_cache(static_file_cache const&) = delete;
+        static_file_cache& operator=(static_file_cache const&) = delete;
+
+        ~static_file_cache() noexcept {
+            if (inotify != -1)
+                ::close(inotify);
+        }
+
+        /**
+         * The file from the cache; it's loaded if it's not there. nullptr if
+         * it can't be cached (it doesn't exist, or it's too big).
+         */
+        [[nodiscard]] file_ptr get(stl::filesystem::path const& path) noexcept {
+            maybe_refresh();
+            auto const& key = path.native();
+            stl::size_t max_file_size;
+            {
+                stl::shared_lock _lock{lock};
+                if (auto it = files.find(key); it != files.end())
+                    return it->second.file;
+                max_file_size = options.max_file_size;
+            }
+
+            // it's read without holding the lock; if two threads load the same
+            // file, the first one is kept
+            auto file = static_file::load(path, max_file_size);
+            if (!file)
+                return file;
+
+            outside_request_arena const _outside;
+            stl::unique_lock            _lock{lock};
+            if (options.max_entries == 0)
+                return file;
+            if (auto it = files.find(key); it != files.end())
+                return it->second.file;
+            if (files.size() >= options.max_entries)
+                drop(files.begin());
+            int watch = -1;
+            if (inotify != -1) {
+                watch = ::inotify_add_watch(inotify, key.c_str(),
+                                            IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF);
+                if (watch != -1)
+                    watches.emplace(watch, key);
+            }
+
+            // it could've changed after we read it and before it was watched
+            if (struct stat info {}; ::stat(key.c_str(), &info) != 0 ||
+                                     static_file::modification_time(info) != file->modified() ||
+                                     static_cast<stl::size_t>(info.st_size) != file->size()) {
+                unwatch(watch, key);
+                return file;
+            }
+            files.emplace(key, entry{file, watch});
+            return file;
+        }
+
+        /**
+         * Change the options while the cache is being used; if there are more
+         * files than the new "max_entries", some of them are dropped, and the
+         * files that are bigger than the new "max_file_size" are dropped too.
+         */
+        void limits(static_file_cache_options const& opts) noexcept {
+            stl::unique_lock _lock{lock};
+            options = opts;
+            refresh_every.store(stl::chrono::duration_cast<clock_type::duration>(opts.refresh_interval).count(),
+                                stl::memory_order_relaxed);
+            for (auto it = files.begin(); it != files.end();) {
+                auto const next = stl::next(it);
+                if (it->second.file->size() > options.max_file_size)
+                    drop(it);
+                it = next;
+            }
+            while (files.size() > options.max_entries)
+                drop(files.begin());
+        }
+
+        [[nodiscard]] static_file_cache_options limits() const noexcept {
+            stl::shared_lock _lock{lock};
+            return options;
+        }
+
+        /**
+         * Apply the "static_files.max_file_size", "static_files.max_entries",
+         * and "static_files.refresh_interval_ms" of the config; the missing
+         * ones are left as they are.
+         */
+        void reload(config_snapshot const& cfg) noexcept {
+            auto opts          = limits();
+            opts.max_file_size = cfg.get_as<stl::size_t>("static_files.max_file_size", opts.max_file_size);
+            opts.max_entries   = cfg.get_as<stl::size_t>("static_files.max_entries", opts.max_entries);
+            if (auto const ms = cfg.get_as<long long>("static_files.refresh_interval_ms", -1); ms >= 0)
+                opts.refresh_interval = stl::chrono::milliseconds{ms};
+            limits(opts);
+        }
+
+        /**
+         * Drop the file; it's loaded again the next time it's asked for.
+         */
+        void invalidate(stl::filesystem::path const& path) noexcept {
+            stl::unique_lock _lock{lock};
+            if (auto it = files.find(path.native()); it != files.end())
+                drop(it);
+        }
+
+        /**
+         * Drop the files that have changed since the last time
+         */
+        void refresh() noexcept {
+            if (inotify == -1)
+                return;
+            alignas(inotify_event) stl::array<char, 4096> events;
+            for (;;) {
+                auto const len = ::read(inotify, events.data(), events.size());
+                if (len <= 0)
+                    return; // EAGAIN: nothing more has changed
+                stl::unique_lock _lock{lock};
+                for (auto* p = events.data(); p < events.data() + len;) {
+                    auto const* event = reinterpret_cast<inotify_event const*>(p);
+                    p += sizeof(inotify_event) + event->len;
+                    auto [first, last] = watches.equal_range(event->wd);
+                    stl::vector<stl::string> paths;
+                    for (auto w = first; w != last; ++w)
+                        paths.push_back(w->second);
+                    if (event->mask & IN_IGNORED) {
+                        // the kernel has removed the watch itself
+                        watches.erase(first, last);
+                        for (auto const& path : paths)
+                            if (auto it = files.find(path); it != files.end())
+                                it->second.watch = -1;
+                    }
+                    for (auto const& path : paths)
+                        if (auto it = files.find(path); it != files.end())
+                            drop(it);
+                }
+            }
+        }
+
+        /**
+         * The inotify descriptor, to be waited on for the changes; -1 if
+         * inotify is not available (the files are never invalidated by
+         * themselves then)
+         */
+        [[nodiscard]] int native_handle() const noexcept {
+            return inotify;
+        }
+
+        [[nodiscard]] stl::size_t size() const noexcept {
+            stl::shared_lock _lock{lock};
+            return files.size();
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_HTTP_STATIC_FILE_CACHE_H
@@ -0,0 +1,99 @@
+#ifndef WEBPP_HTTP_WEBSOCKET_H
+#define WEBPP_HTTP_WEBSOCKET_H
+
+#include "../std/std.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+/**
+ * The WebSocket endpoints (RFC 6455). The handler of an endpoint is
+ * registered in the router, and the interfaces that can upgrade the
+ * connections (the simple server) ask the router for it when a request
+ * wants an upgrade; the routes never see those requests:
+ *
+ *   router.websocket("/echo", {.on_message = [](websocket::sender& ws, stl::string_view msg, bool binary) {
+ *       ws.send(binary ? websocket::opcode::binary : websocket::opcode::text, msg);
+ *   }});
+ *
+ * The handlers are called on the thread of the connection, one message at a
+ * time; the sender belongs to the connection, and it can be kept and used on
+ * that thread until on_close is called.
+ */
+namespace webpp::websocket {
+
+    enum struct opcode : stl::uint8_t {
+        continuation = 0x0,
+        text         = 0x1,
+        binary       = 0x2,
+        close        = 0x8,
+        ping         = 0x9,
+        pong         = 0xA
+    };
+
+    // the status codes of the close frames (section 7.4.1)
+    enum struct close_code : stl::uint16_t {
+        normal           = 1000,
+        going_away       = 1001,
+        protocol_error   = 1002,
+        unsupported_data = 1003,
+        no_status        = 1005, // it's never sent, there was no code in the close frame
+        abnormal         = 1006, // it's never sent, the connection is gone without a close frame
+        invalid_payload  = 1007, // the text is not UTF-8
+        policy_violation = 1008,
+        too_big          = 1009,
+        internal_error   = 1011
+    };
+
+    /**
+     * The connection of the endpoint, to send the messages to the client
+     */
+    struct sender {
+        virtual ~sender() = default;
+
+        /**
+         * Send a message in one frame; nothing is sent after close
+         */
+        virtual void send(opcode op, stl::string_view payload) noexcept = 0;
+
+        /**
+         * Send the close frame, and close the connection after it's written
+         */
+        virtual void close(close_code code = close_code::normal, stl::string_view reason = {}) noexcept = 0;
+
+        void text(stl::string_view message) noexcept {
+            send(opcode::text, message);
+        }
+
+        void binary(stl::string_view message) noexcept {
+            send(opcode::binary, message);
+        }
+
+        void ping(stl::string_view payload = {}) noexcept {
+            send(opcode::ping, payload);
+        }
+    };
+
+    struct handler {
+        // after the handshake is sent
+        stl::function<void(sender&)> on_open{};
+
+        // a whole message; the fragments are put together first (unless there's on_fragment),
+        // and the texts are checked to be UTF-8. The message is only valid in the call.
+        stl::function<void(sender&, stl::string_view message, bool binary)> on_message{};
+
+        // each fragment of the messages as it comes, for streaming the big ones; "last" is set on
+        // the last fragment of a message. The texts are not checked, as they can be cut anywhere.
+        stl::function<void(sender&, stl::string_view fragment, bool binary, bool last)> on_fragment{};
+
+        // the client has closed it (with its code), or the connection is gone (abnormal)
+        stl::function<void(sender&, close_code)> on_close{};
+
+        // the biggest frame, and the biggest message that's put together
+        stl::size_t max_message_size = 1024 * 1024;
+    };
+
+} // namespace webpp::websocket
+
+#endif // WEBPP_HTTP_WEBSOCKET_H
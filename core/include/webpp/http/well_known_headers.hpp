@@ -0,0 +1,192 @@
+#ifndef WEBPP_HTTP_WELL_KNOWN_HEADERS_H
+#define WEBPP_HTTP_WELL_KNOWN_HEADERS_H
+
+#include "../std/std.hpp"
+#include "../utils/perfect_hash.hpp"
+#include "../utils/strings.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace webpp {
+
+    /**
+     * The response header fields that the headers keep track of; the headers
+     * know which ones of them they have without looking at the fields, and
+     * they're written with their canonical names.
+     */
+    enum struct well_known_header : stl::uint8_t {
+        accept_ranges,
+        age,
+        allow,
+        cache_control,
+        connection,
+        content_disposition,
+        content_encoding,
+        content_language,
+        content_length,
+        content_location,
+        content_range,
+        content_security_policy,
+        content_type,
+        date,
+        etag,
+        expires,
+        last_modified,
+        link,
+        location,
+        retry_after,
+        server,
+        set_cookie,
+        strict_transport_security,
+        transfer_encoding,
+        vary,
+        www_authenticate,
+        x_content_type_options,
+        x_frame_options,
+        unknown // not one of them; keep it the last one
+    };
+
+    namespace details {
+        static constexpr auto well_known_header_count = static_cast<stl::size_t>(well_known_header::unknown);
+
+        /**
+         * The names, followed by the ": " that comes after them when they're
+         * written; in the order of the enum.
+         */
+        inline constexpr stl::array<stl::string_view, well_known_header_count> well_known_header_prefixes{
+          "Accept-Ranges: ",
+          "Age: ",
+          "Allow: ",
+          "Cache-Control: ",
+          "Connection: ",
+          "Content-Disposition: ",
+          "Content-Encoding: ",
+          "Content-Language: ",
+          "Content-Length: ",
+          "Content-Location: ",
+          "Content-Range: ",
+          "Content-Security-Policy: ",
+          "Content-Type: ",
+          "Date: ",
+          "ETag: ",
+          "Expires: ",
+          "Last-Modified: ",
+          "Link: ",
+          "Location: ",
+          "Retry-After: ",
+          "Server: ",
+          "Set-Cookie: ",
+          "Strict-Transport-Security: ",
+          "Transfer-Encoding: ",
+          "Vary: ",
+          "WWW-Authenticate: ",
+          "X-Content-Type-Options: ",
+          "X-Frame-Options: "};
+
+        /**
+         * The names, for finding the header of a name with one hash; in the
+         * order of the enum as well.
+         */
+        using well_known_header_names = iperfect_hash<
+          "Accept-Ranges",
+          "Age",
+          "Allow",
+          "Cache-Control",
+          "Connection",
+          "Content-Disposition",
+          "Content-Encoding",
+          "Content-Language",
+          "Content-Length",
+          "Content-Location",
+          "Content-Range",
+          "Content-Security-Policy",
+          "Content-Type",
+          "Date",
+          "ETag",
+          "Expires",
+          "Last-Modified",
+          "Link",
+          "Location",
+          "Retry-After",
+          "Server",
+          "Set-Cookie",
+          "Strict-Transport-Security",
+          "Transfer-Encoding",
+          "Vary",
+          "WWW-Authenticate",
+          "X-Content-Type-Options",
+          "X-Frame-Options">;
+
+        [[nodiscard]] constexpr bool are_well_known_header_names_in_order() noexcept {
+            for (stl::size_t i = 0; i < well_known_header_count; i++) {
+                auto const prefix = well_known_header_prefixes[i];
+                if (well_known_header_names::key(i) != prefix.substr(0, prefix.size() - 2))
+                    return false;
+            }
+            return well_known_header_names::size() == well_known_header_count;
+        }
+
+        static_assert(are_well_known_header_names_in_order(),
+                      "The names and the prefixes of the headers are not the same.");
+    } // namespace details
+
+    /**
+     * The name and the ": " after it ("Content-Type: "); empty for unknown
+     */
+    [[nodiscard]] constexpr stl::string_view well_known_header_prefix(well_known_header header) noexcept {
+        if (header == well_known_header::unknown)
+            return {};
+        return details::well_known_header_prefixes[static_cast<stl::size_t>(header)];
+    }
+
+    /**
+     * The canonical name of the header ("Content-Type"); empty for unknown
+     */
+    [[nodiscard]] constexpr stl::string_view well_known_header_name(well_known_header header) noexcept {
+        auto const prefix = well_known_header_prefix(header);
+        return prefix.substr(0, prefix.empty() ? 0 : prefix.size() - 2);
+    }
+
+    /**
+     * Find the well-known header with this name; the names are compared
+     * case-insensitively.
+     */
+    template <typename StringType>
+    [[nodiscard]] constexpr well_known_header to_well_known_header(StringType const& name) noexcept {
+        auto const index = details::well_known_header_names::index_of(stl::string_view{name.data(), name.size()});
+        return index == details::well_known_header_names::npos ? well_known_header::unknown
+                                                                : static_cast<well_known_header>(index);
+    }
+
+    /**
+     * A bitmap of the well-known headers that are in the headers, so
+     * checking one of them is a bit test.
+     */
+    class well_known_header_set {
+        static_assert(details::well_known_header_count <= 64, "They don't fit in the bitmap.");
+
+        stl::uint64_t bits = 0;
+
+        [[nodiscard]] static constexpr stl::uint64_t bit_of(well_known_header header) noexcept {
+            return header == well_known_header::unknown ? 0 : stl::uint64_t{1} << static_cast<unsigned>(header);
+        }
+
+      public:
+        constexpr void insert(well_known_header header) noexcept {
+            bits |= bit_of(header);
+        }
+
+        [[nodiscard]] constexpr bool contains(well_known_header header) const noexcept {
+            return (bits & bit_of(header)) != 0;
+        }
+
+        constexpr void clear() noexcept {
+            bits = 0;
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_HTTP_WELL_KNOWN_HEADERS_H
@@ -0,0 +1,22 @@
+#ifndef WEBPP_STD_COROUTINE_H
+#define WEBPP_STD_COROUTINE_H
+
+#include "./std.hpp"
+
+#if __has_include(<coroutine>)
+#    include <coroutine>
+#    define have_coroutine 1
+#elif __has_include(<experimental/coroutine>)
+#    include <experimental/coroutine>
+#    define have_coroutine 1
+namespace webpp::stl {
+    using namespace ::std::experimental;
+}
+#endif
+
+#ifndef have_coroutine
+#    define have_coroutine 0
+#    error "There's no <coroutine>"
+#endif
+
+#endif // WEBPP_STD_COROUTINE_H
@@ -12,15 +12,19 @@
 namespace webpp::stl {
 
     template <typename... Args>
-    inline auto format(Args&&... args) {
-        return fmt::format(stl::forward<Args>(args)...);
+    inline auto format(fmt::format_string<Args...> fmt_str, Args&&... args) {
+        return fmt::format(fmt_str, stl::forward<Args>(args)...);
     }
 
-    template <typename... Args>
-    inline auto format_to(Args&&... args) {
-        return fmt::format_to(stl::forward<Args>(args)...);
+    template <typename OutputIt, typename... Args>
+    inline auto format_to(OutputIt out, fmt::format_string<Args...> fmt_str, Args&&... args) {
+        return fmt::format_to(out, fmt_str, stl::forward<Args>(args)...);
     }
 
+    using fmt::format_error;
+    using fmt::make_format_args;
+    using fmt::vformat_to;
+
 } // namespace webpp::std
 #else
 #    error "We don't have access to <format> nor {fmt} library."
@@ -15,18 +15,30 @@
 #if __has_include(<socket>)
 #    define STD_SOCKET STLLIB_STANDARD
 #    include <socket>
+#    include <system_error>
+namespace webpp::istl {
+    using net_error_code = stl::error_code;
+}
 #elif __has_include(<boost/asio/ts/socket.hpp>)
 #    define STD_SOCKET STLLIB_BOOST
 #    include <boost/asio/ts/socket.hpp>
 namespace webpp::stl {
     namespace net = boost::asio;
 }
+namespace webpp::istl {
+    // the error code type that the networking functions use
+    using net_error_code = boost::system::error_code;
+}
 #elif __has_include(<experimental/socket>)
 #    define STD_SOCKET STLLIB_EXPERIMENTAL
 #    include <experimental/socket>
+#    include <system_error>
 namespace webpp::stl {
     namespace net = experimental::net;
 }
+namespace webpp::istl {
+    using net_error_code = stl::error_code;
+}
 #else
 #    error STLLIB_NETWORKING_ERROR
 #endif
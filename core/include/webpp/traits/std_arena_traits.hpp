@@ -0,0 +1,48 @@
+#ifndef WEBPP_STD_ARENA_TRAITS_H
+#define WEBPP_STD_ARENA_TRAITS_H
+
+#include "../utils/request_arena.hpp"
+#include "std_traits.hpp"
+
+namespace webpp {
+
+    /**
+     * The standard traits, with the strings that are allocated in the arena of
+     * the current request (see request_arena); the interfaces make an arena
+     * scope for each request they serve with these traits, and reset the arena
+     * after the response is written.
+     */
+    template <typename CharT, typename CharTraits = stl::char_traits<CharT>>
+    using basic_std_arena_traits = basic_std_traits<CharT, CharTraits, request_allocator>;
+
+    using std_arena_traits = basic_std_arena_traits<char>;
+
+    template <typename TraitsType>
+    concept ArenaTraits = requires {
+        requires stl::same_as<typename TraitsType::template allocator<char>, request_allocator<char>>;
+    };
+
+    /**
+     * Serve one request in the arena of this thread if the traits use it; the
+     * callable should write the response (or copy it out) before it returns.
+     */
+    template <typename TraitsType, typename Callable>
+    decltype(auto) serve_in_request_arena(Callable&& callable) noexcept {
+        if constexpr (ArenaTraits<TraitsType>) {
+            auto& arena = request_arena::local();
+            struct reset_after {
+                request_arena& arena;
+                ~reset_after() noexcept {
+                    arena.reset();
+                }
+            } const             _reset{arena};
+            request_arena_scope _scope{arena};
+            return stl::forward<Callable>(callable)();
+        } else {
+            return stl::forward<Callable>(callable)();
+        }
+    }
+
+} // namespace webpp
+
+#endif // WEBPP_STD_ARENA_TRAITS_H
@@ -0,0 +1,20 @@
+#ifndef WEBPP_STD_COUNTING_TRAITS_H
+#define WEBPP_STD_COUNTING_TRAITS_H
+
+#include "../utils/counting_allocator.hpp"
+#include "std_traits.hpp"
+
+namespace webpp {
+
+    /**
+     * The standard traits, with the allocations of their strings counted (see counting_allocator);
+     * the tests and the benchmarks use them to see where the allocations of a request are.
+     */
+    template <typename CharT, typename CharTraits = stl::char_traits<CharT>>
+    using basic_std_counting_traits = basic_std_traits<CharT, CharTraits, counting_allocator>;
+
+    using std_counting_traits = basic_std_counting_traits<char>;
+
+} // namespace webpp
+
+#endif // WEBPP_STD_COUNTING_TRAITS_H
@@ -5,15 +5,20 @@
 
 #include "std_traits.hpp"
 
+#include <memory_resource>
+
 namespace webpp {
 
+    /**
+     * The standard traits with the polymorphic allocators; the strings get
+     * their memory from the default memory resource unless they're given
+     * another one (an arena, for example).
+     */
     template <typename CharT, typename CharTraits = stl::char_traits<CharT>,
-              template <typename> typename Allocator = stl::pmr::polymorphic_allocator<T>>
+              template <typename> typename Allocator = stl::pmr::polymorphic_allocator>
     using basic_std_pmr_traits = basic_std_traits<CharT, CharTraits, Allocator>;
 
-
-    using std_pmr_traits =
-      basic_std_pmr_traits<char, stl::char_traits<char>, stl::pmr::polymorphic_allocator>;
+    using std_pmr_traits = basic_std_pmr_traits<char>;
 
     template <typename T>
     struct std_pmr_traits_from_string_view {
@@ -0,0 +1,517 @@
+#ifndef WEBPP_UTILS_BASE64_H
+#define WEBPP_UTILS_BASE64_H
+
+#include "../std/std.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#    define WEBPP_BASE64_WIDTH 32
+#elif defined(__SSSE3__)
+#    include <tmmintrin.h>
+#    define WEBPP_BASE64_WIDTH 16
+#else
+#    define WEBPP_BASE64_WIDTH 1
+#endif
+
+namespace webpp {
+
+    enum struct base64_alphabet : stl::uint8_t {
+        standard, // "+" and "/" (RFC 4648, section 4)
+        url       // "-" and "_"; for the URLs, the cookies, and the file names (section 5)
+    };
+
+    namespace details {
+
+        template <base64_alphabet Alphabet>
+        static constexpr stl::string_view base64_chars =
+          Alphabet == base64_alphabet::url ? "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
+                                           : "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        // the chars that are not in the alphabet are 0xFF, so they set the high bits of a group
+        template <base64_alphabet Alphabet>
+        static constexpr auto base64_values = [] {
+            stl::array<stl::uint8_t, 256> res{};
+            res.fill(0xFF);
+            for (stl::size_t i = 0; i < base64_chars<Alphabet>.size(); i++)
+                res[static_cast<unsigned char>(base64_chars<Alphabet>[i])] = static_cast<stl::uint8_t>(i);
+            return res;
+        }();
+
+#if WEBPP_BASE64_WIDTH > 1
+        /**
+         * The few vector operations that the base64 needs, in the widest
+         * vectors that we have; the shuffles work in the 16-byte lanes.
+         */
+        struct base64_simd {
+#    if WEBPP_BASE64_WIDTH == 32
+            using vec = __m256i;
+
+            static constexpr stl::size_t width       = 32;
+            static constexpr stl::size_t encode_step = 24; // the bytes of a vector of chars
+            static constexpr stl::size_t encode_load = 28; // the bytes that are loaded for them
+
+            static vec load(char const* data) noexcept {
+                return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data));
+            }
+
+            // 12 bytes in each lane
+            static vec load_triplets(char const* data) noexcept {
+                auto const low  = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data));
+                auto const high = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + 12));
+                return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+            }
+
+            static void store(char* out, vec v) noexcept {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), v);
+            }
+
+            static vec lanes(__m128i table) noexcept {
+                return _mm256_broadcastsi128_si256(table);
+            }
+
+            static vec set1(char c) noexcept {
+                return _mm256_set1_epi8(c);
+            }
+
+            static vec set1_32(int value) noexcept {
+                return _mm256_set1_epi32(value);
+            }
+
+            static vec and_(vec a, vec b) noexcept {
+                return _mm256_and_si256(a, b);
+            }
+
+            static vec or_(vec a, vec b) noexcept {
+                return _mm256_or_si256(a, b);
+            }
+
+            static vec add8(vec a, vec b) noexcept {
+                return _mm256_add_epi8(a, b);
+            }
+
+            static vec subs_u8(vec a, vec b) noexcept {
+                return _mm256_subs_epu8(a, b);
+            }
+
+            static vec gt(vec a, vec b) noexcept {
+                return _mm256_cmpgt_epi8(a, b);
+            }
+
+            static vec eq(vec a, vec b) noexcept {
+                return _mm256_cmpeq_epi8(a, b);
+            }
+
+            static vec shuffle(vec table, vec index) noexcept {
+                return _mm256_shuffle_epi8(table, index);
+            }
+
+            static bool all(vec mask) noexcept {
+                return static_cast<stl::uint32_t>(_mm256_movemask_epi8(mask)) == 0xFFFF'FFFFu;
+            }
+
+            static vec mulhi_u16(vec a, vec b) noexcept {
+                return _mm256_mulhi_epu16(a, b);
+            }
+
+            static vec mullo_16(vec a, vec b) noexcept {
+                return _mm256_mullo_epi16(a, b);
+            }
+
+            static vec maddubs(vec a, vec b) noexcept {
+                return _mm256_maddubs_epi16(a, b);
+            }
+
+            static vec madd(vec a, vec b) noexcept {
+                return _mm256_madd_epi16(a, b);
+            }
+
+            // the 12 bytes of each lane next to each other
+            static vec compact(vec v) noexcept {
+                return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+            }
+#    else
+            using vec = __m128i;
+
+            static constexpr stl::size_t width       = 16;
+            static constexpr stl::size_t encode_step = 12;
+            static constexpr stl::size_t encode_load = 16;
+
+            static vec load(char const* data) noexcept {
+                return _mm_loadu_si128(reinterpret_cast<__m128i const*>(data));
+            }
+
+            static vec load_triplets(char const* data) noexcept {
+                return load(data);
+            }
+
+            static void store(char* out, vec v) noexcept {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), v);
+            }
+
+            static vec lanes(__m128i table) noexcept {
+                return table;
+            }
+
+            static vec set1(char c) noexcept {
+                return _mm_set1_epi8(c);
+            }
+
+            static vec set1_32(int value) noexcept {
+                return _mm_set1_epi32(value);
+            }
+
+            static vec and_(vec a, vec b) noexcept {
+                return _mm_and_si128(a, b);
+            }
+
+            static vec or_(vec a, vec b) noexcept {
+                return _mm_or_si128(a, b);
+            }
+
+            static vec add8(vec a, vec b) noexcept {
+                return _mm_add_epi8(a, b);
+            }
+
+            static vec subs_u8(vec a, vec b) noexcept {
+                return _mm_subs_epu8(a, b);
+            }
+
+            static vec gt(vec a, vec b) noexcept {
+                return _mm_cmpgt_epi8(a, b);
+            }
+
+            static vec eq(vec a, vec b) noexcept {
+                return _mm_cmpeq_epi8(a, b);
+            }
+
+            static vec shuffle(vec table, vec index) noexcept {
+                return _mm_shuffle_epi8(table, index);
+            }
+
+            static bool all(vec mask) noexcept {
+                return _mm_movemask_epi8(mask) == 0xFFFF;
+            }
+
+            static vec mulhi_u16(vec a, vec b) noexcept {
+                return _mm_mulhi_epu16(a, b);
+            }
+
+            static vec mullo_16(vec a, vec b) noexcept {
+                return _mm_mullo_epi16(a, b);
+            }
+
+            static vec maddubs(vec a, vec b) noexcept {
+                return _mm_maddubs_epi16(a, b);
+            }
+
+            static vec madd(vec a, vec b) noexcept {
+                return _mm_madd_epi16(a, b);
+            }
+
+            static vec compact(vec v) noexcept {
+                return v;
+            }
+#    endif
+
+            /**
+             * The 12 bytes of each lane into sixteen 6-bit values
+             */
+            static vec split(vec in) noexcept {
+                in = shuffle(in, lanes(_mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10)));
+                auto const t0 = and_(in, set1_32(0x0FC0'FC00));
+                auto const t1 = mulhi_u16(t0, set1_32(0x0400'0040));
+                auto const t2 = and_(in, set1_32(0x003F'03F0));
+                auto const t3 = mullo_16(t2, set1_32(0x0100'0010));
+                return or_(t1, t3);
+            }
+
+            /**
+             * The sixteen 6-bit values of each lane into 12 bytes, at the
+             * start of the vector
+             */
+            static vec join(vec values) noexcept {
+                auto const pairs   = maddubs(values, set1_32(0x0140'0140));
+                auto const triples = madd(pairs, set1_32(0x0001'1000));
+                return compact(
+                  shuffle(triples, lanes(_mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1))));
+            }
+        };
+#endif
+
+    } // namespace details
+
+    /**
+     * Base64 encoding and decoding into the caller's buffers; nothing is
+     * allocated, and the output never goes past the capacity that's given.
+     *
+     * With SSSE3 it encodes 12 bytes (into 16 chars) and decodes 16 chars at a
+     * time, and twice that with AVX2 (the algorithms of Muła and Lemire, with
+     * the chars classified by their ranges, so both alphabets use the same
+     * code). The rest, and the constant evaluation, are done by the scalar
+     * code, which is also there as "encode_scalar" and "decode_scalar" to be
+     * compared against.
+     *
+     * The decoder takes the input with or without the padding.
+     *
+     *   char             out[base64::encoded_size(5)];
+     *   base64::encode("hello", out, sizeof(out)) == 8 // "aGVsbG8="
+     */
+    template <base64_alphabet Alphabet, bool Padding>
+    struct basic_base64 {
+        static constexpr stl::size_t npos  = stl::string_view::npos;
+        static constexpr stl::size_t width = WEBPP_BASE64_WIDTH;
+
+        static constexpr stl::string_view chars = details::base64_chars<Alphabet>;
+
+        [[nodiscard]] static constexpr stl::size_t encoded_size(stl::size_t size) noexcept {
+            if constexpr (Padding) {
+                return (size + 2) / 3 * 4;
+            } else {
+                return (size * 4 + 2) / 3;
+            }
+        }
+
+        /**
+         * The most bytes that the chars can be decoded into; it's exact if
+         * there's no padding.
+         */
+        [[nodiscard]] static constexpr stl::size_t max_decoded_size(stl::size_t size) noexcept {
+            return size / 4 * 3 + size % 4 * 3 / 4;
+        }
+
+        /**
+         * Encode the bytes into the output, one char at a time
+         * @returns the number of the chars, or npos if they don't fit
+         */
+        static constexpr stl::size_t encode_scalar(stl::string_view data, char* out, stl::size_t capacity) noexcept {
+            auto const size = encoded_size(data.size());
+            if (size > capacity)
+                return npos;
+            encode_tail(data, 0, out);
+            return size;
+        }
+
+        /**
+         * Decode the chars into the output, one group of four at a time
+         * @returns the number of the bytes, or npos if they're not base64 or
+         *          if they don't fit
+         */
+        static constexpr stl::size_t decode_scalar(stl::string_view str, char* out, stl::size_t capacity) noexcept {
+            if (!strip_padding(str) || max_decoded_size(str.size()) > capacity)
+                return npos;
+            return decode_tail(str, 0, out, 0);
+        }
+
+        /**
+         * Encode the bytes into the output
+         * @returns the number of the chars, or npos if they don't fit
+         */
+        static constexpr stl::size_t encode(stl::string_view data, char* out, stl::size_t capacity) noexcept {
+            auto const size = encoded_size(data.size());
+            if (size > capacity)
+                return npos;
+            stl::size_t pos = 0;
+#if WEBPP_BASE64_WIDTH > 1
+            if (!stl::is_constant_evaluated())
+                pos = encode_vectors(data, out);
+#endif
+            encode_tail(data, pos, out + pos / 3 * 4);
+            return size;
+        }
+
+        /**
+         * Decode the chars into the output
+         * @returns the number of the bytes, or npos if they're not base64 or
+         *          if they don't fit
+         */
+        static constexpr stl::size_t decode(stl::string_view str, char* out, stl::size_t capacity) noexcept {
+            if (!strip_padding(str) || max_decoded_size(str.size()) > capacity)
+                return npos;
+            stl::size_t pos = 0;
+#if WEBPP_BASE64_WIDTH > 1
+            if (!stl::is_constant_evaluated()) {
+                pos = decode_vectors(str, out, capacity);
+                if (pos == npos)
+                    return npos;
+            }
+#endif
+            return decode_tail(str, pos, out, pos / 4 * 3);
+        }
+
+        /**
+         * Encode the bytes at the end of the string
+         */
+        template <typename StrT>
+        static constexpr void encode(stl::string_view data, StrT& out) {
+            auto const old_size = out.size();
+            auto const size     = encoded_size(data.size());
+            out.resize(old_size + size);
+            static_cast<void>(encode(data, out.data() + old_size, size));
+        }
+
+        /**
+         * Decode the chars at the end of the string; false (and the string is
+         * as it was) if they're not base64.
+         */
+        template <typename StrT>
+        static constexpr bool decode(stl::string_view str, StrT& out) {
+            auto const old_size = out.size();
+            auto const room     = max_decoded_size(str.size());
+            out.resize(old_size + room);
+            auto const size = decode(str, out.data() + old_size, room);
+            out.resize(size == npos ? old_size : old_size + size);
+            return size != npos;
+        }
+
+      private:
+        /**
+         * Drop the padding; false if it's misplaced, or the length can't be base64
+         */
+        static constexpr bool strip_padding(stl::string_view& str) noexcept {
+            // the unpadded variant doesn't take the padding either
+            if (Padding && str.size() % 4 == 0) {
+                for (int i = 0; i < 2 && !str.empty() && str.back() == '='; i++)
+                    str.remove_suffix(1);
+            }
+            return str.size() % 4 != 1;
+        }
+
+        static constexpr void encode_tail(stl::string_view data, stl::size_t i, char* out) noexcept {
+            auto const byte = [&](stl::size_t index) constexpr noexcept -> stl::uint32_t {
+                return static_cast<unsigned char>(data[index]);
+            };
+            for (; i + 3 <= data.size(); i += 3) {
+                auto const bits = (byte(i) << 16u) | (byte(i + 1) << 8u) | byte(i + 2);
+                *out++          = chars[bits >> 18u];
+                *out++          = chars[(bits >> 12u) & 63u];
+                *out++          = chars[(bits >> 6u) & 63u];
+                *out++          = chars[bits & 63u];
+            }
+            if (auto const rest = data.size() - i; rest != 0) {
+                auto const bits = (byte(i) << 16u) | (rest == 2 ? byte(i + 1) << 8u : 0u);
+                *out++          = chars[bits >> 18u];
+                *out++          = chars[(bits >> 12u) & 63u];
+                if (rest == 2)
+                    *out++ = chars[(bits >> 6u) & 63u];
+                if constexpr (Padding) {
+                    if (rest == 1)
+                        *out++ = '=';
+                    *out = '=';
+                }
+            }
+        }
+
+        static constexpr stl::size_t
+        decode_tail(stl::string_view str, stl::size_t i, char* out, stl::size_t size) noexcept {
+            constexpr auto const& values   = details::base64_values<Alphabet>;
+            auto const            value_at = [&](stl::size_t index) constexpr noexcept -> stl::uint32_t {
+                return values[static_cast<unsigned char>(str[index])];
+            };
+
+            // a char that's not in the alphabet sets the high bits of the group
+            stl::uint32_t bad = 0;
+            for (; i + 4 <= str.size(); i += 4) {
+                auto const bits = (value_at(i) << 18u) | (value_at(i + 1) << 12u) | (value_at(i + 2) << 6u) |
+                                  value_at(i + 3);
+                bad |= value_at(i) | value_at(i + 1) | value_at(i + 2) | value_at(i + 3);
+                out[size++] = static_cast<char>(bits >> 16u);
+                out[size++] = static_cast<char>(bits >> 8u);
+                out[size++] = static_cast<char>(bits);
+            }
+            stl::uint32_t bits = 0;
+            for (; i < str.size(); i++) {
+                bits = (bits << 6u) | value_at(i);
+                bad |= value_at(i);
+            }
+            if (str.size() % 4 == 3) {
+                out[size++] = static_cast<char>(bits >> 10u);
+                out[size++] = static_cast<char>(bits >> 2u);
+            } else if (str.size() % 4 == 2) {
+                out[size++] = static_cast<char>(bits >> 4u);
+            }
+            return (bad & 0xC0u) != 0 ? npos : size;
+        }
+
+#if WEBPP_BASE64_WIDTH > 1
+        using simd = details::base64_simd;
+        using vec  = simd::vec;
+
+        static constexpr char char62 = Alphabet == base64_alphabet::url ? '-' : '+';
+        static constexpr char char63 = Alphabet == base64_alphabet::url ? '_' : '/';
+
+        /**
+         * The 6-bit values into their chars
+         */
+        static vec to_chars(vec indices) noexcept {
+            // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12
+            auto index = simd::subs_u8(indices, simd::set1(51));
+            index      = simd::or_(index, simd::and_(simd::gt(simd::set1(26), indices), simd::set1(13)));
+            auto const offsets = simd::lanes(_mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                                           '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                                           static_cast<char>(char62 - 62),
+                                                           static_cast<char>(char63 - 63), 'A', 0, 0));
+            return simd::add8(simd::shuffle(offsets, index), indices);
+        }
+
+        /**
+         * The chars into their 6-bit values; false if any of them is not in
+         * the alphabet
+         */
+        static bool to_values(vec& in) noexcept {
+            auto const in_range = [](vec v, char low, char high) noexcept {
+                return simd::and_(simd::gt(v, simd::set1(static_cast<char>(low - 1))),
+                                  simd::gt(simd::set1(static_cast<char>(high + 1)), v));
+            };
+            auto const upper = in_range(in, 'A', 'Z');
+            auto const lower = in_range(in, 'a', 'z');
+            auto const digit = in_range(in, '0', '9');
+            auto const c62   = simd::eq(in, simd::set1(char62));
+            auto const c63   = simd::eq(in, simd::set1(char63));
+            auto const valid = simd::or_(simd::or_(simd::or_(upper, lower), simd::or_(digit, c62)), c63);
+            if (!simd::all(valid))
+                return false;
+            auto const shift = simd::or_(
+              simd::or_(simd::or_(simd::and_(upper, simd::set1(-65)), simd::and_(lower, simd::set1(-71))),
+                        simd::or_(simd::and_(digit, simd::set1(4)),
+                                  simd::and_(c62, simd::set1(static_cast<char>(62 - char62))))),
+              simd::and_(c63, simd::set1(static_cast<char>(63 - char63))));
+            in = simd::add8(in, shift);
+            return true;
+        }
+
+        static stl::size_t encode_vectors(stl::string_view data, char* out) noexcept {
+            stl::size_t i = 0;
+            // each vector takes 3/4 of its width of the bytes, but it loads a bit more
+            for (; i + simd::encode_load <= data.size(); i += simd::encode_step, out += simd::width)
+                simd::store(out, to_chars(simd::split(simd::load_triplets(data.data() + i))));
+            return i;
+        }
+
+        static stl::size_t decode_vectors(stl::string_view str, char* out, stl::size_t capacity) noexcept {
+            stl::size_t i = 0;
+            stl::size_t o = 0;
+            // a whole vector is stored, 3/4 of it are the bytes
+            for (; i + simd::width <= str.size() && o + simd::width <= capacity;
+                 i += simd::width, o += simd::encode_step) {
+                auto in = simd::load(str.data() + i);
+                if (!to_values(in))
+                    return npos;
+                simd::store(out + o, simd::join(in));
+            }
+            return i;
+        }
+#endif
+    };
+
+    using base64    = basic_base64<base64_alphabet::standard, true>;
+    using base64url = basic_base64<base64_alphabet::url, false>;
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_BASE64_H
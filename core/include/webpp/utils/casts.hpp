@@ -2,47 +2,267 @@
 #define WEBPP_CASTS_H
 
 #include "../traits/traits_concepts.hpp"
+#include "./strings.hpp"
 
+#include <array>
+#include <bit>
 #include <charconv>
+#include <cstdint>
+#include <limits>
 #include <stdexcept>
 #include <string_view>
+#include <type_traits>
 
 namespace webpp {
 
+    namespace details {
+
+        static constexpr stl::uint64_t zero_chars = 0x3030'3030'3030'3030ull;
+
+        static constexpr auto powers_of_10 = [] {
+            stl::array<stl::uint64_t, 20> powers{};
+            stl::uint64_t                 power = 1;
+            for (auto& p : powers) {
+                p = power;
+                power *= 10;
+            }
+            return powers;
+        }();
+
+        /**
+         * Are all the 8 chars of the word (the first one in the low byte) digits
+         */
+        [[nodiscard]] constexpr bool is_eight_digits(stl::uint64_t word) noexcept {
+            constexpr stl::uint64_t high_nibbles = 0xF0F0'F0F0'F0F0'F0F0ull;
+            // the high nibble is 3 before and after adding 6
+            return ((word & high_nibbles) | ((word + 0x0606'0606'0606'0606ull) & high_nibbles) >> 4u) ==
+                   0x3333'3333'3333'3333ull;
+        }
+
+        /**
+         * The value of the 8 digits of the word (the first one in the low byte); the pairs, then the
+         * quads, and then the whole of it.
+         */
+        [[nodiscard]] constexpr stl::uint32_t eight_digits_value(stl::uint64_t word) noexcept {
+            word -= zero_chars;
+            word = word * 10 + (word >> 8u);
+            word = ((word & 0x0000'00FF'0000'00FFull) * (100 + (1'000'000ull << 32u)) +
+                    ((word >> 16u) & 0x0000'00FF'0000'00FFull) * (1 + (10'000ull << 32u))) >>
+                   32u;
+            return static_cast<stl::uint32_t>(word);
+        }
+
+        /**
+         * Add 1 to 8 digits to the value, as one word: they come after enough leading zeros to make it
+         * 8 digits.
+         * @returns false if there's a char that's not a digit
+         */
+        [[nodiscard]] constexpr bool add_digits(char const*    data,
+                                                stl::size_t    size,
+                                                stl::uint64_t& value) noexcept {
+            auto const shift = 8u * (8u - size);
+            auto const word  = load_word(data, size) << shift | (zero_chars & ~(~stl::uint64_t{0} << shift));
+            if (!is_eight_digits(word))
+                return false;
+            value = value * powers_of_10[size] + eight_digits_value(word);
+            return true;
+        }
+
+        /**
+         * Add the digits to the value, 8 at a time; the value wraps around if there are more than 19 of
+         * them.
+         * @returns false if there's a char that's not a digit
+         */
+        template <typename CharT>
+        [[nodiscard]] constexpr bool parse_digits(CharT const*   data,
+                                                  stl::size_t    size,
+                                                  stl::uint64_t& value) noexcept {
+            if constexpr (stl::is_same_v<CharT, char>) {
+                if (size <= 8) // the ports and most of the lengths
+                    return size == 0 || add_digits(data, size, value);
+                for (; size > 8; data += 8, size -= 8)
+                    if (!add_digits(data, 8, value))
+                        return false;
+                return add_digits(data, size, value);
+            } else {
+                for (auto const* end = data + size; data != end; ++data) {
+                    if (*data < '0' || *data > '9')
+                        return false;
+                    value = value * 10 + static_cast<stl::uint64_t>(*data - '0');
+                }
+                return true;
+            }
+        }
+
+        static constexpr auto digit_pairs = [] {
+            stl::array<char, 200> pairs{};
+            for (stl::size_t i = 0; i < 100; i++) {
+                pairs[i * 2]     = static_cast<char>('0' + i / 10);
+                pairs[i * 2 + 1] = static_cast<char>('0' + i % 10);
+            }
+            return pairs;
+        }();
+
+        /**
+         * The number of the decimal digits of the value
+         */
+        [[nodiscard]] constexpr stl::size_t decimal_size(stl::uint64_t value) noexcept {
+            value |= 1u; // the zero has one digit too
+            // 1233 / 4096 is about log10(2)
+            auto const guess = (stl::bit_width(value) * 1233u) >> 12u;
+            return guess + (value >= powers_of_10[guess]);
+        }
+
+        /**
+         * Write the digits of the value at the first, two at a time, from the end of them.
+         * @returns the end of the digits
+         */
+        constexpr char* write_digits(char* first, stl::uint64_t value) noexcept {
+            auto* const end = first + decimal_size(value);
+            auto*       it  = end;
+            while (value >= 100) {
+                auto const pair = static_cast<stl::size_t>(value % 100) * 2;
+                value /= 100;
+                *--it = digit_pairs[pair + 1];
+                *--it = digit_pairs[pair];
+            }
+            if (value >= 10) {
+                *--it = digit_pairs[value * 2 + 1];
+                *--it = digit_pairs[value * 2];
+            } else {
+                *--it = static_cast<char>('0' + value);
+            }
+            return end;
+        }
+
+        /**
+         * Write the decimal chars of the integer at the first; there should be room for
+         * digit_count<T>() + 2 chars.
+         * @returns the end of them
+         */
+        template <typename T>
+        constexpr char* write_integer(char* first, T value) noexcept {
+            if constexpr (stl::is_signed_v<T>) {
+                if (value < 0) {
+                    *first++ = '-';
+                    // it's not negated in T, for the min of it
+                    return write_digits(first, ~static_cast<stl::uint64_t>(value) + 1);
+                }
+            }
+            return write_digits(first, static_cast<stl::uint64_t>(value));
+        }
+
+    } // namespace details
+
+    /**
+     * Parse a decimal integer strictly: only the digits (and a "-" for the signed ones), and it should
+     * fit in T. The out is not changed if it returns false. The digits are parsed 8 at a time; this is
+     * what the Content-Length, the ports, and the numbers of the paths go through.
+     */
+    template <typename T, typename CharT>
+    requires(stl::is_integral_v<T>)
+      [[nodiscard]] constexpr bool parse_integer(stl::basic_string_view<CharT> str, T& out) noexcept {
+        bool negative = false;
+        if constexpr (stl::is_signed_v<T>) {
+            if (!str.empty() && str.front() == '-') {
+                negative = true;
+                str.remove_prefix(1);
+            }
+        }
+        if (str.empty())
+            return false;
+        while (str.size() > 1 && str.front() == '0')
+            str.remove_prefix(1);
+        if (str.size() > 20)
+            return false;
+
+        stl::uint64_t value = 0;
+        if (str.size() == 20) {
+            // the only one that can overflow the uint64
+            if (!details::parse_digits(str.data(), 19, value))
+                return false;
+            auto const last = str[19];
+            if (last < '0' || last > '9')
+                return false;
+            auto const     digit = static_cast<stl::uint64_t>(last - '0');
+            constexpr auto max   = stl::numeric_limits<stl::uint64_t>::max();
+            if (value > (max - digit) / 10)
+                return false;
+            value = value * 10 + digit;
+        } else if (!details::parse_digits(str.data(), str.size(), value)) {
+            return false;
+        }
+
+        constexpr auto max = static_cast<stl::uint64_t>(stl::numeric_limits<T>::max());
+        if (value > max + (negative ? 1u : 0u))
+            return false;
+        out = static_cast<T>(negative ? ~value + 1 : value);
+        return true;
+    }
+
+    /**
+     * Parse a decimal floating point number strictly: the whole of the string ("1.5", "-2", "3e8"), and
+     * not the infinities or the NaNs. It's rounded correctly (it's from_chars, which is Eisel-Lemire for
+     * the float and the double). The out is not changed if it returns false.
+     */
+    template <typename T>
+    requires(stl::is_floating_point_v<T>)
+      [[nodiscard]] bool parse_floating(stl::string_view str, T& out) noexcept {
+        // from_chars takes "inf" and "nan", and a number has a digit in the first or the second char
+        stl::size_t const first_digit = str.size() > 1 && str.front() == '-';
+        if (str.size() <= first_digit)
+            return false;
+        auto const c = str[first_digit];
+        if ((c < '0' || c > '9') && c != '.')
+            return false;
+        T          value;
+        auto const end       = str.data() + str.size();
+        auto const [ptr, ec] = stl::from_chars(str.data(), end, value);
+        if (ec != stl::errc{} || ptr != end)
+            return false;
+        out = value;
+        return true;
+    }
+
+    /**
+     * parse_integer or parse_floating, based on T
+     */
+    template <typename T>
+    requires(stl::is_arithmetic_v<T>)
+      [[nodiscard]] bool parse_number(stl::string_view str, T& out) noexcept {
+        if constexpr (stl::is_floating_point_v<T>) {
+            return parse_floating(str, out);
+        } else {
+            return parse_integer(str, out);
+        }
+    }
+
+    /**
+     * Convert the string to an integer; a "-" or a "+" can come first if is_signed. If it's not a
+     * number, it's zero, or it throws if throw_mistakes; too many digits wrap around.
+     */
     template <Traits TraitsType, typename T, bool is_signed = true,
               bool throw_mistakes = false>
     constexpr T to(typename TraitsType::string_view_type const& str) noexcept(
       !throw_mistakes) {
-        T ret = 0;
-        if (str.size() > 0) {
-            // todo: minus is not used!!
-            if constexpr (is_signed) {
-                auto c = str.cbegin();
-                if (*c == '-' || *c == '+')
-                    c++; // first character can be - or +
-                for (; c != str.cend(); c++) {
-                    if constexpr (throw_mistakes) {
-                        if (*c <= '0' || *c >= '9')
-                            throw stl::invalid_argument(
-                              "The specified string is not a number");
-                    }
-                    ret *= 10;
-                    ret += static_cast<T>(*c - '0');
-                }
-                ret *= str.front() == '-' ? -1 : 1;
-            } else {
-                for (auto const& c : str) {
-                    if constexpr (throw_mistakes) {
-                        if (c <= '0' || c >= '9')
-                            throw stl::invalid_argument(
-                              "The specified string is not a number");
-                    }
-                    ret *= 10;
-                    ret += static_cast<T>(c - '0');
-                }
+        if (str.empty())
+            return 0;
+        auto digits   = str;
+        bool negative = false;
+        if constexpr (is_signed) {
+            if (digits.front() == '-' || digits.front() == '+') {
+                negative = digits.front() == '-';
+                digits.remove_prefix(1);
+            }
+        }
+        stl::uint64_t value = 0;
+        if (digits.empty() || !details::parse_digits(digits.data(), digits.size(), value)) {
+            if constexpr (throw_mistakes) {
+                throw stl::invalid_argument("The specified string is not a number");
             }
+            return 0;
         }
-        return ret;
+        return static_cast<T>(negative ? ~value + 1 : value);
     }
 
     template <Traits TraitsType>
@@ -111,41 +331,69 @@ namespace webpp {
     template <typename INT>
     constexpr auto digit_count() noexcept {
         uint_fast8_t t = 0;
-        INT          a = stl::numeric_limits<int>::max();
+        INT          a = stl::numeric_limits<INT>::max();
         while (a /= 10)
             ++t;
         return t;
     }
 
+    /**
+     * The characters of an integer in an inline buffer; see to_str_buffer
+     */
+    template <typename INT>
+    struct int_str_buffer {
+        // the digits, and the sign; digit_count is one less than the digits
+        stl::array<char, digit_count<INT>() + 2> chars{};
+        stl::size_t                              size = 0;
+
+        [[nodiscard]] constexpr stl::string_view view() const noexcept {
+            return {chars.data(), size};
+        }
+    };
+
+    /**
+     * Convert an integer to its decimal characters without allocating a
+     * string; the result can be appended to (or assigned to) a string.
+     */
+    template <typename ValueType>
+    [[nodiscard]] constexpr int_str_buffer<ValueType> to_str_buffer(ValueType value) noexcept {
+        int_str_buffer<ValueType> res;
+        auto* const               end = details::write_integer(res.chars.data(), value);
+        res.size                      = static_cast<stl::size_t>(end - res.chars.data());
+        return res;
+    }
+
 
+    /**
+     * Convert the value to a string; the args are the args of to_chars after
+     * the value (like the base), and without them the integers are written
+     * with details::write_integer.
+     */
     template <Traits TraitsType, typename ValueType, typename... R>
     constexpr auto to_str(ValueType value, R&&... args) noexcept {
         using char_type           = typename TraitsType::char_type;
         using str_t               = typename TraitsType::string_type;
         using size_type           = typename str_t::size_type;
-        constexpr size_type _size = digit_count<ValueType>() + 1;
+        constexpr size_type _size = digit_count<ValueType>() + 2;
+        char                chars[_size];
+        char*               end;
+        if constexpr (sizeof...(R) == 0 && stl::is_integral_v<ValueType>) {
+            end = details::write_integer(chars, value);
+        } else {
+            end = stl::to_chars(chars, chars + _size, value, stl::forward<R>(args)...).ptr;
+        }
+        auto const size = static_cast<size_type>(end - chars);
         if constexpr (stl::is_same_v<char_type, char>) {
-            str_t str(_size, '\0');
-            auto [p, _] = stl::to_chars(str.data(), str.data() + _size, value,
-                                        stl::forward<R>(args)...);
-            str.resize(p - str.data());
-            return str;
+            return str_t(chars, size);
         } else {
-            char str[_size];
-            auto [p, _] =
-              stl::to_chars(str, str + _size, value, stl::forward<R>(args)...);
-            size_type __size = static_cast<size_type>(p - str);
-            str_t     res(__size, '\0');
-            auto      it = res.begin();
-            for (auto _c = str; *_c; ++_c) {
-                *it++ = static_cast<char_type>(*_c);
-            }
+            str_t res(size, '\0');
+            for (size_type i = 0; i < size; i++)
+                res[i] = static_cast<char_type>(chars[i]);
             return res;
         }
     }
 
 
-
 } // namespace webpp
 
 #endif // WEBPP_CASTS_H
@@ -7,11 +7,22 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstdint>
 #include <initializer_list>
 #include <tuple>
 #include <type_traits>
 #include <utility>
 
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#    define WEBPP_CHARSET_SCANNER_WIDTH 32
+#elif defined(__SSSE3__)
+#    include <tmmintrin.h>
+#    define WEBPP_CHARSET_SCANNER_WIDTH 16
+#else
+#    define WEBPP_CHARSET_SCANNER_WIDTH 1
+#endif
+
 namespace webpp {
 
     /**
@@ -39,13 +50,137 @@ namespace webpp {
                              callback);
         }
 
-        using super = stl::array<CharT, N>;
+        using super      = stl::array<CharT, N>;
+        using unsigned_t = stl::make_unsigned_t<CharT>;
+
+        // the chars below 256 as a bitmap, so checking one is a bit test
+        stl::array<stl::uint64_t, 4> bits{};
+
+        // the same bits the way the pshufb lookup wants them: the bit of "c"
+        // is the bit (c >> 4) & 7 of the byte ((c >> 7) << 4) | (c & 15)
+        stl::array<stl::uint8_t, 32> nibble_bits{};
+
+        constexpr void add_bits() noexcept {
+            for (auto const c : *this) {
+                auto const uc = static_cast<unsigned_t>(c);
+                if (uc >= 256)
+                    continue;
+                bits[uc >> 6u] |= stl::uint64_t{1} << (uc & 63u);
+                nibble_bits[((uc >> 3u) & 16u) | (uc & 15u)] |=
+                  static_cast<stl::uint8_t>(1u << ((uc >> 4u) & 7u));
+            }
+        }
+
+        [[nodiscard]] constexpr bool linear_contains(CharT c) const noexcept {
+            for (auto cc : *this) {
+                if (cc == c)
+                    return true;
+            }
+            return false;
+        }
+
+#if WEBPP_CHARSET_SCANNER_WIDTH > 1
+        /**
+         * The position of the first char at or after "pos" that is (or with
+         * "In" false, is not) in the set, 16 (SSSE3) or 32 (AVX2) chars at a
+         * time; the last chunk that doesn't fill the width is left to the
+         * caller, so the returned position is only where to go on from.
+         */
+        template <bool In>
+        [[nodiscard]] stl::size_t
+        vectorized_find(char const* data, stl::size_t size,
+                        stl::size_t pos) const noexcept {
+            constexpr stl::size_t width = WEBPP_CHARSET_SCANNER_WIDTH;
+#    if WEBPP_CHARSET_SCANNER_WIDTH == 32
+            auto const low_rows  = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+              reinterpret_cast<__m128i const*>(nibble_bits.data())));
+            auto const high_rows = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+              reinterpret_cast<__m128i const*>(nibble_bits.data() + 16)));
+            auto const masks     = _mm256_setr_epi8(
+              1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128, 1, 2,
+              4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+            auto const low_nibble = _mm256_set1_epi8(0x0F);
+            auto const index_mask = _mm256_set1_epi8(static_cast<char>(0x8F));
+            auto const high_bit   = _mm256_set1_epi8(static_cast<char>(0x80));
+            auto const zero       = _mm256_setzero_si256();
+            for (; pos + width <= size; pos += width) {
+                auto const chunk = _mm256_loadu_si256(
+                  reinterpret_cast<__m256i const*>(data + pos));
+                auto const rows = _mm256_or_si256(
+                  _mm256_shuffle_epi8(low_rows,
+                                      _mm256_and_si256(chunk, index_mask)),
+                  _mm256_shuffle_epi8(
+                    high_rows,
+                    _mm256_and_si256(_mm256_xor_si256(chunk, high_bit),
+                                     index_mask)));
+                auto const mask = _mm256_shuffle_epi8(
+                  masks,
+                  _mm256_and_si256(_mm256_srli_epi16(chunk, 4), low_nibble));
+                auto const missing = static_cast<stl::uint32_t>(
+                  _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+                    _mm256_and_si256(rows, mask), zero)));
+                auto const found = In ? ~missing : missing;
+                if (found != 0)
+                    return pos + static_cast<stl::size_t>(__builtin_ctz(found));
+            }
+#    else
+            auto const low_rows  = _mm_loadu_si128(
+              reinterpret_cast<__m128i const*>(nibble_bits.data()));
+            auto const high_rows = _mm_loadu_si128(
+              reinterpret_cast<__m128i const*>(nibble_bits.data() + 16));
+            auto const masks     = _mm_setr_epi8(
+              1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+            auto const low_nibble = _mm_set1_epi8(0x0F);
+            auto const index_mask = _mm_set1_epi8(static_cast<char>(0x8F));
+            auto const high_bit   = _mm_set1_epi8(static_cast<char>(0x80));
+            auto const zero       = _mm_setzero_si128();
+            for (; pos + width <= size; pos += width) {
+                auto const chunk = _mm_loadu_si128(
+                  reinterpret_cast<__m128i const*>(data + pos));
+                // pshufb gives zero for the indices with the high bit, so
+                // each of the rows only answers for its own half
+                auto const rows = _mm_or_si128(
+                  _mm_shuffle_epi8(low_rows, _mm_and_si128(chunk, index_mask)),
+                  _mm_shuffle_epi8(high_rows,
+                                   _mm_and_si128(_mm_xor_si128(chunk, high_bit),
+                                                 index_mask)));
+                auto const mask = _mm_shuffle_epi8(
+                  masks,
+                  _mm_and_si128(_mm_srli_epi16(chunk, 4), low_nibble));
+                auto const missing = static_cast<stl::uint32_t>(
+                  _mm_movemask_epi8(
+                    _mm_cmpeq_epi8(_mm_and_si128(rows, mask), zero)));
+                auto const found = In ? ~missing & 0xFFFFu : missing;
+                if (found != 0)
+                    return pos + static_cast<stl::size_t>(__builtin_ctz(found));
+            }
+#    endif
+            return pos;
+        }
+#endif
+
+        template <bool In>
+        [[nodiscard]] constexpr stl::size_t
+        find(stl::basic_string_view<CharT> str,
+             stl::size_t                   pos) const noexcept {
+#if WEBPP_CHARSET_SCANNER_WIDTH > 1
+            if constexpr (stl::is_same_v<CharT, char>) {
+                if (!stl::is_constant_evaluated())
+                    pos = vectorized_find<In>(str.data(), str.size(), pos);
+            }
+#endif
+            for (; pos < str.size(); pos++)
+                if (contains(str[pos]) == In)
+                    return pos;
+            return stl::basic_string_view<CharT>::npos;
+        }
 
       public:
         template <typename... T>
         requires((stl::same_as<T, CharT> && ...) &&
                  sizeof...(T) <= N) constexpr charset_t(T... data) noexcept
           : super{data...} {
+            add_bits();
         }
 
         /**
@@ -66,6 +201,7 @@ namespace webpp {
             write(set1);
             write(set2);
             (write(c_sets), ...);
+            add_bits();
         }
 
 
@@ -81,11 +217,12 @@ namespace webpp {
          *     is in the character set is returned.
          */
         [[nodiscard]] constexpr bool contains(CharT c) const noexcept {
-            for (auto cc : *this) {
-                if (cc == c)
-                    return true;
+            auto const uc = static_cast<unsigned_t>(c);
+            if constexpr (sizeof(CharT) > 1) {
+                if (uc >= 256)
+                    return linear_contains(c);
             }
-            return false;
+            return ((bits[uc >> 6u] >> (uc & 63u)) & 1u) != 0;
         }
 
         /**
@@ -95,10 +232,29 @@ namespace webpp {
          */
         [[nodiscard]] constexpr bool
         contains(stl::basic_string_view<CharT> const& _cs) const noexcept {
-            for (auto const& c : _cs)
-                if (!contains(c))
-                    return false;
-            return true;
+            return find<false>(_cs, 0) == stl::basic_string_view<CharT>::npos;
+        }
+
+        /**
+         * The position of the first char of the string, at or after "pos",
+         * that is in the set; npos if there's none. Like find_first_of of the
+         * string_view, but with the bitmap, and vectorized for the char
+         * strings (see vectorized_find).
+         */
+        [[nodiscard]] constexpr stl::size_t
+        find_first_in(stl::basic_string_view<CharT> str,
+                      stl::size_t pos = 0) const noexcept {
+            return find<true>(str, pos);
+        }
+
+        /**
+         * The position of the first char of the string, at or after "pos",
+         * that is not in the set; npos if all of them are.
+         */
+        [[nodiscard]] constexpr stl::size_t
+        find_first_not_in(stl::basic_string_view<CharT> str,
+                          stl::size_t pos = 0) const noexcept {
+            return find<false>(str, pos);
         }
 
         [[nodiscard]] constexpr auto string_view() const noexcept {
@@ -144,10 +300,11 @@ namespace webpp {
     constexpr auto charset() noexcept {
         constexpr auto the_size =
           static_cast<stl::size_t>(Last) - static_cast<stl::size_t>(First) + 1;
-        charset_t<CharT, the_size> data;
-        for (auto it = First; it != Last + 1; ++it)
-            data[it - First] = it;
-        return data;
+        return []<stl::size_t... I>(stl::index_sequence<I...>) {
+            return charset_t<CharT, the_size>{
+              static_cast<CharT>(First + static_cast<CharT>(I))...};
+        }
+        (stl::make_index_sequence<the_size>());
     }
 
     // TODO: add non-constexpr (or constexpr if you can) charset(first, last) as well
@@ -181,4 +338,7 @@ namespace webpp {
     template <typename CharT = char>
     constexpr auto ALPHA_DIGIT = charset<CharT>(ALPHA<CharT>, DIGIT<CharT>);
 } // namespace webpp
+
+#undef WEBPP_CHARSET_SCANNER_WIDTH
+
 #endif // CHARSET_H
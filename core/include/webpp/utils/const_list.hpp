@@ -2,136 +2,94 @@
 #define WEBPP_CONST_LIST_H
 
 // Created by moisrex on 11/28/19.
+#include <cstddef>
 #include <type_traits>
-#include <typeinfo>
 #include <utility>
 
 namespace webpp {
 
-    //    template <template <typename, typename> class LT, typename LType,
-    //              typename LNextType>
-    //    struct const_list_iterator {
-    //        using type = LT<LType, LNextType>;
-    //
-    //        void const* ptr;
-    //
-    //        constexpr const_list_iterator(type const* const ptr = nullptr)
-    //        noexcept
-    //            : ptr(ptr) {}
-    //
-    //        constexpr auto const* pointer() const noexcept {
-    //            return static_cast<type const*>(ptr);
-    //        }
-    //
-    //        constexpr auto& operator++() noexcept {
-    //            ptr = ptr && !std::is_void_v<pointer()>
-    //                      ? std::addressof(pointer()->next())
-    //                      : nullptr;
-    //            return *this;
-    //        }
-    //
-    //        template <template <typename, typename> class NT, typename NType,
-    //                  typename NNextType>
-    //        constexpr bool
-    //        operator==(const_list_iterator<NT, NType, NNextType> const& iter)
-    //        const
-    //            noexcept {
-    //            if (pointer() == nullptr && iter.pointer() == nullptr)
-    //                return true;
-    //            if constexpr (std::is_convertible_v<LT<LType, LNextType>,
-    //                                                NT<NType, NNextType>>) {
-    //                return *pointer() == *iter.pointer();
-    //            } else {
-    //                return false;
-    //            }
-    //        }
-    //
-    //        template <template <typename, typename> class NT, typename NType,
-    //                  typename NNextType>
-    //        constexpr bool
-    //        operator!=(const_list_iterator<NT, NType, NNextType> const& iter)
-    //        const
-    //            noexcept {
-    //            return !operator==<NT, NType, NNextType>(iter.pointer());
-    //        }
-    //
-    //        constexpr LType operator*() const noexcept {
-    //            if constexpr (!std::is_void_v<LType>) {
-    //                if (ptr) {
-    //                    return pointer()->value();
-    //                }
-    //            }
-    //            return LType{};
-    //        }
-    //
-    //        constexpr auto operator-> () const noexcept
-    //            -> decltype(&pointer()->value()) {
-    //            if constexpr (!std::is_void_v<LType>) {
-    //                if (ptr) {
-    //                    return &pointer()->value();
-    //                }
-    //            }
-    //            return nullptr;
-    //        }
-    //    };
-
-    template <typename ValueType>
-    struct const_list_value {
-        using type = std::decay_t<ValueType>;
-
-        type _value;
-
-        constexpr explicit const_list_value(type value) noexcept
-          : _value(std::move(value)) {
-        }
+    /**
+     * Each value of the const_list is one of these; the index makes them
+     * unique even if the types are the same.
+     */
+    template <std::size_t Index, typename Type>
+    struct const_list_item {
+        Type value;
     };
 
-    template <>
-    struct const_list_value<void> {
-        constexpr const_list_value() noexcept = default;
-    };
+    template <std::size_t Index, typename Type>
+    [[nodiscard]] constexpr Type const&
+    get(const_list_item<Index, Type> const& item) noexcept {
+        return item.value;
+    }
 
-    template <typename ValueType>
-    struct const_list_next_value {
-        using type = std::decay_t<ValueType>;
+    template <typename Indices, typename... Type>
+    struct const_list_items;
 
-        type _next;
+    /**
+     * All of the values, side by side; unlike std::tuple (which is a chain of
+     * bases in libstdc++) it's flat, so a list of N values is N bases and
+     * nothing is instantiated recursively.
+     */
+    template <std::size_t... Index, typename... Type>
+    struct const_list_items<std::index_sequence<Index...>, Type...>
+      : const_list_item<Index, Type>... {
 
-        constexpr explicit const_list_next_value(type next) noexcept
-          : _next(std::move(next)) {
-        }
-    };
-
-    template <>
-    struct const_list_next_value<void> {
-        constexpr const_list_next_value() noexcept = default;
-    };
+        constexpr const_list_items() noexcept = default;
 
-    template <typename Type = void, typename NextType = void>
-    class const_list : public const_list_value<Type>,
-                       public const_list_next_value<NextType> {
-      public:
-        // static_assert(std::negation_v<std::is_void<Type>>, "Type cannot be
-        // void");
+        constexpr explicit const_list_items(Type... value) noexcept
+          requires(sizeof...(Type) != 0)
+          : const_list_item<Index, Type>{std::move(value)}... {
+        }
 
-        using type         = Type;
-        using next_type    = NextType;
-        using value_t      = const_list_value<Type>;
-        using next_value_t = const_list_next_value<NextType>;
-        //        using iterator = const_list_iterator<const_list, Type,
-        //        NextType>; using const_iterator = iterator;
+        /**
+         * Call the callable with all the values
+         */
+        template <typename Callable>
+        constexpr decltype(auto) apply(Callable&& callable) const noexcept {
+            return callable(
+              static_cast<const_list_item<Index, Type> const&>(*this).value...);
+        }
 
-        constexpr explicit const_list() noexcept = default;
+        template <typename Callable>
+        constexpr decltype(auto) apply(Callable&& callable) noexcept {
+            return callable(
+              static_cast<const_list_item<Index, Type>&>(*this).value...);
+        }
+    };
 
-        constexpr explicit const_list(type value) noexcept
-          : value_t(std::move(value)) {
+    /**
+     * A list of values of different types that can be used in constant
+     * expressions (the routes, for example).
+     *
+     * Getting one of the values is a cast to its base, and going through them
+     * is a fold expression; neither one of them recurses, either at compile
+     * time or at run time.
+     */
+    template <typename... Type>
+    class const_list {
+        template <typename... T>
+        friend class const_list;
+
+        using items_type =
+          const_list_items<std::index_sequence_for<Type...>, Type...>;
+
+        items_type items;
+
+        template <std::size_t... I>
+        [[nodiscard]] constexpr auto
+        next_of(std::index_sequence<I...>) const noexcept {
+            return const_list<
+              std::remove_cvref_t<decltype(get<I + 1>(items))>...>{
+              get<I + 1>(items)...};
         }
 
-        template <typename T,
-                  typename = std::enable_if_t<std::negation_v<std::is_void<T>>>>
-        constexpr const_list(type value, T next) noexcept
-          : value_t(std::move(value)),
-            next_value_t(std::move(next)) {
+      public:
+        constexpr const_list() noexcept = default;
+
+        constexpr explicit const_list(Type... value) noexcept
+          requires(sizeof...(Type) != 0)
+          : items(std::move(value)...) {
         }
 
         constexpr const_list(const_list const& v) noexcept = default;
@@ -140,63 +98,35 @@ namespace webpp {
 
         constexpr const_list& operator=(const_list const& v) noexcept = default;
 
-        const_list& operator=(type const& _value) noexcept {
-            value_t::_value = _value;
-            return *this;
-        }
+        constexpr const_list& operator=(const_list&&) noexcept = default;
 
-        const_list& operator=(type&& _value) noexcept {
-            value_t::_value = _value;
-            return *this;
+        /**
+         * The first value
+         */
+        [[nodiscard]] constexpr auto const& value() const noexcept {
+            return get<0>(items);
         }
 
-        constexpr const_list& operator=(const_list&&) noexcept = default;
-
-        constexpr auto const& next() const noexcept {
-            return next_value_t::_next;
+        /**
+         * The list of the values after the first one
+         */
+        [[nodiscard]] constexpr auto next() const noexcept {
+            static_assert(sizeof...(Type) != 0, "An empty list has no next.");
+            return next_of(std::make_index_sequence<sizeof...(Type) - 1>{});
         }
 
-        constexpr auto const& value() const noexcept {
-            return value_t::_value;
+        template <std::size_t I>
+        [[nodiscard]] constexpr auto const& at() const noexcept {
+            return get<I>(items);
         }
 
         template <typename NewValueType>
         [[nodiscard]] constexpr auto append(NewValueType&& v) const noexcept {
-            using nt  = std::decay_t<NewValueType>;
-            using lnt = const_list<nt>;
-
-            if constexpr (std::is_void_v<next_type>) {
-                // this part will only execute when the "next_type" is
-                // void
-
-                // the first way (A<X, void> and B<Y, void> === A<X, B<Y, void>>
-                return const_list<Type, lnt>{value(), lnt{std::forward<nt>(v)}};
-            } else {
-                // this means this function has a "next" const_list already,
-                // so it goes to the next's next const_list
-                // this way we recursively create a const_list type and return
-                // it.
-                auto n = next().append(std::forward<nt>(v));
-                return const_list<Type, decltype(n)>{value(), n};
-            }
-        }
-
-        // [[nodiscard]] constexpr auto& operator[](std::size_t index) const
-        // noexcept {
-        //     if (index == 0)
-        //         return *this;
-        //     if constexpr (!std::is_void_v<next_type>)
-        //         return next_value_t::next[index - 1];
-        //     else
-        //         return *this;
-        // }
-
-        template <std::size_t I>
-        [[nodiscard]] constexpr auto& at() const noexcept {
-            if constexpr (I != 0 && !std::is_void_v<next_type>)
-                return next().template at<I - 1>();
-            else
-                return *this;
+            using nt = std::decay_t<NewValueType>;
+            return items.apply([&](auto const&... value) {
+                return const_list<Type..., nt>{
+                  value..., nt{std::forward<NewValueType>(v)}};
+            });
         }
 
         template <typename NewValueType>
@@ -205,32 +135,8 @@ namespace webpp {
             return append(std::forward<NewValueType>(v));
         }
 
-        //        [[nodiscard]] constexpr auto begin() const noexcept {
-        //            return iterator(this);
-        //        }
-        //
-        //        [[nodiscard]] constexpr auto end() const noexcept {
-        //            return iterator(nullptr);
-        //        }
-        //
-        //        [[nodiscard]] constexpr auto cbegin() const noexcept {
-        //            return const_iterator(this);
-        //        }
-        //
-        //        [[nodiscard]] constexpr auto cend() const noexcept {
-        //            return const_iterator(nullptr);
-        //        }
-
-        [[nodiscard]] constexpr std::size_t size() const noexcept {
-            if constexpr (std::is_void_v<Type>) {
-                return 0;
-            } else if constexpr (std::is_void_v<NextType>) {
-                return 1;
-            } else if constexpr (std::is_base_of_v<const_list, NextType>) {
-                return 1 + next().size();
-            } else {
-                return 2;
-            }
+        [[nodiscard]] static constexpr std::size_t size() noexcept {
+            return sizeof...(Type);
         }
 
         /**
@@ -240,12 +146,9 @@ namespace webpp {
          */
         template <typename Callable>
         constexpr void for_each(Callable const& callable) const noexcept {
-            if constexpr (!std::is_void_v<type>) {
-                callable(value());
-            }
-            if constexpr (!std::is_void_v<next_type>) {
-                next().for_each(callable);
-            }
+            items.apply([&](auto const&... value) {
+                (callable(value), ...);
+            });
         }
 
         /**
@@ -255,12 +158,9 @@ namespace webpp {
          */
         template <typename Callable>
         void for_each(Callable& callable) noexcept {
-            if constexpr (!std::is_void_v<type>) {
-                callable(value());
-            }
-            if constexpr (!std::is_void_v<next_type>) {
-                next().for_each(callable);
-            }
+            items.apply([&](auto&... value) {
+                (callable(value), ...);
+            });
         }
 
         /**
@@ -272,13 +172,10 @@ namespace webpp {
          */
         template <typename Callable>
         constexpr void do_once(Callable const& callable) const noexcept {
-            if constexpr (!std::is_void_v<type>) {
-                if (callable(value()))
-                    return; // don't check the next ones
-            }
-            if constexpr (!std::is_void_v<next_type>) {
-                next().do_once(callable);
-            }
+            // "||" doesn't check the next ones after the first "true"
+            items.apply([&](auto const&... value) {
+                (static_cast<bool>(callable(value)) || ...);
+            });
         }
 
         /**
@@ -293,12 +190,9 @@ namespace webpp {
         constexpr RetType reduce(Callable const& callable,
                                  RetType const&  first_element) const noexcept {
             auto v = first_element;
-            if constexpr (!std::is_void_v<type>) {
-                v = callable(v, value());
-            }
-            if constexpr (!std::is_void_v<next_type>) {
-                v = next().reduce(callable, v);
-            }
+            items.apply([&](auto const&... value) {
+                ((v = callable(v, value)), ...);
+            });
             return v;
         }
 
@@ -311,53 +205,46 @@ namespace webpp {
          */
         template <typename T>
         constexpr bool has(T const& _value) const noexcept {
-            if constexpr (!std::is_void_v<type> &&
-                          std::is_convertible_v<type, T>) {
-                if (value() == _value)
-                    return true;
-            }
-            if constexpr (!std::is_void_v<next_type>) {
-                if constexpr (std::is_convertible_v<next_type, T>) {
-                    if (value() == _value)
-                        return true;
+            auto const is_it = [&](auto const& value) {
+                if constexpr (std::is_convertible_v<
+                                std::decay_t<decltype(value)>, T>) {
+                    return value == _value;
+                } else {
+                    return false;
                 }
-                return next().has(_value);
-            }
-            return false;
+            };
+            return items.apply([&](auto const&... value) {
+                return (is_it(value) || ...);
+            });
         }
 
-        template <typename NType, typename NNextType>
+        template <typename... NType>
         constexpr bool
-        operator==(const_list<NType, NNextType> const& l) const noexcept {
-            if constexpr (!std::is_same_v<type, NType>) {
-                if (value() != l.value())
-                    return false;
-                if constexpr (!std::is_void_v<next_type>) {
-                    return next().operator==(l);
-                } else {
-                    return true;
-                }
-            } else {
+        operator==(const_list<NType...> const& l) const noexcept {
+            if constexpr (sizeof...(Type) != sizeof...(NType)) {
                 return false;
+            } else {
+                return items.apply([&](auto const&... value) {
+                    return l.items.apply([&](auto const&... other) {
+                        return ((value == other) && ...);
+                    });
+                });
             }
         }
 
-        template <typename NType, typename NNextType>
+        template <typename... NType>
         constexpr bool
-        operator!=(const_list<NType, NNextType> const& l) const noexcept {
-            return !operator==<NType, NNextType>(l);
+        operator!=(const_list<NType...> const& l) const noexcept {
+            return !operator==(l);
         }
     };
 
-    //    template <typename Type, typename NextType>
-    //    constexpr auto begin(const_list<Type, NextType> const& l) noexcept {
-    //        return l.begin();
-    //    }
+    template <typename... Type>
+    const_list(Type...) -> const_list<Type...>;
 
-    template <typename First, typename... Args>
-    constexpr auto make_const_list(First&& first, Args&&... args) noexcept {
-        return (const_list(std::forward<First>(first)) + ... +
-                std::forward<Args>(args));
+    template <typename... Args>
+    constexpr auto make_const_list(Args&&... args) noexcept {
+        return const_list<std::decay_t<Args>...>{std::forward<Args>(args)...};
     }
 } // namespace webpp
 #endif // WEBPP_CONST_LIST_H
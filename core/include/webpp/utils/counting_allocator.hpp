@@ -0,0 +1,70 @@
+#ifndef WEBPP_UTILS_COUNTING_ALLOCATOR_H
+#define WEBPP_UTILS_COUNTING_ALLOCATOR_H
+
+#include "../std/std.hpp"
+
+#include <cstddef>
+#include <memory>
+
+namespace webpp {
+
+    /**
+     * The allocations of the counting_allocators of a thread
+     */
+    struct allocation_stats {
+        stl::size_t allocations   = 0;
+        stl::size_t deallocations = 0;
+        stl::size_t bytes         = 0; // allocated
+
+        /**
+         * The stats of this thread; take a copy before and after, and subtract them
+         */
+        [[nodiscard]] static allocation_stats& local() noexcept {
+            thread_local allocation_stats stats;
+            return stats;
+        }
+
+        [[nodiscard]] constexpr allocation_stats operator-(allocation_stats const& other) const noexcept {
+            return {allocations - other.allocations, deallocations - other.deallocations,
+                    bytes - other.bytes};
+        }
+    };
+
+    /**
+     * The std::allocator, but it counts its allocations into the stats of the thread; it's for the
+     * tests and the benchmarks that want to see what the strings of the traits allocate (see
+     * std_counting_traits):
+     *   auto const before = allocation_stats::local();
+     *   ...
+     *   EXPECT_EQ((allocation_stats::local() - before).allocations, 0);
+     */
+    template <typename T>
+    struct counting_allocator {
+        using value_type = T;
+
+        constexpr counting_allocator() noexcept = default;
+
+        template <typename U>
+        constexpr counting_allocator(counting_allocator<U> const&) noexcept {}
+
+        [[nodiscard]] T* allocate(stl::size_t count) {
+            auto& stats = allocation_stats::local();
+            stats.allocations++;
+            stats.bytes += count * sizeof(T);
+            return stl::allocator<T>{}.allocate(count);
+        }
+
+        void deallocate(T* ptr, stl::size_t count) noexcept {
+            allocation_stats::local().deallocations++;
+            stl::allocator<T>{}.deallocate(ptr, count);
+        }
+
+        template <typename U>
+        [[nodiscard]] constexpr bool operator==(counting_allocator<U> const&) const noexcept {
+            return true;
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_COUNTING_ALLOCATOR_H
@@ -0,0 +1,194 @@
+#ifndef WEBPP_UTILS_DEADLINE_H
+#define WEBPP_UTILS_DEADLINE_H
+
+#include "../std/optional.hpp"
+#include "../std/std.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+/**
+ * The deadlines and the cancellation of the requests. Each context carries a
+ * cancellation_token (see basic_context::cancellation); the router gives it
+ * the request's deadline (see deadline_options), and whatever does the work
+ * of the request later (the coroutine routes, the thread_pool tasks, the
+ * calls to the upstream services) checks it and drops the work that nobody
+ * is waiting for anymore:
+ *
+ *   pool.post(ctx.cancellation, [] { ... }); // skipped if it's too late
+ *   co_await db.query(...);
+ *   if (ctx.is_cancelled())
+ *       co_return stl::nullopt;                 // the router answers with a 503
+ */
+namespace webpp {
+
+    using deadline_clock = stl::chrono::steady_clock;
+
+    /**
+     * A deadline, and a flag that someone else (a cancellation_source) can
+     * raise; it's cheap to copy, and the default one is never cancelled and
+     * doesn't allocate anything.
+     */
+    class cancellation_token {
+        using flag_ptr = stl::shared_ptr<stl::atomic<bool> const>;
+
+        deadline_clock::time_point deadline_at = deadline_clock::time_point::max();
+        flag_ptr                   flag{};
+
+        friend class cancellation_source;
+
+        cancellation_token(deadline_clock::time_point at, flag_ptr _flag) noexcept
+          : deadline_at{at},
+            flag{stl::move(_flag)} {}
+
+      public:
+        constexpr cancellation_token() noexcept = default;
+
+        [[nodiscard]] static cancellation_token at(deadline_clock::time_point deadline) noexcept {
+            return {deadline, {}};
+        }
+
+        [[nodiscard]] static cancellation_token after(deadline_clock::duration timeout) noexcept {
+            return at(deadline_clock::now() + timeout);
+        }
+
+        [[nodiscard]] bool has_deadline() const noexcept {
+            return deadline_at != deadline_clock::time_point::max();
+        }
+
+        [[nodiscard]] deadline_clock::time_point deadline() const noexcept {
+            return deadline_at;
+        }
+
+        /**
+         * The time that is left; zero if it has passed, and the max if there's no deadline
+         */
+        [[nodiscard]] deadline_clock::duration remaining(deadline_clock::time_point now = deadline_clock::now()) const
+          noexcept {
+            if (!has_deadline())
+                return deadline_clock::duration::max();
+            return now >= deadline_at ? deadline_clock::duration::zero() : deadline_at - now;
+        }
+
+        /**
+         * Whether it's cancelled, or its deadline has passed; the clock is only
+         * read if there's a deadline.
+         */
+        [[nodiscard]] bool is_cancelled() const noexcept {
+            if (flag && flag->load(stl::memory_order_acquire))
+                return true;
+            return has_deadline() && deadline_clock::now() >= deadline_at;
+        }
+
+        /**
+         * The same token with the earlier of the two deadlines; the calls that
+         * have their own timeouts shorten the request's deadline with it.
+         */
+        [[nodiscard]] cancellation_token with_deadline(deadline_clock::time_point deadline) const {
+            return {stl::min(deadline_at, deadline), flag};
+        }
+
+        [[nodiscard]] cancellation_token with_timeout(deadline_clock::duration timeout) const {
+            return with_deadline(deadline_clock::now() + timeout);
+        }
+    };
+
+    /**
+     * The owner of the flag of the tokens; the interfaces cancel it when the
+     * client goes away, and the user can cancel it for any other reason.
+     */
+    class cancellation_source {
+        stl::shared_ptr<stl::atomic<bool>> flag = stl::make_shared<stl::atomic<bool>>(false);
+
+      public:
+        [[nodiscard]] cancellation_token token(
+          deadline_clock::time_point deadline = deadline_clock::time_point::max()) const {
+            return {deadline, flag};
+        }
+
+        void cancel() noexcept {
+            flag->store(true, stl::memory_order_release);
+        }
+
+        [[nodiscard]] bool is_cancelled() const noexcept {
+            return flag->load(stl::memory_order_acquire);
+        }
+    };
+
+    /**
+     * Where the requests get their deadlines from: a fixed timeout (from the
+     * config), and the timeout that the upstream (a proxy, or the service that
+     * calls us) has put in a header, whichever is shorter.
+     */
+    struct deadline_options {
+        // zero means no deadline, unless the header has one
+        stl::chrono::milliseconds timeout{0};
+
+        // the most that the header can ask for; zero means there's no limit
+        stl::chrono::milliseconds max_timeout{0};
+
+        // the header of the upstream's timeout (see parse_timeout); empty means it's not looked at
+        stl::string_view header = "Request-Timeout";
+    };
+
+    /**
+     * Parse a timeout in the format of the gRPC's "grpc-timeout": up to 8
+     * digits and a unit (H, M, S, m, u, n); the digits alone are seconds.
+     * @returns nullopt if it's not valid
+     */
+    [[nodiscard]] constexpr stl::optional<deadline_clock::duration> parse_timeout(stl::string_view str) noexcept {
+        using namespace stl::chrono;
+
+        stl::uint64_t value  = 0;
+        stl::size_t   digits = 0;
+        for (; digits < str.size() && str[digits] >= '0' && str[digits] <= '9'; digits++)
+            value = value * 10 + static_cast<stl::uint64_t>(str[digits] - '0');
+        if (digits == 0 || digits > 8 || str.size() - digits > 1)
+            return stl::nullopt;
+        auto const count = static_cast<stl::int64_t>(value);
+        // 8 digits of hours don't fit in the nanoseconds
+        auto const saturate = [count]<typename Unit>(Unit) constexpr noexcept -> deadline_clock::duration {
+            if (count > duration_cast<Unit>(deadline_clock::duration::max()).count())
+                return deadline_clock::duration::max();
+            return duration_cast<deadline_clock::duration>(Unit{count});
+        };
+        switch (digits == str.size() ? 'S' : str.back()) {
+            case 'H': return saturate(hours{});
+            case 'M': return saturate(minutes{});
+            case 'S': return saturate(seconds{});
+            case 'm': return saturate(milliseconds{});
+            case 'u': return saturate(microseconds{});
+            case 'n': return saturate(nanoseconds{});
+            default: return stl::nullopt;
+        }
+    }
+
+    /**
+     * The deadline of a request that has come now, from the options and the
+     * value of the header (empty if it doesn't have it); max if it has none.
+     */
+    [[nodiscard]] inline deadline_clock::time_point request_deadline(deadline_options const& options,
+                                                                     stl::string_view        header_value,
+                                                                     deadline_clock::time_point now =
+                                                                       deadline_clock::now()) noexcept {
+        auto timeout = deadline_clock::duration::max();
+        if (options.timeout.count() > 0)
+            timeout = options.timeout;
+        if (!header_value.empty()) {
+            if (auto upstream = parse_timeout(header_value); upstream) {
+                if (options.max_timeout.count() > 0)
+                    upstream = stl::min<deadline_clock::duration>(*upstream, options.max_timeout);
+                timeout = stl::min(timeout, *upstream);
+            }
+        }
+        if (timeout >= deadline_clock::time_point::max() - now)
+            return deadline_clock::time_point::max();
+        return now + timeout;
+    }
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_DEADLINE_H
@@ -4,6 +4,17 @@
 #define WEBPP_DEBOUNCE_H
 
 #include "functional.hpp"
+#include "timing_wheel.hpp"
+
+#include <any>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <type_traits>
 
 namespace webpp {
     /**
@@ -67,6 +78,18 @@ namespace webpp {
 
     /**
      * Debounce type implementation: leading
+     *
+     * For the void callables it's thread-safe without a lock: the time of the
+     * last call is one atomic, and of the threads that call it at the same
+     * time, only the one that moves that time forward (a CAS) calls the
+     * callable; the others return right away, so it can be shared by the io
+     * threads, say to throttle the logs of a hot error. If the callable
+     * throws, the window is given back to the next caller.
+     *
+     * The ones that return something go through a mutex instead, because the
+     * others have to get the result of the last call: they wait for the one
+     * that's running, and until a call returns (say the first one threw),
+     * the next caller makes the call itself.
      * @tparam Callable
      * @tparam Rep
      * @tparam Period
@@ -78,62 +101,185 @@ namespace webpp {
         using ctors = debounce_ctors<Callable, Rep, Period, Clock>;
 
       protected:
-        mutable std::chrono::time_point<Clock> last_invoke_time;
+        using ticks_type = typename Clock::duration::rep;
+
+        // the time of the last call, in the ticks of the clock; never_called
+        // until the first one, whatever the epoch of the clock is
+        static constexpr ticks_type never_called =
+          std::numeric_limits<ticks_type>::min();
+        mutable std::atomic<ticks_type> last_invoke_time{never_called};
+
+        // the result of the last call, guarded by res_lock; empty until one
+        // returns
+        mutable std::mutex res_lock;
+        mutable std::any   res;
+
+        /**
+         * True for the one thread that calls it now
+         */
+        [[nodiscard]] bool claim() const noexcept {
+            using duration = typename Clock::duration;
+            auto const now = Clock::now().time_since_epoch().count();
+            auto const gap =
+              std::chrono::duration_cast<duration>(ctors::interval()).count();
+            auto last = last_invoke_time.load(std::memory_order_relaxed);
+            while (last == never_called || now - last > gap) {
+                if (last_invoke_time.compare_exchange_weak(
+                      last, now, std::memory_order_relaxed))
+                    return true;
+            }
+            return false;
+        }
+
+        template <typename Call>
+        void call_void(Call&& call) const
+          noexcept(std::is_nothrow_invocable_v<Call>) {
+            if (!claim())
+                return;
+            if constexpr (std::is_nothrow_invocable_v<Call>) {
+                call();
+            } else {
+                try {
+                    call();
+                } catch (...) {
+                    last_invoke_time.store(never_called,
+                                           std::memory_order_relaxed);
+                    throw;
+                }
+            }
+        }
 
-        // TODO: convert this to "void*"; but benchmark the performance first.
-        // and even if it's possible, make the whole thing "constexpr" friendly.
-        mutable std::any res;
+        template <typename RetType, typename Call>
+        RetType call_shared(Call&& call) const {
+            std::lock_guard<std::mutex> lock{res_lock};
+            auto* last = std::any_cast<RetType>(&res);
+            if (!claim() && last)
+                return *last;
+            // reuses the storage of the last result when there's one
+            if (last)
+                *last = call();
+            else
+                last = &res.template emplace<RetType>(call());
+            return *last;
+        }
 
       public:
         using ctors::ctors;
 
         template <typename... Args>
         auto operator()(Args&&... args) noexcept(
-          std::is_nothrow_invocable_v<Callable, Args...>) {
+          std::is_nothrow_invocable_v<Callable, Args...> &&
+          std::is_void_v<std::invoke_result_t<Callable, Args...>>) {
             using RetType = std::invoke_result_t<Callable, Args...>;
 
+            auto call = [&]() noexcept(
+                          std::is_nothrow_invocable_v<Callable, Args...>)
+              -> RetType {
+                return Callable::operator()(std::forward<Args>(args)...);
+            };
             if constexpr (std::is_void_v<RetType>) {
-                if ((Clock::now() - last_invoke_time) > ctors::interval()) {
-                    Callable::operator()(std::forward<Args>(args)...);
-                    last_invoke_time = Clock::now();
-                }
+                call_void(call);
             } else {
-                if ((Clock::now() - last_invoke_time) > ctors::interval()) {
-                    res = Callable::operator()(std::forward<Args>(args)...);
-                    last_invoke_time = Clock::now();
-                    return std::any_cast<RetType>(res);
-                } else {
-                    return std::any_cast<RetType>(res);
-                }
+                return call_shared<RetType>(call);
             }
         }
 
-
         template <typename... Args>
-        auto operator()(Args&&... args) const
-          noexcept(std::is_nothrow_invocable_v<Callable, Args...>) {
-            using RetType = std::invoke_result_t<Callable, Args...>;
-
+        auto operator()(Args&&... args) const noexcept(
+          std::is_nothrow_invocable_v<Callable const, Args...> &&
+          std::is_void_v<std::invoke_result_t<Callable const, Args...>>) {
+            using RetType = std::invoke_result_t<Callable const, Args...>;
+
+            auto call = [&]() noexcept(
+                          std::is_nothrow_invocable_v<Callable const, Args...>)
+              -> RetType {
+                return Callable::operator()(std::forward<Args>(args)...);
+            };
             if constexpr (std::is_void_v<RetType>) {
-                if ((Clock::now() - last_invoke_time) > ctors::interval()) {
-                    Callable::operator()(std::forward<Args>(args)...);
-                    last_invoke_time = Clock::now();
-                }
+                call_void(call);
             } else {
-                if ((Clock::now() - last_invoke_time) > ctors::interval()) {
-                    res = Callable::operator()(std::forward<Args>(args)...);
-                    last_invoke_time = Clock::now();
-                    return std::any_cast<RetType>(res);
-                } else {
-                    return std::any_cast<RetType>(res);
-                }
+                return call_shared<RetType>(call);
             }
         }
     };
 
 
+    namespace details {
+
+        /**
+         * The arguments of a callable, decayed, to be kept for a later call;
+         * void if they're not known (a template or an overloaded operator())
+         */
+        template <typename... Params>
+        struct call_arguments {
+            using tuple_type = std::tuple<std::decay_t<Params>...>;
+
+            template <typename Func>
+            static void apply(Func&& func, tuple_type& values) {
+                std::apply(
+                  [&func](auto&... value) {
+                      func(std::forward<Params>(value)...);
+                  },
+                  values);
+            }
+        };
+
+        template <typename T>
+        struct arguments_of {
+            using type = void;
+        };
+
+        template <typename R, typename... Params>
+        struct arguments_of<R(Params...)> {
+            using type = call_arguments<Params...>;
+        };
+
+        template <typename R, typename... Params>
+        struct arguments_of<R(Params...) noexcept>
+          : arguments_of<R(Params...)> {};
+
+        template <typename R, typename C, typename... Params>
+        struct arguments_of<R (C::*)(Params...)>
+          : arguments_of<R(Params...)> {};
+
+        template <typename R, typename C, typename... Params>
+        struct arguments_of<R (C::*)(Params...) const>
+          : arguments_of<R(Params...)> {};
+
+        template <typename R, typename C, typename... Params>
+        struct arguments_of<R (C::*)(Params...) noexcept>
+          : arguments_of<R(Params...)> {};
+
+        template <typename R, typename C, typename... Params>
+        struct arguments_of<R (C::*)(Params...) const noexcept>
+          : arguments_of<R(Params...)> {};
+
+        template <typename C>
+        requires requires { &C::operator(); }
+        struct arguments_of<C> : arguments_of<decltype(&C::operator())> {};
+
+        // the wrappers of make_inheritable
+        template <typename F>
+        struct arguments_of<callable_function<F>>
+          : arguments_of<std::remove_pointer_t<F>> {};
+
+        template <typename C>
+        struct arguments_of<callable_as_field<C>>
+          : arguments_of<std::remove_cv_t<C>> {};
+
+    } // namespace details
+
     /**
-     * This class will be async trailing implementation of the debounce class
+     * Debounce type implementation: trailing
+     *
+     * The callable is called once the interval passes without another call,
+     * with the arguments of the last call; each call only resets a timer of
+     * the timer service (any TimerService, like common::timer_service, the
+     * timing wheel of an io_context), so nothing is spawned per call. The
+     * arguments are kept in a tuple of the parameters of the callable, so a
+     * call doesn't allocate; only a generic callable, whose parameters aren't
+     * known, keeps them in a std::function. It's used from the thread of that
+     * service. Without a timer service, the pending call waits for flush.
      */
     template <typename Callable, typename Rep, typename Period, typename Clock>
     struct debounce_impl<Callable, debounce_type::trailing, Rep, Period, Clock>
@@ -141,65 +287,147 @@ namespace webpp {
         using ctors = debounce_ctors<Callable, Rep, Period, Clock>;
 
       protected:
-        std::queue<std::thread> trs;
-        std::atomic<bool>       done = false;
-
-        template <typename RetType, typename... Args>
-        std::future<RetType> async_run_later(Args&&... args) noexcept(
-          std::is_nothrow_invocable_v<Callable, Args...>) {
-            std::this_thread::sleep_for(ctors::interval());
-            return flush(std::forward<Args>(args)...);
+        using arguments = typename details::arguments_of<Callable>::type;
+
+        static constexpr bool typed_arguments = !std::is_void_v<arguments>;
+
+        template <typename Args>
+        struct pending_call {
+            using type = std::optional<typename Args::tuple_type>;
+        };
+
+        template <typename Args>
+        requires std::is_void_v<Args>
+        struct pending_call<Args> {
+            using type = std::function<void()>;
+        };
+
+        timer_service_ref timers{};
+        timer_node        timer;
+
+        // the arguments of the last call
+        typename pending_call<arguments>::type last_call{};
+
+        template <typename... Args>
+        void defer(Args&&... args) {
+            if constexpr (typed_arguments) {
+                last_call.emplace(std::forward<Args>(args)...);
+            } else {
+                last_call = [this,
+                             ... values = std::forward<Args>(args)]() mutable {
+                    Callable::operator()(std::move(values)...);
+                };
+            }
+            if (timers)
+                timers.schedule(timer, ctors::interval());
         }
 
       public:
-        using ctors::debounce_ctors;
+        using ctors::ctors;
 
-        template <typename RetType, typename... Args>
-        std::future<RetType> operator()(Args&&... args) noexcept(
-          std::is_nothrow_invocable_v<Callable, Args...>) {
-            trs.emplace(&debounce_impl::async_run_later, *this,
-                        std::forward<Args>(args)...);
+        template <TimerService Service, typename TRep, typename TPeriod, typename... Args>
+        debounce_impl(Service&                             service,
+                      std::chrono::duration<TRep, TPeriod> interval,
+                      Args&&... args)
+          : ctors{
+              std::chrono::duration_cast<typename ctors::Interval>(interval),
+              std::forward<Args>(args)...},
+            timers{service} {
+            timer.on_expire = [this] {
+                flush();
+            };
         }
 
+        debounce_impl(debounce_impl const&) = delete;
+
         ~debounce_impl() noexcept {
-            // cancel everything and wait for the thread to join
-            done.store(true, std::memory_order_relaxed);
-
-            // join all the threads
-            while (!trs.empty()) {
-                auto tr = std::move(trs.front());
-                if (tr.joinable())
-                    tr.join();
-                trs.pop();
-            }
+            cancel();
+        }
+
+        template <typename... Args>
+        void operator()(Args&&... args) {
+            defer(std::forward<Args>(args)...);
         }
 
         /**
-         * Cancel the operation
-         * @param value
+         * Drop the pending call
          */
         void cancel() noexcept {
-            done.store(true, std::memory_order_relaxed);
+            if (timers)
+                timers.cancel(timer);
+            last_call = {};
         }
 
         /**
-         * Call the callable now
+         * Run the pending call now, if there's one
          */
-        template <typename... Args>
-        auto flush(Args&&... args) noexcept(
-          std::is_nothrow_invocable_v<Callable, Args...>)
-          -> std::invoke_result_t<Callable, Args...> {
-            auto res = Callable::operator()(std::forward<Args>(args)...);
-            done.store(true, std::memory_order_relaxed);
-            return res;
+        void flush() {
+            if (timers)
+                timers.cancel(timer);
+            if (!last_call)
+                return;
+            auto call = std::move(last_call);
+            last_call = {};
+            if constexpr (typed_arguments) {
+                arguments::apply(
+                  [this](auto&&... values) {
+                      Callable::operator()(
+                        std::forward<decltype(values)>(values)...);
+                  },
+                  *call);
+            } else {
+                call();
+            }
         }
 
         /**
-         * Check if the function is done running or not.
-         * @return true if the function is done, and false otherwise.
+         * Check if there's a call that hasn't run yet.
          */
-        bool pending() noexcept {
-            return !done.load(std::memory_order_relaxed);
+        [[nodiscard]] bool pending() const noexcept {
+            return static_cast<bool>(last_call);
+        }
+    };
+
+    /**
+     * Debounce type implementation: both
+     *
+     * The first call runs right away and opens a window of the interval; the
+     * calls in the window reset it, like the trailing ones, and the last of
+     * them runs when it closes.
+     */
+    template <typename Callable, typename Rep, typename Period, typename Clock>
+    struct debounce_impl<Callable, debounce_type::both, Rep, Period, Clock>
+      : public debounce_impl<Callable, debounce_type::trailing, Rep, Period,
+                             Clock> {
+        using trailing =
+          debounce_impl<Callable, debounce_type::trailing, Rep, Period, Clock>;
+
+      protected:
+        bool in_window = false;
+
+      public:
+        using trailing::trailing;
+
+        template <typename... Args>
+        void operator()(Args&&... args) {
+            if (in_window && (this->timer.is_scheduled() || !this->timers)) {
+                this->defer(std::forward<Args>(args)...);
+                return;
+            }
+            in_window = true;
+            Callable::operator()(std::forward<Args>(args)...);
+            if (this->timers)
+                this->timers.schedule(this->timer, this->interval());
+        }
+
+        void cancel() noexcept {
+            trailing::cancel();
+            in_window = false;
+        }
+
+        void flush() {
+            in_window = false;
+            trailing::flush();
         }
     };
 
@@ -345,6 +573,12 @@ namespace webpp {
     debounce_trailing(Callable func)
       -> debounce_trailing<decltype(func), Rep, Period, Clock>;
 
+    template <typename Callable, TimerService Service, typename Rep, typename Period>
+    debounce_trailing(Service&                           timers,
+                      std::chrono::duration<Rep, Period> interval,
+                      Callable                           func)
+      -> debounce_trailing<decltype(func), Rep, Period>;
+
 
     // both
 
@@ -362,6 +596,12 @@ namespace webpp {
     debounce_both(Callable func)
       -> debounce_both<decltype(func), Rep, Period, Clock>;
 
+    template <typename Callable, TimerService Service, typename Rep, typename Period>
+    debounce_both(Service&                           timers,
+                  std::chrono::duration<Rep, Period> interval,
+                  Callable                           func)
+      -> debounce_both<decltype(func), Rep, Period>;
+
 
     /**************************************************************************
      * Factory functions for debounce_t class
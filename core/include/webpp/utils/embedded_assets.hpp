@@ -0,0 +1,154 @@
+#ifndef WEBPP_UTILS_EMBEDDED_ASSETS_H
+#define WEBPP_UTILS_EMBEDDED_ASSETS_H
+
+#include "../std/std.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string_view>
+
+namespace webpp {
+
+    /**
+     * A file that is compiled into the binary; see cmake/embedded_assets.cmake
+     */
+    struct embedded_asset {
+        stl::string_view path;
+        stl::string_view content;
+        stl::string_view gzip{}; // empty if compressing it didn't make it smaller
+    };
+
+    namespace details {
+
+        /**
+         * FNV-1a with a seed, and a final mix so the low bits (the ones that
+         * pick the slot) depend on all of the bits
+         */
+        [[nodiscard]] constexpr stl::uint64_t asset_hash(stl::string_view str, stl::uint64_t seed) noexcept {
+            stl::uint64_t hash = 0xcbf2'9ce4'8422'2325ull ^ (seed * 0x9e37'79b9'7f4a'7c15ull);
+            for (char const c : str) {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 0x0000'0100'0000'01b3ull;
+            }
+            hash ^= hash >> 33u;
+            hash *= 0xff51'afd7'ed55'8ccdull;
+            hash ^= hash >> 33u;
+            return hash;
+        }
+
+    } // namespace details
+
+    /**
+     * A perfect hash index of the embedded assets; it's built at compile time
+     * (hash and displace): the paths are put into buckets, and each bucket
+     * gets a seed that puts its paths into the empty slots of the table. So
+     * finding an asset is two hashes and one comparison, and it never
+     * touches the file system.
+     */
+    template <stl::size_t N>
+    class embedded_asset_index {
+        static constexpr stl::size_t bucket_count = N < 4 ? 1 : N / 4;
+        static constexpr stl::size_t slot_count   = stl::bit_ceil(N * 2 < 2 ? 2 : N * 2);
+
+        stl::array<embedded_asset, N>           assets;
+        stl::array<stl::uint32_t, bucket_count> seeds{};
+        stl::array<stl::uint32_t, slot_count>   slots{}; // the index of the asset + 1; 0 is empty
+
+        [[nodiscard]] static constexpr stl::size_t bucket_of(stl::string_view path) noexcept {
+            return static_cast<stl::size_t>(details::asset_hash(path, 0) % bucket_count);
+        }
+
+        [[nodiscard]] static constexpr stl::size_t slot_of(stl::string_view path, stl::uint32_t seed) noexcept {
+            return static_cast<stl::size_t>(details::asset_hash(path, seed) & (slot_count - 1));
+        }
+
+      public:
+        /**
+         * The paths should be unique; the index can't be built otherwise (it's
+         * a compile error when it's built at compile time).
+         */
+        constexpr explicit embedded_asset_index(stl::array<embedded_asset, N> const& list) : assets{list} {
+            if constexpr (N != 0) {
+                // the assets sorted by their buckets, the big buckets first
+                stl::array<stl::size_t, bucket_count> sizes{};
+                for (auto const& asset : assets)
+                    sizes[bucket_of(asset.path)]++;
+                stl::array<stl::size_t, N> order{};
+                for (stl::size_t i = 0; i != N; i++)
+                    order[i] = i;
+                stl::sort(order.begin(), order.end(), [&](stl::size_t a, stl::size_t b) {
+                    auto const bucket_a = bucket_of(assets[a].path);
+                    auto const bucket_b = bucket_of(assets[b].path);
+                    if (sizes[bucket_a] != sizes[bucket_b])
+                        return sizes[bucket_a] > sizes[bucket_b];
+                    return bucket_a < bucket_b;
+                });
+
+                stl::array<stl::size_t, N> taken{}; // the slots of the bucket we're placing
+                for (stl::size_t first = 0; first != N;) {
+                    auto const bucket = bucket_of(assets[order[first]].path);
+                    auto const last   = first + sizes[bucket];
+                    for (stl::size_t i = first; i != last; i++)
+                        for (stl::size_t j = first; j != i; j++)
+                            if (assets[order[i]].path == assets[order[j]].path)
+                                throw "Two of the embedded assets have the same path.";
+
+                    for (stl::uint32_t seed = 1;; seed++) {
+                        bool fits = true;
+                        for (stl::size_t i = first; fits && i != last; i++) {
+                            auto const slot = slot_of(assets[order[i]].path, seed);
+                            fits            = slots[slot] == 0 &&
+                                   stl::find(taken.begin(), taken.begin() + (i - first), slot) ==
+                                     taken.begin() + (i - first);
+                            taken[i - first] = slot;
+                        }
+                        if (fits) {
+                            seeds[bucket] = seed;
+                            for (stl::size_t i = first; i != last; i++)
+                                slots[taken[i - first]] = static_cast<stl::uint32_t>(order[i] + 1);
+                            break;
+                        }
+                    }
+                    first = last;
+                }
+            }
+        }
+
+        /**
+         * The asset with this path; nullptr if there's none
+         */
+        [[nodiscard]] constexpr embedded_asset const* find(stl::string_view path) const noexcept {
+            if constexpr (N == 0) {
+                return nullptr;
+            } else {
+                auto const index = slots[slot_of(path, seeds[bucket_of(path)])];
+                if (index == 0 || assets[index - 1].path != path)
+                    return nullptr;
+                return &assets[index - 1];
+            }
+        }
+
+        [[nodiscard]] constexpr auto begin() const noexcept {
+            return assets.begin();
+        }
+
+        [[nodiscard]] constexpr auto end() const noexcept {
+            return assets.end();
+        }
+
+        [[nodiscard]] static constexpr stl::size_t size() noexcept {
+            return N;
+        }
+    };
+
+    /**
+     * The embedded asset with this path; it's defined by the code that
+     * webpp_embed_assets (cmake/embedded_assets.cmake) generates.
+     */
+    [[nodiscard]] embedded_asset const* find_embedded_asset(stl::string_view path) noexcept;
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_EMBEDDED_ASSETS_H
@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <string_view>
+#include <type_traits>
 #include <utility>
 
 #if !((__cpp_nontype_template_parameter_class || (__cpp_nontype_template_args >= 201911L)))
@@ -53,6 +54,21 @@ namespace webpp {
             return {first_unit, 1};
     }
 
+    /**
+     * FNV-1a of the code units; a fixed_string and a string_view of the same
+     * ASCII string have the same hash, so the strings that are only known at
+     * runtime can be looked up in the tables that are made of fixed_strings.
+     */
+    template <typename CharT>
+    [[nodiscard]] constexpr size_t fixed_string_hash(std::basic_string_view<CharT> str) noexcept {
+        uint64_t hash = 0xcbf2'9ce4'8422'2325ull;
+        for (auto const c : str) {
+            hash ^= static_cast<std::make_unsigned_t<CharT>>(c);
+            hash *= 0x0000'0100'0000'01b3ull;
+        }
+        return static_cast<size_t>(hash ^ (hash >> 32u));
+    }
+
     template <size_t N>
     struct fixed_string {
         char32_t content[N] = {};
@@ -214,6 +230,9 @@ namespace webpp {
         constexpr operator std::basic_string_view<char32_t>() const noexcept {
             return std::basic_string_view<char32_t>{content, size()};
         }
+        [[nodiscard]] constexpr size_t hash() const noexcept {
+            return fixed_string_hash(std::basic_string_view<char32_t>{content, size()});
+        }
     };
 
     template <>
@@ -246,6 +265,9 @@ namespace webpp {
         constexpr operator std::basic_string_view<char32_t>() const noexcept {
             return std::basic_string_view<char32_t>{empty, 0};
         }
+        [[nodiscard]] constexpr size_t hash() const noexcept {
+            return fixed_string_hash(std::basic_string_view<char32_t>{empty, 0});
+        }
     };
 
     template <typename CharT, size_t N>
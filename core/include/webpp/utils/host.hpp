@@ -0,0 +1,231 @@
+#ifndef WEBPP_UTILS_HOST_H
+#define WEBPP_UTILS_HOST_H
+
+#include "../std/std.hpp"
+#include "../std/string_view.hpp"
+#include "../traits/traits_concepts.hpp"
+#include "../validators/validators.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace webpp {
+
+    enum struct host_kind : stl::uint8_t {
+        none,       // there's no host
+        ipv4,       // 192.168.1.1
+        ip_literal, // [::1] or an IPvFuture, in the brackets
+        reg_name    // a domain name (or anything else that's not an ip)
+    };
+
+    namespace details {
+
+        /**
+         * The public suffixes with more than one label that are common enough to be worth knowing, sorted.
+         * It's not the whole public suffix list; for the others the TLD is the public suffix, which is the
+         * default rule of that list.
+         */
+        static constexpr stl::array<stl::string_view, 40> public_suffixes{
+          "ac.jp",      "ac.uk",      "appspot.com", "azurewebsites.net", "blogspot.com", "co.id",
+          "co.il",      "co.in",      "co.jp",       "co.kr",             "co.nz",        "co.uk",
+          "co.za",      "com.ar",     "com.au",      "com.br",            "com.cn",       "com.hk",
+          "com.mx",     "com.my",     "com.sg",      "com.tr",            "com.tw",       "com.ua",
+          "github.io",  "gitlab.io",  "gov.uk",      "herokuapp.com",     "ltd.uk",       "me.uk",
+          "ne.jp",      "net.au",     "net.cn",      "netlify.app",       "or.jp",        "org.au",
+          "org.cn",     "org.nz",     "org.uk",      "vercel.app"};
+        static_assert(stl::is_sorted(public_suffixes.begin(), public_suffixes.end()));
+
+        template <typename CharT>
+        [[nodiscard]] constexpr CharT lower_ascii(CharT c) noexcept {
+            return c >= 'A' && c <= 'Z' ? static_cast<CharT>(c - 'A' + 'a') : c;
+        }
+
+        /**
+         * Compare the (any case) host suffix with a (lower case) suffix of the table
+         */
+        template <typename StrView>
+        [[nodiscard]] constexpr int compare_suffix(StrView host_suffix, stl::string_view suffix) noexcept {
+            auto const len = stl::min(host_suffix.size(), suffix.size());
+            for (stl::size_t i = 0; i < len; i++) {
+                auto const a = lower_ascii(host_suffix[i]);
+                auto const b = static_cast<decltype(a)>(suffix[i]);
+                if (a != b)
+                    return a < b ? -1 : 1;
+            }
+            return host_suffix.size() < suffix.size() ? -1 : host_suffix.size() > suffix.size() ? 1 : 0;
+        }
+
+        template <typename StrView>
+        [[nodiscard]] constexpr bool is_public_suffix(StrView host_suffix) noexcept {
+            auto const it =
+              stl::lower_bound(public_suffixes.begin(),
+                               public_suffixes.end(),
+                               host_suffix,
+                               [](stl::string_view suffix, StrView const& str) constexpr noexcept {
+                                   return compare_suffix(str, suffix) > 0;
+                               });
+            return it != public_suffixes.end() && compare_suffix(host_suffix, *it) == 0;
+        }
+
+    } // namespace details
+
+    /**
+     * What a host is, and its labels (as views into it), found in one scan of the host; so the
+     * virtual-host routing and the domain getters of basic_uri don't scan the host again for each
+     * question.
+     *
+     * The hosts with more than "capacity" labels keep only the last ones (the TLD side), since those are
+     * the ones the domains are made of; the "overflowed" tells if that has happened.
+     */
+    template <Traits TraitsType>
+    struct basic_host_info {
+        static constexpr stl::size_t capacity = 16;
+
+        using traits_type = TraitsType;
+        using str_view_t  = typename traits_type::string_view_type;
+        using char_type   = typename traits_type::char_type;
+
+      private:
+        str_view_t                       _host{};
+        stl::array<str_view_t, capacity> labels{}; // a ring of the last ones
+        stl::size_t                      count = 0;
+        host_kind                        _kind = host_kind::none;
+
+        // the label at the index from the end; 0 is the TLD
+        [[nodiscard]] constexpr str_view_t from_end(stl::size_t index) const noexcept {
+            if (index >= size())
+                return {};
+            return labels[(count - 1 - index) % capacity];
+        }
+
+        // the host from the start of the label at the index from the end
+        [[nodiscard]] constexpr str_view_t suffix_from(stl::size_t index) const noexcept {
+            auto const label = from_end(index);
+            return _host.substr(static_cast<stl::size_t>(label.data() - _host.data()));
+        }
+
+      public:
+        constexpr basic_host_info() noexcept = default;
+
+        [[nodiscard]] static constexpr basic_host_info parse(str_view_t host) noexcept {
+            basic_host_info res;
+            res._host = host;
+            if (host.empty())
+                return res;
+            if (host.front() == '[' && host.back() == ']') {
+                res._kind = host_kind::ip_literal;
+                return res;
+            }
+
+            bool        digits_and_dots = true;
+            stl::size_t start           = 0;
+            for (stl::size_t i = 0; i < host.size(); i++) {
+                auto const c = host[i];
+                if (c == '.') {
+                    res.labels[res.count++ % capacity] = host.substr(start, i - start);
+                    start                              = i + 1;
+                } else if (c < '0' || c > '9') {
+                    digits_and_dots = false;
+                }
+            }
+            res.labels[res.count++ % capacity] = host.substr(start);
+
+            // only the ones that look like one are checked
+            bool const ipv4 = digits_and_dots && res.count == 4 && is::ipv4<traits_type>(host);
+            res._kind       = ipv4 ? host_kind::ipv4 : host_kind::reg_name;
+            return res;
+        }
+
+        [[nodiscard]] constexpr host_kind kind() const noexcept {
+            return _kind;
+        }
+
+        [[nodiscard]] constexpr bool is_ip() const noexcept {
+            return _kind == host_kind::ipv4 || _kind == host_kind::ip_literal;
+        }
+
+        [[nodiscard]] constexpr bool is_reg_name() const noexcept {
+            return _kind == host_kind::reg_name;
+        }
+
+        [[nodiscard]] constexpr str_view_t host() const noexcept {
+            return _host;
+        }
+
+        /**
+         * The number of the labels that are kept; zero if it's not a domain name
+         */
+        [[nodiscard]] constexpr stl::size_t size() const noexcept {
+            return is_reg_name() ? stl::min(count, capacity) : 0;
+        }
+
+        [[nodiscard]] constexpr bool overflowed() const noexcept {
+            return count > capacity;
+        }
+
+        /**
+         * The label at the index, from the start; "www" is the 0 of "www.example.com"
+         */
+        [[nodiscard]] constexpr str_view_t label(stl::size_t index) const noexcept {
+            return index < size() ? from_end(size() - 1 - index) : str_view_t{};
+        }
+
+        /**
+         * The last label, "com" of "www.example.com"
+         */
+        [[nodiscard]] constexpr str_view_t top_level_domain() const noexcept {
+            return from_end(0);
+        }
+
+        /**
+         * The label before the TLD, "example" of "www.example.com"
+         */
+        [[nodiscard]] constexpr str_view_t second_level_domain() const noexcept {
+            return from_end(1);
+        }
+
+        /**
+         * All of the labels before the second level domain, "a.b" of "a.b.example.com"
+         */
+        [[nodiscard]] constexpr str_view_t subdomains() const noexcept {
+            if (size() < 3)
+                return {};
+            auto const sld = from_end(1);
+            return _host.substr(0, static_cast<stl::size_t>(sld.data() - _host.data()) - 1);
+        }
+
+        /**
+         * The public suffix that the host ends with; "co.uk" of "www.example.co.uk", and the TLD if it
+         * doesn't end with one that's known (see details::public_suffixes).
+         */
+        [[nodiscard]] constexpr str_view_t public_suffix() const noexcept {
+            if (size() == 0)
+                return {};
+            // the known ones have two labels, and none of them is a suffix of another
+            if (size() >= 2 && details::is_public_suffix(suffix_from(1)))
+                return suffix_from(1);
+            return from_end(0);
+        }
+
+        /**
+         * The public suffix and the label before it, "example.co.uk" of "www.example.co.uk"; the
+         * cookies and the virtual hosts are usually per registrable domain. Empty if the host is a
+         * public suffix itself.
+         */
+        [[nodiscard]] constexpr str_view_t registrable_domain() const noexcept {
+            auto const suffix = public_suffix();
+            if (suffix.empty())
+                return {};
+            auto const dots = stl::count(suffix.begin(), suffix.end(), '.');
+            auto const labels_in_suffix = static_cast<stl::size_t>(dots) + 1;
+            if (size() <= labels_in_suffix)
+                return {};
+            return suffix_from(labels_in_suffix);
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_HOST_H
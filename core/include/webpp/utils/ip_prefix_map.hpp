@@ -0,0 +1,338 @@
+#ifndef WEBPP_UTILS_IP_PREFIX_MAP_H
+#define WEBPP_UTILS_IP_PREFIX_MAP_H
+
+#include "../std/std.hpp"
+#include "../traits/std_traits.hpp"
+#include "./ipv4.hpp"
+#include "./ipv6.hpp"
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace webpp {
+
+    namespace details {
+
+        /**
+         * A trie of the prefixes of the ips that are "Bytes" long, one byte at each level; the keys are the
+         * ips as 64bit words, like ipv6 keeps them (the first byte is the high byte of the first word).
+         *
+         * The prefixes are expanded into all of the slots that they cover in the level they end in, and a
+         * child gets the value of the slot that it replaces in all of its slots (leaf pushing); so a lookup
+         * loads one slot per byte of the ip at most, and the slot that isn't a child is the longest match.
+         */
+        template <stl::size_t Bytes>
+        struct prefix_trie {
+            static constexpr stl::uint32_t child_bit = 0x8000'0000u;
+            static constexpr stl::uint32_t none      = 0;
+
+          private:
+            // the slots of the node N are [N * 256, N * 256 + 256); a child index with the child_bit, or the
+            // value index + 1
+            stl::vector<stl::uint32_t> slots;
+            // the prefix length + 1 of the value of each slot; it's only needed for the inserts, so it's not
+            // next to the slots
+            stl::vector<stl::uint8_t> lengths;
+
+            stl::uint32_t add_node(stl::uint32_t slot, stl::uint8_t length) {
+                auto const index = static_cast<stl::uint32_t>(slots.size() / 256);
+                slots.insert(slots.end(), 256, slot);
+                lengths.insert(lengths.end(), 256, length);
+                return index;
+            }
+
+            [[nodiscard]] static constexpr stl::size_t byte_of(stl::uint64_t const* key,
+                                                               stl::size_t          level) noexcept {
+                return static_cast<stl::size_t>(key[level / 8] >> (56u - level % 8 * 8u) & 0xFFu);
+            }
+
+            // put the value in the slot, and in the slots of its children, unless they're longer prefixes
+            void fill(stl::size_t index, stl::uint32_t slot, stl::uint8_t length) {
+                if (slots[index] & child_bit) {
+                    stl::size_t const child = (slots[index] & ~child_bit) * stl::size_t{256};
+                    for (stl::size_t i = 0; i < 256; i++)
+                        fill(child + i, slot, length);
+                } else if (lengths[index] <= length) {
+                    slots[index]   = slot;
+                    lengths[index] = length;
+                }
+            }
+
+          public:
+            /**
+             * Add the first "prefix" bits of the key, with the value (an index); the order of the inserts
+             * doesn't matter, the longer prefixes win.
+             */
+            void insert(stl::uint64_t const* key, stl::size_t prefix, stl::uint32_t value) {
+                if (slots.empty())
+                    add_node(none, 0);
+                stl::size_t node  = 0;
+                stl::size_t level = 0;
+                for (; prefix > (level + 1) * 8; level++) {
+                    auto const index = node * 256 + byte_of(key, level);
+                    if (!(slots[index] & child_bit)) {
+                        auto const child = add_node(slots[index], lengths[index]);
+                        slots[index]     = child | child_bit;
+                    }
+                    node = slots[index] & ~child_bit;
+                }
+
+                // the slots of this level that the prefix covers
+                auto const bits  = prefix - level * 8;
+                auto const first = bits == 0 ? 0u : byte_of(key, level) & (0xFFu << (8 - bits)) & 0xFFu;
+                auto const count = 1u << (8 - bits);
+                for (auto i = first; i < first + count; i++)
+                    fill(node * 256 + i, value + 1, static_cast<stl::uint8_t>(prefix + 1));
+            }
+
+            /**
+             * The value (an index) of the longest prefix that matches the key, or "none"
+             */
+            [[nodiscard]] stl::uint32_t find(stl::uint64_t const* key) const noexcept {
+                if (slots.empty())
+                    return none;
+                auto const* const data = slots.data();
+                stl::size_t       node = 0;
+                for (stl::size_t level = 0; level < Bytes; level++) {
+                    auto const slot = data[node * 256 + byte_of(key, level)];
+                    if (!(slot & child_bit))
+                        return slot;
+                    node = slot & ~child_bit;
+                }
+                return none; // the last level has no children
+            }
+
+            /**
+             * The memory that the lookups use, in bytes
+             */
+            [[nodiscard]] stl::size_t memory_size() const noexcept {
+                return slots.size() * sizeof(stl::uint32_t);
+            }
+        };
+
+    } // namespace details
+
+    /**
+     * A map of the IPv4 and IPv6 prefixes (CIDRs) to values, for the longest-prefix match; for the allow and
+     * deny lists, the rate-limiting classes, or the geo blocks, with thousands of rules. A lookup is a few
+     * loads (4 for an IPv4, and 16 for an IPv6 at most) instead of checking the rules one by one.
+     *
+     *   ip_prefix_map<bool> allowed;
+     *   allowed.insert("10.0.0.0/8", false);
+     *   allowed.insert("10.1.0.0/16", true);
+     *   allowed.find("10.1.2.3");       // true
+     *   allowed.load_file(path, false); // a CIDR on each line
+     *
+     * The IPv4-mapped IPv6 ips (::ffff:10.1.2.3) are looked up in the IPv4 prefixes. It's not thread-safe to
+     * change it while it's being read; see atomic_ip_prefix_map for that.
+     */
+    template <typename T>
+    struct ip_prefix_map {
+        using value_type = T;
+
+      private:
+        struct entry {
+            value_type value; // not in a vector<bool>
+        };
+
+        details::prefix_trie<4>  v4;
+        details::prefix_trie<16> v6;
+        stl::vector<entry>       values;
+
+        [[nodiscard]] value_type const* value_of(stl::uint32_t slot) const noexcept {
+            return slot == details::prefix_trie<4>::none ? nullptr : &values[slot - 1].value;
+        }
+
+        stl::uint32_t add_value(value_type&& value) {
+            values.push_back(entry{stl::move(value)});
+            return static_cast<stl::uint32_t>(values.size() - 1);
+        }
+
+      public:
+        /**
+         * Add the prefix of the ip, or the ip itself if it has no prefix
+         * @returns false if the ip is not valid
+         */
+        template <Traits TraitsType>
+        bool insert(ipv4<TraitsType> const& ip, value_type value) noexcept {
+            if (!ip.is_valid() || !ip.has_valid_prefix())
+                return false;
+            stl::uint64_t const key = stl::uint64_t{ip.integer()} << 32u;
+            v4.insert(&key, ip.has_prefix() ? ip.prefix() : 32u, add_value(stl::move(value)));
+            return true;
+        }
+
+        template <Traits TraitsType>
+        bool insert(ipv6<TraitsType> const& ip, value_type value) noexcept {
+            if (!ip.is_valid())
+                return false;
+            auto const words = ip.octets64();
+            v6.insert(words.data(), ip.has_prefix() ? ip.prefix() : 128u, add_value(stl::move(value)));
+            return true;
+        }
+
+        /**
+         * Add a prefix like "10.0.0.0/8" or "2001:db8::/32"
+         * @returns false if it's not valid
+         */
+        template <Traits TraitsType = std_traits>
+        bool insert(stl::string_view cidr, value_type value) noexcept {
+            if (cidr.find(':') != stl::string_view::npos)
+                return insert(ipv6<TraitsType>{cidr}, stl::move(value));
+            return insert(ipv4<TraitsType>{cidr}, stl::move(value));
+        }
+
+        /**
+         * The value of the longest prefix that the ip is in; nullptr if it's in none of them
+         */
+        template <Traits TraitsType>
+        [[nodiscard]] value_type const* find(ipv4<TraitsType> const& ip) const noexcept {
+            stl::uint64_t const key = stl::uint64_t{ip.integer()} << 32u;
+            return value_of(v4.find(&key));
+        }
+
+        template <Traits TraitsType>
+        [[nodiscard]] value_type const* find(ipv6<TraitsType> const& ip) const noexcept {
+            auto const words = ip.octets64();
+            if (ip.is_v4_mapped()) {
+                stl::uint64_t const key = words[1] << 32u;
+                return value_of(v4.find(&key));
+            }
+            return value_of(v6.find(words.data()));
+        }
+
+        /**
+         * Find an ip that's in a string; nullptr if it's not valid too
+         */
+        template <Traits TraitsType = std_traits>
+        [[nodiscard]] value_type const* find(stl::string_view ip) const noexcept {
+            if (ip.find(':') != stl::string_view::npos) {
+                ipv6<TraitsType> const ip6{ip};
+                return ip6.is_valid() ? find(ip6) : nullptr;
+            }
+            ipv4<TraitsType> const ip4{ip};
+            return ip4.is_valid() ? find(ip4) : nullptr;
+        }
+
+        template <typename IP>
+        [[nodiscard]] bool contains(IP const& ip) const noexcept {
+            return find(ip) != nullptr;
+        }
+
+        /**
+         * The number of the prefixes that are added
+         */
+        [[nodiscard]] stl::size_t size() const noexcept {
+            return values.size();
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return values.empty();
+        }
+
+        /**
+         * The memory of the tries that the lookups go through, in bytes
+         */
+        [[nodiscard]] stl::size_t memory_size() const noexcept {
+            return v4.memory_size() + v6.memory_size();
+        }
+
+        /**
+         * Add all of the prefixes of the text with the same value; one on each line, and the empty lines and
+         * the "#" comments are skipped.
+         * @returns false if any of the lines is not valid; the other ones are added anyway.
+         */
+        bool load(stl::string_view text, value_type const& value) noexcept {
+            constexpr stl::string_view blanks = " \t\r";
+            bool                       valid  = true;
+            while (!text.empty()) {
+                auto const eol  = text.find('\n');
+                auto       line = text.substr(0, eol);
+                text.remove_prefix(eol == stl::string_view::npos ? text.size() : eol + 1);
+
+                line = line.substr(0, line.find('#'));
+                auto const start = line.find_first_not_of(blanks);
+                if (start == stl::string_view::npos)
+                    continue;
+                line = line.substr(start, line.find_last_not_of(blanks) - start + 1);
+                if (!insert(line, value))
+                    valid = false;
+            }
+            return valid;
+        }
+
+        /**
+         * Add all of the prefixes of the file with the same value (see load)
+         * @returns false if the file can't be read, or any of the lines is not valid
+         */
+        bool load_file(stl::filesystem::path const& path, value_type const& value) noexcept {
+            int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd == -1)
+                return false;
+            stl::string              content;
+            stl::array<char, 16'384> buffer;
+            for (;;) {
+                auto const res = ::read(fd, buffer.data(), buffer.size());
+                if (res < 0 && errno == EINTR)
+                    continue;
+                if (res < 0) {
+                    ::close(fd);
+                    return false;
+                }
+                if (res == 0)
+                    break;
+                content.append(buffer.data(), static_cast<stl::size_t>(res));
+            }
+            ::close(fd);
+            return load(content, value);
+        }
+    };
+
+    /**
+     * An ip_prefix_map that the rules of are updated while the other threads look up in it: the new map is
+     * built on the side and swapped in as a whole, and the readers keep the one they've loaded for as long
+     * as they need it.
+     *
+     *   auto const rules = blocked.load(); // once per request, not per lookup
+     *   if (rules->contains(ip)) ...
+     */
+    template <typename T>
+    struct atomic_ip_prefix_map {
+        using map_type = ip_prefix_map<T>;
+        using map_ptr  = stl::shared_ptr<map_type const>;
+
+      private:
+        stl::atomic<map_ptr> current{stl::make_shared<map_type const>()};
+
+      public:
+        atomic_ip_prefix_map() noexcept = default;
+
+        explicit atomic_ip_prefix_map(map_type map) noexcept
+          : current{stl::make_shared<map_type const>(stl::move(map))} {}
+
+        [[nodiscard]] map_ptr load() const noexcept {
+            return current.load(stl::memory_order_acquire);
+        }
+
+        /**
+         * Replace the map; the readers that have loaded the old one keep it until they drop it.
+         */
+        void store(map_type map) noexcept {
+            current.store(stl::make_shared<map_type const>(stl::move(map)), stl::memory_order_release);
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_IP_PREFIX_MAP_H
@@ -7,6 +7,24 @@
 #include "casts.hpp"
 
 #include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#if defined(__SSSE3__)
+#    include <tmmintrin.h>
+#    define WEBPP_IPV4_SCANNER_WIDTH 16
+#else
+#    define WEBPP_IPV4_SCANNER_WIDTH 1
+#endif
+
+#if defined(__SSE2__)
+#    include <emmintrin.h>
+#    define WEBPP_IPV4_BATCH_WIDTH 16
+#else
+#    define WEBPP_IPV4_BATCH_WIDTH 1
+#endif
 
 namespace webpp {
 
@@ -117,6 +135,342 @@ namespace webpp {
                 static_cast<uint8_t>(subnet & 0xFFu)};
     }
 
+    namespace details {
+
+        /**
+         * Load a string of 4 to 15 chars into two words, the first char in the
+         * lowest byte of the low word and zeros after the last one; two
+         * overlapping loads instead of a memcpy of the size, which costs more
+         * than the parsing itself.
+         */
+        inline void load_short_string(char const* data, stl::size_t size,
+                                      uint64_t& low, uint64_t& high) noexcept {
+            low  = 0;
+            high = 0;
+            if (size >= 8) {
+                stl::memcpy(&low, data, 8);
+                stl::memcpy(&high, data + size - 8, 8);
+                high = high >> (8u * (15u - size)) >> 8u;
+            } else {
+                uint32_t first;
+                uint32_t last;
+                stl::memcpy(&first, data, 4);
+                stl::memcpy(&last, data + size - 4, 4);
+                low = first | uint64_t{last} << (8u * (size - 4u));
+            }
+        }
+
+#if WEBPP_IPV4_SCANNER_WIDTH > 1
+        using ipv4_pattern_table = stl::array<stl::array<int8_t, 16>, 81>;
+
+        /**
+         * The shuffles of the ipv4_scanner, one for each of the lengths of the
+         * octets
+         */
+        constexpr ipv4_pattern_table make_ipv4_patterns() noexcept {
+            ipv4_pattern_table table{};
+            for (int index = 0; index < 81; index++) {
+                int const lengths[4]{index / 27 + 1, index / 9 % 3 + 1,
+                                     index / 3 % 3 + 1, index % 3 + 1};
+                auto&     pattern = table[static_cast<stl::size_t>(index)];
+                pattern.fill(-128); // zero
+                int start = 0;
+                for (int octet = 0; octet < 4; octet++) {
+                    // the digits are right-aligned in the first 3 bytes
+                    for (int digit = 0; digit < lengths[octet]; digit++)
+                        pattern[static_cast<stl::size_t>(
+                          octet * 4 + 3 - lengths[octet] + digit)] =
+                          static_cast<int8_t>(start + digit);
+                    start += lengths[octet] + 1;
+                }
+            }
+            return table;
+        }
+#endif
+
+        /**
+         * Parses the dotted-quad part of an ip ("192.168.1.1" of
+         * "192.168.1.1/24") with SSSE3, all 16 bytes at once: the dots and
+         * the digits are found with compares, the lengths of the octets
+         * (one of the 81 layouts) pick a shuffle that puts the digits of each
+         * octet in its own 4 bytes, and two multiply-adds make the octets.
+         *
+         * It accepts what the scalar parser of ipv4 accepts; see ipv4::parse.
+         */
+        struct ipv4_scanner {
+            static constexpr bool vectorized = WEBPP_IPV4_SCANNER_WIDTH > 1;
+
+#if WEBPP_IPV4_SCANNER_WIDTH > 1
+          private:
+            alignas(16) static constexpr ipv4_pattern_table patterns =
+              make_ipv4_patterns();
+
+          public:
+            /**
+             * @param str the whole ip, with its prefix; 15 chars at most
+             * @param octets the parsed octets, the first one in the highest
+             * byte
+             * @param quad_end the position of the '/', or the size
+             * @returns false if the quad is not valid
+             */
+            [[nodiscard]] static bool parse(stl::string_view str,
+                                            uint32_t&        octets,
+                                            stl::size_t& quad_end) noexcept {
+                // the bytes after the ip are zero
+                uint64_t low;
+                uint64_t high;
+                load_short_string(str.data(), str.size(), low, high);
+                auto const chunk = _mm_set_epi64x(static_cast<long long>(high),
+                                                  static_cast<long long>(low));
+                auto const values = _mm_sub_epi8(chunk, _mm_set1_epi8('0'));
+                auto const digits = _mm_cmpeq_epi8(
+                  _mm_min_epu8(values, _mm_set1_epi8(9)), values);
+                auto const all = (1u << str.size()) - 1u;
+
+                auto const slashes =
+                  static_cast<uint32_t>(_mm_movemask_epi8(
+                    _mm_cmpeq_epi8(chunk, _mm_set1_epi8('/')))) &
+                  all;
+                quad_end = slashes != 0
+                             ? static_cast<stl::size_t>(__builtin_ctz(slashes))
+                             : str.size();
+                auto const quad = (1u << quad_end) - 1u;
+                auto const dots =
+                  static_cast<uint32_t>(_mm_movemask_epi8(
+                    _mm_cmpeq_epi8(chunk, _mm_set1_epi8('.')))) &
+                  quad;
+                auto const digit_bits =
+                  static_cast<uint32_t>(_mm_movemask_epi8(digits)) & quad;
+                auto const zeros =
+                  static_cast<uint32_t>(_mm_movemask_epi8(
+                    _mm_cmpeq_epi8(values, _mm_setzero_si128()))) &
+                  quad;
+
+                // the three dots; 16 if there's not that many of them
+                auto       rest = dots;
+                auto const next_dot = [&rest]() noexcept {
+                    auto const pos = __builtin_ctz(rest | 0x1'00'00u);
+                    rest &= rest - 1u;
+                    return pos;
+                };
+                int const dot1 = next_dot();
+                int const dot2 = next_dot();
+                int const dot3 = next_dot();
+
+                // the checks are done with the bits, and with no branch
+                // until the end, because the random lengths of the octets
+                // are bad for the branch predictor
+                auto const starts = (1u | dots << 1u) & quad;
+                bool const valid =
+                  ((dots | digit_bits) == quad) & (rest == 0) &
+                  (dot3 < static_cast<int>(quad_end) - 1) & // 3 dots, not last
+                  ((starts & dots) == 0) &                   // no empty octet
+                  ((digit_bits & digit_bits >> 1u & digit_bits >> 2u &
+                    digit_bits >> 3u) == 0) &                // 3 digits at most
+                  ((zeros & starts & digit_bits >> 1u) == 0); // leading zeros
+                if (!valid)
+                    return false;
+
+                auto const& pattern =
+                  patterns[static_cast<stl::size_t>(
+                    (dot1 - 1) * 27 + (dot2 - dot1 - 2) * 9 +
+                    (dot3 - dot2 - 2) * 3 +
+                    (static_cast<int>(quad_end) - dot3 - 2))];
+                auto const shuffled = _mm_shuffle_epi8(
+                  values,
+                  _mm_load_si128(reinterpret_cast<__m128i const*>(
+                    pattern.data())));
+                // [100h + 10t, o] for each octet, and then 100h + 10t + o
+                auto const pairs = _mm_maddubs_epi16(
+                  shuffled, _mm_setr_epi8(100, 10, 1, 0, 100, 10, 1, 0, 100,
+                                          10, 1, 0, 100, 10, 1, 0));
+                auto const sums = _mm_madd_epi16(pairs, _mm_set1_epi16(1));
+                if (_mm_movemask_epi8(
+                      _mm_cmpgt_epi32(sums, _mm_set1_epi32(255))) != 0)
+                    return false;
+                auto const bytes = _mm_packus_epi16(
+                  _mm_packs_epi32(sums, sums), _mm_setzero_si128());
+                octets = __builtin_bswap32(
+                  static_cast<uint32_t>(_mm_cvtsi128_si32(bytes)));
+                return true;
+            }
+#endif
+        };
+
+        /**
+         * Parses the dotted-quads of 16 ips at once with SSE2, one ip in each
+         * byte of the registers: the strings are transposed so the Nth chars
+         * of all of them are in one register, and the octets of all of them
+         * are built one char at a time.
+         *
+         * It accepts what the scalar parser of ipv4 accepts (see ipv4::parse),
+         * except for the prefixes, which are left to the caller.
+         */
+        struct ipv4_batch_scanner {
+            static constexpr bool vectorized = WEBPP_IPV4_BATCH_WIDTH > 1;
+            static constexpr stl::size_t width = WEBPP_IPV4_BATCH_WIDTH;
+
+#if WEBPP_IPV4_BATCH_WIDTH > 1
+            struct result {
+                // the octets of each ip, the first one in the highest byte
+                alignas(16) stl::array<uint32_t, 16> octets;
+                // the position of the '/' or the end of each one
+                alignas(16) stl::array<uint8_t, 16> quad_ends;
+                uint32_t invalid; // a bit for each of the ips
+                uint32_t slashes; // a bit for each of the ones with a '/'
+            };
+
+            /**
+             * @param strs "count" strings, 16 at most
+             */
+            template <typename StrView>
+            static void parse(StrView const* strs, stl::size_t count,
+                              result& res) noexcept {
+                // the strings that are not 7 to 15 chars are all zeros
+                __m128i     rows[2][16]; // the rows, and the next ones
+                uint32_t    invalid  = 0;
+                stl::size_t max_size = 0;
+                for (stl::size_t i = 0; i < 16; i++) {
+                    auto const size = i < count ? strs[i].size() : 0;
+                    if (size < 7 || size > 15) {
+                        rows[0][i] = _mm_setzero_si128();
+                        invalid |= 1u << i;
+                        continue;
+                    }
+                    uint64_t low;
+                    uint64_t high;
+                    load_short_string(strs[i].data(), size, low, high);
+                    rows[0][i] = _mm_set_epi64x(static_cast<long long>(high),
+                                                static_cast<long long>(low));
+                    max_size = stl::max(max_size, size);
+                }
+
+                // four rounds of interleaving the row i with the row i + 8
+                // make the row k the chars at k
+                for (stl::size_t round = 0; round < 4; round++) {
+                    auto const* const from = rows[round % 2];
+                    auto* const       to   = rows[1 - round % 2];
+                    for (stl::size_t i = 0; i < 8; i++) {
+                        to[2 * i]     = _mm_unpacklo_epi8(from[i], from[i + 8]);
+                        to[2 * i + 1] = _mm_unpackhi_epi8(from[i], from[i + 8]);
+                    }
+                }
+                auto const* const columns = rows[0];
+
+                auto const zero   = _mm_setzero_si128();
+                auto const ones   = _mm_set1_epi8(-1);
+                auto const three  = _mm_set1_epi8(3);
+                auto const max255 = _mm_set1_epi16(255);
+                auto const ten    = _mm_set1_epi16(10);
+                __m128i    cur_lo = zero; // the octet so far, 16 bits each
+                __m128i    cur_hi = zero;
+                __m128i    digits = zero; // the digits of the octet so far
+                __m128i    lead0  = zero; // the octet started with a '0'
+                __m128i    dots   = zero;
+                __m128i    done   = zero; // the '/' or the end is passed
+                __m128i    bad    = zero;
+                __m128i    slash  = zero;
+                __m128i    ends   = zero;
+                __m128i    octets[4]{zero, zero, zero, zero};
+
+                // the end of the longest one is a zero too
+                for (stl::size_t k = 0; k <= max_size; k++) {
+                    auto const chars  = columns[k];
+                    auto const active = _mm_andnot_si128(done, ones);
+                    auto const values = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+                    auto const digit  = _mm_cmpeq_epi8(
+                      _mm_min_epu8(values, _mm_set1_epi8(9)), values);
+                    auto const dot =
+                      _mm_cmpeq_epi8(chars, _mm_set1_epi8('.'));
+                    auto const is_slash =
+                      _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+                    auto const end =
+                      _mm_or_si128(_mm_cmpeq_epi8(chars, zero), is_slash);
+                    auto const sep =
+                      _mm_and_si128(active, _mm_or_si128(dot, end));
+                    bad            = _mm_or_si128(
+                      bad,
+                      _mm_andnot_si128(
+                        _mm_or_si128(_mm_or_si128(digit, dot), end), active));
+
+                    // an octet ends; it should not be empty or too big, and
+                    // there should be 4 of them
+                    auto const too_big = _mm_packs_epi16(
+                      _mm_cmpgt_epi16(cur_lo, max255),
+                      _mm_cmpgt_epi16(cur_hi, max255));
+                    bad = _mm_or_si128(
+                      bad, _mm_and_si128(sep, _mm_or_si128(
+                                                _mm_cmpeq_epi8(digits, zero),
+                                                too_big)));
+                    auto const octet = _mm_packus_epi16(cur_lo, cur_hi);
+                    for (int j = 0; j < 4; j++) {
+                        auto const here = _mm_and_si128(
+                          sep, _mm_cmpeq_epi8(dots, _mm_set1_epi8(
+                                                      static_cast<char>(j))));
+                        octets[j] = _mm_or_si128(
+                          _mm_andnot_si128(here,
+                                           octets[j]),
+                          _mm_and_si128(here, octet));
+                    }
+                    auto const third = _mm_cmpeq_epi8(dots, three);
+                    bad              = _mm_or_si128(
+                      bad, _mm_and_si128(_mm_and_si128(active, dot), third));
+                    bad = _mm_or_si128(
+                      bad,
+                      _mm_andnot_si128(third, _mm_and_si128(active, end)));
+                    auto const ends_here = _mm_and_si128(active, end);
+                    ends                 = _mm_or_si128(
+                      _mm_andnot_si128(ends_here, ends),
+                      _mm_and_si128(ends_here,
+                                    _mm_set1_epi8(static_cast<char>(k))));
+                    slash =
+                      _mm_or_si128(slash, _mm_and_si128(active, is_slash));
+                    dots  = _mm_sub_epi8(dots, _mm_and_si128(active, dot));
+                    done  = _mm_or_si128(done, end);
+
+                    // a digit; 3 of them at most, and no leading zeros
+                    auto const more = _mm_and_si128(active, digit);
+                    auto const fourth = _mm_cmpeq_epi8(digits, three);
+                    bad               = _mm_or_si128(
+                      bad, _mm_and_si128(more, _mm_or_si128(lead0, fourth)));
+                    lead0  = _mm_and_si128(
+                      more, _mm_and_si128(_mm_cmpeq_epi8(digits, zero),
+                                           _mm_cmpeq_epi8(values, zero)));
+                    digits = _mm_and_si128(_mm_sub_epi8(digits, ones), more);
+                    auto const added = _mm_and_si128(values, more);
+                    cur_lo           = _mm_and_si128(
+                      _mm_add_epi16(_mm_mullo_epi16(cur_lo, ten),
+                                    _mm_unpacklo_epi8(added, zero)),
+                      _mm_unpacklo_epi8(more, more));
+                    cur_hi = _mm_and_si128(
+                      _mm_add_epi16(_mm_mullo_epi16(cur_hi, ten),
+                                    _mm_unpackhi_epi8(added, zero)),
+                      _mm_unpackhi_epi8(more, more));
+                }
+
+                // [o0 o1 o2 o3] bytes to the big-endian words
+                auto const o01_lo = _mm_unpacklo_epi8(octets[1], octets[0]);
+                auto const o01_hi = _mm_unpackhi_epi8(octets[1], octets[0]);
+                auto const o23_lo = _mm_unpacklo_epi8(octets[3], octets[2]);
+                auto const o23_hi = _mm_unpackhi_epi8(octets[3], octets[2]);
+                auto*      out = reinterpret_cast<__m128i*>(res.octets.data());
+                _mm_store_si128(out, _mm_unpacklo_epi16(o23_lo, o01_lo));
+                _mm_store_si128(out + 1, _mm_unpackhi_epi16(o23_lo, o01_lo));
+                _mm_store_si128(out + 2, _mm_unpacklo_epi16(o23_hi, o01_hi));
+                _mm_store_si128(out + 3, _mm_unpackhi_epi16(o23_hi, o01_hi));
+                _mm_store_si128(
+                  reinterpret_cast<__m128i*>(res.quad_ends.data()), ends);
+                res.invalid =
+                  invalid |
+                  static_cast<uint32_t>(_mm_movemask_epi8(
+                    _mm_or_si128(bad, _mm_andnot_si128(done, ones))));
+                res.slashes = static_cast<uint32_t>(_mm_movemask_epi8(slash));
+            }
+#endif
+        };
+
+    } // namespace details
+
     template <Traits TraitsType>
     struct ipv4 {
         using traits_type      = TraitsType;
@@ -132,11 +486,40 @@ namespace webpp {
         // 253 means the prefix was not valid
         mutable uint8_t _prefix = 255u;
 
+        /**
+         * Parse the prefix of "192.168.1.1/24"
+         * @returns false if it's not valid
+         */
+        constexpr bool
+        parse_prefix(string_view_type const& prefix_str) const noexcept {
+            if (prefix_str.empty() ||
+                (starts_with<traits_type>(prefix_str, '0') &&
+                 prefix_str != "0") ||
+                !is::digit(prefix_str)) {
+                _prefix = 254u; // the ip is not valid
+                return false;
+            }
+            auto __prefix = to_uint<traits_type>(prefix_str);
+            if (__prefix > 32) {
+                _prefix = 254; // the ip is not valid
+                return false;
+            }
+            _prefix = static_cast<uint8_t>(__prefix);
+            return true;
+        }
+
         constexpr void parse(string_view_type const& _data) const noexcept {
             if (_data.size() > 15 || _data.size() < 7) {
                 _prefix = 254u; // the ip is not valid
                 return;
             }
+            if constexpr (details::ipv4_scanner::vectorized &&
+                          stl::is_same_v<char_type, char>) {
+                if (!stl::is_constant_evaluated()) {
+                    parse_vectorized(_data);
+                    return;
+                }
+            }
             stl::size_t first_dot = 0u;
             stl::size_t len       = _data.size();
             while (_data[first_dot] != '.' && first_dot != len)
@@ -189,22 +572,8 @@ namespace webpp {
                 return;
             }
 
-            if (slash != len) {
-                auto prefix_str = _data.substr(slash + 1);
-                if (prefix_str.empty() ||
-                    (starts_with<traits_type>(prefix_str, '0') &&
-                     prefix_str != "0") ||
-                    !is::digit(prefix_str)) {
-                    _prefix = 254u; // the ip is not valid
-                    return;
-                }
-                auto __prefix = to_uint<traits_type>(prefix_str);
-                if (__prefix > 32) {
-                    _prefix = 254; // the ip is not valid
-                    return;
-                }
-                _prefix = static_cast<uint8_t>(__prefix);
-            }
+            if (slash != len && !parse_prefix(_data.substr(slash + 1)))
+                return;
 
             auto oc1 = to_uint<traits_type>(octet_1);
             auto oc2 = to_uint<traits_type>(octet_2);
@@ -224,6 +593,52 @@ namespace webpp {
                 _prefix = 255u; // the ip is valid
         }
 
+        void parse_vectorized(string_view_type const& _data) const noexcept {
+#if WEBPP_IPV4_SCANNER_WIDTH > 1
+            uint32_t    octets;
+            stl::size_t slash;
+            if (!details::ipv4_scanner::parse(
+                  stl::string_view{_data.data(), _data.size()}, octets,
+                  slash)) {
+                _prefix = 254u; // the ip is not valid
+                return;
+            }
+            if (slash != _data.size() &&
+                !parse_prefix(_data.substr(slash + 1)))
+                return;
+            data = octets;
+            if (_prefix == 254u)
+                _prefix = 255u; // the ip is valid
+#else
+            static_cast<void>(_data);
+#endif
+        }
+
+#if WEBPP_IPV4_BATCH_WIDTH > 1
+        /**
+         * Take the ip at the lane of what the batch scanner has found
+         * @returns true if it's not valid
+         */
+        bool parse_lane(string_view_type const&                   str,
+                        details::ipv4_batch_scanner::result const& res,
+                        stl::size_t lane) noexcept {
+            data           = 0u;
+            _prefix        = 255u;
+            auto const end = static_cast<stl::size_t>(res.quad_ends[lane]);
+            bool       valid = !(res.invalid >> lane & 1u);
+            if (valid && (res.slashes >> lane & 1u))
+                valid = parse_prefix(str.substr(end + 1));
+            else if (valid)
+                valid = end == str.size(); // not a null in the middle
+            if (!valid) {
+                _prefix = 254u; // the ip is not valid
+                return true;
+            }
+            data = res.octets[lane];
+            return false;
+        }
+#endif
+
         constexpr uint32_t
         parse(stl::array<uint8_t, 4u> const& ip) const noexcept {
             return static_cast<uint32_t>(ip[0] << 24u) |
@@ -233,6 +648,11 @@ namespace webpp {
         }
 
       public:
+        /**
+         * 0.0.0.0, with no prefix
+         */
+        constexpr ipv4() noexcept = default;
+
         constexpr ipv4(ipv4 const& ip) = default;
 
         constexpr ipv4(ipv4&& ip) = default;
@@ -257,8 +677,8 @@ namespace webpp {
 
         constexpr ipv4(string_view_type const&       ip,
                        stl::array<uint8_t, 4> const& subnet) noexcept
-          : _prefix(is::subnet<traits_type>(subnet)
-                      ? to_prefix<traits_type>(subnet)
+          : _prefix(is::subnet(subnet)
+                      ? to_prefix(subnet)
                       : 253u) {
             parse(ip);
         }
@@ -313,8 +733,8 @@ namespace webpp {
         constexpr ipv4(stl::array<uint8_t, 4> const& ip,
                        stl::array<uint8_t, 4> const& subnet) noexcept
           : data(parse(ip)),
-            _prefix(is::subnet<traits_type>(subnet)
-                      ? to_prefix<traits_type>(subnet)
+            _prefix(is::subnet(subnet)
+                      ? to_prefix(subnet)
                       : 253u) {
         }
 
@@ -335,8 +755,9 @@ namespace webpp {
         ipv4& operator=(ipv4&& ip) = default;
 
         ipv4& operator=(string_view_type const& ip) noexcept {
-            parse(ip);
+            data    = 0u;
             _prefix = 255u;
+            parse(ip);
             return *this;
         }
 
@@ -346,6 +767,58 @@ namespace webpp {
             return *this;
         }
 
+        /**
+         * Parse all of the strings into the ips in one call, for the
+         * millions of the addresses of the access logs; ips[i] is what
+         * ipv4{strs[i]} would be, and the bit i % 64 of invalid[i / 64] is
+         * set if it's not valid. They're parsed 16 at a time with SSE2 (see
+         * details::ipv4_batch_scanner).
+         *
+         * The ips should have room for all of the strings, and the invalid
+         * for (strs.size() + 63) / 64 words.
+         * @returns the number of the strings that are not valid
+         */
+        static stl::size_t parse_all(stl::span<string_view_type const> strs,
+                                     stl::span<ipv4>                   ips,
+                                     stl::span<uint64_t> invalid) noexcept {
+            using scanner     = details::ipv4_batch_scanner;
+            stl::size_t count = 0;
+            for (stl::size_t first = 0; first < strs.size(); first += 64) {
+                auto const last =
+                  stl::min<stl::size_t>(strs.size(), first + 64);
+                uint64_t bits = 0;
+                if constexpr (scanner::vectorized &&
+                              stl::is_same_v<char_type, char>) {
+#if WEBPP_IPV4_BATCH_WIDTH > 1
+                    scanner::result res;
+                    for (stl::size_t start = first; start < last;
+                         start += scanner::width) {
+                        auto const size =
+                          stl::min<stl::size_t>(last - start, scanner::width);
+                        scanner::parse(strs.data() + start, size, res);
+                        for (stl::size_t lane = 0; lane < size; lane++) {
+                            auto const i   = start + lane;
+                            bool const bad =
+                              ips[i].parse_lane(strs[i], res, lane);
+                            bits |= uint64_t{bad} << (i - first);
+                        }
+                    }
+#endif
+                } else {
+                    for (stl::size_t i = first; i < last; i++) {
+                        auto& ip   = ips[i];
+                        ip.data    = 0u;
+                        ip._prefix = 255u;
+                        ip.parse(strs[i]);
+                        bits |= uint64_t{!ip.is_valid()} << (i - first);
+                    }
+                }
+                invalid[first / 64] = bits;
+                count += static_cast<stl::size_t>(stl::popcount(bits));
+            }
+            return count;
+        }
+
         constexpr bool
         operator==(stl::array<uint8_t, 4> const& other) const noexcept {
             return data == parse(other);
@@ -544,7 +1017,7 @@ namespace webpp {
          */
         ipv4<traits_type>&
         prefix(stl::array<uint8_t, 4> const& _subnet) noexcept {
-            return prefix(to_prefix<traits_type>(_subnet));
+            return prefix(to_prefix(_subnet));
         }
 
         /**
@@ -760,5 +1233,15 @@ namespace webpp {
 
 } // namespace webpp
 
+#ifdef WEBPP_EXTERN_TEMPLATES
+#    include "../traits/std_traits.hpp"
+namespace webpp {
+    // compiled once, in the library (see src/instances.cpp)
+    extern template struct ipv4<std_traits>;
+} // namespace webpp
+#endif
+
+#undef WEBPP_IPV4_SCANNER_WIDTH
+#undef WEBPP_IPV4_BATCH_WIDTH
 
 #endif // WEBPP_IP_H
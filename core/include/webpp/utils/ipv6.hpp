@@ -8,13 +8,75 @@
 
 #include <algorithm>
 #include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 #include <variant>
 
 namespace webpp {
 
+    namespace details {
+
+        /**
+         * The values of the hex digits, and -1 for the other bytes
+         */
+        static constexpr stl::array<int8_t, 256> hex_values = [] {
+            stl::array<int8_t, 256> table{};
+            table.fill(-1);
+            for (int c = '0'; c <= '9'; c++)
+                table[static_cast<stl::size_t>(c)] =
+                  static_cast<int8_t>(c - '0');
+            for (int c = 'a'; c <= 'f'; c++) {
+                table[static_cast<stl::size_t>(c)] =
+                  static_cast<int8_t>(c - 'a' + 10);
+                table[static_cast<stl::size_t>(c - 'a' + 'A')] =
+                  static_cast<int8_t>(c - 'a' + 10);
+            }
+            return table;
+        }();
+
+        template <typename CharT>
+        [[nodiscard]] constexpr int hex_value(CharT c) noexcept {
+            auto const code = static_cast<stl::make_unsigned_t<CharT>>(c);
+            return code < 256u ? hex_values[code] : -1;
+        }
+
+        struct zero_run {
+            int start = -1;
+            int size  = 1;
+        };
+
+        /**
+         * The longest run of the zero groups of an ipv6 (the first one of the
+         * longest ones), for each set of the zero groups (bit i is group i);
+         * the runs of one group are not counted, so they're written as "0".
+         */
+        constexpr stl::array<zero_run, 256> make_zero_runs() noexcept {
+            stl::array<zero_run, 256> table{};
+            for (unsigned zeros = 0; zeros < 256; zeros++) {
+                for (int i = 0; i < 8;) {
+                    int j = i;
+                    while (j < 8 && ((zeros >> j) & 1u))
+                        j++;
+                    if (j - i > table[zeros].size)
+                        table[zeros] = {i, j - i};
+                    i = j == i ? i + 1 : j;
+                }
+            }
+            return table;
+        }
+
+        static constexpr auto zero_runs = make_zero_runs();
+
+    } // namespace details
+
     template <Traits TraitsType>
     class ipv6 {
       public:
@@ -56,7 +118,10 @@ namespace webpp {
         // byte order. Network's byte order is big endian btw, but here we just
         // have to worry about the host's byte order because we are not sending
         // these data over the network.
-        mutable octets_t data = {}; // filled with zeros
+        // The ip is kept as two 64bit words, the first 64 bits of it in the
+        // first one, so the comparisons and the predicates are a mask and a
+        // compare or two.
+        mutable octets64_t data = {}; // filled with zeros
 
         // 255 means it's doesn't have prefix
         // 254 means the ip is not valid
@@ -64,149 +129,158 @@ namespace webpp {
         mutable uint8_t _prefix = 255u;
 
         /**
-         * converts 16/32/64/... bit arrays to 8bit
-         * @tparam OCTET
-         * @param _octets
-         * @return octets8_t so I could put it in the "data"
+         * converts 8/16/32/64 bit arrays to the two words of the "data"
          */
         template <typename OCTET>
-        [[nodiscard]] static constexpr octets_t
-        to_octets_t(OCTET const& _octets) noexcept {
-            octets_t _data           = {};
-            auto     _octets_it      = _octets.cbegin();
-            auto     _data_it        = _data.begin();
-            auto     each_octet_size = _data.size() / _octets.size();
-            for (; _octets_it != _octets.cend(); ++_octets_it) {
-                auto _octet = *_octets_it;
-                for (stl::size_t i = 0u; i < each_octet_size; i++) {
-                    _octet >>= i * 8u;
-                    _octet |= 0xFFu;
-                    *_data_it++ = static_cast<uint8_t>(*_octets_it);
-                }
-            }
-            return _data;
+        [[nodiscard]] static constexpr octets64_t
+        to_octets64(OCTET const& _octets) noexcept {
+            constexpr stl::size_t bits =
+              sizeof(typename OCTET::value_type) * 8u;
+            constexpr stl::size_t each = 64u / bits; // in each word
+            auto const            word = [&]<stl::size_t... I>(
+                              stl::size_t first,
+                              stl::index_sequence<I...>) constexpr noexcept {
+                return ((static_cast<uint64_t>(_octets[first + I])
+                         << (64u - bits * (I + 1u))) |
+                        ...);
+            };
+            return {word(0, stl::make_index_sequence<each>{}),
+                    word(each, stl::make_index_sequence<each>{})};
+        }
+
+        /**
+         * converts the "data" to 8/16/32/64 bit arrays
+         */
+        template <typename OCTET>
+        [[nodiscard]] constexpr OCTET from_octets64() const noexcept {
+            using value_type           = typename OCTET::value_type;
+            constexpr stl::size_t bits = sizeof(value_type) * 8u;
+            constexpr stl::size_t each = 64u / bits; // in each word
+            OCTET                 res  = {};
+            [&]<stl::size_t... I>(
+              stl::index_sequence<I...>) constexpr noexcept {
+                ((res[I] = static_cast<value_type>(
+                    data[I / each] >> (64u - bits * (I % each + 1u)))),
+                 ...);
+            }(stl::make_index_sequence<2u * each>{});
+            return res;
         }
 
         /**
-         * parses the string_view to the uint8 structure
+         * parses the string_view to the words of the "data"
+         *
+         * It's one pass over the string with a table for the hex digits; the
+         * groups after the "::" are written as they come, and moved to the
+         * end of the ip when the string is finished.
          */
         constexpr void parse(string_view_type ipv6_data) const noexcept {
-            constexpr auto hexes = HEXDIG<char_type>.string_view();
+            constexpr auto no_double_colon = string_view_type::npos;
 
-            if (ipv6_data.empty()) {
-                _prefix = 254u;
-                return;
-            }
+            octets16_t values  = {}; // the groups, all zero
+            auto const invalid = [this]() constexpr noexcept {
+                data    = {};
+                _prefix = 254u; // the ip is not valid
+            };
 
-            data                    = {}; // all zero
-            auto it                 = data.begin();
-            auto double_colon_point = data.end();
+            auto const slash = ipv6_data.find('/');
+            auto const end =
+              slash == string_view_type::npos ? ipv6_data.size() : slash;
+            stl::size_t pos          = 0;
+            stl::size_t groups       = 0;
+            stl::size_t double_colon = no_double_colon;
+            if (end < 2)
+                return invalid(); // "::" is the shortest one
+            if (ipv6_data[0] == ':') {
+                if (ipv6_data[1] != ':')
+                    return invalid();
+                double_colon = 0;
+                pos          = 2;
+            }
 
-            do {
-                if (it == data.cend() &&
-                    !starts_with<traits_type>(ipv6_data, '/')) {
-                    _prefix = 254u; // the ip has too many octets
-                    return;
+            while (pos < end) {
+                auto const  group_start = pos;
+                stl::size_t value       = 0;
+                for (; pos < end && pos - group_start < 5; pos++) {
+                    auto const digit = details::hex_value(ipv6_data[pos]);
+                    if (digit < 0)
+                        break;
+                    value = value << 4u | static_cast<stl::size_t>(digit);
                 }
-                auto colon = ipv6_data.find_first_not_of(hexes);
-                if (colon == string_view_type::npos ||
-                    ipv6_data[colon] == ':' ||
-                    (colon != 0 && ipv6_data[colon] == '/')) {
-                    // it's an octet
-                    switch (colon == string_view_type::npos ? ipv6_data.size()
-                                                            : colon) {
-                        case 4:
-                            *(it++) = stl::stoul(
-                              string_type(ipv6_data.substr(0, 2)), nullptr, 16);
-                            *(it++) = stl::stoul(
-                              string_type(ipv6_data.substr(2, 2)), nullptr, 16);
-                            break;
-                        case 3:
-                            *(it++) = stl::stoul(
-                              string_type(ipv6_data.substr(0, 1)), nullptr, 16);
-                            *(it++) = stl::stoul(
-                              string_type(ipv6_data.substr(1, 2)), nullptr, 16);
-                            break;
-                        case 2:
-                        case 1:
-                            *((++it)++) = stl::stoul(
-                              string_type(ipv6_data.substr(0, colon)), nullptr,
-                              16);
-                            break;
-                        case 0:
-                            // we've reached the double colon rule
-                            if (double_colon_point != data.end()) {
-                                _prefix =
-                                  254u; // we can't have two double colons
-                                return;
-                            } else {
-                                double_colon_point = it;
-                                if (it == data.begin())
-                                    ipv6_data.remove_prefix(1);
-                            }
-                            break;
-                        default:
-                            _prefix = 254u; // the ip is invalid
-                            return;
-                    }
-                    if (ipv6_data[colon] == '/')
-                        colon--;
-                } else if (ipv6_data[colon] == '.') {
-                    // we found an ipv4 address
-                    ipv4<traits_type> ip(ipv6_data);
-                    if (!ip.is_valid()) {
-                        _prefix = 254u; // the ip is not valid
-                        return;
-                    }
-                    for (auto const& octet : ip.octets())
-                        *(it++) = octet;
+
+                if (pos < end && ipv6_data[pos] == '.') {
+                    // an ipv4 in the last 32 bits
+                    ipv4<traits_type> const ip{
+                      ipv6_data.substr(group_start, end - group_start)};
+                    if (groups > 6 || !ip.is_valid())
+                        return invalid();
+                    auto const ip_int  = ip.integer();
+                    values[groups]     = static_cast<uint16_t>(ip_int >> 16u);
+                    values[groups + 1] = static_cast<uint16_t>(ip_int);
+                    groups += 2;
                     break;
-                } else if (ipv6_data[colon] == '/') {
-                    // we have a prefix
-                    auto prefix_str = ipv6_data.substr(colon + 1);
-                    if (!is::digit(prefix_str)) {
-                        _prefix = 253u; // the prefix is invalid
-                        break;          // let's not go all crazy just yet
-                    }
-                    auto __prefix = stl::stoul(string_type(prefix_str));
-                    // if (starts_with(prefix_str, '0') && __prefix != 0) {
-                    //     // there can't be a leading zero in the prefix string
-                    //     _prefix = 253u;
-                    //     return;
-                    // }
-                    _prefix = __prefix > 128u
-                                ? 253u
-                                : static_cast<decltype(_prefix)>(__prefix);
-                    ipv6_data.remove_prefix(prefix_str.size() + 1);
-                    if (!ipv6_data.empty()) {
-                        _prefix = 254u; // there can't be more stuff in the ip
-                                        // from now on.
-                        return;
-                    }
-                    break; // there's nothing in the loop for us anymore
-                } else {
-                    _prefix = 254u; // the ip is not valid
-                    return;
                 }
-                if (colon != string_view_type::npos)
-                    ipv6_data.remove_prefix(colon + 1);
-                else
+
+                auto const digits = pos - group_start;
+                if (digits == 0 || digits > 4 || groups == 8)
+                    return invalid();
+                values[groups++] = static_cast<uint16_t>(value);
+
+                if (pos == end)
                     break;
-            } while (!ipv6_data.empty());
+                if (ipv6_data[pos] != ':')
+                    return invalid();
+                pos++;
+                if (pos < end && ipv6_data[pos] == ':') {
+                    if (double_colon != no_double_colon)
+                        return invalid(); // we can't have two double colons
+                    double_colon = groups;
+                    pos++;
+                } else if (pos == end) {
+                    return invalid(); // it ends with one colon
+                }
+            }
 
-            if (double_colon_point != data.end() && it != data.end()) {
+            if (double_colon == no_double_colon) {
+                if (groups != 8)
+                    return invalid(); // the string doesn't have the whole ip
+            } else {
+                if (groups == 8)
+                    return invalid(); // "::" is one group at least
                 // XXXX XXXX XXXX XXXX YYYY YYYY 0000 0000
                 //                    ^         ^
-                //               double colon   it
+                //               double colon   groups
                 // shift the values to the last
-                stl::rotate(double_colon_point, it, data.end());
-            } else if (it != data.end()) {
-                _prefix = 254u; // the string does not contain the whole ip
-                return;
+                auto const first = values.begin() + double_colon;
+                auto const last  = values.begin() + groups;
+                stl::copy_backward(first, last, values.end());
+                stl::fill(first, values.end() - (last - first), 0);
+            }
+            data = to_octets64(values);
+
+            if (slash != string_view_type::npos) {
+                // the leading zeros are allowed, but nothing else
+                auto const prefix_str = ipv6_data.substr(slash + 1);
+                stl::size_t __prefix  = 0;
+                for (auto const c : prefix_str) {
+                    if (c < '0' || c > '9' || __prefix > 128u) {
+                        __prefix = 253u;
+                        break;
+                    }
+                    __prefix =
+                      __prefix * 10 + static_cast<stl::size_t>(c - '0');
+                }
+                _prefix = prefix_str.empty() || __prefix > 128u
+                            ? 253u // the prefix is invalid
+                            : static_cast<uint8_t>(__prefix);
             }
         }
 
       public:
+        /**
+         * The unspecified ip (::), with no prefix
+         */
+        constexpr ipv6() noexcept = default;
+
         constexpr explicit ipv6(string_view_type const& str,
                                 uint8_t __prefix = 255u) noexcept
           : _prefix(__prefix > 128u && __prefix != 255u ? 253u : __prefix) {
@@ -214,23 +288,23 @@ namespace webpp {
         }
         constexpr explicit ipv6(octets8_t const& _octets,
                                 uint8_t          __prefix = 255u) noexcept
-          : data(_octets),
+          : data{to_octets64(_octets)},
             _prefix(__prefix > 128u && __prefix != 255u ? 253u : __prefix) {
         }
         constexpr explicit ipv6(octets16_t const& _octets,
                                 uint8_t           __prefix = 255u) noexcept
-          : data{to_octets_t(_octets)},
+          : data{to_octets64(_octets)},
             _prefix(__prefix > 128u && __prefix != 255u ? 253u : __prefix) {
         }
 
         constexpr explicit ipv6(octets32_t const& _octets,
                                 uint8_t           __prefix = 255u) noexcept
-          : data{to_octets_t(_octets)},
+          : data{to_octets64(_octets)},
             _prefix(__prefix > 128u && __prefix != 255u ? 253u : __prefix) {
         }
         constexpr explicit ipv6(octets64_t const& _octets,
                                 uint8_t           __prefix = 255u) noexcept
-          : data{to_octets_t(_octets)},
+          : data{to_octets64(_octets)},
             _prefix(__prefix > 128u && __prefix != 255u ? 253u : __prefix) {
         }
         constexpr ipv6(ipv6 const& ip) noexcept = default;
@@ -239,44 +313,88 @@ namespace webpp {
         ipv6& operator=(ipv6 const& ip) noexcept = default;
 
         ipv6& operator=(string_view_type const& str) noexcept {
-            parse(str);
             _prefix = 255u;
+            parse(str);
             return *this;
         }
 
         ipv6& operator=(octets8_t const& _octets) noexcept {
-            data    = _octets;
+            data    = to_octets64(_octets);
             _prefix = 255u;
             return *this;
         }
 
         ipv6& operator=(octets16_t const& _octets) noexcept {
-            data    = to_octets_t(_octets);
+            data    = to_octets64(_octets);
             _prefix = 255u;
             return *this;
         }
 
         ipv6& operator=(octets32_t const& _octets) noexcept {
-            data    = to_octets_t(_octets);
+            data    = to_octets64(_octets);
             _prefix = 255u;
             return *this;
         }
 
         ipv6& operator=(octets64_t const& _octets) noexcept {
-            data    = to_octets_t(_octets);
+            data    = to_octets64(_octets);
             _prefix = 255u;
             return *this;
         }
 
-        bool operator==(ipv6 const& other) const noexcept {
-            return data == other.data && _prefix == other._prefix;
+        /**
+         * Parse all of the strings into the ips in one call; ips[i] is what
+         * ipv6{strs[i]} would be, and the bit i % 64 of invalid[i / 64] is
+         * set if it's not valid (see ipv4::parse_all).
+         * @returns the number of the strings that are not valid
+         */
+        static stl::size_t parse_all(stl::span<string_view_type const> strs,
+                                     stl::span<ipv6>                   ips,
+                                     stl::span<uint64_t> invalid) noexcept {
+            stl::size_t count = 0;
+            for (stl::size_t first = 0; first < strs.size(); first += 64) {
+                auto const last =
+                  stl::min<stl::size_t>(strs.size(), first + 64);
+                uint64_t bits = 0;
+                for (stl::size_t i = first; i < last; i++) {
+                    auto& ip   = ips[i];
+                    ip._prefix = 255u;
+                    ip.parse(strs[i]);
+                    bits |= uint64_t{!ip.is_valid()} << (i - first);
+                }
+                invalid[first / 64] = bits;
+                count += static_cast<stl::size_t>(stl::popcount(bits));
+            }
+            return count;
+        }
+
+        constexpr bool operator==(ipv6 const& other) const noexcept {
+            return data[0] == other.data[0] && data[1] == other.data[1] &&
+                   _prefix == other._prefix;
         }
 
-        bool operator!=(ipv6 const& other) const noexcept {
+        constexpr bool operator!=(ipv6 const& other) const noexcept {
             return !operator==(other);
         }
 
-        // TODO: add other operators
+        // the ips are compared like 128bit numbers; the prefixes are not
+        // compared (like ipv4)
+        constexpr bool operator<(ipv6 const& other) const noexcept {
+            return data[0] < other.data[0] ||
+                   (data[0] == other.data[0] && data[1] < other.data[1]);
+        }
+
+        constexpr bool operator>(ipv6 const& other) const noexcept {
+            return other < *this;
+        }
+
+        constexpr bool operator<=(ipv6 const& other) const noexcept {
+            return !(other < *this);
+        }
+
+        constexpr bool operator>=(ipv6 const& other) const noexcept {
+            return !(*this < other);
+        }
 
         explicit operator octets8_t() const noexcept {
             return octets8();
@@ -308,7 +426,7 @@ namespace webpp {
          * @return the octets in 8bit format
          */
         [[nodiscard]] constexpr octets8_t octets8() const noexcept {
-            return data;
+            return from_octets64<octets8_t>();
         }
 
         /**
@@ -319,78 +437,31 @@ namespace webpp {
             return octets8();
         }
 
+        // IP: XX XX XX XX XX XX XX XX XX XX XX XX XX XX XX XX
+        // 08: 00 01 02 03 04 05 06 07 08 09 10 11 12 13 14 15
+        // 16: --0-- --1-- --2-- --3-- --4-- --5-- --6-- --7--
+        // 32: -----0----- -----1----- -----2----- -----3-----
+        // 64: -----------0----------- -----------1-----------
+
         /**
          * @brief return all the octets in 16bit format
          */
         [[nodiscard]] constexpr octets16_t octets16() const noexcept {
-            // IP: XX XX XX XX XX XX XX XX XX XX XX XX XX XX XX XX
-            // 08: 00 01 02 03 04 05 06 07 08 09 10 11 12 13 14 15
-            // 16: --0-- --1-- --2-- --3-- --4-- --5-- --6-- --7--
-            // 32: -----0----- -----1----- -----2----- -----3-----
-            // 64: -----------0----------- -----------1-----------
-
-            auto                  _octets = octets8();
-            octets16_t            ndata   = {};
-            constexpr stl::size_t len     = ndata.size();
-            using t                       = uint16_t;
-            for (stl::size_t i = 0; i < len; i++) {
-                ndata[i] =
-                  (static_cast<t>(_octets[i * 2u + 0u]) << (16u - 8u * 1u)) |
-                  (static_cast<t>(_octets[i * 2u + 1u]) << (16u - 8u * 2u));
-            }
-            return ndata;
+            return from_octets64<octets16_t>();
         }
 
         /**
          * @brief return all octets in 32bit format
          */
         [[nodiscard]] constexpr octets32_t octets32() const noexcept {
-            // IP: XX XX XX XX XX XX XX XX XX XX XX XX XX XX XX XX
-            // 08: 00 01 02 03 04 05 06 07 08 09 10 11 12 13 14 15
-            // 16: --0-- --1-- --2-- --3-- --4-- --5-- --6-- --7--
-            // 32: -----0----- -----1----- -----2----- -----3-----
-            // 64: -----------0----------- -----------1-----------
-
-            auto                  _octets = octets8();
-            octets32_t            ndata   = {};
-            constexpr stl::size_t len     = ndata.size();
-            using t                       = uint32_t;
-            for (stl::size_t i = 0; i < len; i++) {
-                ndata[i] =
-                  (static_cast<t>(_octets[i * 2u + 0u]) << (32u - 8u * 1u)) |
-                  (static_cast<t>(_octets[i * 2u + 1u]) << (32u - 8u * 2u)) |
-                  (static_cast<t>(_octets[i * 2u + 2u]) << (32u - 8u * 3u)) |
-                  (static_cast<t>(_octets[i * 2u + 3u]) << (32u - 8u * 4u));
-            }
-            return ndata;
+            return from_octets64<octets32_t>();
         }
 
         /**
          * @brief return all octets in 64bit format
          */
         [[nodiscard]] constexpr octets64_t octets64() const noexcept {
-            // IP: XX XX XX XX XX XX XX XX XX XX XX XX XX XX XX XX
-            // 08: 00 01 02 03 04 05 06 07 08 09 10 11 12 13 14 15
-            // 16: --0-- --1-- --2-- --3-- --4-- --5-- --6-- --7--
-            // 32: -----0----- -----1----- -----2----- -----3-----
-            // 64: -----------0----------- -----------1-----------
-
-            auto                  _octets = octets8();
-            octets64_t            ndata   = {};
-            constexpr stl::size_t len     = ndata.size();
-            using t                       = uint64_t;
-            for (stl::size_t i = 0; i < len; i++) {
-                ndata[i] =
-                  (static_cast<t>(_octets[i * 2u + 0u]) << (64u - 8u * 1u)) |
-                  (static_cast<t>(_octets[i * 2u + 1u]) << (64u - 8u * 2u)) |
-                  (static_cast<t>(_octets[i * 2u + 2u]) << (64u - 8u * 3u)) |
-                  (static_cast<t>(_octets[i * 2u + 3u]) << (64u - 8u * 4u)) |
-                  (static_cast<t>(_octets[i * 2u + 4u]) << (64u - 8u * 5u)) |
-                  (static_cast<t>(_octets[i * 2u + 5u]) << (64u - 8u * 6u)) |
-                  (static_cast<t>(_octets[i * 2u + 6u]) << (64u - 8u * 7u)) |
-                  (static_cast<t>(_octets[i * 2u + 7u]) << (64u - 8u * 8u));
-            }
-            return ndata;
+            return data;
         }
 
         /**
@@ -399,7 +470,7 @@ namespace webpp {
          */
         [[nodiscard]] constexpr uint8_t scope() const noexcept {
             if (is_multicast()) {
-                return octets8()[1] & 0xfu;
+                return static_cast<uint8_t>(data[0] >> 48u & 0xFu);
             } else if (is_link_local()) {
                 return static_cast<uint8_t>(scope::link_local);
             } else if (is_loopback()) {
@@ -418,15 +489,7 @@ namespace webpp {
          *
          */
         [[nodiscard]] constexpr bool is_unspecified() const noexcept {
-            auto _octets = octets8();
-            return (_octets[0] == 0) && (_octets[1] == 0) &&
-                   (_octets[2] == 0) && (_octets[3] == 0) &&
-                   (_octets[4] == 0) && (_octets[5] == 0) &&
-                   (_octets[6] == 0) && (_octets[7] == 0) &&
-                   (_octets[8] == 0) && (_octets[9] == 0) &&
-                   (_octets[10] == 0) && (_octets[11] == 0) &&
-                   (_octets[12] == 0) && (_octets[13] == 0) &&
-                   (_octets[14] == 0) && (_octets[15] == 0);
+            return data[0] == 0 && data[1] == 0;
         }
 
         /**
@@ -438,15 +501,7 @@ namespace webpp {
          *
          */
         [[nodiscard]] constexpr bool is_loopback() const noexcept {
-            auto _octets = octets8();
-            return (_octets[0] == 0) && (_octets[1] == 0) &&
-                   (_octets[2] == 0) && (_octets[3] == 0) &&
-                   (_octets[4] == 0) && (_octets[5] == 0) &&
-                   (_octets[6] == 0) && (_octets[7] == 0) &&
-                   (_octets[8] == 0) && (_octets[9] == 0) &&
-                   (_octets[10] == 0) && (_octets[11] == 0) &&
-                   (_octets[12] == 0) && (_octets[13] == 0) &&
-                   (_octets[14] == 0) && (_octets[15] == 1);
+            return data[0] == 0 && data[1] == 1;
         }
 
         /**
@@ -458,8 +513,7 @@ namespace webpp {
          *
          */
         [[nodiscard]] constexpr bool is_link_local() const noexcept {
-            auto _octets = octets8();
-            return (_octets[0] == 0xfeu) && ((_octets[1] & 0xc0u) == 0x80u);
+            return (data[0] & 0xFFC0'0000'0000'0000u) == 0xFE80'0000'0000'0000u;
         }
 
         /**
@@ -471,8 +525,13 @@ namespace webpp {
          *
          */
         [[nodiscard]] constexpr bool is_multicast() const noexcept {
-            auto _octets = octets8();
-            return _octets[0] == 0xffu;
+            return data[0] >> 56u == 0xFFu;
+        }
+
+        // a multicast with the scope (the 4 bits after the flags)
+        [[nodiscard]] constexpr bool
+        is_multicast_scope(uint8_t _scope) const noexcept {
+            return (data[0] >> 48u & 0xFF0Fu) == (0xFF00u | _scope);
         }
 
         /**
@@ -480,8 +539,7 @@ namespace webpp {
          * @return bool
          */
         [[nodiscard]] constexpr bool is_multicast_global() const noexcept {
-            auto _octets = octets8();
-            return ((_octets[0] == 0xffu) && ((_octets[1] & 0x0fu) == 0x0eu));
+            return is_multicast_scope(0x0Eu);
         }
 
         /**
@@ -489,8 +547,7 @@ namespace webpp {
          * @return bool
          */
         [[nodiscard]] constexpr bool is_multicast_link_local() const noexcept {
-            auto _octets = octets8();
-            return ((_octets[0] == 0xffu) && ((_octets[1] & 0x0fu) == 0x02u));
+            return is_multicast_scope(0x02u);
         }
 
         /**
@@ -498,8 +555,7 @@ namespace webpp {
          * @return bool
          */
         [[nodiscard]] constexpr bool is_multicast_node_local() const noexcept {
-            auto _octets = octets8();
-            return ((_octets[0] == 0xffu) && ((_octets[1] & 0x0fu) == 0x01u));
+            return is_multicast_scope(0x01u);
         }
 
         /**
@@ -507,8 +563,7 @@ namespace webpp {
          * @return bool
          */
         [[nodiscard]] constexpr bool is_multicast_org_local() const noexcept {
-            auto _octets = octets8();
-            return ((_octets[0] == 0xffu) && ((_octets[1] & 0x0fu) == 0x08u));
+            return is_multicast_scope(0x08u);
         }
 
         /**
@@ -516,8 +571,7 @@ namespace webpp {
          * @return bool
          */
         [[nodiscard]] constexpr bool is_multicast_site_local() const noexcept {
-            auto _octets = octets8();
-            return ((_octets[0] == 0xffu) && ((_octets[1] & 0x0fu) == 0x05u));
+            return is_multicast_scope(0x05u);
         }
 
         /**
@@ -535,8 +589,7 @@ namespace webpp {
          * @return bool
          */
         [[nodiscard]] constexpr bool is_site_local() const noexcept {
-            auto _octets = octets8();
-            return (_octets[0] == 0xfeu) && ((_octets[1] & 0xc0u) == 0xc0u);
+            return (data[0] & 0xFFC0'0000'0000'0000u) == 0xFEC0'0000'0000'0000u;
         }
 
         /**
@@ -544,13 +597,7 @@ namespace webpp {
          * @return bool
          */
         [[nodiscard]] constexpr bool is_v4_mapped() const noexcept {
-            auto _octets = octets8();
-            return (_octets[0] == 0) && (_octets[1] == 0) &&
-                   (_octets[2] == 0) && (_octets[3] == 0) &&
-                   (_octets[4] == 0) && (_octets[5] == 0) &&
-                   (_octets[6] == 0) && (_octets[7] == 0) &&
-                   (_octets[8] == 0) && (_octets[9] == 0) &&
-                   (_octets[10] == 0xff) && (_octets[11] == 0xff);
+            return data[0] == 0 && data[1] >> 32u == 0xFFFFu;
         }
 
         /**
@@ -579,15 +626,7 @@ namespace webpp {
          */
         [[nodiscard]] constexpr bool
         is_link_local_all_nodes_multicast() const noexcept {
-            auto _octets = octets8();
-            return _octets[0] == 0xFFu && _octets[1] == 0x02u &&
-                   (_octets[2] == 0) && (_octets[3] == 0) &&
-                   (_octets[4] == 0) && (_octets[5] == 0) &&
-                   (_octets[6] == 0) && (_octets[7] == 0) &&
-                   (_octets[8] == 0) && (_octets[9] == 0) &&
-                   (_octets[10] == 0) && (_octets[11] == 0) &&
-                   (_octets[12] == 0) && (_octets[13] == 0) &&
-                   (_octets[14] == 0) && (_octets[15] == 0x01u);
+            return data[0] == 0xFF02'0000'0000'0000u && data[1] == 0x01u;
         }
 
         /**
@@ -602,15 +641,7 @@ namespace webpp {
          */
         [[nodiscard]] constexpr bool
         is_link_local_all_routers_multicast() const noexcept {
-            auto _octets = octets();
-            return _octets[0] == 0xFFu && _octets[1] == 0x02u &&
-                   (_octets[2] == 0) && (_octets[3] == 0) &&
-                   (_octets[4] == 0) && (_octets[5] == 0) &&
-                   (_octets[6] == 0) && (_octets[7] == 0) &&
-                   (_octets[8] == 0) && (_octets[9] == 0) &&
-                   (_octets[10] == 0) && (_octets[11] == 0) &&
-                   (_octets[12] == 0) && (_octets[13] == 0) &&
-                   (_octets[14] == 0) && (_octets[15] == 0x02u);
+            return data[0] == 0xFF02'0000'0000'0000u && data[1] == 0x02u;
         }
 
         /**
@@ -656,15 +687,7 @@ namespace webpp {
          */
         [[nodiscard]] constexpr bool
         is_realm_local_all_routers_multicast() const noexcept {
-            auto _octets = octets();
-            return _octets[0] == 0xFFu && _octets[1] == 0x03u &&
-                   (_octets[2] == 0) && (_octets[3] == 0) &&
-                   (_octets[4] == 0) && (_octets[5] == 0) &&
-                   (_octets[6] == 0) && (_octets[7] == 0) &&
-                   (_octets[8] == 0) && (_octets[9] == 0) &&
-                   (_octets[10] == 0) && (_octets[11] == 0) &&
-                   (_octets[12] == 0) && (_octets[13] == 0) &&
-                   (_octets[14] == 0) && (_octets[15] == 0x02u);
+            return data[0] == 0xFF03'0000'0000'0000u && data[1] == 0x02u;
         }
 
         /**
@@ -679,15 +702,7 @@ namespace webpp {
          */
         [[nodiscard]] constexpr bool
         is_realm_local_all_mpl_forwarders() const noexcept {
-            auto _octets = octets8();
-            return _octets[0] == 0xFFu && _octets[1] == 0x03u &&
-                   (_octets[2] == 0) && (_octets[3] == 0) &&
-                   (_octets[4] == 0) && (_octets[5] == 0) &&
-                   (_octets[6] == 0) && (_octets[7] == 0) &&
-                   (_octets[8] == 0) && (_octets[9] == 0) &&
-                   (_octets[10] == 0) && (_octets[11] == 0) &&
-                   (_octets[12] == 0) && (_octets[13] == 0) &&
-                   (_octets[14] == 0) && (_octets[15] == 0xfcu);
+            return data[0] == 0xFF03'0000'0000'0000u && data[1] == 0xFCu;
         }
 
         /**
@@ -718,14 +733,14 @@ namespace webpp {
             constexpr auto aloc_16_mask = 0xFCu; // The mask for Aloc16
             constexpr auto rloc16_reserved_bit_mask =
               0x02u; // The mask for the reserved bit of Rloc16
-            auto _octets = octets();
             // XX XX XX XX XX XX XX XX 00 00 00 FF FE 00 YY YY
             // 00 01 02 03 04 05 06 07 08 09 10 11 12 13 14 15
             // --0-- --1-- --2-- --3-- --4-- --5-- --6-- --7--
-            return _octets[8] == 0 && _octets[9] == 0 && _octets[10] == 0 &&
-                   _octets[11] == 0xFF && _octets[12] == 0xFE &&
-                   _octets[13] == 0 && (_octets[14] < aloc_16_mask) &&
-                   ((_octets[14] & rloc16_reserved_bit_mask) == 0);
+            auto const octet14 = data[1] >> 8u & 0xFFu;
+            return (data[1] & 0xFFFF'FFFF'FFFF'0000u) ==
+                     0x0000'00FF'FE00'0000u &&
+                   octet14 < aloc_16_mask &&
+                   (octet14 & rloc16_reserved_bit_mask) == 0;
         }
 
         /**
@@ -738,16 +753,10 @@ namespace webpp {
          */
         [[nodiscard]] constexpr bool
         is_anycast_routing_locator() const noexcept {
-            constexpr auto aloc_16_mask = 0xFC; // The mask for Aloc16
-            auto           _octets      = octets();
-
             // XX XX XX XX XX XX XX XX 00 00 00 FF FE 00 FC XX
             // 00 01 02 03 04 05 06 07 08 09 10 11 12 13 14 15
             // --0-- --1-- --2-- --3-- --4-- --5-- --6-- --7--
-
-            return _octets[8] == 0 && _octets[9] == 0 && _octets[10] == 0 &&
-                   _octets[11] == 0xFF && _octets[12] == 0xFE &&
-                   _octets[13] == 0 && _octets[14] == aloc_16_mask;
+            return (data[1] & 0xFFFF'FFFF'FFFF'FF00u) == 0x0000'00FF'FE00'FC00u;
         }
 
         /**
@@ -760,13 +769,12 @@ namespace webpp {
          */
         [[nodiscard]] constexpr bool
         is_anycast_service_locator() const noexcept {
-            constexpr auto aloc8_service_start = 0x10;
-            constexpr auto aloc8_service_end   = 0x2f;
-            auto           _octets             = octets();
+            constexpr auto aloc8_service_start = 0x10u;
+            constexpr auto aloc8_service_end   = 0x2fu;
+            auto const     octet15             = data[1] & 0xFFu;
             return is_anycast_routing_locator() &&
-                   (_octets[IPV6_ADDR_SIZE - 2] == 0xfc) &&
-                   (_octets[IPV6_ADDR_SIZE - 1] >= aloc8_service_start) &&
-                   (_octets[IPV6_ADDR_SIZE - 1] <= aloc8_service_end);
+                   octet15 >= aloc8_service_start &&
+                   octet15 <= aloc8_service_end;
         }
 
         /**
@@ -785,11 +793,7 @@ namespace webpp {
             // 16: --0-- --1-- --2-- --3-- --4-- --5-- --6-- --7--
             // 32: -----0----- -----1----- -----2----- -----3-----
             // 64: -----------0----------- -----------1-----------
-            auto _octets = octets();
-            return (_octets[8] == 0) && (_octets[9] == 0) &&
-                   (_octets[10] == 0) && (_octets[11] == 0) &&
-                   (_octets[12] == 0) && (_octets[13] == 0) &&
-                   (_octets[14] == 0) && (_octets[15] == 0);
+            return data[1] == 0;
         }
 
         /**
@@ -809,11 +813,7 @@ namespace webpp {
             // 16: --0-- --1-- --2-- --3-- --4-- --5-- --6-- --7--
             // 32: -----0----- -----1----- -----2----- -----3-----
             // 64: -----------0----------- -----------1-----------
-            auto _octets = octets8();
-            return _octets[8] == 0xFD && _octets[15] == 0x80 &&
-                   (_octets[9] == 0xFFu) && (_octets[10] == 0xFFu) &&
-                   (_octets[11] == 0xFFu) && (_octets[12] == 0xFFu) &&
-                   (_octets[13] == 0xFFu) && (_octets[14] == 0xFFu);
+            return data[1] == 0xFDFF'FFFF'FFFF'FF80u;
         }
 
         /**
@@ -831,44 +831,30 @@ namespace webpp {
         }
 
         /**
-         * This method returns a pointer to the Interface Identifier.
-         * @returns A pointer to the Interface Identifier.
+         * This method returns the Interface Identifier (the last 64 bits).
+         * @returns The Interface Identifier.
          */
-        octets8_t::iterator iid() noexcept {
-            return data.begin() + interface_identifier_offset;
-        }
-
-        /**
-         * This method returns a pointer to the Interface Identifier.
-         * @returns A pointer to the Interface Identifier.
-         */
-        octets8_t::const_iterator iid() const noexcept {
-            return data.cbegin() + interface_identifier_offset;
+        [[nodiscard]] constexpr uint64_t iid() const noexcept {
+            return data[1];
         }
 
         /**
          * This method sets the Interface Identifier.
-         * @param piid A reference to the Interface Identifier.
+         * @param piid A pointer to the 8 bytes of the Interface Identifier.
          */
         void iid(const uint8_t* piid) noexcept {
-            auto _end = piid + interface_identifier_size;
-            auto _iid = iid();
-            for (auto it = piid; it != _end; it++) {
-                *_iid++ = *it;
-            }
+            uint64_t _iid = 0;
+            for (auto it = piid; it != piid + interface_identifier_size; it++)
+                _iid = _iid << 8u | *it;
+            data[1] = _iid;
         }
 
         /**
          * This method sets the Interface Identifier.
-         * @param A reference to the Interface Identifier.
+         * @param _iid The Interface Identifier.
          */
-        void iid(const octets8_t::const_iterator& piid) noexcept {
-            auto _iid = iid();
-            auto _end = _iid + interface_identifier_size;
-            auto pit  = piid;
-            for (auto it = _iid; it != _end; it++) {
-                *it = *pit++;
-            }
+        void iid(uint64_t _iid) noexcept {
+            data[1] = _iid;
         }
 
         //        /**
@@ -935,94 +921,83 @@ namespace webpp {
         }
 
         /**
-         * @brief return the short string representation of ip version 6
-         * TODO: all zero ip prints in a wrong format
+         * The size of a buffer that any ip fits in, with a null at the end
+         * (INET6_ADDRSTRLEN)
          */
-        string_type short_str() const noexcept {
-            auto _octets = octets16();
-
-            // finding all of the ranges that are zero filled
-            typename decltype(
-              _octets)::const_iterator range_start = _octets.cend(),
-                                       range_end   = _octets.cend(), start,
-                                       finish      = _octets.cbegin();
-            do {
-                start = stl::find(finish, _octets.cend(), 0u);
-                if (start == _octets.cend()) {
-                    break;
-                }
-                finish = stl::find_if(start, _octets.cend(), [](auto const& a) {
-                    return a != 0;
-                });
-                if (range_start == _octets.cend() ||
-                    stl::distance(start, finish) >
-                      stl::distance(range_start, range_end)) {
-                    range_start = start;
-                    range_end   = finish;
-                }
-            } while (finish != _octets.cend());
-
-
-
-
-
-            // generating short string representation of the ip version 6
-
-            // I'm not gonna use std::string here because most small object
-            // optimizations are smaller than 48bit (16 or 20 mostly)
-            char_type   buffer[IPV6_ADDR_SIZE * 2 + (IPV6_ADDR_SIZE - 1) + 1];
-            stl::size_t index = 0;
-
-
-            auto append_to_buffer = [&](uint16_t octet) {
-                constexpr auto hex_table =
-                  "000102030405060708090a0b0c0d0e0f1011"
-                  "12131415161718191a1b1c1d1e1f20212223"
-                  "2425262728292a2b2c2d2e2f303132333435"
-                  "363738393a3b3c3d3e3f4041424344454647"
-                  "48494a4b4c4d4e4f50515253545556575859"
-                  "5a5b5c5d5e5f606162636465666768696a6b"
-                  "6c6d6e6f707172737475767778797a7b7c7d"
-                  "7e7f808182838485868788898a8b8c8d8e8f"
-                  "909192939495969798999a9b9c9d9e9fa0a1"
-                  "a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3"
-                  "b4b5b6b7b8b9babbbcbdbebfc0c1c2c3c4c5"
-                  "c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7"
-                  "d8d9dadbdcdddedfe0e1e2e3e4e5e6e7e8e9"
-                  "eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafb"
-                  "fcfdfeff";
-                auto hex_val = hex_table + octet;
-                if (octet > 0xfu)
-                    buffer[index++] = *hex_val;
-                ++hex_val;
-                buffer[index++] = *hex_val;
-            };
-
-            auto it = _octets.cbegin();
+        static constexpr stl::size_t max_str_size = 46;
 
-            // [0, range_start)
-            while (it != range_start) {
-                append_to_buffer(*it);
-                if (++it != range_start)
-                    buffer[index++] = ':';
-            }
-
-            // [range_start, range_end)
-            if (it != range_end) {
-                buffer[index++] = ':';
-                buffer[index++] = ':';
-                it              = range_end;
+        /**
+         * Write the canonical text representation of the ip (RFC 5952) into
+         * the buffer, which should have room for max_str_size - 1 chars (no
+         * null is written): lower case hex digits with no leading zeros, the
+         * longest run of two or more zero groups (the first one of the
+         * longest ones) written as "::", and the ipv4-mapped ips with the
+         * ipv4 at the end ("::ffff:192.0.2.1").
+         * @returns the end of what's written
+         */
+        constexpr char_type* to_chars(char_type* out) const noexcept {
+            constexpr char_type digits[] = {'0', '1', '2', '3', '4', '5',
+                                            '6', '7', '8', '9', 'a', 'b',
+                                            'c', 'd', 'e', 'f'};
+            auto const          groups   = octets16();
+            bool const          mapped   = groups[0] == 0 && groups[1] == 0 &&
+                               groups[2] == 0 && groups[3] == 0 &&
+                               groups[4] == 0 && groups[5] == 0xFFFFu;
+            int const hex_groups = mapped ? 6 : 8;
+
+            // the longest run of the zero groups, from the bits of the zero
+            // groups
+            unsigned zeros = 0;
+            for (int i = 0; i < hex_groups; i++)
+                zeros |= static_cast<unsigned>(
+                           groups[static_cast<stl::size_t>(i)] == 0)
+                         << i;
+            auto const run       = details::zero_runs[zeros];
+            int const  run_start = run.start;
+            int const  run_end   = run.start + run.size;
+
+            for (int i = 0; i < hex_groups;) {
+                if (i == run_start) {
+                    *out++ = ':';
+                    *out++ = ':';
+                    i      = run_end;
+                    continue;
+                }
+                if (i != 0 && i != run_end)
+                    *out++ = ':';
+                // no leading zeros
+                auto const group = groups[static_cast<stl::size_t>(i++)];
+                auto const width =
+                  stl::max<int>(1, (stl::bit_width(group) + 3) / 4);
+                for (int shift = (width - 1) * 4; shift >= 0; shift -= 4)
+                    *out++ = digits[(group >> shift) & 0xFu];
             }
 
-            // [range_end, end)
-            while (it != _octets.cend()) {
-                append_to_buffer(*it);
-                if (++it != _octets.cend())
-                    buffer[index++] = ':';
+            if (mapped) {
+                if (run_end != 6)
+                    *out++ = ':';
+                for (stl::size_t i = 12; i < 16; i++) {
+                    auto const octet = data[1] >> (8u * (15u - i)) & 0xFFu;
+                    if (octet >= 100)
+                        *out++ = digits[octet / 100];
+                    if (octet >= 10)
+                        *out++ = digits[octet / 10 % 10];
+                    *out++ = digits[octet % 10];
+                    if (i != 15)
+                        *out++ = '.';
+                }
             }
+            return out;
+        }
 
-            buffer[index++] = '\0';
-            return string_type(buffer, index);
+        /**
+         * @brief return the short string representation of ip version 6
+         * (see to_chars)
+         */
+        string_type short_str() const noexcept {
+            char_type  buffer[max_str_size];
+            auto const end = to_chars(buffer);
+            return string_type(buffer, static_cast<stl::size_t>(end - buffer));
         }
 
         /**
@@ -1065,14 +1040,39 @@ namespace webpp {
          * @return
          */
         [[nodiscard]] ipv6 reversed() const noexcept {
-            return ipv6{octets_t{data[14], data[15], data[12], data[13],
-                                 data[10], data[11], data[8], data[9], data[6],
-                                 data[7], data[4], data[5], data[2], data[3],
-                                 data[0], data[1]},
-                        _prefix};
+            auto groups = octets16();
+            stl::reverse(groups.begin(), groups.end());
+            return ipv6{groups, _prefix};
         }
     };
 
 } // namespace webpp
 
+#ifdef WEBPP_EXTERN_TEMPLATES
+#    include "../traits/std_traits.hpp"
+namespace webpp {
+    // compiled once, in the library (see src/instances.cpp)
+    extern template class ipv6<std_traits>;
+} // namespace webpp
+#endif
+
+namespace std {
+
+    /**
+     * The hash of an ipv6 mixes its two words and its prefix, so it can be
+     * a key of the unordered containers.
+     */
+    template <webpp::Traits TraitsType>
+    struct hash<webpp::ipv6<TraitsType>> {
+        [[nodiscard]] size_t
+        operator()(webpp::ipv6<TraitsType> const& ip) const noexcept {
+            auto const words = ip.octets64();
+            auto res = words[0] * 0x9E37'79B9'7F4A'7C15u ^ words[1];
+            res      = (res ^ (res >> 31u)) * 0xBF58'476D'1CE4'E5B9u;
+            return static_cast<size_t>(res ^ (res >> 32u) ^ ip.prefix());
+        }
+    };
+
+} // namespace std
+
 #endif // WEBPP_IPV6_H
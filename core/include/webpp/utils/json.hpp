@@ -1,5 +1,1197 @@
 #ifndef WEBPP_JSON_HPP
 #define WEBPP_JSON_HPP
 
+#include "../std/std.hpp"
+#include "./utf8.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#    define WEBPP_JSON_SCANNER_WIDTH 32
+#elif defined(__SSE2__)
+#    include <emmintrin.h>
+#    define WEBPP_JSON_SCANNER_WIDTH 16
+#else
+#    define WEBPP_JSON_SCANNER_WIDTH 1
+#endif
+
+/**
+ * A JSON writer and reader without a DOM: the writer serializes the values
+ * (the numbers, the strings, the containers, and the types that say how;
+ * see to_json) right into the output string, and the reader is a pull
+ * parser that gives the tokens one by one, in place. The document is for
+ * the big inputs that only a few values are wanted from: it's indexed in
+ * one pass, and the values are found by jumping over the rest.
+ */
+namespace webpp::json {
+
+    /**
+     * Finds the bytes of a string that JSON doesn't let in as they are: the
+     * quote, the backslash, and the control characters. 16 (SSE2) or 32
+     * (AVX2) bytes at a time, like the header sanitizer; almost all of the
+     * strings don't have any, so they're copied in one go.
+     */
+    struct escape_scanner {
+        static constexpr stl::size_t width = WEBPP_JSON_SCANNER_WIDTH;
+
+        [[nodiscard]] static constexpr bool needs_escape(char c) noexcept {
+            return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20u;
+        }
+
+        /**
+         * The position of the first byte that should be escaped at or after
+         * "pos"; npos if there's none.
+         */
+        [[nodiscard]] static constexpr stl::size_t find(stl::string_view data, stl::size_t pos = 0) noexcept {
+#if WEBPP_JSON_SCANNER_WIDTH > 1
+            if (!stl::is_constant_evaluated()) {
+                auto const* const begin = data.data();
+#    if WEBPP_JSON_SCANNER_WIDTH == 32
+                auto const quote     = _mm256_set1_epi8('"');
+                auto const backslash = _mm256_set1_epi8('\\');
+                auto const control   = _mm256_set1_epi8(0x1F);
+                for (; pos + width <= data.size(); pos += width) {
+                    auto const chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(begin + pos));
+                    // c <= 0x1F (unsigned) is max(c, 0x1F) == 0x1F
+                    auto const eq = _mm256_or_si256(
+                      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)),
+                      _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, control), control));
+                    auto const mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+                    if (mask != 0)
+                        return pos + static_cast<stl::size_t>(__builtin_ctz(mask));
+                }
+#    else
+                auto const quote     = _mm_set1_epi8('"');
+                auto const backslash = _mm_set1_epi8('\\');
+                auto const control   = _mm_set1_epi8(0x1F);
+                for (; pos + width <= data.size(); pos += width) {
+                    auto const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(begin + pos));
+                    // c <= 0x1F (unsigned) is max(c, 0x1F) == 0x1F
+                    auto const eq =
+                      _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                                   _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+                    auto const mask = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+                    if (mask != 0)
+                        return pos + static_cast<stl::size_t>(__builtin_ctz(mask));
+                }
+#    endif
+            }
+#endif
+            for (; pos < data.size(); pos++)
+                if (needs_escape(data[pos]))
+                    return pos;
+            return stl::string_view::npos;
+        }
+    };
+
+    /**
+     * Append the string, quoted and escaped
+     */
+    template <typename StringType>
+    constexpr void write_string(StringType& out, stl::string_view str) noexcept {
+        constexpr stl::string_view hex = "0123456789abcdef";
+        out.push_back('"');
+        stl::size_t start = 0;
+        for (;;) {
+            auto const pos = escape_scanner::find(str, start);
+            if (pos == stl::string_view::npos) {
+                out.append(str.data() + start, str.size() - start);
+                break;
+            }
+            out.append(str.data() + start, pos - start);
+            switch (auto const c = str[pos]) {
+                case '"': out.append("\\\""); break;
+                case '\\': out.append("\\\\"); break;
+                case '\b': out.append("\\b"); break;
+                case '\f': out.append("\\f"); break;
+                case '\n': out.append("\\n"); break;
+                case '\r': out.append("\\r"); break;
+                case '\t': out.append("\\t"); break;
+                default:
+                    out.append("\\u00");
+                    out.push_back(hex[static_cast<unsigned char>(c) >> 4u]);
+                    out.push_back(hex[static_cast<unsigned char>(c) & 0xFu]);
+            }
+            start = pos + 1;
+        }
+        out.push_back('"');
+    }
+
+    template <typename StringType>
+    class writer;
+
+    namespace details {
+        template <typename T>
+        concept string_like = stl::is_convertible_v<T const&, stl::string_view>;
+
+        template <typename T>
+        concept optional_like = requires(T const& val) {
+            val.has_value();
+            *val;
+            typename T::value_type;
+        };
+
+        // a map: a range of pairs with string keys
+        template <typename T>
+        concept map_like = stl::ranges::input_range<T> && requires(stl::ranges::range_value_t<T> const& item) {
+            { item.first } -> string_like;
+            item.second;
+        };
+
+        template <typename T, typename StringType>
+        concept has_member_to_json = requires(T const& val, writer<StringType>& out) {
+            val.to_json(out);
+        };
+
+        template <typename T, typename StringType>
+        concept has_adl_to_json = requires(T const& val, writer<StringType>& out) {
+            to_json(out, val);
+        };
+    } // namespace details
+
+    /**
+     * Writes the values into the string as they come; nothing is built in
+     * between. The commas are put in by the writer.
+     *
+     *   json::writer out{res_string};
+     *   out.begin_object();
+     *   out.member("id", 12).member("tags", tags);
+     *   out.end_object();
+     *
+     * A type says how it's written with a "to_json(writer&) const" member or
+     * a "to_json(writer&, T const&)" function that ADL finds.
+     */
+    template <typename StringType>
+    class writer {
+        StringType&   out;
+        stl::uint64_t levels    = 0; // one bit for each level: there's an item before the next one
+        bool          after_key = false;
+
+        constexpr void separate() noexcept {
+            if (after_key) {
+                after_key = false;
+                return;
+            }
+            if (levels & 1u)
+                out.push_back(',');
+            levels |= 1u;
+        }
+
+        template <typename T>
+        constexpr void write_number(T val) noexcept {
+            if constexpr (stl::is_floating_point_v<T>) {
+                if (!stl::isfinite(val)) {
+                    out.append("null"); // JSON has no NaN or infinity
+                    return;
+                }
+            }
+            char       buf[32];
+            auto const res = stl::to_chars(buf, buf + sizeof(buf), val);
+            out.append(buf, static_cast<stl::size_t>(res.ptr - buf));
+        }
+
+      public:
+        constexpr explicit writer(StringType& output) noexcept : out{output} {}
+
+        [[nodiscard]] constexpr StringType& output() noexcept {
+            return out;
+        }
+
+        constexpr writer& begin_object() noexcept {
+            separate();
+            out.push_back('{');
+            levels <<= 1u; // nesting deeper than 64 levels loses its commas
+            return *this;
+        }
+
+        constexpr writer& end_object() noexcept {
+            levels >>= 1u;
+            out.push_back('}');
+            return *this;
+        }
+
+        constexpr writer& begin_array() noexcept {
+            separate();
+            out.push_back('[');
+            levels <<= 1u;
+            return *this;
+        }
+
+        constexpr writer& end_array() noexcept {
+            levels >>= 1u;
+            out.push_back(']');
+            return *this;
+        }
+
+        /**
+         * The key of the next member of the object
+         */
+        constexpr writer& key(stl::string_view name) noexcept {
+            separate();
+            write_string(out, name);
+            out.push_back(':');
+            after_key = true;
+            return *this;
+        }
+
+        template <typename T>
+        constexpr writer& member(stl::string_view name, T const& val) noexcept {
+            return key(name).value(val);
+        }
+
+        /**
+         * Write the bytes as they are; they should be valid JSON
+         */
+        constexpr writer& raw(stl::string_view json) noexcept {
+            separate();
+            out.append(json.data(), json.size());
+            return *this;
+        }
+
+        template <typename T>
+        constexpr writer& value(T const& val) noexcept {
+            if constexpr (details::has_member_to_json<T, StringType>) {
+                val.to_json(*this);
+            } else if constexpr (details::has_adl_to_json<T, StringType>) {
+                to_json(*this, val);
+            } else if constexpr (stl::same_as<T, stl::nullptr_t> || stl::same_as<T, stl::nullopt_t>) {
+                separate();
+                out.append("null");
+            } else if constexpr (stl::same_as<T, bool>) {
+                separate();
+                out.append(val ? "true" : "false");
+            } else if constexpr (stl::is_arithmetic_v<T> && !stl::same_as<T, char>) {
+                separate();
+                write_number(val);
+            } else if constexpr (details::string_like<T>) {
+                separate();
+                write_string(out, stl::string_view{val});
+            } else if constexpr (stl::same_as<T, char>) {
+                separate();
+                write_string(out, stl::string_view{&val, 1});
+            } else if constexpr (details::optional_like<T>) {
+                if (val.has_value()) {
+                    value(*val);
+                } else {
+                    separate();
+                    out.append("null");
+                }
+            } else if constexpr (details::map_like<T>) {
+                begin_object();
+                for (auto const& [name, item] : val)
+                    key(name).value(item);
+                end_object();
+            } else if constexpr (stl::ranges::input_range<T>) {
+                begin_array();
+                for (auto const& item : val)
+                    value(item);
+                end_array();
+            } else {
+                static_assert(stl::is_void_v<T>, "The type can't be written as JSON; give it a to_json.");
+            }
+            return *this;
+        }
+    };
+
+    template <typename StringType>
+    writer(StringType&) -> writer<StringType>;
+
+    /**
+     * Append the value to the string as JSON
+     */
+    template <typename StringType, typename T>
+    constexpr void serialize(StringType& out, T const& val) noexcept {
+        writer<StringType>{out}.value(val);
+    }
+
+    enum struct token : stl::uint8_t {
+        begin_object,
+        end_object,
+        begin_array,
+        end_array,
+        key,     // the name of a member; the value comes next
+        string,
+        number,
+        boolean,
+        null,
+        end,     // the document is over
+        error
+    };
+
+    /**
+     * A pull parser: each "next" is the next token of the document, and the
+     * values are read from the input in place (see raw, string_value,
+     * number_value). It checks the syntax as it goes; the first error is the
+     * last token.
+     */
+    class reader {
+        enum struct state : stl::uint8_t {
+            value,          // a value (the start of the document, or after ':' or ',' in an array)
+            first_value,    // a value or ']'
+            first_key,      // a key or '}'
+            key,            // a key (after ',' in an object)
+            colon,          // ':' after a key
+            comma_or_close, // ',' or the end of the array or the object
+            done
+        };
+
+        stl::string_view input;
+        stl::size_t      pos   = 0;
+        stl::uint64_t    kinds = 0; // one bit for each level: 1 is an object, 0 an array
+        stl::size_t      depth = 0;
+        state            expect      = state::value;
+        stl::string_view token_text  = {};
+        bool             has_escapes = false;
+        token            last        = token::end;
+
+        constexpr void skip_space() noexcept {
+            while (pos < input.size() &&
+                   (input[pos] == ' ' || input[pos] == '\n' || input[pos] == '\r' || input[pos] == '\t'))
+                pos++;
+        }
+
+        constexpr token fail() noexcept {
+            expect = state::done;
+            return last = token::error;
+        }
+
+        // after a value: what comes next depends on what we're in
+        constexpr void after_value() noexcept {
+            expect = depth == 0 ? state::done : state::comma_or_close;
+        }
+
+        constexpr bool scan_string() noexcept {
+            auto const start = ++pos;
+            has_escapes      = false;
+            for (;;) {
+                pos = escape_scanner::find(input, pos);
+                if (pos == stl::string_view::npos)
+                    return false;
+                auto const c = input[pos];
+                if (c == '"')
+                    break;
+                if (c != '\\' || pos + 1 >= input.size())
+                    return false; // the control characters should be escaped
+                has_escapes = true;
+                pos += 2;
+            }
+            token_text = input.substr(start, pos - start);
+            pos++;
+            return true;
+        }
+
+        [[nodiscard]] static constexpr bool is_digit(char c) noexcept {
+            return c >= '0' && c <= '9';
+        }
+
+        constexpr bool scan_number() noexcept {
+            auto const start = pos;
+            if (input[pos] == '-')
+                pos++;
+            if (pos >= input.size() || !is_digit(input[pos]))
+                return false;
+            if (input[pos] == '0') {
+                pos++;
+            } else {
+                while (pos < input.size() && is_digit(input[pos]))
+                    pos++;
+            }
+            if (pos < input.size() && input[pos] == '.') {
+                if (++pos >= input.size() || !is_digit(input[pos]))
+                    return false;
+                while (pos < input.size() && is_digit(input[pos]))
+                    pos++;
+            }
+            if (pos < input.size() && (input[pos] == 'e' || input[pos] == 'E')) {
+                pos++;
+                if (pos < input.size() && (input[pos] == '+' || input[pos] == '-'))
+                    pos++;
+                if (pos >= input.size() || !is_digit(input[pos]))
+                    return false;
+                while (pos < input.size() && is_digit(input[pos]))
+                    pos++;
+            }
+            token_text = input.substr(start, pos - start);
+            return true;
+        }
+
+        constexpr bool scan_literal(stl::string_view literal) noexcept {
+            if (input.substr(pos, literal.size()) != literal)
+                return false;
+            token_text = input.substr(pos, literal.size());
+            pos += literal.size();
+            return true;
+        }
+
+        constexpr token open(bool object) noexcept {
+            if (depth == 64)
+                return fail(); // too deep
+            kinds = (kinds << 1u) | (object ? 1u : 0u);
+            depth++;
+            pos++;
+            expect = object ? state::first_key : state::first_value;
+            return last = object ? token::begin_object : token::begin_array;
+        }
+
+        constexpr token close(char c) noexcept {
+            bool const object = (kinds & 1u) != 0;
+            if (depth == 0 || c != (object ? '}' : ']'))
+                return fail();
+            kinds >>= 1u;
+            depth--;
+            pos++;
+            after_value();
+            return last = object ? token::end_object : token::end_array;
+        }
+
+        constexpr token read_value() noexcept {
+            switch (input[pos]) {
+                case '{': return open(true);
+                case '[': return open(false);
+                case '"':
+                    if (!scan_string())
+                        return fail();
+                    after_value();
+                    return last = token::string;
+                case 't':
+                case 'f':
+                    if (!scan_literal(input[pos] == 't' ? "true" : "false"))
+                        return fail();
+                    after_value();
+                    return last = token::boolean;
+                case 'n':
+                    if (!scan_literal("null"))
+                        return fail();
+                    after_value();
+                    return last = token::null;
+                default:
+                    if (!scan_number())
+                        return fail();
+                    after_value();
+                    return last = token::number;
+            }
+        }
+
+      public:
+        constexpr explicit reader(stl::string_view json) noexcept : input{json} {}
+
+        /**
+         * The next token
+         */
+        constexpr token next() noexcept {
+            if (last == token::error)
+                return last;
+            for (;;) {
+                skip_space();
+                if (expect == state::done) {
+                    if (pos != input.size())
+                        return fail(); // something after the document
+                    return last = token::end;
+                }
+                if (pos >= input.size())
+                    return fail();
+                auto const c = input[pos];
+                switch (expect) {
+                    case state::first_value:
+                        if (c == ']')
+                            return close(c);
+                        [[fallthrough]];
+                    case state::value: return read_value();
+                    case state::first_key:
+                        if (c == '}')
+                            return close(c);
+                        [[fallthrough]];
+                    case state::key:
+                        if (c != '"' || !scan_string())
+                            return fail();
+                        expect = state::colon;
+                        return last = token::key;
+                    case state::colon:
+                        if (c != ':')
+                            return fail();
+                        pos++;
+                        expect = state::value;
+                        continue;
+                    case state::comma_or_close:
+                        if (c == ',') {
+                            pos++;
+                            expect = (kinds & 1u) ? state::key : state::value;
+                            continue;
+                        }
+                        return close(c);
+                    default: return fail();
+                }
+            }
+        }
+
+        /**
+         * The text of the last token, in the input; the strings and the keys
+         * are without their quotes, and they're still escaped (see
+         * string_value).
+         */
+        [[nodiscard]] constexpr stl::string_view raw() const noexcept {
+            return token_text;
+        }
+
+        /**
+         * The string or the key has escapes in it; its raw text is not its
+         * value then.
+         */
+        [[nodiscard]] constexpr bool escaped() const noexcept {
+            return has_escapes;
+        }
+
+        [[nodiscard]] constexpr bool bool_value() const noexcept {
+            return token_text == "true";
+        }
+
+        /**
+         * The last string or key, unescaped, appended to "out"
+         * @returns false if it has an invalid escape
+         */
+        template <typename StringType>
+        constexpr bool string_value(StringType& out) const noexcept {
+            auto const str = token_text;
+            if (!has_escapes) {
+                out.append(str.data(), str.size());
+                return true;
+            }
+            auto const hex_value = [](stl::string_view digits) constexpr noexcept -> long {
+                long code = 0;
+                for (char const c : digits) {
+                    code <<= 4;
+                    if (c >= '0' && c <= '9')
+                        code |= c - '0';
+                    else if (c >= 'a' && c <= 'f')
+                        code |= c - 'a' + 10;
+                    else if (c >= 'A' && c <= 'F')
+                        code |= c - 'A' + 10;
+                    else
+                        return -1;
+                }
+                return code;
+            };
+            for (stl::size_t i = 0; i < str.size(); i++) {
+                if (str[i] != '\\') {
+                    out.push_back(str[i]);
+                    continue;
+                }
+                switch (str[++i]) {
+                    case '"': out.push_back('"'); break;
+                    case '\\': out.push_back('\\'); break;
+                    case '/': out.push_back('/'); break;
+                    case 'b': out.push_back('\b'); break;
+                    case 'f': out.push_back('\f'); break;
+                    case 'n': out.push_back('\n'); break;
+                    case 'r': out.push_back('\r'); break;
+                    case 't': out.push_back('\t'); break;
+                    case 'u': {
+                        if (i + 4 >= str.size())
+                            return false;
+                        auto code = hex_value(str.substr(i + 1, 4));
+                        i += 4;
+                        if (code < 0 || (code >= 0xDC00 && code <= 0xDFFF))
+                            return false;
+                        if (code >= 0xD800 && code <= 0xDBFF) {
+                            // a surrogate pair
+                            if (i + 6 >= str.size() || str[i + 1] != '\\' || str[i + 2] != 'u')
+                                return false;
+                            auto const low = hex_value(str.substr(i + 3, 4));
+                            if (low < 0xDC00 || low > 0xDFFF)
+                                return false;
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                            i += 6;
+                        }
+                        // UTF-8
+                        if (code < 0x80) {
+                            out.push_back(static_cast<char>(code));
+                        } else if (code < 0x800) {
+                            out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                        } else if (code < 0x10000) {
+                            out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                        } else {
+                            out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+                            out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+                            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                        }
+                        break;
+                    }
+                    default: return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * The last number
+         * @returns false if it doesn't fit into T (or it's not an integer and
+         * T is)
+         */
+        template <typename T>
+        requires(stl::is_arithmetic_v<T>)
+        bool number_value(T& out) const noexcept {
+            auto const* const end = token_text.data() + token_text.size();
+            auto const        res = stl::from_chars(token_text.data(), end, out);
+            return res.ec == stl::errc{} && res.ptr == end;
+        }
+
+        /**
+         * Skip the value that the last token started (the whole object or
+         * array if it's the start of one)
+         * @returns false if there's an error in it
+         */
+        constexpr bool skip() noexcept {
+            if (last == token::key)
+                next();
+            if (last != token::begin_object && last != token::begin_array)
+                return last != token::error;
+            auto const level = depth;
+            while (depth >= level) {
+                if (next() == token::error)
+                    return false;
+            }
+            return true;
+        }
+
+        [[nodiscard]] constexpr stl::size_t position() const noexcept {
+            return pos;
+        }
+    };
+
+    namespace details {
+
+        /**
+         * The bits of a block of 64 bytes: the quotes, the backslashes, and
+         * the structural characters ({}[]:,) wherever they are
+         */
+        struct block_masks {
+            stl::uint64_t quotes      = 0;
+            stl::uint64_t backslashes = 0;
+            stl::uint64_t operators   = 0;
+        };
+
+        [[nodiscard]] inline block_masks classify_block(char const* block) noexcept {
+            block_masks masks;
+#if WEBPP_JSON_SCANNER_WIDTH > 1
+            for (stl::size_t i = 0; i < 64; i += WEBPP_JSON_SCANNER_WIDTH) {
+                // '[' | 0x20 is '{' and ']' | 0x20 is '}', so the brackets are two compares
+#    if WEBPP_JSON_SCANNER_WIDTH == 32
+                auto const chunk  = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(block + i));
+                auto const folded = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+                auto const ops    = _mm256_or_si256(
+                  _mm256_or_si256(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')),
+                                  _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'))),
+                  _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(':')),
+                                  _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(','))));
+                auto const bits = [](__m256i eq) noexcept {
+                    return static_cast<stl::uint64_t>(static_cast<stl::uint32_t>(_mm256_movemask_epi8(eq)));
+                };
+                masks.quotes |= bits(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'))) << i;
+                masks.backslashes |= bits(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'))) << i;
+                masks.operators |= bits(ops) << i;
+#    else
+                auto const chunk  = _mm_loadu_si128(reinterpret_cast<__m128i const*>(block + i));
+                auto const folded = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+                auto const ops =
+                  _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')),
+                                            _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))),
+                               _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(':')),
+                                            _mm_cmpeq_epi8(chunk, _mm_set1_epi8(','))));
+                auto const bits = [](__m128i eq) noexcept {
+                    return static_cast<stl::uint64_t>(static_cast<stl::uint32_t>(_mm_movemask_epi8(eq)));
+                };
+                masks.quotes |= bits(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'))) << i;
+                masks.backslashes |= bits(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))) << i;
+                masks.operators |= bits(ops) << i;
+#    endif
+            }
+#else
+            for (stl::size_t i = 0; i < 64; i++) {
+                auto const c   = block[i];
+                auto const bit = stl::uint64_t{1} << i;
+                if (c == '"')
+                    masks.quotes |= bit;
+                else if (c == '\\')
+                    masks.backslashes |= bit;
+                else if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',')
+                    masks.operators |= bit;
+            }
+#endif
+            return masks;
+        }
+
+        /**
+         * The characters that come right after an odd run of backslashes (the
+         * escaped ones); "prev_odd" carries a run that's cut at the end of
+         * the block over to the next one. The carries of the additions end
+         * the runs: a run that starts on an even bit and ends on an odd one
+         * (or the other way around) is odd.
+         */
+        [[nodiscard]] inline stl::uint64_t escaped_bits(stl::uint64_t  backslashes,
+                                                        stl::uint64_t& prev_odd) noexcept {
+            constexpr stl::uint64_t even_bits = 0x5555'5555'5555'5555ull;
+            if (backslashes == 0) {
+                return stl::exchange(prev_odd, 0);
+            }
+            auto const    starts          = backslashes & ~(backslashes << 1u);
+            auto const    even_start_mask = even_bits ^ prev_odd;
+            auto const    even_starts     = starts & even_start_mask;
+            auto const    odd_starts      = starts & ~even_start_mask;
+            auto const    even_carries    = backslashes + even_starts;
+            stl::uint64_t odd_carries     = 0;
+            bool const    ends_odd        = __builtin_add_overflow(backslashes, odd_starts, &odd_carries);
+            odd_carries |= prev_odd;
+            prev_odd = ends_odd ? 1u : 0u;
+            auto const even_ends = even_carries & ~backslashes;
+            auto const odd_ends  = odd_carries & ~backslashes;
+            return (even_ends & ~even_bits) | (odd_ends & even_bits);
+        }
+
+        /**
+         * Each bit is the xor of itself and all the bits below it; between an
+         * opening quote and its closing one it's 1.
+         */
+        [[nodiscard]] constexpr stl::uint64_t prefix_xor(stl::uint64_t bits) noexcept {
+            bits ^= bits << 1u;
+            bits ^= bits << 2u;
+            bits ^= bits << 4u;
+            bits ^= bits << 8u;
+            bits ^= bits << 16u;
+            bits ^= bits << 32u;
+            return bits;
+        }
+
+        /**
+         * The first pass of the document: the positions of the structural
+         * characters that are not in the strings, and the quotes of the
+         * strings, in "out" (which has room for one for each byte).
+         * @returns how many there are; npos if a string is not closed
+         */
+        inline stl::size_t find_structurals(stl::string_view json, stl::uint32_t* out) noexcept {
+            stl::size_t   count     = 0;
+            stl::uint64_t prev_odd  = 0;
+            stl::uint64_t in_string = 0; // all ones if the last block ended in a string
+            for (stl::size_t base = 0; base < json.size(); base += 64) {
+                char const* block = json.data() + base;
+                char        tail[64];
+                if (json.size() - base < 64) {
+                    stl::memset(tail, ' ', sizeof(tail));
+                    stl::memcpy(tail, block, json.size() - base);
+                    block = tail;
+                }
+                auto const masks   = classify_block(block);
+                auto const quotes  = masks.quotes & ~escaped_bits(masks.backslashes, prev_odd);
+                auto const strings = prefix_xor(quotes) ^ in_string;
+                in_string          = static_cast<stl::uint64_t>(static_cast<stl::int64_t>(strings) >> 63);
+
+                auto  bits = (masks.operators & ~strings) | quotes;
+                auto* it   = out + count;
+                count += static_cast<stl::size_t>(__builtin_popcountll(bits));
+                for (; bits != 0; bits &= bits - 1) {
+                    *it++ = static_cast<stl::uint32_t>(base + static_cast<unsigned>(__builtin_ctzll(bits)));
+                }
+            }
+            return in_string != 0 ? stl::string_view::npos : count;
+        }
+
+    } // namespace details
+
+    enum struct kind : stl::uint8_t { object, array, string, number, boolean, null, invalid };
+
+    class element;
+
+    /**
+     * A document that's only parsed as far as it's read, for the handlers
+     * that want a few values out of a big body:
+     *
+     *   json::document doc;
+     *   if (doc.parse(body)) {
+     *       auto const name = doc["user"]["name"].raw(); // a view into the body
+     *   }
+     *
+     * "parse" finds the structural characters ({}[]:, and the quotes) in
+     * one vectorized pass, and matches the brackets; there's no tree. An
+     * element is found by going over the members before it, and jumping
+     * over their values. The syntax of the values is checked when they're
+     * read; a broken value that's jumped over is not noticed.
+     *
+     * The text is not copied; it should outlive the elements. The memory of
+     * the index is kept for the next parse.
+     */
+    class document {
+        friend class element;
+
+        static constexpr stl::size_t max_depth = 64; // like the reader
+
+        stl::string_view                  text{};
+        stl::unique_ptr<stl::uint32_t[]> indexes{}; // the positions of the structural characters
+        stl::unique_ptr<stl::uint32_t[]> jumps{};   // for '{' and '[', the index of the closing one
+        stl::size_t                       capacity = 0;
+        stl::size_t                       count    = 0;
+        bool                              valid    = false;
+
+        [[nodiscard]] char char_at(stl::size_t index) const noexcept {
+            return index < count ? text[indexes[index]] : '\0';
+        }
+
+        [[nodiscard]] bool match_brackets() noexcept {
+            stl::uint32_t opens[max_depth];
+            stl::size_t   depth = 0;
+            for (stl::size_t i = 0; i < count; i++) {
+                switch (auto const c = text[indexes[i]]) {
+                    case '{':
+                    case '[':
+                        if (depth == max_depth)
+                            return false;
+                        opens[depth++] = static_cast<stl::uint32_t>(i);
+                        break;
+                    case '}':
+                    case ']': {
+                        if (depth == 0)
+                            return false;
+                        auto const open = opens[--depth];
+                        if (text[indexes[open]] != (c == '}' ? '{' : '['))
+                            return false;
+                        jumps[open] = static_cast<stl::uint32_t>(i);
+                        break;
+                    }
+                    case '"': i++; break; // the closing quote is the next one
+                    default: break;
+                }
+            }
+            return depth == 0;
+        }
+
+        // the value that starts at "pos" (or after the spaces), "next" being
+        // the index of the first structural character at or after it
+        [[nodiscard]] inline element value_at(stl::size_t pos, stl::size_t next) const noexcept;
+
+      public:
+        document() noexcept = default;
+
+        /**
+         * Index the text
+         * @returns false if the strings or the brackets are not closed
+         */
+        bool parse(stl::string_view json) noexcept;
+
+        /**
+         * The value of the document; invalid if it's not parsed
+         */
+        [[nodiscard]] inline element root() const noexcept;
+
+        [[nodiscard]] inline element operator[](stl::string_view key) const noexcept;
+
+        [[nodiscard]] bool is_valid() const noexcept {
+            return valid;
+        }
+    };
+
+    /**
+     * A value in a document; it's only the place of the value, the value is
+     * read when it's asked for. The default one (and the one that's not
+     * found) is invalid, and so is everything that's asked of it, so the
+     * lookups can be chained.
+     */
+    class element {
+        friend class document;
+
+        document const* doc   = nullptr;
+        stl::size_t     start = 0; // where it starts in the text
+        stl::size_t     at    = 0; // its first structural character, or the one after it for the scalars
+
+        constexpr element(document const* the_doc, stl::size_t the_start, stl::size_t index) noexcept
+          : doc{the_doc},
+            start{the_start},
+            at{index} {}
+
+        [[nodiscard]] char first() const noexcept {
+            return doc->text[start];
+        }
+
+        [[nodiscard]] bool is_empty() const noexcept {
+            auto const& text = doc->text;
+            return text[text.find_first_not_of(" \n\r\t", start + 1)] == (first() == '{' ? '}' : ']');
+        }
+
+        // the index of the structural character after the value
+        [[nodiscard]] stl::size_t end_index() const noexcept {
+            switch (first()) {
+                case '{':
+                case '[': return doc->jumps[at] + 1;
+                case '"': return at + 2;
+                default: return at;
+            }
+        }
+
+        // the value after the structural character at "index"
+        [[nodiscard]] element value_after(stl::size_t index) const noexcept {
+            return doc->value_at(doc->indexes[index] + 1, index + 1);
+        }
+
+      public:
+        constexpr element() noexcept = default;
+
+        [[nodiscard]] explicit operator bool() const noexcept {
+            return doc != nullptr;
+        }
+
+        [[nodiscard]] json::kind kind() const noexcept {
+            if (!doc)
+                return json::kind::invalid;
+            switch (first()) {
+                case '{': return json::kind::object;
+                case '[': return json::kind::array;
+                case '"': return json::kind::string;
+                case 't':
+                case 'f': return json::kind::boolean;
+                case 'n': return json::kind::null;
+                default: return json::kind::number;
+            }
+        }
+
+        /**
+         * The value of the member of the object; the keys are compared as
+         * they're written (still escaped)
+         */
+        [[nodiscard]] element operator[](stl::string_view key) const noexcept {
+            if (kind() != json::kind::object)
+                return {};
+            for (auto index = at + 1;;) {
+                if (doc->char_at(index) != '"' || doc->char_at(index + 2) != ':')
+                    return {};
+                auto const name_start = doc->indexes[index] + 1;
+                auto const name       = doc->text.substr(name_start, doc->indexes[index + 1] - name_start);
+                auto const value      = value_after(index + 2);
+                if (!value || name == key)
+                    return value;
+                index = value.end_index();
+                if (doc->char_at(index) != ',')
+                    return {};
+                index++;
+            }
+        }
+
+        /**
+         * The item of the array
+         */
+        [[nodiscard]] element operator[](stl::size_t item) const noexcept {
+            if (kind() != json::kind::array)
+                return {};
+            for (auto index = at;;) {
+                auto const value = value_after(index);
+                if (!value || item-- == 0)
+                    return value;
+                index = value.end_index();
+                if (doc->char_at(index) != ',')
+                    return {};
+            }
+        }
+
+        /**
+         * Call "callback(key, value)" for each member of the object, with the
+         * raw key; a false from it stops there.
+         * @returns false if it's not an object, or there's an error in it
+         */
+        template <typename Callback>
+        bool for_each_member(Callback&& callback) const noexcept {
+            if (kind() != json::kind::object)
+                return false;
+            if (is_empty())
+                return true;
+            for (auto index = at + 1;;) {
+                if (doc->char_at(index) != '"' || doc->char_at(index + 2) != ':')
+                    return false;
+                auto const name_start = doc->indexes[index] + 1;
+                auto const name       = doc->text.substr(name_start, doc->indexes[index + 1] - name_start);
+                auto const value      = value_after(index + 2);
+                if (!value)
+                    return false;
+                if (!callback(name, value))
+                    return true;
+                index = value.end_index();
+                if (doc->char_at(index) == '}')
+                    return true;
+                if (doc->char_at(index) != ',')
+                    return false;
+                index++;
+            }
+        }
+
+        /**
+         * Call "callback(value)" for each item of the array; a false from it
+         * stops there.
+         * @returns false if it's not an array, or there's an error in it
+         */
+        template <typename Callback>
+        bool for_each(Callback&& callback) const noexcept {
+            if (kind() != json::kind::array)
+                return false;
+            if (is_empty())
+                return true;
+            for (auto index = at;;) {
+                auto const value = value_after(index);
+                if (!value)
+                    return false;
+                if (!callback(value))
+                    return true;
+                index = value.end_index();
+                if (doc->char_at(index) == ']')
+                    return true;
+                if (doc->char_at(index) != ',')
+                    return false;
+            }
+        }
+
+        /**
+         * The text of the value, in the document: the strings are without
+         * their quotes, and they're still escaped (see string_value); the
+         * objects and the arrays are the whole of them.
+         */
+        [[nodiscard]] stl::string_view raw() const noexcept {
+            if (!doc)
+                return {};
+            auto const& text = doc->text;
+            switch (first()) {
+                case '{':
+                case '[': return text.substr(start, doc->indexes[doc->jumps[at]] + 1 - start);
+                case '"': return text.substr(start + 1, doc->indexes[at + 1] - start - 1);
+                default: {
+                    auto end = at < doc->count ? doc->indexes[at] : text.size();
+                    while (end > start &&
+                           (text[end - 1] == ' ' || text[end - 1] == '\n' || text[end - 1] == '\r' ||
+                            text[end - 1] == '\t'))
+                        end--;
+                    return text.substr(start, end - start);
+                }
+            }
+        }
+
+        /**
+         * The string has escapes in it; its raw text is not its value then.
+         */
+        [[nodiscard]] bool escaped() const noexcept {
+            return kind() == json::kind::string && raw().find('\\') != stl::string_view::npos;
+        }
+
+        /**
+         * The string, unescaped, appended to "out"
+         * @returns false if it's not a valid string
+         */
+        template <typename StringType>
+        bool string_value(StringType& out) const noexcept {
+            if (kind() != json::kind::string)
+                return false;
+            reader in{doc->text.substr(start, doc->indexes[at + 1] + 1 - start)};
+            return in.next() == token::string && in.string_value(out);
+        }
+
+        /**
+         * The number
+         * @returns false if it's not a number, or it doesn't fit into T
+         */
+        template <typename T>
+        requires(stl::is_arithmetic_v<T>)
+        bool number_value(T& out) const noexcept {
+            if (kind() != json::kind::number)
+                return false;
+            auto const text = raw();
+            reader     in{text};
+            return in.next() == token::number && in.position() == text.size() && in.number_value(out);
+        }
+
+        /**
+         * The boolean
+         * @returns false if it's not a boolean
+         */
+        bool bool_value(bool& out) const noexcept {
+            auto const text = raw();
+            if (kind() != json::kind::boolean || (text != "true" && text != "false"))
+                return false;
+            out = text == "true";
+            return true;
+        }
+
+        [[nodiscard]] bool is_null() const noexcept {
+            return kind() == json::kind::null && raw() == "null";
+        }
+    };
+
+    inline bool document::parse(stl::string_view json) noexcept {
+        text  = json;
+        count = 0;
+        valid = false;
+        // RFC 8259 only has UTF-8; the strings are given out as they are, so they're checked here
+        if (json.size() > stl::numeric_limits<stl::uint32_t>::max() || !utf8_validator::validate(json))
+            return false;
+        if (capacity < json.size()) {
+            // not value-initialized; only what's found is written
+            capacity = json.size();
+            indexes.reset(new stl::uint32_t[capacity]);
+            jumps.reset(new stl::uint32_t[capacity]);
+        }
+        auto const found = details::find_structurals(json, indexes.get());
+        if (found == stl::string_view::npos)
+            return false;
+        count = found;
+        if (!match_brackets())
+            return false;
+
+        // the root is the whole of the text
+        auto const root = value_at(0, 0);
+        if (!root || root.end_index() != count)
+            return false;
+        if (count != 0 && json.find_first_not_of(" \n\r\t", indexes[count - 1] + 1) != stl::string_view::npos)
+            return false;
+        return valid = true;
+    }
+
+    inline element document::value_at(stl::size_t pos, stl::size_t next) const noexcept {
+        pos = text.find_first_not_of(" \n\r\t", pos);
+        if (pos == stl::string_view::npos)
+            return {};
+        switch (text[pos]) {
+            case '{':
+            case '[':
+            case '"':
+                if (next >= count || indexes[next] != pos)
+                    return {};
+                return element{this, pos, next};
+            case '}':
+            case ']':
+            case ':':
+            case ',': return {}; // the value is missing
+            default: return element{this, pos, next};
+        }
+    }
+
+    inline element document::root() const noexcept {
+        return valid ? value_at(0, 0) : element{};
+    }
+
+    inline element document::operator[](stl::string_view key) const noexcept {
+        return root()[key];
+    }
+
+} // namespace webpp::json
+
+#undef WEBPP_JSON_SCANNER_WIDTH
 
 #endif // WEBPP_JSON_HPP
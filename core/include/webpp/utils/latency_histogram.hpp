@@ -0,0 +1,144 @@
+#ifndef WEBPP_UTILS_LATENCY_HISTOGRAM_H
+#define WEBPP_UTILS_LATENCY_HISTOGRAM_H
+
+#include "../std/std.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace webpp {
+
+    /**
+     * A histogram of the latencies (or any other positive numbers), in the manner of HdrHistogram: the
+     * values are counted in buckets that double in size, and each of them is split into the same number
+     * of sub-buckets, so every value is kept within the same relative error (1/64 with the default 7 bits)
+     * from a nanosecond to hundreds of years, in a few tens of kilobytes, and recording is a couple of
+     * shifts.
+     *
+     * It's not thread-safe; each thread keeps one, and they're merged at the end. To not hide the stalls
+     * of a server (coordinated omission), record the time from when a request was meant to be sent, not
+     * from when it was sent.
+     */
+    class latency_histogram {
+        static constexpr unsigned default_precision = 7;
+
+        unsigned                   precision; // the bits of the sub-buckets
+        stl::uint64_t              sub_bucket_count;
+        stl::vector<stl::uint64_t> counts;
+        stl::uint64_t              total   = 0;
+        stl::uint64_t              lowest  = stl::numeric_limits<stl::uint64_t>::max();
+        stl::uint64_t              highest = 0;
+        double                     sum     = 0;
+
+        [[nodiscard]] stl::size_t index_of(stl::uint64_t value) const noexcept {
+            if (value < sub_bucket_count)
+                return static_cast<stl::size_t>(value);
+            auto const bucket = static_cast<unsigned>(stl::bit_width(value)) - precision;
+            auto const half   = sub_bucket_count / 2;
+            return static_cast<stl::size_t>(sub_bucket_count + (bucket - 1) * half + (value >> bucket) -
+                                            half);
+        }
+
+        // the highest value that's counted in the index
+        [[nodiscard]] stl::uint64_t value_of(stl::size_t index) const noexcept {
+            if (index < sub_bucket_count)
+                return index;
+            auto const half   = sub_bucket_count / 2;
+            auto const bucket = (index - sub_bucket_count) / half + 1;
+            auto const sub    = (index - sub_bucket_count) % half + half;
+            return ((sub + 1) << bucket) - 1;
+        }
+
+      public:
+        explicit latency_histogram(unsigned precision_bits = default_precision)
+          : precision{stl::clamp(precision_bits, 1U, 16U)},
+            sub_bucket_count{stl::uint64_t{1} << precision},
+            counts(static_cast<stl::size_t>(sub_bucket_count + (64 - precision) * (sub_bucket_count / 2))) {}
+
+        void record(stl::uint64_t value, stl::uint64_t count = 1) noexcept {
+            counts[index_of(value)] += count;
+            total += count;
+            lowest  = stl::min(lowest, value);
+            highest = stl::max(highest, value);
+            sum += static_cast<double>(value) * static_cast<double>(count);
+        }
+
+        /**
+         * Record a duration in nanoseconds; the negative ones are recorded as zero
+         */
+        template <typename Rep, typename Period>
+        void record(stl::chrono::duration<Rep, Period> duration) noexcept {
+            auto const nanoseconds = stl::chrono::duration_cast<stl::chrono::nanoseconds>(duration).count();
+            record(static_cast<stl::uint64_t>(stl::max<decltype(nanoseconds)>(nanoseconds, 0)));
+        }
+
+        /**
+         * Add the counts of another histogram (of any precision)
+         */
+        void merge(latency_histogram const& other) noexcept {
+            if (other.precision != precision) {
+                for (stl::size_t index = 0; index < other.counts.size(); index++)
+                    if (other.counts[index] != 0)
+                        record(other.value_of(index), other.counts[index]);
+                return;
+            }
+            for (stl::size_t index = 0; index < counts.size(); index++)
+                counts[index] += other.counts[index];
+            total += other.total;
+            lowest  = stl::min(lowest, other.lowest);
+            highest = stl::max(highest, other.highest);
+            sum += other.sum;
+        }
+
+        /**
+         * The value that "percentile" percent of the values are less than or equal to (within the
+         * precision); zero if it's empty
+         */
+        [[nodiscard]] stl::uint64_t value_at(double percentile) const noexcept {
+            if (total == 0)
+                return 0;
+            auto const rank   = stl::clamp(percentile, 0.0, 100.0) / 100.0 * static_cast<double>(total);
+            auto const wanted = stl::max<stl::uint64_t>(static_cast<stl::uint64_t>(stl::ceil(rank)), 1);
+            stl::uint64_t seen = 0;
+            for (stl::size_t index = 0; index < counts.size(); index++) {
+                seen += counts[index];
+                if (seen >= wanted)
+                    return stl::clamp(value_of(index), lowest, highest);
+            }
+            return highest;
+        }
+
+        [[nodiscard]] stl::uint64_t count() const noexcept {
+            return total;
+        }
+
+        [[nodiscard]] stl::uint64_t min() const noexcept {
+            return total == 0 ? 0 : lowest;
+        }
+
+        [[nodiscard]] stl::uint64_t max() const noexcept {
+            return highest;
+        }
+
+        [[nodiscard]] double mean() const noexcept {
+            return total == 0 ? 0 : sum / static_cast<double>(total);
+        }
+
+        void reset() noexcept {
+            stl::fill(counts.begin(), counts.end(), 0);
+            total   = 0;
+            lowest  = stl::numeric_limits<stl::uint64_t>::max();
+            highest = 0;
+            sum     = 0;
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_LATENCY_HISTOGRAM_H
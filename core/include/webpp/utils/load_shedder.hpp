@@ -0,0 +1,83 @@
+#ifndef WEBPP_UTILS_LOAD_SHEDDER_H
+#define WEBPP_UTILS_LOAD_SHEDDER_H
+
+#include "../std/std.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+namespace webpp {
+
+    struct shedding_options {
+        // the queueing delay that is fine; if it doesn't go below this once in
+        // a whole interval, there's a standing queue and we're overloaded
+        stl::chrono::steady_clock::duration target = stl::chrono::milliseconds{5};
+
+        // how long a queue can stand before it's called an overload; it's the
+        // most that a request waits when we're not overloaded too
+        stl::chrono::steady_clock::duration interval = stl::chrono::milliseconds{100};
+    };
+
+    /**
+     * The admission control of the requests, like the CoDel of the network
+     * queues: it's not the length of the queue that tells an overload apart
+     * from a burst, it's the time that the requests wait in it (their
+     * sojourn). A burst drains, and some of its requests wait less than the
+     * target; in an overload, the lowest sojourn of an interval stays above
+     * the target. Then the requests that have waited more than the target are
+     * rejected (cheaply, before the application sees them) until the queue
+     * drains, so the latency of the ones that are served stays bounded; the
+     * rest of the time they're only rejected after a whole interval.
+     *
+     * One of them belongs to each worker thread; it's not thread-safe.
+     */
+    class load_shedder {
+      public:
+        using clock_t    = stl::chrono::steady_clock;
+        using duration_t = clock_t::duration;
+
+      private:
+        shedding_options    options;
+        clock_t::time_point interval_end{};
+        duration_t          min_sojourn = duration_t::max(); // in this interval
+        bool                overloaded  = false;
+        stl::uint64_t       shed        = 0;
+
+      public:
+        constexpr explicit load_shedder(shedding_options const& _options = {}) noexcept : options{_options} {}
+
+        /**
+         * Whether a request that has waited for "sojourn" should be served
+         */
+        [[nodiscard]] bool admit(duration_t sojourn, clock_t::time_point now = clock_t::now()) noexcept {
+            if (now >= interval_end) {
+                // the last interval is only looked at if it's just ended; an idle
+                // interval (no samples) is not an overload either
+                overloaded = now < interval_end + options.interval && min_sojourn != duration_t::max() &&
+                             min_sojourn > options.target;
+                min_sojourn  = duration_t::max();
+                interval_end = now + options.interval;
+            }
+            if (sojourn < min_sojourn)
+                min_sojourn = sojourn;
+            if (sojourn <= (overloaded ? options.target : options.interval))
+                return true;
+            shed++;
+            return false;
+        }
+
+        [[nodiscard]] bool is_overloaded() const noexcept {
+            return overloaded;
+        }
+
+        /**
+         * The number of the requests that are rejected
+         */
+        [[nodiscard]] stl::uint64_t shed_count() const noexcept {
+            return shed;
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_LOAD_SHEDDER_H
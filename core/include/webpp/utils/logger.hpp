@@ -0,0 +1,485 @@
+#ifndef WEBPP_UTILS_LOGGER_H
+#define WEBPP_UTILS_LOGGER_H
+
+#include "../std/format.hpp"
+#include "../std/std.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+/**
+ * The logs below this level are not compiled in at all (their arguments are still evaluated); it's set
+ * with the WEBPP_LOG_LEVEL option of cmake: 0 trace, 1 debug, 2 info, 3 warning, 4 error, and 5 off.
+ */
+#ifndef WEBPP_LOG_LEVEL
+#    define WEBPP_LOG_LEVEL 2
+#endif
+
+namespace webpp {
+
+    enum struct log_level : stl::uint8_t { trace, debug, info, warning, error, off };
+
+    inline constexpr log_level min_log_level = static_cast<log_level>(WEBPP_LOG_LEVEL);
+
+    [[nodiscard]] constexpr stl::string_view log_level_name(log_level level) noexcept {
+        switch (level) {
+            case log_level::trace: return "trace";
+            case log_level::debug: return "debug";
+            case log_level::info: return "info";
+            case log_level::warning: return "warning";
+            case log_level::error: return "error";
+            case log_level::off: return "off";
+        }
+        return "unknown";
+    }
+
+    enum struct log_format : stl::uint8_t {
+        text, // 2026-01-02T03:04:05.123456Z info message
+        json  // {"time":"2026-01-02T03:04:05.123456Z","level":"info","msg":"message"}
+    };
+
+    /**
+     * One log, as it's written by the thread that logs it: the format string and the bytes of the
+     * arguments; it's only formatted later, by the flusher. The strings are copied into it, and they're
+     * cut short if they don't fit.
+     */
+    struct alignas(64) log_record {
+        using formatter_type = void (*)(log_record const&, stl::string&);
+
+        static constexpr stl::size_t size = 256;
+
+        formatter_type   formatter = nullptr;
+        stl::string_view format;   // should outlive the logger; they're string literals
+        stl::int64_t     time = 0; // the nanoseconds of the system clock
+        log_level        level = log_level::info;
+        stl::array<char, size - 40> data{};
+    };
+
+    static_assert(sizeof(log_record) == log_record::size);
+
+    namespace details {
+
+        // the strings are stored as their bytes, and the rest are copied as they are
+        template <typename T>
+        using log_arg_t = stl::conditional_t<stl::is_convertible_v<T const&, stl::string_view>,
+                                             stl::string_view,
+                                             stl::remove_cvref_t<T>>;
+
+        template <typename T>
+        inline constexpr stl::size_t log_arg_size =
+          stl::is_same_v<T, stl::string_view> ? sizeof(stl::uint16_t) : sizeof(T);
+
+        template <typename T>
+        void put_log_arg(log_record& record, stl::size_t& fixed, stl::size_t& tail, T const& value) noexcept {
+            if constexpr (stl::is_same_v<T, stl::string_view>) {
+                auto const length = static_cast<stl::uint16_t>(
+                  stl::min({value.size(), record.data.size() - tail, stl::size_t{0xFFFF}}));
+                stl::memcpy(record.data.data() + fixed, &length, sizeof(length));
+                stl::memcpy(record.data.data() + tail, value.data(), length);
+                fixed += sizeof(length);
+                tail += length;
+            } else {
+                stl::memcpy(record.data.data() + fixed, &value, sizeof(T));
+                fixed += sizeof(T);
+            }
+        }
+
+        template <typename T>
+        [[nodiscard]] T
+        get_log_arg(log_record const& record, stl::size_t& fixed, stl::size_t& tail) noexcept {
+            if constexpr (stl::is_same_v<T, stl::string_view>) {
+                stl::uint16_t length = 0;
+                stl::memcpy(&length, record.data.data() + fixed, sizeof(length));
+                fixed += sizeof(length);
+                tail += length;
+                return {record.data.data() + tail - length, length};
+            } else {
+                T value;
+                stl::memcpy(&value, record.data.data() + fixed, sizeof(T));
+                fixed += sizeof(T);
+                return value;
+            }
+        }
+
+        template <typename... Args>
+        void format_log_record(log_record const& record, stl::string& out) {
+            [[maybe_unused]] stl::size_t fixed = 0;
+            [[maybe_unused]] stl::size_t tail  = (log_arg_size<Args> + ... + 0);
+            // the braces evaluate them in order
+            stl::tuple<Args...> const values{get_log_arg<Args>(record, fixed, tail)...};
+            auto const                size = out.size();
+            try {
+                stl::apply(
+                  [&](auto const&... args) {
+                      stl::vformat_to(stl::back_inserter(out), record.format, stl::make_format_args(args...));
+                  },
+                  values);
+            } catch (stl::exception const&) {
+                out.resize(size);
+                out.append("(bad log format) ");
+                out.append(record.format);
+            }
+        }
+
+    } // namespace details
+
+    /**
+     * The records of one thread; only that thread writes into it, and only the flusher reads from it.
+     * The records that don't fit are dropped (and counted) instead of waiting for the flusher.
+     */
+    class log_ring {
+      public:
+        static constexpr stl::size_t capacity = 1024; // 256 KiB
+
+      private:
+        stl::unique_ptr<log_record[]> records{new log_record[capacity]};
+        alignas(64) stl::atomic<stl::uint64_t> head{0}; // written by the thread
+        alignas(64) stl::atomic<stl::uint64_t> tail{0}; // written by the flusher
+        alignas(64) stl::atomic<stl::uint64_t> dropped{0};
+
+      public:
+        /**
+         * The next free record, or nullptr if the ring is full; it's published with commit()
+         */
+        [[nodiscard]] log_record* reserve() noexcept {
+            auto const index = head.load(stl::memory_order_relaxed);
+            if (index - tail.load(stl::memory_order_acquire) == capacity) {
+                dropped.fetch_add(1, stl::memory_order_relaxed);
+                return nullptr;
+            }
+            return &records[index & (capacity - 1)];
+        }
+
+        void commit() noexcept {
+            head.store(head.load(stl::memory_order_relaxed) + 1, stl::memory_order_release);
+        }
+
+        /**
+         * Give the records that are written so far to the callable, and free them
+         * @returns the number of the records
+         */
+        template <typename Callable>
+        stl::size_t drain(Callable&& callable) {
+            auto const begin = tail.load(stl::memory_order_relaxed);
+            auto const end   = head.load(stl::memory_order_acquire);
+            for (auto index = begin; index != end; index++)
+                callable(records[index & (capacity - 1)]);
+            tail.store(end, stl::memory_order_release);
+            return static_cast<stl::size_t>(end - begin);
+        }
+
+        [[nodiscard]] stl::uint64_t take_dropped() noexcept {
+            return dropped.exchange(0, stl::memory_order_relaxed);
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return head.load(stl::memory_order_acquire) == tail.load(stl::memory_order_relaxed);
+        }
+    };
+
+    /**
+     * The logger of the process; the threads write their records into their own rings, without locks
+     * or system calls, and a background thread formats them and writes them out in batches:
+     *   webpp::logger::global().start(stdout);
+     *   webpp::log_info("listening on port {}", port);
+     *
+     * Nothing is recorded while it's not started.
+     */
+    class logger {
+        mutable stl::mutex                     lock; // the rings, the sink, and the draining
+        stl::vector<stl::shared_ptr<log_ring>> rings;
+        stl::atomic<bool>                      running{false};
+        stl::thread                            flusher;
+        stl::condition_variable                wake;
+        bool                                   stopping   = false;
+        stl::FILE*                             sink       = nullptr;
+        bool                                   owns_sink  = false;
+        log_format                             out_format = log_format::text;
+        stl::string                            batch;
+        stl::string                            message; // of the json records
+
+        logger() = default;
+
+        [[nodiscard]] log_ring& local() {
+            thread_local stl::shared_ptr<log_ring> ring = [this] {
+                stl::scoped_lock const _lock{lock};
+                return rings.emplace_back(stl::make_shared<log_ring>());
+            }();
+            return *ring;
+        }
+
+        static void write_time(stl::string& out, stl::int64_t time) {
+            using namespace stl::chrono;
+            sys_time<nanoseconds> const now{nanoseconds{time}};
+            auto const                  day = floor<days>(now);
+            year_month_day const        date{day};
+            hh_mm_ss const              clock{duration_cast<microseconds>(now - day)};
+            stl::format_to(stl::back_inserter(out),
+                           "{:04}-{:02}-{:02}T{:02}:{:02}:{:02}.{:06}Z",
+                           static_cast<int>(date.year()),
+                           static_cast<unsigned>(date.month()),
+                           static_cast<unsigned>(date.day()),
+                           clock.hours().count(),
+                           clock.minutes().count(),
+                           clock.seconds().count(),
+                           clock.subseconds().count());
+        }
+
+        static void write_json_string(stl::string& out, stl::string_view str) {
+            static constexpr stl::string_view hex = "0123456789abcdef";
+            out.push_back('"');
+            for (char const c : str) {
+                auto const byte = static_cast<unsigned char>(c);
+                if (c == '"' || c == '\\') {
+                    out.push_back('\\');
+                    out.push_back(c);
+                } else if (byte < 0x20) {
+                    out.append("\\u00");
+                    out.push_back(hex[byte >> 4U]);
+                    out.push_back(hex[byte & 0xFU]);
+                } else {
+                    out.push_back(c);
+                }
+            }
+            out.push_back('"');
+        }
+
+        void format_record(log_record const& record) {
+            if (out_format == log_format::json) {
+                message.clear();
+                record.formatter(record, message);
+                batch.append(R"({"time":")");
+                write_time(batch, record.time);
+                batch.append(R"(","level":")");
+                batch.append(log_level_name(record.level));
+                batch.append(R"(","msg":)");
+                write_json_string(batch, message);
+                batch.append("}\n");
+            } else {
+                write_time(batch, record.time);
+                batch.push_back(' ');
+                batch.append(log_level_name(record.level));
+                batch.push_back(' ');
+                record.formatter(record, batch);
+                batch.push_back('\n');
+            }
+        }
+
+        // while holding the lock
+        void drain() {
+            for (auto& ring : rings) {
+                ring->drain([this](log_record const& record) {
+                    format_record(record);
+                });
+                if (auto const dropped = ring->take_dropped(); dropped != 0) {
+                    log_record note{.formatter = details::format_log_record<stl::uint64_t>,
+                                    .format    = "{} log records were dropped; the ring was full",
+                                    .time      = now(),
+                                    .level     = log_level::warning};
+                    stl::memcpy(note.data.data(), &dropped, sizeof(dropped));
+                    format_record(note);
+                }
+            }
+            // the threads that are gone, and whose records are written
+            stl::erase_if(rings, [](auto const& ring) {
+                return ring.use_count() == 1 && ring->empty();
+            });
+            if (!batch.empty() && sink != nullptr) {
+                stl::fwrite(batch.data(), 1, batch.size(), sink);
+                stl::fflush(sink);
+            }
+            batch.clear();
+        }
+
+        [[nodiscard]] static stl::int64_t now() noexcept {
+            return stl::chrono::duration_cast<stl::chrono::nanoseconds>(
+                     stl::chrono::system_clock::now().time_since_epoch())
+              .count();
+        }
+
+      public:
+        [[nodiscard]] static logger& global() noexcept {
+            static logger instance;
+            return instance;
+        }
+
+        logger(logger const&)            = delete;
+        logger& operator=(logger const&) = delete;
+
+        ~logger() {
+            stop();
+        }
+
+        /**
+         * Start the flusher; it writes the records into the file every "interval", and the file should
+         * outlive the logger (or until stop()).
+         */
+        void start(stl::FILE*                file     = stdout,
+                   log_format                type     = log_format::text,
+                   stl::chrono::milliseconds interval = stl::chrono::milliseconds{10}) {
+            stop();
+            {
+                stl::scoped_lock const _lock{lock};
+                sink       = file;
+                owns_sink  = false;
+                out_format = type;
+                stopping   = false;
+            }
+            flusher = stl::thread{[this, interval] {
+                stl::unique_lock _lock{lock};
+                while (!wake.wait_for(_lock, interval, [this] {
+                    return stopping;
+                })) {
+                    drain();
+                }
+            }};
+            running.store(true, stl::memory_order_release);
+        }
+
+        /**
+         * Start the flusher, and append the records to the file at the path
+         * @returns false if the file can't be opened
+         */
+        bool start(char const*               path,
+                   log_format                type     = log_format::text,
+                   stl::chrono::milliseconds interval = stl::chrono::milliseconds{10}) {
+            auto* file = stl::fopen(path, "a");
+            if (file == nullptr)
+                return false;
+            start(file, type, interval);
+            stl::scoped_lock const _lock{lock};
+            owns_sink = true;
+            return true;
+        }
+
+        /**
+         * Write what's left, and stop the flusher; the records that are written while it's stopping may
+         * be lost.
+         */
+        void stop() {
+            running.store(false, stl::memory_order_release);
+            {
+                stl::scoped_lock const _lock{lock};
+                stopping = true;
+            }
+            wake.notify_all();
+            if (flusher.joinable())
+                flusher.join();
+            stl::scoped_lock const _lock{lock};
+            drain();
+            if (owns_sink && sink != nullptr)
+                stl::fclose(sink);
+            sink      = nullptr;
+            owns_sink = false;
+        }
+
+        /**
+         * Write the records that are recorded so far, now
+         */
+        void flush() {
+            stl::scoped_lock const _lock{lock};
+            drain();
+        }
+
+        [[nodiscard]] bool is_running() const noexcept {
+            return running.load(stl::memory_order_relaxed);
+        }
+
+        /**
+         * Record a log; the format string should outlive the logger (use a string literal), and the
+         * arguments are copied. The strings are cut short if the arguments don't fit in a record.
+         */
+        template <log_level Level, typename... Args>
+        void write(stl::string_view format_str, Args const&... args) noexcept {
+            if constexpr (Level >= min_log_level && Level != log_level::off) {
+                static_assert((details::log_arg_size<details::log_arg_t<Args>> + ... + 0) <=
+                                sizeof(log_record::data),
+                              "The arguments don't fit in a log record.");
+                static_assert((stl::is_trivially_copyable_v<details::log_arg_t<Args>> && ...),
+                              "The arguments of the logs should be strings or trivially copyable.");
+                if (!running.load(stl::memory_order_relaxed))
+                    return;
+                log_ring* ring = nullptr;
+                try {
+                    ring = &local();
+                } catch (...) {
+                    return;
+                }
+                auto* record = ring->reserve();
+                if (record == nullptr)
+                    return;
+                record->formatter = details::format_log_record<details::log_arg_t<Args>...>;
+                record->format    = format_str;
+                record->time      = now();
+                record->level     = Level;
+                [[maybe_unused]] stl::size_t fixed = 0;
+                [[maybe_unused]] stl::size_t tail =
+                  (details::log_arg_size<details::log_arg_t<Args>> + ... + 0);
+                (details::put_log_arg<details::log_arg_t<Args>>(
+                   *record,
+                   fixed,
+                   tail,
+                   static_cast<details::log_arg_t<Args>>(args)),
+                 ...);
+                ring->commit();
+            }
+        }
+    };
+
+    template <typename... Args>
+    void log_trace(stl::string_view format_str, Args const&... args) noexcept {
+        logger::global().write<log_level::trace>(format_str, args...);
+    }
+
+    template <typename... Args>
+    void log_debug(stl::string_view format_str, Args const&... args) noexcept {
+        logger::global().write<log_level::debug>(format_str, args...);
+    }
+
+    template <typename... Args>
+    void log_info(stl::string_view format_str, Args const&... args) noexcept {
+        logger::global().write<log_level::info>(format_str, args...);
+    }
+
+    template <typename... Args>
+    void log_warning(stl::string_view format_str, Args const&... args) noexcept {
+        logger::global().write<log_level::warning>(format_str, args...);
+    }
+
+    template <typename... Args>
+    void log_error(stl::string_view format_str, Args const&... args) noexcept {
+        logger::global().write<log_level::error>(format_str, args...);
+    }
+
+    /**
+     * The access log of the interfaces: "GET /index.html 200 153us"
+     */
+    inline void log_access(stl::string_view                      method,
+                           stl::string_view                      target,
+                           unsigned                              status,
+                           stl::chrono::steady_clock::time_point start) noexcept {
+        if constexpr (log_level::info >= min_log_level) {
+            auto const took = stl::chrono::duration_cast<stl::chrono::microseconds>(
+              stl::chrono::steady_clock::now() - start);
+            log_info("{} {} {} {}us", method, target, status, took.count());
+        }
+    }
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_LOGGER_H
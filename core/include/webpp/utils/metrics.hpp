@@ -0,0 +1,470 @@
+#ifndef WEBPP_UTILS_METRICS_H
+#define WEBPP_UTILS_METRICS_H
+
+#include "../std/format.hpp"
+#include "../std/std.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace webpp {
+
+    class metrics_registry;
+
+    enum struct metric_type : stl::uint8_t { counter, gauge, histogram };
+
+    // the labels of a series: {{"route", "/api"}, {"code", "2xx"}}
+    using metric_labels = stl::initializer_list<stl::pair<stl::string_view, stl::string_view>>;
+
+    namespace details {
+
+        // 8 cells; the lines of the threads never share a cache line
+        struct alignas(64) metric_line {
+            stl::array<stl::atomic<stl::uint64_t>, 8> cells{};
+        };
+
+        /**
+         * The cells of all the metrics for one thread; only that thread writes them, so an increment
+         * is a plain load and store, without a locked instruction.
+         */
+        class metric_shard {
+            stl::unique_ptr<metric_line[]> lines;
+
+          public:
+            explicit metric_shard(stl::size_t cell_count) : lines{new metric_line[(cell_count + 7) / 8]} {}
+
+            [[nodiscard]] stl::atomic<stl::uint64_t>& operator[](stl::size_t index) const noexcept {
+                return lines[index / 8].cells[index % 8];
+            }
+
+            void add(stl::size_t index, stl::uint64_t value) const noexcept {
+                auto& cell = (*this)[index];
+                cell.store(cell.load(stl::memory_order_relaxed) + value, stl::memory_order_relaxed);
+            }
+
+            void add(stl::size_t index, double value) const noexcept {
+                auto& cell = (*this)[index];
+                auto const old = stl::bit_cast<double>(cell.load(stl::memory_order_relaxed));
+                cell.store(stl::bit_cast<stl::uint64_t>(old + value), stl::memory_order_relaxed);
+            }
+        };
+
+    } // namespace details
+
+    /**
+     * The metrics of a server, in the manner of Prometheus: counters, gauges, and histograms, with
+     * labels. Every thread writes into its own cells, so recording a value costs a few nanoseconds and
+     * the threads don't fight over the cache lines; the cells of the threads are added up when they're
+     * scraped (see write_text).
+     *
+     * The metrics are registered once (it takes a lock) and the handles that it returns are used on the
+     * hot path; registering the same name and labels again returns the same series.
+     *   metrics_registry registry;
+     *   auto const hits = registry.counter("cache_hits_total", "The hits of the cache");
+     *   hits.inc();
+     */
+    class metrics_registry {
+      public:
+        static constexpr stl::size_t default_capacity = 4096; // 32 KiB for each thread
+
+        // the buckets of the latencies, in seconds
+        static constexpr stl::array<double, 16> latency_buckets{
+          0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+
+      private:
+        struct series {
+            stl::string labels; // rendered: route="/api",code="2xx"
+            stl::size_t first;  // the first cell of it
+        };
+
+        struct family {
+            stl::string         name;
+            stl::string         help;
+            metric_type         type;
+            stl::vector<double> bounds{}; // of the buckets of the histograms
+            stl::vector<series> members{};
+        };
+
+        struct cached_shard {
+            stl::uint64_t          owner = 0;
+            details::metric_shard* shard = nullptr;
+        };
+
+        static stl::uint64_t next_id() noexcept {
+            static stl::atomic<stl::uint64_t> ids{0};
+            return ids.fetch_add(1, stl::memory_order_relaxed) + 1;
+        }
+
+        stl::uint64_t      id = next_id(); // never reused, unlike the address
+        stl::size_t        capacity;
+        stl::size_t        used = 0;
+        mutable stl::mutex lock;
+        stl::deque<family> families; // they never move
+
+        // the cells of the threads, even the ones that are gone
+        stl::vector<stl::unique_ptr<details::metric_shard>> shards;
+
+        [[nodiscard]] details::metric_shard& new_local() {
+            thread_local stl::vector<cached_shard> mine;
+            for (auto const& item : mine)
+                if (item.owner == id)
+                    return *item.shard;
+            stl::scoped_lock const _lock{lock};
+            auto* shard = shards.emplace_back(stl::make_unique<details::metric_shard>(capacity)).get();
+            mine.push_back({id, shard});
+            return *shard;
+        }
+
+        static void append_escaped(stl::string& out, stl::string_view value) {
+            for (auto const c : value) {
+                switch (c) {
+                    case '\\': out += "\\\\"; break;
+                    case '"': out += "\\\""; break;
+                    case '\n': out += "\\n"; break;
+                    default: out += c;
+                }
+            }
+        }
+
+        [[nodiscard]] static stl::string render_labels(metric_labels labels) {
+            stl::string res;
+            for (auto const& [name, value] : labels) {
+                if (!res.empty())
+                    res += ',';
+                res += name;
+                res += "=\"";
+                append_escaped(res, value);
+                res += '"';
+            }
+            return res;
+        }
+
+        /**
+         * The family of the series, and the first cell of the series; it's made if it's not there
+         */
+        stl::pair<family const*, stl::size_t> add_series(stl::string_view        name,
+                                                         stl::string_view        help,
+                                                         metric_type             type,
+                                                         metric_labels           labels,
+                                                         stl::size_t             cell_count,
+                                                         stl::span<double const> bounds = {}) {
+            auto                   rendered = render_labels(labels);
+            stl::scoped_lock const _lock{lock};
+            auto fam = stl::find_if(families.begin(), families.end(), [name](family const& item) {
+                return item.name == name;
+            });
+            if (fam == families.end()) {
+                fam = families.insert(families.end(), family{stl::string{name}, stl::string{help}, type});
+                fam->bounds.assign(bounds.begin(), bounds.end());
+            } else if (fam->type != type || !stl::equal(bounds.begin(), bounds.end(), fam->bounds.begin(),
+                                                        fam->bounds.end())) {
+                throw stl::invalid_argument("The metric is registered with another type, or other buckets.");
+            }
+            for (auto const& member : fam->members)
+                if (member.labels == rendered)
+                    return {&*fam, member.first};
+            if (used + cell_count > capacity)
+                throw stl::length_error("The metrics registry is full.");
+            fam->members.push_back({stl::move(rendered), used});
+            used += cell_count;
+            return {&*fam, used - cell_count};
+        }
+
+        [[nodiscard]] stl::uint64_t sum_of(stl::size_t cell) const noexcept {
+            stl::uint64_t res = 0;
+            for (auto const& shard : shards)
+                res += (*shard)[cell].load(stl::memory_order_relaxed);
+            return res;
+        }
+
+        [[nodiscard]] double double_sum_of(stl::size_t cell) const noexcept {
+            double res = 0;
+            for (auto const& shard : shards)
+                res += stl::bit_cast<double>((*shard)[cell].load(stl::memory_order_relaxed));
+            return res;
+        }
+
+        friend class metric_counter;
+        friend class metric_gauge;
+        friend class metric_histogram;
+
+      public:
+        explicit metrics_registry(stl::size_t cell_capacity = default_capacity) noexcept
+          : capacity{cell_capacity} {}
+
+        metrics_registry(metrics_registry const&)            = delete;
+        metrics_registry& operator=(metrics_registry const&) = delete;
+
+        /**
+         * The cells of this thread
+         */
+        [[nodiscard]] details::metric_shard& local() {
+            thread_local cached_shard last;
+            if (last.owner != id)
+                last = {id, &new_local()};
+            return *last.shard;
+        }
+
+        [[nodiscard]] class metric_counter counter(stl::string_view name,
+                                                   stl::string_view help,
+                                                   metric_labels    labels = {});
+
+        [[nodiscard]] class metric_gauge gauge(stl::string_view name,
+                                               stl::string_view help,
+                                               metric_labels    labels = {});
+
+        /**
+         * A histogram with the specified upper bounds of its buckets (sorted); the default buckets are
+         * for the latencies in seconds, from 100µs to 10s.
+         */
+        [[nodiscard]] class metric_histogram histogram(stl::string_view        name,
+                                                       stl::string_view        help,
+                                                       metric_labels           labels = {},
+                                                       stl::span<double const> bounds = latency_buckets);
+
+        /**
+         * Append the metrics in the text format of Prometheus (version 0.0.4) to the string
+         */
+        template <typename StringType>
+        void write_text(StringType& out) const {
+            auto                   it = stl::back_inserter(out);
+            stl::scoped_lock const _lock{lock};
+            for (auto const& fam : families) {
+                static constexpr stl::array<stl::string_view, 3> type_names{"counter", "gauge", "histogram"};
+                if (!fam.help.empty()) {
+                    out += "# HELP ";
+                    out += fam.name;
+                    out += ' ';
+                    out += fam.help;
+                    out += '\n';
+                }
+                out += "# TYPE ";
+                out += fam.name;
+                out += ' ';
+                out += type_names[static_cast<stl::size_t>(fam.type)];
+                out += '\n';
+                for (auto const& member : fam.members) {
+                    auto const braced = member.labels.empty() ? stl::string{} : '{' + member.labels + '}';
+                    switch (fam.type) {
+                        case metric_type::counter:
+                            stl::format_to(it, "{}{} {}\n", fam.name, braced, sum_of(member.first));
+                            break;
+                        case metric_type::gauge:
+                            stl::format_to(it,
+                                           "{}{} {}\n",
+                                           fam.name,
+                                           braced,
+                                           static_cast<stl::int64_t>(sum_of(member.first)));
+                            break;
+                        case metric_type::histogram: {
+                            auto const    sep   = member.labels.empty() ? "" : ",";
+                            stl::uint64_t count = 0;
+                            for (stl::size_t i = 0; i <= fam.bounds.size(); i++) {
+                                count += sum_of(member.first + i);
+                                if (i == fam.bounds.size()) {
+                                    stl::format_to(it,
+                                                   "{}_bucket{{{}{}le=\"+Inf\"}} {}\n",
+                                                   fam.name,
+                                                   member.labels,
+                                                   sep,
+                                                   count);
+                                } else {
+                                    stl::format_to(it,
+                                                   "{}_bucket{{{}{}le=\"{}\"}} {}\n",
+                                                   fam.name,
+                                                   member.labels,
+                                                   sep,
+                                                   fam.bounds[i],
+                                                   count);
+                                }
+                            }
+                            stl::format_to(it,
+                                           "{}_sum{} {}\n{}_count{} {}\n",
+                                           fam.name,
+                                           braced,
+                                           double_sum_of(member.first + fam.bounds.size() + 1),
+                                           fam.name,
+                                           braced,
+                                           count);
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        [[nodiscard]] stl::string text() const {
+            stl::string res;
+            write_text(res);
+            return res;
+        }
+    };
+
+    /**
+     * A number that only goes up; the default one is not registered, and counts nothing.
+     */
+    class metric_counter {
+        metrics_registry* registry = nullptr;
+        stl::size_t       cell     = 0;
+
+        friend class metrics_registry;
+
+        constexpr metric_counter(metrics_registry* _registry, stl::size_t _cell) noexcept
+          : registry{_registry},
+            cell{_cell} {}
+
+      public:
+        constexpr metric_counter() noexcept = default;
+
+        void inc(stl::uint64_t value = 1) const noexcept {
+            if (registry != nullptr)
+                registry->local().add(cell, value);
+        }
+
+        /**
+         * The sum of the threads
+         */
+        [[nodiscard]] stl::uint64_t value() const noexcept {
+            if (registry == nullptr)
+                return 0;
+            stl::scoped_lock const _lock{registry->lock};
+            return registry->sum_of(cell);
+        }
+    };
+
+    /**
+     * A number that goes up and down; each thread adds to it (the threads that add and the ones that
+     * subtract don't have to be the same)
+     */
+    class metric_gauge {
+        metrics_registry* registry = nullptr;
+        stl::size_t       cell     = 0;
+
+        friend class metrics_registry;
+
+        constexpr metric_gauge(metrics_registry* _registry, stl::size_t _cell) noexcept
+          : registry{_registry},
+            cell{_cell} {}
+
+      public:
+        constexpr metric_gauge() noexcept = default;
+
+        void add(stl::int64_t value) const noexcept {
+            if (registry != nullptr)
+                registry->local().add(cell, static_cast<stl::uint64_t>(value)); // wraps around
+        }
+
+        void inc() const noexcept {
+            add(1);
+        }
+
+        void dec() const noexcept {
+            add(-1);
+        }
+
+        [[nodiscard]] stl::int64_t value() const noexcept {
+            if (registry == nullptr)
+                return 0;
+            stl::scoped_lock const _lock{registry->lock};
+            return static_cast<stl::int64_t>(registry->sum_of(cell));
+        }
+    };
+
+    /**
+     * The values counted in buckets; their cells are the buckets (the last one is +Inf) and the sum.
+     */
+    class metric_histogram {
+        metrics_registry* registry = nullptr;
+        stl::size_t       cell     = 0;
+        double const*     bounds   = nullptr;
+        stl::size_t       buckets  = 0; // without the +Inf
+
+        friend class metrics_registry;
+
+        constexpr metric_histogram(metrics_registry* _registry,
+                                   stl::size_t       _cell,
+                                   double const*     _bounds,
+                                   stl::size_t       _buckets) noexcept
+          : registry{_registry},
+            cell{_cell},
+            bounds{_bounds},
+            buckets{_buckets} {}
+
+      public:
+        constexpr metric_histogram() noexcept = default;
+
+        void observe(double value) const noexcept {
+            if (registry == nullptr)
+                return;
+            stl::size_t index = 0;
+            while (index != buckets && value > bounds[index])
+                index++;
+            auto& shard = registry->local();
+            shard.add(cell + index, stl::uint64_t{1});
+            shard.add(cell + buckets + 1, value);
+        }
+
+        /**
+         * Observe a duration, in seconds
+         */
+        template <typename Rep, typename Period>
+        void observe(stl::chrono::duration<Rep, Period> duration) const noexcept {
+            observe(stl::chrono::duration<double>(duration).count());
+        }
+
+        [[nodiscard]] stl::uint64_t count() const noexcept {
+            if (registry == nullptr)
+                return 0;
+            stl::scoped_lock const _lock{registry->lock};
+            stl::uint64_t          res = 0;
+            for (stl::size_t i = 0; i <= buckets; i++)
+                res += registry->sum_of(cell + i);
+            return res;
+        }
+
+        [[nodiscard]] double sum() const noexcept {
+            if (registry == nullptr)
+                return 0;
+            stl::scoped_lock const _lock{registry->lock};
+            return registry->double_sum_of(cell + buckets + 1);
+        }
+    };
+
+    inline metric_counter
+    metrics_registry::counter(stl::string_view name, stl::string_view help, metric_labels labels) {
+        return {this, add_series(name, help, metric_type::counter, labels, 1).second};
+    }
+
+    inline metric_gauge
+    metrics_registry::gauge(stl::string_view name, stl::string_view help, metric_labels labels) {
+        return {this, add_series(name, help, metric_type::gauge, labels, 1).second};
+    }
+
+    inline metric_histogram metrics_registry::histogram(stl::string_view        name,
+                                                        stl::string_view        help,
+                                                        metric_labels           labels,
+                                                        stl::span<double const> bounds) {
+        auto const [fam, first] =
+          add_series(name, help, metric_type::histogram, labels, bounds.size() + 2, bounds);
+        return {this, first, fam->bounds.data(), fam->bounds.size()};
+    }
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_METRICS_H
@@ -0,0 +1,250 @@
+#ifndef WEBPP_UTILS_PERFECT_HASH_H
+#define WEBPP_UTILS_PERFECT_HASH_H
+
+#include "../std/std.hpp"
+#include "./fixed_string.hpp"
+#include "./strings.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace webpp {
+
+    namespace details {
+
+        /**
+         * The keys, as chars, one after another; the fixed_strings hold
+         * char32_t, but the strings that are looked up are chars.
+         */
+        template <fixed_string... Keys>
+        struct perfect_hash_chars {
+            static constexpr stl::size_t count = sizeof...(Keys);
+            static constexpr stl::size_t total = (Keys.size() + ... + 0);
+
+            stl::array<char, total + 1>        data{};
+            stl::array<stl::size_t, count + 1> offsets{};
+
+            constexpr perfect_hash_chars() noexcept {
+                stl::size_t key = 0;
+                stl::size_t pos = 0;
+                (
+                  [&](auto const& str) constexpr {
+                      offsets[key++] = pos;
+                      for (auto const c : str)
+                          data[pos++] = static_cast<char>(c);
+                  }(Keys),
+                  ...);
+                offsets[key] = pos;
+            }
+        };
+
+        template <bool IgnoreCase>
+        [[nodiscard]] constexpr stl::size_t perfect_hash_of(stl::string_view str) noexcept {
+            if constexpr (IgnoreCase) {
+                return ascii_ihash(str);
+            } else {
+                return fixed_string_hash(str);
+            }
+        }
+
+        template <bool IgnoreCase>
+        [[nodiscard]] constexpr bool perfect_hash_equals(stl::string_view a, stl::string_view b) noexcept {
+            if constexpr (IgnoreCase) {
+                return ascii_iequals(a, b);
+            } else {
+                return a == b;
+            }
+        }
+
+        /**
+         * Mix the seed into the hash, and take the slot from the high bits of it
+         */
+        [[nodiscard]] constexpr stl::size_t
+        perfect_hash_slot(stl::size_t hash, stl::uint64_t seed, stl::size_t table_size) noexcept {
+            auto const mixed = (static_cast<stl::uint64_t>(hash) ^ seed) * 0x9E37'79B9'7F4A'7C15ull;
+            return static_cast<stl::size_t>(mixed >> 32u) & (table_size - 1);
+        }
+
+        struct perfect_hash_layout {
+            stl::size_t   table_size = 0; // zero if there's none
+            stl::uint64_t seed       = 0;
+        };
+
+        // the largest table is this many times the smallest power of two that fits the keys
+        static constexpr stl::size_t perfect_hash_max_spread = 16;
+        static constexpr stl::size_t perfect_hash_seeds      = 1024;
+
+        /**
+         * Find the smallest table, and a seed for it, that puts each key in a slot of its own
+         */
+        template <bool IgnoreCase, stl::size_t N>
+        [[nodiscard]] constexpr perfect_hash_layout
+        find_perfect_hash(stl::array<stl::string_view, N> const& keys) noexcept {
+            constexpr stl::size_t smallest = stl::bit_ceil(N == 0 ? stl::size_t{1} : N);
+            constexpr stl::size_t largest  = smallest * perfect_hash_max_spread;
+
+            stl::array<stl::size_t, N> hashes{};
+            for (stl::size_t i = 0; i < N; i++) {
+                hashes[i] = perfect_hash_of<IgnoreCase>(keys[i]);
+                for (stl::size_t j = 0; j < i; j++)
+                    if (perfect_hash_equals<IgnoreCase>(keys[i], keys[j]))
+                        return {}; // the same key twice
+            }
+
+            for (stl::size_t size = smallest; size <= largest; size *= 2) {
+                for (stl::uint64_t seed = 0; seed < perfect_hash_seeds; seed++) {
+                    stl::array<bool, largest> used{};
+                    bool                      collided = false;
+                    for (stl::size_t i = 0; !collided && i < N; i++) {
+                        auto& slot = used[perfect_hash_slot(hashes[i], seed, size)];
+                        collided   = slot;
+                        slot       = true;
+                    }
+                    if (!collided)
+                        return {size, seed};
+                }
+            }
+            return {};
+        }
+
+    } // namespace details
+
+    /**
+     * A perfect hash of the keys that's made at compile time; each key has a
+     * slot of its own, so finding one of them is one hash and one compare.
+     *
+     * The index of a key is its position in the keys; the keys are ASCII.
+     *
+     *   using methods = perfect_hash<"GET", "POST", "PUT">;
+     *   methods::index_of("POST") == 1
+     *
+     * @tparam IgnoreCase compare (and hash) the ASCII letters case-insensitively
+     */
+    template <bool IgnoreCase, fixed_string... Keys>
+    struct basic_perfect_hash {
+        static constexpr stl::size_t npos = static_cast<stl::size_t>(-1);
+
+      private:
+        static constexpr details::perfect_hash_chars<Keys...> chars{};
+
+        static constexpr stl::array<stl::string_view, sizeof...(Keys)> keys = [] {
+            stl::array<stl::string_view, sizeof...(Keys)> views{};
+            for (stl::size_t i = 0; i < sizeof...(Keys); i++)
+                views[i] = stl::string_view{chars.data.data() + chars.offsets[i],
+                                            chars.offsets[i + 1] - chars.offsets[i]};
+            return views;
+        }();
+
+        static constexpr auto layout = details::find_perfect_hash<IgnoreCase>(keys);
+
+        static_assert(layout.table_size != 0, "The keys are not unique, or there's no perfect hash for them.");
+
+        using slot_type = stl::conditional_t<(sizeof...(Keys) < 0xFFu), stl::uint8_t, stl::uint16_t>;
+
+        static constexpr slot_type empty_slot = static_cast<slot_type>(-1);
+
+        // the index of the key that's in each slot
+        static constexpr stl::array<slot_type, layout.table_size> slots = [] {
+            stl::array<slot_type, layout.table_size> table{};
+            table.fill(empty_slot);
+            for (stl::size_t i = 0; i < sizeof...(Keys); i++)
+                table[details::perfect_hash_slot(details::perfect_hash_of<IgnoreCase>(keys[i]), layout.seed,
+                                                 layout.table_size)] = static_cast<slot_type>(i);
+            return table;
+        }();
+
+      public:
+        [[nodiscard]] static constexpr stl::size_t size() noexcept {
+            return sizeof...(Keys);
+        }
+
+        /**
+         * The key at the index; the same as the fixed_string that was given
+         */
+        [[nodiscard]] static constexpr stl::string_view key(stl::size_t index) noexcept {
+            return keys[index];
+        }
+
+        /**
+         * The index of the key, or npos if it's not one of them
+         */
+        [[nodiscard]] static constexpr stl::size_t index_of(stl::string_view str) noexcept {
+            if constexpr (sizeof...(Keys) == 0) {
+                return npos;
+            } else {
+                auto const slot = slots[details::perfect_hash_slot(details::perfect_hash_of<IgnoreCase>(str),
+                                                                   layout.seed, layout.table_size)];
+                if (slot == empty_slot || !details::perfect_hash_equals<IgnoreCase>(keys[slot], str))
+                    return npos;
+                return slot;
+            }
+        }
+
+        [[nodiscard]] static constexpr bool contains(stl::string_view str) noexcept {
+            return index_of(str) != npos;
+        }
+    };
+
+    template <fixed_string... Keys>
+    using perfect_hash = basic_perfect_hash<false, Keys...>;
+
+    /**
+     * The perfect hash for the header names, the file extensions, and the
+     * other keys that don't care about the case of the letters.
+     */
+    template <fixed_string... Keys>
+    using iperfect_hash = basic_perfect_hash<true, Keys...>;
+
+    /**
+     * A map from the keys to the values that's looked up with a perfect hash
+     *
+     *   constexpr fixed_string_map<int, "one", "two"> numbers{1, 2};
+     *   *numbers.find("two") == 2
+     */
+    template <typename Value, bool IgnoreCase, fixed_string... Keys>
+    struct basic_fixed_string_map {
+        using hash_type  = basic_perfect_hash<IgnoreCase, Keys...>;
+        using value_type = Value;
+
+        stl::array<Value, sizeof...(Keys)> values;
+
+        /**
+         * The value of the key, or nullptr
+         */
+        [[nodiscard]] constexpr Value const* find(stl::string_view str) const noexcept {
+            auto const index = hash_type::index_of(str);
+            return index == hash_type::npos ? nullptr : values.data() + index;
+        }
+
+        [[nodiscard]] constexpr Value* find(stl::string_view str) noexcept {
+            auto const index = hash_type::index_of(str);
+            return index == hash_type::npos ? nullptr : values.data() + index;
+        }
+
+        [[nodiscard]] constexpr Value value_or(stl::string_view str, Value const& default_value) const noexcept {
+            auto const* value = find(str);
+            return value ? *value : default_value;
+        }
+
+        [[nodiscard]] constexpr bool contains(stl::string_view str) const noexcept {
+            return hash_type::contains(str);
+        }
+
+        [[nodiscard]] static constexpr stl::size_t size() noexcept {
+            return sizeof...(Keys);
+        }
+    };
+
+    template <typename Value, fixed_string... Keys>
+    using fixed_string_map = basic_fixed_string_map<Value, false, Keys...>;
+
+    template <typename Value, fixed_string... Keys>
+    using ifixed_string_map = basic_fixed_string_map<Value, true, Keys...>;
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_PERFECT_HASH_H
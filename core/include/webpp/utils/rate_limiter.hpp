@@ -0,0 +1,179 @@
+#ifndef WEBPP_UTILS_RATE_LIMITER_H
+#define WEBPP_UTILS_RATE_LIMITER_H
+
+#include "../std/std.hpp"
+#include "./embedded_assets.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+
+namespace webpp {
+
+    struct rate_limit {
+        double rate  = 10; // the requests per second in the long run
+        double burst = 20; // the requests that can come at once
+    };
+
+    /**
+     * Whether a request is allowed, and if it's not, when the next one would be
+     */
+    struct rate_decision {
+        bool                     allowed     = true;
+        stl::chrono::nanoseconds retry_after = {};
+
+        [[nodiscard]] explicit constexpr operator bool() const noexcept {
+            return allowed;
+        }
+    };
+
+    namespace details {
+
+        [[nodiscard]] constexpr stl::uint64_t mix_key(stl::uint64_t hash) noexcept {
+            hash = (hash ^ (hash >> 30U)) * 0xBF58'476D'1CE4'E5B9ULL;
+            hash = (hash ^ (hash >> 27U)) * 0x94D0'49BB'1331'11EBULL;
+            return hash ^ (hash >> 31U);
+        }
+
+        /**
+         * The hash of a key of a rate_limiter: the strings (session ids, ...) by their characters, the
+         * ips by their integers, and the rest by std::hash
+         */
+        template <typename Key>
+        [[nodiscard]] constexpr stl::uint64_t rate_key_hash(Key const& key) noexcept {
+            if constexpr (stl::is_convertible_v<Key const&, stl::string_view>) {
+                return asset_hash(stl::string_view{key}, 0);
+            } else if constexpr (stl::is_integral_v<Key> || stl::is_enum_v<Key>) {
+                return mix_key(static_cast<stl::uint64_t>(key));
+            } else if constexpr (requires { key.octets64(); }) { // ipv6
+                auto const words = key.octets64();
+                return mix_key(words[0] ^ mix_key(words[1]));
+            } else if constexpr (requires { key.integer(); }) { // ipv4
+                return mix_key(key.integer());
+            } else {
+                return mix_key(static_cast<stl::uint64_t>(stl::hash<Key>{}(key)));
+            }
+        }
+
+    } // namespace details
+
+    /**
+     * A rate limiter for each key (a client's ip, a session, a user, ...), with the Generic Cell Rate
+     * Algorithm: a token bucket that only keeps one number for each key, the time that its bucket will
+     * be full again (its "theoretical arrival time"); a request moves it forward by 1/rate, and it's
+     * rejected if that's more than burst/rate from now.
+     *
+     * The keys are in a fixed table of cache-line buckets of 4 entries each, with their hashes, so a
+     * request touches one cache line, and the table doesn't grow with the clients; a new key takes the
+     * entry of its bucket that's the least behind, and the keys whose buckets are already full lose
+     * nothing by being forgotten. The entries are updated with CAS, so the io threads share a limiter
+     * without a lock; when two new keys race for an entry, one of them may get a request more.
+     *
+     *   rate_limiter limiter{{.rate = 5, .burst = 10}};
+     *   if (!limiter.allow(session_id)) return 429;
+     */
+    template <typename Clock = stl::chrono::steady_clock>
+    class rate_limiter {
+        static constexpr stl::size_t bucket_size = 4;
+
+        struct entry {
+            stl::atomic<stl::uint64_t> key{0}; // the hash of the key; zero if it's empty
+            stl::atomic<stl::int64_t>  tat{0}; // in the nanoseconds of the clock
+        };
+
+        struct alignas(64) bucket {
+            stl::array<entry, bucket_size> entries{};
+        };
+
+        stl::unique_ptr<bucket[]> buckets;
+        stl::size_t               mask;
+        stl::int64_t              interval;  // the nanoseconds that a request costs
+        stl::int64_t              tolerance; // how far ahead of now the time of a key can be
+
+        [[nodiscard]] static stl::int64_t now_ns() noexcept {
+            return stl::chrono::duration_cast<stl::chrono::nanoseconds>(Clock::now().time_since_epoch())
+              .count();
+        }
+
+        [[nodiscard]] entry* find(stl::uint64_t hash) noexcept {
+            auto& slots = buckets[(hash >> 32U) & mask].entries;
+            for (int attempt = 0; attempt < 2; attempt++) {
+                entry* victim     = nullptr;
+                auto   victim_tat = stl::int64_t{0};
+                for (auto& item : slots) {
+                    if (item.key.load(stl::memory_order_acquire) == hash)
+                        return &item;
+                    auto const tat = item.tat.load(stl::memory_order_relaxed);
+                    if (!victim || tat < victim_tat) {
+                        victim     = &item;
+                        victim_tat = tat;
+                    }
+                }
+                auto old = victim->key.load(stl::memory_order_relaxed);
+                if (victim->key.compare_exchange_strong(old, hash, stl::memory_order_acq_rel)) {
+                    // unless a request of the new key has been counted already
+                    victim->tat.compare_exchange_strong(victim_tat, 0, stl::memory_order_relaxed);
+                    return victim;
+                }
+            }
+            return nullptr;
+        }
+
+        [[nodiscard]] static constexpr stl::size_t bucket_count(stl::size_t max_keys) noexcept {
+            return stl::bit_ceil(stl::max<stl::size_t>(max_keys / bucket_size, 1));
+        }
+
+      public:
+        explicit rate_limiter(rate_limit limit, stl::size_t max_keys = 65'536)
+          : buckets{stl::make_unique<bucket[]>(bucket_count(max_keys))},
+            mask{bucket_count(max_keys) - 1},
+            interval{static_cast<stl::int64_t>(1e9 / stl::max(limit.rate, 1e-9))},
+            tolerance{
+              static_cast<stl::int64_t>(static_cast<double>(interval) * stl::max(limit.burst, 1.0))} {}
+
+        rate_limiter(rate_limiter const&)            = delete;
+        rate_limiter& operator=(rate_limiter const&) = delete;
+
+        /**
+         * Count a request of the key (that costs "cost" requests), if it's allowed
+         */
+        template <typename Key>
+        rate_decision acquire(Key const& key, unsigned cost = 1) noexcept {
+            auto* const item = find(details::rate_key_hash(key) | 1U);
+            if (!item)
+                return {}; // the bucket is too busy to tell
+            auto const now = now_ns();
+            auto       tat = item->tat.load(stl::memory_order_relaxed);
+            for (;;) {
+                auto const next = stl::max(tat, now) + interval * static_cast<stl::int64_t>(cost);
+                if (next - now > tolerance)
+                    return {false, stl::chrono::nanoseconds{next - now - tolerance}};
+                if (item->tat.compare_exchange_weak(tat, next, stl::memory_order_relaxed))
+                    return {};
+            }
+        }
+
+        template <typename Key>
+        [[nodiscard]] bool allow(Key const& key) noexcept {
+            return acquire(key).allowed;
+        }
+
+        /**
+         * The number of the keys that it can keep
+         */
+        [[nodiscard]] stl::size_t capacity() const noexcept {
+            return (mask + 1) * bucket_size;
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_RATE_LIMITER_H
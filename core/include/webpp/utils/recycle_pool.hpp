@@ -0,0 +1,77 @@
+#ifndef WEBPP_UTILS_RECYCLE_POOL_H
+#define WEBPP_UTILS_RECYCLE_POOL_H
+
+#include "../std/std.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace webpp {
+
+    /**
+     * The objects that can be cleared and used again without giving back the
+     * memory they've got (the buckets of the containers, the capacity of the
+     * strings, ...).
+     */
+    template <typename T>
+    concept Recyclable = stl::is_move_constructible_v<T> && requires(T obj) {
+        obj.clear();
+    };
+
+    /**
+     * A free-list of the cleared objects of a type, for each thread.
+     *
+     * The objects are moved in and out of the pool, so they keep the memory
+     * that they own; once the pool has as many objects as a thread needs at
+     * the same time, taking an object from it doesn't allocate.
+     */
+    template <Recyclable T, stl::size_t Capacity = 16>
+    class recycle_pool {
+        stl::vector<T> objects;
+
+      public:
+        recycle_pool() {
+            objects.reserve(Capacity);
+        }
+
+        recycle_pool(recycle_pool const&) = delete;
+        recycle_pool& operator=(recycle_pool const&) = delete;
+
+        /**
+         * A cleared object; a new one if the pool is empty
+         */
+        [[nodiscard]] T acquire() noexcept {
+            if (objects.empty())
+                return T{};
+            T obj{stl::move(objects.back())};
+            objects.pop_back();
+            return obj;
+        }
+
+        /**
+         * Clear the object, and keep it for the next one who asks; it's
+         * destroyed if the pool is full.
+         */
+        void recycle(T&& obj) noexcept {
+            if (objects.size() == Capacity)
+                return;
+            obj.clear();
+            objects.push_back(stl::move(obj));
+        }
+
+        [[nodiscard]] stl::size_t size() const noexcept {
+            return objects.size();
+        }
+
+        /**
+         * The pool of this thread
+         */
+        [[nodiscard]] static recycle_pool& local() noexcept {
+            thread_local recycle_pool pool;
+            return pool;
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_RECYCLE_POOL_H
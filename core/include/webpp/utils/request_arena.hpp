@@ -0,0 +1,124 @@
+#ifndef WEBPP_UTILS_REQUEST_ARENA_H
+#define WEBPP_UTILS_REQUEST_ARENA_H
+
+#include "../std/std.hpp"
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+namespace webpp {
+
+    namespace details {
+        inline thread_local stl::pmr::memory_resource* current_request_resource = nullptr;
+    } // namespace details
+
+    /**
+     * The memory resource of the request that is being served on this thread,
+     * or the default resource if there's none.
+     */
+    [[nodiscard]] inline stl::pmr::memory_resource* current_request_resource() noexcept {
+        auto* const res = details::current_request_resource;
+        return res ? res : stl::pmr::get_default_resource();
+    }
+
+    /**
+     * A bump allocator for everything that lives as long as one request; its
+     * first few kilobytes are inside of it, and the rest comes from the
+     * upstream in growing blocks. Nothing is freed until the request is done,
+     * then it's reset in one go and the blocks are given back.
+     */
+    class request_arena {
+      public:
+        static constexpr stl::size_t inline_size = 8 * 1024;
+
+      private:
+        alignas(stl::max_align_t) stl::array<stl::byte, inline_size> buffer;
+        stl::pmr::monotonic_buffer_resource resource;
+
+      public:
+        explicit request_arena(stl::pmr::memory_resource* upstream = stl::pmr::new_delete_resource()) noexcept
+          : resource{buffer.data(), buffer.size(), upstream} {}
+
+        request_arena(request_arena const&) = delete;
+        request_arena& operator=(request_arena const&) = delete;
+
+        [[nodiscard]] stl::pmr::memory_resource* get() noexcept {
+            return &resource;
+        }
+
+        /**
+         * Forget everything that's allocated so far; the strings that were
+         * allocated here should not be used after this.
+         */
+        void reset() noexcept {
+            resource.release();
+        }
+
+        /**
+         * The arena of this thread; the interfaces reuse it for every request
+         * that they serve on the thread.
+         */
+        [[nodiscard]] static request_arena& local() noexcept {
+            thread_local request_arena arena;
+            return arena;
+        }
+    };
+
+    /**
+     * While it's alive, the request_allocators that are made on this thread
+     * get their memory from the resource (the request's arena).
+     */
+    class request_arena_scope {
+        stl::pmr::memory_resource* previous;
+
+      public:
+        explicit request_arena_scope(stl::pmr::memory_resource* resource) noexcept
+          : previous{stl::exchange(details::current_request_resource, resource)} {}
+
+        explicit request_arena_scope(request_arena& arena) noexcept : request_arena_scope{arena.get()} {}
+
+        request_arena_scope(request_arena_scope const&) = delete;
+        request_arena_scope& operator=(request_arena_scope const&) = delete;
+
+        ~request_arena_scope() noexcept {
+            details::current_request_resource = previous;
+        }
+    };
+
+    /**
+     * The things that outlive the request (the caches, mostly) are made in this
+     * scope, so they don't get their memory from the request's arena.
+     */
+    class outside_request_arena : public request_arena_scope {
+      public:
+        outside_request_arena() noexcept : request_arena_scope{nullptr} {}
+    };
+
+    /**
+     * A polymorphic allocator that uses the arena of the current request when
+     * it's made; so the strings of the traits that use it (std_arena_traits)
+     * get their memory from the request arena without passing the allocator
+     * to each one of them. The copies of the containers get the arena that's
+     * current at the time of the copy, not the arena of the original.
+     */
+    template <typename T>
+    struct request_allocator : public stl::pmr::polymorphic_allocator<T> {
+        using stl::pmr::polymorphic_allocator<T>::polymorphic_allocator;
+
+        request_allocator() noexcept : stl::pmr::polymorphic_allocator<T>{current_request_resource()} {}
+
+        template <typename U>
+        request_allocator(request_allocator<U> const& other) noexcept
+          : stl::pmr::polymorphic_allocator<T>{other.resource()} {}
+
+        [[nodiscard]] request_allocator select_on_container_copy_construction() const noexcept {
+            return {};
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_REQUEST_ARENA_H
@@ -0,0 +1,119 @@
+#ifndef WEBPP_UTILS_SHA1_H
+#define WEBPP_UTILS_SHA1_H
+
+#include "../std/std.hpp"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string_view>
+
+namespace webpp {
+
+    /**
+     * SHA-1 (RFC 3174); it's broken as a cryptographic hash, it's here for the
+     * protocols that still use it as a checksum (the WebSocket handshake).
+     *
+     *   sha1 hash;
+     *   hash.update("abc");
+     *   auto const digest = hash.digest(); // 20 bytes
+     */
+    class sha1 {
+      public:
+        using digest_type = stl::array<stl::uint8_t, 20>;
+
+      private:
+        stl::array<stl::uint32_t, 5> state{0x67452301u, 0xEFCDAB89u, 0x98BADCFEu, 0x10325476u, 0xC3D2E1F0u};
+        stl::array<stl::uint8_t, 64> block{};
+        stl::size_t                  block_size = 0;
+        stl::uint64_t                total_size = 0;
+
+        constexpr void compress() noexcept {
+            stl::array<stl::uint32_t, 80> w{};
+            for (stl::size_t i = 0; i < 16; i++) {
+                w[i] = (stl::uint32_t{block[i * 4]} << 24u) | (stl::uint32_t{block[i * 4 + 1]} << 16u) |
+                       (stl::uint32_t{block[i * 4 + 2]} << 8u) | stl::uint32_t{block[i * 4 + 3]};
+            }
+            for (stl::size_t i = 16; i < 80; i++)
+                w[i] = stl::rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+            auto [a, b, c, d, e] = state;
+            for (stl::size_t i = 0; i < 80; i++) {
+                stl::uint32_t f = 0;
+                stl::uint32_t k = 0;
+                if (i < 20) {
+                    f = (b & c) | (~b & d);
+                    k = 0x5A827999u;
+                } else if (i < 40) {
+                    f = b ^ c ^ d;
+                    k = 0x6ED9EBA1u;
+                } else if (i < 60) {
+                    f = (b & c) | (b & d) | (c & d);
+                    k = 0x8F1BBCDCu;
+                } else {
+                    f = b ^ c ^ d;
+                    k = 0xCA62C1D6u;
+                }
+                auto const temp = stl::rotl(a, 5) + f + e + k + w[i];
+                e               = d;
+                d               = c;
+                c               = stl::rotl(b, 30);
+                b               = a;
+                a               = temp;
+            }
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+        }
+
+      public:
+        constexpr sha1() noexcept = default;
+
+        constexpr sha1& update(stl::string_view data) noexcept {
+            total_size += data.size();
+            for (auto const c : data) {
+                block[block_size++] = static_cast<stl::uint8_t>(c);
+                if (block_size == block.size()) {
+                    compress();
+                    block_size = 0;
+                }
+            }
+            return *this;
+        }
+
+        /**
+         * The hash of what's given so far; it's not to be updated after this
+         */
+        [[nodiscard]] constexpr digest_type digest() noexcept {
+            auto const bits = total_size * 8;
+            block[block_size++] = 0x80;
+            if (block_size > 56) {
+                while (block_size < 64)
+                    block[block_size++] = 0;
+                compress();
+                block_size = 0;
+            }
+            while (block_size < 56)
+                block[block_size++] = 0;
+            for (stl::size_t i = 0; i < 8; i++)
+                block[56 + i] = static_cast<stl::uint8_t>(bits >> (56u - i * 8u));
+            compress();
+
+            digest_type res{};
+            for (stl::size_t i = 0; i < 20; i++)
+                res[i] = static_cast<stl::uint8_t>(state[i / 4] >> (24u - (i % 4) * 8u));
+            return res;
+        }
+
+        [[nodiscard]] static constexpr digest_type hash(stl::string_view data) noexcept {
+            sha1 res;
+            res.update(data);
+            return res.digest();
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_SHA1_H
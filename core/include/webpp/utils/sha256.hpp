@@ -0,0 +1,134 @@
+#ifndef WEBPP_UTILS_SHA256_H
+#define WEBPP_UTILS_SHA256_H
+
+#include "../std/std.hpp"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string_view>
+
+namespace webpp {
+
+    /**
+     * SHA-256 (FIPS 180-4); for the protocols that name things by their
+     * hash (the persisted queries of GraphQL), not for the passwords.
+     *
+     *   sha256 hash;
+     *   hash.update("abc");
+     *   auto const digest = hash.digest(); // 32 bytes
+     */
+    class sha256 {
+      public:
+        using digest_type = stl::array<stl::uint8_t, 32>;
+
+      private:
+        static constexpr stl::array<stl::uint32_t, 64> round_constants{
+          0x428a2f98u, 0x71374491u, 0xb5c0fbcfu, 0xe9b5dba5u, 0x3956c25bu, 0x59f111f1u, 0x923f82a4u, 0xab1c5ed5u,
+          0xd807aa98u, 0x12835b01u, 0x243185beu, 0x550c7dc3u, 0x72be5d74u, 0x80deb1feu, 0x9bdc06a7u, 0xc19bf174u,
+          0xe49b69c1u, 0xefbe4786u, 0x0fc19dc6u, 0x240ca1ccu, 0x2de92c6fu, 0x4a7484aau, 0x5cb0a9dcu, 0x76f988dau,
+          0x983e5152u, 0xa831c66du, 0xb00327c8u, 0xbf597fc7u, 0xc6e00bf3u, 0xd5a79147u, 0x06ca6351u, 0x14292967u,
+          0x27b70a85u, 0x2e1b2138u, 0x4d2c6dfcu, 0x53380d13u, 0x650a7354u, 0x766a0abbu, 0x81c2c92eu, 0x92722c85u,
+          0xa2bfe8a1u, 0xa81a664bu, 0xc24b8b70u, 0xc76c51a3u, 0xd192e819u, 0xd6990624u, 0xf40e3585u, 0x106aa070u,
+          0x19a4c116u, 0x1e376c08u, 0x2748774cu, 0x34b0bcb5u, 0x391c0cb3u, 0x4ed8aa4au, 0x5b9cca4fu, 0x682e6ff3u,
+          0x748f82eeu, 0x78a5636fu, 0x84c87814u, 0x8cc70208u, 0x90befffau, 0xa4506cebu, 0xbef9a3f7u, 0xc67178f2u};
+
+        stl::array<stl::uint32_t, 8> state{0x6a09e667u,
+                                           0xbb67ae85u,
+                                           0x3c6ef372u,
+                                           0xa54ff53au,
+                                           0x510e527fu,
+                                           0x9b05688cu,
+                                           0x1f83d9abu,
+                                           0x5be0cd19u};
+        stl::array<stl::uint8_t, 64> block{};
+        stl::size_t                  block_size = 0;
+        stl::uint64_t                total_size = 0;
+
+        constexpr void compress() noexcept {
+            stl::array<stl::uint32_t, 64> w{};
+            for (stl::size_t i = 0; i < 16; i++) {
+                w[i] = (stl::uint32_t{block[i * 4]} << 24u) | (stl::uint32_t{block[i * 4 + 1]} << 16u) |
+                       (stl::uint32_t{block[i * 4 + 2]} << 8u) | stl::uint32_t{block[i * 4 + 3]};
+            }
+            for (stl::size_t i = 16; i < 64; i++) {
+                auto const s0 = stl::rotr(w[i - 15], 7) ^ stl::rotr(w[i - 15], 18) ^ (w[i - 15] >> 3u);
+                auto const s1 = stl::rotr(w[i - 2], 17) ^ stl::rotr(w[i - 2], 19) ^ (w[i - 2] >> 10u);
+                w[i]          = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            auto [a, b, c, d, e, f, g, h] = state;
+            for (stl::size_t i = 0; i < 64; i++) {
+                auto const s1    = stl::rotr(e, 6) ^ stl::rotr(e, 11) ^ stl::rotr(e, 25);
+                auto const ch    = (e & f) ^ (~e & g);
+                auto const temp1 = h + s1 + ch + round_constants[i] + w[i];
+                auto const s0    = stl::rotr(a, 2) ^ stl::rotr(a, 13) ^ stl::rotr(a, 22);
+                auto const maj   = (a & b) ^ (a & c) ^ (b & c);
+                h                = g;
+                g                = f;
+                f                = e;
+                e                = d + temp1;
+                d                = c;
+                c                = b;
+                b                = a;
+                a                = temp1 + s0 + maj;
+            }
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+            state[5] += f;
+            state[6] += g;
+            state[7] += h;
+        }
+
+      public:
+        constexpr sha256() noexcept = default;
+
+        constexpr sha256& update(stl::string_view data) noexcept {
+            total_size += data.size();
+            for (auto const c : data) {
+                block[block_size++] = static_cast<stl::uint8_t>(c);
+                if (block_size == block.size()) {
+                    compress();
+                    block_size = 0;
+                }
+            }
+            return *this;
+        }
+
+        /**
+         * The hash of what's given so far; it's not to be updated after this
+         */
+        [[nodiscard]] constexpr digest_type digest() noexcept {
+            auto const bits = total_size * 8;
+            block[block_size++] = 0x80;
+            if (block_size > 56) {
+                while (block_size < 64)
+                    block[block_size++] = 0;
+                compress();
+                block_size = 0;
+            }
+            while (block_size < 56)
+                block[block_size++] = 0;
+            for (stl::size_t i = 0; i < 8; i++)
+                block[56 + i] = static_cast<stl::uint8_t>(bits >> (56u - i * 8u));
+            compress();
+
+            digest_type res{};
+            for (stl::size_t i = 0; i < 32; i++)
+                res[i] = static_cast<stl::uint8_t>(state[i / 4] >> (24u - (i % 4) * 8u));
+            return res;
+        }
+
+        [[nodiscard]] static constexpr digest_type hash(stl::string_view data) noexcept {
+            sha256 res;
+            res.update(data);
+            return res.digest();
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_SHA256_H
@@ -8,8 +8,22 @@
 #include "../traits/traits_concepts.hpp"
 
 #include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <type_traits>
 
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#    define WEBPP_STRINGS_SCANNER_WIDTH 32
+#elif defined(__SSE2__)
+#    include <emmintrin.h>
+#    define WEBPP_STRINGS_SCANNER_WIDTH 16
+#else
+#    define WEBPP_STRINGS_SCANNER_WIDTH 1
+#endif
+
 namespace webpp {
 
     /**
@@ -38,45 +52,163 @@ namespace webpp {
     //          std::is_const_v<StringTypeRaw>,
     //        std::basic_string_view<CharT>, StringTypeRaw>>;
 
+    namespace details {
+
+        /**
+         * The white spaces of the trims: ' ', '\t', '\n', '\v', '\f' and '\r'
+         */
+        template <typename CharT>
+        [[nodiscard]] constexpr bool is_ascii_space(CharT c) noexcept {
+            return c == ' ' || (c >= '\t' && c <= '\r');
+        }
+
+#if WEBPP_STRINGS_SCANNER_WIDTH == 32
+        static constexpr stl::uint32_t all_chunk_bits = 0xFFFF'FFFFu;
+
+        [[nodiscard]] inline __m256i load_chunk(char const* data) noexcept {
+            return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data));
+        }
+
+        // a bit for each of the white spaces of the chunk
+        [[nodiscard]] inline stl::uint32_t
+        space_bits(__m256i chunk) noexcept {
+            // '\t' to '\r' are the ones that are 4 at most after '\t'
+            auto const from_tab =
+              _mm256_sub_epi8(chunk, _mm256_set1_epi8('\t'));
+            auto const controls = _mm256_cmpeq_epi8(
+              _mm256_min_epu8(from_tab, _mm256_set1_epi8(4)), from_tab);
+            auto const spaces =
+              _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' '));
+            return static_cast<stl::uint32_t>(
+              _mm256_movemask_epi8(_mm256_or_si256(controls, spaces)));
+        }
+
+        // flip the case of the 26 letters from "first" on, in place
+        inline void flip_case(char* data, char first) noexcept {
+            auto const chunk   = load_chunk(data);
+            auto const shift   = _mm256_set1_epi8(
+              static_cast<char>(first + 128));
+            auto const letters = _mm256_cmpgt_epi8(
+              _mm256_set1_epi8(-128 + 26), _mm256_sub_epi8(chunk, shift));
+            _mm256_storeu_si256(
+              reinterpret_cast<__m256i*>(data),
+              _mm256_xor_si256(
+                chunk, _mm256_and_si256(letters, _mm256_set1_epi8(0x20))));
+        }
+#elif WEBPP_STRINGS_SCANNER_WIDTH == 16
+        static constexpr stl::uint32_t all_chunk_bits = 0xFFFFu;
+
+        [[nodiscard]] inline __m128i load_chunk(char const* data) noexcept {
+            return _mm_loadu_si128(reinterpret_cast<__m128i const*>(data));
+        }
+
+        // a bit for each of the white spaces of the chunk
+        [[nodiscard]] inline stl::uint32_t
+        space_bits(__m128i chunk) noexcept {
+            // '\t' to '\r' are the ones that are 4 at most after '\t'
+            auto const from_tab = _mm_sub_epi8(chunk, _mm_set1_epi8('\t'));
+            auto const controls = _mm_cmpeq_epi8(
+              _mm_min_epu8(from_tab, _mm_set1_epi8(4)), from_tab);
+            auto const spaces = _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' '));
+            return static_cast<stl::uint32_t>(
+              _mm_movemask_epi8(_mm_or_si128(controls, spaces)));
+        }
+
+        // flip the case of the 26 letters from "first" on, in place
+        inline void flip_case(char* data, char first) noexcept {
+            auto const chunk   = load_chunk(data);
+            auto const shift   = _mm_set1_epi8(static_cast<char>(first + 128));
+            auto const letters = _mm_cmplt_epi8(_mm_sub_epi8(chunk, shift),
+                                                _mm_set1_epi8(-128 + 26));
+            _mm_storeu_si128(
+              reinterpret_cast<__m128i*>(data),
+              _mm_xor_si128(chunk,
+                            _mm_and_si128(letters, _mm_set1_epi8(0x20))));
+        }
+#endif
+
+        /**
+         * The number of the white spaces at the start of the string
+         */
+        template <typename CharT>
+        [[nodiscard]] constexpr stl::size_t
+        leading_spaces(CharT const* data, stl::size_t size) noexcept {
+            if (size == 0 || !is_ascii_space(data[0]))
+                return 0; // the usual case
+            stl::size_t pos = 0;
+#if WEBPP_STRINGS_SCANNER_WIDTH > 1
+            constexpr stl::size_t width = WEBPP_STRINGS_SCANNER_WIDTH;
+            if constexpr (stl::is_same_v<CharT, char>) {
+                if (!stl::is_constant_evaluated()) {
+                    for (; pos + width <= size; pos += width) {
+                        auto const others =
+                          ~space_bits(load_chunk(data + pos)) & all_chunk_bits;
+                        if (others != 0)
+                            return pos + static_cast<stl::size_t>(
+                                           __builtin_ctz(others));
+                    }
+                }
+            }
+#endif
+            while (pos < size && is_ascii_space(data[pos]))
+                pos++;
+            return pos;
+        }
+
+        /**
+         * The size of the string without the white spaces at its end
+         */
+        template <typename CharT>
+        [[nodiscard]] constexpr stl::size_t
+        trimmed_size(CharT const* data, stl::size_t size) noexcept {
+            if (size == 0 || !is_ascii_space(data[size - 1]))
+                return size; // the usual case
+#if WEBPP_STRINGS_SCANNER_WIDTH > 1
+            constexpr stl::size_t width = WEBPP_STRINGS_SCANNER_WIDTH;
+            if constexpr (stl::is_same_v<CharT, char>) {
+                if (!stl::is_constant_evaluated()) {
+                    for (; size >= width; size -= width) {
+                        auto const others =
+                          ~space_bits(load_chunk(data + size - width)) &
+                          all_chunk_bits;
+                        if (others != 0)
+                            return size - width + 32 -
+                                   static_cast<stl::size_t>(
+                                     __builtin_clz(others));
+                    }
+                }
+            }
+#endif
+            while (size > 0 && is_ascii_space(data[size - 1]))
+                size--;
+            return size;
+        }
+
+    } // namespace details
+
     // trim from start (in place)
     template <Traits TraitsType>
-    inline void ltrim(typename TraitsType::string_view_type& s) noexcept {
-        if (auto found = stl::find_if_not(s.begin(), s.end(),
-                                          [](auto const& c) -> bool {
-                                              return c == ' ' || c == '\n' ||
-                                                     c == '\r' || c == '\t' ||
-                                                     c == '\f' || c == '\v';
-                                          });
-            found != s.end()) {
-            s.remove_prefix(
-              static_cast<decltype(s.size())>(stl::distance(s.begin(), found)));
-        }
+    constexpr void ltrim(typename TraitsType::string_view_type& s) noexcept {
+        s.remove_prefix(details::leading_spaces(s.data(), s.size()));
     }
 
 
     // trim from end (in place)
     template <Traits TraitsType>
-    inline void rtrim(typename TraitsType::string_view_type& s) noexcept {
-        if (auto found = stl::find_if_not(s.rbegin(), s.rend(),
-                                          [](auto const& c) -> bool {
-                                              return stl::isspace(c);
-                                          });
-            found != s.rend()) {
-            s.remove_suffix(static_cast<decltype(s.size())>(
-              stl::distance(s.rbegin(), found)));
-        }
+    constexpr void rtrim(typename TraitsType::string_view_type& s) noexcept {
+        s.remove_suffix(s.size() - details::trimmed_size(s.data(), s.size()));
     }
 
     // trim from both ends (in place)
     template <Traits TraitsType>
-    inline void trim(typename TraitsType::string_view_type& s) noexcept {
+    constexpr void trim(typename TraitsType::string_view_type& s) noexcept {
         ltrim<TraitsType>(s);
         rtrim<TraitsType>(s);
     }
 
     // trim from start (copying)
     template <Traits TraitsType>
-    [[nodiscard]] inline typename TraitsType::string_view_type
+    [[nodiscard]] constexpr typename TraitsType::string_view_type
     ltrim_copy(typename TraitsType::string_view_type s) noexcept {
         ltrim<TraitsType>(s);
         return s;
@@ -84,7 +216,7 @@ namespace webpp {
 
     // trim from end (copying)
     template <Traits TraitsType>
-    [[nodiscard]] inline typename TraitsType::string_view_type
+    [[nodiscard]] constexpr typename TraitsType::string_view_type
     rtrim_copy(typename TraitsType::string_view_type s) noexcept {
         rtrim<TraitsType>(s);
         return s;
@@ -92,7 +224,7 @@ namespace webpp {
 
     // trim from both ends (copying)
     template <Traits TraitsType>
-    [[nodiscard]] inline typename TraitsType::string_view_type
+    [[nodiscard]] constexpr typename TraitsType::string_view_type
     trim_copy(typename TraitsType::string_view_type s) noexcept {
         trim<TraitsType>(s);
         return s;
@@ -101,22 +233,13 @@ namespace webpp {
     // trim from start (in place)
     template <Traits TraitsType>
     inline void ltrim(typename TraitsType::string_type& s) noexcept {
-        s.erase(s.begin(), stl::find_if(s.begin(), s.end(), [](auto c) {
-                    return c != ' ' && c != '\n' && c != '\r' && c != '\t' &&
-                           c != '\f' && c != '\v';
-                }));
+        s.erase(0, details::leading_spaces(s.data(), s.size()));
     }
 
     // trim from end (in place)
     template <Traits TraitsType>
     inline void rtrim(typename TraitsType::string_type& s) noexcept {
-        s.erase(stl::find_if(s.rbegin(), s.rend(),
-                             [](auto c) {
-                                 return c != ' ' && c != '\n' && c != '\r' &&
-                                        c != '\t' && c != '\f' && c != '\v';
-                             })
-                  .base(),
-                s.end());
+        s.erase(details::trimmed_size(s.data(), s.size()));
     }
 
     // trim from both ends (in place)
@@ -150,27 +273,66 @@ namespace webpp {
         return s;
     }
 
+    /**
+     * Lowercase the ASCII letters of the chars in place, like the header names;
+     * the other bytes (the UTF-8 ones too) are left alone.
+     */
+    inline void ascii_to_lower(char* data, stl::size_t size) noexcept {
+        stl::size_t pos = 0;
+#if WEBPP_STRINGS_SCANNER_WIDTH > 1
+        constexpr stl::size_t width = WEBPP_STRINGS_SCANNER_WIDTH;
+        for (; pos + width <= size; pos += width)
+            details::flip_case(data + pos, 'A');
+#endif
+        for (; pos < size; pos++)
+            if (data[pos] >= 'A' && data[pos] <= 'Z')
+                data[pos] = static_cast<char>(data[pos] + ('a' - 'A'));
+    }
+
+    /**
+     * Uppercase the ASCII letters of the chars in place
+     */
+    inline void ascii_to_upper(char* data, stl::size_t size) noexcept {
+        stl::size_t pos = 0;
+#if WEBPP_STRINGS_SCANNER_WIDTH > 1
+        constexpr stl::size_t width = WEBPP_STRINGS_SCANNER_WIDTH;
+        for (; pos + width <= size; pos += width)
+            details::flip_case(data + pos, 'a');
+#endif
+        for (; pos < size; pos++)
+            if (data[pos] >= 'a' && data[pos] <= 'z')
+                data[pos] = static_cast<char>(data[pos] - ('a' - 'A'));
+    }
+
+    // the ASCII letters only, the way the HTTP names are compared
     template <Traits TraitsType>
-    inline void to_lower(typename TraitsType::stirng_type& str) noexcept {
-        // FIXME: I think you can make this algorithm faster
-        stl::transform(str.cbegin(), str.cend(), str.begin(), [](auto c) {
-            return stl::tolower(c);
-        });
+    inline void to_lower(typename TraitsType::string_type& str) noexcept {
+        using char_type = typename TraitsType::char_type;
+        if constexpr (stl::is_same_v<char_type, char>) {
+            ascii_to_lower(str.data(), str.size());
+        } else {
+            for (auto& c : str)
+                if (c >= 'A' && c <= 'Z')
+                    c = static_cast<char_type>(c + ('a' - 'A'));
+        }
     }
 
     template <Traits TraitsType>
     inline void to_upper(typename TraitsType::string_type& str) noexcept {
-        // FIXME: I think you can make this algorithm faster
-        stl::transform(str.cbegin(), str.cend(), str.begin(),
-                       [](auto const& c) {
-                           return stl::tolower(c);
-                       });
+        using char_type = typename TraitsType::char_type;
+        if constexpr (stl::is_same_v<char_type, char>) {
+            ascii_to_upper(str.data(), str.size());
+        } else {
+            for (auto& c : str)
+                if (c >= 'a' && c <= 'z')
+                    c = static_cast<char_type>(c - ('a' - 'A'));
+        }
     }
 
     template <Traits TraitsType>
     [[nodiscard]] inline typename TraitsType::string_type
     to_lower_copy(typename TraitsType::string_type str) noexcept {
-        to_lower(str);
+        to_lower<TraitsType>(str);
         return str;
     }
 
@@ -181,6 +343,103 @@ namespace webpp {
         return str;
     }
 
+    namespace details {
+
+        static constexpr stl::uint64_t byte_ones = 0x0101'0101'0101'0101ull;
+
+        /**
+         * Lowercase the ASCII letters of the 8 bytes of the word at once
+         */
+        [[nodiscard]] constexpr stl::uint64_t
+        ascii_lower_word(stl::uint64_t word) noexcept {
+            // the high bit of each byte tells if it's >= 'A' and if it's > 'Z';
+            // the bytes are 0x7F at most, so they don't carry into each other
+            auto const heptets = word & (0x7Fu * byte_ones);
+            auto const from_a  = heptets + (0x80u - 'A') * byte_ones;
+            auto const after_z = heptets + (0x80u - 'Z' - 1) * byte_ones;
+            auto const upper =
+              from_a & ~after_z & ~word & (0x80u * byte_ones);
+            return word | (upper >> 2u);
+        }
+
+        template <typename T>
+        [[nodiscard]] inline stl::uint64_t
+        load_bytes(char const* data) noexcept {
+            T value;
+            stl::memcpy(&value, data, sizeof(T));
+            return value;
+        }
+
+        /**
+         * The 8 bytes (or the "size" ones that are left) as a little-endian
+         * word; the missing bytes are zero.
+         */
+        [[nodiscard]] constexpr stl::uint64_t
+        load_word(char const* data, stl::size_t size) noexcept {
+            if constexpr (stl::endian::native == stl::endian::little) {
+                if (!stl::is_constant_evaluated()) {
+                    // two loads that overlap in the middle, instead of a loop
+                    if (size >= 8)
+                        return load_bytes<stl::uint64_t>(data);
+                    if (size >= 4)
+                        return load_bytes<stl::uint32_t>(data) |
+                               load_bytes<stl::uint32_t>(data + size - 4)
+                                 << (8u * (size - 4));
+                    if (size >= 2)
+                        return load_bytes<stl::uint16_t>(data) |
+                               load_bytes<stl::uint16_t>(data + size - 2)
+                                 << (8u * (size - 2));
+                    return size == 0 ? 0 : static_cast<unsigned char>(*data);
+                }
+            }
+            stl::uint64_t word = 0;
+            for (stl::size_t i = 0; i < size && i < 8; i++)
+                word |= stl::uint64_t{static_cast<unsigned char>(data[i])}
+                        << (8u * i);
+            return word;
+        }
+
+    } // namespace details
+
+    /**
+     * Compare the strings with the ASCII letters case-insensitively, the way
+     * the header names are compared; 8 bytes at a time.
+     */
+    [[nodiscard]] constexpr bool ascii_iequals(stl::string_view a,
+                                               stl::string_view b) noexcept {
+        if (a.size() != b.size())
+            return false;
+        auto const same = [&](stl::size_t pos, stl::size_t size) constexpr {
+            auto const wa = details::load_word(a.data() + pos, size);
+            auto const wb = details::load_word(b.data() + pos, size);
+            return wa == wb || details::ascii_lower_word(wa) ==
+                                 details::ascii_lower_word(wb);
+        };
+        if (a.size() < 8)
+            return same(0, a.size());
+        stl::size_t pos = 0;
+        for (; pos + 8 < a.size(); pos += 8)
+            if (!same(pos, 8))
+                return false;
+        return same(a.size() - 8, 8); // the last word overlaps the one before
+    }
+
+    /**
+     * A hash of the string that ignores the case of the ASCII letters, so the
+     * strings that are ascii_iequals have the same hash; 8 bytes at a time.
+     */
+    [[nodiscard]] constexpr stl::size_t
+    ascii_ihash(stl::string_view str) noexcept {
+        constexpr stl::uint64_t multiplier = 0x9E37'79B9'7F4A'7C15ull;
+        stl::uint64_t           hash       = str.size() * multiplier;
+        for (stl::size_t pos = 0; pos < str.size(); pos += 8) {
+            auto const word = details::ascii_lower_word(
+              details::load_word(str.data() + pos, str.size() - pos));
+            hash = (stl::rotl(hash, 5) ^ word) * multiplier;
+        }
+        return static_cast<stl::size_t>(hash ^ (hash >> 32u));
+    }
+
     template <Traits TraitsType, typename T>
     [[nodiscard]] constexpr bool
     starts_with(typename TraitsType::string_view_type const& str,
@@ -218,4 +477,6 @@ namespace webpp {
 
 } // namespace webpp
 
+#undef WEBPP_STRINGS_SCANNER_WIDTH
+
 #endif // WEBPP_UTILS_STRINGS_H
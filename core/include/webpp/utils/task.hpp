@@ -0,0 +1,240 @@
+#ifndef WEBPP_UTILS_TASK_H
+#define WEBPP_UTILS_TASK_H
+
+#include "../std/coroutine.hpp"
+#include "../std/optional.hpp"
+
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+namespace webpp {
+
+    template <typename T = void>
+    class task;
+
+    namespace details {
+
+        /**
+         * A coroutine that nobody waits for; it runs until its first suspension
+         * right away, and it frees itself when it's done.
+         */
+        struct detached_task {
+            struct promise_type {
+                detached_task get_return_object() noexcept {
+                    return {};
+                }
+
+                stl::suspend_never initial_suspend() noexcept {
+                    return {};
+                }
+
+                stl::suspend_never final_suspend() noexcept {
+                    return {};
+                }
+
+                void return_void() noexcept {}
+
+                void unhandled_exception() noexcept {
+                    stl::terminate();
+                }
+            };
+        };
+
+        /**
+         * Resume the awaiting coroutine directly (symmetric transfer), so a
+         * long chain of tasks doesn't grow the stack
+         */
+        struct task_final_awaiter {
+            bool await_ready() noexcept {
+                return false;
+            }
+
+            template <typename Promise>
+            stl::coroutine_handle<> await_suspend(stl::coroutine_handle<Promise> handle) noexcept {
+                return handle.promise().continuation;
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        template <typename T>
+        struct task_promise_base {
+            stl::coroutine_handle<> continuation = stl::noop_coroutine();
+
+            stl::suspend_always initial_suspend() noexcept {
+                return {};
+            }
+
+            task_final_awaiter final_suspend() noexcept {
+                return {};
+            }
+
+            // there's no place to throw the exceptions to; the routes are noexcept too
+            void unhandled_exception() noexcept {
+                stl::terminate();
+            }
+        };
+
+        template <typename T>
+        struct task_promise : task_promise_base<T> {
+            stl::optional<T> value{};
+
+            task<T> get_return_object() noexcept;
+
+            template <typename U>
+            void return_value(U&& val) noexcept {
+                value.emplace(stl::forward<U>(val));
+            }
+        };
+
+        template <>
+        struct task_promise<void> : task_promise_base<void> {
+            task<void> get_return_object() noexcept;
+
+            void return_void() noexcept {}
+        };
+
+    } // namespace details
+
+    /**
+     * A lazy coroutine that returns a T; it starts when it's awaited (or
+     * started), and it resumes its awaiter when it's done. The routes that
+     * wait for their databases or upstream services return a task<Response>
+     * instead of blocking the io thread, and whatever they await resumes them
+     * (usually the io_context of the thread).
+     *
+     * A task can be made ready without a coroutine too (task<T>::ready), which
+     * doesn't allocate a coroutine frame; the router uses it for the
+     * synchronous routes.
+     */
+    template <typename T>
+    class [[nodiscard]] task {
+      public:
+        using value_type   = T;
+        using promise_type = details::task_promise<T>;
+        using handle_type  = stl::coroutine_handle<promise_type>;
+
+      private:
+        struct ready_value {
+            stl::optional<T> value{};
+        };
+        struct ready_void {
+            bool value = false;
+        };
+
+        handle_type handle{};
+        stl::conditional_t<stl::is_void_v<T>, ready_void, ready_value> ready_state{};
+
+        template <typename>
+        friend struct details::task_promise;
+
+        explicit task(handle_type h) noexcept : handle{h} {}
+
+      public:
+        task() noexcept = default;
+
+        task(task&& other) noexcept
+          : handle{stl::exchange(other.handle, {})},
+            ready_state{stl::move(other.ready_state)} {}
+
+        task& operator=(task&& other) noexcept {
+            if (this != &other) {
+                if (handle)
+                    handle.destroy();
+                handle      = stl::exchange(other.handle, {});
+                ready_state = stl::move(other.ready_state);
+            }
+            return *this;
+        }
+
+        task(task const&) = delete;
+        task& operator=(task const&) = delete;
+
+        ~task() noexcept {
+            if (handle)
+                handle.destroy();
+        }
+
+        /**
+         * A task that's already done
+         */
+        template <typename... Args>
+        [[nodiscard]] static task ready(Args&&... args) noexcept {
+            task res;
+            if constexpr (stl::is_void_v<T>) {
+                res.ready_state.value = true;
+            } else {
+                res.ready_state.value.emplace(stl::forward<Args>(args)...);
+            }
+            return res;
+        }
+
+        [[nodiscard]] bool done() const noexcept {
+            return handle ? handle.done() : static_cast<bool>(ready_state.value);
+        }
+
+        bool await_ready() const noexcept {
+            return !handle;
+        }
+
+        stl::coroutine_handle<> await_suspend(stl::coroutine_handle<> awaiter) noexcept {
+            handle.promise().continuation = awaiter;
+            return handle;
+        }
+
+        T await_resume() noexcept {
+            if constexpr (!stl::is_void_v<T>) {
+                if (handle)
+                    return stl::move(*handle.promise().value);
+                return stl::move(*ready_state.value);
+            }
+        }
+
+        /**
+         * Run the task without awaiting it; the callback is called with the
+         * result when it's done, which may be right now, or later on whatever
+         * thread resumes it.
+         */
+        template <typename Callback>
+        void start(Callback&& callback) && noexcept {
+            if (!handle) {
+                if constexpr (stl::is_void_v<T>) {
+                    callback();
+                } else {
+                    callback(stl::move(*ready_state.value));
+                }
+                return;
+            }
+            [](task self, stl::remove_cvref_t<Callback> cb) -> details::detached_task {
+                if constexpr (stl::is_void_v<T>) {
+                    co_await stl::move(self);
+                    cb();
+                } else {
+                    cb(co_await stl::move(self));
+                }
+            }(stl::move(*this), stl::forward<Callback>(callback));
+        }
+    };
+
+    template <typename T>
+    task<T> details::task_promise<T>::get_return_object() noexcept {
+        return task<T>{stl::coroutine_handle<task_promise<T>>::from_promise(*this)};
+    }
+
+    inline task<void> details::task_promise<void>::get_return_object() noexcept {
+        return task<void>{stl::coroutine_handle<task_promise<void>>::from_promise(*this)};
+    }
+
+    template <typename T>
+    struct is_task : stl::false_type {};
+
+    template <typename T>
+    struct is_task<task<T>> : stl::true_type {};
+
+    template <typename T>
+    concept Task = is_task<stl::remove_cvref_t<T>>::value;
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_TASK_H
@@ -3,39 +3,954 @@
 #ifndef WEBPP_THREAD_POOL_H
 #define WEBPP_THREAD_POOL_H
 
+#include "../std/std.hpp"
+#include "./deadline.hpp"
+#include "./embedded_assets.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 namespace webpp {
 
+    namespace details {
+
+        /**
+         * A task that the pool owns; the tasks are allocated once, and the queues only move the pointers
+         * around, so the move-only callables (a packaged_task, ...) can be posted too.
+         */
+        struct pool_task {
+            pool_task()                            = default;
+            pool_task(pool_task const&)            = delete;
+            pool_task& operator=(pool_task const&) = delete;
+            virtual ~pool_task()                   = default;
+            virtual void run()                     = 0;
+
+            // after it's run (or dropped); the registered tasks go back to their slabs
+            virtual void release() noexcept {
+                delete this;
+            }
+        };
+
+        template <typename Func>
+        struct pool_task_of final : pool_task {
+            Func func;
+
+            explicit pool_task_of(Func&& f) : func{stl::move(f)} {}
+
+            void run() override {
+                func();
+            }
+        };
+
+        /**
+         * A Chase-Lev deque of pointers (the C11 version of Lê, Pop, Cohen and Zappa Nardelli): its owner
+         * pushes and pops at the bottom without locks, and the other threads steal from the top with a
+         * CAS. It grows when it's full; the old arrays are kept until it's destroyed, because a thief
+         * could still be reading them.
+         */
+        template <typename T>
+        class work_stealing_deque {
+            static_assert(stl::is_pointer_v<T>, "The items are read and written atomically.");
+
+            struct ring {
+                stl::int64_t                      mask;
+                stl::unique_ptr<stl::atomic<T>[]> slots;
+
+                explicit ring(stl::int64_t capacity)
+                  : mask{capacity - 1},
+                    slots{stl::make_unique<stl::atomic<T>[]>(static_cast<stl::size_t>(capacity))} {}
+
+                [[nodiscard]] stl::int64_t capacity() const noexcept {
+                    return mask + 1;
+                }
+
+                [[nodiscard]] T get(stl::int64_t index) const noexcept {
+                    return slots[static_cast<stl::size_t>(index & mask)].load(stl::memory_order_relaxed);
+                }
+
+                void put(stl::int64_t index, T item) noexcept {
+                    slots[static_cast<stl::size_t>(index & mask)].store(item, stl::memory_order_relaxed);
+                }
+            };
+
+            alignas(64) stl::atomic<stl::int64_t> top{0};
+            alignas(64) stl::atomic<stl::int64_t> bottom{0};
+            stl::atomic<ring*>                    array;
+            stl::vector<stl::unique_ptr<ring>>    rings; // the current one is the last one
+
+            ring* grow(ring* old, stl::int64_t b, stl::int64_t t) {
+                auto bigger = stl::make_unique<ring>(old->capacity() * 2);
+                for (auto i = t; i < b; i++)
+                    bigger->put(i, old->get(i));
+                auto* res = bigger.get();
+                rings.push_back(stl::move(bigger));
+                array.store(res, stl::memory_order_release);
+                return res;
+            }
+
+          public:
+            explicit work_stealing_deque(stl::int64_t capacity = 256) {
+                rings.push_back(stl::make_unique<ring>(capacity));
+                array.store(rings.back().get(), stl::memory_order_relaxed);
+            }
+
+            work_stealing_deque(work_stealing_deque const&)            = delete;
+            work_stealing_deque& operator=(work_stealing_deque const&) = delete;
+
+            /**
+             * Add an item at the bottom; only the owner calls it
+             */
+            void push(T item) {
+                auto const b = bottom.load(stl::memory_order_relaxed);
+                auto const t = top.load(stl::memory_order_acquire);
+                auto*      a = array.load(stl::memory_order_relaxed);
+                if (b - t > a->mask)
+                    a = grow(a, b, t);
+                a->put(b, item);
+                bottom.store(b + 1, stl::memory_order_release);
+            }
+
+            /**
+             * Take the item at the bottom (the last one that was pushed), or null; only the owner calls it
+             */
+            [[nodiscard]] T pop() noexcept {
+                auto const b = bottom.load(stl::memory_order_relaxed) - 1;
+                auto*      a = array.load(stl::memory_order_relaxed);
+                bottom.store(b, stl::memory_order_seq_cst);
+                auto t = top.load(stl::memory_order_seq_cst);
+                if (t > b) {
+                    bottom.store(b + 1, stl::memory_order_relaxed);
+                    return nullptr; // it was empty
+                }
+                T item = a->get(b);
+                if (t == b) {
+                    // the last one; the thieves could be after it too
+                    if (!top.compare_exchange_strong(t, t + 1, stl::memory_order_seq_cst,
+                                                     stl::memory_order_relaxed))
+                        item = nullptr;
+                    bottom.store(b + 1, stl::memory_order_relaxed);
+                }
+                return item;
+            }
+
+            /**
+             * Take the item at the top (the oldest one), or null if it's empty or another thread won it;
+             * any thread can call it
+             */
+            [[nodiscard]] T steal() noexcept {
+                auto       t = top.load(stl::memory_order_seq_cst);
+                auto const b = bottom.load(stl::memory_order_seq_cst);
+                if (t >= b)
+                    return nullptr;
+                T item = array.load(stl::memory_order_acquire)->get(t);
+                if (!top.compare_exchange_strong(t, t + 1, stl::memory_order_seq_cst,
+                                                 stl::memory_order_relaxed))
+                    return nullptr;
+                return item;
+            }
+
+            /**
+             * The number of the items; it's only a hint while the other threads use it
+             */
+            [[nodiscard]] stl::size_t size() const noexcept {
+                auto const b = bottom.load(stl::memory_order_relaxed);
+                auto const t = top.load(stl::memory_order_relaxed);
+                return b > t ? static_cast<stl::size_t>(b - t) : 0;
+            }
+        };
+
+        /**
+         * A bounded queue for many producers and many consumers without locks (Dmitry Vyukov's): each
+         * cell has a sequence number that says whose turn it is to use it, so a push or a pop is one CAS
+         * on its own index, and the two ends don't share a cache line.
+         */
+        template <typename T>
+        class mpmc_ring {
+            struct cell {
+                stl::atomic<stl::size_t> sequence;
+                T                        data;
+            };
+
+            stl::unique_ptr<cell[]>               cells;
+            stl::size_t                           mask;
+            alignas(64) stl::atomic<stl::size_t> tail{0}; // where the next push goes
+            alignas(64) stl::atomic<stl::size_t> head{0}; // where the next pop comes from
+
+          public:
+            explicit mpmc_ring(stl::size_t capacity)
+              : cells{stl::make_unique<cell[]>(stl::bit_ceil(stl::max<stl::size_t>(capacity, 2)))},
+                mask{stl::bit_ceil(stl::max<stl::size_t>(capacity, 2)) - 1} {
+                for (stl::size_t i = 0; i <= mask; i++)
+                    cells[i].sequence.store(i, stl::memory_order_relaxed);
+            }
+
+            /**
+             * False if it's full
+             */
+            [[nodiscard]] bool try_push(T item) noexcept {
+                auto pos = tail.load(stl::memory_order_relaxed);
+                for (;;) {
+                    auto&      c    = cells[pos & mask];
+                    auto const seq  = c.sequence.load(stl::memory_order_acquire);
+                    auto const diff = static_cast<stl::ptrdiff_t>(seq) - static_cast<stl::ptrdiff_t>(pos);
+                    if (diff == 0) {
+                        if (tail.compare_exchange_weak(pos, pos + 1, stl::memory_order_relaxed)) {
+                            c.data = item;
+                            c.sequence.store(pos + 1, stl::memory_order_release);
+                            return true;
+                        }
+                    } else if (diff < 0) {
+                        return false;
+                    } else {
+                        pos = tail.load(stl::memory_order_relaxed);
+                    }
+                }
+            }
+
+            /**
+             * False if it's empty
+             */
+            [[nodiscard]] bool try_pop(T& item) noexcept {
+                auto pos = head.load(stl::memory_order_relaxed);
+                for (;;) {
+                    auto&      c    = cells[pos & mask];
+                    auto const seq  = c.sequence.load(stl::memory_order_acquire);
+                    auto const diff = static_cast<stl::ptrdiff_t>(seq) - static_cast<stl::ptrdiff_t>(pos + 1);
+                    if (diff == 0) {
+                        if (head.compare_exchange_weak(pos, pos + 1, stl::memory_order_relaxed)) {
+                            item = c.data;
+                            c.sequence.store(pos + mask + 1, stl::memory_order_release);
+                            return true;
+                        }
+                    } else if (diff < 0) {
+                        return false;
+                    } else {
+                        pos = head.load(stl::memory_order_relaxed);
+                    }
+                }
+            }
+        };
+
+        /**
+         * A queue with a lock; the count lets the readers skip the lock when it's empty
+         */
+        class locked_task_queue {
+            stl::mutex               lock;
+            stl::deque<pool_task*>   tasks;
+            stl::atomic<stl::size_t> count{0};
+
+          public:
+            void push(pool_task* task) {
+                stl::scoped_lock const guard{lock};
+                tasks.push_back(task);
+                count.fetch_add(1, stl::memory_order_release);
+            }
+
+            [[nodiscard]] pool_task* pop() {
+                if (count.load(stl::memory_order_acquire) == 0)
+                    return nullptr;
+                stl::scoped_lock const guard{lock};
+                if (tasks.empty())
+                    return nullptr;
+                auto* task = tasks.front();
+                tasks.pop_front();
+                count.fetch_sub(1, stl::memory_order_relaxed);
+                return task;
+            }
+
+            [[nodiscard]] bool empty() const noexcept {
+                return count.load(stl::memory_order_acquire) == 0;
+            }
+        };
+
+        /**
+         * A queue that any thread pushes to and pops from: a lock-free ring, and a locked queue for when
+         * it's full
+         */
+        class shared_task_queue {
+            static constexpr stl::size_t ring_capacity = 4096;
+
+            mpmc_ring<pool_task*> ring{ring_capacity};
+            locked_task_queue     overflow{};
+
+          public:
+            void push(pool_task* task) {
+                if (!ring.try_push(task))
+                    overflow.push(task);
+            }
+
+            [[nodiscard]] pool_task* pop() noexcept {
+                pool_task* task = nullptr;
+                if (ring.try_pop(task))
+                    return task;
+                return overflow.pop();
+            }
+        };
+
+        /**
+         * The tasks of a registered callable: a fixed number of them, with the arguments in them, made
+         * once and used again and again. The free ones are in a lock-free stack of their indices; the
+         * head has a tag that changes on every push, so a pop that was interrupted can't be fooled by a
+         * slot that was popped and pushed back in the meantime (ABA).
+         */
+        struct task_slab_base {
+            virtual ~task_slab_base() = default;
+        };
+
+        template <typename Func, typename... Args>
+        class task_slab final : public task_slab_base {
+            static constexpr stl::uint64_t index_mask = 0xFFFF'FFFFULL;
+
+          public:
+            struct node final : pool_task {
+                task_slab*                         slab = nullptr;
+                stl::optional<stl::tuple<Args...>> args{};
+
+                void run() override {
+                    stl::apply(slab->func, stl::move(*args));
+                }
+
+                void release() noexcept override {
+                    args.reset();
+                    slab->free(this);
+                }
+            };
+
+          private:
+            Func                                          func;
+            stl::unique_ptr<node[]>                       nodes;
+            stl::unique_ptr<stl::atomic<stl::uint32_t>[]> next;    // the one below each free one, plus one
+            stl::atomic<stl::uint64_t>                    head{0}; // the tag, and the top one plus one
+            stl::size_t                                   capacity;
+
+            void free(node* n) noexcept {
+                auto const index = static_cast<stl::uint64_t>(n - nodes.get());
+                auto       top   = head.load(stl::memory_order_relaxed);
+                for (;;) {
+                    next[index].store(static_cast<stl::uint32_t>(top & index_mask),
+                                      stl::memory_order_relaxed);
+                    auto const tagged = (((top >> 32U) + 1) << 32U) | (index + 1);
+                    if (head.compare_exchange_weak(top, tagged, stl::memory_order_release,
+                                                   stl::memory_order_relaxed))
+                        return;
+                }
+            }
+
+          public:
+            task_slab(Func&& f, stl::size_t count)
+              : func{stl::move(f)},
+                nodes{stl::make_unique<node[]>(count)},
+                next{stl::make_unique<stl::atomic<stl::uint32_t>[]>(count)},
+                capacity{count} {
+                for (stl::size_t i = count; i > 0; i--) {
+                    nodes[i - 1].slab = this;
+                    free(&nodes[i - 1]);
+                }
+            }
+
+            /**
+             * A free task with the arguments in it, or null if all of them are in use
+             */
+            template <typename... Values>
+            [[nodiscard]] node* make(Values&&... values) {
+                auto top = head.load(stl::memory_order_acquire);
+                for (;;) {
+                    auto const index = top & index_mask;
+                    if (index == 0)
+                        return nullptr;
+                    auto const below  = next[index - 1].load(stl::memory_order_relaxed);
+                    auto const tagged = (((top >> 32U) + 1) << 32U) | below;
+                    if (head.compare_exchange_weak(top, tagged, stl::memory_order_acquire,
+                                                   stl::memory_order_acquire)) {
+                        auto* n = &nodes[index - 1];
+                        n->args.emplace(stl::forward<Values>(values)...);
+                        return n;
+                    }
+                }
+            }
+
+            [[nodiscard]] Func& function() noexcept {
+                return func;
+            }
+
+            /**
+             * The number of the free tasks; it's only a hint while the other threads use it
+             */
+            [[nodiscard]] stl::size_t available() const noexcept {
+                stl::size_t res   = 0;
+                auto        index = head.load(stl::memory_order_acquire) & index_mask;
+                while (index != 0 && res < capacity) {
+                    res++;
+                    index = next[index - 1].load(stl::memory_order_relaxed);
+                }
+                return res;
+            }
+        };
+
+        template <typename T>
+        struct is_task_handle : stl::false_type {};
+
+        // the name of the type is in the signature of the function
+        template <typename T>
+        [[nodiscard]] consteval stl::string_view type_signature() noexcept {
+#ifdef _MSC_VER
+            return __FUNCSIG__;
+#else
+            return __PRETTY_FUNCTION__;
+#endif
+        }
+
+        /**
+         * A hash of the type that's known at compile time; GCC names all the lambdas of a function with
+         * the same parameters alike, so they have the same hash there
+         */
+        template <typename T>
+        inline constexpr stl::uint64_t type_hash = asset_hash(type_signature<T>(), 0);
+
+        // the pool and the index of the worker of the current thread
+        struct current_pool_worker {
+            void const* pool  = nullptr;
+            stl::size_t index = 0;
+        };
+
+        inline thread_local current_pool_worker current_worker{};
+
+    } // namespace details
+
+    /**
+     * The lanes of the tasks of a thread_pool
+     */
+    enum struct task_priority : stl::uint8_t {
+        interactive, // the ones that a response waits for
+        normal,
+        background // cache refreshes, write-backs, cleanups, ...
+    };
+
     /**
-     * Thread pool class helps to implement a vector/list of threads and push
-     * tasks into this thread pool.
+     * A callable that's registered in a thread_pool (see thread_pool::register_task); it's only a
+     * pointer, and it's valid as long as the pool is.
+     */
+    template <typename Func, typename... Args>
+    class task_handle {
+        using slab_type = details::task_slab<Func, Args...>;
+
+        slab_type* slab = nullptr;
+
+        friend class thread_pool;
+
+        explicit task_handle(slab_type* ptr) noexcept : slab{ptr} {}
+
+      public:
+        task_handle() noexcept = default;
+
+        [[nodiscard]] explicit operator bool() const noexcept {
+            return slab != nullptr;
+        }
+
+        /**
+         * The number of the tasks of it that can be posted without an allocation, right now
+         */
+        [[nodiscard]] stl::size_t available() const noexcept {
+            return slab->available();
+        }
+    };
+
+    namespace details {
+        template <typename Func, typename... Args>
+        struct is_task_handle<task_handle<Func, Args...>> : stl::true_type {};
+    } // namespace details
+
+    /**
+     * A work-stealing pool of threads, for the CPU-heavy work of the handlers (hashing the passwords,
+     * rendering, compressing, ...) that shouldn't hold the io threads.
+     *
+     * Each worker has a deque of its own: the tasks that a worker posts go to the bottom of its deque,
+     * and it runs them last-in first-out (they're hot in its cache), while the idle workers steal the
+     * oldest ones from the top. The tasks that are posted from the other threads go into a shared
+     * injection queue, and the ones that are posted to a specific worker (post_to) go into its inbox,
+     * and nobody steals them; post_keyed and post_affine pick that worker by a key, or by the type of
+     * the function, so the tasks of a key run in order on one thread.
+     *
+     * The tasks have a priority too (task_priority): the interactive ones are taken before the normal
+     * ones, and the background ones last, and they don't run on all of the workers at a time, so there's
+     * always a worker for a request that comes in while the caches are being refreshed. One in a few of
+     * the tasks that a worker takes is looked for in the lower lanes first, so they don't starve.
      *
-     * Features of this thread pool:
-     * - [ ] Fewer run-time overhead features:
-     *   - [ ] Register methods before using theme multiple times.
-     *     Use cases:
-     *     - [ ] Buffering the requests
-     *     - [ ] Processing user requests (even parsing the request)
-     * - [ ] Priority scheduling:
-     *   - [ ] defer
-     *   - [ ] dispatch
-     *   - [ ] post
-     * - [ ] Run in a specific thread
-     *   - [ ] By thread id
-     *   - [ ] By thread index
-     *   - [ ] In the last thread which that function was processed on
-     * - [ ] Stop, Pause, Continue, Start methods
-     * - [ ] Join threads
-     * - [ ] Underlying thread class:
-     *   - [ ] std::thread
-     *   - [ ] std::jthread
-     *   - [ ] boost::thread
-     *   - [ ] POSIX
-     * - [ ] Constexpr way to hash a function object into a known number in the
-     * thread pool
+     * The idle workers look for the tasks a few more times before they sleep, and each one sleeps on
+     * its own eventcount: a post wakes one sleeping worker up, if there's one, so a busy pool doesn't
+     * make system calls, and a post_to only wakes up the worker that it's for.
+     *
+     * The functions that are posted often can be registered once; their tasks, with their arguments in
+     * them, are made ahead of time and used again, so posting one of them doesn't allocate anything or
+     * take any locks (the injection queue is a lock-free ring too, unless it's full):
+     *   auto hash = pool.register_task<user_id, std::string>([](user_id id, std::string pw) { ... });
+     *   pool.post(hash, id, std::move(password));
+     *
+     * The exceptions of the tasks are dropped; submit the tasks to get them through their futures. The
+     * tasks that are still queued when the pool is stopped are run first.
+     *
+     *   thread_pool pool{4};
+     *   pool.post([] { ... });
+     *   pool.post(task_priority::background, [] { ... });
+     *   auto hash = pool.submit([&] { return hash_password(password); });
      */
     class thread_pool {
-      private:
+        using task_ptr = details::pool_task*;
+
+        struct alignas(64) worker {
+            details::work_stealing_deque<task_ptr> local{};
+            details::locked_task_queue             inbox{}; // the tasks that only this worker runs
+            stl::thread                            thread{};
+            stl::uint32_t                          turn = 0; // the number of the tasks that it looked for
+
+            // its eventcount: it changes when the worker is woken up, and the worker sleeps on it
+            alignas(64) stl::atomic<stl::uint32_t> signal{0};
+            stl::atomic<bool>                      asleep{false};
+
+            void wake() noexcept {
+                signal.fetch_add(1, stl::memory_order_seq_cst);
+                signal.notify_one();
+            }
+        };
+
+        static constexpr int spin_count = 64;
+
+        // one in this many of the tasks that a worker takes is looked for in the lower lanes first
+        static constexpr stl::uint32_t fairness_interval = 8;
+
+        stl::vector<stl::unique_ptr<worker>>                  workers;
+        details::shared_task_queue                            interactive{};
+        details::shared_task_queue                            injection{}; // the normal ones from outside
+        details::shared_task_queue                            background{};
+        stl::size_t                                           background_limit = 1; // the workers they get
+        stl::mutex                                            slabs_lock{};
+        stl::vector<stl::unique_ptr<details::task_slab_base>> slabs{};
+        alignas(64) stl::atomic<stl::uint32_t> sleeping{0}; // the workers that are asleep, or about to be
+        stl::atomic<stl::size_t>               running_background{0};
+        stl::atomic<bool>                      paused{false};
+        stl::atomic<bool>                      stopping{false};
+
+        template <typename Func>
+            requires(!details::is_task_handle<stl::remove_cvref_t<Func>>::value)
+        [[nodiscard]] static task_ptr make_task(Func&& func) {
+            using func_type = stl::decay_t<Func>;
+            return new details::pool_task_of<func_type>{func_type(stl::forward<Func>(func))};
+        }
+
+        static void run(task_ptr task) noexcept {
+            try {
+                task->run();
+            } catch (...) {
+                // dropped; see submit
+            }
+            task->release();
+        }
+
+        /**
+         * Wake one of the sleeping workers up, for a task that anyone can run; the worker that is
+         * taken can't be taken by the other posts until it looks for the tasks again. A worker that
+         * is about to sleep either is seen here, or finds the task in its last look.
+         */
+        void wake_one() noexcept {
+            stl::atomic_thread_fence(stl::memory_order_seq_cst);
+            if (sleeping.load(stl::memory_order_seq_cst) == 0)
+                return;
+            for (auto& w : workers) {
+                if (w->asleep.exchange(false, stl::memory_order_seq_cst)) {
+                    w->wake();
+                    return;
+                }
+            }
+        }
+
+        /**
+         * Wake up the worker of the index, for a task of its inbox; it either is awake and sees the
+         * task, or its sleep is cut short by the change of its eventcount.
+         */
+        void wake_worker(stl::size_t index) noexcept {
+            auto& w = *workers[index];
+            w.signal.fetch_add(1, stl::memory_order_seq_cst);
+            if (w.asleep.load(stl::memory_order_seq_cst))
+                w.signal.notify_one();
+        }
+
+        void wake_all() noexcept {
+            for (auto& w : workers)
+                w->wake();
+        }
+
+        [[nodiscard]] task_ptr take_background() noexcept {
+            if (running_background.load(stl::memory_order_relaxed) >= background_limit)
+                return nullptr;
+            if (running_background.fetch_add(1, stl::memory_order_acq_rel) < background_limit) {
+                if (auto* task = background.pop())
+                    return task; // the worker gives its place back after it runs it
+            }
+            running_background.fetch_sub(1, stl::memory_order_release);
+            return nullptr;
+        }
+
+        [[nodiscard]] task_ptr find_task(stl::size_t    index,
+                                         stl::uint64_t& random,
+                                         bool&          is_background) noexcept {
+            auto& self = *workers[index];
+            if (auto* task = self.inbox.pop())
+                return task;
+            if (++self.turn % fairness_interval == 0) {
+                // the lower lanes take turns to go first
+                bool const normal_first = self.turn / fairness_interval % 2 == 1;
+                if (normal_first)
+                    if (auto* task = take_normal(index, random))
+                        return task;
+                if (auto* task = take_background()) {
+                    is_background = true;
+                    return task;
+                }
+                if (!normal_first)
+                    if (auto* task = take_normal(index, random))
+                        return task;
+                return interactive.pop();
+            }
+            if (auto* task = interactive.pop())
+                return task;
+            if (auto* task = take_normal(index, random))
+                return task;
+            auto* task    = take_background();
+            is_background = task != nullptr;
+            return task;
+        }
+
+        [[nodiscard]] task_ptr take_normal(stl::size_t index, stl::uint64_t& random) noexcept {
+            if (auto* task = workers[index]->local.pop())
+                return task;
+            if (auto* task = injection.pop())
+                return task;
+
+            // steal from the others, starting at a random one
+            random ^= random << 13U;
+            random ^= random >> 7U;
+            random ^= random << 17U;
+            auto const count = workers.size();
+            auto const start = static_cast<stl::size_t>(random % count);
+            for (stl::size_t i = 0; i < count; i++) {
+                auto const victim = (start + i) % count;
+                if (victim == index)
+                    continue;
+                if (auto* task = workers[victim]->local.steal())
+                    return task;
+            }
+            return nullptr;
+        }
+
+        void work(stl::size_t index) noexcept {
+            details::current_worker = {this, index};
+            stl::uint64_t random    = 0x9E37'79B9'7F4A'7C15ULL * (index + 1);
+            int           idle      = 0;
+            auto&         self      = *workers[index];
+            stl::uint32_t seen      = 0;
+            bool          armed     = false; // it's going to sleep after one more look
+            auto const    disarm    = [&]() noexcept {
+                if (stl::exchange(armed, false)) {
+                    self.asleep.store(false, stl::memory_order_relaxed);
+                    sleeping.fetch_sub(1, stl::memory_order_relaxed);
+                }
+            };
+            for (;;) {
+                if (!paused.load(stl::memory_order_acquire)) {
+                    bool is_background = false;
+                    if (auto* task = find_task(index, random, is_background)) {
+                        disarm();
+                        run(task);
+                        if (is_background)
+                            running_background.fetch_sub(1, stl::memory_order_release);
+                        idle = 0;
+                        continue;
+                    }
+                    if (stopping.load(stl::memory_order_acquire))
+                        break;
+                }
+                if (idle++ < spin_count) {
+                    stl::this_thread::yield();
+                    continue;
+                }
+                if (!armed) {
+                    // the posts from now on either see it asleep, or are found in the last look
+                    seen = self.signal.load(stl::memory_order_seq_cst);
+                    self.asleep.store(true, stl::memory_order_seq_cst);
+                    sleeping.fetch_add(1, stl::memory_order_seq_cst);
+                    stl::atomic_thread_fence(stl::memory_order_seq_cst);
+                    armed = true;
+                    continue;
+                }
+                // it has been woken up since "seen" was read, or the wait returns right away
+                self.signal.wait(seen, stl::memory_order_seq_cst);
+                disarm();
+                idle = 0;
+            }
+            disarm();
+            details::current_worker = {};
+        }
+
+        void push(task_ptr task, task_priority priority) {
+            switch (priority) {
+                case task_priority::interactive: interactive.push(task); break;
+                case task_priority::background: background.push(task); break;
+                default:
+                    if (details::current_worker.pool == this) {
+                        workers[details::current_worker.index]->local.push(task);
+                    } else {
+                        injection.push(task);
+                    }
+            }
+            wake_one();
+        }
+
+        template <typename Func, typename... Args, typename... Values>
+        [[nodiscard]] static task_ptr make_task(task_handle<Func, Args...> const& handle,
+                                                Values&&... values) {
+            if (auto* task = handle.slab->make(stl::forward<Values>(values)...))
+                return task;
+            // all of its tasks are in the queues; this one is allocated
+            return make_task([func = &handle.slab->function(),
+                              args = stl::tuple<Args...>(stl::forward<Values>(values)...)]() mutable {
+                stl::apply(*func, stl::move(args));
+            });
+        }
+
       public:
+        explicit thread_pool(stl::size_t thread_count = stl::max(stl::thread::hardware_concurrency(), 1U)) {
+            thread_count = stl::max<stl::size_t>(thread_count, 1);
+            // one of the workers is left for the other lanes
+            background_limit = stl::max<stl::size_t>(thread_count - 1, 1);
+            workers.reserve(thread_count);
+            for (stl::size_t i = 0; i < thread_count; i++)
+                workers.push_back(stl::make_unique<worker>());
+            // the workers look at each other's deques, so they're all made before any of them starts
+            for (stl::size_t i = 0; i < thread_count; i++) {
+                workers[i]->thread = stl::thread{[this, i] {
+                    work(i);
+                }};
+            }
+        }
+
+        thread_pool(thread_pool const&)            = delete;
+        thread_pool& operator=(thread_pool const&) = delete;
+
+        ~thread_pool() {
+            stop();
+            // the ones that were posted after it was stopped
+            auto const drop = [](task_ptr task) noexcept {
+                task->release();
+            };
+            for (auto* queue : {&interactive, &injection, &background})
+                while (auto* task = queue->pop())
+                    drop(task);
+            for (auto& w : workers) {
+                while (auto* task = w->inbox.pop())
+                    drop(task);
+                while (auto* task = w->local.pop())
+                    drop(task);
+            }
+        }
+
+        /**
+         * Run the function on one of the workers, later. The ones that are posted from a worker are
+         * more likely to run on that same worker.
+         */
+        template <typename Func>
+            requires(!details::is_task_handle<stl::remove_cvref_t<Func>>::value)
+        void post(Func&& func) {
+            push(make_task(stl::forward<Func>(func)), task_priority::normal);
+        }
+
+        /**
+         * Post the function (or the registered one with the values) in the lane of the priority
+         */
+        template <typename Func, typename... Values>
+        void post(task_priority priority, Func&& func, Values&&... values) {
+            push(make_task(stl::forward<Func>(func), stl::forward<Values>(values)...), priority);
+        }
+
+        /**
+         * Post the function for a request; it's dropped if the request is cancelled, or its deadline
+         * has passed, by the time a worker gets to it (see cancellation_token).
+         */
+        template <typename Func>
+        void post(cancellation_token token, Func&& func) {
+            post([token = stl::move(token), func = stl::forward<Func>(func)]() mutable {
+                if (!token.is_cancelled())
+                    stl::invoke(func);
+            });
+        }
+
+        /**
+         * Register the function once, and post it with the arguments later by its handle (see post); the
+         * arguments are stored in one of "capacity" tasks that are made here, and when all of them are
+         * queued, the next posts allocate. The function is called concurrently; it lives as long as the
+         * pool does.
+         */
+        template <typename... Args, typename Func>
+        [[nodiscard]] task_handle<stl::decay_t<Func>, Args...> register_task(Func&& func,
+                                                                              stl::size_t capacity = 1024) {
+            using func_type = stl::decay_t<Func>;
+            static_assert(stl::is_invocable_v<func_type&, Args...>,
+                          "The function can't be called with the arguments of the tasks.");
+            auto slab = stl::make_unique<details::task_slab<func_type, Args...>>(
+              func_type(stl::forward<Func>(func)), stl::max<stl::size_t>(capacity, 1));
+            task_handle<func_type, Args...> handle{slab.get()};
+            stl::scoped_lock const          guard{slabs_lock};
+            slabs.push_back(stl::move(slab));
+            return handle;
+        }
+
+        /**
+         * Run the registered function with the values (as its arguments) on one of the workers, later
+         */
+        template <typename Func, typename... Args, typename... Values>
+        void post(task_handle<Func, Args...> const& handle, Values&&... values) {
+            push(make_task(handle, stl::forward<Values>(values)...), task_priority::normal);
+        }
+
+        /**
+         * Run the function right away if it's called from a worker of this pool, otherwise post it
+         */
+        template <typename Func>
+        void dispatch(Func&& func) {
+            if (details::current_worker.pool == this) {
+                try {
+                    stl::invoke(stl::forward<Func>(func));
+                } catch (...) {
+                    // dropped, like the ones that are posted
+                }
+                return;
+            }
+            post(stl::forward<Func>(func));
+        }
+
+        /**
+         * Run the function on the worker with the index (modulo the number of the workers); the tasks
+         * that keep a worker's thread-local state warm, or that shouldn't run at the same time, can be
+         * sent to the same worker. The registered functions are posted with their values here too.
+         */
+        template <typename Func, typename... Values>
+        void post_to(stl::size_t index, Func&& func, Values&&... values) {
+            index %= workers.size();
+            workers[index]->inbox.push(make_task(stl::forward<Func>(func), stl::forward<Values>(values)...));
+            // the worker has to be the one that wakes up, and the others can keep sleeping
+            wake_worker(index);
+        }
+
+        /**
+         * The index of the worker that the tasks of the key run on; the strings are hashed by their
+         * characters, and the rest of the keys by std::hash.
+         */
+        template <typename Key>
+        [[nodiscard]] stl::size_t worker_of(Key const& key) const noexcept {
+            stl::uint64_t hash = 0;
+            if constexpr (stl::is_convertible_v<Key const&, stl::string_view>) {
+                hash = details::asset_hash(stl::string_view{key}, 0);
+            } else {
+                // std::hash of the integers is the integer itself
+                hash = static_cast<stl::uint64_t>(stl::hash<Key>{}(key)) * 0x9E37'79B9'7F4A'7C15ULL;
+                hash ^= hash >> 32U;
+            }
+            return static_cast<stl::size_t>(hash % workers.size());
+        }
+
+        /**
+         * Run the function on the worker of the key (a session id, a user, a connection, ...): the tasks
+         * of a key run one at a time, in the order that they were posted, and on the same thread, so
+         * the state of the key needs no locks and stays in that thread's cache.
+         */
+        template <typename Key, typename Func, typename... Values>
+        void post_keyed(Key const& key, Func&& func, Values&&... values) {
+            post_to(worker_of(key), stl::forward<Func>(func), stl::forward<Values>(values)...);
+        }
+
+        /**
+         * Run the function on the worker that it ran on the last time: the worker of the hash of the type
+         * of the function (or of the registered function of the handle), which is known at compile time.
+         */
+        template <typename Func, typename... Values>
+        void post_affine(Func&& func, Values&&... values) {
+            constexpr auto hash = details::type_hash<stl::remove_cvref_t<Func>>;
+            post_to(static_cast<stl::size_t>(hash),
+                    stl::forward<Func>(func),
+                    stl::forward<Values>(values)...);
+        }
+
+        /**
+         * Post the function, and get its result (or its exception) through the future
+         */
+        template <typename Func>
+        [[nodiscard]] auto submit(task_priority priority, Func&& func) {
+            using result_type = stl::invoke_result_t<stl::decay_t<Func>&>;
+            stl::packaged_task<result_type()> task{stl::forward<Func>(func)};
+            auto                              res = task.get_future();
+            post(priority, stl::move(task));
+            return res;
+        }
+
+        template <typename Func>
+        [[nodiscard]] auto submit(Func&& func) {
+            return submit(task_priority::normal, stl::forward<Func>(func));
+        }
+
+        /**
+         * The workers don't start any new tasks until it's resumed; the ones that are running finish.
+         */
+        void pause() noexcept {
+            paused.store(true, stl::memory_order_release);
+        }
+
+        void resume() noexcept {
+            paused.store(false, stl::memory_order_release);
+            wake_all();
+        }
+
+        [[nodiscard]] bool is_paused() const noexcept {
+            return paused.load(stl::memory_order_acquire);
+        }
+
+        /**
+         * Run the tasks that are queued, and join the workers; nothing should be posted after it.
+         */
+        void stop() noexcept {
+            if (stopping.exchange(true, stl::memory_order_acq_rel))
+                return;
+            paused.store(false, stl::memory_order_release);
+            wake_all();
+            for (auto& w : workers)
+                if (w->thread.joinable())
+                    w->thread.join();
+        }
+
+        [[nodiscard]] stl::size_t size() const noexcept {
+            return workers.size();
+        }
+
+        /**
+         * The index of the worker of the current thread in this pool, or -1 if it's not one of them
+         */
+        [[nodiscard]] stl::size_t current_index() const noexcept {
+            auto const& worker = details::current_worker;
+            return worker.pool == this ? worker.index : static_cast<stl::size_t>(-1);
+        }
     };
 } // namespace webpp
 
@@ -0,0 +1,224 @@
+#ifndef WEBPP_UTILS_TIMING_WHEEL_H
+#define WEBPP_UTILS_TIMING_WHEEL_H
+
+#include "../std/std.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+
+namespace webpp {
+
+    /**
+     * The hook that puts an object into a timing wheel; it's intrusive so
+     * scheduling and cancelling never allocate. The owner of the hook should
+     * not move while it's scheduled; a moved hook is not scheduled.
+     */
+    struct timer_node {
+        stl::function<void()> on_expire;
+
+      private:
+        friend class timing_wheel;
+
+        timer_node* prev     = nullptr;
+        timer_node* next     = nullptr;
+        uint64_t    deadline = 0; // in ticks
+
+      public:
+        timer_node() noexcept = default;
+        timer_node(timer_node const&) = delete;
+        timer_node(timer_node&& other) noexcept : on_expire{stl::move(other.on_expire)} {
+        }
+        timer_node& operator=(timer_node const&) = delete;
+        timer_node& operator=(timer_node&&) = delete;
+
+        [[nodiscard]] bool is_scheduled() const noexcept {
+            return prev != nullptr;
+        }
+    };
+
+    /**
+     * A hierarchical timing wheel: 4 levels of 64 slots, so a timer can be up
+     * to 2^24 ticks away. Scheduling and cancelling are O(1), and a tick only
+     * touches the timers that expire in it (plus moving the timers of one
+     * upper slot down, once every 64 ticks); unlike a heap of timers, the
+     * number of the timers that are waiting doesn't matter.
+     *
+     * It's not thread-safe; each worker has its own.
+     */
+    class timing_wheel {
+      public:
+        static constexpr unsigned    slot_bits  = 6;
+        static constexpr stl::size_t slot_count = 1u << slot_bits;
+        static constexpr stl::size_t levels     = 4;
+        static constexpr uint64_t    max_ticks  = (uint64_t{1} << (slot_bits * levels)) - 1;
+
+      private:
+        // each slot is a circular list with a sentinel node
+        struct slot {
+            timer_node head;
+
+            slot() noexcept {
+                head.prev = head.next = &head;
+            }
+            slot(slot const&) = delete;
+        };
+
+        stl::array<stl::array<slot, slot_count>, levels> wheel;
+
+        uint64_t    current = 0; // the current tick
+        stl::size_t count   = 0;
+
+        static void link(slot& s, timer_node& node) noexcept {
+            node.prev         = s.head.prev;
+            node.next         = &s.head;
+            s.head.prev->next = &node;
+            s.head.prev       = &node;
+        }
+
+        static void unlink(timer_node& node) noexcept {
+            node.prev->next = node.next;
+            node.next->prev = node.prev;
+            node.prev = node.next = nullptr;
+        }
+
+        void insert(timer_node& node) noexcept {
+            auto const  diff  = node.deadline - current;
+            stl::size_t level = 0;
+            while (level + 1 < levels && diff >= (uint64_t{1} << (slot_bits * (level + 1))))
+                level++;
+            auto const index = (node.deadline >> (slot_bits * level)) & (slot_count - 1);
+            link(wheel[level][index], node);
+        }
+
+        /**
+         * Move the timers of a slot of an upper level to the lower ones
+         */
+        void cascade(stl::size_t level) noexcept {
+            auto& s = wheel[level][(current >> (slot_bits * level)) & (slot_count - 1)];
+            while (s.head.next != &s.head) {
+                auto& node = *s.head.next;
+                unlink(node);
+                insert(node);
+            }
+        }
+
+      public:
+        timing_wheel() noexcept = default;
+        timing_wheel(timing_wheel const&) = delete;
+
+        /**
+         * (Re)schedule the timer to expire after the specified number of ticks
+         * (at least one; at most max_ticks)
+         */
+        void schedule(timer_node& node, uint64_t ticks) noexcept {
+            if (node.is_scheduled())
+                unlink(node);
+            else
+                count++;
+            node.deadline = current + stl::clamp<uint64_t>(ticks, 1, max_ticks);
+            insert(node);
+        }
+
+        void cancel(timer_node& node) noexcept {
+            if (!node.is_scheduled())
+                return;
+            unlink(node);
+            count--;
+        }
+
+        /**
+         * Move one tick forward and call the timers that expire now; the
+         * callbacks can schedule and cancel timers.
+         */
+        void tick() noexcept {
+            current++;
+            // when a level wraps around, the next slot of the level above it
+            // is due; its timers are closer than a full round of this level now
+            for (stl::size_t level = 1; level < levels; level++) {
+                if (((current >> (slot_bits * (level - 1))) & (slot_count - 1)) != 0)
+                    break;
+                cascade(level);
+            }
+            auto& s = wheel[0][current & (slot_count - 1)];
+            while (s.head.next != &s.head) {
+                auto& node = *s.head.next;
+                unlink(node);
+                count--;
+                if (node.on_expire)
+                    node.on_expire();
+            }
+        }
+
+        /**
+         * Move the time forward without any timer to expire; only works when
+         * it's empty.
+         */
+        void skip(uint64_t ticks) noexcept {
+            if (count == 0)
+                current += ticks;
+        }
+
+        [[nodiscard]] uint64_t now() const noexcept {
+            return current;
+        }
+
+        [[nodiscard]] stl::size_t size() const noexcept {
+            return count;
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return count == 0;
+        }
+    };
+
+    /**
+     * Something that calls the timers after a timeout, like the timer service of the io_contexts of
+     * the servers (see common::timer_service)
+     */
+    template <typename T>
+    concept TimerService = requires(T service, timer_node& node, stl::chrono::nanoseconds timeout) {
+        service.schedule(node, timeout);
+        service.cancel(node);
+    };
+
+    /**
+     * A timer service without its type, for the utilities that don't care where it comes from
+     */
+    class timer_service_ref {
+        void* service = nullptr;
+        void (*schedule_timer)(void*, timer_node&, stl::chrono::nanoseconds) = nullptr;
+        void (*cancel_timer)(void*, timer_node&)                             = nullptr;
+
+      public:
+        timer_service_ref() noexcept = default;
+
+        template <TimerService Service>
+        timer_service_ref(Service& _service) noexcept
+          : service{&_service},
+            schedule_timer{[](void* ptr, timer_node& node, stl::chrono::nanoseconds timeout) {
+                static_cast<Service*>(ptr)->schedule(node, timeout);
+            }},
+            cancel_timer{[](void* ptr, timer_node& node) {
+                static_cast<Service*>(ptr)->cancel(node);
+            }} {}
+
+        [[nodiscard]] explicit operator bool() const noexcept {
+            return service != nullptr;
+        }
+
+        void schedule(timer_node& node, stl::chrono::nanoseconds timeout) const {
+            schedule_timer(service, node, timeout);
+        }
+
+        void cancel(timer_node& node) const {
+            cancel_timer(service, node);
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_TIMING_WHEEL_H
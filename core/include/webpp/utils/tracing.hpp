@@ -0,0 +1,243 @@
+#ifndef WEBPP_UTILS_TRACING_H
+#define WEBPP_UTILS_TRACING_H
+
+#include "../std/std.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#    include <x86intrin.h>
+#    define WEBPP_TRACE_TSC
+#elif defined(_M_X64) || defined(_M_IX86)
+#    include <intrin.h>
+#    define WEBPP_TRACE_TSC
+#endif
+
+/**
+ * The trace points of the request path (accept, parse, route, handler, serialize, and write) are only
+ * compiled in with the WEBPP_TRACING option of cmake; the spans are recorded into a ring of events for
+ * each thread, with the timestamps of the TSC where there is one, and they're exported in the format of
+ * the Chrome trace viewer (chrome://tracing, or ui.perfetto.dev):
+ *   std::ofstream file{"trace.json"};
+ *   webpp::tracer::global().write_chrome_trace(file);
+ */
+#ifdef WEBPP_TRACING
+#    define WEBPP_TRACE_CONCAT_IMPL(a, b) a##b
+#    define WEBPP_TRACE_CONCAT(a, b)      WEBPP_TRACE_CONCAT_IMPL(a, b)
+#    define WEBPP_TRACE_SPAN(point, id)                                       \
+        ::webpp::trace_span const WEBPP_TRACE_CONCAT(_trace_span_, __LINE__) { \
+            ::webpp::trace_point::point, static_cast<::std::uint64_t>(id)      \
+        }
+#else
+#    define WEBPP_TRACE_SPAN(point, id) static_cast<void>(0)
+#endif
+
+namespace webpp {
+
+    enum struct trace_point : stl::uint8_t { accept, parse, route, handler, serialize, write };
+
+    [[nodiscard]] constexpr stl::string_view trace_point_name(trace_point point) noexcept {
+        switch (point) {
+            case trace_point::accept: return "accept";
+            case trace_point::parse: return "parse";
+            case trace_point::route: return "route";
+            case trace_point::handler: return "handler";
+            case trace_point::serialize: return "serialize";
+            case trace_point::write: return "write";
+        }
+        return "unknown";
+    }
+
+    /**
+     * The ticks of the TSC, or the nanoseconds of the steady clock where there's no TSC
+     */
+    [[nodiscard]] inline stl::uint64_t trace_ticks() noexcept {
+#ifdef WEBPP_TRACE_TSC
+        return __rdtsc();
+#else
+        return static_cast<stl::uint64_t>(
+          stl::chrono::duration_cast<stl::chrono::nanoseconds>(
+            stl::chrono::steady_clock::now().time_since_epoch())
+            .count());
+#endif
+    }
+
+    struct trace_event {
+        stl::uint64_t begin = 0; // in trace_ticks
+        stl::uint64_t end   = 0;
+        stl::uint64_t id    = 0; // of the connection (or of whatever the span is about)
+        trace_point   point = trace_point::accept;
+    };
+
+    /**
+     * The events of one thread; only that thread records into it, and the last "capacity" of them are
+     * kept. The events are read while they may be written, so a few of the newest ones may be torn if
+     * it's exported while the server is busy.
+     */
+    class trace_buffer {
+      public:
+        static constexpr stl::size_t capacity = 1U << 14U; // 512 KiB
+
+      private:
+        stl::unique_ptr<trace_event[]> events{new trace_event[capacity]};
+        stl::atomic<stl::uint64_t>     head{0};
+        stl::uint32_t                  thread_index;
+
+      public:
+        explicit trace_buffer(stl::uint32_t index) noexcept : thread_index{index} {}
+
+        void record(trace_event const& event) noexcept {
+            auto const index               = head.load(stl::memory_order_relaxed);
+            events[index & (capacity - 1)] = event;
+            head.store(index + 1, stl::memory_order_release);
+        }
+
+        template <typename Callable>
+        void for_each(Callable&& callable) const {
+            auto const end = head.load(stl::memory_order_acquire);
+            for (auto index = end > capacity ? end - capacity : 0; index != end; index++)
+                callable(events[index & (capacity - 1)]);
+        }
+
+        [[nodiscard]] stl::uint32_t thread() const noexcept {
+            return thread_index;
+        }
+
+        [[nodiscard]] stl::uint64_t recorded() const noexcept {
+            return head.load(stl::memory_order_relaxed);
+        }
+
+        void reset() noexcept {
+            head.store(0, stl::memory_order_release);
+        }
+    };
+
+    /**
+     * The buffers of all the threads; the buffers of the threads that are gone are kept until clear().
+     */
+    class tracer {
+        mutable stl::mutex                         lock;
+        stl::vector<stl::shared_ptr<trace_buffer>> buffers;
+        stl::uint64_t                              start_ticks;
+        stl::chrono::steady_clock::time_point      start_time;
+
+        tracer() noexcept : start_ticks{trace_ticks()}, start_time{stl::chrono::steady_clock::now()} {}
+
+      public:
+        [[nodiscard]] static tracer& global() noexcept {
+            static tracer instance;
+            return instance;
+        }
+
+        /**
+         * The buffer of this thread
+         */
+        [[nodiscard]] trace_buffer& local() {
+            thread_local stl::shared_ptr<trace_buffer> buffer = [this] {
+                stl::scoped_lock const _lock{lock};
+                return buffers.emplace_back(
+                  stl::make_shared<trace_buffer>(static_cast<stl::uint32_t>(buffers.size() + 1)));
+            }();
+            return *buffer;
+        }
+
+        /**
+         * Forget the events that are recorded so far; while the other threads are not recording
+         */
+        void clear() {
+            stl::scoped_lock const _lock{lock};
+            buffers.erase(stl::remove_if(buffers.begin(),
+                                         buffers.end(),
+                                         [](auto const& buffer) {
+                                             return buffer.use_count() == 1; // its thread is gone
+                                         }),
+                          buffers.end());
+            for (auto& buffer : buffers)
+                buffer->reset();
+        }
+
+        /**
+         * The ticks in a microsecond, measured from when the tracer was made
+         */
+        [[nodiscard]] double ticks_per_microsecond() const noexcept {
+#ifdef WEBPP_TRACE_TSC
+            auto const ticks   = static_cast<double>(trace_ticks() - start_ticks);
+            auto const elapsed = stl::chrono::duration<double, stl::micro>(
+                                   stl::chrono::steady_clock::now() - start_time)
+                                   .count();
+            return elapsed > 0 && ticks > 0 ? ticks / elapsed : 1.0;
+#else
+            return 1'000.0;
+#endif
+        }
+
+        /**
+         * Write the events of all the threads as the "complete" events of the Chrome trace format; the
+         * timestamps are in the microseconds from the start of the tracer.
+         */
+        void write_chrome_trace(stl::ostream& out) const {
+            auto const scale = ticks_per_microsecond();
+            out << R"({"displayTimeUnit":"ns","traceEvents":[)";
+            bool       first = true;
+            auto const flags = out.flags();
+            out << stl::fixed << stl::setprecision(3);
+            stl::scoped_lock const _lock{lock};
+            for (auto const& buffer : buffers) {
+                buffer->for_each([&](trace_event const& event) {
+                    if (event.begin < start_ticks || event.end < event.begin)
+                        return; // torn
+                    out << (first ? "" : ",") << R"({"name":")" << trace_point_name(event.point)
+                        << R"(","cat":"webpp","ph":"X","pid":1,"tid":)" << buffer->thread()
+                        << R"(,"ts":)" << static_cast<double>(event.begin - start_ticks) / scale
+                        << R"(,"dur":)" << static_cast<double>(event.end - event.begin) / scale
+                        << R"(,"args":{"id":)" << event.id << "}}";
+                    first = false;
+                });
+            }
+            out << "]}";
+            out.flags(flags);
+        }
+    };
+
+    /**
+     * Record the time from when it's made to when it's destroyed (see WEBPP_TRACE_SPAN)
+     */
+    class trace_span {
+        stl::uint64_t id;
+        stl::uint64_t begin;
+        trace_point   point;
+
+      public:
+        trace_span(trace_point _point, stl::uint64_t _id = 0) noexcept
+          : id{_id},
+            begin{trace_ticks()},
+            point{_point} {}
+
+        trace_span(trace_span const&)            = delete;
+        trace_span& operator=(trace_span const&) = delete;
+
+        ~trace_span() noexcept {
+            tracer::global().local().record({begin, trace_ticks(), id, point});
+        }
+    };
+
+    /**
+     * Record a span that started at "begin" (in trace_ticks), and ends now; for the asynchronous
+     * operations, whose ends are in other functions
+     */
+    inline void trace_since(trace_point point, stl::uint64_t id, stl::uint64_t begin) noexcept {
+        tracer::global().local().record({begin, trace_ticks(), id, point});
+    }
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_TRACING_H
@@ -1,25 +1,38 @@
 #ifndef WEBPP_UTILS_URI_H
 #define WEBPP_UTILS_URI_H
 
-#include "../std/map.hpp"
 #include "../std/vector.hpp"
 #include "../std/optional.hpp"
 #include "../traits/traits_concepts.hpp"
 #include "../validators/validators.hpp"
 #include "./casts.hpp"
 #include "./charset.hpp"
+#include "./host.hpp"
 #include "./ipv4.hpp"
 #include "./ipv6.hpp"
 #include "./strings.hpp"
 
+#include <array>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <type_traits>
 #include <variant>
 
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#    define WEBPP_URI_SCANNER_WIDTH 32
+#elif defined(__SSE2__)
+#    include <emmintrin.h>
+#    define WEBPP_URI_SCANNER_WIDTH 16
+#else
+#    define WEBPP_URI_SCANNER_WIDTH 1
+#endif
+
 namespace webpp {
 
     namespace is {
@@ -36,6 +49,112 @@ namespace webpp {
 
     } // namespace is
 
+    namespace details {
+
+        /**
+         * Finds the next '%', 16 (SSE2) or 32 (AVX2) bytes at a time; the
+         * encoded strings are mostly long runs without one.
+         */
+        struct percent_scanner {
+            static constexpr stl::size_t width = WEBPP_URI_SCANNER_WIDTH;
+
+            /**
+             * The position of the first '%' at or after "pos"; npos if
+             * there's none.
+             */
+            [[nodiscard]] static stl::size_t find(stl::string_view data,
+                                                  stl::size_t pos) noexcept {
+#if WEBPP_URI_SCANNER_WIDTH > 1
+                auto const* const begin = data.data();
+#    if WEBPP_URI_SCANNER_WIDTH == 32
+                auto const percent = _mm256_set1_epi8('%');
+                for (; pos + width <= data.size(); pos += width) {
+                    auto const chunk = _mm256_loadu_si256(
+                      reinterpret_cast<__m256i const*>(begin + pos));
+                    auto const mask = static_cast<uint32_t>(
+                      _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, percent)));
+                    if (mask != 0)
+                        return pos +
+                               static_cast<stl::size_t>(__builtin_ctz(mask));
+                }
+#    else
+                auto const percent = _mm_set1_epi8('%');
+                for (; pos + width <= data.size(); pos += width) {
+                    auto const chunk = _mm_loadu_si128(
+                      reinterpret_cast<__m128i const*>(begin + pos));
+                    auto const mask = static_cast<uint32_t>(
+                      _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, percent)));
+                    if (mask != 0)
+                        return pos +
+                               static_cast<stl::size_t>(__builtin_ctz(mask));
+                }
+#    endif
+#endif
+                return data.find('%', pos);
+            }
+        };
+
+        template <typename CharT>
+        [[nodiscard]] constexpr int hex_digit(CharT c) noexcept {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            return -1;
+        }
+
+        /**
+         * Decode the percent-encoded string; the runs between the escapes
+         * are checked against the allowed chars and given to "on_run" as
+         * they are, and the decoded chars are given to "on_char".
+         * @returns false if it's not encoded well or it has bad chars
+         */
+        template <typename CharT, stl::size_t N, typename OnRun,
+                  typename OnChar>
+        [[nodiscard]] bool
+        decode_percents(stl::basic_string_view<CharT> encoded_str,
+                        charset_t<CharT, N> const&    allowed_chars,
+                        OnRun&& on_run, OnChar&& on_char) noexcept {
+            using str_view_t = stl::basic_string_view<CharT>;
+            constexpr bool is_byte =
+              sizeof(CharT) == 1 && stl::is_same_v<CharT, char>;
+
+            stl::size_t const size = encoded_str.size();
+            for (stl::size_t pos = 0; pos < size;) {
+                stl::size_t percent;
+                if constexpr (is_byte) {
+                    percent = percent_scanner::find(encoded_str, pos);
+                } else {
+                    percent = encoded_str.find('%', pos);
+                }
+                if (percent == str_view_t::npos)
+                    percent = size;
+
+                if (percent != pos) {
+                    auto const run = encoded_str.substr(pos, percent - pos);
+                    if (!allowed_chars.contains(run))
+                        return false; // bad chars
+                    on_run(run);
+                }
+                if (percent == size)
+                    break;
+
+                if (size - percent < 3)
+                    return false; // the escape is cut
+                auto const high = hex_digit(encoded_str[percent + 1]);
+                auto const low  = hex_digit(encoded_str[percent + 2]);
+                if (high < 0 || low < 0)
+                    return false; // not encoded well
+                on_char(static_cast<CharT>((high << 4) | low));
+                pos = percent + 3;
+            }
+            return true;
+        }
+
+    } // namespace details
+
     /**
      * @brief this function will decode parts of uri
      * @details this function is almost the same as "decodeURIComponent" in
@@ -47,43 +166,205 @@ namespace webpp {
       typename TraitsType::string_view_type const& encoded_str,
       charset_t<typename TraitsType::char_type, N> const&
         allowed_chars) noexcept {
-        int                            digits_left  = 2;
-        typename TraitsType::char_type decoded_char = 0;
-        // FIXME: decoding is assigned but never used; check if the algorithm is correct
-        bool                             decoding = false;
+        using char_type = typename TraitsType::char_type;
         typename TraitsType::string_type res;
-        for (const auto c : encoded_str) {
-            if (decoding && digits_left) {
-                decoded_char <<= 4;
-                if (c >= '0' && c <= '9') { // DIGITS
-                    decoded_char += c - '0';
-                } else if (c >= 'A' && c <= 'F') { // UPPER_HEX
-                    decoded_char += c - 'A' + 10;
-                } else if (c >= 'a' && c <= 'f') { // LOWER_HEX
-                    decoded_char += c - 'a' + 10;
-                } else {
-                    return stl::nullopt; // not encoded well
-                }
-                --digits_left;
+        res.reserve(encoded_str.size());
+        if (!details::decode_percents(
+              encoded_str, allowed_chars,
+              [&](auto run) {
+                  res.append(run.data(), run.size());
+              },
+              [&](char_type c) {
+                  res.push_back(c);
+              }))
+            return stl::nullopt;
+        return stl::move(res);
+    }
+
+    /**
+     * Decode the string in its own buffer (the decoded string is never
+     * longer than the encoded one), so nothing is allocated.
+     * @returns false if it's not encoded well or it has bad chars; the
+     * string is partly decoded then.
+     */
+    template <Traits TraitsType, stl::size_t N>
+    [[nodiscard]] bool decode_uri_component_inplace(
+      typename TraitsType::string_type& str,
+      charset_t<typename TraitsType::char_type, N> const&
+        allowed_chars) noexcept {
+        using char_type   = typename TraitsType::char_type;
+        using char_traits = typename TraitsType::string_type::traits_type;
+        auto* const data  = str.data();
+        stl::size_t end   = 0;
+        bool const  valid = details::decode_percents(
+          typename TraitsType::string_view_type{data, str.size()},
+          allowed_chars,
+          [&](auto run) {
+              if (run.data() != data + end)
+                  char_traits::move(data + end, run.data(), run.size());
+              end += run.size();
+          },
+          [&](char_type c) {
+              data[end++] = c;
+          });
+        str.resize(end);
+        return valid;
+    }
+
+    namespace details {
+
+        template <typename CharT>
+        [[nodiscard]] constexpr bool is_unreserved(CharT c) noexcept {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                   (c >= '0' && c <= '9') || c == '-' || c == '.' ||
+                   c == '_' || c == '~';
+        }
+
+        template <typename CharT>
+        [[nodiscard]] constexpr CharT upper_hex(CharT c) noexcept {
+            return c >= 'a' && c <= 'f' ? static_cast<CharT>(c - 'a' + 'A')
+                                        : c;
+        }
 
-                if (digits_left == 0) {
-                    decoding = false;
-                    res.push_back(static_cast<typename TraitsType::char_type>(
-                      decoded_char));
+        template <typename CharT>
+        [[nodiscard]] constexpr bool is_lower_hex(CharT c) noexcept {
+            return c >= 'a' && c <= 'f';
+        }
+
+        /**
+         * Where the path of a request target ends; the query and the
+         * fragment after it are not normalized.
+         */
+        template <typename CharT>
+        [[nodiscard]] constexpr stl::size_t
+        path_end(CharT const* data, stl::size_t size) noexcept {
+            stl::size_t pos = 0;
+            while (pos < size && data[pos] != '?' && data[pos] != '#')
+                pos++;
+            return pos;
+        }
+
+    } // namespace details
+
+    /**
+     * Check if the path (of a request target; the query and the fragment are
+     * ignored) is what normalize_path_inplace would leave as it is: there's
+     * no "." or ".." segment, no escaped unreserved char, and no lower case
+     * hex digit in the escapes.
+     */
+    template <typename CharT>
+    [[nodiscard]] constexpr bool
+    is_normalized_path(stl::basic_string_view<CharT> path) noexcept {
+        auto const end = details::path_end(path.data(), path.size());
+        for (stl::size_t pos = 0; pos < end; pos++) {
+            auto const c = path[pos];
+            if (c == '%' && pos + 2 < end) {
+                auto const high = details::hex_digit(path[pos + 1]);
+                auto const low  = details::hex_digit(path[pos + 2]);
+                if (high < 0 || low < 0)
+                    continue;
+                if (details::is_unreserved(
+                      static_cast<CharT>((high << 4) | low)) ||
+                    details::is_lower_hex(path[pos + 1]) ||
+                    details::is_lower_hex(path[pos + 2]))
+                    return false;
+            } else if (c == '.' && (pos == 0 || path[pos - 1] == '/')) {
+                auto segment_end = pos + 1;
+                if (segment_end < end && path[segment_end] == '.')
+                    segment_end++;
+                if (segment_end == end || path[segment_end] == '/')
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Normalize the path of a request target in its own buffer, the way
+     * RFC 3986 (section 6.2.2) says: the escaped unreserved chars are
+     * decoded, the hex digits of the other escapes are upper cased, and then
+     * the "." and ".." segments are removed (remove_dot_segments of section
+     * 5.2.4). The query and the fragment after the path are kept as they
+     * are, and moved back if the path got shorter.
+     *
+     * It's one pass for each of the two steps, with no stack of the
+     * segments: the output is written over the input behind the read
+     * position (it never gets longer), and a ".." just moves the write
+     * position back to the previous '/'.
+     *
+     * @returns the new size; nothing after it is meaningful.
+     */
+    template <typename CharT>
+    constexpr stl::size_t normalize_path_inplace(CharT*      data,
+                                                 stl::size_t size) noexcept {
+        auto const end = details::path_end(data, size);
+
+        // the escapes
+        stl::size_t len = 0;
+        for (stl::size_t pos = 0; pos < end;) {
+            if (data[pos] == '%' && pos + 2 < end) {
+                auto const high = details::hex_digit(data[pos + 1]);
+                auto const low  = details::hex_digit(data[pos + 2]);
+                if (high >= 0 && low >= 0) {
+                    auto const decoded = static_cast<CharT>((high << 4) | low);
+                    if (details::is_unreserved(decoded)) {
+                        data[len++] = decoded;
+                    } else {
+                        data[len++] = '%';
+                        data[len++] = details::upper_hex(data[pos + 1]);
+                        data[len++] = details::upper_hex(data[pos + 2]);
+                    }
+                    pos += 3;
+                    continue;
                 }
-            } else if (c == '%') {
-                decoding = true;
+            }
+            data[len++] = data[pos++];
+        }
 
-                // resetting:
-                digits_left  = 2;
-                decoded_char = 0;
+        // the dot segments
+        stl::size_t out = 0;
+        stl::size_t in  = 0;
+        auto const  at  = [&](stl::size_t index, CharT c) constexpr noexcept {
+            return in + index < len && data[in + index] == c;
+        };
+        auto const pop_segment = [&]() constexpr noexcept {
+            while (out > 0 && data[--out] != '/') {
+            }
+        };
+        while (in < len) {
+            if (at(0, '.') && at(1, '.') && at(2, '/')) { // "../"
+                in += 3;
+            } else if (at(0, '.') && at(1, '/')) { // "./"
+                in += 2;
+            } else if (at(0, '/') && at(1, '.') && at(2, '/')) { // "/./"
+                in += 2;
+            } else if (at(0, '/') && at(1, '.') && in + 2 == len) { // "/."
+                data[out++] = '/';
+                break;
+            } else if (at(0, '/') && at(1, '.') && at(2, '.') &&
+                       at(3, '/')) { // "/../"
+                pop_segment();
+                in += 3;
+            } else if (at(0, '/') && at(1, '.') && at(2, '.') &&
+                       in + 3 == len) { // "/.."
+                pop_segment();
+                data[out++] = '/';
+                break;
+            } else if ((at(0, '.') && in + 1 == len) ||
+                       (at(0, '.') && at(1, '.') && in + 2 == len)) {
+                break; // "." or ".."
             } else {
-                if (!allowed_chars.contains(c))
-                    return stl::nullopt; // bad chars
-                res.push_back(c);
+                // the first segment, with its '/'
+                do {
+                    data[out++] = data[in++];
+                } while (in < len && data[in] != '/');
             }
         }
-        return stl::move(res);
+
+        // the query and the fragment
+        for (stl::size_t pos = end; pos < size; pos++)
+            data[out++] = data[pos];
+        return out;
     }
 
     /**
@@ -121,16 +402,21 @@ namespace webpp {
         };
 
         typename TraitsType::string_type encodedElement;
-        for (auto c : element) {
-            if (allowedCharacters.contains(c)) {
-                encodedElement.push_back(c);
-            } else {
-                encodedElement.push_back('%');
-                encodedElement.push_back(
-                  make_hex_digit(static_cast<unsigned int>(c) >> 4u));
-                encodedElement.push_back(
-                  make_hex_digit(static_cast<unsigned int>(c) & 0x0Fu));
-            }
+        encodedElement.reserve(element.size());
+        for (stl::size_t pos = 0; pos < element.size();) {
+            // the allowed ones are copied as a run
+            auto const end = stl::min(
+              allowedCharacters.find_first_not_in(element, pos), element.size());
+            encodedElement.append(element.data() + pos, end - pos);
+            if (end == element.size())
+                break;
+            auto const c = element[end];
+            encodedElement.push_back('%');
+            encodedElement.push_back(
+              make_hex_digit(static_cast<unsigned int>(c) >> 4u));
+            encodedElement.push_back(
+              make_hex_digit(static_cast<unsigned int>(c) & 0x0Fu));
+            pos = end + 1;
         }
         return encodedElement;
     }
@@ -157,6 +443,9 @@ namespace webpp {
      *
      *  [protocol"://"[username[":"password]"@"]hostname[":"port]"/"?][path]["?"querystring]["#"fragment]
      */
+    template <Traits TraitsType>
+    struct basic_query_params;
+
     template <Traits TraitsType, bool Mutable = true>
     class basic_uri {
       public:
@@ -274,6 +563,16 @@ namespace webpp {
          * port_end == authority_end == path_start
          */
 
+        /**
+         * Check if the colon is the end of the scheme
+         */
+        [[nodiscard]] static constexpr bool
+        is_scheme_end(str_view_t const& _data, stl::size_t colon) noexcept {
+            auto __scheme = _data.substr(0, colon);
+            return ALPHA<char_type>.contains(_data[0]) &&
+                   SCHEME_NOT_FIRST.find_first_not_in(__scheme.substr(1));
+        }
+
         /**
          * parse the scheme
          * this method will fill the "authority_start" and "scheme_end" vars
@@ -291,10 +590,7 @@ namespace webpp {
                 return;
             } else if (const auto colon = _data.find(':');
                        colon != str_view_t::npos) {
-                auto __scheme = _data.substr(0, colon);
-                if (ALPHA<char_type>.contains(__scheme[0]) &&
-                    __scheme.substr(1).find_first_not_of(
-                      SCHEME_NOT_FIRST.string_view())) {
+                if (is_scheme_end(_data, colon)) {
                     scheme_end = colon;
 
                     if (_data.substr(colon + 1, 2) == "//") {
@@ -577,6 +873,51 @@ namespace webpp {
             parse_path(); // to make sure we have "authority_end"
         }
 
+        /**
+         * Find all of the offsets in one scan of the uri. They're the same
+         * ones that the parse_* functions find, but those scan the uri again
+         * for each of them (and find the ones they depend on first), so this
+         * is for when a few of the components are going to be used (like the
+         * uri of a request).
+         */
+        void parse_all() const noexcept {
+            constexpr auto npos = str_view_t::npos;
+            if (authority_end != npos && user_info_end != npos &&
+                port_start != npos)
+                return; // It's already parsed (the rest come with these)
+
+            auto const res  = find_offsets(this->string_view());
+            scheme_end      = res.scheme_end;
+            authority_start = res.authority_start;
+            user_info_end   = res.user_info_end;
+            port_start      = res.port_start;
+            authority_end   = res.authority_end;
+            query_start     = res.query_start;
+            fragment_start  = res.fragment_start;
+        }
+
+        /**
+         * Call the callback with each segment of the path, in order
+         */
+        template <typename Callback>
+        void for_each_path_segment(Callback&& callback) const noexcept {
+            auto _path = path();
+            if (_path.empty())
+                return;
+            stl::size_t slash_start      = 0;
+            stl::size_t last_slash_start = 0;
+            auto        _path_size       = _path.size();
+            if (_path.front() == '/')
+                callback(str_view_t{}); // empty string
+            do {
+                slash_start = _path.find('/', last_slash_start + 1);
+                callback(_path.substr(last_slash_start + 1,
+                                      stl::min(slash_start, _path_size) -
+                                        last_slash_start - 1));
+                last_slash_start = slash_start;
+            } while (slash_start != str_view_t::npos);
+        }
+
         /**
          * Remove the cache and make sure calling the functions will cause
          * re-parsing the uri.
@@ -620,6 +961,122 @@ namespace webpp {
             return Mutable;
         }
 
+        /**
+         * Parse all of the components now, in one scan; otherwise they're
+         * parsed when they're asked for, one by one.
+         */
+        basic_uri const& parse() const noexcept {
+            parse_all();
+            return *this;
+        }
+
+        /**
+         * The offsets of the components; the ones that aren't there are at
+         * the end of the uri (see the comment of the cache variables).
+         */
+        struct offsets {
+            stl::size_t scheme_end, authority_start, user_info_end, port_start,
+              authority_end, query_start, fragment_start;
+        };
+
+        /**
+         * Find all of the offsets in one scan of the uri; it doesn't use the
+         * cache of a basic_uri, so it works in the constant expressions
+         * too (see basic_uri_components).
+         */
+        [[nodiscard]] static constexpr offsets
+        find_offsets(str_view_t const& _data) noexcept {
+            constexpr auto npos = str_view_t::npos;
+            auto const     size = _data.size();
+
+            // a "//" at the start is the authority without a scheme
+            bool const  slashes      = starts_with<traits_type>(_data, "//");
+            bool        scheme_found = false;
+            stl::size_t first_colon = npos, hash = npos, question = npos,
+                        authority = slashes ? 2 : npos, at_sign = npos,
+                        last_colon = npos;
+
+            // the path starts at the first '/' after the authority (or the
+            // scheme, if the authority is empty), or the first one at all if
+            // there's no scheme; and it's before the query if there's a
+            // query after the authority
+            stl::size_t path_start = npos, first_slash = npos;
+            auto const  path_from  = [&]() noexcept -> stl::size_t {
+                if (authority != npos && authority != size)
+                    return authority;
+                return slashes ? 0 : first_colon;
+            };
+
+            for (stl::size_t i = 0; i < size; i++) {
+                switch (_data[i]) {
+                    case '#':
+                        if (hash == npos)
+                            hash = i;
+                        break;
+                    case '?':
+                        if (hash == npos && question == npos)
+                            question = i;
+                        break;
+                    case ':':
+                        if (first_colon == npos) {
+                            first_colon = i;
+                            if (!slashes && is_scheme_end(_data, i)) {
+                                scheme_found = true;
+                                if (_data.substr(i + 1, 2) == "//")
+                                    authority = i + 3;
+                            }
+                        }
+                        if (authority != npos && i >= authority &&
+                            path_start == npos)
+                            last_colon = i;
+                        break;
+                    case '@':
+                        if (authority != npos && i >= authority &&
+                            path_start == npos && at_sign == npos)
+                            at_sign = i;
+                        break;
+                    case '/':
+                        if (first_slash == npos && question == npos)
+                            first_slash = i;
+                        if (path_start == npos && (slashes || scheme_found) &&
+                            i >= path_from() &&
+                            (question == npos || question < path_from()))
+                            path_start = i;
+                        break;
+                }
+            }
+
+            offsets res{};
+            res.fragment_start = hash != npos ? hash : size;
+            res.query_start    = question != npos ? question : size;
+            if (slashes) {
+                res.scheme_end      = size;
+                res.authority_start = 2;
+            } else if (scheme_found) {
+                res.scheme_end      = first_colon;
+                res.authority_start = authority != npos ? authority : size;
+            } else {
+                res.scheme_end = res.authority_start = size;
+            }
+            auto const path_at = slashes || scheme_found ? path_start
+                                                         : first_slash;
+            res.authority_end  = path_at != npos ? path_at : size;
+
+            if (res.authority_start == size) {
+                res.user_info_end = res.port_start = size;
+                return res;
+            }
+            res.user_info_end = at_sign != npos ? at_sign : size;
+            res.port_start    = size;
+            if (last_colon != npos &&
+                (at_sign == npos || last_colon > at_sign) &&
+                is::digit(_data.substr(last_colon + 1,
+                                       res.authority_end - (last_colon + 1))))
+                res.port_start = last_colon;
+            return res;
+        }
+
+
         /**
          * @brief parse from string, it will trim the spaces for generality too
          * @param string_view URI string
@@ -913,8 +1370,8 @@ namespace webpp {
                 // there's no user info
                 start = authority_start;
             } else {
-                // there's a user info
-                start = user_info_end;
+                // there's a user info (and the '@')
+                start = user_info_end + 1;
             }
 
             if (port_start != data.size()) {
@@ -1025,8 +1482,8 @@ namespace webpp {
                     start = authority_start;
                 }
             } else {
-                // there's a user info
-                start = user_info_end;
+                // there's a user info (and the '@')
+                start = user_info_end + 1;
             }
 
             if (port_start != data.size()) {
@@ -1084,10 +1541,15 @@ namespace webpp {
          * valid IP address or not
          */
         [[nodiscard]] bool is_ip() const noexcept {
-            auto _host = host();
-            return is::ipv4<traits_type>(_host) ||
-                   (starts_with<traits_type>(_host, '[') &&
-                    ends_with<traits_type>(_host, ']'));
+            return host_info().is_ip();
+        }
+
+        /**
+         * What the host is and its labels, in one scan of it; keep it if a
+         * few of the domains are needed (the getters below each make one).
+         */
+        [[nodiscard]] basic_host_info<traits_type> host_info() const noexcept {
+            return basic_host_info<traits_type>::parse(host());
         }
 
         /**
@@ -1097,9 +1559,10 @@ namespace webpp {
          */
         [[nodiscard]] istl::vector<traits_type, str_t>
         domains() const noexcept {
-            auto _host = host();
-            if (_host.empty() || is_ip())
+            auto const info = host_info();
+            if (!info.is_reg_name())
                 return {};
+            auto _host = info.host();
             istl::vector<traits_type, str_t> subs;
             for (;;) {
                 auto dot = _host.find('.');
@@ -1118,11 +1581,7 @@ namespace webpp {
          * Get the TLD (top level domain) or sometimes called extension
          */
         [[nodiscard]] str_view_t top_level_domain() const noexcept {
-            auto _host = host();
-            if (_host.empty() || is_ip())
-                return {};
-            auto dot = _host.find_last_of('.');
-            return _host.substr(dot != str_view_t::npos ? dot + 1 : 0);
+            return host_info().top_level_domain();
         }
 
         /**
@@ -1158,17 +1617,7 @@ namespace webpp {
          * Get the second level domain out of the host
          */
         [[nodiscard]] str_view_t second_level_domain() const noexcept {
-            auto _host = host();
-            if (_host.empty() || is_ip())
-                return {};
-            auto last_dot = _host.find_last_of('.');
-            if (last_dot == str_view_t::npos)
-                return {};
-            auto bef_last_dot = _host.find_last_of('.', last_dot - 1);
-            auto start =
-              bef_last_dot == str_view_t::npos ? 0 : bef_last_dot + 1;
-            auto sld = _host.substr(start, last_dot - start);
-            return sld;
+            return host_info().second_level_domain();
         }
 
         /**
@@ -1225,16 +1674,7 @@ namespace webpp {
          * @return
          */
         [[nodiscard]] str_view_t subdomains() const noexcept {
-            auto _host = host();
-            if (_host.empty() || is_ip())
-                return {};
-            auto last_dot = _host.find_last_of('.');
-            if (last_dot == str_view_t::npos)
-                return {};
-            auto bef_last_dot = _host.find_last_of('.', last_dot - 1);
-            if (bef_last_dot == str_view_t::npos)
-                return {};
-            return _host.substr(0, bef_last_dot);
+            return host_info().subdomains();
         }
 
         /**
@@ -1307,7 +1747,10 @@ namespace webpp {
          */
         [[nodiscard]] uint16_t port_uint16() const noexcept {
             if (has_port()) {
-                return static_cast<uint16_t>(to_uint<traits_type>(port()));
+                // zero if it's not a valid port
+                uint16_t res = 0;
+                static_cast<void>(parse_integer(port(), res));
+                return res;
             }
             return default_port();
         }
@@ -1324,10 +1767,7 @@ namespace webpp {
                 return {};
 
             // don't worry authority_end will be the end of the string anyway
-            return substr(port_start + 1,
-                          (authority_end == data.size() ? authority_end - 1
-                                                        : authority_end) -
-                            (port_start + 1));
+            return substr(port_start + 1, authority_end - (port_start + 1));
         }
 
         /**
@@ -1444,29 +1884,44 @@ namespace webpp {
          */
         template <typename Container = istl::vector<traits_type, str_view_t>>
         [[nodiscard]] Container path_structured() const noexcept {
-            auto _path = path();
-            if (_path.empty())
-                return {};
-            Container   container;
-            stl::size_t slash_start      = 0;
-            stl::size_t last_slash_start = 0;
-            auto        _path_size       = _path.size();
-            if (_path.front() == '/')
-                container.emplace_back(); // empty string
-            do {
-                slash_start = _path.find('/', last_slash_start + 1);
-                container.emplace_back(_path.data() + last_slash_start + 1,
-                                       stl::min(slash_start, _path_size) -
-                                         last_slash_start - 1);
-                // if (slash_start != str_view_t::npos)
-                // _path.remove_prefix(slash_start + 1);
-                // else
-                // _path.remove_prefix(_path.size());
-                last_slash_start = slash_start;
-            } while (slash_start != str_view_t::npos);
+            Container container;
+            for_each_path_segment([&](str_view_t segment) noexcept {
+                if (segment.empty())
+                    container.emplace_back(); // empty string
+                else
+                    container.emplace_back(segment.data(), segment.size());
+            });
             return container;
         }
 
+        /**
+         * Split the path into the given array, without allocating; the
+         * segments are views into the uri, still encoded (see
+         * path_segment_decoded), and they're split like the other
+         * path_structured.
+         * @returns the number of the segments; only the first ones are
+         * written if there are more of them than the size of the array.
+         */
+        stl::size_t
+        path_structured(stl::span<str_view_t> segments) const noexcept {
+            stl::size_t count = 0;
+            for_each_path_segment([&](str_view_t segment) noexcept {
+                if (count < segments.size())
+                    segments[count] = segment;
+                count++;
+            });
+            return count;
+        }
+
+        /**
+         * Decode a segment of the path
+         */
+        [[nodiscard]] static stl::optional<str_t>
+        path_segment_decoded(str_view_t segment) noexcept {
+            return decode_uri_component<traits_type>(segment,
+                                                     PCHAR_NOT_PCT_ENCODED);
+        }
+
         /**
          * @brief this one will return a container containing decoded strings of
          * the path.
@@ -1674,62 +2129,46 @@ namespace webpp {
         }
 
         /**
-         * Get the query in as a map<string, string>
-         * It's also in a decoded format
-         * @return unordered_map<string, string>
+         * Get the parameters of the query, as views into the uri; they're
+         * decoded when they're asked for (see basic_query_params). The uri
+         * should outlive it.
          */
-        [[nodiscard]] stl::map<traits_type, str_t, str_t>
+        [[nodiscard]] basic_query_params<traits_type>
         query_structured() const noexcept {
-            stl::map<traits_type, str_t, str_t> q_structured;
-            stl::size_t                         last_and_sep = 0;
-            auto                                _query       = query();
-            do {
-                auto and_sep =
-                  _query.find('&', last_and_sep); // find the delimiter
-                auto eq_sep =
-                  _query.find("=", last_and_sep, and_sep - last_and_sep);
-                auto name =
-                  _query.substr(last_and_sep + 1, stl::min(eq_sep, and_sep));
-                last_and_sep = and_sep;
-                if (name.empty()) // a name should not be empty
-                    continue;
-                str_t value;
-                if (and_sep != str_view_t::npos) { // we have a value as well
-                    value = _query.substr(eq_sep + 1, and_sep);
-                }
-                auto d_name = decode_uri_component<traits_type>(
-                  name, QUERY_OR_FRAGMENT_NOT_PCT_ENCODED);
-                if (d_name)
-                    q_structured[d_name.value()] =
-                      decode_uri_component<traits_type>(
-                        value, QUERY_OR_FRAGMENT_NOT_PCT_ENCODED)
-                        .value_or("");
-            } while (last_and_sep != str_view_t::npos);
-            return q_structured;
+            return basic_query_params<traits_type>::parse(query());
         }
 
         /**
          * @brief checks if the uri path is normalized or not (contains relative
-         * . or .. paths)
+         * . or .. paths, or escapes that are not normalized)
          * @return
          */
         [[nodiscard]] bool is_normalized() const noexcept {
-            auto __path = path_structured();
-            return __path.cend() != stl::find_if(__path.cbegin(), __path.cend(),
-                                                 [](auto const& p) {
-                                                     return p == "." ||
-                                                            p == "..";
-                                                 });
+            return is_normalized_path(path());
         }
 
         /**
          * @details This method applies the "remove_dot_segments" routine talked
          * about in RFC 3986 (https://tools.ietf.org/html/rfc3986) to the path
          * segments of the URI, in order to normalize the path
-         * (apply and remove "." and ".." segments).
+         * (apply and remove "." and ".." segments); the escapes are
+         * normalized as well (see normalize_path_inplace). It's done in the
+         * uri's own string.
          */
         basic_uri& normalize_path() noexcept {
-            // TODO
+            static_assert(is_mutable(),
+                          "You cannot change a const_uri (string_view is not "
+                          "modifiable)");
+            auto const len = path().size();
+            if (len == 0)
+                return *this;
+            auto const start = authority_end;
+            auto const new_len =
+              normalize_path_inplace(data.data() + start, len);
+            if (new_len != len) {
+                data.erase(start + new_len, len - new_len);
+                unparse();
+            }
             return *this;
         }
 
@@ -1738,6 +2177,8 @@ namespace webpp {
          */
         [[nodiscard]] str_view_t fragment() const noexcept {
             parse_fragment();
+            if (fragment_start == data.size())
+                return {};
             return substr(fragment_start + 1);
         }
 
@@ -1983,6 +2424,246 @@ namespace webpp {
     using const_uri = basic_uri<std_traits, false>;
     using uri       = basic_uri<std_traits, true>;
 
+    /**
+     * The parameters of a query, as views into it, in a fixed small vector
+     * (like routes::path_segments); nothing is allocated when it's parsed,
+     * and a value is decoded only when it's asked for, and only if it has
+     * escapes in it. It's split at the '&'s; "a=1&b" is {"a", "1"}, {"b", ""}
+     * and the parameters without a name are skipped.
+     *
+     * The queries with more than "capacity" parameters are truncated; the
+     * "overflowed" tells if that has happened.
+     */
+    template <Traits TraitsType>
+    struct basic_query_params {
+        static constexpr stl::size_t capacity = 16;
+
+        using traits_type = TraitsType;
+        using str_t       = typename traits_type::string_type;
+        using str_view_t  = typename traits_type::string_view_type;
+
+        /**
+         * A parameter; both are still encoded
+         */
+        struct param {
+            str_view_t name;
+            str_view_t value;
+        };
+
+        using value_type     = param;
+        using iterator       = param const*;
+        using const_iterator = param const*;
+
+      private:
+        stl::array<param, capacity> items{};
+        stl::size_t                 count       = 0;
+        bool                        _overflowed = false;
+
+        static constexpr auto allowed_chars =
+          basic_uri<traits_type, false>::QUERY_OR_FRAGMENT_NOT_PCT_ENCODED;
+
+        [[nodiscard]] static bool decode(str_view_t encoded,
+                                         str_t&     out) noexcept {
+            out.clear();
+            if (encoded.find('%') == str_view_t::npos) {
+                if (!allowed_chars.contains(encoded))
+                    return false;
+                out.append(encoded.data(), encoded.size());
+                return true;
+            }
+            auto decoded =
+              decode_uri_component<traits_type>(encoded, allowed_chars);
+            if (!decoded)
+                return false;
+            out = stl::move(*decoded);
+            return true;
+        }
+
+      public:
+        constexpr basic_query_params() noexcept = default;
+
+        /**
+         * Split the query; it's without the '?'
+         */
+        [[nodiscard]] static constexpr basic_query_params
+        parse(str_view_t query) noexcept {
+            basic_query_params res;
+            while (!query.empty()) {
+                auto const and_sep = query.find('&');
+                auto const item    = query.substr(0, and_sep);
+                if (auto const eq_sep = item.find('='); eq_sep != 0) {
+                    if (eq_sep == str_view_t::npos) {
+                        res.emplace_back(item, str_view_t{});
+                    } else {
+                        res.emplace_back(item.substr(0, eq_sep),
+                                         item.substr(eq_sep + 1));
+                    }
+                }
+                if (and_sep == str_view_t::npos)
+                    break;
+                query.remove_prefix(and_sep + 1);
+            }
+            return res;
+        }
+
+        constexpr void emplace_back(str_view_t name,
+                                    str_view_t value) noexcept {
+            if (name.empty())
+                return;
+            if (count == capacity) {
+                _overflowed = true;
+                return;
+            }
+            items[count++] = param{name, value};
+        }
+
+        /**
+         * The first parameter with the name; the name is compared with the
+         * decoded names. nullptr if there's none.
+         */
+        [[nodiscard]] param const* find(str_view_t name) const noexcept {
+            for (auto const& item : *this) {
+                if (item.name == name)
+                    return &item;
+                if (item.name.find('%') != str_view_t::npos) {
+                    str_t decoded_name;
+                    if (decode(item.name, decoded_name) && decoded_name == name)
+                        return &item;
+                }
+            }
+            return nullptr;
+        }
+
+        [[nodiscard]] bool contains(str_view_t name) const noexcept {
+            return find(name) != nullptr;
+        }
+
+        /**
+         * The value of the parameter, still encoded; empty if there's none.
+         */
+        [[nodiscard]] str_view_t raw(str_view_t name) const noexcept {
+            auto const item = find(name);
+            return item ? item->value : str_view_t{};
+        }
+
+        /**
+         * Decode the value of the parameter into "out"
+         * @returns false if there's no such parameter, or its value is not
+         * encoded well
+         */
+        bool decoded(str_view_t name, str_t& out) const noexcept {
+            auto const item = find(name);
+            return item && decode(item->value, out);
+        }
+
+        /**
+         * The decoded value of the parameter; nullopt if there's no such
+         * parameter, or its value is not encoded well
+         */
+        [[nodiscard]] stl::optional<str_t>
+        decoded(str_view_t name) const noexcept {
+            str_t out;
+            if (!decoded(name, out))
+                return stl::nullopt;
+            return out;
+        }
+
+        [[nodiscard]] constexpr iterator begin() const noexcept {
+            return items.data();
+        }
+
+        [[nodiscard]] constexpr iterator end() const noexcept {
+            return items.data() + count;
+        }
+
+        [[nodiscard]] constexpr param const&
+        operator[](stl::size_t index) const noexcept {
+            return items[index];
+        }
+
+        [[nodiscard]] constexpr stl::size_t size() const noexcept {
+            return count;
+        }
+
+        [[nodiscard]] constexpr bool empty() const noexcept {
+            return count == 0;
+        }
+
+        [[nodiscard]] constexpr bool overflowed() const noexcept {
+            return _overflowed;
+        }
+    };
+
+    using query_params = basic_query_params<std_traits>;
+
+    /**
+     * The components of a uri as views into it. It's a literal type, so the
+     * uris that are known at compile time (the redirect tables, the
+     * upstreams in the config) are split (and checked) in the build:
+     *
+     *   constexpr auto upstream = uri_components::parse("http://db:8080/v1");
+     *   static_assert(upstream.is_valid && upstream.port == "8080");
+     *
+     * They're the same as what the getters of basic_uri give.
+     */
+    template <Traits TraitsType>
+    struct basic_uri_components {
+        using traits_type = TraitsType;
+        using str_view_t  = typename traits_type::string_view_type;
+
+        str_view_t scheme{};
+        str_view_t user_info{};
+        str_view_t host{};
+        str_view_t port{};
+        str_view_t path{};
+        str_view_t query{};
+        str_view_t fragment{};
+        bool       is_valid = false;
+
+        [[nodiscard]] static constexpr basic_uri_components
+        parse(str_view_t str) noexcept {
+            auto const o    = basic_uri<traits_type, false>::find_offsets(str);
+            auto const size = str.size();
+            // like basic_uri::substr (the length wraps around if the end is
+            // before the start)
+            auto const sub = [&](stl::size_t start, stl::size_t end) {
+                return start == end ? str_view_t{}
+                                    : str.substr(start, end - start);
+            };
+
+            basic_uri_components res;
+            if (o.scheme_end != size)
+                res.scheme = sub(0, o.scheme_end);
+            if (o.authority_start != size) {
+                auto host_start = o.authority_start;
+                if (o.user_info_end != size) {
+                    res.user_info = sub(o.authority_start, o.user_info_end);
+                    host_start    = o.user_info_end + 1;
+                }
+                res.host = sub(host_start, o.port_start != size
+                                             ? o.port_start
+                                             : o.authority_end);
+                if (o.port_start != size)
+                    res.port = sub(o.port_start + 1, o.authority_end);
+            }
+            if (o.authority_end != size)
+                res.path = sub(o.authority_end,
+                               stl::min(o.query_start, o.fragment_start));
+            if (o.query_start != size)
+                res.query = sub(o.query_start + 1, o.fragment_start);
+            if (o.fragment_start != size)
+                res.fragment = sub(o.fragment_start + 1, size);
+            res.is_valid = o.scheme_end != size || o.scheme_end == 0 ||
+                           !res.host.empty() || !res.user_info.empty() ||
+                           !res.port.empty() || o.authority_end != size ||
+                           o.fragment_start != size;
+            return res;
+        }
+    };
+
+    using uri_components = basic_uri_components<std_traits>;
+    using uri_host_info  = basic_host_info<std_traits>;
+
 
     template <Traits TraitsType, bool Mutable1, bool Mutable2>
     bool operator==(basic_uri<TraitsType, Mutable1> const& one,
@@ -2064,4 +2745,6 @@ namespace webpp {
 
 } // namespace webpp
 
+#undef WEBPP_URI_SCANNER_WIDTH
+
 #endif // WEBPP_UTILS_URI_H
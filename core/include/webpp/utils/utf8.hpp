@@ -0,0 +1,357 @@
+#ifndef WEBPP_UTILS_UTF8_H
+#define WEBPP_UTILS_UTF8_H
+
+#include "../std/std.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#    define WEBPP_UTF8_WIDTH 32
+#elif defined(__SSSE3__)
+#    include <tmmintrin.h>
+#    define WEBPP_UTF8_WIDTH 16
+#else
+#    define WEBPP_UTF8_WIDTH 1
+#endif
+
+namespace webpp {
+
+#if WEBPP_UTF8_WIDTH > 1
+    namespace details {
+
+        /**
+         * The vector operations of the UTF-8 validator, in the widest vectors
+         * that we have; the lookups work in the 16-byte lanes.
+         */
+        struct utf8_simd {
+#    if WEBPP_UTF8_WIDTH == 32
+            using vec = __m256i;
+
+            static constexpr stl::size_t width = 32;
+
+            static vec load(char const* data) noexcept {
+                return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data));
+            }
+
+            static vec zero() noexcept {
+                return _mm256_setzero_si256();
+            }
+
+            static vec set1(stl::uint8_t c) noexcept {
+                return _mm256_set1_epi8(static_cast<char>(c));
+            }
+
+            static vec lookup(__m128i table, vec index) noexcept {
+                return _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(table), index);
+            }
+
+            static vec and_(vec a, vec b) noexcept {
+                return _mm256_and_si256(a, b);
+            }
+
+            static vec or_(vec a, vec b) noexcept {
+                return _mm256_or_si256(a, b);
+            }
+
+            static vec xor_(vec a, vec b) noexcept {
+                return _mm256_xor_si256(a, b);
+            }
+
+            static vec subs_u8(vec a, vec b) noexcept {
+                return _mm256_subs_epu8(a, b);
+            }
+
+            static vec high_nibbles(vec v) noexcept {
+                return _mm256_and_si256(_mm256_srli_epi16(v, 4), set1(0x0F));
+            }
+
+            static bool is_ascii(vec v) noexcept {
+                return _mm256_movemask_epi8(v) == 0;
+            }
+
+            static bool is_zero(vec v) noexcept {
+                return _mm256_testz_si256(v, v) != 0;
+            }
+
+            // the bytes of "v" shifted by N, with the last ones of "prev" coming in
+            template <int N>
+            static vec prev(vec v, vec prev) noexcept {
+                return _mm256_alignr_epi8(v, _mm256_permute2x128_si256(prev, v, 0x21), 16 - N);
+            }
+
+            // the last three bytes can't be the start of an unfinished char
+            static vec max_values() noexcept {
+                return _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                        static_cast<char>(0xEF), static_cast<char>(0xDF),
+                                        static_cast<char>(0xBF));
+            }
+#    else
+            using vec = __m128i;
+
+            static constexpr stl::size_t width = 16;
+
+            static vec load(char const* data) noexcept {
+                return _mm_loadu_si128(reinterpret_cast<__m128i const*>(data));
+            }
+
+            static vec zero() noexcept {
+                return _mm_setzero_si128();
+            }
+
+            static vec set1(stl::uint8_t c) noexcept {
+                return _mm_set1_epi8(static_cast<char>(c));
+            }
+
+            static vec lookup(__m128i table, vec index) noexcept {
+                return _mm_shuffle_epi8(table, index);
+            }
+
+            static vec and_(vec a, vec b) noexcept {
+                return _mm_and_si128(a, b);
+            }
+
+            static vec or_(vec a, vec b) noexcept {
+                return _mm_or_si128(a, b);
+            }
+
+            static vec xor_(vec a, vec b) noexcept {
+                return _mm_xor_si128(a, b);
+            }
+
+            static vec subs_u8(vec a, vec b) noexcept {
+                return _mm_subs_epu8(a, b);
+            }
+
+            static vec high_nibbles(vec v) noexcept {
+                return _mm_and_si128(_mm_srli_epi16(v, 4), set1(0x0F));
+            }
+
+            static bool is_ascii(vec v) noexcept {
+                return _mm_movemask_epi8(v) == 0;
+            }
+
+            static bool is_zero(vec v) noexcept {
+                return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) == 0xFFFF;
+            }
+
+            template <int N>
+            static vec prev(vec v, vec prev) noexcept {
+                return _mm_alignr_epi8(v, prev, 16 - N);
+            }
+
+            static vec max_values() noexcept {
+                return _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                     static_cast<char>(0xEF), static_cast<char>(0xDF),
+                                     static_cast<char>(0xBF));
+            }
+#    endif
+        };
+
+    } // namespace details
+#endif
+
+    /**
+     * Checks that the text is well-formed UTF-8 (no overlong forms, no
+     * surrogates, nothing after U+10FFFF). The vectors (SSSE3 or AVX2) use
+     * the lookup tables of Keiser and Lemire: each error is found from the
+     * nibbles of a byte and the one before it, and the ASCII blocks are
+     * skipped; without them it's one char at a time, with the ASCII skipped
+     * 8 bytes at a time.
+     */
+    struct utf8_validator {
+        static constexpr stl::size_t width = WEBPP_UTF8_WIDTH;
+
+        [[nodiscard]] static constexpr bool validate_scalar(stl::string_view str) noexcept {
+            auto const byte = [&](stl::size_t index) constexpr noexcept -> unsigned {
+                return static_cast<unsigned char>(str[index]);
+            };
+            stl::size_t pos = 0;
+            while (pos < str.size()) {
+                // the most of the texts are ASCII
+                if (pos + 8 <= str.size()) {
+                    unsigned high = 0;
+                    for (stl::size_t i = 0; i < 8; i++)
+                        high |= byte(pos + i);
+                    if ((high & 0x80u) == 0) {
+                        pos += 8;
+                        continue;
+                    }
+                }
+                auto const lead = byte(pos);
+                if (lead < 0x80u) {
+                    pos++;
+                    continue;
+                }
+
+                // the second byte has a narrower range after some of the leads (Table 3-7 of Unicode)
+                stl::size_t length = 0;
+                unsigned    low    = 0x80u;
+                unsigned    high   = 0xBFu;
+                if (lead >= 0xC2u && lead <= 0xDFu) {
+                    length = 2;
+                } else if (lead >= 0xE0u && lead <= 0xEFu) {
+                    length = 3;
+                    if (lead == 0xE0u)
+                        low = 0xA0u; // overlong
+                    else if (lead == 0xEDu)
+                        high = 0x9Fu; // surrogates
+                } else if (lead >= 0xF0u && lead <= 0xF4u) {
+                    length = 4;
+                    if (lead == 0xF0u)
+                        low = 0x90u; // overlong
+                    else if (lead == 0xF4u)
+                        high = 0x8Fu; // after U+10FFFF
+                } else {
+                    return false;
+                }
+                if (pos + length > str.size())
+                    return false;
+                if (byte(pos + 1) < low || byte(pos + 1) > high)
+                    return false;
+                for (stl::size_t i = 2; i < length; i++)
+                    if ((byte(pos + i) & 0xC0u) != 0x80u)
+                        return false;
+                pos += length;
+            }
+            return true;
+        }
+
+        /**
+         * The size of the text without the char that's cut at its end, if
+         * there's one; for checking the text piece by piece.
+         */
+        [[nodiscard]] static constexpr stl::size_t complete_size(stl::string_view str) noexcept {
+            for (stl::size_t i = 1; i <= 3 && i <= str.size(); i++) {
+                auto const c = static_cast<unsigned char>(str[str.size() - i]);
+                if (c < 0x80u)
+                    break;
+                if (c >= 0xC0u) {
+                    stl::size_t const length = c >= 0xF0u ? 4 : c >= 0xE0u ? 3 : 2;
+                    return length > i ? str.size() - i : str.size();
+                }
+            }
+            return str.size();
+        }
+
+        [[nodiscard]] static constexpr bool validate(stl::string_view str) noexcept {
+#if WEBPP_UTF8_WIDTH > 1
+            if (!stl::is_constant_evaluated())
+                return validate_vectors(str);
+#endif
+            return validate_scalar(str);
+        }
+
+      private:
+#if WEBPP_UTF8_WIDTH > 1
+        using simd = details::utf8_simd;
+        using vec  = simd::vec;
+
+        // the errors that the pairs of bytes can have, one bit each
+        static constexpr stl::uint8_t too_short      = 1u << 0u; // a lead without its continuations
+        static constexpr stl::uint8_t too_long       = 1u << 1u; // a continuation without a lead
+        static constexpr stl::uint8_t overlong_3     = 1u << 2u;
+        static constexpr stl::uint8_t too_large      = 1u << 3u;
+        static constexpr stl::uint8_t surrogate      = 1u << 4u;
+        static constexpr stl::uint8_t overlong_2     = 1u << 5u;
+        static constexpr stl::uint8_t too_large_1000 = 1u << 6u;
+        static constexpr stl::uint8_t overlong_4     = 1u << 6u;
+        static constexpr stl::uint8_t two_conts      = 1u << 7u; // two continuations; fine in 3 and 4 byte chars
+        static constexpr stl::uint8_t carry          = too_short | too_long | two_conts;
+
+        static __m128i table(stl::uint8_t const (&values)[16]) noexcept {
+            return _mm_loadu_si128(reinterpret_cast<__m128i const*>(values));
+        }
+
+        static vec special_cases(vec input, vec prev1) noexcept {
+            static constexpr stl::uint8_t byte_1_high[16]{
+              // 0_______ (ASCII)
+              too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+              // 10______ (continuation)
+              two_conts, two_conts, two_conts, two_conts,
+              // 1100____ , 1101____ (two bytes)
+              too_short | overlong_2, too_short,
+              // 1110____ (three bytes)
+              too_short | overlong_3 | surrogate,
+              // 1111____ (four bytes, or more)
+              too_short | too_large | too_large_1000 | overlong_4};
+            static constexpr stl::uint8_t byte_1_low[16]{
+              carry | overlong_3 | overlong_2 | overlong_4, // ____0000
+              carry | overlong_2,                           // ____0001
+              carry,
+              carry,
+              carry | too_large, // ____0100
+              carry | too_large | too_large_1000,
+              carry | too_large | too_large_1000,
+              carry | too_large | too_large_1000,
+              carry | too_large | too_large_1000,
+              carry | too_large | too_large_1000,
+              carry | too_large | too_large_1000,
+              carry | too_large | too_large_1000,
+              carry | too_large | too_large_1000,
+              carry | too_large | too_large_1000 | surrogate, // ____1101
+              carry | too_large | too_large_1000,
+              carry | too_large | too_large_1000};
+            static constexpr stl::uint8_t byte_2_high[16]{
+              // 0_______ (ASCII)
+              too_short, too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+              // 1000____
+              too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4,
+              // 1001____
+              too_long | overlong_2 | two_conts | overlong_3 | too_large,
+              // 101_____
+              too_long | overlong_2 | two_conts | surrogate | too_large,
+              too_long | overlong_2 | two_conts | surrogate | too_large,
+              // 11______ (a lead)
+              too_short, too_short, too_short, too_short};
+
+            return simd::and_(simd::and_(simd::lookup(table(byte_1_high), simd::high_nibbles(prev1)),
+                                         simd::lookup(table(byte_1_low), simd::and_(prev1, simd::set1(0x0F)))),
+                              simd::lookup(table(byte_2_high), simd::high_nibbles(input)));
+        }
+
+        // the 3rd and the 4th bytes of the chars are the ones that two_conts is fine for
+        static vec multibyte_lengths(vec input, vec prev_input, vec special) noexcept {
+            auto const third  = simd::subs_u8(simd::prev<2>(input, prev_input), simd::set1(0xE0 - 0x80));
+            auto const fourth = simd::subs_u8(simd::prev<3>(input, prev_input), simd::set1(0xF0 - 0x80));
+            return simd::xor_(simd::and_(simd::or_(third, fourth), simd::set1(0x80)), special);
+        }
+
+        static bool validate_vectors(stl::string_view str) noexcept {
+            vec         error      = simd::zero();
+            vec         prev_input = simd::zero();
+            vec         incomplete = simd::zero(); // the unfinished char at the end of the previous block
+            stl::size_t pos        = 0;
+
+            auto const check = [&](vec input) noexcept {
+                if (simd::is_ascii(input)) {
+                    error = simd::or_(error, incomplete);
+                    incomplete = simd::zero();
+                } else {
+                    auto const prev1 = simd::prev<1>(input, prev_input);
+                    error = simd::or_(error, multibyte_lengths(input, prev_input, special_cases(input, prev1)));
+                    incomplete = simd::subs_u8(input, simd::max_values());
+                }
+                prev_input = input;
+            };
+
+            for (; pos + simd::width <= str.size(); pos += simd::width)
+                check(simd::load(str.data() + pos));
+
+            // the rest is padded with the ASCII zeros, so an unfinished char is too short
+            char last[simd::width]{};
+            for (stl::size_t i = 0; pos + i < str.size(); i++)
+                last[i] = str[pos + i];
+            check(simd::load(last));
+            return simd::is_zero(simd::or_(error, incomplete));
+        }
+#endif
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_UTILS_UTF8_H
@@ -1,57 +1,331 @@
 #ifndef EMAIL_H
 #define EMAIL_H
 
-#include <regex>
-#include <string>
-#include <vector>
+#include "../std/std.hpp"
+#include "../std/string_view.hpp"
+#include "../utils/strings.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
 
 namespace webpp {
 
+    namespace details {
+
+        /**
+         * A DFA of the email addresses that the signup forms take; a subset of
+         * RFC 5322: the local part is a dot-atom (the atext chars and the dots
+         * between them), and the domain is the labels of the letters, the
+         * digits and the hyphens (not at the start or the end of a label), with
+         * a top level domain of 2 or more letters. The quoted local parts, the
+         * comments and the IP literals are not valid.
+         *
+         * These are the transitions of the char classes, which email_dfa
+         * makes its table of.
+         */
+        struct email_rules {
+            enum state : stl::uint8_t {
+                start,
+                local,        // in an atom of the local part
+                local_dot,    // after a dot of the local part
+                at,           // after the @
+                first_label,  // in the first label, after a letter or digit
+                first_hyphen, // in the first label, after a hyphen
+                dot,          // after a dot of the domain
+                alpha,        // in a label of letters, after one of them
+                tld,          // in a label of 2 or more letters
+                label,        // in a label with a digit or a hyphen
+                label_hyphen, // in a label, after a hyphen
+                error,
+                state_count
+            };
+
+            enum char_class : stl::uint8_t {
+                letter,
+                digit,
+                hyphen,
+                dot_char,
+                at_char,
+                atext, // the other chars of the local parts, like +_!#$
+                other,
+                none // not a char; it keeps the state
+            };
+
+            [[nodiscard]] static constexpr char_class
+            class_of(unsigned char c) noexcept {
+                if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+                    return letter;
+                if (c >= '0' && c <= '9')
+                    return digit;
+                switch (c) {
+                    case '-': return hyphen;
+                    case '.': return dot_char;
+                    case '@': return at_char;
+                    case '!':
+                    case '#':
+                    case '$':
+                    case '%':
+                    case '&':
+                    case '\'':
+                    case '*':
+                    case '+':
+                    case '/':
+                    case '=':
+                    case '?':
+                    case '^':
+                    case '_':
+                    case '`':
+                    case '{':
+                    case '|':
+                    case '}':
+                    case '~': return atext;
+                    default: return other;
+                }
+            }
+
+            [[nodiscard]] static constexpr state next(state      s,
+                                                      char_class c) noexcept {
+                bool const alnum = c == letter || c == digit;
+                bool const atom  = alnum || c == hyphen || c == atext;
+                if (c == none)
+                    return s;
+                switch (s) {
+                    case start:
+                    case local_dot: return atom ? local : error;
+                    case local:
+                        if (atom)
+                            return local;
+                        if (c == dot_char)
+                            return local_dot;
+                        return c == at_char ? at : error;
+                    case at: return alnum ? first_label : error;
+                    case first_label:
+                        if (alnum)
+                            return first_label;
+                        if (c == hyphen)
+                            return first_hyphen;
+                        return c == dot_char ? dot : error;
+                    case first_hyphen:
+                        if (alnum)
+                            return first_label;
+                        return c == hyphen ? first_hyphen : error;
+                    case dot:
+                        if (c == letter)
+                            return alpha;
+                        return c == digit ? label : error;
+                    case alpha:
+                    case tld:
+                        if (c == letter)
+                            return tld;
+                        [[fallthrough]];
+                    case label:
+                        if (alnum)
+                            return label;
+                        if (c == hyphen)
+                            return label_hyphen;
+                        return c == dot_char ? dot : error;
+                    case label_hyphen:
+                        if (alnum)
+                            return label;
+                        return c == hyphen ? label_hyphen : error;
+                    default: return error;
+                }
+            }
+        };
+
+        /**
+         * The tables are generated at compile time from the email_rules. The
+         * table has the state after 3 chars, for every state and 3 classes, so
+         * it takes one load for 3 chars: the class lookups don't wait for the
+         * state, only the last load does. The states are the offsets of their
+         * rows; the 1 or 2 chars at the end come after the "none" classes.
+         */
+        struct email_dfa : email_rules {
+            static constexpr stl::size_t max_size       = 254;
+            static constexpr stl::size_t max_local_size = 64;
+            static constexpr stl::size_t class_bits     = 3;
+            static constexpr stl::size_t class_mask = (1u << class_bits) - 1;
+            static constexpr stl::size_t row        = 1u << (class_bits * 3);
+
+            static constexpr auto classes = [] {
+                stl::array<stl::uint8_t, 256> res{};
+                for (stl::size_t c = 0; c < 256; c++)
+                    res[c] = class_of(static_cast<unsigned char>(c));
+                return res;
+            }();
+
+            static constexpr auto table = [] {
+                stl::array<stl::uint16_t, state_count * row> res{};
+                for (stl::size_t s = 0; s < state_count; s++) {
+                    for (stl::size_t k = 0; k < row; k++) {
+                        auto after = static_cast<state>(s);
+                        for (stl::size_t shift = class_bits * 3; shift != 0;) {
+                            shift -= class_bits;
+                            after = next(after, static_cast<char_class>(
+                                                  k >> shift & class_mask));
+                        }
+                        res[s * row + k] =
+                          static_cast<stl::uint16_t>(after * row);
+                    }
+                }
+                return res;
+            }();
+
+            [[nodiscard]] static constexpr stl::size_t cls(char c) noexcept {
+                return classes[static_cast<unsigned char>(c)];
+            }
+
+            /**
+             * The state after the 3 classes
+             */
+            [[nodiscard]] static constexpr stl::uint16_t
+            step(stl::uint16_t s,
+                 stl::size_t   first,
+                 stl::size_t   second,
+                 stl::size_t   third) noexcept {
+                return table[s + (first << (class_bits * 2) |
+                                  second << class_bits | third)];
+            }
+
+            [[nodiscard]] static constexpr stl::uint16_t
+            run(stl::string_view str, stl::uint16_t s = start) noexcept {
+                auto const* it  = str.data();
+                auto const* end = it + str.size();
+                for (; end - it >= 3; it += 3)
+                    s = step(s, cls(it[0]), cls(it[1]), cls(it[2]));
+                if (end - it == 2)
+                    return step(s, none, cls(it[0]), cls(it[1]));
+                if (end - it == 1)
+                    return step(s, none, none, cls(it[0]));
+                return s;
+            }
+
+            /**
+             * Is the state at the end of the string valid; the lengths are
+             * checked here, since the DFA doesn't count.
+             */
+            [[nodiscard]] static constexpr bool
+            accepts(stl::string_view str, stl::uint16_t s) noexcept {
+                return s == tld * row && str.size() <= max_size &&
+                       str.find('@') <= max_local_size;
+            }
+        };
+
+    } // namespace details
+
+    namespace is {
+
+        /**
+         * Check all the emails at once, for the bulk signup imports: the bit
+         * i % 64 of invalid[i / 64] is set if strs[i] is not valid (see
+         * details::email_dfa). There's nothing between the DFA runs, so the
+         * CPU overlaps the runs of the next few of them.
+         *
+         * The invalid should have room for (strs.size() + 63) / 64 words.
+         * @returns the number of the strings that are not valid
+         */
+        inline stl::size_t emails(stl::span<stl::string_view const> strs,
+                                  stl::span<stl::uint64_t> invalid) noexcept {
+            using dfa         = details::email_dfa;
+            stl::size_t count = 0;
+            for (stl::size_t first = 0; first < strs.size(); first += 64) {
+                auto const last =
+                  stl::min<stl::size_t>(strs.size(), first + 64);
+                stl::uint64_t bits = 0;
+                for (stl::size_t i = first; i < last; i++) {
+                    bool const bad =
+                      !dfa::accepts(strs[i], dfa::run(strs[i]));
+                    bits |= stl::uint64_t{bad} << (i - first);
+                }
+                invalid[first / 64] = bits;
+                count += static_cast<stl::size_t>(stl::popcount(bits));
+            }
+            return count;
+        }
+
+    } // namespace is
+
+    /**
+     * An email address (a view into it) and its parts
+     */
     class email {
       private:
-        std::string username;
-        std::string domain;
+        stl::string_view mail;
+        stl::size_t      at = stl::string_view::npos;
 
       public:
-        email(std::string mail);
+        constexpr explicit email(stl::string_view str) noexcept : mail{str} {
+            using dfa = details::email_dfa;
+            if (dfa::accepts(str, dfa::run(str)))
+                at = str.find('@');
+        }
 
         /**
          * @brief checks if the specified email has a valid syntax or not
          * @return true if it does
          */
-        bool has_valid_syntax() const noexcept;
+        [[nodiscard]] constexpr bool has_valid_syntax() const noexcept {
+            return at != stl::string_view::npos;
+        }
+
+        /**
+         * The part before the @; empty if it's not valid
+         */
+        [[nodiscard]] constexpr stl::string_view username() const noexcept {
+            return has_valid_syntax() ? mail.substr(0, at)
+                                      : stl::string_view{};
+        }
 
         /**
-         * @brief clear the email from unwanted characters
-         * @return cleaned up email address
+         * The part after the @; empty if it's not valid
          */
-        std::string clear(std::string const& second) noexcept;
+        [[nodiscard]] constexpr stl::string_view domain() const noexcept {
+            return has_valid_syntax() ? mail.substr(at + 1)
+                                      : stl::string_view{};
+        }
 
         /**
-         * @brief checks if the specified emails are equal
-         * @param mail
-         * @return
+         * @brief checks if the specified emails are equal; the domains are
+         * compared case-insensitively, the usernames are not.
          */
-        bool is_equal(std::string const& second) const noexcept;
+        [[nodiscard]] constexpr bool
+        is_equal(email const& second) const noexcept {
+            return has_valid_syntax() && second.has_valid_syntax() &&
+                   username() == second.username() &&
+                   domain().size() == second.domain().size() &&
+                   ascii_iequals(domain(), second.domain());
+        }
 
         /**
-         * @brief check if the email provider is in the black list
-         * @return
+         * @brief check if the email provider is in the block list of the
+         * database (an email_database, see email_providers.hpp)
          */
-        bool is_blocked() const noexcept;
+        template <typename Database>
+        [[nodiscard]] bool
+        is_blocked(Database const& providers) const noexcept {
+            return has_valid_syntax() && providers.is_blocked(domain());
+        }
 
         /**
-         * @brief returns other email domains of the same email providers that
-         * are in the database
-         * @return a series of domain names in a vector
+         * @brief the other domains of the same email provider that are in the
+         * database, like googlemail.com for gmail.com
          */
-        std::vector<std::string> alternative_domains() const;
+        template <typename Database>
+        [[nodiscard]] auto
+        alternative_domains(Database const& providers) const {
+            return providers.alternative_domains(domain());
+        }
 
         /**
-         * @brief returns the value in string
-         * @return string representation of the email address
+         * @brief the email address as it was given
          */
-        std::string to_string() const noexcept;
+        [[nodiscard]] constexpr stl::string_view to_string() const noexcept {
+            return mail;
+        }
     };
 
 } // namespace webpp
@@ -0,0 +1,536 @@
+#ifndef WEBPP_VALIDATORS_EMAIL_PROVIDERS_H
+#define WEBPP_VALIDATORS_EMAIL_PROVIDERS_H
+
+#include "../std/std.hpp"
+#include "../std/string_view.hpp"
+#include "../utils/strings.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace webpp {
+
+    /**
+     * What the providers of the domains of the database are
+     */
+    enum struct email_provider_kind : stl::uint8_t {
+        free    = 1, // like gmail.com; the users can sign up with them
+        blocked = 2  // the disposable ones; the signups are refused
+    };
+
+    namespace details {
+
+        /**
+         * The layout of the email provider database files that
+         * email_database_builder writes (and "webpp update" makes); all the
+         * numbers are 32bit, in the byte order of the machine that wrote it:
+         *
+         *   header:  magic, byte order, domain count, bucket count,
+         *            slot count, names size, reserved
+         *   entries: 12 bytes per domain: the offset of the name, the first
+         *            domain of its provider, the domain count of the
+         *            provider (16bit), the name size and the kind (8bit).
+         *            The domains of a provider are next to each other, and
+         *            sorted by their names.
+         *   seeds:   the seed of each bucket of the perfect hash
+         *   slots:   the entry + 1 of each slot; 0 is empty
+         *   names:   the domains, in lower case
+         */
+        struct email_database_layout {
+            static constexpr stl::string_view magic{"WPPEMDB1", 8};
+            static constexpr stl::uint32_t    byte_order  = 0x0102'0304u;
+            static constexpr stl::size_t      header_size = 32;
+            static constexpr stl::size_t      entry_size  = 12;
+            static constexpr stl::size_t      max_name    = 255;
+            static constexpr stl::size_t      max_domains = 0xFFFFu;
+
+            [[nodiscard]] static stl::uint32_t load32(char const* ptr) noexcept {
+                stl::uint32_t value;
+                stl::memcpy(&value, ptr, sizeof(value));
+                return value;
+            }
+
+            [[nodiscard]] static stl::uint64_t hash(stl::string_view domain) noexcept {
+                return static_cast<stl::uint64_t>(ascii_ihash(domain));
+            }
+
+            [[nodiscard]] static stl::size_t bucket_of(stl::uint64_t hash,
+                                                       stl::size_t   buckets) noexcept {
+                return static_cast<stl::size_t>((hash >> 32u) % buckets);
+            }
+
+            [[nodiscard]] static stl::size_t slot_of(stl::uint64_t hash,
+                                                     stl::uint32_t seed,
+                                                     stl::size_t   slots) noexcept {
+                hash ^= seed * 0x9E37'79B9'7F4A'7C15ull;
+                hash ^= hash >> 33u;
+                hash *= 0xFF51'AFD7'ED55'8CCDull;
+                hash ^= hash >> 33u;
+                return static_cast<stl::size_t>(hash & (slots - 1));
+            }
+        };
+
+    } // namespace details
+
+    /**
+     * A view of an email provider database (see details::email_database_layout);
+     * finding a domain is one hash, two loads and one comparison, and there's
+     * nothing to parse: the views of a file that mapped_email_database maps
+     * are ready as soon as it's mapped.
+     *
+     * The bytes that are not a valid database make an empty one.
+     */
+    class email_database {
+        using layout = details::email_database_layout;
+
+        stl::string_view names{};
+        char const*      entries      = nullptr;
+        char const*      seeds        = nullptr;
+        char const*      slots        = nullptr;
+        stl::size_t      count        = 0;
+        stl::size_t      bucket_count = 1;
+        stl::size_t      slot_count   = 1;
+        bool             valid        = false;
+
+        [[nodiscard]] char const* entry(stl::size_t index) const noexcept {
+            return entries + index * layout::entry_size;
+        }
+
+      public:
+        static constexpr stl::size_t npos = stl::string_view::npos;
+
+        email_database() noexcept = default;
+
+        explicit email_database(stl::string_view bytes) noexcept {
+            if (bytes.size() < layout::header_size || bytes.substr(0, layout::magic.size()) != layout::magic)
+                return;
+            auto const* const data = bytes.data();
+            auto const        field = [data](stl::size_t index) noexcept -> stl::size_t {
+                return layout::load32(data + 8 + index * 4);
+            };
+            if (field(0) != layout::byte_order)
+                return;
+            auto const domains    = field(1);
+            auto const buckets    = field(2);
+            auto const table_size = field(3);
+            auto const names_size = field(4);
+            auto const expected_size =
+              layout::header_size + domains * layout::entry_size + (buckets + table_size) * 4 + names_size;
+            if (buckets == 0 || !stl::has_single_bit(table_size) || table_size < domains ||
+                domains > layout::max_domains || bytes.size() != expected_size)
+                return;
+            entries      = data + layout::header_size;
+            seeds        = entries + domains * layout::entry_size;
+            slots        = seeds + buckets * 4;
+            names        = bytes.substr(bytes.size() - names_size);
+            count        = domains;
+            bucket_count = buckets;
+            slot_count   = table_size;
+            valid        = true;
+        }
+
+        /**
+         * Is it a database; the bytes that are not are an empty one
+         */
+        [[nodiscard]] bool is_valid() const noexcept {
+            return valid;
+        }
+
+        /**
+         * The index of the domain (case-insensitive); npos if it's not in it
+         */
+        [[nodiscard]] stl::size_t find(stl::string_view domain) const noexcept {
+            if (count == 0)
+                return npos;
+            auto const hash = layout::hash(domain);
+            auto const seed = layout::load32(seeds + layout::bucket_of(hash, bucket_count) * 4);
+            auto const slot = layout::load32(slots + layout::slot_of(hash, seed, slot_count) * 4);
+            if (slot == 0 || slot > count || !ascii_iequals(this->domain(slot - 1), domain))
+                return npos;
+            return slot - 1;
+        }
+
+        [[nodiscard]] bool contains(stl::string_view domain) const noexcept {
+            return find(domain) != npos;
+        }
+
+        /**
+         * The domain at the index, in lower case
+         */
+        [[nodiscard]] stl::string_view domain(stl::size_t index) const noexcept {
+            if (index >= count)
+                return {};
+            auto const* const ptr    = entry(index);
+            stl::size_t const offset = layout::load32(ptr);
+            auto const        size   = static_cast<unsigned char>(ptr[10]);
+            if (offset > names.size() || size > names.size() - offset)
+                return {};
+            return names.substr(offset, size);
+        }
+
+        [[nodiscard]] email_provider_kind kind(stl::size_t index) const noexcept {
+            return static_cast<email_provider_kind>(entry(index)[11]);
+        }
+
+        /**
+         * Is the domain of a provider that's blocked
+         */
+        [[nodiscard]] bool is_blocked(stl::string_view domain) const noexcept {
+            auto const index = find(domain);
+            return index != npos && kind(index) == email_provider_kind::blocked;
+        }
+
+        /**
+         * The other domains of the provider of this domain, like googlemail.com
+         * for gmail.com; the views are into the database.
+         */
+        [[nodiscard]] stl::vector<stl::string_view> alternative_domains(stl::string_view domain) const {
+            stl::vector<stl::string_view> res;
+            auto const                    index = find(domain);
+            if (index == npos)
+                return res;
+            auto const* const ptr = entry(index);
+            stl::uint16_t     provider_size;
+            stl::memcpy(&provider_size, ptr + 8, sizeof(provider_size));
+            stl::size_t const first = layout::load32(ptr + 4);
+            stl::size_t const last  = stl::min(count, first + provider_size);
+            for (stl::size_t i = first; i < last; i++)
+                if (i != index)
+                    res.push_back(this->domain(i));
+            return res;
+        }
+
+        /**
+         * The number of the domains
+         */
+        [[nodiscard]] stl::size_t size() const noexcept {
+            return count;
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return count == 0;
+        }
+    };
+
+    /**
+     * An email provider database file, mapped read-only; the worker processes
+     * that map the same file share its pages, and it's not read until it's
+     * used. Replace the file with a rename (like email_database_builder does),
+     * so the processes that have it mapped keep the old one.
+     */
+    class mapped_email_database {
+        void*          address = nullptr;
+        stl::size_t    length  = 0;
+        email_database view{};
+
+        void unmap() noexcept {
+            if (address != nullptr)
+                ::munmap(address, length);
+            address = nullptr;
+            length  = 0;
+            view    = email_database{};
+        }
+
+      public:
+        mapped_email_database() noexcept = default;
+
+        explicit mapped_email_database(stl::filesystem::path const& path) noexcept {
+            open(path);
+        }
+
+        mapped_email_database(mapped_email_database const&)            = delete;
+        mapped_email_database& operator=(mapped_email_database const&) = delete;
+
+        mapped_email_database(mapped_email_database&& other) noexcept
+          : address{stl::exchange(other.address, nullptr)},
+            length{stl::exchange(other.length, 0)},
+            view{stl::exchange(other.view, email_database{})} {}
+
+        mapped_email_database& operator=(mapped_email_database&& other) noexcept {
+            if (this != &other) {
+                unmap();
+                address = stl::exchange(other.address, nullptr);
+                length  = stl::exchange(other.length, 0);
+                view    = stl::exchange(other.view, email_database{});
+            }
+            return *this;
+        }
+
+        ~mapped_email_database() noexcept {
+            unmap();
+        }
+
+        /**
+         * Map the file (and unmap the one that was mapped)
+         * @returns false if it can't be mapped, or it's not a valid database
+         */
+        bool open(stl::filesystem::path const& path) noexcept {
+            unmap();
+            int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd == -1)
+                return false;
+            struct stat info {};
+            if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+                ::close(fd);
+                return false;
+            }
+            auto const size = static_cast<stl::size_t>(info.st_size);
+            void* const ptr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd); // the mapping keeps the file
+            if (ptr == MAP_FAILED)
+                return false;
+            address = ptr;
+            length  = size;
+            view    = email_database{stl::string_view{static_cast<char const*>(ptr), size}};
+            if (!view.is_valid()) {
+                unmap();
+                return false;
+            }
+            return true;
+        }
+
+        [[nodiscard]] bool is_open() const noexcept {
+            return address != nullptr;
+        }
+
+        [[nodiscard]] email_database const& database() const noexcept {
+            return view;
+        }
+
+        email_database const* operator->() const noexcept {
+            return &view;
+        }
+    };
+
+    /**
+     * Makes the email provider databases; the updater of the SDK makes them out
+     * of a list like this, a provider on each line:
+     *
+     *   # the kind, and the domains of the provider
+     *   free    gmail.com googlemail.com
+     *   blocked mailinator.com mailinator.net
+     */
+    class email_database_builder {
+        using layout = details::email_database_layout;
+
+        struct domain_entry {
+            stl::string         name;
+            stl::uint32_t       provider;
+            email_provider_kind kind;
+        };
+
+        stl::vector<domain_entry>       domains;
+        stl::unordered_set<stl::string> known;
+        stl::uint32_t                   providers = 0;
+
+      public:
+        /**
+         * Add the domains of a provider
+         * @returns false if any of them is not valid, or it's been added
+         * before; the other ones are added anyway.
+         */
+        bool add(email_provider_kind kind, stl::span<stl::string_view const> names) {
+            bool valid = true;
+            for (auto const name : names) {
+                if (name.empty() || name.size() > layout::max_name ||
+                    domains.size() == layout::max_domains) {
+                    valid = false;
+                    continue;
+                }
+                stl::string lower{name};
+                ascii_to_lower(lower.data(), lower.size());
+                if (!known.insert(lower).second) {
+                    valid = false;
+                    continue;
+                }
+                domains.push_back(domain_entry{stl::move(lower), providers, kind});
+            }
+            providers++;
+            return valid;
+        }
+
+        /**
+         * Add the providers of the list (see above); the empty lines and the
+         * "#" comments are skipped.
+         * @returns false if any of the lines is not valid
+         */
+        bool load(stl::string_view text) {
+            constexpr stl::string_view blanks = " \t\r";
+            bool                       valid  = true;
+            stl::vector<stl::string_view> names;
+            while (!text.empty()) {
+                auto const eol  = text.find('\n');
+                auto       line = text.substr(0, eol);
+                text.remove_prefix(eol == stl::string_view::npos ? text.size() : eol + 1);
+                line = line.substr(0, line.find('#'));
+
+                names.clear();
+                for (;;) {
+                    auto const start = line.find_first_not_of(blanks);
+                    if (start == stl::string_view::npos)
+                        break;
+                    line.remove_prefix(start);
+                    auto const end = line.find_first_of(blanks);
+                    names.push_back(line.substr(0, end));
+                    line.remove_prefix(end == stl::string_view::npos ? line.size() : end);
+                }
+                if (names.empty())
+                    continue;
+                if (names.size() == 1 || (names[0] != "free" && names[0] != "blocked")) {
+                    valid = false;
+                    continue;
+                }
+                auto const kind =
+                  names[0] == "free" ? email_provider_kind::free : email_provider_kind::blocked;
+                if (!add(kind, stl::span{names}.subspan(1)))
+                    valid = false;
+            }
+            return valid;
+        }
+
+        [[nodiscard]] stl::size_t size() const noexcept {
+            return domains.size();
+        }
+
+        /**
+         * The bytes of the database
+         */
+        [[nodiscard]] stl::string build() const {
+            // the domains of each provider next to each other
+            stl::vector<domain_entry const*> sorted;
+            sorted.reserve(domains.size());
+            for (auto const& domain : domains)
+                sorted.push_back(&domain);
+            stl::sort(sorted.begin(), sorted.end(), [](auto const* a, auto const* b) {
+                return a->provider != b->provider ? a->provider < b->provider
+                                                  : a->name < b->name;
+            });
+
+            auto const count   = sorted.size();
+            auto const buckets = stl::max<stl::size_t>(1, count / 4);
+            auto const table   = stl::bit_ceil(stl::max<stl::size_t>(2, count * 2));
+
+            // hash and displace, the big buckets first (see embedded_asset_index)
+            stl::vector<stl::uint64_t>            hashes(count);
+            stl::vector<stl::vector<stl::size_t>> members(buckets);
+            for (stl::size_t i = 0; i < count; i++) {
+                hashes[i] = layout::hash(sorted[i]->name);
+                members[layout::bucket_of(hashes[i], buckets)].push_back(i);
+            }
+            stl::vector<stl::size_t> order(buckets);
+            for (stl::size_t i = 0; i < buckets; i++)
+                order[i] = i;
+            stl::stable_sort(order.begin(), order.end(), [&](auto a, auto b) {
+                return members[a].size() > members[b].size();
+            });
+            stl::vector<stl::uint32_t> seeds(buckets);
+            stl::vector<stl::uint32_t> slots(table);
+            stl::vector<stl::size_t>   taken;
+            for (auto const bucket : order) {
+                for (stl::uint32_t seed = 1;; seed++) {
+                    taken.clear();
+                    for (auto const i : members[bucket]) {
+                        auto const slot = layout::slot_of(hashes[i], seed, table);
+                        if (slots[slot] != 0 ||
+                            stl::find(taken.begin(), taken.end(), slot) != taken.end())
+                            break;
+                        taken.push_back(slot);
+                    }
+                    if (taken.size() == members[bucket].size()) {
+                        seeds[bucket] = seed;
+                        for (stl::size_t j = 0; j < taken.size(); j++)
+                            slots[taken[j]] = static_cast<stl::uint32_t>(members[bucket][j] + 1);
+                        break;
+                    }
+                }
+            }
+
+            stl::string names;
+            stl::string res;
+            auto const  put32 = [&res](stl::size_t value) {
+                auto const word = static_cast<stl::uint32_t>(value);
+                res.append(reinterpret_cast<char const*>(&word), sizeof(word));
+            };
+            res.append(layout::magic);
+            put32(layout::byte_order);
+            put32(count);
+            put32(buckets);
+            put32(table);
+            for (auto const* domain : sorted)
+                names += domain->name;
+            put32(names.size());
+            put32(0);
+
+            stl::size_t offset = 0;
+            for (stl::size_t i = 0, first = 0; i < count; i++) {
+                if (i != 0 && sorted[i]->provider != sorted[i - 1]->provider)
+                    first = i;
+                auto last = first;
+                while (last < count && sorted[last]->provider == sorted[i]->provider)
+                    last++;
+                auto const provider_size = static_cast<stl::uint16_t>(last - first);
+                put32(offset);
+                put32(first);
+                res.append(reinterpret_cast<char const*>(&provider_size), sizeof(provider_size));
+                res.push_back(static_cast<char>(sorted[i]->name.size()));
+                res.push_back(static_cast<char>(sorted[i]->kind));
+                offset += sorted[i]->name.size();
+            }
+            for (auto const seed : seeds)
+                put32(seed);
+            for (auto const slot : slots)
+                put32(slot);
+            res += names;
+            return res;
+        }
+
+        /**
+         * Write the database into a temporary file next to the path, and
+         * rename it to the path; the processes that have mapped the old one
+         * keep it, and the new ones map the new one.
+         * @returns false if it can't be written
+         */
+        bool write_file(stl::filesystem::path const& path) const {
+            auto const bytes = build();
+            auto       temp  = path;
+            temp += ".tmp";
+            int const fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd == -1)
+                return false;
+            for (stl::size_t written = 0; written < bytes.size();) {
+                auto const res = ::write(fd, bytes.data() + written, bytes.size() - written);
+                if (res < 0 && errno == EINTR)
+                    continue;
+                if (res < 0) {
+                    ::close(fd);
+                    ::unlink(temp.c_str());
+                    return false;
+                }
+                written += static_cast<stl::size_t>(res);
+            }
+            bool const synced = ::fsync(fd) == 0;
+            if (::close(fd) != 0 || !synced || ::rename(temp.c_str(), path.c_str()) != 0) {
+                ::unlink(temp.c_str());
+                return false;
+            }
+            return true;
+        }
+    };
+
+} // namespace webpp
+
+#endif // WEBPP_VALIDATORS_EMAIL_PROVIDERS_H
@@ -5,12 +5,60 @@
 #include "../utils/casts.hpp"
 #include "../utils/charset.hpp"
 #include "../utils/strings.hpp"
+#include "../utils/utf8.hpp"
+#include "./email.hpp"
 
 #include <algorithm>
-#include <regex>
+#include <cstdint>
 
 namespace webpp {
 
+    namespace details {
+
+        /**
+         * The 0x80 bit of each byte of the word that's between the first and
+         * the last (ASCII) chars
+         */
+        [[nodiscard]] constexpr stl::uint64_t
+        bytes_in_range(stl::uint64_t word, char first, char last) noexcept {
+            auto const heptets = word & (0x7Fu * byte_ones);
+            auto const from_first =
+              heptets + static_cast<stl::uint64_t>(0x80 - first) * byte_ones;
+            auto const after_last =
+              heptets + static_cast<stl::uint64_t>(0x80 - last - 1) * byte_ones;
+            return from_first & ~after_last & ~word & (0x80u * byte_ones);
+        }
+
+        [[nodiscard]] constexpr bool is_eight_hex(stl::uint64_t word) noexcept {
+            auto const letters = word | (0x20u * byte_ones); // lower case
+            return (bytes_in_range(word, '0', '9') |
+                    bytes_in_range(letters, 'a', 'f')) == 0x80u * byte_ones;
+        }
+
+        /**
+         * Check all the chars of the string 8 at a time with the word check;
+         * the last few chars are checked in one word after enough '0's, so
+         * no char is checked twice.
+         */
+        template <typename WordCheck>
+        [[nodiscard]] constexpr bool
+        all_words(stl::string_view str, WordCheck&& check) noexcept {
+            auto const padded = [&](stl::size_t pos) constexpr {
+                auto const rest = str.size() - pos;
+                return load_word(str.data() + pos, rest) |
+                       (zero_chars & ~stl::uint64_t{0} << (8u * rest));
+            };
+            if (str.size() < 8) // the most of them
+                return check(padded(0));
+            stl::size_t pos = 0;
+            for (; pos + 8 <= str.size(); pos += 8)
+                if (!check(load_word(str.data() + pos, 8)))
+                    return false;
+            return pos == str.size() || check(padded(pos));
+        }
+
+    } // namespace details
+
     namespace is {
 
         /**
@@ -137,6 +185,11 @@ namespace webpp {
                   typename CharTraitsType = stl::char_traits<CharT>>
         [[nodiscard]] constexpr bool digit(
           stl::basic_string_view<CharT, CharTraitsType> const& str) noexcept {
+            if constexpr (stl::is_same_v<CharT, char>) {
+                return !str.empty() &&
+                       details::all_words({str.data(), str.size()},
+                                          details::is_eight_digits);
+            }
             for (auto c : str)
                 if (!digit<CharT>(c))
                     return false;
@@ -163,6 +216,22 @@ namespace webpp {
         template <typename CharT = char>
         requires(stl::is_integral_v<CharT>) [[nodiscard]] constexpr bool number(
           stl::basic_string_view<CharT> const& str) noexcept {
+            if constexpr (stl::is_same_v<CharT, char>) {
+                // the digits, and one dot anywhere
+                bool       has_dot  = false;
+                auto const is_digit = [&has_dot](stl::uint64_t word) constexpr {
+                    auto const dots = details::bytes_in_range(word, '.', '.');
+                    if (dots) {
+                        if (has_dot || (dots & (dots - 1)))
+                            return false; // the second one
+                        has_dot = true;
+                    }
+                    return (details::bytes_in_range(word, '0', '9') | dots) ==
+                           0x80u * details::byte_ones;
+                };
+                return !str.empty() &&
+                       details::all_words({str.data(), str.size()}, is_digit);
+            }
             bool is_first = true;
             for (auto const& c : str) {
                 if (!digit<CharT>(c)) {
@@ -258,6 +327,14 @@ namespace webpp {
                    to_uint(str) <= 255;
         }
 
+        /**
+         * Check if the string is well-formed UTF-8; the paths, the queries,
+         * and the JSON texts should be (see utf8_validator).
+         */
+        [[nodiscard]] constexpr bool utf8(stl::string_view str) noexcept {
+            return utf8_validator::validate(str);
+        }
+
         /**
          * Check if the char is a hexadecimal character
          * @param char
@@ -265,8 +342,7 @@ namespace webpp {
          */
         template <typename CharT = char>
         [[nodiscard]] constexpr bool hex(CharT const& t) noexcept {
-            return (t >= '0' && t <= '9') || (t >= 'a' && t <= 'f') ||
-                   (t >= 'A' && t <= 'F');
+            return HEXDIG<CharT>.contains(t);
         }
 
         /**
@@ -278,6 +354,10 @@ namespace webpp {
         template <typename CharT = char>
         [[nodiscard]] constexpr bool
         hex(stl::basic_string_view<CharT> const& str) noexcept {
+            if constexpr (stl::is_same_v<CharT, char>) {
+                return !str.empty() &&
+                       details::all_words(str, details::is_eight_hex);
+            }
             for (auto const& c : str)
                 if (!hex(c))
                     return false;
@@ -290,13 +370,10 @@ namespace webpp {
          * @return true if the specified str is an email
          */
         template <Traits TraitsType>
-        [[nodiscard]] bool
+        [[nodiscard]] constexpr bool
         email(typename TraitsType::string_view_type const& str) noexcept {
-            // TODO: Do not use regular expression, it's slow; use CTRE
-            static const stl::regex pattern{
-              "^[_A-Za-z0-9-\\+]+(\\.[_A-Za-z0-9-]+)*@[A-Za-z0-9-]+(\\.[A-Za-"
-              "z0-9]+)*(\\.[A-Za-z]{2,})$"};
-            return stl::regex_match(stl::string(str), pattern);
+            using dfa = details::email_dfa;
+            return dfa::accepts(str, dfa::run(str));
         }
 
         template <typename CharT = char>
@@ -690,9 +767,6 @@ namespace webpp {
         rgb_color(stl::basic_string_view<CharT> sstr) noexcept {
             // TODO: there are better ways to do it, check performance
 
-            constexpr stl::initializer_list<CharT const*> numbers =
-              "0123456789";
-
             trim(sstr);
             if (!starts_with<CharT>(sstr, "rgb(") ||
                 !starts_with<CharT>(sstr, "RGB("))
@@ -700,7 +774,7 @@ namespace webpp {
             sstr.remove_prefix(4);
             sstr.remove_suffix(1);
             rtrim(sstr);
-            auto it = sstr.find_first_not_of(numbers);
+            auto it = DIGIT<CharT>.find_first_not_in(sstr);
             if (!is::uint8(sstr.substr(0, it)))
                 return false;
             sstr.remove_suffix(it);
@@ -709,7 +783,7 @@ namespace webpp {
                 return false;
             sstr.remove_prefix(1);
             ltrim(sstr);
-            it = sstr.find_first_not_of(numbers);
+            it = DIGIT<CharT>.find_first_not_in(sstr);
             if (!is::uint8(sstr.substr(0, it)))
                 return false;
             sstr.remove_prefix(it);
@@ -718,7 +792,7 @@ namespace webpp {
                 return false;
             sstr.remove_prefix(1);
             ltrim(sstr);
-            it = sstr.find_first_not_of(numbers);
+            it = DIGIT<CharT>.find_first_not_in(sstr);
             if (!is::uint8(sstr.substr(0, it)))
                 return false;
             sstr.remove_prefix(it);
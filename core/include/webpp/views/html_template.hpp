@@ -0,0 +1,323 @@
+#ifndef WEBPP_VIEWS_HTML_TEMPLATE_H
+#define WEBPP_VIEWS_HTML_TEMPLATE_H
+
+#include "../encoding/html.hpp"
+#include "../std/std.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * The HTML templates; they're compiled once (at compile time, or when the
+ * server starts) into a flat list of the literal slices and the variables,
+ * so a render is a few appends and the escaping of the variables:
+ *
+ *   {{ name }}      the value, escaped for HTML (text and quoted attributes)
+ *   {{{ name }}}    the value as it is, for the HTML that's already safe
+ *   {{! comment }}  nothing
+ *
+ * The variables are numbered (the slots) in the order that they first come
+ * in the template, and the values are given in that order:
+ *
+ *   static constexpr views::static_html_template<"<h1>{{title}}</h1>"> page;
+ *   page.render(res_body, {title});
+ */
+namespace webpp::views {
+
+    enum struct template_op : stl::uint8_t {
+        literal, // a slice of the template
+        escaped, // a variable
+        raw      // a variable that's not escaped
+    };
+
+    struct template_instruction {
+        template_op   op     = template_op::literal;
+        stl::uint16_t slot   = 0;
+        stl::uint32_t offset = 0; // the literal's position in the template
+        stl::uint32_t size   = 0;
+    };
+
+    namespace details {
+
+        [[nodiscard]] constexpr bool is_template_name_char(char c) noexcept {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' ||
+                   c == '-' || c == '.';
+        }
+
+        [[nodiscard]] constexpr stl::string_view trim_template_tag(stl::string_view str) noexcept {
+            while (!str.empty() && (str.front() == ' ' || str.front() == '\t' || str.front() == '\n'))
+                str.remove_prefix(1);
+            while (!str.empty() && (str.back() == ' ' || str.back() == '\t' || str.back() == '\n'))
+                str.remove_suffix(1);
+            return str;
+        }
+
+        /**
+         * Parse the template; on_literal(offset, size) and on_variable(name, raw)
+         * are called for its parts in order.
+         * @returns false if a tag is not closed, or a name is not valid
+         */
+        template <typename LiteralCallback, typename VariableCallback>
+        constexpr bool parse_template(stl::string_view source,
+                                      LiteralCallback&& on_literal,
+                                      VariableCallback&& on_variable) {
+            stl::size_t pos = 0;
+            while (pos < source.size()) {
+                auto const open = source.find("{{", pos);
+                if (open == stl::string_view::npos) {
+                    on_literal(pos, source.size() - pos);
+                    break;
+                }
+                if (open != pos)
+                    on_literal(pos, open - pos);
+
+                bool const raw   = source.substr(open).starts_with("{{{");
+                auto const close = source.find(raw ? "}}}" : "}}", open);
+                if (close == stl::string_view::npos)
+                    return false;
+                auto const start = open + (raw ? 3 : 2);
+                pos              = close + (raw ? 3 : 2);
+                auto const tag   = trim_template_tag(source.substr(start, close - start));
+                if (!raw && tag.starts_with('!'))
+                    continue; // a comment
+                if (tag.empty())
+                    return false;
+                for (auto const c : tag)
+                    if (!is_template_name_char(c))
+                        return false;
+                on_variable(tag, raw);
+            }
+            return true;
+        }
+
+        /**
+         * Compile the template into the instructions and the slot names;
+         * they're fixed-size arrays at compile time and vectors at runtime.
+         */
+        template <typename Instructions, typename Names>
+        constexpr bool compile_template(stl::string_view source, Instructions& instructions, Names& names) {
+            return parse_template(
+              source,
+              [&](stl::size_t offset, stl::size_t size) constexpr {
+                  instructions.push_back({.op     = template_op::literal,
+                                          .offset = static_cast<stl::uint32_t>(offset),
+                                          .size   = static_cast<stl::uint32_t>(size)});
+              },
+              [&](stl::string_view name, bool raw) constexpr {
+                  stl::size_t slot = 0;
+                  while (slot < names.size() && names[slot] != name)
+                      slot++;
+                  if (slot == names.size())
+                      names.push_back(name);
+                  instructions.push_back({.op   = raw ? template_op::raw : template_op::escaped,
+                                          .slot = static_cast<stl::uint16_t>(slot)});
+              });
+        }
+
+        /**
+         * A vector with its capacity known, for compiling at compile time
+         */
+        template <typename T, stl::size_t N>
+        struct fixed_vector {
+            stl::array<T, N> items{};
+            stl::size_t      count = 0;
+
+            constexpr void push_back(T const& item) noexcept {
+                items[count++] = item; // out of the range is a compile error
+            }
+
+            [[nodiscard]] constexpr stl::size_t size() const noexcept {
+                return count;
+            }
+
+            [[nodiscard]] constexpr T const& operator[](stl::size_t index) const noexcept {
+                return items[index];
+            }
+        };
+
+        /**
+         * Render the instructions; the values are in the order of the slots
+         */
+        template <typename StrT, typename Values>
+        constexpr void render_template(stl::string_view                       source,
+                                       stl::span<template_instruction const> instructions,
+                                       stl::size_t                           literal_size,
+                                       Values const&                         values,
+                                       StrT&                                 out) {
+            stl::size_t size = out.size() + literal_size;
+            for (auto const& value : values)
+                size += stl::string_view{value}.size();
+            out.reserve(size);
+            for (auto const& ins : instructions) {
+                switch (ins.op) {
+                    case template_op::literal: out.append(source.data() + ins.offset, ins.size); break;
+                    case template_op::escaped:
+                        encoding::escape_html(stl::string_view{values[ins.slot]}, out);
+                        break;
+                    case template_op::raw: {
+                        stl::string_view const value{values[ins.slot]};
+                        out.append(value.data(), value.size());
+                        break;
+                    }
+                }
+            }
+        }
+
+    } // namespace details
+
+    /**
+     * The template text as a template argument
+     */
+    template <stl::size_t N>
+    struct template_literal {
+        char chars[N]{};
+
+        constexpr template_literal(char const (&str)[N]) noexcept {
+            for (stl::size_t i = 0; i < N; i++)
+                chars[i] = str[i];
+        }
+
+        [[nodiscard]] constexpr stl::string_view view() const noexcept {
+            return {chars, N - 1};
+        }
+    };
+
+    /**
+     * A template that's compiled at compile time; the mistakes in it are
+     * compile errors, and the slots can be looked up at compile time too.
+     */
+    template <template_literal Source>
+    struct static_html_template {
+        static constexpr stl::string_view source = Source.view();
+
+      private:
+        struct compiled {
+            details::fixed_vector<template_instruction, Source.view().size() + 1> instructions{};
+            details::fixed_vector<stl::string_view, Source.view().size() / 4 + 1> names{};
+            bool                                                                   valid = false;
+        };
+
+        static constexpr compiled program = [] {
+            compiled res;
+            res.valid = details::compile_template(source, res.instructions, res.names);
+            return res;
+        }();
+
+        static_assert(program.valid, "The template is not valid; a tag is not closed, or a name is not valid.");
+
+      public:
+        static constexpr stl::size_t slot_count = program.names.size();
+
+        static constexpr stl::size_t literal_size = [] {
+            stl::size_t size = 0;
+            for (stl::size_t i = 0; i < program.instructions.size(); i++)
+                size += program.instructions[i].size;
+            return size;
+        }();
+
+        /**
+         * The slot of the variable; it's a compile error if it's not in the template
+         */
+        template <template_literal Name>
+        [[nodiscard]] static consteval stl::size_t slot() noexcept {
+            for (stl::size_t i = 0; i < slot_count; i++)
+                if (program.names[i] == Name.view())
+                    return i;
+            throw "There's no variable with this name in the template.";
+        }
+
+        [[nodiscard]] static constexpr stl::string_view name(stl::size_t slot) noexcept {
+            return program.names[slot];
+        }
+
+        /**
+         * Append the rendered template to the output; the values are in the
+         * order of the slots.
+         */
+        template <typename StrT>
+        static constexpr void render(StrT& out, stl::array<stl::string_view, slot_count> const& values) {
+            details::render_template(
+              source,
+              stl::span<template_instruction const>{program.instructions.items.data(), program.instructions.size()},
+              literal_size,
+              values,
+              out);
+        }
+    };
+
+    /**
+     * A template that's compiled when the server starts (from a file, or from
+     * the config); it has its own copy of the text.
+     */
+    class html_template {
+        stl::string                        text;
+        stl::vector<template_instruction> instructions;
+        stl::vector<stl::string>           names;
+        stl::size_t                        literal_size = 0;
+
+      public:
+        /**
+         * Compile the template; nullopt if a tag is not closed, or a name is not valid
+         */
+        [[nodiscard]] static stl::optional<html_template> compile(stl::string_view source) {
+            html_template                 res;
+            stl::vector<stl::string_view> names;
+            res.text = source;
+            if (!details::compile_template(res.text, res.instructions, names))
+                return stl::nullopt;
+            res.names.assign(names.begin(), names.end());
+            for (auto const& ins : res.instructions)
+                res.literal_size += ins.size;
+            return res;
+        }
+
+        [[nodiscard]] stl::size_t slot_count() const noexcept {
+            return names.size();
+        }
+
+        /**
+         * The slot of the variable; npos if it's not in the template
+         */
+        [[nodiscard]] stl::size_t slot(stl::string_view name) const noexcept {
+            for (stl::size_t i = 0; i < names.size(); i++)
+                if (names[i] == name)
+                    return i;
+            return stl::string_view::npos;
+        }
+
+        [[nodiscard]] stl::string_view name(stl::size_t slot) const noexcept {
+            return names[slot];
+        }
+
+        /**
+         * Append the rendered template to the output; the values are in the
+         * order of the slots, and the missing ones are empty.
+         */
+        template <typename StrT>
+        void render(StrT& out, stl::span<stl::string_view const> values) const {
+            if (values.size() >= names.size()) {
+                details::render_template(text, instructions, literal_size, values.first(names.size()), out);
+                return;
+            }
+            stl::vector<stl::string_view> all(names.size());
+            stl::copy(values.begin(), values.end(), all.begin());
+            details::render_template(text, instructions, literal_size, all, out);
+        }
+
+        template <typename StrT>
+        void render(StrT& out, stl::initializer_list<stl::string_view> values) const {
+            render(out, stl::span<stl::string_view const>{values.begin(), values.size()});
+        }
+    };
+
+} // namespace webpp::views
+
+#endif // WEBPP_VIEWS_HTML_TEMPLATE_H
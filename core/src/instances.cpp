@@ -0,0 +1,22 @@
+// The templates that almost every program instantiates with the default
+// traits are compiled here once, instead of in each of the translation
+// units that use them; the headers declare them "extern" when
+// WEBPP_EXTERN_TEMPLATES is defined.
+//
+// basic_uri and the request cookies are not here: some of their members
+// don't compile for std_traits yet, and an explicit instantiation compiles
+// all of them.
+
+#include "../include/webpp/http/cookies/cookie.hpp"
+#include "../include/webpp/traits/std_traits.hpp"
+#include "../include/webpp/utils/ipv4.hpp"
+#include "../include/webpp/utils/ipv6.hpp"
+
+namespace webpp {
+
+    template struct ipv4<std_traits>;
+    template class ipv6<std_traits>;
+    template struct basic_cookie_common<std_traits, true>;
+    template struct response_cookie<std_traits>;
+
+} // namespace webpp
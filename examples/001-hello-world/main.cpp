@@ -1,31 +1,24 @@
-#include <webpp/http/request>
-#include <webpp/http/response>
-#include <webpp/interfaces/cgi>
-#include <webpp/router>
-#include <webpp/server>
-#include <webpp/utils/traits>
-#include <webpp/valves/methods>
-#include <webpp/valves/uri>
+#include <string>
+#include <webpp/http/bodies/string.hpp>
+#include <webpp/http/interfaces/cgi.hpp>
+#include <webpp/http/response.hpp>
 
 using namespace webpp;
-using namespace webpp::valves;
-using iface   = cgi<std_traits>;
-using request = request_t<iface>;
 
-response about_page(request req) {
-    return response::file("about.html");
-}
+using response_type =
+  basic_response<std_traits, empty_extension_pack, response_headers<std_traits>, string_body::type<std_traits>>;
+
+struct hello_world {
+    template <typename RequestType>
+    response_type operator()(RequestType const& req) {
+        if (req.env("PATH_INFO") == "/about")
+            return response_type{200u, std::string{"A webpp CGI application"}};
+        return response_type{200u, std::string{"Hello world"}};
+    }
+};
 
 int main() {
-    server<iface> app;
-    app.router.on("/"_path, [] {
-        return "main page";
-    });
-    app.router.on(get and "/cgi-bin/webpp_helloworld"_path,
-                  [](request const& req, response& res) noexcept {
-                      res << "Hello world";
-                  });
-    app.router.on("/about"_path, &about_page);
-    app.router.on(get and "/cgi-bin/webpp_helloworld/about"_path, &about_page);
-    return app.run();
+    cgi<std_traits, hello_world> app;
+    app();
+    return 0;
 }
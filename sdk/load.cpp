@@ -0,0 +1,566 @@
+#include "load.h"
+
+#include <algorithm>
+#include <array>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/write.hpp>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <webpp/http/interfaces/fastcgi/protocol.hpp>
+#include <webpp/utils/latency_histogram.hpp>
+#include <webpp/utils/strings.hpp>
+
+namespace {
+
+    namespace asio   = boost::asio;
+    namespace proto  = webpp::protocol;
+    using tcp        = asio::ip::tcp;
+    using clock_type = std::chrono::steady_clock;
+    using error_code = boost::system::error_code;
+    using namespace std::chrono_literals;
+
+    // how long the responses are waited for after the end of the test
+    constexpr auto drain_time = 2s;
+
+    struct target_url {
+        bool        fastcgi = false;
+        std::string host;
+        std::string port;
+        std::string path;
+    };
+
+    std::optional<target_url> parse_url(std::string_view url) {
+        target_url res;
+        if (url.starts_with("fcgi://"))
+            res.fastcgi = true;
+        else if (!url.starts_with("http://"))
+            return std::nullopt;
+        url.remove_prefix(7);
+
+        auto const slash     = url.find('/');
+        auto const authority = url.substr(0, slash);
+        res.path = slash == std::string_view::npos ? "/" : url.substr(slash);
+
+        // the ipv6 addresses are in brackets: [::1]:8080
+        auto const colon = authority.rfind(':');
+        if (colon == std::string_view::npos || authority.ends_with(']')) {
+            res.host = authority;
+            res.port = res.fastcgi ? "9000" : "80";
+        } else {
+            res.host = authority.substr(0, colon);
+            res.port = authority.substr(colon + 1);
+        }
+        if (res.host.size() > 2 && res.host.front() == '[' &&
+            res.host.back() == ']')
+            res.host = res.host.substr(1, res.host.size() - 2);
+        if (res.host.empty() || res.port.empty())
+            return std::nullopt;
+        return res;
+    }
+
+    void append_record(std::string& out, proto::record_type type,
+                       std::uint16_t id, std::string_view content) {
+        proto::header const head{type, id,
+                                 static_cast<std::uint16_t>(content.size()), 0};
+        out.append(reinterpret_cast<char const*>(&head), sizeof(head));
+        out += content;
+    }
+
+    void append_param(std::string& params, std::string_view name,
+                      std::string_view value) {
+        for (auto const length : {name.size(), value.size()}) {
+            if (length < 128) {
+                params += static_cast<char>(length);
+            } else {
+                params += static_cast<char>((length >> 24U) | 0x80U);
+                params += static_cast<char>(length >> 16U);
+                params += static_cast<char>(length >> 8U);
+                params += static_cast<char>(length);
+            }
+        }
+        params += name;
+        params += value;
+    }
+
+    /**
+     * The bytes of a request; the FastCGI ones are for one request id
+     */
+    std::string make_request(target_url const& url, std::uint16_t id) {
+        if (!url.fastcgi) {
+            return "GET " + url.path + " HTTP/1.1\r\nHost: " + url.host +
+                   "\r\nUser-Agent: webpp-load\r\n\r\n";
+        }
+        std::string_view const uri   = url.path;
+        auto const             query = uri.find('?');
+
+        std::string params;
+        append_param(params, "REQUEST_METHOD", "GET");
+        append_param(params, "REQUEST_URI", uri);
+        append_param(params, "DOCUMENT_URI", uri.substr(0, query));
+        append_param(params, "QUERY_STRING",
+                     query == std::string_view::npos ? ""
+                                                     : uri.substr(query + 1));
+        append_param(params, "SERVER_PROTOCOL", "HTTP/1.1");
+        append_param(params, "SERVER_PORT", url.port);
+        append_param(params, "REMOTE_ADDR", "127.0.0.1");
+        append_param(params, "HTTP_HOST", url.host);
+        append_param(params, "HTTP_USER_AGENT", "webpp-load");
+
+        char const begin[8]{
+          0, static_cast<char>(proto::role_type::responder),
+          static_cast<char>(proto::keep_conn_flag)};
+        std::string res;
+        append_record(res, proto::record_type::begin_request, id, {begin, 8});
+        append_record(res, proto::record_type::params, id, params);
+        append_record(res, proto::record_type::params, id, {});
+        append_record(res, proto::record_type::std_in, id, {});
+        return res;
+    }
+
+    struct response_end {
+        std::size_t   size = 0; // of the data up to its end; 0 if it's not read
+        std::uint16_t id   = 0; // of the FastCGI request
+        bool          ok   = false;
+    };
+
+    /**
+     * The end of the first HTTP response in the data (Content-Length or
+     * chunked); nullopt if it's malformed. The 4xx and 5xx ones are not ok.
+     */
+    std::optional<response_end> find_http_end(std::string_view data) {
+        response_end res;
+        auto const   head_end = data.find("\r\n\r\n");
+        if (head_end == std::string_view::npos)
+            return res;
+        if (!data.starts_with("HTTP/1.") || head_end < 12)
+            return std::nullopt;
+        unsigned status = 0;
+        if (std::from_chars(data.data() + 9, data.data() + 12, status).ec !=
+            std::errc{})
+            return std::nullopt;
+        res.ok = status < 400;
+
+        std::size_t body    = 0;
+        bool        chunked = false;
+        auto const  head    = data.substr(0, head_end + 2);
+        for (auto pos = head.find("\r\n") + 2; pos < head.size();) {
+            auto const eol  = head.find("\r\n", pos);
+            auto const line = head.substr(pos, eol - pos);
+            pos             = eol + 2;
+
+            auto const colon = line.find(':');
+            if (colon == std::string_view::npos)
+                continue;
+            auto const name  = line.substr(0, colon);
+            auto       value = line.substr(colon + 1);
+            while (value.starts_with(' '))
+                value.remove_prefix(1);
+            if (webpp::ascii_iequals(name, "Content-Length")) {
+                if (std::from_chars(value.data(), value.data() + value.size(),
+                                    body)
+                      .ec != std::errc{})
+                    return std::nullopt;
+            } else if (webpp::ascii_iequals(name, "Transfer-Encoding")) {
+                chunked = value.ends_with("chunked");
+            }
+        }
+
+        auto pos = head_end + 4;
+        if (!chunked) {
+            if (data.size() - pos >= body)
+                res.size = pos + body;
+            return res;
+        }
+        for (;;) {
+            auto const eol = data.find("\r\n", pos);
+            if (eol == std::string_view::npos)
+                return res;
+            std::size_t chunk = 0;
+            if (std::from_chars(data.data() + pos, data.data() + eol, chunk, 16)
+                  .ec != std::errc{})
+                return std::nullopt;
+            pos = eol + 2;
+            if (chunk == 0)
+                break;
+            if (data.size() - pos < chunk + 2)
+                return res;
+            pos += chunk + 2;
+        }
+        // the trailers, up to an empty line
+        for (;;) {
+            auto const eol = data.find("\r\n", pos);
+            if (eol == std::string_view::npos)
+                return res;
+            auto const empty = eol == pos;
+            pos              = eol + 2;
+            if (empty)
+                break;
+        }
+        res.size = pos;
+        return res;
+    }
+
+    /**
+     * The end of the first END_REQUEST record in the data; the records of the
+     * other requests may come before it
+     */
+    std::optional<response_end> find_fastcgi_end(std::string_view data) {
+        response_end res;
+        proto::header head{proto::record_type::unknown_type, 0, 0, 0};
+        for (std::size_t pos = 0; data.size() - pos >= sizeof(head);) {
+            std::memcpy(&head, data.data() + pos, sizeof(head));
+            if (head.version != 1)
+                return std::nullopt;
+            auto const size =
+              sizeof(head) + head.content_length() + head.padding_length;
+            if (data.size() - pos < size)
+                break;
+            if (head.type == proto::record_type::end_request &&
+                head.content_length() >= 8) {
+                auto const* body = data.data() + pos + sizeof(head);
+                res.size         = pos + size;
+                res.id           = head.request_id();
+                res.ok = std::all_of(body, body + 4,
+                                     [](char byte) {
+                                         return byte == 0;
+                                     }) &&
+                         body[4] == static_cast<char>(
+                                      proto::protocol_status_type::
+                                        request_complete);
+                return res;
+            }
+            pos += size;
+        }
+        return res;
+    }
+
+    struct load_setup {
+        bool                     fastcgi;
+        std::vector<std::string> requests; // by the FastCGI request ids
+        std::size_t              pipeline;
+        clock_type::duration     interval; // of the requests of a connection
+        clock_type::time_point   start;
+        clock_type::time_point   end;
+    };
+
+    struct load_stats {
+        webpp::latency_histogram latency;
+        std::size_t              ok        = 0;
+        std::size_t              failed    = 0; // the 4xx and 5xx responses
+        std::size_t              missed    = 0; // never sent before the end
+        std::size_t              timed_out = 0;
+        std::size_t              broken    = 0; // the connections
+
+        void merge(load_stats const& other) {
+            latency.merge(other.latency);
+            ok += other.ok;
+            failed += other.failed;
+            missed += other.missed;
+            timed_out += other.timed_out;
+            broken += other.broken;
+        }
+    };
+
+    /**
+     * One connection to the server; its requests are meant to be sent every
+     * "interval", and as many of them as the pipeline allows are in flight at
+     * a time; if the server falls behind, the requests wait for their turn,
+     * and the wait is counted in their latencies.
+     */
+    class load_connection {
+        using in_flight_request =
+          std::pair<std::uint16_t, clock_type::time_point>;
+
+        load_setup const&             setup;
+        load_stats&                   stats;
+        tcp::socket                   socket;
+        asio::steady_timer            timer;
+        std::deque<in_flight_request> in_flight;
+        clock_type::time_point        next; // of the next request
+        clock_type::time_point        armed_at;
+        std::string                   pending;
+        std::string                   sending;
+        std::string                   received;
+        std::array<char, 16 * 1024>   buffer{};
+        bool                          writing = false;
+        bool                          waiting = false;
+        bool                          done    = false;
+
+        void close() {
+            done = true;
+            timer.cancel();
+            error_code ec;
+            socket.close(ec);
+        }
+
+        void fail() {
+            if (done)
+                return;
+            stats.broken++;
+            stats.timed_out += in_flight.size();
+            in_flight.clear();
+            if (next < setup.end)
+                stats.missed += static_cast<std::size_t>(
+                  (setup.end - next + setup.interval - 1ns) / setup.interval);
+            close();
+        }
+
+        [[nodiscard]] std::uint16_t free_id() const noexcept {
+            if (!setup.fastcgi)
+                return 0;
+            for (std::uint16_t id = 1;; id++) {
+                if (std::none_of(in_flight.begin(), in_flight.end(),
+                                 [id](auto const& req) {
+                                     return req.first == id;
+                                 }))
+                    return id;
+            }
+        }
+
+        void arm(clock_type::time_point when) {
+            if (waiting && armed_at == when)
+                return;
+            waiting  = true;
+            armed_at = when;
+            timer.expires_at(when);
+            timer.async_wait([this](error_code ec) {
+                if (ec == asio::error::operation_aborted)
+                    return;
+                waiting = false;
+                schedule();
+            });
+        }
+
+        void schedule() {
+            if (done || writing)
+                return;
+            auto const now = clock_type::now();
+            while (in_flight.size() < setup.pipeline && next < setup.end &&
+                   next <= now) {
+                auto const id = free_id();
+                pending += setup.requests[id];
+                in_flight.emplace_back(id, next);
+                next += setup.interval;
+            }
+            if (!pending.empty()) {
+                write();
+                return;
+            }
+            if (now >= setup.end && next < setup.end) {
+                // the pipeline was full until the end
+                stats.missed += static_cast<std::size_t>(
+                  (setup.end - next + setup.interval - 1ns) / setup.interval);
+                next = setup.end;
+            }
+            if (next < setup.end) {
+                arm(in_flight.size() < setup.pipeline ? next : setup.end);
+            } else if (in_flight.empty()) {
+                close();
+            } else if (now >= setup.end + drain_time) {
+                stats.timed_out += in_flight.size();
+                in_flight.clear();
+                close();
+            } else {
+                arm(setup.end + drain_time);
+            }
+        }
+
+        void write() {
+            writing = true;
+            sending.swap(pending);
+            asio::async_write(socket, asio::buffer(sending),
+                              [this](error_code ec, std::size_t) {
+                                  writing = false;
+                                  sending.clear();
+                                  if (ec)
+                                      return fail();
+                                  schedule();
+                              });
+        }
+
+        [[nodiscard]] bool consume() {
+            auto const  now  = clock_type::now();
+            std::size_t used = 0;
+            for (;;) {
+                std::string_view const data =
+                  std::string_view{received}.substr(used);
+                auto const end =
+                  setup.fastcgi ? find_fastcgi_end(data) : find_http_end(data);
+                if (!end)
+                    return false;
+                if (end->size == 0)
+                    break;
+                used += end->size;
+
+                // a FastCGI server may answer them in any order
+                auto const req = std::find_if(
+                  in_flight.begin(), in_flight.end(), [&end](auto const& item) {
+                      return item.first == end->id;
+                  });
+                if (req == in_flight.end())
+                    return false; // an answer to nothing
+                stats.latency.record(now - req->second);
+                ++(end->ok ? stats.ok : stats.failed);
+                in_flight.erase(req);
+            }
+            received.erase(0, used);
+            return true;
+        }
+
+        void read() {
+            socket.async_read_some(
+              asio::buffer(buffer), [this](error_code ec, std::size_t size) {
+                  if (ec)
+                      return fail();
+                  received.append(buffer.data(), size);
+                  if (!consume())
+                      return fail();
+                  schedule();
+                  if (!done)
+                      read();
+              });
+        }
+
+      public:
+        load_connection(asio::io_context& io, load_setup const& _setup,
+                        load_stats& _stats, clock_type::time_point first)
+          : setup{_setup},
+            stats{_stats},
+            socket{io},
+            timer{io},
+            next{first} {}
+
+        void start(tcp::resolver::results_type const& endpoints) {
+            asio::async_connect(socket, endpoints,
+                                [this](error_code ec, auto const&) {
+                                    if (ec)
+                                        return fail();
+                                    socket.set_option(tcp::no_delay{true}, ec);
+                                    read();
+                                    schedule();
+                                });
+        }
+    };
+
+    void print_latency(char const* name, std::uint64_t nanoseconds) {
+        std::cout << "  " << std::left << std::setw(8) << name << std::right
+                  << std::setw(10) << std::fixed << std::setprecision(3)
+                  << static_cast<double>(nanoseconds) / 1e6 << " ms\n";
+    }
+
+    void print_report(load_options const& options, load_stats const& stats,
+                      clock_type::duration elapsed) {
+        auto const seconds = std::chrono::duration<double>(elapsed).count();
+        auto const answered = stats.ok + stats.failed;
+        std::cout << "Requests:  " << answered << " in " << std::fixed
+                  << std::setprecision(2) << seconds << "s, "
+                  << static_cast<double>(answered) / seconds
+                  << "/s (the target was " << options.rate << "/s)\n"
+                  << "Errors:    " << stats.failed << " 4xx/5xx, "
+                  << stats.missed << " not sent, " << stats.timed_out
+                  << " not answered, " << stats.broken
+                  << " broken connections\n"
+                  << "Latency (from the intended send times):\n";
+        auto const& hist = stats.latency;
+        print_latency("min", hist.min());
+        print_latency("p50", hist.value_at(50));
+        print_latency("p90", hist.value_at(90));
+        print_latency("p99", hist.value_at(99));
+        print_latency("p99.9", hist.value_at(99.9));
+        print_latency("p99.99", hist.value_at(99.99));
+        print_latency("max", hist.max());
+        print_latency("mean", static_cast<std::uint64_t>(hist.mean()));
+    }
+
+} // namespace
+
+bool run_load(load_options const& options) {
+    auto const url = parse_url(options.url);
+    if (!url) {
+        std::cerr << "The url should look like http://host:port/path or "
+                     "fcgi://host:port/path"
+                  << std::endl;
+        return false;
+    }
+    if (!(options.rate > 0) || options.connections == 0 ||
+        options.pipeline == 0 || options.pipeline > 0xFFFF) {
+        std::cerr << "The rate, the connections and the pipeline should be "
+                     "more than zero."
+                  << std::endl;
+        return false;
+    }
+
+    error_code       ec;
+    asio::io_context resolver_io;
+    tcp::resolver    resolver{resolver_io};
+    auto const       endpoints = resolver.resolve(url->host, url->port, ec);
+    if (ec) {
+        std::cerr << "Can't resolve " << url->host << ": " << ec.message()
+                  << std::endl;
+        return false;
+    }
+
+    // each connection sends its share of the rate
+    auto const interval = std::chrono::duration<double>(
+      static_cast<double>(options.connections) / options.rate);
+
+    load_setup setup{
+      .fastcgi  = url->fastcgi,
+      .requests = {},
+      .pipeline = options.pipeline,
+      .interval = std::max<clock_type::duration>(
+        std::chrono::duration_cast<clock_type::duration>(interval), 1ns),
+      .start = clock_type::now() + 100ms,
+      .end   = {}};
+    setup.end = setup.start + options.duration;
+    for (std::size_t id = 0; id <= (url->fastcgi ? options.pipeline : 0); id++)
+        setup.requests.push_back(
+          make_request(*url, static_cast<std::uint16_t>(id)));
+
+    auto const thread_count =
+      std::clamp<std::size_t>(options.threads, 1, options.connections);
+    std::vector<load_stats>  stats(thread_count);
+    std::vector<std::thread> threads;
+    for (std::size_t index = 0; index < thread_count; index++) {
+        threads.emplace_back([&, index] {
+            asio::io_context                              io;
+            std::vector<std::unique_ptr<load_connection>> connections;
+            for (auto conn = index; conn < options.connections;
+                 conn += thread_count) {
+                // spread over the interval, so the requests don't come in waves
+                auto const first =
+                  setup.start + setup.interval * conn / options.connections;
+                connections.push_back(std::make_unique<load_connection>(
+                  io, setup, stats[index], first));
+                connections.back()->start(endpoints);
+            }
+            io.run();
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    auto const elapsed = clock_type::now() - setup.start;
+
+    load_stats total;
+    for (auto const& part : stats)
+        total.merge(part);
+    if (total.broken == options.connections && total.ok + total.failed == 0) {
+        std::cerr << "Can't reach the server." << std::endl;
+        return false;
+    }
+    print_report(options, total, elapsed);
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef LOAD_H
+#define LOAD_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+/**
+ * The options of a load test
+ */
+struct load_options {
+    // http://host:port/target or fcgi://host:port/target
+    std::string          url         = "http://127.0.0.1:8080/";
+    double               rate        = 1000; // requests per second, in total
+    std::size_t          connections = 8;
+    std::size_t          threads     = 2;
+    std::size_t          pipeline    = 1; // in flight on a connection
+    std::chrono::seconds duration{10};
+};
+
+/**
+ * Send the requests to the server at a fixed rate, over keep-alive
+ * connections (pipelined with HTTP/1.1, multiplexed with FastCGI), and print
+ * the throughput and the percentiles of the latencies.
+ *
+ * The latencies are counted from when each request was meant to be sent, not
+ * from when it was sent, so the requests that had to wait behind a stall of
+ * the server are not left out (coordinated omission).
+ * @returns false if the url is not valid or the server can't be reached
+ */
+bool run_load(load_options const& options);
+
+#endif // LOAD_H
@@ -1,4 +1,8 @@
+#include "load.h"
+#include "updater.h"
+
 #include <boost/program_options.hpp>
+#include <filesystem>
 #include <functional>
 #include <iostream>
 #include <tuple>
@@ -21,6 +25,16 @@ void check_args(
       "update the databases")(
       "help,h", bool_switch()->default_value(false)->implicit_value(true),
       "print this help")(
+      "rate,r", value<double>()->default_value(1000),
+      "load: the requests per second")(
+      "connections,c", value<std::size_t>()->default_value(8),
+      "load: the connections to the server")(
+      "threads,t", value<std::size_t>()->default_value(2),
+      "load: the threads that send the requests")(
+      "pipeline,p", value<std::size_t>()->default_value(1),
+      "load: the requests in flight on a connection")(
+      "duration,d", value<unsigned>()->default_value(10),
+      "load: the seconds of the test")(
       "cmd", value<std::string>()->default_value("help")->required(),
       "The command")("cmd_opts",
                      value<std::vector<std::string>>()->multitoken(),
@@ -35,8 +49,16 @@ void check_args(
           vm);
     notify(vm);
 
+    // the command, or a switch that's on; the switches are always in the map
+    auto const is_chosen = [&vm](std::string const& name) {
+        if (vm["cmd"].as<std::string>() == name)
+            return true;
+        auto const opt = vm.find(name);
+        return opt != vm.end() && !opt->second.defaulted() &&
+               opt->second.as<bool>();
+    };
     for (auto const& action : actions) {
-        if (vm.count(action.first)) {
+        if (is_chosen(action.first)) {
             action.second(desc, vm);
             return;
         }
@@ -57,9 +79,39 @@ void create_template(boost::program_options::options_description const& desc,
     // TODO: complete me
 }
 
-void update_db(boost::program_options::options_description const& desc,
-               boost::program_options::variables_map const& /* vm */) {
-    // TODO: complete me
+void update_db(boost::program_options::options_description const& /* desc */,
+               boost::program_options::variables_map const& vm) {
+    using namespace std;
+
+    // the data directory is the first option of the command
+    filesystem::path data_dir = ".";
+    if (vm.count("cmd_opts")) {
+        auto const& opts = vm["cmd_opts"].as<vector<string>>();
+        if (!opts.empty())
+            data_dir = opts.front();
+    }
+    if (!update(UPDATE_EMAIL_DATABASE, data_dir))
+        exit(EXIT_FAILURE);
+}
+
+void load_test(boost::program_options::options_description const& /* desc */,
+               boost::program_options::variables_map const& vm) {
+    using namespace std;
+
+    // the url is the first option of the command
+    load_options options;
+    if (vm.count("cmd_opts")) {
+        auto const& opts = vm["cmd_opts"].as<vector<string>>();
+        if (!opts.empty())
+            options.url = opts.front();
+    }
+    options.rate        = vm["rate"].as<double>();
+    options.connections = vm["connections"].as<size_t>();
+    options.threads     = vm["threads"].as<size_t>();
+    options.pipeline    = vm["pipeline"].as<size_t>();
+    options.duration    = chrono::seconds{vm["duration"].as<unsigned>()};
+    if (!run_load(options))
+        exit(EXIT_FAILURE);
 }
 
 void session_manager(boost::program_options::options_description const& desc,
@@ -94,6 +146,7 @@ auto main(int argc, char const** argv) -> int {
                {{"help", print_help},
                 {"create", create_template},
                 {"session", session_manager},
+                {"load", load_test},
                 {"update", update_db}},
                print_help);
 
@@ -1,5 +1,42 @@
 #include "updater.h"
 
-void update(unsigned int flags) {
-    // TODO: complete me
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <webpp/validators/email_providers.hpp>
+
+namespace {
+
+    bool update_email_database(std::filesystem::path const& data_dir) {
+        auto const    source = data_dir / "email_providers.txt";
+        std::ifstream file{source};
+        if (!file) {
+            std::cerr << "Can't read " << source << std::endl;
+            return false;
+        }
+        std::stringstream text;
+        text << file.rdbuf();
+
+        webpp::email_database_builder builder;
+        if (!builder.load(text.str()))
+            std::cerr << "Some of the lines of " << source
+                      << " are not valid; they're skipped." << std::endl;
+
+        auto const database = data_dir / "email_providers.db";
+        if (!builder.write_file(database)) {
+            std::cerr << "Can't write " << database << std::endl;
+            return false;
+        }
+        std::cout << "Wrote " << builder.size() << " email domains into "
+                  << database << std::endl;
+        return true;
+    }
+
+} // namespace
+
+bool update(unsigned int flags, std::filesystem::path const& data_dir) {
+    bool done = true;
+    if (flags & UPDATE_EMAIL_DATABASE)
+        done = update_email_database(data_dir) && done;
+    return done;
 }
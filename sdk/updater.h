@@ -1,7 +1,16 @@
 #ifndef UPDATER_H
 #define UPDATER_H
 
+#include <filesystem>
+
 static constexpr const unsigned int UPDATE_EMAIL_DATABASE = 0x1;
-void update(unsigned int flags);
+
+/**
+ * Update the databases of the flags in the data directory; the email provider
+ * database is made out of the list in email_providers.txt (see
+ * webpp::email_database_builder) and written into email_providers.db.
+ * @returns false if any of them can't be updated
+ */
+bool update(unsigned int flags, std::filesystem::path const& data_dir);
 
 #endif // UPDATER_H
@@ -0,0 +1,117 @@
+#include "../core/include/webpp/utils/base64.hpp"
+
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <string_view>
+
+using namespace webpp;
+
+namespace {
+    template <typename Codec>
+    std::string encoded(std::string_view data) {
+        std::string res;
+        Codec::encode(data, res);
+        return res;
+    }
+
+    template <typename Codec>
+    std::string decoded(std::string_view str) {
+        std::string res;
+        if (!Codec::decode(str, res))
+            return "(invalid)";
+        return res;
+    }
+} // namespace
+
+TEST(Base64, RFC4648) {
+    EXPECT_EQ(encoded<base64>(""), "");
+    EXPECT_EQ(encoded<base64>("f"), "Zg==");
+    EXPECT_EQ(encoded<base64>("fo"), "Zm8=");
+    EXPECT_EQ(encoded<base64>("foo"), "Zm9v");
+    EXPECT_EQ(encoded<base64>("foob"), "Zm9vYg==");
+    EXPECT_EQ(encoded<base64>("fooba"), "Zm9vYmE=");
+    EXPECT_EQ(encoded<base64>("foobar"), "Zm9vYmFy");
+
+    EXPECT_EQ(decoded<base64>("Zm9vYmFy"), "foobar");
+    EXPECT_EQ(decoded<base64>("Zm9vYmE="), "fooba");
+    EXPECT_EQ(decoded<base64>("Zm9vYg=="), "foob");
+    EXPECT_EQ(decoded<base64>("Zm9vYg"), "foob");
+    EXPECT_EQ(decoded<base64>(""), "");
+}
+
+TEST(Base64, URL) {
+    std::string_view const data = "\xfb\xff\xbf?>";
+    EXPECT_EQ(encoded<base64>(data), "+/+/Pz4=");
+    EXPECT_EQ(encoded<base64url>(data), "-_-_Pz4");
+    EXPECT_EQ(decoded<base64url>("-_-_Pz4"), data);
+    EXPECT_EQ(decoded<base64url>("+/+/Pz4"), "(invalid)");
+    EXPECT_EQ(decoded<base64url>("-_-_Pz4="), "(invalid)") << "no padding in the unpadded variant";
+    EXPECT_EQ(decoded<base64>("-_-_Pz4="), "(invalid)");
+}
+
+TEST(Base64, Invalid) {
+    EXPECT_EQ(decoded<base64>("Zm9vY"), "(invalid)");
+    EXPECT_EQ(decoded<base64>("Zm9v=mFy"), "(invalid)");
+    EXPECT_EQ(decoded<base64>("Zm9vYmF*"), "(invalid)");
+    EXPECT_EQ(decoded<base64>("Zm9vYm\xc3\xa9"), "(invalid)");
+
+    // the invalid chars in the vectorized part too
+    std::string long_one = encoded<base64>(std::string(200, 'x'));
+    long_one[37]         = '.';
+    EXPECT_EQ(decoded<base64>(long_one), "(invalid)");
+    long_one[37] = static_cast<char>(0x80);
+    EXPECT_EQ(decoded<base64>(long_one), "(invalid)");
+
+    std::string out = "kept";
+    EXPECT_FALSE(base64::decode("Zm9v!", out));
+    EXPECT_EQ(out, "kept");
+}
+
+TEST(Base64, BoundedOutput) {
+    char out[8]{};
+    EXPECT_EQ(base64::encode("foob", out, 7), base64::npos);
+    EXPECT_EQ(base64::encode("foob", out, 8), 8);
+    EXPECT_EQ(std::string_view(out, 8), "Zm9vYg==");
+    EXPECT_EQ(base64::decode("Zm9vYmFy", out, 5), base64::npos);
+    EXPECT_EQ(base64::decode("Zm9vYmFy", out, 6), 6);
+    EXPECT_EQ(std::string_view(out, 6), "foobar");
+    EXPECT_EQ(base64url::encode("foob", out, 6), 6);
+    EXPECT_EQ(std::string_view(out, 6), "Zm9vYg");
+
+    static_assert(base64::encoded_size(4) == 8);
+    static_assert(base64url::encoded_size(4) == 6);
+    static_assert(base64url::max_decoded_size(6) == 4);
+}
+
+TEST(Base64, ConstantEvaluated) {
+    constexpr auto size = [] {
+        char out[8]{};
+        return base64::encode("foob", out, 8) + base64::decode("Zm9vYg==", out, 8);
+    }();
+    static_assert(size == 12);
+}
+
+TEST(Base64, SameAsScalar) {
+    std::mt19937 gen{42}; // NOLINT(cert-msc51-cpp)
+    for (std::size_t size = 0; size < 300; size++) {
+        std::string data(size, '\0');
+        for (auto& c : data)
+            c = static_cast<char>(gen());
+
+        std::string scalar(base64::encoded_size(size), '\0');
+        std::string vector(scalar.size(), '\0');
+        ASSERT_EQ(base64::encode_scalar(data, scalar.data(), scalar.size()), scalar.size());
+        ASSERT_EQ(base64::encode(data, vector.data(), vector.size()), vector.size());
+        EXPECT_EQ(scalar, vector) << size;
+
+        std::string back(base64::max_decoded_size(vector.size()), '\0');
+        auto const  back_size = base64::decode(vector, back.data(), back.size());
+        ASSERT_EQ(back_size, size);
+        EXPECT_EQ(base64::decode_scalar(vector, back.data(), back.size()), size);
+        EXPECT_EQ(back.substr(0, back_size), data);
+
+        auto const url = encoded<base64url>(data);
+        EXPECT_EQ(decoded<base64url>(url), data);
+    }
+}
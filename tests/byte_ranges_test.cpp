@@ -0,0 +1,172 @@
+#include "../core/include/webpp/http/bodies/file.hpp"
+#include "../core/include/webpp/http/byte_ranges.hpp"
+#include "../core/include/webpp/http/interfaces/simple_server.hpp"
+#include "../core/include/webpp/http/response.hpp"
+#include "../core/include/webpp/http/static_file_cache.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace webpp;
+
+namespace {
+    using file_response_type =
+      basic_response<std_traits, empty_extension_pack, response_headers<std_traits>, file_body::type<std_traits>>;
+
+    std::string header_value(file_response_type const& res, std::string_view name) {
+        auto const it = res.header.find(name);
+        return it == res.header.end() ? std::string{} : std::string{it->value};
+    }
+
+    std::filesystem::path alphabet_file() {
+        auto const    path = std::filesystem::temp_directory_path() / "webpp_byte_ranges_test.txt";
+        std::ofstream out{path, std::ios::binary | std::ios::trunc};
+        out << "abcdefghijklmnopqrstuvwxyz";
+        return path;
+    }
+
+    struct range_app {
+        std::filesystem::path path;
+        static_file_cache     cache{{.max_file_size = 0}}; // they're sent from the disk
+
+        template <typename RequestType>
+        file_response_type operator()(RequestType const& req) {
+            return file_response<file_response_type>(cache, path, {}, req.header("Range"), req.header("If-Range"));
+        }
+    };
+} // namespace
+
+TEST(ByteRanges, Parser) {
+    std::vector<byte_range> ranges;
+    EXPECT_EQ(parse_byte_ranges("bytes=0-9", 100, ranges), range_status::satisfiable);
+    EXPECT_EQ(ranges, (std::vector<byte_range>{{0, 10}}));
+
+    EXPECT_EQ(parse_byte_ranges("Bytes= 90-, -5 ,,10-19", 100, ranges), range_status::satisfiable);
+    EXPECT_EQ(ranges, (std::vector<byte_range>{{10, 10}, {90, 10}})) << "sorted and merged";
+
+    EXPECT_EQ(parse_byte_ranges("bytes=50-1000", 100, ranges), range_status::satisfiable);
+    EXPECT_EQ(ranges, (std::vector<byte_range>{{50, 50}})) << "cut to the size";
+    EXPECT_EQ(parse_byte_ranges("bytes=-500", 100, ranges), range_status::satisfiable);
+    EXPECT_EQ(ranges, (std::vector<byte_range>{{0, 100}}));
+
+    EXPECT_EQ(parse_byte_ranges("bytes=0-,0-,0-", 100, ranges), range_status::satisfiable);
+    EXPECT_EQ(ranges, (std::vector<byte_range>{{0, 100}}));
+    EXPECT_EQ(parse_byte_ranges("bytes=0-9,10-19", 100, ranges), range_status::satisfiable);
+    EXPECT_EQ(ranges, (std::vector<byte_range>{{0, 20}})) << "the adjacent ones too";
+
+    EXPECT_EQ(parse_byte_ranges("bytes=100-", 100, ranges), range_status::unsatisfiable);
+    EXPECT_EQ(parse_byte_ranges("bytes=-0", 100, ranges), range_status::unsatisfiable);
+    EXPECT_EQ(parse_byte_ranges("bytes=0-0", 0, ranges), range_status::unsatisfiable);
+
+    EXPECT_EQ(parse_byte_ranges("items=0-9", 100, ranges), range_status::ignored);
+    EXPECT_EQ(parse_byte_ranges("bytes=9-0", 100, ranges), range_status::ignored);
+    EXPECT_EQ(parse_byte_ranges("bytes=a-b", 100, ranges), range_status::ignored);
+    EXPECT_EQ(parse_byte_ranges("bytes=", 100, ranges), range_status::ignored);
+    std::string many = "bytes=0-0";
+    for (int i = 1; i <= 20; i++)
+        many += "," + std::to_string(i * 2) + "-" + std::to_string(i * 2);
+    EXPECT_EQ(parse_byte_ranges(many, 100, ranges), range_status::ignored);
+
+    EXPECT_TRUE(if_range_matches("", "\"a\"", 0));
+    EXPECT_TRUE(if_range_matches("\"a\"", "\"a\"", 0));
+    EXPECT_FALSE(if_range_matches("\"b\"", "\"a\"", 0));
+    EXPECT_FALSE(if_range_matches("W/\"a\"", "\"a\"", 0));
+    EXPECT_TRUE(if_range_matches("Sun, 06 Nov 1994 08:49:37 GMT", "\"a\"", 784111777));
+    EXPECT_FALSE(if_range_matches("Sun, 06 Nov 1994 08:49:38 GMT", "\"a\"", 784111777));
+}
+
+TEST(ByteRanges, FileResponse) {
+    auto const        path = alphabet_file();
+    static_file_cache cached;
+    static_file_cache disk{{.max_file_size = 0}};
+
+    for (auto* cache : {&cached, &disk}) {
+        auto full = file_response<file_response_type>(*cache, path);
+        EXPECT_EQ(full.header.status_code, 200);
+        EXPECT_EQ(header_value(full, "Accept-Ranges"), "bytes");
+        auto const etag = header_value(full, "ETag");
+        ASSERT_FALSE(etag.empty());
+        auto const modified = header_value(full, "Last-Modified");
+        EXPECT_EQ(modified.size(), http_date_size);
+
+        auto one = file_response<file_response_type>(*cache, path, {}, "bytes=-3");
+        EXPECT_EQ(one.header.status_code, 206);
+        EXPECT_EQ(header_value(one, "Content-Range"), "bytes 23-25/26");
+        EXPECT_EQ(header_value(one, "Content-Length"), "3");
+        EXPECT_EQ(one.body.str(), "xyz");
+
+        auto two = file_response<file_response_type>(*cache, path, {}, "bytes=0-1,4-5", etag);
+        EXPECT_EQ(two.header.status_code, 206);
+        auto const type = header_value(two, "Content-Type");
+        ASSERT_EQ(type.find("multipart/byteranges; boundary="), 0);
+        auto const boundary = type.substr(type.find('=') + 1);
+        EXPECT_EQ(two.body.str(),
+                  "\r\n--" + boundary + "\r\nContent-Type: text/plain; charset=utf-8\r\nContent-Range: bytes 0-1/26\r\n\r\nab" +
+                    "\r\n--" + boundary + "\r\nContent-Type: text/plain; charset=utf-8\r\nContent-Range: bytes 4-5/26\r\n\r\nef" +
+                    "\r\n--" + boundary + "--\r\n");
+        EXPECT_EQ(header_value(two, "Content-Length"), std::to_string(two.body.str().size()));
+
+        // the file has changed since the client got its part
+        auto changed = file_response<file_response_type>(*cache, path, {}, "bytes=0-1", "\"other\"");
+        EXPECT_EQ(changed.header.status_code, 200);
+        EXPECT_EQ(changed.body.str(), "abcdefghijklmnopqrstuvwxyz");
+        auto by_date = file_response<file_response_type>(*cache, path, {}, "bytes=0-1", modified);
+        EXPECT_EQ(by_date.header.status_code, 206);
+
+        auto none = file_response<file_response_type>(*cache, path, {}, "bytes=26-");
+        EXPECT_EQ(none.header.status_code, 416);
+        EXPECT_EQ(header_value(none, "Content-Range"), "bytes */26");
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(ByteRanges, SimpleServerSendsTheSlices) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    auto const              path = alphabet_file();
+    boost::asio::io_context io;
+    tcp::acceptor           acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    tcp::socket             client{io};
+    client.connect(acceptor.local_endpoint());
+    common::connection conn{acceptor.accept()};
+
+    simple_server<std_traits, range_app> server;
+    server.app.path = path;
+    conn.start([] {},
+               [&, state = decltype(server)::connection_state{}](common::connection& c,
+                                                                 std::string_view    data) mutable {
+                   server.handle(c, state, data);
+               });
+    boost::asio::write(client,
+                       boost::asio::buffer(std::string_view{"GET /a HTTP/1.1\r\n"
+                                                            "Host: a\r\nRange: bytes=2-4\r\n\r\n"
+                                                            "GET /b HTTP/1.1\r\n"
+                                                            "Host: a\r\nRange: bytes=0-0,-1\r\n"
+                                                            "Connection: close\r\n\r\n"}));
+    io.run_for(50ms);
+    std::string               received;
+    boost::system::error_code ec;
+    boost::asio::read(client, boost::asio::dynamic_buffer(received), ec);
+    std::filesystem::remove(path);
+
+    ASSERT_EQ(received.find("HTTP/1.1 206 Partial Content\r\n"), 0);
+    auto const first_head  = received.find("\r\n\r\n");
+    auto const second_head = received.find("HTTP/1.1 206 Partial Content\r\n", first_head);
+    ASSERT_NE(second_head, std::string::npos);
+    EXPECT_EQ(received.substr(first_head + 4, second_head - first_head - 4), "cde");
+
+    auto const second   = received.substr(second_head);
+    auto const type     = second.find("multipart/byteranges; boundary=");
+    ASSERT_NE(type, std::string::npos);
+    auto const boundary = second.substr(type + 31, second.find("\r\n", type) - type - 31);
+    auto const body     = second.substr(second.find("\r\n\r\n") + 4);
+    EXPECT_EQ(body,
+              "\r\n--" + boundary + "\r\nContent-Type: text/plain; charset=utf-8\r\nContent-Range: bytes 0-0/26\r\n\r\na" +
+                "\r\n--" + boundary + "\r\nContent-Type: text/plain; charset=utf-8\r\nContent-Range: bytes 25-25/26\r\n\r\nz" +
+                "\r\n--" + boundary + "--\r\n");
+}
@@ -1,9 +1,500 @@
 #include "../core/include/webpp/cache/cache.hpp"
 
+#include "../core/include/webpp/cache/lru_cache.hpp"
+#include "../core/include/webpp/cache/mmap_cache.hpp"
+#include "../core/include/webpp/cache/passive_cache.hpp"
+#include "../core/include/webpp/cache/refreshing_cache.hpp"
+#include "../core/include/webpp/cache/sharded_cache.hpp"
+#include "../core/include/webpp/cache/tinylfu_cache.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fcntl.h>
+#include <filesystem>
+#include <functional>
 #include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
 
 using namespace webpp;
 
 
 TEST(Cache, CacheSystemInit) {
+    unified_caches<lru_cache<int, int>, lru_cache<std::string, std::string>> caches{
+      lru_cache<int, int>{2},
+      lru_cache<std::string, std::string>{2}};
+    caches.set(1, 10).set(std::string{"one"}, "ten");
+    EXPECT_EQ(caches.get(1, 0), 10);
+    EXPECT_EQ(caches.get(2, 0), 0);
+    EXPECT_EQ(caches.get(std::string{"one"}, std::string{}), "ten");
+    EXPECT_EQ((caches.cache<lru_cache<int, int>>().size()), 1);
+    EXPECT_EQ((caches.cache<lru_cache<int, int>>().max_weight()), 2);
+
+    unified_caches<passive_cache<>> passive;
+    EXPECT_EQ(passive.get(std::string{"key"}, std::string{"default"}), "default");
+}
+
+TEST(Cache, Dispatch) {
+    using int_cache    = lru_cache<int, int>;
+    using long_cache   = lru_cache<long, long>;
+    using string_cache = lru_cache<std::string, std::string>;
+    using caches_type  = unified_caches<int_cache, long_cache, string_cache>;
+
+    static_assert(std::is_same_v<caches_type::cache_for_t<long, long>, long_cache>,
+                  "the exact one is picked, not the first convertible one");
+    static_assert(std::is_same_v<caches_type::cache_for_t<int const&, int&&>, int_cache>);
+    static_assert(std::is_same_v<caches_type::cache_for_t<short, short>, int_cache>);
+    static_assert(std::is_same_v<caches_type::cache_for_t<char const*, char const*>, string_cache>);
+    static_assert(std::is_void_v<caches_type::cache_for_t<std::string, int>>);
+
+    caches_type caches;
+    caches.set(1L, 10L).set(1, 20);
+    EXPECT_EQ(caches.get(1L, 0L), 10);
+    EXPECT_EQ(caches.get(1, 0), 20);
+    EXPECT_EQ(caches.cache<long_cache>().size(), 1);
+    auto const shout = [](std::string const& key) {
+        return key + "!";
+    };
+    EXPECT_EQ(caches.get_or_set(std::string{"key"}, shout), "key!");
+    EXPECT_TRUE(caches.cache<string_cache>().contains("key"));
+}
+
+TEST(Cache, LRU) {
+    lru_cache<int, std::string> cache{3};
+    cache.set(1, "one").set(2, "two").set(3, "three");
+    ASSERT_NE(cache.find(1), nullptr);
+    cache.set(4, "four");
+    EXPECT_TRUE(cache.contains(1)) << "it was used";
+    EXPECT_FALSE(cache.contains(2)) << "it's the least recently used one";
+    EXPECT_EQ(cache.size(), 3);
+
+    cache.set(3, "again");
+    EXPECT_EQ(cache.get(3, ""), "again");
+    EXPECT_EQ(cache.size(), 3);
+    EXPECT_TRUE(cache.erase(3));
+    EXPECT_FALSE(cache.erase(3));
+    EXPECT_EQ(cache.weight(), 2);
+
+    cache.max_weight(1);
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_TRUE(cache.contains(4));
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(cache.weight(), 0);
+}
+
+TEST(Cache, ByteBudget) {
+    lru_cache<std::string, std::string, byte_weight> cache{4096};
+    std::string const big(1000, 'x');
+    for (int i = 0; i < 10; i++)
+        cache.set("file" + std::to_string(i), big);
+    EXPECT_LE(cache.weight(), 4096);
+    EXPECT_EQ(cache.size(), 3);
+    EXPECT_TRUE(cache.contains("file9"));
+
+    cache.set("huge", std::string(5000, 'x'));
+    EXPECT_FALSE(cache.contains("huge")) << "it's bigger than the whole budget";
+    EXPECT_EQ(cache.size(), 3);
+}
+
+TEST(Cache, TinyLFU) {
+    tinylfu_cache<int, int> cache{100};
+    for (int i = 0; i < 100; i++)
+        cache.set(i, i);
+    EXPECT_EQ(cache.size(), 100);
+    EXPECT_EQ(cache.get(5, -1), 5);
+    EXPECT_EQ(cache.get(500, -1), -1);
+
+    cache.set(5, 50);
+    EXPECT_EQ(cache.get(5, -1), 50);
+    EXPECT_TRUE(cache.erase(5));
+    EXPECT_FALSE(cache.contains(5));
+    EXPECT_EQ(cache.size(), 99);
+    EXPECT_EQ(cache.weight(), 99);
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(cache.weight(), 0);
+}
+
+TEST(Cache, ScanResistance) {
+    // the hot keys are used over and over, with a scan of the keys that are used once in between
+    lru_cache<int, int>     lru{100};
+    tinylfu_cache<int, int> lfu{100};
+    for (int round = 0; round < 20; round++) {
+        for (int key = 0; key < 50; key++) {
+            if (!lru.find(key))
+                lru.set(key, key);
+            if (!lfu.find(key))
+                lfu.set(key, key);
+        }
+        for (int key = 0; key < 200; key++) {
+            auto const cold = 1000 + round * 200 + key;
+            lru.set(cold, cold);
+            lfu.set(cold, cold);
+        }
+    }
+    int lru_hits = 0;
+    int lfu_hits = 0;
+    for (int key = 0; key < 50; key++) {
+        lru_hits += lru.contains(key) ? 1 : 0;
+        lfu_hits += lfu.contains(key) ? 1 : 0;
+    }
+    EXPECT_EQ(lru_hits, 0) << "the scan pushes them out of the LRU";
+    EXPECT_GE(lfu_hits, 45) << "they're used more often than the scanned ones";
+    EXPECT_LE(lfu.weight(), 100);
+    EXPECT_LE(lru.weight(), 100);
+}
+
+TEST(Cache, TinyLFUWeights) {
+    tinylfu_cache<std::string, std::string, byte_weight> cache{8192, 64};
+    for (int i = 0; i < 100; i++) {
+        cache.set("file" + std::to_string(i % 10), std::string(static_cast<std::size_t>(100 + i * 10), 'x'));
+        EXPECT_LE(cache.weight(), 8192);
+    }
+    cache.set("huge", std::string(10000, 'x'));
+    EXPECT_FALSE(cache.contains("huge"));
+}
+
+TEST(Cache, Sharded) {
+    sharded_cache<lru_cache<std::string, std::string>, 4> cache{8};
+    cache.set("a", "alpha").set(std::string{"b"}, "beta");
+    EXPECT_EQ(cache.get("a"), "alpha");
+    EXPECT_EQ(cache.get("nope", "default"), "default");
+    EXPECT_FALSE(cache.get("nope"));
+    EXPECT_TRUE(cache.contains("b"));
+    EXPECT_EQ(cache.size(), 2);
+
+    std::size_t size = 0;
+    EXPECT_TRUE(cache.visit("b", [&](std::string const& value) {
+        size = value.size();
+    }));
+    EXPECT_EQ(size, 4);
+
+    EXPECT_TRUE(cache.erase("a"));
+    EXPECT_FALSE(cache.erase("a"));
+    for (int i = 0; i < 100; i++)
+        cache.set(std::to_string(i), "value");
+    EXPECT_LE(cache.size(), 8) << "each shard keeps its share of the budget";
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0);
+
+    sharded_cache<tinylfu_cache<std::string, std::string, byte_weight>, 2> bytes{8192, 16};
+    bytes.set("page", std::string(1000, 'x'));
+    EXPECT_TRUE(bytes.contains("page"));
+    EXPECT_LE(bytes.weight(), 8192);
+}
+
+TEST(Cache, ShardedThreads) {
+    sharded_cache<tinylfu_cache<int, int>> cache{64 * 64};
+    std::vector<std::thread>               threads;
+    std::atomic<int>                       wrong{0};
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 20'000; i++) {
+                auto const key = (i * 7 + t) % 1000;
+                if (auto const value = cache.get(key)) {
+                    if (*value != key * 2)
+                        wrong++;
+                } else {
+                    cache.set(key, key * 2);
+                }
+                if (i % 100 == 0)
+                    cache.erase(key);
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    EXPECT_EQ(wrong, 0);
+    EXPECT_LE(cache.weight(), 64 * 64);
+}
+
+TEST(Cache, GetOrSet) {
+    lru_cache<std::string, std::string> cache{4};
+    int                                 calls = 0;
+    auto const                          fill  = [&](std::string const& key) {
+        calls++;
+        return "value of " + key;
+    };
+    EXPECT_EQ(cache.get_or_set("a", fill), "value of a");
+    EXPECT_EQ(cache.get_or_set("a", fill), "value of a");
+    EXPECT_EQ(calls, 1);
+
+    tinylfu_cache<std::string, std::string> lfu{4};
+    auto const beta = [] {
+        return "beta";
+    };
+    EXPECT_EQ(lfu.get_or_set("b", beta), "beta");
+    EXPECT_TRUE(lfu.contains("b"));
+}
+
+TEST(Cache, SingleFlight) {
+    sharded_cache<lru_cache<std::string, std::string>, 4> cache{64};
+    std::atomic<int>                                      calls{0};
+    std::atomic<int>                                      waiting{0};
+    std::atomic<bool>                                     release{false};
+    std::vector<std::thread>                              threads;
+    std::vector<std::string>                              results(8);
+    for (std::size_t t = 0; t < results.size(); t++) {
+        threads.emplace_back([&, t] {
+            waiting++;
+            results[t] = cache.get_or_set("slow", [&] {
+                calls++;
+                // hold the flight until all of the threads have asked for it
+                while (!release)
+                    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+                return std::string{"computed"};
+            });
+        });
+    }
+    while (waiting != static_cast<int>(results.size()))
+        std::this_thread::yield();
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    release = true;
+    for (auto& thread : threads)
+        thread.join();
+    EXPECT_EQ(calls, 1) << "only one of them computes it";
+    for (auto const& result : results)
+        EXPECT_EQ(result, "computed");
+    EXPECT_EQ(cache.get("slow"), "computed");
+
+    // the exception goes to everyone that waits, and the next one tries again
+    auto const broken = []() -> std::string {
+        throw std::runtime_error{"backend is down"};
+    };
+    auto const fixed = [] {
+        return std::string{"fixed"};
+    };
+    EXPECT_THROW(static_cast<void>(cache.get_or_set("broken", broken)), std::runtime_error);
+    EXPECT_FALSE(cache.contains("broken"));
+    EXPECT_EQ(cache.get_or_set("broken", fixed), "fixed");
+}
+
+// the time only moves when the tests move it
+struct manual_clock {
+    using duration   = std::chrono::milliseconds;
+    using rep        = duration::rep;
+    using period     = duration::period;
+    using time_point = std::chrono::time_point<manual_clock>;
+
+    static constexpr bool is_steady = true;
+
+    static time_point& current() noexcept {
+        static time_point now{};
+        return now;
+    }
+
+    static time_point now() noexcept {
+        return current();
+    }
+};
+
+TEST(Cache, StaleWhileRevalidate) {
+    using namespace std::chrono_literals;
+    std::vector<std::function<void()>> tasks; // the refreshes that are waiting to run
+    refreshing_cache<std::string, std::string, lru_cache, 4, manual_clock> cache{
+      64,
+      {.soft_ttl = 10s, .hard_ttl = 60s, .jitter = 0},
+      [&tasks](std::function<void()> task) {
+          tasks.push_back(std::move(task));
+      }};
+
+    int        calls  = 0;
+    auto const loader = [&calls](std::string const& key) {
+        return key + std::to_string(++calls);
+    };
+    EXPECT_EQ(cache.get_or_set("a", loader), "a1");
+    EXPECT_EQ(cache.get_or_set("a", loader), "a1");
+    EXPECT_TRUE(tasks.empty());
+
+    // stale: it's served right away, and refreshed once in the background
+    manual_clock::current() += 20s;
+    EXPECT_EQ(cache.get_or_set("a", loader), "a1");
+    EXPECT_EQ(cache.get_or_set("a", loader), "a1");
+    EXPECT_EQ(tasks.size(), 1);
+    EXPECT_EQ(cache.refreshing(), 1);
+    tasks.front()();
+    tasks.clear();
+    EXPECT_EQ(cache.refreshing(), 0);
+    EXPECT_EQ(cache.get_or_set("a", loader), "a2");
+    EXPECT_TRUE(tasks.empty());
+
+    // a failed refresh keeps the stale one, and the next request tries again
+    manual_clock::current() += 20s;
+    auto const broken = [](std::string const&) -> std::string {
+        throw std::runtime_error{"backend is down"};
+    };
+    EXPECT_EQ(cache.get_or_set("a", broken), "a2");
+    tasks.front()();
+    tasks.clear();
+    EXPECT_EQ(cache.get("a"), "a2");
+    EXPECT_EQ(cache.get_or_set("a", loader), "a2");
+    EXPECT_EQ(tasks.size(), 1);
+    tasks.clear(); // dropped before it runs; the key stays "being refreshed"
+
+    // too old to be served: the request waits for the loader
+    manual_clock::current() += 60s;
+    EXPECT_FALSE(cache.get("a"));
+    EXPECT_EQ(cache.get_or_set("a", loader), "a3");
+    EXPECT_TRUE(tasks.empty());
+}
+
+TEST(Cache, RefreshesOnTheSharedPool) {
+    using namespace std::chrono_literals;
+    refreshing_cache<std::string, std::string, lru_cache, 4, manual_clock> cache{
+      64,
+      {.soft_ttl = 10s, .hard_ttl = 60s, .jitter = 0}};
+    std::atomic<bool> on_pool{false};
+    auto const        loader = [&on_pool](std::string const& key) {
+        on_pool = webpp::details::current_worker.pool == &webpp::details::refresh_pool();
+        return key + "!";
+    };
+    EXPECT_EQ(cache.get_or_set("key", loader), "key!");
+    EXPECT_FALSE(on_pool);
+
+    manual_clock::current() += 20s;
+    EXPECT_EQ(cache.get_or_set("key", loader), "key!");
+    for (int i = 0; i < 1000 && cache.refreshing() != 0; i++)
+        std::this_thread::sleep_for(1ms);
+    EXPECT_EQ(cache.refreshing(), 0);
+    EXPECT_TRUE(on_pool) << "it's refreshed in the background lane of the shared pool";
+}
+
+TEST(Cache, TTLJitter) {
+    using namespace std::chrono_literals;
+    std::vector<std::function<void()>> tasks;
+    refreshing_cache<std::string, std::string, lru_cache, 4, manual_clock> cache{
+      1024,
+      {.soft_ttl = 100s, .hard_ttl = 1000s, .jitter = 0.2},
+      [&tasks](std::function<void()> task) {
+          tasks.push_back(std::move(task));
+      }};
+    for (int i = 0; i < 200; i++)
+        cache.set("key" + std::to_string(i), "value");
+
+    // they were set together, but they go stale at different times within 80s to 120s
+    auto const identity = [](std::string const& key) {
+        return key;
+    };
+    auto const stale_after = [&](std::chrono::seconds elapsed) {
+        auto const start = manual_clock::current();
+        manual_clock::current() += elapsed;
+        tasks.clear();
+        for (int i = 0; i < 200; i++)
+            static_cast<void>(cache.get_or_set("key" + std::to_string(i), identity));
+        manual_clock::current() = start;
+        auto const res        = tasks.size();
+        for (auto& task : tasks)
+            task(); // so they're not "being refreshed" anymore
+        return res;
+    };
+    EXPECT_EQ(stale_after(79s), 0);
+    auto const halfway = stale_after(100s);
+    EXPECT_GT(halfway, 20);
+    EXPECT_LT(halfway, 180);
+}
+
+TEST(Cache, MemoryMapped) {
+    auto const path = std::filesystem::temp_directory_path() / ("webpp-cache-" + std::to_string(::getpid()));
+    std::filesystem::remove(path);
+    mmap_cache_options const options{.slot_count = 64, .key_size = 32, .value_size = 64};
+    {
+        mmap_cache cache{path, options};
+        ASSERT_TRUE(cache.is_open());
+        EXPECT_EQ(cache.capacity(), 64);
+        cache.set("a", "alpha").set(std::string{"b"}, std::string{"beta"});
+        EXPECT_EQ(cache.get("a"), "alpha");
+        EXPECT_EQ(cache.get("nope", "default"), "default");
+        cache.set("a", "again");
+        EXPECT_EQ(cache.get("a"), "again");
+        EXPECT_EQ(cache.size(), 2);
+
+        cache.set("big", std::string(65, 'x'));
+        EXPECT_FALSE(cache.contains("big")) << "it doesn't fit in a slot";
+        cache.set(std::string(33, 'k'), "value");
+        EXPECT_EQ(cache.size(), 2);
+
+        EXPECT_TRUE(cache.erase("b"));
+        EXPECT_FALSE(cache.erase("b"));
+        auto const compute = [] {
+            return std::string{"computed"};
+        };
+        EXPECT_EQ(cache.get_or_set("c", compute), "computed");
+    }
+    {
+        mmap_cache cache{path, options};
+        EXPECT_EQ(cache.get("a"), "again") << "it's still there after a restart";
+        EXPECT_EQ(cache.get("c"), "computed");
+        EXPECT_FALSE(cache.contains("b"));
+
+        // the workers of a host share it
+        auto const child = ::fork();
+        if (child == 0) {
+            mmap_cache other{path, options};
+            other.set("from-child", "hello");
+            ::_exit(other.get("a") == "again" ? 0 : 1);
+        }
+        int status = 0;
+        ::waitpid(child, &status, 0);
+        EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        EXPECT_EQ(cache.get("from-child"), "hello");
+
+        for (int i = 0; i < 1000; i++)
+            cache.set("key" + std::to_string(i), "value");
+        EXPECT_LE(cache.size(), 64) << "the old ones are replaced";
+        EXPECT_EQ(cache.get("key999"), "value");
+        cache.clear();
+        EXPECT_EQ(cache.size(), 0);
+    }
+    {
+        mmap_cache old_layout{path, options};
+        mmap_cache cache{path, {.slot_count = 128, .key_size = 32, .value_size = 64}};
+        EXPECT_EQ(cache.capacity(), 128);
+        EXPECT_FALSE(cache.contains("a")) << "it's formatted again for the new layout";
+        cache.set("a", "new");
+        old_layout.set("a", "old");
+        EXPECT_EQ(old_layout.get("a"), "old") << "the file that it has mapped is not touched";
+        EXPECT_EQ(cache.get("a"), "new");
+    }
+    {
+        // a writer that died while it had a slot; the slot's header is its sequence, then the owner
+        // at byte 32, and its key is where the header ends, under the next multiple of 64
+        mmap_cache cache{path, {.slot_count = 128, .key_size = 32, .value_size = 64}};
+        cache.set("stuck", "before");
+        std::string file(std::filesystem::file_size(path), '\0');
+        int const   fd = ::open(path.c_str(), O_RDWR);
+        ASSERT_NE(fd, -1);
+        ASSERT_EQ(::pread(fd, file.data(), file.size(), 0), static_cast<ssize_t>(file.size()));
+        auto const  slot  = static_cast<off_t>(file.find("stuckbefore") / 64 * 64);
+        auto const  child = ::fork();
+        if (child == 0)
+            ::_exit(0);
+        ::waitpid(child, nullptr, 0);
+        std::uint64_t seq = 0;
+        ASSERT_EQ(::pread(fd, &seq, sizeof(seq), slot), static_cast<ssize_t>(sizeof(seq)));
+        seq++;
+        pid_t owner = 1; // it's alive
+        ASSERT_EQ(::pwrite(fd, &seq, sizeof(seq), slot), static_cast<ssize_t>(sizeof(seq)));
+        ASSERT_EQ(::pwrite(fd, &owner, sizeof(owner), slot + 32), static_cast<ssize_t>(sizeof(owner)));
+        cache.set("stuck", "after");
+        EXPECT_FALSE(cache.contains("stuck")) << "its owner still has it";
+
+        owner = child;
+        ASSERT_EQ(::pwrite(fd, &owner, sizeof(owner), slot + 32), static_cast<ssize_t>(sizeof(owner)));
+        ::close(fd);
+        cache.set("stuck", "after");
+        EXPECT_EQ(cache.get("stuck"), "after") << "it's taken over";
+    }
+    std::filesystem::remove(path);
+
+    mmap_cache broken{"/nonexistent-dir/cache"};
+    EXPECT_FALSE(broken.is_open());
+    broken.set("a", "alpha");
+    EXPECT_FALSE(broken.get("a"));
 }
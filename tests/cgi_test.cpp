@@ -0,0 +1,152 @@
+#include "../core/include/webpp/http/bodies/string.hpp"
+#include "../core/include/webpp/http/interfaces/cgi.hpp"
+#include "../core/include/webpp/http/interfaces/common/cgi_variables.hpp"
+#include "../core/include/webpp/http/response.hpp"
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+using namespace webpp;
+
+TEST(CGI, HeaderNames) {
+    std::array<char, 32> buffer;
+    EXPECT_EQ(common::cgi_header_name("Accept-Encoding", buffer), "HTTP_ACCEPT_ENCODING");
+    EXPECT_EQ(buffer[20], '\0');
+    EXPECT_TRUE(common::cgi_header_name("X-A-Header-That-Is-Too-Long", buffer).empty());
+
+    std::string headers;
+    common::append_cgi_header(headers, "HTTP_ACCEPT_ENCODING", "gzip");
+    common::append_cgi_header(headers, "SERVER_NAME", "localhost");
+    EXPECT_EQ(headers, "ACCEPT-ENCODING: gzip\r\n");
+}
+
+TEST(CGI, EnvironIndex) {
+    char const* env[] = {"SERVER_NAME=localhost",
+                         "HTTP_HOST=example.com",
+                         "QUERY_STRING=",
+                         "HTTP_ACCEPT=*/*",
+                         "HTTP_HOST=second",
+                         "NOT_A_VARIABLE",
+                         "HTTPS=on",
+                         nullptr};
+    common::environ_index const index{env};
+    EXPECT_EQ(index.size(), 6);
+    EXPECT_EQ(index.get("SERVER_NAME"), "localhost");
+    EXPECT_EQ(index.get("HTTP_HOST"), "example.com"); // the first one, like getenv
+    EXPECT_EQ(index.get("QUERY_STRING"), "");
+    EXPECT_EQ(index.get("HTTP"), "");
+    EXPECT_EQ(index.get("UNKNOWN"), "");
+
+    std::string headers;
+    index.for_each_prefixed("HTTP_", [&](std::string_view name, std::string_view value) {
+        common::append_cgi_header(headers, name, value);
+    });
+    EXPECT_EQ(headers, "ACCEPT: */*\r\nHOST: example.com\r\nHOST: second\r\n");
+}
+
+namespace {
+    using string_response_type =
+      basic_response<std_traits, empty_extension_pack, response_headers<std_traits>, string_body::type<std_traits>>;
+
+    // each test gets its own app type, because the CGI state is per process
+    struct body_app {
+        template <typename RequestType>
+        string_response_type operator()(RequestType const& req) {
+            return string_response_type{200u, std::string{req.body()}};
+        }
+    };
+} // namespace
+
+TEST(CGI, StreamingBody) {
+    using request_type = basic_request<std_traits, cgi<std_traits, body_app>>;
+
+    // the web server doesn't close the stdin after the body
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    std::string_view const input = "0123456789";
+    ASSERT_EQ(::write(fds[1], input.data(), input.size()), static_cast<ssize_t>(input.size()));
+    int const saved = ::dup(0);
+    ::dup2(fds[0], 0);
+    ::setenv("CONTENT_LENGTH", "10", 1);
+
+    request_type const req;
+    EXPECT_EQ(req.body(4), "0123"); // bounded
+    std::array<char, 4> chunk;
+    std::string         rest;
+    for (std::size_t n; (n = req.read_body(chunk.data(), chunk.size())) != 0;) {
+        EXPECT_LE(n, chunk.size());
+        rest.append(chunk.data(), n);
+    }
+    EXPECT_EQ(rest, "456789");
+    EXPECT_EQ(req.read_body(chunk.data(), chunk.size()), 0);
+
+    ::unsetenv("CONTENT_LENGTH");
+    ::dup2(saved, 0);
+    ::close(saved);
+    ::close(fds[0]);
+    ::close(fds[1]);
+    std::cin.clear();
+}
+
+namespace {
+    struct hello_app {
+        template <typename RequestType>
+        string_response_type operator()(RequestType const&) {
+            return string_response_type{404u, std::string{"hello"}};
+        }
+    };
+} // namespace
+
+TEST(CGI, Response) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    int const saved = ::dup(1);
+    ::dup2(fds[1], 1);
+
+    cgi<std_traits, hello_app> app;
+    app();
+
+    ::dup2(saved, 1);
+    ::close(saved);
+    ::close(fds[1]);
+    std::string output;
+    char        buf[256];
+    for (ssize_t n; (n = ::read(fds[0], buf, sizeof(buf))) > 0;)
+        output.append(buf, static_cast<std::size_t>(n));
+    ::close(fds[0]);
+
+    EXPECT_TRUE(output.starts_with("Status: 404 Not Found\r\n")) << output;
+    EXPECT_NE(output.find("Content-Length: 5\r\n"), std::string::npos);
+    EXPECT_TRUE(output.ends_with("\r\n\r\nhello"));
+}
+
+#ifdef WEBPP_CGI_RAW_IO
+TEST(CGI, RawIOKeepsTheOrderOfStdio) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    std::fflush(stdout);
+    int const saved = ::dup(1);
+    ::dup2(fds[1], 1);
+
+    std::fputs("Set-Cookie: a=b\r\n", stdout); // still in the buffer of stdout
+    cgi<std_traits, hello_app> app;
+    app();
+
+    std::fflush(stdout);
+    ::dup2(saved, 1);
+    ::close(saved);
+    ::close(fds[1]);
+    std::string output;
+    char        buf[256];
+    for (ssize_t n; (n = ::read(fds[0], buf, sizeof(buf))) > 0;)
+        output.append(buf, static_cast<std::size_t>(n));
+    ::close(fds[0]);
+
+    EXPECT_TRUE(output.starts_with("Set-Cookie: a=b\r\nStatus: 404 Not Found\r\n")) << output;
+}
+#endif
@@ -1,6 +1,8 @@
 #include "../core/include/webpp/utils/charset.hpp"
 
 #include <gtest/gtest.h>
+#include <string>
+#include <string_view>
 
 using namespace webpp;
 
@@ -17,3 +19,57 @@ TEST(CharsetTest, CharsetCreation) {
     charset_t chars2{'1', '2', '3', '4', '5'};
     EXPECT_EQ(5, chars2.size());
 }
+
+TEST(CharsetTest, LikeALinearSearch) {
+    constexpr charset_t<char, 6> chars{'a', '%', '\x7f', '\x80', '\xff', '0'};
+    static_assert(chars.contains('\xff') && !chars.contains('b'));
+    static_assert(chars.contains(std::string_view{"a%0"}));
+    for (int i = 0; i < 256; i++) {
+        auto const c        = static_cast<char>(i);
+        bool const expected = std::string_view{chars.data(), chars.size()}.find(c) != std::string_view::npos;
+        EXPECT_EQ(chars.contains(c), expected) << i;
+    }
+
+    constexpr auto alpha_digit = ALPHA_DIGIT<char>;
+    std::string    str(100, 'x');
+    for (std::size_t size = 0; size <= str.size(); size++) {
+        auto const view = std::string_view{str}.substr(0, size);
+        EXPECT_TRUE(alpha_digit.contains(view)) << size;
+        for (std::size_t bad = 0; bad < size; bad++) {
+            for (char const c : {'-', '\0', '\x80', '\xfa'}) {
+                str[bad] = c;
+                EXPECT_FALSE(alpha_digit.contains(view)) << size << ' ' << bad;
+                str[bad] = bad % 3 == 0 ? 'Z' : '7';
+            }
+        }
+    }
+
+    constexpr charset_t<char32_t, 3> wide{U'a', U'\x100', U'\x1F600'};
+    static_assert(wide.contains(U'\x1F600') && wide.contains(U'a'));
+    static_assert(!wide.contains(U'\x1F601') && !wide.contains(U'\x00'));
+    EXPECT_TRUE(wide.contains(std::u32string_view{U"a\x100"}));
+    EXPECT_FALSE(wide.contains(std::u32string_view{U"ab"}));
+}
+
+TEST(CharsetTest, FindFirstIn) {
+    constexpr auto digits = DIGIT<char>;
+    static_assert(digits.find_first_not_in(std::string_view{"123a5"}) == 3);
+    static_assert(digits.find_first_in(std::string_view{"abc7"}) == 3);
+    static_assert(digits.find_first_in(std::string_view{"abc"}) == std::string_view::npos);
+
+    std::string_view const chars{digits.data(), digits.size()};
+    std::string            str(130, 'x');
+    for (std::size_t size = 0; size <= str.size(); size += 3) {
+        auto const view = std::string_view{str}.substr(0, size);
+        for (std::size_t at = 0; at < size; at++) {
+            str[at] = static_cast<char>('0' + at % 10);
+            for (std::size_t pos : {0ul, 1ul, 17ul, at, size}) {
+                ASSERT_EQ(digits.find_first_in(view, pos), view.find_first_of(chars, pos)) << size << ' ' << at;
+                ASSERT_EQ(digits.find_first_not_in(view, pos), view.find_first_not_of(chars, pos))
+                  << size << ' ' << at;
+            }
+            str[at] = at % 2 ? '\xff' : '/';
+        }
+        str.assign(str.size(), 'x');
+    }
+}
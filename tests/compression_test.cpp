@@ -0,0 +1,176 @@
+#include "../core/include/webpp/http/bodies/file.hpp"
+#include "../core/include/webpp/http/bodies/string.hpp"
+#include "../core/include/webpp/http/compression.hpp"
+#include "../core/include/webpp/http/response.hpp"
+#include "../core/include/webpp/http/static_file_cache.hpp"
+#include "../core/include/webpp/traits/std_traits.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+
+#ifdef WEBPP_TEST_BROTLI_DECODER
+#    include <brotli/decode.h>
+#endif
+
+using namespace webpp;
+
+namespace {
+    using string_response_type =
+      basic_response<std_traits, empty_extension_pack, response_headers<std_traits>, string_body::type<std_traits>>;
+    using file_response_type =
+      basic_response<std_traits, empty_extension_pack, response_headers<std_traits>, file_body::type<std_traits>>;
+
+    std::string some_text() {
+        std::string text;
+        for (int i = 0; i < 2000; i++)
+            text += "line " + std::to_string(i % 37) + " of the text that is compressed\n";
+        return text;
+    }
+
+    [[maybe_unused]] std::string gunzip(std::string_view data) {
+        std::string out;
+#ifdef WEBPP_USE_ZLIB
+        z_stream stream{};
+        if (::inflateInit2(&stream, 15 + 16) != Z_OK)
+            return out;
+        stream.next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        stream.avail_in = static_cast<uInt>(data.size());
+        std::array<char, 16 * 1024> buf{};
+        int                         res = Z_OK;
+        while (res == Z_OK) {
+            stream.next_out  = reinterpret_cast<Bytef*>(buf.data());
+            stream.avail_out = static_cast<uInt>(buf.size());
+            res              = ::inflate(&stream, Z_NO_FLUSH);
+            out.append(buf.data(), buf.size() - stream.avail_out);
+        }
+        ::inflateEnd(&stream);
+#endif
+        return out;
+    }
+
+    std::string header_value(auto const& res, well_known_header known) {
+        for (auto const& field : res.header)
+            if (field.known == known)
+                return std::string{field.value};
+        return {};
+    }
+} // namespace
+
+TEST(Compression, Negotiation) {
+    EXPECT_EQ(encoding_quality("gzip, deflate, br", content_encoding::br), 1000);
+    EXPECT_EQ(encoding_quality("gzip;q=0.5, br;q=0", content_encoding::gzip), 500);
+    EXPECT_EQ(encoding_quality("gzip;q=0.5, br;q=0", content_encoding::br), 0);
+    EXPECT_EQ(encoding_quality("*;q=0.2", content_encoding::gzip), 200);
+    EXPECT_EQ(encoding_quality("X-GZIP", content_encoding::gzip), 1000);
+    EXPECT_EQ(encoding_quality("deflate", content_encoding::gzip), 0);
+    EXPECT_EQ(encoding_quality("deflate", content_encoding::identity), 1000);
+
+    auto const all = [](content_encoding) constexpr noexcept {
+        return true;
+    };
+    static_assert(negotiate_encoding("gzip, br", all) == content_encoding::br);
+    static_assert(negotiate_encoding("gzip, br;q=0.8", all) == content_encoding::gzip);
+    static_assert(negotiate_encoding("", all) == content_encoding::identity);
+    EXPECT_EQ(negotiate_encoding("gzip, br", [](content_encoding encoding) noexcept {
+                  return encoding == content_encoding::gzip;
+              }),
+              content_encoding::gzip);
+
+    EXPECT_TRUE(is_compressible("text/html; charset=utf-8"));
+    EXPECT_TRUE(is_compressible("application/ld+json"));
+    EXPECT_FALSE(is_compressible("image/png"));
+}
+
+TEST(Compression, RoundTrip) {
+    auto const text = some_text();
+    for (int round = 0; round < 3; round++) { // the encoders of this thread are used again
+#ifdef WEBPP_USE_ZLIB
+        std::string gzip{"prefix"};
+        ASSERT_TRUE(compress(content_encoding::gzip, text, gzip));
+        EXPECT_TRUE(gzip.starts_with("prefix\x1f\x8b"));
+        EXPECT_LT(gzip.size(), text.size() / 4);
+        EXPECT_EQ(gunzip(std::string_view{gzip}.substr(6)), text);
+#endif
+#ifdef WEBPP_USE_BROTLI
+        std::string br;
+        ASSERT_TRUE(compress(content_encoding::br, text, br));
+        EXPECT_LT(br.size(), text.size() / 4);
+#    ifdef WEBPP_TEST_BROTLI_DECODER
+        std::string decoded(text.size(), '\0');
+        auto        decoded_size = decoded.size();
+        ASSERT_EQ(::BrotliDecoderDecompress(br.size(), reinterpret_cast<uint8_t const*>(br.data()),
+                                            &decoded_size, reinterpret_cast<uint8_t*>(decoded.data())),
+                  BROTLI_DECODER_RESULT_SUCCESS);
+        decoded.resize(decoded_size);
+        EXPECT_EQ(decoded, text);
+#    endif
+#endif
+    }
+    std::string identity;
+    EXPECT_FALSE(compress(content_encoding::identity, text, identity));
+}
+
+TEST(Compression, Response) {
+    auto const expected = negotiate_encoding("gzip, br");
+    if (expected == content_encoding::identity)
+        GTEST_SKIP() << "no encoders are compiled in";
+
+    string_response_type res{200u, some_text()};
+    res.header.emplace("Content-Type", "text/plain");
+    compress_response(res, "gzip, br");
+    EXPECT_EQ(header_value(res, well_known_header::content_encoding), encoding_name(expected));
+    EXPECT_EQ(header_value(res, well_known_header::vary), "Accept-Encoding");
+    EXPECT_LT(res.body.str().size(), some_text().size());
+    if (expected == content_encoding::gzip) {
+        EXPECT_EQ(gunzip(res.body.str()), some_text());
+    }
+
+    // the ones that are left alone
+    string_response_type small{200u, "hello"};
+    compress_response(small, "gzip, br");
+    EXPECT_FALSE(small.header.contains(well_known_header::content_encoding));
+
+    string_response_type image{200u, some_text()};
+    image.header.emplace("Content-Type", "image/png");
+    compress_response(image, "gzip, br");
+    EXPECT_EQ(image.body.str(), some_text());
+
+    string_response_type not_accepted{200u, some_text()};
+    compress_response(not_accepted, "identity");
+    EXPECT_EQ(not_accepted.body.str(), some_text());
+}
+
+TEST(Compression, Sidecars) {
+    auto const dir = std::filesystem::temp_directory_path() / "webpp_compression_test";
+    std::filesystem::create_directories(dir);
+    std::ofstream{dir / "app.js"} << "console.log('plain');";
+    std::ofstream{dir / "app.js.br"} << "brotli bytes";
+    std::ofstream{dir / "app.js.gz"} << "gzip bytes";
+
+    static_file_cache cache;
+    auto              br = file_response<file_response_type>(cache, dir / "app.js", "gzip, deflate, br");
+    EXPECT_EQ(br.body.str(), "brotli bytes");
+    EXPECT_EQ(header_value(br, well_known_header::content_encoding), "br");
+    EXPECT_EQ(header_value(br, well_known_header::content_type), "text/javascript; charset=utf-8");
+    EXPECT_EQ(header_value(br, well_known_header::content_length), "12");
+    EXPECT_EQ(header_value(br, well_known_header::vary), "Accept-Encoding");
+
+    auto gzip = file_response<file_response_type>(cache, dir / "app.js", "gzip, br;q=0.5");
+    EXPECT_EQ(gzip.body.str(), "gzip bytes");
+    EXPECT_EQ(header_value(gzip, well_known_header::content_encoding), "gzip");
+
+    auto plain = file_response<file_response_type>(cache, dir / "app.js", "deflate");
+    EXPECT_EQ(plain.body.str(), "console.log('plain');");
+    EXPECT_FALSE(plain.header.contains(well_known_header::content_encoding));
+
+    // the big ones are sent from the disk
+    static_file_cache small{{.max_file_size = 4}};
+    auto              big = file_response<file_response_type>(small, dir / "app.js", "br");
+    EXPECT_NE(big.body.native_handle(), -1);
+    EXPECT_EQ(big.body.str(), "brotli bytes");
+    EXPECT_EQ(header_value(big, well_known_header::content_encoding), "br");
+
+    std::filesystem::remove_all(dir);
+}
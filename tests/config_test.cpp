@@ -0,0 +1,95 @@
+#include "../core/include/webpp/config.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace webpp;
+
+TEST(Config, ParseIni) {
+    auto const values = config_snapshot::parse_ini(R"(
+; the comments
+name = webpp
+port = 8080
+
+[server]
+timeout = 30
+keep_alive = yes
+title = " hello "
+# the last one wins
+timeout = 45
+)");
+    ASSERT_TRUE(values.has_value());
+    EXPECT_EQ(values->size(), 5);
+    EXPECT_EQ(values->get_or("name", ""), "webpp");
+    EXPECT_EQ(values->get_as("port", 0), 8080);
+    EXPECT_EQ(values->get_as("server.timeout", 0), 45);
+    EXPECT_TRUE(values->get_as("server.keep_alive", false));
+    EXPECT_EQ(values->get_or("server.title", ""), " hello ");
+    EXPECT_EQ(values->get_as("name", 7), 7) << "not a number";
+    EXPECT_FALSE(values->get("timeout").has_value());
+
+    EXPECT_FALSE(config_snapshot::parse_ini("[server\nport = 1").has_value());
+    EXPECT_FALSE(config_snapshot::parse_ini("just a line").has_value());
+}
+
+TEST(Config, Publish) {
+    config cfg;
+    EXPECT_EQ(cfg.generation(), 0);
+
+    config::reader settings{cfg};
+    EXPECT_EQ(settings->size(), 0);
+
+    int calls = 0;
+    cfg.subscribe([&](config_snapshot const& values) {
+        calls++;
+        EXPECT_EQ(&values, cfg.snapshot().get());
+    });
+
+    EXPECT_TRUE(cfg.load("port = 80"));
+    EXPECT_EQ(cfg.generation(), 1);
+    EXPECT_EQ(settings->get_as("port", 0), 80);
+
+    auto const old = cfg.snapshot();
+    cfg.set("port", "81");
+    EXPECT_EQ(settings->get_as("port", 0), 81);
+    EXPECT_EQ(old->get_as("port", 0), 80) << "the old snapshot is never changed";
+
+    EXPECT_FALSE(cfg.load("[broken"));
+    EXPECT_EQ(settings->get_as("port", 0), 81);
+    EXPECT_EQ(calls, 2);
+
+    auto const path = std::filesystem::temp_directory_path() / "webpp_config_test.ini";
+    std::ofstream{path} << "[a]\nb = c\n";
+    EXPECT_TRUE(cfg.load_file(path));
+    EXPECT_EQ(settings->get_or("a.b", ""), "c");
+    EXPECT_FALSE(settings->contains("port"));
+    std::filesystem::remove(path);
+}
+
+TEST(Config, ConcurrentReaders) {
+    config            cfg{config_snapshot{{{"value", "0"}}}};
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++) {
+        readers.emplace_back([&] {
+            config::reader settings{cfg};
+            int            last = 0;
+            while (!done.load()) {
+                auto const now = settings->get_as("value", -1);
+                EXPECT_GE(now, last) << "the snapshots only go forward";
+                last = now;
+            }
+        });
+    }
+    for (int i = 1; i <= 200; i++)
+        cfg.set("value", std::to_string(i));
+    done = true;
+    for (auto& reader : readers)
+        reader.join();
+    EXPECT_EQ(config::reader{cfg}->get_as("value", 0), 200);
+}
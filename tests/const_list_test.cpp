@@ -32,3 +32,22 @@ TEST(ConstListTest, ConstList) {
 
     EXPECT_EQ(str_one, "one two 3");
 }
+
+TEST(ConstListTest, MakeConstList) {
+    constexpr auto one = make_const_list(1, 2.0, 'c');
+    static_assert(std::is_same_v<decltype(one), const_list<int, double, char> const>,
+                  "make_const_list should be the same as appending them");
+    static_assert(std::is_same_v<decltype(const_list(1) + 2.0 + 'c'), const_list<int, double, char>>);
+    static_assert(one.size() == 3);
+    static_assert(one.at<2>() == 'c');
+    static_assert(one.next().value() == 2.0);
+    static_assert(one.has('c') && !one.has(5));
+    static_assert(one == make_const_list(1, 2.0, 'c'));
+
+    int calls = 0;
+    one.do_once([&](auto const& value) {
+        ++calls;
+        return value == 2;
+    });
+    EXPECT_EQ(calls, 2);
+}
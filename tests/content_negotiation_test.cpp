@@ -0,0 +1,76 @@
+#include "../core/include/webpp/http/content_negotiation.hpp"
+
+#include <array>
+#include <atomic>
+#include <gtest/gtest.h>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace webpp;
+
+TEST(ContentNegotiation, ParseAccept) {
+    auto const list = parse_accept("text/html;level=1, application/xml;q=0.9, */*;q=0.8, TEXT/Plain ; q=0.9 ;ext");
+    ASSERT_EQ(list.size(), 4);
+    EXPECT_EQ(list[0].value, "text/html");
+    EXPECT_EQ(list[0].quality, 1000);
+    EXPECT_EQ(list[1].value, "application/xml");
+    EXPECT_EQ(list[2].value, "text/plain") << "lowercased, and the ties keep their order";
+    EXPECT_EQ(list[2].quality, 900);
+    EXPECT_EQ(list[3].value, "*/*");
+    EXPECT_EQ(list[3].quality, 800);
+
+    EXPECT_EQ(parse_accept("a;q=0.123, b;q=1.0, c;q=2, d;q=0.1234, , e").size(), 5);
+    EXPECT_EQ(details::parse_qvalue("0.123"), 123);
+    EXPECT_EQ(details::parse_qvalue("1.000"), 1000);
+    EXPECT_EQ(details::parse_qvalue("2"), 0);
+    EXPECT_EQ(details::parse_qvalue("0.1234"), 0);
+    EXPECT_TRUE(parse_accept("").empty());
+}
+
+TEST(ContentNegotiation, Negotiate) {
+    std::array<std::string_view, 2> const types{"application/json", "text/html"};
+    EXPECT_EQ(negotiate(parse_accept("text/html, application/json;q=0.9"), accept_kind::media_type, types), 1);
+    EXPECT_EQ(negotiate(parse_accept("text/*;q=0.5, */*;q=0.1"), accept_kind::media_type, types), 1);
+    EXPECT_EQ(negotiate(parse_accept("*/*"), accept_kind::media_type, types), 0) << "the server's preference";
+    EXPECT_EQ(negotiate(parse_accept("text/*, text/html;q=0"), accept_kind::media_type, types), std::nullopt)
+      << "the most specific range wins";
+    EXPECT_EQ(negotiate(parse_accept(""), accept_kind::media_type, types), 0);
+
+    std::array<std::string_view, 3> const languages{"en-US", "fr", "de-DE"};
+    EXPECT_EQ(negotiate(parse_accept("de, en;q=0.8"), accept_kind::language, languages), 2);
+    EXPECT_EQ(negotiate(parse_accept("en-us;q=0.5, fr;q=0.7"), accept_kind::language, languages), 1);
+    EXPECT_EQ(negotiate(parse_accept("e"), accept_kind::language, languages), std::nullopt);
+
+    std::array<std::string_view, 2> const encodings{"gzip", "br"};
+    EXPECT_EQ(negotiate(parse_accept("gzip;q=0.5, br"), accept_kind::encoding, encodings), 1);
+    EXPECT_EQ(negotiate(parse_accept("*;q=0.1, gzip;q=0"), accept_kind::encoding, encodings), 1);
+}
+
+TEST(ContentNegotiation, Negotiator) {
+    accept_negotiator types{accept_kind::media_type, {"application/json", "text/html"}};
+    EXPECT_EQ(types.choose("text/html,application/xhtml+xml,*/*;q=0.8"), "text/html");
+    EXPECT_EQ(types.choose("text/html,application/xhtml+xml,*/*;q=0.8"), "text/html");
+    EXPECT_EQ(types.choose("image/png"), std::nullopt);
+    EXPECT_EQ(types.choose_index("application/*"), 0);
+    EXPECT_EQ(types.memoized(), 3);
+
+    std::string const huge(accept_negotiator::max_memoized_size + 1, ' ');
+    EXPECT_EQ(types.choose(huge), "application/json");
+    EXPECT_EQ(types.memoized(), 3) << "too long to remember";
+
+    std::atomic<int>         wrong{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 1000; i++) {
+                if (types.choose(i % 2 ? "text/html" : "application/json;q=0.9, text/*;q=0.5") !=
+                    (i % 2 ? "text/html" : "application/json"))
+                    wrong++;
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    EXPECT_EQ(wrong, 0);
+}
@@ -1,5 +1,6 @@
 // Created by moisrex on 7/1/20.
 #include "../core/include/webpp/http/interfaces/cgi.hpp"
+#include "../core/include/webpp/http/interfaces/fcgi.hpp"
 #include "../core/include/webpp/http/request.hpp"
 #include "../core/include/webpp/http/routes/context.hpp"
 #include "../core/include/webpp/http/routes/literals.hpp"
@@ -46,3 +47,101 @@ TEST(Routes, PathTests) {
     EXPECT_TRUE(nctx.test);
 }
 
+
+TEST(Routes, PathSegments) {
+    auto const segs = path_segments::parse("/users/12/posts?page=2#top");
+    ASSERT_EQ(segs.size(), 4);
+    EXPECT_EQ(segs[0], "");
+    EXPECT_EQ(segs[1], "users");
+    EXPECT_EQ(segs[3], "posts");
+    EXPECT_FALSE(segs.overflowed());
+    EXPECT_TRUE(path_segments::parse("").empty());
+    EXPECT_EQ(path_segments::parse("/").size(), 2);
+
+    std::string long_path;
+    for (int i = 0; i < 20; i++)
+        long_path += "/x";
+    auto const truncated = path_segments::parse(long_path);
+    EXPECT_EQ(truncated.size(), path_segments::capacity);
+    EXPECT_TRUE(truncated.overflowed());
+}
+
+namespace {
+    struct fcgi_app {};
+} // namespace
+
+TEST(Routes, SegmentsCache) {
+    using fcgi_request = basic_request<std_traits, fcgi<std_traits, fcgi_app>>;
+    fastcgi::request source;
+    source.params += char(11);
+    source.params += char(6);
+    source.params += "REQUEST_URI/a/b/c";
+    fcgi_request req{source};
+
+    simple_context<fcgi_request> ctx{req};
+    auto const&                  segs = ctx.segments();
+    EXPECT_EQ(segs.size(), 4);
+    EXPECT_EQ(&segs, &ctx.segments()); // parsed once
+
+    // the clones get the already-parsed segments
+    auto nctx = ctx.template clone<fake_mommy>();
+    EXPECT_EQ(nctx.segments().size(), 4);
+    EXPECT_EQ(nctx.segments()[2].data(), segs[2].data());
+
+    // the path routes' extension is a child extension of the context
+    using path_extension = path_context_extension<path<>, path_segments>;
+    static_assert(ChildExtension<path_extension::path_extension>);
+    auto pctx = ctx.template clone<path_extension>();
+    EXPECT_EQ(pctx.request, &req);
+    EXPECT_EQ(pctx.path.pth, nullptr);
+    EXPECT_EQ(pctx.segments().size(), 4);
+}
+
+namespace {
+    template <int N>
+    struct child_field {
+        struct extension {
+            template <Traits TraitsType, typename ContextType>
+            struct type : public ContextType {
+                template <typename... Args>
+                constexpr type(Args&&... args) noexcept : ContextType{std::forward<Args>(args)...} {}
+
+                int value = N;
+            };
+        };
+
+        using context_extensions = extension_pack<extension>;
+    };
+
+    template <typename ContextType>
+    std::ptrdiff_t offset_of(ContextType const& ctx, void const* field) {
+        return static_cast<char const*>(field) - reinterpret_cast<char const*>(&ctx);
+    }
+} // namespace
+
+TEST(Routes, ContextLayout) {
+    using fcgi_request = basic_request<std_traits, fcgi<std_traits, fcgi_app>>;
+    fastcgi::request source;
+    source.params += char(11);
+    source.params += char(6);
+    source.params += "REQUEST_URI/a/b/c";
+    fcgi_request req{source};
+
+    simple_context<fcgi_request> ctx{req};
+    static_cast<void>(ctx.segments());
+
+    // more than one child extension: they're stacked, not virtual bases of each other
+    auto nctx = ctx.template clone<fake_mommy, child_field<1>::extension, child_field<2>::extension>();
+    EXPECT_EQ(nctx.request, &req);
+    EXPECT_TRUE(nctx.test);
+    EXPECT_EQ(nctx.segments().size(), 4);
+    static_assert(!std::is_polymorphic_v<decltype(nctx)>);
+    static_assert(sizeof(nctx) <= sizeof(ctx) + 16, "no virtual base pointers");
+
+    // the hot fields are at the start, whatever the extensions add
+    for (auto const offset : {offset_of(nctx, &nctx.request), offset_of(nctx, &nctx.router_features),
+                              offset_of(nctx, &nctx.cancellation)}) {
+        EXPECT_GE(offset, 0);
+        EXPECT_LT(offset, 64);
+    }
+}
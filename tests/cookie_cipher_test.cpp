@@ -0,0 +1,161 @@
+#include "../core/include/webpp/http/cookies/cookie_cipher.hpp"
+
+#include "../core/include/webpp/http/cookies/cookie_jar.hpp"
+#include "../core/include/webpp/traits/std_traits.hpp"
+
+#include <array>
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace webpp;
+
+namespace {
+    std::array<unsigned char, cookie_cipher::key_size> make_key(unsigned char seed) {
+        std::array<unsigned char, cookie_cipher::key_size> key{};
+        for (std::size_t i = 0; i < key.size(); i++)
+            key[i] = static_cast<unsigned char>(seed + i * 7);
+        return key;
+    }
+} // namespace
+
+TEST(CookieCipher, Base64URL) {
+    std::string_view const data = "any carnal pleas\xff\xfe";
+    for (std::size_t size = 0; size <= data.size(); size++) {
+        std::string encoded(details::base64url_size(size), '\0');
+        details::base64url_encode(reinterpret_cast<unsigned char const*>(data.data()), size, encoded.data());
+        EXPECT_EQ(encoded.find_first_of("+/="), std::string::npos);
+        std::array<unsigned char, 32> decoded{};
+        ASSERT_EQ(details::base64url_decode(encoded, decoded.data()), size);
+        EXPECT_EQ(std::string_view(reinterpret_cast<char const*>(decoded.data()), size),
+                  data.substr(0, size));
+    }
+    std::array<unsigned char, 8> out{};
+    EXPECT_EQ(details::base64url_decode("YW5=", out.data()), std::string_view::npos);
+    EXPECT_EQ(details::base64url_decode("YW5hb", out.data()), std::string_view::npos);
+}
+
+TEST(CookieCipher, SealAndOpen) {
+    if constexpr (!cookie_cipher::is_available())
+        GTEST_SKIP() << "the encryption is not compiled in";
+
+    for (auto const algorithm :
+         {cookie_cipher_algorithm::aes_256_gcm, cookie_cipher_algorithm::chacha20_poly1305}) {
+        cookie_cipher cipher{algorithm};
+        std::string   sealed;
+        EXPECT_FALSE(cipher.seal("session", "state", sealed)) << "there's no key";
+        ASSERT_TRUE(cipher.rotate(make_key(1)));
+
+        ASSERT_TRUE(cipher.seal("session", "user=42; role=admin", sealed));
+        EXPECT_EQ(sealed.size(), details::base64url_size(cookie_cipher::overhead + 19));
+        std::string again;
+        ASSERT_TRUE(cipher.seal("session", "user=42; role=admin", again));
+        EXPECT_NE(sealed, again) << "the nonces are not reused";
+
+        std::string value = "old:";
+        ASSERT_TRUE(cipher.open("session", sealed, value));
+        EXPECT_EQ(value, "old:user=42; role=admin");
+
+        std::string forged;
+        EXPECT_FALSE(cipher.open("other", sealed, forged)) << "the name is authenticated";
+        auto changed = sealed;
+        changed[changed.size() / 2] = changed[changed.size() / 2] == 'A' ? 'B' : 'A';
+        EXPECT_FALSE(cipher.open("session", changed, forged));
+        EXPECT_FALSE(cipher.open("session", sealed.substr(0, sealed.size() - 4), forged));
+        EXPECT_FALSE(cipher.open("session", "not sealed", forged));
+        EXPECT_TRUE(forged.empty());
+
+        std::string empty;
+        ASSERT_TRUE(cipher.seal("e", "", empty));
+        ASSERT_TRUE(cipher.open("e", empty, forged));
+        EXPECT_TRUE(forged.empty());
+        EXPECT_FALSE(cipher.seal("big", std::string(cookie_cipher::max_value_size + 1, 'x'), empty));
+    }
+}
+
+TEST(CookieCipher, Rotation) {
+    if constexpr (!cookie_cipher::is_available())
+        GTEST_SKIP() << "the encryption is not compiled in";
+
+    cookie_cipher cipher;
+    ASSERT_TRUE(cipher.rotate(make_key(1)));
+    std::string first;
+    ASSERT_TRUE(cipher.seal("session", "first", first));
+
+    ASSERT_TRUE(cipher.rotate(make_key(2)));
+    std::string second;
+    ASSERT_TRUE(cipher.seal("session", "second", second));
+    std::array<unsigned char, 64> first_raw{};
+    std::array<unsigned char, 64> second_raw{};
+    details::base64url_decode(first, first_raw.data());
+    details::base64url_decode(second, second_raw.data());
+    EXPECT_NE(first_raw[0], second_raw[0]) << "the key id is different";
+
+    std::string value;
+    EXPECT_TRUE(cipher.open("session", first, value)) << "the old keys still open the old cookies";
+    EXPECT_EQ(value, "first");
+
+    for (unsigned char seed = 3; seed < 3 + cookie_cipher::max_keys - 1; seed++)
+        ASSERT_TRUE(cipher.rotate(make_key(seed)));
+    value.clear();
+    EXPECT_FALSE(cipher.open("session", first, value)) << "the first key is dropped";
+    EXPECT_TRUE(cipher.open("session", second, value));
+    EXPECT_EQ(value, "second");
+
+    cookie_cipher other;
+    ASSERT_TRUE(other.rotate());
+    value.clear();
+    EXPECT_FALSE(other.open("session", second, value));
+}
+
+TEST(CookieCipher, Threads) {
+    if constexpr (!cookie_cipher::is_available())
+        GTEST_SKIP() << "the encryption is not compiled in";
+
+    cookie_cipher cipher{cookie_cipher_algorithm::chacha20_poly1305};
+    ASSERT_TRUE(cipher.rotate(make_key(9)));
+    std::vector<int>         failures(4, 0);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < failures.size(); t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 2'000; i++) {
+                auto const  value = "thread " + std::to_string(t) + " value " + std::to_string(i);
+                std::string sealed;
+                std::string opened;
+                if (!cipher.seal("c", value, sealed) || !cipher.open("c", sealed, opened) || opened != value)
+                    failures[t]++;
+                if (t == 0 && i % 500 == 0)
+                    cipher.rotate(make_key(static_cast<unsigned char>(i / 500 + 10)));
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    for (auto const failure : failures)
+        EXPECT_EQ(failure, 0);
+}
+
+TEST(CookieCipher, CookieJar) {
+    if constexpr (!cookie_cipher::is_available())
+        GTEST_SKIP() << "the encryption is not compiled in";
+
+    cookie_cipher cipher;
+    ASSERT_TRUE(cipher.rotate(make_key(4)));
+    response_cookie_jar<std_traits> jar;
+    jar.emplace_back("session", "secret").encrypted(true);
+    jar.emplace_back("theme", "dark");
+    ASSERT_TRUE(cipher.seal_cookies(jar));
+
+    EXPECT_FALSE(jar.find("session")->encrypted());
+    EXPECT_NE(jar.find("session")->value(), "secret");
+    EXPECT_EQ(jar.find("theme")->value(), "dark");
+    std::string value;
+    ASSERT_TRUE(cipher.open("session", jar.find("session")->value(), value));
+    EXPECT_EQ(value, "secret");
+
+    auto const sealed = jar.find("session")->value();
+    ASSERT_TRUE(cipher.seal_cookies(jar));
+    EXPECT_EQ(jar.find("session")->value(), sealed) << "they're not sealed twice";
+}
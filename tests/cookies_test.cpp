@@ -1,9 +1,13 @@
 #include "../core/include/webpp/http/cookies/cookie.hpp"
+#include "../core/include/webpp/http/cookies/cookie_header.hpp"
 #include "../core/include/webpp/http/cookies/cookie_jar.hpp"
 #include "../core/include/webpp/traits/std_traits.hpp"
 
 #include <gtest/gtest.h>
 #include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
 
 
 using res_cookie_t     = webpp::response_cookie<webpp::std_traits>;
@@ -164,6 +168,83 @@ TEST(ResponseCookies, StringParsing) {
     EXPECT_EQ("value", c.value());
 }
 
+TEST(ResponseCookies, Serialize) {
+    res_cookie_t c("session", "abc");
+    c.path("/").domain("example.com").secure(true).host_only(true).max_age(3600);
+    c.expires(std::chrono::system_clock::time_point{std::chrono::seconds{784'111'777}});
+    std::string const expected = "session=abc; Domain=example.com; Path=/; "
+                                 "Expires=Sun, 06 Nov 1994 08:49:37 GMT; Secure; HttpOnly; Max-Age=3600";
+    EXPECT_EQ(c.render(), expected);
+    EXPECT_FALSE(c.is_serialized());
+
+    c.serialize();
+    EXPECT_TRUE(c.is_serialized());
+    std::string out = "Set-Cookie: ";
+    c.append_to(out);
+    EXPECT_EQ(out, "Set-Cookie: " + expected);
+    EXPECT_EQ(c.response_str(), expected);
+
+    auto copy = c;
+    EXPECT_TRUE(copy.is_serialized());
+    c.value("def");
+    EXPECT_FALSE(c.is_serialized()) << "the setters drop the serialized value";
+    EXPECT_EQ(c.render().substr(0, 12), "session=def;");
+    EXPECT_EQ(copy.render(), expected);
+    c.serialize().same_site(res_cookie_t::same_site_value::STRICT);
+    EXPECT_FALSE(c.is_serialized());
+    EXPECT_NE(c.render().find("; SameSite=Strict"), std::string::npos);
+}
+
 TEST(ResponseCookies, ResponseCookiesEncryption) {
     // TODO
 }
+
+TEST(RequestCookies, HeaderView) {
+    constexpr std::string_view header = " a=1;b = two ;;  quoted=\"x y\"; flag; empty=; a=again ";
+    webpp::cookie_header_view const cookies{header};
+    ASSERT_EQ(cookies.size(), 6);
+    EXPECT_FALSE(cookies.overflowed());
+    EXPECT_EQ(cookies[0].name, "a");
+    EXPECT_EQ(cookies[0].value, "1");
+    EXPECT_EQ(cookies[1].name, "b");
+    EXPECT_EQ(cookies[1].value, "two");
+    EXPECT_EQ(cookies[2].value, "x y") << "the double quotes are not in the value";
+    EXPECT_EQ(cookies[3].name, "") << "the ones without a = are values without a name";
+    EXPECT_EQ(cookies[3].value, "flag");
+    EXPECT_EQ(cookies.value("a"), "1") << "the first one wins";
+    EXPECT_TRUE(cookies.contains("empty"));
+    EXPECT_EQ(cookies.value("empty"), "");
+    EXPECT_FALSE(cookies.contains("missing"));
+    EXPECT_FALSE(cookies.contains("A")) << "the names are case-sensitive";
+    EXPECT_EQ(cookies[0].name.data(), header.data() + 1) << "they're views into the header";
+
+    static_assert(webpp::find_cookie_value("x=1; y=2", "y") == "2");
+    EXPECT_TRUE(webpp::cookie_header_view<>{""}.empty());
+    EXPECT_TRUE(webpp::cookie_header_view<>{" ; ;"}.empty());
+
+    std::string decoded;
+    EXPECT_TRUE(webpp::decode_cookie_value("a%3Db+c%e2%9c%93", decoded));
+    EXPECT_EQ(decoded, "a=b+c\xe2\x9c\x93");
+    EXPECT_FALSE(webpp::decode_cookie_value("100%", decoded));
+    EXPECT_FALSE(webpp::decode_cookie_value("%g0", decoded));
+}
+
+TEST(RequestCookies, ManyCookies) {
+    std::string header;
+    for (int i = 0; i < 45; i++)
+        header += "_tracker" + std::to_string(i) + "=value" + std::to_string(i) + "; ";
+
+    webpp::cookie_header_view<32> const cookies{header};
+    EXPECT_EQ(cookies.size(), 32);
+    EXPECT_TRUE(cookies.overflowed());
+    EXPECT_EQ(cookies.value("_tracker31"), "value31");
+    EXPECT_EQ(cookies.value("_tracker44"), "value44") << "the ones after the capacity are found too";
+    EXPECT_FALSE(cookies.contains("_tracker45"));
+
+    std::vector<std::string_view> names;
+    cookies.for_each([&](webpp::cookie_pair const& pair) {
+        names.push_back(pair.name);
+    });
+    ASSERT_EQ(names.size(), 45);
+    EXPECT_EQ(names.back(), "_tracker44");
+}
@@ -0,0 +1,72 @@
+#include "../core/include/webpp/traits/std_counting_traits.hpp"
+
+#include "../core/include/webpp/http/bodies/string.hpp"
+#include "../core/include/webpp/http/interfaces/fcgi.hpp"
+#include "../core/include/webpp/http/response.hpp"
+#include "../core/include/webpp/http/routes/router.hpp"
+#include "../core/include/webpp/traits/traits_concepts.hpp"
+
+#include <gtest/gtest.h>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+using namespace webpp;
+
+static_assert(Traits<std_counting_traits>);
+
+namespace {
+    struct counting_app {};
+
+    using counting_request = basic_request<std_counting_traits, fcgi<std_counting_traits, counting_app>>;
+
+    struct fake_counting_request {
+        fastcgi::request source;
+        counting_request req{source};
+
+        fake_counting_request(std::string_view uri) {
+            source.params += char(11);
+            source.params += char(uri.size());
+            source.params += "REQUEST_URI";
+            source.params += uri;
+        }
+    };
+} // namespace
+
+TEST(CountingAllocator, Strings) {
+    auto const before = allocation_stats::local();
+    {
+        std_counting_traits::string_type small{"short"};
+        EXPECT_EQ((allocation_stats::local() - before).allocations, 0);
+
+        std_counting_traits::string_type big(100, 'a');
+        auto const used = allocation_stats::local() - before;
+        EXPECT_EQ(used.allocations, 1);
+        EXPECT_GE(used.bytes, 100);
+    }
+    auto const used = allocation_stats::local() - before;
+    EXPECT_EQ(used.deallocations, used.allocations);
+
+    // the stats are per thread
+    std::thread{[] {
+        std_counting_traits::string_type big(100, 'a');
+    }}.join();
+    EXPECT_EQ((allocation_stats::local() - before).allocations, used.allocations);
+}
+
+TEST(CountingAllocator, Router) {
+    router _router{[](Context auto& ctx) noexcept -> std::optional<std::string_view> {
+        if (ctx.request->request_uri() == "/about")
+            return "about";
+        return std::nullopt;
+    }};
+
+    fake_counting_request about{"/about"};
+    auto const            before = allocation_stats::local();
+    auto                  res    = _router(about.req);
+    EXPECT_EQ(res.header.status_code, 200);
+    EXPECT_EQ(res.body.str(), "about");
+    res.calculate_default_headers();
+    EXPECT_GT((allocation_stats::local() - before).allocations, 0);
+}
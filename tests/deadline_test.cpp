@@ -0,0 +1,62 @@
+#include "../core/include/webpp/utils/deadline.hpp"
+
+#include <chrono>
+#include <gtest/gtest.h>
+
+using namespace webpp;
+using namespace std::chrono_literals;
+
+TEST(Deadline, ParseTimeout) {
+    EXPECT_EQ(parse_timeout("250m"), std::chrono::milliseconds{250});
+    EXPECT_EQ(parse_timeout("5S"), std::chrono::seconds{5});
+    EXPECT_EQ(parse_timeout("5"), std::chrono::seconds{5}) << "the digits alone are seconds";
+    EXPECT_EQ(parse_timeout("2M"), std::chrono::minutes{2});
+    EXPECT_EQ(parse_timeout("1H"), std::chrono::hours{1});
+    EXPECT_EQ(parse_timeout("10u"), std::chrono::microseconds{10});
+    EXPECT_EQ(parse_timeout("10n"), std::chrono::nanoseconds{10});
+    EXPECT_EQ(parse_timeout("99999999H"), deadline_clock::duration::max()) << "it doesn't overflow";
+    EXPECT_FALSE(parse_timeout(""));
+    EXPECT_FALSE(parse_timeout("m"));
+    EXPECT_FALSE(parse_timeout("10x"));
+    EXPECT_FALSE(parse_timeout("10mS"));
+    EXPECT_FALSE(parse_timeout("123456789m")) << "more than 8 digits";
+    static_assert(parse_timeout("1m") == std::chrono::milliseconds{1});
+}
+
+TEST(Deadline, RequestDeadline) {
+    auto const now = deadline_clock::now();
+    EXPECT_EQ(request_deadline({}, "", now), deadline_clock::time_point::max());
+    EXPECT_EQ(request_deadline({.timeout = 2s}, "", now), now + 2s);
+    EXPECT_EQ(request_deadline({.timeout = 2s}, "500m", now), now + 500ms) << "the shorter one";
+    EXPECT_EQ(request_deadline({.timeout = 2s}, "5S", now), now + 2s);
+    EXPECT_EQ(request_deadline({}, "5S", now), now + 5s);
+    EXPECT_EQ(request_deadline({.max_timeout = 1s}, "5S", now), now + 1s) << "the upstream can't ask for more";
+    EXPECT_EQ(request_deadline({}, "garbage", now), deadline_clock::time_point::max());
+    EXPECT_EQ(request_deadline({}, "99999999H", now), deadline_clock::time_point::max());
+}
+
+TEST(Deadline, Tokens) {
+    cancellation_token const never;
+    EXPECT_FALSE(never.has_deadline());
+    EXPECT_FALSE(never.is_cancelled());
+    EXPECT_EQ(never.remaining(), deadline_clock::duration::max());
+
+    auto const past = cancellation_token::at(deadline_clock::now() - 1ms);
+    EXPECT_TRUE(past.is_cancelled());
+    EXPECT_EQ(past.remaining(), deadline_clock::duration::zero());
+
+    auto const later = cancellation_token::after(1h);
+    EXPECT_FALSE(later.is_cancelled());
+    EXPECT_GT(later.remaining(), 59min);
+    EXPECT_LT(later.with_timeout(1s).remaining(), 2s) << "the earlier deadline wins";
+    EXPECT_EQ(later.with_timeout(2h).deadline(), later.deadline());
+
+    cancellation_source source;
+    auto const          token   = source.token();
+    auto const          shorter = token.with_timeout(1h);
+    EXPECT_FALSE(token.is_cancelled());
+    source.cancel();
+    EXPECT_TRUE(source.is_cancelled());
+    EXPECT_TRUE(token.is_cancelled());
+    EXPECT_TRUE(shorter.is_cancelled()) << "the copies share the flag";
+}
@@ -0,0 +1,114 @@
+#include "../core/include/webpp/validators/email_providers.hpp"
+
+#include "../core/include/webpp/validators/email.hpp"
+
+#include <array>
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace webpp;
+
+namespace {
+    constexpr std::string_view providers_list =
+      "# the kind, and the domains of the provider\n"
+      "free    gmail.com googlemail.com\n"
+      "\n"
+      "blocked mailinator.com Mailinator.NET  # the disposable ones\r\n"
+      "free\tyahoo.com\n"
+      "blocked 10minutemail.com\n";
+} // namespace
+
+TEST(EmailProviders, Lookup) {
+    email_database_builder builder;
+    EXPECT_TRUE(builder.load(providers_list));
+    EXPECT_EQ(builder.size(), 6);
+
+    auto const           bytes = builder.build();
+    email_database const db{bytes};
+    ASSERT_TRUE(db.is_valid());
+    EXPECT_EQ(db.size(), 6);
+    EXPECT_TRUE(db.contains("gmail.com"));
+    EXPECT_TRUE(db.contains("GMail.Com"));
+    EXPECT_FALSE(db.contains("gmail.co"));
+    EXPECT_FALSE(db.contains(""));
+    EXPECT_EQ(db.domain(db.find("MAILINATOR.net")), "mailinator.net");
+
+    EXPECT_TRUE(db.is_blocked("mailinator.net"));
+    EXPECT_TRUE(db.is_blocked("10minutemail.com"));
+    EXPECT_FALSE(db.is_blocked("gmail.com"));
+    EXPECT_FALSE(db.is_blocked("example.com"));
+    EXPECT_EQ(db.kind(db.find("yahoo.com")), email_provider_kind::free);
+
+    auto const alternatives = db.alternative_domains("GoogleMail.com");
+    ASSERT_EQ(alternatives.size(), 1);
+    EXPECT_EQ(alternatives[0], "gmail.com");
+    EXPECT_TRUE(db.alternative_domains("yahoo.com").empty());
+    EXPECT_TRUE(db.alternative_domains("example.com").empty());
+
+    email const blocked{"someone@mailinator.com"};
+    EXPECT_TRUE(blocked.is_blocked(db));
+    EXPECT_EQ(blocked.alternative_domains(db), std::vector<std::string_view>{"mailinator.net"});
+    EXPECT_FALSE(email{"someone@gmail.com"}.is_blocked(db));
+    EXPECT_FALSE(email{"not an email@mailinator.com"}.is_blocked(db));
+}
+
+TEST(EmailProviders, NotValid) {
+    email_database_builder builder;
+    EXPECT_FALSE(builder.load("free gmail.com\nunknown example.com\nblocked\nfree gmail.com\n"));
+    EXPECT_EQ(builder.size(), 1);
+
+    auto bytes = builder.build();
+    EXPECT_TRUE(email_database{bytes}.is_valid());
+    EXPECT_FALSE(email_database{std::string_view{bytes}.substr(0, bytes.size() - 1)}.is_valid());
+    EXPECT_FALSE(email_database{"WPPEMDB1"}.is_valid());
+    EXPECT_FALSE(email_database{}.contains("gmail.com"));
+    bytes[0] = 'X';
+    email_database const broken{bytes};
+    EXPECT_FALSE(broken.is_valid());
+    EXPECT_FALSE(broken.contains("gmail.com"));
+
+    email_database_builder empty;
+    email_database const   nothing{empty.build()};
+    EXPECT_TRUE(nothing.is_valid());
+    EXPECT_FALSE(nothing.contains("gmail.com"));
+}
+
+TEST(EmailProviders, ManyDomains) {
+    email_database_builder   builder;
+    std::vector<std::string> domains;
+    for (int i = 0; i < 20'000; i++)
+        domains.push_back("disposable" + std::to_string(i) + (i % 3 == 0 ? ".com" : ".net"));
+    for (std::size_t i = 0; i < domains.size(); i += 4) {
+        std::array<std::string_view, 4> const group{domains[i], domains[i + 1], domains[i + 2],
+                                                    domains[i + 3]};
+        auto const kind = i % 8 == 0 ? email_provider_kind::blocked : email_provider_kind::free;
+        ASSERT_TRUE(builder.add(kind, group));
+    }
+
+    auto const path = std::filesystem::temp_directory_path() / "webpp_email_providers_test.db";
+    ASSERT_TRUE(builder.write_file(path));
+    mapped_email_database mapped{path};
+    ASSERT_TRUE(mapped.is_open());
+    EXPECT_EQ(mapped->size(), domains.size());
+    for (std::size_t i = 0; i < domains.size(); i++) {
+        auto const index = mapped->find(domains[i]);
+        ASSERT_NE(index, email_database::npos) << domains[i];
+        EXPECT_EQ(mapped->domain(index), domains[i]);
+        EXPECT_EQ(mapped->is_blocked(domains[i]), i / 4 % 2 == 0) << domains[i];
+        EXPECT_EQ(mapped->alternative_domains(domains[i]).size(), 3);
+        EXPECT_FALSE(mapped->contains(domains[i] + ".org"));
+    }
+
+    mapped_email_database moved = std::move(mapped);
+    EXPECT_TRUE(moved.is_open());
+    EXPECT_TRUE(moved->contains("disposable7.net"));
+    std::filesystem::remove(path);
+    EXPECT_TRUE(moved->contains("disposable7.net")) << "it stays mapped";
+
+    mapped_email_database missing;
+    EXPECT_FALSE(missing.open(path));
+    EXPECT_FALSE(missing.is_open());
+}
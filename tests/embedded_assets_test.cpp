@@ -0,0 +1,56 @@
+#include "../core/include/webpp/http/bodies/file.hpp"
+#include "../core/include/webpp/traits/std_traits.hpp"
+#include "../core/include/webpp/utils/embedded_assets.hpp"
+
+#include <array>
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+
+using namespace webpp;
+
+namespace {
+    constexpr embedded_asset_index<5> assets{std::array<embedded_asset, 5>{
+      embedded_asset{"/a.css", "a"},
+      embedded_asset{"/b.js", "b"},
+      embedded_asset{"/c/d.html", "cd"},
+      embedded_asset{"/e.png", "e"},
+      embedded_asset{"/f.svg", "f"},
+    }};
+
+    // the index is built at compile time
+    static_assert(assets.find("/c/d.html")->content == "cd");
+    static_assert(assets.find("/c/d.htm") == nullptr);
+} // namespace
+
+TEST(EmbeddedAssets, PerfectHash) {
+    for (auto const& asset : assets)
+        EXPECT_EQ(assets.find(asset.path), &asset) << asset.path;
+    EXPECT_EQ(assets.find("/missing"), nullptr);
+    EXPECT_EQ(assets.find(""), nullptr);
+
+    constexpr embedded_asset_index<0> empty{std::array<embedded_asset, 0>{}};
+    EXPECT_EQ(empty.find("/a.css"), nullptr);
+}
+
+TEST(EmbeddedAssets, GeneratedBundle) {
+    // see tests/assets and tests/CMakeLists.txt
+    auto const* html = find_embedded_asset("/static/index.html");
+    ASSERT_NE(html, nullptr);
+    EXPECT_TRUE(html->content.starts_with("<!doctype html>"));
+    EXPECT_EQ(find_embedded_asset("/static/missing.html"), nullptr);
+    EXPECT_EQ(find_embedded_asset("index.html"), nullptr);
+
+    auto const* css = find_embedded_asset("/static/css/style.css");
+    ASSERT_NE(css, nullptr);
+    ASSERT_FALSE(css->gzip.empty()) << "it's repetitive, gzip should've made it smaller";
+    EXPECT_LT(css->gzip.size(), css->content.size());
+    EXPECT_EQ(static_cast<unsigned char>(css->gzip[0]), 0x1fu);
+    EXPECT_EQ(static_cast<unsigned char>(css->gzip[1]), 0x8bu);
+
+    // the file bodies come from the binary
+    file_body::type<std_traits> body{"/static/index.html"};
+    EXPECT_TRUE(body.is_open());
+    EXPECT_EQ(body.native_handle(), -1);
+    EXPECT_EQ(body.str(), html->content);
+}
@@ -0,0 +1,90 @@
+#include "../core/include/webpp/encoding/encoded_word.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+
+using namespace webpp;
+using namespace webpp::encoding;
+
+TEST(EncodedWord, Parse) {
+    auto const word = parse_encoded_word("=?iso-8859-1?Q?=A1Hola,_se=F1or!?= rest");
+    ASSERT_TRUE(word);
+    EXPECT_EQ(word->charset, "iso-8859-1");
+    EXPECT_EQ(word->encoding, word_encoding::Q);
+    EXPECT_EQ(word->text, "=A1Hola,_se=F1or!");
+    EXPECT_EQ(word->size, 34);
+
+    EXPECT_EQ(parse_encoded_word("=?utf-8*en?b?SGk=?=")->charset, "utf-8");
+    EXPECT_FALSE(parse_encoded_word("=?utf-8?X?abc?="));
+    EXPECT_FALSE(parse_encoded_word("=?utf-8?Q?no end"));
+    EXPECT_FALSE(parse_encoded_word("=?utf-8?Q?a b?="));
+    EXPECT_FALSE(parse_encoded_word("plain"));
+}
+
+TEST(EncodedWord, Decode) {
+    std::string buffer;
+
+    // the common case doesn't touch the buffer
+    std::string_view const plain = "text/html; charset=utf-8";
+    EXPECT_EQ(decoded(plain, buffer).data(), plain.data());
+    EXPECT_TRUE(buffer.empty());
+
+    EXPECT_EQ(decoded("=?iso-8859-1?Q?=A1Hola,_se=F1or!?=", buffer), "¡Hola, señor!");
+    EXPECT_EQ(decoded("=?UTF-8?B?wqFIb2xhLCBzZcOxb3Ih?=", buffer), "¡Hola, señor!");
+    EXPECT_EQ(decoded("Re: =?utf-8?q?caf=C3=A9?= time", buffer), "Re: café time");
+
+    // the spaces between two words are dropped, the rest are kept
+    EXPECT_EQ(decoded("=?utf-8?Q?a?= =?utf-8?Q?b?=", buffer), "ab");
+    EXPECT_EQ(decoded("=?utf-8?Q?a?= x =?utf-8?Q?b?=", buffer), "a x b");
+
+    // the broken ones, and the unknown charsets, are left as they are
+    EXPECT_EQ(decoded("=?utf-8?Q?bad=Z?= =?koi8-r?B?8tXT?=", buffer), "=?utf-8?Q?bad=Z?= =?koi8-r?B?8tXT?=");
+    EXPECT_EQ(decoded("a =? b", buffer), "a =? b");
+}
+
+TEST(EncodedWord, Encode) {
+    EXPECT_FALSE(needs_encoding("plain ascii"));
+    EXPECT_TRUE(needs_encoding("café"));
+    EXPECT_TRUE(needs_encoding("a=?b"));
+
+    std::string out;
+    encode_words("plain", out);
+    EXPECT_EQ(out, "plain");
+
+    out.clear();
+    encode_word("café au lait", out);
+    EXPECT_EQ(out, "=?UTF-8?Q?caf=C3=A9_au_lait?=");
+
+    out.clear();
+    encode_word("¡Hola, señor!", out, word_encoding::B);
+    EXPECT_EQ(out, "=?UTF-8?B?wqFIb2xhLCBzZcOxb3Ih?=");
+
+    // the long ones are split into a few words, none of them longer than 75
+    // and none of them in the middle of a character
+    std::string long_text;
+    for (int i = 0; i < 40; i++)
+        long_text += "señor ";
+    for (auto const encoding : {word_encoding::Q, word_encoding::B}) {
+        out.clear();
+        encode_word(long_text, out, encoding);
+        std::string_view rest = out;
+        int              words = 0;
+        while (!rest.empty()) {
+            auto const end  = rest.find(' ');
+            auto const word = rest.substr(0, end);
+            EXPECT_LE(word.size(), 75);
+            words++;
+            rest = end == std::string_view::npos ? std::string_view{} : rest.substr(end + 1);
+        }
+        EXPECT_GT(words, 1);
+        std::string buffer;
+        EXPECT_EQ(decoded(out, buffer), long_text);
+    }
+
+    out.clear();
+    encode_words("日本語", out);
+    std::string buffer;
+    EXPECT_EQ(decoded(out, buffer), "日本語");
+    EXPECT_TRUE(out.starts_with("=?UTF-8?B?")) << "base64 is shorter for these";
+}
@@ -0,0 +1,151 @@
+#include "../core/include/webpp/http/bodies/event_stream.hpp"
+#include "../core/include/webpp/http/event_stream.hpp"
+#include "../core/include/webpp/http/interfaces/simple_server.hpp"
+#include "../core/include/webpp/http/response.hpp"
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace webpp;
+
+namespace {
+    using event_response_type = basic_response<std_traits,
+                                               empty_extension_pack,
+                                               response_headers<std_traits>,
+                                               event_stream_body::type<std_traits>>;
+
+    struct news_app {
+        std::shared_ptr<event_channel> news = std::make_shared<event_channel>(event_channel_options{.max_backlog = 4});
+
+        template <typename RequestType>
+        event_response_type operator()(RequestType const&) {
+            event_response_type res{200u};
+            res.body = event_stream_body::type<std_traits>{news};
+            return res;
+        }
+    };
+
+    /**
+     * The subscribers of the news_app, on one io_context
+     */
+    struct subscribers {
+        using tcp = boost::asio::ip::tcp;
+
+        boost::asio::io_context                          io;
+        tcp::acceptor                                    acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+        simple_server<std_traits, news_app>              server;
+        std::vector<std::unique_ptr<tcp::socket>>        clients;
+        std::vector<std::unique_ptr<common::connection>> conns;
+        std::size_t                                      closed = 0;
+
+        tcp::socket& subscribe(std::string_view request) {
+            auto& client = *clients.emplace_back(std::make_unique<tcp::socket>(io));
+            client.connect(acceptor.local_endpoint());
+            auto& conn = *conns.emplace_back(std::make_unique<common::connection>(acceptor.accept()));
+            conn.start(
+              [this] {
+                  closed++;
+              },
+              [this, state = decltype(server)::connection_state{}](common::connection& c,
+                                                                   std::string_view    data) mutable {
+                  server.handle(c, state, data);
+              });
+            boost::asio::write(client, boost::asio::buffer(request));
+            return client;
+        }
+
+        void run() {
+            using namespace std::chrono_literals;
+            io.restart(); // it stops when all the connections are closed
+            io.run_for(50ms);
+        }
+
+        static std::string read_all(tcp::socket& client) {
+            std::string               received;
+            boost::system::error_code ec;
+            boost::asio::read(client, boost::asio::dynamic_buffer(received), ec);
+            return received;
+        }
+    };
+} // namespace
+
+TEST(EventStream, WriteEvent) {
+    std::string out;
+    write_event(out, {.data = "hello"});
+    EXPECT_EQ(out, "data: hello\n\n");
+
+    out.clear();
+    write_event(out,
+                {.data  = "one\ntwo\r\nthree\n",
+                 .event = "update",
+                 .id    = "7\nx",
+                 .retry = std::chrono::milliseconds{1500}});
+    EXPECT_EQ(out, "event: update\nid: 7\nretry: 1500\ndata: one\ndata: two\ndata: three\ndata: \n\n");
+
+    out.clear();
+    write_event_comment(out, "ping");
+    write_event_comment(out);
+    EXPECT_EQ(out, ":ping\n\n:\n\n");
+}
+
+TEST(EventStream, SimpleServerFanOut) {
+    subscribers subs;
+    auto&       chunked = subs.subscribe("GET /news HTTP/1.1\r\nHost: a\r\n\r\nGET /ignored HTTP/1.1\r\n\r\n");
+    auto&       plain   = subs.subscribe("GET /news HTTP/1.0\r\n\r\n");
+    subs.run();
+    auto& news = *subs.server.app.news;
+    EXPECT_EQ(news.size(), 2);
+
+    news.publish({.data = "first", .id = "1"});
+    news.heartbeat();
+    news.publish({.data = "second", .event = "update"});
+    subs.run();
+    EXPECT_EQ(subs.closed, 0) << "the streams stay open";
+
+    news.close();
+    subs.run();
+    EXPECT_EQ(subs.closed, 2);
+    EXPECT_EQ(news.size(), 0);
+
+    auto const first = subscribers::read_all(chunked);
+    ASSERT_EQ(first.find("HTTP/1.1 200 OK\r\n"), 0);
+    EXPECT_NE(first.find("Content-Type: text/event-stream\r\n"), std::string::npos);
+    EXPECT_NE(first.find("Transfer-Encoding: chunked\r\n"), std::string::npos);
+    EXPECT_EQ(first.substr(first.find("\r\n\r\n") + 4),
+              "13\r\nid: 1\ndata: first\n\n\r\n"
+              "3\r\n:\n\n\r\n"
+              "1c\r\nevent: update\ndata: second\n\n\r\n"
+              "0\r\n\r\n")
+      << "the second request is not answered";
+
+    auto const second = subscribers::read_all(plain);
+    EXPECT_NE(second.find("Connection: close\r\n"), std::string::npos);
+    EXPECT_EQ(second.substr(second.find("\r\n\r\n") + 4),
+              "id: 1\ndata: first\n\n:\n\nevent: update\ndata: second\n\n");
+
+    // the streams of a closed channel end right away
+    auto& late = subs.subscribe("GET /news HTTP/1.1\r\nHost: a\r\n\r\n");
+    subs.run();
+    auto const third = subscribers::read_all(late);
+    EXPECT_EQ(third.substr(third.find("\r\n\r\n") + 4), "0\r\n\r\n") << third;
+    EXPECT_EQ(subs.closed, 3);
+}
+
+TEST(EventStream, SlowSubscribersAreDropped) {
+    subscribers subs;
+    subs.subscribe("GET /news HTTP/1.1\r\nHost: a\r\n\r\n");
+    subs.run();
+    auto& news = *subs.server.app.news;
+    ASSERT_EQ(news.size(), 1);
+
+    // they're all queued before the first one is written
+    for (int i = 0; i < 10; i++)
+        news.publish({.data = std::string(1000, 'x')});
+    subs.run();
+    EXPECT_EQ(news.size(), 0);
+    EXPECT_EQ(subs.closed, 1);
+}
@@ -128,6 +128,11 @@ TEST(ExtensionsTests, ExtensionPackStuff) {
                                pack>,
                   "epack is failing at making the extensions unique");
 
+    static_assert(stl::same_as<typename extension_pack<exes, two, one>::merge_extensions<
+                                 fake_descriptor, empty_extension_pack::template mother_type>,
+                               extension_pack<three, two, one>>,
+                  "The last one of the duplicates should stay");
+
     typename pack::template mother_inherited<std_traits> ipack;
 
     EXPECT_TRUE(ipack.value_one);
@@ -0,0 +1,615 @@
+#include "../core/include/webpp/http/bodies/stream.hpp"
+#include "../core/include/webpp/http/bodies/string.hpp"
+#include "../core/include/webpp/http/interfaces/cgi.hpp"
+#include "../core/include/webpp/http/interfaces/fastcgi/record_parser.hpp"
+#include "../core/include/webpp/http/interfaces/fastcgi/session.hpp"
+#include "../core/include/webpp/http/interfaces/fcgi.hpp"
+#include "../core/include/webpp/http/response.hpp"
+#include "../core/include/webpp/utils/task.hpp"
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <coroutine>
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace webpp;
+using namespace webpp::protocol;
+
+namespace {
+
+    std::string make_record(record_type type, uint16_t req_id, std::string_view content, uint8_t padding = 0) {
+        std::string rec;
+        rec += char(1);
+        rec += char(type);
+        rec += char(req_id >> 8u);
+        rec += char(req_id & 0xFFu);
+        rec += char(content.size() >> 8u);
+        rec += char(content.size() & 0xFFu);
+        rec += char(padding);
+        rec += char(0);
+        rec += content;
+        rec.append(padding, '\0');
+        return rec;
+    }
+
+} // namespace
+
+TEST(FastCGI, RecordParser) {
+    auto const data = make_record(record_type::params, 1, "hello", 3) + make_record(record_type::std_in, 1, "") +
+                      make_record(record_type::std_in, 2, "world");
+
+    record_parser            parser;
+    std::vector<std::string> contents;
+    std::vector<uint16_t>    ids;
+    EXPECT_TRUE(parser.parse(data, [&](record_fragment const& f) {
+        EXPECT_TRUE(f.complete);
+        contents.emplace_back(f.content);
+        ids.push_back(f.request_id);
+    }));
+    EXPECT_EQ(contents, (std::vector<std::string>{"hello", "", "world"}));
+    EXPECT_EQ(ids, (std::vector<uint16_t>{1, 1, 2}));
+    EXPECT_TRUE(parser.at_record_boundary());
+}
+
+TEST(FastCGI, SplitRecords) {
+    auto const data = make_record(record_type::params, 7, "abcdef", 2) + make_record(record_type::std_in, 7, "xyz");
+
+    // feed it one byte at a time
+    record_parser parser;
+    std::string   params, std_in;
+    int           completes = 0;
+    for (char c : data) {
+        EXPECT_TRUE(parser.parse(std::string_view{&c, 1}, [&](record_fragment const& f) {
+            EXPECT_EQ(f.request_id, 7);
+            (f.type == record_type::params ? params : std_in) += f.content;
+            completes += f.complete;
+        }));
+    }
+    EXPECT_EQ(params, "abcdef");
+    EXPECT_EQ(std_in, "xyz");
+    EXPECT_EQ(completes, 2);
+    EXPECT_TRUE(parser.at_record_boundary());
+}
+
+TEST(FastCGI, BadVersion) {
+    auto data = make_record(record_type::params, 1, "hello");
+    data[0]   = 2;
+    record_parser parser;
+    EXPECT_FALSE(parser.parse(data, [](record_fragment const&) {
+        ADD_FAILURE();
+    }));
+    EXPECT_EQ(parser.current_state(), record_parser::state_type::error);
+}
+
+TEST(FastCGI, NameValues) {
+    std::string content;
+    content += char(4);
+    content += char(3);
+    content += "NAMEval";
+    std::string const long_value(200, 'v');
+    content += char(1);
+    content += char(0x80);
+    content += char(0);
+    content += char(0);
+    content += char(200);
+    content += "L" + long_value;
+
+    std::vector<std::pair<std::string, std::string>> pairs;
+    EXPECT_TRUE(parse_name_values(content, [&](std::string_view name, std::string_view value) {
+        pairs.emplace_back(name, value);
+    }));
+    ASSERT_EQ(pairs.size(), 2);
+    EXPECT_EQ(pairs[0].first, "NAME");
+    EXPECT_EQ(pairs[0].second, "val");
+    EXPECT_EQ(pairs[1].first, "L");
+    EXPECT_EQ(pairs[1].second, long_value);
+
+    EXPECT_FALSE(parse_name_values(content.substr(0, 5), [](auto, auto) {}));
+}
+
+namespace {
+
+    std::string begin_request_record(uint16_t req_id, bool keep_conn) {
+        std::string body(8, '\0');
+        body[1] = 1; // responder
+        body[2] = keep_conn ? 1 : 0;
+        return make_record(record_type::begin_request, req_id, body);
+    }
+
+    std::string param(std::string_view name, std::string_view value) {
+        std::string res;
+        res += char(name.size());
+        res += char(value.size());
+        res += name;
+        res += value;
+        return res;
+    }
+
+    // read the records of the output back
+    std::vector<std::pair<uint16_t, std::string>> stdout_of(std::string_view output, int& end_requests) {
+        std::vector<std::pair<uint16_t, std::string>> res;
+        record_parser                                 parser;
+        parser.parse(output, [&](record_fragment const& f) {
+            if (f.type == record_type::std_out && !f.content.empty())
+                res.emplace_back(f.request_id, f.content);
+            if (f.type == record_type::end_request)
+                end_requests++;
+        });
+        return res;
+    }
+
+    template <typename Session>
+    std::string take_output(Session& session) {
+        std::string res;
+        res.reserve(session.output_size());
+        for (auto const& buf : session.output_buffers())
+            res.append(static_cast<char const*>(buf.data()), buf.size());
+        session.release_output();
+        return res;
+    }
+
+} // namespace
+
+TEST(FastCGI, RequestTable) {
+    fastcgi::request_table<int, 4> table;
+    EXPECT_EQ(table.find(1), nullptr);
+    *table.emplace(1) = 10;
+    *table.emplace(5) = 50; // collides with 1
+    EXPECT_EQ(table.emplace(1), nullptr);
+    EXPECT_EQ(*table.find(1), 10);
+    EXPECT_EQ(*table.find(5), 50);
+    EXPECT_TRUE(table.erase(1));
+    EXPECT_EQ(table.find(1), nullptr);
+    EXPECT_EQ(*table.find(5), 50);
+    EXPECT_NE(table.emplace(2), nullptr);
+    EXPECT_NE(table.emplace(3), nullptr);
+    EXPECT_NE(table.emplace(4), nullptr);
+    EXPECT_EQ(table.emplace(6), nullptr); // full
+    EXPECT_EQ(table.size(), 4);
+
+    // the requests are in the slots of their ids (the slots are visited in order), so the first
+    // probe of a lookup finds them
+    fastcgi::request_table<int, 4> placed;
+    *placed.emplace(3) = 30;
+    *placed.emplace(1) = 10;
+    *placed.emplace(7) = 70; // its slot is 3's, so it's in the next free one after it
+    std::vector<uint16_t> order;
+    placed.for_each([&](uint16_t id, int) {
+        order.push_back(id);
+    });
+    EXPECT_EQ(order, (std::vector<uint16_t>{7, 1, 3}));
+}
+
+TEST(FastCGI, Multiplexing) {
+    std::vector<uint16_t> pending;
+    fastcgi::session      session{[&](fastcgi::session&, fastcgi::request& req) {
+        EXPECT_EQ(req.param("SCRIPT_NAME"), req.id == 1 ? "/one" : "/two");
+        pending.push_back(req.id);
+    }};
+
+    // two requests interleaved on the same connection
+    std::string in = begin_request_record(1, true) + begin_request_record(2, true);
+    in += make_record(record_type::params, 2, param("SCRIPT_NAME", "/two"));
+    in += make_record(record_type::params, 1, param("SCRIPT_NAME", "/one"));
+    in += make_record(record_type::params, 1, "") + make_record(record_type::params, 2, "");
+    in += make_record(record_type::std_in, 2, "") + make_record(record_type::std_in, 1, "");
+    EXPECT_TRUE(session.feed(in));
+    EXPECT_EQ(pending, (std::vector<uint16_t>{2, 1}));
+    EXPECT_EQ(session.in_flight(), 2);
+
+    session.write_stdout(1, "a");
+    session.write_stdout(2, std::string{"b"});
+    session.write_stdout(1, "c");
+    EXPECT_EQ(session.output_buffers().size(), 3 * 3); // header, content, padding
+    session.end_request(2);
+    session.end_request(1);
+    EXPECT_EQ(session.in_flight(), 0);
+    EXPECT_FALSE(session.should_close());
+
+    int  end_requests = 0;
+    auto out          = stdout_of(take_output(session), end_requests);
+    EXPECT_EQ(out, (std::vector<std::pair<uint16_t, std::string>>{{1, "a"}, {2, "b"}, {1, "c"}}));
+    EXPECT_EQ(end_requests, 2);
+    EXPECT_FALSE(session.has_output());
+}
+
+TEST(FastCGI, Overloaded) {
+    fastcgi::basic_session<1> session;
+    EXPECT_TRUE(session.feed(begin_request_record(1, false) + begin_request_record(2, false)));
+    EXPECT_EQ(session.in_flight(), 1);
+
+    // the second one should be rejected right away
+    int end_requests = 0;
+    stdout_of(take_output(session), end_requests);
+    EXPECT_EQ(end_requests, 1);
+
+    session.end_request(1);
+    EXPECT_TRUE(session.should_close());
+}
+
+TEST(FastCGI, SizeLimits) {
+    int              served = 0;
+    fastcgi::session session{[&](fastcgi::session&, fastcgi::request&) {
+                                 served++;
+                             },
+                             8};
+
+    // the body is bigger than the limit: it's answered with a 413, and its slot is freed right away
+    std::string in = begin_request_record(1, true);
+    in += make_record(record_type::params, 1, "");
+    in += make_record(record_type::std_in, 1, "12345");
+    in += make_record(record_type::std_in, 1, "6789");
+    in += make_record(record_type::std_in, 1, "the rest is ignored");
+    in += make_record(record_type::std_in, 1, "");
+    EXPECT_TRUE(session.feed(in));
+    EXPECT_EQ(served, 0);
+    EXPECT_EQ(session.in_flight(), 0);
+    int  end_requests = 0;
+    auto out          = stdout_of(take_output(session), end_requests);
+    EXPECT_EQ(end_requests, 1);
+    ASSERT_EQ(out.size(), 1);
+    EXPECT_TRUE(out[0].second.starts_with("Status: 413 ")) << out[0].second;
+
+    // and so are the params, with a 431
+    std::string const big_value(200, 'v');
+    std::string       big_params;
+    while (big_params.size() < 40'000)
+        big_params += param("HTTP_COOKIE", big_value);
+    in = begin_request_record(2, false);
+    in += make_record(record_type::params, 2, big_params);
+    in += make_record(record_type::params, 2, big_params);
+    in += make_record(record_type::params, 2, "");
+    in += make_record(record_type::std_in, 2, "");
+    EXPECT_TRUE(session.feed(in));
+    EXPECT_EQ(served, 0);
+    end_requests = 0;
+    out          = stdout_of(take_output(session), end_requests);
+    EXPECT_EQ(end_requests, 1);
+    ASSERT_EQ(out.size(), 1);
+    EXPECT_TRUE(out[0].second.starts_with("Status: 431 ")) << out[0].second;
+    EXPECT_TRUE(session.should_close());
+
+    // the ones within the limits are served
+    fastcgi::session fitting{[&](fastcgi::session&, fastcgi::request&) {
+                                 served++;
+                             },
+                             8};
+    in = begin_request_record(1, true);
+    in += make_record(record_type::params, 1, big_params);
+    in += make_record(record_type::params, 1, "");
+    in += make_record(record_type::std_in, 1, "12345678");
+    in += make_record(record_type::std_in, 1, "");
+    EXPECT_TRUE(fitting.feed(in));
+    EXPECT_EQ(served, 1);
+}
+
+TEST(FastCGI, GetValues) {
+    constexpr protocol::management_values values{10000, 50};
+    static_assert(values.find("FCGI_MAX_REQS") == std::string_view{"\x0d\x02" "FCGI_MAX_REQS50"});
+    static_assert(values.find("FCGI_UNKNOWN").empty());
+
+    protocol::management_values const configured{123, 50, true};
+    fastcgi::session                  session;
+    session.management_values(configured);
+
+    std::string names = param("FCGI_MAX_CONNS", "") + param("FCGI_UNKNOWN", "") + param("FCGI_MPXS_CONNS", "");
+    EXPECT_TRUE(session.feed(make_record(record_type::get_values, 0, names)));
+
+    record_parser                                    parser;
+    std::vector<std::pair<std::string, std::string>> pairs;
+    EXPECT_TRUE(parser.parse(take_output(session), [&](record_fragment const& f) {
+        EXPECT_EQ(f.type, record_type::get_values_result);
+        EXPECT_EQ(f.request_id, 0);
+        parse_name_values(f.content, [&](std::string_view name, std::string_view value) {
+            pairs.emplace_back(name, value);
+        });
+    }));
+    EXPECT_TRUE(parser.at_record_boundary());
+    EXPECT_EQ(pairs, (std::vector<std::pair<std::string, std::string>>{{"FCGI_MAX_CONNS", "123"},
+                                                                       {"FCGI_MPXS_CONNS", "1"}}));
+}
+
+namespace {
+    using string_response_type =
+      basic_response<std_traits, empty_extension_pack, response_headers<std_traits>, string_body::type<std_traits>>;
+
+    struct echo_app {
+        template <typename RequestType>
+        string_response_type operator()(RequestType const& req) {
+            return string_response_type{200u,
+                                        std::string{req.request_method()} + " " + std::string{req.header("Host")} +
+                                          " " + std::string{req.body()}};
+        }
+    };
+
+    std::string echo_request(uint16_t req_id, bool keep_conn) {
+        std::string in = begin_request_record(req_id, keep_conn);
+        in += make_record(record_type::params, req_id, param("REQUEST_METHOD", "POST") + param("HTTP_HOST", "a.b"));
+        in += make_record(record_type::params, req_id, "");
+        in += make_record(record_type::std_in, req_id, "body");
+        in += make_record(record_type::std_in, req_id, "");
+        return in;
+    }
+
+    std::string stdout_string(std::string_view output, int& end_requests) {
+        std::string res;
+        for (auto const& [id, content] : stdout_of(output, end_requests))
+            res += content;
+        return res;
+    }
+} // namespace
+
+TEST(FastCGI, Responder) {
+    fcgi<std_traits, echo_app> app;
+    fastcgi::session           session{[&](fastcgi::session& s, fastcgi::request& req) {
+        basic_request<std_traits, fcgi<std_traits, echo_app>> const request{req};
+        EXPECT_EQ(request.headers(), "HOST: a.b\r\n");
+        EXPECT_EQ(request.content_type(), "");
+        app.serve(s, req);
+    }};
+    EXPECT_TRUE(session.feed(echo_request(1, false)));
+    EXPECT_TRUE(session.should_close());
+
+    int        end_requests = 0;
+    auto const out          = stdout_string(take_output(session), end_requests);
+    EXPECT_EQ(end_requests, 1);
+    EXPECT_TRUE(out.starts_with("Status: 200 OK\r\n"));
+    EXPECT_TRUE(out.ends_with("\r\n\r\nPOST a.b body"));
+}
+
+TEST(FastCGI, NormalizedTarget) {
+    std::string target;
+    std::string uri;
+    fastcgi::session session{[&](fastcgi::session&, fastcgi::request& req) {
+        basic_request<std_traits, fcgi<std_traits, echo_app>> const request{req};
+        target = request.request_uri();
+        uri    = request.env("REQUEST_URI");
+    }};
+    std::string in = begin_request_record(1, true);
+    in += make_record(record_type::params, 1, param("REQUEST_URI", "/a/./b/../%7ec?%7e"));
+    in += make_record(record_type::params, 1, "");
+    in += make_record(record_type::std_in, 1, "");
+    EXPECT_TRUE(session.feed(in));
+    EXPECT_EQ(target, "/a/~c?%7e");
+    EXPECT_EQ(uri, "/a/./b/../%7ec?%7e") << "the param itself is as the web server sent it";
+}
+
+namespace {
+    std::shared_ptr<std::string const> const cached_page = std::make_shared<std::string const>("the cached page");
+
+    struct cached_app {
+        template <typename RequestType>
+        string_response_type operator()(RequestType const&) {
+            return string_response_type{200u, cached_page};
+        }
+    };
+
+    using stream_response_type =
+      basic_response<std_traits, empty_extension_pack, response_headers<std_traits>, stream_body::type<std_traits>>;
+
+    struct counting_app {
+        int* produced = nullptr;
+
+        template <typename RequestType>
+        stream_response_type operator()(RequestType const&) {
+            stream_response_type res{200u};
+            res.body = stream_body::type<std_traits>{[produced = produced](std::string& chunk) {
+                chunk.append("part ").append(std::to_string((*produced)++));
+                return *produced != 3;
+            }};
+            return res;
+        }
+    };
+} // namespace
+
+TEST(FastCGI, SharedBodyIsNotCopied) {
+    fcgi<std_traits, cached_app> app;
+    fastcgi::session             session{[&](fastcgi::session& s, fastcgi::request& req) {
+        app.serve(s, req);
+    }};
+    EXPECT_TRUE(session.feed(echo_request(1, true)));
+
+    auto const batch = session.detach_output();
+    EXPECT_FALSE(session.has_output());
+    bool borrowed = false;
+    for (auto const& buf : batch->buffers)
+        borrowed = borrowed || buf.data() == cached_page->data();
+    EXPECT_TRUE(borrowed) << "the body is written from the shared string";
+    EXPECT_GE(cached_page.use_count(), 2) << "the batch keeps it alive";
+
+    std::string out;
+    for (auto const& buf : batch->buffers)
+        out.append(static_cast<char const*>(buf.data()), buf.size());
+    int end_requests = 0;
+    EXPECT_TRUE(stdout_string(out, end_requests).ends_with("\r\n\r\nthe cached page"));
+    EXPECT_EQ(end_requests, 1);
+}
+
+TEST(FastCGI, StreamedBody) {
+    int                            produced = 0;
+    fcgi<std_traits, counting_app> app;
+    app.app.produced = &produced;
+    fastcgi::session session{[&](fastcgi::session& s, fastcgi::request& req) {
+        app.serve(s, req);
+    }};
+    EXPECT_TRUE(session.feed(echo_request(1, true)));
+    EXPECT_EQ(session.in_flight(), 0);
+
+    auto const batch = session.detach_output();
+    ASSERT_EQ(batch->streams.size(), 1);
+    EXPECT_EQ(batch->streams[0].position, batch->buffers.size()) << "after the head";
+    EXPECT_EQ(produced, 0) << "nothing is produced before the writer asks for it";
+
+    std::string head;
+    for (auto const& buf : batch->buffers)
+        head.append(static_cast<char const*>(buf.data()), buf.size());
+    int end_requests = 0;
+    EXPECT_TRUE(stdout_string(head, end_requests).starts_with("Status: 200 OK\r\n"));
+    EXPECT_EQ(end_requests, 0);
+
+    // each chunk is a STDOUT record, and the end of the request comes after the last one
+    std::vector<std::string> records;
+    for (bool more = true; more;) {
+        std::string chunk;
+        more = batch->streams[0].producer(chunk);
+        records.push_back(std::move(chunk));
+    }
+    EXPECT_EQ(produced, 3);
+    ASSERT_EQ(records.size(), 3);
+    auto const first = stdout_of(records[0], end_requests);
+    ASSERT_EQ(first.size(), 1);
+    EXPECT_EQ(first[0], (std::pair<uint16_t, std::string>{1, "part 0"}));
+    EXPECT_EQ(end_requests, 0);
+    EXPECT_EQ(stdout_string(records[2], end_requests), "part 2");
+    EXPECT_EQ(end_requests, 1);
+}
+
+#ifdef __unix__
+TEST(FastCGI, ReloadLimits) {
+    fcgi<std_traits, echo_app> app;
+    EXPECT_EQ(app.management_values(), nullptr);
+
+    auto max_requests = [&] {
+        fastcgi::session session;
+        session.management_values(app.management_values());
+        EXPECT_TRUE(session.feed(make_record(record_type::get_values, 0, param("FCGI_MAX_REQS", ""))));
+        record_parser parser;
+        std::string   value;
+        EXPECT_TRUE(parser.parse(take_output(session), [&](record_fragment const& f) {
+            parse_name_values(f.content, [&](std::string_view, std::string_view v) {
+                value = v;
+            });
+        }));
+        return value;
+    };
+
+    app.reload(config_snapshot{{{"fastcgi.max_requests", "10"}}});
+    EXPECT_EQ(max_requests(), "10");
+
+    // a session can't hold more than its table
+    app.reload(config_snapshot{{{"fastcgi.max_requests", "500"}}});
+    EXPECT_EQ(max_requests(), "50");
+}
+
+TEST(FastCGI, PersistentCGI) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    // the web server gives us the listening socket as the stdin
+    boost::asio::io_context io;
+    tcp::acceptor           acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    auto const              endpoint = acceptor.local_endpoint();
+    int const               saved    = ::dup(0);
+    ASSERT_EQ(::dup2(acceptor.native_handle(), 0), 0);
+    EXPECT_TRUE((cgi<std_traits, echo_app>::is_fastcgi()));
+
+    cgi<std_traits, echo_app> app;
+    std::thread               runner{[&] {
+        app();
+    }};
+
+    // two requests on the same connection, the same process
+    tcp::socket client{io};
+    client.connect(endpoint);
+    boost::asio::write(client, boost::asio::buffer(echo_request(1, true) + echo_request(2, false)));
+    std::string output;
+    boost::system::error_code ec;
+    for (char buf[1024]; !ec;) {
+        auto const n = client.read_some(boost::asio::buffer(buf), ec);
+        output.append(buf, n);
+    }
+
+    app.stop();
+    runner.join();
+    ::dup2(saved, 0);
+    ::close(saved);
+
+    int        end_requests = 0;
+    auto const out          = stdout_string(output, end_requests);
+    EXPECT_EQ(end_requests, 2);
+    EXPECT_EQ(out.find("Status: 200 OK"), 0);
+    EXPECT_NE(out.rfind("Status: 200 OK"), 0);
+}
+#endif
+
+namespace {
+    // the tasks wait here until the test resumes them
+    std::vector<std::coroutine_handle<>> waiting_tasks{};
+    std::vector<bool>                    saw_cancel{};
+
+    struct wait_for_test {
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> h) const {
+            waiting_tasks.push_back(h);
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    struct task_app {
+        template <typename RequestType>
+        task<string_response_type> operator()(RequestType const& req) {
+            co_await wait_for_test{};
+            saw_cancel.push_back(req.cancellation().is_cancelled());
+            co_return string_response_type{200u, std::string{req.header("Host")} + " " + std::string{req.body()}};
+        }
+    };
+} // namespace
+
+TEST(FastCGI, Tasks) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    waiting_tasks.clear();
+    saw_cancel.clear();
+    boost::asio::io_context io;
+    tcp::acceptor           acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    tcp::socket             client{io};
+    client.connect(acceptor.local_endpoint());
+    common::connection conn{acceptor.accept()};
+
+    fcgi<std_traits, task_app> app;
+    common::task_link          tasks;
+    fastcgi::session           session{[&](fastcgi::session& s, fastcgi::request& freq) {
+        app.serve_task(tasks, s, freq);
+    }};
+    conn.start([] {},
+               [&](common::connection& c, std::string_view data) {
+                   app.handle(c, session, tasks, data);
+               });
+
+    // the web server gives up on the first one while its task is waiting
+    boost::asio::write(client, boost::asio::buffer(echo_request(1, true) + echo_request(2, false)));
+    io.run_for(20ms);
+    ASSERT_EQ(waiting_tasks.size(), 2);
+    EXPECT_EQ(session.in_flight(), 2) << "their slots are kept until the tasks are done";
+    boost::asio::write(client, boost::asio::buffer(make_record(record_type::abort_request, 1, "")));
+    io.run_for(20ms);
+    for (auto const h : std::exchange(waiting_tasks, {}))
+        h.resume();
+    io.run_for(20ms);
+    EXPECT_EQ(saw_cancel, (std::vector<bool>{true, false}));
+
+    std::string               output;
+    boost::system::error_code ec;
+    boost::asio::read(client, boost::asio::dynamic_buffer(output), ec);
+    EXPECT_EQ(ec, boost::asio::error::eof) << "the second one has asked to close it";
+    int        end_requests = 0;
+    auto const out          = stdout_of(output, end_requests);
+    EXPECT_EQ(end_requests, 2);
+    std::string response;
+    for (auto const& [id, content] : out) {
+        EXPECT_EQ(id, 2) << "the aborted one is not answered";
+        response += content;
+    }
+    EXPECT_TRUE(response.starts_with("Status: 200 OK\r\n"));
+    EXPECT_TRUE(response.ends_with("\r\n\r\na.b body"));
+}
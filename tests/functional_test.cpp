@@ -1,10 +1,18 @@
 // Created by moisrex on 12/10/19.
+#include "../core/include/webpp/http/interfaces/common/timing_wheel.hpp"
 #include "../core/include/webpp/utils/functional.hpp"
 
 #include "../core/include/webpp/utils/debounce.hpp"
 
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 using namespace webpp;
 
@@ -67,9 +75,185 @@ TEST(FunctionalTests, DebouncedFunctions) {
 
 
 TEST(FunctionalTests, TrailingMode) {
-    using dtype = debounce_type;
+    using namespace std::chrono;
 
     debounce_trailing debounced_lambda([] {
 
     });
+
+    // without a timer service, the last call waits for flush
+    std::vector<int>  calls;
+    debounce_trailing manual{milliseconds(5), [&](int value) {
+                                 calls.push_back(value);
+                             }};
+    manual(1);
+    manual(2);
+    EXPECT_TRUE(manual.pending());
+    EXPECT_TRUE(calls.empty());
+    manual.flush();
+    EXPECT_FALSE(manual.pending());
+    EXPECT_EQ(calls, std::vector<int>{2});
+    manual(3);
+    manual.cancel();
+    manual.flush();
+    EXPECT_EQ(calls, std::vector<int>{2});
+
+    // the calls only reset the timer; the last one runs when they stop
+    stl::net::io_context  io;
+    common::timer_service timers{io, milliseconds(1)};
+    calls.clear();
+    debounce_trailing invalidate{timers, milliseconds(5), [&](int value) {
+                                     calls.push_back(value);
+                                 }};
+    for (int i = 0; i < 100; i++)
+        invalidate(i);
+    EXPECT_EQ(timers.size(), 1);
+    io.run();
+    EXPECT_EQ(calls, std::vector<int>{99});
+    EXPECT_FALSE(invalidate.pending());
+}
+
+namespace {
+    // a timer service that only expires its timer when it's told to
+    struct manual_timers {
+        webpp::timer_node* scheduled = nullptr;
+
+        void schedule(webpp::timer_node& node, std::chrono::nanoseconds) noexcept {
+            scheduled = &node;
+        }
+
+        void cancel(webpp::timer_node& node) noexcept {
+            if (scheduled == &node)
+                scheduled = nullptr;
+        }
+
+        void expire() {
+            std::exchange(scheduled, nullptr)->on_expire();
+        }
+    };
+} // namespace
+
+TEST(FunctionalTests, TrailingModeOnAnyTimerService) {
+    using namespace std::chrono;
+
+    manual_timers     timers;
+    std::vector<int>  calls;
+    debounce_trailing debounced{timers, milliseconds(5), [&](int value) {
+                                    calls.push_back(value);
+                                }};
+    debounced(1);
+    debounced(2);
+    ASSERT_NE(timers.scheduled, nullptr);
+    EXPECT_TRUE(calls.empty());
+    timers.expire();
+    EXPECT_EQ(calls, std::vector<int>{2});
+    EXPECT_FALSE(debounced.pending());
+}
+
+TEST(FunctionalTests, BothMode) {
+    using namespace std::chrono;
+
+    stl::net::io_context  io;
+    common::timer_service timers{io, milliseconds(1)};
+    std::vector<int>      calls;
+    debounce_both         debounced{timers, milliseconds(5), [&](int value) {
+                                calls.push_back(value);
+                            }};
+
+    // the first one right away, and the last one at the end
+    for (int i = 0; i < 10; i++)
+        debounced(i);
+    EXPECT_EQ(calls, std::vector<int>{0});
+    io.run();
+    EXPECT_EQ(calls, (std::vector<int>{0, 9}));
+
+    // a single call only runs once
+    calls.clear();
+    debounced(10);
+    io.restart();
+    io.run();
+    EXPECT_EQ(calls, std::vector<int>{10});
+}
+
+TEST(FunctionalTests, ConcurrentLeadingMode) {
+    using namespace std::chrono;
+
+    // only one of the threads gets to call it in the interval
+    std::atomic<int> calls{0};
+    debounce         throttled{hours(1), [&calls] {
+                           calls++;
+                       }};
+    std::atomic<int> results{0};
+    debounce         computed{hours(1), [&results] {
+                          return ++results * 10;
+                      }};
+    std::vector<std::thread> threads;
+    std::atomic<int>         wrong{0};
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 10'000; i++) {
+                throttled();
+                if (computed() != 10)
+                    wrong++;
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(results, 1);
+    EXPECT_EQ(wrong, 0) << "the others get the result of the one that was called";
+}
+
+TEST(FunctionalTests, LeadingModeFirstCallThrows) {
+    using namespace std::chrono;
+
+    // the window of a call that threw is given back, nobody waits for it
+    int      calls = 0;
+    debounce throttled{hours(1), [&calls] {
+                           if (calls++ == 0)
+                               throw std::runtime_error("first one");
+                       }};
+    EXPECT_THROW(throttled(), std::runtime_error);
+    throttled();
+    throttled();
+    EXPECT_EQ(calls, 2);
+
+    int      results = 0;
+    debounce computed{hours(1), [&results] {
+                          if (results++ == 0)
+                              throw std::runtime_error("first one");
+                          return results * 10;
+                      }};
+    EXPECT_THROW(computed(), std::runtime_error);
+    EXPECT_EQ(computed(), 20) << "there's no result yet, so it makes the call";
+    EXPECT_EQ(computed(), 20) << "and then it's shared in its window";
+    EXPECT_EQ(results, 2);
+}
+
+TEST(FunctionalTests, TrailingModeKeepsTheArguments) {
+    using namespace std::chrono;
+
+    // the arguments are kept as the parameters of the callable
+    manual_timers            timers;
+    std::vector<std::string> calls;
+    debounce_trailing        by_ref{timers, milliseconds(5), [&](std::string const& key, std::string&& value) {
+                                 calls.push_back(key + '=' + value);
+                             }};
+    std::string const        long_key(64, 'k');
+    by_ref(long_key, std::string{"1"});
+    by_ref(long_key, std::string{"2"});
+    timers.expire();
+    EXPECT_EQ(calls, std::vector<std::string>{long_key + "=2"});
+
+    // a generic one doesn't have known parameters, but works the same way
+    calls.clear();
+    debounce_trailing generic{timers, milliseconds(5), [&](auto const& value) {
+                                  calls.emplace_back(value);
+                              }};
+    generic("a");
+    generic("b");
+    timers.expire();
+    EXPECT_EQ(calls, std::vector<std::string>{"b"});
+    EXPECT_FALSE(generic.pending());
 }
@@ -0,0 +1,298 @@
+#include "../core/include/webpp/http/graphql.hpp"
+#include "../core/include/webpp/http/routes/extensions/graphql.hpp"
+#include "../core/include/webpp/utils/sha256.hpp"
+
+#include "../core/include/webpp/http/interfaces/fcgi.hpp"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace webpp;
+
+namespace {
+    struct graphql_app {};
+
+    using graphql_request = basic_request<std_traits, fcgi<std_traits, graphql_app>>;
+
+    struct fake_request {
+        fastcgi::request source;
+        graphql_request  req{source};
+
+        fake_request(std::string_view uri, std::string_view method, std::string_view body = {},
+                     std::string_view content_type = "application/json") {
+            auto const add = [this](std::string_view name, std::string_view value) {
+                source.params += char(name.size());
+                source.params += char(value.size());
+                source.params += name;
+                source.params += value;
+            };
+            add("REQUEST_URI", uri);
+            add("REQUEST_METHOD", method);
+            add("CONTENT_TYPE", content_type);
+            add("HTTP_CONTENT_TYPE", content_type);
+            source.std_in = body;
+        }
+    };
+
+    std::string hex(sha256::digest_type const& digest) {
+        std::string res;
+        for (auto const byte : digest) {
+            res += "0123456789abcdef"[byte >> 4u];
+            res += "0123456789abcdef"[byte & 0xFu];
+        }
+        return res;
+    }
+
+    std::string to_json(graphql::response const& res) {
+        std::string out;
+        json::serialize(out, res);
+        return out;
+    }
+
+    // posts and their authors; the authors are loaded in batches
+    struct blog {
+        int                           author_loads = 0; // the calls of the batch resolver
+        std::vector<std::string>      loaded{};         // the ids that it was given
+        std::shared_ptr<graphql::service> service;
+
+        blog() {
+            graphql::schema schema;
+            schema.enumeration("Order", {"NEWEST", "OLDEST"});
+            schema.query()
+              .field("posts", "[Post!]!",
+                     [](graphql::resolve_info const& info) {
+                         graphql::list posts;
+                         auto const    count = info.arg("first")->as_int();
+                         for (std::int64_t i = 1; i <= count; i++)
+                             posts.push_back(graphql::object{{"id", i},
+                                                             {"title", "post " + std::to_string(i)},
+                                                             {"author_id", std::to_string(i % 2)}});
+                         if (info.arg("order")->as_string() == "OLDEST")
+                             std::reverse(posts.begin(), posts.end());
+                         return posts;
+                     })
+              .argument("first", "Int", 3)
+              .argument("order", "Order", "NEWEST");
+            schema.query()
+              .batch_field("user", "User",
+                           [this](graphql::batch_info const& info) {
+                               author_loads++;
+                               graphql::list users;
+                               for (auto const& item : info.items) {
+                                   auto const id = std::string{item.arg("id")->as_string()};
+                                   loaded.push_back(id);
+                                   users.push_back(id == "404" ? graphql::value{}
+                                                               : graphql::object{{"id", id}, {"name", "user " + id}});
+                               }
+                               return users;
+                           })
+              .argument("id", "ID!");
+            schema.query().field("fail", "String", [](graphql::resolve_info const& info) {
+                info.fail("it failed");
+                return graphql::value{"ignored"};
+            });
+            schema.query().field("echo", "[Float]", [](graphql::resolve_info const& info) {
+                return *info.arg("values");
+            }).argument("values", "[Float]");
+            schema.object("Post").field("id", "ID!");
+            schema.object("Post").field("title", "String!");
+            schema.object("Post").batch_field("author", "User!", [this](graphql::batch_info const& info) {
+                author_loads++;
+                graphql::list users;
+                for (auto const& item : info.items) {
+                    auto const id = std::string{item.parent->find("author_id")->as_string()};
+                    loaded.push_back(id);
+                    users.push_back(graphql::object{{"id", id}, {"name", "user " + id}});
+                }
+                return users;
+            });
+            schema.object("User").field("id", "ID!");
+            schema.object("User").field("name", "String!");
+            schema.mutation().field("rename", "String!", [](graphql::resolve_info const& info) {
+                return graphql::value{info.arg("name")->as_string()};
+            }).argument("name", "String!");
+            service = std::make_shared<graphql::service>(std::move(schema));
+        }
+
+        std::string run(std::string_view query, graphql::object variables = {}) {
+            return to_json(service->execute({.query = query, .variables = std::move(variables)}));
+        }
+    };
+} // namespace
+
+TEST(GraphQL, SHA256) {
+    EXPECT_EQ(hex(sha256::hash("")), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    EXPECT_EQ(hex(sha256::hash("abc")), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    EXPECT_EQ(hex(sha256::hash("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq")),
+              "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    sha256 split;
+    split.update("ab").update("c");
+    EXPECT_EQ(split.digest(), sha256::hash("abc"));
+    static_assert(sha256::hash("abc")[0] == 0xba);
+}
+
+TEST(GraphQL, ParseErrors) {
+    blog b;
+    EXPECT_EQ(b.run("{ posts { title }"),
+              R"({"errors":[{"message":"expected \"}\"","locations":[{"line":1,"column":18}]}]})");
+    EXPECT_EQ(b.run("{\n  posts(first: 01) { title } }"),
+              R"({"errors":[{"message":"a number can't start with a zero","locations":[{"line":2,"column":16}]}]})");
+    EXPECT_EQ(b.run("{ echo(values: \"abc) }"),
+              R"({"errors":[{"message":"the string is not closed","locations":[{"line":1,"column":23}]}]})");
+    EXPECT_EQ(b.run(""), R"({"errors":[{"message":"there's no query"}]})");
+    std::string deep = "{ a";
+    for (int i = 0; i < 60; i++)
+        deep += " { a";
+    deep += std::string(61, '}');
+    EXPECT_NE(b.run(deep).find("the query is nested too deep"), std::string::npos);
+}
+
+TEST(GraphQL, ValidationErrors) {
+    blog b;
+    EXPECT_EQ(b.run("{ nope }"),
+              R"({"errors":[{"message":"the type Query has no field \"nope\"","locations":[{"line":1,"column":3}]}]})");
+    EXPECT_NE(b.run("{ posts }").find("needs a selection of its fields"), std::string::npos);
+    EXPECT_NE(b.run("{ posts { title { x } } }").find("has no fields to select"), std::string::npos);
+    EXPECT_NE(b.run("{ user { id } }").find("\\\"id\\\" of the field \\\"user\\\" is required"), std::string::npos);
+    EXPECT_NE(b.run("{ posts(first: \"a\") { id } }").find("the value is not a Int"), std::string::npos);
+    EXPECT_NE(b.run("{ posts(order: SIDEWAYS) { id } }").find("not a Order"), std::string::npos);
+    EXPECT_NE(b.run("{ posts(last: 1) { id } }").find("has no argument \\\"last\\\""), std::string::npos);
+    EXPECT_NE(b.run("query($n: Int) { posts { id } }").find("$n is not used"), std::string::npos);
+    EXPECT_NE(b.run("{ posts(first: $n) { id } }").find("$n is not defined"), std::string::npos);
+    EXPECT_NE(b.run("{ ...F } fragment F on Query { ...F }").find("spreads itself"), std::string::npos);
+    EXPECT_NE(b.run("{ posts { ...F } } fragment F on User { id }").find("can't be spread"), std::string::npos);
+    EXPECT_NE(b.run("{ posts { id } } fragment F on Post { id }").find("F is not used"), std::string::npos);
+    EXPECT_NE(b.run("{ posts @defer { id } }").find("@defer is not known"), std::string::npos);
+    EXPECT_NE(b.run("{ a: posts { id } } { b: posts { id } }").find("should be the only one"), std::string::npos);
+    EXPECT_NE(b.run("subscription { posts { id } }").find("not supported"), std::string::npos);
+    EXPECT_EQ(b.service->cached_plans(), 0) << "the invalid ones are not kept";
+}
+
+TEST(GraphQL, Execution) {
+    blog b;
+    EXPECT_EQ(b.run("{ posts(first: 2) { id title } }"),
+              R"({"data":{"posts":[{"id":"1","title":"post 1"},{"id":"2","title":"post 2"}]}})");
+
+    // aliases, fragments, the directives, the variables, and __typename
+    EXPECT_EQ(b.run(R"(
+        query Blog($skip: Boolean!, $order: Order = OLDEST) {
+          latest: posts(first: 1) { ...title __typename }
+          oldest: posts(first: 2, order: $order) {
+            ... on Post { id }
+            title @skip(if: $skip)
+            id @include(if: false)
+          }
+        }
+        fragment title on Post { title }
+      )",
+                    {{"skip", true}}),
+              R"({"data":{"latest":[{"title":"post 1","__typename":"Post"}],"oldest":[{"id":"2"},{"id":"1"}]}})");
+
+    // the variables are coerced, and checked
+    EXPECT_EQ(b.run("query($v: [Float]) { echo(values: $v) }", {{"v", 2}}), R"({"data":{"echo":[2]}})");
+    EXPECT_EQ(b.run("{ echo(values: [1, 2.5]) }"), R"({"data":{"echo":[1,2.5]}})");
+    EXPECT_NE(b.run("query($v: [Float]) { echo(values: $v) }", {{"v", "x"}}).find("$v is not a [Float]"),
+              std::string::npos);
+    EXPECT_NE(b.run("query($id: ID!) { user(id: $id) { id } }").find("$id is required"), std::string::npos);
+    EXPECT_EQ(b.run("query($id: ID!) { user(id: $id) { id } }", {{"id", 7}}), R"({"data":{"user":{"id":"7"}}})");
+
+    // the errors of the resolvers are next to the data, with their paths
+    EXPECT_EQ(b.run("{ fail user(id: 404) { id } }"),
+              R"({"errors":[{"message":"it failed","locations":[{"line":1,"column":3}],"path":["fail"]}],)"
+              R"("data":{"fail":null,"user":null}})");
+
+    // the strings are unescaped
+    EXPECT_EQ(b.run(R"(mutation { rename(name: "a\"bé\n") })"), R"({"data":{"rename":"a\"bé\n"}})");
+    EXPECT_EQ(b.run("mutation { a: rename(name: \"\"\"\n    x\n      y\n  \"\"\") }"),
+              R"({"data":{"a":"x\n  y"}})");
+}
+
+TEST(GraphQL, BatchedResolvers) {
+    blog b;
+    // one call for the authors of all the posts, not one for each post
+    EXPECT_EQ(b.run("{ posts(first: 4) { id author { name } } }"),
+              R"({"data":{"posts":[{"id":"1","author":{"name":"user 1"}},{"id":"2","author":{"name":"user 0"}},)"
+              R"({"id":"3","author":{"name":"user 1"}},{"id":"4","author":{"name":"user 0"}}]}})");
+    EXPECT_EQ(b.author_loads, 1);
+    EXPECT_EQ(b.loaded.size(), 4);
+
+    // and across the aliases in a level
+    b.author_loads = 0;
+    b.loaded.clear();
+    EXPECT_EQ(b.run(R"({ a: user(id: 1) { name } b: user(id: "2") { name } c: user(id: 404) { name } })"),
+              R"({"data":{"a":{"name":"user 1"},"b":{"name":"user 2"},"c":null}})");
+    EXPECT_EQ(b.author_loads, 1);
+    EXPECT_EQ(b.loaded, (std::vector<std::string>{"1", "2", "404"}));
+}
+
+TEST(GraphQL, PlanCache) {
+    blog       b;
+    auto const query = "{ posts { id } }";
+    EXPECT_EQ(b.run(query), b.run(query));
+    EXPECT_EQ(b.service->cached_plans(), 1);
+
+    std::vector<graphql::error> errors;
+    auto const                  first  = b.service->prepare(query, errors);
+    auto const                  second = b.service->prepare(query, errors);
+    EXPECT_EQ(first, second) << "parsed once";
+    EXPECT_TRUE(errors.empty());
+    EXPECT_NE(b.service->prepare("{ posts { title } }", errors), first);
+    EXPECT_EQ(b.service->cached_plans(), 2);
+}
+
+TEST(GraphQL, PersistedQueries) {
+    blog       b;
+    auto const query = std::string_view{"{ posts(first: 1) { title } }"};
+    auto const hash  = hex(sha256::hash(query));
+
+    auto missing = b.service->execute({.persisted_hash = hash});
+    EXPECT_EQ(to_json(missing),
+              R"({"errors":[{"message":"PersistedQueryNotFound","extensions":{"code":"PERSISTED_QUERY_NOT_FOUND"}}]})");
+
+    auto wrong = b.service->execute({.query = "{ posts { id } }", .persisted_hash = hash});
+    EXPECT_NE(to_json(wrong).find("doesn't match"), std::string::npos);
+    EXPECT_EQ(b.service->persisted_queries(), 0);
+
+    auto const expected = R"({"data":{"posts":[{"title":"post 1"}]}})";
+    EXPECT_EQ(to_json(b.service->execute({.query = query, .persisted_hash = hash})), expected);
+    EXPECT_EQ(b.service->persisted_queries(), 1);
+    EXPECT_EQ(to_json(b.service->execute({.persisted_hash = hash})), expected);
+}
+
+TEST(GraphQL, Route) {
+    using context_type = simple_context<graphql_request>;
+
+    blog b;
+    auto route   = extensions::graphql(b.service);
+    auto respond = [&](fake_request& fake) {
+        context_type ctx{fake.req};
+        auto         res = route(ctx);
+        return res ? std::to_string(res->header.status_code) + " " + std::string{res->body.str()}
+                   : std::string{"none"};
+    };
+
+    fake_request post{"/graphql", "POST",
+                      R"({"query":"query($n: Int) { posts(first: $n) { id } }","variables":{"n":1}})"};
+    EXPECT_EQ(respond(post), R"(200 {"data":{"posts":[{"id":"1"}]}})");
+
+    fake_request raw{"/graphql", "POST", "{ posts(first: 1) { title } }", "application/graphql"};
+    EXPECT_EQ(respond(raw), R"(200 {"data":{"posts":[{"title":"post 1"}]}})");
+
+    fake_request get{"/graphql?query=query%20Q(%24n%3A%20Int)%7Bposts(first%3A%24n)%7Bid%7D%7D&variables=%7B%22n%22%3A2%7D",
+                     "GET"};
+    EXPECT_EQ(respond(get), R"(200 {"data":{"posts":[{"id":"1"},{"id":"2"}]}})");
+
+    fake_request get_mutation{"/graphql?query=mutation%7Brename(name%3A%22x%22)%7D", "GET"};
+    EXPECT_EQ(respond(get_mutation), R"(200 {"errors":[{"message":"the mutations are only allowed over POST"}]})");
+
+    fake_request broken{"/graphql", "POST", "{not json"};
+    EXPECT_EQ(respond(broken), R"(400 {"errors":[{"message":"the GraphQL request is not valid"}]})");
+
+    fake_request put{"/graphql", "PUT"};
+    EXPECT_EQ(respond(put).substr(0, 3), "405");
+
+    fake_request other{"/other", "POST"};
+    EXPECT_EQ(respond(other), "none");
+}
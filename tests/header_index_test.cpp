@@ -0,0 +1,81 @@
+#include "../core/include/webpp/http/header_index.hpp"
+#include "../core/include/webpp/http/interfaces/fcgi.hpp"
+#include "../core/include/webpp/http/interfaces/simple_server.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace webpp;
+
+namespace {
+    struct index_app {};
+
+    void add_param(fastcgi::request& source, std::string_view name, std::string_view value) {
+        source.params += char(name.size());
+        source.params += char(value.size());
+        source.params += name;
+        source.params += value;
+    }
+} // namespace
+
+TEST(HeaderIndex, LazyLookup) {
+    std::vector<std::pair<std::string_view, std::string_view>> const fields{
+      {"Host", "example.com"}, {"accept", "text/html"}, {"X-Dup", "first"}, {"x-dup", "second"}};
+
+    lazy_header_index<8> index;
+    int                  builds = 0;
+    auto const           fill   = [&](auto& add) {
+        builds++;
+        for (auto const& [name, value] : fields)
+            add(name, value);
+    };
+    EXPECT_FALSE(index.is_built());
+    EXPECT_EQ(index.find("Host"), "") << "not built yet";
+
+    EXPECT_EQ(index.find("HOST", fill), "example.com");
+    EXPECT_EQ(index.find("Accept", fill), "text/html");
+    EXPECT_EQ(index.find("X-DUP", fill), "first") << "the first one of the duplicates";
+    EXPECT_EQ(index.find("Cookie", fill), "");
+    EXPECT_EQ(builds, 1) << "indexed once";
+    EXPECT_EQ(index.fields().size(), 4);
+    EXPECT_FALSE(index.overflowed());
+
+    index.clear();
+    EXPECT_FALSE(index.is_built());
+
+    lazy_header_index<2> small;
+    EXPECT_EQ(small.find("accept", fill), "text/html");
+    EXPECT_EQ(small.find("x-dup", fill), "");
+    EXPECT_TRUE(small.overflowed());
+}
+
+TEST(HeaderIndex, FastCGIRequest) {
+    fastcgi::request source;
+    add_param(source, "REQUEST_URI", "/");
+    add_param(source, "CONTENT_TYPE", "application/json");
+    add_param(source, "HTTP_ACCEPT_ENCODING", "gzip");
+    add_param(source, "HTTP_HOST", "example.com");
+    add_param(source, "SERVER_NAME", "localhost");
+    basic_request<std_traits, fcgi<std_traits, index_app>> req{source};
+
+    EXPECT_EQ(req.header("Accept-Encoding"), "gzip");
+    EXPECT_EQ(req.header("host"), "example.com");
+    EXPECT_EQ(req.header("Content-Type"), "application/json") << "it's not an HTTP_ param in CGI";
+    EXPECT_EQ(req.header("Server-Name"), "") << "not a header";
+    EXPECT_EQ(req.header("Cookie"), "");
+}
+
+TEST(HeaderIndex, SimpleServerRequest) {
+    http1::request_view view;
+    view.headers[0]   = {"Host", "example.com"};
+    view.headers[1]   = {"Accept", "*/*"};
+    view.header_count = 2;
+    basic_request<std_traits, simple_server<std_traits, index_app>> req{view};
+
+    EXPECT_EQ(req.header("host"), "example.com");
+    EXPECT_EQ(req.header("ACCEPT"), "*/*");
+    EXPECT_EQ(req.header("Accept-Encoding"), "");
+}
@@ -0,0 +1,60 @@
+#include "../core/include/webpp/views/html_template.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+
+using namespace webpp::views;
+
+TEST(HTMLTemplate, Static) {
+    static constexpr static_html_template<R"(<a href="{{ url }}" title="{{title}}">{{title}}</a>{{{ raw }}}{{! a comment }}!)">
+      link{};
+    static_assert(link.slot_count == 3);
+    static_assert(link.slot<"url">() == 0);
+    static_assert(link.slot<"title">() == 1);
+    static_assert(link.slot<"raw">() == 2);
+    static_assert(link.name(1) == "title");
+
+    std::string out = "[";
+    link.render(out, {"/a?b=1&c=2", "Tom & \"Jerry\"", "<br>"});
+    EXPECT_EQ(out,
+              R"([<a href="/a?b=1&amp;c=2" title="Tom &amp; &quot;Jerry&quot;">Tom &amp; &quot;Jerry&quot;</a><br>!)");
+
+    static constexpr static_html_template<"no variables"> plain{};
+    static_assert(plain.slot_count == 0);
+    out.clear();
+    plain.render(out, {});
+    EXPECT_EQ(out, "no variables");
+}
+
+TEST(HTMLTemplate, Runtime) {
+    auto const page = html_template::compile("<p>{{name}} is {{ age }}</p>{{{footer}}}{{name}}");
+    ASSERT_TRUE(page);
+    EXPECT_EQ(page->slot_count(), 3);
+    EXPECT_EQ(page->slot("age"), 1);
+    EXPECT_EQ(page->slot("none"), std::string_view::npos);
+
+    std::string out;
+    page->render(out, {"<me>", "30", "<hr>"});
+    EXPECT_EQ(out, "<p>&lt;me&gt; is 30</p><hr>&lt;me&gt;");
+
+    out.clear();
+    page->render(out, {"me"});
+    EXPECT_EQ(out, "<p>me is </p>me") << "the missing values are empty";
+
+    // the template has its own copy of the text
+    std::string text = "{{a}}-{{b}}";
+    auto const  copy = html_template::compile(text);
+    text.assign(text.size(), 'x');
+    out.clear();
+    copy->render(out, {"1", "2"});
+    EXPECT_EQ(out, "1-2");
+
+    EXPECT_FALSE(html_template::compile("{{name"));
+    EXPECT_FALSE(html_template::compile("{{{name}}"));
+    EXPECT_FALSE(html_template::compile("{{}}"));
+    EXPECT_FALSE(html_template::compile("{{a b}}"));
+    EXPECT_FALSE(html_template::compile("{{<script>}}"));
+    EXPECT_TRUE(html_template::compile("a } b }} c"));
+    EXPECT_TRUE(html_template::compile(""));
+}
@@ -0,0 +1,58 @@
+#include "../core/include/webpp/encoding/html.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+
+using namespace webpp::encoding;
+
+TEST(HTML, Escape) {
+    auto const escaped = [](std::string_view str) {
+        std::string out = "[";
+        escape_html(str, out);
+        return out;
+    };
+    EXPECT_EQ(escaped(""), "[");
+    EXPECT_EQ(escaped("plain text"), "[plain text");
+    EXPECT_EQ(escaped(R"(<a href="x" title='y'>Tom & Jerry</a>)"),
+              "[&lt;a href=&quot;x&quot; title=&#39;y&#39;&gt;Tom &amp; Jerry&lt;/a&gt;");
+    EXPECT_EQ(escaped("&amp;"), "[&amp;amp;") << "escaped again, it's not known to be escaped";
+    EXPECT_EQ(escaped("caf\xc3\xa9 \xe2\x80\x9c\xe2\x80\x9d"), "[caf\xc3\xa9 \xe2\x80\x9c\xe2\x80\x9d");
+
+    static_assert(html_escaped_size("a<b") == 6);
+    static_assert(html_escaped_size("") == 0);
+}
+
+TEST(HTML, BoundedOutput) {
+    char out[16]{};
+    EXPECT_EQ(escape_html("a<b", out, 6), 6);
+    EXPECT_EQ(std::string_view(out, 6), "a&lt;b");
+    EXPECT_EQ(escape_html("a<b", out, 5), std::string_view::npos);
+    EXPECT_EQ(escape_html("abcdef", out, 5), std::string_view::npos);
+    EXPECT_EQ(escape_html("", out, 0), 0);
+
+    constexpr auto size = [] {
+        char buf[8]{};
+        return escape_html("'&'", buf, 8);
+    }();
+    static_assert(size == std::string_view::npos, "&#39;&amp;&#39; is 15 chars");
+}
+
+TEST(HTML, EveryPosition) {
+    // the vectors find them anywhere in the blocks, and in the tails
+    std::string_view const specials = "<>&\"'";
+    for (std::size_t size = 1; size < 80; size++) {
+        for (std::size_t pos = 0; pos < size; pos++) {
+            for (auto const c : specials) {
+                std::string str(size, 'x');
+                str[pos] = c;
+                EXPECT_EQ(html_scanner::find(str), pos);
+                std::string out;
+                escape_html(str, out);
+                EXPECT_EQ(out.size(), html_escaped_size(str));
+                EXPECT_EQ(out.substr(pos, html_entity(c).size()), html_entity(c));
+            }
+        }
+        EXPECT_EQ(html_scanner::find(std::string(size, 'x')), std::string_view::npos);
+    }
+}
@@ -0,0 +1,597 @@
+#include "../core/include/webpp/http/bodies/file.hpp"
+#include "../core/include/webpp/http/bodies/stream.hpp"
+#include "../core/include/webpp/http/bodies/string.hpp"
+#include "../core/include/webpp/http/http.hpp"
+#include "../core/include/webpp/http/interfaces/http1/request_parser.hpp"
+#include "../core/include/webpp/http/interfaces/http1/scanner.hpp"
+#include "../core/include/webpp/http/interfaces/simple_server.hpp"
+#include "../core/include/webpp/http/response.hpp"
+#include "../core/include/webpp/http/routes/router.hpp"
+#include "../core/include/webpp/utils/task.hpp"
+
+#include <boost/asio/steady_timer.hpp>
+#include <chrono>
+#include <coroutine>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace webpp;
+
+TEST(HTTP1, RequestParser) {
+    std::string_view const data = "GET /index.html?q=1 HTTP/1.1\r\n"
+                                  "Host: example.com\r\n"
+                                  "Content-Length:  5 \r\n"
+                                  "\r\n"
+                                  "helloGET / HTTP/1.0\r\n\r\n";
+
+    http1::request_view req;
+    std::size_t         consumed = 0;
+    ASSERT_EQ(http1::parse_request(data, req, consumed), http1::parse_status::complete);
+    EXPECT_EQ(req.method, "GET");
+    EXPECT_EQ(req.target, "/index.html?q=1");
+    EXPECT_EQ(req.header_count, 2);
+    EXPECT_EQ(req.header("host"), "example.com");
+    EXPECT_EQ(req.header("content-length"), "5");
+    EXPECT_EQ(req.body, "hello");
+    EXPECT_TRUE(req.keep_alive());
+
+    // the pipelined one
+    auto const rest = data.substr(consumed);
+    ASSERT_EQ(http1::parse_request(rest, req, consumed), http1::parse_status::complete);
+    EXPECT_EQ(req.target, "/");
+    EXPECT_EQ(req.version_minor, 0);
+    EXPECT_FALSE(req.keep_alive());
+    EXPECT_EQ(consumed, rest.size());
+    EXPECT_EQ(req.body.data() - data.data() > 0, true); // a view into the data
+}
+
+TEST(HTTP1, IncompleteAndErrors) {
+    http1::request_view req;
+    std::size_t         consumed = 0;
+    EXPECT_EQ(http1::parse_request("GET / HTTP/1.1\r\nHost: a", req, consumed), http1::parse_status::incomplete);
+    EXPECT_EQ(
+      http1::parse_request("POST / HTTP/1.1\r\nHost: a\r\nContent-Length: 10\r\n\r\nabc", req, consumed),
+      http1::parse_status::incomplete);
+    EXPECT_EQ(http1::parse_request("GET / HTTP/2.0\r\n\r\n", req, consumed), http1::parse_status::error);
+    EXPECT_EQ(http1::parse_request("GET /\r\n\r\n", req, consumed), http1::parse_status::error);
+    EXPECT_EQ(http1::parse_request("GET / HTTP/1.1\r\nHost: a\r\nBad Header: x\r\n\r\n", req, consumed),
+              http1::parse_status::error);
+    EXPECT_EQ(http1::parse_request("GET / HTTP/1.1\r\nHost: a\r\nContent-Length: x\r\n\r\n", req, consumed),
+              http1::parse_status::error);
+
+    // the body is too big to wait for, and the transfer codings are not supported
+    EXPECT_EQ(
+      http1::parse_request("POST / HTTP/1.1\r\nHost: a\r\nContent-Length: 11\r\n\r\nabc", req, consumed, 10),
+      http1::parse_status::too_large);
+    EXPECT_EQ(http1::parse_request("POST / HTTP/1.1\r\nHost: a\r\nContent-Length: 10\r\n\r\n0123456789",
+                                   req,
+                                   consumed,
+                                   10),
+              http1::parse_status::complete);
+    EXPECT_EQ(http1::parse_request("POST / HTTP/1.1\r\nHost: a\r\nContent-Length: 999999999999999\r\n\r\n",
+                                   req,
+                                   consumed),
+              http1::parse_status::too_large);
+    EXPECT_EQ(http1::parse_request("POST / HTTP/1.1\r\n"
+                                   "Host: a\r\nTransfer-Encoding: chunked\r\n\r\n0\r\n\r\n",
+                                   req,
+                                   consumed),
+              http1::parse_status::not_implemented);
+
+    // the empty lines before the request count in the size limit
+    std::string crlfs;
+    for (std::size_t i = 0; i < http1::max_header_block_size / 2 + 1; i++)
+        crlfs.append("\r\n");
+    EXPECT_EQ(http1::parse_request(crlfs, req, consumed), http1::parse_status::error);
+
+    // the Content-Lengths should agree, and HTTP/1.1 needs exactly one Host
+    EXPECT_EQ(http1::parse_request("POST / HTTP/1.1\r\nHost: a\r\n"
+                                   "Content-Length: 3\r\nContent-Length: 3\r\n\r\nabc",
+                                   req,
+                                   consumed),
+              http1::parse_status::complete);
+    EXPECT_EQ(http1::parse_request("POST / HTTP/1.1\r\nHost: a\r\n"
+                                   "Content-Length: 3\r\nContent-Length: 4\r\n\r\nabcd",
+                                   req,
+                                   consumed),
+              http1::parse_status::error);
+    EXPECT_EQ(http1::parse_request("GET / HTTP/1.1\r\n\r\n", req, consumed), http1::parse_status::error);
+    EXPECT_EQ(http1::parse_request("GET / HTTP/1.1\r\nHost: a\r\nHost: b\r\n\r\n", req, consumed),
+              http1::parse_status::error);
+    EXPECT_EQ(http1::parse_request("GET / HTTP/1.0\r\n\r\n", req, consumed), http1::parse_status::complete);
+}
+
+TEST(HTTP1, Scanner) {
+    // put the delimiters at every position relative to the 16/32 byte blocks
+    for (std::size_t len = 0; len < 70; len++) {
+        for (std::size_t at = 0; at <= len; at++) {
+            std::string str(len, 'a');
+            if (at != len)
+                str[at] = ':';
+            for (std::size_t pos = 0; pos <= len; pos++) {
+                EXPECT_EQ(http1::simd_scanner::find(str, pos, ':', '\r'),
+                          http1::scalar_scanner::find(str, pos, ':', '\r'));
+            }
+        }
+    }
+    static_assert(http1::simd_scanner::find("ab\r\n", 0, '\r', '\n') == 2);
+}
+
+TEST(HTTP1, LongHeadersAndPartialReads) {
+    std::string data = "GET / HTTP/1.1\r\nHost: a\r\n";
+    for (int i = 0; i < 20; i++) {
+        data.append("X-Header-Number-");
+        data.append(std::to_string(i));
+        data.append(": ");
+        data.append(static_cast<std::size_t>(i * 7), 'v');
+        data.append("\r\n");
+    }
+    data.append("\r\n");
+
+    http1::request_view req;
+    std::size_t         consumed = 0;
+    ASSERT_EQ(http1::parse_request(data, req, consumed), http1::parse_status::complete);
+    EXPECT_EQ(consumed, data.size());
+    EXPECT_EQ(req.header_count, 21);
+    EXPECT_EQ(req.header("x-header-number-19"), std::string(19 * 7, 'v'));
+
+    // the same result with the scalar scanner
+    http1::request_view scalar_req;
+    ASSERT_EQ(http1::parse_request<http1::scalar_scanner>(data, scalar_req, consumed),
+              http1::parse_status::complete);
+    for (std::size_t i = 0; i < req.header_count; i++) {
+        EXPECT_EQ(req.headers[i].name, scalar_req.headers[i].name);
+        EXPECT_EQ(req.headers[i].value, scalar_req.headers[i].value);
+    }
+
+    // any prefix of it is incomplete
+    for (std::size_t len = 0; len < data.size(); len++)
+        EXPECT_EQ(http1::parse_request(std::string_view{data}.substr(0, len), req, consumed),
+                  http1::parse_status::incomplete)
+          << len;
+
+    // bare LFs are not accepted
+    EXPECT_EQ(http1::parse_request("GET / HTTP/1.1\r\nHost: a\n\r\n", req, consumed), http1::parse_status::error);
+}
+
+namespace {
+    using string_response_type =
+      basic_response<std_traits, empty_extension_pack, response_headers<std_traits>, string_body::type<std_traits>>;
+
+    struct echo_app {
+        template <typename RequestType>
+        string_response_type operator()(RequestType const& req) {
+            return string_response_type{200u, std::string{req.request_uri()}};
+        }
+    };
+} // namespace
+
+TEST(HTTP1, SimpleServerKeepAliveAndPipelining) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    boost::asio::io_context io;
+    tcp::acceptor           acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    tcp::socket             client{io};
+    client.connect(acceptor.local_endpoint());
+    common::connection conn{acceptor.accept()};
+
+    simple_server<std_traits, echo_app> server;
+    bool                                closed = false;
+    conn.start(
+      [&] {
+          closed = true;
+      },
+      [&, state = decltype(server)::connection_state{}](common::connection& c, std::string_view data) mutable {
+          server.handle(c, state, data);
+      });
+
+    // two pipelined requests, and the start of the third one
+    boost::asio::write(client, boost::asio::buffer(std::string_view{"GET /one HTTP/1.1\r\nHost: a\r\n\r\n"
+                                                                    "GET /two HTTP/1.1\r\nHost: a\r\n\r\n"
+                                                                    "GET /a/./b/../%7ec?%7e HTTP/1.1\r\n"
+                                                                    "Host: a\r\n\r\n"
+                                                                    "GET /three HTTP/1.1\r\nHost: a\r\n"}));
+    io.run_for(50ms);
+    boost::asio::write(client, boost::asio::buffer(std::string_view{"Connection: close\r\n\r\n"}));
+    io.run_for(50ms);
+    EXPECT_TRUE(closed);
+
+    std::string               received;
+    boost::system::error_code ec;
+    boost::asio::read(client, boost::asio::dynamic_buffer(received), ec);
+    EXPECT_EQ(ec, boost::asio::error::eof);
+
+    auto const first  = received.find("HTTP/1.1 200 OK\r\n");
+    auto const second = received.find("HTTP/1.1 200 OK\r\n", first + 1);
+    auto const third  = received.find("HTTP/1.1 200 OK\r\n", second + 1);
+    EXPECT_EQ(first, 0);
+    EXPECT_NE(third, std::string::npos);
+    EXPECT_LT(received.find("/one"), received.find("/two"));
+    EXPECT_LT(received.find("/two"), received.find("/three"));
+    EXPECT_NE(received.find("/a/~c?%7e"), std::string::npos) << "the target is normalized";
+    EXPECT_NE(received.find("Connection: close\r\n", third), std::string::npos);
+    EXPECT_EQ(received.substr(received.size() - 6), "/three");
+}
+
+TEST(HTTP1, SimpleServerRejectsBigBodies) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    boost::asio::io_context io;
+    tcp::acceptor           acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    tcp::socket             client{io};
+    client.connect(acceptor.local_endpoint());
+    common::connection conn{acceptor.accept()};
+
+    simple_server<std_traits, echo_app> server;
+    server.max_body_size(4);
+    bool closed = false;
+    conn.start(
+      [&] {
+          closed = true;
+      },
+      [&, state = decltype(server)::connection_state{}](common::connection& c, std::string_view data) mutable {
+          server.handle(c, state, data);
+      });
+
+    // the body is never sent; the headers are enough to reject it
+    boost::asio::write(client,
+                       boost::asio::buffer(std::string_view{"POST /big HTTP/1.1\r\n"
+                                                            "Host: a\r\nContent-Length: 5\r\n\r\n"}));
+    io.run_for(50ms);
+    EXPECT_TRUE(closed);
+
+    std::string               received;
+    boost::system::error_code ec;
+    boost::asio::read(client, boost::asio::dynamic_buffer(received), ec);
+    EXPECT_EQ(received.find("HTTP/1.1 413 "), 0);
+    EXPECT_EQ(received.find("/big"), std::string::npos);
+}
+
+namespace {
+    using file_response_type =
+      basic_response<std_traits, empty_extension_pack, response_headers<std_traits>, file_body::type<std_traits>>;
+
+    struct file_app {
+        std::filesystem::path path;
+
+        template <typename RequestType>
+        file_response_type operator()(RequestType const&) {
+            file_response_type res{200u};
+            res.body = file_body::type<std_traits>{path};
+            return res;
+        }
+    };
+} // namespace
+
+TEST(HTTP1, SimpleServerSendFile) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    // bigger than what the socket buffers hold, so the kernel has to wait
+    // for the client in the middle of it
+    std::string content(4 * 1024 * 1024, '\0');
+    for (std::size_t i = 0; i < content.size(); i++)
+        content[i] = static_cast<char>('a' + i % 26);
+    auto const path = std::filesystem::temp_directory_path() / "webpp_send_file_test.txt";
+    {
+        std::ofstream out{path, std::ios::binary};
+        out << content;
+    }
+
+    boost::asio::io_context io;
+    tcp::acceptor           acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    tcp::socket             client{io};
+    client.connect(acceptor.local_endpoint());
+    common::connection conn{acceptor.accept()};
+
+    simple_server<std_traits, file_app> server;
+    server.app.path = path;
+    bool closed     = false;
+    conn.start(
+      [&] {
+          closed = true;
+      },
+      [&, state = decltype(server)::connection_state{}](common::connection& c, std::string_view data) mutable {
+          server.handle(c, state, data);
+      });
+
+    boost::asio::write(client, boost::asio::buffer(std::string_view{"GET /one HTTP/1.1\r\nHost: a\r\n\r\n"
+                                                                    "GET /two HTTP/1.1\r\nHost: a\r\n"
+                                                                    "Connection: close\r\n\r\n"}));
+    std::string               received;
+    std::vector<char>         chunk(64 * 1024);
+    boost::system::error_code ec;
+    client.non_blocking(true);
+    for (int i = 0; i < 10000 && ec != boost::asio::error::eof; i++) {
+        io.run_for(1ms);
+        auto const n = client.read_some(boost::asio::buffer(chunk), ec);
+        received.append(chunk.data(), n);
+    }
+    EXPECT_TRUE(closed);
+    std::filesystem::remove(path);
+
+    // the heads and the files are in their order
+    auto const first_head  = received.find("\r\n\r\n");
+    auto const second_head = received.find("HTTP/1.1 200 OK\r\n", first_head);
+    ASSERT_NE(second_head, std::string::npos);
+    EXPECT_NE(received.find("Content-Length: 4194304\r\n"), std::string::npos);
+    EXPECT_EQ(received.substr(first_head + 4, second_head - first_head - 4), content);
+    EXPECT_EQ(received.substr(received.size() - content.size()), content);
+}
+
+namespace {
+    using stream_response_type =
+      basic_response<std_traits, empty_extension_pack, response_headers<std_traits>, stream_body::type<std_traits>>;
+
+    chunk_generator report(std::string name) {
+        co_yield name;
+        co_yield std::string_view{"beta"};
+        co_yield "gamma";
+    }
+
+    struct stream_app {
+        template <typename RequestType>
+        stream_response_type operator()(RequestType const& req) {
+            stream_response_type res{200u};
+            res.body = stream_body::type<std_traits>{report(std::string{req.request_uri()})};
+            return res;
+        }
+    };
+} // namespace
+
+TEST(HTTP1, SimpleServerStream) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    boost::asio::io_context io;
+    tcp::acceptor           acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    tcp::socket             client{io};
+    client.connect(acceptor.local_endpoint());
+    common::connection conn{acceptor.accept()};
+
+    simple_server<std_traits, stream_app> server;
+    bool                                  closed = false;
+    conn.start(
+      [&] {
+          closed = true;
+      },
+      [&, state = decltype(server)::connection_state{}](common::connection& c, std::string_view data) mutable {
+          server.handle(c, state, data);
+      });
+
+    boost::asio::write(client, boost::asio::buffer(std::string_view{"GET /one HTTP/1.1\r\nHost: a\r\n\r\n"
+                                                                    "GET /two HTTP/1.0\r\n\r\n"}));
+    std::string               received;
+    std::vector<char>         chunk(64 * 1024);
+    boost::system::error_code ec;
+    client.non_blocking(true);
+    for (int i = 0; i < 10000 && ec != boost::asio::error::eof; i++) {
+        io.run_for(1ms);
+        auto const n = client.read_some(boost::asio::buffer(chunk), ec);
+        received.append(chunk.data(), n);
+    }
+    EXPECT_TRUE(closed);
+
+    // the first one is chunked, and the HTTP/1.0 one is read until we close
+    auto const first_head  = received.find("\r\n\r\n");
+    auto const second_head = received.find("HTTP/1.1 200 OK\r\n", first_head);
+    ASSERT_NE(second_head, std::string::npos);
+    auto const first = received.substr(0, second_head);
+    EXPECT_NE(first.find("Transfer-Encoding: chunked\r\n"), std::string::npos);
+    EXPECT_EQ(first.find("Content-Length"), std::string::npos);
+    EXPECT_EQ(first.substr(first_head + 4), "4\r\n/one\r\n4\r\nbeta\r\n5\r\ngamma\r\n0\r\n\r\n");
+
+    auto const second = received.substr(second_head);
+    EXPECT_EQ(second.find("Transfer-Encoding"), std::string::npos);
+    EXPECT_NE(second.find("Connection: close\r\n"), std::string::npos);
+    EXPECT_EQ(second.substr(second.find("\r\n\r\n") + 4), "/twobetagamma");
+}
+
+#ifdef __unix__
+TEST(HTTP1, SimpleServerPrefork) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    // a free port, so the client knows where the master is going to listen
+    unsigned short port = 0;
+    {
+        boost::asio::io_context io;
+        tcp::acceptor           probe{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+        port = probe.local_endpoint().port();
+    }
+    http<simple_server<std_traits, echo_app>, echo_app> server;
+    server.add_endpoint("127.0.0.1", port);
+
+    // the workers are forked from this process, so the client is a thread of the master
+    std::string     received;
+    pthread_t const master = pthread_self();
+    std::thread     client_thread{[&] {
+        boost::asio::io_context   io;
+        tcp::socket               client{io};
+        boost::system::error_code ec;
+        for (int i = 0; i < 100; i++) {
+            client.connect({boost::asio::ip::make_address("127.0.0.1"), port}, ec);
+            if (!ec)
+                break;
+            client.close();
+            std::this_thread::sleep_for(20ms);
+        }
+        boost::asio::write(client,
+                           boost::asio::buffer(std::string_view{"GET /forked HTTP/1.1\r\n"
+                                                                "Host: a\r\nConnection: close\r\n\r\n"}),
+                           ec);
+        boost::asio::read(client, boost::asio::dynamic_buffer(received), ec);
+        pthread_kill(master, SIGTERM); // the supervisor stops the workers
+    }};
+    EXPECT_EQ(server.run(common::prefork_options{.workers = 2, .pin = false, .stop_timeout = 1s}), SIGTERM);
+    client_thread.join();
+    EXPECT_EQ(received.find("HTTP/1.1 200 OK\r\n"), 0);
+    EXPECT_EQ(received.substr(received.size() - 7), "/forked");
+}
+#endif
+
+namespace {
+    struct slow_app {
+        template <typename RequestType>
+        string_response_type operator()(RequestType const& req) {
+            if (req.request_uri() == "/slow")
+                std::this_thread::sleep_for(std::chrono::milliseconds{30});
+            return string_response_type{200u, std::string{req.request_uri()}};
+        }
+    };
+} // namespace
+
+TEST(HTTP1, SimpleServerLoadShedding) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    boost::asio::io_context io;
+    tcp::acceptor           acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    tcp::socket             client{io};
+    client.connect(acceptor.local_endpoint());
+    common::connection conn{acceptor.accept()};
+
+    simple_server<std_traits, slow_app> server;
+    load_shedder                        shedder{{.target = 1ms, .interval = 10ms}};
+    conn.shedding(shedder);
+    conn.start([] {},
+               [&, state = decltype(server)::connection_state{}](common::connection& c, std::string_view data) mutable {
+                   server.handle(c, state, data);
+               });
+
+    // the second one waits behind the slow one for longer than it should
+    boost::asio::write(client, boost::asio::buffer(std::string_view{"GET /slow HTTP/1.1\r\nHost: a\r\n\r\n"
+                                                                    "GET /fast HTTP/1.1\r\n"
+                                                                    "Host: a\r\nConnection: close\r\n\r\n"}));
+    io.run_for(100ms);
+
+    std::string               received;
+    boost::system::error_code ec;
+    boost::asio::read(client, boost::asio::dynamic_buffer(received), ec);
+    EXPECT_EQ(received.find("HTTP/1.1 200 OK\r\n"), 0);
+    EXPECT_NE(received.find("/slow"), std::string::npos);
+    EXPECT_NE(received.find("HTTP/1.1 503 Service Unavailable\r\n"), std::string::npos);
+    EXPECT_EQ(received.find("/fast"), std::string::npos) << "the application never saw it";
+    EXPECT_EQ(shedder.shed_count(), 1);
+}
+
+namespace {
+    // the io_context of the test that is running; the routes' timers wait on it
+    boost::asio::io_context* timers_io  = nullptr;
+    bool                     saw_cancel = false;
+
+    struct sleep_for {
+        std::chrono::milliseconds                delay;
+        std::optional<boost::asio::steady_timer> timer{};
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> h) {
+            timer.emplace(*timers_io, delay);
+            timer->async_wait([h](boost::system::error_code const&) {
+                h.resume();
+            });
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    struct task_app {
+        template <typename RequestType>
+        auto operator()(RequestType& req) const {
+            static router const app{[](auto& ctx) -> task<std::optional<std::string>> {
+                auto const uri = std::string{ctx.request->request_uri()};
+                co_await sleep_for{uri == "/first" ? std::chrono::milliseconds{30} : std::chrono::milliseconds{5}};
+                saw_cancel = ctx.is_cancelled();
+                if (saw_cancel)
+                    co_return std::nullopt;
+                co_return uri;
+            }};
+            return app(req);
+        }
+    };
+} // namespace
+
+TEST(HTTP1, SimpleServerTasks) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    boost::asio::io_context io;
+    timers_io  = &io;
+    saw_cancel = false;
+    tcp::acceptor acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    tcp::socket   client{io};
+    client.connect(acceptor.local_endpoint());
+    common::connection conn{acceptor.accept()};
+
+    simple_server<std_traits, task_app> server;
+    bool                                closed = false;
+    conn.start(
+      [&] {
+          closed = true;
+      },
+      [&, state = decltype(server)::connection_state{}](common::connection& c, std::string_view data) mutable {
+          server.handle(c, state, data);
+      });
+
+    // the first one waits for longer, but the second one is answered after it
+    boost::asio::write(client, boost::asio::buffer(std::string_view{"GET /first HTTP/1.1\r\nHost: a\r\n\r\n"
+                                                                    "GET /second HTTP/1.1\r\nHost: a\r\n"
+                                                                    "Connection: close\r\n\r\n"}));
+    io.run_for(10ms);
+    EXPECT_FALSE(closed);
+    EXPECT_EQ(client.available(), 0) << "nothing is sent before the first task is done";
+    io.run_for(100ms);
+    EXPECT_TRUE(closed);
+
+    std::string               received;
+    boost::system::error_code ec;
+    boost::asio::read(client, boost::asio::dynamic_buffer(received), ec);
+    EXPECT_EQ(received.find("HTTP/1.1 200 OK\r\n"), 0);
+    EXPECT_LT(received.find("/first"), received.find("/second"));
+    EXPECT_NE(received.find("Connection: close\r\n"), std::string::npos);
+    EXPECT_EQ(received.substr(received.size() - 7), "/second");
+    EXPECT_FALSE(saw_cancel);
+}
+
+TEST(HTTP1, SimpleServerCancelsTasksOfClosedConnections) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    boost::asio::io_context io;
+    timers_io  = &io;
+    saw_cancel = false;
+    tcp::acceptor acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    tcp::socket   client{io};
+    client.connect(acceptor.local_endpoint());
+    common::connection conn{acceptor.accept()};
+
+    simple_server<std_traits, task_app> server;
+    bool                                closed = false;
+    conn.start(
+      [&] {
+          closed = true;
+      },
+      [&, state = decltype(server)::connection_state{}](common::connection& c, std::string_view data) mutable {
+          server.handle(c, state, data);
+      });
+
+    // the client gives up while the task is waiting for its timer
+    boost::asio::write(client, boost::asio::buffer(std::string_view{"GET /first HTTP/1.1\r\n"
+                                                                    "Host: a\r\n\r\n"}));
+    io.run_for(10ms);
+    client.close();
+    io.run_for(100ms);
+    EXPECT_TRUE(closed);
+    EXPECT_TRUE(saw_cancel);
+}
@@ -0,0 +1,453 @@
+#include "../core/include/webpp/http/bodies/string.hpp"
+#include "../core/include/webpp/http/interfaces/http2.hpp"
+#include "../core/include/webpp/http/interfaces/http2/hpack.hpp"
+#include "../core/include/webpp/http/interfaces/http2/session.hpp"
+#include "../core/include/webpp/http/response.hpp"
+#include "../core/include/webpp/utils/task.hpp"
+
+#include <algorithm>
+#include <boost/asio.hpp>
+#include <chrono>
+#include <coroutine>
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace webpp;
+using namespace webpp::http2;
+
+namespace {
+
+    using field_list = std::vector<std::pair<std::string, std::string>>;
+
+    std::string from_hex(std::string_view hex) {
+        std::string res;
+        auto        nibble = [](char c) {
+            return c <= '9' ? c - '0' : c - 'a' + 10;
+        };
+        for (std::size_t i = 0; i + 1 < hex.size(); i += 2) {
+            if (hex[i] == ' ') {
+                i--;
+                continue;
+            }
+            res.push_back(static_cast<char>(nibble(hex[i]) * 16 + nibble(hex[i + 1])));
+        }
+        return res;
+    }
+
+    field_list decode(hpack::decoder& dec, std::string_view block) {
+        field_list res;
+        EXPECT_TRUE(dec.decode(block, [&](std::string_view name, std::string_view value) {
+            res.emplace_back(name, value);
+        }));
+        return res;
+    }
+
+    struct client_frame {
+        frame_header header;
+        std::string  payload;
+    };
+
+    std::vector<client_frame> frames_of(std::string_view data) {
+        std::vector<client_frame> res;
+        while (data.size() >= frame_header_length) {
+            auto const header = frame_header::parse(data);
+            res.push_back({header, std::string{data.substr(frame_header_length, header.length)}});
+            data.remove_prefix(frame_header_length + header.length);
+        }
+        return res;
+    }
+
+    std::string request_headers(uint32_t id, std::string_view path, uint8_t frame_flags) {
+        std::string block;
+        hpack::encode_header(block, ":method", "GET");
+        hpack::encode_header(block, ":scheme", "http");
+        hpack::encode_header(block, ":path", path);
+        hpack::encode_header(block, ":authority", "example.com");
+        std::string frame;
+        append_frame(frame, frame_type::headers, frame_flags, id, block);
+        return frame;
+    }
+
+    std::string client_start() {
+        std::string data{connection_preface};
+        append_settings(data, {});
+        return data;
+    }
+
+} // namespace
+
+TEST(HTTP2, HPACKRequestExamples) {
+    // RFC 7541 C.4: requests with Huffman coding, sharing one dynamic table
+    hpack::decoder dec;
+    auto first = decode(dec, from_hex("8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff"));
+    EXPECT_EQ(first, (field_list{{":method", "GET"},
+                                 {":scheme", "http"},
+                                 {":path", "/"},
+                                 {":authority", "www.example.com"}}));
+    EXPECT_EQ(dec.dynamic_table_size(), 57);
+
+    auto second = decode(dec, from_hex("8286 84be 5886 a8eb 1064 9cbf"));
+    EXPECT_EQ(second.back(), (std::pair<std::string, std::string>{"cache-control", "no-cache"}));
+    EXPECT_EQ(second[3].second, "www.example.com");
+    EXPECT_EQ(dec.dynamic_table_size(), 110);
+
+    auto third = decode(dec, from_hex("8287 85bf 4088 25a8 49e9 5ba9 7d7f 8925 a849 e95b b8e8 b4bf"));
+    EXPECT_EQ(third.back(), (std::pair<std::string, std::string>{"custom-key", "custom-value"}));
+    EXPECT_EQ(third[2].second, "/index.html");
+    EXPECT_EQ(dec.dynamic_table_size(), 164);
+
+    // an index that is not in any of the tables
+    EXPECT_FALSE(dec.decode(from_hex("ff00"), [](auto, auto) {}));
+}
+
+TEST(HTTP2, HPACKEncoder) {
+    std::string block;
+    hpack::encode_status(block, 200);
+    EXPECT_EQ(block, "\x88"); // one byte from the static table
+    hpack::encode_status(block, 201);
+    hpack::encode_header(block, "Content-Type", "text/html; charset=utf-8");
+    hpack::encode_header(block, "X-Powered-By", "webpp");
+    hpack::encode_header(block, "accept-encoding", "gzip, deflate");
+
+    hpack::decoder dec;
+    auto const     fields = decode(dec, block);
+    EXPECT_EQ(fields, (field_list{{":status", "200"},
+                                  {":status", "201"},
+                                  {"content-type", "text/html; charset=utf-8"},
+                                  {"x-powered-by", "webpp"},
+                                  {"accept-encoding", "gzip, deflate"}}));
+    EXPECT_EQ(dec.dynamic_table_count(), 0); // the encoder doesn't use the dynamic table
+
+    // Huffman round trip of all the bytes
+    std::string all;
+    for (int i = 0; i < 256; i++)
+        all.push_back(static_cast<char>(i));
+    std::string encoded, decoded;
+    hpack::huffman_encode(all, encoded);
+    EXPECT_EQ(encoded.size(), hpack::huffman_encoded_size(all));
+    ASSERT_TRUE(hpack::huffman_decode(encoded, decoded));
+    EXPECT_EQ(decoded, all);
+}
+
+TEST(HTTP2, SessionMultiplexing) {
+    std::vector<uint32_t> handled;
+    session               s{[&](session& sess, stream& st) {
+        handled.push_back(st.id);
+        EXPECT_EQ(st.authority(), "example.com");
+        struct field {
+            std::string_view name, value;
+        };
+        std::vector<field> headers{{"Content-Type", "text/plain"}, {"Connection", "keep-alive"}};
+        sess.respond(st.id, 200, headers, std::string{st.path()});
+    }};
+    auto const            greeting = frames_of(s.take_output());
+    ASSERT_EQ(greeting.size(), 2);
+    EXPECT_EQ(greeting[0].header.type, frame_type::settings);
+    EXPECT_EQ(greeting[1].header.type, frame_type::window_update);
+
+    auto data = client_start();
+    data.append(request_headers(1, "/one", flags::end_headers | flags::end_stream));
+    data.append(request_headers(3, "/three", flags::end_headers | flags::end_stream));
+    // feed it in small pieces to see that frames can be split between reads
+    for (std::size_t i = 0; i < data.size(); i += 7)
+        ASSERT_TRUE(s.feed(std::string_view{data}.substr(i, 7)));
+    EXPECT_EQ(handled, (std::vector<uint32_t>{1, 3}));
+    EXPECT_EQ(s.stream_count(), 0);
+
+    hpack::decoder dec;
+    auto const     frames = frames_of(s.take_output());
+    ASSERT_EQ(frames.size(), 5);
+    EXPECT_EQ(frames[0].header.type, frame_type::settings);
+    EXPECT_TRUE(frames[0].header.has(flags::ack));
+    EXPECT_EQ(frames[1].header.type, frame_type::headers);
+    EXPECT_EQ(frames[1].header.stream_id, 1);
+    EXPECT_EQ(decode(dec, frames[1].payload),
+              (field_list{{":status", "200"}, {"content-type", "text/plain"}})); // no "connection"
+    EXPECT_EQ(frames[2].header.type, frame_type::data);
+    EXPECT_EQ(frames[2].payload, "/one");
+    EXPECT_TRUE(frames[2].header.has(flags::end_stream));
+    EXPECT_EQ(frames[4].header.stream_id, 3);
+    EXPECT_EQ(frames[4].payload, "/three");
+}
+
+TEST(HTTP2, SessionNormalizesThePath) {
+    std::string path;
+    session     s{[&](session&, stream& st) {
+        path = st.path();
+    }};
+    auto        data = client_start();
+    data.append(request_headers(1, "/a/./b/../%7ec?%7e", flags::end_headers | flags::end_stream));
+    ASSERT_TRUE(s.feed(data));
+    EXPECT_EQ(path, "/a/~c?%7e");
+}
+
+TEST(HTTP2, SessionFlowControl) {
+    session s{[](session& sess, stream& st) {
+        struct field {
+            std::string_view name, value;
+        };
+        sess.respond(st.id, 200, std::vector<field>{}, std::string(25, 'x'));
+    }};
+    (void)s.take_output();
+
+    std::string data{connection_preface};
+    append_settings(data, {{settings_id::initial_window_size, 10}});
+    data.append(request_headers(1, "/", flags::end_headers | flags::end_stream));
+    ASSERT_TRUE(s.feed(data));
+
+    auto frames = frames_of(s.take_output());
+    ASSERT_EQ(frames.size(), 3); // settings ack, headers, the first 10 bytes
+    EXPECT_EQ(frames[2].payload.size(), 10);
+    EXPECT_FALSE(frames[2].header.has(flags::end_stream));
+    EXPECT_EQ(s.stream_count(), 1);
+
+    std::string update;
+    append_window_update(update, 1, 100);
+    ASSERT_TRUE(s.feed(update));
+    frames = frames_of(s.take_output());
+    ASSERT_EQ(frames.size(), 1);
+    EXPECT_EQ(frames[0].payload.size(), 15);
+    EXPECT_TRUE(frames[0].header.has(flags::end_stream));
+    EXPECT_EQ(s.stream_count(), 0);
+}
+
+TEST(HTTP2, SessionErrors) {
+    session bad_preface;
+    EXPECT_FALSE(bad_preface.feed("GET / HTTP/1.1\r\n\r\n"));
+
+    session s;
+    (void)s.take_output();
+    auto data = client_start();
+    append_frame(data, frame_type::data, 0, 0, "oops"); // DATA on the connection stream
+    EXPECT_FALSE(s.feed(data));
+    auto const frames = frames_of(s.take_output());
+    ASSERT_FALSE(frames.empty());
+    EXPECT_EQ(frames.back().header.type, frame_type::goaway);
+    EXPECT_EQ(read_uint32(std::string_view{frames.back().payload}.substr(4)),
+              static_cast<uint32_t>(error_code::protocol_error));
+    EXPECT_TRUE(s.should_close());
+}
+
+TEST(HTTP2, SessionBodyLimit) {
+    std::string body;
+    session     s{[&](session&, stream& st) {
+                  body = st.body;
+              },
+              10};
+    (void)s.take_output();
+
+    auto data = client_start();
+    data.append(request_headers(1, "/", flags::end_headers));
+    append_frame(data, frame_type::data, 0, 1, "01234");
+    ASSERT_TRUE(s.feed(data));
+    auto frames = frames_of(s.take_output());
+    ASSERT_EQ(frames.size(), 2); // the settings ack, and the connection's window is opened right away
+    EXPECT_EQ(frames[0].header.type, frame_type::settings);
+    EXPECT_EQ(frames[1].header.type, frame_type::window_update);
+    EXPECT_EQ(frames[1].header.stream_id, 0);
+    EXPECT_EQ(read_uint32(frames[1].payload), 5);
+
+    data.clear();
+    append_frame(data, frame_type::data, flags::end_stream, 1, "56789");
+    ASSERT_TRUE(s.feed(data));
+    EXPECT_EQ(body, "0123456789");
+    frames = frames_of(s.take_output());
+    ASSERT_EQ(frames.size(), 1);
+    EXPECT_EQ(frames[0].header.type, frame_type::window_update);
+    EXPECT_EQ(frames[0].header.stream_id, 0);
+    EXPECT_EQ(read_uint32(frames[0].payload), 5);
+
+    // one byte too many
+    data = request_headers(3, "/", flags::end_headers);
+    append_frame(data, frame_type::data, 0, 3, "0123456789a");
+    ASSERT_TRUE(s.feed(data));
+    frames = frames_of(s.take_output());
+    ASSERT_EQ(frames.size(), 3);
+    EXPECT_EQ(frames[0].header.type, frame_type::headers);
+    EXPECT_TRUE(frames[0].header.has(flags::end_stream));
+    hpack::decoder dec;
+    EXPECT_EQ(decode(dec, frames[0].payload), (field_list{{":status", "413"}}));
+    EXPECT_EQ(frames[1].header.type, frame_type::rst_stream);
+    EXPECT_EQ(read_uint32(frames[1].payload), static_cast<uint32_t>(error_code::no_error));
+    EXPECT_EQ(frames[2].header.type, frame_type::window_update);
+    EXPECT_EQ(read_uint32(frames[2].payload), 11);
+    EXPECT_EQ(s.stream_count(), 1); // the first one is waiting for its response
+}
+
+TEST(HTTP2, SessionConcurrentUploads) {
+    constexpr std::size_t    body_size = 1024 * 1024;
+    std::vector<std::size_t> bodies;
+    session                  s{[&](session&, stream& st) {
+                  bodies.push_back(st.body.size());
+              },
+              body_size};
+
+    // what the client is allowed to send on the connection
+    int64_t window = default_initial_window_size;
+    auto    credit = [&] {
+        for (auto const& frame : frames_of(s.take_output()))
+            if (frame.header.type == frame_type::window_update && frame.header.stream_id == 0)
+                window += read_uint32(frame.payload);
+    };
+    auto upload = [&](uint32_t id, std::size_t size, uint8_t last_flags) {
+        std::string const chunk(default_max_frame_size, 'x');
+        for (std::size_t sent = 0; sent < size; sent += chunk.size()) {
+            auto const len = std::min(chunk.size(), size - sent);
+            ASSERT_GE(window, static_cast<int64_t>(len)) << "the connection's window is used up";
+            std::string frame;
+            append_frame(frame, frame_type::data, sent + len == size ? last_flags : 0, id,
+                         std::string_view{chunk}.substr(0, len));
+            window -= static_cast<int64_t>(len);
+            ASSERT_TRUE(s.feed(frame));
+            credit();
+        }
+    };
+    credit();
+
+    auto data = client_start();
+    data.append(request_headers(1, "/", flags::end_headers));
+    data.append(request_headers(3, "/", flags::end_headers));
+    ASSERT_TRUE(s.feed(data));
+    credit();
+
+    // together, the two halves are more than the connection's window
+    upload(1, body_size * 3 / 4, 0);
+    upload(3, body_size * 3 / 4, 0);
+    EXPECT_TRUE(bodies.empty());
+    upload(1, body_size / 4, flags::end_stream);
+    upload(3, body_size / 4, flags::end_stream);
+    EXPECT_EQ(bodies, (std::vector<std::size_t>{body_size, body_size}));
+}
+
+TEST(HTTP2, SessionBufferedLimit) {
+    std::vector<std::string> bodies;
+    session                  s{[&](session&, stream& st) {
+                  bodies.push_back(st.body);
+              },
+              10,
+              15};
+    (void)s.take_output();
+
+    auto data = client_start();
+    data.append(request_headers(1, "/", flags::end_headers));
+    data.append(request_headers(3, "/", flags::end_headers));
+    append_frame(data, frame_type::data, 0, 1, "01234567");
+    append_frame(data, frame_type::data, 0, 3, "01234567"); // 16 bytes held
+    ASSERT_TRUE(s.feed(data));
+    auto const frames = frames_of(s.take_output());
+    auto const reset  = std::find_if(frames.begin(), frames.end(), [](auto const& frame) {
+        return frame.header.type == frame_type::rst_stream;
+    });
+    ASSERT_NE(reset, frames.end());
+    EXPECT_EQ(reset->header.stream_id, 3);
+    EXPECT_EQ(read_uint32(reset->payload), static_cast<uint32_t>(error_code::refused_stream));
+    EXPECT_EQ(s.stream_count(), 1);
+
+    // the first one goes on
+    data.clear();
+    append_frame(data, frame_type::data, flags::end_stream, 1, "89");
+    ASSERT_TRUE(s.feed(data));
+    EXPECT_EQ(bodies, std::vector<std::string>{"0123456789"});
+}
+
+namespace {
+    using string_response_type =
+      basic_response<std_traits, empty_extension_pack, response_headers<std_traits>, string_body::type<std_traits>>;
+
+    struct authority_app {
+        template <typename RequestType>
+        string_response_type operator()(RequestType const& req) {
+            return string_response_type{200u, std::string{req.header("Host")} + std::string{req.request_uri()}};
+        }
+    };
+} // namespace
+
+TEST(HTTP2, ServerResponses) {
+    http2_server<std_traits, authority_app> server;
+    session s{[&](session& sess, stream& st) {
+        server.serve(sess, st);
+    }};
+    (void)s.take_output();
+
+    auto data = client_start();
+    data.append(request_headers(1, "/path", flags::end_headers | flags::end_stream));
+    ASSERT_TRUE(s.feed(data));
+
+    hpack::decoder dec;
+    auto const     frames = frames_of(s.take_output());
+    ASSERT_EQ(frames.size(), 3);
+    auto const fields = decode(dec, frames[1].payload);
+    ASSERT_FALSE(fields.empty());
+    EXPECT_EQ(fields[0], (std::pair<std::string, std::string>{":status", "200"}));
+    EXPECT_NE(std::find(fields.begin(), fields.end(), std::pair<std::string, std::string>{"content-length", "16"}),
+              fields.end());
+    EXPECT_EQ(frames[2].payload, "example.com/path");
+}
+
+namespace {
+    // the tasks wait here until the test resumes them
+    std::coroutine_handle<> waiting_task{};
+
+    struct wait_for_test {
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> h) const noexcept {
+            waiting_task = h;
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    struct task_app {
+        template <typename RequestType>
+        task<string_response_type> operator()(RequestType const& req) {
+            co_await wait_for_test{};
+            co_return string_response_type{200u, std::string{req.header("Host")} + std::string{req.request_uri()}};
+        }
+    };
+} // namespace
+
+TEST(HTTP2, ServerTasks) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    boost::asio::io_context io;
+    tcp::acceptor           acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    tcp::socket             client{io};
+    client.connect(acceptor.local_endpoint());
+    common::connection conn{acceptor.accept()};
+
+    http2_server<std_traits, task_app> server;
+    common::task_link                  tasks;
+    session                            s{[&](session& sess, stream& st) {
+        server.serve_task(tasks, sess, st);
+    }};
+    conn.start([] {},
+               [&](common::connection& c, std::string_view data) {
+                   server.handle(c, s, tasks, data);
+               });
+
+    auto data = client_start();
+    data.append(request_headers(1, "/path", flags::end_headers | flags::end_stream));
+    boost::asio::write(client, boost::asio::buffer(data));
+    io.run_for(20ms);
+    ASSERT_TRUE(waiting_task);
+    EXPECT_EQ(s.stream_count(), 1) << "the stream waits for its task";
+
+    std::exchange(waiting_task, {}).resume();
+    io.run_for(20ms);
+    EXPECT_EQ(s.stream_count(), 0);
+
+    std::string received(client.available(), '\0');
+    boost::asio::read(client, boost::asio::buffer(received));
+    auto const frames = frames_of(received);
+    ASSERT_GE(frames.size(), 2);
+    EXPECT_EQ(frames[frames.size() - 2].header.type, frame_type::headers);
+    EXPECT_EQ(frames.back().header.type, frame_type::data);
+    EXPECT_EQ(frames.back().payload, "example.com/path");
+}
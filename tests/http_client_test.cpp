@@ -0,0 +1,172 @@
+#include "../core/include/webpp/http/bodies/string.hpp"
+#include "../core/include/webpp/http/http_client.hpp"
+#include "../core/include/webpp/http/interfaces/common/server.hpp"
+#include "../core/include/webpp/http/interfaces/http1/response_parser.hpp"
+#include "../core/include/webpp/http/interfaces/simple_server.hpp"
+#include "../core/include/webpp/http/response.hpp"
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace webpp;
+
+namespace {
+    using string_response_type = basic_response<std_traits,
+                                                empty_extension_pack,
+                                                response_headers<std_traits>,
+                                                string_body::type<std_traits>>;
+
+    struct echo_app {
+        template <typename RequestType>
+        string_response_type operator()(RequestType const& req) {
+            return string_response_type{200u, std::string{req.request_method()} + " " + std::string{req.request_uri()}};
+        }
+    };
+
+    /**
+     * An HTTP/1.1 server on the loopback; the client runs on its io_context too
+     */
+    struct echo_server {
+        common::server                      srv{{boost::asio::ip::tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}}};
+        simple_server<std_traits, echo_app> app;
+
+        echo_server() {
+            srv.on_connection([this] {
+                return [this, state = decltype(app)::connection_state{}](common::connection& conn,
+                                                                         std::string_view    data) mutable {
+                    app.handle(conn, state, data);
+                };
+            });
+        }
+
+        [[nodiscard]] std::uint16_t port() {
+            return srv.local_endpoints().front().port();
+        }
+
+        template <typename Pred>
+        void run_until(Pred&& pred) {
+            using namespace std::chrono_literals;
+            auto const limit = std::chrono::steady_clock::now() + 2s;
+            while (!pred() && std::chrono::steady_clock::now() < limit)
+                srv.io.run_for(5ms);
+        }
+    };
+} // namespace
+
+TEST(HTTPClient, ResponseParser) {
+    http1::response_view res;
+    std::size_t          head_size = 0;
+    std::string_view     data      = "HTTP/1.1 404 Not Found\r\nContent-Length: 5\r\nConnection: close\r\n\r\nnope!";
+    ASSERT_EQ(http1::parse_response_head(data, res, head_size), http1::parse_status::complete);
+    EXPECT_EQ(res.status, 404);
+    EXPECT_EQ(res.reason, "Not Found");
+    EXPECT_FALSE(res.keep_alive());
+    std::size_t length = 0;
+    EXPECT_EQ(http1::response_framing(res, false, length), http1::body_framing::content_length);
+    EXPECT_EQ(data.substr(head_size, length), "nope!");
+    EXPECT_EQ(http1::response_framing(res, true, length), http1::body_framing::none);
+
+    EXPECT_EQ(http1::parse_response_head(data.substr(0, 20), res, head_size), http1::parse_status::incomplete);
+    EXPECT_EQ(http1::parse_response_head("HTTP/1.1 2x0 OK\r\n\r\n", res, head_size), http1::parse_status::error);
+
+    std::string_view const chunked = "5\r\nhello\r\n6;ext=1\r\n world\r\n0\r\nTrailer: x\r\n\r\nHTTP/1.1";
+    std::string            body;
+    std::size_t            consumed = 0;
+    ASSERT_EQ(http1::parse_chunked_body(chunked, body, consumed), http1::parse_status::complete);
+    EXPECT_EQ(body, "hello world");
+    EXPECT_EQ(chunked.substr(consumed), "HTTP/1.1");
+    for (std::size_t i = 0; i < consumed; i++)
+        EXPECT_EQ(http1::parse_chunked_body(chunked.substr(0, i), body, consumed), http1::parse_status::incomplete)
+          << i;
+    EXPECT_EQ(http1::parse_chunked_body("5\r\nhelloXX0\r\n\r\n", body, consumed), http1::parse_status::error);
+}
+
+TEST(HTTPClient, KeepAlive) {
+    echo_server server;
+    http_client client{server.srv.io};
+
+    std::vector<client_response> results;
+    bool                         done = false;
+    // the lambda should outlive its coroutine
+    auto calls = [&]() -> task<void> {
+        for (auto const* target : {"/one", "/two", "/three"})
+            results.push_back(co_await client.get("127.0.0.1", server.port(), target));
+        client_request const post{.method = "POST", .target = "/four", .body = "x"};
+        results.push_back(co_await client.request("127.0.0.1", server.port(), post));
+    };
+    calls().start([&] {
+        done = true;
+    });
+    server.run_until([&] {
+        return done;
+    });
+
+    ASSERT_TRUE(done);
+    ASSERT_EQ(results.size(), 4);
+    EXPECT_EQ(results[0].status, 200);
+    EXPECT_EQ(results[0].body, "GET /one");
+    EXPECT_EQ(results[2].body, "GET /three");
+    EXPECT_EQ(results[3].body, "POST /four");
+    EXPECT_FALSE(results[3].header("Content-Length").empty());
+    EXPECT_EQ(client.connection_count("127.0.0.1", server.port()), 1) << "the connection is reused";
+    EXPECT_EQ(server.srv.connection_count(), 1);
+}
+
+TEST(HTTPClient, PipeliningAndFanOut) {
+    for (auto const pipelined : {true, false}) {
+        echo_server server;
+        http_client client{server.srv.io,
+                           {.max_connections_per_host = pipelined ? 1u : 4u, .max_pipeline = pipelined ? 4u : 1u}};
+
+        std::vector<std::string> bodies(8);
+        std::size_t              done = 0;
+        for (std::size_t i = 0; i < bodies.size(); i++) {
+            client.get("127.0.0.1", server.port(), "/" + std::to_string(i)).start([&, i](client_response res) {
+                bodies[i] = res.body;
+                done++;
+            });
+        }
+        server.run_until([&] {
+            return done == bodies.size();
+        });
+
+        ASSERT_EQ(done, bodies.size());
+        for (std::size_t i = 0; i < bodies.size(); i++)
+            EXPECT_EQ(bodies[i], "GET /" + std::to_string(i));
+        EXPECT_EQ(client.connection_count("127.0.0.1", server.port()), pipelined ? 1 : 4);
+    }
+}
+
+TEST(HTTPClient, TimeoutAndCancellation) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    // it accepts the connection, but it never answers
+    boost::asio::io_context io;
+    tcp::acceptor           acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    tcp::socket             peer{io};
+    acceptor.async_accept(peer, [](boost::system::error_code const&) {});
+    auto const port = acceptor.local_endpoint().port();
+
+    http_client                    client{io, {.timeout = 50ms}};
+    std::optional<client_response> timed_out, expired;
+    client.get("127.0.0.1", port, "/").start([&](client_response res) {
+        timed_out = std::move(res);
+    });
+    client.get("127.0.0.1", port, "/", cancellation_token::after(-1ms)).start([&](client_response res) {
+        expired = std::move(res);
+    });
+    ASSERT_TRUE(expired) << "it's not even sent";
+    EXPECT_EQ(expired->error, client_error::cancelled);
+
+    auto const start = std::chrono::steady_clock::now();
+    io.run_for(300ms);
+    ASSERT_TRUE(timed_out);
+    EXPECT_EQ(timed_out->error, client_error::timed_out);
+    EXPECT_FALSE(*timed_out);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 300ms);
+    EXPECT_EQ(client.connection_count("127.0.0.1", port), 0) << "its connection is closed";
+}
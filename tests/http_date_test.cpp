@@ -0,0 +1,111 @@
+#include "../core/include/webpp/http/http_date.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace webpp;
+
+namespace {
+    std::string http_date(std::int64_t seconds) {
+        std::string out(http_date_size, '\0');
+        format_http_date(seconds, out.data());
+        return out;
+    }
+} // namespace
+
+TEST(HTTPDate, Format) {
+    EXPECT_EQ(http_date(0), "Thu, 01 Jan 1970 00:00:00 GMT");
+    EXPECT_EQ(http_date(784'111'777), "Sun, 06 Nov 1994 08:49:37 GMT");
+    EXPECT_EQ(http_date(951'782'400), "Tue, 29 Feb 2000 00:00:00 GMT");
+    EXPECT_EQ(http_date(1'709'251'199), "Thu, 29 Feb 2024 23:59:59 GMT");
+    EXPECT_EQ(http_date(-1), "Wed, 31 Dec 1969 23:59:59 GMT");
+    EXPECT_EQ(http_date(-86'400 * 365), "Wed, 01 Jan 1969 00:00:00 GMT");
+    EXPECT_EQ(http_date(253'402'300'800).substr(5, 11), "01 Jan 9999") << "the years after 9999";
+
+    static constexpr auto at_compile_time = [] {
+        std::array<char, http_date_size> out{};
+        format_http_date(784'111'777, out.data());
+        return out;
+    }();
+    EXPECT_EQ(std::string_view(at_compile_time.data(), http_date_size), "Sun, 06 Nov 1994 08:49:37 GMT");
+}
+
+TEST(HTTPDate, Parse) {
+    EXPECT_EQ(parse_http_date("Thu, 01 Jan 1970 00:00:00 GMT"), 0);
+    EXPECT_EQ(parse_http_date("Sun, 06 Nov 1994 08:49:37 GMT"), 784'111'777);
+    EXPECT_EQ(parse_http_date("Thu, 29 Feb 2024 23:59:59 GMT"), 1'709'251'199);
+    EXPECT_EQ(parse_http_date("Wed, 31 Dec 1969 23:59:59 GMT"), -1);
+    for (std::int64_t seconds : {0LL, 951'782'400LL, 1'709'251'199LL, 4'102'444'800LL})
+        EXPECT_EQ(parse_http_date(http_date(seconds)), seconds);
+
+    EXPECT_FALSE(parse_http_date("Sunday, 06-Nov-94 08:49:37 GMT")) << "RFC 850";
+    EXPECT_FALSE(parse_http_date("Sun Nov  6 08:49:37 1994")) << "asctime";
+    EXPECT_FALSE(parse_http_date("Sun, 06 Nox 1994 08:49:37 GMT"));
+    EXPECT_FALSE(parse_http_date("Sun, 06 Nov 1994 24:49:37 GMT"));
+    EXPECT_FALSE(parse_http_date("Sun, 0a Nov 1994 08:49:37 GMT"));
+    EXPECT_FALSE(parse_http_date("Sun, 06 Nov 1994 08:49:37 UTC"));
+    EXPECT_FALSE(parse_http_date(""));
+    static_assert(parse_http_date("Sun, 06 Nov 1994 08:49:37 GMT") == 784'111'777);
+}
+
+TEST(HTTPDate, Cache) {
+    http_date_cache cache;
+    std::vector<std::thread> threads;
+    std::vector<int>         mismatches(4, 0);
+    for (std::size_t t = 0; t < mismatches.size(); t++) {
+        threads.emplace_back([&, t] {
+            char out[http_date_size];
+            for (std::int64_t i = 0; i < 20'000; i++) {
+                auto const seconds = 1'700'000'000 + i / 100 + static_cast<std::int64_t>(t) * 7;
+                cache.format(seconds, out);
+                if (std::string_view(out, http_date_size) != http_date(seconds))
+                    mismatches[t]++;
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    for (auto const mismatch : mismatches)
+        EXPECT_EQ(mismatch, 0);
+
+    using namespace std::chrono;
+    char out[http_date_size];
+    format_http_date(system_clock::time_point{seconds{784'111'777} + milliseconds{999}}, out);
+    EXPECT_EQ(std::string_view(out, http_date_size), "Sun, 06 Nov 1994 08:49:37 GMT");
+}
+
+TEST(HTTPDate, Clock) {
+    http_date_clock clock;
+    std::vector<std::thread> threads;
+    std::vector<int>         mismatches(4, 0);
+    for (std::size_t t = 0; t < mismatches.size(); t++) {
+        threads.emplace_back([&, t] {
+            char out[http_date_size];
+            for (std::int64_t i = 0; i < 20'000; i++) {
+                // the threads are a second apart now and then, like the clocks of the cores
+                auto const seconds = 1'700'000'000 + i / 100 + static_cast<std::int64_t>(t % 2);
+                clock.format(seconds, out);
+                if (std::string_view(out, http_date_size) != http_date(seconds))
+                    mismatches[t]++;
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    for (auto const mismatch : mismatches)
+        EXPECT_EQ(mismatch, 0);
+
+    char out[http_date_size];
+    format_current_http_date(out);
+    auto const now = parse_http_date({out, http_date_size});
+    ASSERT_TRUE(now);
+    auto const system_now =
+      std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    EXPECT_LE(std::abs(*now - system_now), 1);
+}
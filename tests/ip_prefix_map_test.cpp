@@ -0,0 +1,173 @@
+#include "../core/include/webpp/utils/ip_prefix_map.hpp"
+
+#include "../core/include/webpp/traits/std_traits.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace webpp;
+
+using ipv4_t = ipv4<std_traits>;
+using ipv6_t = ipv6<std_traits>;
+
+TEST(IPPrefixMap, LongestPrefix) {
+    ip_prefix_map<int> rules;
+    EXPECT_EQ(rules.find("10.1.2.3"), nullptr);
+    EXPECT_TRUE(rules.insert("10.1.2.0/24", 24));
+    EXPECT_TRUE(rules.insert("10.0.0.0/8", 8));
+    EXPECT_TRUE(rules.insert("10.1.0.0/16", 16));
+    EXPECT_TRUE(rules.insert("10.1.2.3", 32));
+    EXPECT_TRUE(rules.insert("2001:db8::/32", 32));
+    EXPECT_TRUE(rules.insert("2001:db8:1::/48", 48));
+    EXPECT_TRUE(rules.insert("::/0", 0));
+    EXPECT_FALSE(rules.insert("10.0.0.300/8", 0));
+    EXPECT_FALSE(rules.insert("10.0.0.0/40", 0));
+    EXPECT_FALSE(rules.insert("2001:db8::/200", 0));
+    EXPECT_EQ(rules.size(), 7);
+
+    auto value = [&](auto ip) {
+        auto const* res = rules.find(ip);
+        return res ? *res : -1;
+    };
+    EXPECT_EQ(value("10.1.2.3"), 32);
+    EXPECT_EQ(value("10.1.2.4"), 24);
+    EXPECT_EQ(value("10.1.3.4"), 16);
+    EXPECT_EQ(value("10.200.3.4"), 8);
+    EXPECT_EQ(value("11.0.0.1"), -1);
+    EXPECT_EQ(value("not an ip"), -1);
+    EXPECT_EQ(value(ipv4_t{10, 1, 2, 3}), 32);
+    EXPECT_EQ(value("2001:db8:1:2::1"), 48);
+    EXPECT_EQ(value("2001:db8:2::1"), 32);
+    EXPECT_EQ(value("fe80::1"), 0);
+    EXPECT_EQ(value("::ffff:10.1.2.4"), 24) << "the mapped ones are looked up in the IPv4 rules";
+    EXPECT_TRUE(rules.contains("10.9.9.9"));
+    EXPECT_FALSE(rules.contains("192.168.1.1"));
+}
+
+namespace {
+    template <std::size_t N>
+    bool matches(std::array<std::uint8_t, N> const& ip, std::array<std::uint8_t, N> const& net, int prefix) {
+        for (int bit = 0; bit < prefix; bit++) {
+            auto const mask = 0x80u >> (bit % 8);
+            if ((ip[bit / 8] & mask) != (net[bit / 8] & mask))
+                return false;
+        }
+        return true;
+    }
+
+    // the value of the longest one, and the last one of the same length
+    template <std::size_t N, typename Rules>
+    int linear_find(Rules const& rules, std::array<std::uint8_t, N> const& ip) {
+        int value = -1, best = -1;
+        for (std::size_t i = 0; i < rules.size(); i++) {
+            auto const& [net, prefix] = rules[i];
+            if (prefix >= best && matches(ip, net, prefix)) {
+                best  = prefix;
+                value = static_cast<int>(i);
+            }
+        }
+        return value;
+    }
+} // namespace
+
+TEST(IPPrefixMap, LikeALinearScan) {
+    std::mt19937 gen{42}; // NOLINT(cert-msc51-cpp)
+    auto         byte = [&] {
+        // a few of them, so the rules overlap
+        return static_cast<std::uint8_t>(gen() % 4 == 0 ? gen() % 256 : gen() % 3);
+    };
+
+    std::vector<std::pair<std::array<std::uint8_t, 4>, int>>  rules4;
+    std::vector<std::pair<std::array<std::uint8_t, 16>, int>> rules6;
+    ip_prefix_map<int>                                         map;
+    for (int i = 0; i < 3000; i++) {
+        if (gen() % 2) {
+            std::array<std::uint8_t, 4> net{byte(), byte(), byte(), byte()};
+            int const                   prefix = static_cast<int>(gen() % 33);
+            rules4.emplace_back(net, prefix);
+            map.insert(ipv4_t{net, static_cast<std::uint8_t>(prefix)}, static_cast<int>(rules4.size() - 1));
+        } else {
+            std::array<std::uint8_t, 16> net{};
+            for (auto& octet : net)
+                octet = byte();
+            net[0]           = 0x20; // not the IPv4-mapped ones
+            int const prefix = static_cast<int>(gen() % 129);
+            rules6.emplace_back(net, prefix);
+            map.insert(ipv6_t{net, static_cast<std::uint8_t>(prefix)},
+                       static_cast<int>(rules6.size() - 1) + 100'000);
+        }
+    }
+
+    for (int i = 0; i < 20'000; i++) {
+        std::array<std::uint8_t, 4> ip4{byte(), byte(), byte(), byte()};
+        auto const*                 found4 = map.find(ipv4_t{ip4});
+        ASSERT_EQ(found4 ? *found4 : -1, linear_find(rules4, ip4)) << ipv4_t{ip4}.str();
+
+        std::array<std::uint8_t, 16> ip6{};
+        for (auto& octet : ip6)
+            octet = byte();
+        ip6[0]            = 0x20;
+        auto const* found6 = map.find(ipv6_t{ip6});
+        auto const  linear = linear_find(rules6, ip6);
+        ASSERT_EQ(found6 ? *found6 : -1, linear == -1 ? -1 : linear + 100'000) << ipv6_t{ip6}.short_str();
+    }
+}
+
+TEST(IPPrefixMap, Load) {
+    ip_prefix_map<bool> allowed;
+    EXPECT_TRUE(allowed.load("# the office\n"
+                             "10.0.0.0/8\r\n"
+                             "\n"
+                             "   192.168.1.0/24   # the vpn\n"
+                             "2001:db8::/32",
+                             true));
+    EXPECT_EQ(allowed.size(), 3);
+    EXPECT_TRUE(allowed.contains("10.20.30.40"));
+    EXPECT_TRUE(allowed.contains("192.168.1.7"));
+    EXPECT_TRUE(allowed.contains("2001:db8::7"));
+    EXPECT_FALSE(allowed.contains("192.168.2.7"));
+
+    EXPECT_FALSE(allowed.load("172.16.0.0/12\nnonsense\n", false));
+    EXPECT_EQ(allowed.size(), 4) << "the valid lines are added anyway";
+    ASSERT_TRUE(allowed.find("172.16.1.1"));
+    EXPECT_FALSE(*allowed.find("172.16.1.1"));
+
+    auto const path = std::filesystem::temp_directory_path() / "webpp_ip_prefix_map_test.txt";
+    {
+        std::ofstream file{path};
+        for (int i = 0; i < 2000; i++)
+            file << "100." << i / 256 << '.' << i % 256 << ".0/24\n";
+    }
+    ip_prefix_map<bool> from_file;
+    EXPECT_TRUE(from_file.load_file(path, true));
+    EXPECT_EQ(from_file.size(), 2000);
+    EXPECT_TRUE(from_file.contains("100.7.207.1"));
+    EXPECT_FALSE(from_file.contains("100.7.208.1"));
+    std::filesystem::remove(path);
+    EXPECT_FALSE(from_file.load_file(path, true));
+}
+
+TEST(IPPrefixMap, AtomicSwap) {
+    atomic_ip_prefix_map<int> blocked;
+    EXPECT_TRUE(blocked.load()->empty());
+
+    ip_prefix_map<int> rules;
+    rules.insert("10.0.0.0/8", 1);
+    blocked.store(std::move(rules));
+    auto const old = blocked.load();
+    EXPECT_TRUE(old->contains("10.1.1.1"));
+
+    ip_prefix_map<int> new_rules;
+    new_rules.insert("192.168.0.0/16", 2);
+    blocked.store(std::move(new_rules));
+    EXPECT_FALSE(blocked.load()->contains("10.1.1.1"));
+    EXPECT_TRUE(blocked.load()->contains("192.168.1.1"));
+    EXPECT_TRUE(old->contains("10.1.1.1")) << "the old one is kept while it's being used";
+}
@@ -5,7 +5,10 @@
 
 #include <array>
 #include <gtest/gtest.h>
+#include <random>
+#include <string>
 #include <string_view>
+#include <vector>
 
 using namespace webpp;
 
@@ -55,6 +58,16 @@ TEST(IPv4Tests, Methods) {
     EXPECT_EQ(octets[3], 1);
 }
 
+TEST(IPv4Tests, SubnetArrays) {
+    ipv4_t ip{{10, 0, 0, 1}, std::array<uint8_t, 4>{255, 255, 0, 0}};
+    EXPECT_EQ(ip.prefix(), 16);
+    ip.prefix(std::array<uint8_t, 4>{255, 255, 255, 0});
+    EXPECT_EQ(ip.prefix(), 24);
+
+    ipv4_t other{"10.0.0.2", std::array<uint8_t, 4>{255, 0, 0, 0}};
+    EXPECT_EQ(other.prefix(), 8);
+}
+
 TEST(IPv4Tests, Validation) {
     auto valid_ipv4s = {"0.0.0.0", "192.168.1.1", "255.255.255.255"};
 
@@ -103,3 +116,130 @@ TEST(IPv4Tests, CIDR) {
         // TODO: check cidr(prefix) method
     }
 }
+
+TEST(IPv4Tests, ParseLikeTheScalarParser) {
+    // the SSSE3 builds parse with details::ipv4_scanner, the others with the scalar parser; both are
+    // checked against the same reference here
+    EXPECT_EQ(ipv4_t{"10.0.255.3/24"}.integer(), 0x0A'00'FF'03u);
+    EXPECT_EQ(ipv4_t{"10.0.255.3/24"}.prefix(), 24);
+    EXPECT_EQ(ipv4_t{"255.255.255.255"}.integer(), 0xFF'FF'FF'FFu);
+    for (std::string_view bad : {"10.0.256.3", "10.00.1.3", "1.2.3", "1.2.3.4.5", "1..2.3", "1.2.3.4/", "1.2.3.4/33",
+                                 "1.2.3.4/05", "1.2.3.4/2/", "1/2.3.4.5", "1.2.3.-4", "1234.1.1.1", "1.2.3.4 "})
+        EXPECT_FALSE(ipv4_t{bad}.is_valid()) << bad;
+
+    // what the scalar parser accepts, written plainly
+    auto const reference = [](std::string_view str, uint32_t& octets, int& prefix) {
+        if (str.size() < 7 || str.size() > 15)
+            return false;
+        auto const slash = std::min(str.find('/'), str.size());
+        auto const is_number = [](std::string_view part, int max) {
+            if (part.empty() || part.size() > 3 || (part.size() > 1 && part[0] == '0'))
+                return -1;
+            int value = 0;
+            for (auto c : part) {
+                if (c < '0' || c > '9')
+                    return -1;
+                value = value * 10 + (c - '0');
+            }
+            return value > max ? -1 : value;
+        };
+        auto quad = str.substr(0, slash);
+        octets    = 0;
+        for (int i = 0; i < 4; i++) {
+            auto const dot   = i == 3 ? quad.size() : quad.find('.');
+            auto const octet = is_number(quad.substr(0, dot), 255);
+            if (dot == std::string_view::npos || octet < 0)
+                return false;
+            octets = octets << 8u | static_cast<uint32_t>(octet);
+            quad.remove_prefix(std::min(dot + 1, quad.size()));
+        }
+        prefix = 255;
+        if (slash != str.size()) {
+            prefix = is_number(str.substr(slash + 1), 32);
+            if (prefix < 0)
+                return false;
+        }
+        return true;
+    };
+
+    std::mt19937           random{58};
+    std::string_view const alphabet = "0123456789....//9a5";
+    for (int i = 0; i < 50000; i++) {
+        std::string str;
+        if (random() % 2 == 0) {
+            // mostly valid ones
+            str = std::to_string(random() % 300) + "." + std::to_string(random() % 256) + "." +
+                  std::to_string(random() % 256) + "." + std::to_string(random() % 260);
+            if (random() % 3 == 0)
+                str += "/" + std::to_string(random() % 40);
+            if (random() % 4 == 0)
+                str[random() % str.size()] = alphabet[random() % alphabet.size()];
+        } else {
+            str.resize(random() % 18);
+            for (auto& c : str)
+                c = alphabet[random() % alphabet.size()];
+        }
+        uint32_t   octets = 0;
+        int        prefix = 0;
+        auto const valid  = reference(str, octets, prefix);
+        ipv4_t     ip{str};
+        ASSERT_EQ(ip.is_valid(), valid) << str;
+        if (valid) {
+            EXPECT_EQ(ip.integer(), octets) << str;
+            EXPECT_EQ(ip.prefix(), prefix) << str;
+        }
+    }
+}
+
+TEST(IPv4Tests, ParseAll) {
+    // assigning a string is parsing it, like the batches
+    ipv4_t assigned{"1.1.1.1"};
+    assigned = "300.1.1.1";
+    EXPECT_FALSE(assigned.is_valid());
+    assigned = "1.2.3.4/8";
+    EXPECT_TRUE(assigned.is_valid());
+    EXPECT_EQ(assigned.prefix(), 8);
+
+    std::mt19937           random{62};
+    std::string_view const alphabet = "0123456789....//9a5";
+    std::vector<std::string> strs;
+    for (int i = 0; i < 5000; i++) {
+        std::string str;
+        if (random() % 2 == 0) {
+            str = std::to_string(random() % 300) + "." + std::to_string(random() % 256) + "." +
+                  std::to_string(random() % 256) + "." + std::to_string(random() % 260);
+            if (random() % 3 == 0)
+                str += "/" + std::to_string(random() % 40);
+            if (random() % 4 == 0)
+                str[random() % str.size()] = alphabet[random() % alphabet.size()];
+        } else {
+            str.resize(random() % 18);
+            for (auto& c : str)
+                c = alphabet[random() % alphabet.size()];
+        }
+        strs.push_back(str);
+    }
+    strs.push_back(std::string{"1.2.3.4\0\0", 9});
+    strs.push_back(std::string{"1.2.3.4/2\0", 10});
+    strs.push_back(std::string{"1.2\0.3.4", 8});
+
+    // every size, so the last batch is cut everywhere
+    for (std::size_t size : {0ul, 1ul, 15ul, 16ul, 17ul, 63ul, 64ul, 65ul, strs.size()}) {
+        std::vector<std::string_view> const views(strs.begin(), strs.begin() + static_cast<long>(size));
+        std::vector<ipv4_t>                 ips(size, ipv4_t{"9.9.9.9/9"});
+        std::vector<uint64_t>               invalid((size + 63) / 64, ~uint64_t{0});
+        std::size_t                         expected_invalid = 0;
+        auto const                          count            = ipv4_t::parse_all(views, ips, invalid);
+        for (std::size_t i = 0; i < size; i++) {
+            ipv4_t const one{views[i]};
+            expected_invalid += !one.is_valid();
+            ASSERT_EQ(ips[i], one) << views[i];
+            ASSERT_EQ(ips[i].is_valid(), one.is_valid()) << views[i];
+            ASSERT_EQ(invalid[i / 64] >> (i % 64) & 1u, !one.is_valid()) << views[i];
+        }
+        if (size % 64 != 0) {
+            EXPECT_EQ(invalid.back() >> (size % 64), 0) << "the bits after the last one are zero";
+        }
+        EXPECT_EQ(count, expected_invalid);
+    }
+}
@@ -3,7 +3,15 @@
 #include "../core/include/webpp/traits/std_traits.hpp"
 #include "../core/include/webpp/validators/validators.hpp"
 
+#include <algorithm>
+#include <arpa/inet.h>
+#include <array>
 #include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
 
 using namespace webpp;
 
@@ -118,3 +126,138 @@ TEST(IPv6Tests, StrTests) {
     EXPECT_EQ(ipv6_t("::1").short_str(), "::1");
     EXPECT_EQ(ipv6_t("::f0:1").short_str(), "::f0:1");
 }
+
+TEST(IPv6Tests, Words) {
+    ipv6_t const ip{"2001:db8:85a3:1:2:8a2e:370:7334"};
+    EXPECT_EQ(ip.octets64(), (ipv6_t::octets64_t{0x2001'0db8'85a3'0001u, 0x0002'8a2e'0370'7334u}));
+    EXPECT_EQ(ip.octets32(), (ipv6_t::octets32_t{0x2001'0db8u, 0x85a3'0001u, 0x0002'8a2eu, 0x0370'7334u}));
+    EXPECT_EQ(ip.octets16(), (ipv6_t::octets16_t{0x2001, 0xdb8, 0x85a3, 1, 2, 0x8a2e, 0x370, 0x7334}));
+    EXPECT_EQ(ip.octets8()[0], 0x20);
+    EXPECT_EQ(ip.octets8()[15], 0x34);
+    EXPECT_EQ(ipv6_t{ip.octets8()}, ip);
+    EXPECT_EQ(ipv6_t{ip.octets16()}, ip);
+    EXPECT_EQ(ipv6_t{ip.octets32()}, ip);
+    EXPECT_EQ(ipv6_t{ip.octets64()}, ip);
+    EXPECT_EQ(ip.iid(), 0x0002'8a2e'0370'7334u);
+    EXPECT_EQ(ip.reversed().short_str(), "7334:370:8a2e:2:1:85a3:db8:2001");
+
+    EXPECT_TRUE(ipv6_t{"::"}.is_unspecified());
+    EXPECT_TRUE(ipv6_t{"::1"}.is_loopback());
+    EXPECT_TRUE(ipv6_t{"fe80::1"}.is_link_local());
+    EXPECT_TRUE(ipv6_t{"febf::1"}.is_link_local());
+    EXPECT_FALSE(ipv6_t{"fec0::1"}.is_link_local());
+    EXPECT_TRUE(ipv6_t{"fec0::1"}.is_site_local());
+    EXPECT_TRUE(ipv6_t{"ff0e::1"}.is_multicast_global());
+    EXPECT_TRUE(ipv6_t{"ff12::1"}.is_multicast_link_local());
+    EXPECT_FALSE(ipv6_t{"fe02::1"}.is_multicast_link_local());
+    EXPECT_EQ(ipv6_t{"ff05::1"}.scope(), 5);
+    EXPECT_TRUE(ipv6_t{"ff02::1"}.is_link_local_all_nodes_multicast());
+    EXPECT_TRUE(ipv6_t{"ff02::2"}.is_link_local_all_routers_multicast());
+    EXPECT_TRUE(ipv6_t{"ff03::fc"}.is_realm_local_all_mpl_forwarders());
+    EXPECT_TRUE(ipv6_t{"::ffff:1.2.3.4"}.is_v4_mapped());
+    EXPECT_FALSE(ipv6_t{"::fffe:1.2.3.4"}.is_v4_mapped());
+    EXPECT_TRUE(ipv6_t{"2001:db8::ff:fe00:1034"}.is_routing_locator());
+    EXPECT_FALSE(ipv6_t{"2001:db8::ff:fe00:fc10"}.is_routing_locator());
+    EXPECT_TRUE(ipv6_t{"2001:db8::ff:fe00:fc10"}.is_anycast_service_locator());
+    EXPECT_TRUE(ipv6_t{"2001:db8::"}.is_subnet_router_anycast());
+    EXPECT_TRUE(ipv6_t{"2001:db8::fdff:ffff:ffff:ff80"}.is_reserved_subnet_anycast());
+
+    // compared like 128bit numbers
+    EXPECT_LT(ipv6_t{"::ffff"}, ipv6_t{"::1:0"});
+    EXPECT_LT(ipv6_t{"ffff::"}.reversed(), ipv6_t{"1::"});
+    EXPECT_GT(ipv6_t{"1::"}, ipv6_t{"0:ffff:ffff:ffff:ffff:ffff:ffff:ffff"});
+    EXPECT_LE(ipv6_t{"1::"}, ipv6_t{"1::"});
+    EXPECT_NE(ipv6_t{"1::"}, ipv6_t{"1::/64"});
+
+    std::unordered_set<ipv6_t> ips{ipv6_t{"::1"}, ipv6_t{"::2"}, ipv6_t{"::1"}, ipv6_t{"::1/64"}};
+    EXPECT_EQ(ips.size(), 3);
+    EXPECT_TRUE(ips.contains(ipv6_t{"0::0.0.0.2"}));
+}
+
+TEST(IPv6Tests, CanonicalText) {
+    // the examples of RFC 5952
+    EXPECT_EQ(ipv6_t("2001:0db8::0001").short_str(), "2001:db8::1");
+    EXPECT_EQ(ipv6_t("2001:db8:0:0:0:0:2:1").short_str(), "2001:db8::2:1");
+    EXPECT_EQ(ipv6_t("2001:db8:0:1:1:1:1:1").short_str(), "2001:db8:0:1:1:1:1:1");
+    EXPECT_EQ(ipv6_t("2001:0:0:1:0:0:0:1").short_str(), "2001:0:0:1::1");
+    EXPECT_EQ(ipv6_t("2001:db8:0:0:1:0:0:1").short_str(), "2001:db8::1:0:0:1");
+    EXPECT_EQ(ipv6_t("2001:DB8::AB").short_str(), "2001:db8::ab");
+    EXPECT_EQ(ipv6_t("::ffff:192.0.2.1").short_str(), "::ffff:192.0.2.1");
+    EXPECT_EQ(ipv6_t("0:0:0:0:0:ffff:c000:0201").short_str(), "::ffff:192.0.2.1");
+    EXPECT_EQ(ipv6_t("1::").short_str(), "1::");
+    EXPECT_EQ(ipv6_t("1:0:0:0:0:0:0:0").short_str(), "1::");
+    EXPECT_EQ(ipv6_t("1:2:3:4:5:6:1.2.3.4").short_str(), "1:2:3:4:5:6:102:304");
+
+    std::array<char, ipv6_t::max_str_size> buffer{};
+    ipv6_t const longest{"ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff"};
+    EXPECT_EQ(std::string_view(buffer.data(), longest.to_chars(buffer.data())), longest.short_str());
+
+    EXPECT_FALSE(ipv6_t("1:2:3:4:5:6:7::8").is_valid()) << "the :: should be one group at least";
+    EXPECT_FALSE(ipv6_t("1:2:3:4:5:6:7:1.2.3.4").is_valid());
+    EXPECT_FALSE(ipv6_t("1:2:3:4:5:6:7:").is_valid());
+    EXPECT_FALSE(ipv6_t("::1/12a").is_valid());
+    EXPECT_EQ(ipv6_t("::1.2.3.4/96").prefix(), 96);
+}
+
+TEST(IPv6Tests, LikeInetPton) {
+    // checked against the libc, on the random strings and on the random ips
+    std::mt19937           random{59};
+    std::string_view const alphabet = "0f1a:::.B92";
+    for (int i = 0; i < 50000; i++) {
+        std::string str;
+        if (i % 2 == 0) {
+            str.resize(random() % 20);
+            for (auto& c : str)
+                c = alphabet[random() % alphabet.size()];
+        } else {
+            std::array<unsigned char, 16> bytes{};
+            for (auto& byte : bytes)
+                byte = random() % 3 == 0 ? static_cast<unsigned char>(random()) : 0;
+            if (i % 7 == 0) {
+                bytes = {};
+                bytes[10] = bytes[11] = 0xff; // ipv4-mapped
+                bytes[12]             = static_cast<unsigned char>(random());
+            }
+            std::array<char, INET6_ADDRSTRLEN> text{};
+            inet_ntop(AF_INET6, bytes.data(), text.data(), text.size());
+            str = text.data();
+        }
+
+        std::array<unsigned char, 16> expected{};
+        bool const valid = inet_pton(AF_INET6, str.c_str(), expected.data()) == 1;
+        ipv6_t const ip{str};
+        ASSERT_EQ(ip.is_valid(), valid) << str;
+        if (!valid)
+            continue;
+        auto const octets = ip.octets();
+        EXPECT_TRUE(std::equal(octets.begin(), octets.end(), expected.begin())) << str;
+
+        // the libc writes the ipv4-compatible ones (deprecated) with the ipv4 too
+        auto const  groups = ip.octets16();
+        bool const compatible = std::all_of(groups.begin(), groups.begin() + 6, [](auto g) {
+            return g == 0;
+        }) && groups[6] != 0;
+        if (compatible)
+            continue;
+        std::array<char, INET6_ADDRSTRLEN> text{};
+        inet_ntop(AF_INET6, expected.data(), text.data(), text.size());
+        EXPECT_EQ(ip.short_str(), text.data()) << str;
+    }
+}
+
+TEST(IPv6Tests, ParseAll) {
+    std::vector<std::string_view> const strs{"::1", "fe80::1/64", "not an ip", "1:2:3:4:5:6:7:8", "1::2::3",
+                                             "::ffff:1.2.3.4", "::/129"};
+    std::vector<ipv6_t>                 ips(strs.size(), ipv6_t{"ff::/8"});
+    std::vector<uint64_t>               invalid(1);
+    EXPECT_EQ(ipv6_t::parse_all(strs, ips, invalid), 3);
+    EXPECT_EQ(invalid[0], 0b1010100u);
+    for (std::size_t i = 0; i < strs.size(); i++)
+        EXPECT_EQ(ips[i], ipv6_t{strs[i]}) << strs[i];
+
+    ipv6_t assigned{"::1"};
+    assigned = "1::2::3";
+    EXPECT_FALSE(assigned.is_valid());
+    assigned = "1::/16";
+    EXPECT_EQ(assigned.prefix(), 16);
+}
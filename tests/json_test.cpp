@@ -0,0 +1,301 @@
+#include "../core/include/webpp/http/bodies/json.hpp"
+#include "../core/include/webpp/http/response.hpp"
+#include "../core/include/webpp/traits/std_traits.hpp"
+#include "../core/include/webpp/utils/json.hpp"
+
+#include <gtest/gtest.h>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace webpp;
+
+namespace {
+    struct user {
+        int                        id;
+        std::string                name;
+        std::vector<std::string>   tags;
+        std::optional<double>      score;
+
+        template <typename WriterType>
+        void to_json(WriterType& out) const {
+            out.begin_object()
+              .member("id", id)
+              .member("name", name)
+              .member("tags", tags)
+              .member("score", score)
+              .end_object();
+        }
+    };
+
+    struct point {
+        int x, y;
+    };
+
+    // found by ADL
+    template <typename WriterType>
+    void to_json(WriterType& out, point const& p) {
+        out.begin_array().value(p.x).value(p.y).end_array();
+    }
+
+    std::string to_json_string(auto const& value) {
+        std::string out;
+        json::serialize(out, value);
+        return out;
+    }
+} // namespace
+
+TEST(JSON, Escaping) {
+    EXPECT_EQ(to_json_string("plain"), "\"plain\"");
+    EXPECT_EQ(to_json_string("a\"b\\c\nd\te\x01"), R"("a\"b\\c\nd\te\u0001")");
+
+    // long enough for the vectorized scanner, with the escapes in and after the blocks
+    std::string long_str(100, 'x');
+    long_str[5]  = '"';
+    long_str[40] = '\n';
+    long_str[99] = '\x1f';
+    std::string expected = "\"" + long_str.substr(0, 5) + "\\\"" + long_str.substr(6, 34) + "\\n" +
+                           long_str.substr(41, 58) + "\\u001f\"";
+    EXPECT_EQ(to_json_string(long_str), expected);
+
+    // UTF-8 is not escaped
+    EXPECT_EQ(to_json_string("caf\xc3\xa9"), "\"caf\xc3\xa9\"");
+    static_assert(json::escape_scanner::find("abc\"", 0) == 3);
+}
+
+TEST(JSON, Writer) {
+    EXPECT_EQ(to_json_string(42), "42");
+    EXPECT_EQ(to_json_string(-1.5), "-1.5");
+    EXPECT_EQ(to_json_string(true), "true");
+    EXPECT_EQ(to_json_string(nullptr), "null");
+    EXPECT_EQ(to_json_string(std::numeric_limits<double>::infinity()), "null");
+    EXPECT_EQ(to_json_string(std::vector<int>{}), "[]");
+    EXPECT_EQ(to_json_string(std::vector<std::vector<int>>{{1, 2}, {}, {3}}), "[[1,2],[],[3]]");
+    EXPECT_EQ(to_json_string(std::map<std::string, int>{{"a", 1}, {"b", 2}}), R"({"a":1,"b":2})");
+    EXPECT_EQ(to_json_string(point{1, 2}), "[1,2]");
+
+    user const someone{7, "Jo \"J\"", {"admin", "dev"}, std::nullopt};
+    EXPECT_EQ(to_json_string(someone), R"({"id":7,"name":"Jo \"J\"","tags":["admin","dev"],"score":null})");
+    EXPECT_EQ(to_json_string(std::vector<user>{someone, {8, "", {}, 0.5}}),
+              R"([{"id":7,"name":"Jo \"J\"","tags":["admin","dev"],"score":null},)"
+              R"({"id":8,"name":"","tags":[],"score":0.5}])");
+}
+
+TEST(JSON, Reader) {
+    json::reader in{R"( {"id": 12, "name": "a\"b\u00e9\ud83d\ude00", "list": [true, null, -1.5e3, {}], "x": []} )"};
+    EXPECT_EQ(in.next(), json::token::begin_object);
+    EXPECT_EQ(in.next(), json::token::key);
+    EXPECT_EQ(in.raw(), "id");
+    EXPECT_EQ(in.next(), json::token::number);
+    int id = 0;
+    EXPECT_TRUE(in.number_value(id));
+    EXPECT_EQ(id, 12);
+
+    EXPECT_EQ(in.next(), json::token::key);
+    EXPECT_EQ(in.next(), json::token::string);
+    EXPECT_TRUE(in.escaped());
+    std::string name;
+    EXPECT_TRUE(in.string_value(name));
+    EXPECT_EQ(name, "a\"b\xc3\xa9\xf0\x9f\x98\x80");
+
+    EXPECT_EQ(in.next(), json::token::key);
+    EXPECT_EQ(in.next(), json::token::begin_array);
+    EXPECT_EQ(in.next(), json::token::boolean);
+    EXPECT_TRUE(in.bool_value());
+    EXPECT_EQ(in.next(), json::token::null);
+    EXPECT_EQ(in.next(), json::token::number);
+    double number = 0;
+    EXPECT_TRUE(in.number_value(number));
+    EXPECT_EQ(number, -1500.0);
+    EXPECT_FALSE(in.number_value(id)) << "it's not an integer";
+    EXPECT_EQ(in.next(), json::token::begin_object);
+    EXPECT_EQ(in.next(), json::token::end_object);
+    EXPECT_EQ(in.next(), json::token::end_array);
+
+    // skip the value of a member
+    EXPECT_EQ(in.next(), json::token::key);
+    EXPECT_TRUE(in.skip());
+    EXPECT_EQ(in.next(), json::token::end_object);
+    EXPECT_EQ(in.next(), json::token::end);
+
+    // the errors
+    for (std::string_view bad : {"{", "[1,]", "{\"a\" 1}", "[1 2]", "01", "\"a\nb\"", "[1]]", "tru", "{1:2}"}) {
+        json::reader err{bad};
+        json::token  tok = json::token::end;
+        for (int i = 0; i < 10 && tok != json::token::error; i++)
+            tok = err.next();
+        EXPECT_EQ(tok, json::token::error) << bad;
+    }
+}
+
+TEST(JSON, RoundTrip) {
+    std::string const text = "tab\there, \"quoted\", back\\slash, \x02 and \xe2\x82\xac";
+    auto const        json_text = to_json_string(std::vector<std::string>{text});
+
+    json::reader in{json_text};
+    EXPECT_EQ(in.next(), json::token::begin_array);
+    EXPECT_EQ(in.next(), json::token::string);
+    std::string value;
+    EXPECT_TRUE(in.string_value(value));
+    EXPECT_EQ(value, text);
+    EXPECT_EQ(in.next(), json::token::end_array);
+    EXPECT_EQ(in.next(), json::token::end);
+}
+
+TEST(JSON, StructuralIndex) {
+    // the vectorized index against a byte at a time one, on the strings and
+    // the runs of backslashes that go over the blocks
+    std::mt19937               random{42};
+    std::string_view const     alphabet = "\"\\\\\\{}[]:,a ";
+    std::vector<std::uint32_t> found;
+    for (int round = 0; round < 2000; round++) {
+        std::string text(random() % 300, ' ');
+        for (auto& c : text)
+            c = alphabet[random() % alphabet.size()];
+
+        std::vector<std::uint32_t> expected;
+        bool                       in_string = false;
+        bool                       escaped   = false;
+        for (std::size_t i = 0; i < text.size(); i++) {
+            auto const c = text[i];
+            // a backslash escapes the next one, in a string or not (it's not valid outside of them anyway)
+            bool const was_escaped = escaped;
+            escaped                = !was_escaped && c == '\\';
+            if (c == '"' && !was_escaped) {
+                in_string = !in_string;
+                expected.push_back(static_cast<std::uint32_t>(i));
+            } else if (!in_string && std::string_view{"{}[]:,"}.find(c) != std::string_view::npos) {
+                expected.push_back(static_cast<std::uint32_t>(i));
+            }
+        }
+
+        found.resize(text.size());
+        auto const count = json::details::find_structurals(text, found.data());
+        if (in_string) {
+            EXPECT_EQ(count, std::string_view::npos) << text;
+            continue;
+        }
+        ASSERT_EQ(count, expected.size()) << text;
+        found.resize(count);
+        EXPECT_EQ(found, expected) << text;
+    }
+}
+
+TEST(JSON, Document) {
+    std::string text = R"( {"id": 12, "name": "a\"b", "skip": {"deep": [1, {"name": "no"}, "]}"]},
+                          "list": [true, null, -1.5e3, {}, [], "x"], "empty": {}, "user": {"name": "me"}} )";
+    json::document doc;
+    ASSERT_TRUE(doc.parse(text));
+
+    int id = 0;
+    EXPECT_EQ(doc["id"].kind(), json::kind::number);
+    EXPECT_TRUE(doc["id"].number_value(id));
+    EXPECT_EQ(id, 12);
+    EXPECT_EQ(doc["id"].raw(), "12");
+
+    auto const name = doc["name"];
+    EXPECT_EQ(name.raw(), R"(a\"b)");
+    EXPECT_TRUE(name.escaped());
+    std::string name_value;
+    EXPECT_TRUE(name.string_value(name_value));
+    EXPECT_EQ(name_value, "a\"b");
+
+    // the views are into the text
+    auto const user_name = doc["user"]["name"].raw();
+    EXPECT_EQ(user_name, "me");
+    EXPECT_GE(user_name.data(), text.data());
+    EXPECT_LT(user_name.data(), text.data() + text.size());
+
+    auto const list = doc["list"];
+    EXPECT_EQ(list.kind(), json::kind::array);
+    bool flag = false;
+    EXPECT_TRUE(list[0].bool_value(flag));
+    EXPECT_TRUE(flag);
+    EXPECT_TRUE(list[1].is_null());
+    double number = 0;
+    EXPECT_TRUE(list[2].number_value(number));
+    EXPECT_EQ(number, -1500.0);
+    EXPECT_EQ(list[3].kind(), json::kind::object);
+    EXPECT_EQ(list[4].raw(), "[]");
+    EXPECT_EQ(list[5].raw(), "x");
+    EXPECT_FALSE(list[6]);
+    EXPECT_EQ(doc["skip"]["deep"][1]["name"].raw(), "no");
+    EXPECT_EQ(doc["skip"]["deep"][2].raw(), "]}");
+
+    // the missing ones, and the chains through them
+    EXPECT_FALSE(doc["nothing"]);
+    EXPECT_FALSE(doc["nothing"]["more"][3]);
+    EXPECT_FALSE(doc["empty"]["a"]);
+    EXPECT_FALSE(doc["id"]["a"]);
+    EXPECT_FALSE(doc["name"].number_value(id));
+
+    std::vector<std::string> keys;
+    EXPECT_TRUE(doc.root().for_each_member([&](std::string_view key, json::element) {
+        keys.emplace_back(key);
+        return true;
+    }));
+    EXPECT_EQ(keys, (std::vector<std::string>{"id", "name", "skip", "list", "empty", "user"}));
+    std::size_t items = 0;
+    EXPECT_TRUE(list.for_each([&](json::element) {
+        items++;
+        return true;
+    }));
+    EXPECT_EQ(items, 6);
+    EXPECT_TRUE(doc["empty"].for_each_member([](auto, auto) {
+        return false;
+    }));
+    EXPECT_TRUE(list[4].for_each([](auto) {
+        return false;
+    }));
+
+    // the scalars at the root, and the errors that are found by the index
+    ASSERT_TRUE(doc.parse(" 42 "));
+    EXPECT_TRUE(doc.root().number_value(id));
+    EXPECT_EQ(id, 42);
+    ASSERT_TRUE(doc.parse(R"("text")"));
+    EXPECT_EQ(doc.root().raw(), "text");
+    for (std::string_view bad : {"", "{", "[1]]", "{\"a\": 1", "[\"a]", "{\"a\": [}", "[1] 2"}) {
+        EXPECT_FALSE(doc.parse(bad)) << bad;
+        EXPECT_FALSE(doc.root()) << bad;
+    }
+    // a broken value is noticed when it's read
+    ASSERT_TRUE(doc.parse(R"({"a": tru, "b": 1, "c": })"));
+    EXPECT_FALSE(doc["a"].bool_value(flag));
+    EXPECT_FALSE(doc["c"]);
+    EXPECT_TRUE(doc["b"].number_value(id));
+
+    // a big one, to go over the blocks
+    std::string big = R"({"items": [)";
+    for (int i = 0; i < 1000; i++)
+        big += R"({"id": )" + std::to_string(i) + R"(, "text": "some \"quoted\" text \\"},)";
+    big += R"({}], "total": 1000})";
+    ASSERT_TRUE(doc.parse(big));
+    EXPECT_TRUE(doc["total"].number_value(id));
+    EXPECT_EQ(id, 1000);
+    EXPECT_TRUE(doc["items"][999]["id"].number_value(id));
+    EXPECT_EQ(id, 999);
+    EXPECT_EQ(doc["items"][500]["text"].raw(), R"(some \"quoted\" text \\)");
+
+    // only UTF-8
+    EXPECT_TRUE(doc.parse("{\"name\": \"caf\xc3\xa9\"}"));
+    EXPECT_FALSE(doc.parse("{\"name\": \"caf\xe9\"}"));
+    EXPECT_FALSE(doc.parse("{\"name\": \"\xed\xa0\x80\"}")) << "a surrogate";
+}
+
+TEST(JSON, Body) {
+    using json_response_type =
+      basic_response<std_traits, empty_extension_pack, response_headers<std_traits>, json_body::type<std_traits>>;
+
+    auto res = make_json_response<json_response_type>(std::map<std::string, int>{{"count", 3}});
+    EXPECT_EQ(res.body.str(), R"({"count":3})");
+    EXPECT_TRUE(res.header.contains(well_known_header::content_type));
+    res.calculate_default_headers();
+    EXPECT_NE(res.header.str().find("Content-Type: application/json\r\n"), std::string::npos);
+    EXPECT_NE(res.header.str().find("Content-Length: 11\r\n"), std::string::npos);
+
+    res.body.clear();
+    res.body.writer().begin_object().member("ok", true).end_object();
+    EXPECT_EQ(res.body.str(), R"({"ok":true})");
+}
@@ -0,0 +1,74 @@
+#include "../core/include/webpp/utils/latency_histogram.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <gtest/gtest.h>
+
+using namespace webpp;
+using namespace std::chrono_literals;
+
+TEST(LatencyHistogram, Empty) {
+    latency_histogram const hist;
+    EXPECT_EQ(hist.count(), 0);
+    EXPECT_EQ(hist.min(), 0);
+    EXPECT_EQ(hist.max(), 0);
+    EXPECT_EQ(hist.value_at(99), 0);
+    EXPECT_EQ(hist.mean(), 0);
+}
+
+TEST(LatencyHistogram, Percentiles) {
+    latency_histogram hist;
+    for (std::uint64_t value = 1; value <= 10'000; value++)
+        hist.record(value * 1'000);
+    EXPECT_EQ(hist.count(), 10'000);
+    EXPECT_EQ(hist.min(), 1'000);
+    EXPECT_EQ(hist.max(), 10'000'000);
+    EXPECT_NEAR(hist.mean(), 5'000'500, 1);
+
+    // within 1/64 of the real ones
+    for (double const percentile : {50.0, 90.0, 99.0, 99.9}) {
+        auto const expected = percentile * 100'000;
+        EXPECT_NEAR(static_cast<double>(hist.value_at(percentile)), expected, expected / 64) << percentile;
+    }
+    EXPECT_EQ(hist.value_at(100), 10'000'000);
+    EXPECT_NEAR(static_cast<double>(hist.value_at(0)), 1'000, 1'000 / 64.0);
+}
+
+TEST(LatencyHistogram, SmallValuesAreExact) {
+    latency_histogram hist;
+    for (std::uint64_t value = 0; value < 128; value++)
+        hist.record(value);
+    EXPECT_EQ(hist.value_at(50), 63);
+    EXPECT_EQ(hist.value_at(100), 127);
+}
+
+TEST(LatencyHistogram, HugeValues) {
+    latency_histogram hist;
+    hist.record(UINT64_MAX);
+    hist.record(std::uint64_t{1} << 63U);
+    EXPECT_EQ(hist.count(), 2);
+    EXPECT_EQ(hist.max(), UINT64_MAX);
+    EXPECT_EQ(hist.value_at(100), UINT64_MAX);
+    EXPECT_GE(hist.value_at(50), std::uint64_t{1} << 63U);
+}
+
+TEST(LatencyHistogram, DurationsAndMerge) {
+    latency_histogram first;
+    latency_histogram second;
+    first.record(2ms);
+    first.record(-1ms); // a clock that went back
+    second.record(std::chrono::duration<double>{0.5});
+    first.merge(second);
+    EXPECT_EQ(first.count(), 3);
+    EXPECT_EQ(first.min(), 0);
+    EXPECT_EQ(first.max(), 500'000'000);
+
+    latency_histogram coarse{3};
+    coarse.merge(first);
+    EXPECT_EQ(coarse.count(), 3);
+    EXPECT_NEAR(static_cast<double>(coarse.value_at(100)), 500'000'000, 500'000'000 / 8.0);
+
+    first.reset();
+    EXPECT_EQ(first.count(), 0);
+    EXPECT_EQ(first.value_at(50), 0);
+}
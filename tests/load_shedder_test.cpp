@@ -0,0 +1,52 @@
+#include "../core/include/webpp/utils/load_shedder.hpp"
+
+#include <chrono>
+#include <gtest/gtest.h>
+
+using namespace webpp;
+using namespace std::chrono_literals;
+
+TEST(LoadShedder, BurstIsNotOverload) {
+    load_shedder shedder{{.target = 5ms, .interval = 100ms}};
+    auto         now = load_shedder::clock_t::now();
+
+    // a burst: the queue grows, but it drains within the interval
+    for (auto const sojourn : {1ms, 20ms, 40ms, 60ms, 2ms}) {
+        EXPECT_TRUE(shedder.admit(sojourn, now));
+        now += 10ms;
+    }
+    now += 100ms;
+    EXPECT_TRUE(shedder.admit(30ms, now));
+    EXPECT_FALSE(shedder.is_overloaded()) << "it went below the target in the last interval";
+    EXPECT_FALSE(shedder.admit(150ms, now)) << "nothing waits for more than an interval";
+    EXPECT_EQ(shedder.shed_count(), 1);
+}
+
+TEST(LoadShedder, StandingQueue) {
+    load_shedder shedder{{.target = 5ms, .interval = 100ms}};
+    auto         now = load_shedder::clock_t::now();
+
+    // the queue never drains for a whole interval
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(shedder.admit(30ms, now));
+        now += 10ms;
+    }
+    EXPECT_FALSE(shedder.admit(30ms, now));
+    EXPECT_TRUE(shedder.is_overloaded());
+    EXPECT_TRUE(shedder.admit(3ms, now)) << "the ones that haven't waited are still served";
+
+    // the queue has drained once, so the next interval is fine again
+    now += 100ms;
+    EXPECT_TRUE(shedder.admit(30ms, now));
+    EXPECT_FALSE(shedder.is_overloaded());
+}
+
+TEST(LoadShedder, IdleIntervals) {
+    load_shedder shedder{{.target = 5ms, .interval = 100ms}};
+    auto const   now = load_shedder::clock_t::now();
+    EXPECT_TRUE(shedder.admit(50ms, now));
+    EXPECT_TRUE(shedder.admit(50ms, now + 10s)) << "a quiet time isn't an overload";
+    EXPECT_FALSE(shedder.is_overloaded());
+    EXPECT_FALSE(shedder.admit(50ms, now + 10s + 100ms)) << "but one sample in an interval is enough";
+    EXPECT_TRUE(shedder.is_overloaded());
+}
@@ -0,0 +1,144 @@
+#include "../core/include/webpp/utils/logger.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace webpp;
+
+namespace {
+
+    std::string read_all(std::FILE* file) {
+        std::fflush(file);
+        std::rewind(file);
+        std::string res;
+        char        buf[4096];
+        for (std::size_t n; (n = std::fread(buf, 1, sizeof(buf), file)) != 0;)
+            res.append(buf, n);
+        return res;
+    }
+
+    std::vector<std::string> lines_of(std::string const& str) {
+        std::vector<std::string> res;
+        for (std::size_t pos = 0; pos < str.size();) {
+            auto const end = str.find('\n', pos);
+            res.push_back(str.substr(pos, end - pos));
+            pos = end == std::string::npos ? str.size() : end + 1;
+        }
+        return res;
+    }
+
+    // the line without its timestamp
+    std::string message_of(std::string const& line) {
+        return line.substr(line.find(' ') + 1);
+    }
+
+} // namespace
+
+TEST(Logger, Text) {
+    auto* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    log_info("not started");
+    logger::global().start(file);
+    EXPECT_TRUE(logger::global().is_running());
+
+    std::string const name = "world";
+    log_info("hello {} {} {} {:.1f}", name, "and", 42, 1.25);
+    log_warning("no arguments");
+    log_error("{:>4}|{}", 7, std::string_view{"x"});
+    log_trace("it's not compiled in");
+    log_info("{} {}", 1); // a bad format
+    logger::global().stop();
+    EXPECT_FALSE(logger::global().is_running());
+    log_info("stopped");
+
+    auto const lines = lines_of(read_all(file));
+    ASSERT_EQ(lines.size(), 4);
+    EXPECT_EQ(message_of(lines[0]), "info hello world and 42 1.2");
+    EXPECT_EQ(message_of(lines[1]), "warning no arguments");
+    EXPECT_EQ(message_of(lines[2]), "error    7|x");
+    EXPECT_EQ(message_of(lines[3]), "info (bad log format) {} {}");
+
+    // 2026-01-02T03:04:05.123456Z
+    auto const time = lines[0].substr(0, lines[0].find(' '));
+    ASSERT_EQ(time.size(), 27);
+    EXPECT_EQ(time[10], 'T');
+    EXPECT_EQ(time.back(), 'Z');
+    std::fclose(file);
+}
+
+TEST(Logger, Json) {
+    auto* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    logger::global().start(file, log_format::json);
+    log_error("a \"quoted\" {}", "line\nbreak");
+    logger::global().stop();
+
+    auto const lines = lines_of(read_all(file));
+    ASSERT_EQ(lines.size(), 1);
+    EXPECT_EQ(lines[0].substr(0, 9), R"({"time":")");
+    EXPECT_NE(lines[0].find(R"("level":"error","msg":"a \"quoted\" line\u000abreak"})"), std::string::npos)
+      << lines[0];
+    std::fclose(file);
+}
+
+TEST(Logger, LongStrings) {
+    auto* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    logger::global().start(file);
+    std::string const long_one(1000, 'a');
+    log_info("{}|{}|{}", long_one, 5, long_one);
+    logger::global().stop();
+
+    auto const lines = lines_of(read_all(file));
+    ASSERT_EQ(lines.size(), 1);
+    auto const message = message_of(lines[0]);
+    EXPECT_LT(message.size(), log_record::size);
+    EXPECT_NE(message.find("a|5|"), std::string::npos) << "the strings are cut short, not the rest";
+    std::fclose(file);
+}
+
+TEST(Logger, Threads) {
+    auto* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    logger::global().start(file, log_format::text, std::chrono::milliseconds{1});
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([i] {
+            for (int j = 0; j < 500; j++)
+                log_info("thread {} log {}", i, j);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    logger::global().stop();
+
+    auto const lines = lines_of(read_all(file));
+    EXPECT_EQ(lines.size(), 2'000);
+    for (auto const& line : lines)
+        EXPECT_EQ(message_of(line).substr(0, 12), "info thread ");
+    std::fclose(file);
+}
+
+TEST(Logger, Dropped) {
+    auto* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    // the flusher doesn't wake up, so the ring gets full
+    logger::global().start(file, log_format::text, std::chrono::hours{1});
+    for (std::size_t i = 0; i < log_ring::capacity + 10; i++)
+        log_info("log {}", i);
+    logger::global().flush();
+    log_info("after");
+    logger::global().stop();
+
+    auto const lines = lines_of(read_all(file));
+    ASSERT_EQ(lines.size(), log_ring::capacity + 2);
+    EXPECT_EQ(message_of(lines[log_ring::capacity]),
+              "warning 10 log records were dropped; the ring was full");
+    EXPECT_EQ(message_of(lines.back()), "info after");
+    std::fclose(file);
+}
@@ -0,0 +1,131 @@
+#include "../core/include/webpp/utils/metrics.hpp"
+
+#include "../core/include/webpp/http/interfaces/common/connection.hpp"
+
+#include <array>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace webpp;
+
+TEST(Metrics, Counters) {
+    metrics_registry registry;
+    auto const       hits  = registry.counter("hits_total", "The hits");
+    auto const       open  = registry.gauge("open", "The open ones");
+    auto const       again = registry.counter("hits_total", "The hits");
+
+    hits.inc();
+    again.inc(2);
+    open.inc();
+    open.inc();
+    open.dec();
+    EXPECT_EQ(hits.value(), 3) << "the same name and labels are the same series";
+    EXPECT_EQ(open.value(), 1);
+
+    metric_counter const unregistered;
+    unregistered.inc();
+    EXPECT_EQ(unregistered.value(), 0);
+
+    EXPECT_THROW(static_cast<void>(registry.gauge("hits_total", "")), std::invalid_argument);
+    metrics_registry small{2};
+    static_cast<void>(small.counter("a", ""));
+    static_cast<void>(small.counter("b", ""));
+    EXPECT_THROW(static_cast<void>(small.counter("c", "")), std::length_error);
+}
+
+TEST(Metrics, Threads) {
+    metrics_registry registry;
+    auto const       requests = registry.counter("requests_total", "The requests");
+    auto const       open     = registry.gauge("open", "The open ones");
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < 10'000; j++)
+                requests.inc();
+            open.inc();
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    // the threads that are gone are still counted, and the one that decrements isn't the same
+    open.dec();
+    EXPECT_EQ(requests.value(), 40'000);
+    EXPECT_EQ(open.value(), 3);
+}
+
+TEST(Metrics, Text) {
+    metrics_registry registry;
+    auto const       ok       = registry.counter("requests_total", "The requests", {{"code", "2xx"}});
+    auto const       notfound = registry.counter("requests_total", "The requests", {{"code", "4xx"}});
+    auto const       latency  = registry.histogram("latency_seconds", "", {}, std::array{0.1, 1.0});
+    auto const       sizes    = registry.histogram("size", "", {{"path", "/a\"b"}}, std::array{10.0});
+    auto const       open     = registry.gauge("open", "The open ones");
+
+    ok.inc(5);
+    notfound.inc();
+    latency.observe(0.05);
+    latency.observe(std::chrono::milliseconds{500});
+    latency.observe(2.0);
+    sizes.observe(3);
+    open.dec();
+    EXPECT_EQ(latency.count(), 3);
+    EXPECT_DOUBLE_EQ(latency.sum(), 2.55);
+
+    EXPECT_EQ(registry.text(),
+              "# HELP requests_total The requests\n"
+              "# TYPE requests_total counter\n"
+              "requests_total{code=\"2xx\"} 5\n"
+              "requests_total{code=\"4xx\"} 1\n"
+              "# TYPE latency_seconds histogram\n"
+              "latency_seconds_bucket{le=\"0.1\"} 1\n"
+              "latency_seconds_bucket{le=\"1\"} 2\n"
+              "latency_seconds_bucket{le=\"+Inf\"} 3\n"
+              "latency_seconds_sum 2.55\n"
+              "latency_seconds_count 3\n"
+              "# TYPE size histogram\n"
+              "size_bucket{path=\"/a\\\"b\",le=\"10\"} 1\n"
+              "size_bucket{path=\"/a\\\"b\",le=\"+Inf\"} 1\n"
+              "size_sum{path=\"/a\\\"b\"} 3\n"
+              "size_count{path=\"/a\\\"b\"} 1\n"
+              "# HELP open The open ones\n"
+              "# TYPE open gauge\n"
+              "open -1\n");
+}
+
+TEST(Metrics, ConnectionBytes) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    metrics_registry                 registry;
+    common::connection_metrics const counters{registry.counter("received", ""), registry.counter("sent", "")};
+
+    boost::asio::io_context io;
+    tcp::acceptor           acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    tcp::socket             client{io};
+    client.connect(acceptor.local_endpoint());
+    common::connection conn{acceptor.accept()};
+    conn.metrics(counters);
+    conn.start([] {},
+               [](common::connection& c, std::string_view data) {
+                   c.send(std::string{data} + std::string{data});
+                   c.close_after_write();
+               });
+
+    boost::asio::write(client, boost::asio::buffer(std::string_view{"hello"}));
+    io.run_for(50ms);
+
+    std::string               received;
+    boost::system::error_code ec;
+    boost::asio::read(client, boost::asio::dynamic_buffer(received), ec);
+    EXPECT_EQ(received, "hellohello");
+    EXPECT_EQ(counters.received.value(), 5);
+    EXPECT_EQ(counters.sent.value(), 10);
+}
@@ -0,0 +1,51 @@
+#include "../core/include/webpp/utils/perfect_hash.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+
+using namespace webpp;
+
+TEST(PerfectHash, FixedStringHash) {
+    static_assert(fixed_string{"text/html"}.hash() == fixed_string_hash(std::string_view{"text/html"}));
+    static_assert(fixed_string{"a"}.hash() != fixed_string{"b"}.hash());
+    EXPECT_EQ(fixed_string{"GET"}.hash(), fixed_string_hash(std::string_view{std::string{"GET"}}));
+}
+
+TEST(PerfectHash, IndexOf) {
+    using methods = perfect_hash<"GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH">;
+    static_assert(methods::size() == 9);
+    static_assert(methods::index_of("GET") == 0);
+    static_assert(methods::index_of("PATCH") == 8);
+    static_assert(methods::key(2) == "POST");
+
+    std::string const post{"POST"};
+    EXPECT_EQ(methods::index_of(post), 2);
+    EXPECT_EQ(methods::index_of("post"), methods::npos);
+    EXPECT_EQ(methods::index_of("POS"), methods::npos);
+    EXPECT_EQ(methods::index_of(""), methods::npos);
+    EXPECT_FALSE(methods::contains("GETS"));
+
+    using names = iperfect_hash<"Content-Type", "Content-Length", "Host">;
+    EXPECT_EQ(names::index_of("content-length"), 1);
+    EXPECT_EQ(names::index_of("HOST"), 2);
+    EXPECT_EQ(names::index_of("Hosts"), names::npos);
+
+    using none = perfect_hash<>;
+    EXPECT_EQ(none::index_of("anything"), none::npos);
+}
+
+TEST(PerfectHash, FixedStringMap) {
+    constexpr ifixed_string_map<std::string_view, "png", "jpg", "html"> types{"image/png", "image/jpeg", "text/html"};
+    static_assert(*types.find("JPG") == "image/jpeg");
+    static_assert(types.find("gif") == nullptr);
+
+    EXPECT_EQ(types.value_or("HTML", "none"), "text/html");
+    EXPECT_EQ(types.value_or("htm", "none"), "none");
+
+    fixed_string_map<int, "one", "two", "three"> numbers{1, 2, 3};
+    *numbers.find("two") = 22;
+    EXPECT_EQ(numbers.value_or("two", 0), 22);
+    EXPECT_TRUE(numbers.contains("three"));
+    EXPECT_FALSE(numbers.contains("Three"));
+}
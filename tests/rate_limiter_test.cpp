@@ -0,0 +1,107 @@
+#include "../core/include/webpp/utils/rate_limiter.hpp"
+
+#include "../core/include/webpp/traits/std_traits.hpp"
+#include "../core/include/webpp/utils/ipv4.hpp"
+#include "../core/include/webpp/utils/ipv6.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace webpp;
+using namespace std::chrono_literals;
+
+namespace {
+    struct manual_clock {
+        using duration   = std::chrono::nanoseconds;
+        using rep        = duration::rep;
+        using period     = duration::period;
+        using time_point = std::chrono::time_point<manual_clock>;
+
+        static constexpr bool is_steady = true;
+
+        static time_point& current() noexcept {
+            static time_point value{};
+            return value;
+        }
+
+        static time_point now() noexcept {
+            return current();
+        }
+    };
+} // namespace
+
+TEST(RateLimiter, Burst) {
+    rate_limiter<manual_clock> limiter{{.rate = 10, .burst = 3}};
+    EXPECT_TRUE(limiter.allow("a"));
+    EXPECT_TRUE(limiter.allow("a"));
+    EXPECT_TRUE(limiter.allow("a"));
+    auto const rejected = limiter.acquire("a");
+    EXPECT_FALSE(rejected);
+    EXPECT_EQ(rejected.retry_after, 100ms);
+    EXPECT_TRUE(limiter.allow("b")) << "each key has its own bucket";
+
+    // a token comes back every 1/rate
+    manual_clock::current() += 100ms;
+    EXPECT_TRUE(limiter.allow("a"));
+    EXPECT_FALSE(limiter.allow("a"));
+
+    // it doesn't fill up more than the burst
+    manual_clock::current() += 10s;
+    for (int i = 0; i < 3; i++)
+        EXPECT_TRUE(limiter.allow("a"));
+    EXPECT_FALSE(limiter.allow("a"));
+
+    // the expensive requests cost more
+    manual_clock::current() += 10s;
+    EXPECT_TRUE(limiter.acquire("a", 2));
+    EXPECT_FALSE(limiter.acquire("a", 2));
+    EXPECT_TRUE(limiter.acquire("a", 1));
+}
+
+TEST(RateLimiter, Keys) {
+    using ipv4_t = ipv4<std_traits>;
+    using ipv6_t = ipv6<std_traits>;
+
+    rate_limiter<manual_clock> limiter{{.rate = 1, .burst = 1}};
+    EXPECT_TRUE(limiter.allow(ipv4_t{"10.0.0.1"}));
+    EXPECT_FALSE(limiter.allow(ipv4_t{"10.0.0.1"}));
+    EXPECT_TRUE(limiter.allow(ipv4_t{"10.0.0.2"}));
+    EXPECT_TRUE(limiter.allow(ipv6_t{"2001:db8::1"}));
+    EXPECT_FALSE(limiter.allow(ipv6_t{"2001:db8::1"}));
+    EXPECT_TRUE(limiter.allow(42));
+    EXPECT_FALSE(limiter.allow(42));
+    EXPECT_TRUE(limiter.allow(std::string{"session"}));
+    EXPECT_FALSE(limiter.allow(std::string_view{"session"}));
+}
+
+TEST(RateLimiter, FixedTable) {
+    rate_limiter<manual_clock> limiter{{.rate = 1, .burst = 1}, 64};
+    EXPECT_EQ(limiter.capacity(), 64);
+
+    // a lot more keys than it keeps; the new ones push the ones that are the least behind out
+    manual_clock::current() += 1h;
+    for (int i = 0; i < 10'000; i++)
+        EXPECT_TRUE(limiter.allow(i));
+    EXPECT_FALSE(limiter.allow(9'999)) << "the last ones are still there";
+}
+
+TEST(RateLimiter, Concurrent) {
+    // the threads share the bucket of a key without a lock
+    rate_limiter<manual_clock> limiter{{.rate = 0.001, .burst = 100}};
+    std::atomic<int>           allowed{0};
+    std::vector<std::thread>   threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 1'000; i++)
+                if (limiter.allow("hot"))
+                    allowed++;
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    EXPECT_EQ(allowed, 100);
+}
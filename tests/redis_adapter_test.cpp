@@ -0,0 +1,276 @@
+#include "../core/include/webpp/http/modules/session/server-adapter/redis_adapter.hpp"
+
+#include <atomic>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <chrono>
+#include <future>
+#include <gtest/gtest.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace webpp;
+using namespace std::chrono_literals;
+using tcp = boost::asio::ip::tcp;
+
+namespace {
+
+    /**
+     * A server that speaks enough of RESP for GET, SET, and DEL; it counts the commands, and the
+     * most of them that came in one read (the pipelined ones).
+     */
+    struct fake_redis {
+        boost::asio::io_context            io;
+        tcp::acceptor                      acceptor{io, {boost::asio::ip::make_address("127.0.0.1"), 0}};
+        std::map<std::string, std::string> data;
+        std::atomic<int>                   gets{0};
+        std::atomic<int>                   commands{0};
+        std::atomic<int>                   max_batch{0};
+        std::atomic<bool>                  hang_up{false}; // close the connections instead of replying
+        std::thread                        runner;
+
+        struct session : std::enable_shared_from_this<session> {
+            fake_redis&            server;
+            tcp::socket            socket;
+            std::string            inbox;
+            std::array<char, 4096> chunk{};
+            std::string            outbox;
+
+            session(fake_redis& srv, tcp::socket sock) : server{srv}, socket{std::move(sock)} {}
+
+            void read() {
+                socket.async_read_some(boost::asio::buffer(chunk),
+                                       [self = shared_from_this()](auto ec, std::size_t size) {
+                                           if (ec)
+                                               return;
+                                           self->inbox.append(self->chunk.data(), size);
+                                           self->handle();
+                                       });
+            }
+
+            // parse the arrays of bulk strings
+            bool next_command(std::vector<std::string>& args) {
+                std::size_t pos = 0;
+                auto const  line = [&]() -> std::string {
+                    auto const end = inbox.find("\r\n", pos);
+                    if (end == std::string::npos)
+                        return {};
+                    auto res = inbox.substr(pos, end - pos);
+                    pos      = end + 2;
+                    return res;
+                };
+                auto const count = line();
+                if (count.empty())
+                    return false;
+                args.clear();
+                for (int i = 0; i < std::stoi(count.substr(1)); i++) {
+                    auto const size = line();
+                    if (size.empty() || inbox.size() < pos + std::stoul(size.substr(1)) + 2)
+                        return false;
+                    args.push_back(inbox.substr(pos, std::stoul(size.substr(1))));
+                    pos += args.back().size() + 2;
+                }
+                inbox.erase(0, pos);
+                return true;
+            }
+
+            void handle() {
+                if (server.hang_up) {
+                    socket.close();
+                    return;
+                }
+                std::vector<std::string> args;
+                int                      batch = 0;
+                while (next_command(args)) {
+                    batch++;
+                    server.commands++;
+                    if (args[0] == "GET") {
+                        server.gets++;
+                        auto const it = server.data.find(args[1]);
+                        outbox += it == server.data.end()
+                                    ? std::string{"$-1\r\n"}
+                                    : "$" + std::to_string(it->second.size()) + "\r\n" + it->second + "\r\n";
+                    } else if (args[0] == "SET") {
+                        server.data[args[1]] = args[2];
+                        outbox += "+OK\r\n";
+                    } else if (args[0] == "DEL") {
+                        outbox += ":" + std::to_string(server.data.erase(args[1])) + "\r\n";
+                    } else {
+                        outbox += "-ERR unknown command\r\n";
+                    }
+                }
+                if (batch > server.max_batch)
+                    server.max_batch = batch;
+                auto reply = std::make_shared<std::string>(std::move(outbox));
+                outbox.clear();
+                boost::asio::async_write(socket, boost::asio::buffer(*reply),
+                                         [self = shared_from_this(), reply](auto ec, std::size_t) {
+                                             if (!ec)
+                                                 self->read();
+                                         });
+            }
+        };
+
+        fake_redis() {
+            accept();
+            runner = std::thread{[this] {
+                io.run();
+            }};
+        }
+
+        ~fake_redis() {
+            io.stop();
+            runner.join();
+        }
+
+        void accept() {
+            acceptor.async_accept([this](auto ec, tcp::socket socket) {
+                if (ec)
+                    return;
+                std::make_shared<session>(*this, std::move(socket))->read();
+                accept();
+            });
+        }
+
+        tcp::endpoint endpoint() const {
+            return acceptor.local_endpoint();
+        }
+    };
+
+    // the io_context of the adapter, on its own thread
+    struct client_io {
+        boost::asio::io_context                                                  io;
+        boost::asio::executor_work_guard<boost::asio::io_context::executor_type> guard{io.get_executor()};
+        std::thread                                                              runner{[this] {
+            io.run();
+        }};
+
+        ~client_io() {
+            guard.reset();
+            runner.join();
+        }
+    };
+} // namespace
+
+TEST(RedisAdapter, RESP) {
+    std::string command;
+    details::append_resp_command(command, {"SET", "k", "a value"});
+    EXPECT_EQ(command, "*3\r\n$3\r\nSET\r\n$1\r\nk\r\n$7\r\na value\r\n");
+
+    details::resp_reply reply;
+    EXPECT_EQ(details::parse_resp_reply("+OK\r\n", reply), 5);
+    EXPECT_EQ(reply.kind, details::resp_reply::type::simple);
+    EXPECT_EQ(reply.value, "OK");
+    EXPECT_EQ(details::parse_resp_reply("$5\r\nhello\r\n+OK", reply), 11);
+    EXPECT_EQ(reply.kind, details::resp_reply::type::bulk);
+    EXPECT_EQ(reply.value, "hello");
+    EXPECT_EQ(details::parse_resp_reply("$-1\r\n", reply), 5);
+    EXPECT_EQ(reply.kind, details::resp_reply::type::nil);
+    EXPECT_EQ(details::parse_resp_reply(":42\r\n", reply), 5);
+    EXPECT_EQ(reply.integer, 42);
+    EXPECT_EQ(details::parse_resp_reply("-ERR no\r\n", reply), 9);
+    EXPECT_EQ(reply.kind, details::resp_reply::type::error);
+
+    EXPECT_EQ(details::parse_resp_reply("$5\r\nhel", reply), 0) << "it's not all there";
+    EXPECT_EQ(details::parse_resp_reply("+OK", reply), 0);
+    EXPECT_EQ(details::parse_resp_reply("", reply), 0);
+    EXPECT_EQ(details::parse_resp_reply("$5\r\nhello!!", reply), std::string_view::npos);
+    EXPECT_EQ(details::parse_resp_reply(":4x\r\n", reply), std::string_view::npos);
+    EXPECT_EQ(details::parse_resp_reply("*1\r\n", reply), std::string_view::npos);
+}
+
+TEST(RedisAdapter, Sessions) {
+    fake_redis server;
+    client_io  client;
+    {
+        redis_adapter sessions{client.io, server.endpoint(), {.key_prefix = "s:", .near_cache_ttl = 0s}};
+        EXPECT_FALSE(sessions.get("nope"));
+
+        std::promise<bool> stored;
+        sessions.async_set("a", "alpha", 1min, [&](bool ok) {
+            stored.set_value(ok);
+        });
+        EXPECT_TRUE(stored.get_future().get());
+        EXPECT_EQ(sessions.get("a"), "alpha");
+
+        std::promise<bool> erased;
+        sessions.async_erase("a", [&](bool ok) {
+            erased.set_value(ok);
+        });
+        EXPECT_TRUE(erased.get_future().get());
+        EXPECT_FALSE(sessions.get("a"));
+    }
+    boost::asio::post(server.io, [&] {
+        EXPECT_EQ(server.data.count("s:a"), 0);
+    });
+}
+
+TEST(RedisAdapter, Pipelining) {
+    fake_redis server;
+    client_io  client;
+    redis_adapter sessions{client.io, server.endpoint(), {.near_cache_ttl = 0s}};
+
+    for (int i = 0; i < 200; i++)
+        sessions.set("id" + std::to_string(i), "value " + std::to_string(i));
+    std::vector<std::future<std::optional<std::string>>> values;
+    for (int i = 0; i < 200; i++) {
+        auto promise = std::make_shared<std::promise<std::optional<std::string>>>();
+        values.push_back(promise->get_future());
+        sessions.async_get("id" + std::to_string(i), [promise](auto value) {
+            promise->set_value(std::move(value));
+        });
+    }
+    for (int i = 0; i < 200; i++)
+        EXPECT_EQ(values[i].get(), "value " + std::to_string(i));
+    EXPECT_EQ(server.gets, 200);
+    EXPECT_GT(server.max_batch, 1) << "the commands are written together";
+}
+
+TEST(RedisAdapter, NearCache) {
+    fake_redis server;
+    client_io  client;
+    redis_adapter sessions{client.io, server.endpoint(), {.near_cache_ttl = 50ms}};
+
+    std::promise<bool> stored;
+    sessions.async_set("a", "alpha", 1min, [&](bool ok) {
+        stored.set_value(ok);
+    });
+    ASSERT_TRUE(stored.get_future().get());
+    EXPECT_EQ(sessions.get("a"), "alpha");
+    EXPECT_EQ(server.gets, 0);
+
+    std::this_thread::sleep_for(80ms);
+    EXPECT_EQ(sessions.get("a"), "alpha");
+    EXPECT_EQ(server.gets, 1) << "it's expired in the near-cache";
+    EXPECT_EQ(sessions.get("a"), "alpha");
+    EXPECT_EQ(server.gets, 1);
+}
+
+TEST(RedisAdapter, LostConnection) {
+    fake_redis server;
+    client_io  client;
+    redis_adapter sessions{client.io, server.endpoint(), {.near_cache_ttl = 0s}};
+    sessions.set("a", "alpha");
+    EXPECT_EQ(sessions.get("a"), "alpha");
+
+    server.hang_up = true;
+    EXPECT_FALSE(sessions.get("a")) << "the handlers get nothing when the connection is lost";
+    server.hang_up = false;
+    EXPECT_EQ(sessions.get("a"), "alpha") << "it's connected again";
+}
+
+TEST(RedisAdapter, NoServer) {
+    tcp::endpoint endpoint;
+    {
+        boost::asio::io_context io;
+        tcp::acceptor           closed{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+        endpoint = closed.local_endpoint();
+    }
+    client_io     client;
+    redis_adapter sessions{client.io, endpoint};
+    EXPECT_FALSE(sessions.get("a"));
+}
@@ -0,0 +1,244 @@
+#include "../core/include/webpp/http/request_body.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace webpp;
+
+namespace {
+    struct fake_request : request_body_parsers<fake_request> {
+        std::string_view content_type;
+        std::string_view content;
+        std::string_view cookie_header;
+        mutable int      reads = 0;
+
+        [[nodiscard]] std::string_view header(std::string_view name) const noexcept {
+            if (name == "Cookie")
+                return cookie_header;
+            return name == "Content-Type" ? content_type : std::string_view{};
+        }
+
+        [[nodiscard]] std::string_view body() const noexcept {
+            reads++;
+            return content;
+        }
+    };
+} // namespace
+
+TEST(RequestBody, Form) {
+    fake_request req;
+    req.content_type = "application/x-www-form-urlencoded; charset=utf-8";
+    req.content      = "name=John+Doe&city=K%C3%B6ln&empty=&flag&=nameless&name=second";
+
+    auto const& fields = req.form();
+    ASSERT_EQ(fields.size(), 5);
+    EXPECT_EQ(fields[0].name, "name");
+    EXPECT_EQ(fields[0].value, "John+Doe");
+    EXPECT_EQ(fields[3].name, "flag");
+    EXPECT_EQ(fields[3].value, "");
+    EXPECT_EQ(req.form_value("name"), "John+Doe");
+    EXPECT_EQ(req.form_value("missing"), "");
+
+    std::string city;
+    EXPECT_TRUE(fields[1].decoded_value(city));
+    EXPECT_EQ(city, "K\xc3\xb6ln");
+    std::string broken;
+    EXPECT_FALSE(decode_form_component("100%", broken));
+    EXPECT_FALSE(decode_form_component("%zz", broken));
+
+    // the views are into the body, and it's parsed only once
+    EXPECT_EQ(fields[0].value.data(), req.content.data() + 5);
+    static_cast<void>(req.form());
+    EXPECT_EQ(req.reads, 1);
+
+    fake_request other;
+    other.content_type = "text/plain";
+    other.content      = "a=1";
+    EXPECT_TRUE(other.form().empty());
+}
+
+TEST(RequestBody, Multipart) {
+    std::string const body = "preamble\r\n"
+                             "--XyZ\r\n"
+                             "Content-Disposition: form-data; name=\"title\"\r\n"
+                             "\r\n"
+                             "a title\r\n"
+                             "--XyZ\r\n"
+                             "content-disposition: form-data; name=\"file\"; filename=\"a;b.txt\"\r\n"
+                             "Content-Type: text/plain\r\n"
+                             "\r\n"
+                             "line one\r\n--XyZnot the end\r\n"
+                             "--XyZ\r\n"
+                             "Content-Disposition: form-data; name=\"empty\"\r\n"
+                             "\r\n"
+                             "\r\n"
+                             "--XyZ--\r\n"
+                             "epilogue";
+    fake_request req;
+    req.content_type = "multipart/form-data; boundary=\"XyZ\"";
+    req.content      = body;
+
+    auto const& parts = req.multipart();
+    EXPECT_TRUE(req.is_multipart_complete());
+    ASSERT_EQ(parts.size(), 3);
+    EXPECT_EQ(parts[0].name, "title");
+    EXPECT_EQ(parts[0].data, "a title");
+    EXPECT_EQ(parts[0].filename, "");
+    EXPECT_EQ(parts[1].name, "file");
+    EXPECT_EQ(parts[1].filename, "a;b.txt");
+    EXPECT_EQ(parts[1].content_type, "text/plain");
+    EXPECT_EQ(parts[1].data, "line one\r\n--XyZnot the end");
+    EXPECT_EQ(parts[2].data, "");
+    ASSERT_NE(req.part("file"), nullptr);
+    EXPECT_EQ(req.part("file")->filename, "a;b.txt");
+    EXPECT_EQ(req.part("nothing"), nullptr);
+    EXPECT_EQ(req.reads, 1);
+
+    // cut before the last boundary
+    std::vector<multipart_part> cut;
+    EXPECT_FALSE(parse_multipart(std::string_view{body}.substr(0, body.size() - 30), "XyZ", cut));
+    EXPECT_EQ(cut.size(), 2);
+    std::vector<multipart_part> none;
+    EXPECT_FALSE(parse_multipart(body, "", none));
+}
+
+TEST(RequestBody, JSON) {
+    fake_request req;
+    req.content_type = "application/json";
+    req.content      = R"({"user": {"name": "someone", "id": 7}})";
+
+    auto const& doc = req.json();
+    ASSERT_TRUE(doc.is_valid());
+    EXPECT_EQ(doc["user"]["name"].raw(), "someone");
+    int id = 0;
+    EXPECT_TRUE(req.json()["user"]["id"].number_value(id));
+    EXPECT_EQ(id, 7);
+    EXPECT_EQ(req.reads, 1);
+
+    // the copies parse again, they don't share the index
+    auto const copy = req;
+    EXPECT_EQ(copy.json()["user"]["name"].raw(), "someone");
+
+    fake_request broken;
+    broken.content = "{\"a\": ";
+    EXPECT_FALSE(broken.json().is_valid());
+    EXPECT_FALSE(broken.json()["a"]);
+}
+
+namespace {
+    struct collected_part {
+        std::string name;
+        std::string filename;
+        std::string data;
+        bool        ended = false;
+    };
+
+    struct collector {
+        std::vector<collected_part> parts;
+        std::size_t                 data_calls = 0;
+
+        void on_part(multipart_part const& part) {
+            parts.push_back({std::string{part.name}, std::string{part.filename}, {}, false});
+        }
+
+        void on_data(std::string_view data) {
+            data_calls++;
+            parts.back().data += data;
+        }
+
+        void on_part_end() {
+            parts.back().ended = true;
+        }
+    };
+} // namespace
+
+TEST(RequestBody, MultipartStream) {
+    std::string big(100'000, 'x');
+    for (std::size_t i = 0; i < big.size(); i += 97)
+        big[i] = '\r'; // the almost-boundaries
+    std::string const body = "--XyZ\r\n"
+                             "Content-Disposition: form-data; name=\"title\"\r\n"
+                             "\r\n"
+                             "a title\r\n"
+                             "--XyZ  \r\n"
+                             "Content-Disposition: form-data; name=\"upload\"; filename=\"big.bin\"\r\n"
+                             "Content-Type: application/octet-stream\r\n"
+                             "\r\n" +
+                             big + "\r\n--XyZnot the end\r\n--Xy\r\n" +
+                             "\r\n"
+                             "--XyZ\r\n"
+                             "\r\n"
+                             "\r\n"
+                             "--XyZ--";
+    auto const expected = big + "\r\n--XyZnot the end\r\n--Xy\r\n";
+
+    // cut into chunks of every size, so the boundaries fall everywhere
+    for (std::size_t chunk_size : {1ul, 2ul, 3ul, 5ul, 7ul, 64ul, 1000ul, 4096ul, body.size()}) {
+        multipart_parser parser{"XyZ"};
+        collector        handler;
+        for (std::size_t pos = 0; pos < body.size(); pos += chunk_size)
+            ASSERT_TRUE(parser.feed(std::string_view{body}.substr(pos, chunk_size), handler)) << chunk_size;
+        EXPECT_TRUE(parser.is_done()) << chunk_size;
+        ASSERT_EQ(handler.parts.size(), 3) << chunk_size;
+        EXPECT_EQ(handler.parts[0].name, "title");
+        EXPECT_EQ(handler.parts[0].data, "a title");
+        EXPECT_EQ(handler.parts[1].filename, "big.bin");
+        EXPECT_EQ(handler.parts[1].data.size(), expected.size()) << chunk_size;
+        EXPECT_TRUE(handler.parts[1].data == expected) << chunk_size;
+        EXPECT_EQ(handler.parts[2].name, "");
+        EXPECT_EQ(handler.parts[2].data, "");
+        for (auto const& part : handler.parts)
+            EXPECT_TRUE(part.ended);
+        if (chunk_size == body.size()) {
+            EXPECT_EQ(handler.data_calls, 2) << "the data is given out of the chunk, in one go";
+        }
+    }
+
+    // cut, broken, and a boundary that's too long
+    multipart_parser cut{"XyZ"};
+    collector        handler;
+    EXPECT_TRUE(cut.feed(std::string_view{body}.substr(0, 200), handler));
+    EXPECT_FALSE(cut.is_done());
+    multipart_parser broken{"XyZ"};
+    EXPECT_FALSE(broken.feed("--XyZ garbage\r\n", handler));
+    multipart_parser too_long{std::string(71, 'a')};
+    EXPECT_FALSE(too_long.feed("anything", handler));
+
+    // from the request
+    fake_request req;
+    req.content_type = "multipart/form-data; boundary=XyZ";
+    req.content      = body;
+    collector from_request;
+    EXPECT_TRUE(req.read_multipart(from_request));
+    EXPECT_EQ(from_request.parts.size(), 3);
+}
+
+TEST(RequestBody, Cookies) {
+    fake_request req;
+    EXPECT_TRUE(req.cookies().empty());
+    EXPECT_EQ(req.cookie("session"), "");
+
+    req.cookie_header = "_ga=GA1.2.3; session=abc%20def; theme=\"dark\"";
+    auto const cookies = req.cookies();
+    ASSERT_EQ(cookies.size(), 3);
+    EXPECT_EQ(cookies.value("theme"), "dark");
+    EXPECT_EQ(req.cookie("session"), "abc%20def");
+    EXPECT_EQ(req.cookie("session").data(), req.cookie_header.data() + 21) << "it's a view into the header";
+    std::string session;
+    EXPECT_TRUE(cookies.find("session").decoded_value(session));
+    EXPECT_EQ(session, "abc def");
+    EXPECT_EQ(req.reads, 0) << "the body is not read for the cookies";
+}
+
+TEST(RequestBody, DecodedHeader) {
+    fake_request req;
+    req.content_type  = "text/plain";
+    req.cookie_header = "=?utf-8?B?Y2Fmw6k=?=";
+
+    std::string buffer;
+    EXPECT_EQ(req.decoded_header("Content-Type", buffer), "text/plain");
+    EXPECT_TRUE(buffer.empty()) << "it's only decoded if it needs to be";
+    EXPECT_EQ(req.decoded_header("Cookie", buffer), "café");
+}
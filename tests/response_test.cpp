@@ -3,10 +3,14 @@
 #include "../core/include/webpp/http/response.hpp"
 
 #include "../core/include/webpp/http/body.hpp"
+#include "../core/include/webpp/http/bodies/stream.hpp"
+#include "../core/include/webpp/http/bodies/string.hpp"
 
+#include <algorithm>
 #include <cstdio>
 #include <fstream>
 #include <gtest/gtest.h>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <type_traits>
@@ -15,6 +19,20 @@ using namespace webpp;
 
 using res_t  = basic_response<std_traits>;
 using body_t = response_body<std_traits>;
+using string_body_response_t =
+  basic_response<std_traits, empty_extension_pack, response_headers<std_traits>, string_body::type<std_traits>>;
+
+static_assert(cgi_status_line(200) == "Status: 200 OK\r\n");
+static_assert(http11_status_line(404) == "HTTP/1.1 404 Not Found\r\n");
+
+TEST(Response, StatusLines) {
+    EXPECT_EQ(cgi_status_line(100), "Status: 100 Continue\r\n");
+    EXPECT_EQ(cgi_status_line(599), "Status: 599 \r\n");
+    EXPECT_EQ(http11_status_line(511), "HTTP/1.1 511 Network Authentication Required\r\n");
+    EXPECT_EQ(http11_status_line(299), "HTTP/1.1 299 \r\n");
+    EXPECT_TRUE(cgi_status_line(99).empty());
+    EXPECT_TRUE(http11_status_line(600).empty());
+}
 
 // TEST(Body, Text) {
 //    body_t b = "Testing";
@@ -88,3 +106,243 @@ using body_t = response_body<std_traits>;
 //    EXPECT_EQ(res_t::res_t(file).body.str(), "Hello World");
 //    std::filesystem::remove(file);
 //}
+
+TEST(Response, Recycle) {
+    using string_res_t = basic_response<std_traits, empty_extension_pack, response_headers<std_traits>,
+                                        string_body::type<std_traits>>;
+    static_assert(RecyclableResponse<string_res_t>);
+
+    // the other tests may have left some responses in the pool of this thread
+    auto& pool = recycle_pool<string_res_t>::local();
+    while (pool.size() > 0)
+        (void) pool.acquire();
+
+    auto res = pool.acquire();
+    res.assign(404u, "a body that is too long for the small string optimization");
+    res.calculate_default_headers();
+    res.header.emplace("X-Header", "a value that is too long for the small string optimization");
+    auto const* const body_data = res.body.str().data();
+
+    recycle_response(stl::move(res));
+    EXPECT_EQ(pool.size(), 1);
+
+    auto again = pool.acquire();
+    EXPECT_EQ(pool.size(), 0);
+    EXPECT_EQ(again.header.status_code, 200);
+    EXPECT_TRUE(again.header.empty());
+    EXPECT_TRUE(again.body.str().empty());
+
+    again.assign(200u, "hello");
+    again.calculate_default_headers();
+    EXPECT_EQ(again.body.str(), "hello");
+    EXPECT_EQ(again.body.str().data(), body_data) << "The capacity of the body should be reused";
+    EXPECT_EQ(again.header.size(), 2);
+    EXPECT_TRUE(again.header.contains("Content-Length"));
+    EXPECT_NE(again.header.str().find("Content-Length: 5\r\n"), std::string::npos);
+}
+
+TEST(Response, HashedHeadersLookup) {
+    response_headers<std_traits> headers;
+    headers.emplace("Set-Cookie", "a=1");
+    headers.emplace("Content-Type", "text/plain");
+    headers.emplace("set-cookie", "b=2");
+    for (int i = 0; i < 40; i++)
+        headers.emplace("X-Field-" + std::to_string(i), std::to_string(i));
+
+    EXPECT_TRUE(headers.contains("SET-COOKIE"));
+    EXPECT_TRUE(headers.contains("x-field-39"));
+    EXPECT_FALSE(headers.contains("X-Field-40"));
+    EXPECT_FALSE(headers.contains("Set-Cookie2"));
+    ASSERT_NE(headers.find("content-type"), headers.end());
+    EXPECT_EQ(headers.find("content-type")->value, "text/plain");
+    EXPECT_EQ(headers.count("Set-Cookie"), 2) << "the fields with the same name are kept";
+
+    response_headers<std_traits> reordered;
+    for (int i = 39; i >= 0; i--)
+        reordered.emplace("x-field-" + std::to_string(i), std::to_string(i));
+    reordered.emplace("SET-COOKIE", "b=2");
+    reordered.emplace("Content-Type", "text/plain");
+    reordered.emplace("Set-Cookie", "a=1");
+    EXPECT_TRUE(std::is_permutation(headers.begin(), headers.end(), reordered.begin(), reordered.end()));
+}
+
+TEST(Response, FlatHeaders) {
+    using flat_res_t = typename extension_pack<flat_headers, string_response>::template extensie_type<
+      std_traits, basic_response_descriptor>;
+    static_assert(flat_res_t::headers_type::inline_capacity == 16);
+
+    flat_res_t res{201u, "hello"};
+    res.header.emplace("X-First", "1");
+    res.calculate_default_headers();
+    EXPECT_EQ(res.header.status_code, 201);
+    EXPECT_EQ(res.header.size(), 3);
+    EXPECT_TRUE(res.header.contains("content-type"));
+    EXPECT_FALSE(res.header.contains("Content"));
+    EXPECT_EQ(res.header.str(), "X-First: 1\r\n"
+                                "Content-Type: text/html; charset=utf-8\r\n"
+                                "Content-Length: 5\r\n")
+      << "The fields should be serialized in the order that they're added";
+
+    // more fields than there's room for inside of the headers
+    for (int i = 0; i < 20; i++)
+        res.header.emplace("X-Field-" + std::to_string(i), std::to_string(i));
+    EXPECT_EQ(res.header.size(), 23);
+    EXPECT_EQ(res.header.find("x-field-19")->value, "19");
+    EXPECT_EQ(res.header.begin()->name, "X-First");
+
+    auto copy = res;
+    EXPECT_EQ(copy.header, res.header);
+    auto moved = std::move(copy);
+    EXPECT_EQ(moved.header, res.header);
+    EXPECT_TRUE(copy.header.empty());
+
+    moved.header.clear();
+    EXPECT_TRUE(moved.header.empty());
+    moved.header.emplace("Content-Length", "0");
+    EXPECT_EQ(moved.header.str(), "Content-Length: 0\r\n");
+}
+
+TEST(Response, HeaderSanitizer) {
+    static_assert(header_sanitizer::find("Content-Type") == std::string_view::npos);
+    static_assert(header_sanitizer::find("a\r\nb") == 1);
+
+    // long enough for the vectorized loop, with the unsafe byte in the tail and in the middle
+    std::string const safe(100, 'a');
+    EXPECT_EQ(header_sanitizer::find(safe), std::string_view::npos);
+    for (auto pos : {0ul, 15ul, 16ul, 31ul, 32ul, 70ul, 99ul}) {
+        for (char c : {'\r', '\n', '\0'}) {
+            auto str = safe;
+            str[pos] = c;
+            EXPECT_EQ(header_sanitizer::find(str), pos);
+        }
+    }
+
+    response_headers<std_traits> headers;
+    headers.emplace("X-Injected", "value\r\nSet-Cookie: session=stolen");
+    EXPECT_EQ(headers.str(), "X-Injected: value  Set-Cookie: session=stolen\r\n");
+
+    using flat_res_t = typename extension_pack<flat_headers, string_response>::template extensie_type<
+      std_traits, basic_response_descriptor>;
+    flat_res_t res;
+    res.header.emplace(std::string{"X-\nName"}, std::string{"a\0b", 3});
+    EXPECT_EQ(res.header.str(), "X- Name: a b\r\n");
+}
+
+TEST(Response, WellKnownHeaders) {
+    static_assert(to_well_known_header(std::string_view{"content-TYPE"}) == well_known_header::content_type);
+    static_assert(to_well_known_header(std::string_view{"Content-Typo"}) == well_known_header::unknown);
+    static_assert(well_known_header_name(well_known_header::www_authenticate) == "WWW-Authenticate");
+    static_assert(well_known_header_prefix(well_known_header::etag) == "ETag: ");
+    static_assert(well_known_header_name(well_known_header::unknown).empty());
+
+    response_headers<std_traits> headers;
+    EXPECT_FALSE(headers.contains(well_known_header::content_length));
+    headers.emplace("content-length", "12");
+    headers.emplace("X-Custom", "value");
+    EXPECT_TRUE(headers.contains(well_known_header::content_length));
+    EXPECT_FALSE(headers.contains(well_known_header::content_type));
+
+    // the well-known names are written in their canonical form
+    EXPECT_NE(headers.str().find("Content-Length: 12\r\n"), std::string::npos);
+    EXPECT_NE(headers.str().find("X-Custom: value\r\n"), std::string::npos);
+
+    headers.clear();
+    EXPECT_FALSE(headers.contains(well_known_header::content_length));
+
+    string_body_response_t res{200u, "hello"};
+    res.header.emplace("Content-Type", "text/plain");
+    res.calculate_default_headers();
+    EXPECT_EQ(res.header.size(), 2);
+    EXPECT_TRUE(res.header.contains(well_known_header::content_length));
+    EXPECT_NE(res.header.str().find("Content-Type: text/plain\r\n"), std::string::npos);
+
+    res.calculate_date_header();
+    EXPECT_EQ(res.header.size(), 3);
+    EXPECT_TRUE(res.header.contains(well_known_header::date));
+    EXPECT_NE(res.header.str().find(" GMT\r\n"), std::string::npos);
+    res.calculate_date_header();
+    EXPECT_EQ(res.header.size(), 3) << "the Date header is added once";
+}
+
+TEST(Response, StreamBody) {
+    using stream_res_t =
+      basic_response<std_traits, empty_extension_pack, response_headers<std_traits>, stream_body::type<std_traits>>;
+
+    stream_res_t res{200u};
+    res.body = stream_body::type<std_traits>{[calls = 0](std::string& chunk) mutable {
+        chunk.append("part ").append(std::to_string(calls));
+        return ++calls != 3;
+    }};
+    EXPECT_TRUE(res.body.is_stream());
+    res.calculate_default_headers();
+    EXPECT_FALSE(res.header.contains(well_known_header::content_length)) << "its length is not known";
+
+    // the copies share the producer
+    auto const  copy = res;
+    std::string chunk;
+    EXPECT_TRUE(copy.body.next(chunk));
+    EXPECT_EQ(chunk, "part 0");
+    EXPECT_EQ(res.body.str(), "part 1part 2");
+    EXPECT_FALSE(res.body.is_stream());
+    EXPECT_FALSE(copy.body.is_stream());
+    EXPECT_EQ(res.body.str(), "part 1part 2");
+}
+
+TEST(Response, SharedBody) {
+    // one cached payload for all of the responses
+    auto const payload = std::make_shared<std::string const>("<html>the cached page</html>");
+
+    string_body_response_t shared{200u, payload};
+    auto const             copy = shared;
+    EXPECT_EQ(copy.body.view().data(), payload->data()) << "the copies should not copy the payload";
+    EXPECT_EQ(copy.body.shared_owner(), payload);
+
+    // a part of a buffer that someone else owns
+    string_body_response_t borrowed{200u};
+    borrowed.body = string_body::type<std_traits>{std::string_view{*payload}.substr(6, 15), payload};
+    EXPECT_EQ(borrowed.body.view().data(), payload->data() + 6);
+    EXPECT_EQ(borrowed.body.size(), 15);
+    borrowed.calculate_default_headers();
+    EXPECT_NE(borrowed.header.str().find("Content-Length: 15\r\n"), std::string::npos);
+    EXPECT_EQ(borrowed.body.str(), "the cached page");
+    EXPECT_EQ(payload.use_count(), 4);
+
+    borrowed.body.clear();
+    EXPECT_EQ(borrowed.body.shared_owner(), nullptr);
+    EXPECT_EQ(payload.use_count(), 3);
+
+    string_body_response_t owned{200u, "hello"};
+    EXPECT_EQ(owned.body.shared_owner(), nullptr);
+}
+
+TEST(Response, BodySelection) {
+    // one body type is the type itself
+    static_assert(std::is_same_v<select_response_body<std_traits, string_body>, string_body::type<std_traits>>);
+
+    using either_body = select_response_body<std_traits, string_body, stream_body>;
+    static_assert(
+      std::is_same_v<either_body, variant_body<string_body::type<std_traits>, stream_body::type<std_traits>>>);
+    using either_res_t = basic_response<std_traits, empty_extension_pack, response_headers<std_traits>, either_body>;
+
+    either_res_t res{200u, "hello"};
+    EXPECT_TRUE(res.body.holds<string_body::type<std_traits>>());
+    EXPECT_EQ(res.body.str(), "hello");
+    EXPECT_EQ(res.body.size(), 5);
+
+    res.body = stream_body::type<std_traits>{[](std::string& chunk) {
+        chunk = "streamed";
+        return false;
+    }};
+    EXPECT_TRUE(res.body.holds<stream_body::type<std_traits>>());
+    EXPECT_EQ(res.body.str(), "streamed");
+
+    // a string goes to the first one that can be assigned a string
+    res = std::string{"again"};
+    EXPECT_TRUE(res.body.holds<string_body::type<std_traits>>());
+    EXPECT_EQ(res.body.str(), "again");
+
+    string_body_response_t single{200u, "one"};
+    std::string const      str = "two";
+    single                     = str;
+    EXPECT_EQ(single.body.str(), "two");
+}
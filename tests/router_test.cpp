@@ -1,16 +1,948 @@
 #include "../core/include/webpp/http/routes/router.hpp"
 
+#include "../core/include/webpp/http/routes/dynamic_router.hpp"
+#include "../core/include/webpp/http/routes/extensions/memoize.hpp"
+#include "../core/include/webpp/http/routes/extensions/metrics.hpp"
+#include "../core/include/webpp/http/routes/extensions/rate_limit.hpp"
+#include "../core/include/webpp/http/routes/extensions/response_cache.hpp"
+#include "../core/include/webpp/http/routes/tpath.hpp"
+
 #include "../core/include/webpp/http/application_concepts.hpp"
 #include "../core/include/webpp/http/interfaces/cgi.hpp"
+#include "../core/include/webpp/http/interfaces/fcgi.hpp"
 #include "../core/include/webpp/utils/const_list.hpp"
+#include "../core/include/webpp/utils/task.hpp"
 
 #include <gtest/gtest.h>
+#include <optional>
+#include <string>
 #include <tuple>
 #include <vector>
 
 using namespace webpp;
 using namespace std;
 
+namespace {
+    struct router_app {};
+
+    using router_request = basic_request<std_traits, fcgi<std_traits, router_app>>;
+
+    // a FastCGI request is the easiest one to fake
+    struct fake_request {
+        fastcgi::request source;
+        router_request   req{source};
+
+        using param_list = std::initializer_list<std::pair<std::string_view, std::string_view>>;
+
+        fake_request(std::string_view uri, std::string_view method = "GET", param_list headers = {}) {
+            auto const add = [this](std::string_view name, std::string_view value) {
+                source.params += char(name.size());
+                source.params += char(value.size());
+                source.params += name;
+                source.params += value;
+            };
+            add("REQUEST_URI", uri);
+            add("REQUEST_METHOD", method);
+            for (auto [name, value] : headers)
+                add(name, value);
+        }
+    };
+
+    // a route that only responds to "/page/..."
+    struct page_route {
+        [[nodiscard]] constexpr std::string_view static_path_prefix() const noexcept {
+            return "/page/";
+        }
+
+        std::optional<std::string_view> operator()(Context auto& ctx) const noexcept {
+            if (ctx.request->request_uri().ends_with("/skip"))
+                return std::nullopt;
+            return "page";
+        }
+    };
+
+    template <std::size_t N>
+    struct counted_route {
+        std::string_view prefix;
+        int*             calls;
+
+        [[nodiscard]] constexpr std::string_view static_path_prefix() const noexcept {
+            return prefix;
+        }
+
+        std::string_view operator()(Context auto&) const noexcept {
+            ++*calls;
+            return prefix;
+        }
+    };
+} // namespace
+
+TEST(Router, PrefixTree) {
+    routes::prefix_tree<5> tree;
+    tree.insert("/user/", 0);
+    tree.insert("/users", 1);
+    tree.insert("", 2);
+    tree.insert("/about", 3);
+    tree.insert("/user/", 4);
+
+    auto const bits = [&](std::string_view path) {
+        std::string res;
+        routes::prefix_tree<5>::for_each(tree.candidates(path), [&](std::size_t i) {
+            res += char('0' + i);
+            return false;
+        });
+        return res;
+    };
+    EXPECT_EQ(bits("/user/12"), "024");
+    EXPECT_EQ(bits("/users/12"), "12");
+    EXPECT_EQ(bits("/about"), "23");
+    EXPECT_EQ(bits("/abo"), "2");
+    EXPECT_EQ(bits("/nothing"), "2");
+    EXPECT_EQ(bits(""), "2");
+
+    using user_route = decltype(tpath<"/user/{uint:id}/posts">([] {
+        return "";
+    }));
+    static_assert(user_route::static_path_prefix() == "/user/");
+    static_assert(PrefixedRoute<user_route>);
+}
+
+TEST(Router, PrefixDispatch) {
+    int    home_calls = 0, about_calls = 0;
+    router _router{counted_route<0>{"/home", &home_calls}, page_route{},
+                   counted_route<1>{"/about", &about_calls},
+                   [](Context auto& ctx) noexcept -> std::optional<std::string> {
+                       if (ctx.request->request_uri() == "/fallback")
+                           return "fallback";
+                       return std::nullopt;
+                   }};
+
+    auto respond = [&](std::string_view uri) {
+        fake_request fake{uri};
+        auto         res = _router(fake.req);
+        return std::pair{static_cast<int>(res.header.status_code), std::string{res.body.str()}};
+    };
+
+    EXPECT_EQ(respond("/about?x=1"), std::pair(200, std::string{"/about"}));
+    EXPECT_EQ(about_calls, 1);
+    EXPECT_EQ(home_calls, 0);
+    EXPECT_EQ(respond("/page/1"), std::pair(200, std::string{"page"}));
+    EXPECT_EQ(respond("/fallback"), std::pair(200, std::string{"fallback"}));
+    EXPECT_EQ(respond("/page/skip").first, 404);
+    EXPECT_EQ(respond("/nowhere").first, 404);
+    EXPECT_EQ(home_calls, 0);
+    EXPECT_EQ(about_calls, 1);
+
+    // the linear walk calls the routes that the prefixes would've skipped
+    fake_request fake{"/about"};
+    simple_context<router_request> ctx{fake.req};
+    EXPECT_EQ(_router.walk(ctx).body.str(), "/home");
+    EXPECT_EQ(home_calls, 1);
+}
+
+TEST(Router, PrefixOrder) {
+    int  a = 0, b = 0;
+    auto _router = router{counted_route<0>{"/a", &a}, counted_route<1>{"/", &b}};
+    fake_request fake{"/a/b"};
+    EXPECT_EQ(_router(fake.req).body.str(), "/a");
+    fake_request other{"/b"};
+    EXPECT_EQ(_router(other.req).body.str(), "/");
+    EXPECT_EQ(a, 1);
+    EXPECT_EQ(b, 1);
+
+    constexpr router<> empty{};
+    fake_request       none{"/"};
+    EXPECT_EQ(empty(none.req).header.status_code, 404);
+}
+
+TEST(Router, ErrorPages) {
+    using context_type = simple_context<router_request>;
+
+    constexpr router<> empty{};
+    fake_request       first{"/a"}, second{"/b"};
+    auto const         a = empty(first.req);
+    auto const         b = empty(second.req);
+    EXPECT_EQ(a.header.status_code, 404);
+    EXPECT_NE(a.body.str().find("404 Not Found"), std::string::npos);
+    EXPECT_EQ(&a.body.str(), &b.body.str()); // the body is shared, not rendered again
+
+    context_type ctx{first.req};
+    auto const   custom  = empty.error(ctx, 404u, "Gone Fishing");
+    auto const   custom2 = empty.error(ctx, 404u, "Gone Fishing");
+    auto const   other   = empty.error(ctx, 500u);
+    EXPECT_NE(custom.body.str().find("404 Gone Fishing"), std::string::npos);
+    EXPECT_EQ(&custom.body.str(), &custom2.body.str());
+    EXPECT_NE(&custom.body.str(), &a.body.str());
+    EXPECT_EQ(other.header.status_code, 500);
+    EXPECT_NE(other.body.str().find("500"), std::string::npos);
+
+    // the phrase is escaped
+    auto const html = empty.error(ctx, 400u, "<script>alert('x')</script>");
+    EXPECT_EQ(html.body.str().find("<script>"), std::string::npos);
+    EXPECT_NE(html.body.str().find("400 &lt;script&gt;alert(&#39;x&#39;)&lt;/script&gt;"), std::string::npos);
+}
+
+TEST(Router, MethodBuckets) {
+    using namespace webpp::routes;
+
+    int  get_calls = 0, post_calls = 0;
+    auto _router = router{on<http_method::get>([&](Context auto&) noexcept {
+                              ++get_calls;
+                              return "get";
+                          }),
+                          on<http_method::post>([&](router_request const&) noexcept {
+                              ++post_calls;
+                              return "post";
+                          }),
+                          [](Context auto& ctx) noexcept {
+                              return std::string{ctx.request->request_method()};
+                          }};
+    static_assert(MethodRoute<std::tuple_element_t<0, std::remove_const_t<decltype(_router.routes)>>>);
+    static_assert(parse_http_method("DELETE") == http_method::delete_);
+    static_assert(parse_http_method("BREW") == http_method::other);
+
+    fake_request post{"/", "POST"};
+    EXPECT_EQ(_router(post.req).body.str(), "post");
+    EXPECT_EQ(get_calls, 0);
+    fake_request get{"/", "GET"};
+    EXPECT_EQ(_router(get.req).body.str(), "get");
+    EXPECT_EQ(post_calls, 1);
+    fake_request put{"/", "PUT"};
+    EXPECT_EQ(_router(put.req).body.str(), "PUT");
+    EXPECT_EQ(get_calls + post_calls, 2);
+
+    // they still check the method themselves when they're walked through
+    simple_context<router_request> ctx{put.req};
+    EXPECT_EQ(_router.walk(ctx).body.str(), "PUT");
+    EXPECT_EQ(get_calls + post_calls, 2);
+}
+
+TEST(Router, TPath) {
+    using program = webpp::details::tpath_program<"/page/{uint:page_num}.html">;
+    static_assert(program::valid);
+    static_assert(program::segment_count == 3);
+    static_assert(program::capture_count == 1);
+    static_assert(std::is_same_v<program::values_type, std::tuple<std::uint64_t>>);
+    static_assert(!webpp::details::tpath_program<"/{a}/{a}">::valid);
+    static_assert(!webpp::details::tpath_program<"/{float:a}">::valid);
+    static_assert(!webpp::details::tpath_program<"/{a}{b}">::valid);
+
+    auto _router = router{tpath<"/page/{uint:page_num}.html">([](Context auto& ctx) {
+                              return std::to_string(ctx.captures.template get<"page_num">() + 1);
+                          }),
+                          tpath<"/user/{int:id}/{name}">([](Context auto& ctx) {
+                              auto const& caps = ctx.captures;
+                              return std::to_string(caps.template get<"id">()) + " " +
+                                     std::string{caps.template get<"name">()};
+                          }),
+                          tpath<"/about">([] {
+                              return "about";
+                          })};
+
+    auto respond = [&](std::string_view uri) {
+        fake_request fake{uri};
+        auto         res = _router(fake.req);
+        return res.header.status_code == 404 ? std::string{"404"} : std::string{res.body.str()};
+    };
+    EXPECT_EQ(respond("/page/41.html"), "42");
+    EXPECT_EQ(respond("/page/41.htm"), "404");
+    EXPECT_EQ(respond("/page/abc.html"), "404");
+    EXPECT_EQ(respond("/page/-1.html"), "404");
+    EXPECT_EQ(respond("/user/-5/moisrex?x=y"), "-5 moisrex");
+    EXPECT_EQ(respond("/user/5"), "404");
+    EXPECT_EQ(respond("/user/5/"), "404");
+    EXPECT_EQ(respond("/about"), "about");
+}
+
+TEST(Router, DynamicRouter) {
+    using context_type = simple_context<router_request>;
+
+    int                          calls = 0;
+    dynamic_router<context_type> _router;
+    _router.on("/", [] {
+        return "home";
+    });
+    _router.on("/users/{id}", [](context_type&, path_captures const& captures) {
+        return std::string{"user "} + std::string{captures["id"]};
+    });
+    _router.on("/users/me", [&calls](context_type&) noexcept {
+        ++calls;
+        return "me";
+    });
+    _router.on("/users/{id}/posts/{post}", [](context_type&, path_captures const& captures) {
+        return std::string{captures["id"]} + ":" + std::string{captures["post"]};
+    });
+    _router.on("/static/*", [](router_request const& req) {
+        return std::string{req.request_uri()};
+    });
+    _router.on("/skip", [](context_type&) -> std::optional<std::string_view> {
+        return std::nullopt;
+    });
+    _router.on("/skip", [] {
+        return "second";
+    });
+    EXPECT_EQ(_router.route_count(), 7);
+
+    auto respond = [&](std::string_view uri) {
+        fake_request fake{uri};
+        auto         res = _router(fake.req);
+        return res.header.status_code == 404 ? std::string{"404"} : std::string{res.body.str()};
+    };
+
+    EXPECT_EQ(respond("/"), "home");
+    EXPECT_EQ(respond("/users/12"), "user 12");
+    EXPECT_EQ(respond("/users/me?tab=1"), "me");
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(respond("/users/12/posts/3"), "12:3");
+    EXPECT_EQ(respond("/users/me/posts/3"), "me:3"); // falls back to the variable
+    EXPECT_EQ(respond("/static/css/main.css"), "/static/css/main.css");
+    EXPECT_EQ(respond("/skip"), "second");
+    EXPECT_EQ(respond("/users"), "404");
+    EXPECT_EQ(respond("/users/12/posts"), "404");
+
+    // big callables go on the heap
+    std::array<char, 128> big{'b', 'i', 'g'};
+    _router.on("/big", [big] {
+        return std::string{big.data()};
+    });
+    EXPECT_EQ(respond("/big"), "big");
+}
+
+TEST(Router, DynamicRouterAdaptiveOrder) {
+    using context_type = simple_context<router_request>;
+
+    dynamic_router<context_type> _router;
+    auto only = [](std::string_view method, std::string_view body) {
+        return [=](router_request const& req) -> std::optional<std::string_view> {
+            if (req.request_method() != method)
+                return std::nullopt;
+            return body;
+        };
+    };
+    _router.on("/items", only("GET", "get"));
+    _router.on("/items", only("POST", "post"));
+    _router.adapt(4);
+    EXPECT_TRUE(_router.is_adaptive());
+
+    auto respond = [&](std::string_view method) {
+        fake_request fake{"/items", method};
+        auto         res = _router(fake.req);
+        return std::string{res.body.str()};
+    };
+
+    for (int i = 0; i < 3; i++)
+        EXPECT_EQ(respond("POST"), "post");
+    EXPECT_EQ(_router.hits("/items", 0), 0);
+    EXPECT_EQ(_router.hits("/items", 1), 3);
+
+    // the 4th request reorders the routes; the hottest goes first
+    EXPECT_EQ(respond("GET"), "get");
+    EXPECT_EQ(_router.hits("/items", 0), 1); // POST, halved
+    EXPECT_EQ(_router.hits("/items", 1), 1); // GET
+
+    // the order is kept after freezing, and the hits are not counted anymore
+    _router.freeze();
+    EXPECT_FALSE(_router.is_adaptive());
+    EXPECT_EQ(respond("GET"), "get");
+    EXPECT_EQ(respond("POST"), "post");
+    EXPECT_EQ(_router.hits("/items", 0), 1);
+    EXPECT_EQ(_router.hits("/items", 1), 1);
+
+    // a warm up freezes the order by itself
+    int                          get_tries = 0;
+    dynamic_router<context_type> warm;
+    warm.on("/items", [&get_tries](router_request const& req) -> std::optional<std::string_view> {
+        ++get_tries;
+        if (req.request_method() != "GET")
+            return std::nullopt;
+        return "get";
+    });
+    warm.on("/items", only("POST", "post"));
+    warm.adapt(1000, 2);
+    fake_request post{"/items", "POST"};
+    EXPECT_EQ(warm(post.req).body.str(), "post");
+    EXPECT_EQ(warm(post.req).body.str(), "post");
+    EXPECT_FALSE(warm.is_adaptive());
+    EXPECT_EQ(get_tries, 1); // the second request is already routed in the learned order
+    EXPECT_EQ(warm(post.req).body.str(), "post");
+    EXPECT_EQ(get_tries, 1);
+}
+
+namespace {
+    struct fake_clock {
+        using duration   = std::chrono::nanoseconds;
+        using rep        = duration::rep;
+        using period     = duration::period;
+        using time_point = std::chrono::time_point<fake_clock>;
+
+        static constexpr bool is_steady = true;
+
+        static inline time_point current{};
+
+        static time_point now() noexcept {
+            return current;
+        }
+    };
+} // namespace
+
+TEST(Router, Memoize) {
+    using namespace std::chrono_literals;
+    using context_type = simple_context<router_request>;
+
+    int  calls = 0;
+    auto page  = extensions::memoize<fake_clock>(
+      [&calls](router_request const& req) -> std::optional<std::string> {
+          ++calls;
+          if (req.request_uri().starts_with("/none"))
+              return std::nullopt;
+          return std::string{"page "} + std::to_string(calls);
+      },
+      {.ttl = 10s, .max_entries = 2});
+
+    auto respond = [&](std::string_view uri, std::string_view method = "GET") {
+        fake_request fake{uri, method};
+        context_type ctx{fake.req};
+        auto         res = page(ctx);
+        return res ? std::string{res->body.str()} : std::string{"none"};
+    };
+
+    EXPECT_EQ(respond("/a?x=1"), "page 1");
+    EXPECT_EQ(respond("/a?x=1"), "page 1"); // the handler is skipped
+    EXPECT_EQ(respond("/a?x=1#frag", "POST"), "page 1");
+    EXPECT_EQ(calls, 1);
+    fake_clock::current += 1s;
+    EXPECT_EQ(respond("/a?x=2"), "page 2"); // another query
+    EXPECT_EQ(page.cached_count<context_type>(), 2);
+
+    // the routes that don't respond are not remembered
+    EXPECT_EQ(respond("/none"), "none");
+    EXPECT_EQ(respond("/none"), "none");
+    EXPECT_EQ(calls, 4);
+
+    // the size limit pushes the one that expires first out
+    fake_clock::current += 1s;
+    EXPECT_EQ(respond("/b"), "page 5");
+    EXPECT_EQ(page.cached_count<context_type>(), 2);
+    EXPECT_EQ(respond("/a?x=2"), "page 2");
+    EXPECT_EQ(respond("/a?x=1"), "page 6");
+
+    // expired
+    fake_clock::current += 11s;
+    EXPECT_EQ(respond("/b"), "page 7");
+
+    // keyed by the method and the path only
+    auto by_method = extensions::memoize(
+      [&calls] {
+          return std::to_string(++calls);
+      },
+      {.keys = extensions::memo_key::method | extensions::memo_key::path});
+    fake_request get_a{"/a?one"}, get_b{"/a?two"}, post_a{"/a?one", "POST"};
+    context_type ctx_a{get_a.req}, ctx_b{get_b.req}, ctx_post{post_a.req};
+    EXPECT_EQ(by_method(ctx_a)->body.str(), "8");
+    EXPECT_EQ(by_method(ctx_b)->body.str(), "8");
+    EXPECT_EQ(by_method(ctx_post)->body.str(), "9");
+
+    // it goes in a router like any other route
+    router _router{extensions::memoize([&calls] {
+        return std::to_string(++calls);
+    })};
+    EXPECT_EQ(_router(ctx_a).body.str(), "10");
+    EXPECT_EQ(_router(ctx_a).body.str(), "10");
+}
+
+TEST(Router, ResponseCache) {
+    using namespace std::chrono_literals;
+    using context_type = simple_context<router_request>;
+
+    int  calls = 0;
+    auto pages = extensions::cache_responses<fake_clock>(
+      [&calls](context_type& ctx) {
+          ++calls;
+          auto const uri  = ctx.request->request_uri();
+          auto const body = uri.starts_with("/private") ? std::string{"private"}
+                                                         : "page " + std::to_string(calls);
+          auto       res  = ctx.template response<string_response>(200u, body);
+          if (uri.starts_with("/short"))
+              res.header.emplace("Cache-Control", "public, max-age=5");
+          if (uri.starts_with("/private"))
+              res.header.emplace("Cache-Control", "no-store");
+          if (uri.starts_with("/lang"))
+              res.header.emplace("Vary", "Accept-Language");
+          return res;
+      },
+      {.ttl = 60s});
+
+    struct result {
+        std::string body;
+        unsigned    status;
+        std::string etag;
+        std::string last_modified;
+        bool        has_age;
+    };
+    auto respond = [&](std::string_view         uri,
+                       fake_request::param_list headers = {},
+                       std::string_view         method  = "GET") {
+        fake_request fake{uri, method, headers};
+        context_type ctx{fake.req};
+        auto         res = pages(ctx);
+        return result{std::string{res->body.str()},
+                      static_cast<unsigned>(res->header.status_code),
+                      std::string{extensions::details::header_of(*res, well_known_header::etag)},
+                      std::string{extensions::details::header_of(*res, well_known_header::last_modified)},
+                      res->header.contains(well_known_header::age)};
+    };
+
+    auto const first = respond("/a");
+    EXPECT_EQ(first.body, "page 1");
+    EXPECT_EQ(first.etag.size(), 18) << "a strong ETag of the hash of the body";
+    EXPECT_TRUE(parse_http_date(first.last_modified));
+    EXPECT_FALSE(first.has_age);
+    auto const second = respond("/a#top");
+    EXPECT_EQ(second.body, "page 1");
+    EXPECT_EQ(second.etag, first.etag);
+    EXPECT_TRUE(second.has_age);
+    EXPECT_EQ(calls, 1);
+
+    // the conditional requests get a 304 without calling the route
+    auto const matched = respond("/a", {{"HTTP_IF_NONE_MATCH", "\"other\", W/" + first.etag}});
+    EXPECT_EQ(matched.status, 304);
+    EXPECT_EQ(matched.body, "");
+    EXPECT_EQ(matched.etag, first.etag);
+    EXPECT_EQ(respond("/a", {{"HTTP_IF_NONE_MATCH", "\"other\""}}).status, 200);
+    EXPECT_EQ(respond("/a", {{"HTTP_IF_MODIFIED_SINCE", first.last_modified}}).status, 304);
+    EXPECT_EQ(respond("/a", {{"HTTP_IF_MODIFIED_SINCE", "Thu, 01 Jan 1970 00:00:00 GMT"}}).status, 200);
+    EXPECT_EQ(calls, 1);
+
+    // the other methods, and the clients that ask for a new one, call the route
+    EXPECT_EQ(respond("/a", {}, "POST").body, "page 2");
+    EXPECT_EQ(respond("/a", {{"HTTP_CACHE_CONTROL", "no-cache"}}).body, "page 3");
+    EXPECT_EQ(respond("/a").body, "page 3");
+    EXPECT_EQ(respond("/a", {{"HTTP_AUTHORIZATION", "Basic eDp5"}}).body, "page 4");
+
+    // max-age of the response
+    EXPECT_EQ(respond("/short").body, "page 5");
+    fake_clock::current += 4s;
+    EXPECT_EQ(respond("/short").body, "page 5");
+    fake_clock::current += 2s;
+    EXPECT_EQ(respond("/short").body, "page 6");
+
+    // no-store: it's not kept, but the conditional requests still get their 304
+    auto const private_page = respond("/private");
+    EXPECT_EQ(private_page.body, "private");
+    EXPECT_EQ(respond("/private", {{"HTTP_IF_NONE_MATCH", private_page.etag}}).status, 304);
+    EXPECT_EQ(calls, 8);
+
+    // varies by the headers of the request
+    EXPECT_EQ(respond("/lang", {{"HTTP_ACCEPT_LANGUAGE", "en"}}).body, "page 9");
+    EXPECT_EQ(respond("/lang", {{"HTTP_ACCEPT_LANGUAGE", "en"}}).body, "page 9");
+    EXPECT_EQ(respond("/lang", {{"HTTP_ACCEPT_LANGUAGE", "fr"}}).body, "page 10");
+
+    // the virtual hosts don't share their pages
+    EXPECT_EQ(respond("/home", {{"HTTP_HOST", "a.example"}}).body, "page 11");
+    EXPECT_EQ(respond("/home", {{"HTTP_HOST", "b.example"}}).body, "page 12");
+    EXPECT_EQ(respond("/home", {{"HTTP_HOST", "a.example"}}).body, "page 11");
+
+    // a HEAD response is not served for a GET
+    EXPECT_EQ(respond("/head", {}, "HEAD").body, "page 13");
+    EXPECT_EQ(respond("/head").body, "page 14");
+    EXPECT_EQ(respond("/head", {}, "HEAD").body, "page 13");
+
+    EXPECT_EQ(pages.cached_count<context_type>(), 7);
+}
+
+TEST(Router, RateLimit) {
+    using namespace std::chrono_literals;
+    using context_type = simple_context<router_request>;
+
+    int    calls = 0;
+    router _router{extensions::limit_rate<fake_clock>({.rate = 1, .burst = 2}),
+                   [&calls] {
+                       return std::to_string(++calls);
+                   }};
+    auto   respond = [&](std::string_view addr) {
+        fake_request fake{"/", "GET", {{"REMOTE_ADDR", addr}}};
+        context_type ctx{fake.req};
+        auto         res = _router(ctx);
+        return std::pair{static_cast<unsigned>(res.header.status_code),
+                         std::string{extensions::details::header_of(res, well_known_header::retry_after)}};
+    };
+
+    EXPECT_EQ(respond("10.0.0.1").first, 200);
+    EXPECT_EQ(respond("10.0.0.1").first, 200);
+    auto const rejected = respond("10.0.0.1");
+    EXPECT_EQ(rejected.first, 429);
+    EXPECT_EQ(rejected.second, "1");
+    EXPECT_EQ(calls, 2) << "the rejected ones don't get to the routes";
+
+    // the other clients have their own limits; an ipv6 client is limited by its /64
+    EXPECT_EQ(respond("10.0.0.2").first, 200);
+    EXPECT_EQ(respond("2001:db8::1").first, 200);
+    EXPECT_EQ(respond("2001:db8::2").first, 200);
+    EXPECT_EQ(respond("2001:db8::3").first, 429);
+    EXPECT_EQ(respond("2001:db8:0:1::1").first, 200);
+
+    fake_clock::current += 1s;
+    EXPECT_EQ(respond("10.0.0.1").first, 200);
+    EXPECT_EQ(respond("10.0.0.1").first, 429);
+}
+
+namespace {
+    // the requests of the servers know the address from their connection, and have no environment
+    struct addressed_request {
+        std::string_view address;
+
+        [[nodiscard]] std::string_view remote_address() const noexcept {
+            return address;
+        }
+    };
+
+    struct addressed_context {
+        using traits_type = std_traits;
+
+        addressed_request const* request;
+    };
+} // namespace
+
+TEST(Router, RateLimitKey) {
+    extensions::client_address const key_of;
+    addressed_request                req{"10.0.0.1"};
+    EXPECT_EQ(key_of(addressed_context{&req}), std::optional<std::uint64_t>{0x0A00'0001});
+    req.address = "::ffff:10.0.0.1";
+    EXPECT_EQ(key_of(addressed_context{&req}), std::optional<std::uint64_t>{0x0A00'0001});
+
+    // the clients that we don't know are not put in one bucket
+    req.address = "";
+    EXPECT_EQ(key_of(addressed_context{&req}), std::nullopt);
+}
+
+TEST(Router, Profiler) {
+    using context_type = simple_context<router_request>;
+
+    route_profiler profiler{3};
+    router         _router{[](context_type& ctx) {
+                       auto const uri = std::string_view{ctx.request->request_uri()};
+                       return uri == "/a" ? std::optional<std::string>{"a"} : std::nullopt;
+                   },
+                   routes::prefix<"/b"> && [](context_type&) {
+                       return "b";
+                   },
+                   [] {
+                       return "fallback";
+                   }};
+    _router.profile(&profiler);
+
+    for (auto const uri : {"/a", "/b", "/c", "/a"}) {
+        fake_request fake{uri};
+        static_cast<void>(_router(fake.req));
+    }
+
+    auto const a = profiler.profile(0);
+    EXPECT_EQ(a.evaluations, 4);
+    EXPECT_EQ(a.matches, 2);
+    auto const b = profiler.profile(1);
+    EXPECT_EQ(b.evaluations, 1) << "the prefix tree skips it for the other paths";
+    EXPECT_EQ(b.matches, 1);
+    auto const fallback = profiler.profile(2);
+    EXPECT_EQ(fallback.evaluations, 1);
+    EXPECT_EQ(fallback.matches, 1);
+
+    std::string table;
+    profiler.write(table);
+    EXPECT_TRUE(table.starts_with("route  evaluations"));
+    EXPECT_EQ(std::count(table.begin(), table.end(), '\n'), 4);
+
+    profiler.reset();
+    EXPECT_EQ(profiler.profile(0).evaluations, 0);
+    _router.profile(nullptr);
+    fake_request fake{"/a"};
+    static_cast<void>(_router(fake.req));
+    EXPECT_EQ(profiler.profile(0).evaluations, 0);
+}
+
+TEST(Router, ReloadableRouter) {
+    using context_type = simple_context<router_request>;
+
+    auto respond = [](auto& router, std::string_view uri) {
+        fake_request fake{uri};
+        auto         res = router(fake.req);
+        return res.header.status_code == 404 ? std::string{"404"} : std::string{res.body.str()};
+    };
+
+    reloadable_router<context_type> _router;
+    EXPECT_EQ(respond(_router, "/"), "404");
+
+    dynamic_router<context_type> first;
+    first.on("/", [] {
+        return "first";
+    });
+    _router.store(std::move(first));
+    EXPECT_EQ(respond(_router, "/"), "first");
+
+    // the ones that hold the old routes keep them
+    auto const old = _router.load();
+
+    dynamic_router<context_type> second;
+    second.adapt(1);
+    second.on("/", [] {
+        return "second";
+    });
+    second.on("/about", [] {
+        return "about";
+    });
+    _router.store(std::move(second));
+    EXPECT_EQ(_router.route_count(), 2);
+    EXPECT_FALSE(_router.load()->is_adaptive()) << "the shared routers are not reordered";
+    EXPECT_EQ(respond(_router, "/"), "second");
+    EXPECT_EQ(respond(_router, "/about"), "about");
+    EXPECT_EQ(respond(*old, "/"), "first");
+}
+
+TEST(Router, Metrics) {
+    using context_type = simple_context<router_request>;
+
+    metrics_registry registry;
+    router           _router{extensions::expose_metrics(registry),
+                   extensions::measure(registry, "posts", [](context_type& ctx) {
+                       std::optional<decltype(ctx.template response<string_response>(200u))> res;
+                       auto const uri = std::string_view{ctx.request->request_uri()};
+                       auto const status = uri == "/posts/1" ? 200u : 404u;
+                       if (uri.starts_with("/posts/"))
+                           res.emplace(ctx.template response<string_response>(status));
+                       return res;
+                   })};
+    auto             respond = [&](std::string_view uri, std::string_view method = "GET") {
+        fake_request fake{uri, method};
+        context_type ctx{fake.req};
+        auto         res = _router(ctx);
+        return std::pair{static_cast<int>(res.header.status_code), std::string{res.body.str()}};
+    };
+
+    EXPECT_EQ(respond("/posts/1").first, 200);
+    EXPECT_EQ(respond("/posts/1").first, 200);
+    EXPECT_EQ(respond("/posts/2").first, 404);
+    EXPECT_EQ(respond("/other").first, 404) << "the requests that it doesn't respond to aren't counted";
+    EXPECT_EQ(respond("/metrics", "POST").first, 404);
+
+    auto const [status, text] = respond("/metrics?format=text");
+    EXPECT_EQ(status, 200);
+    EXPECT_NE(text.find(R"(webpp_requests_total{route="posts",code="2xx"} 2)"), std::string::npos) << text;
+    EXPECT_NE(text.find(R"(webpp_requests_total{route="posts",code="4xx"} 1)"), std::string::npos);
+    EXPECT_NE(text.find(R"(webpp_requests_total{route="posts",code="5xx"} 0)"), std::string::npos);
+    EXPECT_NE(text.find(R"(webpp_handler_duration_seconds_count{route="posts"} 3)"), std::string::npos);
+}
+
+TEST(Router, LogicalRoutes) {
+    using namespace webpp::routes;
+    using context_type = simple_context<router_request>;
+
+    // the static conditions are folded at compile time
+    constexpr auto get_or_head = method<http_method::get> || method<http_method::head>;
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(get_or_head)>,
+                                 method_set<method<http_method::get, http_method::head>.mask>>);
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(get_or_head && method<http_method::get>)>,
+                                 std::remove_cvref_t<decltype(method<http_method::get>)>>);
+    static_assert(
+      std::is_same_v<std::remove_cvref_t<decltype(method<http_method::get> && method<http_method::post>)>,
+                     constant_condition<false>>);
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(prefix<"/api"> && prefix<"/api/v1">)>,
+                                 path_prefix<"/api/v1">>);
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(prefix<"/api"> && exact<"/web">)>,
+                                 constant_condition<false>>);
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(prefix<"/api/v1"> || prefix<"/api">)>,
+                                 path_prefix<"/api">>);
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(always && prefix<"/a"> && always)>,
+                                 path_prefix<"/a">>);
+
+    // the fused conditions are next to each other even if they're written in groups
+    auto handler = [](context_type&) {
+        return "api";
+    };
+    auto nested = (method<http_method::get> && prefix<"/api">) &&
+                  (method<http_method::get, http_method::post> && prefix<"/api/v1"> && handler);
+    using nested_type = decltype(nested);
+    static_assert(std::is_same_v<typename nested_type::left_type, method_set<method<http_method::get>.mask>>);
+    static_assert(std::is_same_v<typename nested_type::right_type::left_type, path_prefix<"/api/v1">>);
+    static_assert(MethodRoute<nested_type>);
+    static_assert(PrefixedRoute<nested_type>);
+    EXPECT_EQ(nested.static_path_prefix(), "/api/v1");
+
+    auto respond = [](auto const& _route, std::string_view uri, std::string_view method_name = "GET") {
+        fake_request fake{uri, method_name};
+        context_type ctx{fake.req};
+        return _route(ctx);
+    };
+
+    EXPECT_EQ(respond(nested, "/api/v1/users").value_or("none"), std::string_view{"api"});
+    EXPECT_EQ(respond(nested, "/api/v2").value_or("none"), std::string_view{"none"});
+    EXPECT_EQ(respond(nested, "/api/v1", "POST").value_or("none"), std::string_view{"none"});
+
+    // the short circuits
+    int  calls   = 0;
+    auto counted = route{[&calls] {
+        ++calls;
+        return true;
+    }};
+    EXPECT_FALSE(respond(method<http_method::post> && counted, "/"));
+    EXPECT_TRUE(respond(method<http_method::get> || counted, "/"));
+    EXPECT_EQ(calls, 0);
+    EXPECT_TRUE(respond(exact<"/x"> || counted, "/"));
+    EXPECT_FALSE(respond(exact<"/"> ^ counted, "/?q"));
+    EXPECT_EQ(calls, 2);
+    EXPECT_TRUE(respond(get_or_head, "/", "HEAD"));
+
+    // and they work in the router, with its prefix tree and method buckets
+    router _router{method<http_method::post> && prefix<"/api"> &&
+                     [] {
+                         return "post";
+                     },
+                   prefix<"/api"> && [] {
+                       return "any";
+                   }};
+    fake_request post{"/api/x", "POST"}, get{"/api/x"}, other{"/web"};
+    EXPECT_EQ(_router(post.req).body.str(), "post");
+    EXPECT_EQ(_router(get.req).body.str(), "any");
+    EXPECT_EQ(_router(other.req).header.status_code, 404);
+}
+
+TEST(Router, ValidUTF8) {
+    using namespace webpp::routes;
+    using context_type = simple_context<router_request>;
+
+    auto respond = [](auto const& _route, std::string_view uri) {
+        fake_request fake{uri};
+        context_type ctx{fake.req};
+        return _route(ctx);
+    };
+    EXPECT_TRUE(respond(valid_utf8, "/caf%C3%A9?q=%E2%82%AC"));
+    EXPECT_TRUE(respond(valid_utf8, "/caf\xc3\xa9"));
+    EXPECT_TRUE(respond(valid_utf8, "/100%25/%zz")) << "the broken escapes are not UTF-8 errors";
+    EXPECT_FALSE(respond(valid_utf8, "/caf%E9"));
+    EXPECT_FALSE(respond(valid_utf8, "/search?q=%ED%A0%80"));
+    EXPECT_FALSE(respond(valid_utf8, "/caf%C3"));
+    EXPECT_TRUE(respond(valid_utf8, "/caf#%C3")) << "the fragment is not checked";
+
+    // the chars that are cut between the pieces that it's decoded in
+    for (std::size_t pos = 250; pos < 262; pos++) {
+        std::string uri(pos, 'a');
+        EXPECT_TRUE(routes::details::is_utf8_uri(uri + "%F0%9D%84%9E" + std::string(300, 'b'))) << pos;
+        EXPECT_FALSE(routes::details::is_utf8_uri(uri + "%F0%9D%84" + std::string(300, 'b'))) << pos;
+    }
+
+    router _router{valid_utf8 && prefix<"/search"> && [] {
+        return "found";
+    }};
+    fake_request good{"/search?q=%C3%A9"}, bad{"/search?q=%E9"};
+    EXPECT_EQ(_router(good.req).body.str(), "found");
+    EXPECT_EQ(_router(bad.req).header.status_code, 404);
+}
+
+TEST(Router, AsyncRoutes) {
+    using namespace webpp::routes;
+    using context_type = simple_context<router_request>;
+
+    std::coroutine_handle<> waiting{};
+    struct upstream_reply {
+        std::coroutine_handle<>& waiting;
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> h) const noexcept {
+            waiting = h;
+        }
+
+        std::string await_resume() const noexcept {
+            return "from upstream";
+        }
+    };
+
+    router _router{prefix<"/sync"> &&
+                     [] {
+                         return "sync";
+                     },
+                   prefix<"/async"> && [&waiting](context_type&) -> task<std::string> {
+                       co_return co_await upstream_reply{waiting};
+                   },
+                   tpath<"/user/{uint:id}">([&waiting](auto& ctx) -> task<std::string> {
+                       auto const reply = co_await upstream_reply{waiting};
+                       co_return reply + " " + std::to_string(ctx.captures.template get<"id">());
+                   })};
+
+    auto respond = [&](std::string_view uri, std::string& out) {
+        fake_request fake{uri};
+        auto         res = _router(fake.req);
+        static_assert(Task<decltype(res)>);
+        std::move(res).start([&](auto response) {
+            out = response.header.status_code == 404 ? "404" : response.body.str();
+        });
+        if (waiting)
+            std::exchange(waiting, {}).resume(); // the upstream replies; the request is still alive here
+    };
+
+    std::string sync, async, user, none;
+    respond("/sync", sync);
+    respond("/async/page", async);
+    respond("/user/7", user);
+    respond("/nowhere", none);
+    EXPECT_EQ(sync, "sync");
+    EXPECT_EQ(async, "from upstream");
+    EXPECT_EQ(user, "from upstream 7");
+    EXPECT_EQ(none, "404");
+}
+
+TEST(Router, Deadlines) {
+    using namespace webpp::routes;
+    using context_type = simple_context<router_request>;
+
+    int    calls = 0;
+    router _router{prefix<"/work"> && [&calls] {
+        ++calls;
+        return "done";
+    }};
+    _router.deadlines({.timeout = std::chrono::seconds{5}});
+
+    fake_request fresh{"/work"}, late{"/work", "GET", {{"HTTP_REQUEST_TIMEOUT", "0m"}}};
+    EXPECT_EQ(_router(fresh.req).body.str(), "done");
+    EXPECT_EQ(_router(late.req).header.status_code, 503) << "the upstream has given up on it already";
+    EXPECT_EQ(calls, 1);
+
+    // the client goes away while a coroutine route is waiting for its upstream
+    std::coroutine_handle<> waiting{};
+    struct upstream_reply {
+        std::coroutine_handle<>& waiting;
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> h) const noexcept {
+            waiting = h;
+        }
+
+        void await_resume() const noexcept {}
+    };
+    router async_router{prefix<"/slow"> && [&waiting](context_type& ctx) -> task<std::optional<std::string>> {
+        co_await upstream_reply{waiting};
+        if (ctx.is_cancelled())
+            co_return std::nullopt; // nobody's waiting for it
+        co_return "slow";
+    }};
+
+    cancellation_source source;
+    fake_request        slow{"/slow"};
+    context_type        ctx{slow.req};
+    ctx.cancellation = source.token();
+    int  status      = 0;
+    auto res         = async_router(ctx);
+    std::move(res).start([&](auto response) {
+        status = response.header.status_code;
+    });
+    source.cancel();
+    std::exchange(waiting, {}).resume();
+    EXPECT_EQ(status, 503);
+}
+
 // TEST(Router, RouterConcepts) {
 //    EXPECT_TRUE(static_cast<bool>(Application<const_router>));
 //}
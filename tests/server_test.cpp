@@ -1,8 +1,21 @@
 #include "../core/include/webpp/http/http.hpp"
+#include "../core/include/webpp/http/interfaces/common/buffer_pool.hpp"
+#include "../core/include/webpp/http/interfaces/common/connection_pool.hpp"
+#include "../core/include/webpp/http/interfaces/common/numa.hpp"
+#include "../core/include/webpp/http/interfaces/common/prefork.hpp"
+#include "../core/include/webpp/http/interfaces/common/server.hpp"
+#include "../core/include/webpp/http/interfaces/common/timing_wheel.hpp"
 #include "../core/include/webpp/http/routes/tpath.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <csignal>
 #include <gtest/gtest.h>
+#include <memory>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 using namespace webpp;
 //
@@ -71,3 +84,699 @@ using namespace webpp;
 //    app.run();
 //    EXPECT_EQ(app.body_result, "Something");
 //}
+
+
+TEST(Server, AcceptLoop) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    common::server srv{{tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}}, 1};
+    auto           endpoints = srv.local_endpoints();
+    ASSERT_EQ(endpoints.size(), 1);
+    EXPECT_NE(endpoints.front().port(), 0);
+
+    boost::asio::io_context client_io;
+    tcp::socket             one{client_io};
+    tcp::socket             two{client_io};
+    one.connect(endpoints.front());
+    srv.io.run_for(50ms);
+    EXPECT_EQ(srv.connection_count(), 1);
+
+    // the limit is one, so the second one should wait in the backlog
+    two.connect(endpoints.front());
+    srv.io.run_for(50ms);
+    EXPECT_EQ(srv.connection_count(), 1);
+
+    // closing the first one makes room for the second one
+    one.close();
+    srv.io.run_for(50ms);
+    EXPECT_EQ(srv.connection_count(), 1);
+
+    two.close();
+    srv.io.run_for(50ms);
+    EXPECT_EQ(srv.connection_count(), 0);
+    srv.stop();
+}
+
+TEST(Server, MultipleIoContexts) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    common::server srv{{tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}},
+                       100,
+                       2,
+                       common::balance_policy::round_robin};
+    EXPECT_EQ(srv.concurrency(), 2);
+    auto endpoints = srv.local_endpoints();
+    ASSERT_EQ(endpoints.size(), 1);
+
+    std::thread runner{[&] {
+        srv.run();
+    }};
+
+    boost::asio::io_context  client_io;
+    std::vector<tcp::socket> clients;
+    for (int i = 0; i < 4; i++)
+        clients.emplace_back(client_io).connect(endpoints.front());
+
+    for (int i = 0; i < 100 && srv.connection_count() != 4; i++)
+        std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(srv.connection_count(), 4);
+
+    for (auto& client : clients)
+        client.close();
+    for (int i = 0; i < 100 && srv.connection_count() != 0; i++)
+        std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(srv.connection_count(), 0);
+
+    boost::asio::post(srv.io, [&] {
+        srv.stop();
+    });
+    runner.join();
+}
+
+TEST(Server, NumaPlacement) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    EXPECT_EQ(common::parse_cpu_list("0-3,8,10-11\n"), (std::vector<unsigned>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_TRUE(common::parse_cpu_list("").empty());
+    EXPECT_EQ(common::parse_cpu_list("x,5-4,7"), std::vector<unsigned>{7});
+
+    common::numa_topology const topology{{{0, {0, 2}}, {1, {1, 3}}, {2, {}}}};
+    EXPECT_EQ(topology.node_count(), 2) << "the nodes without our cores are left out";
+    EXPECT_EQ(topology.node_of_cpu(3), 1);
+    EXPECT_FALSE(topology.node_of_cpu(4));
+    EXPECT_GE(common::numa_topology::detect().node_count(), 1);
+
+    common::server srv{{tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}}, 100, 4};
+    EXPECT_FALSE(srv.worker_node(0));
+    srv.numa(topology);
+    for (std::size_t i = 0; i < 4; i++) {
+        EXPECT_EQ(srv.worker_node(i), i / 2) << "in blocks";
+        EXPECT_EQ(srv.worker_cpu(i), std::vector<unsigned>({0, 2, 1, 3})[i]);
+    }
+
+    std::thread runner{[&] {
+        srv.run();
+    }};
+    boost::asio::io_context  client_io;
+    std::vector<tcp::socket> clients;
+    for (int i = 0; i < 4; i++)
+        clients.emplace_back(client_io).connect(srv.local_endpoints().front());
+    for (int i = 0; i < 100 && srv.connection_count() != 4; i++)
+        std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(srv.connection_count(), 4) << "they're steered to the workers of the nodes";
+    for (auto& client : clients)
+        client.close();
+    for (int i = 0; i < 100 && srv.connection_count() != 0; i++)
+        std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(srv.connection_count(), 0);
+
+    boost::asio::post(srv.io, [&] {
+        srv.stop();
+    });
+    runner.join();
+}
+
+#ifdef SO_REUSEPORT
+TEST(Server, ShardedAcceptors) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    common::server srv{{tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}},
+                       100,
+                       3,
+                       common::balance_policy::least_load,
+                       true};
+    EXPECT_EQ(srv.acceptor_count(), 3);
+    auto endpoints = srv.local_endpoints();
+    ASSERT_EQ(endpoints.size(), 1);
+
+    std::thread runner{[&] {
+        srv.run();
+    }};
+
+    boost::asio::io_context  client_io;
+    std::vector<tcp::socket> clients;
+    for (int i = 0; i < 6; i++)
+        clients.emplace_back(client_io).connect(endpoints.front());
+
+    for (int i = 0; i < 100 && srv.connection_count() != 6; i++)
+        std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(srv.connection_count(), 6);
+
+    boost::asio::post(srv.io, [&] {
+        srv.stop();
+    });
+    runner.join();
+}
+#endif
+
+TEST(Server, GatherWrite) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    boost::asio::io_context io;
+    tcp::acceptor           acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    tcp::socket             client{io};
+    client.connect(acceptor.local_endpoint());
+    common::connection conn{acceptor.accept()};
+
+    // the buffers go out with one gather write, and their owner is dropped then
+    auto owner = std::make_shared<std::pair<std::string, std::string> const>("hello ", "world");
+    std::vector<boost::asio::const_buffer> const buffers{boost::asio::buffer(owner->first),
+                                                         boost::asio::buffer(owner->second)};
+    std::weak_ptr<void const> const              watched = owner;
+    conn.write(buffers, std::exchange(owner, nullptr));
+    io.run_for(50ms);
+    EXPECT_TRUE(watched.expired());
+
+    std::string received(11, '\0');
+    boost::asio::read(client, boost::asio::buffer(received));
+    EXPECT_EQ(received, "hello world");
+}
+
+TEST(Server, WriteCoalescing) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    boost::asio::io_context io;
+    tcp::acceptor           acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    tcp::socket             client{io};
+    client.connect(acceptor.local_endpoint());
+    common::connection conn{acceptor.accept()};
+
+    metrics_registry registry;
+    auto const       writes = registry.counter("writes_total", "");
+    conn.metrics({.writes = writes});
+    conn.start([] {},
+               [](common::connection& c, std::string_view data) {
+                   // a response for each of the pipelined requests
+                   for (auto const req : data)
+                       c.send(std::string{"re:"} + req + ' ');
+               });
+
+    boost::asio::write(client, boost::asio::buffer(std::string_view{"abc"}));
+    io.run_for(50ms);
+    EXPECT_EQ(writes.value(), 1) << "the three responses are written together";
+
+    // the responses that are finished later can be corked by hand
+    conn.cork();
+    conn.send("x ");
+    conn.send("y");
+    io.run_for(20ms);
+    EXPECT_EQ(writes.value(), 1);
+    conn.uncork();
+    io.run_for(50ms);
+    EXPECT_EQ(writes.value(), 2);
+
+    std::string received(18, '\0');
+    boost::asio::read(client, boost::asio::buffer(received));
+    EXPECT_EQ(received, "re:a re:b re:c x y");
+}
+
+TEST(Server, BorrowedSend) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    boost::asio::io_context io;
+    tcp::acceptor           acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    tcp::socket             client{io};
+    client.connect(acceptor.local_endpoint());
+    common::connection conn{acceptor.accept()};
+    conn.start([] {});
+
+    // the bytes are not copied, they're kept alive by their owner
+    auto owner = std::make_shared<std::string const>("borrowed ");
+    conn.send(*owner, owner);
+    conn.send("owned");
+    EXPECT_EQ(conn.queued_size(), 5);
+    owner.reset();
+    io.run_for(50ms);
+
+    std::string received(14, '\0');
+    boost::asio::read(client, boost::asio::buffer(received));
+    EXPECT_EQ(received, "borrowed owned");
+    conn.stop();
+    io.run_for(10ms);
+}
+
+TEST(Server, Backpressure) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    boost::asio::io_context io;
+    tcp::acceptor           acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    tcp::socket             client{io};
+    client.connect(acceptor.local_endpoint());
+    common::connection conn{acceptor.accept()};
+    conn.water_marks(1024, 512);
+
+    // every request produces a response that is way bigger than what the
+    // kernel is willing to hold for a client that doesn't read
+    constexpr std::size_t response_size = 16 * 1024 * 1024;
+    int                   requests      = 0;
+    conn.start([] {},
+               [&](common::connection& c, std::string_view) {
+                   requests++;
+                   c.send(std::string(response_size, 'x'));
+               });
+
+    boost::asio::write(client, boost::asio::buffer(std::string_view{"one"}));
+    io.run_for(50ms);
+    EXPECT_EQ(requests, 1);
+    EXPECT_TRUE(conn.is_read_paused());
+
+    // we should not read this one until the client reads its response
+    boost::asio::write(client, boost::asio::buffer(std::string_view{"two"}));
+    io.run_for(50ms);
+    EXPECT_EQ(requests, 1);
+
+    std::vector<char> received(64 * 1024);
+    std::size_t       total = 0;
+    while (total < response_size) {
+        client.non_blocking(true);
+        boost::system::error_code ec;
+        total += client.read_some(boost::asio::buffer(received), ec);
+        io.run_for(1ms);
+    }
+    io.run_for(50ms);
+    EXPECT_EQ(requests, 2);
+    conn.stop();
+}
+
+TEST(Server, ObjectPool) {
+    common::object_pool<std::string, 2> pool;
+    EXPECT_EQ(pool.reuse(), nullptr);
+    auto one   = pool.emplace("one");
+    auto two   = pool.emplace("two");
+    auto three = pool.emplace("three"); // a new slab
+    EXPECT_EQ(*one, "one");
+    EXPECT_EQ(*three, "three");
+    EXPECT_EQ(pool.size(), 3);
+
+    pool.release(two);
+    EXPECT_EQ(pool.size(), 2);
+    EXPECT_EQ(pool.capacity(), 3);
+    EXPECT_EQ(pool.reuse(), two); // same address, no allocation
+    EXPECT_EQ(pool.reuse(), nullptr);
+
+    int count = 0;
+    pool.for_each([&](std::string&) {
+        count++;
+    });
+    EXPECT_EQ(count, 3);
+}
+
+TEST(Server, BufferPool) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    common::buffer_pool pool{512 * 1024};
+    EXPECT_EQ(pool.reserved(), 0) << "nothing until the first read";
+    auto* const one = pool.acquire();
+    auto* const two = pool.acquire();
+    ASSERT_NE(one, nullptr);
+    EXPECT_EQ(two, one + 512 * 1024) << "cut out of the same huge page";
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(one) % common::buffer_pool::huge_page_size, 0);
+    EXPECT_EQ(pool.reserved(), common::buffer_pool::huge_page_size);
+    EXPECT_EQ(pool.in_use(), 2);
+    EXPECT_EQ(pool.available(), 2);
+    pool.release(two);
+    EXPECT_EQ(pool.acquire(), two) << "the most recent one first";
+    pool.release(one);
+    pool.release(two);
+    EXPECT_EQ(pool.in_use(), 0);
+
+    boost::asio::io_context io;
+    tcp::acceptor           acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    tcp::socket             client{io};
+    client.connect(acceptor.local_endpoint());
+    common::connection conn{acceptor.accept()};
+    conn.read_buffers(pool);
+
+    std::size_t held = 0;
+    conn.start([] {},
+               [&](common::connection& c, std::string_view data) {
+                   held = pool.in_use();
+                   c.send(std::string{data});
+               });
+    io.run_for(20ms);
+    EXPECT_EQ(pool.in_use(), 0) << "the idle connection holds no buffer";
+
+    boost::asio::write(client, boost::asio::buffer(std::string_view{"ping"}));
+    io.run_for(50ms);
+    EXPECT_EQ(held, 1) << "it's borrowed while the data is handled";
+    EXPECT_EQ(pool.in_use(), 0) << "and given back after it";
+
+    std::string received(4, '\0');
+    boost::asio::read(client, boost::asio::buffer(received));
+    EXPECT_EQ(received, "ping");
+    conn.stop();
+    io.run_for(10ms);
+    EXPECT_EQ(pool.in_use(), 0);
+}
+
+TEST(Server, GracefulDrain) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    common::server srv{{tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}}, 100, 2};
+    srv.on_connection([] {
+        return [](common::connection& conn, std::string_view data) {
+            // "begin" starts a request and "end" finishes it
+            if (data == "begin") {
+                conn.busy(true);
+                conn.send("ok");
+            } else if (data == "end") {
+                conn.send("bye");
+                conn.busy(false);
+            }
+        };
+    });
+    auto const endpoint = srv.local_endpoints().front();
+
+    std::thread runner{[&] {
+        srv.run();
+    }};
+
+    boost::asio::io_context client_io;
+    tcp::socket             idle{client_io}, busy{client_io};
+    idle.connect(endpoint);
+    busy.connect(endpoint);
+    boost::asio::write(busy, boost::asio::buffer(std::string_view{"begin"}));
+    std::string started(2, '\0');
+    boost::asio::read(busy, boost::asio::buffer(started)); // it's busy once it's said so
+    EXPECT_EQ(started, "ok");
+    for (int i = 0; i < 100 && srv.connection_count() != 2; i++)
+        std::this_thread::sleep_for(10ms);
+
+    boost::asio::post(srv.io, [&] {
+        srv.drain(10s);
+    });
+
+    // the idle one is closed right away
+    char                      byte;
+    boost::system::error_code ec;
+    idle.read_some(boost::asio::buffer(&byte, 1), ec);
+    EXPECT_EQ(ec, boost::asio::error::eof);
+    for (int i = 0; i < 100 && srv.connection_count() != 1; i++)
+        std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(srv.connection_count(), 1);
+
+    // no new connections
+    tcp::socket late{client_io};
+    late.connect(endpoint, ec);
+    EXPECT_TRUE(ec);
+
+    // the busy one gets to finish its request
+    auto const start = std::chrono::steady_clock::now();
+    boost::asio::write(busy, boost::asio::buffer(std::string_view{"end"}));
+    std::string response(3, '\0');
+    boost::asio::read(busy, boost::asio::buffer(response));
+    EXPECT_EQ(response, "bye");
+    busy.read_some(boost::asio::buffer(&byte, 1), ec);
+    EXPECT_EQ(ec, boost::asio::error::eof);
+
+    runner.join();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+    EXPECT_EQ(srv.connection_count(), 0);
+}
+
+TEST(Server, DrainDeadline) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    common::server srv{{tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}}};
+    srv.on_connection([] {
+        return [](common::connection& conn, std::string_view) {
+            conn.busy(true); // it never finishes
+        };
+    });
+
+    boost::asio::io_context client_io;
+    tcp::socket             client{client_io};
+    client.connect(srv.local_endpoints().front());
+    boost::asio::write(client, boost::asio::buffer(std::string_view{"slow"}));
+    srv.io.run_for(50ms);
+    EXPECT_EQ(srv.connection_count(), 1);
+
+    auto const start = std::chrono::steady_clock::now();
+    srv.drain(100ms);
+    srv.run();
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 100ms);
+    EXPECT_EQ(srv.connection_count(), 0);
+
+    char                      byte;
+    boost::system::error_code ec;
+    client.read_some(boost::asio::buffer(&byte, 1), ec);
+    EXPECT_TRUE(ec);
+}
+
+TEST(Server, TimingWheel) {
+    common::timing_wheel wheel;
+
+    // across all the levels, so the timers should be cascaded down correctly
+    std::vector<uint64_t> const      delays{1, 2, 63, 64, 65, 100, 4095, 4096, 4097, 70000, 300000};
+    std::vector<common::timer_node>  nodes(delays.size());
+    std::vector<uint64_t>            fired(delays.size(), 0);
+    for (std::size_t i = 0; i < delays.size(); i++) {
+        nodes[i].on_expire = [&, i] {
+            fired[i] = wheel.now();
+        };
+        wheel.schedule(nodes[i], delays[i]);
+    }
+    EXPECT_EQ(wheel.size(), delays.size());
+
+    // cancel one, and push another one further
+    wheel.cancel(nodes[5]);
+    wheel.schedule(nodes[2], 200);
+    EXPECT_EQ(wheel.size(), delays.size() - 1);
+
+    while (!wheel.empty())
+        wheel.tick();
+    for (std::size_t i = 0; i < delays.size(); i++) {
+        if (i == 5) {
+            EXPECT_EQ(fired[i], 0);
+        } else if (i == 2) {
+            EXPECT_EQ(fired[i], 200);
+        } else {
+            EXPECT_EQ(fired[i], delays[i]) << "delay " << delays[i];
+        }
+    }
+
+    // a timer that reschedules itself
+    common::timer_node repeat;
+    int                count = 0;
+    repeat.on_expire         = [&] {
+        if (++count < 3)
+            wheel.schedule(repeat, 10);
+    };
+    auto const start = wheel.now();
+    wheel.schedule(repeat, 10);
+    while (!wheel.empty())
+        wheel.tick();
+    EXPECT_EQ(count, 3);
+    EXPECT_EQ(wheel.now() - start, 30);
+}
+
+TEST(Server, IdleTimeout) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    common::server srv{{tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}}};
+    srv.timeouts({.idle = 200ms, .read = 500ms, .write = 0ms});
+    srv.on_connection([] {
+        return [](common::connection& conn, std::string_view data) {
+            conn.busy(data == "begin");
+        };
+    });
+
+    boost::asio::io_context client_io;
+    tcp::socket             idle{client_io}, busy{client_io};
+    idle.connect(srv.local_endpoints().front());
+    busy.connect(srv.local_endpoints().front());
+    boost::asio::write(busy, boost::asio::buffer(std::string_view{"begin"}));
+    srv.io.run_for(100ms);
+    EXPECT_EQ(srv.connection_count(), 2);
+
+    // the idle one is closed after its idle timeout, but the half-read
+    // request gets the longer read timeout
+    srv.io.run_for(250ms);
+    EXPECT_EQ(srv.connection_count(), 1);
+    srv.io.run_for(400ms);
+    EXPECT_EQ(srv.connection_count(), 0);
+
+    char                      byte;
+    boost::system::error_code ec;
+    idle.read_some(boost::asio::buffer(&byte, 1), ec);
+    EXPECT_TRUE(ec);
+    busy.read_some(boost::asio::buffer(&byte, 1), ec);
+    EXPECT_TRUE(ec);
+
+    // the asio timer doesn't keep the io_context busy when there's nothing
+    // to time
+    srv.stop();
+    srv.io.restart();
+    auto const start = std::chrono::steady_clock::now();
+    srv.io.run();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 1s);
+}
+
+TEST(Server, ReloadLimits) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    common::server srv{{tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}}, 1};
+    auto const     endpoint = srv.local_endpoints().front();
+
+    boost::asio::io_context client_io;
+    tcp::socket             one{client_io}, two{client_io};
+    one.connect(endpoint);
+    two.connect(endpoint);
+    srv.io.run_for(50ms);
+    EXPECT_EQ(srv.connection_count(), 1);
+
+    // raising the limit lets the paused acceptor take the waiting one
+    srv.reload(config_snapshot{{{"server.max_connections", "2"}, {"server.idle_timeout_ms", "500"}}});
+    EXPECT_EQ(srv.max_connection_count(), 2);
+    EXPECT_EQ(srv.timeouts().idle, 500ms);
+    EXPECT_EQ(srv.timeouts().read, common::connection_timeouts{}.read) << "the missing ones stay as they are";
+    srv.io.run_for(50ms);
+    EXPECT_EQ(srv.connection_count(), 2);
+
+    // the new connections get the new idle timeout
+    srv.io.run_for(800ms);
+    EXPECT_EQ(srv.connection_count(), 1);
+    srv.stop();
+}
+
+#ifdef __unix__
+TEST(Server, ReloadOnHangup) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    common::server srv{{tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}}};
+    int            hangups = 0;
+    srv.on_hangup([&] {
+        ++hangups;
+    });
+    ::raise(SIGHUP);
+    srv.io.run_for(50ms);
+    EXPECT_EQ(hangups, 1);
+    ::raise(SIGHUP);
+    srv.io.run_for(50ms);
+    EXPECT_EQ(hangups, 2);
+    srv.stop();
+}
+#endif
+
+#ifdef __unix__
+TEST(Server, ListenerHandoff) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    auto const path = std::string{"/tmp/webpp_handoff_test_"} + std::to_string(::getpid());
+    common::server old_srv{{tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}}};
+    auto const     endpoint = old_srv.local_endpoints().front();
+    ASSERT_TRUE(old_srv.serve_handoff(path, 1s));
+    std::thread runner{[&] {
+        old_srv.run(); // returns when it has handed off and drained
+    }};
+
+    auto const handles = common::receive_listeners(path);
+    ASSERT_EQ(handles.size(), 1);
+    runner.join();
+
+    common::server new_srv{{}};
+    ASSERT_TRUE(new_srv.adopt(handles.front()));
+    ASSERT_EQ(new_srv.local_endpoints().size(), 1);
+    EXPECT_EQ(new_srv.local_endpoints().front(), endpoint);
+
+    // the port was never closed
+    boost::asio::io_context client_io;
+    tcp::socket             client{client_io};
+    client.connect(endpoint);
+    new_srv.io.run_for(50ms);
+    EXPECT_EQ(new_srv.connection_count(), 1);
+    new_srv.stop();
+}
+#endif
+
+#ifdef __unix__
+namespace {
+    // the workers tell the test what they did through a pipe
+    std::string read_all(int fd) {
+        std::string res;
+        char        buf[64];
+        ssize_t     count = 0;
+        while ((count = ::read(fd, buf, sizeof(buf))) > 0)
+            res.append(buf, static_cast<std::size_t>(count));
+        return res;
+    }
+} // namespace
+
+TEST(Prefork, Workers) {
+    using tcp = boost::asio::ip::tcp;
+
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    common::prefork supervisor{{.workers = 3, .pin = false}};
+    ASSERT_TRUE(supervisor.listen(std::vector{tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}}));
+    ASSERT_EQ(supervisor.local_endpoints().size(), 1);
+    EXPECT_NE(supervisor.local_endpoints().front().port(), 0);
+
+    auto const result = supervisor.run([&](common::prefork_worker const& worker) {
+        char const c = worker.listeners.size() == 1 ? static_cast<char>('0' + worker.index) : 'x';
+        return ::write(fds[1], &c, 1) == 1 ? 0 : 1;
+    });
+    ::close(fds[1]);
+    auto spawned = read_all(fds[0]);
+    ::close(fds[0]);
+    std::sort(spawned.begin(), spawned.end());
+    EXPECT_EQ(result, 0);
+    EXPECT_EQ(spawned, "012");
+}
+
+TEST(Prefork, RestartCrashedWorker) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    common::prefork supervisor{{.workers = 2, .pin = false, .restart_delay = 10ms}};
+    ASSERT_TRUE(supervisor.listen(std::vector{tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}}));
+    auto const result = supervisor.run([&](common::prefork_worker const& worker) {
+        if (worker.index == 1 && worker.restarts == 0)
+            ::kill(::getpid(), SIGKILL); // crashes the first time
+        char const c = static_cast<char>('0' + worker.restarts);
+        return ::write(fds[1], &c, 1) == 1 ? 0 : 1;
+    });
+    ::close(fds[1]);
+    auto restarts = read_all(fds[0]);
+    ::close(fds[0]);
+    std::sort(restarts.begin(), restarts.end());
+    EXPECT_EQ(result, 0);
+    EXPECT_EQ(restarts, "01");
+}
+
+TEST(Prefork, Stop) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    common::prefork supervisor{{.workers = 2, .pin = false, .stop_timeout = 2s}};
+    ASSERT_TRUE(supervisor.listen(std::vector{tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}}));
+    std::thread stopper{[&] {
+        std::this_thread::sleep_for(100ms);
+        supervisor.stop();
+    }};
+    auto const result = supervisor.run([](common::prefork_worker const&) {
+        for (;;)
+            ::pause(); // until the SIGTERM
+        return 0;
+    });
+    stopper.join();
+    EXPECT_EQ(result, SIGTERM);
+}
+#endif
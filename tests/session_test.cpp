@@ -0,0 +1,247 @@
+#include "../core/include/webpp/http/modules/session.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace webpp;
+using namespace std::chrono_literals;
+
+namespace {
+    // a clock that's moved by the tests
+    struct manual_clock {
+        using duration   = std::chrono::steady_clock::duration;
+        using rep        = duration::rep;
+        using period     = duration::period;
+        using time_point = std::chrono::time_point<manual_clock>;
+
+        static constexpr bool is_steady = true;
+        static inline time_point current{};
+
+        static time_point now() noexcept {
+            return current;
+        }
+    };
+
+    // an adapter that's slow to write to, like a database
+    struct slow_adapter {
+        using value_type = std::string;
+
+        std::mutex                                       lock;
+        std::vector<std::pair<std::string, std::string>> writes;
+        std::atomic<bool>                                blocked{false};
+        std::atomic<int>                                 entered{0};
+
+        void set(std::string_view id, std::string value) {
+            entered++;
+            while (blocked)
+                std::this_thread::sleep_for(1ms);
+            std::scoped_lock const guard{lock};
+            writes.emplace_back(id, std::move(value));
+        }
+
+        std::optional<std::string> get(std::string_view id) {
+            std::scoped_lock const guard{lock};
+            for (auto it = writes.rbegin(); it != writes.rend(); ++it)
+                if (it->first == id)
+                    return it->second;
+            return std::nullopt;
+        }
+    };
+
+    // an adapter that counts what's done to it
+    struct counting_adapter : memory_adapter {
+        using memory_adapter::memory_adapter;
+
+        int gets   = 0;
+        int sets   = 0;
+        int erases = 0;
+
+        std::optional<std::string> get(std::string_view id) {
+            gets++;
+            return memory_adapter::get(id);
+        }
+
+        void set(std::string_view id, std::string value) {
+            sets++;
+            memory_adapter::set(id, std::move(value));
+        }
+
+        bool erase(std::string_view id) {
+            erases++;
+            return memory_adapter::erase(id);
+        }
+    };
+} // namespace
+
+TEST(MemoryAdapter, Sessions) {
+    basic_memory_adapter<std::string, manual_clock> sessions{30min, manual_clock::duration::zero()};
+    EXPECT_FALSE(sessions.get("nope"));
+
+    sessions.set("a", "alpha");
+    sessions.set("b", "beta", 5min);
+    EXPECT_EQ(sessions.size(), 2);
+    EXPECT_EQ(sessions.get("a"), "alpha");
+    sessions.set("a", "again");
+    EXPECT_EQ(sessions.get("a"), "again");
+    EXPECT_EQ(sessions.size(), 2);
+
+    std::size_t size = 0;
+    EXPECT_TRUE(sessions.visit("b", [&](std::string const& value) {
+        size = value.size();
+    }));
+    EXPECT_EQ(size, 4);
+
+    manual_clock::current += 6min;
+    EXPECT_FALSE(sessions.get("b")) << "it's expired";
+    EXPECT_FALSE(sessions.touch("b"));
+    EXPECT_EQ(sessions.size(), 2) << "it's not swept yet";
+    EXPECT_EQ(sessions.sweep(), 1);
+    EXPECT_EQ(sessions.size(), 1);
+
+    manual_clock::current += 20min;
+    EXPECT_TRUE(sessions.touch("a"));
+    manual_clock::current += 20min;
+    EXPECT_EQ(sessions.get("a"), "again") << "it's extended";
+    EXPECT_TRUE(sessions.erase("a"));
+    EXPECT_FALSE(sessions.erase("a"));
+    EXPECT_EQ(sessions.size(), 0);
+
+    for (int i = 0; i < 1000; i++)
+        sessions.set("id" + std::to_string(i), "value");
+    EXPECT_EQ(sessions.size(), 1000);
+    sessions.clear();
+    EXPECT_EQ(sessions.size(), 0);
+}
+
+TEST(MemoryAdapter, Sweeper) {
+    memory_adapter sessions{1ms, 1ms};
+    for (int i = 0; i < 100; i++)
+        sessions.set("id" + std::to_string(i), "value");
+    for (int i = 0; i < 500 && sessions.size() != 0; i++)
+        std::this_thread::sleep_for(2ms);
+    EXPECT_EQ(sessions.size(), 0);
+}
+
+TEST(MemoryAdapter, Threads) {
+    memory_adapter           sessions;
+    std::vector<std::thread> threads;
+    std::vector<int>         misses(4, 0);
+    for (std::size_t t = 0; t < misses.size(); t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 5'000; i++) {
+                auto const id = std::to_string(t) + "-" + std::to_string(i);
+                sessions.set(id, id);
+                if (sessions.get(id) != id)
+                    misses[t]++;
+                if (i % 2 == 0)
+                    sessions.erase(id);
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    for (auto const miss : misses)
+        EXPECT_EQ(miss, 0);
+    EXPECT_EQ(sessions.size(), misses.size() * 2'500);
+}
+
+TEST(Session, SharedAdapter) {
+    auto store = std::make_shared<memory_adapter>();
+    store->set("session-id", "data");
+    session<> first{store};
+    session<> second{store};
+    EXPECT_EQ(first.get("session-id"), "data");
+    second.server_adapter().set("other", "more");
+    EXPECT_EQ(first.get("other"), "more");
+}
+
+TEST(Session, Writer) {
+    auto adapter = std::make_shared<slow_adapter>();
+    {
+        auto writer = std::make_shared<session_writer<slow_adapter>>(*adapter, 4);
+        session<slow_adapter> sessions{adapter, nullptr, writer};
+        adapter->blocked = true;
+        sessions.set("a", "1");
+        for (int i = 0; i < 1000 && adapter->entered == 0; i++)
+            std::this_thread::sleep_for(1ms);
+
+        // the writer is stuck on "a"; the queue fills up, then the requests write the sessions themselves
+        sessions.set("a", "2");
+        sessions.set("a", "3"); // replaces the queued one
+        EXPECT_TRUE(writer->push("b", "1"));
+        EXPECT_TRUE(writer->push("c", "1"));
+        EXPECT_TRUE(writer->push("d", "1"));
+        EXPECT_FALSE(writer->push("e", "1")) << "the queue is full";
+        adapter->blocked = false;
+        writer->flush();
+        EXPECT_EQ(writer->size(), 0);
+        EXPECT_EQ(sessions.get("a"), "3");
+        EXPECT_EQ(sessions.get("d"), "1");
+        EXPECT_FALSE(sessions.get("e"));
+
+        adapter->blocked = true;
+        sessions.set("g", "1");
+        adapter->blocked = false;
+    }
+    EXPECT_EQ(adapter->get("g"), "1") << "the queue is written before the writer is destroyed";
+    EXPECT_EQ(adapter->entered, 6);
+}
+
+TEST(Session, Lazy) {
+    auto                      store = std::make_shared<counting_adapter>();
+    session<counting_adapter> sessions{store};
+    store->memory_adapter::set("a", "alpha");
+
+    {
+        auto data = sessions.open("a");
+        EXPECT_FALSE(data.is_loaded());
+    }
+    EXPECT_EQ(store->gets + store->sets, 0) << "an unused session costs nothing";
+
+    {
+        auto data = sessions.open("a");
+        EXPECT_EQ(data.value(), "alpha");
+        EXPECT_TRUE(data.has_value());
+        EXPECT_FALSE(data.is_dirty());
+    }
+    EXPECT_EQ(store->gets, 1) << "it's read once";
+    EXPECT_EQ(store->sets, 0) << "it's not changed, so it's not written";
+
+    {
+        auto data = sessions.open("a");
+        data.mutate() += "!";
+        EXPECT_TRUE(data.is_dirty());
+    }
+    EXPECT_EQ(store->gets, 2);
+    EXPECT_EQ(store->sets, 1);
+    EXPECT_EQ(sessions.get("a"), "alpha!");
+
+    auto const gets = store->gets;
+    {
+        auto data = sessions.open("b");
+        data.set("beta");
+        auto moved = std::move(data);
+        moved.save();
+        EXPECT_FALSE(moved.is_dirty());
+    }
+    EXPECT_EQ(store->gets, gets) << "the session that's replaced is not read";
+    EXPECT_EQ(store->sets, 2) << "and it's written once";
+
+    {
+        auto data = sessions.open("a");
+        data.erase();
+    }
+    EXPECT_EQ(store->erases, 1);
+    EXPECT_FALSE(sessions.open("a").has_value());
+
+    {
+        auto data = sessions.open("new");
+        data.mutate() = "created";
+    }
+    EXPECT_EQ(sessions.get("new"), "created");
+}
@@ -0,0 +1,134 @@
+#include "../core/include/webpp/http/bodies/file.hpp"
+#include "../core/include/webpp/http/response.hpp"
+#include "../core/include/webpp/http/static_file_cache.hpp"
+#include "../core/include/webpp/traits/std_traits.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+
+using namespace webpp;
+
+namespace {
+    using file_response_type =
+      basic_response<std_traits, empty_extension_pack, response_headers<std_traits>, file_body::type<std_traits>>;
+
+    void write_file(std::filesystem::path const& path, std::string const& content) {
+        std::ofstream out{path, std::ios::binary | std::ios::trunc};
+        out << content;
+    }
+} // namespace
+
+TEST(StaticFileCache, MimeTypes) {
+    EXPECT_EQ(mime_type_of("/a/b/style.css"), "text/css; charset=utf-8");
+    EXPECT_EQ(mime_type_of("logo.PNG"), "image/png");
+    EXPECT_EQ(mime_type_of("archive.tar.unknown"), "application/octet-stream");
+    EXPECT_EQ(mime_type_of("/a.dir/README"), "application/octet-stream");
+    EXPECT_EQ(mime_type_of("font.WOFF2"), "font/woff2");
+    EXPECT_EQ(mime_type_of("song.mp3"), "audio/mpeg");
+    EXPECT_EQ(mime_type_of("trailing."), "application/octet-stream");
+    static_assert(mime_type_of("app.webmanifest") == "application/manifest+json");
+}
+
+TEST(StaticFileCache, FileBodyContentType) {
+    auto const path = std::filesystem::temp_directory_path() / "webpp_static_file_cache_test.svg";
+    write_file(path, "<svg/>");
+
+    file_response_type res{200u};
+    res.body = file_body::type<std_traits>{path};
+    EXPECT_EQ(res.body.content_type(), "image/svg+xml");
+    res.calculate_default_headers();
+    EXPECT_NE(res.header.str().find("Content-Type: image/svg+xml"), std::string::npos);
+
+    file_response_type empty{200u};
+    empty.calculate_default_headers();
+    EXPECT_NE(empty.header.str().find("text/html"), std::string::npos) << "it's not a file";
+    std::filesystem::remove(path);
+}
+
+TEST(StaticFileCache, LoadOnce) {
+    auto const path = std::filesystem::temp_directory_path() / "webpp_static_file_cache_test.css";
+    write_file(path, "body { color: red; }");
+
+    static_file_cache cache;
+    auto const        file = cache.get(path);
+    ASSERT_NE(file, nullptr);
+    EXPECT_EQ(file->content(), "body { color: red; }");
+    EXPECT_EQ(file->content_length(), "20");
+    EXPECT_EQ(file->content_type(), "text/css; charset=utf-8");
+    EXPECT_EQ(file->etag().front(), '"');
+    EXPECT_EQ(cache.get(path), file) << "it should come from the cache";
+    EXPECT_EQ(cache.size(), 1);
+
+    // the responses point into the cached file
+    auto res = file_response<file_response_type>(cache, path);
+    EXPECT_EQ(res.header.status_code, 200);
+    EXPECT_EQ(res.body.cached_file(), file);
+    EXPECT_EQ(res.body.view().data(), file->content().data());
+    EXPECT_EQ(res.body.str(), "body { color: red; }");
+    EXPECT_TRUE(res.header.contains(well_known_header::etag));
+    res.calculate_default_headers();
+    EXPECT_EQ(res.header.str().find("text/html"), std::string::npos);
+
+    // the files that are too big are not cached, they're sent from the disk
+    static_file_cache small{{.max_file_size = 4}};
+    EXPECT_EQ(small.get(path), nullptr);
+    auto big = file_response<file_response_type>(small, path);
+    EXPECT_NE(big.body.native_handle(), -1);
+    EXPECT_EQ(big.body.size(), 20);
+
+    EXPECT_EQ(file_response<file_response_type>(cache, "/nonexistent/file.css").header.status_code, 404);
+    std::filesystem::remove(path);
+}
+
+TEST(StaticFileCache, ReloadLimits) {
+    auto const path = std::filesystem::temp_directory_path() / "webpp_static_file_cache_limits.css";
+    write_file(path, "body { color: red; }");
+
+    static_file_cache cache;
+    ASSERT_NE(cache.get(path), nullptr);
+    EXPECT_EQ(cache.size(), 1);
+
+    // a smaller limit drops the cached file that's too big for it
+    cache.reload(config_snapshot{{{"static_files.max_file_size", "4"}}});
+    EXPECT_EQ(cache.limits().max_file_size, 4);
+    EXPECT_EQ(cache.limits().max_entries, 1024) << "the missing ones stay as they are";
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(cache.get(path), nullptr);
+
+    cache.reload(config_snapshot{{{"static_files.max_file_size", "1024"}, {"static_files.max_entries", "0"}}});
+    EXPECT_NE(cache.get(path), nullptr);
+    EXPECT_EQ(cache.size(), 0) << "nothing is kept with no entries";
+    std::filesystem::remove(path);
+}
+
+TEST(StaticFileCache, Invalidation) {
+    using namespace std::chrono_literals;
+
+    auto const path = std::filesystem::temp_directory_path() / "webpp_static_file_cache_test.txt";
+    write_file(path, "one");
+
+    static_file_cache cache{{.refresh_interval = 0s}};
+    if (cache.native_handle() == -1)
+        GTEST_SKIP() << "inotify is not available";
+    auto const first = cache.get(path);
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(first->content(), "one");
+
+    write_file(path, "two!");
+    auto second = cache.get(path);
+    for (int i = 0; i < 100 && second == first; i++) {
+        std::this_thread::sleep_for(1ms);
+        second = cache.get(path);
+    }
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(second->content(), "two!");
+    EXPECT_EQ(first->content(), "one") << "the old one lives as long as someone has it";
+
+    cache.invalidate(path);
+    EXPECT_EQ(cache.size(), 0);
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,73 @@
+#include "../core/include/webpp/traits/std_pmr_traits.hpp"
+
+#include "../core/include/webpp/http/bodies/string.hpp"
+#include "../core/include/webpp/http/cookies/cookie_jar.hpp"
+#include "../core/include/webpp/http/interfaces/fcgi.hpp"
+#include "../core/include/webpp/http/response.hpp"
+#include "../core/include/webpp/http/routes/router.hpp"
+#include "../core/include/webpp/traits/traits_concepts.hpp"
+
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+
+using namespace webpp;
+
+static_assert(Traits<std_pmr_traits>);
+static_assert(stl::same_as<std_pmr_traits::string_type, stl::pmr::string>);
+static_assert(stl::same_as<std_pmr_traits_from<stl::string_view>::type, std_pmr_traits>);
+
+namespace {
+    struct pmr_app {};
+
+    using pmr_request = basic_request<std_pmr_traits, fcgi<std_pmr_traits, pmr_app>>;
+
+    struct fake_pmr_request {
+        fastcgi::request source;
+        pmr_request      req{source};
+
+        fake_pmr_request(std::string_view uri) {
+            source.params += char(11);
+            source.params += char(uri.size());
+            source.params += "REQUEST_URI";
+            source.params += uri;
+        }
+    };
+} // namespace
+
+TEST(PmrTraits, Response) {
+    using pmr_response = basic_response<std_pmr_traits, empty_extension_pack, response_headers<std_pmr_traits>,
+                                        string_body::type<std_pmr_traits>>;
+    pmr_response res{200u, "hello"};
+    res.calculate_default_headers();
+    EXPECT_EQ(res.body.str(), "hello");
+    EXPECT_NE(res.header.str().find("Content-Length: 5"), std::string::npos);
+}
+
+TEST(PmrTraits, CookieJar) {
+    response_cookie_jar<std_pmr_traits> jar;
+    jar.emplace_back("one", "value");
+    jar.emplace_back("two", "value 2");
+    jar.emplace_back("one", "value 3");
+    jar.remove_duplicates();
+    EXPECT_EQ(jar.size(), 2);
+    EXPECT_EQ(jar.find("two")->value(), "value 2");
+}
+
+TEST(PmrTraits, Router) {
+    router _router{[](Context auto& ctx) noexcept -> std::optional<std::string_view> {
+        if (ctx.request->request_uri() == "/about")
+            return "about";
+        return std::nullopt;
+    }};
+
+    fake_pmr_request about{"/about"};
+    auto             res = _router(about.req);
+    EXPECT_EQ(res.header.status_code, 200);
+    EXPECT_EQ(res.body.str(), "about");
+
+    fake_pmr_request nowhere{"/nowhere"};
+    EXPECT_EQ(_router(nowhere.req).header.status_code, 404);
+}
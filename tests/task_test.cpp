@@ -0,0 +1,89 @@
+#include "../core/include/webpp/utils/task.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace webpp;
+
+namespace {
+
+    /**
+     * Something that the tasks wait for, like a reply from a database; the
+     * test resumes the waiting coroutine by hand.
+     */
+    struct fake_upstream {
+        std::coroutine_handle<> waiting{};
+        int                     reply = 0;
+
+        auto wait() noexcept {
+            struct awaiter {
+                fake_upstream& self;
+
+                bool await_ready() const noexcept {
+                    return false;
+                }
+
+                void await_suspend(std::coroutine_handle<> h) noexcept {
+                    self.waiting = h;
+                }
+
+                int await_resume() const noexcept {
+                    return self.reply;
+                }
+            };
+            return awaiter{*this};
+        }
+
+        void respond(int value) noexcept {
+            reply = value;
+            std::exchange(waiting, {}).resume();
+        }
+    };
+
+    task<int> query(fake_upstream& db) {
+        co_return co_await db.wait() * 2;
+    }
+
+    task<std::string> render(fake_upstream& db) {
+        auto const a = co_await query(db);
+        auto const b = co_await task<int>::ready(1);
+        co_return std::to_string(a + b);
+    }
+
+} // namespace
+
+TEST(Task, Ready) {
+    auto t = task<int>::ready(42);
+    EXPECT_TRUE(t.done());
+    int result = 0;
+    std::move(t).start([&](int value) {
+        result = value;
+    });
+    EXPECT_EQ(result, 42);
+}
+
+TEST(Task, SuspendAndResume) {
+    fake_upstream db;
+    std::string   result;
+    render(db).start([&](std::string value) {
+        result = std::move(value);
+    });
+    EXPECT_TRUE(result.empty()); // waiting for the upstream
+    ASSERT_TRUE(db.waiting);
+    db.respond(20);
+    EXPECT_EQ(result, "41");
+    EXPECT_FALSE(db.waiting);
+}
+
+TEST(Task, Void) {
+    fake_upstream db;
+    bool          done = false;
+    [](fake_upstream& db) -> task<> {
+        co_await db.wait();
+    }(db).start([&] {
+        done = true;
+    });
+    EXPECT_FALSE(done);
+    db.respond(0);
+    EXPECT_TRUE(done);
+}
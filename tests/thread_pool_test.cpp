@@ -0,0 +1,411 @@
+#include "../core/include/webpp/utils/thread_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <gtest/gtest.h>
+#include <latch>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace webpp;
+
+TEST(ThreadPool, WorkStealingDeque) {
+    details::work_stealing_deque<int*> deque{4};
+    std::vector<int>                   items(10'000);
+    EXPECT_EQ(deque.pop(), nullptr);
+    EXPECT_EQ(deque.steal(), nullptr);
+    deque.push(&items[0]);
+    deque.push(&items[1]);
+    EXPECT_EQ(deque.steal(), &items[0]) << "the thieves take the oldest one";
+    EXPECT_EQ(deque.pop(), &items[1]) << "the owner takes the newest one";
+    EXPECT_EQ(deque.pop(), nullptr);
+
+    // every item is taken once, by the owner or by one of the thieves
+    std::vector<std::atomic<int>> taken(items.size());
+    std::atomic<bool>             done{false};
+    std::vector<std::thread>      thieves;
+    for (int t = 0; t < 3; t++) {
+        thieves.emplace_back([&] {
+            while (!done) {
+                if (auto* item = deque.steal())
+                    taken[static_cast<std::size_t>(item - items.data())]++;
+            }
+        });
+    }
+    for (std::size_t i = 0; i < items.size(); i++) {
+        deque.push(&items[i]); // it grows from 4
+        if (i % 3 == 0)
+            if (auto* item = deque.pop())
+                taken[static_cast<std::size_t>(item - items.data())]++;
+    }
+    while (auto* item = deque.pop())
+        taken[static_cast<std::size_t>(item - items.data())]++;
+    while (deque.size() != 0)
+        std::this_thread::yield();
+    done = true;
+    for (auto& thief : thieves)
+        thief.join();
+    for (auto const& count : taken)
+        EXPECT_EQ(count, 1);
+}
+
+TEST(ThreadPool, Post) {
+    thread_pool pool{4};
+    EXPECT_EQ(pool.size(), 4);
+    EXPECT_EQ(pool.current_index(), static_cast<std::size_t>(-1));
+
+    std::atomic<int> sum{0};
+    std::latch       done{1000};
+    for (int i = 1; i <= 1000; i++) {
+        pool.post([&, i] {
+            sum += i;
+            done.count_down();
+        });
+    }
+    done.wait();
+    EXPECT_EQ(sum, 500'500);
+
+    // the tasks that the tasks post go to the deques of the workers, and the idle ones steal them
+    std::atomic<int>               leaves{0};
+    std::latch                     tree{1 << 10};
+    std::function<void(int)> const spawn = [&](int depth) {
+        if (depth == 0) {
+            leaves++;
+            tree.count_down();
+            return;
+        }
+        pool.post([&, depth] {
+            spawn(depth - 1);
+        });
+        pool.post([&, depth] {
+            spawn(depth - 1);
+        });
+    };
+    spawn(10);
+    tree.wait();
+    EXPECT_EQ(leaves, 1 << 10);
+}
+
+TEST(ThreadPool, Submit) {
+    thread_pool pool{2};
+    auto        answer = pool.submit([] {
+        return 42;
+    });
+    auto        failed = pool.submit([]() -> int {
+        throw std::runtime_error{"failed"};
+    });
+    EXPECT_EQ(answer.get(), 42);
+    EXPECT_THROW(failed.get(), std::runtime_error);
+
+    // move-only ones too
+    auto value = std::make_unique<int>(7);
+    auto moved = pool.submit([value = std::move(value)] {
+        return *value;
+    });
+    EXPECT_EQ(moved.get(), 7);
+
+    // the worker is still there after an exception that nobody waited for
+    pool.post([] {
+        throw std::runtime_error{"dropped"};
+    });
+    EXPECT_EQ(pool.submit([] {
+                      return 1;
+                  }).get(),
+              1);
+}
+
+TEST(ThreadPool, Affinity) {
+    thread_pool              pool{3};
+    std::vector<std::size_t> ran_on(30);
+    std::latch               done{30};
+    for (std::size_t i = 0; i < ran_on.size(); i++) {
+        pool.post_to(i, [&, i] {
+            ran_on[i] = pool.current_index();
+            done.count_down();
+        });
+    }
+    done.wait();
+    for (std::size_t i = 0; i < ran_on.size(); i++)
+        EXPECT_EQ(ran_on[i], i % 3);
+
+    // dispatch runs right away on a worker
+    auto inline_run = pool.submit([&pool] {
+        bool ran = false;
+        pool.dispatch([&ran] {
+            ran = true;
+        });
+        return ran;
+    });
+    EXPECT_TRUE(inline_run.get());
+}
+
+TEST(ThreadPool, SleepingWorkers) {
+    using namespace std::chrono_literals;
+    thread_pool pool{4};
+    for (int round = 0; round < 20; round++) {
+        std::this_thread::sleep_for(2ms); // they're all asleep by now
+        std::array<std::size_t, 8> ran_on{};
+        std::latch                 done{ran_on.size()};
+        for (std::size_t i = 0; i < ran_on.size(); i++) {
+            // only its worker is woken up for it, and nobody else can run it
+            pool.post_to(i, [&, i] {
+                ran_on[i] = pool.current_index();
+                done.count_down();
+            });
+        }
+        done.wait();
+        for (std::size_t i = 0; i < ran_on.size(); i++)
+            EXPECT_EQ(ran_on[i], i % 4);
+
+        // and one of them is woken up for the others
+        pool.submit([] {}).wait();
+    }
+}
+
+TEST(ThreadPool, PauseAndStop) {
+    using namespace std::chrono_literals;
+    std::atomic<int> count{0};
+    {
+        thread_pool pool{2};
+        pool.pause();
+        EXPECT_TRUE(pool.is_paused());
+        for (int i = 0; i < 100; i++) {
+            pool.post([&count] {
+                count++;
+            });
+        }
+        std::this_thread::sleep_for(20ms);
+        EXPECT_EQ(count, 0);
+        pool.resume();
+        auto const last = pool.submit([] {});
+        last.wait();
+
+        pool.pause();
+        for (int i = 0; i < 100; i++) {
+            pool.post([&count] {
+                count++;
+            });
+        }
+    } // the queued ones are run before the workers are joined
+    EXPECT_EQ(count, 200);
+}
+
+TEST(ThreadPool, MPMCRing) {
+    details::mpmc_ring<int*> ring{3}; // rounded up to 4
+    std::vector<int>         items(40'000);
+    int*                     item = nullptr;
+    EXPECT_FALSE(ring.try_pop(item));
+    for (std::size_t i = 0; i < 4; i++)
+        EXPECT_TRUE(ring.try_push(&items[i]));
+    EXPECT_FALSE(ring.try_push(&items[4])) << "it's full";
+    EXPECT_TRUE(ring.try_pop(item));
+    EXPECT_EQ(item, &items[0]);
+    while (ring.try_pop(item)) {}
+
+    // every item is taken once
+    std::vector<std::atomic<int>> taken(items.size());
+    std::atomic<std::size_t>      popped{0};
+    std::vector<std::thread>      threads;
+    for (std::size_t p = 0; p < 2; p++) {
+        threads.emplace_back([&, p] {
+            for (std::size_t i = p; i < items.size(); i += 2)
+                while (!ring.try_push(&items[i]))
+                    std::this_thread::yield();
+        });
+        threads.emplace_back([&] {
+            int* got = nullptr;
+            while (popped < items.size()) {
+                if (ring.try_pop(got)) {
+                    taken[static_cast<std::size_t>(got - items.data())]++;
+                    popped++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    for (auto const& count : taken)
+        EXPECT_EQ(count, 1);
+}
+
+TEST(ThreadPool, RegisteredTasks) {
+    thread_pool      pool{3};
+    std::atomic<int> sum{0};
+    std::latch       done{2000};
+    auto             add = pool.register_task<int, std::string>(
+      [&](int value, std::string const& str) {
+          sum += value + static_cast<int>(str.size());
+          done.count_down();
+      },
+      16);
+    EXPECT_TRUE(add);
+    EXPECT_EQ(add.available(), 16);
+
+    // more than the capacity at a time; the rest are allocated
+    pool.pause();
+    for (int i = 1; i <= 1000; i++)
+        pool.post(add, i, std::string{"ab"});
+    EXPECT_EQ(add.available(), 0);
+    pool.resume();
+
+    // from the workers too
+    for (int i = 1; i <= 1000; i++) {
+        pool.post([&, i] {
+            pool.post(add, i, "");
+        });
+    }
+    done.wait();
+    EXPECT_EQ(sum, 2 * 500'500 + 2000);
+
+    // the tasks go back to it after they're run
+    pool.submit([] {}).wait();
+    auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+    while (add.available() != 16 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::yield();
+    EXPECT_EQ(add.available(), 16);
+
+    // and to a specific worker
+    std::vector<std::size_t> ran_on(9);
+    std::latch               placed{9};
+    auto                     place = pool.register_task<std::size_t>([&](std::size_t i) {
+        ran_on[i] = pool.current_index();
+        placed.count_down();
+    });
+    for (std::size_t i = 0; i < ran_on.size(); i++)
+        pool.post_to(i, place, i);
+    placed.wait();
+    for (std::size_t i = 0; i < ran_on.size(); i++)
+        EXPECT_EQ(ran_on[i], i % 3);
+}
+
+TEST(ThreadPool, Priorities) {
+    thread_pool       pool{1};
+    std::vector<char> order;
+    std::latch        done{30};
+    std::array const  lanes{task_priority::background, task_priority::normal, task_priority::interactive};
+    std::array const  names{'b', 'n', 'i'};
+    pool.pause();
+    for (std::size_t lane = 0; lane < lanes.size(); lane++) {
+        for (int i = 0; i < 10; i++) {
+            pool.post(lanes[lane], [&, name = names[lane]] {
+                order.push_back(name);
+                done.count_down();
+            });
+        }
+    }
+    pool.resume();
+    done.wait();
+
+    auto const first = [&](char name) {
+        return std::find(order.begin(), order.end(), name) - order.begin();
+    };
+    auto const last = [&](char name) {
+        return order.rend() - std::find(order.rbegin(), order.rend(), name) - 1;
+    };
+    EXPECT_EQ(order.front(), 'i');
+    EXPECT_LT(last('i'), last('n'));
+    EXPECT_LT(last('n'), last('b'));
+    // the lower lanes get a turn now and then
+    EXPECT_LT(first('n'), 10);
+    EXPECT_LT(first('b'), 20);
+
+    // the background tasks don't take all of the workers
+    thread_pool                    busy{2};
+    std::latch                     release{1};
+    std::atomic<int>               running{0};
+    std::vector<std::future<void>> blocked;
+    for (int i = 0; i < 2; i++) {
+        blocked.push_back(busy.submit(task_priority::background, [&] {
+            running++;
+            release.wait();
+        }));
+    }
+    while (running == 0)
+        std::this_thread::yield();
+    auto const answer = busy.submit(task_priority::interactive, [] {
+        return 42;
+    });
+    EXPECT_EQ(answer.wait_for(std::chrono::seconds{5}), std::future_status::ready);
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    EXPECT_EQ(running, 1) << "the other one waits for a worker to be free";
+    release.count_down();
+    for (auto& task : blocked)
+        task.wait();
+    EXPECT_EQ(running, 2);
+}
+
+TEST(ThreadPool, KeyedAffinity) {
+    thread_pool pool{4};
+    EXPECT_EQ(pool.worker_of(std::string{"session"}), pool.worker_of(std::string_view{"session"}));
+    EXPECT_LT(pool.worker_of(42), pool.size());
+
+    // the tasks of a key run in order on its worker, and its state needs no locks
+    struct session {
+        std::vector<int>         steps;
+        std::vector<std::size_t> ran_on;
+    };
+    std::array<session, 3> sessions{};
+    std::latch             done{3 * 500};
+    for (int step = 0; step < 500; step++) {
+        for (std::size_t key = 0; key < sessions.size(); key++) {
+            pool.post_keyed(key, [&, key, step] {
+                sessions[key].steps.push_back(step);
+                sessions[key].ran_on.push_back(pool.current_index());
+                done.count_down();
+            });
+        }
+    }
+    done.wait();
+    for (std::size_t key = 0; key < sessions.size(); key++) {
+        auto const& state = sessions[key];
+        ASSERT_EQ(state.steps.size(), 500);
+        for (int step = 0; step < 500; step++) {
+            EXPECT_EQ(state.steps[static_cast<std::size_t>(step)], step);
+            EXPECT_EQ(state.ran_on[static_cast<std::size_t>(step)], pool.worker_of(key));
+        }
+    }
+
+    // the same function runs on the same worker
+    std::vector<std::size_t> ran_on;
+    std::latch               affine{100};
+    auto const               record = [&] {
+        ran_on.push_back(pool.current_index());
+        affine.count_down();
+    };
+    for (int i = 0; i < 100; i++)
+        pool.post_affine(record);
+    affine.wait();
+    EXPECT_EQ(std::count(ran_on.begin(), ran_on.end(), ran_on.front()), 100);
+    static_assert(details::type_hash<int> != details::type_hash<long>);
+}
+
+TEST(ThreadPool, CancelledTasks) {
+    thread_pool         pool{2};
+    cancellation_source source;
+    std::atomic<int>    ran{0};
+
+    pool.pause(); // so the tasks wait in the queue
+    pool.post(source.token(), [&] {
+        ran++;
+    });
+    pool.post(cancellation_token::at(deadline_clock::now() - std::chrono::milliseconds{1}), [&] {
+        ran += 10;
+    });
+    pool.post(cancellation_token{}, [&] {
+        ran += 100;
+    });
+    source.cancel();
+    pool.resume();
+    pool.stop();
+    EXPECT_EQ(ran, 100) << "the work of the abandoned requests is dropped";
+}
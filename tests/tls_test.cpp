@@ -0,0 +1,167 @@
+#include "../core/include/webpp/http/bodies/file.hpp"
+#include "../core/include/webpp/http/interfaces/common/tls.hpp"
+#include "../core/include/webpp/http/interfaces/simple_server.hpp"
+#include "../core/include/webpp/http/response.hpp"
+#include "../core/include/webpp/http/static_file_cache.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+
+using namespace webpp;
+
+#ifdef WEBPP_USE_TLS
+
+#    include <openssl/evp.h>
+#    include <openssl/pem.h>
+#    include <openssl/x509.h>
+
+namespace {
+    using file_response_type =
+      basic_response<std_traits, empty_extension_pack, response_headers<std_traits>, file_body::type<std_traits>>;
+
+    /**
+     * A self-signed certificate for localhost, and its key, in PEM files
+     */
+    struct self_signed {
+        std::filesystem::path cert_path = std::filesystem::temp_directory_path() / "webpp_tls_test_cert.pem";
+        std::filesystem::path key_path  = std::filesystem::temp_directory_path() / "webpp_tls_test_key.pem";
+
+        self_signed() {
+            EVP_PKEY* key  = EVP_EC_gen("P-256");
+            X509*     cert = X509_new();
+            ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+            X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+            X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+            X509_set_pubkey(cert, key);
+            auto* name = X509_get_subject_name(cert);
+            X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<unsigned char const*>("localhost"),
+                                       -1, -1, 0);
+            X509_set_issuer_name(cert, name);
+            X509_sign(cert, key, EVP_sha256());
+
+            FILE* cert_file = std::fopen(cert_path.c_str(), "w");
+            PEM_write_X509(cert_file, cert);
+            std::fclose(cert_file);
+            FILE* key_file = std::fopen(key_path.c_str(), "w");
+            PEM_write_PrivateKey(key_file, key, nullptr, nullptr, 0, nullptr, nullptr);
+            std::fclose(key_file);
+            X509_free(cert);
+            EVP_PKEY_free(key);
+        }
+
+        ~self_signed() {
+            std::filesystem::remove(cert_path);
+            std::filesystem::remove(key_path);
+        }
+
+        [[nodiscard]] common::tls_options options() const {
+            return {.certificate_chain_file = cert_path.string(), .private_key_file = key_path.string()};
+        }
+    };
+
+    struct file_app {
+        std::filesystem::path path;
+        static_file_cache     cache{{.max_file_size = 0}}; // they're sent from the disk
+
+        template <typename RequestType>
+        file_response_type operator()(RequestType const& req) {
+            return file_response<file_response_type>(cache, path, {}, req.header("Range"));
+        }
+    };
+} // namespace
+
+TEST(TLS, ContextErrors) {
+    common::tls_context missing{{.certificate_chain_file = "/nonexistent/cert.pem", .private_key_file = "x"}};
+    EXPECT_FALSE(missing.is_valid());
+    EXPECT_NE(missing.error().find("/nonexistent/cert.pem"), std::string_view::npos);
+    EXPECT_EQ(missing.new_session(0), nullptr);
+
+    self_signed         files;
+    common::tls_context ctx{files.options()};
+    EXPECT_TRUE(ctx.is_valid()) << ctx.error();
+}
+
+TEST(TLS, SimpleServerOverTLS) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    self_signed         files;
+    common::tls_context ctx{files.options()};
+    ASSERT_TRUE(ctx.is_valid()) << ctx.error();
+
+    // bigger than what's read of a file at once, when OpenSSL encrypts it
+    std::string content(200'000, '\0');
+    for (std::size_t i = 0; i < content.size(); i++)
+        content[i] = static_cast<char>('a' + i % 26);
+    auto const path = std::filesystem::temp_directory_path() / "webpp_tls_test.txt";
+    {
+        std::ofstream out{path, std::ios::binary | std::ios::trunc};
+        out << content;
+    }
+
+    boost::asio::io_context io;
+    tcp::acceptor           acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    tcp::socket             client{io};
+    client.connect(acceptor.local_endpoint());
+    common::connection conn{acceptor.accept()};
+    conn.use_tls(ctx);
+    EXPECT_TRUE(conn.is_tls());
+
+    simple_server<std_traits, file_app> server;
+    server.app.path = path;
+    bool closed     = false;
+    conn.start(
+      [&] {
+          closed = true;
+      },
+      [&, state = decltype(server)::connection_state{}](common::connection& c, std::string_view data) mutable {
+          server.handle(c, state, data);
+      });
+
+    // the client blocks, so it has its own thread
+    std::string       received;
+    std::atomic<bool> done{false};
+    std::thread       client_thread{[&] {
+        SSL_CTX* client_ctx = SSL_CTX_new(TLS_client_method());
+        SSL*     ssl        = SSL_new(client_ctx);
+        SSL_set_fd(ssl, client.native_handle());
+        if (SSL_connect(ssl) == 1) {
+            std::string_view const requests = "GET /a HTTP/1.1\r\nHost: a\r\n\r\n"
+                                              "GET /b HTTP/1.1\r\n"
+                                              "Host: a\r\nRange: bytes=-3\r\nConnection: close\r\n\r\n";
+            SSL_write(ssl, requests.data(), static_cast<int>(requests.size()));
+            std::array<char, 16 * 1024> buf{};
+            for (;;) {
+                auto const res = SSL_read(ssl, buf.data(), static_cast<int>(buf.size()));
+                if (res <= 0)
+                    break;
+                received.append(buf.data(), static_cast<std::size_t>(res));
+            }
+        }
+        SSL_free(ssl);
+        SSL_CTX_free(client_ctx);
+        done = true;
+    }};
+    for (auto const deadline = std::chrono::steady_clock::now() + 5s;
+         !done && std::chrono::steady_clock::now() < deadline;) {
+        io.restart();
+        io.run_for(10ms);
+    }
+    client_thread.join();
+    std::filesystem::remove(path);
+    EXPECT_TRUE(closed);
+
+    ASSERT_EQ(received.find("HTTP/1.1 200 OK\r\n"), 0) << received.substr(0, 200);
+    auto const first_head  = received.find("\r\n\r\n");
+    auto const second_head = received.find("HTTP/1.1 206 Partial Content\r\n", first_head);
+    ASSERT_NE(second_head, std::string::npos);
+    EXPECT_TRUE(received.substr(first_head + 4, second_head - first_head - 4) == content);
+    EXPECT_EQ(received.substr(received.find("\r\n\r\n", second_head) + 4), content.substr(content.size() - 3));
+}
+
+#endif
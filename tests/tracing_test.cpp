@@ -0,0 +1,82 @@
+#include "../core/include/webpp/utils/tracing.hpp"
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace webpp;
+
+namespace {
+    std::string chrome_trace() {
+        std::ostringstream out;
+        tracer::global().write_chrome_trace(out);
+        return out.str();
+    }
+
+    std::size_t count_of(std::string const& str, std::string_view part) {
+        std::size_t count = 0;
+        for (auto pos = str.find(part); pos != std::string::npos; pos = str.find(part, pos + 1))
+            count++;
+        return count;
+    }
+} // namespace
+
+TEST(Tracing, Spans) {
+    tracer::global().clear();
+    {
+        trace_span const parse{trace_point::parse, 7};
+        trace_span const route{trace_point::route};
+    }
+    auto const began = trace_ticks();
+    trace_since(trace_point::write, 7, began);
+    EXPECT_EQ(tracer::global().local().recorded(), 3);
+
+    auto const json = chrome_trace();
+    EXPECT_TRUE(json.starts_with(R"({"displayTimeUnit":"ns","traceEvents":[{"name":"route")")) << json;
+    EXPECT_TRUE(json.ends_with("]}"));
+    EXPECT_EQ(count_of(json, R"("ph":"X")"), 3);
+    EXPECT_EQ(count_of(json, R"("name":"parse")"), 1);
+    EXPECT_EQ(count_of(json, R"("name":"write")"), 1);
+    EXPECT_EQ(count_of(json, R"("args":{"id":7})"), 2);
+}
+
+TEST(Tracing, Threads) {
+    tracer::global().clear();
+    std::thread{[] {
+        trace_span const span{trace_point::handler, 1};
+    }}.join();
+    {
+        trace_span const span{trace_point::handler, 2};
+    }
+
+    // the events of the threads that are gone are kept until clear()
+    auto const json = chrome_trace();
+    EXPECT_EQ(count_of(json, R"("name":"handler")"), 2);
+    EXPECT_NE(json.find(R"("args":{"id":1})"), std::string::npos);
+
+    tracer::global().clear();
+    EXPECT_EQ(chrome_trace(), R"({"displayTimeUnit":"ns","traceEvents":[]})");
+}
+
+TEST(Tracing, Ring) {
+    tracer::global().clear();
+    for (std::size_t i = 0; i < trace_buffer::capacity + 10; i++)
+        trace_since(trace_point::serialize, i, trace_ticks());
+    auto const json = chrome_trace();
+    EXPECT_EQ(count_of(json, R"("name":"serialize")"), trace_buffer::capacity);
+    EXPECT_EQ(json.find(R"("args":{"id":9})"), std::string::npos); // the oldest ones are gone
+    EXPECT_NE(json.find(R"("args":{"id":10})"), std::string::npos);
+}
+
+TEST(Tracing, Macro) {
+    tracer::global().clear();
+    {
+        WEBPP_TRACE_SPAN(accept, 3);
+    }
+#ifdef WEBPP_TRACING
+    EXPECT_EQ(tracer::global().local().recorded(), 1);
+#else
+    EXPECT_EQ(tracer::global().local().recorded(), 0); // compiled out
+#endif
+}
@@ -0,0 +1,93 @@
+#include "../core/include/webpp/http/interfaces/common/uring.hpp"
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace webpp;
+
+#ifdef WEBPP_HAS_IO_URING
+
+TEST(Uring, AcceptReadWrite) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    boost::asio::io_context io;
+    common::uring_service   ring{io};
+    if (!ring.is_open())
+        GTEST_SKIP() << "io_uring is not available here";
+
+    tcp::acceptor acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    auto const    endpoint = acceptor.local_endpoint();
+
+    // one multishot accept for both of the clients
+    std::vector<int>        accepted;
+    common::uring_operation accept_op;
+    accept_op.on_complete = [&](int res, unsigned) {
+        if (res >= 0)
+            accepted.push_back(res);
+    };
+    ring.accept(accept_op, acceptor.native_handle());
+
+    tcp::socket first{io}, second{io};
+    first.connect(endpoint);
+    second.connect(endpoint);
+    for (int i = 0; i < 100 && accepted.size() != 2; i++)
+        io.run_for(10ms);
+    ASSERT_EQ(accepted.size(), 2);
+
+    // read into a registered buffer
+    std::string buffer(64, '\0');
+    auto const  index = ring.register_buffer(buffer.data(), buffer.size());
+    std::string received;
+    common::uring_operation read_op;
+    read_op.on_complete = [&](int res, unsigned) {
+        if (res > 0)
+            received.assign(buffer.data(), static_cast<std::size_t>(res));
+    };
+    ring.recv(read_op, accepted[0], buffer.data(), buffer.size(), index);
+    boost::asio::write(first, boost::asio::buffer(std::string_view{"hello"}));
+    for (int i = 0; i < 100 && received.empty(); i++)
+        io.run_for(10ms);
+    EXPECT_EQ(received, "hello");
+
+    // a gather write
+    std::string head = "HTTP/1.1 200 OK\r\n\r\n", body = "body";
+    iovec       iovs[2] = {{head.data(), head.size()}, {body.data(), body.size()}};
+    msghdr      msg{};
+    msg.msg_iov    = iovs;
+    msg.msg_iovlen = 2;
+    int                     sent = 0;
+    common::uring_operation write_op;
+    write_op.on_complete = [&](int res, unsigned) {
+        sent = res;
+    };
+    ring.sendmsg(write_op, accepted[1], msg);
+    for (int i = 0; i < 100 && sent == 0; i++)
+        io.run_for(10ms);
+    EXPECT_EQ(sent, static_cast<int>(head.size() + body.size()));
+    std::string response(head.size() + body.size(), '\0');
+    boost::asio::read(second, boost::asio::buffer(response));
+    EXPECT_EQ(response, head + body);
+
+    // a pending read can be cancelled
+    int result = 0;
+    read_op.on_complete = [&](int res, unsigned) {
+        result = res;
+    };
+    ring.recv(read_op, accepted[0], buffer.data(), buffer.size());
+    io.run_for(10ms);
+    ring.cancel(read_op);
+    for (int i = 0; i < 100 && result == 0; i++)
+        io.run_for(10ms);
+    EXPECT_EQ(result, -ECANCELED);
+
+    ring.cancel(accept_op);
+    io.run_for(10ms);
+    for (auto fd : accepted)
+        ::close(fd);
+}
+
+#endif
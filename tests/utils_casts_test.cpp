@@ -3,8 +3,11 @@
 #include "../core/include/webpp/utils/casts.hpp"
 
 #include <gtest/gtest.h>
+#include <cstdint>
 #include <limits>
+#include <random>
 #include <string>
+#include <string_view>
 
 using namespace webpp;
 using namespace std;
@@ -36,3 +39,115 @@ TEST(Casts, ToStr) {
     EXPECT_EQ("-12", to_str<std_traits>(-12));
     EXPECT_EQ(to_str<std_traits>(1222).size(), 4);
 }
+
+TEST(Casts, ToStrBuffer) {
+    EXPECT_EQ(to_str_buffer(0).view(), "0");
+    EXPECT_EQ(to_str_buffer(1234u).view(), "1234");
+    EXPECT_EQ(to_str_buffer(std::numeric_limits<std::uint64_t>::max()).view(), "18446744073709551615");
+    EXPECT_EQ(to_str_buffer(std::numeric_limits<std::int64_t>::min()).view(), "-9223372036854775808");
+    EXPECT_EQ(to_str<std_traits>(std::numeric_limits<std::int64_t>::min()), "-9223372036854775808");
+}
+
+TEST(Casts, ParseInteger) {
+    std::uint64_t u64 = 7;
+    EXPECT_TRUE(parse_integer(std::string_view{"0"}, u64));
+    EXPECT_EQ(u64, 0);
+    EXPECT_TRUE(parse_integer(std::string_view{"18446744073709551615"}, u64));
+    EXPECT_EQ(u64, std::numeric_limits<std::uint64_t>::max());
+    EXPECT_TRUE(parse_integer(std::string_view{"000000000000000000000000123456789"}, u64));
+    EXPECT_EQ(u64, 123456789);
+    for (auto const invalid : {"", "-1", "+1", "18446744073709551616", "99999999999999999999", "1234567a",
+                               "12345678a", "123456789012345x7", " 1", "1 ", "0x10", "1.5"}) {
+        std::uint64_t res = 7;
+        EXPECT_FALSE(parse_integer(std::string_view{invalid}, res)) << invalid;
+        EXPECT_EQ(res, 7) << "it's not changed: " << invalid;
+    }
+
+    std::int8_t i8 = 0;
+    EXPECT_TRUE(parse_integer(std::string_view{"-128"}, i8));
+    EXPECT_EQ(i8, -128);
+    EXPECT_TRUE(parse_integer(std::string_view{"127"}, i8));
+    EXPECT_EQ(i8, 127);
+    EXPECT_FALSE(parse_integer(std::string_view{"128"}, i8));
+    EXPECT_FALSE(parse_integer(std::string_view{"-129"}, i8));
+    EXPECT_FALSE(parse_integer(std::string_view{"-"}, i8));
+
+    std::int64_t i64 = 0;
+    EXPECT_TRUE(parse_integer(std::string_view{"-9223372036854775808"}, i64));
+    EXPECT_EQ(i64, std::numeric_limits<std::int64_t>::min());
+    EXPECT_FALSE(parse_integer(std::string_view{"9223372036854775808"}, i64));
+
+    std::uint16_t port = 0;
+    EXPECT_TRUE(parse_integer(std::string_view{"65535"}, port));
+    EXPECT_EQ(port, 65535);
+    EXPECT_FALSE(parse_integer(std::string_view{"65536"}, port));
+    static_assert([] {
+        int res = 0;
+        return parse_integer(std::string_view{"-123456789"}, res) && res == -123456789;
+    }());
+
+    // every length, and a wrong char in every position
+    std::mt19937_64 gen{42}; // NOLINT(cert-msc51-cpp)
+    for (int i = 0; i < 20'000; i++) {
+        auto const value = gen() >> (gen() % 64);
+        auto       str   = std::to_string(value);
+        ASSERT_TRUE(parse_integer(std::string_view{str}, u64)) << str;
+        ASSERT_EQ(u64, value);
+        ASSERT_EQ(to_uint64<std_traits>(str), value);
+        str[gen() % str.size()] = static_cast<char>("/:a \0"[gen() % 5]);
+        ASSERT_FALSE(parse_integer(std::string_view{str}, u64)) << str;
+        ASSERT_EQ(to_uint64<std_traits>(str), 0);
+    }
+}
+
+TEST(Casts, WriteInteger) {
+    static_assert(to_str_buffer(-1234567).view() == "-1234567");
+    std::mt19937_64 gen{42}; // NOLINT(cert-msc51-cpp)
+    for (int i = 0; i < 20'000; i++) {
+        auto const value        = gen() >> (gen() % 64);
+        auto const signed_value = static_cast<std::int64_t>(gen()) >> (gen() % 64);
+        ASSERT_EQ(to_str_buffer(value).view(), std::to_string(value));
+        ASSERT_EQ(to_str<std_traits>(signed_value), std::to_string(signed_value));
+    }
+    for (std::uint64_t power = 1; power < std::numeric_limits<std::uint64_t>::max() / 10; power *= 10) {
+        EXPECT_EQ(to_str_buffer(power - 1).view(), std::to_string(power - 1));
+        EXPECT_EQ(to_str_buffer(power).view(), std::to_string(power));
+    }
+    EXPECT_EQ(to_str_buffer(std::numeric_limits<std::int8_t>::min()).view(), "-128");
+    EXPECT_EQ(to_str<std_traits>(255u, 16), "ff") << "with the to_chars args";
+}
+
+TEST(Casts, ParseFloating) {
+    double value = 7;
+    EXPECT_TRUE(parse_floating("1.5", value));
+    EXPECT_EQ(value, 1.5);
+    EXPECT_TRUE(parse_floating("-2", value));
+    EXPECT_EQ(value, -2);
+    EXPECT_TRUE(parse_floating("-.25", value));
+    EXPECT_EQ(value, -0.25);
+    EXPECT_TRUE(parse_floating("3e8", value));
+    EXPECT_EQ(value, 3e8);
+    EXPECT_TRUE(parse_floating("0.1", value));
+    EXPECT_EQ(value, 0.1) << "it's rounded correctly";
+    EXPECT_TRUE(parse_floating("9007199254740993", value));
+    EXPECT_EQ(value, 9007199254740992.0) << "the ties go to the even one";
+    for (auto const invalid : {"", "-", ".", "+1", " 1", "1 ", "1e", "1.5.", "inf", "-nan", "0x10", "1e999"}) {
+        double res = 7;
+        EXPECT_FALSE(parse_floating(invalid, res)) << invalid;
+        EXPECT_EQ(res, 7) << "it's not changed: " << invalid;
+    }
+
+    float single = 0;
+    EXPECT_TRUE(parse_floating("16777217", single));
+    EXPECT_EQ(single, 16777216.0f);
+    long double extended = 0;
+    EXPECT_TRUE(parse_floating("0.5", extended));
+    EXPECT_EQ(extended, 0.5L);
+
+    unsigned int uint = 0;
+    EXPECT_TRUE(parse_number("42", uint));
+    EXPECT_EQ(uint, 42);
+    EXPECT_FALSE(parse_number("4.2", uint));
+    EXPECT_TRUE(parse_number("4.2", single));
+    EXPECT_EQ(single, 4.2f);
+}
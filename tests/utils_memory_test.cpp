@@ -1,5 +1,8 @@
 // Created by moisrex on 1/27/20.
 
+#include "../core/include/webpp/http/bodies/string.hpp"
+#include "../core/include/webpp/http/response.hpp"
+#include "../core/include/webpp/traits/std_arena_traits.hpp"
 #include "../core/include/webpp/utils/memory.hpp"
 
 #include <gtest/gtest.h>
@@ -11,3 +14,49 @@ using namespace std;
 TEST(MemoryTest, AvailableMemory) {
     EXPECT_TRUE(available_memory() >= 0);
 }
+
+TEST(MemoryTest, RequestArena) {
+    request_arena arena{stl::pmr::null_memory_resource()};
+    using arena_string = typename std_arena_traits::string_type;
+    {
+        request_arena_scope const _scope{arena};
+        EXPECT_EQ(current_request_resource(), arena.get());
+
+        arena_string str{"a string that is too long for the small string optimization"};
+        EXPECT_EQ(str.get_allocator().resource(), arena.get());
+
+        {
+            outside_request_arena const _outside;
+            EXPECT_EQ(current_request_resource(), stl::pmr::get_default_resource());
+            arena_string const copy{str};
+            EXPECT_EQ(copy.get_allocator().resource(), stl::pmr::get_default_resource());
+            EXPECT_EQ(copy, str);
+        }
+        EXPECT_EQ(current_request_resource(), arena.get());
+
+        basic_response<std_arena_traits, empty_extension_pack, response_headers<std_arena_traits>,
+                       string_body::type<std_arena_traits>> const res{200u, "hello"};
+        EXPECT_EQ(res.body.str(), "hello");
+    }
+    EXPECT_EQ(current_request_resource(), stl::pmr::get_default_resource());
+
+    // the inline buffer is all we have (the upstream is the null resource), so
+    // this only works if reset gives it back
+    arena.reset();
+    request_arena_scope const _scope{arena};
+    arena_string big(request_arena::inline_size / 2, 'x');
+    EXPECT_EQ(big.size(), request_arena::inline_size / 2);
+}
+
+TEST(MemoryTest, ServeInRequestArena) {
+    auto const* inside = serve_in_request_arena<std_arena_traits>([] {
+        return current_request_resource();
+    });
+    EXPECT_EQ(inside, request_arena::local().get());
+    EXPECT_EQ(current_request_resource(), stl::pmr::get_default_resource());
+
+    auto const* plain = serve_in_request_arena<std_traits>([] {
+        return current_request_resource();
+    });
+    EXPECT_EQ(plain, stl::pmr::get_default_resource());
+}
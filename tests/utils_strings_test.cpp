@@ -3,6 +3,8 @@
 #include "../core/include/webpp/utils/strings.hpp"
 
 #include <gtest/gtest.h>
+#include <string>
+#include <string_view>
 
 using namespace webpp;
 using namespace std;
@@ -23,3 +25,80 @@ TEST(Strings, StartsEndsWith) {
     EXPECT_TRUE(starts_with<std_traits>("_one! ", "_one!"));
     EXPECT_FALSE(starts_with<std_traits>("_one! ", "__one!"));
 }
+
+TEST(Strings, Trim) {
+    static_assert(trim_copy<std_traits>(std::string_view{" \t a b \r\n"}) == "a b");
+    EXPECT_EQ(ltrim_copy<std_traits>(std::string_view{"  \v\fvalue "}), "value ");
+    EXPECT_EQ(rtrim_copy<std_traits>(std::string_view{" value \t"}), " value");
+    EXPECT_EQ(trim_copy<std_traits>(std::string_view{" \t\r\n "}), "");
+    EXPECT_EQ(trim_copy<std_traits>(std::string{"\t value\x0b"}), "value");
+    EXPECT_EQ(trim_copy<std_traits>(std::string{"   "}), "");
+
+    // the spaces around the chunks of the vectorized ones
+    for (std::size_t spaces = 0; spaces < 70; spaces++) {
+        for (std::size_t size : {0ul, 1ul, 15ul, 16ul, 33ul}) {
+            std::string const padding(spaces, spaces % 2 ? ' ' : '\t');
+            std::string const word(size, '\x80');
+            auto const        str = padding + word + padding;
+            EXPECT_EQ(trim_copy<std_traits>(std::string_view{str}), word) << spaces << ' ' << size;
+            EXPECT_EQ(ltrim_copy<std_traits>(std::string_view{str}).size(), size == 0 ? 0 : size + spaces);
+            EXPECT_EQ(rtrim_copy<std_traits>(std::string{str}).size(), size == 0 ? 0 : size + spaces);
+        }
+    }
+}
+
+TEST(Strings, AsciiCase) {
+    std::string all;
+    for (int i = 0; i < 256 * 3; i++)
+        all.push_back(static_cast<char>(i));
+    for (std::size_t size = 0; size <= all.size(); size += 37) {
+        auto lower = all.substr(0, size);
+        auto upper = lower;
+        ascii_to_lower(lower.data(), lower.size());
+        ascii_to_upper(upper.data(), upper.size());
+        for (std::size_t i = 0; i < size; i++) {
+            auto const c = all[i];
+            ASSERT_EQ(lower[i], c >= 'A' && c <= 'Z' ? c + 32 : c) << i;
+            ASSERT_EQ(upper[i], c >= 'a' && c <= 'z' ? c - 32 : c) << i;
+        }
+    }
+
+    std::string name = "Content-Type";
+    to_lower<std_traits>(name);
+    EXPECT_EQ(name, "content-type");
+    EXPECT_EQ(to_upper_copy<std_traits>("X-Forwarded-For"), "X-FORWARDED-FOR");
+    EXPECT_EQ(to_lower_copy<std_traits>("K\xc3\x96LN"), "k\xc3\x96ln") << "only the ASCII letters";
+}
+
+TEST(Strings, AsciiCaseInsensitive) {
+    static_assert(ascii_iequals("Content-Type", "content-TYPE"));
+    static_assert(!ascii_iequals("Content-Type", "Content-Typo"));
+    static_assert(ascii_ihash("X-Forwarded-For") == ascii_ihash("x-forwarded-for"));
+    EXPECT_EQ(ascii_ihash("Access-Control-Allow-Origin"), ascii_ihash("access-control-allow-origin"));
+    EXPECT_NE(ascii_ihash("Accept"), ascii_ihash("Accept-Encoding"));
+    EXPECT_NE(ascii_ihash(""), ascii_ihash(std::string_view{"\0", 1}));
+
+    // every byte against every byte, at the places of the words and the tails
+    std::string a(19, 'x');
+    std::string b(19, 'x');
+    for (std::size_t pos : {0ul, 7ul, 8ul, 15ul, 18ul}) {
+        for (int i = 0; i < 256; i++) {
+            for (int j = 0; j < 256; j++) {
+                auto const ca = static_cast<char>(i);
+                auto const cb = static_cast<char>(j);
+                a[pos]        = ca;
+                b[pos]        = cb;
+                auto const lower = [](char c) {
+                    return c >= 'A' && c <= 'Z' ? c + 32 : c;
+                };
+                auto const same = lower(ca) == lower(cb);
+                ASSERT_EQ(ascii_iequals(a, b), same) << pos << ' ' << i << ' ' << j;
+                if (same) {
+                    ASSERT_EQ(ascii_ihash(a), ascii_ihash(b)) << pos << ' ' << i << ' ' << j;
+                }
+            }
+        }
+        a[pos] = b[pos] = 'x';
+    }
+    EXPECT_FALSE(ascii_iequals("abc", "abcd"));
+}
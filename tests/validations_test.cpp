@@ -2,9 +2,12 @@
 #include "../core/include/webpp/utils/charset.hpp"
 #include "../core/include/webpp/validators/validators.hpp"
 
+#include <algorithm>
 #include <gtest/gtest.h>
+#include <cstdint>
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 
 using namespace webpp::is;
@@ -142,6 +145,81 @@ TEST(ValidationsTest, EmailFunction) {
       << "spaces are not allowed in emails";
 }
 
+TEST(ValidationsTest, EmailDFA) {
+    std::vector<std::string_view> const valids{"a@b.co",
+                                               "first.last@example.com",
+                                               "user+tag@sub.example.co.uk",
+                                               "o'neil_{x}|~!#$%&*/=?^`@mail-server.example.org",
+                                               "x@123.example.com",
+                                               "x@a-b--c.d3.example",
+                                               "UPPER@EXAMPLE.COM"};
+    std::vector<std::string_view> const invalids{"",
+                                                 "plain",
+                                                 "@example.com",
+                                                 "a@",
+                                                 "a@b",
+                                                 "a@b.c",
+                                                 "a@b.c1",
+                                                 ".a@b.com",
+                                                 "a.@b.com",
+                                                 "a..b@c.com",
+                                                 "a@@b.com",
+                                                 "a@b@c.com",
+                                                 "a@-b.com",
+                                                 "a@b-.com",
+                                                 "a@b.-c.com",
+                                                 "a@b..com",
+                                                 "a@b.com.",
+                                                 "a@b.com-",
+                                                 "a@b_c.com",
+                                                 "a b@c.com",
+                                                 "\"quoted\"@b.com",
+                                                 "a@[127.0.0.1]",
+                                                 "caf\xc3\xa9@b.com"};
+    for (auto const str : valids) {
+        EXPECT_TRUE(email<webpp::std_traits>(str)) << str;
+        EXPECT_TRUE(webpp::email{str}.has_valid_syntax()) << str;
+    }
+    for (auto const str : invalids) {
+        EXPECT_FALSE(email<webpp::std_traits>(str)) << str;
+        EXPECT_FALSE(webpp::email{str}.has_valid_syntax()) << str;
+    }
+    static_assert(email<webpp::std_traits>("compile@time.dev"));
+
+    // the lengths
+    std::string const local_64(64, 'a');
+    EXPECT_TRUE(email<webpp::std_traits>(local_64 + "@b.com"));
+    EXPECT_FALSE(email<webpp::std_traits>(local_64 + "a@b.com"));
+    std::string long_domain = "a@";
+    while (long_domain.size() < 250)
+        long_domain += "abcdefghi.";
+    EXPECT_FALSE(email<webpp::std_traits>(long_domain + "com")) << long_domain.size() + 3;
+    EXPECT_TRUE(email<webpp::std_traits>(long_domain.substr(0, 250) + "com"));
+
+    // the parts
+    webpp::email const mail{"Some.One@Example.COM"};
+    EXPECT_EQ(mail.username(), "Some.One");
+    EXPECT_EQ(mail.domain(), "Example.COM");
+    EXPECT_TRUE(mail.is_equal(webpp::email{"Some.One@example.com"}));
+    EXPECT_FALSE(mail.is_equal(webpp::email{"some.one@example.com"})) << "the usernames are case-sensitive";
+    EXPECT_EQ(webpp::email{"not valid"}.domain(), "");
+
+    // all at once, like one at a time
+    std::vector<std::string_view> all;
+    for (int i = 0; i < 300; i++)
+        all.push_back(i % 3 == 0 ? invalids[static_cast<std::size_t>(i) % invalids.size()]
+                                 : valids[static_cast<std::size_t>(i) % valids.size()]);
+    std::vector<std::uint64_t> bad((all.size() + 63) / 64);
+    std::size_t                expected = 0;
+    EXPECT_EQ(emails(all, bad), 100);
+    for (std::size_t i = 0; i < all.size(); i++) {
+        bool const invalid = (bad[i / 64] >> (i % 64)) & 1u;
+        EXPECT_EQ(invalid, !email<webpp::std_traits>(all[i])) << all[i];
+        expected += invalid;
+    }
+    EXPECT_EQ(expected, 100);
+}
+
 TEST(ValidationsTest, NumberFunctions) {
     for (char i = '0'; i <= '9'; i++)
         EXPECT_TRUE(digit(i));
@@ -168,3 +246,94 @@ TEST(ValidationsTest, NumberFunctions) {
     EXPECT_TRUE(number('1'));
     EXPECT_TRUE(number('.'));
 }
+
+TEST(ValidationsTest, NumbersAWordAtATime) {
+    // like the char at a time checks, for every length and a wrong char anywhere
+    auto digits_bytewise = [](std::string_view str) {
+        return !str.empty() && std::all_of(str.begin(), str.end(), [](char c) {
+            return c >= '0' && c <= '9';
+        });
+    };
+    auto hex_bytewise = [](std::string_view str) {
+        return !str.empty() && std::all_of(str.begin(), str.end(), [](char c) {
+            return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+        });
+    };
+    std::string const hex_chars = "0123456789abcdefABCDEF";
+    for (std::size_t size = 0; size <= 40; size++) {
+        std::string hex_str, digits_str;
+        for (std::size_t i = 0; i < size; i++) {
+            hex_str += hex_chars[(i * 7) % hex_chars.size()];
+            digits_str += static_cast<char>('0' + i % 10);
+        }
+        EXPECT_EQ(hex(std::string_view{hex_str}), size != 0);
+        EXPECT_EQ(digit(std::string_view{digits_str}), size != 0);
+        for (std::size_t pos = 0; pos < size; pos++) {
+            for (int c = 0; c < 256; c++) {
+                auto changed_hex    = hex_str;
+                auto changed_digits = digits_str;
+                changed_hex[pos]    = static_cast<char>(c);
+                changed_digits[pos] = static_cast<char>(c);
+                ASSERT_EQ(hex(std::string_view{changed_hex}), hex_bytewise(changed_hex)) << size << ' ' << c;
+                ASSERT_EQ(digit(std::string_view{changed_digits}), digits_bytewise(changed_digits))
+                  << size << ' ' << c;
+                ASSERT_EQ(integer(std::string_view{changed_digits}), digits_bytewise(changed_digits));
+            }
+        }
+    }
+    EXPECT_TRUE(hex(std::string_view{"0123456789abcdefABCDEF"}));
+    EXPECT_FALSE(hex(std::string_view{"0123456789abcdefABCDEFg"}));
+    EXPECT_FALSE(hex(std::string_view{""}));
+    EXPECT_TRUE(hex('F'));
+    EXPECT_FALSE(hex('g'));
+    static_assert(digit(std::string_view{"12345678901234567890"}));
+    static_assert(!digit(std::string_view{"1234567890123456789/"}));
+    static_assert(hex(std::string_view{"deadBEEF"}));
+    EXPECT_TRUE(number(std::string_view{"123456789012345678.123456789012345678"}));
+    EXPECT_FALSE(number(std::string_view{"123456789012345678.1234567890123456.78"}));
+    EXPECT_FALSE(number(std::string_view{"1.2."}));
+    EXPECT_FALSE(number(std::string_view{"1.2e5"}));
+    EXPECT_TRUE(number(std::string_view{"."})) << "like it was";
+}
+
+TEST(ValidationsTest, UTF8) {
+    using webpp::utf8_validator;
+
+    EXPECT_TRUE(utf8(""));
+    EXPECT_TRUE(utf8("plain ASCII"));
+    EXPECT_TRUE(utf8("caf\xc3\xa9 \xe2\x82\xac \xf0\x9d\x84\x9e"));
+    EXPECT_TRUE(utf8("\xef\xbf\xbf\xf4\x8f\xbf\xbf"));      // U+FFFF and U+10FFFF
+    EXPECT_FALSE(utf8("\x80"));                                // a continuation without a lead
+    EXPECT_FALSE(utf8("\xc0\xaf"));                            // overlong
+    EXPECT_FALSE(utf8("\xe0\x80\xaf"));                        // overlong
+    EXPECT_FALSE(utf8("\xf0\x80\x80\xaf"));                    // overlong
+    EXPECT_FALSE(utf8("\xed\xa0\x80"));                        // a surrogate
+    EXPECT_FALSE(utf8("\xf4\x90\x80\x80"));                    // after U+10FFFF
+    EXPECT_FALSE(utf8("\xf5\x80\x80\x80"));
+    EXPECT_FALSE(utf8("\xff"));
+    EXPECT_FALSE(utf8("caf\xc3"));                              // cut at the end
+    EXPECT_FALSE(utf8("\xe2\x82 "));
+    static_assert(utf8("\xe2\x82\xac"));
+    static_assert(!utf8("\xe2\x82"));
+
+    EXPECT_EQ(utf8_validator::complete_size("ab\xe2\x82"), 2);
+    EXPECT_EQ(utf8_validator::complete_size("ab\xe2\x82\xac"), 5);
+    EXPECT_EQ(utf8_validator::complete_size("ab\x80"), 3) << "not a char of its own, it's left to the check";
+
+    // the vectors agree with the scalar check, with the errors at every place of the blocks
+    std::string_view const pieces[]{"a", "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9d\x84\x9e", "\x80", "\xc0\xaf",
+                                    "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xc3", "\xe2\x82", "\xf0\x9d\x84"};
+    std::string_view const filler = "0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz";
+    for (std::size_t pos = 0; pos < 70; pos++) {
+        for (auto const piece : pieces) {
+            for (auto const after : pieces) {
+                std::string str{filler.substr(0, pos)};
+                str += piece;
+                str += after;
+                ASSERT_EQ(utf8(str), utf8_validator::validate_scalar(str)) << pos << ' ' << str;
+                str += filler;
+                ASSERT_EQ(utf8(str), utf8_validator::validate_scalar(str)) << pos << ' ' << str;
+            }
+        }
+    }
+}
@@ -0,0 +1,247 @@
+#include "../core/include/webpp/http/bodies/string.hpp"
+#include "../core/include/webpp/http/interfaces/http1/websocket_frame.hpp"
+#include "../core/include/webpp/http/interfaces/simple_server.hpp"
+#include "../core/include/webpp/http/response.hpp"
+#include "../core/include/webpp/http/routes/router.hpp"
+#include "../core/include/webpp/utils/sha1.hpp"
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace webpp;
+
+namespace {
+    std::string hex(sha1::digest_type const& digest) {
+        std::string res;
+        for (auto const byte : digest) {
+            res.push_back("0123456789abcdef"[byte >> 4u]);
+            res.push_back("0123456789abcdef"[byte & 15u]);
+        }
+        return res;
+    }
+
+    // a frame like the clients send it
+    std::string client_frame(websocket::opcode op, std::string_view payload, bool fin = true) {
+        std::string frame;
+        websocket::write_frame(frame, op, payload, fin);
+        std::array<std::uint8_t, 4> const mask{0x37, 0xfa, 0x21, 0x3d};
+        auto const                        header_size = frame.size() - payload.size();
+        frame[1]                                      = static_cast<char>(frame[1] | 0x80);
+        frame.insert(header_size, reinterpret_cast<char const*>(mask.data()), mask.size());
+        websocket::unmask_scalar(frame.data() + header_size + 4, payload.size(), mask);
+        return frame;
+    }
+
+    using string_response_type = basic_response<std_traits,
+                                                empty_extension_pack,
+                                                response_headers<std_traits>,
+                                                string_body::type<std_traits>>;
+
+    struct ws_app {
+        router<> endpoints{};
+
+        template <typename RequestType>
+        string_response_type operator()(RequestType const& req) {
+            return string_response_type{200u, std::string{req.request_uri()}};
+        }
+
+        auto websocket_handler(std::string_view path) const noexcept {
+            return endpoints.websocket_handler(path);
+        }
+    };
+} // namespace
+
+TEST(WebSocket, SHA1AndAcceptKey) {
+    EXPECT_EQ(hex(sha1::hash("")), "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+    EXPECT_EQ(hex(sha1::hash("abc")), "a9993e364706816aba3e25717850c26c9cd0d89d");
+    EXPECT_EQ(hex(sha1::hash(std::string(1000, 'a'))), "291e9a6c66994949b57ba5e650361e98fc36b1ba");
+
+    // the example of RFC 6455
+    static constexpr auto key = websocket::accept_key("dGhlIHNhbXBsZSBub25jZQ==");
+    EXPECT_EQ(std::string_view(key.data(), key.size()), "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+}
+
+TEST(WebSocket, FrameParser) {
+    // a masked "Hello" (RFC 6455, 5.7)
+    std::string frame = "\x81\x85\x37\xfa\x21\x3d\x7f\x9f\x4d\x51\x58";
+    websocket::frame_header header;
+    for (std::size_t i = 0; i < 6; i++)
+        EXPECT_EQ(websocket::parse_frame_header(std::string_view{frame}.substr(0, i), header),
+                  http1::parse_status::incomplete);
+    ASSERT_EQ(websocket::parse_frame_header(frame, header), http1::parse_status::complete);
+    EXPECT_TRUE(header.fin);
+    EXPECT_TRUE(header.masked);
+    EXPECT_EQ(header.op, websocket::opcode::text);
+    EXPECT_EQ(header.payload_size, 5);
+    EXPECT_EQ(header.header_size, 6);
+    websocket::unmask(frame.data() + header.header_size, 5, header.mask);
+    EXPECT_EQ(frame.substr(header.header_size), "Hello");
+
+    // 256 bytes have a 16 bit length, 64KiB have a 64 bit one
+    for (std::size_t const size : {125u, 256u, 65536u}) {
+        std::string out;
+        websocket::write_frame(out, websocket::opcode::binary, std::string(size, 'x'));
+        ASSERT_EQ(websocket::parse_frame_header(out, header), http1::parse_status::complete);
+        EXPECT_EQ(header.payload_size, size);
+        EXPECT_EQ(header.header_size + size, out.size());
+    }
+
+    EXPECT_EQ(websocket::parse_frame_header(std::string_view{"\xC1\x00", 2}, header), http1::parse_status::error)
+      << "RSV1";
+    EXPECT_EQ(websocket::parse_frame_header(std::string_view{"\x83\x00", 2}, header), http1::parse_status::error)
+      << "opcode 3";
+    EXPECT_EQ(websocket::parse_frame_header(std::string_view{"\x09\x00", 2}, header), http1::parse_status::error)
+      << "a fragmented ping";
+}
+
+TEST(WebSocket, UnmaskMatchesScalar) {
+    std::mt19937                         rng{42};
+    std::uniform_int_distribution<int>   byte{0, 255};
+    std::array<std::uint8_t, 4> const    mask{0x12, 0x34, 0x56, 0x78};
+    for (std::size_t size = 0; size < 200; size += 7) {
+        for (std::size_t offset = 0; offset < 4; offset++) {
+            std::string data(size, '\0');
+            for (auto& c : data)
+                c = static_cast<char>(byte(rng));
+            auto expected = data;
+            websocket::unmask_scalar(expected.data(), expected.size(), mask, offset);
+            websocket::unmask(data.data(), data.size(), mask, offset);
+            EXPECT_EQ(data, expected) << size << " " << offset;
+        }
+    }
+}
+
+TEST(WebSocket, SimpleServerUpgrade) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    std::vector<std::string> events;
+    simple_server<std_traits, ws_app> server;
+    server.app.endpoints.websocket(
+      "/echo",
+      {.on_open =
+         [&](websocket::sender& ws) {
+             events.emplace_back("open");
+             ws.text("welcome");
+         },
+       .on_message =
+         [&](websocket::sender& ws, std::string_view msg, bool binary) {
+             events.emplace_back(msg);
+             ws.send(binary ? websocket::opcode::binary : websocket::opcode::text, msg);
+         },
+       .on_close =
+         [&](websocket::sender&, websocket::close_code code) {
+             events.emplace_back("close " + std::to_string(static_cast<int>(code)));
+         }});
+    EXPECT_NE(server.app.websocket_handler("/echo?room=1"), nullptr);
+    EXPECT_EQ(server.app.websocket_handler("/other"), nullptr);
+
+    boost::asio::io_context io;
+    tcp::acceptor           acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+    tcp::socket             client{io};
+    client.connect(acceptor.local_endpoint());
+    common::connection conn{acceptor.accept()};
+    bool               closed = false;
+    conn.start(
+      [&] {
+          closed = true;
+      },
+      [&, state = decltype(server)::connection_state{}](common::connection& c, std::string_view data) mutable {
+          server.handle(c, state, data);
+      });
+
+    // the handshake, and a frame right after it
+    boost::asio::write(client,
+                       boost::asio::buffer("GET /echo HTTP/1.1\r\nHost: a\r\nUpgrade: websocket\r\n"
+                                           "Connection: keep-alive, Upgrade\r\nSec-WebSocket-Version: 13\r\n"
+                                           "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n\r\n" +
+                                           client_frame(websocket::opcode::text, "first")));
+    io.run_for(50ms);
+
+    // a fragmented message, with a ping between its fragments, and a frame that's cut in two reads
+    auto const big = client_frame(websocket::opcode::binary, std::string(300, 'b'));
+    boost::asio::write(client,
+                       boost::asio::buffer(client_frame(websocket::opcode::text, "Hel", false) +
+                                           client_frame(websocket::opcode::ping, "p") +
+                                           client_frame(websocket::opcode::continuation, "lo") + big.substr(0, 100)));
+    io.run_for(50ms);
+    boost::asio::write(client,
+                       boost::asio::buffer(big.substr(100) + client_frame(websocket::opcode::close, "\x03\xe8")));
+    io.run_for(50ms);
+    EXPECT_TRUE(closed);
+
+    std::string               received;
+    boost::system::error_code ec;
+    boost::asio::read(client, boost::asio::dynamic_buffer(received), ec);
+    ASSERT_EQ(received.find("HTTP/1.1 101 Switching Protocols\r\n"), 0);
+    EXPECT_NE(received.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"), std::string::npos);
+
+    std::string expected;
+    websocket::write_frame(expected, websocket::opcode::text, "welcome");
+    websocket::write_frame(expected, websocket::opcode::text, "first");
+    websocket::write_frame(expected, websocket::opcode::pong, "p");
+    websocket::write_frame(expected, websocket::opcode::text, "Hello");
+    websocket::write_frame(expected, websocket::opcode::binary, std::string(300, 'b'));
+    websocket::write_close_frame(expected, websocket::close_code::normal);
+    EXPECT_EQ(received.substr(received.find("\r\n\r\n") + 4), expected);
+
+    ASSERT_EQ(events.size(), 5);
+    EXPECT_EQ(events[0], "open");
+    EXPECT_EQ(events[1], "first");
+    EXPECT_EQ(events[2], "Hello");
+    EXPECT_EQ(events[3], std::string(300, 'b'));
+    EXPECT_EQ(events[4], "close 1000");
+}
+
+TEST(WebSocket, SimpleServerBadHandshakeAndProtocolErrors) {
+    using namespace std::chrono_literals;
+    using tcp = boost::asio::ip::tcp;
+
+    simple_server<std_traits, ws_app> server;
+    websocket::close_code             closed_with{};
+    server.app.endpoints.websocket("/ws",
+                                   {.on_close = [&](websocket::sender&, websocket::close_code code) {
+                                       closed_with = code;
+                                   }});
+
+    auto const exchange = [&](std::string const& input) {
+        boost::asio::io_context io;
+        tcp::acceptor           acceptor{io, tcp::endpoint{boost::asio::ip::make_address("127.0.0.1"), 0}};
+        tcp::socket             client{io};
+        client.connect(acceptor.local_endpoint());
+        common::connection conn{acceptor.accept()};
+        conn.start([] {},
+                   [&, state = decltype(server)::connection_state{}](common::connection& c,
+                                                                     std::string_view    data) mutable {
+                       server.handle(c, state, data);
+                   });
+        boost::asio::write(client, boost::asio::buffer(input));
+        io.run_for(50ms);
+        std::string               received;
+        boost::system::error_code ec;
+        boost::asio::read(client, boost::asio::dynamic_buffer(received), ec);
+        return received;
+    };
+
+    std::string const handshake = "GET /ws HTTP/1.1\r\n"
+                                  "Host: a\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                                  "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n";
+    EXPECT_EQ(exchange(handshake + "Sec-WebSocket-Version: 8\r\n\r\n").find("HTTP/1.1 426 Upgrade Required\r\n"), 0);
+
+    // the frames of the clients should be masked
+    std::string unmasked;
+    websocket::write_frame(unmasked, websocket::opcode::text, "hi");
+    auto const received = exchange(handshake + "Sec-WebSocket-Version: 13\r\n\r\n" + unmasked);
+    std::string expected;
+    websocket::write_close_frame(expected, websocket::close_code::protocol_error);
+    EXPECT_EQ(received.substr(received.find("\r\n\r\n") + 4), expected);
+    EXPECT_EQ(closed_with, websocket::close_code::protocol_error);
+
+    // the texts should be UTF-8
+    exchange(handshake + "Sec-WebSocket-Version: 13\r\n\r\n" + client_frame(websocket::opcode::text, "\xff"));
+    EXPECT_EQ(closed_with, websocket::close_code::invalid_payload);
+}